@@ -69,6 +69,8 @@ option(USE_ASCEND_HETEROGENEOUS "option for transferring between ascend npu and
 option(USE_MNNVL "option for using Multi-Node NVLink transport" OFF)
 option(USE_CXL "option for using CXL protocol" OFF)
 option(USE_EFA "option for using AWS EFA transport" OFF)
+option(USE_MLX5_DC "option for using the dynamically connected transport of mlx5 NICs" OFF)
+option(USE_RDMA_ONLY "option for building only the RDMA transport, with a devirtualized transfer path" OFF)
 
 if (USE_EFA)
   # Find libfabric headers and library; default to AWS EFA installer path
@@ -99,7 +101,6 @@ option(WITH_RUST_EXAMPLE "build the Rust interface and sample code for the trans
 option(WITH_METRICS "enable metrics and metrics reporting thread" ON)
 option(USE_3FS "option for using 3FS storage backend" OFF)
 option(WITH_NVIDIA_PEERMEM "disable to support RDMA without nvidia-peermem. If WITH_NVIDIA_PEERMEM=OFF then USE_CUDA=ON is required." ON)
-option(USE_EVENT_DRIVEN_COMPLETION "option for using event-driven completion (store & transfer engine)" OFF)
 
 option(USE_TENT "option for building Mooncake TENT" OFF)
 
@@ -112,13 +113,6 @@ if (USE_LRU_MASTER)
   add_compile_definitions(LRU_MAX_CAPACITY)
 endif()
 
-if (USE_EVENT_DRIVEN_COMPLETION)
-  add_compile_definitions(USE_EVENT_DRIVEN_COMPLETION)
-  message(STATUS "Event-driven completion is enabled")
-else()
-  message(STATUS "Event-driven completion is disabled")
-endif()
-
 if (USE_NVMEOF)
   set(USE_CUDA ON)
   add_compile_definitions(USE_NVMEOF)
@@ -206,6 +200,20 @@ if (USE_BAREX)
   add_compile_definitions(USE_BAREX)
 endif()
 
+if (USE_MLX5_DC)
+  add_compile_definitions(USE_MLX5_DC)
+endif()
+
+if (USE_RDMA_ONLY)
+  if (USE_TCP OR USE_NVMEOF OR USE_BAREX OR USE_ASCEND OR USE_ASCEND_DIRECT
+      OR USE_UBSHMEM OR USE_ASCEND_HETEROGENEOUS OR USE_MNNVL OR USE_CXL
+      OR USE_EFA OR USE_INTRA_NVLINK)
+    message(FATAL_ERROR "USE_RDMA_ONLY requires all other transports to be disabled, including USE_TCP")
+  endif()
+  add_compile_definitions(USE_RDMA_ONLY)
+  message(STATUS "Only the RDMA transport is built")
+endif()
+
 if (USE_ASCEND OR USE_ASCEND_DIRECT OR USE_UBSHMEM)
   set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DOPEN_BUILD_PROJECT ")
   set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DOPEN_BUILD_PROJECT ")
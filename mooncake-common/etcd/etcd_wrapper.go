@@ -72,6 +72,9 @@ var (
 	// watch contexts for prefix watch
 	storePrefixWatchCtx   = make(map[string]prefixWatchInfo)
 	storePrefixWatchMutex sync.Mutex
+	// prefix watches of transfer engine, keyed by callback context
+	globalWatchCtx   = make(map[uintptr]prefixWatchInfo)
+	globalWatchMutex sync.Mutex
 )
 
 const (
@@ -165,6 +168,54 @@ func EtcdGetWrapper(key *C.char, value **C.char, errMsg **C.char) int {
 	return 0
 }
 
+//export EtcdBatchGetWrapper
+func EtcdBatchGetWrapper(keys **C.char, count C.int, values **C.char, errMsg **C.char) int {
+	if globalClient == nil {
+		*errMsg = C.CString("etcd client not initialized")
+		return -1
+	}
+	n := int(count)
+	if n == 0 {
+		return 0
+	}
+	keyPtrs := (*[1 << 28]*C.char)(unsafe.Pointer(keys))[:n:n]
+	valPtrs := (*[1 << 28]*C.char)(unsafe.Pointer(values))[:n:n]
+	// Each txn carries at most 128 ops, the default --max-txn-ops of etcd
+	const maxTxnOps = 128
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+	for start := 0; start < n; start += maxTxnOps {
+		end := start + maxTxnOps
+		if end > n {
+			end = n
+		}
+		ops := make([]clientv3.Op, 0, end-start)
+		for i := start; i < end; i++ {
+			ops = append(ops, clientv3.OpGet(C.GoString(keyPtrs[i])))
+		}
+		resp, err := globalClient.Txn(ctx).Then(ops...).Commit()
+		if err != nil {
+			for i := 0; i < start; i++ {
+				if valPtrs[i] != nil {
+					C.free(unsafe.Pointer(valPtrs[i]))
+					valPtrs[i] = nil
+				}
+			}
+			*errMsg = C.CString(err.Error())
+			return -1
+		}
+		for i, r := range resp.Responses {
+			kvs := r.GetResponseRange().Kvs
+			if len(kvs) == 0 {
+				valPtrs[start+i] = nil
+			} else {
+				valPtrs[start+i] = C.CString(string(kvs[0].Value))
+			}
+		}
+	}
+	return 0
+}
+
 //export EtcdDeleteWrapper
 func EtcdDeleteWrapper(key *C.char, errMsg **C.char) int {
 	if globalClient == nil {
@@ -195,6 +246,92 @@ func EtcdCloseWrapper() {
 	}
 }
 
+//export EtcdWatchWithPrefixWrapper
+func EtcdWatchWithPrefixWrapper(prefix *C.char, callbackContext unsafe.Pointer, callbackFunc unsafe.Pointer, errMsg **C.char) int {
+	if globalClient == nil {
+		*errMsg = C.CString("etcd client not initialized")
+		return -1
+	}
+	if callbackFunc == nil {
+		*errMsg = C.CString("callback function is nil")
+		return -1
+	}
+	p := C.GoString(prefix)
+	id := uintptr(callbackContext)
+	ctx, cancel := context.WithCancel(context.Background())
+
+	globalWatchMutex.Lock()
+	if _, exists := globalWatchCtx[id]; exists {
+		globalWatchMutex.Unlock()
+		*errMsg = C.CString("This context is already watching")
+		cancel()
+		return -1
+	}
+	doneCh := make(chan struct{})
+	globalWatchCtx[id] = prefixWatchInfo{
+		cancel:          cancel,
+		callbackContext: callbackContext,
+		done:            doneCh,
+	}
+	globalWatchMutex.Unlock()
+
+	go func(doneCh chan struct{}) {
+		defer close(doneCh)
+		// Resume from the last revision seen, and tell the watcher that
+		// changes may have been missed if the history is gone
+		rev := int64(0)
+		for {
+			opts := []clientv3.OpOption{clientv3.WithPrefix()}
+			if rev > 0 {
+				opts = append(opts, clientv3.WithRev(rev+1))
+			}
+			watchChan := globalClient.Watch(clientv3.WithRequireLeader(ctx), p, opts...)
+			for watchResp := range watchChan {
+				if watchResp.Err() != nil {
+					if watchResp.CompactRevision > 0 {
+						rev = 0
+					}
+					break
+				}
+				for _, event := range watchResp.Events {
+					keyStr := string(event.Kv.Key)
+					keyPtr := C.CString(keyStr)
+					C.call_watch_cb(callbackFunc, callbackContext, keyPtr, C.size_t(len(keyStr)), nil, 0, C.int(event.Type), C.longlong(event.Kv.ModRevision))
+					C.free(unsafe.Pointer(keyPtr))
+				}
+				if watchResp.Header.Revision > rev {
+					rev = watchResp.Header.Revision
+				}
+			}
+			select {
+			case <-ctx.Done():
+				return
+			case <-time.After(time.Second):
+			}
+			if rev == 0 {
+				C.call_watch_cb(callbackFunc, callbackContext, nil, 0, nil, 0, C.int(2) /*WATCH_BROKEN*/, C.longlong(0))
+			}
+		}
+	}(doneCh)
+
+	return 0
+}
+
+//export EtcdCancelWatchWithPrefixWrapper
+func EtcdCancelWatchWithPrefixWrapper(callbackContext unsafe.Pointer) {
+	id := uintptr(callbackContext)
+	globalWatchMutex.Lock()
+	watchInfo, exists := globalWatchCtx[id]
+	delete(globalWatchCtx, id)
+	globalWatchMutex.Unlock()
+	if !exists {
+		return
+	}
+	// No callback runs once this returns
+	watchInfo.cancel()
+	<-watchInfo.done
+}
+
 //export NewStoreEtcdClient
 func NewStoreEtcdClient(endpoints *C.char, errMsg **C.char) int {
 	storeMutex.Lock()
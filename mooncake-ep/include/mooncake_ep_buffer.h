@@ -73,18 +73,30 @@ struct MooncakeEpBuffer {
     // IBGDA
     static constexpr size_t CTRL_BUF_SIZE = 1024 * 1024 * 1024;  // 1024 MiB
     void* ctrl_buf = nullptr;
-    // RDMA memory region for `gdr_buffer`. Must be nullptr when IBGDA init
+    // A GPU may stripe its QPs over several NICs
+    struct IbgdaNic {
+        ibv_context* ctx = nullptr;
+        ibv_pd* pd = nullptr;
+        mlx5dv_pd mpd{};
+        // RDMA memory region for `gdr_buffer` on this NIC
+        ibv_mr* mr = nullptr;
+        mlx5dv_devx_umem* ctrl_buf_umem = nullptr;
+        ibv_gid gid{};
+        int gid_index = -1;  // Dynamically discovered GID index
+    };
+    std::vector<IbgdaNic> nics_;
+    // RDMA memory region of the first NIC. Must be nullptr when IBGDA init
     // fails.
     ibv_mr* mr = nullptr;
+    // QP `dst_rank * num_qp_per_rank_ + j` goes to `dst_rank` through NIC
+    // `j % nics_.size()`
+    int num_qp_per_rank_ = 0;
     std::vector<mlx5gda_qp*> qps;
-    ibv_gid gid;
     void* raddrs = nullptr;
-    void* rkeys = nullptr;
     void* qp_devctxs = nullptr;
     std::string device_name;
     bool is_roce_ = false;
     bool ibgda_disabled_ = false;
-    int gid_index_ = -1;  // Dynamically discovered GID index
 
     // NVLink P2P
     int32_t* nvlink_available = nullptr;
@@ -110,7 +122,10 @@ struct MooncakeEpBuffer {
     dispatch(const torch::Tensor& x, const torch::Tensor& topk_idx,
              torch::Tensor& active_ranks, int num_max_dispatch_tokens_per_rank,
              int num_experts, int timeout_us, bool use_fp8, bool async,
-             bool return_recv_hook);
+             bool return_recv_hook,
+             const std::optional<torch::Tensor>&
+                 cumulative_local_expert_recv_stats,
+             const std::optional<torch::Tensor>& dispatch_wait_recv_cost_stats);
 
     std::tuple<torch::Tensor, std::optional<EventHandle>,
                std::optional<std::function<void()>>>
@@ -118,14 +133,25 @@ struct MooncakeEpBuffer {
             const torch::Tensor& topk_weights, const torch::Tensor& src_info,
             const torch::Tensor& layout_range, torch::Tensor& active_ranks,
             int num_max_dispatch_tokens_per_rank, int num_experts,
-            int timeout_us, bool zero_copy, bool async, bool return_recv_hook,
-            const std::optional<torch::Tensor>& out);
+            int timeout_us, bool zero_copy, bool use_fp8, bool async,
+            bool return_recv_hook, const std::optional<torch::Tensor>& out);
 
     torch::Tensor get_next_combine_buffer(int num_max_dispatch_tokens_per_rank,
                                           int hidden, int num_experts);
 
     int init_ibgda();
 
+    int open_nic(ibv_device* device, IbgdaNic& nic);
+
+    int num_qps() const { return num_qp_per_rank_ * num_ranks; }
+
+    size_t nic_of_qp(int qp_idx) const {
+        return (qp_idx % num_qp_per_rank_) % nics_.size();
+    }
+
+    void sync_remote_keys(const std::vector<int64_t>& remote_addrs,
+                          const std::vector<int32_t>& remote_keys);
+
     bool ibgda_disabled() { return ibgda_disabled_; }
 
     bool is_roce() { return is_roce_; }
@@ -171,14 +197,31 @@ struct MooncakeEpBuffer {
         return {(int64_t)mr->addr, (int32_t)mr->rkey};
     }
 
-    std::tuple<int64_t, int64_t> get_gid() {
-        return {(int64_t)gid.global.subnet_prefix,
-                (int64_t)gid.global.interface_id};
+    int get_num_qp_per_rank() { return num_qp_per_rank_; }
+
+    // GIDs of the NICs behind each QP, as subnet prefixes and interface ids
+    std::tuple<std::vector<int64_t>, std::vector<int64_t>> get_local_gids() {
+        std::vector<int64_t> subnet_prefixes, interface_ids;
+        for (int i = 0; i < num_qps(); ++i) {
+            const auto& gid = nics_[nic_of_qp(i)].gid;
+            subnet_prefixes.push_back((int64_t)gid.global.subnet_prefix);
+            interface_ids.push_back((int64_t)gid.global.interface_id);
+        }
+        return {subnet_prefixes, interface_ids};
+    }
+
+    // Keys of `gdr_buffer` on the NICs behind each QP
+    std::vector<int32_t> get_local_rkeys() {
+        std::vector<int32_t> local_rkeys;
+        for (int i = 0; i < num_qps(); ++i) {
+            local_rkeys.push_back((int32_t)nics_[nic_of_qp(i)].mr->rkey);
+        }
+        return local_rkeys;
     }
 
     std::vector<int32_t> get_local_qpns() {
         std::vector<int32_t> local_qpns;
-        for (int i = 0; i < MAX_QP_COUNT; ++i) {
+        for (int i = 0; i < num_qps(); ++i) {
             local_qpns.push_back((int32_t)qps[i]->qpn);
         }
         return local_qpns;
@@ -186,7 +229,7 @@ struct MooncakeEpBuffer {
 
     std::vector<int32_t> get_local_lids() {
         std::vector<int32_t> local_lids;
-        for (int i = 0; i < MAX_QP_COUNT; ++i) {
+        for (int i = 0; i < num_qps(); ++i) {
             local_lids.push_back((int32_t)qps[i]->port_attr.lid);
         }
         return local_lids;
@@ -80,6 +80,8 @@ struct mlx5gda_qp_devctx {
     uint32_t bf_offset;  // toggle on every post
     uint16_t wq_head;    // next free wqeid
     uint16_t wq_tail;    // last non-completed wqeid
+    uint32_t lkey;       // key of the local buffer on the NIC of this QP
+    uint32_t rkey;       // key of the remote buffer on the peer NIC
 };
 
 struct mlx5gda_qp *mlx5gda_create_rc_qp(struct mlx5dv_pd mpd, void *ctrl_buf,
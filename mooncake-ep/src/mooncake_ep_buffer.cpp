@@ -1,5 +1,13 @@
 #include <mooncake_ep_buffer.h>
 #include <arpa/inet.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <sstream>
+#include <string>
 
 namespace mooncake {
 
@@ -46,9 +54,16 @@ MooncakeEpBuffer::MooncakeEpBuffer(int rank, int num_ranks,
                                       device_id));
     CUDA_CHECK(cudaMalloc(&gdr_buffer, num_ep_buffer_bytes));
     CUDA_CHECK(cudaMalloc(&raddrs, num_ranks * sizeof(uint64_t)));
-    CUDA_CHECK(cudaMalloc(&rkeys, num_ranks * sizeof(uint32_t)));
+
+    // QPs per peer, by default `MAX_QP_COUNT` QPs spread over all peers
+    num_qp_per_rank_ = std::max(MAX_QP_COUNT / num_ranks, 1);
+    const char* num_qp_env = std::getenv("MC_EP_NUM_QP_PER_RANK");
+    if (num_qp_env && *num_qp_env) {
+        num_qp_per_rank_ = std::atoi(num_qp_env);
+        EP_HOST_ASSERT(num_qp_per_rank_ > 0);
+    }
     CUDA_CHECK(
-        cudaMalloc(&qp_devctxs, MAX_QP_COUNT * sizeof(mlx5gda_qp_devctx)));
+        cudaMalloc(&qp_devctxs, num_qps() * sizeof(mlx5gda_qp_devctx)));
 
     // Allocate NVLink P2P arrays
     CUDA_CHECK(cudaMalloc(&nvlink_available, num_ranks * sizeof(int32_t)));
@@ -73,7 +88,6 @@ MooncakeEpBuffer::MooncakeEpBuffer(int rank, int num_ranks,
 MooncakeEpBuffer::~MooncakeEpBuffer() noexcept(false) {
     cudaFree(gdr_buffer);
     cudaFree(raddrs);
-    cudaFree(rkeys);
     cudaFree(qp_devctxs);
     if (nvlink_available) cudaFree(nvlink_available);
     if (ipc_peer_ptrs) cudaFree(ipc_peer_ptrs);
@@ -97,7 +111,11 @@ MooncakeEpBuffer::dispatch(const torch::Tensor& x,
                            torch::Tensor& active_ranks,
                            int num_max_dispatch_tokens_per_rank,
                            int num_experts, int timeout_us, bool use_fp8,
-                           bool async, bool return_recv_hook) {
+                           bool async, bool return_recv_hook,
+                           const std::optional<torch::Tensor>&
+                               cumulative_local_expert_recv_stats,
+                           const std::optional<torch::Tensor>&
+                               dispatch_wait_recv_cost_stats) {
     // Tensor checks
     // By default using `ptp128c` FP8 cast
     EP_HOST_ASSERT(x.dim() == 2 and x.is_contiguous() and
@@ -108,7 +126,6 @@ MooncakeEpBuffer::dispatch(const torch::Tensor& x,
                    x.size(0) <= num_max_dispatch_tokens_per_rank);
     EP_HOST_ASSERT(topk_idx.scalar_type() == torch::kInt64);
     EP_HOST_ASSERT(num_experts % num_ranks == 0);
-    EP_HOST_ASSERT(MAX_QP_COUNT % num_ranks == 0);
 
     auto num_tokens = static_cast<int>(x.size(0)),
          hidden = static_cast<int>(x.size(1));
@@ -116,6 +133,24 @@ MooncakeEpBuffer::dispatch(const torch::Tensor& x,
          num_topk = static_cast<int>(topk_idx.size(1));
     int num_local_experts = num_experts / num_ranks;
 
+    // Optional load statistics
+    int* cumulative_local_expert_recv_stats_ptr = nullptr;
+    if (cumulative_local_expert_recv_stats.has_value()) {
+        const auto& stats = cumulative_local_expert_recv_stats.value();
+        EP_HOST_ASSERT(stats.scalar_type() == torch::kInt32);
+        EP_HOST_ASSERT(stats.dim() == 1 and stats.is_contiguous());
+        EP_HOST_ASSERT(stats.size(0) == num_local_experts);
+        cumulative_local_expert_recv_stats_ptr = stats.data_ptr<int>();
+    }
+    int64_t* dispatch_wait_recv_cost_stats_ptr = nullptr;
+    if (dispatch_wait_recv_cost_stats.has_value()) {
+        const auto& stats = dispatch_wait_recv_cost_stats.value();
+        EP_HOST_ASSERT(stats.scalar_type() == torch::kInt64);
+        EP_HOST_ASSERT(stats.dim() == 1 and stats.is_contiguous());
+        EP_HOST_ASSERT(stats.size(0) == num_ranks);
+        dispatch_wait_recv_cost_stats_ptr = stats.data_ptr<int64_t>();
+    }
+
     // Buffer control
     BufferPair layout(gdr_buffer, num_max_dispatch_tokens_per_rank, hidden,
                       num_ranks, num_experts);
@@ -172,9 +207,12 @@ MooncakeEpBuffer::dispatch(const torch::Tensor& x,
             packed_recv_count.data_ptr<int>(), active_ranks.data_ptr<int32_t>(),
             gdr_buffer, buffer.rdma_send_signal_buffer,
             buffer.rdma_recv_signal_buffer, buffer.rdma_send_data_buffer,
-            buffer.rdma_recv_data_buffer, nullptr, nullptr, raddrs, rkeys,
-            qp_devctxs, nvlink_available, ipc_peer_ptrs, x.data_ptr(),
-            topk_idx.data_ptr<int64_t>(), next_buffer.rdma_recv_signal_buffer,
+            buffer.rdma_recv_data_buffer, nullptr, nullptr, raddrs, qp_devctxs,
+            num_qp_per_rank_, nvlink_available, ipc_peer_ptrs, x.data_ptr(),
+            topk_idx.data_ptr<int64_t>(),
+            cumulative_local_expert_recv_stats_ptr,
+            dispatch_wait_recv_cost_stats_ptr,
+            next_buffer.rdma_recv_signal_buffer,
             num_tokens, hidden, num_max_dispatch_tokens_per_rank, num_topk,
             num_experts, rank, num_ranks, use_fp8, workspace, launch_stream,
             timeout_ticks, phases);
@@ -217,8 +255,8 @@ MooncakeEpBuffer::combine(const torch::Tensor& x, const torch::Tensor& topk_idx,
                           const torch::Tensor& layout_range,
                           torch::Tensor& active_ranks,
                           int num_max_dispatch_tokens_per_rank, int num_experts,
-                          int timeout_us, bool zero_copy, bool async,
-                          bool return_recv_hook,
+                          int timeout_us, bool zero_copy, bool use_fp8,
+                          bool async, bool return_recv_hook,
                           const std::optional<torch::Tensor>& out) {
     // Tensor checks
     EP_HOST_ASSERT(x.dim() == 3 and x.is_contiguous() and
@@ -226,6 +264,8 @@ MooncakeEpBuffer::combine(const torch::Tensor& x, const torch::Tensor& topk_idx,
     EP_HOST_ASSERT(x.size(0) == num_experts / num_ranks);
     EP_HOST_ASSERT(x.size(1) == num_ranks * num_max_dispatch_tokens_per_rank);
     EP_HOST_ASSERT(x.size(2) % sizeof(int4) == 0 and x.size(2) % 128 == 0);
+    // FP8 messages are cast from x, so x cannot already be the send buffer
+    EP_HOST_ASSERT(not(use_fp8 and zero_copy));
     EP_HOST_ASSERT(topk_idx.dim() == 2 and topk_idx.is_contiguous());
     EP_HOST_ASSERT(topk_idx.size(0) == topk_weights.size(0) and
                    topk_idx.size(1) == topk_weights.size(1));
@@ -281,14 +321,14 @@ MooncakeEpBuffer::combine(const torch::Tensor& x, const torch::Tensor& topk_idx,
             combined_x.data_ptr(), active_ranks.data_ptr<int32_t>(), gdr_buffer,
             buffer.rdma_send_signal_buffer, buffer.rdma_recv_signal_buffer,
             buffer.rdma_send_data_buffer, buffer.rdma_recv_data_buffer, nullptr,
-            nullptr, raddrs, rkeys, qp_devctxs, nvlink_available, ipc_peer_ptrs,
-            x.data_ptr(), topk_idx.data_ptr<int64_t>(),
+            nullptr, raddrs, qp_devctxs, num_qp_per_rank_, nvlink_available,
+            ipc_peer_ptrs, x.data_ptr(), topk_idx.data_ptr<int64_t>(),
             topk_weights.data_ptr<float>(), src_info.data_ptr<int>(),
             layout_range.data_ptr<int64_t>(),
             next_buffer.rdma_recv_signal_buffer, num_combined_tokens, hidden,
             num_max_dispatch_tokens_per_rank, num_topk, num_experts, rank,
             num_ranks, workspace, launch_stream, timeout_ticks, phases,
-            zero_copy);
+            zero_copy, use_fp8);
     };
     launcher(return_recv_hook
                  ? LOW_LATENCY_SEND_PHASE
@@ -336,25 +376,9 @@ torch::Tensor MooncakeEpBuffer::get_next_combine_buffer(
         torch::TensorOptions().dtype(dtype).device(torch::kCUDA));
 }
 
-int MooncakeEpBuffer::init_ibgda() {
-    int num_devices;
-    ibv_device** dev_list = ibv_get_device_list(&num_devices);
-    int nic_id = -1;
-    for (int i = 0; i < num_devices; ++i) {
-        const char* name = ibv_get_device_name(dev_list[i]);
-        if (name && device_name == name) {
-            nic_id = i;
-            break;
-        }
-    }
-    if (nic_id == -1) {
-        throw std::runtime_error("Device matching name '" + device_name +
-                                 "' not found.");
-    }
-    LOG(INFO) << "[EP] GPU " << device_id << " uses NIC " << nic_id
-              << " out of " << num_devices << " NIC(s)";
-    ibv_context* ctx = ibv_open_device(dev_list[nic_id]);
-    if (!ctx) {
+int MooncakeEpBuffer::open_nic(ibv_device* device, IbgdaNic& nic) {
+    nic.ctx = ibv_open_device(device);
+    if (!nic.ctx) {
         perror("Failed to open device");
         return -1;
     }
@@ -362,63 +386,111 @@ int MooncakeEpBuffer::init_ibgda() {
     // Query port attributes to get GID table length
     ibv_port_attr port_attr;
     const uint8_t port_num = 1;
-    if (ibv_query_port(ctx, port_num, &port_attr)) {
+    if (ibv_query_port(nic.ctx, port_num, &port_attr)) {
         perror("Failed to query port");
         return -1;
     }
 
     // Dynamically find the best GID index (replaces hardcoded index 3)
-    gid_index_ = findBestGidIndex(ctx, port_num, port_attr);
-    if (gid_index_ < 0) {
+    nic.gid_index = findBestGidIndex(nic.ctx, port_num, port_attr);
+    if (nic.gid_index < 0) {
         LOG(ERROR) << "[EP] Failed to find a suitable GID index on "
-                   << device_name;
+                   << ibv_get_device_name(device);
         return -1;
     }
 
-    if (ibv_query_gid(ctx, port_num, gid_index_, &gid)) {
+    if (ibv_query_gid(nic.ctx, port_num, nic.gid_index, &nic.gid)) {
         perror("Failed to query gid");
         return -1;
     }
-    ibv_free_device_list(dev_list);
 
-    ibv_pd* pd = ibv_alloc_pd(ctx);
-    if (!pd) {
+    nic.pd = ibv_alloc_pd(nic.ctx);
+    if (!nic.pd) {
         perror("Failed to allocate protection domain");
         return -1;
     }
-    mlx5dv_pd mpd;
     mlx5dv_obj dv_obj = {};
-    dv_obj.pd.in = pd;
-    dv_obj.pd.out = &mpd;
+    dv_obj.pd.in = nic.pd;
+    dv_obj.pd.out = &nic.mpd;
     if (mlx5dv_init_obj(&dv_obj, MLX5DV_OBJ_PD)) {
         perror("Failed to initialize mlx5dv object");
     }
-    mr = ibv_reg_mr(pd, gdr_buffer, num_ep_buffer_bytes,
-                    IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ |
-                        IBV_ACCESS_REMOTE_WRITE | IBV_ACCESS_REMOTE_ATOMIC);
-    if (!mr) {
+    nic.mr = ibv_reg_mr(nic.pd, gdr_buffer, num_ep_buffer_bytes,
+                        IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ |
+                            IBV_ACCESS_REMOTE_WRITE |
+                            IBV_ACCESS_REMOTE_ATOMIC);
+    if (!nic.mr) {
         perror("Failed to reg mr");
+        return -1;
     }
 
-    // Allocate ctrl_buf without zero-initialization. Individual regions will be
-    // initialized as needed: CQ needs -1 (hardware requirement), DBR needs 0.
-    // WQ doesn't need initialization as it's zeroed before each use.
-    CUDA_CHECK(cudaMalloc(&ctrl_buf, CTRL_BUF_SIZE));
-    mlx5dv_devx_umem* ctrl_buf_umem = mlx5dv_devx_umem_reg(
-        ctx, ctrl_buf, CTRL_BUF_SIZE, IBV_ACCESS_LOCAL_WRITE);
-    if (!ctrl_buf_umem) {
+    nic.ctrl_buf_umem = mlx5dv_devx_umem_reg(nic.ctx, ctrl_buf, CTRL_BUF_SIZE,
+                                             IBV_ACCESS_LOCAL_WRITE);
+    if (!nic.ctrl_buf_umem) {
         perror("Failed to register control buffer as umem");
         fprintf(stderr,
                 "If the error is `Bad address`, probably because your GPU "
                 "does not support GPUDirect RDMA.\n");
-        // Keep internal state consistent: IBGDA init failed, so `mr` must not
-        // be treated as valid.
-        if (mr) {
-            ibv_dereg_mr(mr);
-            mr = nullptr;
-        }
         return -1;
     }
+    return 0;
+}
+
+int MooncakeEpBuffer::init_ibgda() {
+    // `MC_EP_NICS` lists the NICs this GPU stripes over, separated by commas
+    std::vector<std::string> nic_names;
+    const char* nics_env = std::getenv("MC_EP_NICS");
+    std::stringstream nic_list(nics_env && *nics_env ? nics_env : device_name);
+    for (std::string name; std::getline(nic_list, name, ',');) {
+        if (!name.empty()) nic_names.push_back(name);
+    }
+
+    int num_devices;
+    ibv_device** dev_list = ibv_get_device_list(&num_devices);
+    std::vector<ibv_device*> devices;
+    for (const auto& nic_name : nic_names) {
+        int nic_id = -1;
+        for (int i = 0; i < num_devices; ++i) {
+            const char* name = ibv_get_device_name(dev_list[i]);
+            if (name && nic_name == name) {
+                nic_id = i;
+                break;
+            }
+        }
+        if (nic_id == -1) {
+            ibv_free_device_list(dev_list);
+            throw std::runtime_error("Device matching name '" + nic_name +
+                                     "' not found.");
+        }
+        LOG(INFO) << "[EP] GPU " << device_id << " uses NIC " << nic_id
+                  << " out of " << num_devices << " NIC(s)";
+        devices.push_back(dev_list[nic_id]);
+    }
+    if (devices.empty()) {
+        ibv_free_device_list(dev_list);
+        throw std::runtime_error("No NIC given for EP");
+    }
+
+    // Allocate ctrl_buf without zero-initialization. Individual regions will be
+    // initialized as needed: CQ needs -1 (hardware requirement), DBR needs 0.
+    // WQ doesn't need initialization as it's zeroed before each use.
+    CUDA_CHECK(cudaMalloc(&ctrl_buf, CTRL_BUF_SIZE));
+    nics_.resize(devices.size());
+    for (size_t i = 0; i < devices.size(); ++i) {
+        if (open_nic(devices[i], nics_[i])) {
+            ibv_free_device_list(dev_list);
+            // Keep internal state consistent: IBGDA init failed, so `mr`
+            // must not be treated as valid.
+            for (auto& nic : nics_) {
+                if (nic.mr) ibv_dereg_mr(nic.mr);
+                nic.mr = nullptr;
+            }
+            return -1;
+        }
+    }
+    ibv_free_device_list(dev_list);
+    mr = nics_[0].mr;
+
     memheap* ctrl_buf_heap = memheap_create(CTRL_BUF_SIZE);
     if (!ctrl_buf_heap) {
         perror("Failed to create memory heap");
@@ -426,10 +498,11 @@ int MooncakeEpBuffer::init_ibgda() {
     }
     // Individual regions (CQ, DBR) will be initialized as needed via async
     // memset.
-    for (int i = 0; i < MAX_QP_COUNT; ++i) {
-        mlx5gda_qp* qp =
-            mlx5gda_create_rc_qp(mpd, ctrl_buf, ctrl_buf_umem, ctrl_buf_heap,
-                                 pd, 16384, 1, comm_stream.stream());
+    for (int i = 0; i < num_qps(); ++i) {
+        const auto& nic = nics_[nic_of_qp(i)];
+        mlx5gda_qp* qp = mlx5gda_create_rc_qp(
+            nic.mpd, ctrl_buf, nic.ctrl_buf_umem, ctrl_buf_heap, nic.pd,
+            16384, 1, comm_stream.stream());
         if (!qp) {
             perror("Failed to create QP");
             return -1;
@@ -443,6 +516,7 @@ int MooncakeEpBuffer::init_ibgda() {
         // structures
         CUDA_CHECK(cudaStreamSynchronize(comm_stream.stream()));
 
+        // The remote key is filled in once the peers are known
         mlx5gda_qp_devctx qp_devctx = {
             .qpn = qp->qpn,
             .wqeid_mask = qp->num_wqebb - 1,
@@ -450,6 +524,7 @@ int MooncakeEpBuffer::init_ibgda() {
             .cq = (mlx5_cqe64*)(ctrl_buf + qp->send_cq->cq_offset),
             .dbr = (mlx5gda_wq_dbr*)(ctrl_buf + qp->dbr_offset),
             .bf = (char*)qp->uar->reg_addr,
+            .lkey = nic.mr->lkey,
         };
         cudaMemcpy(qp_devctxs + i * sizeof(mlx5gda_qp_devctx), &qp_devctx,
                    sizeof(mlx5gda_qp_devctx), cudaMemcpyHostToDevice);
@@ -458,11 +533,28 @@ int MooncakeEpBuffer::init_ibgda() {
     return 0;
 }
 
+void MooncakeEpBuffer::sync_remote_keys(
+    const std::vector<int64_t>& remote_addrs,
+    const std::vector<int32_t>& remote_keys) {
+    for (int i = 0; i < num_qps(); ++i) {
+        auto rkey = (uint32_t)remote_keys[i];
+        cudaMemcpy(qp_devctxs + i * sizeof(mlx5gda_qp_devctx) +
+                       offsetof(mlx5gda_qp_devctx, rkey),
+                   &rkey, sizeof(uint32_t), cudaMemcpyHostToDevice);
+    }
+    for (int i = 0; i < num_ranks; ++i) {
+        uint64_t raddr =
+            i == rank ? (uint64_t)mr->addr : (uint64_t)remote_addrs[i];
+        cudaMemcpy(raddrs + i * sizeof(uint64_t), &raddr, sizeof(uint64_t),
+                   cudaMemcpyHostToDevice);
+    }
+}
+
 void MooncakeEpBuffer::sync_ib(const std::vector<int64_t>& remote_addrs,
                                const std::vector<int32_t>& remote_keys,
                                const std::vector<int32_t>& remote_qpns,
                                const std::vector<int32_t>& remote_lids) {
-    for (int i = 0; i < MAX_QP_COUNT; ++i) {
+    for (int i = 0; i < num_qps(); ++i) {
         ibv_ah_attr ah_attr = {
             .dlid = (uint16_t)remote_lids[i],
             .port_num = 0,
@@ -477,15 +569,7 @@ void MooncakeEpBuffer::sync_ib(const std::vector<int64_t>& remote_addrs,
             exit(1);
         }
     }
-    for (int i = 0; i < num_ranks; ++i) {
-        uint64_t raddr =
-            i == rank ? (uint64_t)mr->addr : (uint64_t)remote_addrs[i];
-        cudaMemcpy(raddrs + i * sizeof(uint64_t), &raddr, sizeof(uint64_t),
-                   cudaMemcpyHostToDevice);
-        uint32_t rkey = i == rank ? mr->lkey : (uint32_t)remote_keys[i];
-        cudaMemcpy(rkeys + i * sizeof(uint32_t), &rkey, sizeof(uint32_t),
-                   cudaMemcpyHostToDevice);
-    }
+    sync_remote_keys(remote_addrs, remote_keys);
 }
 
 void MooncakeEpBuffer::sync_roce(const std::vector<int64_t>& remote_addrs,
@@ -493,17 +577,15 @@ void MooncakeEpBuffer::sync_roce(const std::vector<int64_t>& remote_addrs,
                                  const std::vector<int32_t>& remote_qpns,
                                  const std::vector<int64_t>& subnet_prefixes,
                                  const std::vector<int64_t>& interface_ids) {
-    for (int i = 0; i < MAX_QP_COUNT; ++i) {
+    for (int i = 0; i < num_qps(); ++i) {
         ibv_gid remote_gid{};
-        remote_gid.global.subnet_prefix =
-            subnet_prefixes[i * num_ranks / MAX_QP_COUNT];
-        remote_gid.global.interface_id =
-            interface_ids[i * num_ranks / MAX_QP_COUNT];
+        remote_gid.global.subnet_prefix = subnet_prefixes[i];
+        remote_gid.global.interface_id = interface_ids[i];
         ibv_ah_attr ah_attr = {};
         ah_attr.is_global = 1;
         ah_attr.grh.dgid = remote_gid;
-        ah_attr.grh.sgid_index =
-            gid_index_;  // Use dynamically discovered GID index
+        // Use the GID index discovered on the NIC of this QP
+        ah_attr.grh.sgid_index = nics_[nic_of_qp(i)].gid_index;
         ah_attr.grh.hop_limit = 1;
         ah_attr.port_num = 1;
         ah_attr.dlid = qps[i]->port_attr.lid | 0xC000;
@@ -517,51 +599,79 @@ void MooncakeEpBuffer::sync_roce(const std::vector<int64_t>& remote_addrs,
             exit(1);
         }
     }
-    for (int i = 0; i < num_ranks; ++i) {
-        uint64_t raddr =
-            i == rank ? (uint64_t)mr->addr : (uint64_t)remote_addrs[i];
-        cudaMemcpy(raddrs + i * sizeof(uint64_t), &raddr, sizeof(uint64_t),
-                   cudaMemcpyHostToDevice);
-        uint32_t rkey = i == rank ? mr->lkey : (uint32_t)remote_keys[i];
-        cudaMemcpy(rkeys + i * sizeof(uint32_t), &rkey, sizeof(uint32_t),
-                   cudaMemcpyHostToDevice);
-    }
+    sync_remote_keys(remote_addrs, remote_keys);
+}
+
+// The IPC handle is followed by the location of the buffer: a hash of the
+// host name and the PCI domain, bus and device of the GPU
+static constexpr size_t kNumLocationInt32s = 5;
+
+static size_t numIpcHandleInt32s() {
+    return (sizeof(cudaIpcMemHandle_t) + sizeof(int32_t) - 1) /
+           sizeof(int32_t);
 }
 
 std::vector<int32_t> MooncakeEpBuffer::get_ipc_handle() {
     cudaIpcMemHandle_t handle;
     CUDA_CHECK(cudaIpcGetMemHandle(&handle, gdr_buffer));
     // Convert handle bytes to int32_t array
-    const size_t handle_size = sizeof(cudaIpcMemHandle_t);
-    const size_t num_int32s =
-        (handle_size + sizeof(int32_t) - 1) / sizeof(int32_t);
-    std::vector<int32_t> handle_ints(num_int32s);
-    memcpy(handle_ints.data(), &handle, handle_size);
+    const size_t num_int32s = numIpcHandleInt32s();
+    std::vector<int32_t> handle_ints(num_int32s + kNumLocationInt32s);
+    memcpy(handle_ints.data(), &handle, sizeof(cudaIpcMemHandle_t));
+
+    char hostname[256] = {};
+    gethostname(hostname, sizeof(hostname) - 1);
+    uint64_t host_hash = std::hash<std::string>{}(hostname);
+    memcpy(&handle_ints[num_int32s], &host_hash, sizeof(host_hash));
+    CUDA_CHECK(cudaDeviceGetAttribute(&handle_ints[num_int32s + 2],
+                                      cudaDevAttrPciDomainId, device_id));
+    CUDA_CHECK(cudaDeviceGetAttribute(&handle_ints[num_int32s + 3],
+                                      cudaDevAttrPciBusId, device_id));
+    CUDA_CHECK(cudaDeviceGetAttribute(&handle_ints[num_int32s + 4],
+                                      cudaDevAttrPciDeviceId, device_id));
     return handle_ints;
 }
 
 void MooncakeEpBuffer::sync_nvlink_ipc_handles(
     const std::vector<std::vector<int32_t>>& remote_handles) {
-    // We assume ranks are grouped by device_count (same node)
-    int device_count = 0;
-    CUDA_CHECK(cudaGetDeviceCount(&device_count));
-
+    // Peers are matched by host and GPU, so any rank layout gets NVLink for
+    // the peers it can reach and IBGDA for the others
+    const size_t num_int32s = numIpcHandleInt32s();
     std::vector<int32_t> nvlink_array(num_ranks, 0);
     nvlink_array[rank] = 1;
+    ipc_peer_ptrs_host[rank] = gdr_buffer;
+
+    auto local_handle = get_ipc_handle();
+    for (int dst_rank = 0; dst_rank < num_ranks; ++dst_rank) {
+        if (dst_rank == rank) continue;
+        if (dst_rank >= static_cast<int>(remote_handles.size())) {
+            LOG(WARNING) << "[EP] Rank " << rank
+                         << " missing IPC handle for rank " << dst_rank;
+            continue;
+        }
+        const auto& handle_ints = remote_handles[dst_rank];
+        if (handle_ints.size() < num_int32s + kNumLocationInt32s) {
+            LOG(WARNING) << "[EP] Rank " << rank
+                         << " invalid IPC handle size for rank " << dst_rank;
+            continue;
+        }
+        // Peers on other hosts are reached over IBGDA
+        if (handle_ints[num_int32s] != local_handle[num_int32s] ||
+            handle_ints[num_int32s + 1] != local_handle[num_int32s + 1]) {
+            continue;
+        }
 
-    int node_id = rank / device_count;
-    int group_start = node_id * device_count;
-    int group_end = std::min(group_start + device_count, num_ranks);
-
-    // Check peer access and enable it within the same node group
-    for (int dst_rank = group_start; dst_rank < group_end; ++dst_rank) {
-        if (dst_rank == rank) {
-            // Local rank - use local pointer
-            ipc_peer_ptrs_host[dst_rank] = gdr_buffer;
+        char pci_bus_id[32];
+        snprintf(pci_bus_id, sizeof(pci_bus_id), "%04x:%02x:%02x.0",
+                 handle_ints[num_int32s + 2], handle_ints[num_int32s + 3],
+                 handle_ints[num_int32s + 4]);
+        int dst_device = -1;
+        if (cudaDeviceGetByPCIBusId(&dst_device, pci_bus_id) != cudaSuccess) {
+            // The peer GPU is not visible to this process
+            cudaGetLastError();
             continue;
         }
 
-        int dst_device = dst_rank % device_count;
         int can_access_peer = 0;
         cudaError_t err =
             cudaDeviceCanAccessPeer(&can_access_peer, device_id, dst_device);
@@ -575,28 +685,10 @@ void MooncakeEpBuffer::sync_nvlink_ipc_handles(
                 if (peer_err == cudaErrorPeerAccessAlreadyEnabled) {
                     cudaGetLastError();
                 }
-                nvlink_array[dst_rank] = 1;
-
-                // Open IPC handle for this peer
-                if (dst_rank >= static_cast<int>(remote_handles.size())) {
-                    LOG(WARNING) << "[EP] Rank " << rank
-                                 << " missing IPC handle for rank " << dst_rank;
-                    continue;
-                }
-
-                const size_t handle_size = sizeof(cudaIpcMemHandle_t);
-                const size_t num_int32s =
-                    (handle_size + sizeof(int32_t) - 1) / sizeof(int32_t);
-                const auto& handle_ints = remote_handles[dst_rank];
-                if (handle_ints.size() < num_int32s) {
-                    LOG(WARNING)
-                        << "[EP] Rank " << rank
-                        << " invalid IPC handle size for rank " << dst_rank;
-                    continue;
-                }
 
                 cudaIpcMemHandle_t remote_handle;
-                memcpy(&remote_handle, handle_ints.data(), handle_size);
+                memcpy(&remote_handle, handle_ints.data(),
+                       sizeof(cudaIpcMemHandle_t));
 
                 void* peer_ptr = nullptr;
                 cudaError_t ipc_err = cudaIpcOpenMemHandle(
@@ -606,8 +698,8 @@ void MooncakeEpBuffer::sync_nvlink_ipc_handles(
                         << "[EP] Rank " << rank
                         << " failed to open IPC handle for rank " << dst_rank
                         << ": " << cudaGetErrorString(ipc_err);
-                    nvlink_array[dst_rank] = 0;
                 } else {
+                    nvlink_array[dst_rank] = 1;
                     ipc_peer_ptrs_host[dst_rank] = peer_ptr;
                 }
             }
@@ -616,26 +708,20 @@ void MooncakeEpBuffer::sync_nvlink_ipc_handles(
 
     // Check if P2P+IPC is available for ALL rank pairs.
     // For P2P+IPC to be fully usable without IBGDA, every rank must be able to
-    // access every other rank via P2P+IPC. Since we only check within the same
-    // node group, all ranks must be in the same node group.
+    // access every other rank via P2P+IPC, which implies a single node.
     p2p_ipc_all_enabled_ = true;
+    int num_nvlink_peers = 0;
     for (int i = 0; i < num_ranks; ++i) {
         // Must have P2P enabled and a valid peer pointer for every rank.
         // Note: for local rank we set ipc_peer_ptrs_host[rank] = gdr_buffer.
         if (nvlink_array[i] == 0 || ipc_peer_ptrs_host[i] == nullptr) {
             p2p_ipc_all_enabled_ = false;
-            break;
-        }
-    }
-    // Verify all ranks are in the same node group (cross-node requires IBGDA)
-    if (p2p_ipc_all_enabled_ && num_ranks > 1) {
-        int first_node_id = 0 / device_count;
-        int last_node_id = (num_ranks - 1) / device_count;
-        if (first_node_id != last_node_id) {
-            // Ranks span multiple nodes, P2P only works within nodes
-            p2p_ipc_all_enabled_ = false;
+        } else if (i != rank) {
+            ++num_nvlink_peers;
         }
     }
+    LOG(INFO) << "[EP] Rank " << rank << " reaches " << num_nvlink_peers
+              << " of " << num_ranks - 1 << " peers over NVLink";
 
     // Copy NVLink availability to device memory
     CUDA_CHECK(cudaMemcpy(nvlink_available, nvlink_array.data(),
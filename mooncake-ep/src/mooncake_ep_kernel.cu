@@ -159,9 +159,10 @@ dispatch(void* packed_recv_x, float* packed_recv_x_scales,
          int* rdma_send_signal_buffer, int* rdma_recv_signal_buffer,
          void* rdma_send_data_buffer, void* rdma_recv_data_buffer,
          void* cuda_counter_buffer, void* cuda_data_buffer,
-         void* raddrs, void* rkeys, void* qp_devctxs,
+         void* raddrs, void* qp_devctxs, int num_qp_per_rank,
          const int32_t* nvlink_available, void* const* ipc_peer_ptrs,
          const void* x, const int64_t* topk_idx,
+         int* cumulative_local_expert_recv_stats, int64_t* dispatch_wait_recv_cost_stats,
          int* atomic_counter_per_expert, int* atomic_finish_counter_per_expert,
          int* next_clean_buffer,
          int num_tokens, int num_max_dispatch_tokens_per_rank,
@@ -194,9 +195,7 @@ dispatch(void* packed_recv_x, float* packed_recv_x_scales,
 
     // IBGDA
     auto raddr_array = reinterpret_cast<uint64_t*>(raddrs);
-    auto rkey_array = reinterpret_cast<uint32_t*>(rkeys);
     auto ctx_array = reinterpret_cast<mlx5gda_qp_devctx*>(qp_devctxs);
-    const size_t num_qp_per_rank = MAX_QP_COUNT / num_ranks;
 
     // Sending phase
     if ((phases & LOW_LATENCY_SEND_PHASE) == 0)
@@ -289,7 +288,7 @@ dispatch(void* packed_recv_x, float* packed_recv_x_scales,
                             uint64_t req_rptr_actual = raddr_array[dst_rank] + ((char *)dst_ptr - (char *)(mxa_buffer));
                             auto ctx = ctx_array + dst_rank * num_qp_per_rank + dst_expert_local_idx % num_qp_per_rank;
                             device_mutex_lock_system(&ctx->mutex);
-                            __mlx5gda_device_write_rdma_write_wqe(ctx, src_ptr, device_byteswap(rkey_array[rank]), req_rptr_actual, device_byteswap(rkey_array[dst_rank]), num_bytes_per_msg);
+                            __mlx5gda_device_write_rdma_write_wqe(ctx, src_ptr, device_byteswap(ctx->lkey), req_rptr_actual, device_byteswap(ctx->rkey), num_bytes_per_msg);
                             __mlx5gda_device_post_send_db(ctx);
                             device_mutex_unlock_system(&ctx->mutex);
                         }
@@ -366,7 +365,7 @@ dispatch(void* packed_recv_x, float* packed_recv_x_scales,
                 uint64_t rptr_actual = (uint64_t)((char *)(raddr_array[dst_rank]) + ((char *)(rdma_recv_signal_buffer + dst_expert_local_idx * num_ranks + rank) - (char *)(mxa_buffer)));
                 auto ctx = ctx_array + dst_rank * num_qp_per_rank + dst_expert_local_idx % num_qp_per_rank;
                 device_mutex_lock_system(&ctx->mutex);
-                __mlx5gda_device_write_rdma_atomic_add_wqe(ctx, -num_tokens_sent - 1, laddr, device_byteswap(rkey_array[rank]), rptr_actual, device_byteswap(rkey_array[dst_rank]));
+                __mlx5gda_device_write_rdma_atomic_add_wqe(ctx, -num_tokens_sent - 1, laddr, device_byteswap(ctx->lkey), rptr_actual, device_byteswap(ctx->rkey));
                 __mlx5gda_device_post_send_db(ctx);
                 device_mutex_unlock_system(&ctx->mutex);
             }
@@ -427,6 +426,12 @@ dispatch(void* packed_recv_x, float* packed_recv_x_scales,
             }
             num_recv_tokens = -num_recv_tokens - 1;
             recv_token_begin_idx = atomicAdd(packed_recv_count + local_expert_idx, num_recv_tokens);
+
+            // Load statistics, accumulated over calls until the caller resets them
+            if (cumulative_local_expert_recv_stats != nullptr)
+                atomicAdd(cumulative_local_expert_recv_stats + local_expert_idx, num_recv_tokens);
+            if (dispatch_wait_recv_cost_stats != nullptr)
+                atomicAdd(reinterpret_cast<unsigned long long*>(dispatch_wait_recv_cost_stats + src_rank), clock64() - start_time);
             shared_num_recv_tokens[warp_group_id] = num_recv_tokens;
             shared_recv_token_begin_idx[warp_group_id] = recv_token_begin_idx;
             recv_range[src_rank] = pack2<int, int64_t>(num_recv_tokens, recv_token_begin_idx);
@@ -471,9 +476,10 @@ void dispatch(void* packed_recv_x, float* packed_recv_x_scales,
               int* rdma_send_signal_buffer, int* rdma_recv_signal_buffer,
               void* rdma_send_data_buffer, void* rdma_recv_data_buffer,
               void* cuda_counter_buffer, void* cuda_data_buffer,
-              void* raddrs, void* rkeys, void* qp_devctxs,
+              void* raddrs, void* qp_devctxs, int num_qp_per_rank,
               const int32_t* nvlink_available, void* const* ipc_peer_ptrs,
               const void* x, const int64_t* topk_idx,
+              int* cumulative_local_expert_recv_stats, int64_t* dispatch_wait_recv_cost_stats,
               int* next_clean_buffer,
               int num_tokens, int hidden, int num_max_dispatch_tokens_per_rank,
               int num_topk, int num_experts, int rank, int num_ranks, bool use_fp8,
@@ -503,9 +509,10 @@ LAUNCH_KERNEL(&cfg, dispatch_func, \
               rdma_send_signal_buffer, rdma_recv_signal_buffer, \
               rdma_send_data_buffer, rdma_recv_data_buffer, \
               cuda_counter_buffer, cuda_data_buffer, \
-              raddrs, rkeys, qp_devctxs, \
+              raddrs, qp_devctxs, num_qp_per_rank, \
               nvlink_available, ipc_peer_ptrs, \
               x, topk_idx, \
+              cumulative_local_expert_recv_stats, dispatch_wait_recv_cost_stats, \
               atomic_counter_per_expert, atomic_finish_counter_per_expert, \
               next_clean_buffer, \
               num_tokens, num_max_dispatch_tokens_per_rank, \
@@ -516,14 +523,14 @@ LAUNCH_KERNEL(&cfg, dispatch_func, \
 #undef DISPATCH_LAUNCH_CASE
 }
 
-template <int kNumWarpGroups, int kNumWarpsPerGroup, int kHidden, int kNumMaxTopk>
+template <bool kUseFP8, int kNumWarpGroups, int kNumWarpsPerGroup, int kHidden, int kNumMaxTopk>
 __global__ __launch_bounds__(kNumWarpGroups * kNumWarpsPerGroup * 32, 1) void
 combine(void* combined_x, int32_t* active_ranks,
         void* mxa_buffer,
         int* rdma_send_signal_buffer, int* rdma_recv_signal_buffer,
         void* rdma_send_data_buffer, void* rdma_recv_data_buffer,
         void* cuda_counter_buffer, void* cuda_data_buffer,
-        void* raddrs, void* rkeys, void* qp_devctxs,
+        void* raddrs, void* qp_devctxs, int num_qp_per_rank,
         const int32_t* nvlink_available, void* const* ipc_peer_ptrs,
         const void* x, const int64_t* topk_idx, const float* topk_weights,
         const int* src_info, const int64_t* layout_range,
@@ -548,15 +555,19 @@ combine(void* combined_x, int32_t* active_ranks,
     constexpr int kNumElemsPerInt4 = sizeof(int4) / sizeof(nv_bfloat16);
     const size_t hidden_bf16_int4 = kHidden / kNumElemsPerInt4;
 
-    // Message package
-    constexpr size_t num_bytes_per_slot = kHidden * sizeof(nv_bfloat16);
+    // FP8 staffs: per-token scales for every 128 channels, as in dispatch
+    constexpr int kNumPerChannels = 128;
+    constexpr float kFP8Margin = 1e-4, kFP8Amax = 448, kFP8AmaxInv = 1.0f / 448.0f;
+    constexpr int kNumScales = kHidden / kNumPerChannels;
+
+    // Message package: hidden data, then FP8 scales
+    constexpr size_t hidden_bytes = kHidden * (kUseFP8 ? sizeof(__nv_fp8_storage_t) : sizeof(nv_bfloat16));
+    constexpr size_t num_bytes_per_slot = hidden_bytes + (kUseFP8 ? kNumScales * sizeof(float) : 0);
     EP_STATIC_ASSERT(num_bytes_per_slot % sizeof(int4) == 0, "Invalid vectorization");
 
     // IBGDA
     auto raddr_array = reinterpret_cast<uint64_t*>(raddrs);
-    auto rkey_array = reinterpret_cast<uint32_t*>(rkeys);
     auto ctx_array = reinterpret_cast<mlx5gda_qp_devctx*>(qp_devctxs);
-    const size_t num_qp_per_rank = MAX_QP_COUNT / num_ranks;
 
     // Sending phase
     if ((phases & LOW_LATENCY_SEND_PHASE) == 0)
@@ -596,34 +607,61 @@ combine(void* combined_x, int32_t* active_ranks,
             const auto rdma_send_type_row = reinterpret_cast<int*>(rdma_send_x_vec + token_idx * num_bytes_per_slot);
             const auto rdma_send_x_vec_row = reinterpret_cast<uint8_t*>(rdma_send_type_row);
 
-            // Copy directly to local rank, or copy to buffer and issue RDMA
+            // Write directly to local or NVLink peers, or to the send buffer and issue RDMA
             auto src_idx = __ldg(local_src_info + token_idx);
             const auto buf_ptr = reinterpret_cast<int64_t>(rdma_send_x_vec_row);
             const auto dst_ptr = reinterpret_cast<uint64_t>(rdma_recv_data_buffer) + (global_expert_idx * num_max_dispatch_tokens_per_rank + src_idx) * num_bytes_per_slot;
-            if (dst_rank == rank) {
-                const auto dst_int4_ptr = reinterpret_cast<int4*>(dst_ptr);
-                UNROLLED_WARP_COPY(7, lane_id, hidden_bf16_int4, dst_int4_ptr, x_int4, ld_nc_global, st_na_global);
-            } else {
-                bool use_nvlink = nvlink_available[dst_rank] != 0;
-                if (use_nvlink) {
-                    size_t offset = (char *)dst_ptr - (char *)(mxa_buffer);
-                    void* peer_dst_ptr = (char *)ipc_peer_ptrs[dst_rank] + offset;
-                    const auto dst_int4_ptr = reinterpret_cast<int4*>(peer_dst_ptr);
-                    UNROLLED_WARP_COPY(7, lane_id, hidden_bf16_int4, dst_int4_ptr, x_int4, ld_nc_global, st_na_global);
-                } else {
-                    const auto buf_int4_ptr = reinterpret_cast<int4*>(buf_ptr);
-                    if (not zero_copy)
-                        UNROLLED_WARP_COPY(7, lane_id, hidden_bf16_int4, buf_int4_ptr, x_int4, ld_nc_global, st_na_global);
-                    __syncwarp();
-
-                    if (lane_id == 0) {
-                        uint64_t req_rptr_actual = raddr_array[dst_rank] + ((char *)dst_ptr - (char *)(mxa_buffer));
-                        auto ctx = ctx_array + dst_rank * num_qp_per_rank + local_expert_idx % num_qp_per_rank;
-                        device_mutex_lock_system(&ctx->mutex);
-                        __mlx5gda_device_write_rdma_write_wqe(ctx, (uint64_t) buf_ptr, device_byteswap(rkey_array[rank]), req_rptr_actual, device_byteswap(rkey_array[dst_rank]), num_bytes_per_slot);
-                        __mlx5gda_device_post_send_db(ctx);
-                        device_mutex_unlock_system(&ctx->mutex);
+            const bool use_rdma = dst_rank != rank and nvlink_available[dst_rank] == 0;
+            auto write_ptr = reinterpret_cast<uint8_t*>(dst_ptr);
+            if (use_rdma)
+                write_ptr = reinterpret_cast<uint8_t*>(buf_ptr);
+            else if (dst_rank != rank)
+                write_ptr = reinterpret_cast<uint8_t*>(ipc_peer_ptrs[dst_rank]) + ((char *)dst_ptr - (char *)(mxa_buffer));
+
+            if (kUseFP8) {
+                // FP8 cast, each half warp owns one 128-channel block
+                const auto fp8_row = reinterpret_cast<int2*>(write_ptr);
+                const auto scales_row = reinterpret_cast<float*>(write_ptr + hidden_bytes);
+                for (int i = lane_id; i < hidden_bf16_int4; i += 32) {
+                    auto int4_value = ld_nc_global(x_int4 + i);
+                    auto bf16_values = reinterpret_cast<nv_bfloat16*>(&int4_value);
+                    float fp32_values[kNumElemsPerInt4];
+                    float amax = kFP8Margin, scale, scale_inv;
+                    #pragma unroll
+                    for (int j = 0; j < kNumElemsPerInt4; ++ j) {
+                        fp32_values[j] = __bfloat162float(bf16_values[j]);
+                        amax = fmaxf(amax, fabsf(fp32_values[j]));
+                    }
+
+                    // Reduce amax and scale
+                    EP_STATIC_ASSERT(kNumElemsPerInt4 * 32 / kNumPerChannels == 2, "Invalid vectorization");
+                    amax = half_warp_reduce_max(amax), scale = kFP8Amax / amax, scale_inv = amax * kFP8AmaxInv;
+                    if (lane_id == 0 or lane_id == 16)
+                        st_na_global(scales_row + i * kNumElemsPerInt4 / kNumPerChannels, scale_inv);
+
+                    int2 int2_value;
+                    auto fp8x2_values = reinterpret_cast<__nv_fp8x2_storage_t*>(&int2_value);
+                    #pragma unroll
+                    for (int j = 0; j < kNumElemsPerInt4; j += 2) {
+                        float2 fp32x2 = {fp32_values[j] * scale, fp32_values[j + 1] * scale};
+                        fp8x2_values[j / 2] = __nv_cvt_float2_to_fp8x2(fp32x2, __NV_SATFINITE, __NV_E4M3);
                     }
+                    st_na_global(fp8_row + i, int2_value);
+                }
+            } else if (not (use_rdma and zero_copy)) {
+                const auto write_int4_ptr = reinterpret_cast<int4*>(write_ptr);
+                UNROLLED_WARP_COPY(7, lane_id, hidden_bf16_int4, write_int4_ptr, x_int4, ld_nc_global, st_na_global);
+            }
+
+            if (use_rdma) {
+                __syncwarp();
+                if (lane_id == 0) {
+                    uint64_t req_rptr_actual = raddr_array[dst_rank] + ((char *)dst_ptr - (char *)(mxa_buffer));
+                    auto ctx = ctx_array + dst_rank * num_qp_per_rank + local_expert_idx % num_qp_per_rank;
+                    device_mutex_lock_system(&ctx->mutex);
+                    __mlx5gda_device_write_rdma_write_wqe(ctx, (uint64_t) buf_ptr, device_byteswap(ctx->lkey), req_rptr_actual, device_byteswap(ctx->rkey), num_bytes_per_slot);
+                    __mlx5gda_device_post_send_db(ctx);
+                    device_mutex_unlock_system(&ctx->mutex);
                 }
             }
         }
@@ -645,7 +683,7 @@ combine(void* combined_x, int32_t* active_ranks,
                     uint64_t req_rptr_actual = (uint64_t)((char *)(raddr_array[dst_rank]) + ((char *)(rdma_recv_signal_buffer + global_expert_idx) - (char *)(mxa_buffer)));
                     auto ctx = ctx_array + dst_rank * num_qp_per_rank + local_expert_idx % num_qp_per_rank;
                     device_mutex_lock_system(&ctx->mutex);
-                    __mlx5gda_device_write_rdma_atomic_add_wqe(ctx, 1, laddr, device_byteswap(rkey_array[rank]), req_rptr_actual, device_byteswap(rkey_array[dst_rank]));
+                    __mlx5gda_device_write_rdma_atomic_add_wqe(ctx, 1, laddr, device_byteswap(ctx->lkey), req_rptr_actual, device_byteswap(ctx->rkey));
                     __mlx5gda_device_post_send_db(ctx);
                     device_mutex_unlock_system(&ctx->mutex);
                 }
@@ -702,12 +740,26 @@ combine(void* combined_x, int32_t* active_ranks,
                 auto rdma_buffer_type = reinterpret_cast<const int*>(reinterpret_cast<uint8_t*>(rdma_recv_data_buffer) + (reg_topk_idx[i] * num_max_dispatch_tokens_per_rank + token_idx) * num_bytes_per_slot);
                 auto rdma_buffer_row = reinterpret_cast<const uint8_t*>(rdma_buffer_type);
 
-                // Reduce
-                auto x_vec = ld_nc_global(reinterpret_cast<const int4*>(rdma_buffer_row) + thread_id);
-                const auto x_bf16 = reinterpret_cast<nv_bfloat16*>(&x_vec);
-                #pragma unroll
-                for (int j = 0; j < kNumElemsPerInt4; ++ j)
-                    combined_values[j] += __bfloat162float(x_bf16[j]) * reg_topk_weights[i];
+                // Reduce, in the same top-k order on every run
+                if (kUseFP8) {
+                    auto x_vec = ld_nc_global(reinterpret_cast<const int2*>(rdma_buffer_row) + thread_id);
+                    const auto x_fp8x2 = reinterpret_cast<__nv_fp8x2_storage_t*>(&x_vec);
+                    const auto scale_inv = ld_nc_global(reinterpret_cast<const float*>(rdma_buffer_row + hidden_bytes) +
+                                                        thread_id * kNumElemsPerInt4 / kNumPerChannels);
+                    const auto weight = scale_inv * reg_topk_weights[i];
+                    #pragma unroll
+                    for (int j = 0; j < kNumElemsPerInt4; j += 2) {
+                        auto fp32x2 = __half22float2(__half2(__nv_cvt_fp8x2_to_halfraw2(x_fp8x2[j / 2], __NV_E4M3)));
+                        combined_values[j] += fp32x2.x * weight;
+                        combined_values[j + 1] += fp32x2.y * weight;
+                    }
+                } else {
+                    auto x_vec = ld_nc_global(reinterpret_cast<const int4*>(rdma_buffer_row) + thread_id);
+                    const auto x_bf16 = reinterpret_cast<nv_bfloat16*>(&x_vec);
+                    #pragma unroll
+                    for (int j = 0; j < kNumElemsPerInt4; ++ j)
+                        combined_values[j] += __bfloat162float(x_bf16[j]) * reg_topk_weights[i];
+                }
             }
 
             // Write results
@@ -726,7 +778,7 @@ void combine(void* combined_x, int32_t* active_ranks,
              int* rdma_send_signal_buffer, int* rdma_recv_signal_buffer,
              void* rdma_send_data_buffer, void* rdma_recv_data_buffer,
              void* cuda_counter_buffer, void* cuda_data_buffer,
-             void* raddrs, void* rkeys, void* qp_devctxs,
+             void* raddrs, void* qp_devctxs, int num_qp_per_rank,
              const int32_t* nvlink_available, void* const* ipc_peer_ptrs,
              const void* x, const int64_t* topk_idx, const float* topk_weights,
              const int* src_info, const int64_t* layout_range,
@@ -734,7 +786,7 @@ void combine(void* combined_x, int32_t* active_ranks,
              int num_combined_tokens, int hidden, int num_max_dispatch_tokens_per_rank,
              int num_topk, int num_experts, int rank, int num_ranks,
              void* workspace, cudaStream_t stream,
-             int64_t timeout_ticks, int phases, bool zero_copy) {
+             int64_t timeout_ticks, int phases, bool zero_copy, bool use_fp8) {
     constexpr int kNumWarpsPerGroup = 4;
     constexpr int kNumWarpGroups = 8;
     constexpr int kNumMaxTopk = 11;
@@ -748,14 +800,15 @@ void combine(void* combined_x, int32_t* active_ranks,
     EP_HOST_ASSERT(num_topk <= kNumMaxTopk);
 
 #define COMBINE_LAUNCH_CASE(hidden) { \
-auto combine_func = combine<kNumWarpGroups, kNumWarpsPerGroup, hidden, kNumMaxTopk>; \
+auto combine_func = use_fp8 ? combine<true, kNumWarpGroups, kNumWarpsPerGroup, hidden, kNumMaxTopk> : \
+                             combine<false, kNumWarpGroups, kNumWarpsPerGroup, hidden, kNumMaxTopk>; \
 LAUNCH_KERNEL(&cfg, combine_func, \
               combined_x, active_ranks, \
               mxa_buffer, \
               rdma_send_signal_buffer, rdma_recv_signal_buffer, \
               rdma_send_data_buffer, rdma_recv_data_buffer, \
               cuda_counter_buffer, cuda_data_buffer, \
-              raddrs, rkeys, qp_devctxs, \
+              raddrs, qp_devctxs, num_qp_per_rank, \
               nvlink_available, ipc_peer_ptrs, \
               x, topk_idx, topk_weights, src_info, layout_range, \
               next_clean_buffer, \
@@ -28,7 +28,9 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
         .def("sync_ib", &MooncakeEpBuffer::sync_ib)
         .def("sync_roce", &MooncakeEpBuffer::sync_roce)
         .def("get_mr_info", &MooncakeEpBuffer::get_mr_info)
-        .def("get_gid", &MooncakeEpBuffer::get_gid)
+        .def("get_num_qp_per_rank", &MooncakeEpBuffer::get_num_qp_per_rank)
+        .def("get_local_gids", &MooncakeEpBuffer::get_local_gids)
+        .def("get_local_rkeys", &MooncakeEpBuffer::get_local_rkeys)
         .def("get_local_qpns", &MooncakeEpBuffer::get_local_qpns)
         .def("get_local_lids", &MooncakeEpBuffer::get_local_lids)
         .def("get_ipc_handle", &MooncakeEpBuffer::get_ipc_handle)
@@ -3,6 +3,57 @@ import functools
 from mooncake.store import MooncakeDistributedStore
 
 class MooncakeDistributedStoreAsync(MooncakeDistributedStore):
+    # get_into and put_from complete through the completion queue of the
+    # client instead of blocking a thread of the executor, so one event loop
+    # can keep many transfers in flight. The buffers must stay valid until
+    # the awaitables complete.
+    async def async_get_into(self, key, buffer_ptr, size):
+        future = self._completion_future()
+        self.get_into_async(key, buffer_ptr, size,
+                            self._completion_callback(future))
+        return await future
+
+    async def async_put_from(self, key, buffer_ptr, size, config=None):
+        future = self._completion_future()
+        callback = self._completion_callback(future)
+        if config is None:
+            self.put_from_async(key, buffer_ptr, size, callback)
+        else:
+            self.put_from_async(key, buffer_ptr, size, callback, config)
+        return await future
+
+    async def async_batch_get_into(self, keys, buffer_ptrs, sizes):
+        return await asyncio.gather(*(
+            self.async_get_into(key, buffer_ptr, size)
+            for key, buffer_ptr, size in zip(keys, buffer_ptrs, sizes)))
+
+    async def async_batch_get_into_stream(self, keys, buffer_ptrs, sizes):
+        # Yields (index, result) in the order of the keys, each as soon as
+        # the key and all keys before it are done
+        loop = asyncio.get_running_loop()
+        queue = asyncio.Queue()
+        self.batch_get_into_stream(
+            keys, buffer_ptrs, sizes,
+            lambda index, result: loop.call_soon_threadsafe(
+                queue.put_nowait, (index, result)))
+        for _ in range(len(keys)):
+            yield await queue.get()
+
+    @staticmethod
+    def _completion_future():
+        return asyncio.get_running_loop().create_future()
+
+    @staticmethod
+    def _completion_callback(future):
+        loop = future.get_loop()
+
+        def set_result(result):
+            if not future.done():
+                future.set_result(result)
+
+        # Called from a thread of the client
+        return lambda result: loop.call_soon_threadsafe(set_result, result)
+
     def __getattr__(self, name: str):
         if not name.startswith("async_"):
             raise AttributeError(f"'{type(self).__name__}' object has no attribute '{name}'")
@@ -20,6 +20,8 @@ struct PyTensorInfo {
     uintptr_t data_ptr;
     size_t tensor_size;
     TensorMetadata metadata;
+    // Data lives in GPU memory and must not be touched by the CPU
+    bool is_cuda = false;
 
     // Check validity
     bool valid() const {
@@ -62,6 +64,17 @@ struct PyTensorInfo {
     }
 };
 
+// Result of one key of batch_get_tensor_into_slots, returned to Python as a
+// record of a numpy structured array
+struct TensorSlot {
+    int64_t status;  // 0 or the negative error code
+    int32_t dtype;
+    int32_t ndim;
+    int64_t shape[4];
+    uint64_t offset;  // of the tensor data in the output buffer
+    uint64_t nbytes;
+};
+
 PyTensorInfo extract_tensor_info(const py::object &tensor,
                                  const std::string &key_name = "") {
     PyTensorInfo info = {
@@ -81,6 +94,14 @@ PyTensorInfo extract_tensor_info(const py::object &tensor,
 
     try {
         info.data_ptr = tensor.attr("data_ptr")().cast<uintptr_t>();
+        info.is_cuda = tensor.attr("is_cuda").cast<bool>();
+        if (info.is_cuda &&
+            !tensor.attr("is_contiguous")().cast<bool>()) {
+            LOG(ERROR) << "CUDA tensor"
+                       << (key_name.empty() ? "" : " for " + key_name)
+                       << " is not contiguous";
+            return {0, 0, {}};
+        }
         size_t numel = tensor.attr("numel")().cast<size_t>();
         size_t element_size = tensor.attr("element_size")().cast<size_t>();
         info.tensor_size = numel * element_size;
@@ -119,6 +140,180 @@ PyTensorInfo extract_tensor_info(const py::object &tensor,
     return info;
 }
 
+// A quantized tensor is stored with kQuantizedDtypeFlag set in the dtype of
+// its TensorMetadata, which otherwise keeps the dtype and shape of the
+// original tensor. The metadata is followed by a QuantizationHeader, one
+// float32 scale per row of the last dimension, and the quantized values.
+// Readers without quantization support reject the unknown dtype.
+constexpr int32_t kQuantizedDtypeFlag = 0x100;
+
+struct QuantizationHeader {
+    int32_t dtype;  // INT8 or FLOAT8_E4M3
+    int32_t reserved;
+    int64_t num_scales;
+};
+
+// Name of the torch dtype of the tensors that can be quantized
+const char *quantizable_torch_dtype(TensorDtype dtype) {
+    switch (dtype) {
+        case TensorDtype::FLOAT32:
+            return "float32";
+        case TensorDtype::FLOAT64:
+            return "float64";
+        case TensorDtype::FLOAT16:
+            return "float16";
+        case TensorDtype::BFLOAT16:
+            return "bfloat16";
+        default:
+            return nullptr;
+    }
+}
+
+// Parses the quantize argument of put_tensor, UNKNOWN for no quantization
+bool parse_quantize_mode(const std::string &mode, TensorDtype &dtype) {
+    if (mode.empty() || mode == "none") {
+        dtype = TensorDtype::UNKNOWN;
+    } else if (mode == "int8") {
+        dtype = TensorDtype::INT8;
+    } else if (mode == "fp8") {
+        dtype = TensorDtype::FLOAT8_E4M3;
+    } else {
+        LOG(ERROR) << "Unsupported quantize mode: " << mode;
+        return false;
+    }
+    return true;
+}
+
+// Quantizes the tensor with symmetric per-row scales, on its own device, and
+// returns a host uint8 tensor with the QuantizationHeader, the scales and the
+// values. On success info is updated to describe it. Only the quantized
+// bytes of a CUDA tensor are copied to host memory.
+py::object quantize_tensor(const py::object &tensor, TensorDtype qdtype,
+                           PyTensorInfo &info, const std::string &key) {
+    auto dtype = static_cast<TensorDtype>(info.metadata.dtype);
+    if (!quantizable_torch_dtype(dtype)) {
+        LOG(ERROR) << "Tensor for " << key << " of dtype "
+                   << info.metadata.dtype << " cannot be quantized";
+        return py::none();
+    }
+    try {
+        auto torch = torch_module();
+        const int64_t cols =
+            info.metadata.ndim > 0 ? info.metadata.shape[info.metadata.ndim - 1]
+                                   : 1;
+        py::object rows = tensor.attr("float")().attr("reshape")(-1, cols);
+        const double qmax = qdtype == TensorDtype::INT8 ? 127.0 : 448.0;
+        py::object scales =
+            rows.attr("abs")()
+                .attr("amax")(py::arg("dim") = 1, py::arg("keepdim") = true)
+                .attr("clamp")(py::arg("min") = 1e-12)
+                .attr("div")(qmax);
+        py::object values = rows.attr("div")(scales);
+        if (qdtype == TensorDtype::INT8) {
+            values = values.attr("round")()
+                         .attr("clamp")(-qmax, qmax)
+                         .attr("to")(torch.attr("int8"));
+        } else {
+            values = values.attr("clamp")(-qmax, qmax)
+                         .attr("to")(torch.attr("float8_e4m3fn"));
+        }
+
+        QuantizationHeader header{static_cast<int32_t>(qdtype), 0,
+                                  rows.attr("shape")[py::int_(0)]
+                                      .cast<int64_t>()};
+        py::object packed = torch.attr("cat")(py::make_tuple(
+            scales.attr("reshape")(-1).attr("view")(torch.attr("uint8")),
+            values.attr("reshape")(-1).attr("view")(torch.attr("uint8"))));
+        const int64_t packed_size = packed.attr("numel")().cast<int64_t>();
+        py::object payload = torch.attr("empty")(
+            static_cast<int64_t>(sizeof(QuantizationHeader)) + packed_size,
+            py::arg("dtype") = torch.attr("uint8"));
+        payload.attr("narrow")(0, sizeof(QuantizationHeader), packed_size)
+            .attr("copy_")(packed);
+        auto payload_ptr = payload.attr("data_ptr")().cast<uintptr_t>();
+        memcpy(reinterpret_cast<void *>(payload_ptr), &header, sizeof(header));
+
+        info.data_ptr = payload_ptr;
+        info.tensor_size = sizeof(QuantizationHeader) + packed_size;
+        info.metadata.dtype |= kQuantizedDtypeFlag;
+        info.is_cuda = false;
+        return payload;
+    } catch (const std::exception &e) {
+        LOG(ERROR) << "Failed to quantize tensor for " << key << ": "
+                   << e.what();
+        return py::none();
+    }
+}
+
+// Dequantizes the payload written by quantize_tensor, a uint8 tensor on any
+// device, on that device
+py::object dequantize_tensor(const py::object &payload,
+                             const TensorMetadata &metadata) {
+    try {
+        auto torch = torch_module();
+        auto dtype =
+            static_cast<TensorDtype>(metadata.dtype & ~kQuantizedDtypeFlag);
+        const char *torch_dtype = quantizable_torch_dtype(dtype);
+        const int64_t size = payload.attr("numel")().cast<int64_t>();
+        if (!torch_dtype || metadata.ndim < 0 || metadata.ndim > 4 ||
+            size < static_cast<int64_t>(sizeof(QuantizationHeader))) {
+            LOG(ERROR) << "Invalid quantized tensor metadata: dtype="
+                       << metadata.dtype << ", size=" << size;
+            return py::none();
+        }
+
+        QuantizationHeader header;
+        py::object header_bytes =
+            payload.attr("narrow")(0, 0, sizeof(QuantizationHeader))
+                .attr("cpu")();
+        memcpy(&header,
+               reinterpret_cast<void *>(
+                   header_bytes.attr("data_ptr")().cast<uintptr_t>()),
+               sizeof(header));
+
+        py::object qdtype;
+        if (header.dtype == static_cast<int32_t>(TensorDtype::INT8)) {
+            qdtype = torch.attr("int8");
+        } else if (header.dtype ==
+                   static_cast<int32_t>(TensorDtype::FLOAT8_E4M3)) {
+            qdtype = torch.attr("float8_e4m3fn");
+        } else {
+            LOG(ERROR) << "Invalid quantized dtype " << header.dtype;
+            return py::none();
+        }
+        const int64_t scales_size = header.num_scales * sizeof(float);
+        const int64_t values_size =
+            size - sizeof(QuantizationHeader) - scales_size;
+        if (header.num_scales <= 0 || values_size < 0 ||
+            values_size % header.num_scales != 0) {
+            LOG(ERROR) << "Invalid quantized tensor: " << header.num_scales
+                       << " scales, " << values_size << " bytes of values";
+            return py::none();
+        }
+
+        py::object scales = payload
+                                .attr("narrow")(0, sizeof(QuantizationHeader),
+                                                scales_size)
+                                .attr("view")(torch.attr("float32"))
+                                .attr("reshape")(-1, 1);
+        py::object values =
+            payload
+                .attr("narrow")(0, sizeof(QuantizationHeader) + scales_size,
+                                values_size)
+                .attr("view")(qdtype)
+                .attr("reshape")(header.num_scales, -1);
+        py::object tensor = values.attr("float")()
+                                .attr("mul")(scales)
+                                .attr("to")(torch.attr(torch_dtype));
+        std::vector<int64_t> shape(metadata.shape,
+                                   metadata.shape + metadata.ndim);
+        return tensor.attr("reshape")(py::cast(shape));
+    } catch (const std::exception &e) {
+        LOG(ERROR) << "Failed to dequantize tensor: " << e.what();
+        return py::none();
+    }
+}
+
 pybind11::object buffer_to_tensor(BufferHandle *buffer_handle, char *usr_buffer,
                                   int64_t data_length) {
     if (!buffer_handle && !usr_buffer) return pybind11::none();
@@ -156,6 +351,26 @@ pybind11::object buffer_to_tensor(BufferHandle *buffer_handle, char *usr_buffer,
     TensorMetadata metadata;
     memcpy(&metadata, exported_data, sizeof(TensorMetadata));
 
+    if (metadata.dtype & kQuantizedDtypeFlag) {
+        py::object tensor = py::none();
+        try {
+            const auto payload_size =
+                static_cast<int64_t>(total_length - sizeof(TensorMetadata));
+            py::object payload = torch_module().attr("empty")(
+                payload_size, py::arg("dtype") = torch_module().attr("uint8"));
+            memcpy(reinterpret_cast<void *>(
+                       payload.attr("data_ptr")().cast<uintptr_t>()),
+                   exported_data + sizeof(TensorMetadata), payload_size);
+            tensor = dequantize_tensor(payload, metadata);
+        } catch (const std::exception &e) {
+            LOG(ERROR) << "Failed to read quantized tensor: " << e.what();
+        }
+        if (take_ownership) {
+            delete[] exported_data;
+        }
+        return tensor;
+    }
+
     if (metadata.ndim < 0 || metadata.ndim > 4) {
         if (take_ownership) {
             delete[] exported_data;
@@ -225,17 +440,21 @@ pybind11::object buffer_to_tensor(BufferHandle *buffer_handle, char *usr_buffer,
     }
 }
 
+std::vector<void *> CastAddrs2Ptrs(const std::vector<uintptr_t> &buffer_ptrs) {
+    std::vector<void *> ptrs;
+    ptrs.reserve(buffer_ptrs.size());
+    for (uintptr_t ptr : buffer_ptrs) {
+        ptrs.push_back(reinterpret_cast<void *>(ptr));
+    }
+    return ptrs;
+}
+
 std::vector<std::vector<void *>> CastAddrs2Ptrs(
     const std::vector<std::vector<uintptr_t>> &all_buffer_ptrs) {
     std::vector<std::vector<void *>> all_buffers;
     all_buffers.reserve(all_buffer_ptrs.size());
     for (auto &buffer_ptrs : all_buffer_ptrs) {
-        std::vector<void *> ptrs;
-        ptrs.reserve(buffer_ptrs.size());
-        for (uintptr_t ptr : buffer_ptrs) {
-            ptrs.push_back(reinterpret_cast<void *>(ptr));
-        }
-        all_buffers.emplace_back(std::move(ptrs));
+        all_buffers.emplace_back(CastAddrs2Ptrs(buffer_ptrs));
     }
     return all_buffers;
 }
@@ -247,6 +466,26 @@ inline int to_py_ret(ErrorCode error_code) {
 }
 }  // namespace
 // Python-specific wrapper functions that handle GIL and return pybind11 types
+// Callback of an asynchronous operation calling a Python function from a
+// thread of the client. The function is only copied and released with the
+// GIL held.
+template <typename... Result>
+std::function<void(Result...)> WrapAsyncCallback(py::function callback) {
+    std::shared_ptr<py::function> function(
+        new py::function(std::move(callback)), [](py::function *f) {
+            py::gil_scoped_acquire acquire_gil;
+            delete f;
+        });
+    return [function](Result... result) {
+        py::gil_scoped_acquire acquire_gil;
+        try {
+            (*function)(result...);
+        } catch (py::error_already_set &e) {
+            LOG(ERROR) << "Async callback failed: " << e.what();
+        }
+    };
+}
+
 class MooncakeStorePyWrapper {
    public:
     std::shared_ptr<PyClient> store_{nullptr};
@@ -307,6 +546,41 @@ class MooncakeStorePyWrapper {
         }
     }
 
+    // Reads length bytes at offset of an object, without transferring the
+    // rest of it
+    pybind11::bytes get_range(const std::string &key, uint64_t offset,
+                              size_t length) {
+        const auto kNullString = pybind11::bytes("\\0", 0);
+        if (!is_client_initialized() || use_dummy_client_) {
+            LOG(ERROR) << "Client not initialized or Dummy client not "
+                          "supported for range reads";
+            return kNullString;
+        }
+        if (length == 0) {
+            return kNullString;
+        }
+
+        std::optional<BufferHandle> buffer_handle;
+        {
+            py::gil_scoped_release release_gil;
+            auto alloc_result =
+                store_->client_buffer_allocator_->allocate(length);
+            if (!alloc_result) {
+                LOG(ERROR) << "Failed to allocate buffer for range of key: "
+                           << key;
+            } else if (store_->get_object_ranges_into(key, {offset},
+                                                      {alloc_result->ptr()},
+                                                      {length}) >= 0) {
+                buffer_handle.emplace(std::move(*alloc_result));
+            }
+        }
+        if (!buffer_handle) {
+            return kNullString;
+        }
+        return pybind11::bytes(static_cast<char *>(buffer_handle->ptr()),
+                               length);
+    }
+
     std::vector<pybind11::bytes> get_batch(
         const std::vector<std::string> &keys) {
         const auto kNullString = pybind11::bytes("\\0", 0);
@@ -417,6 +691,149 @@ class MooncakeStorePyWrapper {
         return buffer_to_tensor(NULL, buffer, total_length);
     }
 
+    // Reads the tensor stored under the key into a pre-allocated tensor of
+    // the same dtype and size. For CUDA tensors registered with
+    // register_device_buffer the data lands in GPU memory via GPUDirect RDMA,
+    // and only the metadata header goes through the client buffer.
+    int64_t get_tensor_into_device(const std::string &key,
+                                   pybind11::object tensor) {
+        if (!is_client_initialized()) {
+            LOG(ERROR) << "Client is not initialized";
+            return to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+
+        if (use_dummy_client_) {
+            LOG(ERROR) << "get_tensor_into_device is not supported for dummy "
+                          "client now";
+            return to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+
+        auto info = extract_tensor_info(tensor, key);
+        if (!info.valid()) return to_py_ret(ErrorCode::INVALID_PARAMS);
+
+        TensorMetadata metadata;
+        int64_t total_length;
+        {
+            py::gil_scoped_release release_gil;
+            auto alloc_result = store_->client_buffer_allocator_->allocate(
+                sizeof(TensorMetadata));
+            if (!alloc_result) {
+                LOG(ERROR) << "Failed to allocate header buffer for key: "
+                           << key;
+                return to_py_ret(ErrorCode::BUFFER_OVERFLOW);
+            }
+
+            std::vector<void *> buffers = {
+                alloc_result->ptr(), reinterpret_cast<void *>(info.data_ptr)};
+            std::vector<size_t> sizes = {sizeof(TensorMetadata),
+                                         info.tensor_size};
+            total_length = store_->get_into_ranges(key, buffers, sizes);
+            if (total_length < 0) return total_length;
+            memcpy(&metadata, alloc_result->ptr(), sizeof(TensorMetadata));
+        }
+
+        if (metadata.dtype == (info.metadata.dtype | kQuantizedDtypeFlag)) {
+            // The quantized bytes landed at the start of the tensor, they are
+            // dequantized on its device and written over it
+            try {
+                const auto payload_size =
+                    static_cast<int64_t>(total_length - sizeof(TensorMetadata));
+                py::object payload =
+                    tensor.attr("reshape")(-1)
+                        .attr("view")(torch_module().attr("uint8"))
+                        .attr("narrow")(0, 0, payload_size)
+                        .attr("clone")();
+                py::object values = dequantize_tensor(payload, metadata);
+                if (values.is_none() ||
+                    values.attr("numel")().cast<int64_t>() !=
+                        tensor.attr("numel")().cast<int64_t>()) {
+                    LOG(ERROR) << "Quantized tensor of key " << key
+                               << " does not match the target tensor";
+                    return to_py_ret(ErrorCode::INVALID_PARAMS);
+                }
+                tensor.attr("copy_")(
+                    values.attr("reshape")(tensor.attr("shape")));
+            } catch (const std::exception &e) {
+                LOG(ERROR) << "Failed to dequantize tensor of key " << key
+                           << ": " << e.what();
+                return to_py_ret(ErrorCode::INVALID_PARAMS);
+            }
+            return static_cast<int64_t>(info.tensor_size);
+        }
+
+        if (static_cast<size_t>(total_length) !=
+                sizeof(TensorMetadata) + info.tensor_size ||
+            metadata.dtype != info.metadata.dtype) {
+            LOG(ERROR) << "Tensor of key " << key
+                       << " does not match the target tensor: length="
+                       << total_length << ", dtype=" << metadata.dtype;
+            return to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+        return static_cast<int64_t>(info.tensor_size);
+    }
+
+    // Reads key i into the slot at i * slot_size of the output buffer, with
+    // the GIL released for the whole batch. The metadata is parsed in C++ and
+    // returned as one structured array, so no Python object is built per key.
+    py::array batch_get_tensor_into_slots(const std::vector<std::string> &keys,
+                                          uintptr_t buffer_ptr,
+                                          size_t slot_size) {
+        std::vector<TensorSlot> slots(keys.size());
+        for (auto &slot : slots) {
+            slot.status = to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+
+        if (!is_client_initialized() || use_dummy_client_) {
+            LOG(ERROR) << "Client not initialized or Dummy client not "
+                          "supported for tensors";
+        } else if (slot_size <= sizeof(TensorMetadata)) {
+            LOG(ERROR) << "Slot size " << slot_size
+                       << " leaves no room for tensor data";
+        } else {
+            py::gil_scoped_release release_gil;
+            char *base = reinterpret_cast<char *>(buffer_ptr);
+            std::vector<void *> buffers(keys.size());
+            std::vector<size_t> sizes(keys.size(), slot_size);
+            for (size_t i = 0; i < keys.size(); ++i) {
+                buffers[i] = base + i * slot_size;
+            }
+            auto total_lengths = store_->batch_get_into(keys, buffers, sizes);
+
+            for (size_t i = 0; i < keys.size(); ++i) {
+                auto &slot = slots[i];
+                if (total_lengths[i] < 0) {
+                    slot.status = total_lengths[i];
+                    continue;
+                }
+                const size_t total_length = total_lengths[i];
+                TensorMetadata metadata;
+                memcpy(&metadata, buffers[i], sizeof(TensorMetadata));
+                if (total_length <= sizeof(TensorMetadata) ||
+                    metadata.ndim < 0 || metadata.ndim > 4 ||
+                    metadata.dtype < 0 ||
+                    metadata.dtype >=
+                        static_cast<int32_t>(TensorDtype::NR_DTYPES)) {
+                    LOG(ERROR) << "Invalid tensor metadata for key " << keys[i];
+                    continue;
+                }
+                slot.status = 0;
+                slot.dtype = metadata.dtype;
+                slot.ndim = metadata.ndim;
+                std::copy(std::begin(metadata.shape), std::end(metadata.shape),
+                          std::begin(slot.shape));
+                slot.offset = i * slot_size + sizeof(TensorMetadata);
+                slot.nbytes = total_length - sizeof(TensorMetadata);
+            }
+        }
+
+        py::array_t<TensorSlot> result(slots.size());
+        if (!slots.empty()) {
+            memcpy(result.mutable_data(), slots.data(),
+                   slots.size() * sizeof(TensorSlot));
+        }
+        return std::move(result);
+    }
+
     pybind11::list batch_get_tensor_into(
         const std::vector<std::string> &keys,
         const std::vector<uintptr_t> &buffer_ptrs,
@@ -500,6 +917,125 @@ class MooncakeStorePyWrapper {
         return get_tensor_into(tp_key, buffer_ptr, size);
     }
 
+    // Reads the slice of tensor parallel rank tp_rank of a whole tensor put
+    // with put_tensor, as torch.chunk(tp_size, split_dim) would cut it. Only
+    // the header and the bytes of the slice are transferred, so readers may
+    // use any tp_size whatever the writer used.
+    pybind11::object get_tensor_shard_into(const std::string &key,
+                                           uintptr_t buffer_ptr, size_t size,
+                                           int tp_rank, int tp_size,
+                                           int split_dim = 0) {
+        if (!is_client_initialized() || use_dummy_client_) {
+            LOG(ERROR) << "Client not initialized or Dummy client not "
+                          "supported for tensors";
+            return pybind11::none();
+        }
+        if (tp_size < 1 || tp_rank < 0 || tp_rank >= tp_size ||
+            size <= sizeof(TensorMetadata)) {
+            LOG(ERROR) << "Invalid tp_rank " << tp_rank << " of tp_size "
+                       << tp_size << " or buffer size " << size;
+            return pybind11::none();
+        }
+        char *buffer = reinterpret_cast<char *>(buffer_ptr);
+
+        int64_t total_length = -1;
+        {
+            py::gil_scoped_release release_gil;
+
+            // The header gives the layout of the tensor
+            int64_t object_size = store_->get_object_ranges_into(
+                key, {0}, {buffer}, {sizeof(TensorMetadata)});
+            if (object_size < 0) {
+                total_length = object_size;
+            } else if (static_cast<size_t>(object_size) <=
+                       sizeof(TensorMetadata)) {
+                LOG(ERROR) << "Object of key " << key << " is not a tensor";
+            } else {
+                total_length = read_tensor_shard(
+                    key, buffer, size, object_size, tp_rank, tp_size,
+                    split_dim);
+            }
+        }
+        return buffer_to_tensor(NULL, buffer, total_length);
+    }
+
+    // Reads the shard after its header is read into the buffer, and rewrites
+    // the header to the shape of the shard. Returns the length of the header
+    // and the shard, negative on error.
+    int64_t read_tensor_shard(const std::string &key, char *buffer,
+                              size_t size, uint64_t object_size, int tp_rank,
+                              int tp_size, int split_dim) {
+        TensorMetadata metadata;
+        memcpy(&metadata, buffer, sizeof(TensorMetadata));
+        if (metadata.ndim < 1 || metadata.ndim > 4 || split_dim < 0 ||
+            split_dim >= metadata.ndim) {
+            LOG(ERROR) << "Cannot split dim " << split_dim << " of tensor "
+                       << key << " with ndim " << metadata.ndim;
+            return to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+        uint64_t numel = 1;
+        for (int i = 0; i < metadata.ndim; ++i) {
+            numel *= metadata.shape[i];
+        }
+        const uint64_t data_size = object_size - sizeof(TensorMetadata);
+        if (numel == 0 || data_size % numel != 0) {
+            LOG(ERROR) << "Invalid tensor metadata of key " << key;
+            return to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+
+        // torch.chunk gives every rank ceil(dim / tp_size) rows but the last
+        const uint64_t dim = metadata.shape[split_dim];
+        const uint64_t chunk = (dim + tp_size - 1) / tp_size;
+        const uint64_t begin = tp_rank * chunk;
+        if (begin >= dim) {
+            LOG(ERROR) << "Tensor " << key << " has no rows for tp_rank "
+                       << tp_rank << " of tp_size " << tp_size;
+            return to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+        const uint64_t count = std::min(chunk, dim - begin);
+
+        uint64_t outer = 1;
+        for (int i = 0; i < split_dim; ++i) {
+            outer *= metadata.shape[i];
+        }
+        const uint64_t row_size = data_size / numel * (numel / outer / dim);
+        const uint64_t shard_size = outer * count * row_size;
+        if (sizeof(TensorMetadata) + shard_size > size) {
+            LOG(ERROR) << "Buffer of " << size << " bytes is too small for "
+                       << "the shard of " << shard_size << " bytes of " << key;
+            return to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+
+        // One range per index of the leading dimensions, merged when they
+        // follow each other
+        std::vector<uint64_t> offsets;
+        std::vector<void *> buffers;
+        std::vector<size_t> sizes;
+        char *dest = buffer + sizeof(TensorMetadata);
+        for (uint64_t i = 0; i < outer; ++i) {
+            const uint64_t offset =
+                sizeof(TensorMetadata) + (i * dim + begin) * row_size;
+            const uint64_t length = count * row_size;
+            if (!offsets.empty() && offsets.back() + sizes.back() == offset) {
+                sizes.back() += length;
+            } else {
+                offsets.push_back(offset);
+                buffers.push_back(dest);
+                sizes.push_back(length);
+            }
+            dest += length;
+        }
+        int64_t ret =
+            store_->get_object_ranges_into(key, offsets, buffers, sizes);
+        if (ret < 0) {
+            return ret;
+        }
+
+        metadata.shape[split_dim] = count;
+        memcpy(buffer, &metadata, sizeof(TensorMetadata));
+        return sizeof(TensorMetadata) + shard_size;
+    }
+
     pybind11::list batch_get_tensor_with_tp_into(
         const std::vector<std::string> &base_keys,
         const std::vector<uintptr_t> &buffer_ptrs,
@@ -539,11 +1075,47 @@ class MooncakeStorePyWrapper {
         return batch_get_tensor_into(shard_keys, buffer_ptrs, sizes);
     }
 
+    // Puts a CUDA tensor without staging its data in host memory. Only the
+    // metadata header is copied to the registered client buffer, and the
+    // data is read from the GPU memory, which must have been registered
+    // with register_device_buffer, via GPUDirect RDMA.
+    int put_device_tensor(const std::string &key, const PyTensorInfo &info,
+                          const ReplicateConfig &config) {
+        auto alloc_result =
+            store_->client_buffer_allocator_->allocate(sizeof(TensorMetadata));
+        if (!alloc_result) {
+            LOG(ERROR) << "Failed to allocate header buffer for key: " << key;
+            return to_py_ret(ErrorCode::BUFFER_OVERFLOW);
+        }
+        memcpy(alloc_result->ptr(), &info.metadata, sizeof(TensorMetadata));
+
+        std::vector<void *> buffers = {
+            alloc_result->ptr(), reinterpret_cast<void *>(info.data_ptr)};
+        std::vector<size_t> sizes = {sizeof(TensorMetadata), info.tensor_size};
+        int ret = store_->put_from_ranges(key, buffers, sizes, config);
+        if (ret != 0)
+            LOG(ERROR) << "put_from_ranges failed for key " << key
+                       << " with code " << ret;
+        return ret;
+    }
+
     int put_tensor_impl(const std::string &key, pybind11::object tensor,
-                        const ReplicateConfig &config) {
+                        const ReplicateConfig &config,
+                        TensorDtype quantize = TensorDtype::UNKNOWN) {
         // Validation & Metadata extraction (GIL Held)
         auto info = extract_tensor_info(tensor, key);
         if (!info.valid()) return to_py_ret(ErrorCode::INVALID_PARAMS);
+        // Keeps the quantized bytes alive until they are stored
+        py::object payload;
+        if (quantize != TensorDtype::UNKNOWN) {
+            payload = quantize_tensor(tensor, quantize, info, key);
+            if (payload.is_none()) return to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+
+        if (info.is_cuda) {
+            py::gil_scoped_release release_gil;
+            return put_device_tensor(key, info, config);
+        }
 
         // Prepare spans
         std::vector<std::span<const char>> values;
@@ -561,14 +1133,19 @@ class MooncakeStorePyWrapper {
         return ret;
     }
 
-    int put_tensor(const std::string &key, pybind11::object tensor) {
+    int put_tensor(const std::string &key, pybind11::object tensor,
+                   const std::string &quantize = "") {
         if (!is_client_initialized() || use_dummy_client_) {
             LOG(ERROR) << "Client not initialized or Dummy client not "
                           "supported for tensors";
             return to_py_ret(ErrorCode::INVALID_PARAMS);
         }
-        return put_tensor_impl(key, tensor,
-                               ReplicateConfig{});  // Default config
+        TensorDtype qdtype;
+        if (!parse_quantize_mode(quantize, qdtype)) {
+            return to_py_ret(ErrorCode::INVALID_PARAMS);
+        }
+        return put_tensor_impl(key, tensor, ReplicateConfig{},
+                               qdtype);  // Default config
     }
 
     int put_tensor_with_tp_impl(
@@ -616,15 +1193,27 @@ class MooncakeStorePyWrapper {
     std::vector<int> batch_put_tensor_impl(
         const std::vector<std::string> &keys,
         const pybind11::list &tensors_list,
-        const ReplicateConfig &config = ReplicateConfig{}) {
+        const ReplicateConfig &config = ReplicateConfig{},
+        TensorDtype quantize = TensorDtype::UNKNOWN) {
         std::vector<PyTensorInfo> infos(keys.size());
         std::vector<int> results(keys.size(), 0);
+        std::vector<py::object> payloads;
 
         // 1. Extract Metadata (GIL Held)
         for (size_t i = 0; i < keys.size(); ++i) {
             infos[i] = extract_tensor_info(tensors_list[i], keys[i]);
-            if (!infos[i].valid())
+            if (!infos[i].valid()) {
                 results[i] = to_py_ret(ErrorCode::INVALID_PARAMS);
+            } else if (quantize != TensorDtype::UNKNOWN) {
+                auto payload = quantize_tensor(tensors_list[i], quantize,
+                                               infos[i], keys[i]);
+                if (payload.is_none()) {
+                    infos[i] = PyTensorInfo{0, 0, {}};
+                    results[i] = to_py_ret(ErrorCode::INVALID_PARAMS);
+                } else {
+                    payloads.push_back(std::move(payload));
+                }
+            }
         }
 
         // 2. Prepare Buffers and Execute (GIL Released)
@@ -643,6 +1232,10 @@ class MooncakeStorePyWrapper {
 
             for (size_t i = 0; i < infos.size(); ++i) {
                 if (!infos[i].valid()) continue;
+                if (infos[i].is_cuda) {
+                    results[i] = put_device_tensor(keys[i], infos[i], config);
+                    continue;
+                }
 
                 size_t total_size =
                     sizeof(TensorMetadata) + infos[i].tensor_size;
@@ -687,8 +1280,11 @@ class MooncakeStorePyWrapper {
     }
 
     std::vector<int> batch_put_tensor(const std::vector<std::string> &keys,
-                                      const pybind11::list &tensors_list) {
-        if (!is_client_initialized() || use_dummy_client_)
+                                      const pybind11::list &tensors_list,
+                                      const std::string &quantize = "") {
+        TensorDtype qdtype;
+        if (!is_client_initialized() || use_dummy_client_ ||
+            !parse_quantize_mode(quantize, qdtype))
             return std::vector<int>(keys.size(),
                                     to_py_ret(ErrorCode::INVALID_PARAMS));
 
@@ -698,7 +1294,8 @@ class MooncakeStorePyWrapper {
                                     to_py_ret(ErrorCode::INVALID_PARAMS));
         }
 
-        return batch_put_tensor_impl(keys, tensors_list, ReplicateConfig{});
+        return batch_put_tensor_impl(keys, tensors_list, ReplicateConfig{},
+                                     qdtype);
     }
 
     std::vector<int> batch_put_tensor_with_tp_impl(
@@ -891,6 +1488,9 @@ class MooncakeHostMemAllocatorPyWrapper {
 };
 
 PYBIND11_MODULE(store, m) {
+    PYBIND11_NUMPY_DTYPE(TensorSlot, status, dtype, ndim, shape, offset,
+                         nbytes);
+
     // Define the ReplicateConfig class
     py::class_<ReplicateConfig>(m, "ReplicateConfig")
         .def(py::init<>())
@@ -901,6 +1501,16 @@ PYBIND11_MODULE(store, m) {
         .def_readwrite("preferred_segment", &ReplicateConfig::preferred_segment)
         .def_readwrite("prefer_alloc_in_same_node",
                        &ReplicateConfig::prefer_alloc_in_same_node)
+        .def_readwrite("recompute_cost", &ReplicateConfig::recompute_cost)
+        .def_readwrite("reader_locality", &ReplicateConfig::reader_locality)
+        .def_readwrite("stripe_data_chunks",
+                       &ReplicateConfig::stripe_data_chunks)
+        .def_readwrite("stripe_parity_chunks",
+                       &ReplicateConfig::stripe_parity_chunks)
+        .def_readwrite("tenant", &ReplicateConfig::tenant)
+        .def_readwrite("wait_for_concurrent_put",
+                       &ReplicateConfig::wait_for_concurrent_put)
+        .def_readwrite("ttl_ms", &ReplicateConfig::ttl_ms)
         .def("__str__", [](const ReplicateConfig &config) {
             std::ostringstream oss;
             oss << config;
@@ -964,6 +1574,24 @@ PYBIND11_MODULE(store, m) {
         .value("REPLICA_MOVE", TaskType::REPLICA_MOVE)
         .export_values();
 
+    // Values of the dtype field of batch_get_tensor_into_slots
+    py::enum_<TensorDtype>(m, "TensorDtype")
+        .value("FLOAT32", TensorDtype::FLOAT32)
+        .value("FLOAT64", TensorDtype::FLOAT64)
+        .value("INT8", TensorDtype::INT8)
+        .value("UINT8", TensorDtype::UINT8)
+        .value("INT16", TensorDtype::INT16)
+        .value("UINT16", TensorDtype::UINT16)
+        .value("INT32", TensorDtype::INT32)
+        .value("UINT32", TensorDtype::UINT32)
+        .value("INT64", TensorDtype::INT64)
+        .value("UINT64", TensorDtype::UINT64)
+        .value("BOOL", TensorDtype::BOOL)
+        .value("FLOAT16", TensorDtype::FLOAT16)
+        .value("BFLOAT16", TensorDtype::BFLOAT16)
+        .value("FLOAT8_E4M3", TensorDtype::FLOAT8_E4M3)
+        .value("FLOAT8_E5M2", TensorDtype::FLOAT8_E5M2);
+
     py::enum_<TaskStatus>(m, "TaskStatus")
         .value("PENDING", TaskStatus::PENDING)
         .value("PROCESSING", TaskStatus::PROCESSING)
@@ -1134,6 +1762,49 @@ PYBIND11_MODULE(store, m) {
              })
         .def("get", &mooncake::MooncakeStorePyWrapper::get)
         .def("get_batch", &mooncake::MooncakeStorePyWrapper::get_batch)
+        .def("get_range", &MooncakeStorePyWrapper::get_range, py::arg("key"),
+             py::arg("offset"), py::arg("length"),
+             "Get length bytes at offset of an object")
+        .def(
+            "get_range_into",
+            [](MooncakeStorePyWrapper &self, const std::string &key,
+               uint64_t offset, uintptr_t buffer_ptr, size_t size) {
+                py::gil_scoped_release release;
+                int64_t ret = self.store_->get_object_ranges_into(
+                    key, {offset}, {reinterpret_cast<void *>(buffer_ptr)},
+                    {size});
+                return ret < 0 ? ret : static_cast<int64_t>(size);
+            },
+            py::arg("key"), py::arg("offset"), py::arg("buffer_ptr"),
+            py::arg("size"),
+            "Get size bytes at offset of an object directly into a "
+            "registered buffer")
+        .def(
+            "get_zero_copy",
+            [](MooncakeStorePyWrapper &self,
+               const std::string &key) -> py::object {
+                uint64_t addr = 0;
+                size_t size = 0;
+                uint64_t lease_ttl_ms = 0;
+                {
+                    py::gil_scoped_release release;
+                    std::tie(addr, size, lease_ttl_ms) =
+                        self.store_->get_zero_copy_info(key);
+                }
+                if (size == 0) {
+                    return py::none();
+                }
+                return py::make_tuple(
+                    py::memoryview::from_memory(
+                        reinterpret_cast<const void *>(addr),
+                        static_cast<py::ssize_t>(size), true),
+                    lease_ttl_ms);
+            },
+            py::arg("key"),
+            "Read an object held in a segment of the local real client "
+            "without copying it. Returns (memoryview, lease_ttl_ms), or None "
+            "if the object has no replica there. The read-only view is only "
+            "valid until the lease expires")
         .def(
             "get_buffer",
             [](MooncakeStorePyWrapper &self, const std::string &key) {
@@ -1199,6 +1870,17 @@ PYBIND11_MODULE(store, m) {
             py::arg("keys"),
             "Check if multiple objects exist. Returns list of results: 1 if "
             "exists, 0 if not exists, -1 if error")
+        .def(
+            "prefetch",
+            [](MooncakeStorePyWrapper &self,
+               const std::vector<std::string> &keys) {
+                py::gil_scoped_release release;
+                return self.store_->prefetch(keys);
+            },
+            py::arg("keys"),
+            "Start copying the disk replicas of objects into local memory "
+            "segments without waiting, so that later gets read them from "
+            "memory. Returns 0 if started, a negative error code otherwise")
         .def("close",
              [](MooncakeStorePyWrapper &self) {
                  if (!self.store_) return 0;
@@ -1245,12 +1927,15 @@ PYBIND11_MODULE(store, m) {
              "Put a batch of PyTorch tensors into the store, splitting each "
              "into shards for tensor parallelism.")
         .def("put_tensor", &MooncakeStorePyWrapper::put_tensor, py::arg("key"),
-             py::arg("tensor"), "Put a PyTorch tensor into the store")
+             py::arg("tensor"), py::arg("quantize") = "",
+             "Put a PyTorch tensor into the store, optionally quantized to "
+             "\"int8\" or \"fp8\"")
         .def("batch_get_tensor", &MooncakeStorePyWrapper::batch_get_tensor,
              py::arg("keys"), "Get a batch of PyTorch tensors from the store")
         .def("batch_put_tensor", &MooncakeStorePyWrapper::batch_put_tensor,
-             py::arg("keys"), py::arg("tensors_list"),
-             "Put a batch of PyTorch tensors into the store")
+             py::arg("keys"), py::arg("tensors_list"), py::arg("quantize") = "",
+             "Put a batch of PyTorch tensors into the store, optionally "
+             "quantized to \"int8\" or \"fp8\"")
         .def("pub_tensor", &MooncakeStorePyWrapper::pub_tensor, py::arg("key"),
              py::arg("tensor"), py::arg("config") = ReplicateConfig{},
              "Publish a PyTorch tensor with configurable replication settings")
@@ -1279,6 +1964,17 @@ PYBIND11_MODULE(store, m) {
         .def("get_tensor_into", &MooncakeStorePyWrapper::get_tensor_into,
              py::arg("key"), py::arg("buffer_ptr"), py::arg("size"),
              "Get tensor directly into a pre-allocated buffer")
+        .def("get_tensor_into_device",
+             &MooncakeStorePyWrapper::get_tensor_into_device, py::arg("key"),
+             py::arg("tensor"),
+             "Get a PyTorch tensor from the store directly into a "
+             "pre-allocated tensor, which may be in registered GPU memory")
+        .def("batch_get_tensor_into_slots",
+             &MooncakeStorePyWrapper::batch_get_tensor_into_slots,
+             py::arg("keys"), py::arg("buffer_ptr"), py::arg("slot_size"),
+             "Get a batch of PyTorch tensors into fixed-size slots of one "
+             "registered buffer, returning their metadata as a numpy "
+             "structured array")
         .def("batch_get_tensor_into",
              &MooncakeStorePyWrapper::batch_get_tensor_into, py::arg("keys"),
              py::arg("buffer_ptrs"), py::arg("sizes"),
@@ -1299,6 +1995,12 @@ PYBIND11_MODULE(store, m) {
             "  tp_rank: The current tensor parallel rank (default 0).\n"
             "  tp_size: The total tensor parallel size (default 1).\n"
             "  split_dim: The dimension to split the tensor along (default 0).")
+        .def("get_tensor_shard_into",
+             &MooncakeStorePyWrapper::get_tensor_shard_into, py::arg("key"),
+             py::arg("buffer_ptr"), py::arg("size"), py::arg("tp_rank"),
+             py::arg("tp_size"), py::arg("split_dim") = 0,
+             "Get the tensor parallel slice of a whole tensor put with "
+             "put_tensor into a pre-allocated buffer, reading only its bytes")
         .def(
             "batch_get_tensor_with_tp_into",
             &MooncakeStorePyWrapper::batch_get_tensor_with_tp_into,
@@ -1317,6 +2019,22 @@ PYBIND11_MODULE(store, m) {
             },
             py::arg("buffer_ptr"), py::arg("size"),
             "Register a memory buffer for direct access operations")
+        .def(
+            "register_device_buffer",
+            [](MooncakeStorePyWrapper &self, uintptr_t buffer_ptr, size_t size,
+               int device_id) {
+                if (self.use_dummy_client_) {
+                    LOG(ERROR) << "register_device_buffer is not supported "
+                                  "for dummy client";
+                    return to_py_ret(ErrorCode::INVALID_PARAMS);
+                }
+                void *buffer = reinterpret_cast<void *>(buffer_ptr);
+                py::gil_scoped_release release;
+                return self.store_->register_device_buffer(buffer, size,
+                                                           device_id);
+            },
+            py::arg("buffer_ptr"), py::arg("size"), py::arg("device_id"),
+            "Register GPU memory for GPUDirect RDMA operations")
         .def(
             "unregister_buffer",
             [](MooncakeStorePyWrapper &self, uintptr_t buffer_ptr) {
@@ -1328,6 +2046,17 @@ PYBIND11_MODULE(store, m) {
             py::arg("buffer_ptr"),
             "Unregister a previously registered memory "
             "buffer for direct access operations")
+        .def(
+            "invalidate_buffer",
+            [](MooncakeStorePyWrapper &self, uintptr_t buffer_ptr,
+               size_t size) {
+                void *buffer = reinterpret_cast<void *>(buffer_ptr);
+                py::gil_scoped_release release;
+                return self.store_->invalidate_buffer(buffer, size);
+            },
+            py::arg("buffer_ptr"), py::arg("size"),
+            "Drop the cached registrations of a memory range before it is "
+            "freed")
         .def(
             "get_into",
             [](MooncakeStorePyWrapper &self, const std::string &key,
@@ -1344,6 +2073,45 @@ PYBIND11_MODULE(store, m) {
             },
             py::arg("key"), py::arg("buffer_ptr"), py::arg("size"),
             "Get object data directly into a pre-allocated buffer")
+        .def(
+            "get_into_async",
+            [](MooncakeStorePyWrapper &self, const std::string &key,
+               uintptr_t buffer_ptr, size_t size, py::function callback) {
+                void *buffer = reinterpret_cast<void *>(buffer_ptr);
+                auto done = WrapAsyncCallback<int64_t>(std::move(callback));
+                py::gil_scoped_release release;
+                if (self.use_dummy_client_) {
+                    LOG(ERROR) << "get_into_async is not supported for "
+                                  "dummy client now";
+                    done(-1);
+                    return;
+                }
+                self.store_->get_into_async(key, buffer, size,
+                                            std::move(done));
+            },
+            py::arg("key"), py::arg("buffer_ptr"), py::arg("size"),
+            py::arg("callback"),
+            "Start a get_into and return once its transfer is submitted. "
+            "callback(result) is called with the result of get_into from a "
+            "thread of the client, the buffer must stay valid until then")
+        .def(
+            "batch_get_into_stream",
+            [](MooncakeStorePyWrapper &self,
+               const std::vector<std::string> &keys,
+               const std::vector<uintptr_t> &buffer_ptrs,
+               const std::vector<size_t> &sizes, py::function callback) {
+                auto done =
+                    WrapAsyncCallback<size_t, int64_t>(std::move(callback));
+                py::gil_scoped_release release;
+                self.store_->batch_get_into_stream(
+                    keys, CastAddrs2Ptrs(buffer_ptrs), sizes, std::move(done));
+            },
+            py::arg("keys"), py::arg("buffer_ptrs"), py::arg("sizes"),
+            py::arg("callback"),
+            "Start a batch_get_into and return once its transfers are "
+            "submitted. callback(index, result) is called once per key, in "
+            "the order of the keys, as soon as the key and all keys before "
+            "it are done. The buffers must stay valid until the last call")
         .def(
             "batch_get_into",
             [](MooncakeStorePyWrapper &self,
@@ -1380,6 +2148,28 @@ PYBIND11_MODULE(store, m) {
             py::arg("key"), py::arg("buffer_ptr"), py::arg("size"),
             py::arg("config") = ReplicateConfig{},
             "Put object data directly from a pre-allocated buffer")
+        .def(
+            "put_from_async",
+            [](MooncakeStorePyWrapper &self, const std::string &key,
+               uintptr_t buffer_ptr, size_t size, py::function callback,
+               const ReplicateConfig &config = ReplicateConfig{}) {
+                void *buffer = reinterpret_cast<void *>(buffer_ptr);
+                auto done = WrapAsyncCallback<int>(std::move(callback));
+                py::gil_scoped_release release;
+                if (self.use_dummy_client_) {
+                    LOG(ERROR) << "put_from_async is not supported for "
+                                  "dummy client now";
+                    done(-1);
+                    return;
+                }
+                self.store_->put_from_async(key, buffer, size, config,
+                                            std::move(done));
+            },
+            py::arg("key"), py::arg("buffer_ptr"), py::arg("size"),
+            py::arg("callback"), py::arg("config") = ReplicateConfig{},
+            "Start a put_from and return once its transfers are submitted. "
+            "callback(result) is called with the result of put_from from a "
+            "thread of the client, the buffer must stay valid until then")
         .def(
             "put_from_with_metadata",
             [](MooncakeStorePyWrapper &self, const std::string &key,
@@ -1543,6 +2333,62 @@ PYBIND11_MODULE(store, m) {
             "Get object data directly into multiple pre-allocated buffers for "
             "multiple "
             "keys")
+        .def(
+            "get_into_ranges",
+            [](MooncakeStorePyWrapper &self, const std::string &key,
+               const std::vector<uintptr_t> &buffer_ptrs,
+               const std::vector<size_t> &sizes) {
+                py::gil_scoped_release release;
+                return self.store_->get_into_ranges(
+                    key, CastAddrs2Ptrs(buffer_ptrs), sizes);
+            },
+            py::arg("key"), py::arg("buffer_ptrs"), py::arg("sizes"),
+            "Get object data directly into a list of regions, filled in "
+            "order. Adjacent regions are transferred as one")
+        .def(
+            "broadcast_publish",
+            [](MooncakeStorePyWrapper &self, const std::string &key,
+               uintptr_t buffer_ptr, size_t size, size_t chunk_size,
+               const ReplicateConfig &config) {
+                py::gil_scoped_release release;
+                return self.store_->broadcast_publish(
+                    key, reinterpret_cast<void *>(buffer_ptr), size,
+                    chunk_size, config);
+            },
+            py::arg("key"), py::arg("buffer_ptr"), py::arg("size"),
+            py::arg("chunk_size") = 16 * 1024 * 1024,
+            py::arg("config") = ReplicateConfig{},
+            "Publish a registered buffer to be received by many subscribers "
+            "with broadcast_receive")
+        .def(
+            "broadcast_receive",
+            [](MooncakeStorePyWrapper &self, const std::string &key,
+               uintptr_t buffer_ptr, size_t size, int rank,
+               int num_subscribers, int fanout, int64_t timeout_ms) {
+                py::gil_scoped_release release;
+                return self.store_->broadcast_receive(
+                    key, reinterpret_cast<void *>(buffer_ptr), size, rank,
+                    num_subscribers, fanout, timeout_ms);
+            },
+            py::arg("key"), py::arg("buffer_ptr"), py::arg("size"),
+            py::arg("rank"), py::arg("num_subscribers"), py::arg("fanout") = 1,
+            py::arg("timeout_ms") = 60000,
+            "Receive a broadcast into a registered buffer, forwarding its "
+            "chunks down a chain (fanout 1) or tree of subscribers")
+        .def(
+            "put_from_ranges",
+            [](MooncakeStorePyWrapper &self, const std::string &key,
+               const std::vector<uintptr_t> &buffer_ptrs,
+               const std::vector<size_t> &sizes,
+               const ReplicateConfig &config = ReplicateConfig{}) {
+                py::gil_scoped_release release;
+                return self.store_->put_from_ranges(
+                    key, CastAddrs2Ptrs(buffer_ptrs), sizes, config);
+            },
+            py::arg("key"), py::arg("buffer_ptrs"), py::arg("sizes"),
+            py::arg("config") = ReplicateConfig{},
+            "Put an object made of a list of regions, in order, without "
+            "packing them into a staging buffer")
         .def(
             "get_replica_desc",
             [](MooncakeStorePyWrapper &self, const std::string &key) {
@@ -30,7 +30,12 @@
 #endif
 
 #ifdef USE_CUDA
+#include <cuda.h>
 #include <cuda_runtime.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <thread>
 #endif
 
 static void *(*allocateMemory)(size_t) = nullptr;
@@ -89,6 +94,10 @@ TransferEnginePy::TransferEnginePy() {
 }
 
 TransferEnginePy::~TransferEnginePy() {
+#ifdef USE_CUDA
+    // Finishes the transfers still enqueued on CUDA streams
+    cuda_worker_.reset();
+#endif
     for (auto &handle : handle_map_) engine_->closeSegment(handle.second);
     handle_map_.clear();
     engine_.reset();
@@ -329,6 +338,30 @@ batch_id_t TransferEnginePy::batchTransferAsyncRead(
                               lengths, TransferOpcode::READ);
 }
 
+int TransferEnginePy::batchTransferSyncWriteArray(const char *target_hostname,
+                                                  RequestArray requests) {
+    return batchTransferSyncArray(target_hostname, std::move(requests),
+                                  TransferOpcode::WRITE);
+}
+
+int TransferEnginePy::batchTransferSyncReadArray(const char *target_hostname,
+                                                 RequestArray requests) {
+    return batchTransferSyncArray(target_hostname, std::move(requests),
+                                  TransferOpcode::READ);
+}
+
+batch_id_t TransferEnginePy::batchTransferAsyncWriteArray(
+    const char *target_hostname, RequestArray requests) {
+    return batchTransferAsyncArray(target_hostname, std::move(requests),
+                                   TransferOpcode::WRITE);
+}
+
+batch_id_t TransferEnginePy::batchTransferAsyncReadArray(
+    const char *target_hostname, RequestArray requests) {
+    return batchTransferAsyncArray(target_hostname, std::move(requests),
+                                   TransferOpcode::READ);
+}
+
 int TransferEnginePy::transferSync(const char *target_hostname,
                                    uintptr_t buffer,
                                    uintptr_t peer_buffer_address, size_t length,
@@ -427,6 +460,72 @@ int TransferEnginePy::batchTransferSync(
     const char *target_hostname, std::vector<uintptr_t> buffers,
     std::vector<uintptr_t> peer_buffer_addresses, std::vector<size_t> lengths,
     TransferOpcode opcode, TransferNotify *notify) {
+    std::vector<TransferRequest> entries;
+    if (makeRequests(buffers, peer_buffer_addresses, lengths, opcode,
+                     entries))
+        return -1;
+    return submitBatchSync(target_hostname, entries, notify);
+}
+
+int TransferEnginePy::batchTransferSyncArray(const char *target_hostname,
+                                             RequestArray requests,
+                                             TransferOpcode opcode,
+                                             TransferNotify *notify) {
+    std::vector<TransferRequest> entries;
+    if (makeRequests(requests, opcode, entries)) return -1;
+    return submitBatchSync(target_hostname, entries, notify);
+}
+
+int TransferEnginePy::makeRequests(
+    const std::vector<uintptr_t> &buffers,
+    const std::vector<uintptr_t> &peer_buffer_addresses,
+    const std::vector<size_t> &lengths, TransferOpcode opcode,
+    std::vector<TransferRequest> &entries) {
+    if (buffers.size() != peer_buffer_addresses.size() ||
+        buffers.size() != lengths.size()) {
+        LOG(ERROR)
+            << "buffers, peer_buffer_addresses and lengths have different size";
+        return -1;
+    }
+    entries.resize(buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        auto &entry = entries[i];
+        entry.opcode = opcode == TransferOpcode::WRITE ? TransferRequest::WRITE
+                                                       : TransferRequest::READ;
+        entry.length = lengths[i];
+        entry.source = (void *)buffers[i];
+        entry.target_offset = peer_buffer_addresses[i];
+        entry.advise_retry_cnt = 0;
+    }
+    return 0;
+}
+
+int TransferEnginePy::makeRequests(const RequestArray &requests,
+                                   TransferOpcode opcode,
+                                   std::vector<TransferRequest> &entries) {
+    if (requests.ndim() != 2 || requests.shape(1) != 3) {
+        LOG(ERROR) << "requests must be an array of shape (N, 3) holding "
+                      "(buffer, peer_buffer_address, length) rows";
+        return -1;
+    }
+    // Read straight from the array, without a Python call per element
+    auto rows = requests.unchecked<2>();
+    entries.resize(rows.shape(0));
+    for (pybind11::ssize_t i = 0; i < rows.shape(0); ++i) {
+        auto &entry = entries[i];
+        entry.opcode = opcode == TransferOpcode::WRITE ? TransferRequest::WRITE
+                                                       : TransferRequest::READ;
+        entry.source = (void *)(uintptr_t)rows(i, 0);
+        entry.target_offset = (uint64_t)rows(i, 1);
+        entry.length = (size_t)rows(i, 2);
+        entry.advise_retry_cnt = 0;
+    }
+    return 0;
+}
+
+int TransferEnginePy::submitBatchSync(const char *target_hostname,
+                                      std::vector<TransferRequest> &entries,
+                                      TransferNotify *notify) {
     pybind11::gil_scoped_release release;
     Transport::SegmentHandle handle;
     {
@@ -440,32 +539,14 @@ int TransferEnginePy::batchTransferSync(
         }
     }
 
-    if (buffers.size() != peer_buffer_addresses.size() ||
-        buffers.size() != lengths.size()) {
-        LOG(ERROR)
-            << "buffers, peer_buffer_addresses and lengths have different size";
-        return -1;
-    }
-
     const int max_retry = engine_->numContexts() + 1;
     auto start_ts = getCurrentTimeInNano();
-    auto total_length = std::accumulate(lengths.begin(), lengths.end(), 0ull);
-    auto batch_size = buffers.size();
-    std::vector<TransferRequest> entries;
-    for (size_t i = 0; i < batch_size; ++i) {
-        TransferRequest entry;
-        if (opcode == TransferOpcode::WRITE) {
-            entry.opcode = TransferRequest::WRITE;
-        } else {
-            entry.opcode = TransferRequest::READ;
-        }
-        entry.length = lengths[i];
-        entry.source = (void *)buffers[i];
+    uint64_t total_length = 0;
+    for (auto &entry : entries) {
         entry.target_id = handle;
-        entry.target_offset = peer_buffer_addresses[i];
-        entry.advise_retry_cnt = 0;
-        entries.push_back(entry);
+        total_length += entry.length;
     }
+    auto batch_size = entries.size();
 
     for (int retry = 0; retry < max_retry; ++retry) {
         auto batch_id = engine_->allocateBatchID(batch_size);
@@ -530,6 +611,22 @@ batch_id_t TransferEnginePy::batchTransferAsync(
     const char *target_hostname, const std::vector<uintptr_t> &buffers,
     const std::vector<uintptr_t> &peer_buffer_addresses,
     const std::vector<size_t> &lengths, TransferOpcode opcode) {
+    std::vector<TransferRequest> entries;
+    if (makeRequests(buffers, peer_buffer_addresses, lengths, opcode,
+                     entries))
+        return 0;
+    return submitBatchAsync(target_hostname, entries);
+}
+
+batch_id_t TransferEnginePy::batchTransferAsyncArray(
+    const char *target_hostname, RequestArray requests, TransferOpcode opcode) {
+    std::vector<TransferRequest> entries;
+    if (makeRequests(requests, opcode, entries)) return 0;
+    return submitBatchAsync(target_hostname, entries);
+}
+
+batch_id_t TransferEnginePy::submitBatchAsync(
+    const char *target_hostname, std::vector<TransferRequest> &entries) {
     pybind11::gil_scoped_release release;
     Transport::SegmentHandle handle;
     {
@@ -543,31 +640,10 @@ batch_id_t TransferEnginePy::batchTransferAsync(
         }
     }
 
-    if (buffers.size() != peer_buffer_addresses.size() ||
-        buffers.size() != lengths.size()) {
-        LOG(ERROR)
-            << "buffers, peer_buffer_addresses and lengths have different size";
-        return 0;
-    }
-
     const int max_retry = engine_->numContexts() + 1;
-    auto batch_size = buffers.size();
-    std::vector<TransferRequest> entries;
+    auto batch_size = entries.size();
     batch_id_t batch_id = 0;
-    for (size_t i = 0; i < batch_size; ++i) {
-        TransferRequest entry;
-        if (opcode == TransferOpcode::WRITE) {
-            entry.opcode = TransferRequest::WRITE;
-        } else {
-            entry.opcode = TransferRequest::READ;
-        }
-        entry.length = lengths[i];
-        entry.source = (void *)buffers[i];
-        entry.target_id = handle;
-        entry.target_offset = peer_buffer_addresses[i];
-        entry.advise_retry_cnt = 0;
-        entries.push_back(entry);
-    }
+    for (auto &entry : entries) entry.target_id = handle;
 
     for (int retry = 0; retry < max_retry; ++retry) {
         batch_id = engine_->allocateBatchID(batch_size);
@@ -733,79 +809,213 @@ int TransferEnginePy::unregisterMemory(uintptr_t buffer_addr) {
 #ifdef USE_CUDA
 
 /**
- * @brief Context structure for CUDA-stream-synchronized transfers.
+ * @brief Runs the transfers enqueued on CUDA streams.
  *
- * This structure holds all necessary data to execute a Mooncake transfer
- * from within a CUDA host callback.
+ * A host function on the stream hands a transfer over to the worker thread
+ * once all preceding work of the stream is done, and the stream then waits
+ * with cuStreamWaitValue32 until the worker writes the slot of the
+ * transfer. Neither the Python thread nor the CUDA host function thread
+ * waits for the transfer, and the worker drives all transfers in flight at
+ * once.
  */
-struct TransferOnCudaContext {
-    std::shared_ptr<TransferEngine> engine;
-    Transport::BatchID batch_id;
-    std::vector<Transport::TransferRequest> requests;
-    uint64_t total_bytes;
-};
+class CudaStreamWorker {
+   public:
+    struct Context {
+        std::shared_ptr<TransferEngine> engine;
+        Transport::BatchID batch_id;
+        std::vector<Transport::TransferRequest> requests;
+        uint64_t total_bytes;
+        CudaStreamWorker *worker;
+        int slot;
+        // Written to the slot once the transfer is done
+        uint32_t value;
+    };
+
+    CudaStreamWorker() {
+        cudaError_t err =
+            cudaHostAlloc((void **)&slots_, kSlots * sizeof(uint32_t),
+                          cudaHostAllocMapped | cudaHostAllocPortable);
+        if (err != cudaSuccess)
+            throw std::runtime_error(std::string("cudaHostAlloc failed: ") +
+                                     cudaGetErrorString(err));
+        memset((void *)slots_, 0, kSlots * sizeof(uint32_t));
+        values_.assign(kSlots, 0);
+        for (int slot = kSlots - 1; slot >= 0; --slot)
+            free_slots_.push_back(slot);
+        thread_ = std::thread(&CudaStreamWorker::run, this);
+    }
 
-/**
- * @brief CUDA Host Callback function for triggered transfers.
- *
- * This function is called by the CUDA driver when all preceding operations
- * in the associated stream have completed. It submits the transfer requests
- * and waits synchronously for their completion.
- *
- * @param data Pointer to a TransferOnCudaContext object.
- */
-void CUDART_CB transfer_on_cuda_callback(void *data) {
-    auto *ctx = reinterpret_cast<TransferOnCudaContext *>(data);
+    ~CudaStreamWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+        cudaFreeHost((void *)slots_);
+    }
+
+    // Reserves a slot and the value the stream waits for, returns false if
+    // all slots are in use
+    bool acquireSlot(int &slot, uint32_t &value, CUdeviceptr &addr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_slots_.empty()) return false;
+        void *dev_ptr = nullptr;
+        if (cudaHostGetDevicePointer(&dev_ptr,
+                                     (void *)&slots_[free_slots_.back()],
+                                     0) != cudaSuccess)
+            return false;
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        value = ++values_[slot];
+        addr = (CUdeviceptr)dev_ptr;
+        return true;
+    }
 
-    auto status = ctx->engine->submitTransfer(ctx->batch_id, ctx->requests);
-    if (!status.ok()) {
-        LOG(ERROR) << "[Mooncake Cuda] Submit failed: " << status.ToString()
-                   << " | BatchID: " << ctx->batch_id;
-        goto error_exit;
+    // Releases the streams waiting on the slot
+    void releaseSlot(int slot, uint32_t value) {
+        __atomic_store_n(&slots_[slot], value, __ATOMIC_RELEASE);
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_slots_.push_back(slot);
     }
 
-    Transport::TransferStatus t_status;
-    while (true) {
+    // Whether the slot reached the value, for streams that cannot wait with
+    // stream memory operations
+    bool slotReached(int slot, uint32_t value) const {
+        return (int32_t)(__atomic_load_n(&slots_[slot], __ATOMIC_ACQUIRE) -
+                         value) >= 0;
+    }
+
+    void push(Context *ctx) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(ctx);
+        }
+        cv_.notify_one();
+    }
+
+   private:
+    static const int kSlots = 4096;
+
+    void run() {
+        std::vector<Context *> inflight, ready;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (inflight.empty())
+                    cv_.wait(lock,
+                             [&] { return stopping_ || !queue_.empty(); });
+                if (stopping_ && queue_.empty() && inflight.empty()) return;
+                ready.swap(queue_);
+            }
+            for (auto ctx : ready) {
+                auto status =
+                    ctx->engine->submitTransfer(ctx->batch_id, ctx->requests);
+                if (!status.ok()) {
+                    LOG(ERROR) << "[Mooncake Cuda] Submit failed: "
+                               << status.ToString()
+                               << " | BatchID: " << ctx->batch_id;
+                    fail();
+                }
+                inflight.push_back(ctx);
+            }
+            ready.clear();
+            for (size_t i = 0; i < inflight.size();) {
+                if (!done(inflight[i])) {
+                    ++i;
+                    continue;
+                }
+                auto ctx = inflight[i];
+                inflight[i] = inflight.back();
+                inflight.pop_back();
+                ctx->engine->freeBatchID(ctx->batch_id);
+                releaseSlot(ctx->slot, ctx->value);
+                delete ctx;
+            }
+            if (!inflight.empty()) std::this_thread::yield();
+        }
+    }
+
+    bool done(Context *ctx) {
+        Transport::TransferStatus t_status;
         auto ret = ctx->engine->getBatchTransferStatus(ctx->batch_id, t_status);
         if (!ret.ok()) {
             LOG(ERROR) << "[Mooncake Cuda] Failed to get status for BatchID: "
                        << ctx->batch_id;
-            goto error_exit;
+            fail();
         }
-
-        if (t_status.s == Transport::TransferStatusEnum::COMPLETED) {
-            break;
-        } else if (t_status.s == Transport::TransferStatusEnum::FAILED) {
+        if (t_status.s == Transport::TransferStatusEnum::FAILED) {
             LOG(ERROR) << "[Mooncake Cuda] Transfer failed | BatchID: "
                        << ctx->batch_id << " | Bytes: " << ctx->total_bytes;
-            goto error_exit;
+            fail();
         } else if (t_status.s == Transport::TransferStatusEnum::TIMEOUT) {
             LOG(ERROR) << "[Mooncake Cuda] Transfer timeout | BatchID: "
                        << ctx->batch_id;
-            goto error_exit;
+            fail();
         }
+        return t_status.s == Transport::TransferStatusEnum::COMPLETED;
     }
 
-    ctx->engine->freeBatchID(ctx->batch_id);
-    delete ctx;
-    return;
-
-error_exit:
-    // Since this is a CUDA host callback running in a driver thread,
-    // we cannot propagate exceptions or error codes back to the main
-    // application. A failure here implies the data transfer required for
-    // subsequent stream operations has failed, leaving the system in an
-    // inconsistent state. We use _exit(1) to terminate the process
-    // immediately and avoid undefined behavior.
-    _exit(1);
+    [[noreturn]] static void fail() {
+        // The streams waiting for the transfer cannot be told that it
+        // failed. A failure here implies the data transfer required for
+        // subsequent stream operations has failed, leaving the system in
+        // an inconsistent state. We use _exit(1) to terminate the process
+        // immediately and avoid undefined behavior.
+        _exit(1);
+    }
+
+    volatile uint32_t *slots_ = nullptr;
+    std::vector<uint32_t> values_;
+    std::vector<int> free_slots_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Context *> queue_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+/**
+ * @brief CUDA Host Callback function for triggered transfers.
+ *
+ * This function is called by the CUDA driver when all preceding operations
+ * in the associated stream have completed. It hands the transfer over to
+ * the worker and returns at once.
+ *
+ * @param data Pointer to a CudaStreamWorker::Context object.
+ */
+void CUDART_CB transfer_on_cuda_callback(void *data) {
+    auto *ctx = reinterpret_cast<CudaStreamWorker::Context *>(data);
+    ctx->worker->push(ctx);
+}
+
+struct TransferOnCudaWait {
+    CudaStreamWorker *worker;
+    int slot;
+    uint32_t value;
+};
+
+/**
+ * @brief CUDA Host Callback blocking the stream until a transfer is done.
+ *
+ * Only used where the stream cannot wait with cuStreamWaitValue32.
+ *
+ * @param data Pointer to a TransferOnCudaWait object.
+ */
+void CUDART_CB wait_transfer_on_cuda_callback(void *data) {
+    auto *wait = reinterpret_cast<TransferOnCudaWait *>(data);
+    while (!wait->worker->slotReached(wait->slot, wait->value))
+        std::this_thread::yield();
+    delete wait;
 }
 
 /**
  * @brief Submits a batch of transfer requests synchronized with a CUDA stream.
  *
- * This method schedules a host callback on the provided CUDA stream. The
- * Mooncake transfer will only start after all previous kernels/memcpys on
- * the stream have finished.
+ * The Mooncake transfer starts only after all previous kernels/memcpys on
+ * the stream, and wait_event if given, have finished. Work enqueued on the
+ * stream afterwards runs only after the transfer is done, and done_event if
+ * given is recorded at that point. The call returns at once.
  *
  * @param target_hostname Remote host to transfer to/from.
  * @param buffers Local buffer addresses.
@@ -813,12 +1023,14 @@ error_exit:
  * @param lengths Length of each transfer in bytes.
  * @param opcode READ or WRITE operation.
  * @param stream_ptr Handle to a CUDA stream (cudaStream_t as uintptr_t).
+ * @param wait_event Handle to a CUDA event (cudaEvent_t) to wait for, or 0.
+ * @param done_event Handle to a CUDA event (cudaEvent_t) to record, or 0.
  */
 void TransferEnginePy::batchTransferOnCuda(
     const char *target_hostname, const std::vector<uintptr_t> &buffers,
     const std::vector<uintptr_t> &peer_buffer_addresses,
     const std::vector<size_t> &lengths, TransferOpcode opcode,
-    uintptr_t stream_ptr) {
+    uintptr_t stream_ptr, uintptr_t wait_event, uintptr_t done_event) {
     pybind11::gil_scoped_release release;
     Transport::SegmentHandle handle;
     {
@@ -831,68 +1043,98 @@ void TransferEnginePy::batchTransferOnCuda(
                 throw std::runtime_error("Failed to open segment");
             handle_map_[target_hostname] = handle;
         }
+        if (!cuda_worker_) cuda_worker_ = std::make_unique<CudaStreamWorker>();
     }
 
-    if (buffers.size() != peer_buffer_addresses.size() ||
-        buffers.size() != lengths.size()) {
-        LOG(ERROR)
-            << "buffers, peer_buffer_addresses and lengths have different size";
+    std::vector<TransferRequest> entries;
+    if (makeRequests(buffers, peer_buffer_addresses, lengths, opcode,
+                     entries))
         throw std::runtime_error(
             "buffers, peer_buffer_addresses and lengths have different size");
-    }
-
-    size_t batch_size = buffers.size();
-    std::vector<TransferRequest> entries;
     uint64_t total_bytes = 0;
-    for (size_t i = 0; i < batch_size; ++i) {
-        TransferRequest entry;
-        entry.opcode = (opcode == TransferOpcode::WRITE)
-                           ? TransferRequest::WRITE
-                           : TransferRequest::READ;
-        entry.length = lengths[i];
-        entry.source = (void *)buffers[i];
+    for (auto &entry : entries) {
         entry.target_id = handle;
-        entry.target_offset = peer_buffer_addresses[i];
-        entries.push_back(entry);
-        total_bytes += lengths[i];
+        total_bytes += entry.length;
     }
 
-    auto batch_id = engine_->allocateBatchID(batch_size);
-    auto *ctx = new TransferOnCudaContext{engine_, batch_id, std::move(entries),
-                                          total_bytes};
-
     cudaStream_t stream = reinterpret_cast<cudaStream_t>(stream_ptr);
-    cudaError_t err =
-        cudaLaunchHostFunc(stream, transfer_on_cuda_callback, ctx);
+    cudaError_t err;
+    if (wait_event) {
+        err = cudaStreamWaitEvent(
+            stream, reinterpret_cast<cudaEvent_t>(wait_event), 0);
+        if (err != cudaSuccess)
+            throw std::runtime_error(
+                std::string("cudaStreamWaitEvent failed: ") +
+                cudaGetErrorString(err));
+    }
+
+    int slot;
+    uint32_t value;
+    CUdeviceptr slot_addr;
+    if (!cuda_worker_->acquireSlot(slot, value, slot_addr))
+        throw std::runtime_error("Too many transfers on CUDA streams");
+
+    auto batch_id = engine_->allocateBatchID(entries.size());
+    auto *ctx = new CudaStreamWorker::Context{
+        engine_, batch_id, std::move(entries), total_bytes, cuda_worker_.get(),
+        slot,    value};
+    err = cudaLaunchHostFunc(stream, transfer_on_cuda_callback, ctx);
     if (err != cudaSuccess) {
         delete ctx;
         engine_->freeBatchID(batch_id);
+        cuda_worker_->releaseSlot(slot, value);
         throw std::runtime_error(std::string("cudaLaunchHostFunc failed: ") +
                                  cudaGetErrorString(err));
     }
+
+    // From here on the transfer runs whatever happens, errors only leave
+    // the stream unordered with it
+    if (cuStreamWaitValue32(stream, slot_addr, value,
+                            CU_STREAM_WAIT_VALUE_GEQ) != CUDA_SUCCESS) {
+        // Stream memory operations are not supported, block the stream
+        // from a host function instead
+        auto *wait = new TransferOnCudaWait{cuda_worker_.get(), slot, value};
+        err = cudaLaunchHostFunc(stream, wait_transfer_on_cuda_callback,
+                                 wait);
+        if (err != cudaSuccess) {
+            delete wait;
+            throw std::runtime_error(
+                std::string("cudaLaunchHostFunc failed: ") +
+                cudaGetErrorString(err));
+        }
+    }
+
+    if (done_event) {
+        err = cudaEventRecord(reinterpret_cast<cudaEvent_t>(done_event),
+                              stream);
+        if (err != cudaSuccess)
+            throw std::runtime_error(std::string("cudaEventRecord failed: ") +
+                                     cudaGetErrorString(err));
+    }
 }
 
 /**
  * @brief Async WRITE transfer triggered by a CUDA stream.
  */
-void TransferEnginePy::transferWriteOnCuda(const char *target_hostname,
-                                           uintptr_t buffer,
-                                           uintptr_t peer_buffer_address,
-                                           size_t length,
-                                           uintptr_t stream_ptr) {
+void TransferEnginePy::transferWriteOnCuda(
+    const char *target_hostname, uintptr_t buffer,
+    uintptr_t peer_buffer_address, size_t length, uintptr_t stream_ptr,
+    uintptr_t wait_event, uintptr_t done_event) {
     batchTransferOnCuda(target_hostname, {buffer}, {peer_buffer_address},
-                        {length}, TransferOpcode::WRITE, stream_ptr);
+                        {length}, TransferOpcode::WRITE, stream_ptr,
+                        wait_event, done_event);
 }
 
 /**
  * @brief Async READ transfer triggered by a CUDA stream.
  */
-void TransferEnginePy::transferReadOnCuda(const char *target_hostname,
-                                          uintptr_t buffer,
-                                          uintptr_t peer_buffer_address,
-                                          size_t length, uintptr_t stream_ptr) {
+void TransferEnginePy::transferReadOnCuda(
+    const char *target_hostname, uintptr_t buffer,
+    uintptr_t peer_buffer_address, size_t length, uintptr_t stream_ptr,
+    uintptr_t wait_event, uintptr_t done_event) {
     batchTransferOnCuda(target_hostname, {buffer}, {peer_buffer_address},
-                        {length}, TransferOpcode::READ, stream_ptr);
+                        {length}, TransferOpcode::READ, stream_ptr,
+                        wait_event, done_event);
 }
 
 /**
@@ -901,9 +1143,11 @@ void TransferEnginePy::transferReadOnCuda(const char *target_hostname,
 void TransferEnginePy::batchTransferWriteOnCuda(
     const char *target_hostname, const std::vector<uintptr_t> &buffers,
     const std::vector<uintptr_t> &peer_buffer_addresses,
-    const std::vector<size_t> &lengths, uintptr_t stream_ptr) {
+    const std::vector<size_t> &lengths, uintptr_t stream_ptr,
+    uintptr_t wait_event, uintptr_t done_event) {
     batchTransferOnCuda(target_hostname, buffers, peer_buffer_addresses,
-                        lengths, TransferOpcode::WRITE, stream_ptr);
+                        lengths, TransferOpcode::WRITE, stream_ptr, wait_event,
+                        done_event);
 }
 
 /**
@@ -912,9 +1156,11 @@ void TransferEnginePy::batchTransferWriteOnCuda(
 void TransferEnginePy::batchTransferReadOnCuda(
     const char *target_hostname, const std::vector<uintptr_t> &buffers,
     const std::vector<uintptr_t> &peer_buffer_addresses,
-    const std::vector<size_t> &lengths, uintptr_t stream_ptr) {
+    const std::vector<size_t> &lengths, uintptr_t stream_ptr,
+    uintptr_t wait_event, uintptr_t done_event) {
     batchTransferOnCuda(target_hostname, buffers, peer_buffer_addresses,
-                        lengths, TransferOpcode::READ, stream_ptr);
+                        lengths, TransferOpcode::READ, stream_ptr, wait_event,
+                        done_event);
 }
 #endif
 
@@ -1001,38 +1247,62 @@ PYBIND11_MODULE(engine, m) {
             .def("transfer_sync_read", &TransferEnginePy::transferSyncRead)
             .def("batch_transfer_sync_write",
                  &TransferEnginePy::batchTransferSyncWrite)
+            .def("batch_transfer_sync_write",
+                 &TransferEnginePy::batchTransferSyncWriteArray,
+                 py::arg("target_hostname"), py::arg("requests"))
             .def("batch_transfer_sync_read",
                  &TransferEnginePy::batchTransferSyncRead)
+            .def("batch_transfer_sync_read",
+                 &TransferEnginePy::batchTransferSyncReadArray,
+                 py::arg("target_hostname"), py::arg("requests"))
             .def("batch_transfer_async_write",
                  &TransferEnginePy::batchTransferAsyncWrite)
+            .def("batch_transfer_async_write",
+                 &TransferEnginePy::batchTransferAsyncWriteArray,
+                 py::arg("target_hostname"), py::arg("requests"))
             .def("batch_transfer_async_read",
                  &TransferEnginePy::batchTransferAsyncRead)
+            .def("batch_transfer_async_read",
+                 &TransferEnginePy::batchTransferAsyncReadArray,
+                 py::arg("target_hostname"), py::arg("requests"))
             .def("transfer_sync", &TransferEnginePy::transferSync,
                  py::arg("target_hostname"), py::arg("buffer"),
                  py::arg("peer_buffer_address"), py::arg("length"),
                  py::arg("opcode"), py::arg("notify") = nullptr)
             .def("batch_transfer_sync", &TransferEnginePy::batchTransferSync)
+            .def("batch_transfer_sync",
+                 &TransferEnginePy::batchTransferSyncArray,
+                 py::arg("target_hostname"), py::arg("requests"),
+                 py::arg("opcode"), py::arg("notify") = nullptr)
             .def("batch_transfer_async", &TransferEnginePy::batchTransferAsync)
+            .def("batch_transfer_async",
+                 &TransferEnginePy::batchTransferAsyncArray,
+                 py::arg("target_hostname"), py::arg("requests"),
+                 py::arg("opcode"))
 #ifdef USE_CUDA
             .def("transfer_write_on_cuda",
                  &TransferEnginePy::transferWriteOnCuda,
                  py::arg("target_hostname"), py::arg("buffer"),
                  py::arg("peer_buffer_address"), py::arg("length"),
-                 py::arg("stream_ptr") = 0)
+                 py::arg("stream_ptr") = 0, py::arg("wait_event") = 0,
+                 py::arg("done_event") = 0)
             .def("transfer_read_on_cuda", &TransferEnginePy::transferReadOnCuda,
                  py::arg("target_hostname"), py::arg("buffer"),
                  py::arg("peer_buffer_address"), py::arg("length"),
-                 py::arg("stream_ptr") = 0)
+                 py::arg("stream_ptr") = 0, py::arg("wait_event") = 0,
+                 py::arg("done_event") = 0)
             .def("batch_transfer_write_on_cuda",
                  &TransferEnginePy::batchTransferWriteOnCuda,
                  py::arg("target_hostname"), py::arg("buffers"),
                  py::arg("peer_buffer_addresses"), py::arg("lengths"),
-                 py::arg("stream_ptr") = 0)
+                 py::arg("stream_ptr") = 0, py::arg("wait_event") = 0,
+                 py::arg("done_event") = 0)
             .def("batch_transfer_read_on_cuda",
                  &TransferEnginePy::batchTransferReadOnCuda,
                  py::arg("target_hostname"), py::arg("buffers"),
                  py::arg("peer_buffer_addresses"), py::arg("lengths"),
-                 py::arg("stream_ptr") = 0)
+                 py::arg("stream_ptr") = 0, py::arg("wait_event") = 0,
+                 py::arg("done_event") = 0)
 #endif
             .def("get_batch_transfer_status",
                  &TransferEnginePy::getBatchTransferStatus)
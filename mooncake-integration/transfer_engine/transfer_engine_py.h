@@ -14,6 +14,7 @@
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <sys/time.h>
 
@@ -32,6 +33,10 @@
 
 using namespace mooncake;
 
+#ifdef USE_CUDA
+class CudaStreamWorker;
+#endif
+
 const static size_t kDefaultBufferCapacity = 2ull * 1024 * 1024 * 1024;
 const static size_t kSlabSizeKBTabLen = 16;
 const static size_t kMaxClassId = kSlabSizeKBTabLen - 1;
@@ -50,6 +55,11 @@ class TransferEnginePy {
 
    public:
     using BatchDesc = Transport::BatchDesc;
+    // Requests of a batch as (buffer, peer_buffer_address, length) rows,
+    // from an int64 NumPy array or CPU torch tensor of shape (N, 3)
+    using RequestArray =
+        pybind11::array_t<int64_t, pybind11::array::c_style |
+                                       pybind11::array::forcecast>;
 
    public:
     TransferEnginePy();
@@ -102,6 +112,20 @@ class TransferEnginePy {
         const std::vector<uintptr_t> &peer_buffer_addresses,
         const std::vector<size_t> &lengths);
 
+    // Overloads of the batch APIs taking a RequestArray, which is converted
+    // without a Python call per request
+    int batchTransferSyncWriteArray(const char *target_hostname,
+                                    RequestArray requests);
+
+    int batchTransferSyncReadArray(const char *target_hostname,
+                                   RequestArray requests);
+
+    batch_id_t batchTransferAsyncWriteArray(const char *target_hostname,
+                                            RequestArray requests);
+
+    batch_id_t batchTransferAsyncReadArray(const char *target_hostname,
+                                           RequestArray requests);
+
     int transferSync(const char *target_hostname, uintptr_t buffer,
                      uintptr_t peer_buffer_address, size_t length,
                      TransferOpcode opcode, TransferNotify *notify = nullptr);
@@ -120,32 +144,50 @@ class TransferEnginePy {
         const std::vector<uintptr_t> &peer_buffer_addresses,
         const std::vector<size_t> &lengths, TransferOpcode opcode);
 
+    int batchTransferSyncArray(const char *target_hostname,
+                               RequestArray requests, TransferOpcode opcode,
+                               TransferNotify *notify = nullptr);
+
+    batch_id_t batchTransferAsyncArray(const char *target_hostname,
+                                       RequestArray requests,
+                                       TransferOpcode opcode);
+
     int getBatchTransferStatus(const std::vector<batch_id_t> &batch_ids);
 
 #ifdef USE_CUDA
+    // Transfers ordered on a CUDA stream: they start once the preceding work
+    // of the stream and wait_event are done, and the following work of the
+    // stream and done_event wait for them. Events are cudaEvent_t handles,
+    // 0 for none. The calls return at once.
     void batchTransferOnCuda(
         const char *target_hostname, const std::vector<uintptr_t> &buffers,
         const std::vector<uintptr_t> &peer_buffer_addresses,
         const std::vector<size_t> &lengths, TransferOpcode opcode,
-        uintptr_t stream_ptr = 0);
+        uintptr_t stream_ptr = 0, uintptr_t wait_event = 0,
+        uintptr_t done_event = 0);
 
     void transferWriteOnCuda(const char *target_hostname, uintptr_t buffer,
                              uintptr_t peer_buffer_address, size_t length,
-                             uintptr_t stream_ptr = 0);
+                             uintptr_t stream_ptr = 0,
+                             uintptr_t wait_event = 0,
+                             uintptr_t done_event = 0);
 
     void transferReadOnCuda(const char *target_hostname, uintptr_t buffer,
                             uintptr_t peer_buffer_address, size_t length,
-                            uintptr_t stream_ptr = 0);
+                            uintptr_t stream_ptr = 0, uintptr_t wait_event = 0,
+                            uintptr_t done_event = 0);
 
     void batchTransferWriteOnCuda(
         const char *target_hostname, const std::vector<uintptr_t> &buffers,
         const std::vector<uintptr_t> &peer_buffer_addresses,
-        const std::vector<size_t> &lengths, uintptr_t stream_ptr = 0);
+        const std::vector<size_t> &lengths, uintptr_t stream_ptr = 0,
+        uintptr_t wait_event = 0, uintptr_t done_event = 0);
 
     void batchTransferReadOnCuda(
         const char *target_hostname, const std::vector<uintptr_t> &buffers,
         const std::vector<uintptr_t> &peer_buffer_addresses,
-        const std::vector<size_t> &lengths, uintptr_t stream_ptr = 0);
+        const std::vector<size_t> &lengths, uintptr_t stream_ptr = 0,
+        uintptr_t wait_event = 0, uintptr_t done_event = 0);
 #endif
 
     uintptr_t getFirstBufferAddress(const std::string &segment_name);
@@ -183,6 +225,24 @@ class TransferEnginePy {
     uintptr_t getEnginePtr() const { return (uintptr_t)engine_.get(); }
 
    private:
+    int makeRequests(const std::vector<uintptr_t> &buffers,
+                     const std::vector<uintptr_t> &peer_buffer_addresses,
+                     const std::vector<size_t> &lengths, TransferOpcode opcode,
+                     std::vector<TransferRequest> &entries);
+
+    // Called with the GIL held
+    int makeRequests(const RequestArray &requests, TransferOpcode opcode,
+                     std::vector<TransferRequest> &entries);
+
+    // Release the GIL while the batch is submitted and, for the sync
+    // version, waited for
+    int submitBatchSync(const char *target_hostname,
+                        std::vector<TransferRequest> &entries,
+                        TransferNotify *notify);
+
+    batch_id_t submitBatchAsync(const char *target_hostname,
+                                std::vector<TransferRequest> &entries);
+
     char *allocateRawBuffer(size_t capacity);
 
     int findClassId(size_t size);
@@ -201,4 +261,7 @@ class TransferEnginePy {
     bool auto_discovery_;
 
     uint64_t transfer_timeout_nsec_;
+#ifdef USE_CUDA
+    std::unique_ptr<CudaStreamWorker> cuda_worker_;
+#endif
 };
@@ -16,7 +16,9 @@ package p2pstore
 
 import (
 	"context"
+	"hash/fnv"
 	"log"
+	"math/rand"
 	"net"
 	"strconv"
 	"sync"
@@ -30,6 +32,13 @@ import (
 const MAX_CHUNK_SIZE uint64 = 4096 * 1024 * 1024
 const METADATA_KEY_PREFIX string = "mooncake/checkpoint/"
 
+// Shards fetched at the same time by GetReplica
+const MAX_CONCURRENT_SHARDS int = 16
+
+// Shards are fetched from several locations at once in stripes of at least
+// MIN_STRIPE_SIZE bytes
+const MIN_STRIPE_SIZE uint64 = 16 * 1024 * 1024
+
 type P2PStore struct {
 	metadataConnString string
 	localServerName    string
@@ -246,36 +255,108 @@ func (store *P2PStore) List(ctx context.Context, namePrefix string) ([]PayloadIn
 	return result, nil
 }
 
-func (store *P2PStore) doGetReplica(ctx context.Context, payload *Payload, addrList []uintptr, sizeList []uint64) error {
-	var wg sync.WaitGroup
-	errChan := make(chan error, 1)
+// Returns the location of each shard of a payload stored at addrList
+func (store *P2PStore) localLocations(addrList []uintptr, sizeList []uint64, maxShardSize uint64) []Location {
+	var locations []Location
+	for i := 0; i < len(addrList); i++ {
+		addr, size := addrList[i], sizeList[i]
+		for offset := uint64(0); offset < size; offset += maxShardSize {
+			locations = append(locations, Location{
+				SegmentName: store.localServerName,
+				Offset:      uint64(addr) + offset,
+			})
+		}
+	}
+	return locations
+}
 
-	var offset uint64 = 0
-	taskID := 0
+// Fetches the shards in an order of their own on each node, starting from a
+// shard picked by the node name. Nodes fetching the same payload at the same
+// time then hold different shards early on, and serve them to each other.
+func (store *P2PStore) doGetReplica(ctx context.Context, name string, payload *Payload, addrList []uintptr, sizeList []uint64) error {
 	maxShardSize := payload.MaxShardSize
-
 	for i := 0; i < len(addrList); i++ {
-		addr, size := addrList[i], sizeList[i]
-		err := store.memory.Add(addr, size, maxShardSize, "cpu:0")
+		err := store.memory.Add(addrList[i], sizeList[i], maxShardSize, "cpu:0")
 		if err != nil {
 			return err
 		}
-		for ; offset < size; offset += maxShardSize {
-			source := addr + uintptr(offset)
-			shard := payload.Shards[taskID]
-			taskID++
-			wg.Add(1)
-			go func() {
-				defer wg.Done()
-				err = store.performTransfer(ctx, source, shard)
-				if err != nil {
-					select {
-					case errChan <- err:
-					default:
-					}
+	}
+	locations := store.localLocations(addrList, sizeList, maxShardSize)
+	if len(locations) != len(payload.Shards) {
+		return ErrInvalidArgument
+	}
+
+	publisher := NewReplicaPublisher(ctx, store, name, payload, locations)
+	defer publisher.Close()
+
+	var wg sync.WaitGroup
+	errChan := make(chan error, 1)
+	slots := make(chan struct{}, MAX_CONCURRENT_SHARDS)
+	hash := fnv.New32a()
+	hash.Write([]byte(store.localServerName))
+	first := int(hash.Sum32() % uint32(len(locations)))
+	for i := 0; i < len(locations); i++ {
+		index := (first + i) % len(locations)
+		slots <- struct{}{}
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			defer func() { <-slots }()
+			source := uintptr(locations[index].Offset)
+			err := store.fetchShard(ctx, source, func() Shard { return publisher.Shard(index) })
+			if err != nil {
+				select {
+				case errChan <- err:
+				default:
 				}
-			}()
+				return
+			}
+			publisher.Done(index)
+		}()
+	}
+
+	wg.Wait()
+	close(errChan)
+	select {
+	case err := <-errChan:
+		if err != nil {
+			return err
 		}
+	default:
+	}
+	return nil
+}
+
+// Fetches a shard striped over all locations holding it, so that each of
+// them serves a part
+func (store *P2PStore) fetchShard(ctx context.Context, source uintptr, shard func() Shard) error {
+	current := shard()
+	stripes := current.Count()
+	if limit := int(current.Length / MIN_STRIPE_SIZE); stripes > limit {
+		stripes = limit
+	}
+	if stripes < 1 {
+		stripes = 1
+	}
+	stripeSize := (current.Length + uint64(stripes) - 1) / uint64(stripes)
+	first := rand.Intn(max(1, current.Count()))
+
+	var wg sync.WaitGroup
+	errChan := make(chan error, 1)
+	for i := 0; i < stripes; i++ {
+		offset := uint64(i) * stripeSize
+		length := min(stripeSize, current.Length-offset)
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			err := store.performTransfer(ctx, source+uintptr(offset), offset, length, shard, first+i)
+			if err != nil {
+				select {
+				case errChan <- err:
+				default:
+				}
+			}
+		}()
 	}
 
 	wg.Wait()
@@ -335,34 +416,48 @@ func (store *P2PStore) GetReplica(ctx context.Context, name string, addrList []u
 		return ErrPayloadNotFound
 	}
 	for {
-		err = store.doGetReplica(ctx, payload, addrList, sizeList)
+		err = store.doGetReplica(ctx, name, payload, addrList, sizeList)
 		if err != nil {
+			// Shards fetched so far may have been published already
+			innerErr := store.withdrawReplicas(context.WithoutCancel(ctx), name)
+			if innerErr != nil {
+				log.Println("cascading error:", innerErr)
+			}
 			return err
 		}
 		newPayload, recheckRevision, err := store.metadata.Get(ctx, name)
 		if err != nil {
 			return err
 		}
+		if newPayload == nil {
+			return ErrPayloadNotFound
+		}
 		if revision == recheckRevision {
 			break
 		}
 		if isSubsetOf(payload, newPayload) {
 			break
 		}
+		// Locations went away while fetching, fetch again from the others
+		payload, revision = newPayload, recheckRevision
 	}
 	return store.updatePayloadMetadata(ctx, name, addrList, sizeList, payload, revision)
 }
 
-func (store *P2PStore) performTransfer(ctx context.Context, source uintptr, shard Shard) error {
+// Reads length bytes at offset of a shard. The first attempt reads from
+// location number preferred of the shard, the retries from the next ones.
+func (store *P2PStore) performTransfer(ctx context.Context, source uintptr, offset uint64, length uint64, shard func() Shard, preferred int) error {
 	retryCount := 0
-	maxRetryCount := max(3, shard.Count())
+	maxRetryCount := max(3, shard().Count())
 	for retryCount < maxRetryCount {
 		batchID, err := store.transfer.allocateBatchID(1)
 		if err != nil {
 			return err
 		}
 
-		location := shard.GetLocation(retryCount)
+		// Retries see the replicas published meanwhile
+		current := shard()
+		location := current.LocationAt(preferred + retryCount)
 		if location == nil {
 			break
 		}
@@ -376,8 +471,8 @@ func (store *P2PStore) performTransfer(ctx context.Context, source uintptr, shar
 			Opcode:       OPCODE_READ,
 			Source:       uint64(source),
 			TargetID:     targetID,
-			TargetOffset: location.Offset,
-			Length:       shard.Length,
+			TargetOffset: location.Offset + offset,
+			Length:       length,
 		}
 
 		err = store.transfer.submitTransfer(batchID, []TransferRequest{request})
@@ -414,19 +509,14 @@ func (store *P2PStore) performTransfer(ctx context.Context, source uintptr, shar
 }
 
 func (store *P2PStore) updatePayloadMetadata(ctx context.Context, name string, addrList []uintptr, sizeList []uint64, payload *Payload, revision int64) error {
+	maxShardSize := payload.MaxShardSize
+	locations := store.localLocations(addrList, sizeList, maxShardSize)
 	for {
-		taskID := 0
-		maxShardSize := payload.MaxShardSize
-		for i := 0; i < len(addrList); i++ {
-			addr, size := addrList[i], sizeList[i]
-			var offset uint64 = 0
-			for ; offset < size; offset += maxShardSize {
-				replicaLocation := Location{
-					SegmentName: store.localServerName,
-					Offset:      uint64(addr) + offset,
-				}
-				payload.Shards[taskID].ReplicaList = append(payload.Shards[taskID].ReplicaList, replicaLocation)
-				taskID++
+		// Some shards were published while fetching
+		for index, location := range locations {
+			shard := &payload.Shards[index]
+			if !contains(shard.ReplicaList, location) {
+				shard.ReplicaList = append(shard.ReplicaList, location)
 			}
 		}
 
@@ -462,6 +552,22 @@ func (store *P2PStore) DeleteReplica(ctx context.Context, name string) error {
 		return ErrPayloadNotOpened
 	}
 
+	err := store.withdrawReplicas(ctx, name)
+	if err != nil {
+		return err
+	}
+	store.catalog.Remove(name)
+	for index := 0; index < len(params.AddrList); index++ {
+		innerErr := store.memory.Remove(params.AddrList[index], params.SizeList[index], params.MaxShardSize)
+		if innerErr != nil {
+			log.Println("cascading error:", innerErr)
+		}
+	}
+	return nil
+}
+
+// Removes the local node from the replicas of every shard of a payload
+func (store *P2PStore) withdrawReplicas(ctx context.Context, name string) error {
 	for {
 		payload, revision, err := store.metadata.Get(ctx, name)
 		if err != nil {
@@ -485,13 +591,6 @@ func (store *P2PStore) DeleteReplica(ctx context.Context, name string) error {
 			return err
 		}
 		if success {
-			store.catalog.Remove(name)
-			for index := 0; index < len(params.AddrList); index++ {
-				innerErr := store.memory.Remove(params.AddrList[index], params.SizeList[index], params.MaxShardSize)
-				if innerErr != nil {
-					log.Println("cascading error:", innerErr)
-				}
-			}
 			return nil
 		}
 	}
@@ -18,7 +18,6 @@ import (
 	"context"
 	"encoding/json"
 	"fmt"
-	"math/rand"
 	"time"
 
 	clientv3 "go.etcd.io/etcd/client/v3"
@@ -62,39 +61,22 @@ type Payload struct {
 	Shards       []Shard  `json:"shards"`
 }
 
-func (s *Shard) GetLocation(retryTimes int) *Location {
-	if retryTimes == 0 {
-		return s.getRandomLocation()
-	} else {
-		return s.getRetryLocation(retryTimes - 1)
-	}
-}
-
 func (s *Shard) Count() int {
 	return len(s.ReplicaList) + len(s.Gold)
 }
 
-func (s *Shard) getRandomLocation() *Location {
-	r := rand.New(rand.NewSource(time.Now().UnixNano()))
-	if len(s.ReplicaList) > 0 {
-		index := r.Intn(len(s.ReplicaList))
-		return &s.ReplicaList[index]
-	} else if len(s.Gold) > 0 {
-		index := r.Intn(len(s.Gold))
-		return &s.Gold[index]
+// Returns location number index % Count(), replicas first, so that indexes
+// in a row spread the reads over all locations
+func (s *Shard) LocationAt(index int) *Location {
+	count := s.Count()
+	if count == 0 {
+		return nil
 	}
-	return nil
-}
-
-func (s *Shard) getRetryLocation(retryTimes int) *Location {
-	if len(s.ReplicaList) > retryTimes {
-		return &s.ReplicaList[retryTimes]
-	}
-	retryTimes -= len(s.ReplicaList)
-	if len(s.Gold) > retryTimes {
-		return &s.Gold[retryTimes]
+	index %= count
+	if index < len(s.ReplicaList) {
+		return &s.ReplicaList[index]
 	}
-	return nil
+	return &s.Gold[index-len(s.ReplicaList)]
 }
 
 func (s *Payload) IsEmpty() bool {
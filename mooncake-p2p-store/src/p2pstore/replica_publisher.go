@@ -0,0 +1,136 @@
+// Copyright 2024 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package p2pstore
+
+import (
+	"context"
+	"log"
+	"sync"
+	"time"
+)
+
+// Shards fetched within this interval are published in one metadata update
+const PUBLISH_INTERVAL = 100 * time.Millisecond
+
+// Publishes the local node as a replica of each shard as soon as the shard
+// is fetched, so that other nodes fetching the payload can read it from here
+// before the whole payload is fetched. It also keeps the latest locations of
+// the shards, including the replicas published by other nodes meanwhile.
+type ReplicaPublisher struct {
+	store     *P2PStore
+	name      string
+	locations []Location // local location of each shard
+
+	mu      sync.Mutex
+	payload *Payload
+	pending []int
+
+	wake    chan struct{}
+	quit    chan struct{}
+	stopped chan struct{}
+}
+
+func NewReplicaPublisher(ctx context.Context, store *P2PStore, name string, payload *Payload, locations []Location) *ReplicaPublisher {
+	publisher := &ReplicaPublisher{
+		store:     store,
+		name:      name,
+		locations: locations,
+		payload:   payload,
+		wake:      make(chan struct{}, 1),
+		quit:      make(chan struct{}),
+		stopped:   make(chan struct{}),
+	}
+	go publisher.run(ctx)
+	return publisher
+}
+
+// Stops publishing. Shards not published yet are left to the caller.
+func (publisher *ReplicaPublisher) Close() {
+	close(publisher.quit)
+	<-publisher.stopped
+}
+
+// Returns the latest known locations of a shard
+func (publisher *ReplicaPublisher) Shard(index int) Shard {
+	publisher.mu.Lock()
+	defer publisher.mu.Unlock()
+	return publisher.payload.Shards[index]
+}
+
+// Marks a shard as fetched in full
+func (publisher *ReplicaPublisher) Done(index int) {
+	publisher.mu.Lock()
+	publisher.pending = append(publisher.pending, index)
+	publisher.mu.Unlock()
+	select {
+	case publisher.wake <- struct{}{}:
+	default:
+	}
+}
+
+func (publisher *ReplicaPublisher) run(ctx context.Context) {
+	defer close(publisher.stopped)
+	for {
+		select {
+		case <-publisher.wake:
+		case <-publisher.quit:
+			return
+		}
+		publisher.publish(ctx)
+		select {
+		case <-time.After(PUBLISH_INTERVAL):
+		case <-publisher.quit:
+			return
+		}
+	}
+}
+
+func (publisher *ReplicaPublisher) publish(ctx context.Context) {
+	publisher.mu.Lock()
+	pending := publisher.pending
+	publisher.pending = nil
+	publisher.mu.Unlock()
+	if len(pending) == 0 {
+		return
+	}
+
+	for {
+		payload, revision, err := publisher.store.metadata.Get(ctx, publisher.name)
+		if err != nil {
+			log.Println("failed to publish replicas:", err)
+			return
+		}
+		if payload == nil || len(payload.Shards) != len(publisher.locations) {
+			return
+		}
+		for _, index := range pending {
+			shard := &payload.Shards[index]
+			if !contains(shard.ReplicaList, publisher.locations[index]) {
+				shard.ReplicaList = append(shard.ReplicaList, publisher.locations[index])
+			}
+		}
+		success, err := publisher.store.metadata.Update(ctx, publisher.name, payload, revision)
+		if err != nil {
+			log.Println("failed to publish replicas:", err)
+			return
+		}
+		if success {
+			publisher.mu.Lock()
+			publisher.payload = payload
+			publisher.mu.Unlock()
+			return
+		}
+	}
+}
@@ -143,17 +143,27 @@ class MooncakeBackend final : public ::c10d::Backend {
     void processSendOp(const P2POp& op);
     void processRecvOp(const P2POp& op);
 
+    // Signals every active peer and waits for their signals of the same
+    // barrier epoch, bypassing the worker tasks of bulk collectives
+    void signalBarrier();
+
+    // Drops the peer from the group, as the worker does on failures
+    void markPeerBroken(int rank);
+
     static TransferEngine engine_;
     static bool engineInitialized_;
     static int backendIndex_;
     bool isCpu_{false};
     static std::string hostIp_;
-    void* send_buffer_[2];
-    void* recv_buffer_[2];
-    int32_t* cpu_sync_send_region_[2];
-    int32_t* cpu_sync_recv_region_[2];
+    void* send_buffer_[kMaxNumSlots];
+    void* recv_buffer_[kMaxNumSlots];
+    int32_t* cpu_sync_send_region_[kMaxNumSlots];
+    int32_t* cpu_sync_recv_region_[kMaxNumSlots];
     int32_t* warmup_send_region_;
     int32_t* warmup_recv_region_;
+    int64_t* barrier_send_region_;
+    int64_t* barrier_recv_region_;  // Latest barrier epoch of each peer
+    int64_t barrierEpoch_ = 0;
     static MooncakeWorker worker_;
     SegmentInfo rank_info;
     TransferGroupMeta meta_;
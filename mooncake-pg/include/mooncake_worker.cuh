@@ -10,23 +10,48 @@
 #include <torch/csrc/distributed/c10d/Store.hpp>
 #include <transfer_engine.h>
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <vector>
+
 namespace mooncake {
 
-static constexpr size_t kBufferSize = 1u << 24;
+// Size of each send/recv buffer slot, overridden by MC_PG_BUFFER_SIZE
+static constexpr size_t kDefaultBufferSize = 1u << 24;
 static constexpr size_t kMaxNumRanks = 64;
+// Collectives cycle through this many send/recv buffer slots, overridden by
+// MC_PG_PIPELINE_SLOTS. With S slots, S - 2 chunks can be reduced while the
+// next chunk is on the wire; 2 slots run chunks strictly one after another.
+static constexpr int kDefaultNumSlots = 3;
+static constexpr int kMaxNumSlots = 8;
 // Number of slots in the circular buffer for P2P operations.
 static constexpr size_t kP2PNumSlots = 256;
-static constexpr size_t kP2PSlotSize = kBufferSize / kP2PNumSlots;
+
+// Ranks a task moves data between. Ranks are assumed to be laid out node
+// by node, localSize consecutive ranks per node.
+enum PeerGroup : int {
+    kAllRanks = 0,
+    kLocalNode = 1,      // Ranks on the same node
+    kSameLocalRank = 2,  // Ranks with the same local rank on other nodes
+};
 
 struct SegmentInfo {
-    uint64_t send_buffer[2], recv_buffer[2], send_sync[2], recv_sync[2],
-        warmup_buffer[2];
+    uint64_t send_buffer[kMaxNumSlots], recv_buffer[kMaxNumSlots],
+        send_sync[kMaxNumSlots], recv_sync[kMaxNumSlots], warmup_buffer[2],
+        barrier_buffer;
 };
 
 struct TransferGroupMeta {
     int rank;
     int size;
     int taskCount;
+    // Task i uses buffer slot i % numSlots; identical on all ranks
+    int numSlots;
+    size_t bufferSize;
+    size_t p2pSlotSize;
+    int localSize;  // Ranks per node, 1 if unknown
     bool* activeRanks;
     bool* activeRanksDevice;
     at::Tensor activeRanksTensor;
@@ -42,6 +67,25 @@ struct TransferGroupMeta {
     int64_t p2pSendLowestInFlight[kMaxNumRanks]{};
     int64_t p2pRecvLowestInFlight[kMaxNumRanks]{};
     int64_t p2pRecvNextExpected[kMaxNumRanks]{};
+    // CUDA pipelining: transfers run on their own stream and hand buffer
+    // slots back and forth with the compute stream through these events
+    cudaStream_t transferStream = nullptr;
+    cudaEvent_t copiedEvent;
+    cudaEvent_t transferredEvents[kMaxNumSlots];
+    cudaEvent_t consumedEvents[kMaxNumSlots];
+};
+
+// One transfer round of a pipelined collective
+struct PipelineTask {
+    c10d::OpType opType;
+    size_t tensorSize;  // Bytes sent to each peer
+    int64_t broadcastRoot;
+    int peerGroup;
+    // Fills the send buffer of the slot. Empty if the consume step of the
+    // previous task already did, in which case this task waits for it.
+    std::function<void(int slot)> copyIn;
+    // Drains the recv buffer of the slot once the round is complete
+    std::function<void(int slot)> consume;
 };
 
 __global__ struct Task {
@@ -50,6 +94,7 @@ __global__ struct Task {
     size_t tensorSize;  // In bytes
     int64_t broadcastRoot;
     int bufferOffset;
+    int peerGroup;
     BatchID batchID;
     void* transferGroupMeta;
 };
@@ -81,6 +126,36 @@ class MooncakeWorker {
         const std::function<void(void* src, size_t pos, size_t realSize)>&
             bufferToTensor);
 
+    // Allreduce as a reduce-scatter followed by an allgather of the reduced
+    // shards. Each rank moves 2 * (N - 1) / N of the tensor instead of
+    // receiving N copies of it, at the cost of a second round. Every chunk
+    // is split into one shard per rank; reduceShard(dst, src, shardSize,
+    // numRanks) reduces the numRanks received copies of the local shard
+    // into dst.
+    //
+    // If hierarchical, the shards are reduced within each node first, then
+    // allreduced across nodes among ranks with the same local rank, and
+    // finally gathered within each node again. Only 1 / localSize of the
+    // tensor leaves each rank for other nodes.
+    c10::intrusive_ptr<c10d::Work> putAllreduceTaskCpu(
+        size_t tensorSize, TransferGroupMeta* meta, bool hierarchical,
+        const std::function<void(void* dst, size_t pos, size_t realSize)>&
+            tensorToBuffer,
+        const std::function<void(void* dst, void* src, size_t shardSize,
+                                 int numRanks)>& reduceShard,
+        const std::function<void(void* src, size_t pos, size_t realSize)>&
+            bufferToTensor);
+
+    c10::intrusive_ptr<c10d::Work> putAllreduceTaskCuda(
+        size_t tensorSize, TransferGroupMeta* meta, bool hierarchical,
+        const at::cuda::CUDAStream& stream,
+        const std::function<void(void* dst, size_t pos, size_t realSize)>&
+            tensorToBuffer,
+        const std::function<void(void* dst, void* src, size_t shardSize,
+                                 int numRanks)>& reduceShard,
+        const std::function<void(void* src, size_t pos, size_t realSize)>&
+            bufferToTensor);
+
     void startWorker();
 
     void stopWorker() { running_ = false; }
@@ -88,6 +163,27 @@ class MooncakeWorker {
    private:
     static constexpr size_t kNumTasks_ = 4;
 
+    // Runs the rounds one at a time on the wire, draining each round on
+    // the consumer thread while the next one is transferred
+    void runPipelineCpu(TransferGroupMeta* meta,
+                        std::vector<PipelineTask> pipelineTasks,
+                        c10::intrusive_ptr<c10::ivalue::Future> future);
+
+    // Same on CUDA: rounds are enqueued on meta->transferStream and drained
+    // on the caller's stream
+    void runPipelineCuda(TransferGroupMeta* meta,
+                         std::vector<PipelineTask>& pipelineTasks,
+                         const at::cuda::CUDAStream& stream);
+
+    void startConsumer();
+
+    // Fills the next CPU task slot and activates it; callback runs on the
+    // worker thread once all peers have signaled
+    void launchTaskCpu(c10d::OpType opType, size_t tensorSize,
+                       int64_t broadcastRoot, int peerGroup,
+                       TransferGroupMeta* meta, int bufferOffset,
+                       std::function<void()> callback);
+
     static constexpr size_t kPingTimeoutMicroseconds_ = 100;
 
     bool running_ = false;
@@ -98,6 +194,11 @@ class MooncakeWorker {
 
     int cpuTaskCount = 0;
     int cudaTaskCount = 0;
+
+    // Consume steps of CPU pipelines, run in submission order
+    std::mutex consumeMutex_;
+    std::condition_variable consumeCv_;
+    std::queue<std::function<void()>> consumeQueue_;
 };
 
 }  // namespace mooncake
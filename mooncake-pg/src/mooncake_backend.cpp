@@ -6,7 +6,9 @@
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <algorithm>
 #include <memory>
+#include <cstdlib>
 
 namespace mooncake {
 
@@ -18,7 +20,54 @@ constexpr const char* SYNC_OP_ERROR_MSG = "Expecting async op but got sync op.";
 constexpr const char* REDUCE_OP_ERROR_MSG = "Only support SUM.";
 constexpr const char* SPARSE_ERROR_MSG = "Sparse op not supported.";
 constexpr const char* REDUCE_DTYPE_ERROR_MSG = "Unsupported reduce dtype: ";
-constexpr int kBarrierDummyTensorSize = 1;
+// Peers that have not signaled a barrier for this long are pinged
+constexpr auto kBarrierPingInterval = std::chrono::milliseconds(100);
+
+// Allreduce switches from one-shot (every rank receives the whole tensor
+// from every peer) to reduce-scatter + allgather once a rank would receive
+// more than this many bytes. Overridden by MC_PG_ALLREDUCE_SPLIT_THRESHOLD.
+constexpr size_t kDefaultAllreduceSplitThreshold = 1u << 20;
+
+static size_t getAllreduceSplitThreshold() {
+    static const size_t threshold = [] {
+        const char* env = std::getenv("MC_PG_ALLREDUCE_SPLIT_THRESHOLD");
+        return env ? (size_t)std::strtoull(env, nullptr, 10)
+                   : kDefaultAllreduceSplitThreshold;
+    }();
+    return threshold;
+}
+
+// Ranks per node for hierarchical collectives: MC_PG_LOCAL_SIZE, else the
+// LOCAL_WORLD_SIZE set by torchrun, else 1 (flat)
+static int getLocalSize() {
+    static const int localSize = [] {
+        const char* env = std::getenv("MC_PG_LOCAL_SIZE");
+        if (!env) env = std::getenv("LOCAL_WORLD_SIZE");
+        return env ? std::max(std::atoi(env), 1) : 1;
+    }();
+    return localSize;
+}
+
+// Size of each send/recv buffer slot, overridden by MC_PG_BUFFER_SIZE
+static size_t getBufferSize() {
+    static const size_t bufferSize = [] {
+        const char* env = std::getenv("MC_PG_BUFFER_SIZE");
+        return env ? (size_t)std::strtoull(env, nullptr, 10)
+                   : kDefaultBufferSize;
+    }();
+    return bufferSize;
+}
+
+// Number of buffer slots chunks rotate through, overridden by
+// MC_PG_PIPELINE_SLOTS. Must match on all ranks.
+static int getNumSlots() {
+    static const int numSlots = [] {
+        const char* env = std::getenv("MC_PG_PIPELINE_SLOTS");
+        int value = env ? std::atoi(env) : kDefaultNumSlots;
+        return std::min(std::max(value, 2), kMaxNumSlots);
+    }();
+    return numSlots;
+}
 
 std::string MooncakeBackend::hostIp_ = "127.0.0.1";
 TransferEngine MooncakeBackend::engine_ = TransferEngine(true);
@@ -88,41 +137,45 @@ MooncakeBackend::MooncakeBackend(
                                   std::to_string(localRpcMeta.rpc_port);
 
     // Register buffers
+    const size_t bufferSize = getBufferSize();
+    const int numSlots = getNumSlots();
+    TORCH_CHECK(bufferSize >= kP2PNumSlots * (size_t)kMaxNumRanks,
+                "MC_PG_BUFFER_SIZE is too small: ", bufferSize);
     if (isCpu) {
-        for (size_t i = 0; i < 2; i++) {
-            send_buffer_[i] = malloc(kBufferSize);
+        for (int i = 0; i < numSlots; i++) {
+            send_buffer_[i] = malloc(bufferSize);
             TORCH_CHECK(send_buffer_[i],
                         c10::str("Failed to allocate CPU send buffer"));
 
-            int rc = engine_.registerLocalMemory(send_buffer_[i], kBufferSize,
+            int rc = engine_.registerLocalMemory(send_buffer_[i], bufferSize,
                                                  kWildcardLocation);
             TORCH_CHECK(!rc, REGISTER_BUFFER_ERROR_MSG);
         }
 
-        for (size_t i = 0; i < 2; i++) {
-            recv_buffer_[i] = malloc(kBufferSize);
+        for (int i = 0; i < numSlots; i++) {
+            recv_buffer_[i] = malloc(bufferSize);
             TORCH_CHECK(recv_buffer_[i],
                         c10::str("Failed to allocate CPU recv buffer"));
 
-            int rc = engine_.registerLocalMemory(recv_buffer_[i], kBufferSize,
+            int rc = engine_.registerLocalMemory(recv_buffer_[i], bufferSize,
                                                  kWildcardLocation);
             TORCH_CHECK(!rc, REGISTER_BUFFER_ERROR_MSG);
         }
     } else {
-        for (size_t i = 0; i < 2; i++) {
-            cudaError err = cudaMalloc(&send_buffer_[i], kBufferSize);
+        for (int i = 0; i < numSlots; i++) {
+            cudaError err = cudaMalloc(&send_buffer_[i], bufferSize);
             TORCH_CHECK(!err, c10::str("Failed to allocate CUDA send buffer"));
 
-            int rc = engine_.registerLocalMemory(send_buffer_[i], kBufferSize,
+            int rc = engine_.registerLocalMemory(send_buffer_[i], bufferSize,
                                                  kWildcardLocation);
             TORCH_CHECK(!rc, REGISTER_BUFFER_ERROR_MSG);
         }
 
-        for (size_t i = 0; i < 2; i++) {
-            cudaError err = cudaMalloc(&recv_buffer_[i], kBufferSize);
+        for (int i = 0; i < numSlots; i++) {
+            cudaError err = cudaMalloc(&recv_buffer_[i], bufferSize);
             TORCH_CHECK(!err, c10::str("Failed to allocate CUDA recv buffer"));
 
-            int rc = engine_.registerLocalMemory(recv_buffer_[i], kBufferSize,
+            int rc = engine_.registerLocalMemory(recv_buffer_[i], bufferSize,
                                                  kWildcardLocation);
             TORCH_CHECK(!rc, REGISTER_BUFFER_ERROR_MSG);
         }
@@ -130,7 +183,7 @@ MooncakeBackend::MooncakeBackend(
 
     // Register CPU sync regions
     TORCH_CHECK(size <= kMaxNumRanks, "The number of ranks exceeds the limit.");
-    for (size_t i = 0; i < 2; i++) {
+    for (int i = 0; i < numSlots; i++) {
         cpu_sync_send_region_[i] = new int32_t[kMaxNumRanks];
         int rc = engine_.registerLocalMemory(cpu_sync_send_region_[i],
                                              kMaxNumRanks * sizeof(int32_t),
@@ -138,7 +191,7 @@ MooncakeBackend::MooncakeBackend(
         TORCH_CHECK(!rc, REGISTER_BUFFER_ERROR_MSG);
     }
 
-    for (size_t i = 0; i < 2; i++) {
+    for (int i = 0; i < numSlots; i++) {
         cpu_sync_recv_region_[i] = new int32_t[kMaxNumRanks];
         int rc = engine_.registerLocalMemory(cpu_sync_recv_region_[i],
                                              kMaxNumRanks * sizeof(int32_t),
@@ -157,16 +210,26 @@ MooncakeBackend::MooncakeBackend(
         warmup_recv_region_, kMaxNumRanks * sizeof(int32_t), kWildcardLocation);
     TORCH_CHECK(!rc, REGISTER_BUFFER_ERROR_MSG);
 
-    rank_info.send_buffer[0] = (uint64_t)send_buffer_[0];
-    rank_info.send_buffer[1] = (uint64_t)send_buffer_[1];
-    rank_info.recv_buffer[0] = (uint64_t)recv_buffer_[0];
-    rank_info.recv_buffer[1] = (uint64_t)recv_buffer_[1];
-    rank_info.send_sync[0] = (uint64_t)cpu_sync_send_region_[0];
-    rank_info.send_sync[1] = (uint64_t)cpu_sync_send_region_[1];
-    rank_info.recv_sync[0] = (uint64_t)cpu_sync_recv_region_[0];
-    rank_info.recv_sync[1] = (uint64_t)cpu_sync_recv_region_[1];
+    barrier_send_region_ = new int64_t[1]{};
+    rc = engine_.registerLocalMemory(barrier_send_region_, sizeof(int64_t),
+                                     kWildcardLocation);
+    TORCH_CHECK(!rc, REGISTER_BUFFER_ERROR_MSG);
+
+    barrier_recv_region_ = new int64_t[kMaxNumRanks]{};
+    rc = engine_.registerLocalMemory(barrier_recv_region_,
+                                     kMaxNumRanks * sizeof(int64_t),
+                                     kWildcardLocation);
+    TORCH_CHECK(!rc, REGISTER_BUFFER_ERROR_MSG);
+
+    for (int i = 0; i < numSlots; i++) {
+        rank_info.send_buffer[i] = (uint64_t)send_buffer_[i];
+        rank_info.recv_buffer[i] = (uint64_t)recv_buffer_[i];
+        rank_info.send_sync[i] = (uint64_t)cpu_sync_send_region_[i];
+        rank_info.recv_sync[i] = (uint64_t)cpu_sync_recv_region_[i];
+    }
     rank_info.warmup_buffer[0] = (uint64_t)warmup_send_region_;
     rank_info.warmup_buffer[1] = (uint64_t)warmup_recv_region_;
+    rank_info.barrier_buffer = (uint64_t)barrier_recv_region_;
 
     std::vector<uint8_t> rank_info_bytes(sizeof(SegmentInfo));
     memcpy(rank_info_bytes.data(), &rank_info, sizeof(SegmentInfo));
@@ -188,6 +251,10 @@ MooncakeBackend::MooncakeBackend(
     meta_.rank = rank;
     meta_.size = size;
     meta_.taskCount = 0;
+    meta_.numSlots = numSlots;
+    meta_.bufferSize = bufferSize;
+    meta_.p2pSlotSize = bufferSize / kP2PNumSlots;
+    meta_.localSize = getLocalSize();
     if (isCpu) {
         meta_.activeRanks = new bool[kMaxNumRanks];
     } else {
@@ -236,6 +303,15 @@ MooncakeBackend::MooncakeBackend(
         }
     }
 
+    if (options && options->isExtension_) {
+        auto key = "extension_barrier_epoch_" +
+                   std::to_string(backendIndex_) + "_" + std::to_string(rank_);
+        while (!store->check({key})) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        barrierEpoch_ = std::atoll((char*)store->get(key).data());
+    }
+
     // Increment backend index
     ++backendIndex_;
 
@@ -291,11 +367,13 @@ c10::intrusive_ptr<c10d::Work> MooncakeBackend::send(
     auto contiguous = tensor.contiguous();
     const auto numBytes =
         contiguous.numel() * static_cast<size_t>(contiguous.element_size());
-    TORCH_CHECK(numBytes <= kBufferSize, "P2P send: tensor size ", numBytes,
-                " exceeds total buffer capacity ", kBufferSize, " bytes.");
+    TORCH_CHECK(numBytes <= meta_.bufferSize, "P2P send: tensor size ",
+                numBytes, " exceeds total buffer capacity ", meta_.bufferSize,
+                " bytes.");
 
     const int numSlotsNeeded =
-        static_cast<int>((numBytes + kP2PSlotSize - 1) / kP2PSlotSize);
+        static_cast<int>((numBytes + meta_.p2pSlotSize - 1) /
+                         meta_.p2pSlotSize);
     TORCH_CHECK(numSlotsNeeded <= static_cast<int>(kP2PNumSlots),
                 "P2P send: tensor requires ", numSlotsNeeded,
                 " slots, but only ", kP2PNumSlots, " slots available.");
@@ -395,6 +473,53 @@ c10::intrusive_ptr<c10d::Work> MooncakeBackend::allreduce(
     TORCH_CHECK(opts.sparseIndices == std::nullopt, SPARSE_ERROR_MSG);
     auto tensor = tensors.back();
     size_t tensorSize = tensor.numel() * tensor.element_size();
+    // Splitting needs every shard owner alive; with ranks already missing,
+    // the one-shot path reduces over whoever is left
+    bool splitReduce =
+        tensorSize * meta_.size > getAllreduceSplitThreshold() &&
+        std::all_of(meta_.activeRanks, meta_.activeRanks + meta_.size,
+                    [](bool active) { return active; });
+    // Ranks are expected node by node, as torchrun assigns them
+    bool hierarchical = splitReduce && meta_.localSize > 1 &&
+                        meta_.size > meta_.localSize &&
+                        meta_.size % meta_.localSize == 0;
+    if (isCpu_ && splitReduce) {
+        return worker_.putAllreduceTaskCpu(
+            tensorSize, &meta_, hierarchical,
+            [=](void* dst, size_t pos, size_t realSize) {
+                memcpy(dst, (char*)tensor.data_ptr() + pos, realSize);
+            },
+            [=](void* dst, void* src, size_t shardSize, int numRanks) {
+                auto shard = torch::from_blob(
+                    dst, {(int64_t)(shardSize / tensor.element_size())},
+                    tensor.options());
+                launchReduceCpu(shard, 0, shardSize, src, numRanks,
+                                opts.reduceOp, meta_.activeRanks);
+            },
+            [=](void* src, size_t pos, size_t realSize) {
+                memcpy((char*)tensor.data_ptr() + pos, src, realSize);
+            });
+    } else if (splitReduce) {
+        auto stream = at::cuda::getCurrentCUDAStream(tensor.device().index());
+        return worker_.putAllreduceTaskCuda(
+            tensorSize, &meta_, hierarchical, stream,
+            [=](void* dst, size_t pos, size_t realSize) {
+                cudaMemcpyAsync(dst, (char*)tensor.data_ptr() + pos, realSize,
+                                cudaMemcpyDeviceToDevice, stream);
+            },
+            [=](void* dst, void* src, size_t shardSize, int numRanks) {
+                auto shard = torch::from_blob(
+                    dst, {(int64_t)(shardSize / tensor.element_size())},
+                    tensor.options());
+                launchReduceKernel(shard, 0, shardSize, src, numRanks,
+                                   opts.reduceOp, meta_.activeRanksDevice,
+                                   stream);
+            },
+            [=](void* src, size_t pos, size_t realSize) {
+                cudaMemcpyAsync((char*)tensor.data_ptr() + pos, src, realSize,
+                                cudaMemcpyDeviceToDevice, stream);
+            });
+    }
     if (isCpu_) {
         auto numRanks = meta_.size;
         return worker_.putTaskCpu(
@@ -589,11 +714,83 @@ c10::intrusive_ptr<c10d::Work> MooncakeBackend::alltoall(
 c10::intrusive_ptr<c10d::Work> MooncakeBackend::barrier(
     const c10d::BarrierOptions& opts) {
     TORCH_CHECK(isCpu_, "Barrier is available only for CPU.")
-    return worker_.putTaskCpu(
-        // a non-zero tensorSize is required to ensure the worker task for the
-        // barrier is created
-        c10d::OpType::BARRIER, kBarrierDummyTensorSize, 0, &meta_,
-        [=](void*, size_t, size_t) {}, [=](void*, size_t, size_t) {});
+    signalBarrier();
+    auto future = c10::make_intrusive<c10::ivalue::Future>(
+        c10::ListType::create(c10::TensorType::get()));
+    future->markCompleted(c10::IValue());
+    return c10d::Work::create_from_future(future);
+}
+
+void MooncakeBackend::signalBarrier() {
+    int64_t epoch = ++barrierEpoch_;
+    *barrier_send_region_ = epoch;
+
+    std::vector<int> peers;
+    std::vector<TransferRequest> entries;
+    for (int j = 0; j < meta_.size; ++j) {
+        if (!meta_.activeRanks[j]) {
+            continue;
+        }
+        peers.push_back(j);
+        entries.push_back(TransferRequest{
+            .opcode = TransferRequest::WRITE,
+            .source = barrier_send_region_,
+            .target_id = meta_.segmentIDs[j],
+            .target_offset = meta_.segmentInfos[j].barrier_buffer +
+                             rank_ * sizeof(int64_t),
+            .length = sizeof(int64_t),
+        });
+    }
+    auto batchID = engine_.allocateBatchID(entries.size());
+    engine_.submitTransfer(batchID, entries);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        while (true) {
+            TransferStatus status;
+            engine_.getTransferStatus(batchID, i, status);
+            if (status.s == TransferStatusEnum::COMPLETED) {
+                break;
+            } else if (status.s == TransferStatusEnum::FAILED) {
+                markPeerBroken(peers[i]);
+                break;
+            }
+        }
+    }
+    engine_.freeBatchID(batchID);
+
+    // Epochs only grow, so a peer that is already in the next barrier
+    // still counts as having arrived at this one
+    auto signals = (volatile int64_t*)barrier_recv_region_;
+    TransferMetadata::NotifyDesc msg{"ping", "ping"};
+    for (int j : peers) {
+        auto lastPing = std::chrono::steady_clock::now();
+        while (meta_.activeRanks[j] && signals[j] < epoch) {
+            PAUSE();
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastPing < kBarrierPingInterval) {
+                continue;
+            }
+            lastPing = now;
+            if (engine_.sendNotifyByID(meta_.segmentIDs[j], msg)) {
+                markPeerBroken(j);
+            }
+        }
+    }
+    for (int i = 0; i < meta_.size; ++i) {
+        meta_.activeRanksTensor[i] = meta_.activeRanks[i] ? 1 : 0;
+    }
+}
+
+void MooncakeBackend::markPeerBroken(int rank) {
+    LOG(ERROR) << "Rank " << rank_ << " marking peer " << rank
+               << " as broken during barrier";
+    for (const char* prefix :
+         {"buffer_", "server_name_", "extension_task_count_",
+          "extension_barrier_epoch_"}) {
+        meta_.store->deleteKey(prefix + std::to_string(meta_.backendIndex) +
+                               "_" + std::to_string(rank));
+    }
+    meta_.activeRanks[rank] = false;
+    meta_.peerConnected[rank] = false;
 }
 
 c10::intrusive_ptr<c10d::Work> MooncakeBackend::reduce(
@@ -743,7 +940,11 @@ void MooncakeBackend::shutdown() {
     engine_.unregisterLocalMemory(warmup_recv_region_);
     delete[] warmup_send_region_;
     delete[] warmup_recv_region_;
-    for (size_t i = 0; i < 2; i++) {
+    engine_.unregisterLocalMemory(barrier_send_region_);
+    engine_.unregisterLocalMemory(barrier_recv_region_);
+    delete[] barrier_send_region_;
+    delete[] barrier_recv_region_;
+    for (int i = 0; i < meta_.numSlots; i++) {
         engine_.unregisterLocalMemory(cpu_sync_send_region_[i]);
         engine_.unregisterLocalMemory(cpu_sync_recv_region_[i]);
         engine_.unregisterLocalMemory(send_buffer_[i]);
@@ -839,17 +1040,42 @@ void MooncakeBackend::recoverRanks(const std::vector<int>& ranks) {
                              std::to_string(meta_.backendIndex) + "_" +
                              std::to_string(rank),
                          std::to_string(meta_.taskCount));
+        meta_.store->set("extension_barrier_epoch_" +
+                             std::to_string(meta_.backendIndex) + "_" +
+                             std::to_string(rank),
+                         std::to_string(barrierEpoch_));
     }
 }
 
 void MooncakeBackend::connectionPoller(c10::intrusive_ptr<::c10d::Store> store,
                                        int backendIndex) {
+    // Every pass handshakes all ranks that have published their metadata
+    // at once: their segments are warmed up in parallel and the warmup
+    // signals go out in one batch. A replacement rank thus only exchanges
+    // its segment and buffer addresses with the running ranks, and joins
+    // within a few polling intervals rather than one handshake per peer.
+    bool opened[kMaxNumRanks]{};
+    bool wasConnected[kMaxNumRanks]{};
     while (!isShutdown_) {
-        for (int pollingRank = 0; pollingRank <= nextRankForConnection_;
-             ++pollingRank) {
+        int lastRank = std::min<int>(
+            std::max(nextRankForConnection_, size_ - 1), kMaxNumRanks - 1);
+        std::vector<int> newRanks;
+        std::vector<std::string> newServerNames;
+        std::vector<std::string> replacedServerNames;
+        for (int pollingRank = 0; pollingRank <= lastRank; ++pollingRank) {
             if (meta_.peerConnected[pollingRank]) {
                 continue;
             }
+            bool replaced = wasConnected[pollingRank];
+            if (replaced) {
+                // Marked broken by the worker: forget the old process
+                wasConnected[pollingRank] = false;
+                opened[pollingRank] = false;
+                warmup_recv_region_[pollingRank] = 0;
+            }
+            if (opened[pollingRank]) {
+                continue;
+            }
             std::string serverNameKey = "server_name_" +
                                         std::to_string(backendIndex) + "_" +
                                         std::to_string(pollingRank);
@@ -864,22 +1090,34 @@ void MooncakeBackend::connectionPoller(c10::intrusive_ptr<::c10d::Store> store,
             if (isShutdown_) {
                 break;
             }
-            auto peerServerName = store->get_to_str(serverNameKey);
-            auto segment_id = engine_.openSegment(peerServerName);
-            meta_.segmentIDs[pollingRank] = segment_id;
-            std::string buffer_key = "buffer_" + std::to_string(backendIndex) +
-                                     "_" + std::to_string(pollingRank);
-            auto buffer_data = store->get(buffer_key);
-            memcpy(&meta_.segmentInfos[pollingRank], buffer_data.data(),
-                   sizeof(SegmentInfo));
-
-            if (pollingRank <= rank_) {
-                // Send a pre-flight request to establish connections
-                std::vector<TransferRequest> entries;
-                auto batchID = engine_.allocateBatchID(1);
-                engine_.submitTransfer(
-                    batchID,
-                    {TransferRequest{
+            newRanks.push_back(pollingRank);
+            newServerNames.push_back(store->get_to_str(serverNameKey));
+            if (replaced) replacedServerNames.push_back(newServerNames.back());
+        }
+
+        if (!newRanks.empty() && !isShutdown_) {
+            // A replacement may come back under the address of the rank it
+            // replaces, so its cached segment descriptor is stale
+            for (const auto& name : replacedServerNames) {
+                engine_.syncSegmentCache(name);
+            }
+            engine_.warmupSegments(newServerNames);
+
+            std::vector<TransferRequest> entries;
+            for (size_t i = 0; i < newRanks.size(); ++i) {
+                int pollingRank = newRanks[i];
+                meta_.segmentIDs[pollingRank] =
+                    engine_.openSegment(newServerNames[i]);
+                std::string buffer_key = "buffer_" +
+                                         std::to_string(backendIndex) + "_" +
+                                         std::to_string(pollingRank);
+                auto buffer_data = store->get(buffer_key);
+                memcpy(&meta_.segmentInfos[pollingRank], buffer_data.data(),
+                       sizeof(SegmentInfo));
+                opened[pollingRank] = true;
+                if (pollingRank <= rank_) {
+                    // Send a pre-flight request to establish connections
+                    entries.push_back(TransferRequest{
                         .opcode = TransferRequest::WRITE,
                         .source = warmup_send_region_,
                         .target_id = meta_.segmentIDs[pollingRank],
@@ -887,31 +1125,51 @@ void MooncakeBackend::connectionPoller(c10::intrusive_ptr<::c10d::Store> store,
                             meta_.segmentInfos[pollingRank].warmup_buffer[1] +
                             rank_ * sizeof(int32_t),
                         .length = sizeof(int32_t),
-                    }});
+                    });
+                }
+            }
 
-                while (true) {
-                    TransferStatus status;
-                    engine_.getTransferStatus(batchID, 0, status);
-                    if (status.s == TransferStatusEnum::COMPLETED) {
-                        break;
-                    } else if (status.s == TransferStatusEnum::FAILED) {
-                        LOG(WARNING) << "Warmup request " << rank_ << " -> "
-                                     << pollingRank << " failed.";
-                        break;
+            if (!entries.empty()) {
+                auto batchID = engine_.allocateBatchID(entries.size());
+                engine_.submitTransfer(batchID, entries);
+                for (size_t i = 0; i < entries.size(); ++i) {
+                    while (true) {
+                        TransferStatus status;
+                        engine_.getTransferStatus(batchID, i, status);
+                        if (status.s == TransferStatusEnum::COMPLETED) {
+                            break;
+                        } else if (status.s == TransferStatusEnum::FAILED) {
+                            LOG(WARNING) << "Warmup request " << rank_
+                                         << " -> " << newRanks[i]
+                                         << " failed.";
+                            break;
+                        }
                     }
                 }
-            } else {
-                // Wait for the warmup signals
-                while (!warmup_recv_region_[pollingRank]) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
-                }
+                engine_.freeBatchID(batchID);
+            }
+        }
+
+        // Lower ranks are connected once we reached them; higher ranks once
+        // their warmup signal has arrived
+        bool pending = false;
+        for (int pollingRank = 0; pollingRank <= lastRank; ++pollingRank) {
+            if (!opened[pollingRank] || meta_.peerConnected[pollingRank]) {
+                continue;
             }
-            meta_.peerConnected[pollingRank] = true;
-            if (pollingRank == nextRankForConnection_) {
-                ++nextRankForConnection_;
+            if (pollingRank <= rank_ || warmup_recv_region_[pollingRank]) {
+                meta_.peerConnected[pollingRank] = true;
+                wasConnected[pollingRank] = true;
+            } else {
+                pending = true;
             }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        while (nextRankForConnection_ < (int)kMaxNumRanks &&
+               meta_.peerConnected[nextRankForConnection_]) {
+            ++nextRankForConnection_;
+        }
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(pending ? 1 : 50));
     }
 }
 
@@ -1039,7 +1297,8 @@ void MooncakeBackend::processSendOp(const P2POp& op) {
         tensor.numel() * static_cast<size_t>(tensor.element_size());
 
     const int numSlotsNeeded =
-        static_cast<int>((numBytes + kP2PSlotSize - 1) / kP2PSlotSize);
+        static_cast<int>((numBytes + meta_.p2pSlotSize - 1) /
+                         meta_.p2pSlotSize);
 
     const std::string slotRequestKey =
         makeP2PSlotKey(meta_.backendIndex, rank_, dstRank, tag, seq);
@@ -1078,7 +1337,7 @@ void MooncakeBackend::processSendOp(const P2POp& op) {
         makeP2PCtrlKey(meta_.backendIndex, rank_, dstRank, tag, seq);
     uint64_t sendAddrBase = meta_.segmentInfos[rank_].send_buffer[0];
 
-    uint64_t sendAddr = sendAddrBase + baseSlot * kP2PSlotSize;
+    uint64_t sendAddr = sendAddrBase + baseSlot * meta_.p2pSlotSize;
     void* sendBuf = reinterpret_cast<void*>(sendAddr);
 
     if (isCpu_) {
@@ -1093,7 +1352,7 @@ void MooncakeBackend::processSendOp(const P2POp& op) {
     }
     uint64_t remoteRecvAddrBase = meta_.segmentInfos[dstRank].recv_buffer[0];
 
-    uint64_t remoteRecvAddr = remoteRecvAddrBase + baseSlot * kP2PSlotSize;
+    uint64_t remoteRecvAddr = remoteRecvAddrBase + baseSlot * meta_.p2pSlotSize;
     std::vector<TransferRequest> entries;
     entries.push_back(TransferRequest{
         .opcode = TransferRequest::WRITE,
@@ -1218,7 +1477,7 @@ void MooncakeBackend::processRecvOp(const P2POp& op) {
                 " but got ", numSlots);
     uint64_t recvAddrBase = meta_.segmentInfos[rank_].recv_buffer[0];
 
-    uint64_t recvAddr = recvAddrBase + baseSlot * kP2PSlotSize;
+    uint64_t recvAddr = recvAddrBase + baseSlot * meta_.p2pSlotSize;
     void* recvBuf = reinterpret_cast<void*>(recvAddr);
 
     if (isCpu_) {
@@ -0,0 +1,185 @@
+#include <ATen/Parallel.h>
+#include <mooncake_worker.cuh>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// The inner loops are plain element-wise loops that the compiler
+// vectorizes; on x86 each one is also built for AVX2 and AVX-512 and the
+// best version is picked when the library is loaded.
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define REDUCE_TARGET_CLONES \
+    __attribute__((target_clones("arch=skylake-avx512", "avx2", "default")))
+#else
+#define REDUCE_TARGET_CLONES
+#endif
+
+namespace mooncake {
+namespace {
+
+// Elements reduced per block, so that the accumulator stays in L1 while
+// the contributions of all ranks stream through
+constexpr int64_t kReduceBlock = 2048;
+
+struct SumOp {
+    template <typename T>
+    static T apply(T a, T b) {
+        return a + b;
+    }
+};
+
+struct ProductOp {
+    template <typename T>
+    static T apply(T a, T b) {
+        return a * b;
+    }
+};
+
+struct MinOp {
+    template <typename T>
+    static T apply(T a, T b) {
+        return b < a ? b : a;
+    }
+};
+
+struct MaxOp {
+    template <typename T>
+    static T apply(T a, T b) {
+        return a < b ? b : a;
+    }
+};
+
+template <typename Op, typename T>
+REDUCE_TARGET_CLONES void combine(T* __restrict acc, const T* __restrict src,
+                                  int64_t n) {
+    for (int64_t i = 0; i < n; ++i) acc[i] = Op::apply(acc[i], src[i]);
+}
+
+// 16-bit floating types are reduced in fp32 and rounded once at the end
+template <typename T>
+REDUCE_TARGET_CLONES void widen(float* __restrict acc, const T* __restrict src,
+                                int64_t n) {
+    for (int64_t i = 0; i < n; ++i) acc[i] = static_cast<float>(src[i]);
+}
+
+template <typename Op, typename T>
+REDUCE_TARGET_CLONES void widenCombine(float* __restrict acc,
+                                       const T* __restrict src, int64_t n) {
+    for (int64_t i = 0; i < n; ++i)
+        acc[i] = Op::apply(acc[i], static_cast<float>(src[i]));
+}
+
+template <typename T>
+REDUCE_TARGET_CLONES void narrow(T* __restrict dst,
+                                 const float* __restrict acc, int64_t n) {
+    for (int64_t i = 0; i < n; ++i) dst[i] = static_cast<T>(acc[i]);
+}
+
+template <typename T>
+constexpr bool kReduceInFloat =
+    std::is_same_v<T, c10::BFloat16> || std::is_same_v<T, c10::Half>;
+
+// src holds numElements elements of each rank back to back
+template <typename Op, typename T>
+void reduceBlocks(T* dst, const T* src, size_t numElements,
+                  const std::vector<size_t>& ranks) {
+    if (ranks.empty()) {
+        std::fill(dst, dst + numElements, T{});
+        return;
+    }
+    at::parallel_for(
+        0, numElements, kReduceBlock, [&](int64_t begin, int64_t end) {
+            for (int64_t pos = begin; pos < end; pos += kReduceBlock) {
+                int64_t n = std::min(kReduceBlock, end - pos);
+                auto block = [&](size_t k) {
+                    return src + ranks[k] * numElements + pos;
+                };
+                if constexpr (kReduceInFloat<T>) {
+                    float acc[kReduceBlock];
+                    widen(acc, block(0), n);
+                    for (size_t k = 1; k < ranks.size(); ++k)
+                        widenCombine<Op>(acc, block(k), n);
+                    narrow(dst + pos, acc, n);
+                } else {
+                    memcpy(dst + pos, block(0), n * sizeof(T));
+                    for (size_t k = 1; k < ranks.size(); ++k)
+                        combine<Op>(dst + pos, block(k), n);
+                }
+            }
+        });
+}
+
+template <typename T>
+void reduceCpu(T* dst, const T* src, size_t numElements,
+               const std::vector<size_t>& ranks, c10d::ReduceOp op) {
+    switch (op) {
+        case c10d::ReduceOp::SUM:
+            reduceBlocks<SumOp>(dst, src, numElements, ranks);
+            break;
+        case c10d::ReduceOp::PRODUCT:
+            reduceBlocks<ProductOp>(dst, src, numElements, ranks);
+            break;
+        case c10d::ReduceOp::MIN:
+            reduceBlocks<MinOp>(dst, src, numElements, ranks);
+            break;
+        case c10d::ReduceOp::MAX:
+            reduceBlocks<MaxOp>(dst, src, numElements, ranks);
+            break;
+        default:
+            TORCH_CHECK(false, c10::str("Unsupported reduce op: ", op));
+    }
+}
+
+}  // namespace
+
+void launchReduceCpu(at::Tensor dst, size_t pos, size_t realSize, void* src,
+                     size_t numRanks, c10d::ReduceOp op, bool* activeRanks) {
+    auto ptr = (char*)dst.data_ptr() + pos;
+    size_t num = realSize / dst.element_size();
+
+    std::vector<size_t> ranks;
+    for (size_t rank = 0; rank < numRanks; ++rank) {
+        if (activeRanks[rank]) ranks.push_back(rank);
+    }
+
+    switch (dst.scalar_type()) {
+        case c10::kByte:
+            reduceCpu((uint8_t*)ptr, (uint8_t*)src, num, ranks, op);
+            break;
+        case c10::kChar:
+            reduceCpu((int8_t*)ptr, (int8_t*)src, num, ranks, op);
+            break;
+        case c10::kShort:
+            reduceCpu((int16_t*)ptr, (int16_t*)src, num, ranks, op);
+            break;
+        case c10::kInt:
+            reduceCpu((int*)ptr, (int*)src, num, ranks, op);
+            break;
+        case c10::kLong:
+            reduceCpu((int64_t*)ptr, (int64_t*)src, num, ranks, op);
+            break;
+        case c10::kFloat:
+            reduceCpu((float*)ptr, (float*)src, num, ranks, op);
+            break;
+        case c10::kDouble:
+            reduceCpu((double*)ptr, (double*)src, num, ranks, op);
+            break;
+        case c10::kBool:
+            reduceCpu((bool*)ptr, (bool*)src, num, ranks, op);
+            break;
+        case c10::kBFloat16:
+            reduceCpu((c10::BFloat16*)ptr, (c10::BFloat16*)src, num, ranks,
+                      op);
+            break;
+        case c10::kHalf:
+            reduceCpu((c10::Half*)ptr, (c10::Half*)src, num, ranks, op);
+            break;
+        default:
+            TORCH_CHECK(false, c10::str("Unsupported reduce dtype: ",
+                                        dst.scalar_type()));
+    }
+}
+
+}  // namespace mooncake
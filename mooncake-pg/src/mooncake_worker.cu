@@ -1,3 +1,4 @@
+#include <c10/cuda/CUDAGuard.h>
 #include <mooncake_backend.h>
 #include <mooncake_worker.cuh>
 
@@ -36,14 +37,16 @@ class MooncakeWorkCuda : public ::c10d::Work {
 };
 
 __global__ void enqueueTaskKernel(c10d::OpType opType, size_t tensorSize,
-                                  int64_t broadcastRoot, int bufferOffset,
-                                  void* meta, Task* tasks, int numRanks,
+                                  int64_t broadcastRoot, int peerGroup,
+                                  int bufferOffset, void* meta, Task* tasks,
+                                  int numRanks,
                                   const bool* activeRanks,
                                   int* activeRanksTensor, size_t taskId) {
     // Copy task into slot
     tasks[taskId].opType = opType;
     tasks[taskId].tensorSize = tensorSize;
     tasks[taskId].broadcastRoot = broadcastRoot;
+    tasks[taskId].peerGroup = peerGroup;
     tasks[taskId].bufferOffset = bufferOffset;
     tasks[taskId].transferGroupMeta = meta;
 
@@ -157,86 +160,6 @@ void launchReduceKernel(at::Tensor dst, size_t pos, size_t realSize, void* src,
     }
 }
 
-template <typename T>
-T applyReduceOp(const T& a, const T& b, c10d::ReduceOp op) {
-    switch (op) {
-        case c10d::ReduceOp::SUM:
-            return a + b;
-        case c10d::ReduceOp::PRODUCT:
-            return a * b;
-        case c10d::ReduceOp::MIN:
-            return std::min(a, b);
-        case c10d::ReduceOp::MAX:
-            return std::max(a, b);
-        default:
-            TORCH_CHECK(false, c10::str("Unsupported reduce op: ", op));
-    }
-}
-
-template <typename T>
-void reduceCpu(T* dst, const T* src, size_t numElements, size_t numRanks,
-               c10d::ReduceOp op, bool* activeRanks) {
-    at::parallel_for(0, numElements, 1024, [&](int64_t begin, int64_t end) {
-        for (int64_t i = begin; i < end; ++i) {
-            bool valid = false;
-            T acc{};
-            for (int64_t rank = 0; rank < numRanks; ++rank) {
-                if (activeRanks[rank]) {
-                    if (!valid) {
-                        acc = src[i + rank * numElements];
-                        valid = true;
-                    } else {
-                        acc =
-                            applyReduceOp(acc, src[i + rank * numElements], op);
-                    }
-                }
-            }
-            dst[i] = acc;
-        }
-    });
-}
-
-void launchReduceCpu(at::Tensor dst, size_t pos, size_t realSize, void* src,
-                     size_t numRanks, c10d::ReduceOp op, bool* activeRanks) {
-    auto ptr = (char*)dst.data_ptr() + pos;
-    size_t num = realSize / dst.element_size();
-
-    switch (dst.scalar_type()) {
-        case c10::kByte:
-            reduceCpu((uint8_t*)ptr, (uint8_t*)src, num, numRanks, op,
-                      activeRanks);
-            break;
-        case c10::kChar:
-            reduceCpu((int8_t*)ptr, (int8_t*)src, num, numRanks, op,
-                      activeRanks);
-            break;
-        case c10::kShort:
-            reduceCpu((int16_t*)ptr, (int16_t*)src, num, numRanks, op,
-                      activeRanks);
-            break;
-        case c10::kInt:
-            reduceCpu((int*)ptr, (int*)src, num, numRanks, op, activeRanks);
-            break;
-        case c10::kLong:
-            reduceCpu((int64_t*)ptr, (int64_t*)src, num, numRanks, op,
-                      activeRanks);
-            break;
-        case c10::kFloat:
-            reduceCpu((float*)ptr, (float*)src, num, numRanks, op, activeRanks);
-            break;
-        case c10::kDouble:
-            reduceCpu((double*)ptr, (double*)src, num, numRanks, op,
-                      activeRanks);
-            break;
-        case c10::kBool:
-            reduceCpu((bool*)ptr, (bool*)src, num, numRanks, op, activeRanks);
-            break;
-        default:
-            TORCH_CHECK(false, c10::str("Unsupported reduce dtype: ",
-                                        dst.scalar_type()));
-    }
-}
-
 MooncakeWorker::MooncakeWorker() {
     int deviceCount = 0;
     cudaError err = cudaGetDeviceCount(&deviceCount);
@@ -255,73 +178,205 @@ MooncakeWorker::MooncakeWorker() {
 
     // Start worker
     startWorker();
+    startConsumer();
 }
 
-c10::intrusive_ptr<c10d::Work> MooncakeWorker::putTaskCpu(
+void MooncakeWorker::startConsumer() {
+    std::thread([this] {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(consumeMutex_);
+                consumeCv_.wait(lock,
+                                [this] { return !consumeQueue_.empty(); });
+                job = std::move(consumeQueue_.front());
+                consumeQueue_.pop();
+            }
+            job();
+        }
+    }).detach();
+}
+
+using TensorToBuffer =
+    std::function<void(void* dst, size_t pos, size_t realSize)>;
+using ReduceShard = std::function<void(void* dst, void* src, size_t shardSize,
+                                       int numRanks)>;
+using BufferToTensor =
+    std::function<void(void* src, size_t pos, size_t realSize)>;
+
+// Rounds of a collective whose peers each receive one chunk of the tensor
+static std::vector<PipelineTask> splitIntoChunks(
     c10d::OpType opType, size_t tensorSize, int64_t broadcastRoot,
     TransferGroupMeta* meta,
     const std::function<void(void* dst, size_t pos, size_t realSize)>&
         tensorToBuffer,
     const std::function<void(void* src, size_t pos, size_t realSize)>&
         bufferToTensor) {
-    size_t chunkSize = ((kBufferSize - 1) / meta->size) & ~(size_t)7;
-    auto future = c10::make_intrusive<c10::ivalue::Future>(
-        c10::ListType::create(c10::TensorType::get()));
-
-    struct IterState {
-        size_t currentPos = 0;
-    };
-    auto state = std::make_shared<IterState>();
-
-    auto processNextChunk = std::make_shared<std::function<void()>>();
-
-    *processNextChunk = [this, processNextChunk, state, opType, tensorSize,
-                         chunkSize, broadcastRoot, meta, tensorToBuffer,
-                         bufferToTensor, future]() {
-        if (state->currentPos >= tensorSize) {
-            future->markCompleted(c10::IValue());
-            return;
-        }
-
-        int taskId = cpuTaskCount % 2;
-        TORCH_CHECK(!tasks_[taskId].active);
-
-        size_t realSize = std::min(chunkSize, tensorSize - state->currentPos);
-        int bufferOffset = meta->taskCount % 2;
-
-        tasks_[taskId].opType = opType;
-        tasks_[taskId].tensorSize = realSize;
-        tasks_[taskId].broadcastRoot = broadcastRoot;
-        tasks_[taskId].bufferOffset = bufferOffset;
-        tasks_[taskId].transferGroupMeta = meta;
-        tensorToBuffer(
-            (void*)meta->segmentInfos[meta->rank].send_buffer[bufferOffset],
-            state->currentPos, realSize);
-
-        hasCallback_[taskId] = true;
+    size_t chunkSize = ((meta->bufferSize - 1) / meta->size) & ~(size_t)7;
+    std::vector<PipelineTask> pipelineTasks;
+    for (size_t pos = 0; pos < tensorSize; pos += chunkSize) {
+        size_t realSize = std::min(chunkSize, tensorSize - pos);
+        pipelineTasks.push_back(PipelineTask{
+            .opType = opType,
+            .tensorSize = realSize,
+            .broadcastRoot = broadcastRoot,
+            .peerGroup = kAllRanks,
+            .copyIn =
+                [meta, tensorToBuffer, pos, realSize](int slot) {
+                    tensorToBuffer(
+                        (void*)meta->segmentInfos[meta->rank].send_buffer[slot],
+                        pos, realSize);
+                },
+            .consume =
+                [meta, bufferToTensor, pos, realSize](int slot) {
+                    bufferToTensor(
+                        (void*)meta->segmentInfos[meta->rank].recv_buffer[slot],
+                        pos, realSize);
+                },
+        });
+    }
+    return pipelineTasks;
+}
 
-        callbacks_[taskId] = [this, processNextChunk, state, meta,
-                              bufferToTensor, bufferOffset, realSize,
-                              future]() {
-            for (int i = 0; i < meta->size; ++i) {
-                meta->activeRanksTensor[i] = meta->activeRanks[i] ? 1 : 0;
-            }
-            bufferToTensor(
-                (void*)meta->segmentInfos[meta->rank].recv_buffer[bufferOffset],
-                state->currentPos, realSize);
+// Bytes of the shard each rank owns when a chunk is reduce-scattered.
+// Shards are 8-byte aligned so that every dtype splits on an element
+// boundary; the tail of the last shard is padding and never read back.
+static size_t shardSizeOf(size_t chunkSize, int numRanks) {
+    return ((chunkSize + numRanks - 1) / numRanks + 7) & ~(size_t)7;
+}
 
-            state->currentPos += realSize;
+// Round that ships the chunk at pos out of the send buffer
+static PipelineTask sendChunk(c10d::OpType opType, size_t tensorSize,
+                              int peerGroup, TransferGroupMeta* meta,
+                              const TensorToBuffer& tensorToBuffer,
+                              size_t pos, size_t realSize) {
+    return PipelineTask{
+        .opType = opType,
+        .tensorSize = tensorSize,
+        .broadcastRoot = 0,
+        .peerGroup = peerGroup,
+        .copyIn =
+            [meta, tensorToBuffer, pos, realSize](int slot) {
+                tensorToBuffer(
+                    (void*)meta->segmentInfos[meta->rank].send_buffer[slot],
+                    pos, realSize);
+            },
+        .consume = nullptr,
+    };
+}
 
-            (*processNextChunk)();
-        };
+// Consume step that reduces the numRanks received copies of a shard
+// straight into the send buffer of the next round
+static std::function<void(int slot)> reduceIntoNextSlot(
+    TransferGroupMeta* meta, const ReduceShard& reduceShard, size_t shardSize,
+    int numRanks) {
+    return [meta, reduceShard, shardSize, numRanks](int slot) {
+        auto& localInfo = meta->segmentInfos[meta->rank];
+        int nextSlot = (slot + 1) % meta->numSlots;
+        reduceShard((void*)localInfo.send_buffer[nextSlot],
+                    (void*)localInfo.recv_buffer[slot], shardSize, numRanks);
+    };
+}
 
-        tasks_[taskId].active = true;
-        ++cpuTaskCount;
-        ++meta->taskCount;
+// Final round that gathers the reduced shards of the chunk at pos
+static PipelineTask gatherChunk(size_t shardSize, int peerGroup,
+                                TransferGroupMeta* meta,
+                                const BufferToTensor& bufferToTensor,
+                                size_t pos, size_t realSize) {
+    return PipelineTask{
+        .opType = c10d::OpType::_ALLGATHER_BASE,
+        .tensorSize = shardSize,
+        .broadcastRoot = 0,
+        .peerGroup = peerGroup,
+        .copyIn = nullptr,
+        .consume =
+            [meta, bufferToTensor, pos, realSize](int slot) {
+                bufferToTensor(
+                    (void*)meta->segmentInfos[meta->rank].recv_buffer[slot],
+                    pos, realSize);
+            },
     };
+}
+
+// Two rounds per chunk: a reduce-scatter whose consume step reduces the
+// local shard straight into the send buffer of the following allgather
+static std::vector<PipelineTask> splitAllreduce(
+    size_t tensorSize, TransferGroupMeta* meta,
+    const TensorToBuffer& tensorToBuffer, const ReduceShard& reduceShard,
+    const BufferToTensor& bufferToTensor) {
+    // A chunk only has to fit in the buffer once, not once per rank
+    size_t chunkSize =
+        ((meta->bufferSize / meta->size) & ~(size_t)7) * meta->size;
+    std::vector<PipelineTask> pipelineTasks;
+    for (size_t pos = 0; pos < tensorSize; pos += chunkSize) {
+        size_t realSize = std::min(chunkSize, tensorSize - pos);
+        size_t shardSize = shardSizeOf(realSize, meta->size);
+        // Round 1: shard j goes to rank j
+        auto scatter =
+            sendChunk(c10d::OpType::_REDUCE_SCATTER_BASE, shardSize,
+                      kAllRanks, meta, tensorToBuffer, pos, realSize);
+        scatter.consume =
+            reduceIntoNextSlot(meta, reduceShard, shardSize, meta->size);
+        pipelineTasks.push_back(std::move(scatter));
+        // Round 2: every rank gathers the reduced shards in order
+        pipelineTasks.push_back(gatherChunk(shardSize, kAllRanks, meta,
+                                            bufferToTensor, pos, realSize));
+    }
+    return pipelineTasks;
+}
 
-    (*processNextChunk)();
+// Three rounds per chunk: reduce-scatter within the node, allreduce of the
+// local shard across nodes, allgather within the node. Across nodes, each
+// rank only exchanges its own shard with the ranks of the same local rank,
+// so all NICs of a node carry 1 / localSize of the inter-node traffic each.
+static std::vector<PipelineTask> splitHierarchicalAllreduce(
+    size_t tensorSize, TransferGroupMeta* meta,
+    const TensorToBuffer& tensorToBuffer, const ReduceShard& reduceShard,
+    const BufferToTensor& bufferToTensor) {
+    int localSize = meta->localSize;
+    int numNodes = meta->size / localSize;
+    // Round 1 receives localSize shards and round 2 numNodes of them
+    size_t chunkSize =
+        ((meta->bufferSize / std::max(localSize, numNodes)) & ~(size_t)7) *
+        localSize;
+    std::vector<PipelineTask> pipelineTasks;
+    for (size_t pos = 0; pos < tensorSize; pos += chunkSize) {
+        size_t realSize = std::min(chunkSize, tensorSize - pos);
+        size_t shardSize = shardSizeOf(realSize, localSize);
+        auto scatter =
+            sendChunk(c10d::OpType::_REDUCE_SCATTER_BASE, shardSize,
+                      kLocalNode, meta, tensorToBuffer, pos, realSize);
+        scatter.consume =
+            reduceIntoNextSlot(meta, reduceShard, shardSize, localSize);
+        pipelineTasks.push_back(std::move(scatter));
+        pipelineTasks.push_back(PipelineTask{
+            .opType = c10d::OpType::ALLREDUCE,
+            .tensorSize = shardSize,
+            .broadcastRoot = 0,
+            .peerGroup = kSameLocalRank,
+            .copyIn = nullptr,
+            .consume =
+                reduceIntoNextSlot(meta, reduceShard, shardSize, numNodes),
+        });
+        pipelineTasks.push_back(gatherChunk(shardSize, kLocalNode, meta,
+                                            bufferToTensor, pos, realSize));
+    }
+    return pipelineTasks;
+}
 
+c10::intrusive_ptr<c10d::Work> MooncakeWorker::putTaskCpu(
+    c10d::OpType opType, size_t tensorSize, int64_t broadcastRoot,
+    TransferGroupMeta* meta,
+    const std::function<void(void* dst, size_t pos, size_t realSize)>&
+        tensorToBuffer,
+    const std::function<void(void* src, size_t pos, size_t realSize)>&
+        bufferToTensor) {
+    auto future = c10::make_intrusive<c10::ivalue::Future>(
+        c10::ListType::create(c10::TensorType::get()));
+    runPipelineCpu(meta,
+                   splitIntoChunks(opType, tensorSize, broadcastRoot, meta,
+                                   tensorToBuffer, bufferToTensor),
+                   future);
     return c10::make_intrusive<MooncakeWorkCpu>(opType, future);
 }
 
@@ -332,34 +387,208 @@ c10::intrusive_ptr<c10d::Work> MooncakeWorker::putTaskCuda(
         tensorToBuffer,
     const std::function<void(void* src, size_t pos, size_t realSize)>&
         bufferToTensor) {
-    // TORCH_CHECK(tensorSize * meta->size < kBufferSize, "Too large!");
-    //  Alternately use even-odd items to maintain tasks
-    size_t chunkSize = ((kBufferSize - 1) / meta->size) & ~(size_t)7;
+    auto pipelineTasks = splitIntoChunks(opType, tensorSize, broadcastRoot,
+                                         meta, tensorToBuffer, bufferToTensor);
+    runPipelineCuda(meta, pipelineTasks, stream);
 
-    for (size_t pos = 0; pos < tensorSize; pos += chunkSize) {
-        size_t realSize = min(tensorSize, pos + chunkSize) - pos;
-        int taskId = cudaTaskCount % 2 + 2;
-        int bufferOffset = meta->taskCount % 2;
-        tensorToBuffer(
-            (void*)meta->segmentInfos[meta->rank].send_buffer[bufferOffset],
-            pos, realSize);
+    auto event = std::make_shared<torch::Event>(torch::kCUDA);
+    event->record(stream);
+    return c10::make_intrusive<MooncakeWorkCuda>(opType, event);
+}
+
+c10::intrusive_ptr<c10d::Work> MooncakeWorker::putAllreduceTaskCpu(
+    size_t tensorSize, TransferGroupMeta* meta, bool hierarchical,
+    const std::function<void(void* dst, size_t pos, size_t realSize)>&
+        tensorToBuffer,
+    const std::function<void(void* dst, void* src, size_t shardSize,
+                             int numRanks)>& reduceShard,
+    const std::function<void(void* src, size_t pos, size_t realSize)>&
+        bufferToTensor) {
+    auto future = c10::make_intrusive<c10::ivalue::Future>(
+        c10::ListType::create(c10::TensorType::get()));
+    auto split = hierarchical ? splitHierarchicalAllreduce : splitAllreduce;
+    runPipelineCpu(meta,
+                   split(tensorSize, meta, tensorToBuffer, reduceShard,
+                         bufferToTensor),
+                   future);
+    return c10::make_intrusive<MooncakeWorkCpu>(c10d::OpType::ALLREDUCE,
+                                                future);
+}
+
+c10::intrusive_ptr<c10d::Work> MooncakeWorker::putAllreduceTaskCuda(
+    size_t tensorSize, TransferGroupMeta* meta, bool hierarchical,
+    const at::cuda::CUDAStream& stream,
+    const std::function<void(void* dst, size_t pos, size_t realSize)>&
+        tensorToBuffer,
+    const std::function<void(void* dst, void* src, size_t shardSize,
+                             int numRanks)>& reduceShard,
+    const std::function<void(void* src, size_t pos, size_t realSize)>&
+        bufferToTensor) {
+    auto split = hierarchical ? splitHierarchicalAllreduce : splitAllreduce;
+    auto pipelineTasks =
+        split(tensorSize, meta, tensorToBuffer, reduceShard, bufferToTensor);
+    runPipelineCuda(meta, pipelineTasks, stream);
+
+    auto event = std::make_shared<torch::Event>(torch::kCUDA);
+    event->record(stream);
+    return c10::make_intrusive<MooncakeWorkCuda>(c10d::OpType::ALLREDUCE,
+                                                 event);
+}
+
+void MooncakeWorker::launchTaskCpu(c10d::OpType opType, size_t tensorSize,
+                                   int64_t broadcastRoot, int peerGroup,
+                                   TransferGroupMeta* meta, int bufferOffset,
+                                   std::function<void()> callback) {
+    int taskId = cpuTaskCount % 2;
+    TORCH_CHECK(!tasks_[taskId].active);
+
+    tasks_[taskId].opType = opType;
+    tasks_[taskId].tensorSize = tensorSize;
+    tasks_[taskId].broadcastRoot = broadcastRoot;
+    tasks_[taskId].peerGroup = peerGroup;
+    tasks_[taskId].bufferOffset = bufferOffset;
+    tasks_[taskId].transferGroupMeta = meta;
+
+    hasCallback_[taskId] = true;
+    callbacks_[taskId] = std::move(callback);
+
+    tasks_[taskId].active = true;
+    ++cpuTaskCount;
+    ++meta->taskCount;
+}
+
+// Only one round is on the wire at a time. Round i may start once round
+// i - S + 1 has been consumed (S = meta->numSlots): a peer that has started
+// round i - 1 has then drained round i - S from the slot that round i
+// writes. A round without copyIn also waits for the previous consume.
+static bool pipelineReady(const PipelineTask& task, size_t index,
+                          size_t consumed, int numSlots) {
+    if (consumed + numSlots < index + 2) return false;
+    return task.copyIn || consumed >= index;
+}
 
+void MooncakeWorker::runPipelineCpu(
+    TransferGroupMeta* meta, std::vector<PipelineTask> pipelineTasks,
+    c10::intrusive_ptr<c10::ivalue::Future> future) {
+    if (pipelineTasks.empty()) {
+        future->markCompleted(c10::IValue());
+        return;
+    }
+
+    struct PipelineState {
+        std::mutex mutex;
+        std::vector<PipelineTask> tasks;
+        size_t launched = 0;
+        size_t consumed = 0;
+        bool inFlight = false;
+    };
+    auto state = std::make_shared<PipelineState>();
+    state->tasks = std::move(pipelineTasks);
+
+    // Called with state->mutex held, from the caller, the worker thread
+    // when a round completes, or the consumer thread when one is drained
+    auto tryLaunch = std::make_shared<std::function<void()>>();
+    *tryLaunch = [this, meta, state, tryLaunch, future]() {
+        size_t index = state->launched;
+        if (state->inFlight || index == state->tasks.size()) return;
+        auto& task = state->tasks[index];
+        if (!pipelineReady(task, index, state->consumed, meta->numSlots))
+            return;
+
+        int slot = meta->taskCount % meta->numSlots;
+        if (task.copyIn) task.copyIn(slot);
+        state->inFlight = true;
+        ++state->launched;
+
+        launchTaskCpu(
+            task.opType, task.tensorSize, task.broadcastRoot, task.peerGroup,
+            meta, slot,
+            [this, meta, state, tryLaunch, future, index, slot]() {
+                for (int i = 0; i < meta->size; ++i) {
+                    meta->activeRanksTensor[i] = meta->activeRanks[i] ? 1 : 0;
+                }
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->inFlight = false;
+                {
+                    std::lock_guard<std::mutex> consumeLock(consumeMutex_);
+                    consumeQueue_.push([state, tryLaunch, future, index,
+                                        slot]() {
+                        state->tasks[index].consume(slot);
+                        bool done;
+                        {
+                            std::lock_guard<std::mutex> lock(state->mutex);
+                            done = ++state->consumed == state->tasks.size();
+                            if (done)
+                                *tryLaunch = nullptr;  // break the cycle
+                            else
+                                (*tryLaunch)();
+                        }
+                        if (done) future->markCompleted(c10::IValue());
+                    });
+                }
+                consumeCv_.notify_one();
+                (*tryLaunch)();
+            });
+    };
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    (*tryLaunch)();
+}
+
+void MooncakeWorker::runPipelineCuda(TransferGroupMeta* meta,
+                                     std::vector<PipelineTask>& pipelineTasks,
+                                     const at::cuda::CUDAStream& stream) {
+    if (!meta->transferStream) {
+        at::cuda::CUDAGuard guard(stream.device_index());
+        cudaStreamCreateWithFlags(&meta->transferStream,
+                                  cudaStreamNonBlocking);
+        cudaEventCreateWithFlags(&meta->copiedEvent, cudaEventDisableTiming);
+        for (int i = 0; i < kMaxNumSlots; ++i) {
+            cudaEventCreateWithFlags(&meta->transferredEvents[i],
+                                     cudaEventDisableTiming);
+            cudaEventCreateWithFlags(&meta->consumedEvents[i],
+                                     cudaEventDisableTiming);
+        }
+    }
+
+    std::vector<int> slots(pipelineTasks.size());
+    size_t consumed = 0;
+    auto consumeNext = [&]() {
+        int slot = slots[consumed];
+        cudaStreamWaitEvent(stream, meta->transferredEvents[slot], 0);
+        pipelineTasks[consumed].consume(slot);
+        cudaEventRecord(meta->consumedEvents[slot], stream);
+        ++consumed;
+    };
+
+    for (size_t index = 0; index < pipelineTasks.size(); ++index) {
+        auto& task = pipelineTasks[index];
+        while (!pipelineReady(task, index, consumed, meta->numSlots)) {
+            consumeNext();
+        }
+
+        int slot = meta->taskCount % meta->numSlots;
+        slots[index] = slot;
+        if (task.copyIn) task.copyIn(slot);
+        cudaEventRecord(meta->copiedEvent, stream);
+        cudaStreamWaitEvent(meta->transferStream, meta->copiedEvent, 0);
+        // Round index - S + 1 lives in the slot after this one
+        cudaStreamWaitEvent(meta->transferStream,
+                            meta->consumedEvents[(slot + 1) % meta->numSlots],
+                            0);
+
+        int taskId = cudaTaskCount % 2 + 2;
         hasCallback_[taskId] = false;
-        enqueueTaskKernel<<<1, 1, 0, stream>>>(
-            opType, realSize, broadcastRoot, bufferOffset, meta, tasks_device_,
-            meta->size, meta->activeRanksDevice,
+        enqueueTaskKernel<<<1, 1, 0, meta->transferStream>>>(
+            task.opType, task.tensorSize, task.broadcastRoot, task.peerGroup,
+            slot, meta, tasks_device_, meta->size, meta->activeRanksDevice,
             meta->activeRanksTensor.data_ptr<int>(), taskId);
-        bufferToTensor(
-            (void*)meta->segmentInfos[meta->rank].recv_buffer[bufferOffset],
-            pos, realSize);
+        cudaEventRecord(meta->transferredEvents[slot], meta->transferStream);
 
         ++cudaTaskCount;
         ++meta->taskCount;
     }
-
-    auto event = std::make_shared<torch::Event>(torch::kCUDA);
-    event->record(stream);
-    return c10::make_intrusive<MooncakeWorkCuda>(opType, event);
+    while (consumed < pipelineTasks.size()) consumeNext();
 }
 
-}  // namespace mooncake
\ No newline at end of file
+}  // namespace mooncake
@@ -11,6 +11,27 @@ enum WorkerTaskStatus {
     DONE = 3,
 };
 
+// Ranks that exchange data in a task: first + k * stride for k < count.
+// The completion signal still goes to every rank of the group, so buffer
+// slots are recycled in lockstep no matter which peers a round involves.
+struct PeerRange {
+    int first, stride, count;
+    int indexOf(int rank) const { return (rank - first) / stride; }
+};
+
+static PeerRange peerRangeOf(const TransferGroupMeta* group, int peerGroup) {
+    int localSize = group->localSize;
+    switch (peerGroup) {
+        case kLocalNode:
+            return {group->rank - group->rank % localSize, 1, localSize};
+        case kSameLocalRank:
+            return {group->rank % localSize, localSize,
+                    group->size / localSize};
+        default:
+            return {0, 1, group->size};
+    }
+}
+
 void MooncakeWorker::startWorker() {
     running_ = true;
     std::thread([this] {
@@ -40,8 +61,11 @@ void MooncakeWorker::startWorker() {
                                              std::memory_order_release);
                         continue;
                     }
+                    auto peers = peerRangeOf(group, task.peerGroup);
+                    int index = peers.indexOf(group->rank);
                     std::vector<TransferRequest> entries;
-                    for (int j = 0; j < group->size; ++j) {
+                    for (int k = 0; k < peers.count; ++k) {
+                        int j = peers.first + k * peers.stride;
                         if (!group->activeRanks[j]) {
                             continue;
                         }
@@ -65,7 +89,7 @@ void MooncakeWorker::startWorker() {
                             case c10d::OpType::ALLTOALL:
                             case c10d::OpType::_REDUCE_SCATTER_BASE:
                             case c10d::OpType::SCATTER:
-                                source += j * task.tensorSize;
+                                source += k * task.tensorSize;
                                 break;
                             default:
                                 break;
@@ -86,7 +110,7 @@ void MooncakeWorker::startWorker() {
                             case c10d::OpType::_REDUCE_SCATTER_BASE:
                             case c10d::OpType::REDUCE:
                             case c10d::OpType::GATHER:
-                                target_offset += group->rank * task.tensorSize;
+                                target_offset += index * task.tensorSize;
                                 break;
 
                             default:
@@ -116,7 +140,9 @@ void MooncakeWorker::startWorker() {
                         auto now = clock::now();
                         auto diff = std::chrono::duration_cast<
                             std::chrono::microseconds>(now - activeTime[i]);
-                        for (int j = 0; j < group->size; ++j) {
+                        auto peers = peerRangeOf(group, task.peerGroup);
+                        for (int k = 0; k < peers.count; ++k) {
+                            int j = peers.first + k * peers.stride;
                             if (!group->activeRanks[j]) {
                                 continue;
                             }
@@ -145,6 +171,10 @@ void MooncakeWorker::startWorker() {
                                         "extension_task_count_" +
                                         std::to_string(group->backendIndex) +
                                         "_" + std::to_string(j));
+                                    group->store->deleteKey(
+                                        "extension_barrier_epoch_" +
+                                        std::to_string(group->backendIndex) +
+                                        "_" + std::to_string(j));
                                     group->activeRanks[j] = false;
                                     group->peerConnected[j] = false;
                                 } else {
@@ -212,6 +242,10 @@ void MooncakeWorker::startWorker() {
                                     "extension_task_count_" +
                                     std::to_string(group->backendIndex) + "_" +
                                     std::to_string(j));
+                                group->store->deleteKey(
+                                    "extension_barrier_epoch_" +
+                                    std::to_string(group->backendIndex) + "_" +
+                                    std::to_string(j));
                                 group->activeRanks[j] = false;
                                 group->peerConnected[j] = false;
                             } else {
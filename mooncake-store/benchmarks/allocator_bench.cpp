@@ -1,3 +1,4 @@
+#include <atomic>
 #include <iostream>
 #include <random>
 #include <vector>
@@ -5,7 +6,10 @@
 #include <algorithm>
 #include <numeric>
 #include <iomanip>
+#include <deque>
+#include <thread>
 
+#include "allocation_strategy.h"
 #include "offset_allocator/offset_allocator.hpp"
 
 using namespace mooncake::offset_allocator;
@@ -178,8 +182,166 @@ void random_size_allocation_benchmark() {
     std::cout << "avg alloc time: " << avg_time_ns << " ns/op" << std::endl;
 }
 
+// Place objects on segments of different sizes with a strategy, dropping
+// the oldest objects when allocation fails, like a cache under churn.
+template <typename Strategy>
+void allocation_strategy_benchmark(const std::string& strategy_name) {
+    const size_t num_segments = 64;
+    const size_t num_busy_segments = 8;
+    const size_t min_alloc_size = 1024 * 1024;
+    const size_t max_alloc_size = 16 * 1024 * 1024;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> segment_size_dist(128, 512);
+    std::uniform_int_distribution<size_t> alloc_size_dist(min_alloc_size,
+                                                          max_alloc_size);
+
+    Strategy strategy;
+    mooncake::AllocatorManager allocator_manager;
+    std::vector<std::shared_ptr<mooncake::BufferAllocatorBase>> allocators;
+    for (size_t i = 0; i < num_segments; i++) {
+        const std::string name = "segment_" + std::to_string(i);
+        const size_t size = segment_size_dist(gen) * 1024 * 1024;
+        auto allocator = std::make_shared<mooncake::OffsetBufferAllocator>(
+            name, 0x100000000ULL * (i + 1), size, name);
+        allocator_manager.addAllocator(name, allocator);
+        allocators.push_back(allocator);
+        // The first segments are on hosts with saturated NICs
+        strategy.UpdateSegmentLoad(
+            name, i < num_busy_segments ? 20ULL << 30 : 2ULL << 30);
+    }
+
+    std::deque<std::vector<mooncake::Replica>> objects;
+    int benchmark_num = 200000;
+    int busy_allocations = 0;
+    int failed_allocations = 0;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < benchmark_num; i++) {
+        const size_t alloc_size = alloc_size_dist(gen);
+        auto result = strategy.Allocate(allocator_manager, alloc_size);
+        while (!result.has_value() && !objects.empty()) {
+            objects.pop_front();
+            result = strategy.Allocate(allocator_manager, alloc_size);
+        }
+        if (!result.has_value()) {
+            failed_allocations++;
+            continue;
+        }
+        const auto segment_name =
+            result.value()[0].get_segment_names()[0].value_or("");
+        if (std::stoul(segment_name.substr(segment_name.find('_') + 1)) <
+            num_busy_segments) {
+            busy_allocations++;
+        }
+        objects.push_back(std::move(result.value()));
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    std::vector<double> used_ratios;
+    for (const auto& allocator : allocators) {
+        used_ratios.push_back(static_cast<double>(allocator->size()) /
+                              allocator->capacity());
+    }
+    std::sort(used_ratios.begin(), used_ratios.end());
+    const double mean_used =
+        std::accumulate(used_ratios.begin(), used_ratios.end(), 0.0) /
+        used_ratios.size();
+    const double avg_time_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end_time -
+                                                             start_time)
+            .count() /
+        static_cast<double>(benchmark_num);
+
+    std::cout << std::endl
+              << "=== " << strategy_name << " Benchmark ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(6);
+    std::cout << "segment used ratio (min / p50 / max / avg): "
+              << used_ratios.front() << " / "
+              << used_ratios[used_ratios.size() / 2] << " / "
+              << used_ratios.back() << " / " << mean_used << std::endl;
+    std::cout << "allocations on busy segments: "
+              << static_cast<double>(busy_allocations) / benchmark_num
+              << " (busy segments: "
+              << static_cast<double>(num_busy_segments) / num_segments << ")"
+              << std::endl;
+    std::cout << "failed allocations: " << failed_allocations << std::endl;
+    std::cout << "avg alloc time (including evictions): " << avg_time_ns
+              << " ns/op" << std::endl;
+}
+
+// Threads allocating and freeing KV-block-like sizes on one allocator: mostly
+// 16-64KB, some smaller, a few of megabytes, each thread keeping a window of
+// live blocks. Compares the bin allocator alone with the per-CPU magazines.
+void multi_threaded_mixed_size_benchmark(uint64_t magazine_bytes) {
+    const size_t pool_size = 8ull * 1024 * 1024 * 1024;
+    const size_t live_blocks = 64;
+    const int ops_per_thread = 500000;
+
+    std::cout << std::endl
+              << "=== Multi-threaded Mixed Size Benchmark (magazine bytes: "
+              << magazine_bytes << ") ===" << std::endl;
+    for (int num_threads : {1, 4, 8, 16}) {
+        auto allocator = OffsetAllocator::create(0x1000, pool_size, 128 * 1024,
+                                                 16 * 1024 * 1024,
+                                                 magazine_bytes);
+        std::atomic<int> failed{0};
+        std::vector<std::thread> threads;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&, t] {
+                std::mt19937 gen(t);
+                std::uniform_int_distribution<uint32_t> kind(0, 99);
+                std::uniform_int_distribution<uint32_t> kv(16 * 1024,
+                                                           64 * 1024);
+                std::uniform_int_distribution<uint32_t> small(1024, 16 * 1024);
+                std::uniform_int_distribution<uint32_t> large(
+                    256 * 1024, 4 * 1024 * 1024);
+                std::uniform_int_distribution<size_t> victim(0,
+                                                             live_blocks - 1);
+                std::vector<OffsetAllocationHandle> live;
+                live.reserve(live_blocks);
+                for (int i = 0; i < ops_per_thread; i++) {
+                    const uint32_t k = kind(gen);
+                    const size_t size =
+                        k < 80 ? kv(gen) : (k < 95 ? small(gen) : large(gen));
+                    if (live.size() == live_blocks) {
+                        std::swap(live[victim(gen)], live.back());
+                        live.pop_back();
+                    }
+                    auto handle = allocator->allocate(size);
+                    if (!handle) {
+                        failed++;
+                        continue;
+                    }
+                    live.push_back(std::move(*handle));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        auto end_time = std::chrono::high_resolution_clock::now();
+        const double seconds =
+            std::chrono::duration<double>(end_time - start_time).count();
+        const double total_ops =
+            static_cast<double>(num_threads) * ops_per_thread;
+        std::cout << std::fixed << std::setprecision(2)
+                  << "threads: " << num_threads
+                  << ", throughput: " << total_ops / seconds / 1e6
+                  << " M alloc+free/s, avg: " << seconds * 1e9 / total_ops
+                  << " ns/op, failed: " << failed.load() << std::endl;
+    }
+}
+
 int main() {
     std::cout << "=== OffsetAllocator Benchmark ===" << std::endl;
     uniform_size_allocation_benchmark<OffsetAllocatorBenchHelper>();
     random_size_allocation_benchmark<OffsetAllocatorBenchHelper>();
+    multi_threaded_mixed_size_benchmark(0);
+    multi_threaded_mixed_size_benchmark(4 * 1024 * 1024);
+
+    allocation_strategy_benchmark<mooncake::RandomAllocationStrategy>(
+        "RandomAllocationStrategy");
+    allocation_strategy_benchmark<mooncake::LoadAwareAllocationStrategy>(
+        "LoadAwareAllocationStrategy");
 }
\ No newline at end of file
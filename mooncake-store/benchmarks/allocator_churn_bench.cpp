@@ -0,0 +1,474 @@
+// Compares the buffer allocators under long-running churn driven by a size
+// and lifetime distribution, as recorded from a deployment.
+//
+// The churn phase simulates hours of allocations on one segment: objects
+// arrive as a Poisson process at the rate that fills the segment to
+// --target_utilization on average (Little's law), and are freed after an
+// exponentially distributed lifetime. When an allocation fails, the oldest
+// objects are evicted until it succeeds, as the master does. Utilization and
+// fragmentation are reported every --report_interval_s of simulated time.
+//
+// The contention phase runs threads allocating and freeing sizes of the
+// same distribution on one allocator, and reports the throughput and the
+// allocation latency percentiles.
+//
+// The distribution is a CSV file of `min_size,max_size,weight,lifetime_s`
+// lines: sizes are uniform in [min_size, max_size] bytes, an entry is picked
+// with a probability proportional to its weight, and lifetime_s is the mean
+// lifetime in seconds. Lines starting with '#' are skipped.
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "allocator.h"
+
+DEFINE_string(size_distribution, "",
+              "CSV of min_size,max_size,weight,lifetime_s lines, empty for "
+              "a built-in KV cache like distribution");
+DEFINE_string(allocators, "offset,cachelib,slab",
+              "Comma-separated allocators to compare: offset|cachelib|slab");
+DEFINE_uint64(pool_size_mb, 4096, "Size of the segment in MB");
+DEFINE_uint64(slab_block_size, 0,
+              "Block size of the slab allocator, 0 for the largest size of "
+              "the distribution. Larger sizes fail on it.");
+DEFINE_double(simulated_hours, 24, "Simulated time of the churn phase");
+DEFINE_double(report_interval_s, 1800,
+              "Simulated seconds between two churn reports");
+DEFINE_double(target_utilization, 0.9,
+              "Average share of the segment the live objects would take");
+DEFINE_string(threads, "1,4,8,16",
+              "Comma-separated thread counts of the contention phase");
+DEFINE_uint64(ops_per_thread, 200000,
+              "Allocations per thread in the contention phase");
+DEFINE_string(csv_output, "",
+              "Write the churn reports to this CSV file, for plotting");
+DEFINE_uint64(seed, 42, "Random seed");
+
+using namespace mooncake;
+
+namespace {
+
+constexpr size_t kBase = 0x100000000ULL;
+
+struct SizeClass {
+    size_t min_size;
+    size_t max_size;
+    double weight;
+    double lifetime_s;
+};
+
+class Workload {
+   public:
+    explicit Workload(std::vector<SizeClass> classes)
+        : classes_(std::move(classes)) {
+        std::vector<double> weights;
+        for (const auto& size_class : classes_) {
+            weights.push_back(size_class.weight);
+        }
+        pick_ = std::discrete_distribution<size_t>(weights.begin(),
+                                                   weights.end());
+    }
+
+    const SizeClass& pick(std::mt19937_64& gen) { return classes_[pick_(gen)]; }
+
+    static size_t size(const SizeClass& size_class, std::mt19937_64& gen) {
+        return std::uniform_int_distribution<size_t>(size_class.min_size,
+                                                     size_class.max_size)(gen);
+    }
+
+    size_t maxSize() const {
+        size_t max_size = 0;
+        for (const auto& size_class : classes_) {
+            max_size = std::max(max_size, size_class.max_size);
+        }
+        return max_size;
+    }
+
+    // Mean of size * lifetime, the byte-seconds an arrival holds
+    double meanByteSeconds() const {
+        double total = 0, weights = 0;
+        for (const auto& c : classes_) {
+            total += c.weight * (c.min_size + c.max_size) / 2 * c.lifetime_s;
+            weights += c.weight;
+        }
+        return total / weights;
+    }
+
+   private:
+    std::vector<SizeClass> classes_;
+    std::discrete_distribution<size_t> pick_;
+};
+
+std::vector<SizeClass> DefaultClasses() {
+    return {{4 << 10, 16 << 10, 15, 30},
+            {16 << 10, 64 << 10, 35, 120},
+            {64 << 10, 256 << 10, 25, 300},
+            {256 << 10, 1 << 20, 15, 600},
+            {1 << 20, 4 << 20, 10, 1800}};
+}
+
+bool ParseClasses(const std::string& path, std::vector<SizeClass>& classes) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG(ERROR) << "Cannot open size distribution " << path;
+        return false;
+    }
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(file, line)) {
+        line_no++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::stringstream stream(line);
+        std::string field;
+        std::vector<double> values;
+        while (std::getline(stream, field, ',')) {
+            try {
+                values.push_back(std::stod(field));
+            } catch (const std::exception&) {
+                values.clear();
+                break;
+            }
+        }
+        if (values.size() != 4 || values[0] < 1 || values[1] < values[0] ||
+            values[2] <= 0 || values[3] <= 0) {
+            LOG(ERROR) << "Malformed size distribution line " << line_no
+                       << ": " << line;
+            return false;
+        }
+        classes.push_back({static_cast<size_t>(values[0]),
+                           static_cast<size_t>(values[1]), values[2],
+                           values[3]});
+    }
+    if (classes.empty()) {
+        LOG(ERROR) << "Empty size distribution " << path;
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> SplitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::shared_ptr<BufferAllocatorBase> CreateAllocator(const std::string& type,
+                                                     size_t pool_size,
+                                                     size_t block_size) {
+    if (type == "offset") {
+        return std::make_shared<OffsetBufferAllocator>(type, kBase, pool_size,
+                                                       type);
+    }
+    if (type == "cachelib") {
+        return std::make_shared<CachelibBufferAllocator>(type, kBase,
+                                                         pool_size, type);
+    }
+    if (type == "slab") {
+        return std::make_shared<SlabBufferAllocator>(type, kBase, pool_size,
+                                                     block_size, type);
+    }
+    LOG(ERROR) << "Unknown allocator " << type;
+    return nullptr;
+}
+
+// Slab allocators only hand out whole blocks, smaller objects take one
+size_t AllocationSize(const BufferAllocatorBase& allocator, size_t size) {
+    const size_t block_size = allocator.getBlockSize();
+    return block_size && size <= block_size ? block_size : size;
+}
+
+struct ChurnReport {
+    double hours;
+    double utilization;  // Bytes of the live objects / capacity
+    double used;         // Bytes the allocator hands out / capacity
+    double fragmentation;
+    uint64_t live_objects;
+    uint64_t allocations;
+    uint64_t evictions;
+    uint64_t failures;
+    double avg_alloc_ns;
+};
+
+void RunChurn(const std::string& type, Workload& workload, size_t pool_size,
+              size_t block_size, std::ofstream* csv) {
+    auto allocator = CreateAllocator(type, pool_size, block_size);
+    if (!allocator) {
+        return;
+    }
+    struct Object {
+        std::unique_ptr<AllocatedBuffer> buffer;
+        size_t size;
+    };
+    std::mt19937_64 gen(FLAGS_seed);
+    const double arrival_rate = FLAGS_target_utilization *
+                                allocator->capacity() /
+                                workload.meanByteSeconds();
+    std::exponential_distribution<double> interarrival(arrival_rate);
+    std::unordered_map<uint64_t, Object> live;
+    // Expiries as (time, id), and ids in allocation order for eviction;
+    // both skip the objects already gone
+    using Expiry = std::pair<double, uint64_t>;
+    std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>>
+        expiries;
+    std::deque<uint64_t> order;
+    size_t live_bytes = 0;
+    uint64_t next_id = 0;
+
+    ChurnReport report{};
+    double interval_ns = 0;
+    uint64_t interval_allocations = 0;
+    const double end = FLAGS_simulated_hours * 3600;
+    double next_report = FLAGS_report_interval_s;
+
+    std::cout << std::endl
+              << "=== Churn: " << type << " (" << std::fixed
+              << std::setprecision(2) << arrival_rate
+              << " allocations/s) ===" << std::endl;
+    std::cout << std::left << std::setw(8) << "Hours" << std::setw(10)
+              << "Util" << std::setw(10) << "Used" << std::setw(10) << "Frag"
+              << std::setw(10) << "Objects" << std::setw(12) << "Evictions"
+              << std::setw(10) << "Failures" << std::setw(10) << "Alloc ns"
+              << std::endl;
+
+    auto free_object = [&](uint64_t id) {
+        auto it = live.find(id);
+        if (it == live.end()) {
+            return false;
+        }
+        live_bytes -= it->second.size;
+        live.erase(it);
+        return true;
+    };
+    auto emit = [&](double now) {
+        const auto stats = allocator->getStats();
+        report.hours = now / 3600;
+        report.utilization =
+            static_cast<double>(live_bytes) / allocator->capacity();
+        report.used =
+            static_cast<double>(allocator->size()) / allocator->capacity();
+        report.fragmentation = stats.fragmentation;
+        report.live_objects = live.size();
+        report.avg_alloc_ns =
+            interval_allocations ? interval_ns / interval_allocations : 0;
+        interval_ns = 0;
+        interval_allocations = 0;
+        std::cout << std::fixed << std::setprecision(2) << std::setw(8)
+                  << report.hours << std::setprecision(4) << std::setw(10)
+                  << report.utilization << std::setw(10) << report.used
+                  << std::setw(10) << report.fragmentation << std::setw(10)
+                  << report.live_objects << std::setw(12) << report.evictions
+                  << std::setw(10) << report.failures << std::setprecision(0)
+                  << std::setw(10) << report.avg_alloc_ns << std::endl;
+        if (csv) {
+            *csv << type << "," << report.hours << "," << report.utilization
+                 << "," << report.used << "," << report.fragmentation << ","
+                 << report.live_objects << "," << report.allocations << ","
+                 << report.evictions << "," << report.failures << ","
+                 << report.avg_alloc_ns << "\n";
+        }
+    };
+
+    double now = 0;
+    while (true) {
+        const double arrival = now + interarrival(gen);
+        // Free what expires before the arrival, reporting on the way
+        while (!expiries.empty() && expiries.top().first <= arrival) {
+            auto [time, id] = expiries.top();
+            while (next_report <= time && next_report <= end) {
+                emit(next_report);
+                next_report += FLAGS_report_interval_s;
+            }
+            expiries.pop();
+            free_object(id);
+        }
+        while (next_report <= arrival && next_report <= end) {
+            emit(next_report);
+            next_report += FLAGS_report_interval_s;
+        }
+        now = arrival;
+        if (now > end) {
+            break;
+        }
+
+        const auto& size_class = workload.pick(gen);
+        const size_t size = Workload::size(size_class, gen);
+        const size_t alloc_size = AllocationSize(*allocator, size);
+        std::unique_ptr<AllocatedBuffer> buffer;
+        while (true) {
+            auto start = std::chrono::steady_clock::now();
+            buffer = allocator->allocate(alloc_size);
+            interval_ns += std::chrono::duration<double, std::nano>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+            interval_allocations++;
+            if (buffer || live.empty()) {
+                break;
+            }
+            while (!order.empty() && !free_object(order.front())) {
+                order.pop_front();
+            }
+            if (!order.empty()) {
+                order.pop_front();
+                report.evictions++;
+            }
+        }
+        if (!buffer) {
+            report.failures++;
+            continue;
+        }
+        const uint64_t id = next_id++;
+        report.allocations++;
+        live_bytes += size;
+        live.emplace(id, Object{std::move(buffer), size});
+        order.push_back(id);
+        expiries.emplace(now + std::exponential_distribution<double>(
+                                   1 / size_class.lifetime_s)(gen),
+                         id);
+    }
+    live.clear();
+}
+
+void RunContention(const std::string& type, Workload& workload,
+                   size_t pool_size, size_t block_size, int num_threads) {
+    auto allocator = CreateAllocator(type, pool_size, block_size);
+    if (!allocator) {
+        return;
+    }
+    // Each thread keeps its share of the target utilization live, freeing
+    // random objects of its own to make room
+    const size_t budget = static_cast<size_t>(
+        FLAGS_target_utilization * allocator->capacity() / num_threads);
+    std::atomic<uint64_t> failures{0};
+    std::vector<std::vector<double>> latencies(num_threads);
+    std::vector<std::thread> threads;
+    auto start_time = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 gen(FLAGS_seed + t);
+            Workload thread_workload = workload;
+            std::vector<std::unique_ptr<AllocatedBuffer>> live;
+            size_t live_bytes = 0;
+            auto& thread_latencies = latencies[t];
+            thread_latencies.reserve(FLAGS_ops_per_thread);
+            for (uint64_t i = 0; i < FLAGS_ops_per_thread; i++) {
+                const size_t size = AllocationSize(
+                    *allocator, Workload::size(thread_workload.pick(gen), gen));
+                while (!live.empty() && live_bytes + size > budget) {
+                    std::uniform_int_distribution<size_t> victim(
+                        0, live.size() - 1);
+                    std::swap(live[victim(gen)], live.back());
+                    live_bytes -= live.back()->size();
+                    live.pop_back();
+                }
+                auto start = std::chrono::steady_clock::now();
+                auto buffer = allocator->allocate(size);
+                thread_latencies.push_back(
+                    std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count());
+                if (!buffer) {
+                    failures++;
+                    continue;
+                }
+                live_bytes += size;
+                live.push_back(std::move(buffer));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start_time)
+                               .count();
+    std::vector<double> all;
+    for (auto& thread_latencies : latencies) {
+        all.insert(all.end(), thread_latencies.begin(),
+                   thread_latencies.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) {
+        return all.empty() ? 0.0
+                           : all[std::min(all.size() - 1,
+                                          static_cast<size_t>(p * all.size()))];
+    };
+    std::cout << std::left << std::fixed << std::setprecision(2)
+              << std::setw(10) << type << std::setw(9) << num_threads
+              << std::setw(14) << all.size() / seconds / 1e6
+              << std::setprecision(0) << std::setw(10) << percentile(0.5)
+              << std::setw(10) << percentile(0.99) << std::setw(10)
+              << percentile(0.999) << std::setw(10) << failures.load()
+              << std::endl;
+}
+
+int Run() {
+    std::vector<SizeClass> classes;
+    if (FLAGS_size_distribution.empty()) {
+        classes = DefaultClasses();
+    } else if (!ParseClasses(FLAGS_size_distribution, classes)) {
+        return 1;
+    }
+    Workload workload(std::move(classes));
+    const size_t pool_size = FLAGS_pool_size_mb * 1024 * 1024;
+    const size_t block_size =
+        FLAGS_slab_block_size ? FLAGS_slab_block_size : workload.maxSize();
+    const auto types = SplitList(FLAGS_allocators);
+
+    std::unique_ptr<std::ofstream> csv;
+    if (!FLAGS_csv_output.empty()) {
+        csv = std::make_unique<std::ofstream>(FLAGS_csv_output);
+        if (!*csv) {
+            LOG(ERROR) << "Cannot open " << FLAGS_csv_output;
+            return 1;
+        }
+        *csv << "allocator,hours,utilization,used,fragmentation,live_objects,"
+                "allocations,evictions,failures,avg_alloc_ns\n";
+    }
+    for (const auto& type : types) {
+        RunChurn(type, workload, pool_size, block_size, csv.get());
+    }
+
+    std::cout << std::endl << "=== Contention ===" << std::endl;
+    std::cout << std::left << std::setw(10) << "Allocator" << std::setw(9)
+              << "Threads" << std::setw(14) << "M allocs/s" << std::setw(10)
+              << "P50 ns" << std::setw(10) << "P99 ns" << std::setw(10)
+              << "P999 ns" << std::setw(10) << "Failures" << std::endl;
+    for (const auto& type : types) {
+        for (const auto& threads : SplitList(FLAGS_threads)) {
+            RunContention(type, workload, pool_size, block_size,
+                          std::stoi(threads));
+        }
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    google::InitGoogleLogging(argv[0]);
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    return Run();
+}
@@ -21,10 +21,14 @@
 #include <thread>
 #include <vector>
 
+#include <ylt/coro_rpc/coro_rpc_server.hpp>
+
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 
 #include "master_client.h"
+#include "master_service.h"
+#include "rpc_service.h"
 
 // Size units for better readability
 static constexpr size_t KiB = 1024;
@@ -44,6 +48,16 @@ DEFINE_uint64(num_keys, 10 * 1000,
 DEFINE_uint64(batch_size, 128, "Batch size for batch operations");
 DEFINE_uint64(value_size, 4096, "Size of object values");
 DEFINE_uint64(duration, 60, "Test duration in seconds");
+DEFINE_uint64(num_hot_keys, 8,
+              "Number of keys shared by all threads for HotGet operations");
+DEFINE_uint64(hot_replica_cache_size, 1024,
+              "Size of the hot key read cache of the in-process master used "
+              "by LocalHotGet, 0 to disable");
+DEFINE_uint64(local_master_rpc_threads, 0,
+              "Serve the port of master_server from a master in this process "
+              "with this many RPC threads, to compare the throughput of "
+              "thread counts without a separate master. 0 to use a running "
+              "master");
 
 static inline void unset_cpu_affinity() {
     // Ensure that the worker threads are not bound to any CPU cores.
@@ -124,6 +138,10 @@ enum class BenchOperation {
     GET,
     BATCH_PUT,
     BATCH_GET,
+    // Every thread reads the same few keys, e.g. the blocks of a shared
+    // system prompt
+    HOT_GET,
+    HOT_BATCH_GET,
 };
 
 static inline BenchOperation ParseOperation(const std::string& operation_str) {
@@ -135,6 +153,10 @@ static inline BenchOperation ParseOperation(const std::string& operation_str) {
         return BenchOperation::BATCH_PUT;
     } else if (operation_str == "BatchGet") {
         return BenchOperation::BATCH_GET;
+    } else if (operation_str == "HotGet") {
+        return BenchOperation::HOT_GET;
+    } else if (operation_str == "HotBatchGet") {
+        return BenchOperation::HOT_BATCH_GET;
     } else {
         throw std::invalid_argument("Invalid operation");
     }
@@ -284,6 +306,34 @@ class BenchClient {
         return keys;
     }
 
+    std::vector<std::string> GenerateHotKeys(uint64_t num_keys) {
+        static thread_local std::mt19937 generator(std::random_device{}());
+
+        std::vector<std::string> keys;
+        keys.reserve(num_keys);
+        std::uniform_int_distribution<uint64_t> distribution(
+            0, FLAGS_num_hot_keys - 1);
+        for (size_t i = 0; i < num_keys; i++) {
+            keys.push_back("hot_key_" +
+                           std::to_string(distribution(generator)));
+        }
+
+        return keys;
+    }
+
+    void PrefillHotKeys(uint64_t value_size) {
+        const mooncake::ReplicateConfig config;
+
+        // The keys are shared, all but the first put of each key fail
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < FLAGS_num_hot_keys; i++) {
+            keys.push_back("hot_key_" + std::to_string(i));
+        }
+        std::vector<std::vector<uint64_t>> slice_lengths(keys.size(),
+                                                         {value_size});
+        BatchPut(keys, slice_lengths, config);
+    }
+
     void PrefillKeys(uint64_t& key_id, uint64_t batch_size, uint64_t value_size,
                      uint64_t num_keys) {
         const mooncake::ReplicateConfig config;
@@ -316,6 +366,9 @@ class BenchClient {
         if (operation == BenchOperation::GET ||
             operation == BenchOperation::BATCH_GET) {
             PrefillKeys(key_id, batch_size, value_size, num_keys);
+        } else if (operation == BenchOperation::HOT_GET ||
+                   operation == BenchOperation::HOT_BATCH_GET) {
+            PrefillHotKeys(value_size);
         }
 
         barrier->arrive_and_wait();
@@ -343,6 +396,16 @@ class BenchClient {
                     keys = GenerateGetKeys(key_id, batch_size);
                     gCompletedOperations.fetch_add(BatchGet(keys));
                     break;
+                case BenchOperation::HOT_GET:
+                    keys = GenerateHotKeys(1);
+                    if (Get(keys[0])) {
+                        gCompletedOperations.fetch_add(1);
+                    }
+                    break;
+                case BenchOperation::HOT_BATCH_GET:
+                    keys = GenerateHotKeys(batch_size);
+                    gCompletedOperations.fetch_add(BatchGet(keys));
+                    break;
                 default:
                     break;
             }
@@ -355,6 +418,99 @@ class BenchClient {
     std::vector<std::thread> threads_;
 };
 
+// Read the hot keys directly from an in-process MasterService with
+// num_threads threads, so that the scalability of the master's read path is
+// measured without the RPC overhead.
+static int RunLocalHotGet() {
+    auto service_config = mooncake::MasterServiceConfig::builder()
+                              .set_hot_replica_cache_size(
+                                  FLAGS_hot_replica_cache_size)
+                              .build();
+    mooncake::MasterService service(service_config);
+
+    mooncake::Segment segment;
+    segment.id = mooncake::generate_uuid();
+    segment.name = "local_segment";
+    segment.base = kSegmentBase;
+    segment.size = FLAGS_segment_size;
+    segment.te_endpoint = segment.name;
+    const auto client_id = mooncake::generate_uuid();
+    if (!service.MountSegment(segment, client_id).has_value()) {
+        LOG(ERROR) << "Failed to mount segment";
+        return -1;
+    }
+
+    std::vector<std::string> keys;
+    const mooncake::ReplicateConfig config;
+    for (size_t i = 0; i < FLAGS_num_hot_keys; i++) {
+        keys.push_back("hot_key_" + std::to_string(i));
+        if (!service.PutStart(client_id, keys.back(), FLAGS_value_size, config)
+                 .has_value() ||
+            !service.PutEnd(client_id, keys.back(),
+                            mooncake::ReplicaType::MEMORY)
+                 .has_value()) {
+            LOG(ERROR) << "Failed to put key " << keys.back();
+            return -1;
+        }
+    }
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < FLAGS_num_threads; i++) {
+        threads.emplace_back([&, i] {
+            unset_cpu_affinity();
+            uint64_t completed = 0;
+            for (size_t j = i; running.load(std::memory_order_relaxed); j++) {
+                if (service.GetReplicaList(keys[j % keys.size()])
+                        .has_value()) {
+                    completed++;
+                }
+            }
+            gCompletedOperations.fetch_add(completed);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(FLAGS_duration));
+    running = false;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::cout << "Operations per second: " << std::fixed << std::setprecision(2)
+              << gCompletedOperations.load() / (double)FLAGS_duration << "\n";
+    return 0;
+}
+
+// Serves the port of FLAGS_master_server, with its metrics on the next port
+static std::unique_ptr<coro_rpc::coro_rpc_server> StartLocalMaster(
+    std::unique_ptr<mooncake::WrappedMasterService>& service) {
+    const auto port_pos = FLAGS_master_server.rfind(':');
+    if (port_pos == std::string::npos) {
+        LOG(ERROR) << "No port in master_server " << FLAGS_master_server;
+        return nullptr;
+    }
+    const auto port = static_cast<uint16_t>(
+        std::stoul(FLAGS_master_server.substr(port_pos + 1)));
+
+    auto server = std::make_unique<coro_rpc::coro_rpc_server>(
+        FLAGS_local_master_rpc_threads, port, "0.0.0.0",
+        std::chrono::seconds(0), /*tcp_no_delay=*/true);
+    mooncake::WrappedMasterServiceConfig config;
+    config.default_kv_lease_ttl = mooncake::DEFAULT_DEFAULT_KV_LEASE_TTL;
+    config.enable_metric_reporting = false;
+    config.http_port = port + 1;
+    service = std::make_unique<mooncake::WrappedMasterService>(config);
+    mooncake::RegisterRpcService(*server, *service);
+    auto ec = server->async_start();
+    if (ec.hasResult()) {
+        LOG(ERROR) << "Failed to start the local master on port " << port;
+        return nullptr;
+    }
+    LOG(INFO) << "Local master serving port " << port << " with "
+              << FLAGS_local_master_rpc_threads << " RPC threads";
+    return server;
+}
+
 int main(int argc, char** argv) {
     std::vector<std::unique_ptr<SegmentClient>> segment_clients;
     std::mutex segment_clients_mutex;
@@ -366,6 +522,26 @@ int main(int argc, char** argv) {
 
     gflags::ParseCommandLineFlags(&argc, &argv, false);
 
+    if (FLAGS_num_hot_keys == 0) {
+        LOG(ERROR) << "num_hot_keys must be positive";
+        return -1;
+    }
+    if (FLAGS_operation == "LocalHotGet") {
+        int ret = RunLocalHotGet();
+        google::ShutdownGoogleLogging();
+        return ret;
+    }
+
+    // Stopped once the clients below are disconnected
+    std::unique_ptr<mooncake::WrappedMasterService> local_master_service;
+    std::unique_ptr<coro_rpc::coro_rpc_server> local_master_server;
+    if (FLAGS_local_master_rpc_threads > 0) {
+        local_master_server = StartLocalMaster(local_master_service);
+        if (!local_master_server) {
+            return -1;
+        }
+    }
+
     ping_thread = std::jthread([&](std::stop_token stop_token) {
         static const auto OneSecond = std::chrono::seconds(1);
 
@@ -448,6 +624,9 @@ int main(int argc, char** argv) {
     bench_clients.clear();
     segment_clients.clear();
     LOG(INFO) << "Disconnected from master";
+    if (local_master_server) {
+        local_master_server->stop();
+    }
 
     std::cout << "Operations per second: " << std::fixed << std::setprecision(2)
               << num_completed_operations / (double)FLAGS_duration << "\n";
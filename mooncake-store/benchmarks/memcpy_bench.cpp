@@ -0,0 +1,89 @@
+// Throughput of MemcpyWorkerPool for local transfers, by number of workers
+// per NUMA node and copy size
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "transfer_task.h"
+
+DEFINE_string(threads, "1,2,4,8",
+              "Comma-separated numbers of workers per NUMA node");
+DEFINE_uint64(max_size_mb, 256, "Largest copy size in MB");
+DEFINE_uint64(total_gb, 8, "Bytes copied per configuration in GB");
+DEFINE_uint64(tasks_in_flight, 4, "Tasks submitted before waiting");
+
+using namespace mooncake;
+
+namespace {
+
+std::vector<size_t> ParseThreads(const std::string& spec) {
+    std::vector<size_t> threads;
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            threads.push_back(std::stoul(item));
+        }
+    }
+    return threads;
+}
+
+double MeasureGBps(MemcpyWorkerPool& pool, std::vector<char>& src,
+                   std::vector<char>& dest, size_t size) {
+    const size_t in_flight =
+        std::max<size_t>(1, std::min(FLAGS_tasks_in_flight, src.size() / size));
+    const size_t rounds =
+        std::max<size_t>(1, (FLAGS_total_gb << 30) / (size * in_flight));
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        std::vector<std::shared_ptr<MemcpyOperationState>> states;
+        for (size_t i = 0; i < in_flight; ++i) {
+            auto state = std::make_shared<MemcpyOperationState>();
+            std::vector<MemcpyOperation> operations;
+            operations.emplace_back(dest.data() + i * size,
+                                    src.data() + i * size, size);
+            pool.submitTask(MemcpyTask(std::move(operations), state));
+            states.push_back(std::move(state));
+        }
+        for (auto& state : states) {
+            state->wait_for_completion();
+        }
+    }
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    return static_cast<double>(rounds * in_flight * size) / seconds / 1e9;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    const size_t buffer_size = FLAGS_max_size_mb << 20;
+    std::vector<char> src(buffer_size, 'a');
+    std::vector<char> dest(buffer_size, 'b');
+
+    std::cout << std::setw(10) << "threads" << std::setw(14) << "size"
+              << std::setw(12) << "GB/s" << std::endl;
+    for (size_t threads : ParseThreads(FLAGS_threads)) {
+        MemcpyWorkerPool pool(threads);
+        for (size_t size = 64 << 10; size <= buffer_size; size *= 4) {
+            const double gbps = MeasureGBps(pool, src, dest, size);
+            std::cout << std::setw(10) << threads << std::setw(12)
+                      << (size >> 10) << "KB" << std::setw(12)
+                      << std::fixed << std::setprecision(2) << gbps
+                      << std::endl;
+        }
+    }
+    return 0;
+}
@@ -61,6 +61,9 @@
  *
  *   # Zipf access pattern (hot keys)
  *   ./storage_backend_bench --pattern=zipf --zipf_skew=1.2
+ *
+ *   # Checksum overhead: compare against the same run with --checksum=false
+ *   ./storage_backend_bench --test=load --checksum=true
  */
 
 #include <algorithm>
@@ -90,6 +93,7 @@
 #include <sys/utsname.h>
 #endif
 
+#include "crc32c.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "storage_backend.h"
@@ -102,7 +106,8 @@ namespace fs = std::filesystem;
 
 // === Core Parameters ===
 DEFINE_string(backend, "offset_allocator",
-              "Backend type: offset_allocator, bucket, file_per_key, or all");
+              "Backend type: offset_allocator, log_structured, bucket, "
+              "file_per_key, or all");
 DEFINE_uint64(value_size, 128 * 1024, "Value size in bytes (default: 128KB)");
 DEFINE_uint64(batch_size, 32, "Batch size for operations (default: 32)");
 DEFINE_uint64(num_operations, 1000,
@@ -128,6 +133,9 @@ DEFINE_uint64(verify_rate, 1,
               "Verify 1 in N operations (default: 1 = verify all)");
 DEFINE_bool(verify_warmup_all, true, "Always verify all warmup operations");
 DEFINE_bool(fail_fast, true, "Exit immediately on first corruption detected");
+DEFINE_bool(checksum, false,
+            "Keep a CRC32C of each value and verify it on load "
+            "(offset_allocator backend)");
 DEFINE_double(fill_ratio, 0.1,
               "Pre-populate to this fraction of capacity (0.0-1.0)");
 
@@ -242,12 +250,19 @@ AccessPattern StringToAccessPattern(const std::string& str) {
 // Backend Types
 // ============================================================================
 
-enum class BackendType { OFFSET_ALLOCATOR, BUCKET, FILE_PER_KEY };
+enum class BackendType {
+    OFFSET_ALLOCATOR,
+    LOG_STRUCTURED,
+    BUCKET,
+    FILE_PER_KEY
+};
 
 std::string BackendTypeToString(BackendType type) {
     switch (type) {
         case BackendType::OFFSET_ALLOCATOR:
             return "offset_allocator";
+        case BackendType::LOG_STRUCTURED:
+            return "log_structured";
         case BackendType::BUCKET:
             return "bucket";
         case BackendType::FILE_PER_KEY:
@@ -258,6 +273,7 @@ std::string BackendTypeToString(BackendType type) {
 
 BackendType StringToBackendType(const std::string& str) {
     if (str == "offset_allocator") return BackendType::OFFSET_ALLOCATOR;
+    if (str == "log_structured") return BackendType::LOG_STRUCTURED;
     if (str == "bucket") return BackendType::BUCKET;
     if (str == "file_per_key") return BackendType::FILE_PER_KEY;
     LOG(FATAL) << "Unknown backend type: " << str;
@@ -806,6 +822,7 @@ std::shared_ptr<mooncake::StorageBackendInterface> CreateBackend(
     config.storage_filepath = storage_path;
     config.total_size_limit = capacity_bytes;
     config.total_keys_limit = 10'000'000;
+    config.enable_checksum = FLAGS_checksum;
 
     switch (type) {
         case BackendType::OFFSET_ALLOCATOR: {
@@ -814,6 +831,12 @@ std::shared_ptr<mooncake::StorageBackendInterface> CreateBackend(
             return std::make_shared<mooncake::OffsetAllocatorStorageBackend>(
                 config);
         }
+        case BackendType::LOG_STRUCTURED: {
+            config.storage_backend_type =
+                mooncake::StorageBackendType::kLogStructured;
+            return std::make_shared<mooncake::LogStructuredStorageBackend>(
+                config, mooncake::LogStructuredConfig{});
+        }
         case BackendType::BUCKET: {
             config.storage_backend_type = mooncake::StorageBackendType::kBucket;
             mooncake::BucketBackendConfig bucket_config;
@@ -929,6 +952,15 @@ void PrintBenchmarkConfig(BackendType backend, CacheMode cache_mode) {
     }
     std::cout << "\n";
     std::cout << "  Fail fast:    " << (FLAGS_fail_fast ? "yes" : "no") << "\n";
+    std::cout << "  Checksum:     ";
+    if (!FLAGS_checksum) {
+        std::cout << "no\n";
+    } else {
+        std::cout << "crc32c ("
+                  << (mooncake::Crc32cIsHardwareAccelerated() ? "hardware"
+                                                              : "software")
+                  << ")\n";
+    }
     std::cout << "  Flush writes: "
               << (FLAGS_flush_between_ops
                       ? "yes (NOT IMPLEMENTED - requires backend API)"
@@ -2280,9 +2312,9 @@ struct BenchmarkResult {
 };
 
 void RunAllBenchmarks(const std::string& storage_path, size_t capacity) {
-    std::vector<BackendType> backends = {BackendType::OFFSET_ALLOCATOR,
-                                         BackendType::BUCKET,
-                                         BackendType::FILE_PER_KEY};
+    std::vector<BackendType> backends = {
+        BackendType::OFFSET_ALLOCATOR, BackendType::LOG_STRUCTURED,
+        BackendType::BUCKET, BackendType::FILE_PER_KEY};
 
     std::vector<BenchmarkResult> results;
 
@@ -0,0 +1,335 @@
+// Replays a recorded access trace against a running store cluster with the
+// arrival times of the trace (open loop), and reports the hit ratio, the
+// throughput and the latency percentiles of each operation.
+//
+// The trace is a CSV file of `timestamp_ms,op,key,size` lines, op being put
+// or get and size the value size in bytes. Lines starting with '#' and a
+// header line are skipped. Latencies are measured from the time an
+// operation is due, so that a saturated cluster shows up in the latencies
+// instead of slowing down the arrivals.
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allocator.h"
+#include "client_service.h"
+#include "types.h"
+#include "utils.h"
+
+DEFINE_string(trace_file, "", "Trace to replay, timestamp_ms,op,key,size");
+DEFINE_string(master_server, "localhost:50051", "Master server address");
+DEFINE_string(metadata_server, "P2PHANDSHAKE", "Metadata connection string");
+DEFINE_string(local_hostname, "localhost:12345", "Local hostname for client");
+DEFINE_string(protocol, "tcp", "Transfer protocol: rdma|tcp");
+DEFINE_string(device_names, "", "RDMA devices, valid if protocol=rdma");
+DEFINE_uint64(segment_size_mb, 4096,
+              "Memory this client contributes to the cluster, 0 for none");
+DEFINE_uint64(buffer_size_mb, 1024, "Local buffer for the values replayed");
+DEFINE_uint64(num_threads, 8, "Threads issuing the operations");
+DEFINE_double(speedup, 1.0, "Factor the trace timestamps are divided by");
+DEFINE_uint64(replica_num, 1, "Replicas of each put");
+DEFINE_bool(put_on_miss, true,
+            "Put the value after a get miss, as a recomputed KV cache");
+
+namespace mooncake {
+namespace benchmark {
+namespace {
+
+enum class OpType { PUT, GET };
+
+struct TraceOp {
+    std::chrono::microseconds time;
+    OpType type;
+    std::string key;
+    size_t size;
+};
+
+struct OpStats {
+    std::vector<double> latencies_us;
+    uint64_t count = 0;
+    uint64_t failures = 0;
+    uint64_t bytes = 0;
+};
+
+struct ThreadStats {
+    OpStats put;
+    OpStats get;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+bool ParseTrace(const std::string& path, std::vector<TraceOp>& ops) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG(ERROR) << "Cannot open trace file " << path;
+        return false;
+    }
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(file, line)) {
+        line_no++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::stringstream stream(line);
+        std::string time, op, key, size;
+        if (!std::getline(stream, time, ',') ||
+            !std::getline(stream, op, ',') ||
+            !std::getline(stream, key, ',') || !std::getline(stream, size)) {
+            LOG(ERROR) << "Malformed trace line " << line_no << ": " << line;
+            return false;
+        }
+        TraceOp trace_op;
+        try {
+            trace_op.time = std::chrono::microseconds(
+                static_cast<int64_t>(std::stod(time) * 1000));
+            trace_op.size = std::stoull(size);
+        } catch (const std::exception&) {
+            if (line_no == 1) {
+                continue;  // Header
+            }
+            LOG(ERROR) << "Malformed trace line " << line_no << ": " << line;
+            return false;
+        }
+        if (op == "put") {
+            trace_op.type = OpType::PUT;
+        } else if (op == "get") {
+            trace_op.type = OpType::GET;
+        } else {
+            LOG(ERROR) << "Unknown op on trace line " << line_no << ": " << op;
+            return false;
+        }
+        trace_op.key = std::move(key);
+        ops.push_back(std::move(trace_op));
+    }
+    std::stable_sort(ops.begin(), ops.end(),
+                     [](const TraceOp& a, const TraceOp& b) {
+                         return a.time < b.time;
+                     });
+    return true;
+}
+
+std::vector<Slice> MakeSlices(char* buffer, size_t size) {
+    std::vector<Slice> slices;
+    for (size_t offset = 0; offset < size; offset += kMaxSliceSize) {
+        slices.push_back(
+            Slice{buffer + offset, std::min(size - offset, kMaxSliceSize)});
+    }
+    return slices;
+}
+
+void Replay(Client& client, const std::vector<const TraceOp*>& ops,
+            char* buffer, std::chrono::steady_clock::time_point start,
+            ThreadStats& stats) {
+    ReplicateConfig config;
+    config.replica_num = FLAGS_replica_num;
+    auto put = [&](const TraceOp& op,
+                   std::chrono::steady_clock::time_point due) {
+        auto slices = MakeSlices(buffer, op.size);
+        auto result = client.Put(op.key, slices, config);
+        // OBJECT_ALREADY_EXISTS is a put that did not need to happen
+        bool ok = result.has_value() ||
+                  result.error() == ErrorCode::OBJECT_ALREADY_EXISTS;
+        auto end = std::chrono::steady_clock::now();
+        stats.put.count++;
+        stats.put.failures += ok ? 0 : 1;
+        stats.put.bytes += ok ? op.size : 0;
+        stats.put.latencies_us.push_back(
+            std::chrono::duration<double, std::micro>(end - due).count());
+    };
+
+    for (const TraceOp* op : ops) {
+        const auto due =
+            start + std::chrono::duration_cast<std::chrono::microseconds>(
+                        op->time / FLAGS_speedup);
+        std::this_thread::sleep_until(due);
+        if (op->type == OpType::PUT) {
+            memset(buffer, static_cast<int>(std::hash<std::string>{}(op->key)),
+                   std::min<size_t>(op->size, 4096));
+            put(*op, due);
+            continue;
+        }
+        auto slices = MakeSlices(buffer, op->size);
+        auto result = client.Get(op->key, slices);
+        auto end = std::chrono::steady_clock::now();
+        stats.get.count++;
+        stats.get.latencies_us.push_back(
+            std::chrono::duration<double, std::micro>(end - due).count());
+        if (result.has_value()) {
+            stats.hits++;
+            stats.get.bytes += op->size;
+        } else if (result.error() == ErrorCode::OBJECT_NOT_FOUND) {
+            stats.misses++;
+            if (FLAGS_put_on_miss) {
+                put(*op, std::chrono::steady_clock::now());
+            }
+        } else {
+            stats.get.failures++;
+        }
+    }
+}
+
+void Merge(OpStats& into, OpStats& from) {
+    into.latencies_us.insert(into.latencies_us.end(),
+                             from.latencies_us.begin(),
+                             from.latencies_us.end());
+    into.count += from.count;
+    into.failures += from.failures;
+    into.bytes += from.bytes;
+}
+
+void Report(const std::string& name, OpStats& stats, double seconds) {
+    if (stats.count == 0) {
+        return;
+    }
+    auto& latencies = stats.latencies_us;
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1,
+                                  static_cast<size_t>(p * latencies.size()))];
+    };
+    std::cout << std::fixed << std::setprecision(1) << name << ": "
+              << stats.count << " ops, " << stats.failures << " failed, "
+              << stats.count / seconds << " ops/s, "
+              << stats.bytes / seconds / (1024 * 1024) << " MB/s, latency us"
+              << " p50 " << percentile(0.5) << " p90 " << percentile(0.9)
+              << " p99 " << percentile(0.99) << " p999 " << percentile(0.999)
+              << " max " << latencies.back() << std::endl;
+}
+
+int Run() {
+    std::vector<TraceOp> ops;
+    if (FLAGS_trace_file.empty() || !ParseTrace(FLAGS_trace_file, ops)) {
+        LOG(ERROR) << "A valid --trace_file is required";
+        return 1;
+    }
+    size_t max_size = 0;
+    for (const auto& op : ops) {
+        max_size = std::max(max_size, op.size);
+    }
+    const size_t buffer_size = FLAGS_buffer_size_mb * 1024 * 1024;
+    if (max_size * FLAGS_num_threads > buffer_size) {
+        LOG(ERROR) << "--buffer_size_mb is too small for " << FLAGS_num_threads
+                   << " values of " << max_size << " bytes";
+        return 1;
+    }
+
+    auto client_opt = Client::Create(
+        FLAGS_local_hostname, FLAGS_metadata_server, FLAGS_protocol,
+        FLAGS_device_names.empty()
+            ? std::nullopt
+            : std::optional<std::string>(FLAGS_device_names),
+        FLAGS_master_server);
+    if (!client_opt.has_value()) {
+        LOG(ERROR) << "Failed to create client";
+        return 1;
+    }
+    auto client = *client_opt;
+
+    const size_t segment_size = FLAGS_segment_size_mb * 1024 * 1024;
+    void* segment = nullptr;
+    if (segment_size > 0) {
+        segment = allocate_buffer_allocator_memory(segment_size);
+        if (!segment ||
+            !client->MountSegment(segment, segment_size).has_value()) {
+            LOG(ERROR) << "Failed to mount segment of " << segment_size
+                       << " bytes";
+            return 1;
+        }
+    }
+    SimpleAllocator buffer_allocator(buffer_size);
+    if (!client
+             ->RegisterLocalMemory(buffer_allocator.getBase(), buffer_size,
+                                   kWildcardLocation, false, false)
+             .has_value()) {
+        LOG(ERROR) << "Failed to register local buffer";
+        return 1;
+    }
+
+    // Operations on a key stay on one thread, in trace order
+    std::vector<std::vector<const TraceOp*>> thread_ops(FLAGS_num_threads);
+    for (const auto& op : ops) {
+        thread_ops[std::hash<std::string>{}(op.key) % FLAGS_num_threads]
+            .push_back(&op);
+    }
+    std::vector<ThreadStats> thread_stats(FLAGS_num_threads);
+    std::vector<char*> buffers;
+    for (size_t i = 0; i < FLAGS_num_threads; ++i) {
+        buffers.push_back(static_cast<char*>(
+            buffer_allocator.allocate(std::max<size_t>(max_size, 1))));
+        if (!buffers.back()) {
+            LOG(ERROR) << "Failed to allocate value buffer";
+            return 1;
+        }
+    }
+
+    LOG(INFO) << "Replaying " << ops.size() << " operations with "
+              << FLAGS_num_threads << " threads";
+    const auto start =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < FLAGS_num_threads; ++i) {
+        threads.emplace_back([&, i]() {
+            Replay(*client, thread_ops[i], buffers[i], start, thread_stats[i]);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+
+    ThreadStats total;
+    for (auto& stats : thread_stats) {
+        Merge(total.put, stats.put);
+        Merge(total.get, stats.get);
+        total.hits += stats.hits;
+        total.misses += stats.misses;
+    }
+    std::cout << "Replayed " << ops.size() << " operations in " << std::fixed
+              << std::setprecision(2) << seconds << " s" << std::endl;
+    Report("put", total.put, seconds);
+    Report("get", total.get, seconds);
+    if (total.hits + total.misses > 0) {
+        std::cout << "get hit ratio: " << std::setprecision(4)
+                  << static_cast<double>(total.hits) /
+                         (total.hits + total.misses)
+                  << " (" << total.hits << " hits, " << total.misses
+                  << " misses)" << std::endl;
+    }
+
+    for (size_t i = 0; i < FLAGS_num_threads; ++i) {
+        buffer_allocator.deallocate(buffers[i], std::max<size_t>(max_size, 1));
+    }
+    if (segment) {
+        client->UnmountSegment(segment, segment_size);
+    }
+    client.reset();
+    if (segment) {
+        free_memory("", segment);
+    }
+    return 0;
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace mooncake
+
+int main(int argc, char** argv) {
+    google::InitGoogleLogging(argv[0]);
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    return mooncake::benchmark::Run();
+}
@@ -5,8 +5,10 @@
 #include <random>
 #include <string>
 #include <set>
+#include <shared_mutex>
 #include <unordered_map>
 #include <iterator>
+#include <limits>
 #include <time.h>
 #include <ylt/util/tl/expected.hpp>
 
@@ -40,13 +42,27 @@ class AllocatorManager {
      * @brief Add an allocator of segment `name` into the manager.
      * @param name the name of the segment
      * @param allocator the buffer allocator to add for the segment
+     * @param locality the failure domains of the segment, see
+     *        Segment::locality. An empty one keeps the current label.
      */
     void addAllocator(const std::string& name,
-                      const std::shared_ptr<BufferAllocatorBase>& allocator) {
+                      const std::shared_ptr<BufferAllocatorBase>& allocator,
+                      const std::string& locality = "") {
         if (!allocators_.contains(name)) {
             names_.push_back(name);
         }
         allocators_[name].push_back(allocator);
+        if (!locality.empty()) {
+            localities_[name] = locality;
+        }
+        const size_t block_size = allocator->getBlockSize();
+        if (block_size != 0) {
+            auto& slab_names = slab_names_[block_size];
+            if (std::find(slab_names.begin(), slab_names.end(), name) ==
+                slab_names.end()) {
+                slab_names.push_back(name);
+            }
+        }
     }
 
     /**
@@ -73,11 +89,20 @@ class AllocatorManager {
         if (alloc_it != it->second.end()) {
             it->second.erase(alloc_it);
             allocator_removed = true;
+            const size_t block_size = allocator->getBlockSize();
+            if (block_size != 0 &&
+                std::none_of(it->second.begin(), it->second.end(),
+                             [block_size](const auto& other) {
+                                 return other->getBlockSize() == block_size;
+                             })) {
+                removeSlabName(block_size, name);
+            }
         }
 
         if (it->second.empty()) {
             // If there is no allocator left, remove the name too.
             allocators_.erase(name);
+            localities_.erase(name);
             auto name_it = std::find(names_.begin(), names_.end(), name);
             if (name_it != names_.end()) {
                 std::swap(*name_it, names_.back());
@@ -109,15 +134,84 @@ class AllocatorManager {
         }
     }
 
+    /**
+     * @brief Get the locality label of the segment `name`.
+     * @return the label, or an empty string if the segment has none
+     */
+    const std::string& getLocality(const std::string& name) const {
+        static const std::string kNoLocality;
+        auto it = localities_.find(name);
+        return it != localities_.end() ? it->second : kNoLocality;
+    }
+
+    /**
+     * @brief Whether any segment carries a locality label.
+     */
+    bool hasLocalities() const { return !localities_.empty(); }
+
+    /**
+     * @brief Get the names of the segments with a slab allocator of blocks
+     *        of exactly `block_size`.
+     * @return the names, or nullptr if there are none
+     */
+    const std::vector<std::string>* getSlabNames(size_t block_size) const {
+        auto it = slab_names_.find(block_size);
+        return it != slab_names_.end() ? &it->second : nullptr;
+    }
+
    private:
+    void removeSlabName(size_t block_size, const std::string& name) {
+        auto it = slab_names_.find(block_size);
+        if (it == slab_names_.end()) {
+            return;
+        }
+        auto name_it = std::find(it->second.begin(), it->second.end(), name);
+        if (name_it != it->second.end()) {
+            std::swap(*name_it, it->second.back());
+            it->second.pop_back();
+        }
+        if (it->second.empty()) {
+            slab_names_.erase(it);
+        }
+    }
+
     // Name array for randomly picking allocators.
     std::vector<std::string> names_;
     // Segment name to allocators mapping.
     std::unordered_map<std::string,
                        std::vector<std::shared_ptr<BufferAllocatorBase>>>
         allocators_;
+    // Segment name to locality label, only for labeled segments.
+    std::unordered_map<std::string, std::string> localities_;
+    // Slab block size to the names of the segments with such blocks.
+    std::unordered_map<size_t, std::vector<std::string>> slab_names_;
 };
 
+/**
+ * @brief Number of leading failure domains two locality labels share, e.g.
+ *        2 for "zone-a/rack-3/host-7" and "zone-a/rack-3/host-9". Returns 0
+ *        if either label is empty.
+ */
+inline size_t SharedLocalityDepth(const std::string& a, const std::string& b) {
+    if (a.empty() || b.empty()) {
+        return 0;
+    }
+    size_t depth = 0;
+    size_t i = 0;
+    while (true) {
+        const size_t a_end = std::min(a.find('/', i), a.size());
+        const size_t b_end = std::min(b.find('/', i), b.size());
+        if (a_end != b_end || a.compare(i, a_end - i, b, i, b_end - i) != 0) {
+            return depth;
+        }
+        depth++;
+        if (a_end == a.size() || b_end == b.size()) {
+            return depth;
+        }
+        i = a_end + 1;
+    }
+}
+
 /**
  * @brief Abstract interface for allocation strategy, responsible for
  *        allocating a slice (with one or more replicas) using available
@@ -148,6 +242,9 @@ class AllocationStrategy {
      * @param preferred_segments Preferred segments to allocate buffers from
      * @param excluded_segments Excluded segments that should not allocate
      * buffers from
+     * @param reader_locality Locality of the expected reader. When segments
+     * carry locality labels, one replica is placed as close to the reader
+     * as possible and the others in failure domains apart from it.
      * @return tl::expected<std::vector<Replica>, ErrorCode> containing
      *         allocated replicas.
      *         - On success: vector of allocated replicas (may be fewer than
@@ -162,7 +259,8 @@ class AllocationStrategy {
         const std::vector<std::string>& preferred_segments =
             std::vector<std::string>(),
         const std::set<std::string>& excluded_segments =
-            std::set<std::string>()) = 0;
+            std::set<std::string>(),
+        const std::string& reader_locality = std::string()) = 0;
 
     /**
      * @brief Allocate one replica from the specified segment.
@@ -181,6 +279,19 @@ class AllocationStrategy {
     virtual tl::expected<Replica, ErrorCode> AllocateFrom(
         const AllocatorManager& allocator_manager, const size_t slice_length,
         const std::string& segment_name) = 0;
+
+    /**
+     * @brief Report the recent transfer load of the host of a segment, in
+     * bytes per second. Ignored by strategies that do not balance load.
+     */
+    virtual void UpdateSegmentLoad(const std::string& segment_name,
+                                   uint64_t transfer_bytes_per_sec) {}
+
+    /**
+     * @brief Forget the load of an unmounted segment. Other segments of the
+     * same host report it again with their next ping.
+     */
+    virtual void RemoveSegmentLoad(const std::string& segment_name) {}
 };
 
 /**
@@ -196,6 +307,8 @@ class AllocationStrategy {
  *   possible (limited by the number of available segments)
  * - Only fails if no replicas can be allocated at all
  * - Preferred segment allocation is attempted first if specified
+ * - When segments carry locality labels, the remaining replicas are spread
+ *   across failure domains, see allocateByLocality()
  */
 class RandomAllocationStrategy : public AllocationStrategy {
    public:
@@ -207,7 +320,8 @@ class RandomAllocationStrategy : public AllocationStrategy {
         const std::vector<std::string>& preferred_segments =
             std::vector<std::string>(),
         const std::set<std::string>& excluded_segments =
-            std::set<std::string>()) {
+            std::set<std::string>(),
+        const std::string& reader_locality = std::string()) {
         // Validate input parameters
         if (slice_length == 0 || replica_num == 0) {
             return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
@@ -242,6 +356,7 @@ class RandomAllocationStrategy : public AllocationStrategy {
         }
 
         std::set<std::string> used_segments;
+        std::vector<std::string> placed_localities;
 
         // Try preferred segments first if specified
         for (auto& preferred_segment : preferred_segments) {
@@ -262,9 +377,26 @@ class RandomAllocationStrategy : public AllocationStrategy {
 
                 // Add preferred segment to used_segments on allocation success
                 used_segments.insert(preferred_segment);
+                placed_localities.push_back(
+                    allocator_manager.getLocality(preferred_segment));
+            }
+        }
+
+        if (allocator_manager.hasLocalities()) {
+            allocateByLocality(allocator_manager, slice_length, replica_num,
+                               excluded_segments, reader_locality,
+                               used_segments, placed_localities, replicas,
+                               generator);
+            if (replicas.empty()) {
+                return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
             }
+            return replicas;
         }
 
+        allocateFromSlabs(allocator_manager, slice_length, replica_num,
+                          excluded_segments, used_segments, placed_localities,
+                          replicas, generator);
+
         // If replica_num is not satisfied, allocate the remaining replicas
         // randomly.
         std::uniform_int_distribution<size_t> distribution(0, names.size() - 1);
@@ -342,80 +474,493 @@ class RandomAllocationStrategy : public AllocationStrategy {
         }
 
         // Randomly select a start point to distribute
-        // allocations across all segments
+        // allocations across all segments. Slab blocks of exactly the slice
+        // length are used first, slabs of other block sizes not at all.
         std::uniform_int_distribution<size_t> dist(0, num_segs - 1);
         size_t seg_offset = dist(generator);
-        for (size_t i = 0; i < num_segs; i++) {
-            auto& allocator = (*allocators)[(i + seg_offset) % num_segs];
-            if (auto buffer = allocator->allocate(slice_length)) {
-                return buffer;
+        for (const bool slab : {true, false}) {
+            for (size_t i = 0; i < num_segs; i++) {
+                auto& allocator = (*allocators)[(i + seg_offset) % num_segs];
+                const size_t block_size = allocator->getBlockSize();
+                if (block_size != (slab ? slice_length : 0)) {
+                    continue;
+                }
+                if (auto buffer = allocator->allocate(slice_length)) {
+                    return buffer;
+                }
             }
         }
 
         return nullptr;
     }
 
+    /**
+     * @brief Allocate the remaining replicas on the segments with slab
+     *        blocks of exactly the slice length, which hold the slice
+     *        without fragmenting. Tried segments are added to
+     *        used_segments.
+     */
+    void allocateFromSlabs(const AllocatorManager& allocator_manager,
+                           const size_t slice_length, const size_t replica_num,
+                           const std::set<std::string>& excluded_segments,
+                           std::set<std::string>& used_segments,
+                           std::vector<std::string>& placed_localities,
+                           std::vector<Replica>& replicas,
+                           std::mt19937& generator) {
+        const auto* names = allocator_manager.getSlabNames(slice_length);
+        if (names == nullptr) {
+            return;
+        }
+        std::uniform_int_distribution<size_t> dist(0, names->size() - 1);
+        const size_t start_idx = dist(generator);
+        for (size_t i = 0; i < names->size() && replicas.size() < replica_num;
+             i++) {
+            const auto& name = (*names)[(start_idx + i) % names->size()];
+            if (excluded_segments.contains(name) ||
+                used_segments.contains(name)) {
+                continue;
+            }
+            used_segments.insert(name);
+            auto buffer = allocateSingle(allocator_manager, name, slice_length,
+                                         generator);
+            if (buffer) {
+                replicas.emplace_back(std::move(buffer),
+                                      ReplicaStatus::PROCESSING);
+                placed_localities.push_back(
+                    allocator_manager.getLocality(name));
+            }
+        }
+    }
+
+    /**
+     * @brief Allocate the remaining replicas by segment locality labels.
+     *
+     * Without replicas placed yet, the segments sharing the most failure
+     * domains with the reader are tried first. Afterwards, the segments
+     * sharing the fewest failure domains with any placed replica are tried
+     * first, so that replicas land on other zones, then other racks and so
+     * on. Segments without a label share no domain with anything. Ties are
+     * broken randomly.
+     *
+     * @param used_segments segments to skip, tried ones are added
+     * @param placed_localities labels of the placed replicas, extended with
+     *        the new ones
+     */
+    void allocateByLocality(const AllocatorManager& allocator_manager,
+                            const size_t slice_length,
+                            const size_t replica_num,
+                            const std::set<std::string>& excluded_segments,
+                            const std::string& reader_locality,
+                            std::set<std::string>& used_segments,
+                            std::vector<std::string>& placed_localities,
+                            std::vector<Replica>& replicas,
+                            std::mt19937& generator) {
+        std::vector<std::pair<size_t, const std::string*>> candidates;
+        size_t try_count = 0;
+        while (replicas.size() < replica_num && try_count < kMaxRetryLimit) {
+            candidates.clear();
+            for (const auto& name : allocator_manager.getNames()) {
+                if (excluded_segments.contains(name) ||
+                    used_segments.contains(name)) {
+                    continue;
+                }
+                const auto& locality = allocator_manager.getLocality(name);
+                size_t rank = 0;
+                if (placed_localities.empty()) {
+                    // Smaller is closer to the reader
+                    rank = std::numeric_limits<size_t>::max() -
+                           SharedLocalityDepth(locality, reader_locality);
+                } else {
+                    for (const auto& placed : placed_localities) {
+                        rank = std::max(rank,
+                                        SharedLocalityDepth(locality, placed));
+                    }
+                }
+                candidates.emplace_back(rank, &name);
+            }
+            if (candidates.empty()) {
+                return;
+            }
+            std::shuffle(candidates.begin(), candidates.end(), generator);
+            std::stable_sort(
+                candidates.begin(), candidates.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            // Walk the best candidates until one has room
+            bool allocated = false;
+            for (const auto& [rank, name] : candidates) {
+                if (try_count++ >= kMaxRetryLimit) {
+                    break;
+                }
+                used_segments.insert(*name);
+                auto buffer = allocateSingle(allocator_manager, *name,
+                                             slice_length, generator);
+                if (buffer) {
+                    replicas.emplace_back(std::move(buffer),
+                                          ReplicaStatus::PROCESSING);
+                    placed_localities.push_back(
+                        allocator_manager.getLocality(*name));
+                    allocated = true;
+                    break;
+                }
+            }
+            if (!allocated) {
+                return;
+            }
+        }
+    }
+
    private:
     static constexpr size_t kMaxRetryLimit = 100;
 };
 
-class CxlAllocationStrategy : public AllocationStrategy {
+/**
+ * @brief Allocation strategy balancing free space and transfer load across
+ *        segments, with the same best-effort semantics and preferred
+ *        segment handling as RandomAllocationStrategy.
+ *
+ * Each replica goes to the better of two randomly sampled segments (power
+ * of two choices), which keeps the segments evenly used without looking at
+ * all of them. A segment scores
+ *
+ *     free_ratio / (1 + load / mean_load)
+ *
+ * where free_ratio is the unused fraction of its capacity and load is the
+ * transfer load reported for its host. Segments whose largest free region
+ * cannot hold the slice are skipped, which steers allocations away from
+ * fragmented segments.
+ *
+ * When segments carry locality labels, replicas are placed by failure
+ * domain like in RandomAllocationStrategy and the load is not considered.
+ */
+class LoadAwareAllocationStrategy : public AllocationStrategy {
    public:
-    CxlAllocationStrategy() = default;
+    LoadAwareAllocationStrategy() = default;
+
     tl::expected<std::vector<Replica>, ErrorCode> Allocate(
         const AllocatorManager& allocator_manager, const size_t slice_length,
         const size_t replica_num = 1,
         const std::vector<std::string>& preferred_segments =
             std::vector<std::string>(),
         const std::set<std::string>& excluded_segments =
-            std::set<std::string>()) {
+            std::set<std::string>(),
+        const std::string& reader_locality = std::string()) {
         if (slice_length == 0 || replica_num == 0) {
             return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
         }
 
-        if (preferred_segments.empty()) {
-            LOG(ERROR) << "Preferred_segments is empty.";
-            return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+        const auto& names = allocator_manager.getNames();
+        if (names.empty()) {
+            return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
         }
 
-        const std::string& cxl_segment_name = preferred_segments[0];
+        static thread_local std::mt19937 generator(std::random_device{}());
 
-        VLOG(1) << "Do cxl allocate, overwritten segment=" << cxl_segment_name;
+        std::vector<Replica> replicas;
+        replicas.reserve(replica_num);
+        // Segments holding a replica or that failed to allocate
+        std::set<std::string> used_segments;
+        std::vector<std::string> placed_localities;
+        auto try_allocate = [&](const std::string& name) {
+            used_segments.insert(name);
+            auto buffer = random_strategy_.allocateSingle(
+                allocator_manager, name, slice_length, generator);
+            if (buffer) {
+                replicas.emplace_back(std::move(buffer),
+                                      ReplicaStatus::PROCESSING);
+                placed_localities.push_back(
+                    allocator_manager.getLocality(name));
+            }
+        };
 
-        const auto cxl_allocators =
-            allocator_manager.getAllocators(cxl_segment_name);
+        for (auto& preferred_segment : preferred_segments) {
+            if (replicas.size() == replica_num) {
+                return replicas;
+            }
+            if (!excluded_segments.contains(preferred_segment) &&
+                !used_segments.contains(preferred_segment)) {
+                try_allocate(preferred_segment);
+            }
+        }
 
-        if (cxl_allocators == nullptr || cxl_allocators->size() == 0) {
-            return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
+        // Failure domains take precedence over load
+        if (allocator_manager.hasLocalities()) {
+            random_strategy_.allocateByLocality(
+                allocator_manager, slice_length, replica_num,
+                excluded_segments, reader_locality, used_segments,
+                placed_localities, replicas, generator);
+            if (replicas.empty()) {
+                return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
+            }
+            return replicas;
         }
-        std::shared_ptr<BufferAllocatorBase> cxl_allocator =
-            (*cxl_allocators)[0];
-        if (!cxl_allocator) {
-            LOG(ERROR) << "No CXL allocator in preferred_segment";
-            return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
+
+        random_strategy_.allocateFromSlabs(
+            allocator_manager, slice_length, replica_num, excluded_segments,
+            used_segments, placed_localities, replicas, generator);
+        if (replicas.size() == replica_num) {
+            return replicas;
         }
 
-        std::vector<Replica> replicas;
-        replicas.reserve(replica_num);
+        std::shared_lock lock(load_mutex_);
+        const double mean_load = MeanLoadLocked();
+        auto score = [&](const std::string& name) {
+            return Score(allocator_manager, name, slice_length, mean_load);
+        };
 
-        auto buffer = cxl_allocator->allocate(slice_length);
-        if (!buffer) {
+        std::uniform_int_distribution<size_t> distribution(0, names.size() - 1);
+        const size_t max_retry = std::min(kMaxRetryLimit, names.size());
+        for (size_t try_count = 0;
+             replicas.size() < replica_num && try_count < max_retry;
+             try_count++) {
+            const std::string* best = nullptr;
+            double best_score = 0.0;
+            for (size_t choice = 0; choice < kNumChoices; choice++) {
+                const std::string& name = names[distribution(generator)];
+                if (excluded_segments.contains(name) ||
+                    used_segments.contains(name)) {
+                    continue;
+                }
+                const double name_score = score(name);
+                if (name_score < 0.0) {
+                    used_segments.insert(name);  // the slice does not fit
+                } else if (!best || name_score > best_score) {
+                    best = &name;
+                    best_score = name_score;
+                }
+            }
+            if (best) {
+                try_allocate(*best);
+            }
+        }
+
+        // Sampling may miss the few segments left, scan the others in turn
+        size_t start_idx = distribution(generator);
+        for (size_t i = 0; i < names.size() && replicas.size() < replica_num;
+             i++) {
+            const auto& name = names[(start_idx + i) % names.size()];
+            if (!excluded_segments.contains(name) &&
+                !used_segments.contains(name)) {
+                try_allocate(name);
+            }
+        }
+
+        if (replicas.empty()) {
             return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
         }
+        return replicas;
+    }
+
+    tl::expected<Replica, ErrorCode> AllocateFrom(
+        const AllocatorManager& allocator_manager, const size_t slice_length,
+        const std::string& segment_name) {
+        return random_strategy_.AllocateFrom(allocator_manager, slice_length,
+                                             segment_name);
+    }
+
+    void UpdateSegmentLoad(const std::string& segment_name,
+                           uint64_t transfer_bytes_per_sec) {
+        std::unique_lock lock(load_mutex_);
+        auto& load = segment_loads_[segment_name];
+        total_load_ = total_load_ - load + transfer_bytes_per_sec;
+        load = transfer_bytes_per_sec;
+    }
+
+    void RemoveSegmentLoad(const std::string& segment_name) {
+        std::unique_lock lock(load_mutex_);
+        auto it = segment_loads_.find(segment_name);
+        if (it != segment_loads_.end()) {
+            total_load_ -= it->second;
+            segment_loads_.erase(it);
+        }
+    }
+
+    // Mean load of the segments that reported one, 0 if none did
+    double MeanLoad() const {
+        std::shared_lock lock(load_mutex_);
+        return MeanLoadLocked();
+    }
+
+   private:
+    double MeanLoadLocked() const {
+        return segment_loads_.empty()
+                   ? 0.0
+                   : static_cast<double>(total_load_) / segment_loads_.size();
+    }
+
+    // Negative if the slice does not fit in the segment
+    double Score(const AllocatorManager& allocator_manager,
+                 const std::string& name, size_t slice_length,
+                 double mean_load) const {
+        const auto allocators = allocator_manager.getAllocators(name);
+        if (allocators == nullptr) {
+            return -1.0;
+        }
+        size_t capacity = 0;
+        size_t used = 0;
+        size_t largest_free_region = 0;
+        for (const auto& allocator : *allocators) {
+            const size_t block_size = allocator->getBlockSize();
+            if (block_size != 0 && block_size != slice_length) {
+                continue;  // only holds blocks of another size
+            }
+            capacity += allocator->capacity();
+            used += allocator->size();
+            largest_free_region = std::max(largest_free_region,
+                                           allocator->getLargestFreeRegion());
+        }
+        if (capacity == 0 || largest_free_region < slice_length) {
+            return -1.0;
+        }
+        const double free_ratio =
+            static_cast<double>(capacity - std::min(used, capacity)) /
+            capacity;
+        auto it = segment_loads_.find(name);
+        if (it == segment_loads_.end() || mean_load <= 0.0) {
+            return free_ratio;
+        }
+        return free_ratio / (1.0 + it->second / mean_load);
+    }
+
+    static constexpr size_t kMaxRetryLimit = 100;
+    static constexpr size_t kNumChoices = 2;
+
+    RandomAllocationStrategy random_strategy_;
+
+    mutable std::shared_mutex load_mutex_;
+    // Segment name -> transfer load of its host, in bytes per second
+    std::unordered_map<std::string, uint64_t> segment_loads_;
+    uint64_t total_load_{0};
+};
+
+/**
+ * @brief Allocation over DRAM segments and a CXL memory tier.
+ *
+ * CXL segments of all clients are windows onto one shared device and share
+ * its global allocator. The device is larger but slower than DRAM, so it
+ * holds the objects of at least min_object_size, while smaller objects are
+ * placed on DRAM segments by the wrapped strategy. Either tier is used as a
+ * fallback when the other one is full. The CXL replica is taken from the
+ * preferred segment if that is a CXL segment, so that a client writing
+ * through its own mapping reads back with loads and stores.
+ */
+class CxlAllocationStrategy : public AllocationStrategy {
+   public:
+    CxlAllocationStrategy(std::shared_ptr<AllocationStrategy> dram_strategy,
+                          std::string cxl_pool_name, size_t min_object_size)
+        : dram_strategy_(std::move(dram_strategy)),
+          cxl_pool_name_(std::move(cxl_pool_name)),
+          min_object_size_(min_object_size) {}
+
+    tl::expected<std::vector<Replica>, ErrorCode> Allocate(
+        const AllocatorManager& allocator_manager, const size_t slice_length,
+        const size_t replica_num = 1,
+        const std::vector<std::string>& preferred_segments =
+            std::vector<std::string>(),
+        const std::set<std::string>& excluded_segments =
+            std::set<std::string>(),
+        const std::string& reader_locality = std::string()) {
+        if (slice_length == 0 || replica_num == 0) {
+            return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+        }
+
+        std::set<std::string> dram_excluded = excluded_segments;
+        std::string cxl_segment;
+        for (const auto& name : allocator_manager.getNames()) {
+            if (isCxlSegment(allocator_manager, name)) {
+                dram_excluded.insert(name);
+                if (cxl_segment.empty() && !excluded_segments.contains(name)) {
+                    cxl_segment = name;
+                }
+            }
+        }
+        for (const auto& name : preferred_segments) {
+            if (isCxlSegment(allocator_manager, name) &&
+                !excluded_segments.contains(name)) {
+                cxl_segment = name;
+                break;
+            }
+        }
 
-        buffer->change_to_cxl(cxl_segment_name);
-        replicas.emplace_back(std::move(buffer), ReplicaStatus::PROCESSING);
+        const bool prefer_cxl = slice_length >= min_object_size_;
+        if (!prefer_cxl) {
+            auto replicas = dram_strategy_->Allocate(
+                allocator_manager, slice_length, replica_num,
+                preferred_segments, dram_excluded, reader_locality);
+            if (replicas.has_value() || cxl_segment.empty()) {
+                return replicas;
+            }
+        }
 
-        VLOG(1) << "Successfully allocated " << replicas.size()
-                << " CXL replica.";
+        std::vector<Replica> replicas;
+        replicas.reserve(replica_num);
+        if (!cxl_segment.empty()) {
+            auto replica =
+                AllocateFrom(allocator_manager, slice_length, cxl_segment);
+            if (replica.has_value()) {
+                replicas.push_back(std::move(replica.value()));
+            }
+        }
+        // The device is a single failure domain, further replicas and the
+        // objects that do not fit on it go to DRAM
+        if (prefer_cxl && replicas.size() < replica_num) {
+            auto dram_replicas = dram_strategy_->Allocate(
+                allocator_manager, slice_length,
+                replica_num - replicas.size(), preferred_segments,
+                dram_excluded, reader_locality);
+            if (dram_replicas.has_value()) {
+                for (auto& replica : dram_replicas.value()) {
+                    replicas.push_back(std::move(replica));
+                }
+            }
+        }
+        if (replicas.empty()) {
+            return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
+        }
+        VLOG(1) << "Allocated " << replicas.size()
+                << " replicas, cxl_segment=" << cxl_segment;
         return replicas;
     }
 
     tl::expected<Replica, ErrorCode> AllocateFrom(
         const AllocatorManager& allocator_manager, const size_t slice_length,
         const std::string& segment_name) {
-        return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
+        if (!isCxlSegment(allocator_manager, segment_name)) {
+            return dram_strategy_->AllocateFrom(allocator_manager,
+                                                slice_length, segment_name);
+        }
+        auto buffer =
+            (*allocator_manager.getAllocators(segment_name))[0]->allocate(
+                slice_length);
+        if (!buffer) {
+            return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
+        }
+        buffer->change_to_cxl(segment_name);
+        return Replica(std::move(buffer), ReplicaStatus::PROCESSING);
+    }
+
+    void UpdateSegmentLoad(const std::string& segment_name,
+                           uint64_t transfer_bytes_per_sec) {
+        dram_strategy_->UpdateSegmentLoad(segment_name,
+                                          transfer_bytes_per_sec);
     }
+
+    void RemoveSegmentLoad(const std::string& segment_name) {
+        dram_strategy_->RemoveSegmentLoad(segment_name);
+    }
+
+   private:
+    bool isCxlSegment(const AllocatorManager& allocator_manager,
+                      const std::string& name) const {
+        const auto* allocators = allocator_manager.getAllocators(name);
+        return allocators != nullptr && !allocators->empty() &&
+               (*allocators)[0]->getSegmentName() == cxl_pool_name_;
+    }
+
+    std::shared_ptr<AllocationStrategy> dram_strategy_;
+    // Segment name of the global allocator of the CXL device
+    const std::string cxl_pool_name_;
+    const size_t min_object_size_;
 };
 
 }  // namespace mooncake
@@ -5,8 +5,10 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "cachelib_memory_allocator/MemoryAllocator.h"
+#include "mutex.h"
 #include "offset_allocator/offset_allocator.hpp"
 #include "types.h"
 
@@ -22,10 +24,26 @@ static constexpr size_t kAllocatorUnknownFreeSpace =
 // Forward declarations
 class BufferAllocatorBase;
 
+/**
+ * Free space of a buffer allocator, for telemetry and placement decisions.
+ */
+struct AllocatorStats {
+    uint64_t capacity{0};
+    uint64_t allocated{0};  // Bytes of the allocated buffers
+    uint64_t free{0};       // Bytes left for new buffers
+    // Largest buffer that can be allocated, at most free
+    uint64_t largest_free_region{0};
+    uint64_t free_regions{0};  // Number of free regions, 0 if unknown
+    // Share of the free bytes that cannot serve the largest allocations,
+    // from 0 to 1
+    double fragmentation{0.0};
+};
+
 class AllocatedBuffer {
    public:
     friend class CachelibBufferAllocator;
     friend class OffsetBufferAllocator;
+    friend class SlabBufferAllocator;
     // Forward declaration of the descriptor struct
     struct Descriptor;
 
@@ -58,6 +76,24 @@ class AllocatedBuffer {
 
     [[nodiscard]] std::string getSegmentName() const noexcept;
 
+    /**
+     * Free the buffers, grouped by allocator so that each allocator frees its
+     * group in one deallocateBatch call instead of one call per buffer.
+     * Buffers whose allocator is already gone are just destroyed.
+     */
+    static void DeallocateBatch(
+        std::vector<std::unique_ptr<AllocatedBuffer>>&& buffers);
+
+    /**
+     * Split the buffer into consecutive buffers of the given sizes, e.g. to
+     * place several objects in one contiguous extent. On success the buffer
+     * is consumed; if its allocator cannot split it, or the sizes do not fit,
+     * returns no buffers and leaves the buffer as is.
+     */
+    static std::vector<std::unique_ptr<AllocatedBuffer>> Split(
+        std::unique_ptr<AllocatedBuffer>& buffer,
+        const std::vector<size_t>& sizes);
+
     // Friend declaration for operator<<
     friend std::ostream& operator<<(std::ostream& os,
                                     const AllocatedBuffer& buffer);
@@ -96,6 +132,27 @@ class BufferAllocatorBase {
 
     virtual std::unique_ptr<AllocatedBuffer> allocate(size_t size) = 0;
     virtual void deallocate(AllocatedBuffer* handle) = 0;
+
+    /**
+     * Free buffers allocated by this allocator and clear the vector.
+     * Allocators that can amortize their locking over several frees override
+     * this; the default frees the buffers one by one.
+     */
+    virtual void deallocateBatch(
+        std::vector<std::unique_ptr<AllocatedBuffer>>& buffers) {
+        buffers.clear();
+    }
+
+    /**
+     * Split a buffer allocated by this allocator, see AllocatedBuffer::Split.
+     * Allocators that cannot split buffers return no buffers.
+     */
+    virtual std::vector<std::unique_ptr<AllocatedBuffer>> split(
+        std::unique_ptr<AllocatedBuffer>& buffer,
+        const std::vector<size_t>& sizes) {
+        return {};
+    }
+
     virtual size_t capacity() const = 0;
     virtual size_t size() const = 0;
     virtual std::string getSegmentName() const = 0;
@@ -111,6 +168,28 @@ class BufferAllocatorBase {
      * allocation may still fail due to race conditions or fragmentation.
      */
     virtual size_t getLargestFreeRegion() const = 0;
+
+    /**
+     * Returns the free space of the allocator. Unlike getLargestFreeRegion,
+     * this may walk internal structures and is meant for periodic reports.
+     */
+    virtual AllocatorStats getStats() const = 0;
+
+    /**
+     * Re-claims a buffer at a fixed address, e.g. when the master restores
+     * previously persisted replicas onto a re-mounted segment. Allocators
+     * that cannot place a buffer at an arbitrary address return nullptr.
+     */
+    virtual std::unique_ptr<AllocatedBuffer> reserve(uintptr_t address,
+                                                     size_t size) {
+        return nullptr;
+    }
+
+    /**
+     * Size of the blocks of allocators that only hand out buffers of one
+     * size, or 0 for allocators of any size.
+     */
+    virtual size_t getBlockSize() const { return 0; }
 };
 
 /**
@@ -164,6 +243,13 @@ class CachelibBufferAllocator
         return kAllocatorUnknownFreeSpace;
     }
 
+    /**
+     * Free bytes kept by allocation classes only serve allocations of their
+     * class, they count as fragmentation. The largest free region is a
+     * whole unassigned slab.
+     */
+    AllocatorStats getStats() const override;
+
    private:
     // metadata
     const std::string segment_name_;
@@ -197,8 +283,21 @@ class OffsetBufferAllocator
 
     std::unique_ptr<AllocatedBuffer> allocate(size_t size) override;
 
+    std::unique_ptr<AllocatedBuffer> reserve(uintptr_t address,
+                                             size_t size) override;
+
     void deallocate(AllocatedBuffer* handle) override;
 
+    /**
+     * Frees all the buffers under one lock of the offset allocator.
+     */
+    void deallocateBatch(
+        std::vector<std::unique_ptr<AllocatedBuffer>>& buffers) override;
+
+    std::vector<std::unique_ptr<AllocatedBuffer>> split(
+        std::unique_ptr<AllocatedBuffer>& buffer,
+        const std::vector<size_t>& sizes) override;
+
     size_t capacity() const override { return total_size_; }
     size_t size() const override { return cur_size_.load(); }
     std::string getSegmentName() const override { return segment_name_; }
@@ -211,6 +310,8 @@ class OffsetBufferAllocator
      */
     size_t getLargestFreeRegion() const override;
 
+    AllocatorStats getStats() const override;
+
    private:
     // metadata
     const std::string segment_name_;
@@ -223,6 +324,81 @@ class OffsetBufferAllocator
     std::shared_ptr<offset_allocator::OffsetAllocator> offset_allocator_;
 };
 
+/**
+ * SlabBufferAllocator cuts a segment into equal blocks and only allocates
+ * buffers of exactly the block size, e.g. the KV cache blocks of one model.
+ * Free blocks are kept on a stack, so that allocation and deallocation are
+ * O(1) and the segment never fragments. The most recently freed block is
+ * reused first.
+ */
+class SlabBufferAllocator
+    : public BufferAllocatorBase,
+      public std::enable_shared_from_this<SlabBufferAllocator> {
+   public:
+    /**
+     * @throws std::invalid_argument if block_size is 0 or larger than size
+     */
+    SlabBufferAllocator(std::string segment_name, size_t base, size_t size,
+                        size_t block_size, std::string transport_endpoint);
+
+    ~SlabBufferAllocator() override;
+
+    std::unique_ptr<AllocatedBuffer> allocate(size_t size) override;
+
+    /**
+     * Re-claims the block starting at address; the buffer must cover the
+     * whole block.
+     */
+    std::unique_ptr<AllocatedBuffer> reserve(uintptr_t address,
+                                             size_t size) override;
+
+    void deallocate(AllocatedBuffer* handle) override;
+
+    /**
+     * Frees all the blocks under one lock.
+     */
+    void deallocateBatch(
+        std::vector<std::unique_ptr<AllocatedBuffer>>& buffers) override;
+
+    size_t capacity() const override { return num_blocks_ * block_size_; }
+    size_t size() const override { return cur_size_.load(); }
+    std::string getSegmentName() const override { return segment_name_; }
+    std::string getTransportEndpoint() const override {
+        return transport_endpoint_;
+    }
+
+    /**
+     * The block size if a block is free, 0 otherwise.
+     */
+    size_t getLargestFreeRegion() const override;
+
+    AllocatorStats getStats() const override;
+
+    size_t getBlockSize() const override { return block_size_; }
+
+   private:
+    static constexpr uint32_t kUsed = std::numeric_limits<uint32_t>::max();
+
+    // Moves a free block out of free_blocks_, or back into it
+    void takeBlockLocked(uint32_t block) REQUIRES(mutex_);
+    void freeBlockLocked(uint32_t block) REQUIRES(mutex_);
+    std::unique_ptr<AllocatedBuffer> makeBuffer(uint32_t block);
+
+    // metadata
+    const std::string segment_name_;
+    const size_t base_;
+    const size_t block_size_;
+    const size_t num_blocks_;
+    std::atomic_size_t cur_size_;
+    const std::string transport_endpoint_;
+
+    mutable Mutex mutex_;
+    // Indices of the free blocks, the next one to allocate at the back
+    std::vector<uint32_t> free_blocks_ GUARDED_BY(mutex_);
+    // Block index -> its position in free_blocks_, or kUsed
+    std::vector<uint32_t> free_positions_ GUARDED_BY(mutex_);
+};
+
 // The main difference is that it allocates real memory and returns it, while
 // BufferAllocator allocates an address
 class SimpleAllocator {
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Keys of the master stored as ranges of a bundle object.
+ *
+ * Clients with many small values, e.g. the pages of a paged KV cache, put
+ * them as one bundle object, with one allocation, lease and replica list,
+ * and link the keys to their ranges of it. A linked key only takes an
+ * entry here instead of the metadata of an object, and is read as a range
+ * of its bundle. The bundle object is removed with its last key.
+ *
+ * Thread-safe. Links are sharded by key and bundles by bundle key, like the
+ * metadata of the master, so that operations on different keys do not
+ * contend. Link shards are locked in ascending order and may be locked
+ * before a bundle shard, never the other way round. empty() is lock-free,
+ * so that masters without bundles pay nothing on reads.
+ */
+class BundleIndex {
+   public:
+    static constexpr const char* kBundleKeyPrefix = "__mooncake_bundle__/";
+
+    struct Member {
+        std::string bundle_key;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    struct Stats {
+        uint64_t member_keys = 0;
+        uint64_t bundles = 0;
+    };
+
+    static bool IsBundleKey(const std::string& key);
+
+    bool empty() const {
+        return num_member_keys_.load(std::memory_order_relaxed) == 0;
+    }
+
+    /**
+     * @brief Links the keys to consecutive ranges of the bundle object, of
+     * the given sizes from offset 0. Either all keys are linked or none.
+     * Linking a bundle again with the same keys and sizes does nothing.
+     * @param inserted Set to whether this call linked the keys.
+     * @return OBJECT_ALREADY_EXISTS if a key is linked to another range.
+     */
+    ErrorCode Link(const std::string& bundle_key,
+                   const std::vector<std::string>& keys,
+                   const std::vector<uint64_t>& sizes, bool& inserted);
+
+    std::optional<Member> Resolve(const std::string& key) const;
+
+    /**
+     * @brief Unlinks the key.
+     * @param orphaned Set to the bundle key if it has no keys left.
+     * @return false if the key is not linked.
+     */
+    bool Unlink(const std::string& key, std::optional<std::string>& orphaned);
+
+    /**
+     * @brief Unlinks those of the keys that are linked to the bundle, e.g.
+     * to undo a Link.
+     * @param orphaned Set to the bundle key if it has no keys left.
+     * @return Number of unlinked keys.
+     */
+    size_t UnlinkFrom(const std::string& bundle_key,
+                      const std::vector<std::string>& keys,
+                      std::optional<std::string>& orphaned);
+
+    /**
+     * @brief Unlinks the keys matching the predicate.
+     * @param orphaned Receives the bundle keys left without keys.
+     * @return Number of unlinked keys.
+     */
+    size_t UnlinkIf(const std::function<bool(const std::string&)>& pred,
+                    std::vector<std::string>& orphaned);
+
+    /**
+     * @brief Unlinks all keys of a bundle, e.g. once its object is gone.
+     * @return Number of unlinked keys.
+     */
+    size_t Drop(const std::string& bundle_key);
+
+    Stats GetStats() const;
+
+   private:
+    static constexpr size_t kNumShards = 1024;
+
+    struct Bundle {
+        // Shared by the links to the bundle, tells apart a bundle linked
+        // again under the same key
+        std::shared_ptr<const std::string> key;
+        // Keys linked to the bundle, some possibly unlinked since
+        std::vector<std::string> keys;
+        uint64_t refs = 0;
+    };
+
+    struct Range {
+        std::shared_ptr<const std::string> bundle_key;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct LinkShard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Range> links;  // key -> range
+    };
+
+    struct BundleShard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Bundle> bundles;
+    };
+
+    static size_t ShardIndex(const std::string& key) {
+        return std::hash<std::string>{}(key) % kNumShards;
+    }
+
+    LinkShard& GetLinkShard(const std::string& key) const {
+        return link_shards_[ShardIndex(key)];
+    }
+
+    BundleShard& GetBundleShard(const std::string& bundle_key) {
+        return bundle_shards_[ShardIndex(bundle_key)];
+    }
+
+    // Returns true if the bundle has no keys left, false if it has or was
+    // dropped
+    bool Release(const std::shared_ptr<const std::string>& bundle_key);
+
+    mutable std::array<LinkShard, kNumShards> link_shards_;
+    std::array<BundleShard, kNumShards> bundle_shards_;
+    std::atomic<uint64_t> num_member_keys_{0};
+    std::atomic<uint64_t> num_bundles_{0};
+};
+
+}  // namespace mooncake
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <optional>
 #include <vector>
 #include <string>
@@ -12,6 +15,25 @@ namespace mooncake {
 
 class BufferHandle;
 
+/**
+ * Caching and placement of a ClientBufferAllocator. The defaults keep the
+ * plain behaviour: one offset allocator over the whole buffer, no cache.
+ */
+struct ClientBufferArenaConfig {
+    // Bytes of freed small blocks each arena keeps for reuse, 0 disables
+    // the caches
+    size_t cache_bytes = 0;
+    // Arenas per NUMA node, threads are spread over them
+    size_t arenas = 8;
+    // Split an owned buffer into one region per NUMA node, bound to it, and
+    // allocate from the region of the calling CPU first
+    bool numa_local = false;
+
+    // MC_STORE_CLIENT_BUFFER_CACHE_BYTES, MC_STORE_CLIENT_BUFFER_ARENAS and
+    // MC_STORE_CLIENT_BUFFER_NUMA
+    static ClientBufferArenaConfig FromEnvironment();
+};
+
 /**
  * ClientBufferAllocator manages a contiguous memory buffer using an
  * offset-based allocation strategy. It provides thread-safe allocation and
@@ -22,6 +44,12 @@ class BufferHandle;
  * - Automatic memory cleanup via RAII
  * - Thread-safe allocation operations
  * - Support for shared memory allocation
+ *
+ * Blocks of up to kMaxCachedSize are rounded up to a size class and, once
+ * freed, kept in the arena of the freeing thread for the next allocation
+ * of the class, so small allocations mostly skip the shared offset
+ * allocator and its lock. Cached blocks are given back to it when an
+ * allocation would otherwise fail.
  */
 class ClientBufferAllocator
     : public std::enable_shared_from_this<ClientBufferAllocator> {
@@ -29,11 +57,27 @@ class ClientBufferAllocator
     // Create for heap-allocated memory
     static std::shared_ptr<ClientBufferAllocator> create(
         size_t size, const std::string& protocol = "",
-        bool use_hugepage = false);
+        bool use_hugepage = false,
+        const ClientBufferArenaConfig& arena_config = {});
 
     // Create for shared memory
     static std::shared_ptr<ClientBufferAllocator> create(
-        void* addr, size_t size, const std::string& protocol = "");
+        void* addr, size_t size, const std::string& protocol = "",
+        const ClientBufferArenaConfig& arena_config = {});
+
+    static constexpr size_t kMaxCachedSize = 1024 * 1024;
+
+    struct Stats {
+        uint64_t cache_hits = 0;
+        uint64_t cache_misses = 0;
+        uint64_t cached_bytes = 0;
+        // Arena locks found held by another thread
+        uint64_t arena_lock_waits = 0;
+        // Allocations that went to the shared offset allocators
+        uint64_t central_allocations = 0;
+        // Allocations served by the region of another NUMA node
+        uint64_t remote_node_allocations = 0;
+    };
 
     ~ClientBufferAllocator();
 
@@ -51,13 +95,69 @@ class ClientBufferAllocator
 
     [[nodiscard]] std::optional<BufferHandle> allocate(size_t size);
 
+    [[nodiscard]] Stats GetStats() const;
+
+    // Gives all cached blocks back to the offset allocators
+    void FlushCaches();
+
    private:
+    friend class BufferHandle;
+
+    // 4 classes per power of two from 4 KB up to kMaxCachedSize
+    static constexpr size_t kNumSizeClasses = 33;
+
+    // Part of the buffer on one NUMA node, or the whole buffer
+    struct Region {
+        std::shared_ptr<offset_allocator::OffsetAllocator> allocator;
+        uint64_t begin = 0;
+        uint64_t end = 0;
+    };
+
+    struct Arena {
+        std::mutex mutex;
+        std::array<std::vector<offset_allocator::OffsetAllocationHandle>,
+                   kNumSizeClasses>
+            free_lists;
+        size_t cached_bytes = 0;
+    };
+
     // Private constructors for different memory types
     ClientBufferAllocator(size_t size, const std::string& protocol,
-                          bool use_hugepage);
-    ClientBufferAllocator(void* addr, size_t size, const std::string& protocol);
-
-    std::shared_ptr<offset_allocator::OffsetAllocator> allocator_;
+                          bool use_hugepage,
+                          const ClientBufferArenaConfig& arena_config);
+    ClientBufferAllocator(void* addr, size_t size, const std::string& protocol,
+                          const ClientBufferArenaConfig& arena_config);
+
+    static int SizeClass(size_t size);
+    static size_t ClassSize(int size_class);
+
+    void InitRegions(bool numa_local);
+    void InitArenas(const ClientBufferArenaConfig& arena_config);
+    // Region index of the calling CPU
+    size_t CurrentNode() const;
+    Arena& CurrentArena(size_t node);
+    std::unique_lock<std::mutex> LockArena(Arena& arena);
+    std::optional<offset_allocator::OffsetAllocationHandle> AllocateCentral(
+        size_t size, size_t node);
+    // Caches a freed block of size_class in the arena of the calling
+    // thread; handle is left alone, to be freed, if the arena is full
+    void Recycle(offset_allocator::OffsetAllocationHandle&& handle,
+                 int size_class);
+
+    // One region per NUMA node, or a single one without NUMA placement
+    std::vector<Region> regions_;
+    // Region index of each CPU, empty with a single region
+    std::vector<size_t> cpu_nodes_;
+    std::vector<std::unique_ptr<Arena>> arenas_;
+    size_t arenas_per_node_ = 1;
+    size_t cache_bytes_ = 0;
+
+    std::atomic<uint64_t> cache_hits_{0};
+    std::atomic<uint64_t> cache_misses_{0};
+    std::atomic<uint64_t> cached_bytes_{0};
+    std::atomic<uint64_t> arena_lock_waits_{0};
+    std::atomic<uint64_t> central_allocations_{0};
+    std::atomic<uint64_t> remote_node_allocations_{0};
 
     std::string protocol;
     void* buffer_;
@@ -78,10 +178,14 @@ class BufferHandle {
    public:
     BufferHandle(std::shared_ptr<ClientBufferAllocator> allocator,
                  offset_allocator::OffsetAllocationHandle handle);
+    // A block of size_class of the allocator's caches, size bytes used
+    BufferHandle(std::shared_ptr<ClientBufferAllocator> allocator,
+                 offset_allocator::OffsetAllocationHandle handle, size_t size,
+                 int size_class);
     ~BufferHandle();
 
-    BufferHandle(BufferHandle&&) = default;  // Allow move operations
-    BufferHandle& operator=(BufferHandle&&) = default;
+    BufferHandle(BufferHandle&& other) noexcept;
+    BufferHandle& operator=(BufferHandle&& other) noexcept;
 
     // Disable copy constructor and copy assignment operator
     BufferHandle(const BufferHandle&) = delete;
@@ -91,8 +195,12 @@ class BufferHandle {
     [[nodiscard]] size_t size() const;
 
    private:
+    void Release();
+
     std::shared_ptr<ClientBufferAllocator> allocator_;
     offset_allocator::OffsetAllocationHandle handle_;
+    size_t size_;
+    int size_class_ = -1;
 };
 
 // Utility functions for buffer and slice management
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <boost/functional/hash.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Liveness leases of the clients of the master.
+ *
+ * Every ping renews the lease of its client, which stores a new deadline
+ * in an atomic of the client entry. The entries are spread over shards, so
+ * that a ping only takes the read lock of one shard and never waits for
+ * the other clients.
+ *
+ * Expiry runs on a timing wheel with one bucket per tick. A client sits in
+ * the bucket of its deadline, and Expire() only visits the buckets that
+ * became due since the last call. A client that was renewed in the
+ * meantime moves to the bucket of its new deadline, so each client is
+ * visited about once per TTL instead of once per tick.
+ *
+ * A client is OK once it has (re)mounted its segments since its last
+ * lease. A client that pings without a lease gets a new lease, but is not
+ * OK until it remounts.
+ */
+class ClientLeaseTable {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    ClientLeaseTable(std::chrono::milliseconds ttl,
+                     std::chrono::milliseconds tick,
+                     Clock::time_point now = Clock::now());
+
+    ClientLeaseTable(const ClientLeaseTable&) = delete;
+    ClientLeaseTable& operator=(const ClientLeaseTable&) = delete;
+
+    // Renews the lease of the client, starting one if it has none. Returns
+    // whether the client is OK.
+    bool Renew(const UUID& client_id, Clock::time_point now = Clock::now());
+
+    bool IsOk(const UUID& client_id) const;
+
+    // Marks a client with a lease as OK. Returns false if it has no lease
+    // or was already OK.
+    bool SetOk(const UUID& client_id);
+
+    // Removes the clients whose lease ran out by `now` and appends them to
+    // `expired`. Returns how many of them were OK. Not thread-safe against
+    // itself, there is a single caller.
+    size_t Expire(Clock::time_point now, std::vector<UUID>& expired);
+
+    size_t Size() const;
+
+   private:
+    static constexpr size_t kNumShards = 64;
+
+    struct Entry {
+        std::atomic<int64_t> deadline_ms{0};
+        std::atomic<bool> ok{false};
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<UUID, std::unique_ptr<Entry>, boost::hash<UUID>>
+            entries;
+    };
+
+    Shard& ShardOf(const UUID& client_id) const;
+
+    int64_t ToMs(Clock::time_point now) const;
+
+    // The first tick at which a deadline has passed
+    int64_t DueTick(int64_t deadline_ms) const;
+
+    void Schedule(const UUID& client_id, int64_t deadline_ms);
+
+    const int64_t ttl_ms_;
+    const int64_t tick_ms_;
+
+    mutable std::array<Shard, kNumShards> shards_;
+
+    // Only Schedule() and Expire() touch the wheel
+    std::mutex wheel_mutex_;
+    std::vector<std::vector<UUID>> wheel_;
+    int64_t last_tick_;
+};
+
+}  // namespace mooncake
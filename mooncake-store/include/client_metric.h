@@ -59,7 +59,20 @@ struct TransferMetric {
           get_latency_us("mooncake_transfer_get_latency",
                          "Get transfer latency (us)", kLatencyBucket, labels),
           put_latency_us("mooncake_transfer_put_latency",
-                         "Put transfer latency (us)", kLatencyBucket, labels) {}
+                         "Put transfer latency (us)", kLatencyBucket, labels),
+          hedged_reads("mooncake_transfer_hedged_reads",
+                       "Gets that read a second replica after the hedge delay",
+                       labels),
+          hedged_read_wins("mooncake_transfer_hedged_read_wins",
+                           "Hedged reads that completed before the first one",
+                           labels),
+          object_cache_hits("mooncake_transfer_object_cache_hits",
+                            "Gets served from the client object cache",
+                            labels),
+          object_cache_misses("mooncake_transfer_object_cache_misses",
+                              "Gets of remote objects not in the client "
+                              "object cache",
+                              labels) {}
 
     ylt::metric::counter_t total_read_bytes;
     ylt::metric::counter_t total_write_bytes;
@@ -67,6 +80,10 @@ struct TransferMetric {
     ylt::metric::histogram_t batch_get_latency_us;
     ylt::metric::histogram_t get_latency_us;
     ylt::metric::histogram_t put_latency_us;
+    ylt::metric::counter_t hedged_reads;
+    ylt::metric::counter_t hedged_read_wins;
+    ylt::metric::counter_t object_cache_hits;
+    ylt::metric::counter_t object_cache_misses;
 
     void serialize(std::string& str) {
         total_read_bytes.serialize(str);
@@ -75,6 +92,10 @@ struct TransferMetric {
         batch_get_latency_us.serialize(str);
         get_latency_us.serialize(str);
         put_latency_us.serialize(str);
+        hedged_reads.serialize(str);
+        hedged_read_wins.serialize(str);
+        object_cache_hits.serialize(str);
+        object_cache_misses.serialize(str);
     }
 
     std::string summary_metrics() {
@@ -96,6 +117,19 @@ struct TransferMetric {
         ss << "Batch Put: " << format_latency_summary(batch_put_latency_us)
            << "\n";
 
+        auto hedges = hedged_reads.value();
+        if (hedges > 0) {
+            ss << "Hedged Reads: " << hedges
+               << ", wins=" << hedged_read_wins.value() << "\n";
+        }
+
+        auto cache_hits = object_cache_hits.value();
+        auto cache_misses = object_cache_misses.value();
+        if (cache_hits + cache_misses > 0) {
+            ss << "Object Cache: hits=" << cache_hits
+               << ", misses=" << cache_misses << "\n";
+        }
+
         return ss.str();
     }
 
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "client_buffer.hpp"
+#include "replica.h"
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Client-side cache of the bytes of recently read remote objects.
+ *
+ * Repeated Gets of a hot remote object are served with a memcpy instead of
+ * a transfer. The bytes live in a ClientBufferAllocator of the configured
+ * capacity and are evicted in LRU order.
+ *
+ * An entry records the ids of the complete replicas it was read from. It is
+ * only served for a query, which holds a lease on the object, that still
+ * lists one of these replicas with the same size: a replica is never
+ * rewritten, so the cached bytes are those of the current object. A new
+ * master view drops every entry since replica ids may be reused then.
+ *
+ * Thread-safe.
+ */
+class ClientObjectCache {
+   public:
+    // capacity = 0 disables the cache
+    ClientObjectCache(size_t capacity, size_t max_object_size);
+
+    ClientObjectCache(const ClientObjectCache&) = delete;
+    ClientObjectCache& operator=(const ClientObjectCache&) = delete;
+
+    bool enabled() const { return allocator_ != nullptr; }
+
+    size_t max_object_size() const { return max_object_size_; }
+
+    /**
+     * @brief Copy the cached bytes of key into slices if they are the bytes
+     * of one of the given replicas and fill the slices exactly.
+     */
+    bool Read(const std::string& key,
+              const std::vector<Replica::Descriptor>& replicas,
+              std::vector<Slice>& slices);
+
+    /**
+     * @brief Cache the bytes just read into slices from the given replicas.
+     * Evicts the least recently used entries to make room.
+     */
+    void Put(const std::string& key,
+             const std::vector<Replica::Descriptor>& replicas,
+             const std::vector<Slice>& slices);
+
+    void Invalidate(const std::string& key);
+
+    void Clear();
+
+    // Drops every entry if the master view changed
+    void SyncView(uint64_t view_version);
+
+    size_t size() const;
+
+   private:
+    struct CachedObject {
+        std::string key;
+        std::vector<ReplicaID> replica_ids;
+        uint64_t object_size;
+        BufferHandle buffer;
+    };
+    using LruList = std::list<CachedObject>;
+
+    static std::vector<ReplicaID> CompleteReplicaIds(
+        const std::vector<Replica::Descriptor>& replicas,
+        uint64_t object_size);
+
+    void EraseLocked(LruList::iterator it);
+
+    const size_t max_object_size_;
+    std::shared_ptr<ClientBufferAllocator> allocator_;
+
+    mutable std::mutex mutex_;
+    // Most recently used first
+    LruList lru_;
+    std::unordered_map<std::string, LruList::iterator> entries_;
+    std::optional<uint64_t> view_version_;
+};
+
+}  // namespace mooncake
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <async_simple/coro/Lazy.h>
 #include <atomic>
 #include <boost/functional/hash.hpp>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <thread>
 #include <vector>
@@ -12,11 +17,18 @@
 #include <chrono>
 #include <unordered_set>
 
+#include "client_buffer.hpp"
 #include "client_metric.h"
 #include "ha_helper.h"
+#include "key_filter.h"
+#include "latency_percentile.h"
 #include "master_client.h"
+#include "client_object_cache.h"
+#include "replica_location_cache.h"
+#include "replica_speed_tracker.h"
 #include "storage_backend.h"
 #include "thread_pool.h"
+#include "transfer_completion_queue.h"
 #include "transfer_engine.h"
 #include "transfer_task.h"
 #include "types.h"
@@ -70,6 +82,9 @@ class Client {
      * @param master_server_entry The entry of master server (IP:Port of master
      *        address for non-HA mode, etcd://IP:Port;IP:Port;...;IP:Port for
      *        HA mode)
+     * @param client_id Id of a previous process of the client, whose
+     *        segments are mounted again, see WarmRestartState. A new id by
+     *        default.
      * @return std::optional containing a shared_ptr to Client if successful,
      * std::nullopt otherwise
      */
@@ -79,7 +94,8 @@ class Client {
         const std::optional<std::string>& device_names = std::nullopt,
         const std::string& master_server_entry = kDefaultMasterAddress,
         const std::shared_ptr<TransferEngine>& transfer_engine = nullptr,
-        std::map<std::string, std::string> labels = {});
+        std::map<std::string, std::string> labels = {},
+        const std::optional<UUID>& client_id = std::nullopt);
 
     /**
      * @brief Retrieves data for a given key
@@ -118,6 +134,19 @@ class Client {
      */
     tl::expected<QueryResult, ErrorCode> Query(const std::string& object_key);
 
+    /**
+     * @brief Like Query, but if the object is still being put, waits up to
+     * timeout for the put to complete instead of failing with
+     * REPLICA_IS_NOT_READY
+     * @param object_key Key to query
+     * @param timeout Longest time to wait for the pending put
+     * @return QueryResult of the completed object, or ErrorCode indicating
+     * failure. REPLICA_IS_NOT_READY if the put did not complete in time,
+     * OBJECT_NOT_FOUND if it was revoked.
+     */
+    tl::expected<QueryResult, ErrorCode> QueryWait(
+        const std::string& object_key, std::chrono::milliseconds timeout);
+
     /**
      * @brief Queries replica lists for object keys that match a regex pattern.
      * @param str The regular expression string to match against object keys.
@@ -163,6 +192,86 @@ class Client {
     tl::expected<void, ErrorCode> Get(const std::string& object_key,
                                       const QueryResult& query_result,
                                       std::vector<Slice>& slices);
+    // Bytes [offset, offset + slice.size) of an object and their destination
+    struct ObjectRange {
+        uint64_t offset;
+        Slice slice;
+    };
+
+    /**
+     * @brief Reads only the given ranges of an object, e.g. the tensor slice
+     * of one tensor parallel rank, in a single batch of transfers
+     * @param object_key Key of the object
+     * @param query_result Previously queried object metadata
+     * @param ranges Ranges to read, within the object
+     * @return ErrorCode::INVALID_PARAMS for ranges past the end of the object,
+     * ErrorCode::INVALID_REPLICA if the object has neither a memory replica
+     * nor a disk replica readable through the storage backend
+     * @note Disk replicas are read with a pread per range
+     */
+    tl::expected<void, ErrorCode> GetRanges(
+        const std::string& object_key, const QueryResult& query_result,
+        const std::vector<ObjectRange>& ranges);
+
+    /**
+     * @brief Starts a chunked put of an object of the given size. Each chunk
+     * appended with ChunkedPutAppend is readable at once through
+     * WaitCommitted and GetCommittedRanges, before ChunkedPutEnd completes
+     * the object, e.g. to stream KV cache layer by layer.
+     * @return Replicas to pass to the other ChunkedPut calls, or ErrorCode
+     * as PutStart. ErrorCode::INVALID_REPLICA for striped replicas, which
+     * cannot be written in chunks.
+     * @note Chunked puts only write memory replicas
+     */
+    tl::expected<std::vector<Replica::Descriptor>, ErrorCode> ChunkedPutStart(
+        const ObjectKey& key, size_t size, const ReplicateConfig& config);
+
+    /**
+     * @brief Writes a chunk at offset to every memory replica, then commits
+     * the object up to its end. Chunks must be appended in order, offset
+     * being the bytes appended so far.
+     */
+    tl::expected<void, ErrorCode> ChunkedPutAppend(
+        const ObjectKey& key, const std::vector<Replica::Descriptor>& replicas,
+        uint64_t offset, const Slice& chunk);
+
+    // Completes a chunked put, the object is then read as any other
+    tl::expected<void, ErrorCode> ChunkedPutEnd(
+        const ObjectKey& key, const std::vector<Replica::Descriptor>& replicas);
+
+    // Revokes a chunked put. Readers of its chunks may read freed memory.
+    tl::expected<void, ErrorCode> ChunkedPutRevoke(
+        const ObjectKey& key, const std::vector<Replica::Descriptor>& replicas);
+
+    // Readable part of an object, see WaitCommitted
+    struct CommittedQueryResult {
+        std::vector<Replica::Descriptor> replicas;
+        // Readable prefix of an object still being put
+        uint64_t committed_bytes;
+        // The put completed, the whole object is readable
+        bool complete;
+        std::chrono::steady_clock::time_point lease_timeout;
+    };
+
+    /**
+     * @brief Waits up to timeout until the first min_bytes of an object are
+     * readable, either committed by a chunked put or completed by any put
+     * @return ErrorCode::REPLICA_IS_NOT_READY or ErrorCode::OBJECT_NOT_FOUND
+     * if the bytes were not committed in time
+     */
+    tl::expected<CommittedQueryResult, ErrorCode> WaitCommitted(
+        const std::string& object_key, uint64_t min_bytes,
+        std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Reads ranges of an object within what WaitCommitted found
+     * readable, see GetRanges
+     * @return ErrorCode::INVALID_PARAMS for ranges past the committed bytes
+     */
+    tl::expected<void, ErrorCode> GetCommittedRanges(
+        const std::string& object_key, const CommittedQueryResult& committed,
+        const std::vector<ObjectRange>& ranges);
+
     /**
      * @brief Transfers data using pre-queried object information
      * @param object_keys Keys of the objects
@@ -181,11 +290,96 @@ class Client {
      * @param key Object key
      * @param slices Vector of data slices to store
      * @param config Replication configuration
+     * @param fill_slices If set, called to write the data into the slices
+     * once the put is known to be needed, so that nothing is copied for
+     * keys that already exist
      * @return ErrorCode indicating success/failure
      */
-    tl::expected<void, ErrorCode> Put(const ObjectKey& key,
-                                      std::vector<Slice>& slices,
-                                      const ReplicateConfig& config);
+    tl::expected<void, ErrorCode> Put(
+        const ObjectKey& key, std::vector<Slice>& slices,
+        const ReplicateConfig& config,
+        const std::function<void()>& fill_slices = nullptr);
+
+    // Receives the result of an asynchronous Get or Put
+    using AsyncCallback = std::function<void(tl::expected<void, ErrorCode>)>;
+    using AsyncResult = std::future<tl::expected<void, ErrorCode>>;
+
+    /**
+     * @brief Starts a Get and returns once its transfer is submitted
+     * @param callback Called with the result, on the completion thread of
+     * the client once the transfer finishes, or on the calling thread if the
+     * Get fails before
+     * @note The metadata query runs on the calling thread. The buffers of the
+     * slices must stay valid until the callback runs.
+     */
+    void AsyncGet(const std::string& object_key, std::vector<Slice>& slices,
+                  AsyncCallback callback);
+    void AsyncGet(const std::string& object_key,
+                  const QueryResult& query_result, std::vector<Slice>& slices,
+                  AsyncCallback callback);
+    AsyncResult AsyncGet(const std::string& object_key,
+                         std::vector<Slice>& slices);
+
+    /**
+     * @brief Starts a batch of Gets with a single metadata query
+     * @return Results in the order of the keys
+     */
+    std::vector<AsyncResult> AsyncBatchGet(
+        const std::vector<std::string>& object_keys,
+        std::unordered_map<std::string, std::vector<Slice>>& slices);
+
+    // Receives the result of the Get of object_keys[index]
+    using StreamCallback = std::function<void(
+        size_t index, tl::expected<void, ErrorCode> result)>;
+
+    /**
+     * @brief Starts a batch of Gets with a single metadata query and reports
+     * each key as soon as it and all the keys before it are done
+     * @param callback Called once per key, in the order of the keys, so
+     * that e.g. the first layers of a KV cache can be used while the later
+     * ones are still being transferred. Runs on the completion thread of the
+     * client, or on the calling thread for keys done before this returns.
+     * @note The transfers are submitted in the order of the keys. The
+     * buffers of the slices must stay valid until the last callback runs.
+     */
+    void StreamingBatchGet(
+        const std::vector<std::string>& object_keys,
+        std::unordered_map<std::string, std::vector<Slice>>& slices,
+        StreamCallback callback);
+    // Same with the results of BatchQuery, failed queries are reported as is
+    void StreamingBatchGet(
+        const std::vector<std::string>& object_keys,
+        const std::vector<tl::expected<QueryResult, ErrorCode>>& query_results,
+        std::unordered_map<std::string, std::vector<Slice>>& slices,
+        StreamCallback callback);
+
+    /**
+     * @brief Starts a Put and returns once its transfers are submitted
+     * @param callback Called with the result, on the completion thread of
+     * the client after the PutEnd or PutRevoke, or on the calling thread if
+     * the Put fails before any transfer is submitted
+     * @note PutStart runs on the calling thread. The buffers of the slices
+     * must stay valid until the callback runs.
+     */
+    void AsyncPut(const ObjectKey& key, std::vector<Slice>& slices,
+                  const ReplicateConfig& config, AsyncCallback callback);
+    AsyncResult AsyncPut(const ObjectKey& key, std::vector<Slice>& slices,
+                         const ReplicateConfig& config);
+
+    /**
+     * @brief Get and Put as coroutines, suspending instead of blocking the
+     * thread on the master RPCs and on the transfers, so that one thread can
+     * drive many operations
+     * @note The transfers complete on the completion thread of the client,
+     * which resumes the coroutine unless it runs on an executor. The buffers
+     * of the slices must stay valid until the coroutine returns. Unlike Get,
+     * CoroGet reads a single replica, without the object cache, split or
+     * hedged reads.
+     */
+    async_simple::coro::Lazy<tl::expected<void, ErrorCode>> CoroGet(
+        std::string object_key, std::vector<Slice>& slices);
+    async_simple::coro::Lazy<tl::expected<void, ErrorCode>> CoroPut(
+        ObjectKey key, std::vector<Slice>& slices, ReplicateConfig config);
 
     /**
      * @brief Batch put data with replication
@@ -199,6 +393,47 @@ class Client {
         std::vector<std::vector<Slice>>& batched_slices,
         const ReplicateConfig& config);
 
+    /**
+     * @brief Stores many small values as one bundle object, with a single
+     * allocation, lease and metadata entry on the master, e.g. the pages of
+     * one request of a paged KV cache. The keys stay addressable one by one
+     * through GetBundled and Remove; the bundle is removed with its last key.
+     * @param bundle_name Name of the bundle, unique among bundles
+     * @param keys Keys stored in the bundle
+     * @param batched_slices Data of each key (indexed to match keys)
+     * @param config Replication configuration of the bundle
+     * @return ErrorCode::OBJECT_ALREADY_EXISTS if the bundle or a key exists,
+     * ErrorCode::UNAVAILABLE_IN_CURRENT_MODE if the master persists its
+     * metadata, in which cases no key is stored
+     */
+    tl::expected<void, ErrorCode> PutBundle(
+        const std::string& bundle_name, const std::vector<ObjectKey>& keys,
+        std::vector<std::vector<Slice>>& batched_slices,
+        const ReplicateConfig& config);
+
+    /**
+     * @brief Reads keys stored with PutBundle, with one range read of each
+     * bundle they are in
+     * @param keys Keys to read
+     * @param slices Map of the keys to their destination slices, at most as
+     * large as the values
+     * @return Per key, ErrorCode::OBJECT_NOT_FOUND if the key is not in a
+     * bundle, ErrorCode::INVALID_PARAMS if its slices exceed its value
+     */
+    std::vector<tl::expected<void, ErrorCode>> GetBundled(
+        const std::vector<std::string>& keys,
+        std::unordered_map<std::string, std::vector<Slice>>& slices);
+
+    /**
+     * @brief Capacity signal of the masters from the last ping. While the
+     * memory segments are above the eviction high watermark, put starts
+     * wait for the reported backoff; callers may rather batch their puts or
+     * send them to offload storage.
+     * @return The used ratio of the fullest master, in range [0.0, 1.0]
+     */
+    double GetMemUsedRatio() const { return mem_used_ratio_.load(); }
+    uint64_t GetPutBackoffMs() const { return put_backoff_ms_.load(); }
+
     /**
      * @brief Removes an object and all its replicas
      * @param key Key to remove
@@ -218,6 +453,25 @@ class Client {
     tl::expected<long, ErrorCode> RemoveByRegex(const ObjectKey& str,
                                                 bool force = false);
 
+    /**
+     * @brief Starts removing the objects whose keys start with prefix in the
+     * background, without blocking the masters for the whole removal.
+     * @param force If true, skip lease checks
+     * @return The ids of the removal tasks, one per master, to be polled
+     * with QueryTask
+     */
+    tl::expected<std::vector<UUID>, ErrorCode> RemoveByPrefix(
+        const std::string& prefix, bool force = false);
+
+    /**
+     * @brief Fetches one page of the keys starting with prefix
+     * @param cursor 0 for the first page, then the next_cursor of the
+     * previous page, which is 0 once all keys are scanned
+     */
+    tl::expected<ScanKeysResponse, ErrorCode> ScanKeys(
+        const std::string& prefix, uint64_t cursor,
+        uint64_t limit = kScanKeysPageSize);
+
     /**
      * @brief Removes all objects and all its replicas
      * @param force If true, skip lease and replication task checks
@@ -229,10 +483,26 @@ class Client {
      * @brief Registers a memory segment to master for allocation
      * @param buffer Memory buffer to register
      * @param size Size of the buffer in bytes
+     * @param location Memory location the buffer is registered with, e.g.
+     * "cpu:1" for memory on NUMA node 1, which the transfer engine uses to
+     * pick the NICs of that node
+     * @param segment_id Id the segment had in a previous process of the
+     * client, which keeps its objects if the master still has it mounted. A
+     * new id by default.
      * @return ErrorCode indicating success/failure
      */
     tl::expected<void, ErrorCode> MountSegment(
-        const void* buffer, size_t size, const std::string& protocol = "tcp");
+        const void* buffer, size_t size, const std::string& protocol = "tcp",
+        const std::string& location = kWildcardLocation,
+        const std::optional<UUID>& segment_id = std::nullopt);
+
+    /**
+     * @brief Forgets the mounted segments without unmounting them, so that
+     * they stay in the master for a restarted process of the client. The
+     * master unmounts them once the lease of the client expires if none
+     * comes back.
+     */
+    void DetachSegments();
 
     /**
      * @brief Unregisters a memory segment from master
@@ -243,6 +513,20 @@ class Client {
     tl::expected<void, ErrorCode> UnmountSegment(const void* buffer,
                                                  size_t size);
 
+    /**
+     * @brief Unmounts a memory segment without losing its objects: the
+     * master stops allocating in it and moves its objects, the hot ones
+     * first, to other segments before it is unmounted
+     * @param buffer Memory buffer to unregister
+     * @param size Size of the buffer in bytes
+     * @param timeout Time after which the segment is unmounted with the
+     * objects it still holds
+     * @return ErrorCode indicating success/failure
+     */
+    tl::expected<void, ErrorCode> DrainSegment(
+        const void* buffer, size_t size,
+        std::chrono::milliseconds timeout = std::chrono::seconds(60));
+
     /**
      * @brief Registers memory buffer with TransferEngine for data transfer
      * @param addr Memory address to register
@@ -281,6 +565,18 @@ class Client {
     std::vector<tl::expected<bool, ErrorCode>> BatchIsExist(
         const std::vector<std::string>& keys);
 
+    /**
+     * @brief Starts copying the disk replicas of objects into the memory
+     * segments mounted by this client, so that their later Gets read from
+     * memory. Returns without waiting for the copies. Objects that have a
+     * memory replica, or no disk replica, are skipped.
+     * @param keys Keys of the objects to prefetch
+     * @return ErrorCode::SEGMENT_NOT_FOUND if this client mounted no
+     * segment to copy into
+     */
+    tl::expected<void, ErrorCode> Prefetch(
+        const std::vector<std::string>& keys);
+
     /**
      * @brief Create a copy task to copy an object's replicas to target segments
      * @param key Object key
@@ -330,11 +626,14 @@ class Client {
      * @param enable_offloading Indicates whether offloading is enabled for this
      * segment.
      * @param offloading_objects On return, contains a map from object key to
-     * size (in bytes) for all objects that require offload.
+     * size (in bytes) for the objects that require offload.
+     * @param max_objects Upper bound of the objects each master returns, the
+     * others are returned by later heartbeats. 0 for no bound.
      */
     tl::expected<void, ErrorCode> OffloadObjectHeartbeat(
         bool enable_offloading,
-        std::unordered_map<std::string, int64_t>& offloading_objects);
+        std::unordered_map<std::string, int64_t>& offloading_objects,
+        uint64_t max_objects = 0);
 
     /**
      * @brief Performs a batched read of multiple objects using a
@@ -412,13 +711,16 @@ class Client {
     tl::expected<Replica::Descriptor, ErrorCode> GetPreferredReplica(
         const std::vector<Replica::Descriptor>& replica_list);
 
+    bool IsReplicaOnLocalMemory(const Replica::Descriptor& replica);
+
    private:
     /**
      * @brief Private constructor to enforce creation through Create() method
      */
     Client(const std::string& local_hostname,
            const std::string& metadata_connstring, const std::string& protocol,
-           const std::map<std::string, std::string>& labels = {});
+           const std::map<std::string, std::string>& labels = {},
+           const std::optional<UUID>& client_id = std::nullopt);
 
     /**
      * @brief Internal helper functions for initialization and data transfer
@@ -434,8 +736,50 @@ class Client {
                            TransferRequest::OpCode op_code);
     ErrorCode TransferWrite(const Replica::Descriptor& replica_descriptor,
                             std::vector<Slice>& slices);
+    tl::expected<void, ErrorCode> PutObject(
+        const ObjectKey& key, std::vector<Slice>& slices,
+        const ReplicateConfig& config,
+        const std::function<void()>& fill_slices = nullptr);
+    // PutStart, retried while another put of the key is in progress if
+    // config.wait_for_concurrent_put is set
+    tl::expected<std::vector<Replica::Descriptor>, ErrorCode> PutStartOrWait(
+        const ObjectKey& key, const std::vector<size_t>& slice_lengths,
+        const ReplicateConfig& config);
+    // Waits the put backoff of the last ping, if any
+    void WaitForPutBackoff();
+    // Backs off the puts until the next ping once the master is out of space
+    void OnPutStartResult(ErrorCode error);
+    // Query and PutStartOrWait as coroutines
+    async_simple::coro::Lazy<tl::expected<QueryResult, ErrorCode>> CoroQuery(
+        const std::string& object_key);
+    async_simple::coro::Lazy<
+        tl::expected<std::vector<Replica::Descriptor>, ErrorCode>>
+    CoroPutStartOrWait(const ObjectKey& key,
+                       const std::vector<size_t>& slice_lengths,
+                       const ReplicateConfig& config);
+    // Writes the disk replica, submits the transfers to the memory replicas
+    // and calls done on the completion thread once they finish, with the
+    // first error of the submission or of the transfers
+    void SubmitPut(const ObjectKey& key, std::vector<Slice>& slices,
+                   const std::vector<Replica::Descriptor>& replicas,
+                   TransferCompletionQueue::Callback done);
+    // Puts the objects of a batch whose keys were being put by another
+    // client, once that put ended
+    void PutAfterConcurrentPuts(std::span<PutOperation> ops,
+                                const ReplicateConfig& config);
+    // Links the key to the content object of the slices, putting it first
+    // if no client did. Falls back to PutObject if the key cannot be linked.
+    tl::expected<void, ErrorCode> PutDeduplicated(
+        const ObjectKey& key, std::vector<Slice>& slices,
+        const ReplicateConfig& config);
     ErrorCode TransferRead(const Replica::Descriptor& replica_descriptor,
                            std::vector<Slice>& slices);
+    tl::expected<TransferFuture, ErrorCode> SubmitTransfer(
+        const Replica::Descriptor& replica_descriptor,
+        std::vector<Slice>& slices, TransferRequest::OpCode op_code);
+    tl::expected<TransferFuture, ErrorCode> SubmitRead(
+        const Replica::Descriptor& replica_descriptor,
+        std::vector<Slice>& slices);
 
     /**
      * @brief Prepare and use the storage backend for persisting data
@@ -445,6 +789,17 @@ class Client {
                                bool enable_eviction = true,
                                uint64_t quota_bytes = 0);
 
+    tl::expected<void, ErrorCode> GetDiskRanges(
+        const std::string& object_key, const QueryResult& query_result,
+        const Replica::Descriptor& replica,
+        const std::vector<ObjectRange>& ranges);
+
+    // Reads or writes ranges of a memory replica in a single batch
+    tl::expected<void, ErrorCode> TransferRanges(
+        const std::string& object_key, const Replica::Descriptor& replica,
+        const std::vector<ObjectRange>& ranges,
+        TransferRequest::OpCode op_code);
+
     void PutToLocalFile(const std::string& object_key,
                         const std::vector<Slice>& slices,
                         const DiskDescriptor& disk_descriptor);
@@ -460,22 +815,80 @@ class Client {
         const std::vector<Replica::Descriptor>& replica_list,
         Replica::Descriptor& replica);
 
+    /**
+     * @brief Select the complete replica to read an object from: the first
+     * one, or with MC_STORE_REPLICA_SELECTION=fastest a replica in local
+     * memory, else the memory replica expected to be read the fastest
+     * @return ErrorCode::OK if found, ErrorCode::INVALID_REPLICA if no complete
+     * replica
+     */
+    ErrorCode SelectReplica(const std::vector<Replica::Descriptor>& replica_list,
+                            Replica::Descriptor& replica);
+
+    // Feeds the duration of a read of the replica to replica_speed_
+    void RecordReplicaRead(const Replica::Descriptor& replica, ErrorCode result,
+                           uint64_t latency_us);
+
+    // A contiguous part of an object, read from one of its replicas
+    struct ReadPart {
+        Replica::Descriptor replica;
+        std::vector<Slice> slices;
+    };
+
+    /**
+     * @brief Split a read across all complete memory replicas of an object,
+     * so that a large object is read through several remote NICs at once
+     * @param replica_list Replicas of the object
+     * @param slices Destination of the whole object
+     * @return one part per replica, empty if the object is read from a
+     * single replica, e.g. when it is small or has a local replica
+     */
+    std::vector<ReadPart> SplitRead(
+        const std::vector<Replica::Descriptor>& replica_list,
+        const std::vector<Slice>& slices);
+    ErrorCode TransferReadParts(std::vector<ReadPart>& parts);
+
+    /**
+     * @brief Read an object into a staging buffer, and read it again from a
+     * second replica if the first read takes longer than the hedge delay
+     * @param replica_list Replicas of the object
+     * @param slices Destination of the whole object
+     * @return the result of the first read to succeed, std::nullopt if the
+     * read cannot be hedged and is left to TransferRead
+     */
+    std::optional<ErrorCode> HedgedRead(
+        const std::vector<Replica::Descriptor>& replica_list,
+        std::vector<Slice>& slices);
+
     /**
      * @brief Batch put helper methods for structured approach
      */
     std::vector<PutOperation> CreatePutOperations(
         const std::vector<ObjectKey>& keys,
         const std::vector<std::vector<Slice>>& batched_slices);
-    void StartBatchPut(std::vector<PutOperation>& ops,
+    void StartBatchPut(std::span<PutOperation> ops,
                        const ReplicateConfig& config);
-    void SubmitTransfers(std::vector<PutOperation>& ops);
-    void WaitForTransfers(std::vector<PutOperation>& ops);
-    void FinalizeBatchPut(std::vector<PutOperation>& ops);
+    void SubmitTransfers(std::span<PutOperation> ops);
+    void WaitForTransfers(std::span<PutOperation> ops);
+    void FinalizeBatchPut(std::span<PutOperation> ops);
+    // Runs the phases above on sub-batches of batch_put_pipeline_size_ keys,
+    // the PutStart of the next and the PutEnd of the previous sub-batch
+    // overlapping the transfers of the current one
+    void PipelinedBatchPut(std::vector<PutOperation>& ops,
+                           const ReplicateConfig& config);
     std::vector<tl::expected<void, ErrorCode>> CollectResults(
         const std::vector<PutOperation>& ops);
 
     std::vector<tl::expected<void, ErrorCode>> BatchPutWhenPreferSameNode(
         std::vector<PutOperation>& ops);
+    // BatchIsExist without the key filter
+    std::vector<tl::expected<bool, ErrorCode>> BatchIsExistOnMaster(
+        const std::vector<std::string>& keys);
+    // BatchQuery that only asks the master for the keys missing in
+    // replica_location_cache_. If any is missing, the lookahead chain
+    // successors of the last key are queried and cached along.
+    std::vector<tl::expected<QueryResult, ErrorCode>> BatchQueryWithCache(
+        const std::vector<std::string>& object_keys, size_t lookahead = 0);
     std::vector<tl::expected<void, ErrorCode>> BatchGetWhenPreferSameNode(
         const std::vector<std::string>& object_keys,
         const std::vector<QueryResult>& query_results,
@@ -491,6 +904,58 @@ class Client {
     std::shared_ptr<TransferEngine> transfer_engine_;
     MasterClient master_client_;
     std::unique_ptr<TransferSubmitter> transfer_submitter_;
+    // Bytes of all submitted transfers, the ping thread reports the rate
+    std::atomic<uint64_t> transferred_bytes_{0};
+    // Capacity signal of the last ping, see GetMemUsedRatio
+    std::atomic<double> mem_used_ratio_{0.0};
+    std::atomic<uint64_t> put_backoff_ms_{0};
+    // Completes the transfers of AsyncGet and AsyncPut
+    std::unique_ptr<TransferCompletionQueue> completion_queue_;
+
+    // Replica locations of recently queried keys, disabled unless
+    // MC_STORE_REPLICA_CACHE_SIZE is set
+    ReplicaLocationCache replica_location_cache_;
+    // Successors of a chain key queried along with it on a cache miss, so
+    // that sequential reads of a prefix skip the master,
+    // MC_STORE_REPLICA_CACHE_LOOKAHEAD
+    const size_t replica_cache_lookahead_;
+    // Bytes of recently read remote objects, disabled unless
+    // MC_STORE_OBJECT_CACHE_SIZE is set
+    ClientObjectCache object_cache_;
+    // Copy of the key filters of the masters, synced on every ping if
+    // MC_STORE_KEY_FILTER=1. IsExist reports the keys it excludes missing
+    // without asking the master.
+    KeyFilterView key_filter_;
+    const bool key_filter_enabled_;
+    // Steady clock time of the last complete sync in ns, 0 if none
+    std::atomic<int64_t> key_filter_synced_ns_{0};
+    // Minimum size of the parts of an object read from several replicas,
+    // MC_STORE_PARALLEL_READ_MIN_PART_SIZE, 0 to always read one replica
+    const uint64_t parallel_read_min_part_size_;
+    // Keys per sub-batch of a pipelined BatchPut,
+    // MC_STORE_BATCH_PUT_PIPELINE_SIZE, 0 to put the whole batch at once
+    const uint64_t batch_put_pipeline_size_;
+
+    // Speed of the reads from each remote endpoint, to read from the fastest
+    // replica, unless MC_STORE_REPLICA_SELECTION is set to fastest the first
+    // complete replica is read
+    std::unique_ptr<ReplicaSpeedTracker> replica_speed_;
+
+    // Hedged reads, disabled unless MC_STORE_HEDGED_READ_PERCENTILE is set.
+    // The delay is that percentile of the latency of the recent reads.
+    std::unique_ptr<LatencyPercentile> hedge_delay_;
+    const uint64_t hedged_read_max_size_;
+    // Content-addressed deduplication of Put, MC_STORE_DEDUP=1. The data is
+    // put once under its content key and the keys are linked to it.
+    const bool dedup_enabled_;
+    // How long a put waits for a concurrent put of the same key,
+    // MC_STORE_PUT_WAIT_TIMEOUT_MS
+    const std::chrono::milliseconds put_wait_timeout_;
+    // Registered staging buffers of the reads, as the losing read cannot be
+    // cancelled
+    std::shared_ptr<ClientBufferAllocator> hedge_buffer_allocator_;
+    // Waits for the losing reads before releasing their staging buffers
+    std::unique_ptr<ThreadPool> hedge_reaper_pool_;
 
     // Mutex to protect mounted_segments_
     std::mutex mounted_segments_mutex_;
@@ -509,8 +974,17 @@ class Client {
     MasterViewHelper master_view_helper_;
     std::thread ping_thread_;
     std::atomic<bool> ping_running_{false};
+    // Wakes the ping thread on shutdown and when a new leader is elected
+    std::mutex ping_mutex_;
+    std::condition_variable ping_cv_;
+    // Leader reported by MasterViewWatcher, connected by the ping thread
+    std::string next_master_address_;
+    std::optional<uint64_t> master_view_subscription_;
     void PingThreadMain(bool is_ha_mode, std::string current_master_address);
     void PollAndDispatchTasks();
+    void SyncKeyFilter();
+    // Whether a recent key filter sync shows that the key does not exist
+    bool KeyFilterExcludes(const std::string& key) const;
     void SubmitTask(const TaskAssignment& assignment);
 
     // For task management
@@ -553,7 +1027,26 @@ class Client {
                                        const std::string& source,
                                        const std::string& target);
 
-    bool IsReplicaOnLocalMemory(const Replica::Descriptor& replica);
+    /**
+     * @brief Copy the disk replica of an object into a local memory segment
+     * @param key Object key
+     * @param target Target segment, mounted by this client
+     * @return tl::expected<void, ErrorCode> indicating success/failure
+     */
+    tl::expected<void, ErrorCode> Promote(const std::string& key,
+                                          const std::string& target);
+
+    // Promotes the keys of a Prefetch that are only held by disk replicas
+    void PrefetchKeys(const std::vector<std::string>& keys,
+                      const std::vector<std::string>& targets);
+
+    // Runs the queries and promotions of Prefetch, MC_STORE_PREFETCH_THREADS
+    static constexpr size_t kPrefetchBatchSize = 64;
+    ThreadPool prefetch_thread_pool_;
+    std::atomic<bool> prefetch_running_{true};
+    // Keys queued or being promoted, prefetched again only once done
+    std::mutex prefetch_mutex_;
+    std::unordered_set<std::string> prefetching_keys_;
 
     // Task thread pool for async task execution
     ThreadPool task_thread_pool_;
@@ -562,6 +1055,9 @@ class Client {
     // Task polling configuration
     static constexpr size_t kTaskBatchSize =
         16;  // Number of tasks to fetch per poll
+
+    // Interval at which DrainSegment asks the master how much is left
+    static constexpr std::chrono::milliseconds kDrainPollInterval{200};
 };
 
 }  // namespace mooncake
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <ylt/util/tl/expected.hpp>
+
+#include "rpc_types.h"
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Protocol and transport endpoint shared by the buffers of a segment
+ */
+struct BufferEndpoint {
+    std::string protocol;
+    std::string transport_endpoint;
+    YLT_REFL(BufferEndpoint, protocol, transport_endpoint);
+};
+
+/**
+ * @brief Wire format of BatchGetReplicaList results.
+ *
+ * The buffers of a segment repeat the same protocol and transport endpoint,
+ * once per replica of every key. Here the distinct endpoints are sent once
+ * per response, and the buffer descriptors of the results carry empty
+ * strings and an index in the endpoint table instead.
+ */
+struct CompactReplicaLists {
+    // Index of a buffer that kept its own strings
+    static constexpr uint32_t kInlineEndpoint =
+        std::numeric_limits<uint32_t>::max();
+
+    std::vector<tl::expected<GetReplicaListResponse, ErrorCode>> results;
+    std::vector<BufferEndpoint> endpoints;
+    // Endpoint of every buffer of the results, in the order of the replicas
+    // and of the chunks of striped replicas
+    std::vector<uint32_t> endpoint_indices;
+    YLT_REFL(CompactReplicaLists, results, endpoints, endpoint_indices);
+};
+
+CompactReplicaLists EncodeReplicaLists(
+    std::vector<tl::expected<GetReplicaListResponse, ErrorCode>> results);
+
+/**
+ * @brief Restore the results encoded by EncodeReplicaLists
+ * @return RPC_FAIL if the endpoint table does not match the results
+ */
+tl::expected<std::vector<tl::expected<GetReplicaListResponse, ErrorCode>>,
+             ErrorCode>
+DecodeReplicaLists(CompactReplicaLists compact);
+
+}  // namespace mooncake
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Keys of the master that are linked to content-addressed objects.
+ *
+ * Clients with deduplication on put the data of an object once, under the
+ * content key made of its hash, and link their keys to it. Reads of a
+ * linked key are served from the replicas of its content object. The
+ * content object is shared by all its keys and removed with the last one.
+ *
+ * Thread-safe. Links are sharded by key and contents by content key, like
+ * the metadata of the master, so that operations on different keys do not
+ * contend. A link shard may be locked before a content shard, never the
+ * other way round. empty() is lock-free, so that masters without linked
+ * keys pay nothing on reads.
+ */
+class ContentIndex {
+   public:
+    static constexpr const char* kContentKeyPrefix = "__mooncake_content__/";
+
+    struct Stats {
+        uint64_t linked_keys = 0;
+        uint64_t content_objects = 0;
+        // Bytes the linked keys would take as objects of their own, less
+        // the bytes of their content objects
+        uint64_t saved_bytes = 0;
+    };
+
+    static bool IsContentKey(const std::string& key);
+
+    /**
+     * @brief Content key of the concatenation of the slices, from its
+     * SHA-256 and size. Slices must be in host memory.
+     */
+    static std::string ContentKey(const std::vector<Slice>& slices);
+
+    bool empty() const {
+        return num_linked_keys_.load(std::memory_order_relaxed) == 0;
+    }
+
+    /**
+     * @brief Links the key to the content object of size bytes. Linking a
+     * key again to the same content object does nothing.
+     * @return OBJECT_ALREADY_EXISTS if the key is linked to another one.
+     */
+    ErrorCode Link(const std::string& key, const std::string& content_key,
+                   uint64_t size);
+
+    std::optional<std::string> Resolve(const std::string& key) const;
+
+    /**
+     * @brief Unlinks the key.
+     * @param orphaned Set to the content key if it has no keys left.
+     * @return false if the key is not linked.
+     */
+    bool Unlink(const std::string& key, std::optional<std::string>& orphaned);
+
+    /**
+     * @brief Unlinks the keys matching the predicate.
+     * @param orphaned Receives the content keys left without keys.
+     * @return Number of unlinked keys.
+     */
+    size_t UnlinkIf(const std::function<bool(const std::string&)>& pred,
+                    std::vector<std::string>& orphaned);
+
+    Stats GetStats() const;
+
+   private:
+    static constexpr size_t kNumShards = 1024;
+
+    struct Content {
+        uint64_t size = 0;
+        uint64_t refs = 0;
+    };
+
+    struct LinkShard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::string> links;  // key -> content
+    };
+
+    struct ContentShard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Content> contents;
+    };
+
+    LinkShard& GetLinkShard(const std::string& key) const {
+        return link_shards_[std::hash<std::string>{}(key) % kNumShards];
+    }
+
+    ContentShard& GetContentShard(const std::string& content_key) {
+        return content_shards_[std::hash<std::string>{}(content_key) %
+                               kNumShards];
+    }
+
+    // Counts one more key of the content
+    void Acquire(const std::string& content_key, uint64_t size);
+
+    // Returns true if the content has no keys left
+    bool Release(const std::string& content_key);
+
+    void UpdateMetrics();
+
+    mutable std::array<LinkShard, kNumShards> link_shards_;
+    std::array<ContentShard, kNumShards> content_shards_;
+    std::atomic<uint64_t> num_linked_keys_{0};
+    std::atomic<uint64_t> num_contents_{0};
+    std::atomic<uint64_t> saved_bytes_{0};
+};
+
+}  // namespace mooncake
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Does the local copies of MemcpyWorkerPool.
+ *
+ * Engines other than the CPU one offload the copies to a DMA engine, and
+ * the worker waits for them without spinning, so that local transfers do
+ * not keep cores busy. Thread-safe.
+ */
+class CopyEngine {
+   public:
+    virtual ~CopyEngine() = default;
+
+    virtual const char* name() const = 0;
+
+    // Copies size bytes and returns once they are copied
+    virtual ErrorCode Copy(void* dest, const void* src, size_t size) = 0;
+
+    /**
+     * @brief Engine of the given name as set by MC_STORE_COPY_ENGINE, "cpu"
+     * or "cuda". Falls back to the CPU engine for unknown names and engines
+     * not built in.
+     */
+    static std::unique_ptr<CopyEngine> Create(const std::string& name);
+};
+
+class CpuCopyEngine : public CopyEngine {
+   public:
+    const char* name() const override { return "cpu"; }
+
+    ErrorCode Copy(void* dest, const void* src, size_t size) override;
+};
+
+#ifdef USE_CUDA
+/**
+ * @brief Copies with cudaMemcpyAsync on the copy engines of the GPU when
+ * either buffer is device memory or host memory registered with CUDA, and
+ * with the CPU otherwise.
+ */
+class CudaCopyEngine : public CopyEngine {
+   public:
+    const char* name() const override { return "cuda"; }
+
+    ErrorCode Copy(void* dest, const void* src, size_t size) override;
+};
+#endif
+
+}  // namespace mooncake
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mooncake {
+
+/**
+ * @brief CRC-32C (Castagnoli) of a buffer, continuing from the CRC of the
+ * data before it, so that the CRC of data in several slices is
+ * Crc32c(Crc32c(0, a, n), b, m).
+ *
+ * Uses the SSE4.2 or ARMv8 CRC instructions when the CPU has them, running
+ * three independent streams over large buffers to hide the latency of the
+ * instruction, and a table otherwise.
+ */
+uint32_t Crc32c(uint32_t crc, const void* data, size_t size);
+
+/**
+ * @brief Whether Crc32c runs on CRC instructions.
+ */
+bool Crc32cIsHardwareAccelerated();
+
+}  // namespace mooncake
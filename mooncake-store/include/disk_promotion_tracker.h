@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Re-reads of objects only held by disk replicas.
+ *
+ * A key read `reads` times within `window` of its first counted read becomes
+ * due for promotion into memory. A due key is reported once, and counted
+ * again only after its window passed. At most `capacity` keys are tracked,
+ * reads of further keys are ignored until Prune makes room.
+ *
+ * Thread-safe.
+ */
+class DiskPromotionTracker {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    DiskPromotionTracker(uint32_t reads, std::chrono::seconds window,
+                         size_t capacity);
+
+    // Count a read of a disk-only object, true if it made the key due
+    bool Record(const std::string& key, Clock::time_point now);
+
+    // Keys that became due since the last call
+    std::vector<std::string> TakeDue();
+
+    // Forget the keys whose window has passed
+    void Prune(Clock::time_point now);
+
+    size_t size() const;
+
+   private:
+    struct Reads {
+        Clock::time_point first_read;
+        uint32_t count{0};
+        bool due{false};
+    };
+
+    const uint32_t reads_;
+    const std::chrono::seconds window_;
+    const size_t capacity_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Reads> keys_;
+    std::vector<std::string> due_;
+};
+
+}  // namespace mooncake
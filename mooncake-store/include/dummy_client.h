@@ -84,8 +84,12 @@ class DummyClient : public PyClient {
 
     int register_buffer(void *buffer, size_t size);
 
+    int register_device_buffer(void *buffer, size_t size, int device_id);
+
     int unregister_buffer(void *buffer);
 
+    int invalidate_buffer(void *buffer, size_t size);
+
     int64_t get_into(const std::string &key, void *buffer, size_t size);
 
     std::vector<int64_t> batch_get_into(const std::vector<std::string> &keys,
@@ -101,6 +105,40 @@ class DummyClient : public PyClient {
     int put_from(const std::string &key, void *buffer, size_t size,
                  const ReplicateConfig &config = ReplicateConfig{});
 
+    void get_into_async(const std::string &key, void *buffer, size_t size,
+                        std::function<void(int64_t)> callback);
+
+    void batch_get_into_stream(const std::vector<std::string> &keys,
+                               const std::vector<void *> &buffers,
+                               const std::vector<size_t> &sizes,
+                               std::function<void(size_t, int64_t)> callback);
+
+    void put_from_async(const std::string &key, void *buffer, size_t size,
+                        const ReplicateConfig &config,
+                        std::function<void(int)> callback);
+
+    int64_t get_into_ranges(const std::string &key,
+                            const std::vector<void *> &buffers,
+                            const std::vector<size_t> &sizes);
+
+    int64_t get_object_ranges_into(const std::string &key,
+                                   const std::vector<uint64_t> &offsets,
+                                   const std::vector<void *> &buffers,
+                                   const std::vector<size_t> &sizes);
+
+    int put_from_ranges(const std::string &key,
+                        const std::vector<void *> &buffers,
+                        const std::vector<size_t> &sizes,
+                        const ReplicateConfig &config = ReplicateConfig{});
+
+    int broadcast_publish(const std::string &key, void *buffer, size_t size,
+                          size_t chunk_size,
+                          const ReplicateConfig &config = ReplicateConfig{});
+
+    int64_t broadcast_receive(const std::string &key, void *buffer,
+                              size_t size, int rank, int num_subscribers,
+                              int fanout, int64_t timeout_ms);
+
     int put_from_with_metadata(
         const std::string &key, void *buffer, void *metadata_buffer,
         size_t size, size_t metadata_size,
@@ -121,6 +159,9 @@ class DummyClient : public PyClient {
 
     std::tuple<uint64_t, size_t> get_buffer_info(const std::string &key);
 
+    std::tuple<uint64_t, size_t, uint64_t> get_zero_copy_info(
+        const std::string &key);
+
     std::vector<std::shared_ptr<BufferHandle>> batch_get_buffer(
         const std::vector<std::string> &keys);
 
@@ -144,6 +185,8 @@ class DummyClient : public PyClient {
 
     std::vector<int> batchIsExist(const std::vector<std::string> &keys);
 
+    int prefetch(const std::vector<std::string> &keys);
+
     int64_t getSize(const std::string &key);
 
     std::map<std::string, std::vector<Replica::Descriptor>>
@@ -164,9 +207,14 @@ class DummyClient : public PyClient {
    private:
     ErrorCode connect(const std::string &server_address);
 
+    int connect_ipc();
+
     int register_shm_via_ipc(const ShmHelper::ShmSegment *shm,
                              bool is_local = false);
 
+    // Maps the global segments of the real client read-only
+    int import_segments_via_ipc();
+
     /**
      * @brief Generic RPC invocation helper for single-result operations
      * @tparam ServiceMethod Pointer to WrappedMasterService member function
@@ -234,6 +282,16 @@ class DummyClient : public PyClient {
     ShmHelper *shm_helper_ = nullptr;
     std::string ipc_socket_path_;
 
+    // Global segments of the real client, for zero copy reads
+    struct ImportedSegment {
+        uint64_t real_base_addr = 0;
+        void *base = nullptr;
+        size_t size = 0;
+    };
+    std::mutex imported_segments_mutex_;
+    std::vector<ImportedSegment> imported_segments_;
+    bool segments_imported_ = false;
+
     // For high availability
     std::thread ping_thread_;
     std::atomic<bool> ping_running_{false};
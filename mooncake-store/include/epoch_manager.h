@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Epoch based reclamation for objects that are read without locks.
+ *
+ * A reader wraps its accesses in a Guard, which only writes to a cache line
+ * owned by the calling thread. A writer unlinks an object so that new
+ * readers cannot reach it anymore, and then hands it to Retire. The object
+ * is deleted once every reader that entered before the unlink has left its
+ * guard.
+ *
+ * Writers are expected to be rare compared to readers.
+ */
+class EpochManager {
+    struct ReaderRecord;
+
+   public:
+    // Marks the calling thread as reading lock-free objects. Guards of the
+    // same thread may be nested.
+    class Guard {
+       public:
+        explicit Guard(EpochManager& manager);
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+       private:
+        ReaderRecord* record_;
+    };
+
+    static EpochManager& instance();
+
+    ~EpochManager();
+
+    /**
+     * @brief Delete an unlinked object once no reader can access it.
+     * Must not be called inside a Guard.
+     */
+    void Retire(std::function<void()> deleter);
+
+    // Delete the retired objects that are no longer accessible
+    void Reclaim();
+
+   private:
+    EpochManager() = default;
+
+    ReaderRecord* AcquireRecord();
+
+    struct Retired {
+        uint64_t epoch;
+        std::function<void()> deleter;
+    };
+
+    static constexpr size_t kReclaimThreshold = 64;
+
+    std::atomic<uint64_t> global_epoch_{1};
+    // Records are never freed, the record of an exited thread is reused
+    std::atomic<ReaderRecord*> records_{nullptr};
+
+    std::mutex retired_mutex_;
+    std::vector<Retired> retired_;
+};
+
+}  // namespace mooncake
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Systematic Reed-Solomon code over GF(2^8) with k data chunks and m
+ * parity chunks. Any k of the k + m chunks recover the data.
+ *
+ * Parity chunk j is sum_i C[j][i] * data_i, where C is a Cauchy matrix, so
+ * that every k x k submatrix of [I; C] is invertible. The sum is linear, so
+ * a data chunk can be encoded piece by piece as its bytes become available,
+ * e.g. when it spans several slices.
+ *
+ * All chunks have the same size, a shorter last data chunk is encoded as if
+ * padded with zeros. Thread-safe once constructed.
+ */
+class ReedSolomonCode {
+   public:
+    static constexpr size_t kMaxChunks = 256;
+
+    // Requires 0 < data_chunks and data_chunks + parity_chunks <= kMaxChunks
+    ReedSolomonCode(size_t data_chunks, size_t parity_chunks);
+
+    size_t data_chunks() const { return data_chunks_; }
+    size_t parity_chunks() const { return parity_chunks_; }
+
+    /**
+     * @brief Add length bytes of data chunk data_index, starting at offset
+     * within the chunk, into the parity chunks. The parity chunks must be
+     * zeroed before the first call.
+     */
+    void Encode(size_t data_index, const uint8_t* data, size_t length,
+                size_t offset, const std::vector<uint8_t*>& parity) const;
+
+    /**
+     * @brief Rebuild the missing data chunks in place.
+     * @param chunks the k + m chunks of chunk_size bytes, data chunks first
+     * @param present whether each chunk holds valid content
+     * @return false if fewer than k chunks are present
+     */
+    bool Reconstruct(const std::vector<uint8_t*>& chunks,
+                     const std::vector<bool>& present,
+                     size_t chunk_size) const;
+
+   private:
+    // dst[i] ^= coefficient * src[i]
+    static void MulAdd(uint8_t coefficient, const uint8_t* src, uint8_t* dst,
+                       size_t length);
+
+    const size_t data_chunks_;
+    const size_t parity_chunks_;
+    // Cauchy part of the generator matrix, parity_chunks x data_chunks
+    std::vector<uint8_t> parity_matrix_;
+};
+
+}  // namespace mooncake
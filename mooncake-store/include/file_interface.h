@@ -8,8 +8,19 @@
 #include <atomic>
 #include <thread>
 #include <sys/file.h>
+#include <vector>
 
 namespace mooncake {
+
+/**
+ * @brief One contiguous read of a batch, see StorageFile::batch_read
+ */
+struct FileReadRequest {
+    void *buffer;
+    size_t length;
+    off_t offset;
+};
+
 class FileLockRAII {
    public:
     enum class LockType { READ, WRITE };
@@ -122,6 +133,26 @@ class StorageFile {
                                                         int iovcnt,
                                                         off_t offset) = 0;
 
+    /**
+     * @brief Reads all the requests, which may be served concurrently
+     * @return FILE_READ_FAIL if any request is not read in full
+     * @note The default implementation reads them one by one
+     */
+    virtual tl::expected<void, ErrorCode> batch_read(
+        const std::vector<FileReadRequest> &requests) {
+        for (const auto &request : requests) {
+            iovec iov{request.buffer, request.length};
+            auto result = vector_read(&iov, 1, request.offset);
+            if (!result) {
+                return tl::make_unexpected(result.error());
+            }
+            if (result.value() != request.length) {
+                return make_error<void>(ErrorCode::FILE_READ_FAIL);
+            }
+        }
+        return {};
+    }
+
     template <typename T>
     tl::expected<T, ErrorCode> make_error(ErrorCode code) {
         error_code_ = code;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <condition_variable>
+
 #include "client_service.h"
 #include "client_buffer.hpp"
 #include "storage_backend.h"
@@ -17,14 +19,27 @@ class FileStorage {
     /**
      * @brief Reads multiple key-value (KV) entries from local storage and
      * forwards them to a remote node.
+     *
+     * The values are staged in the client buffer, which stays leased to the
+     * batch until ReleaseBatch is called with its id, or until the lease of
+     * client_buffer_gc_ttl_ms expires. When the client buffer is full, waits
+     * up to client_buffer_wait_timeout_ms for leased batches to be released.
      * @param keys                 List of keys to read from the local KV store
      * @param sizes                Expected size in bytes for each value
+     * @param batch_id             Set to the id of the leased batch
      * @return tl::expected<std::vector<uint64_t>, ErrorCode> indicating
      * operation status.
      */
     tl::expected<std::vector<uint64_t>, ErrorCode> BatchGet(
         const std::vector<std::string>& keys,
-        const std::vector<int64_t>& sizes);
+        const std::vector<int64_t>& sizes, uint64_t& batch_id);
+
+    /**
+     * @brief Returns the client buffer of a batch read by BatchGet once the
+     * remote node has transferred it. Unknown ids, e.g. of expired leases,
+     * are ignored.
+     */
+    void ReleaseBatch(uint64_t batch_id);
 
     FileStorageConfig config_;
 
@@ -60,9 +75,18 @@ class FileStorage {
      * client.
      * 2. Receives feedback on which objects should be offloaded.
      * 3. Triggers asynchronous offloading of pending objects.
-     * @return tl::expected<void, ErrorCode> indicating operation status.
+     * @return The number of objects the master asked to offload.
      */
-    tl::expected<void, ErrorCode> Heartbeat();
+    tl::expected<size_t, ErrorCode> Heartbeat();
+
+    /**
+     * @brief The pause before the next heartbeat: none while the master
+     * returns full batches, heartbeat_interval_seconds after a batch, and
+     * doubling up to heartbeat_max_interval_seconds while there is nothing
+     * to offload.
+     */
+    uint32_t NextHeartbeatInterval(uint32_t interval_seconds,
+                                   size_t received_objects) const;
 
     tl::expected<bool, ErrorCode> IsEnableOffloading();
 
@@ -75,26 +99,40 @@ class FileStorage {
 
     tl::expected<void, ErrorCode> RegisterLocalMemory();
 
+    /**
+     * @brief Allocates the client buffer of a batch, waiting for leased
+     * batches to be released when it is full. The buffer returns to the
+     * allocator as soon as the last reference to the batch is dropped.
+     */
     tl::expected<std::shared_ptr<AllocatedBatch>, ErrorCode> AllocateBatch(
         const std::vector<std::string>& keys,
         const std::vector<int64_t>& sizes);
 
-    void ClientBufferGCThreadFunc();
+    // Drops the leases that have expired, returns the batches so that the
+    // caller frees them without holding client_buffer_mutex_
+    std::vector<std::shared_ptr<AllocatedBatch>> TakeExpiredBatches()
+        REQUIRES(client_buffer_mutex_);
 
     std::shared_ptr<Client> client_;
     std::string local_rpc_addr_;
     std::shared_ptr<StorageBackendInterface> storage_backend_;
     std::shared_ptr<ClientBufferAllocator> client_buffer_allocator_;
     mutable Mutex client_buffer_mutex_;
-    std::vector<std::shared_ptr<AllocatedBatch>> GUARDED_BY(
-        client_buffer_mutex_) client_buffer_allocated_batches_;
+    // Signalled, with client_buffer_release_seq_ bumped, whenever a batch
+    // returns its buffer
+    std::condition_variable_any client_buffer_released_cv_;
+    uint64_t GUARDED_BY(client_buffer_mutex_) client_buffer_release_seq_ = 0;
+    uint64_t GUARDED_BY(client_buffer_mutex_) next_batch_id_ = 1;
+    std::unordered_map<uint64_t, std::shared_ptr<AllocatedBatch>> GUARDED_BY(
+        client_buffer_mutex_) client_buffer_leased_batches_;
 
     mutable Mutex offloading_mutex_;
     bool GUARDED_BY(offloading_mutex_) enable_offloading_;
     std::atomic<bool> heartbeat_running_;
+    // Wakes the heartbeat thread up for shutdown
+    Mutex heartbeat_mutex_;
+    std::condition_variable_any heartbeat_cv_;
     std::thread heartbeat_thread_;
-    std::atomic<bool> client_buffer_gc_running_;
-    std::thread client_buffer_gc_thread_;
 };
 
 }  // namespace mooncake
\ No newline at end of file
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mooncake {
+
+struct NoopMemoryTracker {
+    static void Add(int64_t) {}
+};
+
+/**
+ * @brief Notified of the keys inserted into and erased from a FlatKeyMap,
+ * e.g. to maintain a secondary index over the keys.
+ */
+class FlatKeyMapObserver {
+   public:
+    virtual ~FlatKeyMapObserver() = default;
+    virtual void OnInsert(const std::string& key) = 0;
+    virtual void OnErase(const std::string& key) = 0;
+};
+
+/**
+ * @brief Open-addressing map from string keys to values, used as the key
+ * index of the master metadata.
+ *
+ * Compared to std::unordered_map it avoids a heap allocation and a pointer
+ * chase per key on lookups:
+ * - The index is a flat array of {hash, entry} slots with linear probing.
+ *   The full hash is kept in the slot, so probing compares hashes and only
+ *   touches the entry of the key that matches.
+ * - Entries are allocated from chunks of a per-map pool and recycled on
+ *   erase. Short keys stay inline thanks to the small string optimization.
+ *
+ * Entries never move, so references to values stay valid until the entry is
+ * erased. Iterators are invalidated by inserts, like the ones of
+ * std::unordered_map on rehash. Erasing does not invalidate other iterators.
+ *
+ * The interface is the subset of std::unordered_map used by the master.
+ * MemoryTracker::Add is called with the change of memory_usage().
+ *
+ * Not thread-safe.
+ */
+template <typename V, typename MemoryTracker = NoopMemoryTracker>
+class FlatKeyMap {
+   public:
+    using key_type = std::string;
+    using mapped_type = V;
+    using value_type = std::pair<const std::string, V>;
+
+   private:
+    struct Slot {
+        size_t hash;
+        // nullptr if empty, Tombstone() if the entry was erased
+        value_type* entry;
+    };
+
+    static value_type* Tombstone() {
+        return reinterpret_cast<value_type*>(alignof(value_type));
+    }
+
+    static bool IsOccupied(const Slot& slot) {
+        return slot.entry != nullptr && slot.entry != Tombstone();
+    }
+
+    template <bool kConst>
+    class Iterator {
+        using MapPtr =
+            std::conditional_t<kConst, const FlatKeyMap*, FlatKeyMap*>;
+
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = FlatKeyMap::value_type;
+        using pointer =
+            std::conditional_t<kConst, const value_type*, value_type*>;
+        using reference =
+            std::conditional_t<kConst, const value_type&, value_type&>;
+
+        Iterator() = default;
+        Iterator(MapPtr map, size_t index) : map_(map), index_(index) {}
+
+        // iterator -> const_iterator
+        template <bool kToConst = true,
+                  typename = std::enable_if_t<kToConst && !kConst>>
+        operator Iterator<kToConst>() const {
+            return Iterator<kToConst>(map_, index_);
+        }
+
+        reference operator*() const { return *map_->slots_[index_].entry; }
+        pointer operator->() const { return map_->slots_[index_].entry; }
+
+        Iterator& operator++() {
+            index_ = map_->NextOccupied(index_ + 1);
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+        bool operator!=(const Iterator& other) const {
+            return index_ != other.index_;
+        }
+
+       private:
+        friend class FlatKeyMap;
+
+        MapPtr map_{nullptr};
+        size_t index_{0};
+    };
+
+   public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatKeyMap() = default;
+    ~FlatKeyMap() {
+        clear();
+        MemoryTracker::Add(-static_cast<int64_t>(memory_usage_));
+    }
+
+    FlatKeyMap(const FlatKeyMap&) = delete;
+    FlatKeyMap& operator=(const FlatKeyMap&) = delete;
+
+    iterator begin() { return iterator(this, NextOccupied(0)); }
+    iterator end() { return iterator(this, slots_.size()); }
+    const_iterator begin() const {
+        return const_iterator(this, NextOccupied(0));
+    }
+    const_iterator end() const { return const_iterator(this, slots_.size()); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * @brief Bytes used by the index and the entries, including the heap
+     * buffers of the keys. Memory owned by the values is not included.
+     */
+    size_t memory_usage() const { return memory_usage_; }
+
+    /**
+     * @brief Set the observer of inserted and erased keys, nullptr to
+     * detach. Keys already in the map are not reported.
+     */
+    void set_observer(FlatKeyMapObserver* observer) { observer_ = observer; }
+
+    iterator find(const std::string& key) {
+        return iterator(this, FindIndex(key, Hash(key)));
+    }
+
+    const_iterator find(const std::string& key) const {
+        return const_iterator(this, FindIndex(key, Hash(key)));
+    }
+
+    bool contains(const std::string& key) const { return find(key) != end(); }
+
+    template <typename... KeyArgs, typename... ValueArgs>
+    std::pair<iterator, bool> emplace(std::piecewise_construct_t,
+                                      std::tuple<KeyArgs...> key_args,
+                                      std::tuple<ValueArgs...> value_args) {
+        std::string key =
+            std::make_from_tuple<std::string>(std::move(key_args));
+        const size_t hash = Hash(key);
+        size_t index = FindIndex(key, hash);
+        if (index != slots_.size()) {
+            return {iterator(this, index), false};
+        }
+
+        ReserveForInsert();
+        void* storage = AllocateEntry();
+        value_type* entry;
+        try {
+            entry = new (storage)
+                value_type(std::piecewise_construct,
+                           std::forward_as_tuple(std::move(key)),
+                           std::move(value_args));
+        } catch (...) {
+            FreeEntry(storage);
+            throw;
+        }
+
+        index = hash & (slots_.size() - 1);
+        while (IsOccupied(slots_[index])) {
+            index = (index + 1) & (slots_.size() - 1);
+        }
+        if (slots_[index].entry == Tombstone()) {
+            tombstones_--;
+        }
+        slots_[index] = {hash, entry};
+        size_++;
+        AddMemory(KeyHeapBytes(entry->first));
+        if (observer_) {
+            observer_->OnInsert(entry->first);
+        }
+        return {iterator(this, index), true};
+    }
+
+    iterator erase(const_iterator pos) {
+        Slot& slot = slots_[pos.index_];
+        if (observer_) {
+            observer_->OnErase(slot.entry->first);
+        }
+        AddMemory(-static_cast<int64_t>(KeyHeapBytes(slot.entry->first)));
+        slot.entry->~value_type();
+        FreeEntry(slot.entry);
+        slot.entry = Tombstone();
+        tombstones_++;
+        size_--;
+        return iterator(this, NextOccupied(pos.index_ + 1));
+    }
+
+    iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+    size_t erase(const std::string& key) {
+        auto it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    void clear() {
+        for (auto& slot : slots_) {
+            if (IsOccupied(slot)) {
+                if (observer_) {
+                    observer_->OnErase(slot.entry->first);
+                }
+                AddMemory(
+                    -static_cast<int64_t>(KeyHeapBytes(slot.entry->first)));
+                slot.entry->~value_type();
+                FreeEntry(slot.entry);
+            }
+            slot = {0, nullptr};
+        }
+        size_ = 0;
+        tombstones_ = 0;
+    }
+
+   private:
+    static constexpr size_t kInitialCapacity = 16;
+    static constexpr size_t kEntriesPerChunk = 64;
+
+    // Storage of an entry, a free entry holds the next free one
+    union EntryStorage {
+        EntryStorage* next_free;
+        alignas(value_type) unsigned char bytes[sizeof(value_type)];
+    };
+
+    static size_t Hash(const std::string& key) {
+        // Keys of the same metadata shard share the low bits of
+        // std::hash, mix them before they select the slot.
+        uint64_t h = std::hash<std::string>{}(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static size_t KeyHeapBytes(const std::string& key) {
+        // Inline keys need no extra memory
+        return key.capacity() > std::string().capacity() ? key.capacity() + 1
+                                                         : 0;
+    }
+
+    void AddMemory(int64_t delta) {
+        memory_usage_ += delta;
+        MemoryTracker::Add(delta);
+    }
+
+    size_t NextOccupied(size_t index) const {
+        while (index < slots_.size() && !IsOccupied(slots_[index])) {
+            index++;
+        }
+        return index;
+    }
+
+    // Returns slots_.size() if not found
+    size_t FindIndex(const std::string& key, size_t hash) const {
+        if (size_ == 0) {
+            return slots_.size();
+        }
+        const size_t mask = slots_.size() - 1;
+        for (size_t index = hash & mask;; index = (index + 1) & mask) {
+            const Slot& slot = slots_[index];
+            if (slot.entry == nullptr) {
+                return slots_.size();
+            }
+            if (slot.hash == hash && slot.entry != Tombstone() &&
+                slot.entry->first == key) {
+                return index;
+            }
+        }
+    }
+
+    void ReserveForInsert() {
+        // Keep the load factor including tombstones below 7/8, so that
+        // probing always ends at an empty slot.
+        if ((size_ + tombstones_ + 1) * 8 <= slots_.size() * 7) {
+            return;
+        }
+        size_t capacity = std::max(slots_.size(), kInitialCapacity);
+        while ((size_ + 1) * 2 > capacity) {
+            capacity *= 2;
+        }
+        Rehash(capacity);
+    }
+
+    void Rehash(size_t capacity) {
+        std::vector<Slot> old_slots(capacity, Slot{0, nullptr});
+        old_slots.swap(slots_);
+        AddMemory(static_cast<int64_t>(slots_.size() * sizeof(Slot)) -
+                  static_cast<int64_t>(old_slots.size() * sizeof(Slot)));
+        tombstones_ = 0;
+
+        const size_t mask = slots_.size() - 1;
+        for (const auto& slot : old_slots) {
+            if (!IsOccupied(slot)) {
+                continue;
+            }
+            size_t index = slot.hash & mask;
+            while (slots_[index].entry != nullptr) {
+                index = (index + 1) & mask;
+            }
+            slots_[index] = slot;
+        }
+    }
+
+    void* AllocateEntry() {
+        if (!free_entries_) {
+            auto chunk = std::make_unique<EntryStorage[]>(kEntriesPerChunk);
+            for (size_t i = 0; i < kEntriesPerChunk; i++) {
+                chunk[i].next_free = free_entries_;
+                free_entries_ = &chunk[i];
+            }
+            chunks_.push_back(std::move(chunk));
+            AddMemory(kEntriesPerChunk * sizeof(EntryStorage));
+        }
+        EntryStorage* storage = free_entries_;
+        free_entries_ = storage->next_free;
+        return storage->bytes;
+    }
+
+    void FreeEntry(void* entry) {
+        auto* storage = reinterpret_cast<EntryStorage*>(entry);
+        storage->next_free = free_entries_;
+        free_entries_ = storage;
+    }
+
+    std::vector<Slot> slots_;
+    size_t size_{0};
+    size_t tombstones_{0};
+
+    std::vector<std::unique_ptr<EntryStorage[]>> chunks_;
+    EntryStorage* free_entries_{nullptr};
+    size_t memory_usage_{0};
+    FlatKeyMapObserver* observer_{nullptr};
+};
+
+}  // namespace mooncake
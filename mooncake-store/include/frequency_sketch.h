@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace mooncake {
+
+/**
+ * @brief Count-min sketch of access frequencies, used by the LFU eviction
+ * policy.
+ *
+ * Keeps 4-bit saturating counters in kDepth rows indexed by the key hash,
+ * the estimate of a key is the minimum of its counters. Once
+ * kSampleFactor * width accesses are recorded, Age halves all counters so
+ * that the history of keys that turned cold fades away. The counters are
+ * independent of the objects, so keys keep their history across eviction.
+ *
+ * Thread-safe and lock-free. Concurrent updates may be lost, which only
+ * makes the estimates slightly lower.
+ */
+class FrequencySketch {
+   public:
+    // width is rounded up to a power of two
+    explicit FrequencySketch(size_t width);
+
+    FrequencySketch(const FrequencySketch&) = delete;
+    FrequencySketch& operator=(const FrequencySketch&) = delete;
+
+    void Increment(size_t key_hash);
+
+    uint8_t Estimate(size_t key_hash) const;
+
+    /**
+     * @brief Halves every counter if enough accesses were recorded since
+     * the last time. Walks all the counters, so it is called from a
+     * background thread rather than by Increment.
+     * @return Whether the counters were halved
+     */
+    bool Age();
+
+    static constexpr uint8_t kMaxCount = 15;
+
+   private:
+    static constexpr size_t kDepth = 4;
+    static constexpr size_t kSampleFactor = 10;
+
+    size_t Index(size_t key_hash, size_t row) const;
+
+    const size_t width_;
+    const size_t sample_size_;
+    std::unique_ptr<std::atomic<uint8_t>[]> counters_;
+    std::atomic<size_t> num_increments_{0};
+};
+
+}  // namespace mooncake
@@ -0,0 +1,54 @@
+#pragma once
+
+#ifdef STORE_USE_GDS
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "file_interface.h"
+
+namespace mooncake {
+
+/**
+ * @class GdsFile
+ * @brief PosixFile that reads into and writes from GPU memory with
+ * GPUDirect Storage (cuFile), without a copy through host memory.
+ *
+ * Host buffers use the plain fd. Device buffers use the cuFile handle of
+ * direct_fd, the file opened with O_DIRECT; without one, or if cuFile is
+ * unavailable, they are staged through a host buffer.
+ */
+class GdsFile : public PosixFile {
+   public:
+    /**
+     * @param direct_fd The same file opened with O_DIRECT, or -1. Owned.
+     */
+    GdsFile(const std::string &filename, int fd, int direct_fd = -1);
+    ~GdsFile() override;
+
+    tl::expected<size_t, ErrorCode> vector_write(const iovec *iov, int iovcnt,
+                                                 off_t offset) override;
+    tl::expected<size_t, ErrorCode> vector_read(const iovec *iov, int iovcnt,
+                                                off_t offset) override;
+
+    static bool IsDeviceMemory(const void *ptr);
+
+   private:
+    // Returns the bytes transferred, short only at the end of the file
+    tl::expected<size_t, ErrorCode> ReadDevice(void *dst, size_t length,
+                                               off_t offset);
+    tl::expected<size_t, ErrorCode> WriteDevice(const void *src,
+                                                size_t length, off_t offset);
+    tl::expected<size_t, ErrorCode> ReadHost(void *dst, size_t length,
+                                             off_t offset);
+    tl::expected<size_t, ErrorCode> WriteHost(const void *src, size_t length,
+                                              off_t offset);
+
+    int direct_fd_;
+    void *handle_ = nullptr;  // CUfileHandle_t of direct_fd_
+};
+
+}  // namespace mooncake
+
+#endif  // STORE_USE_GDS
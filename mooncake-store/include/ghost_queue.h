@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace mooncake {
+
+/**
+ * @brief Ghost queue of the S3FIFO eviction policy, remembering the hashes
+ * of keys evicted from the small queue so that they skip it when they are
+ * put again.
+ *
+ * A direct-mapped table of key hashes: a newer key overwrites an older one
+ * in the same slot, which approximates the FIFO order of the queue without
+ * keeping one. Holds no keys, so it costs one word per slot however long
+ * the keys are.
+ *
+ * Thread-safe and lock-free. A collision may drop a ghost early or, with a
+ * 64-bit hash, very rarely let a key in that was never evicted.
+ */
+class GhostQueue {
+   public:
+    // capacity is rounded up to a power of two
+    explicit GhostQueue(size_t capacity);
+
+    GhostQueue(const GhostQueue&) = delete;
+    GhostQueue& operator=(const GhostQueue&) = delete;
+
+    void Insert(size_t key_hash);
+
+    /**
+     * @brief Removes the key from the queue.
+     * @return Whether the key was in the queue
+     */
+    bool Remove(size_t key_hash);
+
+   private:
+    size_t Index(size_t key_hash) const;
+    // Never 0, which marks an empty slot
+    static size_t Tag(size_t key_hash) { return key_hash | 1; }
+
+    const size_t capacity_;
+    std::unique_ptr<std::atomic<size_t>[]> slots_;
+};
+
+}  // namespace mooncake
@@ -4,8 +4,12 @@
 #include <csignal>
 #include <glog/logging.h>
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <ylt/coro_rpc/coro_rpc_server.hpp>
 
 #include "types.h"
@@ -40,9 +44,11 @@ class MasterViewHelper {
      * @param master_address: The ip:port address of the master to be elected.
      * @param version: Output param, the version of the new master view.
      * @param lease_id: Output param, the lease id of the leader.
+     * @param lease_ttl: The ttl of the lease of the leader, in seconds.
      */
     void ElectLeader(const std::string& master_address, ViewVersionId& version,
-                     EtcdLeaseId& lease_id);
+                     EtcdLeaseId& lease_id,
+                     int64_t lease_ttl = ETCD_MASTER_VIEW_LEASE_TTL);
 
     /*
      * @brief Keep the master to be the leader. This function blocks until the
@@ -64,6 +70,59 @@ class MasterViewHelper {
     std::string master_view_key_;
 };
 
+/*
+ * @brief Watches the master view in etcd and tells its subscribers about
+ *        every newly elected leader, as soon as the leader is written to
+ *        etcd. There is one watcher per process, shared by all clients,
+ *        because etcd allows one watch per key in a process. The etcd
+ *        client must be connected before the first subscription.
+ */
+class MasterViewWatcher {
+   public:
+    using Callback = std::function<void(const std::string& master_address,
+                                        ViewVersionId version)>;
+
+    static MasterViewWatcher& Instance();
+
+    MasterViewWatcher(const MasterViewWatcher&) = delete;
+    MasterViewWatcher& operator=(const MasterViewWatcher&) = delete;
+
+    /*
+     * @brief Subscribe to leader changes, starting the watch if needed. The
+     *        callback runs on the etcd watch thread and must not block.
+     * @return: The id to unsubscribe with.
+     */
+    uint64_t Subscribe(Callback callback);
+
+    /*
+     * @brief Unsubscribe, stopping the watch after the last subscriber.
+     *        The callback is not called anymore once this returns.
+     */
+    void Unsubscribe(uint64_t id);
+
+   private:
+    MasterViewWatcher();
+
+    static void OnWatchEvent(void* context, const char* key, size_t key_size,
+                             const char* value, size_t value_size,
+                             int event_type, int64_t revision);
+    void Notify(const std::string& master_address, ViewVersionId version);
+    // Restarts the etcd watch whenever it breaks, until no one subscribes
+    void WatchThreadMain();
+
+    const std::string master_view_key_;
+    // Serializes starting and stopping the watch thread
+    std::mutex subscribe_mutex_;
+    std::thread watch_thread_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<uint64_t, Callback> callbacks_;
+    uint64_t next_id_ = 0;
+    bool watch_broken_ = false;
+    ViewVersionId last_version_ = 0;
+};
+
 /*
  * @brief A supervisor class for the master service, only used in HA mode.
  *        This class will continuously do the following procedures after start:
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <vector>
 #include <thread>
 #include <hf3fs_usrbio.h>
 #include "types.h"
@@ -19,6 +21,10 @@ struct Hf3fsConfig {
     std::string mount_root = "/";  // Mount point root directory
     size_t iov_size = 32 << 20;    // Shared memory size (32MB)
     size_t ior_entries = 16;       // Maximum number of requests in IO ring
+    // Largest single I/O. An operation is split into I/Os of this size that
+    // are submitted together, as many as fit in the iov and the ring, so
+    // that the storage servers serve them in parallel.
+    size_t io_block_size = 4 << 20;
     //`0` for no control with I/O depth.
     // If greater than 0, then only when `io_depth` I/O requests are in queue,
     // they will be issued to server as a batch. If smaller than 0, then USRBIO
@@ -27,6 +33,10 @@ struct Hf3fsConfig {
     // prepared I/O requests to server ASAP.
     size_t io_depth = 0;  // IO batch processing depth
     int ior_timeout = 0;  // IO timeout (milliseconds)
+
+    // Defaults, overridden by MC_STORE_3FS_IOV_SIZE, MC_STORE_3FS_IOR_ENTRIES
+    // and MC_STORE_3FS_IO_BLOCK_SIZE
+    static Hf3fsConfig FromEnv(const std::string &mount_root);
 };
 
 class USRBIOResourceManager {
@@ -79,6 +89,24 @@ struct ThreadUSRBIOResource {
     // Cleanup resource
     void Cleanup();
 
+    struct IoRange {
+        off_t offset;
+        size_t length;
+    };
+
+    /**
+     * Reads or writes the ranges of fd through the iov, split into blocks
+     * that are submitted together, as many as fit in the iov and the ring.
+     * copy(iov_buffer, range, position, size) moves the bytes at position
+     * of the range between the iov and the caller's buffers, in order of
+     * position within a range: before the I/O for a write, after it for a
+     * read. Returns the bytes done of each range, less than its length if a
+     * read reaches the end of the file or a write is short.
+     */
+    tl::expected<std::vector<size_t>, ErrorCode> BatchIO(
+        int fd, bool read, const std::vector<IoRange> &ranges,
+        const std::function<void(char *, size_t, size_t, size_t)> &copy);
+
     ~ThreadUSRBIOResource() { Cleanup(); }
 };
 
@@ -99,6 +127,13 @@ class ThreeFSFile : public StorageFile {
     tl::expected<size_t, ErrorCode> vector_read(const iovec *iov, int iovcnt,
                                                 off_t offset) override;
 
+    /**
+     * Reads the blocks of all the requests in the same submissions, so
+     * that many small objects of a file are read in parallel.
+     */
+    tl::expected<void, ErrorCode> batch_read(
+        const std::vector<FileReadRequest> &requests) override;
+
    private:
     USRBIOResourceManager *resource_manager_;
 };
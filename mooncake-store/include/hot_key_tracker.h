@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Top-N most read keys, counted by a count-min sketch.
+ *
+ * Every read increments kDepth counters of the key, its estimate is the
+ * minimum of them. Keys whose estimate beats the coldest key of the full
+ * top-N list replace it. Once kSampleFactor * width reads are recorded, all
+ * counts are halved so that the list follows the keys that are hot now.
+ *
+ * Thread-safe. The sketch is lock-free, the list is only locked for keys
+ * hot enough to enter it.
+ */
+class HotKeyTracker {
+   public:
+    struct HotKey {
+        std::string key;
+        uint64_t count;  // estimated reads, decayed
+    };
+
+    // width is rounded up to a power of two
+    HotKeyTracker(size_t top_n, size_t width);
+
+    HotKeyTracker(const HotKeyTracker&) = delete;
+    HotKeyTracker& operator=(const HotKeyTracker&) = delete;
+
+    void Record(const std::string& key, size_t key_hash);
+
+    // Hottest first
+    std::vector<HotKey> TopKeys() const;
+
+   private:
+    static constexpr size_t kDepth = 4;
+    static constexpr size_t kSampleFactor = 10;
+
+    size_t Index(size_t key_hash, size_t row) const;
+
+    // Halve every counter and the counts of the list
+    void Decay();
+
+    const size_t top_n_;
+    const size_t width_;
+    const size_t sample_size_;
+    std::unique_ptr<std::atomic<uint32_t>[]> counters_;
+    std::atomic<size_t> num_records_{0};
+    // Count of the coldest key once the list is full, 0 before
+    std::atomic<uint64_t> admit_count_{0};
+
+    mutable std::mutex mutex_;
+    std::vector<HotKey> top_keys_;  // unordered
+};
+
+}  // namespace mooncake
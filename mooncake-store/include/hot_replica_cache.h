@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "replica.h"
+#include "rpc_types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Lock-free read path for the replica lists of frequently read keys.
+ *
+ * A slow path read of a key, done under the shard read lock, publishes an
+ * immutable snapshot of the replica descriptors together with the lease it
+ * granted. Later reads of the key are answered from the snapshot without
+ * touching the shard lock, as long as enough of that lease is left. The
+ * snapshots are reclaimed through EpochManager.
+ *
+ * Every write lock taken on a shard invalidates the snapshots of that shard,
+ * so a snapshot never outlives a mutation of its object.
+ */
+class HotReplicaCache {
+   public:
+    // num_slots = 0 disables the cache
+    HotReplicaCache(size_t num_slots, size_t num_shards);
+    ~HotReplicaCache();
+
+    HotReplicaCache(const HotReplicaCache&) = delete;
+    HotReplicaCache& operator=(const HotReplicaCache&) = delete;
+
+    bool enabled() const { return !slots_.empty(); }
+
+    // Must be read before the object is looked up on the slow path and be
+    // passed to Publish.
+    uint64_t generation() const {
+        return generation_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Lock-free lookup. The returned lease ttl is what is left of the
+     * lease granted on publication, at least min_lease_ms.
+     */
+    std::optional<GetReplicaListResponse> Get(const std::string& key,
+                                              size_t key_hash,
+                                              size_t shard_idx,
+                                              uint64_t min_lease_ms) const;
+
+    /**
+     * @brief Publish the complete replicas of a key. The caller must hold
+     * the read lock of the shard, and lease_timeout must not be later than
+     * the lease granted to the object.
+     */
+    void Publish(const std::string& key, size_t key_hash, size_t shard_idx,
+                 uint64_t generation,
+                 const std::vector<Replica::Descriptor>& replicas,
+                 std::chrono::steady_clock::time_point lease_timeout);
+
+    // Called with the write lock of the shard held, before it is modified
+    void InvalidateShard(size_t shard_idx) {
+        if (enabled()) {
+            shard_versions_[shard_idx].value.fetch_add(
+                1, std::memory_order_acq_rel);
+        }
+    }
+
+    // Invalidate every snapshot, e.g. when a segment is being unmounted
+    void InvalidateAll() {
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+   private:
+    struct Entry {
+        std::string key;
+        std::vector<Replica::Descriptor> replicas;
+        std::chrono::steady_clock::time_point lease_timeout;
+        uint64_t shard_version;
+        uint64_t generation;
+    };
+
+    // Written on shard writes only, keep them off the lines of other shards
+    struct alignas(64) ShardVersion {
+        std::atomic<uint64_t> value{0};
+    };
+
+    size_t SlotIndex(size_t key_hash) const;
+
+    std::vector<std::atomic<Entry*>> slots_;
+    std::vector<ShardVersion> shard_versions_;
+    std::atomic<uint64_t> generation_{0};
+};
+
+}  // namespace mooncake
@@ -1,15 +1,43 @@
 #ifndef MOONCAKE_HTTP_METADATA_SERVER_H
 #define MOONCAKE_HTTP_METADATA_SERVER_H
 
+#include <array>
 #include <csignal>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
-#include <mutex>
+#include <vector>
 
 #include <ylt/coro_http/coro_http_server.hpp>
+#include <ylt/struct_json/json_reader.h>
+#include <ylt/struct_json/json_writer.h>
 
 namespace mooncake {
 
+// Body of POST /metadata/batch_get
+struct MetadataBatchGetRequest {
+    std::vector<std::string> keys;
+    YLT_REFL(MetadataBatchGetRequest, keys);
+};
+
+// Reply to POST /metadata/batch_get, keys that are not found are left out
+struct MetadataBatchGetResponse {
+    std::unordered_map<std::string, std::string> values;
+    YLT_REFL(MetadataBatchGetResponse, values);
+};
+
+struct MetadataEntry {
+    std::string key;
+    std::string value;
+    YLT_REFL(MetadataEntry, key, value);
+};
+
+// Body of POST /metadata/batch_put, the entries are stored in order
+struct MetadataBatchPutRequest {
+    std::vector<MetadataEntry> entries;
+    YLT_REFL(MetadataBatchPutRequest, entries);
+};
+
 enum class KVPoll {
     Failed = 0,
     Bootstrapping = 1,
@@ -42,11 +70,27 @@ class HttpMetadataServer {
    private:
     void init_server();
 
+    static constexpr size_t kNumShards = 64;
+
+    // Readers of different keys, and of the same key, run concurrently
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::string> entries;
+    };
+
+    Shard& shard_of(const std::string& key) const;
+
+    bool get(const std::string& key, std::string& value) const;
+
+    // Fails only for a duplicate rpc_meta key
+    bool put(const std::string& key, std::string value);
+
+    bool remove(const std::string& key);
+
     uint16_t port_;
     std::string host_;
     std::unique_ptr<coro_http::coro_http_server> server_;
-    std::unordered_map<std::string, std::string> store_;
-    mutable std::mutex store_mutex_;
+    mutable std::array<Shard, kNumShards> shards_;
     bool running_;
 };
 
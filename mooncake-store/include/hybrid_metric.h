@@ -252,12 +252,31 @@ class basic_hybrid_histogram : public dynamic_metric {
 
     void observe(const std::array<std::string, N>& labels_value,
                  value_type value) {
-        const auto bucket_index = static_cast<std::size_t>(
+        sum_->inc(labels_value, value);
+        bucket_counts_[bucket_index(value)]->inc(labels_value);
+    }
+
+    size_t bucket_index(value_type value) const {
+        return static_cast<std::size_t>(
             std::distance(bucket_boundaries_.begin(),
                           std::lower_bound(bucket_boundaries_.begin(),
                                            bucket_boundaries_.end(), value)));
-        sum_->inc(labels_value, value);
-        bucket_counts_[bucket_index]->inc(labels_value);
+    }
+
+    size_t bucket_count() const { return bucket_counts_.size(); }
+
+    // Adds several observations at once, counted per bucket_index, with the
+    // sum of their values
+    void observe_counts(const std::array<std::string, N>& labels_value,
+                        const std::vector<value_type>& counts,
+                        value_type sum) {
+        sum_->inc(labels_value, sum);
+        for (size_t i = 0; i < counts.size() && i < bucket_counts_.size();
+             i++) {
+            if (counts[i] != 0) {
+                bucket_counts_[i]->inc(labels_value, counts[i]);
+            }
+        }
     }
 
     void clean_expired_label() override {
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "flat_key_map.h"
+#include "rpc_types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Counting Bloom filter over the keys of one metadata shard of the
+ * master, exported to clients as a plain bit array so that they can answer
+ * most existence queries for missing keys locally.
+ *
+ * Attached to the FlatKeyMap of the shard, it forwards the notifications to
+ * next, e.g. the prefix index of the shard. The counters saturate, a
+ * saturated counter is never decremented.
+ *
+ * Every change of the exported bits records the next value of seq, the
+ * change sequence number shared by all the shards of the master, so that
+ * clients can ask for the shards changed since their last sync.
+ *
+ * Not thread-safe, accessed under the lock of the shard.
+ */
+class KeyFilterShard : public FlatKeyMapObserver {
+   public:
+    static constexpr size_t kNumHashes = 4;
+
+    KeyFilterShard(size_t num_bits, std::atomic<uint64_t>* seq,
+                   FlatKeyMapObserver* next = nullptr);
+
+    KeyFilterShard(const KeyFilterShard&) = delete;
+    KeyFilterShard& operator=(const KeyFilterShard&) = delete;
+
+    void OnInsert(const std::string& key) override;
+    void OnErase(const std::string& key) override;
+
+    // Change sequence number of the last change of the bits
+    uint64_t version() const { return version_; }
+
+    // One bit per counter, set if the counter is not zero
+    const std::string& bits() const { return bits_; }
+
+    /**
+     * @brief Whether the key may be in the shard the bits were exported
+     * from. key_hash is std::hash of the key, the same the master shards
+     * its metadata with. Empty bits stand for a shard that never had a key.
+     */
+    static bool MayContain(const std::string& bits, size_t key_hash);
+
+   private:
+    void SetBit(size_t pos, bool value);
+
+    std::vector<uint8_t> counters_;
+    std::string bits_;
+    uint64_t version_{0};
+    std::atomic<uint64_t>* seq_;
+    FlatKeyMapObserver* next_;
+};
+
+/**
+ * @brief The client side copy of the key filters of the masters, kept up to
+ * date with GetKeyFilter deltas.
+ *
+ * A key is reported missing only if the filters of every master are synced
+ * and none of them may contain it. The copy lags the masters by up to the
+ * sync interval, so keys put in the meantime by other clients may be
+ * reported missing.
+ *
+ * Thread-safe.
+ */
+class KeyFilterView {
+   public:
+    /**
+     * @brief The sequence number to ask each master for the changes since.
+     * 0 asks for the whole filter.
+     */
+    std::vector<uint64_t> SyncPoints(size_t num_masters) const;
+
+    /**
+     * @brief Apply the responses to GetKeyFilter requests sent with the
+     * given sync points, in the order of the masters. A failed response, a
+     * master without filter or a restarted master makes the view unusable
+     * until the next full sync.
+     */
+    void Apply(
+        const std::vector<uint64_t>& sync_points,
+        const std::vector<tl::expected<GetKeyFilterResponse, ErrorCode>>&
+            responses);
+
+    // Whether the key may exist. True if the view is not usable.
+    bool MayContain(const std::string& key) const;
+
+    bool usable() const;
+
+    void Reset();
+
+   private:
+    struct MasterFilter {
+        bool synced = false;
+        uint64_t filter_id = 0;
+        uint64_t seq = 0;
+        uint32_t num_shards = 0;
+        std::vector<std::string> shard_bits;
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::vector<MasterFilter> masters_;
+};
+
+}  // namespace mooncake
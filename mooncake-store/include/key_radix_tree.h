@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flat_key_map.h"
+
+namespace mooncake {
+
+/**
+ * @brief Radix tree (compressed trie) over a set of keys.
+ *
+ * Hierarchical keys like `<model>/<tp_rank>/<hash-chain>` share long
+ * prefixes, and the tree lets prefix queries walk only the matching subtree
+ * instead of scanning every key.
+ *
+ * Not thread-safe. Attached to a FlatKeyMap it mirrors the keys of the map,
+ * as an index next to them: the map keeps its own copy of each key, so the
+ * tree adds a node and the unshared suffix of each key to the memory of the
+ * map rather than saving any.
+ */
+class KeyRadixTree : public FlatKeyMapObserver {
+   public:
+    KeyRadixTree();
+    ~KeyRadixTree() override;
+
+    KeyRadixTree(const KeyRadixTree&) = delete;
+    KeyRadixTree& operator=(const KeyRadixTree&) = delete;
+
+    // Returns false if the key is already present
+    bool Insert(std::string_view key);
+
+    // Returns false if the key is not present
+    bool Erase(std::string_view key);
+
+    bool Contains(std::string_view key) const;
+
+    // Append all keys starting with prefix to keys
+    void CollectWithPrefix(std::string_view prefix,
+                           std::vector<std::string>& keys) const;
+
+    size_t size() const { return size_; }
+
+    void OnInsert(const std::string& key) override { Insert(key); }
+    void OnErase(const std::string& key) override { Erase(key); }
+
+   private:
+    struct Node;
+
+    static void CollectAll(const Node* node, std::string& path,
+                           std::vector<std::string>& keys);
+
+    std::unique_ptr<Node> root_;
+    size_t size_{0};
+};
+
+/**
+ * @brief Get the literal prefix every match of an ECMAScript regex must
+ * start with, e.g. "model/0/" for "^model/0/.*". Returns an empty string if
+ * the pattern is not anchored or the prefix cannot be determined.
+ */
+std::string GetRegexLiteralPrefix(const std::string& regex_pattern);
+
+}  // namespace mooncake
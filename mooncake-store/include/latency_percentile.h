@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Percentile of the latencies of the most recent operations, e.g. the
+ * delay after which a slow read is hedged.
+ *
+ * Keeps the last kWindowSize samples and recomputes the percentile every
+ * kRecomputeInterval samples, so that reading it is a single atomic load.
+ *
+ * Thread-safe.
+ */
+class LatencyPercentile {
+   public:
+    static constexpr size_t kWindowSize = 1024;
+    static constexpr size_t kRecomputeInterval = 64;
+
+    // percentile in (0, 100]
+    explicit LatencyPercentile(double percentile);
+
+    LatencyPercentile(const LatencyPercentile&) = delete;
+    LatencyPercentile& operator=(const LatencyPercentile&) = delete;
+
+    void Record(uint64_t latency_us);
+
+    // 0 until kRecomputeInterval samples are recorded
+    uint64_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+   private:
+    const double percentile_;
+
+    std::mutex mutex_;
+    std::vector<uint64_t> samples_;  // ring buffer of the window
+    size_t next_{0};
+    size_t num_samples_{0};
+    std::vector<uint64_t> scratch_;
+    std::atomic<uint64_t> value_{0};
+};
+
+}  // namespace mooncake
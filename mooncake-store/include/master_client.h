@@ -1,16 +1,21 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <csignal>
 #include <memory>
 #include <string>
 #include <vector>
 #include <cstdlib>
+#include <async_simple/coro/Lazy.h>
 #include <boost/functional/hash.hpp>
 #include <ylt/coro_rpc/coro_rpc_client.hpp>
 #include <ylt/coro_io/client_pool.hpp>
 
 #include "client_metric.h"
+#include "master_shard_ring.h"
 #include "replica.h"
+#include "rpc_coalescer.h"
 #include "types.h"
 #include "rpc_types.h"
 #include "master_metric_manager.h"
@@ -37,6 +42,9 @@ class MasterClient {
         client_pools_ =
             std::make_shared<coro_io::client_pools<coro_rpc::coro_rpc_client>>(
                 pool_conf);
+        InitRdmaRpc();
+        InitStandbyRpc();
+        InitCoalescers();
     }
     ~MasterClient();
 
@@ -45,12 +53,24 @@ class MasterClient {
 
     /**
      * @brief Connects to the master service
-     * @param master_addr Master service address (IP:Port)
+     * @param master_addr Master service address (IP:Port), or a comma
+     * separated list of the addresses of the masters of a sharded deployment,
+     * which partition the keys with a MasterShardRing
      * @return ErrorCode indicating success/failure
      */
     [[nodiscard]] ErrorCode Connect(
         const std::string& master_addr = kDefaultMasterAddress);
 
+    /**
+     * @brief Retries calls that could not reach the master once Connect
+     * moved the client to another master, e.g. a newly elected leader in HA
+     * mode, until `timeout` after the failure. Calls sent to all the
+     * masters, such as Ping, are not retried. 0 disables retries.
+     */
+    void SetFailoverTimeout(std::chrono::milliseconds timeout) {
+        failover_timeout_ms_.store(timeout.count(), std::memory_order_relaxed);
+    }
+
     /**
      * @brief Checks if an object exists
      * @param object_key Key to query
@@ -121,6 +141,19 @@ class MasterClient {
         ErrorCode>
     GetReplicaListByRegex(const std::string& str);
 
+    /**
+     * @brief Fetches one page of the keys starting with prefix, scanning the
+     * masters one after another
+     * @param cursor 0 for the first page, then the next_cursor of the
+     * previous page. The upper bits select the master.
+     * @param limit Number of keys after which a page ends, it may hold the
+     * remaining keys of a master shard beyond it
+     * @return The page, whose next_cursor is 0 once all masters are scanned
+     */
+    [[nodiscard]] tl::expected<ScanKeysResponse, ErrorCode> ScanKeys(
+        const std::string& prefix, uint64_t cursor,
+        uint64_t limit = kScanKeysPageSize);
+
     /**
      * @brief Gets object metadata without transferring data
      * @param object_keys Keys to query
@@ -130,6 +163,44 @@ class MasterClient {
     [[nodiscard]] std::vector<tl::expected<GetReplicaListResponse, ErrorCode>>
     BatchGetReplicaList(const std::vector<std::string>& object_keys);
 
+    /**
+     * @brief Gets the replicas of the leading keys that are cached, stopping
+     * at the first miss
+     * @param object_keys Keys to query, in prefix order
+     * @return Replica lists of the hit prefix, possibly empty
+     */
+    [[nodiscard]] tl::expected<std::vector<GetReplicaListResponse>, ErrorCode>
+    LongestCachedPrefix(const std::vector<std::string>& object_keys);
+
+    /**
+     * @brief Links a key to a content-addressed object put before
+     * @param key Object key
+     * @param content_key Key of the content object, see ContentIndex
+     * @return OBJECT_NOT_FOUND if the content object is not in the store
+     */
+    [[nodiscard]] tl::expected<void, ErrorCode> LinkContent(
+        const std::string& key, const std::string& content_key);
+
+    /**
+     * @brief Links keys to consecutive ranges of a bundle object put before
+     * @param bundle_key Key of the bundle object, see BundleIndex
+     * @param keys Keys stored in the bundle, in order
+     * @param sizes Size of the range of each key
+     * @return OBJECT_NOT_FOUND if the bundle object is not in the store,
+     * UNAVAILABLE_IN_CURRENT_MODE if the keys live on other masters than
+     * the bundle
+     */
+    [[nodiscard]] tl::expected<void, ErrorCode> LinkBundle(
+        const std::string& bundle_key, const std::vector<std::string>& keys,
+        const std::vector<uint64_t>& sizes);
+
+    /**
+     * @brief Gets the ranges of the bundle objects the keys are stored as
+     * @return Per key, OBJECT_NOT_FOUND if it is not linked to a bundle
+     */
+    [[nodiscard]] std::vector<tl::expected<BundleMember, ErrorCode>>
+    BatchResolveBundle(const std::vector<std::string>& keys);
+
     /**
      * @brief Starts a put operation
      * @param key Object key
@@ -174,6 +245,24 @@ class MasterClient {
     [[nodiscard]] std::vector<tl::expected<void, ErrorCode>> BatchPutEnd(
         const std::vector<std::string>& keys);
 
+    /**
+     * @brief Makes the first committed_bytes of an object being put readable
+     * @param key Object key
+     * @param committed_bytes Bytes written to every memory replica
+     * @return tl::expected<void, ErrorCode> indicating success/failure
+     */
+    [[nodiscard]] tl::expected<void, ErrorCode> PutCommit(
+        const std::string& key, uint64_t committed_bytes);
+
+    /**
+     * @brief Gets the replicas of an object and its readable prefix, also
+     * while it is being put
+     * @param key Object key
+     * @return GetCommittedReplicaListResponse or ErrorCode
+     */
+    [[nodiscard]] tl::expected<GetCommittedReplicaListResponse, ErrorCode>
+    GetCommittedReplicaList(const std::string& key);
+
     /**
      * @brief Revokes a put operation
      * @param key Object key
@@ -191,6 +280,28 @@ class MasterClient {
     [[nodiscard]] std::vector<tl::expected<void, ErrorCode>> BatchPutRevoke(
         const std::vector<std::string>& keys);
 
+    /**
+     * @brief Coroutine versions of GetReplicaList, PutStart, PutEnd and
+     * PutRevoke, for callers driving many operations from few threads.
+     * They suspend instead of blocking the thread while the RPC is in flight
+     * and while waiting to retry after a master failover.
+     * @note They are sent over TCP, without the RDMA channel or the request
+     * coalescing of GetReplicaList, which both serve blocking callers.
+     */
+    async_simple::coro::Lazy<tl::expected<GetReplicaListResponse, ErrorCode>>
+    CoroGetReplicaList(std::string object_key);
+
+    async_simple::coro::Lazy<
+        tl::expected<std::vector<Replica::Descriptor>, ErrorCode>>
+    CoroPutStart(std::string key, std::vector<size_t> slice_lengths,
+                 ReplicateConfig config);
+
+    async_simple::coro::Lazy<tl::expected<void, ErrorCode>> CoroPutEnd(
+        std::string key, ReplicaType replica_type);
+
+    async_simple::coro::Lazy<tl::expected<void, ErrorCode>> CoroPutRevoke(
+        std::string key, ReplicaType replica_type);
+
     /**
      * @brief Removes an object and all its replicas
      * @param key Key to remove
@@ -217,6 +328,16 @@ class MasterClient {
      */
     [[nodiscard]] tl::expected<long, ErrorCode> RemoveAll(bool force = false);
 
+    /**
+     * @brief Starts removing the objects whose keys start with prefix in the
+     * background on every master
+     * @param force If true, skip lease checks
+     * @return The ids of the removal tasks, one per master, whose progress
+     * is reported by QueryTask
+     */
+    [[nodiscard]] tl::expected<std::vector<UUID>, ErrorCode> RemoveByPrefix(
+        const std::string& prefix, bool force = false);
+
     /**
      * @brief Registers a segment to master for allocation
      * @param segment Segment to register
@@ -244,6 +365,30 @@ class MasterClient {
     [[nodiscard]] tl::expected<void, ErrorCode> UnmountSegment(
         const UUID& segment_id);
 
+    /**
+     * @brief Stops allocating in a segment and moves its objects away
+     * @param segment_id ID of the segment to drain
+     * @return Bytes the segment still holds, 0 once it can be unmounted
+     * without losing objects
+     */
+    [[nodiscard]] tl::expected<uint64_t, ErrorCode> DrainSegment(
+        const UUID& segment_id);
+
+    /**
+     * @brief Gets the key filter shards changed on each master since the
+     * given sequence numbers, see KeyFilterView
+     * @param since One sequence number per master, missing ones are 0
+     * @return One response per master, in the order of the masters
+     */
+    [[nodiscard]] std::vector<tl::expected<GetKeyFilterResponse, ErrorCode>>
+    GetKeyFilter(const std::vector<uint64_t>& since);
+
+    // Number of masters the keys are sharded over
+    size_t NumMasters() const {
+        auto shards = client_accessor_.GetShards();
+        return shards ? shards->pools.size() : 1;
+    }
+
     /**
      * @brief Gets the cluster ID for the current client to use as subdirectory
      * name
@@ -256,10 +401,13 @@ class MasterClient {
 
     /**
      * @brief Pings master to check its availability
+     * @param transfer_bytes_per_sec Recent transfer throughput of this
+     * client, reported for load aware allocation
      * @return tl::expected<PingResponse, ErrorCode>
      * containing view version and client status
      */
-    [[nodiscard]] tl::expected<PingResponse, ErrorCode> Ping();
+    [[nodiscard]] tl::expected<PingResponse, ErrorCode> Ping(
+        uint64_t transfer_bytes_per_sec = 0);
 
     /**
      * @brief Mounts a local disk segment into the master.
@@ -273,10 +421,13 @@ class MasterClient {
      * set of non-persisted objects.
      * @param enable_offloading Indicates whether persistence is enabled for
      * this segment.
+     * @param max_objects Upper bound of the objects returned by each master
+     * shard, 0 for no bound.
      */
     [[nodiscard]] tl::expected<std::unordered_map<std::string, int64_t>,
                                ErrorCode>
-    OffloadObjectHeartbeat(const UUID& client_id, bool enable_offloading);
+    OffloadObjectHeartbeat(const UUID& client_id, bool enable_offloading,
+                           uint64_t max_objects);
 
     /**
      * @brief Adds multiple new objects to a specified client in batch.
@@ -394,7 +545,99 @@ class MasterClient {
 
    private:
     /**
-     * @brief Generic RPC invocation helper for single-result operations
+     * @brief Create the coalescers of single-key calls, if enabled by
+     * MC_STORE_RPC_COALESCE_WINDOW_US
+     */
+    void InitCoalescers();
+
+    // Set up the RDMA channel of MC_MASTER_RDMA_RPC_PORT, served by the
+    // masters started with --rdma_rpc_port
+    void InitRdmaRpc();
+
+    // Set up the hot standby of MC_STORE_STANDBY_MASTER, see
+    // with_standby_fallback
+    void InitStandbyRpc();
+
+    using ClientPool = coro_io::client_pool<coro_rpc::coro_rpc_client>;
+
+    // Client pools of the masters, and the ring mapping the keys to them
+    struct MasterShards {
+        explicit MasterShards(const std::vector<std::string>& addresses)
+            : ring(addresses) {}
+
+        // Indices of the keys owned by each master
+        std::vector<std::vector<size_t>> Split(
+            const std::vector<std::string>& keys) const {
+            std::vector<std::vector<size_t>> indices(pools.size());
+            for (size_t i = 0; i < keys.size(); i++) {
+                indices[ring.ShardOf(keys[i])].push_back(i);
+            }
+            return indices;
+        }
+
+        MasterShardRing ring;
+        std::vector<std::shared_ptr<ClientPool>> pools;
+        // RDMA channels to the masters, see InitRdmaRpc. Empty if disabled.
+        std::vector<std::shared_ptr<ClientPool>> rdma_pools;
+    };
+
+    /**
+     * @brief Sends an RPC to one master
+     * @tparam ServiceMethod Pointer to WrappedMasterService member function
+     * @tparam ReturnType The expected return type of the RPC call
+     * @param pool Client pool of the master
+     * @param args Arguments to pass to the RPC call, values or reference
+     * wrappers of arguments outliving the coroutine
+     * @return The result of the RPC call
+     */
+    template <auto ServiceMethod, typename ReturnType, typename... Args>
+    async_simple::coro::Lazy<tl::expected<ReturnType, ErrorCode>> rpc_on(
+        std::shared_ptr<ClientPool> pool, Args... args);
+
+    /**
+     * @brief Sends a batch RPC to one master, see rpc_on
+     * @param input_size Size of input batch for error handling
+     * @return Vector of results from the batch RPC call
+     */
+    template <auto ServiceMethod, typename ResultType, typename... Args>
+    async_simple::coro::Lazy<std::vector<tl::expected<ResultType, ErrorCode>>>
+    batch_rpc_on(std::shared_ptr<ClientPool> pool, size_t input_size,
+                 Args... args);
+
+    /**
+     * @brief BatchGetReplicaList of one master, sent in the compact wire
+     * format of CompactReplicaLists
+     * @param keys The keys, or a reference to them
+     */
+    template <typename Keys>
+    async_simple::coro::Lazy<
+        std::vector<tl::expected<GetReplicaListResponse, ErrorCode>>>
+    batch_get_replica_list_on(std::shared_ptr<ClientPool> pool,
+                              size_t input_size, Keys keys);
+
+    /**
+     * @brief Runs `call` with the current masters, and again with the new
+     * ones if it could not reach the master and Connect switched masters
+     * before the failover timeout, see SetFailoverTimeout
+     * @param call Sends the request, given the MasterShards to use
+     */
+    template <typename CallFn>
+    auto call_with_failover(CallFn call)
+        -> decltype(call(std::shared_ptr<const MasterShards>()));
+
+    /**
+     * @brief Sends a read-only query again to the hot standby master of
+     * MC_STORE_STANDBY_MASTER if the leader could not be reached. Only used
+     * with a single master.
+     * @param result Result of the leader
+     * @param send Returns the RPC for the given client pool
+     */
+    template <typename Result, typename SendFn>
+    Result with_standby_fallback(Result result, SendFn send);
+
+    /**
+     * @brief Generic RPC invocation helper for single-result operations,
+     * sent to the first master
      * @tparam ServiceMethod Pointer to WrappedMasterService member function
      * @tparam ReturnType The expected return type of the RPC call
      * @tparam Args Parameter types for the RPC call
@@ -406,7 +649,41 @@ class MasterClient {
         Args&&... args);
 
     /**
-     * @brief Generic RPC invocation helper for batch operations
+     * @brief Same as invoke_rpc, sent to the master owning the key
+     */
+    template <auto ServiceMethod, typename ReturnType, typename... Args>
+    [[nodiscard]] tl::expected<ReturnType, ErrorCode> invoke_key_rpc(
+        const std::string& key, Args&&... args);
+
+    /**
+     * @brief Same as invoke_key_rpc as a coroutine, which suspends instead
+     * of sleeping between failover retries
+     * @param args Arguments outliving the coroutine
+     */
+    template <auto ServiceMethod, typename ReturnType, typename... Args>
+    async_simple::coro::Lazy<tl::expected<ReturnType, ErrorCode>>
+    co_invoke_key_rpc(const std::string& key, const Args&... args);
+
+    /**
+     * @brief Same as invoke_key_rpc, sent over the RDMA channel when it is
+     * enabled. The call is sent again over TCP if the channel fails, which
+     * then stays unused for kRdmaRpcRetryInterval.
+     */
+    template <auto ServiceMethod, typename ReturnType, typename... Args>
+    [[nodiscard]] tl::expected<ReturnType, ErrorCode> invoke_rdma_key_rpc(
+        const std::string& key, Args&&... args);
+
+    /**
+     * @brief Same as invoke_rpc, sent to all the masters in parallel
+     * @return The result of each master
+     */
+    template <auto ServiceMethod, typename ReturnType, typename... Args>
+    [[nodiscard]] std::vector<tl::expected<ReturnType, ErrorCode>>
+    invoke_rpc_on_all(Args&&... args);
+
+    /**
+     * @brief Generic RPC invocation helper for batch operations, sent to the
+     * first master
      * @tparam ServiceMethod Pointer to WrappedMasterService member function
      * @tparam ResultType The expected return type of the RPC call
      * @tparam Args Parameter types for the RPC call
@@ -419,29 +696,55 @@ class MasterClient {
     invoke_batch_rpc(size_t input_size, Args&&... args);
 
     /**
-     * @brief Accessor for the coro_rpc_client pool. Since coro_rpc_client pool
+     * @brief Splits a batch over the masters owning its keys and sends the
+     * parts in parallel
+     * @param keys Keys of the batch
+     * @param send Returns the batch RPC of a master for the given indices
+     * of keys, e.g. built with batch_rpc_on
+     * @return The results in the order of keys
+     */
+    template <typename ResultType, typename SendFn>
+    [[nodiscard]] std::vector<tl::expected<ResultType, ErrorCode>>
+    invoke_sharded_batch_rpc(const std::vector<std::string>& keys,
+                             SendFn send);
+
+    /**
+     * @brief Splits a request over the masters owning its keys and sends the
+     * parts in parallel
+     * @param keys Keys of the request
+     * @param send Returns the RPC of a master for the given indices of keys,
+     * e.g. built with rpc_on
+     * @return The result of each master owning some of the keys
+     */
+    template <typename ReturnType, typename SendFn>
+    [[nodiscard]] std::vector<tl::expected<ReturnType, ErrorCode>>
+    invoke_sharded_rpc(const std::vector<std::string>& keys, SendFn send);
+
+    bool IsSharded() const {
+        auto shards = client_accessor_.GetShards();
+        return shards && shards->pools.size() > 1;
+    }
+
+    /**
+     * @brief Accessor for the coro_rpc_client pools. Since coro_rpc_client pool
      * cannot reconnect to a different address, a new coro_rpc_client pool is
      * created if the address is different from the current one.
      */
     class RpcClientAccessor {
        public:
-        void SetClientPool(
-            std::shared_ptr<coro_io::client_pool<coro_rpc::coro_rpc_client>>
-                client_pool) {
+        void SetShards(std::shared_ptr<const MasterShards> shards) {
             std::lock_guard<std::shared_mutex> lock(client_mutex_);
-            client_pool_ = client_pool;
+            shards_ = std::move(shards);
         }
 
-        std::shared_ptr<coro_io::client_pool<coro_rpc::coro_rpc_client>>
-        GetClientPool() {
+        std::shared_ptr<const MasterShards> GetShards() const {
             std::shared_lock<std::shared_mutex> lock(client_mutex_);
-            return client_pool_;
+            return shards_;
         }
 
        private:
         mutable std::shared_mutex client_mutex_;
-        std::shared_ptr<coro_io::client_pool<coro_rpc::coro_rpc_client>>
-            client_pool_;
+        std::shared_ptr<const MasterShards> shards_;
     };
     RpcClientAccessor client_accessor_;
 
@@ -450,9 +753,30 @@ class MasterClient {
 
     // Metrics for tracking RPC operations
     MasterClientMetric* metrics_;
+
+    // See SetFailoverTimeout
+    std::atomic<int64_t> failover_timeout_ms_{0};
+
+    // Merge concurrent ExistKey and GetReplicaList calls into the batch RPCs
+    std::unique_ptr<RpcCoalescer<tl::expected<bool, ErrorCode>>>
+        exist_key_coalescer_;
+    std::unique_ptr<
+        RpcCoalescer<tl::expected<GetReplicaListResponse, ErrorCode>>>
+        replica_list_coalescer_;
     std::shared_ptr<coro_io::client_pools<coro_rpc::coro_rpc_client>>
         client_pools_;
 
+    // RDMA RPC channel, only created if rdma_rpc_port_ is set
+    static constexpr auto kRdmaRpcRetryInterval = std::chrono::seconds(10);
+    int rdma_rpc_port_ = 0;
+    std::shared_ptr<coro_io::client_pools<coro_rpc::coro_rpc_client>>
+        rdma_client_pools_;
+    // steady_clock time before which the channel is not used, in ns
+    std::atomic<int64_t> rdma_rpc_retry_at_ns_{0};
+
+    // Hot standby queried when the leader is unreachable, null if not set
+    std::shared_ptr<ClientPool> standby_pool_;
+
     // Mutex to insure the Connect function is atomic.
     mutable Mutex connect_mutex_;
     // The address which is passed to the coro_rpc_client
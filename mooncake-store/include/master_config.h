@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <optional>
 #include <stdexcept>
 
@@ -8,6 +9,8 @@
 
 namespace mooncake {
 
+class MetadataFollower;
+
 // The configuration for the master server
 struct MasterConfig {
     bool enable_metric_reporting;
@@ -28,6 +31,8 @@ struct MasterConfig {
     bool enable_ha;
     bool enable_offload;
     std::string etcd_endpoints;
+    // TTL of the etcd lease of the leader, which bounds failover time
+    int64_t etcd_lease_ttl_sec = ETCD_MASTER_VIEW_LEASE_TTL;
 
     std::string cluster_id;
     std::string root_fs_dir;
@@ -53,9 +58,41 @@ struct MasterConfig {
     uint64_t pending_task_timeout_sec;
     uint64_t processing_task_timeout_sec;
     uint32_t max_retry_attempts;
+    uint64_t max_task_bytes_per_client;
     std::string cxl_path;
     size_t cxl_size;
     bool enable_cxl = false;
+    std::string metadata_persist_dir = DEFAULT_METADATA_PERSIST_DIR;
+    uint64_t metadata_snapshot_interval_sec =
+        DEFAULT_METADATA_SNAPSHOT_INTERVAL_SEC;
+    bool enable_hot_standby = false;
+    int standby_rpc_port = 0;
+    int rdma_rpc_port = 0;
+    uint64_t hot_replica_cache_size = DEFAULT_HOT_REPLICA_CACHE_SIZE;
+    uint64_t key_filter_bits_per_shard = DEFAULT_KEY_FILTER_BITS_PER_SHARD;
+    bool enable_key_prefix_index = DEFAULT_ENABLE_KEY_PREFIX_INDEX;
+    std::string eviction_policy = DEFAULT_EVICTION_POLICY;
+    bool enable_tinylfu_admission = false;
+    uint32_t put_start_eviction_retries = DEFAULT_PUT_START_EVICTION_RETRIES;
+    bool batch_put_contiguous = DEFAULT_BATCH_PUT_CONTIGUOUS;
+    std::string allocation_strategy = DEFAULT_ALLOCATION_STRATEGY;
+    double compaction_fragmentation_threshold =
+        DEFAULT_COMPACTION_FRAGMENTATION_THRESHOLD;
+    uint32_t compaction_moves_per_sec = DEFAULT_COMPACTION_MOVES_PER_SEC;
+    double rebalance_utilization_gap = DEFAULT_REBALANCE_UTILIZATION_GAP;
+    uint32_t rebalance_moves_per_sec = DEFAULT_REBALANCE_MOVES_PER_SEC;
+    std::string tenant_quotas;
+    double lazy_lease_renewal_ratio = DEFAULT_LAZY_LEASE_RENEWAL_RATIO;
+    bool enable_async_replica_reclaim = DEFAULT_ENABLE_ASYNC_REPLICA_RECLAIM;
+    uint32_t hot_key_top_n = DEFAULT_HOT_KEY_TOP_N;
+    uint32_t hot_key_replica_reads_per_sec =
+        DEFAULT_HOT_KEY_REPLICA_READS_PER_SEC;
+    uint32_t hot_key_max_replicas = DEFAULT_HOT_KEY_MAX_REPLICAS;
+    uint32_t disk_promotion_reads = DEFAULT_DISK_PROMOTION_READS;
+    uint32_t disk_promotion_window_sec = DEFAULT_DISK_PROMOTION_WINDOW_SEC;
+    double memory_tier_target_ratio = DEFAULT_MEMORY_TIER_TARGET_RATIO;
+    uint32_t tier_demotion_min_idle_sec = DEFAULT_TIER_DEMOTION_MIN_IDLE_SEC;
+    uint64_t cxl_min_object_size = DEFAULT_CXL_MIN_OBJECT_SIZE;
 };
 
 class MasterServiceSupervisorConfig {
@@ -81,6 +118,7 @@ class MasterServiceSupervisorConfig {
         0);  // Client connection timeout. 0 = no timeout (infinite)
     bool rpc_enable_tcp_no_delay = true;
     std::string etcd_endpoints = "0.0.0.0:2379";
+    int64_t etcd_lease_ttl_sec = ETCD_MASTER_VIEW_LEASE_TTL;
     std::string local_hostname = "0.0.0.0:50051";
     std::string cluster_id = DEFAULT_CLUSTER_ID;
     std::string root_fs_dir = DEFAULT_ROOT_FS_DIR;
@@ -98,10 +136,44 @@ class MasterServiceSupervisorConfig {
     uint64_t processing_task_timeout_sec =
         DEFAULT_PROCESSING_TASK_TIMEOUT_SEC;  // 0 = no timeout(infinite)
     uint32_t max_retry_attempts = DEFAULT_MAX_RETRY_ATTEMPTS;
+    uint64_t max_task_bytes_per_client =
+        DEFAULT_MAX_TASK_BYTES_PER_CLIENT;  // 0 = no limit
 
     std::string cxl_path = DEFAULT_CXL_PATH;
     size_t cxl_size = DEFAULT_CXL_SIZE;
     bool enable_cxl = false;
+    std::string metadata_persist_dir = DEFAULT_METADATA_PERSIST_DIR;
+    uint64_t metadata_snapshot_interval_sec =
+        DEFAULT_METADATA_SNAPSHOT_INTERVAL_SEC;
+    bool enable_hot_standby = false;
+    int standby_rpc_port = 0;
+    int rdma_rpc_port = 0;
+    uint64_t hot_replica_cache_size = DEFAULT_HOT_REPLICA_CACHE_SIZE;
+    uint64_t key_filter_bits_per_shard = DEFAULT_KEY_FILTER_BITS_PER_SHARD;
+    bool enable_key_prefix_index = DEFAULT_ENABLE_KEY_PREFIX_INDEX;
+    EvictionPolicy eviction_policy = EvictionPolicy::LRU;
+    bool enable_tinylfu_admission = false;
+    uint32_t put_start_eviction_retries = DEFAULT_PUT_START_EVICTION_RETRIES;
+    bool batch_put_contiguous = DEFAULT_BATCH_PUT_CONTIGUOUS;
+    AllocationStrategyType allocation_strategy =
+        AllocationStrategyType::RANDOM;
+    double compaction_fragmentation_threshold =
+        DEFAULT_COMPACTION_FRAGMENTATION_THRESHOLD;
+    uint32_t compaction_moves_per_sec = DEFAULT_COMPACTION_MOVES_PER_SEC;
+    double rebalance_utilization_gap = DEFAULT_REBALANCE_UTILIZATION_GAP;
+    uint32_t rebalance_moves_per_sec = DEFAULT_REBALANCE_MOVES_PER_SEC;
+    std::string tenant_quotas;
+    double lazy_lease_renewal_ratio = DEFAULT_LAZY_LEASE_RENEWAL_RATIO;
+    bool enable_async_replica_reclaim = DEFAULT_ENABLE_ASYNC_REPLICA_RECLAIM;
+    uint32_t hot_key_top_n = DEFAULT_HOT_KEY_TOP_N;
+    uint32_t hot_key_replica_reads_per_sec =
+        DEFAULT_HOT_KEY_REPLICA_READS_PER_SEC;
+    uint32_t hot_key_max_replicas = DEFAULT_HOT_KEY_MAX_REPLICAS;
+    uint32_t disk_promotion_reads = DEFAULT_DISK_PROMOTION_READS;
+    uint32_t disk_promotion_window_sec = DEFAULT_DISK_PROMOTION_WINDOW_SEC;
+    double memory_tier_target_ratio = DEFAULT_MEMORY_TIER_TARGET_RATIO;
+    uint32_t tier_demotion_min_idle_sec = DEFAULT_TIER_DEMOTION_MIN_IDLE_SEC;
+    uint64_t cxl_min_object_size = DEFAULT_CXL_MIN_OBJECT_SIZE;
     MasterServiceSupervisorConfig() = default;
 
     // From MasterConfig
@@ -126,6 +198,7 @@ class MasterServiceSupervisorConfig {
             std::chrono::seconds(config.rpc_conn_timeout_seconds);
         rpc_enable_tcp_no_delay = config.rpc_enable_tcp_no_delay;
         etcd_endpoints = config.etcd_endpoints;
+        etcd_lease_ttl_sec = config.etcd_lease_ttl_sec;
         local_hostname = rpc_address + ":" + std::to_string(rpc_port);
         cluster_id = config.cluster_id;
         root_fs_dir = config.root_fs_dir;
@@ -149,10 +222,43 @@ class MasterServiceSupervisorConfig {
         pending_task_timeout_sec = config.pending_task_timeout_sec;
         processing_task_timeout_sec = config.processing_task_timeout_sec;
         max_retry_attempts = config.max_retry_attempts;
+        max_task_bytes_per_client = config.max_task_bytes_per_client;
 
         cxl_path = config.cxl_path;
         cxl_size = config.cxl_size;
         enable_cxl = config.enable_cxl;
+        metadata_persist_dir = config.metadata_persist_dir;
+        metadata_snapshot_interval_sec = config.metadata_snapshot_interval_sec;
+        enable_hot_standby = config.enable_hot_standby;
+        standby_rpc_port = config.standby_rpc_port;
+        rdma_rpc_port = config.rdma_rpc_port;
+        hot_replica_cache_size = config.hot_replica_cache_size;
+        key_filter_bits_per_shard = config.key_filter_bits_per_shard;
+        enable_key_prefix_index = config.enable_key_prefix_index;
+        eviction_policy = ParseEvictionPolicy(config.eviction_policy)
+                              .value_or(EvictionPolicy::LRU);
+        enable_tinylfu_admission = config.enable_tinylfu_admission;
+        put_start_eviction_retries = config.put_start_eviction_retries;
+        batch_put_contiguous = config.batch_put_contiguous;
+        allocation_strategy =
+            ParseAllocationStrategyType(config.allocation_strategy)
+                .value_or(AllocationStrategyType::RANDOM);
+        compaction_fragmentation_threshold =
+            config.compaction_fragmentation_threshold;
+        compaction_moves_per_sec = config.compaction_moves_per_sec;
+        rebalance_utilization_gap = config.rebalance_utilization_gap;
+        rebalance_moves_per_sec = config.rebalance_moves_per_sec;
+        tenant_quotas = config.tenant_quotas;
+        lazy_lease_renewal_ratio = config.lazy_lease_renewal_ratio;
+        enable_async_replica_reclaim = config.enable_async_replica_reclaim;
+        hot_key_top_n = config.hot_key_top_n;
+        hot_key_replica_reads_per_sec = config.hot_key_replica_reads_per_sec;
+        hot_key_max_replicas = config.hot_key_max_replicas;
+        disk_promotion_reads = config.disk_promotion_reads;
+        disk_promotion_window_sec = config.disk_promotion_window_sec;
+        memory_tier_target_ratio = config.memory_tier_target_ratio;
+        tier_demotion_min_idle_sec = config.tier_demotion_min_idle_sec;
+        cxl_min_object_size = config.cxl_min_object_size;
         validate();
     }
 
@@ -231,10 +337,43 @@ class WrappedMasterServiceConfig {
     uint64_t processing_task_timeout_sec =
         DEFAULT_PROCESSING_TASK_TIMEOUT_SEC;  // 0 = no timeout(infinite)
     uint32_t max_retry_attempts = DEFAULT_MAX_RETRY_ATTEMPTS;
+    uint64_t max_task_bytes_per_client =
+        DEFAULT_MAX_TASK_BYTES_PER_CLIENT;  // 0 = no limit
 
     std::string cxl_path = DEFAULT_CXL_PATH;
     size_t cxl_size = DEFAULT_CXL_SIZE;
     bool enable_cxl = false;
+    std::string metadata_persist_dir = DEFAULT_METADATA_PERSIST_DIR;
+    uint64_t metadata_snapshot_interval_sec =
+        DEFAULT_METADATA_SNAPSHOT_INTERVAL_SEC;
+    // Already replayed metadata of a promoted hot standby, not a flag
+    std::shared_ptr<MetadataFollower> metadata_follower;
+    uint64_t hot_replica_cache_size = DEFAULT_HOT_REPLICA_CACHE_SIZE;
+    uint64_t key_filter_bits_per_shard = DEFAULT_KEY_FILTER_BITS_PER_SHARD;
+    bool enable_key_prefix_index = DEFAULT_ENABLE_KEY_PREFIX_INDEX;
+    EvictionPolicy eviction_policy = EvictionPolicy::LRU;
+    bool enable_tinylfu_admission = false;
+    uint32_t put_start_eviction_retries = DEFAULT_PUT_START_EVICTION_RETRIES;
+    bool batch_put_contiguous = DEFAULT_BATCH_PUT_CONTIGUOUS;
+    AllocationStrategyType allocation_strategy =
+        AllocationStrategyType::RANDOM;
+    double compaction_fragmentation_threshold =
+        DEFAULT_COMPACTION_FRAGMENTATION_THRESHOLD;
+    uint32_t compaction_moves_per_sec = DEFAULT_COMPACTION_MOVES_PER_SEC;
+    double rebalance_utilization_gap = DEFAULT_REBALANCE_UTILIZATION_GAP;
+    uint32_t rebalance_moves_per_sec = DEFAULT_REBALANCE_MOVES_PER_SEC;
+    std::string tenant_quotas;
+    double lazy_lease_renewal_ratio = DEFAULT_LAZY_LEASE_RENEWAL_RATIO;
+    bool enable_async_replica_reclaim = DEFAULT_ENABLE_ASYNC_REPLICA_RECLAIM;
+    uint32_t hot_key_top_n = DEFAULT_HOT_KEY_TOP_N;
+    uint32_t hot_key_replica_reads_per_sec =
+        DEFAULT_HOT_KEY_REPLICA_READS_PER_SEC;
+    uint32_t hot_key_max_replicas = DEFAULT_HOT_KEY_MAX_REPLICAS;
+    uint32_t disk_promotion_reads = DEFAULT_DISK_PROMOTION_READS;
+    uint32_t disk_promotion_window_sec = DEFAULT_DISK_PROMOTION_WINDOW_SEC;
+    double memory_tier_target_ratio = DEFAULT_MEMORY_TIER_TARGET_RATIO;
+    uint32_t tier_demotion_min_idle_sec = DEFAULT_TIER_DEMOTION_MIN_IDLE_SEC;
+    uint64_t cxl_min_object_size = DEFAULT_CXL_MIN_OBJECT_SIZE;
     WrappedMasterServiceConfig() = default;
 
     // From MasterConfig
@@ -277,9 +416,39 @@ class WrappedMasterServiceConfig {
         pending_task_timeout_sec = config.pending_task_timeout_sec;
         processing_task_timeout_sec = config.processing_task_timeout_sec;
         max_retry_attempts = config.max_retry_attempts;
+        max_task_bytes_per_client = config.max_task_bytes_per_client;
         cxl_path = config.cxl_path;
         cxl_size = config.cxl_size;
         enable_cxl = config.enable_cxl;
+        metadata_persist_dir = config.metadata_persist_dir;
+        metadata_snapshot_interval_sec = config.metadata_snapshot_interval_sec;
+        hot_replica_cache_size = config.hot_replica_cache_size;
+        key_filter_bits_per_shard = config.key_filter_bits_per_shard;
+        enable_key_prefix_index = config.enable_key_prefix_index;
+        eviction_policy = ParseEvictionPolicy(config.eviction_policy)
+                              .value_or(EvictionPolicy::LRU);
+        enable_tinylfu_admission = config.enable_tinylfu_admission;
+        put_start_eviction_retries = config.put_start_eviction_retries;
+        batch_put_contiguous = config.batch_put_contiguous;
+        allocation_strategy =
+            ParseAllocationStrategyType(config.allocation_strategy)
+                .value_or(AllocationStrategyType::RANDOM);
+        compaction_fragmentation_threshold =
+            config.compaction_fragmentation_threshold;
+        compaction_moves_per_sec = config.compaction_moves_per_sec;
+        rebalance_utilization_gap = config.rebalance_utilization_gap;
+        rebalance_moves_per_sec = config.rebalance_moves_per_sec;
+        tenant_quotas = config.tenant_quotas;
+        lazy_lease_renewal_ratio = config.lazy_lease_renewal_ratio;
+        enable_async_replica_reclaim = config.enable_async_replica_reclaim;
+        hot_key_top_n = config.hot_key_top_n;
+        hot_key_replica_reads_per_sec = config.hot_key_replica_reads_per_sec;
+        hot_key_max_replicas = config.hot_key_max_replicas;
+        disk_promotion_reads = config.disk_promotion_reads;
+        disk_promotion_window_sec = config.disk_promotion_window_sec;
+        memory_tier_target_ratio = config.memory_tier_target_ratio;
+        tier_demotion_min_idle_sec = config.tier_demotion_min_idle_sec;
+        cxl_min_object_size = config.cxl_min_object_size;
     }
 
     // From MasterServiceSupervisorConfig, enable_ha is set to true
@@ -316,10 +485,37 @@ class WrappedMasterServiceConfig {
         pending_task_timeout_sec = config.pending_task_timeout_sec;
         processing_task_timeout_sec = config.processing_task_timeout_sec;
         max_retry_attempts = config.max_retry_attempts;
+        max_task_bytes_per_client = config.max_task_bytes_per_client;
 
         cxl_path = config.cxl_path;
         cxl_size = config.cxl_size;
         enable_cxl = config.enable_cxl;
+        metadata_persist_dir = config.metadata_persist_dir;
+        metadata_snapshot_interval_sec = config.metadata_snapshot_interval_sec;
+        hot_replica_cache_size = config.hot_replica_cache_size;
+        key_filter_bits_per_shard = config.key_filter_bits_per_shard;
+        enable_key_prefix_index = config.enable_key_prefix_index;
+        eviction_policy = config.eviction_policy;
+        enable_tinylfu_admission = config.enable_tinylfu_admission;
+        put_start_eviction_retries = config.put_start_eviction_retries;
+        batch_put_contiguous = config.batch_put_contiguous;
+        allocation_strategy = config.allocation_strategy;
+        compaction_fragmentation_threshold =
+            config.compaction_fragmentation_threshold;
+        compaction_moves_per_sec = config.compaction_moves_per_sec;
+        rebalance_utilization_gap = config.rebalance_utilization_gap;
+        rebalance_moves_per_sec = config.rebalance_moves_per_sec;
+        tenant_quotas = config.tenant_quotas;
+        lazy_lease_renewal_ratio = config.lazy_lease_renewal_ratio;
+        enable_async_replica_reclaim = config.enable_async_replica_reclaim;
+        hot_key_top_n = config.hot_key_top_n;
+        hot_key_replica_reads_per_sec = config.hot_key_replica_reads_per_sec;
+        hot_key_max_replicas = config.hot_key_max_replicas;
+        disk_promotion_reads = config.disk_promotion_reads;
+        disk_promotion_window_sec = config.disk_promotion_window_sec;
+        memory_tier_target_ratio = config.memory_tier_target_ratio;
+        tier_demotion_min_idle_sec = config.tier_demotion_min_idle_sec;
+        cxl_min_object_size = config.cxl_min_object_size;
     }
 };
 
@@ -354,10 +550,41 @@ class MasterServiceConfigBuilder {
     uint64_t pending_task_timeout_sec_ = DEFAULT_PENDING_TASK_TIMEOUT_SEC;
     uint64_t processing_task_timeout_sec_ = DEFAULT_PROCESSING_TASK_TIMEOUT_SEC;
     uint32_t max_retry_attempts_ = DEFAULT_MAX_RETRY_ATTEMPTS;
+    uint64_t max_task_bytes_per_client_ = DEFAULT_MAX_TASK_BYTES_PER_CLIENT;
 
     std::string cxl_path_ = DEFAULT_CXL_PATH;
     size_t cxl_size_ = DEFAULT_CXL_SIZE;
     bool enable_cxl_ = false;
+    std::string metadata_persist_dir_ = DEFAULT_METADATA_PERSIST_DIR;
+    uint64_t metadata_snapshot_interval_sec_ =
+        DEFAULT_METADATA_SNAPSHOT_INTERVAL_SEC;
+    uint64_t hot_replica_cache_size_ = DEFAULT_HOT_REPLICA_CACHE_SIZE;
+    uint64_t key_filter_bits_per_shard_ =
+        DEFAULT_KEY_FILTER_BITS_PER_SHARD;
+    bool enable_key_prefix_index_ = DEFAULT_ENABLE_KEY_PREFIX_INDEX;
+    EvictionPolicy eviction_policy_ = EvictionPolicy::LRU;
+    bool enable_tinylfu_admission_ = false;
+    uint32_t put_start_eviction_retries_ = DEFAULT_PUT_START_EVICTION_RETRIES;
+    bool batch_put_contiguous_ = DEFAULT_BATCH_PUT_CONTIGUOUS;
+    AllocationStrategyType allocation_strategy_ =
+        AllocationStrategyType::RANDOM;
+    double compaction_fragmentation_threshold_ =
+        DEFAULT_COMPACTION_FRAGMENTATION_THRESHOLD;
+    uint32_t compaction_moves_per_sec_ = DEFAULT_COMPACTION_MOVES_PER_SEC;
+    double rebalance_utilization_gap_ = DEFAULT_REBALANCE_UTILIZATION_GAP;
+    uint32_t rebalance_moves_per_sec_ = DEFAULT_REBALANCE_MOVES_PER_SEC;
+    std::string tenant_quotas_;
+    double lazy_lease_renewal_ratio_ = DEFAULT_LAZY_LEASE_RENEWAL_RATIO;
+    bool enable_async_replica_reclaim_ = DEFAULT_ENABLE_ASYNC_REPLICA_RECLAIM;
+    uint32_t hot_key_top_n_ = DEFAULT_HOT_KEY_TOP_N;
+    uint32_t hot_key_replica_reads_per_sec_ =
+        DEFAULT_HOT_KEY_REPLICA_READS_PER_SEC;
+    uint32_t hot_key_max_replicas_ = DEFAULT_HOT_KEY_MAX_REPLICAS;
+    uint32_t disk_promotion_reads_ = DEFAULT_DISK_PROMOTION_READS;
+    uint32_t disk_promotion_window_sec_ = DEFAULT_DISK_PROMOTION_WINDOW_SEC;
+    double memory_tier_target_ratio_ = DEFAULT_MEMORY_TIER_TARGET_RATIO;
+    uint32_t tier_demotion_min_idle_sec_ = DEFAULT_TIER_DEMOTION_MIN_IDLE_SEC;
+    uint64_t cxl_min_object_size_ = DEFAULT_CXL_MIN_OBJECT_SIZE;
 
    public:
     MasterServiceConfigBuilder() = default;
@@ -477,6 +704,12 @@ class MasterServiceConfigBuilder {
         return *this;
     }
 
+    MasterServiceConfigBuilder& set_max_task_bytes_per_client(
+        uint64_t max_task_bytes_per_client) {
+        max_task_bytes_per_client_ = max_task_bytes_per_client;
+        return *this;
+    }
+
     MasterServiceConfigBuilder& set_cxl_path(const std::string& path) {
         cxl_path_ = path;
         return *this;
@@ -492,6 +725,154 @@ class MasterServiceConfigBuilder {
         return *this;
     }
 
+    MasterServiceConfigBuilder& set_metadata_persist_dir(
+        const std::string& metadata_persist_dir) {
+        metadata_persist_dir_ = metadata_persist_dir;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_metadata_snapshot_interval_sec(
+        uint64_t metadata_snapshot_interval_sec) {
+        metadata_snapshot_interval_sec_ = metadata_snapshot_interval_sec;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_hot_replica_cache_size(
+        uint64_t hot_replica_cache_size) {
+        hot_replica_cache_size_ = hot_replica_cache_size;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_key_filter_bits_per_shard(
+        uint64_t key_filter_bits_per_shard) {
+        key_filter_bits_per_shard_ = key_filter_bits_per_shard;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_enable_key_prefix_index(
+        bool enable_key_prefix_index) {
+        enable_key_prefix_index_ = enable_key_prefix_index;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_eviction_policy(
+        EvictionPolicy eviction_policy) {
+        eviction_policy_ = eviction_policy;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_enable_tinylfu_admission(bool enable) {
+        enable_tinylfu_admission_ = enable;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_put_start_eviction_retries(
+        uint32_t put_start_eviction_retries) {
+        put_start_eviction_retries_ = put_start_eviction_retries;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_batch_put_contiguous(bool enable) {
+        batch_put_contiguous_ = enable;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_allocation_strategy(
+        AllocationStrategyType allocation_strategy) {
+        allocation_strategy_ = allocation_strategy;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_compaction_fragmentation_threshold(
+        double compaction_fragmentation_threshold) {
+        compaction_fragmentation_threshold_ =
+            compaction_fragmentation_threshold;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_compaction_moves_per_sec(
+        uint32_t compaction_moves_per_sec) {
+        compaction_moves_per_sec_ = compaction_moves_per_sec;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_rebalance_utilization_gap(
+        double rebalance_utilization_gap) {
+        rebalance_utilization_gap_ = rebalance_utilization_gap;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_rebalance_moves_per_sec(
+        uint32_t rebalance_moves_per_sec) {
+        rebalance_moves_per_sec_ = rebalance_moves_per_sec;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_tenant_quotas(
+        const std::string& tenant_quotas) {
+        tenant_quotas_ = tenant_quotas;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_lazy_lease_renewal_ratio(
+        double lazy_lease_renewal_ratio) {
+        lazy_lease_renewal_ratio_ = lazy_lease_renewal_ratio;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_enable_async_replica_reclaim(
+        bool enable_async_replica_reclaim) {
+        enable_async_replica_reclaim_ = enable_async_replica_reclaim;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_hot_key_top_n(uint32_t hot_key_top_n) {
+        hot_key_top_n_ = hot_key_top_n;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_hot_key_replica_reads_per_sec(
+        uint32_t hot_key_replica_reads_per_sec) {
+        hot_key_replica_reads_per_sec_ = hot_key_replica_reads_per_sec;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_hot_key_max_replicas(
+        uint32_t hot_key_max_replicas) {
+        hot_key_max_replicas_ = hot_key_max_replicas;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_disk_promotion_reads(
+        uint32_t disk_promotion_reads) {
+        disk_promotion_reads_ = disk_promotion_reads;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_disk_promotion_window_sec(
+        uint32_t disk_promotion_window_sec) {
+        disk_promotion_window_sec_ = disk_promotion_window_sec;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_memory_tier_target_ratio(
+        double memory_tier_target_ratio) {
+        memory_tier_target_ratio_ = memory_tier_target_ratio;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_tier_demotion_min_idle_sec(
+        uint32_t tier_demotion_min_idle_sec) {
+        tier_demotion_min_idle_sec_ = tier_demotion_min_idle_sec;
+        return *this;
+    }
+
+    MasterServiceConfigBuilder& set_cxl_min_object_size(
+        uint64_t cxl_min_object_size) {
+        cxl_min_object_size_ = cxl_min_object_size;
+        return *this;
+    }
+
     MasterServiceConfig build() const;
 };
 
@@ -503,6 +884,7 @@ struct TaskManagerConfig {
     uint64_t pending_task_timeout_sec;
     uint64_t processing_task_timeout_sec;
     uint32_t max_retry_attempts;
+    uint64_t max_task_bytes_per_client;
 };
 
 class MasterServiceConfig {
@@ -534,11 +916,43 @@ class MasterServiceConfig {
         .pending_task_timeout_sec = DEFAULT_PENDING_TASK_TIMEOUT_SEC,
         .processing_task_timeout_sec = DEFAULT_PROCESSING_TASK_TIMEOUT_SEC,
         .max_retry_attempts = DEFAULT_MAX_RETRY_ATTEMPTS,
+        .max_task_bytes_per_client = DEFAULT_MAX_TASK_BYTES_PER_CLIENT,
     };
 
     std::string cxl_path = DEFAULT_CXL_PATH;
     size_t cxl_size = DEFAULT_CXL_SIZE;
     bool enable_cxl = false;
+    std::string metadata_persist_dir = DEFAULT_METADATA_PERSIST_DIR;
+    uint64_t metadata_snapshot_interval_sec =
+        DEFAULT_METADATA_SNAPSHOT_INTERVAL_SEC;
+    // Already replayed metadata of a promoted hot standby, not a flag
+    std::shared_ptr<MetadataFollower> metadata_follower;
+    uint64_t hot_replica_cache_size = DEFAULT_HOT_REPLICA_CACHE_SIZE;
+    uint64_t key_filter_bits_per_shard = DEFAULT_KEY_FILTER_BITS_PER_SHARD;
+    bool enable_key_prefix_index = DEFAULT_ENABLE_KEY_PREFIX_INDEX;
+    EvictionPolicy eviction_policy = EvictionPolicy::LRU;
+    bool enable_tinylfu_admission = false;
+    uint32_t put_start_eviction_retries = DEFAULT_PUT_START_EVICTION_RETRIES;
+    bool batch_put_contiguous = DEFAULT_BATCH_PUT_CONTIGUOUS;
+    AllocationStrategyType allocation_strategy =
+        AllocationStrategyType::RANDOM;
+    double compaction_fragmentation_threshold =
+        DEFAULT_COMPACTION_FRAGMENTATION_THRESHOLD;
+    uint32_t compaction_moves_per_sec = DEFAULT_COMPACTION_MOVES_PER_SEC;
+    double rebalance_utilization_gap = DEFAULT_REBALANCE_UTILIZATION_GAP;
+    uint32_t rebalance_moves_per_sec = DEFAULT_REBALANCE_MOVES_PER_SEC;
+    std::string tenant_quotas;
+    double lazy_lease_renewal_ratio = DEFAULT_LAZY_LEASE_RENEWAL_RATIO;
+    bool enable_async_replica_reclaim = DEFAULT_ENABLE_ASYNC_REPLICA_RECLAIM;
+    uint32_t hot_key_top_n = DEFAULT_HOT_KEY_TOP_N;
+    uint32_t hot_key_replica_reads_per_sec =
+        DEFAULT_HOT_KEY_REPLICA_READS_PER_SEC;
+    uint32_t hot_key_max_replicas = DEFAULT_HOT_KEY_MAX_REPLICAS;
+    uint32_t disk_promotion_reads = DEFAULT_DISK_PROMOTION_READS;
+    uint32_t disk_promotion_window_sec = DEFAULT_DISK_PROMOTION_WINDOW_SEC;
+    double memory_tier_target_ratio = DEFAULT_MEMORY_TIER_TARGET_RATIO;
+    uint32_t tier_demotion_min_idle_sec = DEFAULT_TIER_DEMOTION_MIN_IDLE_SEC;
+    uint64_t cxl_min_object_size = DEFAULT_CXL_MIN_OBJECT_SIZE;
     MasterServiceConfig() = default;
 
     // From WrappedMasterServiceConfig
@@ -575,9 +989,38 @@ class MasterServiceConfig {
         task_manager_config.processing_task_timeout_sec =
             config.processing_task_timeout_sec;
         task_manager_config.max_retry_attempts = config.max_retry_attempts;
+        task_manager_config.max_task_bytes_per_client =
+            config.max_task_bytes_per_client;
         cxl_path = config.cxl_path;
         cxl_size = config.cxl_size;
         enable_cxl = config.enable_cxl;
+        metadata_persist_dir = config.metadata_persist_dir;
+        metadata_snapshot_interval_sec = config.metadata_snapshot_interval_sec;
+        metadata_follower = config.metadata_follower;
+        hot_replica_cache_size = config.hot_replica_cache_size;
+        key_filter_bits_per_shard = config.key_filter_bits_per_shard;
+        enable_key_prefix_index = config.enable_key_prefix_index;
+        eviction_policy = config.eviction_policy;
+        enable_tinylfu_admission = config.enable_tinylfu_admission;
+        put_start_eviction_retries = config.put_start_eviction_retries;
+        batch_put_contiguous = config.batch_put_contiguous;
+        allocation_strategy = config.allocation_strategy;
+        compaction_fragmentation_threshold =
+            config.compaction_fragmentation_threshold;
+        compaction_moves_per_sec = config.compaction_moves_per_sec;
+        rebalance_utilization_gap = config.rebalance_utilization_gap;
+        rebalance_moves_per_sec = config.rebalance_moves_per_sec;
+        tenant_quotas = config.tenant_quotas;
+        lazy_lease_renewal_ratio = config.lazy_lease_renewal_ratio;
+        enable_async_replica_reclaim = config.enable_async_replica_reclaim;
+        hot_key_top_n = config.hot_key_top_n;
+        hot_key_replica_reads_per_sec = config.hot_key_replica_reads_per_sec;
+        hot_key_max_replicas = config.hot_key_max_replicas;
+        disk_promotion_reads = config.disk_promotion_reads;
+        disk_promotion_window_sec = config.disk_promotion_window_sec;
+        memory_tier_target_ratio = config.memory_tier_target_ratio;
+        tier_demotion_min_idle_sec = config.tier_demotion_min_idle_sec;
+        cxl_min_object_size = config.cxl_min_object_size;
     }
 
     // Static factory method to create a builder
@@ -615,9 +1058,37 @@ inline MasterServiceConfig MasterServiceConfigBuilder::build() const {
     config.task_manager_config.processing_task_timeout_sec =
         processing_task_timeout_sec_;
     config.task_manager_config.max_retry_attempts = max_retry_attempts_;
+    config.task_manager_config.max_task_bytes_per_client =
+        max_task_bytes_per_client_;
     config.cxl_path = cxl_path_;
     config.cxl_size = cxl_size_;
     config.enable_cxl = enable_cxl_;
+    config.metadata_persist_dir = metadata_persist_dir_;
+    config.metadata_snapshot_interval_sec = metadata_snapshot_interval_sec_;
+    config.hot_replica_cache_size = hot_replica_cache_size_;
+    config.key_filter_bits_per_shard = key_filter_bits_per_shard_;
+    config.enable_key_prefix_index = enable_key_prefix_index_;
+    config.eviction_policy = eviction_policy_;
+    config.enable_tinylfu_admission = enable_tinylfu_admission_;
+    config.put_start_eviction_retries = put_start_eviction_retries_;
+    config.batch_put_contiguous = batch_put_contiguous_;
+    config.allocation_strategy = allocation_strategy_;
+    config.compaction_fragmentation_threshold =
+        compaction_fragmentation_threshold_;
+    config.compaction_moves_per_sec = compaction_moves_per_sec_;
+    config.rebalance_utilization_gap = rebalance_utilization_gap_;
+    config.rebalance_moves_per_sec = rebalance_moves_per_sec_;
+    config.tenant_quotas = tenant_quotas_;
+    config.lazy_lease_renewal_ratio = lazy_lease_renewal_ratio_;
+    config.enable_async_replica_reclaim = enable_async_replica_reclaim_;
+    config.hot_key_top_n = hot_key_top_n_;
+    config.hot_key_replica_reads_per_sec = hot_key_replica_reads_per_sec_;
+    config.hot_key_max_replicas = hot_key_max_replicas_;
+    config.disk_promotion_reads = disk_promotion_reads_;
+    config.disk_promotion_window_sec = disk_promotion_window_sec_;
+    config.memory_tier_target_ratio = memory_tier_target_ratio_;
+    config.tier_demotion_min_idle_sec = tier_demotion_min_idle_sec_;
+    config.cxl_min_object_size = cxl_min_object_size_;
     return config;
 }
 
@@ -635,6 +1106,7 @@ struct InProcMasterConfig {
     std::optional<bool> enable_cxl;
     std::optional<std::string> cxl_path;
     std::optional<size_t> cxl_size;
+    std::optional<std::string> root_fs_dir;
 };
 
 // Builder class for InProcMasterConfig
@@ -647,6 +1119,7 @@ class InProcMasterConfigBuilder {
     std::optional<bool> enable_cxl_ = std::nullopt;
     std::optional<std::string> cxl_path_ = std::nullopt;
     std::optional<size_t> cxl_size_ = std::nullopt;
+    std::optional<std::string> root_fs_dir_ = std::nullopt;
 
    public:
     InProcMasterConfigBuilder() = default;
@@ -686,6 +1159,11 @@ class InProcMasterConfigBuilder {
         return *this;
     }
 
+    InProcMasterConfigBuilder& set_root_fs_dir(const std::string& dir) {
+        root_fs_dir_ = dir;
+        return *this;
+    }
+
     InProcMasterConfig build() const;
 };
 
@@ -699,6 +1177,7 @@ inline InProcMasterConfig InProcMasterConfigBuilder::build() const {
     config.enable_cxl = enable_cxl_;
     config.cxl_path = cxl_path_;
     config.cxl_size = cxl_size_;
+    config.root_fs_dir = root_fs_dir_;
     return config;
 }
 
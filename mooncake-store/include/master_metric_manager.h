@@ -1,14 +1,23 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+#include "hybrid_metric.h"
 #include "ylt/metric/counter.hpp"
 #include "ylt/metric/gauge.hpp"
 #include "ylt/metric/histogram.hpp"
 
 namespace mooncake {
 
+struct AllocatorStats;
+
 class MasterMetricManager {
    public:
     // --- Singleton Access ---
@@ -81,11 +90,41 @@ class MasterMetricManager {
     int64_t get_key_count();
     int64_t get_soft_pin_key_count();
 
+    // Memory of the metadata key index, see FlatKeyMap::memory_usage
+    void inc_metadata_index_bytes(int64_t val);
+    void dec_metadata_index_bytes(int64_t val);
+    int64_t get_metadata_index_bytes();
+    double get_metadata_index_bytes_per_key();
+
     // Cluster Metrics
     void inc_active_clients(int64_t val = 1);
     void dec_active_clients(int64_t val = 1);
     int64_t get_active_clients();
 
+    // Tenant Metrics, see TenantQuotaManager
+    void inc_tenant_used_bytes(const std::string& tenant, int64_t val);
+    void dec_tenant_used_bytes(const std::string& tenant, int64_t val);
+    int64_t get_tenant_used_bytes(const std::string& tenant);
+    void inc_tenant_quota_exceeded(const std::string& tenant);
+    void inc_tenant_rate_limited(const std::string& tenant);
+    void inc_tenant_evicted_bytes(const std::string& tenant, int64_t val);
+
+    // Latency Metrics, per WrappedMasterService RPC. Buffered per thread
+    // and added to the histogram every kRpcLatencyFlushSamples
+    // observations, kRpcLatencyFlushInterval, or when serialized.
+    void observe_rpc_latency(std::string_view rpc, int64_t latency_us);
+
+    // Metadata shard lock contention, summed over all shards
+    void set_shard_lock_contention(int64_t contended, int64_t wait_us);
+
+    // Allocator Metrics, per segment
+    void observe_segment_allocation(const std::string& segment,
+                                    int64_t latency_ns, bool success);
+    // Replaces the free space of all segments, segments left out are
+    // dropped from the report
+    void set_segment_allocator_stats(
+        const std::unordered_map<std::string, AllocatorStats>& stats);
+
     // Operation Statistics (Counters)
     void inc_put_start_requests(int64_t val = 1);
     void inc_put_start_failures(int64_t val = 1);
@@ -95,6 +134,14 @@ class MasterMetricManager {
     void inc_put_revoke_failures(int64_t val = 1);
     void inc_get_replica_list_by_regex_requests(int64_t val = 1);
     void inc_get_replica_list_by_regex_failures(int64_t val = 1);
+    void inc_longest_cached_prefix_requests(int64_t val = 1);
+    void inc_longest_cached_prefix_failures(int64_t val = 1);
+    void inc_link_content_requests(int64_t val = 1);
+    void inc_link_content_failures(int64_t val = 1);
+    void inc_link_bundle_requests(int64_t val = 1);
+    void inc_link_bundle_failures(int64_t val = 1);
+    void inc_resolve_bundle_requests(int64_t val = 1);
+    void inc_resolve_bundle_failures(int64_t val = 1);
     void inc_get_replica_list_requests(int64_t val = 1);
     void inc_get_replica_list_failures(int64_t val = 1);
     void inc_exist_key_requests(int64_t val = 1);
@@ -103,6 +150,10 @@ class MasterMetricManager {
     void inc_remove_failures(int64_t val = 1);
     void inc_remove_by_regex_requests(int64_t val = 1);
     void inc_remove_by_regex_failures(int64_t val = 1);
+    void inc_remove_by_prefix_requests(int64_t val = 1);
+    void inc_remove_by_prefix_failures(int64_t val = 1);
+    void inc_scan_keys_requests(int64_t val = 1);
+    void inc_scan_keys_failures(int64_t val = 1);
     void inc_remove_all_requests(int64_t val = 1);
     void inc_remove_all_failures(int64_t val = 1);
     void inc_mount_segment_requests(int64_t val = 1);
@@ -111,6 +162,14 @@ class MasterMetricManager {
     void inc_unmount_segment_failures(int64_t val = 1);
     void inc_remount_segment_requests(int64_t val = 1);
     void inc_remount_segment_failures(int64_t val = 1);
+    void inc_drain_segment_requests(int64_t val = 1);
+    void inc_drain_segment_failures(int64_t val = 1);
+    void inc_get_key_filter_requests(int64_t val = 1);
+    void inc_get_key_filter_failures(int64_t val = 1);
+    void inc_put_commit_requests(int64_t val = 1);
+    void inc_put_commit_failures(int64_t val = 1);
+    void inc_get_committed_replica_list_requests(int64_t val = 1);
+    void inc_get_committed_replica_list_failures(int64_t val = 1);
     void inc_ping_requests(int64_t val = 1);
     void inc_ping_failures(int64_t val = 1);
 
@@ -148,12 +207,24 @@ class MasterMetricManager {
     int64_t get_get_replica_list_failures();
     int64_t get_get_replica_list_by_regex_requests();
     int64_t get_get_replica_list_by_regex_failures();
+    int64_t get_longest_cached_prefix_requests();
+    int64_t get_longest_cached_prefix_failures();
+    int64_t get_link_content_requests();
+    int64_t get_link_content_failures();
+    int64_t get_link_bundle_requests();
+    int64_t get_link_bundle_failures();
+    int64_t get_resolve_bundle_requests();
+    int64_t get_resolve_bundle_failures();
     int64_t get_exist_key_requests();
     int64_t get_exist_key_failures();
     int64_t get_remove_requests();
     int64_t get_remove_failures();
     int64_t get_remove_by_regex_requests();
     int64_t get_remove_by_regex_failures();
+    int64_t get_remove_by_prefix_requests();
+    int64_t get_remove_by_prefix_failures();
+    int64_t get_scan_keys_requests();
+    int64_t get_scan_keys_failures();
     int64_t get_remove_all_requests();
     int64_t get_remove_all_failures();
     int64_t get_mount_segment_requests();
@@ -162,6 +233,14 @@ class MasterMetricManager {
     int64_t get_unmount_segment_failures();
     int64_t get_remount_segment_requests();
     int64_t get_remount_segment_failures();
+    int64_t get_drain_segment_requests();
+    int64_t get_drain_segment_failures();
+    int64_t get_get_key_filter_requests();
+    int64_t get_get_key_filter_failures();
+    int64_t get_put_commit_requests();
+    int64_t get_put_commit_failures();
+    int64_t get_get_committed_replica_list_requests();
+    int64_t get_get_committed_replica_list_failures();
     int64_t get_ping_requests();
     int64_t get_ping_failures();
 
@@ -212,6 +291,24 @@ class MasterMetricManager {
     int64_t get_evicted_key_count();
     int64_t get_evicted_size();
 
+    // Objects removed once their ReplicateConfig::ttl_ms passed
+    void inc_ttl_expired_keys(int64_t val = 1);
+    int64_t get_ttl_expired_key_count();
+
+    // Tiering Metrics, objects queued to be offloaded to the local disk tier
+    void inc_tier_demotion(int64_t key_count, int64_t size);
+    int64_t get_demoted_key_count();
+    int64_t get_demoted_size();
+
+    // Deduplication Metrics, keys linked to content-addressed objects
+    void set_dedup_stats(int64_t linked_keys, int64_t content_objects,
+                         int64_t saved_bytes);
+    int64_t get_dedup_linked_keys();
+    int64_t get_dedup_content_objects();
+    int64_t get_dedup_saved_bytes();
+    // Linked keys per content object, 0 without linked keys
+    double get_dedup_ratio();
+
     // PutStart Discard Metrics
     void inc_put_start_discard_cnt(int64_t count, int64_t size);
     void inc_put_start_release_cnt(int64_t count, int64_t size);
@@ -295,6 +392,18 @@ class MasterMetricManager {
     // Update all metrics once to ensure zero values are serialized
     void update_metrics_for_zero_output();
 
+    // The RPC threads would otherwise contend on the label maps of
+    // rpc_latency_us_ for every request
+    struct RpcLatencyBuffer;
+    static constexpr size_t kRpcLatencyFlushSamples = 256;
+    static constexpr std::chrono::milliseconds kRpcLatencyFlushInterval{100};
+    RpcLatencyBuffer& local_rpc_latency_buffer();
+    // Called with the mutex of the buffer held
+    void flush_rpc_latency(RpcLatencyBuffer& buffer);
+    void flush_rpc_latencies();
+    std::mutex rpc_latency_buffers_mutex_;
+    std::vector<std::shared_ptr<RpcLatencyBuffer>> rpc_latency_buffers_;
+
     // --- Metric Members ---
 
     // Memory Storage Metrics
@@ -316,11 +425,36 @@ class MasterMetricManager {
     // Key/Value Metrics
     ylt::metric::gauge_t key_count_;
     ylt::metric::gauge_t soft_pin_key_count_;
+    ylt::metric::gauge_t metadata_index_bytes_;
+    // Derived from metadata_index_bytes_ and key_count_ on serialization
+    ylt::metric::gauge_t metadata_index_bytes_per_key_;
     ylt::metric::histogram_t value_size_distribution_;
 
     // Cluster Metrics
     ylt::metric::gauge_t active_clients_;
 
+    // Tenant Metrics
+    ylt::metric::dynamic_gauge_1t tenant_used_bytes_;
+    ylt::metric::dynamic_counter_1t tenant_quota_exceeded_;
+    ylt::metric::dynamic_counter_1t tenant_rate_limited_;
+    ylt::metric::dynamic_counter_1t tenant_evicted_bytes_;
+
+    // Latency Metrics
+    ylt::metric::hybrid_histogram_1t rpc_latency_us_;
+    ylt::metric::gauge_t shard_lock_contended_;
+    ylt::metric::gauge_t shard_lock_wait_us_;
+
+    // Allocator Metrics
+    ylt::metric::dynamic_gauge_1t segment_free_bytes_;
+    ylt::metric::dynamic_gauge_1t segment_largest_free_region_;
+    ylt::metric::dynamic_gauge_1t segment_free_regions_;
+    ylt::metric::dynamic_gauge_1t segment_fragmentation_percent_;
+    ylt::metric::hybrid_histogram_1t segment_allocation_latency_ns_;
+    ylt::metric::dynamic_counter_1t segment_allocation_failures_;
+    std::mutex segment_allocator_stats_mutex_;
+    // Segments in the last set_segment_allocator_stats
+    std::unordered_set<std::string> segment_allocator_stats_names_;
+
     // Operation Statistics
     ylt::metric::counter_t put_start_requests_;
     ylt::metric::counter_t put_start_failures_;
@@ -332,12 +466,24 @@ class MasterMetricManager {
     ylt::metric::counter_t get_replica_list_failures_;
     ylt::metric::counter_t get_replica_list_by_regex_requests_;
     ylt::metric::counter_t get_replica_list_by_regex_failures_;
+    ylt::metric::counter_t longest_cached_prefix_requests_;
+    ylt::metric::counter_t longest_cached_prefix_failures_;
+    ylt::metric::counter_t link_content_requests_;
+    ylt::metric::counter_t link_content_failures_;
+    ylt::metric::counter_t link_bundle_requests_;
+    ylt::metric::counter_t link_bundle_failures_;
+    ylt::metric::counter_t resolve_bundle_requests_;
+    ylt::metric::counter_t resolve_bundle_failures_;
     ylt::metric::counter_t exist_key_requests_;
     ylt::metric::counter_t exist_key_failures_;
     ylt::metric::counter_t remove_requests_;
     ylt::metric::counter_t remove_failures_;
     ylt::metric::counter_t remove_by_regex_requests_;
     ylt::metric::counter_t remove_by_regex_failures_;
+    ylt::metric::counter_t remove_by_prefix_requests_;
+    ylt::metric::counter_t remove_by_prefix_failures_;
+    ylt::metric::counter_t scan_keys_requests_;
+    ylt::metric::counter_t scan_keys_failures_;
     ylt::metric::counter_t remove_all_requests_;
     ylt::metric::counter_t remove_all_failures_;
     ylt::metric::counter_t mount_segment_requests_;
@@ -346,6 +492,14 @@ class MasterMetricManager {
     ylt::metric::counter_t unmount_segment_failures_;
     ylt::metric::counter_t remount_segment_requests_;
     ylt::metric::counter_t remount_segment_failures_;
+    ylt::metric::counter_t drain_segment_requests_;
+    ylt::metric::counter_t drain_segment_failures_;
+    ylt::metric::counter_t get_key_filter_requests_;
+    ylt::metric::counter_t get_key_filter_failures_;
+    ylt::metric::counter_t put_commit_requests_;
+    ylt::metric::counter_t put_commit_failures_;
+    ylt::metric::counter_t get_committed_replica_list_requests_;
+    ylt::metric::counter_t get_committed_replica_list_failures_;
     ylt::metric::counter_t ping_requests_;
     ylt::metric::counter_t ping_failures_;
 
@@ -410,6 +564,19 @@ class MasterMetricManager {
     ylt::metric::counter_t eviction_attempts_;
     ylt::metric::counter_t evicted_key_count_;
     ylt::metric::counter_t evicted_size_;
+    ylt::metric::counter_t ttl_expired_key_count_;
+
+    // Tiering Metrics
+    ylt::metric::counter_t demoted_key_count_;
+    ylt::metric::counter_t demoted_size_;
+
+    // Deduplication Metrics
+    ylt::metric::gauge_t dedup_linked_keys_;
+    ylt::metric::gauge_t dedup_content_objects_;
+    ylt::metric::gauge_t dedup_saved_bytes_;
+    // Derived from dedup_linked_keys_ and dedup_content_objects_ on
+    // serialization, in percent
+    ylt::metric::gauge_t dedup_ratio_percent_;
 
     // PutStart Discard Metrics
     ylt::metric::counter_t put_start_discard_cnt_;
@@ -2,7 +2,6 @@
 
 #include <atomic>
 #include <boost/functional/hash.hpp>
-#include <boost/lockfree/queue.hpp>
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
@@ -19,7 +18,19 @@
 #include <ylt/util/tl/expected.hpp>
 
 #include "allocation_strategy.h"
+#include "bundle_index.h"
+#include "client_lease_table.h"
+#include "content_index.h"
+#include "disk_promotion_tracker.h"
+#include "flat_key_map.h"
+#include "frequency_sketch.h"
+#include "ghost_queue.h"
+#include "hot_key_tracker.h"
+#include "hot_replica_cache.h"
+#include "key_filter.h"
+#include "key_radix_tree.h"
 #include "master_metric_manager.h"
+#include "metadata_persistence.h"
 #include "mutex.h"
 #include "segment.h"
 #include "types.h"
@@ -27,6 +38,8 @@
 #include "rpc_types.h"
 #include "replica.h"
 #include "task_manager.h"
+#include "tenant_quota.h"
+#include "timing_wheel.h"
 
 namespace mooncake {
 // Forward declarations
@@ -39,6 +52,8 @@ class EvictionStrategy;
  * 1. client_mutex_
  * 2. metadata_shards_[shard_idx_].mutex
  * 3. segment_mutex_
+ * pending_restore_mutex_ and the locks inside client_leases_ are leaf
+ * locks, no other lock is acquired while holding them.
  */
 class MasterService {
    public:
@@ -90,12 +105,33 @@ class MasterService {
     std::vector<tl::expected<bool, ErrorCode>> BatchExistKey(
         const std::vector<std::string>& keys);
 
+    /**
+     * @brief Get the key filters of the metadata shards changed after the
+     * sequence number since, all of them if since is 0
+     * @return UNAVAILABLE_IN_CURRENT_MODE if the key filter is disabled
+     */
+    auto GetKeyFilter(uint64_t since)
+        -> tl::expected<GetKeyFilterResponse, ErrorCode>;
+
     /**
      * @brief Fetch all keys
      * @return ErrorCode::OK if exists
      */
     auto GetAllKeys() -> tl::expected<std::vector<std::string>, ErrorCode>;
 
+    /**
+     * @brief Fetch one page of the keys starting with prefix. Pages are made
+     * of whole shards, starting at the shard given by cursor, until at least
+     * limit keys are collected, so only one shard is locked at a time.
+     * @param cursor 0 for the first page, then the next_cursor of the
+     * previous page
+     * @return The keys of the page and the cursor of the next one, 0 once
+     * all shards are scanned. Keys present during the whole scan are
+     * returned exactly once.
+     */
+    auto ScanKeys(const std::string& prefix, uint64_t cursor, size_t limit)
+        -> tl::expected<ScanKeysResponse, ErrorCode>;
+
     /**
      * @brief Fetch all segments, each node has a unique real client with fixed
      * segment name : segment name, preferred format : {ip}:{port}, bad format :
@@ -112,6 +148,23 @@ class MasterService {
     auto QuerySegments(const std::string& segment)
         -> tl::expected<std::pair<size_t, size_t>, ErrorCode>;
 
+    /**
+     * @brief Stop allocating in a segment and move its objects to the other
+     * segments, so that it can be unmounted without losing them. With
+     * draining false, the segment takes new objects again.
+     * @return ErrorCode::SEGMENT_NOT_FOUND if no such segment is mounted
+     */
+    auto DrainSegment(const std::string& segment, bool draining = true)
+        -> tl::expected<void, ErrorCode>;
+
+    /**
+     * @brief Drain one segment of a client ahead of UnmountSegment. Called
+     * repeatedly until the segment is empty, hot objects are moved first.
+     * @return Bytes still held by the segment
+     */
+    auto DrainSegment(const UUID& segment_id, const UUID& client_id)
+        -> tl::expected<uint64_t, ErrorCode>;
+
     /**
      * @brief Query IP addresses for a given client ID.
      * @param client_id The UUID of the client to query.
@@ -171,6 +224,59 @@ class MasterService {
     auto GetReplicaList(const std::string& key)
         -> tl::expected<GetReplicaListResponse, ErrorCode>;
 
+    /**
+     * @brief Get the replicas of the longest prefix of keys that is cached,
+     * e.g. the leading blocks of a chain of KV-cache block hashes. Stops at
+     * the first key that is not found or has no complete replica.
+     * @return The replica lists of keys[0, n), where n is the number of
+     * leading hits. A lease is granted on every returned key.
+     */
+    auto LongestCachedPrefix(const std::vector<std::string>& keys)
+        -> tl::expected<std::vector<GetReplicaListResponse>, ErrorCode>;
+
+    /**
+     * @brief Link the key to the content-addressed object content_key, put
+     * by a client with deduplication on. Reads of the key are then served
+     * from the replicas of content_key, which is removed with the last key
+     * linked to it. Links are not written to the metadata WAL, so they are
+     * refused while it is enabled, and not listed with the keys.
+     * @return ErrorCode::OK on success or if the key is already linked to
+     * content_key, ErrorCode::OBJECT_NOT_FOUND if content_key has no
+     * complete replica, ErrorCode::OBJECT_ALREADY_EXISTS if the key exists,
+     * ErrorCode::UNAVAILABLE_IN_CURRENT_MODE if metadata persistence is on
+     */
+    auto LinkContent(const std::string& key, const std::string& content_key)
+        -> tl::expected<void, ErrorCode>;
+
+    /**
+     * @brief Link the keys to consecutive ranges of the bundle object
+     * bundle_key, of the given sizes from its start. The keys take no object
+     * metadata of their own: they share the lease and replicas of the
+     * bundle, which is removed with the last key linked to it. Keys are read
+     * as ranges of the bundle, see BatchResolveBundle. Links are not written
+     * to the metadata WAL, so they are refused while it is enabled, and not
+     * listed with the keys.
+     * @return ErrorCode::OK on success, or if the keys are already linked
+     * to the same ranges, ErrorCode::OBJECT_NOT_FOUND if bundle_key has no
+     * complete replica, ErrorCode::INVALID_PARAMS if the ranges do not fit
+     * in it, ErrorCode::OBJECT_ALREADY_EXISTS if a key exists,
+     * ErrorCode::UNAVAILABLE_IN_CURRENT_MODE if metadata persistence is on.
+     * No key is linked on failure, and a bundle object left without keys
+     * is removed.
+     */
+    auto LinkBundle(const std::string& bundle_key,
+                    const std::vector<std::string>& keys,
+                    const std::vector<uint64_t>& sizes)
+        -> tl::expected<void, ErrorCode>;
+
+    /**
+     * @brief Ranges of the bundle objects the keys are stored as
+     * @return Per key, ErrorCode::OBJECT_NOT_FOUND if the key is not linked
+     * to a bundle or the bundle object is gone
+     */
+    std::vector<tl::expected<BundleMember, ErrorCode>> BatchResolveBundle(
+        const std::vector<std::string>& keys);
+
     /**
      * @brief Start a put operation for an object
      * @param[out] replica_list Vector to store replica information for the
@@ -178,11 +284,25 @@ class MasterService {
      * @return ErrorCode::OK on success, ErrorCode::OBJECT_NOT_FOUND if exists,
      *         ErrorCode::NO_AVAILABLE_HANDLE if allocation fails,
      *         ErrorCode::INVALID_PARAMS if slice size is invalid
+     * @note If allocation fails, up to put_start_eviction_retries times
+     * objects are evicted from the target segments and the allocation is
+     * retried before returning.
      */
     auto PutStart(const UUID& client_id, const std::string& key,
                   const uint64_t slice_length, const ReplicateConfig& config)
         -> tl::expected<std::vector<Replica::Descriptor>, ErrorCode>;
 
+    /**
+     * @brief Start a batch of put operations with the same config. The keys
+     * are grouped by metadata shard and every shard is locked once for all
+     * of its keys, instead of once per key as with PutStart.
+     * @return One result per key, see PutStart
+     */
+    std::vector<tl::expected<std::vector<Replica::Descriptor>, ErrorCode>>
+    BatchPutStart(const UUID& client_id, const std::vector<std::string>& keys,
+                  const std::vector<uint64_t>& slice_lengths,
+                  const ReplicateConfig& config);
+
     /**
      * @brief Complete a put operation, replica_type indicates the type of
      * replica to complete (memory or disk)
@@ -192,6 +312,26 @@ class MasterService {
     auto PutEnd(const UUID& client_id, const std::string& key,
                 ReplicaType replica_type) -> tl::expected<void, ErrorCode>;
 
+    /**
+     * @brief Make bytes [0, committed_bytes) of an object being put readable
+     * before PutEnd, once the client wrote them to every memory replica
+     * @return ErrorCode::OK on success, ErrorCode::OBJECT_NOT_FOUND if not
+     * found, ErrorCode::ILLEGAL_CLIENT if put by another client,
+     * ErrorCode::INVALID_PARAMS if past the end of the object or below the
+     * bytes already committed
+     */
+    auto PutCommit(const UUID& client_id, const std::string& key,
+                   uint64_t committed_bytes) -> tl::expected<void, ErrorCode>;
+
+    /**
+     * @brief Get the replicas of an object and how much of it is readable.
+     * Completed objects are returned as by GetReplicaList, objects being put
+     * with their memory replicas once PutCommit committed some bytes.
+     * @return ErrorCode::REPLICA_IS_NOT_READY if nothing is committed yet
+     */
+    auto GetCommittedReplicaList(const std::string& key)
+        -> tl::expected<GetCommittedReplicaListResponse, ErrorCode>;
+
     /**
      * @brief Adds a replica instance associated with the given client and key.
      */
@@ -230,7 +370,8 @@ class MasterService {
      *
      * @param client_id the client that submit the CopyStart request
      * @param key key of the object
-     * @param src_segment source segment name of the replica to copy from
+     * @param src_segment source segment name of the replica to copy from,
+     * empty to copy from the disk replica
      * @param tgt_segments target segment names of the replicas to copy to
      *
      * @return allocated replicas on success, or ErrorCode indicating the
@@ -297,20 +438,65 @@ class MasterService {
      */
     long RemoveAll(bool force = false);
 
+    /**
+     * @brief Wait until the metadata changes made so far are in the WAL on
+     * disk, so that they can be acked. Changes are written in batches, one
+     * fsync for all callers waiting at the same time. Must not be called
+     * with a shard lock held.
+     * @return ErrorCode::OK, also if persistence is disabled, or the error
+     * writing the WAL
+     */
+    ErrorCode SyncMetadata();
+
+    /**
+     * @brief Removes the objects whose keys start with prefix in the
+     * background. Shards are processed one after another and keys are
+     * removed in small batches, so no lock is held for long.
+     * @param force If true, skip lease checks.
+     * @return The id of the task, whose progress and removed count are
+     * reported in the message returned by QueryTask.
+     */
+    auto RemoveByPrefix(const std::string& prefix, bool force = false)
+        -> tl::expected<UUID, ErrorCode>;
+
     /**
      * @brief Get the count of keys
      * @return The count of keys
      */
     size_t GetKeyCount() const;
 
+    /**
+     * @brief Get the most read keys, hottest first
+     * @return Empty unless hot key tracking is enabled
+     */
+    std::vector<HotKeyTracker::HotKey> GetHotKeys() const;
+
+    /**
+     * @brief Get the lock contention of every metadata shard
+     * @return Pairs of shard index and its contention, most waited on first
+     */
+    std::vector<std::pair<size_t, SharedMutex::ContentionStats>>
+    GetShardLockStats() const;
+
+    /**
+     * @brief Get the free space of every mounted segment, summed over its
+     * allocators
+     * @return Segment name to its stats
+     */
+    std::unordered_map<std::string, AllocatorStats> GetSegmentAllocatorStats();
+
     /**
      * @brief Heartbeat from client
      * @param client_id The uuid of the client
-     * @return PingResponse containing view version and client status
+     * @param transfer_bytes_per_sec Recent transfer throughput of the client,
+     * used by the load aware allocation strategy
+     * @return PingResponse containing view version, client status, the
+     * replica invalidation epoch and the capacity signal
      * @return ErrorCode::OK on success, ErrorCode::INTERNAL_ERROR if the client
      *         ping queue is full
      */
-    auto Ping(const UUID& client_id) -> tl::expected<PingResponse, ErrorCode>;
+    auto Ping(const UUID& client_id, uint64_t transfer_bytes_per_sec = 0)
+        -> tl::expected<PingResponse, ErrorCode>;
 
     /**
      * @brief Get the master service cluster ID to use as subdirectory name
@@ -338,8 +524,11 @@ class MasterService {
      * set of non-offloaded objects.
      * @param enable_offloading Indicates whether offloading is enabled for this
      * segment.
+     * @param max_objects At most this many objects are returned, the others
+     * stay queued for the next heartbeats. 0 returns all of them.
      */
-    auto OffloadObjectHeartbeat(const UUID& client_id, bool enable_offloading)
+    auto OffloadObjectHeartbeat(const UUID& client_id, bool enable_offloading,
+                                uint64_t max_objects = 0)
         -> tl::expected<std::unordered_map<std::string, int64_t>, ErrorCode>;
 
     /**
@@ -360,16 +549,18 @@ class MasterService {
      * @return Copy task ID on success, ErrorCode on failure
      */
     tl::expected<UUID, ErrorCode> CreateCopyTask(
-        const std::string& key, const std::vector<std::string>& targets);
+        const std::string& key, const std::vector<std::string>& targets,
+        TaskPriority priority = TaskPriority::NORMAL);
 
     /**
      * @brief Create a move task to move an object's replica from source segment
      * to target segment
      * @return Move task ID on success, ErrorCode on failure
      */
-    tl::expected<UUID, ErrorCode> CreateMoveTask(const std::string& key,
-                                                 const std::string& source,
-                                                 const std::string& target);
+    tl::expected<UUID, ErrorCode> CreateMoveTask(
+        const std::string& key, const std::string& source,
+        const std::string& target,
+        TaskPriority priority = TaskPriority::NORMAL);
 
     /**
      * @brief Query the status of a task
@@ -414,6 +605,59 @@ class MasterService {
     // And also we can add some task ttl mechanism in the future
     void TaskCleanupThreadFunc();
 
+    // Move small objects out of the most fragmented memory segment, at most
+    // compaction_moves_per_sec_ moves in flight per round
+    void CompactionThreadFunc();
+    void CompactSegments();
+
+    // Move objects off draining segments, and from the most to the least
+    // utilized segment while they differ by more than
+    // rebalance_utilization_gap_, at most rebalance_moves_per_sec_ moves in
+    // flight per round
+    void RebalanceThreadFunc();
+    void RebalanceSegments();
+    // Runs a round now, after segments came or went
+    void WakeRebalancer();
+
+    // Add a replica per round to the keys read more than
+    // hot_key_replica_reads_per_sec_ times a second, and drop the replicas
+    // added to keys read less than half as often
+    void HotKeyReplicationThreadFunc();
+    void AmplifyHotKeys();
+    // A mounted segment without a replica of the key with room for it, none
+    // if the key has max_memory_replicas memory replicas already
+    std::optional<std::string> SelectReplicaTarget(const std::string& key,
+                                                   size_t max_memory_replicas);
+    // Drop the replicas of the key on the segments, as long as another
+    // complete memory replica is left. Returns false to retry later.
+    bool DropHotKeyReplicas(const std::string& key,
+                            const std::vector<std::string>& segments);
+
+    // Count a read of an object without memory replicas, and wake the
+    // promotion thread once the object is read often enough
+    void RecordDiskRead(const std::string& key,
+                        const std::vector<Replica::Descriptor>& replicas);
+    // Ask the client of a segment with room for the object to copy its disk
+    // replica into memory
+    void DiskPromotionThreadFunc();
+    void PromoteDiskReplica(const std::string& key);
+
+    // While the memory usage is above memory_tier_target_ratio_, queue the
+    // coldest objects unread for tier_demotion_min_idle_ for offloading to
+    // the local disk tier, so that evicting their memory replicas later keeps
+    // them readable
+    void TieringThreadFunc();
+    void DemoteColdObjects();
+
+    // Runs the tasks of the master itself, e.g. those of RemoveByPrefix
+    void MasterTaskThreadFunc();
+    void RunPrefixRemoval(const Task& task);
+
+    // Removes the content or bundle objects left without linked keys. Those
+    // with a lease are left to eviction.
+    void RemoveOrphanedContents(const std::vector<std::string>& content_keys,
+                                bool force);
+
     // Internal data structures
     struct ObjectMetadata {
         // RAII-style metric management
@@ -422,6 +666,7 @@ class MasterService {
             if (soft_pin_timeout) {
                 MasterMetricManager::instance().dec_soft_pin_key_count(1);
             }
+            ReleaseTenantBytes();
         }
 
         ObjectMetadata() = delete;
@@ -430,10 +675,15 @@ class MasterService {
             const UUID& client_id_,
             const std::chrono::steady_clock::time_point put_start_time_,
             size_t value_length, std::vector<Replica>&& reps,
-            bool enable_soft_pin)
+            bool enable_soft_pin, uint32_t recompute_cost_ = 0,
+            std::shared_ptr<TenantUsage> tenant_ = nullptr,
+            uint64_t tenant_bytes_ = 0)
             : client_id(client_id_),
               put_start_time(put_start_time_),
               size(value_length),
+              recompute_cost(recompute_cost_),
+              tenant(std::move(tenant_)),
+              tenant_bytes(tenant_bytes_),
               lease_timeout(),
               soft_pin_timeout(std::nullopt),
               replicas_(std::move(reps)) {
@@ -453,15 +703,62 @@ class MasterService {
         const UUID client_id;
         const std::chrono::steady_clock::time_point put_start_time;
         const size_t size;
+        // Hint from ReplicateConfig, not persisted
+        const uint32_t recompute_cost;
+        // Tenant charged with tenant_bytes of segment memory by PutStart,
+        // not persisted
+        const std::shared_ptr<TenantUsage> tenant;
+        uint64_t tenant_bytes;
+        // Prefix readable before PutEnd, see PutCommit. Not persisted.
+        uint64_t committed_bytes{0};
+        // From ReplicateConfig::ttl_ms, not persisted. The object expires
+        // at expire_time, set once its put completed.
+        std::chrono::milliseconds ttl{0};
+        std::optional<std::chrono::steady_clock::time_point> expire_time;
+
+        // Return the charged bytes to the tenant, e.g. once the memory
+        // replicas are evicted
+        void ReleaseTenantBytes() {
+            if (tenant && tenant_bytes > 0) {
+                tenant->Release(tenant_bytes);
+                tenant_bytes = 0;
+            }
+        }
+
+        // Account the eviction of num_evicted memory replicas, each
+        // returning its size to the tenant. Whatever is left of the charge,
+        // e.g. of a striped replica, is returned with the last one.
+        void OnMemoryReplicasEvicted(size_t num_evicted) {
+            if (!tenant || num_evicted == 0) {
+                return;
+            }
+            tenant->RecordEviction(size * num_evicted);
+            if (!HasReplica(&Replica::fn_is_in_memory)) {
+                ReleaseTenantBytes();
+                return;
+            }
+            const uint64_t bytes =
+                std::min<uint64_t>(size * num_evicted, tenant_bytes);
+            tenant->Release(bytes);
+            tenant_bytes -= bytes;
+        }
 
         mutable SpinLock lock;
         // Default constructor, creates a time_point representing
         // the Clock's epoch (i.e., time_since_epoch() is zero).
-        mutable std::chrono::steady_clock::time_point lease_timeout
-            GUARDED_BY(lock);  // hard lease
+        // Hard lease. Only extended under lock, but read without it so that
+        // reads of leased objects need not write the metadata.
+        mutable std::atomic<std::chrono::steady_clock::time_point>
+            lease_timeout;
         mutable std::optional<std::chrono::steady_clock::time_point>
             soft_pin_timeout GUARDED_BY(lock);  // optional soft pin, only
                                                 // set for vip objects
+        // Reads since the last eviction pass, used by the SIEVE and S3FIFO
+        // eviction policies
+        mutable uint8_t access_freq GUARDED_BY(lock){0};
+        // Whether S3FIFO moved the object from its small queue to the main
+        // queue
+        mutable bool in_main_queue GUARDED_BY(lock){false};
 
         void AddReplicas(std::vector<Replica>&& replicas) {
             replicas_.insert(replicas_.end(),
@@ -584,8 +881,10 @@ class MasterService {
             SpinLocker locker(&lock);
             std::chrono::steady_clock::time_point now =
                 std::chrono::steady_clock::now();
-            lease_timeout =
-                std::max(lease_timeout, now + std::chrono::milliseconds(ttl));
+            lease_timeout.store(
+                std::max(lease_timeout.load(std::memory_order_relaxed),
+                         now + std::chrono::milliseconds(ttl)),
+                std::memory_order_relaxed);
             if (soft_pin_timeout) {
                 soft_pin_timeout =
                     std::max(*soft_pin_timeout,
@@ -593,16 +892,79 @@ class MasterService {
             }
         }
 
+        /**
+         * @brief GrantLease for reads, skipped while at least min_ttl of
+         * the lease is left. The soft pin is extended along with the lease.
+         * @return Milliseconds left on the lease
+         */
+        uint64_t RenewLease(const uint64_t ttl, const uint64_t soft_ttl,
+                            const uint64_t min_ttl) const {
+            if (min_ttl < ttl) {
+                const auto now = std::chrono::steady_clock::now();
+                const auto left =
+                    lease_timeout.load(std::memory_order_relaxed) - now;
+                if (left >= std::chrono::milliseconds(min_ttl)) {
+                    return std::chrono::duration_cast<
+                               std::chrono::milliseconds>(left)
+                        .count();
+                }
+            }
+            GrantLease(ttl, soft_ttl);
+            return ttl;
+        }
+
+        static constexpr uint8_t kMaxAccessFreq = 3;
+
+        void RecordAccess() const {
+            SpinLocker locker(&lock);
+            access_freq = std::min<uint8_t>(access_freq + 1, kMaxAccessFreq);
+        }
+
+        uint8_t GetAccessFreq() const {
+            SpinLocker locker(&lock);
+            return access_freq;
+        }
+
+        // Called when an eviction pass spares the object because it was
+        // read. Clears the visited bit of SIEVE.
+        void DecayAccessFreq(bool reset) const {
+            SpinLocker locker(&lock);
+            access_freq = reset || access_freq == 0 ? 0 : access_freq - 1;
+        }
+
+        bool InMainQueue() const {
+            SpinLocker locker(&lock);
+            return in_main_queue;
+        }
+
+        void EnterMainQueue() const {
+            SpinLocker locker(&lock);
+            in_main_queue = true;
+        }
+
+        // Called when an S3FIFO eviction pass spares the object because it
+        // was read. A read object of the small queue moves to the main
+        // queue and starts over, one in the main queue is reinserted with
+        // its frequency decayed by one.
+        void S3FifoSecondChance() const {
+            SpinLocker locker(&lock);
+            if (!in_main_queue) {
+                in_main_queue = true;
+                access_freq = 0;
+            } else if (access_freq > 0) {
+                --access_freq;
+            }
+        }
+
         // Check if the lease has expired
         bool IsLeaseExpired() const {
-            SpinLocker locker(&lock);
-            return std::chrono::steady_clock::now() >= lease_timeout;
+            return std::chrono::steady_clock::now() >=
+                   lease_timeout.load(std::memory_order_relaxed);
         }
 
         // Check if the lease has expired
         bool IsLeaseExpired(std::chrono::steady_clock::time_point& now) const {
-            SpinLocker locker(&lock);
-            return now >= lease_timeout;
+            return now >= lease_timeout.load(std::memory_order_relaxed);
         }
 
         // Check if is in soft pin status
@@ -623,7 +985,7 @@ class MasterService {
         // than 0
         bool IsValid() const {
             return size > 0 && HasReplica([](const Replica& replica) {
-                       return !replica.is_memory_replica() ||
+                       return !Replica::fn_is_in_memory(replica) ||
                               !replica.has_invalid_mem_handle();
                    });
         }
@@ -659,11 +1021,31 @@ class MasterService {
 
     static constexpr size_t kNumShards = 1024;  // Number of metadata shards
 
+    // Reports the memory of the metadata key index to the metrics
+    struct MetadataIndexMemoryTracker {
+        static void Add(int64_t delta) {
+            if (delta > 0) {
+                MasterMetricManager::instance().inc_metadata_index_bytes(delta);
+            } else if (delta < 0) {
+                MasterMetricManager::instance().dec_metadata_index_bytes(
+                    -delta);
+            }
+        }
+    };
+    using MetadataMap = FlatKeyMap<ObjectMetadata, MetadataIndexMemoryTracker>;
+
     // Sharded metadata maps and their mutexes
     struct MetadataShard {
         mutable SharedMutex mutex;
-        std::unordered_map<std::string, ObjectMetadata> metadata
-            GUARDED_BY(mutex);
+        // Optional prefix index over the keys of metadata, kept in sync as
+        // its observer. Costs memory on top of the keys and only speeds up
+        // anchored regex queries. Declared first so that it outlives
+        // metadata.
+        std::unique_ptr<KeyRadixTree> key_index GUARDED_BY(mutex);
+        // Optional filter over the keys of metadata, exported to clients.
+        // Observer of metadata, forwarding to key_index.
+        std::unique_ptr<KeyFilterShard> key_filter GUARDED_BY(mutex);
+        MetadataMap metadata GUARDED_BY(mutex);
         std::unordered_set<std::string> processing_keys GUARDED_BY(mutex);
         std::unordered_map<std::string, const ReplicationTask> replication_tasks
             GUARDED_BY(mutex);
@@ -676,7 +1058,9 @@ class MasterService {
         MetadataShardAccessorRW(MasterService* master_service,
                                 size_t shard_index)
             : shard_(master_service->metadata_shards_[shard_index]),
-              lock_(&shard_.mutex) {}
+              lock_(&shard_.mutex) {
+            master_service->hot_replica_cache_.InvalidateShard(shard_index);
+        }
 
         MetadataShard* operator->() { return &shard_; }
 
@@ -702,6 +1086,11 @@ class MasterService {
         SharedMutexLocker lock_;
     };
 
+    // Append the keys of the shard starting with prefix to keys
+    static void CollectShardKeys(const MetadataShardAccessorRO& shard,
+                                 const std::string& prefix,
+                                 std::vector<std::string>& keys);
+
     // Helper to get shard index from key
     size_t getShardIndex(const std::string& key) const {
         return std::hash<std::string>{}(key) % kNumShards;
@@ -710,9 +1099,21 @@ class MasterService {
     // Helper to clean up stale handles pointing to unmounted segments
     bool CleanupStaleHandles(ObjectMetadata& metadata);
 
+    // Record a read of an object for the eviction policy
+    void RecordAccess(const std::string& key, const ObjectMetadata& metadata);
+
+    // Order in which BatchEvict evicts objects, smallest first
+    using EvictionRank =
+        std::pair<double, std::chrono::steady_clock::time_point>;
+    EvictionRank GetEvictionRank(const std::string& key,
+                                 const ObjectMetadata& metadata) const;
+
     /**
      * @brief Helper to discard expired processing keys.
      */
+    // Remove the objects whose TTL expired by now
+    void ExpireObjects(const std::chrono::steady_clock::time_point& now);
+
     void DiscardExpiredProcessingReplicas(
         MetadataShardAccessorRW& shard,
         const std::chrono::steady_clock::time_point& now);
@@ -724,15 +1125,108 @@ class MasterService {
     uint64_t ReleaseExpiredDiscardedReplicas(
         const std::chrono::steady_clock::time_point& now);
 
+    /**
+     * @brief Free the segment memory of removed or evicted replicas, batched
+     * per allocator. Handed to the reclaim thread when async replica reclaim
+     * is enabled and allow_async is set, freed in the calling thread
+     * otherwise.
+     */
+    void ReclaimReplicas(std::vector<Replica>&& replicas,
+                         bool allow_async = true);
+    void ReclaimThreadFunc();
+
+    // Check the parameters of a PutStart
+    auto ValidatePutStart(const std::string& key, const uint64_t slice_length,
+                          const ReplicateConfig& config) const
+        -> tl::expected<void, ErrorCode>;
+
+    // PutStart without evicting on allocation failure
+    auto PutStartOnce(const UUID& client_id, const std::string& key,
+                      const uint64_t slice_length,
+                      const ReplicateConfig& config)
+        -> tl::expected<std::vector<Replica::Descriptor>, ErrorCode>;
+
+    // PutStart of a validated key, with its shard locked and the allocators
+    // accessed by the caller. A buffer given by the caller is used as the
+    // memory replica instead of allocating one.
+    auto PutStartLocked(MetadataShardAccessorRW& shard,
+                        const AllocatorManager& allocator_manager,
+                        const UUID& client_id, const std::string& key,
+                        const uint64_t slice_length,
+                        const ReplicateConfig& config,
+                        std::chrono::steady_clock::time_point now,
+                        std::unique_ptr<AllocatedBuffer>* buffer = nullptr)
+        -> tl::expected<std::vector<Replica::Descriptor>, ErrorCode>;
+
+    // Allocates one extent for the keys at the given indices and splits it
+    // into one buffer per key, in order, so that the transfers of the keys
+    // coalesce. Returns a buffer per slice length, null for the keys not
+    // given or if the extent could not be allocated or split.
+    auto AllocateBatchExtent(const std::vector<uint64_t>& slice_lengths,
+                             const std::vector<size_t>& indices,
+                             const ReplicateConfig& config)
+        -> std::vector<std::unique_ptr<AllocatedBuffer>>;
+
+    /**
+     * @brief Evict memory replicas in the given segments, or in any segment
+     * if segment_names is empty, until required_size bytes are freed. Evicts
+     * from up to kSegmentEvictionMaxShards shards, continuing from where the
+     * previous call stopped. If admission_freq is set, objects whose sketch
+     * estimate is not below it are kept.
+     * @return Number of bytes freed
+     */
+    uint64_t EvictFromSegments(
+        const std::vector<std::string>& segment_names, uint64_t required_size,
+        std::optional<uint8_t> admission_freq = std::nullopt);
+
+    // Remember a key evicted from the S3FIFO small queue
+    void OnObjectEvicted(const std::string& key,
+                         const ObjectMetadata& metadata);
+
     // Eviction thread function
     void EvictionThreadFunc();
 
     tl::expected<void, ErrorCode> PushOffloadingQueue(const std::string& key,
                                                       const Replica& replica);
 
+    // Metadata persistence helpers. They are no-ops if persistence is
+    // disabled. Callers must hold the shard lock of the key so that the WAL
+    // order matches the mutation order of every key.
+    void PersistPutEnd(const std::string& key, const ObjectMetadata& metadata);
+    void PersistRemove(const std::string& key);
+    void PersistEvict(const std::string& key, const ObjectMetadata& metadata);
+    PersistedObject ToPersistedObject(const std::string& key,
+                                      const ObjectMetadata& metadata) const;
+    // Forget the not yet restored replicas of a key, since it is mutated.
+    void DropPendingRestore(const std::string& key);
+    // Forget the not yet restored replicas on a freshly mounted segment, as
+    // its previous content is gone.
+    void DropPendingRestoreOnSegment(const std::string& segment_name);
+
+    /**
+     * @brief Rebuild metadata from the persisted objects. Disk replicas are
+     * restored immediately. Memory replicas are kept pending until their
+     * segments are re-mounted, so that their buffers can be re-reserved in
+     * the segment allocators.
+     */
+    void RestoreMetadata(std::vector<PersistedObject>&& objects);
+
+    /**
+     * @brief Restore the pending memory replicas located on the given
+     * segments. Must be called without holding the segment mutex.
+     */
+    void RestorePendingReplicas(const std::vector<std::string>& segment_names);
+
+    // Write a snapshot of all committed objects, including pending ones.
+    ErrorCode WriteMetadataSnapshot();
+    void MetadataSnapshotThreadFunc();
+
     // Lease related members
     const uint64_t default_kv_lease_ttl_;     // in milliseconds
     const uint64_t default_kv_soft_pin_ttl_;  // in milliseconds
+    // Reads do not renew leases with at least this much left, in
+    // milliseconds
+    const uint64_t lease_renewal_min_ttl_;
     const bool allow_evict_soft_pinned_objects_;
 
     // Eviction related members
@@ -740,6 +1234,38 @@ class MasterService {
         false};  // Set to trigger eviction when not enough space left
     const double eviction_ratio_;                 // in range [0.0, 1.0]
     const double eviction_high_watermark_ratio_;  // in range [0.0, 1.0]
+    const EvictionPolicy eviction_policy_;
+    // Only allocated for EvictionPolicy::LFU or TinyLFU admission, aged by
+    // the eviction thread
+    std::unique_ptr<FrequencySketch> frequency_sketch_;
+    static constexpr size_t kFrequencySketchWidth = 1 << 20;
+    // Whether inline PutStart eviction only evicts objects the sketch
+    // estimates colder than the new key
+    const bool tinylfu_admission_;
+    // Only allocated for EvictionPolicy::S3FIFO
+    std::unique_ptr<GhostQueue> ghost_queue_;
+    static constexpr size_t kGhostQueueCapacity = 1 << 20;
+    // Whether S3FIFO evicts from the small queue before the main queue,
+    // updated by each BatchEvict pass from the share of the small queue
+    std::atomic<bool> s3fifo_small_first_{true};
+    // Share of the objects S3FIFO keeps in the small queue, in percent
+    static constexpr size_t kS3FifoSmallQueuePercent = 10;
+    // Only allocated if hot_key_top_n > 0
+    std::unique_ptr<HotKeyTracker> hot_key_tracker_;
+    static constexpr size_t kHotKeySketchWidth = 1 << 16;
+    const uint32_t put_start_eviction_retries_;
+    // Put backoff reported in Ping, growing from 0 at the high watermark to
+    // kMaxPutBackoffMs when full or when an allocation failed since the
+    // last eviction
+    uint64_t PutBackoffMs(double used_ratio) const;
+    static constexpr uint64_t kMaxPutBackoffMs = 100;
+    // Whether BatchPutStart places single-replica objects in one extent
+    const bool batch_put_contiguous_;
+    // Quotas of the tenants of ReplicateConfig::tenant
+    std::unique_ptr<TenantQuotaManager> tenant_quota_manager_;
+    // Next shard EvictFromSegments scans
+    std::atomic<size_t> segment_eviction_cursor_{0};
+    static constexpr size_t kSegmentEvictionMaxShards = 64;
 
     // Eviction thread related members
     std::thread eviction_thread_;
@@ -747,6 +1273,14 @@ class MasterService {
     static constexpr uint64_t kEvictionThreadSleepMs =
         10;  // 10 ms sleep between eviction checks
 
+    // Deadlines of the objects put with a TTL, advanced by the eviction
+    // thread
+    TimingWheel ttl_wheel_{std::chrono::milliseconds(kEvictionThreadSleepMs),
+                           std::chrono::steady_clock::now()};
+    // Wait before retrying to expire an object that is busy, e.g. with a
+    // replication task
+    static constexpr auto kTtlRetryInterval = std::chrono::seconds(1);
+
     // Task cleanup thread related members
     std::thread task_cleanup_thread_;
     std::atomic<bool> task_cleanup_running_{false};
@@ -757,6 +1291,100 @@ class MasterService {
     std::mutex task_cleanup_mutex_;
     std::condition_variable task_cleanup_cv_;
 
+    // Compaction thread related members, only started for offset allocators
+    std::thread compaction_thread_;
+    std::atomic<bool> compaction_running_{false};
+    static constexpr uint64_t kCompactionThreadSleepMs = 1000;
+    static constexpr size_t kCompactionMaxShards = 64;
+    std::mutex compaction_mutex_;
+    std::condition_variable compaction_cv_;
+    const double compaction_fragmentation_threshold_;
+    const uint32_t compaction_moves_per_sec_;
+    // Only accessed by the compaction thread
+    size_t compaction_cursor_{0};
+    std::vector<UUID> compaction_tasks_;
+
+    // Rebalance thread related members, only started if
+    // rebalance_moves_per_sec is set
+    std::thread rebalance_thread_;
+    std::atomic<bool> rebalance_running_{false};
+    std::atomic<bool> rebalance_pending_{false};
+    static constexpr uint64_t kRebalanceThreadSleepMs = 1000;
+    static constexpr size_t kRebalanceMaxShards = 64;
+    std::mutex rebalance_mutex_;
+    std::condition_variable rebalance_cv_;
+    const double rebalance_utilization_gap_;
+    const uint32_t rebalance_moves_per_sec_;
+    // Only accessed by the rebalance thread
+    size_t rebalance_cursor_{0};
+    std::vector<UUID> rebalance_tasks_;
+
+    // Reclaim thread related members, only started with async replica
+    // reclaim. Buffers queued by ReclaimReplicas are freed in one batch per
+    // wakeup.
+    const bool enable_async_replica_reclaim_;
+    std::thread reclaim_thread_;
+    std::atomic<bool> reclaim_running_{false};
+    std::mutex reclaim_mutex_;
+    std::condition_variable reclaim_cv_;
+    std::vector<std::unique_ptr<AllocatedBuffer>> reclaim_queue_;
+
+    // Hot key replication thread related members, only started if both
+    // hot_key_top_n and hot_key_replica_reads_per_sec are set
+    std::thread hot_key_replication_thread_;
+    std::atomic<bool> hot_key_replication_running_{false};
+    static constexpr uint64_t kHotKeyReplicationThreadSleepMs = 1000;
+    std::mutex hot_key_replication_mutex_;
+    std::condition_variable hot_key_replication_cv_;
+    const uint32_t hot_key_replica_reads_per_sec_;
+    const uint32_t hot_key_max_replicas_;
+    struct HotKeyReplicas {
+        std::vector<std::string> segments;  // targets of the copies
+        std::optional<UUID> pending_task;
+    };
+    // Only accessed by the hot key replication thread
+    std::unordered_map<std::string, uint64_t> hot_key_counts_;
+    std::chrono::steady_clock::time_point hot_key_counted_at_{};
+    std::unordered_map<std::string, HotKeyReplicas> hot_key_replicas_;
+
+    // Disk promotion thread related members, only started if
+    // disk_promotion_reads is set
+    std::unique_ptr<DiskPromotionTracker> disk_promotion_tracker_;
+    static constexpr size_t kDiskPromotionMaxTrackedKeys = 1 << 16;
+    std::thread disk_promotion_thread_;
+    std::atomic<bool> disk_promotion_running_{false};
+    // Set by RecordDiskRead when a key became due
+    std::atomic<bool> disk_promotion_pending_{false};
+    static constexpr uint64_t kDiskPromotionThreadSleepMs = 1000;
+    std::mutex disk_promotion_mutex_;
+    std::condition_variable disk_promotion_cv_;
+
+    // Tiering thread related members, only started with offloading and
+    // memory_tier_target_ratio set
+    std::thread tiering_thread_;
+    std::atomic<bool> tiering_running_{false};
+    static constexpr uint64_t kTieringThreadSleepMs = 1000;
+    // Objects queued for offloading are not queued again for this long
+    static constexpr std::chrono::seconds kTierDemotionRetry{60};
+    std::mutex tiering_mutex_;
+    std::condition_variable tiering_cv_;
+    const double memory_tier_target_ratio_;
+    const std::chrono::seconds tier_demotion_min_idle_;
+    // Only accessed by the tiering thread
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+        tier_demotions_;
+
+    // Tasks assigned to this id are popped by the master task thread instead
+    // of being fetched by a client
+    static constexpr UUID kMasterTaskClient{0, 0};
+    std::thread master_task_thread_;
+    std::atomic<bool> master_task_running_{false};
+    static constexpr uint64_t kMasterTaskThreadSleepMs = 1000;
+    // Keys removed per acquisition of a shard lock by RemoveByPrefix
+    static constexpr size_t kPrefixRemovalBatchSize = 256;
+    std::mutex master_task_mutex_;
+    std::condition_variable master_task_cv_;
+
     // Helper class for accessing metadata with automatic locking and cleanup
     class MetadataAccessorRW {
        public:
@@ -770,12 +1398,16 @@ class MasterService {
               replication_task_it_(shard_guard_->replication_tasks.find(key)) {
             // Automatically clean up invalid handles
             if (it_ != shard_guard_->metadata.end()) {
+                const size_t replica_num = it_->second.CountReplicas();
                 if (service_->CleanupStaleHandles(it_->second)) {
+                    service_->PersistRemove(key_);
                     this->Erase();
 
                     if (processing_it_ != shard_guard_->processing_keys.end()) {
                         this->EraseFromProcessing();
                     }
+                } else if (it_->second.CountReplicas() != replica_num) {
+                    service_->PersistPutEnd(key_, it_->second);
                 }
             }
         }
@@ -839,7 +1471,7 @@ class MasterService {
         std::string key_;
         size_t shard_idx_;
         MetadataShardAccessorRW shard_guard_;
-        std::unordered_map<std::string, ObjectMetadata>::iterator it_;
+        MetadataMap::iterator it_;
         std::unordered_set<std::string>::iterator processing_it_;
         std::unordered_map<std::string, const ReplicationTask>::iterator
             replication_task_it_;
@@ -878,7 +1510,7 @@ class MasterService {
         const std::string key_;
         const size_t shard_idx_;
         MetadataShardAccessorRO shard_guard_;
-        std::unordered_map<std::string, ObjectMetadata>::const_iterator it_;
+        MetadataMap::const_iterator it_;
         std::unordered_set<std::string>::const_iterator processing_it_;
     };
 
@@ -886,25 +1518,20 @@ class MasterService {
     friend class MetadataAccessorRO;
 
     ViewVersionId view_version_;
+    // Reported to clients in Ping, see PingResponse
+    std::atomic<uint64_t> replica_invalidation_epoch_{0};
 
     // Client related members
+    // Serializes remounts with the expiry of clients, pings do not take it
     mutable std::shared_mutex client_mutex_;
-    std::unordered_set<UUID, boost::hash<UUID>>
-        ok_client_;  // client with ok status
     void ClientMonitorFunc();
     std::thread client_monitor_thread_;
     std::atomic<bool> client_monitor_running_{false};
     static constexpr uint64_t kClientMonitorSleepMs =
         1000;  // 1000 ms sleep between client monitor checks
-    // boost lockfree queue requires trivial assignment operator
-    struct PodUUID {
-        uint64_t first;
-        uint64_t second;
-    };
-    static constexpr size_t kClientPingQueueSize =
-        128 * 1024;  // Size of the client ping queue
-    boost::lockfree::queue<PodUUID> client_ping_queue_{kClientPingQueueSize};
-    const int64_t client_live_ttl_sec_;
+    // Leases of the clients, renewed by pings. Clients with ok status are
+    // marked in their lease.
+    ClientLeaseTable client_leases_;
 
     // if high availability features enabled
     const bool enable_ha_;
@@ -926,6 +1553,7 @@ class MasterService {
     // Segment management
     SegmentManager segment_manager_;
     BufferAllocatorType memory_allocator_type_;
+    const AllocationStrategyType allocation_strategy_type_;
     std::shared_ptr<AllocationStrategy> allocation_strategy_;
 
     // Discarded replicas management
@@ -935,6 +1563,40 @@ class MasterService {
     const size_t cxl_size_;
     bool enable_cxl_;
 
+    // Metadata persistence related members, metadata_persistence_ is nullptr
+    // if persistence is disabled.
+    std::unique_ptr<MetadataPersistence> metadata_persistence_;
+    const uint64_t metadata_snapshot_interval_sec_;
+    std::thread metadata_snapshot_thread_;
+    std::atomic<bool> metadata_snapshot_running_{false};
+    std::mutex metadata_snapshot_mutex_;
+    std::condition_variable metadata_snapshot_cv_;
+
+    // Restored objects whose memory replicas wait for their segments to be
+    // re-mounted. Only the not yet restored replicas are kept.
+    Mutex pending_restore_mutex_;
+    std::unordered_map<std::string, PersistedObject> pending_restore_
+        GUARDED_BY(pending_restore_mutex_);
+    // segment name -> keys with pending replicas on it, may contain stale keys
+    std::unordered_map<std::string, std::vector<std::string>>
+        pending_restore_by_segment_ GUARDED_BY(pending_restore_mutex_);
+
+    // Lock-free read path of GetReplicaList for hot keys
+    HotReplicaCache hot_replica_cache_;
+
+    // Key filters synced by clients, see GetKeyFilter
+    bool enable_key_filter_{false};
+    uint64_t key_filter_id_{0};
+    std::atomic<uint64_t> key_filter_seq_{0};
+
+    // Keys linked to content-addressed objects by LinkContent. Its locks are
+    // taken after the shard locks, never before.
+    ContentIndex content_index_;
+
+    // Keys linked to ranges of bundle objects by LinkBundle. Its locks are
+    // taken after the shard locks, never before.
+    BundleIndex bundle_index_;
+
     class DiscardedReplicas {
        public:
         DiscardedReplicas() = delete;
@@ -956,6 +1618,8 @@ class MasterService {
 
         uint64_t memSize() const { return mem_size_; }
 
+        std::vector<Replica> TakeReplicas() { return std::move(replicas_); }
+
         bool isExpired(const std::chrono::steady_clock::time_point& now) const {
             return ttl_ <= now;
         }
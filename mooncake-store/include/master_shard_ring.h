@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Consistent hash ring partitioning the key space over the masters of
+ * a sharded deployment.
+ *
+ * Each master owns kVirtualNodes points of the ring, picked by hashing its
+ * address, and a key belongs to the master of the first point at or after
+ * the hash of the key. The hash does not depend on the process or the
+ * build, so clients given the same masters in any order agree on the owner
+ * of every key, and adding a master only moves about 1/N of the keys.
+ */
+class MasterShardRing {
+   public:
+    static constexpr size_t kVirtualNodes = 128;
+
+    explicit MasterShardRing(const std::vector<std::string>& masters);
+
+    size_t size() const { return num_masters_; }
+
+    // Index of the owner of the key in the masters given to the constructor
+    size_t ShardOf(std::string_view key) const;
+
+    // Split a comma separated list of master addresses
+    static std::vector<std::string> ParseMasters(const std::string& entry);
+
+   private:
+    static uint64_t Hash(std::string_view data);
+
+    size_t num_masters_;
+    // Sorted {hash, master index} points
+    std::vector<std::pair<uint64_t, size_t>> points_;
+};
+
+}  // namespace mooncake
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ylt/util/tl/expected.hpp>
+
+#include "metadata_persistence.h"
+#include "mutex.h"
+#include "rpc_types.h"
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Keeps an up-to-date copy of the leader's committed metadata by
+ * tailing the snapshot and WAL it writes to a shared persist directory.
+ *
+ * It is used by standby masters in HA mode: read-only queries can be served
+ * from the copy while waiting for leadership, and on promotion the copy is
+ * handed over to the new MasterService so the persisted metadata does not
+ * have to be reloaded.
+ *
+ * Thread-safe.
+ */
+class MetadataFollower {
+   public:
+    explicit MetadataFollower(std::string persist_dir);
+    ~MetadataFollower();
+
+    MetadataFollower(const MetadataFollower&) = delete;
+    MetadataFollower& operator=(const MetadataFollower&) = delete;
+
+    // Start the background thread tailing the persist directory
+    void Start();
+
+    /**
+     * @brief Replay the records appended since the last call. Called
+     * periodically by the background thread.
+     */
+    ErrorCode CatchUp();
+
+    /**
+     * @brief Stop tailing and hand over the replayed state, e.g. to
+     * MetadataPersistence::Load on promotion. The follower serves no data
+     * afterwards.
+     */
+    MetadataReplayState Detach();
+
+    tl::expected<bool, ErrorCode> ExistKey(const std::string& key) const;
+
+    std::vector<tl::expected<bool, ErrorCode>> BatchExistKey(
+        const std::vector<std::string>& keys) const;
+
+    /**
+     * @brief Get the disk replicas of a key as last seen in the WAL, with a
+     * zero lease ttl. Memory and local disk replicas are left out since a
+     * standby cannot protect them with a lease.
+     * @return REPLICA_IS_NOT_READY if the key has no disk replica, the
+     * client then has to ask the leader
+     */
+    tl::expected<GetReplicaListResponse, ErrorCode> GetReplicaList(
+        const std::string& key) const;
+
+    uint64_t last_sequence() const;
+
+   private:
+    void TailThreadFunc();
+
+    static constexpr uint64_t kTailIntervalMs = 100;
+
+    const std::string persist_dir_;
+
+    mutable SharedMutex mutex_;
+    MetadataReplayState state_ GUARDED_BY(mutex_);
+    bool detached_ GUARDED_BY(mutex_){false};
+
+    std::thread tail_thread_;
+    std::atomic<bool> tail_running_{false};
+    // Used to wake the tail thread immediately when stopping.
+    std::mutex tail_mutex_;
+    std::condition_variable tail_cv_;
+};
+
+}  // namespace mooncake
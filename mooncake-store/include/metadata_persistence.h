@@ -0,0 +1,398 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ylt/util/tl/expected.hpp>
+
+#include "mutex.h"
+#include "replica.h"
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Replica state as persisted by the master. Memory replicas are
+ * identified by segment name and absolute buffer address so that they can be
+ * re-reserved in the allocator when the owning segment is mounted again.
+ */
+struct PersistedReplica {
+    ReplicaType type{ReplicaType::MEMORY};
+    // MEMORY: buffer size, DISK / LOCAL_DISK: object size
+    uint64_t size{0};
+    // MEMORY only
+    std::string segment_name;
+    uint64_t buffer_address{0};
+    std::string protocol;
+    // DISK only
+    std::string file_path;
+    // LOCAL_DISK only
+    UUID client_id{0, 0};
+    // MEMORY and LOCAL_DISK
+    std::string transport_endpoint;
+
+    template <typename T>
+    void serialize_to(T& serializer) const;
+
+    template <typename T>
+    static PersistedReplica read_from(T& serializer);
+};
+
+/**
+ * @brief A committed object as persisted by the master. Only replicas in
+ * COMPLETE status are persisted.
+ */
+struct PersistedObject {
+    std::string key;
+    UUID client_id{0, 0};
+    uint64_t size{0};
+    bool soft_pin{false};
+    // Remaining hard lease at the time of persisting, in milliseconds
+    uint64_t lease_remaining_ms{0};
+    std::vector<PersistedReplica> replicas;
+
+    template <typename T>
+    void serialize_to(T& serializer) const;
+
+    template <typename T>
+    static PersistedObject read_from(T& serializer);
+};
+
+enum class MetadataWalOp : uint8_t {
+    PUT_END = 1,  // insert or overwrite the object with the carried state
+    REMOVE = 2,   // drop the object
+    EVICT = 3,    // memory replicas evicted, carries the remaining state
+};
+
+struct MetadataWalRecord {
+    uint64_t sequence{0};
+    MetadataWalOp op{MetadataWalOp::PUT_END};
+    std::string key;
+    // PUT_END: the new state. EVICT: the remaining state, empty if the
+    // object was dropped entirely.
+    std::optional<PersistedObject> object;
+
+    template <typename T>
+    void serialize_to(T& serializer) const;
+
+    template <typename T>
+    static std::shared_ptr<MetadataWalRecord> deserialize_from(T& serializer);
+};
+
+/**
+ * @brief Point-in-time image of all committed objects. All WAL records with a
+ * sequence number larger than last_sequence must be replayed on top of it.
+ */
+struct MetadataSnapshot {
+    static constexpr uint32_t kMagic = 0x4d43534e;  // "MCSN"
+    static constexpr uint32_t kVersion = 2;
+
+    uint64_t last_sequence{0};
+    std::vector<PersistedObject> objects;
+
+    template <typename T>
+    void serialize_to(T& serializer) const;
+
+    template <typename T>
+    static std::shared_ptr<MetadataSnapshot> deserialize_from(T& serializer);
+};
+
+/**
+ * @brief Metadata replayed from a persist directory, together with the WAL
+ * position it has been replayed up to. It allows to continue an interrupted
+ * replay, e.g. a standby master tailing the WAL of the leader.
+ */
+struct MetadataReplayState {
+    bool initialized{false};  // whether the snapshot has been loaded
+    uint64_t last_sequence{0};
+    std::unordered_map<std::string, PersistedObject> objects;
+    // First sequence of the WAL segment being replayed and the offset of the
+    // first byte not replayed yet in it
+    uint64_t segment_first_sequence{0};
+    uint64_t segment_offset{0};
+};
+
+/**
+ * @brief Snapshot + write-ahead log persistence of the master metadata.
+ *
+ * Layout of the persist directory:
+ *   metadata.snapshot        latest complete snapshot (written via rename)
+ *   metadata.wal.<sequence>  WAL segment; <sequence> is the sequence number
+ *                            of the first record it may contain
+ *
+ * Each WAL record is framed as [u32 length][u32 crc32][payload]. A torn or
+ * corrupted tail produced by a crash is detected by the crc and ignored
+ * during replay.
+ *
+ * Thread-safe. Appends only buffer the records in memory, so that they can
+ * be made under the shard locks of the master. Sync writes and fsyncs them
+ * with group commit: the first caller writes all buffered records with one
+ * fsync while the others wait for it, and callers ack a change only once
+ * Sync has returned.
+ */
+class MetadataPersistence {
+   public:
+    explicit MetadataPersistence(std::string persist_dir);
+    ~MetadataPersistence();
+
+    MetadataPersistence(const MetadataPersistence&) = delete;
+    MetadataPersistence& operator=(const MetadataPersistence&) = delete;
+
+    /**
+     * @brief Load the latest snapshot and replay the WAL on top of it. Must be
+     * called once before any Append. Opens a fresh WAL segment for writes.
+     * @param state A partially replayed state to continue from, by default
+     * everything is replayed from scratch.
+     * @return The restored objects.
+     */
+    auto Load(MetadataReplayState state = {})
+        -> tl::expected<std::vector<PersistedObject>, ErrorCode>;
+
+    /**
+     * @brief Replay the records appended to the persist directory since the
+     * given state was last caught up. A torn record at the tail of the last
+     * WAL segment is left for the next call, as it may still be being
+     * written. If the WAL segments the state was replaying have been
+     * compacted into a newer snapshot, the state is rebuilt from it.
+     * @param replayed Optional output of the number of replayed records.
+     */
+    static ErrorCode CatchUp(const std::string& persist_dir,
+                             MetadataReplayState& state,
+                             size_t* replayed = nullptr);
+
+    /**
+     * @brief Append records to the WAL buffer, assigning their sequence
+     * numbers. They are on disk once Sync returns.
+     */
+    ErrorCode AppendPutEnd(PersistedObject object);
+    ErrorCode AppendRemove(const std::string& key);
+    ErrorCode AppendEvict(const std::string& key,
+                          std::optional<PersistedObject> remaining);
+
+    /**
+     * @brief Write and fsync the records appended before the call.
+     * @return ErrorCode::FILE_WRITE_FAIL if the WAL cannot be written, in
+     * which case later records are refused too.
+     */
+    ErrorCode Sync();
+
+    /**
+     * @brief Start a new WAL segment and return the last sequence number
+     * written to the previous ones. The caller should then collect the
+     * objects and call WriteSnapshot with the returned sequence.
+     */
+    uint64_t RotateWal();
+
+    /**
+     * @brief Atomically replace the snapshot and delete the WAL segments it
+     * fully covers. Records appended while the objects were being collected
+     * are replayed again on load, which is harmless since replay is
+     * idempotent.
+     */
+    ErrorCode WriteSnapshot(uint64_t last_sequence,
+                            std::vector<PersistedObject> objects);
+
+    const std::string& persist_dir() const { return persist_dir_; }
+
+   private:
+    ErrorCode Append(MetadataWalRecord& record);
+    // Writes the buffered records as one batch and starts a new segment
+    // after them if rotate. Runs one at a time, with the lock released
+    // while writing.
+    void Flush(std::unique_lock<std::mutex>& lock, bool rotate);
+    ErrorCode OpenWalSegment(uint64_t first_sequence) REQUIRES(wal_mutex_);
+    static std::vector<std::pair<uint64_t, std::string>> ListWalSegments(
+        const std::string& persist_dir);
+    static std::string SnapshotPath(const std::string& persist_dir);
+    static ErrorCode LoadSnapshot(const std::string& persist_dir,
+                                  MetadataReplayState& state);
+
+    const std::string persist_dir_;
+
+    // Taken by the flush writing the WAL only, not by appends
+    Mutex wal_mutex_;
+    std::FILE* wal_file_ GUARDED_BY(wal_mutex_){nullptr};
+    uint64_t wal_file_first_sequence_ GUARDED_BY(wal_mutex_){0};
+
+    // Guards the buffered records and the sequence numbers
+    std::mutex pending_mutex_;
+    std::condition_variable flushed_cv_;
+    std::vector<SerializedByte> pending_;
+    uint64_t next_sequence_{1};
+    uint64_t synced_sequence_{0};
+    bool flushing_{false};
+    ErrorCode wal_error_{ErrorCode::OK};
+};
+
+/**
+ * @brief CRC-32 (IEEE 802.3) of a buffer, continuing from the CRC of the data
+ * before it when crc is given.
+ */
+uint32_t Crc32(const void* data, size_t size, uint32_t crc = 0);
+
+namespace persistence_detail {
+
+template <typename T, typename V>
+void WritePod(T& serializer, const V& value) {
+    serializer.write(&value, sizeof(value));
+}
+
+template <typename T, typename V>
+V ReadPod(T& serializer) {
+    V value{};
+    serializer.read(&value, sizeof(value));
+    return value;
+}
+
+template <typename T>
+void WriteString(T& serializer, const std::string& str) {
+    WritePod<T, uint64_t>(serializer, str.size());
+    if (!str.empty()) {
+        serializer.write(str.data(), str.size());
+    }
+}
+
+template <typename T>
+std::string ReadString(T& serializer) {
+    auto size = ReadPod<T, uint64_t>(serializer);
+    std::string str(size, '\0');
+    if (size > 0) {
+        serializer.read(str.data(), size);
+    }
+    return str;
+}
+
+}  // namespace persistence_detail
+
+template <typename T>
+void PersistedReplica::serialize_to(T& serializer) const {
+    using namespace persistence_detail;
+    WritePod(serializer, static_cast<uint8_t>(type));
+    WritePod(serializer, size);
+    WriteString(serializer, segment_name);
+    WritePod(serializer, buffer_address);
+    WriteString(serializer, protocol);
+    WriteString(serializer, file_path);
+    WritePod(serializer, client_id.first);
+    WritePod(serializer, client_id.second);
+    WriteString(serializer, transport_endpoint);
+}
+
+template <typename T>
+PersistedReplica PersistedReplica::read_from(T& serializer) {
+    using namespace persistence_detail;
+    PersistedReplica replica;
+    replica.type = static_cast<ReplicaType>(ReadPod<T, uint8_t>(serializer));
+    replica.size = ReadPod<T, uint64_t>(serializer);
+    replica.segment_name = ReadString(serializer);
+    replica.buffer_address = ReadPod<T, uint64_t>(serializer);
+    replica.protocol = ReadString(serializer);
+    replica.file_path = ReadString(serializer);
+    replica.client_id.first = ReadPod<T, uint64_t>(serializer);
+    replica.client_id.second = ReadPod<T, uint64_t>(serializer);
+    replica.transport_endpoint = ReadString(serializer);
+    return replica;
+}
+
+template <typename T>
+void PersistedObject::serialize_to(T& serializer) const {
+    using namespace persistence_detail;
+    WriteString(serializer, key);
+    WritePod(serializer, client_id.first);
+    WritePod(serializer, client_id.second);
+    WritePod(serializer, size);
+    WritePod(serializer, static_cast<uint8_t>(soft_pin));
+    WritePod(serializer, lease_remaining_ms);
+    WritePod<T, uint64_t>(serializer, replicas.size());
+    for (const auto& replica : replicas) {
+        replica.serialize_to(serializer);
+    }
+}
+
+template <typename T>
+PersistedObject PersistedObject::read_from(T& serializer) {
+    using namespace persistence_detail;
+    PersistedObject object;
+    object.key = ReadString(serializer);
+    object.client_id.first = ReadPod<T, uint64_t>(serializer);
+    object.client_id.second = ReadPod<T, uint64_t>(serializer);
+    object.size = ReadPod<T, uint64_t>(serializer);
+    object.soft_pin = ReadPod<T, uint8_t>(serializer) != 0;
+    object.lease_remaining_ms = ReadPod<T, uint64_t>(serializer);
+    auto replica_num = ReadPod<T, uint64_t>(serializer);
+    for (uint64_t i = 0; i < replica_num; i++) {
+        object.replicas.push_back(PersistedReplica::read_from(serializer));
+    }
+    return object;
+}
+
+template <typename T>
+void MetadataWalRecord::serialize_to(T& serializer) const {
+    using namespace persistence_detail;
+    WritePod(serializer, sequence);
+    WritePod(serializer, static_cast<uint8_t>(op));
+    WriteString(serializer, key);
+    WritePod(serializer, static_cast<uint8_t>(object.has_value()));
+    if (object) {
+        object->serialize_to(serializer);
+    }
+}
+
+template <typename T>
+std::shared_ptr<MetadataWalRecord> MetadataWalRecord::deserialize_from(
+    T& serializer) {
+    using namespace persistence_detail;
+    auto record = std::make_shared<MetadataWalRecord>();
+    record->sequence = ReadPod<T, uint64_t>(serializer);
+    record->op = static_cast<MetadataWalOp>(ReadPod<T, uint8_t>(serializer));
+    record->key = ReadString(serializer);
+    if (ReadPod<T, uint8_t>(serializer) != 0) {
+        record->object = PersistedObject::read_from(serializer);
+    }
+    return record;
+}
+
+template <typename T>
+void MetadataSnapshot::serialize_to(T& serializer) const {
+    using namespace persistence_detail;
+    WritePod(serializer, kMagic);
+    WritePod(serializer, kVersion);
+    WritePod(serializer, last_sequence);
+    WritePod<T, uint64_t>(serializer, objects.size());
+    for (const auto& object : objects) {
+        object.serialize_to(serializer);
+    }
+}
+
+template <typename T>
+std::shared_ptr<MetadataSnapshot> MetadataSnapshot::deserialize_from(
+    T& serializer) {
+    using namespace persistence_detail;
+    if (ReadPod<T, uint32_t>(serializer) != kMagic) {
+        LOG(ERROR) << "error=invalid_snapshot_magic";
+        return nullptr;
+    }
+    auto version = ReadPod<T, uint32_t>(serializer);
+    if (version != kVersion) {
+        LOG(ERROR) << "error=unsupported_snapshot_version, version="
+                   << version;
+        return nullptr;
+    }
+    auto snapshot = std::make_shared<MetadataSnapshot>();
+    snapshot->last_sequence = ReadPod<T, uint64_t>(serializer);
+    auto object_num = ReadPod<T, uint64_t>(serializer);
+    snapshot->objects.reserve(object_num);
+    for (uint64_t i = 0; i < object_num; i++) {
+        snapshot->objects.push_back(PersistedObject::read_from(serializer));
+    }
+    return snapshot;
+}
+
+}  // namespace mooncake
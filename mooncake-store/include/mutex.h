@@ -2,6 +2,8 @@
 #define THREAD_SAFETY_ANALYSIS_MUTEX_H
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
 #include <shared_mutex>
 
@@ -86,17 +88,49 @@ class CAPABILITY("mutex") Mutex {
 };
 
 // Simple shared_mutex implementation using std::shared_mutex for exclusive
-// locking only.
+// locking only. Acquisitions that have to wait are counted along with their
+// wait time; uncontended ones do not read the clock.
 class CAPABILITY("shared_mutex") SharedMutex {
    private:
     std::shared_mutex mutex_;
+    std::atomic<uint64_t> contended_{0};
+    std::atomic<uint64_t> wait_us_{0};
+
+    template <typename LockFn>
+    void wait_for(LockFn&& lock_fn) {
+        const auto start = std::chrono::steady_clock::now();
+        lock_fn();
+        const auto waited =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+        contended_.fetch_add(1, std::memory_order_relaxed);
+        wait_us_.fetch_add(waited.count(), std::memory_order_relaxed);
+    }
 
    public:
+    struct ContentionStats {
+        uint64_t contended{0};  // acquisitions that had to wait
+        uint64_t wait_us{0};    // total time they waited
+    };
+
     // Acquire/lock this mutex exclusively.
-    void lock() ACQUIRE() { mutex_.lock(); }
+    void lock() ACQUIRE() {
+        if (!mutex_.try_lock()) {
+            wait_for([this] { mutex_.lock(); });
+        }
+    }
 
     // Acquire/lock this mutex shared.
-    void lock_shared() ACQUIRE_SHARED() { mutex_.lock_shared(); }
+    void lock_shared() ACQUIRE_SHARED() {
+        if (!mutex_.try_lock_shared()) {
+            wait_for([this] { mutex_.lock_shared(); });
+        }
+    }
+
+    ContentionStats contention_stats() const {
+        return {contended_.load(std::memory_order_relaxed),
+                wait_us_.load(std::memory_order_relaxed)};
+    }
 
     // Release/unlock the mutex.
     void unlock() RELEASE() { mutex_.unlock(); }
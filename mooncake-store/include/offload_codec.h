@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace mooncake {
+
+// Recorded per object in BucketObjectMetadata, values must not change
+enum class OffloadCodecType : int32_t {
+    kNone = 0,
+    kZstd = 1,
+    kLz4 = 2,
+    // 16-bit values split into a plane of low and a plane of high bytes
+    // before zstd or lz4, for FP16/BF16 KV cache whose high bytes
+    // (sign and exponent) compress well
+    kBytePlane16 = 3,
+};
+
+/**
+ * @brief Compresses objects offloaded to disk and decompresses them on load.
+ *
+ * zstd and lz4 are only available when built with STORE_USE_ZSTD and
+ * STORE_USE_LZ4. Codecs are stateless and thread-safe.
+ */
+class OffloadCodec {
+   public:
+    virtual ~OffloadCodec() = default;
+
+    virtual OffloadCodecType type() const = 0;
+
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Encodes the concatenation of the slices into out.
+     * @return false if the encoded bytes would not be smaller, in which case
+     * the object is to be stored as it is.
+     */
+    bool Encode(const std::vector<Slice>& slices, size_t size,
+                std::vector<char>& out) const;
+
+    // Decodes src into exactly dst_size bytes at dst
+    virtual ErrorCode Decode(const char* src, size_t src_size, char* dst,
+                             size_t dst_size) const = 0;
+
+    /**
+     * @brief Codec of the given type, nullptr if it is not built in.
+     */
+    static const OffloadCodec* Get(OffloadCodecType type);
+
+    /**
+     * @brief Codec of the given name as set by MOONCAKE_OFFLOAD_CODEC,
+     * "none", "zstd", "lz4" or "byteplane16". Falls back to none for unknown
+     * names and codecs not built in.
+     */
+    static const OffloadCodec* FromName(const std::string& name);
+
+    // Splits 16-bit values into the planes of low and high bytes, an odd
+    // trailing byte is kept at the end
+    static void SplitBytePlanes(const char* src, size_t size, char* dst);
+
+    static void MergeBytePlanes(const char* src, size_t size, char* dst);
+
+   protected:
+    virtual bool EncodeContiguous(const char* src, size_t size,
+                                  std::vector<char>& out) const = 0;
+
+    friend class BytePlane16Codec;
+};
+
+}  // namespace mooncake
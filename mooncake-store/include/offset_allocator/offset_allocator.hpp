@@ -2,6 +2,7 @@
 // (C) Sebastian Aaltonen 2023
 // MIT License (see file: LICENSE)
 
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -46,6 +47,7 @@ struct OffsetAllocation {
 struct OffsetAllocStorageReport {
     uint64_t totalFreeSpace;
     uint64_t largestFreeRegion;
+    uint64_t freeRegions = 0;  // Number of free regions
 };
 
 struct OffsetAllocStorageReportFull {
@@ -96,7 +98,10 @@ class OffsetAllocationHandle {
     // The real base and requested size of the allocated memory.
     uint64_t real_base;
     uint64_t requested_size;
+    // Rounded up to its bin by allocate(), so the magazines may reuse it
+    bool m_cacheable = false;
 
+    friend class OffsetAllocator;      // for freeAllocations
     friend class OffsetAllocatorTest;  // for unit tests
 };
 
@@ -125,12 +130,20 @@ std::ostream& operator<<(std::ostream& os,
 // This will a) reduce the memory consumption in general cases, b) auto
 // increase the capacity in case there are a lot of small regions to be
 // allocated.
+// With magazine_bytes, freed blocks of up to kMagazineMaxSize are kept in
+// per-CPU magazines, up to magazine_bytes each, and handed out again by
+// allocate() without taking the lock of the bin allocator. A miss takes a few
+// blocks of the bin at once. The cached blocks count as allocated in the
+// storage reports, and are given back when an allocation would fail and
+// before serialization.
 class OffsetAllocator : public std::enable_shared_from_this<OffsetAllocator> {
    public:
+    static constexpr uint64_t kMagazineMaxSize = 1 << 20;
+
     // Factory method to create shared_ptr<OffsetAllocator>
     static std::shared_ptr<OffsetAllocator> create(
         uint64_t base, size_t size, uint32 init_capacity = 128 * 1024,
-        uint32 max_capacity = (1 << 20));
+        uint32 max_capacity = (1 << 20), uint64_t magazine_bytes = 0);
 
     // Disable copy constructor and copy assignment
     OffsetAllocator(const OffsetAllocator&) = delete;
@@ -147,6 +160,25 @@ class OffsetAllocator : public std::enable_shared_from_this<OffsetAllocator> {
     [[nodiscard]]
     std::optional<OffsetAllocationHandle> allocate(size_t size);
 
+    // Allocate the range starting at a fixed address (thread-safe). The whole
+    // range must currently be free. Used to rebuild allocations from
+    // persisted metadata.
+    [[nodiscard]]
+    std::optional<OffsetAllocationHandle> allocateAt(uint64_t address,
+                                                     size_t size);
+
+    // Split a handle of this allocator into consecutive allocations of the
+    // given sizes, starting at its address (thread-safe). Returns the new
+    // handles and leaves the handle invalid, or returns none and leaves the
+    // handle untouched if the sizes do not fit in its allocation.
+    [[nodiscard]]
+    std::vector<OffsetAllocationHandle> split(OffsetAllocationHandle& handle,
+                                              const std::vector<size_t>& sizes);
+
+    // Free the handles of this allocator under a single lock (thread-safe).
+    // The handles are left invalid; handles of other allocators are skipped.
+    void freeAllocations(std::vector<OffsetAllocationHandle>& handles);
+
     // Get storage report (thread-safe)
     [[nodiscard]]
     OffsetAllocStorageReport storageReport() const;
@@ -159,6 +191,10 @@ class OffsetAllocator : public std::enable_shared_from_this<OffsetAllocator> {
     [[nodiscard]]
     OffsetAllocatorMetrics get_metrics() const;
 
+    // Give the blocks cached in the magazines back to the bin allocator
+    // (thread-safe)
+    void flushMagazines();
+
     // Serialize the allocator with serializer.
     template <typename T>
     void serialize_to(T& serializer) const;
@@ -169,8 +205,29 @@ class OffsetAllocator : public std::enable_shared_from_this<OffsetAllocator> {
    private:
     friend class OffsetAllocationHandle;
 
+    // Bins of up to kMagazineMaxSize, SmallFloat bin 144 is 2^20
+    static constexpr uint32 kMagazineBins = 145;
+    static constexpr size_t kMagazineMaxBlocks = 64;
+    static constexpr size_t kMagazineRefill = 8;
+
+    // Rarely contended: only threads running on the same CPU share one
+    struct alignas(64) Magazine {
+        Mutex lock;
+        std::vector<OffsetAllocation> bins[kMagazineBins] GUARDED_BY(lock);
+        uint64_t cached_bytes GUARDED_BY(lock) = 0;
+    };
+
     // Internal method for Handle to free allocation (thread-safe)
-    void freeAllocation(const OffsetAllocation& allocation, uint64_t size);
+    void freeAllocation(const OffsetAllocation& allocation, uint64_t size,
+                        bool cacheable);
+
+    // Bin of the blocks of size if the magazines cache it
+    bool magazineBin(uint64_t size, uint32& bin) const;
+    Magazine& currentMagazine() const;
+    std::optional<OffsetAllocation> popMagazine(uint32 bin);
+    bool pushMagazine(const OffsetAllocation& allocation, uint32 bin);
+    // Returns whether any cached block was freed
+    bool flushMagazinesLocked() const REQUIRES(m_mutex);
 
     // Internal method to get metrics without locking (caller must hold m_mutex)
     [[nodiscard]]
@@ -187,10 +244,17 @@ class OffsetAllocator : public std::enable_shared_from_this<OffsetAllocator> {
     // Lightweight metrics maintained during allocation/deallocation
     uint64_t m_allocated_size GUARDED_BY(m_mutex) = 0;
     uint64_t m_allocated_num GUARDED_BY(m_mutex) = 0;
+    // Changes to the two above made by the magazines without the lock
+    std::atomic<int64_t> m_magazine_size_delta{0};
+    std::atomic<int64_t> m_magazine_num_delta{0};
+
+    std::unique_ptr<Magazine[]> m_magazines;
+    size_t m_num_magazines = 0;
+    uint64_t m_magazine_bytes = 0;
 
     // Private constructor - use create() factory method instead
     OffsetAllocator(uint64_t base, size_t size, uint32 init_capacity,
-                    uint32 max_capacity);
+                    uint32 max_capacity, uint64_t magazine_bytes);
 
     // Private constructor - initialize from serialized data
     template <typename T>
@@ -209,6 +273,8 @@ class __Allocator {
     void reset();
 
     OffsetAllocation allocate(uint32 size);
+    // With exact, the size is not rounded up to its bin
+    OffsetAllocation allocateAt(uint32 offset, uint32 size, bool exact = false);
     void free(OffsetAllocation allocation);
 
     uint32 allocationSize(OffsetAllocation allocation) const;
@@ -222,6 +288,8 @@ class __Allocator {
    private:
     uint32 insertNodeIntoBin(uint32 size, uint32 dataOffset);
     void removeNodeFromBin(uint32 nodeIndex);
+    bool reserveFreeNodes(uint32 count);
+    void linkNeighbors(uint32 prevIndex, uint32 nextIndex);
 
     struct Node {
         static constexpr NodeIndex unused = 0xffffffff;
@@ -247,6 +315,8 @@ class __Allocator {
     std::vector<Node> m_nodes;
     std::vector<NodeIndex> m_freeNodes;
     uint32 m_freeOffset;
+    // Nodes in the bins, not serialized
+    uint32 m_freeRegions = 0;
 
     friend class OffsetAllocatorTest;  // for unit tests
 };
@@ -261,12 +331,19 @@ void OffsetAllocator::serialize_to(T& serializer) const {
         return;
     }
 
+    // Cached blocks are not allocations of the restored allocator
+    flushMagazinesLocked();
+    const uint64_t allocated_size =
+        m_allocated_size + m_magazine_size_delta.load();
+    const uint64_t allocated_num =
+        m_allocated_num + m_magazine_num_delta.load();
+
     // Basic member variables
     serializer.write(&m_base, sizeof(m_base));
     serializer.write(&m_multiplier_bits, sizeof(m_multiplier_bits));
     serializer.write(&m_capacity, sizeof(m_capacity));
-    serializer.write(&m_allocated_size, sizeof(m_allocated_size));
-    serializer.write(&m_allocated_num, sizeof(m_allocated_num));
+    serializer.write(&allocated_size, sizeof(allocated_size));
+    serializer.write(&allocated_num, sizeof(allocated_num));
     // Serialize the allocator
     m_allocator->serialize_to(serializer);
 }
@@ -337,6 +414,12 @@ __Allocator::__Allocator(T& serializer) {
         // Deserialize the arrays
         serializer.read(m_nodes.data(), m_current_capacity * sizeof(Node));
         serializer.read(m_freeNodes.data(), m_current_capacity * sizeof(NodeIndex));
+        for (uint32 i = 0; i < NUM_LEAF_BINS; i++) {
+            for (NodeIndex n = m_binIndices[i]; n != Node::unused;
+                 n = m_nodes[n].binListNext) {
+                m_freeRegions++;
+            }
+        }
     } catch (const std::exception& e) {
         LOG(ERROR) << "Deserializing __Allocator failed, error=" << e.what();
         throw std::runtime_error("Deserializing __Allocator failed");
@@ -2,6 +2,7 @@
 
 #include <csignal>
 #include <atomic>
+#include <functional>
 #include <thread>
 #include <string>
 #include <memory>
@@ -23,6 +24,19 @@ struct ShmRegisterRequest {
     uint64_t dummy_base_addr;
     uint64_t shm_size;
     bool is_local_buffer;
+    // kShmIpcRegister registers the shm passed along with the request,
+    // kShmIpcExportSegments asks for the global segments of the real client.
+    uint8_t op = 0;
+};
+
+constexpr uint8_t kShmIpcRegister = 0;
+constexpr uint8_t kShmIpcExportSegments = 1;
+
+// Sent by the real client, with the memfd of the segment, for each exported
+// global segment. A count of segments (uint32_t) is sent before them.
+struct SegmentExportEntry {
+    uint64_t real_base_addr;
+    uint64_t size;
 };
 
 class ClientRequester {
@@ -40,6 +54,14 @@ class ClientRequester {
                              const std::vector<std::string> &keys,
                              const std::vector<int64_t> sizes);
 
+    /**
+     * @brief Tells the remote client that a batch returned by
+     * batch_get_offload_object has been read, so that its buffer is reused
+     * without waiting for the lease to expire.
+     */
+    tl::expected<void, ErrorCode> release_offload_object(
+        const std::string &client_addr, uint64_t batch_id);
+
    private:
     /**
      * @brief A batch of allocated memory buffers, tracking both handles and
@@ -111,8 +133,14 @@ class PyClient {
 
     virtual int register_buffer(void *buffer, size_t size) = 0;
 
+    virtual int register_device_buffer(void *buffer, size_t size,
+                                       int device_id) = 0;
+
     virtual int unregister_buffer(void *buffer) = 0;
 
+    // Drops cached registrations of memory about to be returned to the OS
+    virtual int invalidate_buffer(void *buffer, size_t size) = 0;
+
     virtual int64_t get_into(const std::string &key, void *buffer,
                              size_t size) = 0;
 
@@ -130,6 +158,43 @@ class PyClient {
     virtual int put_from(const std::string &key, void *buffer, size_t size,
                          const ReplicateConfig &config = ReplicateConfig{}) = 0;
 
+    // get_into and put_from completing through a callback
+    virtual void get_into_async(const std::string &key, void *buffer,
+                                size_t size,
+                                std::function<void(int64_t)> callback) = 0;
+
+    virtual void batch_get_into_stream(
+        const std::vector<std::string> &keys,
+        const std::vector<void *> &buffers, const std::vector<size_t> &sizes,
+        std::function<void(size_t, int64_t)> callback) = 0;
+
+    virtual void put_from_async(const std::string &key, void *buffer,
+                                size_t size, const ReplicateConfig &config,
+                                std::function<void(int)> callback) = 0;
+
+    virtual int64_t get_into_ranges(const std::string &key,
+                                    const std::vector<void *> &buffers,
+                                    const std::vector<size_t> &sizes) = 0;
+
+    virtual int64_t get_object_ranges_into(
+        const std::string &key, const std::vector<uint64_t> &offsets,
+        const std::vector<void *> &buffers,
+        const std::vector<size_t> &sizes) = 0;
+
+    virtual int put_from_ranges(
+        const std::string &key, const std::vector<void *> &buffers,
+        const std::vector<size_t> &sizes,
+        const ReplicateConfig &config = ReplicateConfig{}) = 0;
+
+    virtual int broadcast_publish(
+        const std::string &key, void *buffer, size_t size, size_t chunk_size,
+        const ReplicateConfig &config = ReplicateConfig{}) = 0;
+
+    virtual int64_t broadcast_receive(const std::string &key, void *buffer,
+                                      size_t size, int rank,
+                                      int num_subscribers, int fanout,
+                                      int64_t timeout_ms) = 0;
+
     virtual int put_from_with_metadata(
         const std::string &key, void *buffer, void *metadata_buffer,
         size_t size, size_t metadata_size,
@@ -152,6 +217,16 @@ class PyClient {
     virtual std::tuple<uint64_t, size_t> get_buffer_info(
         const std::string &key) = 0;
 
+    /**
+     * @brief Locate a key in the global segment of the local real client
+     * without copying it
+     * @return Tuple of the read-only address, size and lease in ms of the
+     * object, or (0, 0, 0) if it has no replica in a local segment. The
+     * bytes stay valid until the lease expires.
+     */
+    virtual std::tuple<uint64_t, size_t, uint64_t> get_zero_copy_info(
+        const std::string &key) = 0;
+
     virtual std::vector<std::shared_ptr<BufferHandle>> batch_get_buffer(
         const std::vector<std::string> &keys) = 0;
 
@@ -177,6 +252,8 @@ class PyClient {
     virtual std::vector<int> batchIsExist(
         const std::vector<std::string> &keys) = 0;
 
+    virtual int prefetch(const std::vector<std::string> &keys) = 0;
+
     virtual int64_t getSize(const std::string &key) = 0;
 
     virtual std::map<std::string, std::vector<Replica::Descriptor>>
@@ -3,7 +3,9 @@
 #include <atomic>
 #include <boost/lockfree/queue.hpp>
 #include <csignal>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_set>
@@ -13,6 +15,8 @@
 #include "client_service.h"
 #include "client_buffer.hpp"
 #include "mutex.h"
+#include "registration_cache.h"
+#include "warm_restart.h"
 #include "utils.h"
 #include "rpc_types.h"
 
@@ -93,8 +97,21 @@ class RealClient : public PyClient {
 
     int register_buffer(void *buffer, size_t size);
 
+    /**
+     * @brief Register GPU memory of the given CUDA device, so that the
+     * transfer engine reads and writes it directly with GPUDirect RDMA
+     */
+    int register_device_buffer(void *buffer, size_t size, int device_id);
+
     int unregister_buffer(void *buffer);
 
+    /**
+     * @brief Deregister the released buffers overlapping the range, and the
+     * registered ones once released, before their memory is unmapped. Only
+     * needed with MC_STORE_REGISTRATION_CACHE_BYTES set.
+     */
+    int invalidate_buffer(void *buffer, size_t size);
+
     /**
      * @brief Get object data directly into a pre-allocated buffer
      * @param key Key of the object to get
@@ -153,6 +170,109 @@ class RealClient : public PyClient {
     int put_from(const std::string &key, void *buffer, size_t size,
                  const ReplicateConfig &config = ReplicateConfig{});
 
+    /**
+     * @brief Starts a get_into and returns once its transfer is submitted
+     * @param callback Called with the result of get_into, from the
+     * completion thread of the client unless the get fails before its
+     * transfer is submitted
+     * @note The buffer must stay valid until the callback runs
+     */
+    void get_into_async(const std::string &key, void *buffer, size_t size,
+                        std::function<void(int64_t)> callback);
+
+    /**
+     * @brief Starts a batch_get_into and reports each key as soon as it and
+     * all the keys before it are done
+     * @param callback Called once per key, in the order of the keys, with
+     * the index of the key and its get_into result, from the completion
+     * thread of the client or the calling thread
+     * @note The buffers must stay valid until the last callback runs
+     */
+    void batch_get_into_stream(const std::vector<std::string> &keys,
+                               const std::vector<void *> &buffers,
+                               const std::vector<size_t> &sizes,
+                               std::function<void(size_t, int64_t)> callback);
+
+    /**
+     * @brief Starts a put_from and returns once its transfers are submitted
+     * @param callback Called with the result of put_from, from the
+     * completion thread of the client unless the put fails before its
+     * transfers are submitted
+     * @note The buffer must stay valid until the callback runs
+     */
+    void put_from_async(const std::string &key, void *buffer, size_t size,
+                        const ReplicateConfig &config,
+                        std::function<void(int)> callback);
+
+    /**
+     * @brief Get object data directly into a list of regions, e.g. the pages
+     * of a paged KV cache, in order
+     * @param buffers Start of each region (must be registered with
+     * register_buffer)
+     * @param sizes Size of each region
+     * @return Number of bytes read on success, negative value on error
+     * @note Regions are filled in order and those past the end of the object
+     * are left untouched. Adjacent regions are transferred as one.
+     */
+    int64_t get_into_ranges(const std::string &key,
+                            const std::vector<void *> &buffers,
+                            const std::vector<size_t> &sizes);
+
+    /**
+     * @brief Read only some byte ranges of an object
+     * @param offsets Offset of each range in the object
+     * @param buffers Destination of each range (must be registered with
+     * register_buffer)
+     * @param sizes Size of each range
+     * @return Size of the whole object on success, negative value on error
+     */
+    int64_t get_object_ranges_into(const std::string &key,
+                                   const std::vector<uint64_t> &offsets,
+                                   const std::vector<void *> &buffers,
+                                   const std::vector<size_t> &sizes);
+
+    /**
+     * @brief Put an object made of a list of regions, in order, without
+     * packing them into a staging buffer
+     * @param buffers Start of each region (must be registered with
+     * register_buffer)
+     * @param sizes Size of each region
+     * @return 0 on success, negative value on error
+     */
+    int put_from_ranges(const std::string &key,
+                        const std::vector<void *> &buffers,
+                        const std::vector<size_t> &sizes,
+                        const ReplicateConfig &config = ReplicateConfig{});
+
+    /**
+     * @brief Publish a buffer to be broadcast to many subscribers, as a
+     * manifest under the key and chunks of chunk_size bytes
+     * @param buffer Data to publish (must be registered with register_buffer)
+     * @return 0 on success, negative value on error
+     */
+    int broadcast_publish(const std::string &key, void *buffer, size_t size,
+                          size_t chunk_size,
+                          const ReplicateConfig &config = ReplicateConfig{});
+
+    /**
+     * @brief Receive a broadcast published with broadcast_publish
+     *
+     * Subscribers form a tree of the given fanout below the publisher, a
+     * chain with fanout 1. Each subscriber reads the chunks from its parent
+     * and, if it has children, puts each chunk into its own segment as soon
+     * as it is read, so that the chunks are forwarded down the tree while
+     * the next ones are read and no NIC serves more than fanout readers.
+     * @param buffer Destination (must be registered with register_buffer)
+     * @param rank Rank of the subscriber in [0, num_subscribers)
+     * @param timeout_ms Time to wait for each chunk of the parent
+     * @return Size of the broadcast on success, negative value on error
+     * @note The forwarded chunks are regular objects under key@<node>#<chunk>,
+     * to be removed with the broadcast by remove_by_regex
+     */
+    int64_t broadcast_receive(const std::string &key, void *buffer,
+                              size_t size, int rank, int num_subscribers,
+                              int fanout, int64_t timeout_ms);
+
     /**
      * @brief Put object data directly from pre-allocated buffers for multiple
      * keys(metadata version, better not be directly used in Python)
@@ -235,6 +355,9 @@ class RealClient : public PyClient {
      */
     std::tuple<uint64_t, size_t> get_buffer_info(const std::string &key);
 
+    std::tuple<uint64_t, size_t, uint64_t> get_zero_copy_info(
+        const std::string &key);
+
     /**
      * @brief Get buffers containing the data for multiple keys (batch version)
      * @param keys Vector of keys to get data for
@@ -267,6 +390,14 @@ class RealClient : public PyClient {
      */
     std::vector<int> batchIsExist(const std::vector<std::string> &keys);
 
+    /**
+     * @brief Start copying the disk replicas of objects into local memory
+     * segments without waiting, so that later gets read them from memory
+     * @param keys Keys of the objects to prefetch
+     * @return 0 if the prefetch was started, negative value on error
+     */
+    int prefetch(const std::vector<std::string> &keys);
+
     /**
      * @brief Get the size of an object
      * @param key Key of the object
@@ -311,6 +442,10 @@ class RealClient : public PyClient {
     tl::expected<std::tuple<uint64_t, size_t>, ErrorCode>
     get_buffer_info_dummy_helper(const std::string &key, const UUID &client_id);
 
+    // Lease on a local replica of the key in an exported segment
+    tl::expected<ZeroCopyLease, ErrorCode> get_zero_copy_dummy_helper(
+        const std::string &key);
+
     tl::expected<void, ErrorCode> put_dummy_helper(
         const std::string &key, std::span<const char> value,
         const ReplicateConfig &config, const UUID &client_id);
@@ -335,6 +470,30 @@ class RealClient : public PyClient {
         const std::vector<size_t> &sizes, const ReplicateConfig &config,
         const UUID &client_id);
 
+    tl::expected<int64_t, ErrorCode> get_into_ranges_dummy_helper(
+        const std::string &key, const std::vector<uint64_t> &dummy_buffers,
+        const std::vector<size_t> &sizes, const UUID &client_id);
+
+    tl::expected<int64_t, ErrorCode> get_object_ranges_into_dummy_helper(
+        const std::string &key, const std::vector<uint64_t> &offsets,
+        const std::vector<uint64_t> &dummy_buffers,
+        const std::vector<size_t> &sizes, const UUID &client_id);
+
+    tl::expected<void, ErrorCode> put_from_ranges_dummy_helper(
+        const std::string &key, const std::vector<uint64_t> &dummy_buffers,
+        const std::vector<size_t> &sizes, const ReplicateConfig &config,
+        const UUID &client_id);
+
+    tl::expected<void, ErrorCode> broadcast_publish_dummy_helper(
+        const std::string &key, uint64_t dummy_buffer, size_t size,
+        size_t chunk_size, const ReplicateConfig &config,
+        const UUID &client_id);
+
+    tl::expected<int64_t, ErrorCode> broadcast_receive_dummy_helper(
+        const std::string &key, uint64_t dummy_buffer, size_t size, int rank,
+        int num_subscribers, int fanout, int64_t timeout_ms,
+        const UUID &client_id);
+
     // Share mem management for dummy client
     // Modified: map_shm_internal now takes fd instead of just name
     tl::expected<void, ErrorCode> map_shm_internal(int fd,
@@ -380,10 +539,18 @@ class RealClient : public PyClient {
     tl::expected<void, ErrorCode> register_buffer_internal(void *buffer,
                                                            size_t size);
 
+    tl::expected<void, ErrorCode> register_device_buffer_internal(
+        void *buffer, size_t size, int device_id);
+
     tl::expected<int64_t, ErrorCode> get_into_internal(const std::string &key,
                                                        void *buffer,
                                                        size_t size);
 
+    // Slices of the buffer for the preferred replica, returns the object size
+    tl::expected<uint64_t, ErrorCode> prepare_get_into_slices(
+        const QueryResult &query_result, void *buffer, size_t size,
+        std::vector<Slice> &slices);
+
     std::vector<tl::expected<int64_t, ErrorCode>> batch_get_into_internal(
         const std::vector<std::string> &keys,
         const std::vector<void *> &buffers, const std::vector<size_t> &sizes);
@@ -395,10 +562,36 @@ class RealClient : public PyClient {
         const std::vector<std::vector<size_t>> &all_sizes,
         bool prefer_same_node);
 
+    tl::expected<int64_t, ErrorCode> get_into_ranges_internal(
+        const std::string &key, const std::vector<void *> &buffers,
+        const std::vector<size_t> &sizes);
+
+    tl::expected<int64_t, ErrorCode> get_object_ranges_into_internal(
+        const std::string &key, const std::vector<uint64_t> &offsets,
+        const std::vector<void *> &buffers, const std::vector<size_t> &sizes);
+
+    tl::expected<void, ErrorCode> put_from_ranges_internal(
+        const std::string &key, const std::vector<void *> &buffers,
+        const std::vector<size_t> &sizes,
+        const ReplicateConfig &config = ReplicateConfig{});
+
     tl::expected<void, ErrorCode> put_from_internal(
         const std::string &key, void *buffer, size_t size,
         const ReplicateConfig &config = ReplicateConfig{});
 
+    tl::expected<void, ErrorCode> broadcast_publish_internal(
+        const std::string &key, void *buffer, size_t size, size_t chunk_size,
+        const ReplicateConfig &config);
+
+    tl::expected<int64_t, ErrorCode> broadcast_receive_internal(
+        const std::string &key, void *buffer, size_t size, int rank,
+        int num_subscribers, int fanout, int64_t timeout_ms);
+
+    // Query the key until it is complete or the deadline passes
+    tl::expected<QueryResult, ErrorCode> wait_for_object(
+        const std::string &key,
+        std::chrono::steady_clock::time_point deadline);
+
     std::vector<tl::expected<void, ErrorCode>> batch_put_from_internal(
         const std::vector<std::string> &keys,
         const std::vector<void *> &buffers, const std::vector<size_t> &sizes,
@@ -439,6 +632,9 @@ class RealClient : public PyClient {
     std::vector<tl::expected<bool, ErrorCode>> batchIsExist_internal(
         const std::vector<std::string> &keys);
 
+    tl::expected<void, ErrorCode> prefetch_internal(
+        const std::vector<std::string> &keys);
+
     tl::expected<int64_t, ErrorCode> getSize_internal(const std::string &key);
 
     std::shared_ptr<BufferHandle> get_buffer_internal(
@@ -446,6 +642,9 @@ class RealClient : public PyClient {
         std::shared_ptr<ClientBufferAllocator> client_buffer_allocator =
             nullptr);
 
+    tl::expected<ZeroCopyLease, ErrorCode> get_zero_copy_internal(
+        const std::string &key);
+
     std::vector<std::shared_ptr<BufferHandle>> batch_get_buffer_internal(
         const std::vector<std::string> &keys);
 
@@ -459,6 +658,12 @@ class RealClient : public PyClient {
     batch_get_offload_object(const std::vector<std::string> &keys,
                              const std::vector<int64_t> &sizes);
 
+    /**
+     * @brief Returns the buffer staging a batch of batch_get_offload_object
+     * to the local file storage, once the caller has read it.
+     */
+    tl::expected<void, ErrorCode> release_offload_object(uint64_t batch_id);
+
     /**
      * @brief Retrieves multiple stored objects from a remote service.
      * @param target_rpc_service_addr Address of the remote RPC service (e.g.,
@@ -471,6 +676,10 @@ class RealClient : public PyClient {
 
     std::unique_ptr<AutoPortBinder> port_binder_ = nullptr;
 
+    // Registrations of the buffers passed to register_buffer and
+    // register_device_buffer
+    std::unique_ptr<RegistrationCache> registration_cache_;
+
     struct SegmentDeleter {
         void operator()(void *ptr) {
             if (ptr) {
@@ -501,6 +710,38 @@ class RealClient : public PyClient {
     std::vector<std::unique_ptr<void, SegmentDeleter>> segment_ptrs_;
     std::vector<std::unique_ptr<void, AscendSegmentDeleter>>
         ascend_segment_ptrs_;
+    // Global segments backed by a memfd, or by the shared memory of
+    // warm_restart_, shared with dummy clients on request when the IPC
+    // server is enabled
+    struct ExportedSegment {
+        int fd = -1;
+        void *base = nullptr;
+        size_t size = 0;
+    };
+    std::vector<ExportedSegment> exported_segments_;
+    void *allocate_exported_segment(size_t &mapped_size, bool use_hugepage);
+
+    // Part of the global segment mounted as one segment, numa_node is -1
+    // when it is not bound to a node
+    struct SegmentChunk {
+        size_t size = 0;
+        int numa_node = -1;
+    };
+    // Guards the segment pointers appended by the warm-up threads
+    std::mutex segment_ptrs_mutex_;
+    // Mount the chunks left after setup, the first is mounted at setup so
+    // the client starts serving with a partial capacity
+    std::vector<std::jthread> segment_warmup_threads_;
+    tl::expected<void, ErrorCode> mount_segment_chunk(
+        const SegmentChunk &chunk, bool use_hugepage);
+    void start_segment_warmup(std::vector<SegmentChunk> chunks,
+                              bool use_hugepage);
+    // Global segment and ids kept for the next process of this client,
+    // unless MC_STORE_WARM_RESTART_DIR is unset
+    std::unique_ptr<WarmRestartState> warm_restart_;
+    tl::expected<void, ErrorCode> mount_warm_segment(
+        const WarmRestartState::Mapping &mapping);
+
     std::string protocol;
     std::string device_name;
     std::string local_hostname;
@@ -525,6 +766,12 @@ class RealClient : public PyClient {
     mutable std::shared_mutex dummy_client_mutex_;
     std::unordered_map<UUID, ShmContext, boost::hash<UUID>> shm_contexts_;
 
+    // Addresses in this process of buffers in the shared memory of a dummy
+    // client. They stay valid while dummy_client_mutex_ is held.
+    tl::expected<std::vector<void *>, ErrorCode> map_dummy_buffers(
+        const UUID &client_id, const std::vector<uint64_t> &dummy_buffers,
+        const std::vector<size_t> &sizes) const;
+
     // Ensure cleanup executes at most once across multiple entry points
     std::atomic<bool> closed_{false};
 
@@ -554,6 +801,7 @@ class RealClient : public PyClient {
     int start_ipc_server();
     int stop_ipc_server();
     void ipc_server_func();
+    void export_segments_via_ipc(int client_sock);
 };
 
 }  // namespace mooncake
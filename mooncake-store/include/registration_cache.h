@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <ylt/util/tl/expected.hpp>
+
+#include "mutex.h"
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Reference-counted cache of the memory registrations of user
+ * buffers, so that registering memory that is already registered, or was
+ * registered recently, does not pay for another memory registration.
+ *
+ * A registration covers a range of addresses. Registering a range inside a
+ * cached one with the same location takes a reference on it. A released
+ * registration stays registered while idle, up to idle_capacity bytes of
+ * them, the least recently released being deregistered first. Registering
+ * a range that partly overlaps idle ones deregisters them first, as the
+ * memory behind them has been remapped.
+ *
+ * Idle registrations pin their memory: with idle_capacity > 0, memory
+ * returned to the OS must be invalidated, or a later mapping at the same
+ * address would reuse the stale registration.
+ */
+class RegistrationCache {
+   public:
+    using RegisterFunc = std::function<tl::expected<void, ErrorCode>(
+        void* addr, size_t length, const std::string& location)>;
+    using UnregisterFunc =
+        std::function<tl::expected<void, ErrorCode>(void* addr)>;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t regions = 0;
+        size_t idle_bytes = 0;
+    };
+
+    // idle_capacity = 0 deregisters a region as soon as it is released
+    RegistrationCache(RegisterFunc register_func,
+                      UnregisterFunc unregister_func, size_t idle_capacity);
+
+    RegistrationCache(const RegistrationCache&) = delete;
+    RegistrationCache& operator=(const RegistrationCache&) = delete;
+
+    tl::expected<void, ErrorCode> Register(void* addr, size_t length,
+                                           const std::string& location);
+
+    /**
+     * @brief Releases a registration made with Register at addr. Addresses
+     * not registered through the cache are deregistered directly.
+     */
+    tl::expected<void, ErrorCode> Unregister(void* addr);
+
+    /**
+     * @brief Deregisters the idle regions overlapping [addr, addr + length),
+     * and the busy ones once released, e.g. before the memory is unmapped.
+     */
+    void Invalidate(void* addr, size_t length);
+
+    // Deregisters every region, registered or not
+    void Clear();
+
+    Stats GetStats() const;
+
+   private:
+    struct Region {
+        size_t length = 0;
+        std::string location;
+        size_t refs = 0;
+        bool stale = false;
+        // Released and kept registered, at idle_it in idle_
+        bool idle = false;
+        std::list<uintptr_t>::iterator idle_it;
+    };
+
+    using RegionMap = std::map<uintptr_t, Region>;
+
+    // The region containing [begin, begin + length), or end()
+    RegionMap::iterator FindContaining(uintptr_t begin, size_t length)
+        REQUIRES(mutex_);
+    void DeregisterLocked(RegionMap::iterator it) REQUIRES(mutex_);
+    void EvictIdleLocked() REQUIRES(mutex_);
+
+    const RegisterFunc register_func_;
+    const UnregisterFunc unregister_func_;
+    const size_t idle_capacity_;
+
+    mutable Mutex mutex_;
+    // Regions by start address, never overlapping
+    RegionMap regions_ GUARDED_BY(mutex_);
+    // Start of each idle region, least recently released first
+    std::list<uintptr_t> idle_ GUARDED_BY(mutex_);
+    size_t idle_bytes_ GUARDED_BY(mutex_) = 0;
+    // Registered address -> start of its region and registration count
+    std::unordered_map<uintptr_t, std::pair<uintptr_t, size_t>> handles_
+        GUARDED_BY(mutex_);
+    uint64_t hits_ GUARDED_BY(mutex_) = 0;
+    uint64_t misses_ GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace mooncake
@@ -28,8 +28,9 @@ using ReplicaID = uint64_t;
  */
 enum class ReplicaType {
     MEMORY,     // Memory replica
-    DISK,       // Disk replica
-    LOCAL_DISK  // Local disk replica
+    DISK,        // Disk replica
+    LOCAL_DISK,  // Local disk replica
+    STRIPED      // Memory replica erasure coded across segments
 };
 
 /**
@@ -39,7 +40,8 @@ inline std::ostream& operator<<(std::ostream& os,
                                 const ReplicaType& replicaType) noexcept {
     static const std::unordered_map<ReplicaType, std::string_view>
         replica_type_strings{{ReplicaType::MEMORY, "MEMORY"},
-                             {ReplicaType::DISK, "DISK"}};
+                             {ReplicaType::DISK, "DISK"},
+                             {ReplicaType::STRIPED, "STRIPED"}};
 
     os << (replica_type_strings.count(replicaType)
                ? replica_type_strings.at(replicaType)
@@ -88,6 +90,29 @@ struct ReplicateConfig {
     std::string preferred_segment{};  // Deprecated: Single preferred segment
                                       // for backward compatibility
     bool prefer_alloc_in_same_node{false};
+    // Relative cost of recomputing the value on a miss, e.g. the number of
+    // tokens of a KV cache block. 0 if unknown, which counts as 1. Only
+    // used by the cost_aware eviction policy.
+    uint32_t recompute_cost{0};
+    // Locality of the expected reader, in the format of Segment::locality.
+    // One replica is placed as close to it as possible.
+    std::string reader_locality{};
+    // If not 0, the object is stored as one striped replica of
+    // stripe_data_chunks data chunks and stripe_parity_chunks parity chunks
+    // on distinct segments instead of replica_num full copies.
+    uint32_t stripe_data_chunks{0};
+    uint32_t stripe_parity_chunks{0};
+    // Tenant charged for the memory of the object, subject to the quotas of
+    // --tenant_quotas. Empty for no tenant.
+    std::string tenant{};
+    // If another put of the key is in progress, PutStart fails with
+    // OBJECT_PUT_IN_PROGRESS instead of OBJECT_ALREADY_EXISTS, and the client
+    // waits for that put to end. It puts the object itself if that put was
+    // revoked.
+    bool wait_for_concurrent_put{false};
+    // If not 0, the object is removed this long after its put completed,
+    // even if soft pinned. Leases still delay the removal.
+    uint64_t ttl_ms{0};
 
     friend std::ostream& operator<<(std::ostream& os,
                                     const ReplicateConfig& config) noexcept {
@@ -104,7 +129,25 @@ struct ReplicateConfig {
                << config.preferred_segment;
         }
         os << ", prefer_alloc_in_same_node: "
-           << config.prefer_alloc_in_same_node << " }";
+           << config.prefer_alloc_in_same_node
+           << ", recompute_cost: " << config.recompute_cost;
+        if (!config.reader_locality.empty()) {
+            os << ", reader_locality: " << config.reader_locality;
+        }
+        if (config.stripe_data_chunks != 0) {
+            os << ", stripe: " << config.stripe_data_chunks << "+"
+               << config.stripe_parity_chunks;
+        }
+        if (!config.tenant.empty()) {
+            os << ", tenant: " << config.tenant;
+        }
+        if (config.wait_for_concurrent_put) {
+            os << ", wait_for_concurrent_put: true";
+        }
+        if (config.ttl_ms != 0) {
+            os << ", ttl_ms: " << config.ttl_ms;
+        }
+        os << " }";
         return os;
     }
 };
@@ -124,6 +167,13 @@ struct LocalDiskReplicaData {
     std::string transport_endpoint;
 };
 
+struct StripedReplicaData {
+    // Data chunks first, then parity chunks, all of the same size
+    std::vector<std::unique_ptr<AllocatedBuffer>> chunks;
+    uint32_t data_chunks = 0;
+    uint64_t object_size = 0;
+};
+
 struct MemoryDescriptor {
     AllocatedBuffer::Descriptor buffer_descriptor;
     YLT_REFL(MemoryDescriptor, buffer_descriptor);
@@ -142,6 +192,18 @@ struct LocalDiskDescriptor {
     YLT_REFL(LocalDiskDescriptor, client_id, object_size, transport_endpoint);
 };
 
+struct StripedDescriptor {
+    uint32_t data_chunks = 0;
+    uint64_t object_size = 0;
+    // Chunk buffers, data chunks first. A lost chunk has size 0.
+    std::vector<AllocatedBuffer::Descriptor> chunk_descriptors;
+    YLT_REFL(StripedDescriptor, data_chunks, object_size, chunk_descriptors);
+
+    uint64_t chunk_size() const {
+        return (object_size + data_chunks - 1) / data_chunks;
+    }
+};
+
 class Replica {
    public:
     struct Descriptor;
@@ -169,6 +231,23 @@ class Replica {
                                      std::move(transport_endpoint)}),
           status_(status) {}
 
+    /**
+     * @brief Build a striped replica from memory replicas holding its
+     * chunks, data chunks first.
+     */
+    static Replica MakeStriped(std::vector<Replica>&& chunk_replicas,
+                               uint32_t data_chunks, uint64_t object_size,
+                               ReplicaStatus status) {
+        StripedReplicaData data;
+        data.data_chunks = data_chunks;
+        data.object_size = object_size;
+        for (auto& chunk_replica : chunk_replicas) {
+            data.chunks.push_back(std::move(
+                std::get<MemoryReplicaData>(chunk_replica.data_).buffer));
+        }
+        return Replica(std::move(data), status);
+    }
+
     ~Replica() {
         if (status_ != ReplicaStatus::UNDEFINED && is_disk_replica()) {
             const auto& disk_data = std::get<DiskReplicaData>(data_);
@@ -265,11 +344,33 @@ class Replica {
         return replica.is_local_disk_replica();
     }
 
+    [[nodiscard]] bool is_striped_replica() const {
+        return std::holds_alternative<StripedReplicaData>(data_);
+    }
+
+    [[nodiscard]] static bool fn_is_striped_replica(const Replica& replica) {
+        return replica.is_striped_replica();
+    }
+
+    // Memory or striped replica, i.e. one that holds segment memory
+    [[nodiscard]] static bool fn_is_in_memory(const Replica& replica) {
+        return replica.is_memory_replica() || replica.is_striped_replica();
+    }
+
     [[nodiscard]] bool has_invalid_mem_handle() const {
         if (is_memory_replica()) {
             const auto& mem_data = std::get<MemoryReplicaData>(data_);
             return !mem_data.buffer->isAllocatorValid();
         }
+        if (is_striped_replica()) {
+            // Readable as long as data_chunks chunks are left
+            const auto& striped_data = std::get<StripedReplicaData>(data_);
+            size_t valid_chunks = 0;
+            for (const auto& chunk : striped_data.chunks) {
+                valid_chunks += chunk->isAllocatorValid();
+            }
+            return valid_chunks < striped_data.data_chunks;
+        }
         return false;  // DiskReplicaData does not have handles
     }
 
@@ -277,6 +378,13 @@ class Replica {
         if (is_memory_replica()) {
             const auto& mem_data = std::get<MemoryReplicaData>(data_);
             return mem_data.buffer->size();
+        } else if (is_striped_replica()) {
+            const auto& striped_data = std::get<StripedReplicaData>(data_);
+            size_t size = 0;
+            for (const auto& chunk : striped_data.chunks) {
+                size += chunk->size();
+            }
+            return size;
         } else {
             LOG(ERROR) << "Invalid replica type: " << type();
             return 0;
@@ -286,6 +394,21 @@ class Replica {
     [[nodiscard]] std::vector<std::optional<std::string>> get_segment_names()
         const;
 
+    // Move the segment buffers out of a memory or striped replica, e.g. to
+    // free them in a batch. The replica may only be destroyed afterwards.
+    [[nodiscard]] std::vector<std::unique_ptr<AllocatedBuffer>> take_buffers() {
+        std::vector<std::unique_ptr<AllocatedBuffer>> buffers;
+        if (is_memory_replica()) {
+            auto& mem_data = std::get<MemoryReplicaData>(data_);
+            if (mem_data.buffer) {
+                buffers.push_back(std::move(mem_data.buffer));
+            }
+        } else if (is_striped_replica()) {
+            buffers = std::move(std::get<StripedReplicaData>(data_).chunks);
+        }
+        return buffers;
+    }
+
     void mark_complete() {
         if (status_ == ReplicaStatus::PROCESSING) {
             status_ = ReplicaStatus::COMPLETE;
@@ -314,11 +437,15 @@ class Replica {
         ReplicaType operator()(const LocalDiskReplicaData&) const {
             return ReplicaType::LOCAL_DISK;
         }
+        ReplicaType operator()(const StripedReplicaData&) const {
+            return ReplicaType::STRIPED;
+        }
     };
 
     struct Descriptor {
         ReplicaID id;
-        std::variant<MemoryDescriptor, DiskDescriptor, LocalDiskDescriptor>
+        std::variant<MemoryDescriptor, DiskDescriptor, LocalDiskDescriptor,
+                     StripedDescriptor>
             descriptor_variant;
         ReplicaStatus status;
         YLT_REFL(Descriptor, id, descriptor_variant, status);
@@ -350,6 +477,11 @@ class Replica {
                 descriptor_variant);
         }
 
+        bool is_striped_replica() const noexcept {
+            return std::holds_alternative<StripedDescriptor>(
+                descriptor_variant);
+        }
+
         MemoryDescriptor& get_memory_descriptor() {
             if (auto* desc =
                     std::get_if<MemoryDescriptor>(&descriptor_variant)) {
@@ -395,13 +527,28 @@ class Replica {
             }
             throw std::runtime_error("Expected LocalDiskDescriptor");
         }
+
+        const StripedDescriptor& get_striped_descriptor() const {
+            if (auto* desc =
+                    std::get_if<StripedDescriptor>(&descriptor_variant)) {
+                return *desc;
+            }
+            throw std::runtime_error("Expected StripedDescriptor");
+        }
     };
 
    private:
+    Replica(StripedReplicaData&& data, ReplicaStatus status)
+        : id_(next_id_.fetch_add(1)),
+          data_(std::move(data)),
+          status_(status),
+          refcnt_(0) {}
+
     inline static std::atomic<ReplicaID> next_id_{1};
 
     ReplicaID id_;
-    std::variant<MemoryReplicaData, DiskReplicaData, LocalDiskReplicaData>
+    std::variant<MemoryReplicaData, DiskReplicaData, LocalDiskReplicaData,
+                 StripedReplicaData>
         data_;
     ReplicaStatus status_{ReplicaStatus::UNDEFINED};
     std::atomic<uint32_t> refcnt_{0};
@@ -437,6 +584,21 @@ inline Replica::Descriptor Replica::get_descriptor() const {
         local_disk_desc.object_size = disk_data.object_size;
         local_disk_desc.transport_endpoint = disk_data.transport_endpoint;
         desc.descriptor_variant = std::move(local_disk_desc);
+    } else if (is_striped_replica()) {
+        const auto& striped_data = std::get<StripedReplicaData>(data_);
+        StripedDescriptor striped_desc;
+        striped_desc.data_chunks = striped_data.data_chunks;
+        striped_desc.object_size = striped_data.object_size;
+        for (const auto& chunk : striped_data.chunks) {
+            if (chunk->isAllocatorValid()) {
+                striped_desc.chunk_descriptors.push_back(
+                    chunk->get_descriptor());
+            } else {
+                // The segment is gone, the client rebuilds the chunk
+                striped_desc.chunk_descriptors.emplace_back();
+            }
+        }
+        desc.descriptor_variant = std::move(striped_desc);
     }
 
     return desc;
@@ -454,6 +616,18 @@ inline std::vector<std::optional<std::string>> Replica::get_segment_names()
         }
         return segment_names;
     }
+    if (is_striped_replica()) {
+        const auto& striped_data = std::get<StripedReplicaData>(data_);
+        std::vector<std::optional<std::string>> segment_names;
+        for (const auto& chunk : striped_data.chunks) {
+            if (chunk->isAllocatorValid()) {
+                segment_names.push_back(chunk->getSegmentName());
+            } else {
+                segment_names.push_back(std::nullopt);
+            }
+        }
+        return segment_names;
+    }
     return std::vector<std::optional<std::string>>();
 }
 
@@ -472,6 +646,15 @@ inline std::ostream& operator<<(std::ostream& os, const Replica& replica) {
         const auto& disk_data = std::get<DiskReplicaData>(replica.data_);
         os << "type: DISK, file_path: " << disk_data.file_path
            << ", object_size: " << disk_data.object_size;
+    } else if (replica.is_striped_replica()) {
+        const auto& striped_data = std::get<StripedReplicaData>(replica.data_);
+        os << "type: STRIPED, data_chunks: " << striped_data.data_chunks
+           << ", object_size: " << striped_data.object_size << ", chunks: [";
+        for (size_t i = 0; i < striped_data.chunks.size(); ++i) {
+            if (i > 0) os << ", ";
+            os << *striped_data.chunks[i];
+        }
+        os << "]";
     }
 
     os << ", refcnt: " << replica.refcnt_.load() << " }";
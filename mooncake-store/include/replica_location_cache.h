@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "replica.h"
+
+namespace mooncake {
+
+/**
+ * @brief Client-side cache of the replica descriptors returned by the
+ * master, keyed by object key.
+ *
+ * While the lease granted by a query holds, the master neither evicts nor
+ * removes the object (unless forced), so repeated reads of a hot object can
+ * skip the master RPC. An entry is only served while at least half of its
+ * lease is left, so the read can finish before the lease ends.
+ *
+ * The master bumps an invalidation epoch, reported in every Ping response,
+ * when replicas may disappear regardless of leases: forced removals, moves
+ * and unmounted segments. A new epoch or master view drops every entry.
+ *
+ * Thread-safe.
+ */
+class ReplicaLocationCache {
+   public:
+    struct Entry {
+        std::vector<Replica::Descriptor> replicas;
+        std::chrono::steady_clock::time_point lease_timeout;
+    };
+
+    // capacity = 0 disables the cache
+    explicit ReplicaLocationCache(size_t capacity);
+
+    ReplicaLocationCache(const ReplicaLocationCache&) = delete;
+    ReplicaLocationCache& operator=(const ReplicaLocationCache&) = delete;
+
+    bool enabled() const { return capacity_per_shard_ > 0; }
+
+    // Must be read before the query is sent and be passed to Put
+    uint64_t generation() const;
+
+    std::optional<Entry> Get(const std::string& key) const;
+
+    /**
+     * @brief Cache the result of a query sent at query_time. Ignored if the
+     * cache was invalidated after generation was read.
+     */
+    void Put(const std::string& key, uint64_t generation,
+             const std::vector<Replica::Descriptor>& replicas,
+             std::chrono::steady_clock::time_point query_time,
+             std::chrono::steady_clock::time_point lease_timeout);
+
+    void Invalidate(const std::string& key);
+
+    void Clear();
+
+    /**
+     * @brief Apply the master view and invalidation epoch of a Ping
+     * response. Drops every entry if either changed.
+     */
+    void SyncEpoch(uint64_t view_version, uint64_t invalidation_epoch);
+
+    size_t size() const;
+
+   private:
+    struct CachedEntry {
+        Entry entry;
+        // Entries are served until this time point, the middle of the lease
+        std::chrono::steady_clock::time_point serve_until;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, CachedEntry> entries;
+    };
+
+    static constexpr size_t kNumShards = 16;
+
+    Shard& GetShard(const std::string& key) const {
+        return shards_[std::hash<std::string>{}(key) % kNumShards];
+    }
+
+    const size_t capacity_per_shard_;
+    mutable Shard shards_[kNumShards];
+
+    mutable std::mutex epoch_mutex_;
+    // Bumped on every invalidation, protected by epoch_mutex_
+    uint64_t generation_{0};
+    std::optional<std::pair<uint64_t, uint64_t>> last_epoch_;
+};
+
+/**
+ * @brief The keys following key in a chain of numbered keys, e.g. the
+ * blocks of a prefix "req/0007" -> "req/0008", "req/0009", ...
+ * @return Empty if the key does not end with a number
+ */
+std::vector<std::string> ChainSuccessorKeys(const std::string& key,
+                                            size_t count);
+
+}  // namespace mooncake
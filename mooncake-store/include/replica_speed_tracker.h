@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Latency and bandwidth of the reads from each remote transport
+ * endpoint, as exponentially weighted moving averages, to read an object
+ * from the replica expected to be the fastest.
+ *
+ * Reads of at most kLatencyBoundSize bytes update the latency, larger ones
+ * the bandwidth. A failed read counts as a read of kFailurePenaltyUs, so
+ * that degraded hosts are avoided. Estimates not updated for the ttl are
+ * dropped, so that an avoided endpoint is probed again once it may have
+ * recovered.
+ *
+ * Thread-safe.
+ */
+class ReplicaSpeedTracker {
+   public:
+    static constexpr uint64_t kLatencyBoundSize = 64 * 1024;
+    static constexpr uint64_t kFailurePenaltyUs = 1000 * 1000;
+    // Weight of a new sample
+    static constexpr double kAlpha = 0.2;
+
+    explicit ReplicaSpeedTracker(std::chrono::milliseconds ttl);
+
+    ReplicaSpeedTracker(const ReplicaSpeedTracker&) = delete;
+    ReplicaSpeedTracker& operator=(const ReplicaSpeedTracker&) = delete;
+
+    void Record(const std::string& endpoint, uint64_t size,
+                uint64_t latency_us);
+
+    void RecordFailure(const std::string& endpoint);
+
+    // Expected microseconds to read size bytes, nullopt without an estimate
+    std::optional<double> Estimate(const std::string& endpoint,
+                                   uint64_t size) const;
+
+    /**
+     * @brief Index of the endpoint expected to read size bytes the fastest.
+     * Endpoints without an estimate come first so that they get one.
+     */
+    size_t PickFastest(const std::vector<std::string>& endpoints,
+                       uint64_t size) const;
+
+   private:
+    struct Speed {
+        std::optional<double> latency_us;
+        std::optional<double> bytes_per_us;
+        std::chrono::steady_clock::time_point updated;
+    };
+
+    void Update(const std::string& endpoint, uint64_t size, double latency_us);
+
+    std::optional<double> EstimateLocked(const std::string& endpoint,
+                                         uint64_t size) const;
+
+    const std::chrono::milliseconds ttl_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Speed> speeds_;
+};
+
+}  // namespace mooncake
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace mooncake {
+
+/**
+ * @brief A timed step of a sampled client request.
+ *
+ * A root span starts a trace for the sampled share of the requests, set by
+ * MC_STORE_TRACE_SAMPLE_RATE (0, the default, disables tracing). A child
+ * span is recorded only within a sampled span of the same thread and costs
+ * a thread-local load otherwise, so steps deep in the request path can be
+ * spans without a cost for the requests not sampled. A root span within a
+ * sampled span is a child of it.
+ *
+ * Ended spans are appended to MC_STORE_TRACE_FILE, by default
+ * mooncake_trace_<pid>.jsonl, one OTLP JSON span per line for an
+ * OpenTelemetry collector to pick up.
+ *
+ * Spans are scoped objects, and must end in the reverse order they start.
+ */
+class TraceSpan {
+   public:
+    enum class Kind { ROOT, CHILD };
+
+    explicit TraceSpan(const char* name, Kind kind = Kind::CHILD)
+        : name_(name) {
+        if (current_ != nullptr || (kind == Kind::ROOT && Sample())) {
+            Begin();
+        }
+    }
+
+    ~TraceSpan() {
+        if (active_) {
+            End();
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    bool active() const { return active_; }
+
+    void SetAttribute(const char* key, std::string_view value) {
+        if (active_) {
+            AddAttribute(key, value, true);
+        }
+    }
+
+    void SetAttribute(const char* key, int64_t value) {
+        if (active_) {
+            AddAttribute(key, std::to_string(value), false);
+        }
+    }
+
+    /**
+     * @brief Replace the sample rate and the file spans are written to,
+     * which are otherwise read from the environment on first use.
+     */
+    static void Configure(double sample_rate, const std::string& path);
+
+   private:
+    static bool Sample();
+    void Begin();
+    void End();
+    void AddAttribute(const char* key, std::string_view value,
+                      bool is_string);
+
+    static inline thread_local TraceSpan* current_ = nullptr;
+
+    const char* name_;
+    bool active_ = false;
+    uint64_t trace_id_high_ = 0;
+    uint64_t trace_id_low_ = 0;
+    uint64_t span_id_ = 0;
+    uint64_t parent_span_id_ = 0;
+    uint64_t start_ns_ = 0;
+    TraceSpan* parent_ = nullptr;
+    // OTLP JSON attribute list entries, comma-separated
+    std::string attributes_;
+};
+
+}  // namespace mooncake
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Merges concurrent single-key calls into calls of a batch function,
+ * e.g. ExistKey calls from many threads into one BatchExistKey RPC.
+ *
+ * The first caller opens a batch and waits up to the window for other
+ * callers to join, or until the batch is full. It then calls the batch
+ * function for all of them and hands out the results. Callers arriving once
+ * the batch is closed open the next one, so batches overlap and a caller
+ * waits at most one window plus one batch call.
+ *
+ * Thread-safe.
+ */
+template <typename Result>
+class RpcCoalescer {
+   public:
+    // Must return one result per key, in the order of the keys
+    using BatchFn =
+        std::function<std::vector<Result>(const std::vector<std::string>&)>;
+
+    RpcCoalescer(std::chrono::microseconds window, size_t max_batch_size,
+                 BatchFn batch_fn)
+        : window_(window),
+          max_batch_size_(max_batch_size),
+          batch_fn_(std::move(batch_fn)) {}
+
+    RpcCoalescer(const RpcCoalescer&) = delete;
+    RpcCoalescer& operator=(const RpcCoalescer&) = delete;
+
+    Result Call(const std::string& key) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (open_batch_) {
+            auto batch = open_batch_;
+            const size_t index = batch->keys.size();
+            batch->keys.push_back(key);
+            if (batch->keys.size() == max_batch_size_) {
+                open_batch_.reset();
+                cv_.notify_all();  // the leader need not wait any longer
+            }
+            cv_.wait(lock, [&batch] { return batch->done; });
+            return std::move(batch->results[index]);
+        }
+
+        auto batch = std::make_shared<Batch>();
+        batch->keys.push_back(key);
+        if (max_batch_size_ > 1) {
+            open_batch_ = batch;
+            cv_.wait_for(lock, window_,
+                         [this, &batch] { return open_batch_ != batch; });
+            if (open_batch_ == batch) {
+                open_batch_.reset();
+            }
+        }
+
+        // No caller joins a closed batch, its keys can be read unlocked
+        lock.unlock();
+        std::vector<Result> results = batch_fn_(batch->keys);
+        lock.lock();
+        batch->results = std::move(results);
+        batch->done = true;
+        cv_.notify_all();
+        return std::move(batch->results[0]);
+    }
+
+   private:
+    struct Batch {
+        std::vector<std::string> keys;
+        std::vector<Result> results;
+        bool done{false};
+    };
+
+    const std::chrono::microseconds window_;
+    const size_t max_batch_size_;
+    const BatchFn batch_fn_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    // The batch new callers join, nullptr once it is closed
+    std::shared_ptr<Batch> open_batch_;
+};
+
+}  // namespace mooncake
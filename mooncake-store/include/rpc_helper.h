@@ -2,11 +2,14 @@
 
 #include <ylt/struct_json/json_writer.h>
 
+#include <chrono>
+#include <string>
 #include <string_view>
 #include <type_traits>
 #include <ylt/reflection/user_reflect_macro.hpp>
 #include <ylt/util/tl/expected.hpp>
 
+#include "master_metric_manager.h"
 #include "types.h"
 #include "utils/scoped_vlog_timer.h"
 
@@ -21,6 +24,30 @@ struct is_tl_expected<tl::expected<T, ErrorCode>> : std::true_type {};
 template <typename T>
 concept TlExpected = is_tl_expected<std::decay_t<T>>::value;
 
+/**
+ * @brief Observes the latency of a master RPC into the per-RPC latency
+ * histogram of MasterMetricManager when it goes out of scope.
+ */
+class ScopedRpcLatency {
+   public:
+    explicit ScopedRpcLatency(std::string_view rpc_name)
+        : rpc_name_(rpc_name), start_time_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedRpcLatency() {
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time_);
+        MasterMetricManager::instance().observe_rpc_latency(rpc_name_,
+                                                            latency.count());
+    }
+
+    ScopedRpcLatency(const ScopedRpcLatency&) = delete;
+    ScopedRpcLatency& operator=(const ScopedRpcLatency&) = delete;
+
+   private:
+    std::string_view rpc_name_;
+    std::chrono::steady_clock::time_point start_time_;
+};
+
 /**
  * @brief A helper function to execute a single RPC call, handling common tasks
  * like logging, metrics, and error handling.
@@ -43,6 +70,7 @@ auto execute_rpc(std::string_view rpc_name, RpcCallable&& rpc_call,
                  IncReqMetric&& inc_req_metric, IncFailMetric&& inc_fail_metric)
     requires TlExpected<std::invoke_result_t<RpcCallable>>
 {
+    ScopedRpcLatency latency(rpc_name);
     ScopedVLogTimer timer(1, rpc_name.data());
     log_request(timer);
 
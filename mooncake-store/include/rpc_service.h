@@ -4,15 +4,18 @@
 #include <atomic>
 #include <boost/functional/hash.hpp>
 #include <cstdint>
+#include <memory>
 #include <thread>
 #include <ylt/coro_http/coro_http_server.hpp>
 #include <ylt/coro_rpc/coro_rpc_server.hpp>
 #include <ylt/util/tl/expected.hpp>
 
+#include "compact_replica_list.h"
 #include "master_service.h"
 #include "types.h"
 #include "rpc_types.h"
 #include "master_config.h"
+#include "metadata_follower.h"
 
 namespace mooncake {
 
@@ -22,6 +25,11 @@ class WrappedMasterService {
    public:
     WrappedMasterService(const WrappedMasterServiceConfig& config);
 
+    // Standby mode: only the read-only queries are served, from the metadata
+    // replayed by the follower. See RegisterStandbyRpcService.
+    explicit WrappedMasterService(
+        std::shared_ptr<MetadataFollower> standby_follower);
+
     ~WrappedMasterService();
 
     void init_http_server();
@@ -48,12 +56,32 @@ class WrappedMasterService {
         ErrorCode>
     GetReplicaListByRegex(const std::string& str);
 
+    tl::expected<ScanKeysResponse, ErrorCode> ScanKeys(
+        const std::string& prefix, uint64_t cursor, uint64_t limit);
+
     tl::expected<GetReplicaListResponse, ErrorCode> GetReplicaList(
         const std::string& key);
 
     std::vector<tl::expected<GetReplicaListResponse, ErrorCode>>
     BatchGetReplicaList(const std::vector<std::string>& keys);
 
+    // BatchGetReplicaList in the compact wire format, see CompactReplicaLists
+    CompactReplicaLists BatchGetReplicaListCompact(
+        const std::vector<std::string>& keys);
+
+    tl::expected<std::vector<GetReplicaListResponse>, ErrorCode>
+    LongestCachedPrefix(const std::vector<std::string>& keys);
+
+    tl::expected<void, ErrorCode> LinkContent(const std::string& key,
+                                              const std::string& content_key);
+
+    tl::expected<void, ErrorCode> LinkBundle(
+        const std::string& bundle_key, const std::vector<std::string>& keys,
+        const std::vector<uint64_t>& sizes);
+
+    std::vector<tl::expected<BundleMember, ErrorCode>> BatchResolveBundle(
+        const std::vector<std::string>& keys);
+
     tl::expected<std::vector<Replica::Descriptor>, ErrorCode> PutStart(
         const UUID& client_id, const std::string& key,
         const uint64_t slice_length, const ReplicateConfig& config);
@@ -66,6 +94,13 @@ class WrappedMasterService {
                                             const std::string& key,
                                             ReplicaType replica_type);
 
+    tl::expected<void, ErrorCode> PutCommit(const UUID& client_id,
+                                            const std::string& key,
+                                            uint64_t committed_bytes);
+
+    tl::expected<GetCommittedReplicaListResponse, ErrorCode>
+    GetCommittedReplicaList(const std::string& key);
+
     std::vector<tl::expected<std::vector<Replica::Descriptor>, ErrorCode>>
     BatchPutStart(const UUID& client_id, const std::vector<std::string>& keys,
                   const std::vector<uint64_t>& slice_lengths,
@@ -85,6 +120,9 @@ class WrappedMasterService {
 
     long RemoveAll(bool force = false);
 
+    tl::expected<UUID, ErrorCode> RemoveByPrefix(const std::string& prefix,
+                                                 bool force = false);
+
     tl::expected<void, ErrorCode> MountSegment(const Segment& segment,
                                                const UUID& client_id);
 
@@ -94,11 +132,17 @@ class WrappedMasterService {
     tl::expected<void, ErrorCode> UnmountSegment(const UUID& segment_id,
                                                  const UUID& client_id);
 
+    tl::expected<uint64_t, ErrorCode> DrainSegment(const UUID& segment_id,
+                                                   const UUID& client_id);
+
+    tl::expected<GetKeyFilterResponse, ErrorCode> GetKeyFilter(uint64_t since);
+
     tl::expected<std::string, ErrorCode> GetFsdir();
 
     tl::expected<GetStorageConfigResponse, ErrorCode> GetStorageConfig();
 
-    tl::expected<PingResponse, ErrorCode> Ping(const UUID& client_id);
+    tl::expected<PingResponse, ErrorCode> Ping(const UUID& client_id,
+                                               uint64_t transfer_bytes_per_sec);
 
     tl::expected<std::string, ErrorCode> ServiceReady();
 
@@ -106,7 +150,8 @@ class WrappedMasterService {
                                                         bool enable_offloading);
 
     tl::expected<std::unordered_map<std::string, int64_t>, ErrorCode>
-    OffloadObjectHeartbeat(const UUID& client_id, bool enable_offloading);
+    OffloadObjectHeartbeat(const UUID& client_id, bool enable_offloading,
+                           uint64_t max_objects);
 
     tl::expected<void, ErrorCode> NotifyOffloadSuccess(
         const UUID& client_id, const std::vector<std::string>& keys,
@@ -148,7 +193,9 @@ class WrappedMasterService {
                                              const std::string& key);
 
    private:
-    MasterService master_service_;
+    // nullptr in standby mode
+    std::unique_ptr<MasterService> master_service_;
+    std::shared_ptr<MetadataFollower> standby_follower_;
     std::thread metric_report_thread_;
     coro_http::coro_http_server http_server_;
     std::atomic<bool> metric_report_running_;
@@ -157,4 +204,16 @@ class WrappedMasterService {
 void RegisterRpcService(coro_rpc::coro_rpc_server& server,
                         mooncake::WrappedMasterService& wrapped_master_service);
 
+// Register the read-only queries a standby master can serve
+void RegisterStandbyRpcService(
+    coro_rpc::coro_rpc_server& server,
+    mooncake::WrappedMasterService& standby_master_service);
+
+// Serve the latency critical lookups, ExistKey and GetReplicaList, over
+// RDMA on a second port, next to the TCP server of every RPC. Returns null
+// if the server cannot start, e.g. without an RDMA device.
+std::unique_ptr<coro_rpc::coro_rpc_server> StartRdmaRpcServer(
+    size_t thread_num, int port, const std::string& address,
+    mooncake::WrappedMasterService& wrapped_master_service);
+
 }  // namespace mooncake
@@ -12,19 +12,35 @@ namespace mooncake {
 struct PingResponse {
     ViewVersionId view_version_id;
     ClientStatus client_status;
+    // Bumped when replicas may be gone before their leases expire, clients
+    // drop their cached replica locations when it changes.
+    uint64_t replica_invalidation_epoch{0};
+    // Capacity signal: the used ratio of the memory segments, and how long
+    // clients wait before each put start to let eviction catch up, 0 below
+    // the eviction high watermark
+    double mem_used_ratio{0.0};
+    uint64_t put_backoff_ms{0};
 
     PingResponse() = default;
-    PingResponse(ViewVersionId view_version, ClientStatus status)
-        : view_version_id(view_version), client_status(status) {}
+    PingResponse(ViewVersionId view_version, ClientStatus status,
+                 uint64_t invalidation_epoch = 0)
+        : view_version_id(view_version),
+          client_status(status),
+          replica_invalidation_epoch(invalidation_epoch) {}
 
     friend std::ostream& operator<<(std::ostream& os,
                                     const PingResponse& response) noexcept {
         return os << "PingResponse: { view_version_id: "
                   << response.view_version_id
-                  << ", client_status: " << response.client_status << " }";
+                  << ", client_status: " << response.client_status
+                  << ", replica_invalidation_epoch: "
+                  << response.replica_invalidation_epoch
+                  << ", mem_used_ratio: " << response.mem_used_ratio
+                  << ", put_backoff_ms: " << response.put_backoff_ms << " }";
     }
 };
-YLT_REFL(PingResponse, view_version_id, client_status);
+YLT_REFL(PingResponse, view_version_id, client_status,
+         replica_invalidation_epoch, mem_used_ratio, put_backoff_ms);
 
 /**
  * @brief Response structure for GetReplicaList operation
@@ -41,6 +57,53 @@ struct GetReplicaListResponse {
 };
 YLT_REFL(GetReplicaListResponse, replicas, lease_ttl_ms);
 
+/**
+ * @brief Range of the bundle object a key is stored as, see BundleIndex
+ */
+struct BundleMember {
+    std::string bundle_key;
+    uint64_t offset{0};
+    uint64_t size{0};
+};
+YLT_REFL(BundleMember, bundle_key, offset, size);
+
+/**
+ * @brief Replicas of an object put in chunks. Until the put completes only
+ * bytes [0, committed_bytes) of the memory replicas are readable.
+ */
+struct GetCommittedReplicaListResponse {
+    std::vector<Replica::Descriptor> replicas;
+    uint64_t committed_bytes{0};
+    // The put completed, the whole object is readable
+    bool complete{false};
+    uint64_t lease_ttl_ms{0};
+};
+YLT_REFL(GetCommittedReplicaListResponse, replicas, committed_bytes, complete,
+         lease_ttl_ms);
+
+/**
+ * @brief Location of an object in a global segment of the real client,
+ * readable by co-located dummy clients until the lease expires
+ */
+struct ZeroCopyLease {
+    uint64_t real_addr{0};
+    uint64_t size{0};
+    uint64_t lease_ttl_ms{0};
+};
+YLT_REFL(ZeroCopyLease, real_addr, size, lease_ttl_ms);
+
+/**
+ * @brief One page of ScanKeys. A next_cursor of 0 ends the scan.
+ */
+struct ScanKeysResponse {
+    std::vector<std::string> keys;
+    uint64_t next_cursor{0};
+};
+YLT_REFL(ScanKeysResponse, keys, next_cursor);
+
+// Default number of keys per ScanKeys page requested by clients
+static constexpr uint64_t kScanKeysPageSize = 10000;
+
 /**
  * @brief Response structure for GetStorageConfig operation
  */
@@ -147,16 +210,43 @@ struct BatchGetOffloadObjectResponse {
     std::vector<uint64_t> pointers;
     std::string transfer_engine_addr;
     uint64_t gc_ttl_ms;
+    // Passed to release_offload_object once the pointers have been read
+    uint64_t batch_id = 0;
 
     BatchGetOffloadObjectResponse() = default;
     BatchGetOffloadObjectResponse(std::vector<uint64_t>&& pointers_param,
                                   std::string transfer_engine_addr_param,
-                                  uint64_t gc_ttl_ms_param)
+                                  uint64_t gc_ttl_ms_param,
+                                  uint64_t batch_id_param)
         : pointers(std::move(pointers_param)),
           transfer_engine_addr(std::move(transfer_engine_addr_param)),
-          gc_ttl_ms(gc_ttl_ms_param) {}
+          gc_ttl_ms(gc_ttl_ms_param),
+          batch_id(batch_id_param) {}
 };
 YLT_REFL(BatchGetOffloadObjectResponse, pointers, transfer_engine_addr,
-         gc_ttl_ms);
+         gc_ttl_ms, batch_id);
+
+/**
+ * @brief Exported bits of the key filter of one metadata shard
+ */
+struct KeyFilterShardBits {
+    uint32_t shard;
+    std::string bits;
+};
+YLT_REFL(KeyFilterShardBits, shard, bits);
+
+/**
+ * @brief Key filter shards changed since the sequence number of a request.
+ * filter_id changes when the master restarts, the sequence numbers of
+ * different ids must not be compared.
+ */
+struct GetKeyFilterResponse {
+    uint64_t filter_id{0};
+    // Shards changed after seq are sent again by the next sync
+    uint64_t seq{0};
+    uint32_t num_shards{0};
+    std::vector<KeyFilterShardBits> shards;
+};
+YLT_REFL(GetKeyFilterResponse, filter_id, seq, num_shards, shards);
 
 }  // namespace mooncake
@@ -20,6 +20,7 @@ enum class SegmentStatus {
     UNDEFINED = 0,  // Uninitialized
     OK,             // Segment is mounted and available for allocation
     UNMOUNTING,     // Segment is under unmounting
+    DRAINING,       // Segment is readable but its objects are moved away
 };
 
 /**
@@ -30,7 +31,8 @@ inline std::ostream& operator<<(std::ostream& os,
     static const std::unordered_map<SegmentStatus, std::string_view>
         status_strings{{SegmentStatus::UNDEFINED, "UNDEFINED"},
                        {SegmentStatus::OK, "OK"},
-                       {SegmentStatus::UNMOUNTING, "UNMOUNTING"}};
+                       {SegmentStatus::UNMOUNTING, "UNMOUNTING"},
+                       {SegmentStatus::DRAINING, "DRAINING"}};
 
     os << (status_strings.count(status) ? status_strings.at(status)
                                         : "UNKNOWN");
@@ -43,6 +45,14 @@ struct MountedSegment {
     std::shared_ptr<BufferAllocatorBase> buf_allocator;
 };
 
+// Space used in the memory segments of one name
+struct SegmentUsage {
+    std::string name;
+    size_t used = 0;
+    size_t capacity = 0;
+    bool draining = false;
+};
+
 struct LocalDiskSegment {
     mutable Mutex offloading_mutex_;
     bool enable_offloading;
@@ -133,6 +143,26 @@ class ScopedSegmentAccess {
      */
     bool ExistsSegmentName(const std::string& segment_name) const;
 
+    /**
+     * @brief Stop or resume allocating in the segments of a name. Draining
+     * segments stay readable until they are unmounted.
+     */
+    ErrorCode SetSegmentDraining(const std::string& segment_name,
+                                 bool draining);
+
+    /**
+     * @brief Stop allocating in one segment of a client before it is
+     * unmounted
+     * @param used Bytes still allocated in the segment
+     */
+    ErrorCode DrainSegment(const UUID& segment_id, const UUID& client_id,
+                           size_t& used);
+
+    /**
+     * @brief Get the usage of the memory segments, CXL segments excluded
+     */
+    void GetSegmentUsage(std::vector<SegmentUsage>& usage) const;
+
    private:
     SegmentManager* segment_manager_;
     std::unique_lock<std::shared_mutex> lock_;
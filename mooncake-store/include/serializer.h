@@ -1,9 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <cstring>
 #include <cstdint>
+#include <cerrno>
+#include <climits>
+#include <vector>
+#include <sys/uio.h>
+#include <unistd.h>
 #include <glog/logging.h>
 
 #include "types.h"
@@ -59,6 +65,15 @@ namespace mooncake {
  * serialize_to(obj, buffer);                    // Serialize
  * auto restored = deserialize_from<MyClass>(buffer);  // Deserialize
  * @endcode
+ *
+ * Large objects that are only written out, e.g. snapshots, can be serialized
+ * in a single pass into a SerializeChunkWriter and written with writev,
+ * without a second traversal or one contiguous buffer:
+ * @code
+ * SerializeChunkWriter writer;
+ * serialize_to(obj, writer);
+ * writer.write_to_fd(fd);
+ * @endcode
  */
 
 /**
@@ -234,6 +249,168 @@ class SerializeWriter {
     std::string error_;  ///< Error message describing what went wrong
 };
 
+/**
+ * @brief A class for writing serialized data in a single pass into a list of
+ * chunks that grows as needed.
+ *
+ * It implements the same interface as SerializeWriter without knowing the
+ * size up front, so the object is traversed once and no contiguous buffer of
+ * the whole size is allocated. Chunks start at kMinChunkSize and double up to
+ * kMaxChunkSize, so small objects stay small and large ones take few chunks.
+ * The chunks can be visited in order, e.g. to checksum them, and written out
+ * with scatter-gather I/O.
+ */
+class SerializeChunkWriter {
+   public:
+    static constexpr size_t kMinChunkSize = 64 * 1024;
+    static constexpr size_t kMaxChunkSize = 4 * 1024 * 1024;
+
+    SerializeChunkWriter() = default;
+
+    ~SerializeChunkWriter() = default;
+
+    SerializeChunkWriter(const SerializeChunkWriter&) = delete;
+    SerializeChunkWriter& operator=(const SerializeChunkWriter&) = delete;
+
+    /**
+     * @brief Appends data after what was written so far, filling the last
+     * chunk before adding a new one
+     *
+     * @param data Pointer to the data to be written
+     * @param data_size Size of the data in bytes
+     */
+    void write(const void* data, const size_t data_size) {
+        if (has_error_) {
+            return;
+        }
+        if (data == nullptr) {
+            set_error("null_pointer_data");
+            return;
+        }
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        size_t remaining = data_size;
+        while (remaining > 0) {
+            if (chunks_.empty() || chunks_.back().used == chunks_.back().size) {
+                add_chunk(remaining);
+            }
+            Chunk& chunk = chunks_.back();
+            size_t n = std::min(remaining, chunk.size - chunk.used);
+            std::memcpy(chunk.data.get() + chunk.used, bytes, n);
+            chunk.used += n;
+            bytes += n;
+            remaining -= n;
+        }
+        size_ += data_size;
+    }
+
+    /**
+     * @brief Sets an error state with a descriptive message
+     *
+     * @param error Error message describing what went wrong
+     */
+    void set_error(const char* error) {
+        has_error_ = true;
+        error_ = error;
+    }
+
+    /**
+     * @brief Checks if an error occurred during writing
+     *
+     * @return true if an error occurred, false otherwise
+     */
+    bool has_error() const { return has_error_; }
+
+    /**
+     * @brief Returns the error message if an error occurred
+     *
+     * @return Error message string, empty if no error occurred
+     */
+    const std::string& get_error() const { return error_; }
+
+    /**
+     * @brief Returns the total size of the data written so far
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Calls fn(data, size) on the written part of each chunk, in order
+     */
+    template <typename Fn>
+    void for_each_chunk(Fn&& fn) const {
+        for (const auto& chunk : chunks_) {
+            fn(static_cast<const void*>(chunk.data.get()), chunk.used);
+        }
+    }
+
+    /**
+     * @brief Writes all chunks, followed by the optional trailer, to a file
+     * or socket with writev, retrying partial writes
+     *
+     * @param fd File descriptor to write to
+     * @param trailer Data written after the chunks, e.g. a checksum
+     * @param trailer_size Size of the trailer in bytes
+     * @return true if everything was written, false otherwise with errno set
+     */
+    bool write_to_fd(int fd, const void* trailer = nullptr,
+                     size_t trailer_size = 0) const {
+        std::vector<iovec> iov;
+        iov.reserve(chunks_.size() + 1);
+        for_each_chunk([&iov](const void* data, size_t size) {
+            iov.push_back({const_cast<void*>(data), size});
+        });
+        if (trailer_size > 0) {
+            iov.push_back({const_cast<void*>(trailer), trailer_size});
+        }
+        size_t index = 0;
+        while (index < iov.size()) {
+            int count = static_cast<int>(
+                std::min<size_t>(iov.size() - index, IOV_MAX));
+            ssize_t written = ::writev(fd, iov.data() + index, count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            // Skip the fully written entries and trim the partial one
+            auto left = static_cast<size_t>(written);
+            while (index < iov.size() && left >= iov[index].iov_len) {
+                left -= iov[index].iov_len;
+                index++;
+            }
+            if (left > 0) {
+                iov[index].iov_base =
+                    static_cast<uint8_t*>(iov[index].iov_base) + left;
+                iov[index].iov_len -= left;
+            }
+        }
+        return true;
+    }
+
+   private:
+    struct Chunk {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+        size_t used;
+    };
+
+    void add_chunk(size_t min_size) {
+        size_t size = chunks_.empty()
+                          ? kMinChunkSize
+                          : std::min(chunks_.back().size * 2, kMaxChunkSize);
+        // A single write larger than the next chunk gets one of its own
+        size = std::max(size, std::min(min_size, kMaxChunkSize));
+        chunks_.push_back(
+            {std::unique_ptr<uint8_t[]>(new uint8_t[size]), size, 0});
+    }
+
+    std::vector<Chunk> chunks_;  ///< Chunks in write order
+    size_t size_{0};             ///< Total size of the data written
+    bool has_error_{false};  ///< Flag indicating if an error occurred during
+                             ///< writing
+    std::string error_;      ///< Error message describing what went wrong
+};
+
 /**
  * @brief A class for reading serialized data from a buffer during
  * deserialization.
@@ -343,6 +520,24 @@ template <typename T>
     return serialize_to_internal(target.get(), buffer);
 }
 
+/**
+ * @brief Serializes an object in a single pass into a chunk list.
+ * @tparam T Type that implements serialize_to(SerializeChunkWriter&)
+ * @param target Object to serialize
+ * @param writer Writer to append the serialized data to
+ * @return ErrorCode indicating success or failure
+ */
+template <typename T>
+[[nodiscard]] ErrorCode serialize_to(const T& target,
+                                     SerializeChunkWriter& writer) {
+    target.serialize_to(writer);
+    if (writer.has_error()) {
+        LOG(ERROR) << "Serializing failed, error=" << writer.get_error();
+        return ErrorCode::INTERNAL_ERROR;
+    }
+    return ErrorCode::OK;
+}
+
 /**
  * @brief Deserializes an object from a byte buffer.
  * @tparam T Type that implements static deserialize_from(SerializerReader&)
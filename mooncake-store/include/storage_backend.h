@@ -2,13 +2,18 @@
 
 #include <glog/logging.h>
 
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <map>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "file_interface.h"
 #include "mutex.h"
+#include "offload_codec.h"
 #include "offset_allocator/offset_allocator.hpp"
 #include "types.h"
 
@@ -22,8 +27,13 @@ struct BucketObjectMetadata {
     int64_t offset;
     int64_t key_size;
     int64_t data_size;
+    // OffloadCodecType of the stored bytes, and their size when encoded. Both
+    // are 0 in buckets written without a codec.
+    int32_t codec = 0;
+    int64_t stored_size = 0;
 };
-YLT_REFL(BucketObjectMetadata, offset, key_size, data_size);
+YLT_REFL(BucketObjectMetadata, offset, key_size, data_size, codec,
+         stored_size);
 
 struct BucketMetadata {
     int64_t meta_size;
@@ -33,6 +43,19 @@ struct BucketMetadata {
 };
 YLT_REFL(BucketMetadata, data_size, keys, metadatas);
 
+// A bucket in the index checkpoint of BucketStorageBackend
+struct BucketIndexEntry {
+    int64_t bucket_id;
+    int64_t meta_size;
+    BucketMetadata metadata;
+};
+YLT_REFL(BucketIndexEntry, bucket_id, meta_size, metadata);
+
+struct BucketIndexCheckpoint {
+    std::vector<BucketIndexEntry> buckets;
+};
+YLT_REFL(BucketIndexCheckpoint, buckets);
+
 struct OffloadMetadata {
     int64_t total_keys;
     int64_t total_size;
@@ -42,7 +65,12 @@ struct OffloadMetadata {
 
 enum class FileMode { Read, Write };
 
-enum class StorageBackendType { kFilePerKey, kBucket, kOffsetAllocator };
+enum class StorageBackendType {
+    kFilePerKey,
+    kBucket,
+    kOffsetAllocator,
+    kLogStructured
+};
 
 static constexpr size_t kKB = 1024;
 static constexpr size_t kMB = kKB * 1024;
@@ -64,11 +92,53 @@ struct BucketBackendConfig {
 
     int64_t bucket_keys_limit = 500;  // Max number of keys allowed in a single
                                       // bucket, required by bucket backend only
+
+    // Codec of the offloaded objects, see OffloadCodec::FromName
+    std::string codec = "none";
+
+    // Bucket files are read and written through io_uring, see UringFile.
+    // Ignored unless built with STORE_USE_URING.
+    bool use_uring = false;
+
+    // With use_uring, aligned I/O bypasses the page cache with O_DIRECT
+    bool direct_io = false;
+
+    // Threads reading the bucket metadata files at startup
+    int64_t scan_threads = 8;
+
+    // Interval between writes of the index checkpoint, a single file with
+    // the metadata of all buckets that spares reading their metadata files
+    // at startup. 0 disables the checkpoint.
+    int64_t index_checkpoint_interval_sec = 0;
+
+    // Concurrent offloads are written together as one bucket: the first
+    // waits up to this long for others to join its group, which stops
+    // growing at bucket_keys_limit or bucket_size_limit. 0 writes every
+    // offload as a bucket of its own, without waiting.
+    int64_t group_commit_window_us = 0;
+
     bool Validate() const;
 
     static BucketBackendConfig FromEnvironment();
 };
 
+struct LogStructuredConfig {
+    // The segment being appended to is sealed, and a new one started, once
+    // the next record would take it past this size (256 MB)
+    int64_t segment_size_limit = 256 * kMB;
+
+    // Sealed segments holding less than this percentage of live bytes are
+    // compacted
+    int64_t compaction_live_percent = 50;
+
+    // Interval between compaction passes (in milliseconds)
+    int64_t compaction_interval_ms = 1000;
+
+    bool Validate() const;
+
+    static LogStructuredConfig FromEnvironment();
+};
+
 struct FileStorageConfig {
     // type of the storage backend
     StorageBackendType storage_backend_type = StorageBackendType::kBucket;
@@ -90,10 +160,22 @@ struct FileStorageConfig {
 
     // Interval between heartbeats sent to the control plane (in seconds)
     uint32_t heartbeat_interval_seconds = 10;
-
-    // Interval between client_buffer_gc (in seconds)
-    uint32_t client_buffer_gc_interval_seconds = 1;
+    // Heartbeats back off up to this interval while there is nothing to
+    // offload, and follow each other without a pause while the master has
+    // more objects than a heartbeat returns
+    uint32_t heartbeat_max_interval_seconds = 60;
+    // Objects the master returns per heartbeat, 0 for no bound
+    uint64_t heartbeat_max_objects = 20000;
+
+    // Keep a CRC32C of each offloaded value and verify it on load, for the
+    // offset allocator backend
+    bool enable_checksum = false;
+
+    // Lease of the client buffer of a batch read for a remote node, after
+    // which it may be reused even if the node has not released it
     uint64_t client_buffer_gc_ttl_ms = 5000;
+    // How long a read waits for client buffer when it is full
+    uint64_t client_buffer_wait_timeout_ms = 1000;
 
     // Validates the configuration for correctness and consistency
     bool Validate() const;
@@ -136,6 +218,12 @@ class StorageBackendInterface {
             const std::vector<std::string>& keys,
             std::vector<StorageObjectMetadata>& metadatas)>& handler) = 0;
 
+    /**
+     * @brief Tells the backend about the buffer the loads are done into, so
+     * that it can register it for its I/O. Default: nothing to do.
+     */
+    virtual void RegisterLoadBuffer(void* /* addr */, size_t /* length */) {}
+
     // Test-only: Set predicate to force failures for specific keys in
     // BatchOffload. Default implementation does nothing (no failures injected).
     // Concrete backends can override to provide test failure injection.
@@ -173,9 +261,7 @@ class StorageBackend {
           is_3fs_dir_(is_3fs_dir),
           enable_eviction_(enable_eviction) {
         resource_manager_ = std::make_unique<USRBIOResourceManager>();
-        Hf3fsConfig config;
-        config.mount_root = root_dir;
-        resource_manager_->setDefaultParams(config);
+        resource_manager_->setDefaultParams(Hf3fsConfig::FromEnv(root_dir));
     }
 #else
     explicit StorageBackend(const std::string& root_dir,
@@ -295,6 +381,17 @@ class StorageBackend {
                                              std::vector<Slice>& slices,
                                              int64_t length);
 
+    /**
+     * @brief Loads a range of an object with a single pread
+     * @param path path for the object
+     * @param slices Output slices, filled in order
+     * @param offset Offset of the range in the object
+     * @return tl::expected<void, ErrorCode> indicating operation status
+     */
+    tl::expected<void, ErrorCode> LoadObjectRange(
+        const std::string& path, const std::vector<Slice>& slices,
+        int64_t offset);
+
     /**
      * @brief Loads an object as a string
      * @param path path for the object
@@ -569,6 +666,8 @@ class BucketStorageBackend : public StorageBackendInterface {
     BucketStorageBackend(const FileStorageConfig& file_storage_config_,
                          const BucketBackendConfig& bucket_backend_config_);
 
+    ~BucketStorageBackend();
+
     /**
      * @brief Offload objects in batches
      * @param batch_object  A map from object key to a list of data slices to be
@@ -605,6 +704,8 @@ class BucketStorageBackend : public StorageBackendInterface {
     tl::expected<void, ErrorCode> BatchLoad(
         const std::unordered_map<std::string, Slice>& batched_slices) override;
 
+    void RegisterLoadBuffer(void* addr, size_t length) override;
+
     /**
      * @brief Retrieves the list of object keys belonging to a specific bucket.
      * @param bucket_id The unique identifier of the bucket to query.
@@ -689,11 +790,35 @@ class BucketStorageBackend : public StorageBackendInterface {
      */
     tl::expected<OffloadMetadata, ErrorCode> GetStoreMetadata();
 
+    /**
+     * @brief Writes the metadata of all buckets to the index checkpoint,
+     * as the checkpoint thread does every index_checkpoint_interval_sec.
+     * Buckets found in the checkpoint at startup are not read again.
+     * @return tl::expected<void, ErrorCode> indicating operation status.
+     */
+    tl::expected<void, ErrorCode> WriteIndexCheckpoint();
+
    private:
+    // A BatchOffload waiting for its group to be written
+    struct OffloadWriter;
+
+    tl::expected<int64_t, ErrorCode> GroupOffload(
+        const std::unordered_map<std::string, std::vector<Slice>>& batch_object,
+        const std::function<
+            ErrorCode(const std::vector<std::string>& keys,
+                      std::vector<StorageObjectMetadata>& metadatas)>&
+            complete_handler);
+
+    // Writes the group of the writer at the head of the queue, called by it
+    void CommitGroup(std::unique_lock<std::mutex>& lock);
+
+    tl::expected<int64_t, ErrorCode> WriteGroup(
+        const std::vector<OffloadWriter*>& group);
+
     tl::expected<std::shared_ptr<BucketMetadata>, ErrorCode> BuildBucket(
         int64_t bucket_id,
         const std::unordered_map<std::string, std::vector<Slice>>& batch_object,
-        std::vector<iovec>& iovs,
+        std::vector<iovec>& iovs, std::vector<std::vector<char>>& encoded,
         std::vector<StorageObjectMetadata>& metadatas);
 
     tl::expected<void, ErrorCode> WriteBucket(
@@ -706,6 +831,13 @@ class BucketStorageBackend : public StorageBackendInterface {
     tl::expected<void, ErrorCode> LoadBucketMetadata(
         int64_t bucket_id, std::shared_ptr<BucketMetadata> bucket_metadata);
 
+    tl::expected<void, ErrorCode> LoadIndexCheckpoint(
+        std::unordered_map<int64_t, BucketIndexEntry>& entries);
+
+    std::string GetIndexCheckpointPath() const;
+
+    void IndexCheckpointThreadFunc();
+
     tl::expected<void, ErrorCode> BatchLoadBucket(
         int64_t bucket_id, const std::vector<std::string>& keys,
         const std::vector<StorageObjectMetadata>& metadatas,
@@ -737,6 +869,8 @@ class BucketStorageBackend : public StorageBackendInterface {
     std::optional<BucketIdGenerator> bucket_id_generator_;
     static constexpr const char* BUCKET_DATA_FILE_SUFFIX = ".bucket";
     static constexpr const char* BUCKET_METADATA_FILE_SUFFIX = ".meta";
+    static constexpr const char* INDEX_CHECKPOINT_FILE_NAME =
+        "bucket_index.ckpt";
     /**
      * @brief A shared mutex to protect concurrent access to metadata.
      *
@@ -756,10 +890,24 @@ class BucketStorageBackend : public StorageBackendInterface {
         mutex_) buckets_;
     int64_t GUARDED_BY(mutex_) next_bucket_ = -1;
     BucketBackendConfig bucket_backend_config_;
+    const OffloadCodec* codec_;
 
     mutable Mutex offloading_mutex_;
     std::unordered_map<std::string, int64_t> GUARDED_BY(offloading_mutex_)
         ungrouped_offloading_objects_;
+
+    // Buckets added since the index checkpoint was last written
+    std::atomic<int64_t> buckets_since_checkpoint_{0};
+    Mutex checkpoint_mutex_;  // Only one checkpoint write at a time
+    std::atomic<bool> checkpoint_running_{false};
+    std::mutex checkpoint_wait_mutex_;
+    std::condition_variable checkpoint_cv_;
+    std::thread checkpoint_thread_;
+
+    // Offloads waiting for group commit, the head writes the next group
+    std::mutex group_mutex_;
+    std::condition_variable group_cv_;
+    std::deque<OffloadWriter*> group_queue_;
 };
 
 class OffsetAllocatorStorageBackend : public StorageBackendInterface {
@@ -901,13 +1049,17 @@ class OffsetAllocatorStorageBackend : public StorageBackendInterface {
         // Value size only (excluding header and key)
         uint32_t value_size;
 
+        // CRC32C of the value, when enable_checksum is set
+        uint32_t checksum;
+
         // Refcounted handle keeps physical extent alive during reads
         AllocationPtr allocation;
         ObjectEntry(uint64_t off, uint32_t total, uint32_t val,
-                    AllocationPtr alloc_ptr)
+                    AllocationPtr alloc_ptr, uint32_t crc = 0)
             : offset(off),
               total_size(total),
               value_size(val),
+              checksum(crc),
               allocation(std::move(alloc_ptr)) {}
     };
 
@@ -977,6 +1129,199 @@ class OffsetAllocatorStorageBackend : public StorageBackendInterface {
     std::function<bool(const std::string& key)> test_failure_predicate_;
 };
 
+/**
+ * @class LogStructuredStorageBackend
+ * @brief Log-structured variant of OffsetAllocatorStorageBackend.
+ *
+ * Records ([u32 key_len][u32 value_len][key][value], as in
+ * OffsetAllocatorStorageBackend) are only ever appended, to the tail of the
+ * active segment file, so that the disk sees large sequential writes
+ * instead of small writes scattered over a preallocated file. The records
+ * of a batch are written together with one pwritev per segment. Overwritten
+ * records stay in their segment as dead bytes; a background thread
+ * compacts the sealed segments whose live ratio falls below
+ * compaction_live_percent by appending their live records to the tail and
+ * deleting the segment.
+ */
+class LogStructuredStorageBackend : public StorageBackendInterface {
+   public:
+    LogStructuredStorageBackend(const FileStorageConfig& file_storage_config,
+                                const LogStructuredConfig& log_config);
+
+    ~LogStructuredStorageBackend();
+
+    /**
+     * @brief Initializes the backend: removes the segments of a previous
+     * run and starts the compaction thread.
+     * @return tl::expected<void, ErrorCode> indicating operation status.
+     */
+    tl::expected<void, ErrorCode> Init() override;
+
+    tl::expected<int64_t, ErrorCode> BatchOffload(
+        const std::unordered_map<std::string, std::vector<Slice>>& batch_object,
+        std::function<ErrorCode(const std::vector<std::string>& keys,
+                                std::vector<StorageObjectMetadata>& metadatas)>
+            complete_handler) override;
+
+    tl::expected<void, ErrorCode> BatchLoad(
+        const std::unordered_map<std::string, Slice>& batched_slices) override;
+
+    tl::expected<bool, ErrorCode> IsExist(const std::string& key) override;
+
+    /**
+     * @brief Offloading is enabled while the live bytes, the keys and the
+     * bytes of all segment files are within their limits.
+     */
+    tl::expected<bool, ErrorCode> IsEnableOffloading() override;
+
+    /**
+     * @brief Reports the in-memory index; bucket_id is the segment id.
+     */
+    tl::expected<void, ErrorCode> ScanMeta(
+        const std::function<ErrorCode(
+            const std::vector<std::string>& keys,
+            std::vector<StorageObjectMetadata>& metadatas)>& handler) override;
+
+    /**
+     * @brief Runs one compaction pass, as the background thread does.
+     * @return The number of segments deleted, or an error.
+     */
+    tl::expected<size_t, ErrorCode> Compact();
+
+    // Bytes of all segment files, dead records included
+    int64_t GetDiskSize() const {
+        return disk_size_.load(std::memory_order_relaxed);
+    }
+
+    // Number of segment files
+    size_t GetSegmentCount() const;
+
+    // Test-only: Set predicate to force failures for specific keys in
+    // BatchOffload.
+    void SetTestFailurePredicate(
+        std::function<bool(const std::string& key)> predicate) override {
+        test_failure_predicate_ = std::move(predicate);
+    }
+
+   private:
+    // On-disk record header, the same as OffsetAllocatorStorageBackend's
+    struct RecordHeader {
+        uint32_t key_len;
+        uint32_t value_len;
+        static constexpr size_t SIZE = sizeof(uint32_t) * 2;
+    };
+
+    struct Segment {
+        uint64_t id;
+        std::string path;
+        std::unique_ptr<StorageFile> file;
+
+        // Bytes appended so far, written under append_mutex_
+        std::atomic<uint64_t> size{0};
+
+        // Bytes of the records the index points to
+        std::atomic<int64_t> live_bytes{0};
+
+        // Set once compacted: the file is deleted with the last reference,
+        // after the loads still reading it
+        std::atomic<bool> obsolete{false};
+
+        ~Segment();
+    };
+
+    using SegmentPtr = std::shared_ptr<Segment>;
+
+    // Metadata entry for a stored object. The segment pointer keeps the
+    // file of the record alive during reads.
+    struct ObjectEntry {
+        SegmentPtr segment;
+        uint64_t offset;
+        uint32_t total_size;
+        uint32_t value_size;
+    };
+
+    // A record to append: the iovecs of the whole record, and where it was
+    // written once AppendRecords returns
+    struct AppendRecord {
+        std::vector<iovec> iovs;
+        size_t record_size = 0;
+        SegmentPtr segment;
+        uint64_t offset = 0;
+        bool written = false;
+    };
+
+    static constexpr size_t kNumShards = 1024;
+    static_assert((kNumShards & (kNumShards - 1)) == 0,
+                  "kNumShards must be a power of 2");
+
+    struct MetadataShard {
+        mutable SharedMutex mutex;
+        std::unordered_map<std::string, ObjectEntry> map;
+    };
+
+    inline size_t ShardForKey(const std::string& key) const {
+        return std::hash<std::string>{}(key) & (kNumShards - 1);
+    }
+
+    std::string GetSegmentPath(uint64_t id) const;
+
+    // Appends the records in order, one pwritev per run of records landing
+    // in the same segment. Offloads stop at total_size_limit; compaction
+    // may go past it by the size of the segments it is about to delete.
+    void AppendRecords(std::vector<AppendRecord>& records, bool for_compaction)
+        EXCLUDES(append_mutex_);
+
+    // Returns the segment to append record_size bytes to, sealing the
+    // active one if it is full
+    tl::expected<SegmentPtr, ErrorCode> SegmentForAppend(size_t record_size,
+                                                         bool for_compaction)
+        REQUIRES(append_mutex_);
+
+    // A record the index points to in a segment being compacted
+    struct LiveRecord {
+        std::string key;
+        uint64_t offset;
+        uint32_t total_size;
+    };
+
+    // Appends the live records of the segment to the tail of the log and
+    // points the index to the copies. Returns false if one could not be
+    // moved, the segment is kept then.
+    bool MoveLiveRecords(const SegmentPtr& segment,
+                         std::vector<LiveRecord>& records);
+
+    void CompactionThreadFunc();
+
+    std::atomic<bool> initialized_{false};
+    std::string storage_path_;
+    LogStructuredConfig log_config_;
+
+    Mutex append_mutex_;
+    SegmentPtr active_segment_ GUARDED_BY(append_mutex_);
+    uint64_t next_segment_id_ GUARDED_BY(append_mutex_) = 0;
+
+    // All segments, the active one included, by id
+    mutable Mutex segments_mutex_;
+    std::map<uint64_t, SegmentPtr> segments_ GUARDED_BY(segments_mutex_);
+
+    std::array<MetadataShard, kNumShards> shards_;
+
+    // Bytes of the live records, and of all segment files
+    std::atomic<int64_t> total_size_{0};
+    std::atomic<int64_t> disk_size_{0};
+    std::atomic<int64_t> total_keys_{0};
+
+    // Only one compaction pass at a time
+    Mutex compaction_mutex_;
+
+    std::atomic<bool> compaction_running_{false};
+    std::mutex compaction_wait_mutex_;
+    std::condition_variable compaction_cv_;
+    std::thread compaction_thread_;
+
+    std::function<bool(const std::string& key)> test_failure_predicate_;
+};
+
 tl::expected<std::shared_ptr<StorageBackendInterface>, ErrorCode>
 CreateStorageBackend(const FileStorageConfig& config);
 
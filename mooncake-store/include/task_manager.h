@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <boost/functional/hash.hpp>
 #include <deque>
 #include <queue>
@@ -16,6 +17,8 @@ namespace mooncake {
 enum class TaskType {
     REPLICA_COPY,
     REPLICA_MOVE,
+    REPLICA_PROMOTE,
+    PREFIX_REMOVE,
 };
 
 inline std::ostream& operator<<(std::ostream& os, const TaskType& type) {
@@ -26,6 +29,12 @@ inline std::ostream& operator<<(std::ostream& os, const TaskType& type) {
         case TaskType::REPLICA_MOVE:
             os << "REPLICA_MOVE";
             break;
+        case TaskType::REPLICA_PROMOTE:
+            os << "REPLICA_PROMOTE";
+            break;
+        case TaskType::PREFIX_REMOVE:
+            os << "PREFIX_REMOVE";
+            break;
         default:
             os << "UNKNOWN_TASK_TYPE";
             break;
@@ -33,6 +42,35 @@ inline std::ostream& operator<<(std::ostream& os, const TaskType& type) {
     return os;
 }
 
+// Order in which a client is handed its pending tasks, so that background
+// maintenance does not hold back replicas needed for serving reads
+enum class TaskPriority : uint8_t {
+    HIGH = 0,    // hot key amplification, disk replica promotion
+    NORMAL = 1,  // copies and moves requested by users
+    LOW = 2,     // maintenance such as segment compaction
+};
+
+static constexpr size_t kNumTaskPriorities = 3;
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const TaskPriority& priority) {
+    switch (priority) {
+        case TaskPriority::HIGH:
+            os << "HIGH";
+            break;
+        case TaskPriority::NORMAL:
+            os << "NORMAL";
+            break;
+        case TaskPriority::LOW:
+            os << "LOW";
+            break;
+        default:
+            os << "UNKNOWN_TASK_PRIORITY";
+            break;
+    }
+    return os;
+}
+
 enum class TaskStatus {
     PENDING,
     PROCESSING,
@@ -76,6 +114,8 @@ struct Task {
     std::string message;
     UUID assigned_client;
     uint32_t max_retry_attempts;
+    TaskPriority priority;
+    uint64_t size;  // bytes the task transfers, 0 if unknown
 
     bool is_finished() const { return is_finished_status(status); }
 
@@ -105,6 +145,20 @@ struct ReplicaMovePayload {
 };
 YLT_REFL(ReplicaMovePayload, key, source, target);
 
+// Copy the disk replica of key into the local memory segment target
+struct ReplicaPromotePayload {
+    std::string key;
+    std::string target;
+};
+YLT_REFL(ReplicaPromotePayload, key, target);
+
+// Remove the objects whose keys start with prefix, run by the master itself
+struct PrefixRemovePayload {
+    std::string prefix;
+    bool force{false};
+};
+YLT_REFL(PrefixRemovePayload, prefix, force);
+
 template <TaskType T>
 struct TaskPayloadTraits;
 
@@ -120,6 +174,18 @@ struct TaskPayloadTraits<TaskType::REPLICA_MOVE> {
     static constexpr const char* name = "ReplicaMovePayload";
 };
 
+template <>
+struct TaskPayloadTraits<TaskType::REPLICA_PROMOTE> {
+    using type = ReplicaPromotePayload;
+    static constexpr const char* name = "ReplicaPromotePayload";
+};
+
+template <>
+struct TaskPayloadTraits<TaskType::PREFIX_REMOVE> {
+    using type = PrefixRemovePayload;
+    static constexpr const char* name = "PrefixRemovePayload";
+};
+
 template <typename T>
 std::string serialize_payload(const T& payload) {
     std::string json;
@@ -155,16 +221,25 @@ class ScopedTaskWriteAccess {
     template <TaskType Type>
     tl::expected<UUID, ErrorCode> submit_task_typed(
         const UUID& client_id,
-        const typename TaskPayloadTraits<Type>::type& payload) {
+        const typename TaskPayloadTraits<Type>::type& payload,
+        TaskPriority priority = TaskPriority::NORMAL, uint64_t size = 0) {
         std::string json = serialize_payload(payload);
-        return submit_task(client_id, Type, json);
+        return submit_task(client_id, Type, json, priority, size);
     }
 
+    // Pops up to batch_size pending tasks of the client, higher priorities
+    // first and in submission order within a priority. Stops at a task that
+    // would exceed the bytes the client may process at once, unless the
+    // client processes nothing, so that large tasks still run.
     std::vector<Task> pop_tasks(const UUID& client_id, size_t batch_size);
 
     ErrorCode complete_task(const UUID& client_id, const UUID& task_id,
                             TaskStatus status, const std::string& message);
 
+    // Report the progress of a processing task in its message
+    ErrorCode update_task_message(const UUID& task_id,
+                                  const std::string& message);
+
     void prune_finished_tasks();
 
     void prune_expired_tasks();
@@ -172,7 +247,12 @@ class ScopedTaskWriteAccess {
    private:
     tl::expected<UUID, ErrorCode> submit_task(const UUID& client_id,
                                               TaskType type,
-                                              const std::string& payload);
+                                              const std::string& payload,
+                                              TaskPriority priority,
+                                              uint64_t size);
+
+    // Returns the bytes of a task leaving the processing set to its client
+    void release_processing_bytes(const Task& task);
 
     ClientTaskManager* manager_;
     SharedMutexLocker lock_;
@@ -189,7 +269,8 @@ class ClientTaskManager {
           max_total_processing_tasks_(config.max_total_processing_tasks),
           pending_task_timeout_sec_(config.pending_task_timeout_sec),
           processing_task_timeout_sec_(config.processing_task_timeout_sec),
-          max_retry_attempts_(config.max_retry_attempts) {}
+          max_retry_attempts_(config.max_retry_attempts),
+          max_task_bytes_per_client_(config.max_task_bytes_per_client) {}
 
     ~ClientTaskManager() = default;
 
@@ -212,6 +293,8 @@ class ClientTaskManager {
     uint64_t pending_task_timeout_sec_;
     uint64_t processing_task_timeout_sec_;
     uint32_t max_retry_attempts_;
+    // 0 = no limit
+    uint64_t max_task_bytes_per_client_;
 
     size_t total_pending_tasks_ GUARDED_BY(mutex_) = 0;
     size_t total_processing_tasks_ GUARDED_BY(mutex_) = 0;
@@ -221,9 +304,11 @@ class ClientTaskManager {
         GUARDED_BY(mutex_);
 
     // Dispatch Queue (Pending)
-    // Map: client_id -> queue of pending task_ids
-    std::unordered_map<UUID, std::queue<UUID>, boost::hash<UUID>> pending_tasks_
-        GUARDED_BY(mutex_);
+    // Map: client_id -> queue of pending task_ids for each priority
+    std::unordered_map<UUID,
+                       std::array<std::queue<UUID>, kNumTaskPriorities>,
+                       boost::hash<UUID>>
+        pending_tasks_ GUARDED_BY(mutex_);
 
     // Active Set (Processing)
     // Map: client_id -> set of task_ids currently being processed
@@ -231,6 +316,10 @@ class ClientTaskManager {
                        boost::hash<UUID>>
         processing_tasks_ GUARDED_BY(mutex_);
 
+    // Map: client_id -> bytes of its processing tasks, absent when 0
+    std::unordered_map<UUID, uint64_t, boost::hash<UUID>> processing_bytes_
+        GUARDED_BY(mutex_);
+
     // Tracks the order of finished tasks (Oldest -> Newest)
     // Used to implement LRU eviction for completed tasks
     std::deque<UUID> finished_task_history_ GUARDED_BY(mutex_);
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <ylt/util/tl/expected.hpp>
+
+#include "types.h"
+
+namespace mooncake {
+
+struct TenantLimit {
+    uint64_t quota_bytes{0};         // 0 = unlimited
+    uint32_t put_starts_per_sec{0};  // 0 = unlimited
+};
+
+/**
+ * @brief Memory usage and PutStart rate of one tenant.
+ *
+ * Objects keep a reference to the usage of their tenant and release their
+ * bytes when destroyed, so the usage stays correct whichever path erases
+ * them. Thread-safe.
+ */
+class TenantUsage {
+   public:
+    TenantUsage(std::string name, TenantLimit limit);
+
+    const std::string& name() const { return name_; }
+    const TenantLimit& limit() const { return limit_; }
+    uint64_t used_bytes() const;
+
+    /**
+     * @brief Admit a PutStart that allocates bytes of segment memory.
+     * @return OK and charges the bytes, TENANT_RATE_LIMITED or
+     * TENANT_QUOTA_EXCEEDED otherwise
+     */
+    ErrorCode TryCharge(uint64_t bytes,
+                        std::chrono::steady_clock::time_point now);
+
+    void Release(uint64_t bytes);
+
+    // Accounting of the bytes of the tenant freed by eviction
+    void RecordEviction(uint64_t bytes);
+
+   private:
+    const std::string name_;
+    const TenantLimit limit_;
+
+    mutable std::mutex mutex_;
+    uint64_t used_bytes_{0};
+    // Token bucket of put_starts_per_sec tokens, refilled continuously
+    double tokens_{0};
+    std::chrono::steady_clock::time_point last_refill_{};
+};
+
+/**
+ * @brief Per-tenant quotas of the master, keyed by ReplicateConfig::tenant.
+ *
+ * Tenants without a configured limit get the limit of the "*" entry, or
+ * none if there is no such entry. Objects without a tenant are not limited.
+ */
+class TenantQuotaManager {
+   public:
+    static constexpr const char* kDefaultTenant = "*";
+
+    explicit TenantQuotaManager(
+        std::unordered_map<std::string, TenantLimit> limits = {});
+
+    /**
+     * @brief Parse "tenant=quota_bytes[:put_starts_per_sec],..." as given
+     * by --tenant_quotas, e.g. "llama=10737418240:100,*=1073741824".
+     */
+    static tl::expected<std::unordered_map<std::string, TenantLimit>,
+                        ErrorCode>
+    ParseLimits(const std::string& spec);
+
+    // Usage of the tenant, created on first use
+    std::shared_ptr<TenantUsage> GetUsage(const std::string& tenant);
+
+   private:
+    const std::unordered_map<std::string, TenantLimit> limits_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<TenantUsage>> usages_;
+};
+
+}  // namespace mooncake
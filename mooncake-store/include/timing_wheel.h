@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mooncake {
+
+/**
+ * @brief Hierarchical timing wheel of key deadlines.
+ *
+ * Level 0 has one slot per tick, every further level slots of 64 times the
+ * span of the previous one. A deadline is kept in the lowest level whose
+ * span covers it, and moved down a level when the clock reaches its slot,
+ * so Advance costs the expired keys, the ticks passed and the keys moved,
+ * not the number of scheduled keys. Deadlines past the top level wait in
+ * it and are placed again each time its slot is reached.
+ *
+ * Deadlines are rounded up to the next tick. Keys are not deduplicated: a
+ * key scheduled twice is reported twice, callers check it is still due.
+ *
+ * Thread-safe.
+ */
+class TimingWheel {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t kLevels = 4;
+    static constexpr size_t kSlotBits = 6;
+    static constexpr size_t kSlots = size_t{1} << kSlotBits;
+
+    struct Entry {
+        std::string key;
+        Clock::time_point deadline;
+    };
+
+    TimingWheel(std::chrono::milliseconds tick, Clock::time_point start);
+
+    void Schedule(std::string key, Clock::time_point deadline);
+
+    // Entries whose deadline is at or before now
+    std::vector<Entry> Advance(Clock::time_point now);
+
+    size_t size() const;
+
+   private:
+    struct TickEntry {
+        Entry entry;
+        uint64_t tick;
+    };
+
+    uint64_t ToTick(Clock::time_point deadline) const;
+    void Place(TickEntry&& entry);
+
+    const std::chrono::milliseconds tick_;
+    const Clock::time_point start_;
+
+    mutable std::mutex mutex_;
+    uint64_t current_tick_{0};
+    size_t size_{0};
+    std::array<std::array<std::vector<TickEntry>, kSlots>, kLevels> levels_;
+    std::vector<Entry> due_;
+};
+
+}  // namespace mooncake
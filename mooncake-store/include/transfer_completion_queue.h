@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "transfer_task.h"
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Completes asynchronous client operations on a single thread.
+ *
+ * Each entry is a set of submitted transfers and a callback. The completion
+ * thread polls the transfers of all entries and runs the callback of an
+ * entry once all its transfers are finished, with the first error among
+ * them or OK. The callbacks run on the completion thread, so they must not
+ * block for long. Thread-safe.
+ */
+class TransferCompletionQueue {
+   public:
+    using Callback = std::function<void(ErrorCode)>;
+
+    TransferCompletionQueue();
+
+    // Waits for the transfers of the remaining entries and runs their
+    // callbacks
+    ~TransferCompletionQueue();
+
+    TransferCompletionQueue(const TransferCompletionQueue&) = delete;
+    TransferCompletionQueue& operator=(const TransferCompletionQueue&) =
+        delete;
+
+    void Add(std::vector<TransferFuture> futures, Callback callback);
+
+    // Entries added and not yet completed
+    size_t pending() const;
+
+   private:
+    struct Entry {
+        std::vector<TransferFuture> futures;
+        Callback callback;
+    };
+
+    static constexpr auto kPollInterval = std::chrono::microseconds(20);
+
+    void ThreadFunc();
+    // Runs the callback of the entry if all its transfers are finished
+    static bool TryComplete(Entry& entry, bool wait);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Entry> incoming_;
+    size_t pending_{0};
+    bool running_{true};
+    std::thread thread_;
+};
+
+}  // namespace mooncake
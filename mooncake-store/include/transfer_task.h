@@ -18,6 +18,8 @@
 #include "replica.h"
 #include "storage_backend.h"
 #include "client_metric.h"
+#include "copy_engine.h"
+#include "transfer_window.h"
 
 namespace mooncake {
 
@@ -28,7 +30,8 @@ enum class TransferStrategy {
     LOCAL_MEMCPY = 0,     // Local memory copy using memcpy
     TRANSFER_ENGINE = 1,  // Remote transfer using transfer engine
     FILE_READ = 2,        // File read operation
-    EMPTY = 3
+    EMPTY = 3,
+    STRIPED = 4  // Erasure coded chunks on several segments
 };
 
 /**
@@ -43,6 +46,8 @@ inline std::ostream& operator<<(std::ostream& os,
             return os << "TRANSFER_ENGINE";
         case TransferStrategy::FILE_READ:
             return os << "FILE_READ";
+        case TransferStrategy::STRIPED:
+            return os << "STRIPED";
         default:
             return os << "UNKNOWN";
     }
@@ -167,6 +172,25 @@ class FilereadOperationState : public OperationState {
     }
 };
 
+/**
+ * @brief Operation state for striped replica transfers, which complete
+ * within the submission
+ */
+class StripedOperationState : public OperationState {
+   public:
+    explicit StripedOperationState(ErrorCode error_code) {
+        result_.emplace(error_code);
+    }
+
+    bool is_completed() override { return true; }
+
+    void wait_for_completion() override {}
+
+    TransferStrategy get_strategy() const override {
+        return TransferStrategy::STRIPED;
+    }
+};
+
 /**
  * @brief Operation state for transfer engine operations
  */
@@ -186,6 +210,13 @@ class TransferEngineOperationState : public OperationState {
         return TransferStrategy::TRANSFER_ENGINE;
     }
 
+    // Room taken in the window of the target segment, finished with the
+    // outcome once the result is set
+    void set_window_lease(std::unique_ptr<TransferWindows::Lease> lease) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        window_lease_ = std::move(lease);
+    }
+
    private:
     /**
      * @brief Check the current completion status of the task, make sure to lock
@@ -199,6 +230,7 @@ class TransferEngineOperationState : public OperationState {
     TransferEngine& engine_;
     BatchID batch_id_;
     size_t batch_size_;
+    std::unique_ptr<TransferWindows::Lease> window_lease_;
 };
 
 /**
@@ -242,10 +274,23 @@ class TransferFuture {
      */
     TransferStrategy strategy() const;
 
+    /**
+     * @brief Another future on the same operation, e.g. for each of the
+     * objects a coalesced transfer carries
+     */
+    TransferFuture share() const;
+
    private:
     std::shared_ptr<OperationState> state_;
 };
 
+/**
+ * @brief Merge the requests that continue one another in both the local and
+ * the remote address space, e.g. of objects allocated one after another.
+ * Requests are reordered by target.
+ */
+void CoalesceTransferRequests(std::vector<TransferRequest>& requests);
+
 /**
  * @brief Memory copy operation descriptor
  */
@@ -273,12 +318,24 @@ struct MemcpyTask {
 /**
  * @brief Thread pool for asynchronous memcpy operations
  *
- * This class manages a single worker thread that executes memcpy operations
- * asynchronously.
+ * A group of worker threads is pinned to each NUMA node, and a copy runs on
+ * the group of the node of its destination. Copies of at least
+ * kMinSplitChunkSize * 2 bytes are split into chunks copied by several
+ * workers of the group, as one thread cannot saturate the memory bandwidth
+ * of a node.
  */
 class MemcpyWorkerPool {
    public:
-    explicit MemcpyWorkerPool();
+    static constexpr size_t kDefaultThreadsPerNode = 4;
+    // Smallest chunk of a split copy
+    static constexpr size_t kMinSplitChunkSize = 1 << 20;
+
+    /**
+     * @param copy_engine Engine doing the copies, the CPU one if null
+     */
+    explicit MemcpyWorkerPool(
+        size_t threads_per_node = kDefaultThreadsPerNode,
+        std::unique_ptr<CopyEngine> copy_engine = nullptr);
     ~MemcpyWorkerPool();
 
     // Non-copyable, non-movable
@@ -294,12 +351,32 @@ class MemcpyWorkerPool {
     void submitTask(MemcpyTask task);
 
    private:
-    void workerThread();
-
+    // Part of a task run by one worker, the task completes with its last job
+    struct Progress {
+        std::atomic<size_t> remaining;
+        std::atomic<bool> failed{false};
+    };
+
+    struct Job {
+        std::vector<MemcpyOperation> operations;
+        std::shared_ptr<MemcpyOperationState> state;
+        std::shared_ptr<Progress> progress;
+    };
+
+    struct NodeQueue {
+        std::queue<Job> jobs;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    void workerThread(size_t node);
+    // NUMA node of the queue of the copies to dest
+    size_t nodeOf(void* dest) const;
+
+    const size_t threads_per_node_;
+    const std::unique_ptr<CopyEngine> copy_engine_;
+    std::vector<std::unique_ptr<NodeQueue>> queues_;
     std::vector<std::thread> workers_;
-    std::queue<MemcpyTask> task_queue_;
-    std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
     std::atomic<bool> shutdown_;
 };
 
@@ -364,9 +441,14 @@ class FilereadWorkerPool {
  */
 class TransferSubmitter {
    public:
-    explicit TransferSubmitter(TransferEngine& engine,
-                               std::shared_ptr<StorageBackend>& backend,
-                               TransferMetric* transfer_metric = nullptr);
+    /**
+     * @param transferred_bytes If not null, accumulates the bytes of every
+     * submitted transfer, e.g. to report the transfer load
+     */
+    explicit TransferSubmitter(
+        TransferEngine& engine, std::shared_ptr<StorageBackend>& backend,
+        TransferMetric* transfer_metric = nullptr,
+        std::atomic<uint64_t>* transferred_bytes = nullptr);
 
     /**
      * @brief Submit an asynchronous transfer operation
@@ -390,6 +472,22 @@ class TransferSubmitter {
         std::vector<std::vector<Slice>>& all_slices,
         TransferRequest::OpCode op_code);
 
+    /**
+     * @brief Submit the transfers of many objects, coalescing the ones that
+     * are contiguous in both local and remote memory
+     *
+     * Objects moved by the transfer engine are submitted in one batch per
+     * segment, see CoalesceTransferRequests(), sharing its future, so that
+     * a failure fails all of them. Other objects are submitted as by
+     * submit().
+     *
+     * @return One future per object, nullopt for those not submitted
+     */
+    std::vector<std::optional<TransferFuture>> submit_coalesced(
+        const std::vector<Replica::Descriptor>& replicas,
+        const std::vector<std::vector<Slice>*>& all_slices,
+        TransferRequest::OpCode op_code);
+
     std::optional<TransferFuture> submit_batch_get_offload_object(
         const std::string& transfer_engine_addr,
         const std::vector<std::string>& keys,
@@ -402,6 +500,10 @@ class TransferSubmitter {
     std::unique_ptr<FilereadWorkerPool> fileread_pool_;
     bool memcpy_enabled_;
     TransferMetric* transfer_metric_;
+    std::atomic<uint64_t>* transferred_bytes_;
+    // Per-segment windows of remote transfers, if MC_STORE_TRANSFER_WINDOW
+    // is set
+    std::unique_ptr<TransferWindows> windows_;
 
     /**
      * @brief Select the optimal transfer strategy
@@ -436,18 +538,50 @@ class TransferSubmitter {
         const std::vector<Slice>& slices,
         const TransferRequest::OpCode op_code);
 
+    // Append the requests moving slices to or from the buffer, merging
+    // those of adjacent slices, and set seg to its segment. Returns the
+    // bytes of the requests, nullopt if the segment cannot be opened.
+    std::optional<uint64_t> appendTransferEngineRequests(
+        const AllocatedBuffer::Descriptor& handle,
+        const std::vector<Slice>& slices, TransferRequest::OpCode op_code,
+        SegmentHandle& seg, std::vector<TransferRequest>& requests);
+
     std::optional<TransferFuture> submitFileReadOperation(
         const Replica::Descriptor& replica, std::vector<Slice>& slices,
         TransferRequest::OpCode op_code);
 
+    /**
+     * @brief Transfer the chunks of a striped replica in one batch, so
+     * that they move in parallel from or to their segments.
+     *
+     * Writes encode the parity chunks from the slices. Reads go straight
+     * into the slices if all data chunks are present, otherwise any k
+     * present chunks are read and the missing data is reconstructed.
+     * Blocks until the chunks are transferred.
+     */
+    std::optional<TransferFuture> submitStripedOperation(
+        const StripedDescriptor& striped, std::vector<Slice>& slices,
+        TransferRequest::OpCode op_code);
+
+    // Append the requests moving slices to or from a chunk buffer
+    bool appendChunkRequests(const AllocatedBuffer::Descriptor& handle,
+                             const std::vector<Slice>& slices,
+                             TransferRequest::OpCode op_code,
+                             std::vector<TransferRequest>& requests);
+
+    // Run a batch of transfer requests to completion
+    ErrorCode runTransfer(std::vector<TransferRequest>& requests);
+
     /**
      * @brief Calculate total bytes for transfer operation and update metrics
      */
     void updateTransferMetrics(const std::vector<Slice>& slices,
                                TransferRequest::OpCode op);
 
+    // The lease, if any, is held by the operation until it completes
     std::optional<TransferFuture> submitTransfer(
-        std::vector<TransferRequest>& requests);
+        std::vector<TransferRequest>& requests,
+        std::unique_ptr<TransferWindows::Lease> window_lease = nullptr);
 };
 
 }  // namespace mooncake
\ No newline at end of file
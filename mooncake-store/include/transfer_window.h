@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace mooncake {
+
+/**
+ * @brief Limits the bytes in flight to each remote segment with an AIMD
+ * window, so that many clients reading from one node at once do not
+ * overflow its NIC.
+ *
+ * The window of a segment grows by increase_bytes per window of transfers
+ * completed in time, and shrinks by decrease_factor, at most once per
+ * latency, when a transfer fails or its queueing delay exceeds
+ * target_delay_us. The queueing delay is the completion latency minus the
+ * time the bytes take on the wire at link_gbps. A transfer larger than the
+ * window still goes out once nothing else is in flight to its segment.
+ *
+ * Transfers are only noticed as complete when their state is polled, so a
+ * thread waiting for room polls the transfers in flight to the segment
+ * itself, e.g. those it submitted before. Thread-safe.
+ */
+class TransferWindows {
+   public:
+    struct Config {
+        uint64_t initial_bytes = 16ull << 20;
+        uint64_t min_bytes = 1ull << 20;
+        uint64_t max_bytes = 1ull << 30;
+        uint64_t increase_bytes = 1ull << 20;
+        double decrease_factor = 0.7;
+        int64_t target_delay_us = 500;
+        uint64_t link_gbps = 100;
+
+        // Reads MC_STORE_TRANSFER_WINDOW_* over the defaults
+        static Config FromEnv();
+    };
+
+    /**
+     * @brief Room taken in the window of a segment by one transfer, given
+     * back on Finish or destruction
+     */
+    class Lease {
+       public:
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        // Called while waiting for room in the window, to notice whether
+        // the transfer completed
+        void SetPoller(std::function<void()> poller);
+
+        // Gives the room back and adjusts the window with the outcome and
+        // the latency since the lease was taken
+        void Finish(bool ok);
+        void Finish(bool ok, int64_t latency_us);
+
+       private:
+        friend class TransferWindows;
+
+        Lease(TransferWindows* owner, uint64_t segment, uint64_t bytes);
+
+        TransferWindows* owner_;
+        uint64_t segment_;
+        uint64_t bytes_;
+        std::chrono::steady_clock::time_point start_;
+        std::function<void()> poller_;
+        std::list<Lease*>::iterator position_;  // in the leases of its window
+        bool finished_ = false;
+    };
+
+    explicit TransferWindows(const Config& config);
+
+    /**
+     * @brief Waits until the window of the segment has room for the bytes
+     */
+    std::unique_ptr<Lease> Acquire(uint64_t segment, uint64_t bytes);
+
+    // Current window and bytes in flight of the segment
+    uint64_t WindowBytes(uint64_t segment) const;
+    uint64_t InflightBytes(uint64_t segment) const;
+
+   private:
+    struct Window {
+        uint64_t window_bytes;
+        uint64_t inflight_bytes = 0;
+        std::chrono::steady_clock::time_point last_decrease;
+        std::list<Lease*> leases;
+    };
+
+    void Release(Lease* lease, bool adjust, bool ok, int64_t latency_us);
+
+    const Config config_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<uint64_t, Window> windows_;
+};
+
+}  // namespace mooncake
@@ -56,6 +56,48 @@ static constexpr uint64_t DEFAULT_PENDING_TASK_TIMEOUT_SEC =
 static constexpr uint64_t DEFAULT_PROCESSING_TASK_TIMEOUT_SEC =
     300;  // 0 to be no timeout
 static constexpr uint32_t DEFAULT_MAX_RETRY_ATTEMPTS = 10;
+// Bytes of processing tasks a client runs at once, 0 = no limit
+static constexpr uint64_t DEFAULT_MAX_TASK_BYTES_PER_CLIENT = 0;
+
+// Metadata persistence constants
+constexpr const char* DEFAULT_METADATA_PERSIST_DIR = "";  // empty = disabled
+static constexpr uint64_t DEFAULT_METADATA_SNAPSHOT_INTERVAL_SEC =
+    300;  // 5 minutes
+
+// Number of slots of the lock-free hot key read cache, 0 = disabled
+static constexpr uint64_t DEFAULT_HOT_REPLICA_CACHE_SIZE = 0;
+// Bits of the key filter of each metadata shard, 0 = disabled
+static constexpr uint64_t DEFAULT_KEY_FILTER_BITS_PER_SHARD = 0;
+// Radix tree over the keys of each metadata shard for anchored regex
+// queries, an extra copy of the keys
+static constexpr bool DEFAULT_ENABLE_KEY_PREFIX_INDEX = false;
+constexpr const char* DEFAULT_EVICTION_POLICY = "lru";
+static constexpr uint32_t DEFAULT_PUT_START_EVICTION_RETRIES = 0;
+static constexpr bool DEFAULT_BATCH_PUT_CONTIGUOUS = false;
+constexpr const char* DEFAULT_ALLOCATION_STRATEGY = "random";
+// Fragmentation of an offset allocator above which its segment is compacted,
+// 0 = disabled
+static constexpr double DEFAULT_COMPACTION_FRAGMENTATION_THRESHOLD = 0.0;
+static constexpr uint32_t DEFAULT_COMPACTION_MOVES_PER_SEC = 16;
+static constexpr double DEFAULT_REBALANCE_UTILIZATION_GAP = 0.0;
+static constexpr uint32_t DEFAULT_REBALANCE_MOVES_PER_SEC = 16;
+// Fraction of the lease TTL reads may leave unrenewed, 0 = renew every read
+static constexpr double DEFAULT_LAZY_LEASE_RENEWAL_RATIO = 0.0;
+static constexpr bool DEFAULT_ENABLE_ASYNC_REPLICA_RECLAIM = false;
+// Number of most read keys reported by the master, 0 = disabled
+static constexpr uint32_t DEFAULT_HOT_KEY_TOP_N = 0;
+// Reads per second above which hot keys get more replicas, 0 = disabled
+static constexpr uint32_t DEFAULT_HOT_KEY_REPLICA_READS_PER_SEC = 0;
+static constexpr uint32_t DEFAULT_HOT_KEY_MAX_REPLICAS = 3;
+// Reads of a disk-only object within the window that copy it back into
+// memory, 0 = disabled
+static constexpr uint32_t DEFAULT_DISK_PROMOTION_READS = 0;
+static constexpr uint32_t DEFAULT_DISK_PROMOTION_WINDOW_SEC = 60;
+// Memory usage ratio above which idle objects are offloaded, 0 = offload all
+static constexpr double DEFAULT_MEMORY_TIER_TARGET_RATIO = 0.0;
+static constexpr uint32_t DEFAULT_TIER_DEMOTION_MIN_IDLE_SEC = 30;
+// Objects of at least this size go to the CXL tier, 0 = all
+static constexpr uint64_t DEFAULT_CXL_MIN_OBJECT_SIZE = 0;
 
 // Forward declarations
 class BufferAllocatorBase;
@@ -174,6 +216,8 @@ enum class ErrorCode : int32_t {
     REPLICA_IS_GONE = -712,         ///< Replica existed once, but is gone now.
     REPLICA_NOT_IN_LOCAL_MEMORY =
         -713,  ///< Replica does not reside in current node memory.
+    OBJECT_PUT_IN_PROGRESS =
+        -714,  ///< Object is being put by another client.
 
     // Transfer errors (Range: -800 to -899)
     TRANSFER_FAIL = -800,  ///< Transfer operation failed.
@@ -199,6 +243,8 @@ enum class ErrorCode : int32_t {
     FILE_INVALID_BUFFER = -1104,  ///< File buffer is wrong.
     FILE_LOCK_FAIL = -1105,       ///< File lock operation failed.
     FILE_INVALID_HANDLE = -1106,  ///< Invalid file handle.
+    FILE_CHECKSUM_MISMATCH =
+        -1107,  ///< Data read does not match its checksum.
 
     BUCKET_NOT_FOUND = -1200,          ///< Bucket not found.
     BUCKET_ALREADY_EXISTS = -1201,     ///< Bucket already exists.
@@ -211,6 +257,10 @@ enum class ErrorCode : int32_t {
     TASK_NOT_FOUND = -1400,  ///< Task not found.
     TASK_PENDING_LIMIT_EXCEEDED =
         -1401,  ///< Total pending tasks exceed the limit.
+
+    // Tenant errors (Range: -1500 to -1599)
+    TENANT_QUOTA_EXCEEDED = -1500,  ///< Tenant memory quota exceeded.
+    TENANT_RATE_LIMITED = -1501,    ///< Tenant PutStart rate exceeded.
 };
 
 int32_t toInt(ErrorCode errorCode) noexcept;
@@ -246,9 +296,17 @@ struct Segment {
     // TE p2p endpoint (ip:port) for transport-only addressing
     std::string te_endpoint{};
     std::string protocol;
+    // Failure domains of the segment from the widest one down, separated by
+    // '/', e.g. "zone-a/rack-3/host-7". Empty if unknown.
+    std::string locality{};
+    // Size of the equal blocks a slab segment is cut into, e.g. one KV cache
+    // block. 0 lets the master allocate any size with its configured
+    // allocator.
+    uint64_t slab_block_size{0};
     Segment() = default;
 };
-YLT_REFL(Segment, id, name, base, size, te_endpoint, protocol);
+YLT_REFL(Segment, id, name, base, size, te_endpoint, protocol, locality,
+         slab_block_size);
 
 /**
  * @brief Client status from the master's perspective
@@ -278,8 +336,66 @@ inline std::ostream& operator<<(std::ostream& os,
 enum class BufferAllocatorType {
     CACHELIB = 0,  // CachelibBufferAllocator
     OFFSET = 1,    // OffsetBufferAllocator
+    SLAB = 2,      // SlabBufferAllocator, for segments of fixed-size blocks
+};
+
+/**
+ * @brief Policy choosing which objects BatchEvict evicts first. Objects
+ * holding a lease are never evicted.
+ */
+enum class EvictionPolicy {
+    LRU = 0,     // Least recently granted lease first
+    SIEVE = 1,   // Objects not read since the last eviction pass first
+    // Unread objects of a small probationary queue first, read ones move to
+    // a main queue, keys evicted from the small queue are remembered in a
+    // ghost queue and enter the main queue directly when put again
+    S3FIFO = 2,
+    LFU = 3,     // Lowest frequency in a sketch that outlives objects first
+    // Fewest expected hits times recompute cost per freed byte first
+    COST_AWARE = 4,
 };
 
+/**
+ * @brief Parse an eviction policy name, e.g. "lru" or "s3fifo".
+ */
+inline std::optional<EvictionPolicy> ParseEvictionPolicy(
+    std::string_view name) {
+    static const std::unordered_map<std::string_view, EvictionPolicy>
+        policies{{"lru", EvictionPolicy::LRU},
+                 {"sieve", EvictionPolicy::SIEVE},
+                 {"s3fifo", EvictionPolicy::S3FIFO},
+                 {"lfu", EvictionPolicy::LFU},
+                 {"cost_aware", EvictionPolicy::COST_AWARE}};
+    auto it = policies.find(name);
+    if (it == policies.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+/**
+ * @brief How the master picks the segments of new replicas.
+ */
+enum class AllocationStrategyType {
+    RANDOM = 0,      // Random segments
+    LOAD_AWARE = 1,  // Best of two random segments by free space and load
+};
+
+/**
+ * @brief Parse an allocation strategy name, "random" or "load_aware".
+ */
+inline std::optional<AllocationStrategyType> ParseAllocationStrategyType(
+    std::string_view name) {
+    static const std::unordered_map<std::string_view, AllocationStrategyType>
+        strategies{{"random", AllocationStrategyType::RANDOM},
+                   {"load_aware", AllocationStrategyType::LOAD_AWARE}};
+    auto it = strategies.find(name);
+    if (it == strategies.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
 /**
  * @brief Stream operator for BufferAllocatorType
  */
@@ -287,7 +403,8 @@ inline std::ostream& operator<<(std::ostream& os,
                                 const BufferAllocatorType& type) noexcept {
     static const std::unordered_map<BufferAllocatorType, std::string_view>
         type_strings{{BufferAllocatorType::CACHELIB, "CACHELIB"},
-                     {BufferAllocatorType::OFFSET, "OFFSET"}};
+                     {BufferAllocatorType::OFFSET, "OFFSET"},
+                     {BufferAllocatorType::SLAB, "SLAB"}};
 
     os << (type_strings.count(type) ? type_strings.at(type) : "UNKNOWN");
     return os;
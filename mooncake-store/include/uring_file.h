@@ -0,0 +1,60 @@
+#pragma once
+
+#ifdef STORE_USE_URING
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "file_interface.h"
+
+namespace mooncake {
+
+/**
+ * @class UringFile
+ * @brief PosixFile whose positioned reads and writes go through io_uring.
+ *
+ * Each thread submits on a ring of its own. Reads and writes into buffers
+ * registered with RegisterBuffer use fixed buffers, and the requests of
+ * batch_read are in flight together. With a direct_fd opened with
+ * O_DIRECT, the requests whose buffer, length and offset are aligned to
+ * kDirectIoAlignment bypass the page cache; the others use the buffered fd
+ * and their pages are dropped afterwards.
+ */
+class UringFile : public PosixFile {
+   public:
+    static constexpr size_t kDirectIoAlignment = 4096;
+
+    /**
+     * @param direct_fd The same file opened with O_DIRECT, or -1. Owned.
+     */
+    UringFile(const std::string &filename, int fd, int direct_fd = -1);
+    ~UringFile() override;
+
+    tl::expected<size_t, ErrorCode> vector_write(const iovec *iov, int iovcnt,
+                                                 off_t offset) override;
+    tl::expected<size_t, ErrorCode> vector_read(const iovec *iov, int iovcnt,
+                                                off_t offset) override;
+    tl::expected<void, ErrorCode> batch_read(
+        const std::vector<FileReadRequest> &requests) override;
+
+    /**
+     * @brief Registers a buffer, e.g. the client buffer of the file storage,
+     * with the rings of all threads, so that I/O into it skips pinning its
+     * pages on every request. Rings register it on their next submission.
+     */
+    static void RegisterBuffer(void *addr, size_t length);
+
+   private:
+    struct Op;
+
+    tl::expected<size_t, ErrorCode> Submit(std::vector<Op> &ops,
+                                           bool is_write);
+    int FdFor(const void *buffer, size_t length, off_t offset) const;
+
+    int direct_fd_;
+};
+
+}  // namespace mooncake
+
+#endif  // STORE_USE_URING
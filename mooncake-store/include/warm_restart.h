@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace mooncake {
+
+/**
+ * @brief Global segment and identity of a store client kept across restarts
+ * of its process, e.g. upgrades of the real client.
+ *
+ * The segments live in named POSIX shared memory, which outlives the
+ * process, and their addresses, the segment ids and the client id are saved
+ * in a state file. A restarted client maps the segments back at the same
+ * addresses and mounts them with the same ids under the same client id. If
+ * it is back before the master expires the lease of the client, the master
+ * keeps the segments and the objects in them. Memory registrations and
+ * connections belong to the process and are set up again.
+ *
+ * The shared memory stays until the state is destroyed or the host reboots.
+ * Not thread-safe.
+ */
+class WarmRestartState {
+   public:
+    // A segment mapped into this process, the caller unmaps it and closes
+    // the fd
+    struct Mapping {
+        int fd = -1;
+        void* base = nullptr;
+        size_t size = 0;
+        int numa_node = -1;
+        UUID segment_id;
+    };
+
+    /**
+     * @param dir Directory of the state file, created if missing
+     * @param local_hostname Host and port of the client, the state of
+     * another one is not restored
+     * @param total_size Size of the global segment, the state of another
+     * size is not restored
+     */
+    WarmRestartState(std::string dir, std::string local_hostname,
+                     size_t total_size);
+
+    /**
+     * @brief Maps the saved segments back at their addresses. If there are
+     * none, they do not match or an address is taken, the saved state is
+     * dropped and a new client id is used.
+     * @return The mappings, empty if nothing was restored
+     */
+    std::vector<Mapping> Restore();
+
+    bool restored() const { return restored_; }
+
+    const UUID& client_id() const { return client_id_; }
+
+    /**
+     * @brief Creates and maps a new segment of the state
+     */
+    std::optional<Mapping> CreateSegment(size_t size, int numa_node);
+
+    /**
+     * @brief Writes the state file, replacing the previous one at once
+     */
+    bool Save() const;
+
+    /**
+     * @brief Removes the shared memory and the state file
+     */
+    void Destroy();
+
+   private:
+    struct Segment {
+        std::string shm_name;
+        uint64_t base = 0;
+        uint64_t size = 0;
+        int numa_node = -1;
+        UUID id;
+    };
+
+    std::string StatePath() const;
+    bool Load(std::vector<Segment>& segments, UUID& client_id) const;
+
+    const std::string dir_;
+    const std::string local_hostname_;
+    const size_t total_size_;
+    // Prefix of the shared memory names, unique per directory and client
+    const std::string shm_prefix_;
+    UUID client_id_;
+    std::vector<Segment> segments_;
+    bool restored_ = false;
+};
+
+}  // namespace mooncake
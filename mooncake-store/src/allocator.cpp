@@ -3,12 +3,45 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <stdexcept>
+#include <unordered_map>
 
 #include "master_metric_manager.h"
+#include "utils.h"
 
 namespace mooncake {
 
+namespace {
+
+// Reports the latency of one allocation on the segment, and whether it
+// failed, when going out of scope
+class AllocationTimer {
+   public:
+    explicit AllocationTimer(const std::string& segment_name)
+        : segment_name_(segment_name),
+          start_(std::chrono::steady_clock::now()) {}
+
+    ~AllocationTimer() {
+        const auto latency =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_);
+        MasterMetricManager::instance().observe_segment_allocation(
+            segment_name_, latency.count(), succeeded_);
+    }
+
+    void Succeeded() { succeeded_ = true; }
+
+   private:
+    const std::string& segment_name_;
+    const std::chrono::steady_clock::time_point start_;
+    bool succeeded_ = false;
+};
+
+}  // namespace
+
 std::string AllocatedBuffer::getSegmentName() const noexcept {
     auto alloc = allocator_.lock();
     if (alloc) {
@@ -28,6 +61,40 @@ AllocatedBuffer::~AllocatedBuffer() {
     }
 }
 
+void AllocatedBuffer::DeallocateBatch(
+    std::vector<std::unique_ptr<AllocatedBuffer>>&& buffers) {
+    std::unordered_map<std::shared_ptr<BufferAllocatorBase>,
+                       std::vector<std::unique_ptr<AllocatedBuffer>>>
+        groups;
+    for (auto& buffer : buffers) {
+        if (!buffer) {
+            continue;
+        }
+        auto alloc = buffer->allocator_.lock();
+        if (alloc) {
+            groups[std::move(alloc)].push_back(std::move(buffer));
+        }
+    }
+    // Buffers of expired allocators are destroyed here
+    buffers.clear();
+    for (auto& [alloc, group] : groups) {
+        alloc->deallocateBatch(group);
+    }
+}
+
+std::vector<std::unique_ptr<AllocatedBuffer>> AllocatedBuffer::Split(
+    std::unique_ptr<AllocatedBuffer>& buffer,
+    const std::vector<size_t>& sizes) {
+    if (!buffer) {
+        return {};
+    }
+    auto alloc = buffer->allocator_.lock();
+    if (!alloc) {
+        return {};
+    }
+    return alloc->split(buffer, sizes);
+}
+
 // Implementation of get_descriptor
 AllocatedBuffer::Descriptor AllocatedBuffer::get_descriptor() const {
     auto alloc = allocator_.lock();
@@ -116,6 +183,7 @@ CachelibBufferAllocator::~CachelibBufferAllocator() {
 
 std::unique_ptr<AllocatedBuffer> CachelibBufferAllocator::allocate(
     size_t size) {
+    AllocationTimer timer(segment_name_);
     void* buffer = nullptr;
     try {
         // Allocate memory using CacheLib.
@@ -138,6 +206,7 @@ std::unique_ptr<AllocatedBuffer> CachelibBufferAllocator::allocate(
             << " segment=" << segment_name_ << " address=" << buffer;
     cur_size_.fetch_add(size);
     MasterMetricManager::instance().inc_allocated_mem_size(segment_name_, size);
+    timer.Succeeded();
     return std::make_unique<AllocatedBuffer>(shared_from_this(), buffer, size);
 }
 
@@ -162,6 +231,28 @@ void CachelibBufferAllocator::deallocate(AllocatedBuffer* handle) {
     }
 }
 
+AllocatorStats CachelibBufferAllocator::getStats() const {
+    const auto& pool = memory_allocator_->getPool(pool_id_);
+    AllocatorStats stats;
+    stats.capacity = total_size_;
+    stats.allocated = cur_size_.load();
+    const size_t usable = pool.getPoolUsableSize();
+    // Rounding up to the allocation class is not free either
+    const size_t held = std::min(pool.getCurrentAllocSize(), usable);
+    stats.free = usable - held;
+    const size_t unassigned = std::min(pool.getUnAllocatedSlabMemory(),
+                                       static_cast<size_t>(stats.free));
+    stats.largest_free_region =
+        unassigned > 0
+            ? std::min<uint64_t>(facebook::cachelib::Slab::kSize, unassigned)
+            : 0;
+    if (stats.free > 0) {
+        stats.fragmentation =
+            1.0 - static_cast<double>(unassigned) / stats.free;
+    }
+    return stats;
+}
+
 // OffsetBufferAllocator implementation
 OffsetBufferAllocator::OffsetBufferAllocator(std::string segment_name,
                                              size_t base, size_t size,
@@ -187,10 +278,13 @@ OffsetBufferAllocator::OffsetBufferAllocator(std::string segment_name,
             std::max(max_capacity, static_cast<uint64_t>(1024 * 1024));
         max_capacity =
             std::min(max_capacity, static_cast<uint64_t>(64 * 1024 * 1024));
+        // Per-CPU caches of small freed blocks, off by default
+        static const uint64_t magazine_bytes =
+            GetEnvOr<uint64_t>("MC_OFFSET_ALLOCATOR_MAGAZINE_BYTES", 0);
         // Create the offset allocator
         offset_allocator_ = offset_allocator::OffsetAllocator::create(
             base, size, static_cast<uint32_t>(init_capacity),
-            static_cast<uint32_t>(max_capacity));
+            static_cast<uint32_t>(max_capacity), magazine_bytes);
         if (!offset_allocator_) {
             LOG(ERROR) << "status=failed_to_create_offset_allocator";
             throw std::runtime_error("Failed to create offset allocator");
@@ -210,6 +304,7 @@ OffsetBufferAllocator::~OffsetBufferAllocator() {
 };
 
 std::unique_ptr<AllocatedBuffer> OffsetBufferAllocator::allocate(size_t size) {
+    AllocationTimer timer(segment_name_);
     if (!offset_allocator_) {
         LOG(ERROR) << "allocator_status=not_initialized";
         return nullptr;
@@ -243,6 +338,46 @@ std::unique_ptr<AllocatedBuffer> OffsetBufferAllocator::allocate(size_t size) {
         return nullptr;
     }
 
+    cur_size_.fetch_add(size);
+    MasterMetricManager::instance().inc_allocated_mem_size(segment_name_, size);
+    timer.Succeeded();
+    return allocated_buffer;
+}
+
+std::unique_ptr<AllocatedBuffer> OffsetBufferAllocator::reserve(
+    uintptr_t address, size_t size) {
+    if (!offset_allocator_) {
+        LOG(ERROR) << "allocator_status=not_initialized";
+        return nullptr;
+    }
+    if (address < base_ || size == 0 || address - base_ > total_size_ ||
+        size > total_size_ - (address - base_)) {
+        LOG(ERROR) << "reserve_out_of_range address="
+                   << reinterpret_cast<void*>(address) << " size=" << size
+                   << " segment=" << segment_name_;
+        return nullptr;
+    }
+
+    std::unique_ptr<AllocatedBuffer> allocated_buffer = nullptr;
+    try {
+        auto allocation_handle = offset_allocator_->allocateAt(address, size);
+        if (!allocation_handle) {
+            VLOG(1) << "reserve_failed address="
+                    << reinterpret_cast<void*>(address) << " size=" << size
+                    << " segment=" << segment_name_;
+            return nullptr;
+        }
+        void* buffer_ptr = allocation_handle->ptr();
+        allocated_buffer = std::make_unique<AllocatedBuffer>(
+            shared_from_this(), buffer_ptr, size, std::move(allocation_handle));
+    } catch (const std::exception& e) {
+        LOG(ERROR) << "reserve_exception error=" << e.what();
+        return nullptr;
+    } catch (...) {
+        LOG(ERROR) << "reserve_unknown_exception";
+        return nullptr;
+    }
+
     cur_size_.fetch_add(size);
     MasterMetricManager::instance().inc_allocated_mem_size(segment_name_, size);
     return allocated_buffer;
@@ -266,6 +401,68 @@ void OffsetBufferAllocator::deallocate(AllocatedBuffer* handle) {
     }
 }
 
+void OffsetBufferAllocator::deallocateBatch(
+    std::vector<std::unique_ptr<AllocatedBuffer>>& buffers) {
+    std::vector<offset_allocator::OffsetAllocationHandle> handles;
+    handles.reserve(buffers.size());
+    size_t freed_size = 0;
+    for (auto& buffer : buffers) {
+        if (buffer->offset_handle_) {
+            handles.push_back(std::move(*buffer->offset_handle_));
+            buffer->offset_handle_.reset();
+        }
+        freed_size += buffer->size();
+        // Freed below, not again when the buffer is destroyed
+        buffer->allocator_.reset();
+    }
+    buffers.clear();
+    if (offset_allocator_) {
+        offset_allocator_->freeAllocations(handles);
+    }
+    cur_size_.fetch_sub(freed_size);
+    MasterMetricManager::instance().dec_allocated_mem_size(segment_name_,
+                                                           freed_size);
+    VLOG(1) << "batch_deallocation_succeeded count=" << handles.size()
+            << " size=" << freed_size << " segment=" << segment_name_;
+}
+
+std::vector<std::unique_ptr<AllocatedBuffer>> OffsetBufferAllocator::split(
+    std::unique_ptr<AllocatedBuffer>& buffer,
+    const std::vector<size_t>& sizes) {
+    std::vector<std::unique_ptr<AllocatedBuffer>> pieces;
+    if (!offset_allocator_ || !buffer || !buffer->offset_handle_) {
+        return pieces;
+    }
+    auto handles = offset_allocator_->split(*buffer->offset_handle_, sizes);
+    if (handles.empty()) {
+        return pieces;
+    }
+
+    size_t split_size = 0;
+    pieces.reserve(handles.size());
+    for (auto& handle : handles) {
+        void* buffer_ptr = handle.ptr();
+        const size_t size = handle.size();
+        split_size += size;
+        pieces.push_back(std::make_unique<AllocatedBuffer>(
+            shared_from_this(), buffer_ptr, size, std::move(handle)));
+    }
+    // The pieces own the memory now, the buffer is not freed again
+    const size_t buffer_size = buffer->size();
+    buffer->offset_handle_.reset();
+    buffer->allocator_.reset();
+    buffer.reset();
+    cur_size_.fetch_add(split_size);
+    cur_size_.fetch_sub(buffer_size);
+    MasterMetricManager::instance().inc_allocated_mem_size(segment_name_,
+                                                           split_size);
+    MasterMetricManager::instance().dec_allocated_mem_size(segment_name_,
+                                                           buffer_size);
+    VLOG(1) << "split_succeeded count=" << pieces.size()
+            << " size=" << split_size << " segment=" << segment_name_;
+    return pieces;
+}
+
 size_t OffsetBufferAllocator::getLargestFreeRegion() const {
     if (!offset_allocator_) {
         return 0;
@@ -285,6 +482,185 @@ size_t OffsetBufferAllocator::getLargestFreeRegion() const {
     }
 }
 
+AllocatorStats OffsetBufferAllocator::getStats() const {
+    AllocatorStats stats;
+    stats.capacity = total_size_;
+    stats.allocated = cur_size_.load();
+    if (!offset_allocator_) {
+        return stats;
+    }
+    const auto report = offset_allocator_->storageReport();
+    stats.free = report.totalFreeSpace;
+    stats.largest_free_region =
+        std::min(report.largestFreeRegion, report.totalFreeSpace);
+    stats.free_regions = report.freeRegions;
+    if (stats.free > 0) {
+        stats.fragmentation =
+            1.0 - static_cast<double>(stats.largest_free_region) / stats.free;
+    }
+    return stats;
+}
+
+// SlabBufferAllocator implementation
+SlabBufferAllocator::SlabBufferAllocator(std::string segment_name, size_t base,
+                                         size_t size, size_t block_size,
+                                         std::string transport_endpoint)
+    : segment_name_(std::move(segment_name)),
+      base_(base),
+      block_size_(block_size),
+      num_blocks_(block_size == 0 ? 0 : size / block_size),
+      cur_size_(0),
+      transport_endpoint_(std::move(transport_endpoint)) {
+    if (num_blocks_ == 0 || num_blocks_ >= kUsed) {
+        LOG(ERROR) << "invalid_slab_block_size segment_name=" << segment_name_
+                   << " size=" << size << " block_size=" << block_size;
+        throw std::invalid_argument("Invalid slab block size");
+    }
+    MutexLocker lock(&mutex_);
+    free_blocks_.resize(num_blocks_);
+    free_positions_.resize(num_blocks_);
+    for (size_t i = 0; i < num_blocks_; ++i) {
+        // Lowest addresses first
+        const auto block = static_cast<uint32_t>(num_blocks_ - 1 - i);
+        free_blocks_[i] = block;
+        free_positions_[block] = static_cast<uint32_t>(i);
+    }
+    VLOG(1) << "slab_buffer_allocator_initialized segment_name="
+            << segment_name_
+            << " base_address=" << reinterpret_cast<void*>(base)
+            << " block_size=" << block_size_ << " num_blocks=" << num_blocks_;
+}
+
+SlabBufferAllocator::~SlabBufferAllocator() {
+    MasterMetricManager::instance().dec_allocated_mem_size(segment_name_,
+                                                           cur_size_);
+}
+
+void SlabBufferAllocator::takeBlockLocked(uint32_t block) {
+    const uint32_t position = free_positions_[block];
+    const uint32_t last = free_blocks_.back();
+    free_blocks_[position] = last;
+    free_positions_[last] = position;
+    free_blocks_.pop_back();
+    free_positions_[block] = kUsed;
+}
+
+void SlabBufferAllocator::freeBlockLocked(uint32_t block) {
+    free_positions_[block] = static_cast<uint32_t>(free_blocks_.size());
+    free_blocks_.push_back(block);
+}
+
+std::unique_ptr<AllocatedBuffer> SlabBufferAllocator::makeBuffer(
+    uint32_t block) {
+    void* buffer_ptr = reinterpret_cast<void*>(base_ + block * block_size_);
+    cur_size_.fetch_add(block_size_);
+    MasterMetricManager::instance().inc_allocated_mem_size(segment_name_,
+                                                           block_size_);
+    VLOG(1) << "allocation_succeeded size=" << block_size_
+            << " segment=" << segment_name_ << " address=" << buffer_ptr;
+    return std::make_unique<AllocatedBuffer>(shared_from_this(), buffer_ptr,
+                                             block_size_);
+}
+
+std::unique_ptr<AllocatedBuffer> SlabBufferAllocator::allocate(size_t size) {
+    if (size != block_size_) {
+        VLOG(1) << "allocation_size_mismatch size=" << size
+                << " block_size=" << block_size_
+                << " segment=" << segment_name_;
+        return nullptr;
+    }
+    AllocationTimer timer(segment_name_);
+    uint32_t block;
+    {
+        MutexLocker lock(&mutex_);
+        if (free_blocks_.empty()) {
+            VLOG(1) << "allocation_failed size=" << size
+                    << " segment=" << segment_name_
+                    << " current_size=" << cur_size_;
+            return nullptr;
+        }
+        block = free_blocks_.back();
+        free_blocks_.pop_back();
+        free_positions_[block] = kUsed;
+    }
+    timer.Succeeded();
+    return makeBuffer(block);
+}
+
+std::unique_ptr<AllocatedBuffer> SlabBufferAllocator::reserve(
+    uintptr_t address, size_t size) {
+    if (address < base_ || size != block_size_ ||
+        (address - base_) % block_size_ != 0 ||
+        (address - base_) / block_size_ >= num_blocks_) {
+        LOG(ERROR) << "reserve_out_of_range address="
+                   << reinterpret_cast<void*>(address) << " size=" << size
+                   << " segment=" << segment_name_;
+        return nullptr;
+    }
+    const auto block = static_cast<uint32_t>((address - base_) / block_size_);
+    {
+        MutexLocker lock(&mutex_);
+        if (free_positions_[block] == kUsed) {
+            VLOG(1) << "reserve_failed address="
+                    << reinterpret_cast<void*>(address) << " size=" << size
+                    << " segment=" << segment_name_;
+            return nullptr;
+        }
+        takeBlockLocked(block);
+    }
+    return makeBuffer(block);
+}
+
+void SlabBufferAllocator::deallocate(AllocatedBuffer* handle) {
+    const auto address = reinterpret_cast<uintptr_t>(handle->data());
+    {
+        MutexLocker lock(&mutex_);
+        freeBlockLocked(static_cast<uint32_t>((address - base_) / block_size_));
+    }
+    cur_size_.fetch_sub(block_size_);
+    MasterMetricManager::instance().dec_allocated_mem_size(segment_name_,
+                                                           block_size_);
+    VLOG(1) << "deallocation_succeeded address=" << handle->data()
+            << " size=" << block_size_ << " segment=" << segment_name_;
+}
+
+void SlabBufferAllocator::deallocateBatch(
+    std::vector<std::unique_ptr<AllocatedBuffer>>& buffers) {
+    {
+        MutexLocker lock(&mutex_);
+        for (auto& buffer : buffers) {
+            const auto address = reinterpret_cast<uintptr_t>(buffer->data());
+            freeBlockLocked(
+                static_cast<uint32_t>((address - base_) / block_size_));
+            // Freed here, not again when the buffer is destroyed
+            buffer->allocator_.reset();
+        }
+    }
+    const size_t freed_size = buffers.size() * block_size_;
+    cur_size_.fetch_sub(freed_size);
+    MasterMetricManager::instance().dec_allocated_mem_size(segment_name_,
+                                                           freed_size);
+    VLOG(1) << "batch_deallocation_succeeded count=" << buffers.size()
+            << " size=" << freed_size << " segment=" << segment_name_;
+    buffers.clear();
+}
+
+size_t SlabBufferAllocator::getLargestFreeRegion() const {
+    MutexLocker lock(&mutex_);
+    return free_blocks_.empty() ? 0 : block_size_;
+}
+
+AllocatorStats SlabBufferAllocator::getStats() const {
+    AllocatorStats stats;
+    stats.capacity = capacity();
+    stats.allocated = cur_size_.load();
+    MutexLocker lock(&mutex_);
+    stats.free = free_blocks_.size() * block_size_;
+    stats.largest_free_region = free_blocks_.empty() ? 0 : block_size_;
+    stats.free_regions = free_blocks_.size();
+    return stats;
+}
+
 SimpleAllocator::SimpleAllocator(size_t size) {
     LOG(INFO) << "initializing_simple_allocator size=" << size;
 
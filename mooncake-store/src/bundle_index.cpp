@@ -0,0 +1,197 @@
+#include "bundle_index.h"
+
+#include <algorithm>
+
+namespace mooncake {
+
+bool BundleIndex::IsBundleKey(const std::string& key) {
+    return key.starts_with(kBundleKeyPrefix);
+}
+
+ErrorCode BundleIndex::Link(const std::string& bundle_key,
+                            const std::vector<std::string>& keys,
+                            const std::vector<uint64_t>& sizes,
+                            bool& inserted) {
+    inserted = false;
+    // All keys are checked and linked at once, under the locks of their
+    // shards taken in ascending order
+    std::vector<size_t> shards;
+    shards.reserve(keys.size());
+    for (const auto& key : keys) {
+        shards.push_back(ShardIndex(key));
+    }
+    std::sort(shards.begin(), shards.end());
+    shards.erase(std::unique(shards.begin(), shards.end()), shards.end());
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(shards.size());
+    for (size_t shard : shards) {
+        locks.emplace_back(link_shards_[shard].mutex);
+    }
+
+    uint64_t offset = 0;
+    size_t linked = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        const auto& links = GetLinkShard(keys[i]).links;
+        auto it = links.find(keys[i]);
+        if (it != links.end()) {
+            if (*it->second.bundle_key != bundle_key ||
+                it->second.offset != offset || it->second.size != sizes[i]) {
+                return ErrorCode::OBJECT_ALREADY_EXISTS;
+            }
+            linked++;
+        }
+        offset += sizes[i];
+    }
+    if (linked == keys.size()) {
+        return ErrorCode::OK;
+    }
+    if (linked > 0) {
+        // Part of the keys are linked to this bundle already
+        return ErrorCode::OBJECT_ALREADY_EXISTS;
+    }
+
+    std::shared_ptr<const std::string> key_ptr;
+    {
+        auto& shard = GetBundleShard(bundle_key);
+        std::lock_guard lock(shard.mutex);
+        auto [it, created] = shard.bundles.try_emplace(bundle_key);
+        auto& bundle = it->second;
+        if (created) {
+            bundle.key = std::make_shared<const std::string>(bundle_key);
+            num_bundles_.fetch_add(1, std::memory_order_relaxed);
+        }
+        bundle.keys.insert(bundle.keys.end(), keys.begin(), keys.end());
+        bundle.refs += keys.size();
+        key_ptr = bundle.key;
+    }
+    offset = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        GetLinkShard(keys[i]).links.emplace(
+            keys[i], Range{key_ptr, offset, sizes[i]});
+        offset += sizes[i];
+    }
+    num_member_keys_.fetch_add(keys.size(), std::memory_order_relaxed);
+    inserted = true;
+    return ErrorCode::OK;
+}
+
+std::optional<BundleIndex::Member> BundleIndex::Resolve(
+    const std::string& key) const {
+    auto& shard = GetLinkShard(key);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.links.find(key);
+    if (it == shard.links.end()) {
+        return std::nullopt;
+    }
+    return Member{*it->second.bundle_key, it->second.offset, it->second.size};
+}
+
+bool BundleIndex::Unlink(const std::string& key,
+                         std::optional<std::string>& orphaned) {
+    auto& shard = GetLinkShard(key);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.links.find(key);
+    if (it == shard.links.end()) {
+        return false;
+    }
+    if (Release(it->second.bundle_key)) {
+        orphaned = *it->second.bundle_key;
+    }
+    shard.links.erase(it);
+    num_member_keys_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t BundleIndex::UnlinkFrom(const std::string& bundle_key,
+                               const std::vector<std::string>& keys,
+                               std::optional<std::string>& orphaned) {
+    size_t unlinked = 0;
+    for (const auto& key : keys) {
+        auto& shard = GetLinkShard(key);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.links.find(key);
+        if (it == shard.links.end() || *it->second.bundle_key != bundle_key) {
+            continue;
+        }
+        if (Release(it->second.bundle_key)) {
+            orphaned = bundle_key;
+        }
+        shard.links.erase(it);
+        unlinked++;
+    }
+    num_member_keys_.fetch_sub(unlinked, std::memory_order_relaxed);
+    return unlinked;
+}
+
+size_t BundleIndex::UnlinkIf(
+    const std::function<bool(const std::string&)>& pred,
+    std::vector<std::string>& orphaned) {
+    size_t unlinked = 0;
+    for (auto& shard : link_shards_) {
+        std::lock_guard lock(shard.mutex);
+        for (auto it = shard.links.begin(); it != shard.links.end();) {
+            if (!pred(it->first)) {
+                ++it;
+                continue;
+            }
+            if (Release(it->second.bundle_key)) {
+                orphaned.push_back(*it->second.bundle_key);
+            }
+            it = shard.links.erase(it);
+            unlinked++;
+        }
+    }
+    num_member_keys_.fetch_sub(unlinked, std::memory_order_relaxed);
+    return unlinked;
+}
+
+size_t BundleIndex::Drop(const std::string& bundle_key) {
+    Bundle bundle;
+    {
+        auto& shard = GetBundleShard(bundle_key);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.bundles.find(bundle_key);
+        if (it == shard.bundles.end()) {
+            return 0;
+        }
+        bundle = std::move(it->second);
+        shard.bundles.erase(it);
+        num_bundles_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    // Only the links to this bundle, not to one linked again since
+    size_t unlinked = 0;
+    for (const auto& key : bundle.keys) {
+        auto& shard = GetLinkShard(key);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.links.find(key);
+        if (it != shard.links.end() && it->second.bundle_key == bundle.key) {
+            shard.links.erase(it);
+            unlinked++;
+        }
+    }
+    num_member_keys_.fetch_sub(unlinked, std::memory_order_relaxed);
+    return unlinked;
+}
+
+BundleIndex::Stats BundleIndex::GetStats() const {
+    return Stats{num_member_keys_.load(std::memory_order_relaxed),
+                 num_bundles_.load(std::memory_order_relaxed)};
+}
+
+bool BundleIndex::Release(
+    const std::shared_ptr<const std::string>& bundle_key) {
+    auto& shard = GetBundleShard(*bundle_key);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.bundles.find(*bundle_key);
+    if (it == shard.bundles.end() || it->second.key != bundle_key) {
+        return false;
+    }
+    if (--it->second.refs > 0) {
+        return false;
+    }
+    shard.bundles.erase(it);
+    num_bundles_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+}  // namespace mooncake
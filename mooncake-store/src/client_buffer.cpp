@@ -1,8 +1,15 @@
 #include "client_buffer.hpp"
 
 #include <algorithm>
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
+#include <utility>
 #include <vector>
+#include <glog/logging.h>
+#include <numa.h>
+#include <numaif.h>    // For mbind
+#include <sched.h>     // For sched_getcpu
 #include <sys/mman.h>  // For shm_open, mmap, munmap
 #include <sys/stat.h>  // For S_IRUSR, S_IWUSR
 #include <fcntl.h>     // For O_CREAT, O_RDWR
@@ -12,31 +19,77 @@
 
 namespace mooncake {
 
+namespace {
+
+// Spreads threads over the arenas of a node
+size_t ThreadSlot() {
+    static std::atomic<size_t> next_slot{0};
+    thread_local const size_t slot =
+        next_slot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+}  // namespace
+
+ClientBufferArenaConfig ClientBufferArenaConfig::FromEnvironment() {
+    ClientBufferArenaConfig config;
+    config.cache_bytes = GetEnvOr<size_t>("MC_STORE_CLIENT_BUFFER_CACHE_BYTES",
+                                          config.cache_bytes);
+    config.arenas =
+        GetEnvOr<size_t>("MC_STORE_CLIENT_BUFFER_ARENAS", config.arenas);
+    config.numa_local =
+        GetEnvOr<bool>("MC_STORE_CLIENT_BUFFER_NUMA", config.numa_local);
+    return config;
+}
+
 std::shared_ptr<ClientBufferAllocator> ClientBufferAllocator::create(
-    size_t size, const std::string& protocol, bool use_hugepage) {
-    return std::shared_ptr<ClientBufferAllocator>(
-        new ClientBufferAllocator(size, protocol, use_hugepage));
+    size_t size, const std::string& protocol, bool use_hugepage,
+    const ClientBufferArenaConfig& arena_config) {
+    return std::shared_ptr<ClientBufferAllocator>(new ClientBufferAllocator(
+        size, protocol, use_hugepage, arena_config));
 }
 
 std::shared_ptr<ClientBufferAllocator> ClientBufferAllocator::create(
-    void* addr, size_t size, const std::string& protocol) {
+    void* addr, size_t size, const std::string& protocol,
+    const ClientBufferArenaConfig& arena_config) {
     return std::shared_ptr<ClientBufferAllocator>(
-        new ClientBufferAllocator(addr, size, protocol));
+        new ClientBufferAllocator(addr, size, protocol, arena_config));
 }
 
-ClientBufferAllocator::ClientBufferAllocator(size_t size,
-                                             const std::string& protocol,
-                                             bool use_hugepage)
+ClientBufferAllocator::ClientBufferAllocator(
+    size_t size, const std::string& protocol, bool use_hugepage,
+    const ClientBufferArenaConfig& arena_config)
     : protocol(protocol), buffer_size_(size), use_hugepage_(use_hugepage) {
     if (size == 0) {
         buffer_ = nullptr;
-        allocator_ = nullptr;
         return;
     }
     // Align to 64 bytes(cache line size) for better cache performance
     constexpr size_t alignment = 64;
     if (use_hugepage_) {
         buffer_ = allocate_buffer_mmap_memory(size, alignment);
+        if (!buffer_) {
+            // Not enough reserved hugepages, let transparent hugepages back
+            // what they can instead
+            LOG(WARNING) << "Falling back to regular pages for the client "
+                            "buffer, size="
+                         << size;
+            use_hugepage_ = false;
+            buffer_ =
+                allocate_buffer_allocator_memory(size, protocol, alignment);
+            if (buffer_ && protocol != "ascend") {
+                const size_t page = getpagesize();
+                const uintptr_t begin =
+                    align_up(reinterpret_cast<uintptr_t>(buffer_), page);
+                const uintptr_t end =
+                    (reinterpret_cast<uintptr_t>(buffer_) + size) &
+                    ~(page - 1);
+                if (end > begin) {
+                    madvise(reinterpret_cast<void*>(begin), end - begin,
+                            MADV_HUGEPAGE);
+                }
+            }
+        }
     } else {
         buffer_ = allocate_buffer_allocator_memory(size, protocol, alignment);
     }
@@ -44,20 +97,24 @@ ClientBufferAllocator::ClientBufferAllocator(size_t size,
         throw std::bad_alloc();
     }
 
-    allocator_ = mooncake::offset_allocator::OffsetAllocator::create(
-        reinterpret_cast<uint64_t>(buffer_), size);
+    InitRegions(arena_config.numa_local);
+    InitArenas(arena_config);
 }
 
-ClientBufferAllocator::ClientBufferAllocator(void* addr, size_t size,
-                                             const std::string& protocol)
+ClientBufferAllocator::ClientBufferAllocator(
+    void* addr, size_t size, const std::string& protocol,
+    const ClientBufferArenaConfig& arena_config)
     : protocol(protocol), buffer_size_(size) {
     buffer_ = addr;
     is_external_memory_ = true;
-    allocator_ = mooncake::offset_allocator::OffsetAllocator::create(
-        reinterpret_cast<uint64_t>(buffer_), size);
+    // Memory of someone else is placed by them
+    InitRegions(false);
+    InitArenas(arena_config);
 }
 
 ClientBufferAllocator::~ClientBufferAllocator() {
+    // Give the cached blocks back before the regions go
+    arenas_.clear();
     // Free the aligned allocated memory or unmap shared memory
     if (!is_external_memory_ && buffer_) {
         if (use_hugepage_) {
@@ -68,32 +125,295 @@ ClientBufferAllocator::~ClientBufferAllocator() {
     }
 }
 
+void ClientBufferAllocator::InitRegions(bool numa_local) {
+    const uint64_t base = reinterpret_cast<uint64_t>(buffer_);
+    const int nodes = numa_local && !is_external_memory_ &&
+                              protocol != "ascend" && numa_available() >= 0
+                          ? numa_num_configured_nodes()
+                          : 1;
+    const size_t page =
+        use_hugepage_ ? get_hugepage_size_from_env() : getpagesize();
+    const uint64_t first_page = align_up(base, page);
+    const uint64_t share =
+        nodes > 1 ? (base + buffer_size_ - first_page) / nodes / page * page
+                  : 0;
+    if (nodes <= 1 || nodes > 64 || share == 0) {
+        if (numa_local && nodes > 1) {
+            LOG(WARNING) << "Client buffer too small to split over " << nodes
+                         << " NUMA nodes, size=" << buffer_size_;
+        }
+        regions_.push_back(Region{
+            offset_allocator::OffsetAllocator::create(base, buffer_size_),
+            base, base + buffer_size_});
+        return;
+    }
+
+    for (int node = 0; node < nodes; ++node) {
+        const uint64_t begin = node == 0 ? base : first_page + node * share;
+        const uint64_t end = node == nodes - 1
+                                 ? base + buffer_size_
+                                 : first_page + (node + 1) * share;
+        // The pages shared with the previous region stay where they are
+        const uint64_t bind_begin = align_up(begin, page);
+        const uint64_t bind_end = end / page * page;
+        unsigned long mask = 1UL << node;
+        if (bind_end > bind_begin &&
+            mbind(reinterpret_cast<void*>(bind_begin), bind_end - bind_begin,
+                  MPOL_PREFERRED, &mask, sizeof(mask) * 8,
+                  MPOL_MF_MOVE) != 0) {
+            LOG(WARNING) << "Failed to bind client buffer region to NUMA node "
+                         << node << ", errno=" << errno << " ("
+                         << strerror(errno) << ")";
+        }
+        regions_.push_back(Region{
+            offset_allocator::OffsetAllocator::create(begin, end - begin),
+            begin, end});
+    }
+
+    const int cpus = numa_num_configured_cpus();
+    cpu_nodes_.assign(std::max(cpus, 0), 0);
+    for (int cpu = 0; cpu < cpus; ++cpu) {
+        const int node = numa_node_of_cpu(cpu);
+        if (node >= 0 && node < nodes) {
+            cpu_nodes_[cpu] = node;
+        }
+    }
+    LOG(INFO) << "Client buffer split over " << nodes
+              << " NUMA nodes, size=" << buffer_size_;
+}
+
+void ClientBufferAllocator::InitArenas(
+    const ClientBufferArenaConfig& arena_config) {
+    cache_bytes_ = arena_config.cache_bytes;
+    if (cache_bytes_ == 0 || regions_.empty()) {
+        return;
+    }
+    arenas_per_node_ = std::max<size_t>(arena_config.arenas, 1);
+    const size_t count = regions_.size() * arenas_per_node_;
+    arenas_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        arenas_.push_back(std::make_unique<Arena>());
+    }
+}
+
+int ClientBufferAllocator::SizeClass(size_t size) {
+    constexpr int kMinShift = 12;
+    if (size <= (size_t{1} << kMinShift)) {
+        return 0;
+    }
+    // 2^shift < size <= 2^(shift + 1), in four steps of 2^(shift - 2)
+    const int shift = 63 - __builtin_clzll(size - 1);
+    const size_t step = size_t{1} << (shift - 2);
+    const size_t steps = (size + step - 1) / step;  // 5 to 8
+    return 1 + (shift - kMinShift) * 4 + static_cast<int>(steps - 5);
+}
+
+size_t ClientBufferAllocator::ClassSize(int size_class) {
+    if (size_class == 0) {
+        return 4096;
+    }
+    const int shift = 12 + (size_class - 1) / 4;
+    return (5 + (size_class - 1) % 4) * (size_t{1} << (shift - 2));
+}
+
+size_t ClientBufferAllocator::CurrentNode() const {
+    if (cpu_nodes_.empty()) {
+        return 0;
+    }
+    const int cpu = sched_getcpu();
+    if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_nodes_.size()) {
+        return 0;
+    }
+    return cpu_nodes_[cpu];
+}
+
+ClientBufferAllocator::Arena& ClientBufferAllocator::CurrentArena(
+    size_t node) {
+    return *arenas_[node * arenas_per_node_ + ThreadSlot() % arenas_per_node_];
+}
+
+std::unique_lock<std::mutex> ClientBufferAllocator::LockArena(Arena& arena) {
+    std::unique_lock<std::mutex> lock(arena.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        arena_lock_waits_.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+    }
+    return lock;
+}
+
+std::optional<offset_allocator::OffsetAllocationHandle>
+ClientBufferAllocator::AllocateCentral(size_t size, size_t node) {
+    central_allocations_.fetch_add(1, std::memory_order_relaxed);
+    auto handle = regions_[node].allocator->allocate(size);
+    if (handle) {
+        return handle;
+    }
+    for (size_t i = 0; i < regions_.size(); ++i) {
+        if (i == node) {
+            continue;
+        }
+        handle = regions_[i].allocator->allocate(size);
+        if (handle) {
+            remote_node_allocations_.fetch_add(1, std::memory_order_relaxed);
+            return handle;
+        }
+    }
+    return std::nullopt;
+}
+
 std::optional<BufferHandle> ClientBufferAllocator::allocate(size_t size) {
-    if (allocator_ == nullptr) {
+    if (regions_.empty()) {
         return std::nullopt;
     }
-    auto handle = allocator_->allocate(size);
+    const size_t node = CurrentNode();
+
+    if (arenas_.empty() || size == 0 || size > kMaxCachedSize) {
+        auto handle = AllocateCentral(size, node);
+        if (!handle && cached_bytes_.load(std::memory_order_relaxed) > 0) {
+            FlushCaches();
+            handle = AllocateCentral(size, node);
+        }
+        if (!handle) {
+            return std::nullopt;
+        }
+        return std::make_optional<BufferHandle>(shared_from_this(),
+                                                std::move(*handle));
+    }
+
+    const int size_class = SizeClass(size);
+    const size_t class_size = ClassSize(size_class);
+    std::optional<offset_allocator::OffsetAllocationHandle> handle;
+    {
+        Arena& arena = CurrentArena(node);
+        auto lock = LockArena(arena);
+        auto& free_list = arena.free_lists[size_class];
+        if (!free_list.empty()) {
+            handle.emplace(std::move(free_list.back()));
+            free_list.pop_back();
+            arena.cached_bytes -= class_size;
+            cached_bytes_.fetch_sub(class_size, std::memory_order_relaxed);
+        }
+    }
+    if (handle) {
+        cache_hits_.fetch_add(1, std::memory_order_relaxed);
+        return std::make_optional<BufferHandle>(
+            shared_from_this(), std::move(*handle), size, size_class);
+    }
+
+    cache_misses_.fetch_add(1, std::memory_order_relaxed);
+    handle = AllocateCentral(class_size, node);
     if (!handle) {
-        return std::nullopt;
+        FlushCaches();
+        handle = AllocateCentral(class_size, node);
     }
+    if (!handle) {
+        // The rounding up to the class may be what does not fit
+        handle = AllocateCentral(size, node);
+        if (!handle) {
+            return std::nullopt;
+        }
+        return std::make_optional<BufferHandle>(shared_from_this(),
+                                                std::move(*handle));
+    }
+    return std::make_optional<BufferHandle>(
+        shared_from_this(), std::move(*handle), size, size_class);
+}
 
-    return std::make_optional<BufferHandle>(shared_from_this(),
-                                            std::move(*handle));
+void ClientBufferAllocator::Recycle(
+    offset_allocator::OffsetAllocationHandle&& handle, int size_class) {
+    const size_t node = CurrentNode();
+    const uint64_t address = handle.address();
+    if (address < regions_[node].begin || address >= regions_[node].end) {
+        return;  // cached blocks stay on the node of their arena
+    }
+    const size_t class_size = ClassSize(size_class);
+    Arena& arena = CurrentArena(node);
+    auto lock = LockArena(arena);
+    if (arena.cached_bytes + class_size > cache_bytes_) {
+        return;
+    }
+    arena.free_lists[size_class].push_back(std::move(handle));
+    arena.cached_bytes += class_size;
+    cached_bytes_.fetch_add(class_size, std::memory_order_relaxed);
+}
+
+void ClientBufferAllocator::FlushCaches() {
+    for (auto& arena : arenas_) {
+        std::array<std::vector<offset_allocator::OffsetAllocationHandle>,
+                   kNumSizeClasses>
+            free_lists;
+        {
+            auto lock = LockArena(*arena);
+            free_lists.swap(arena->free_lists);
+            cached_bytes_.fetch_sub(arena->cached_bytes,
+                                    std::memory_order_relaxed);
+            arena->cached_bytes = 0;
+        }
+        // The handles free their blocks here, outside the arena lock
+    }
+}
+
+ClientBufferAllocator::Stats ClientBufferAllocator::GetStats() const {
+    Stats stats;
+    stats.cache_hits = cache_hits_.load(std::memory_order_relaxed);
+    stats.cache_misses = cache_misses_.load(std::memory_order_relaxed);
+    stats.cached_bytes = cached_bytes_.load(std::memory_order_relaxed);
+    stats.arena_lock_waits = arena_lock_waits_.load(std::memory_order_relaxed);
+    stats.central_allocations =
+        central_allocations_.load(std::memory_order_relaxed);
+    stats.remote_node_allocations =
+        remote_node_allocations_.load(std::memory_order_relaxed);
+    return stats;
 }
 
 BufferHandle::BufferHandle(
     std::shared_ptr<ClientBufferAllocator> allocator,
     mooncake::offset_allocator::OffsetAllocationHandle handle)
-    : allocator_(std::move(allocator)), handle_(std::move(handle)) {}
+    : allocator_(std::move(allocator)),
+      handle_(std::move(handle)),
+      size_(handle_.size()) {}
+
+BufferHandle::BufferHandle(
+    std::shared_ptr<ClientBufferAllocator> allocator,
+    mooncake::offset_allocator::OffsetAllocationHandle handle, size_t size,
+    int size_class)
+    : allocator_(std::move(allocator)),
+      handle_(std::move(handle)),
+      size_(size),
+      size_class_(size_class) {}
+
+BufferHandle::BufferHandle(BufferHandle&& other) noexcept
+    : allocator_(std::move(other.allocator_)),
+      handle_(std::move(other.handle_)),
+      size_(std::exchange(other.size_, 0)),
+      size_class_(std::exchange(other.size_class_, -1)) {}
+
+BufferHandle& BufferHandle::operator=(BufferHandle&& other) noexcept {
+    if (this != &other) {
+        Release();
+        allocator_ = std::move(other.allocator_);
+        handle_ = std::move(other.handle_);
+        size_ = std::exchange(other.size_, 0);
+        size_class_ = std::exchange(other.size_class_, -1);
+    }
+    return *this;
+}
 
 BufferHandle::~BufferHandle() {
-    // The OffsetAllocationHandle destructor will automatically deallocate
-    // No need to manually call deallocate
+    // Blocks not taken by the cache are freed by the OffsetAllocationHandle
+    // destructor
+    Release();
+}
+
+void BufferHandle::Release() {
+    if (size_class_ >= 0 && allocator_ && handle_.isValid()) {
+        allocator_->Recycle(std::move(handle_), size_class_);
+    }
 }
 
 void* BufferHandle::ptr() const { return handle_.ptr(); }
 
-size_t BufferHandle::size() const { return handle_.size(); }
+size_t BufferHandle::size() const { return size_; }
 
 // Utility functions for buffer and slice management
 std::vector<Slice> split_into_slices(BufferHandle& handle) {
@@ -122,6 +442,8 @@ uint64_t calculate_total_size(const Replica::Descriptor& replica) {
         total_length = disk_descriptor.object_size;
     } else if (replica.is_local_disk_replica()) {
         total_length = replica.get_local_disk_descriptor().object_size;
+    } else if (replica.is_striped_replica()) {
+        total_length = replica.get_striped_descriptor().object_size;
     } else {
         total_length = replica.get_memory_descriptor().buffer_descriptor.size_;
     }
@@ -143,6 +465,9 @@ int allocateSlices(std::vector<Slice>& slices,
     } else if (replica.is_local_disk_replica()) {
         slices.emplace_back(
             Slice{buffer_ptr, replica.get_local_disk_descriptor().object_size});
+    } else if (replica.is_striped_replica()) {
+        slices.emplace_back(
+            Slice{buffer_ptr, replica.get_striped_descriptor().object_size});
     } else {
         // For memory-based replica, split into slices based on buffer
         // descriptors
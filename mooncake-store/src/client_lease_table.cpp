@@ -0,0 +1,145 @@
+#include "client_lease_table.h"
+
+#include <algorithm>
+
+namespace mooncake {
+
+ClientLeaseTable::ClientLeaseTable(std::chrono::milliseconds ttl,
+                                   std::chrono::milliseconds tick,
+                                   Clock::time_point now)
+    : ttl_ms_(ttl.count()), tick_ms_(std::max<int64_t>(tick.count(), 1)) {
+    // A deadline is at most ttl ahead, so its bucket never wraps around
+    // to one that is due before it
+    wheel_.resize(ttl_ms_ / tick_ms_ + 3);
+    last_tick_ = ToMs(now) / tick_ms_;
+}
+
+ClientLeaseTable::Shard& ClientLeaseTable::ShardOf(
+    const UUID& client_id) const {
+    return shards_[boost::hash<UUID>{}(client_id) % kNumShards];
+}
+
+int64_t ClientLeaseTable::ToMs(Clock::time_point now) const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               now.time_since_epoch())
+        .count();
+}
+
+int64_t ClientLeaseTable::DueTick(int64_t deadline_ms) const {
+    return (deadline_ms + tick_ms_ - 1) / tick_ms_;
+}
+
+void ClientLeaseTable::Schedule(const UUID& client_id, int64_t deadline_ms) {
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    int64_t tick = std::max(DueTick(deadline_ms), last_tick_ + 1);
+    wheel_[tick % wheel_.size()].push_back(client_id);
+}
+
+bool ClientLeaseTable::Renew(const UUID& client_id, Clock::time_point now) {
+    const int64_t deadline_ms = ToMs(now) + ttl_ms_;
+    Shard& shard = ShardOf(client_id);
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(client_id);
+        if (it != shard.entries.end()) {
+            it->second->deadline_ms.store(deadline_ms,
+                                          std::memory_order_relaxed);
+            return it->second->ok.load(std::memory_order_relaxed);
+        }
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.entries.try_emplace(client_id);
+        if (!inserted) {
+            it->second->deadline_ms.store(deadline_ms,
+                                          std::memory_order_relaxed);
+            return it->second->ok.load(std::memory_order_relaxed);
+        }
+        it->second = std::make_unique<Entry>();
+        it->second->deadline_ms.store(deadline_ms, std::memory_order_relaxed);
+    }
+    Schedule(client_id, deadline_ms);
+    return false;
+}
+
+bool ClientLeaseTable::IsOk(const UUID& client_id) const {
+    Shard& shard = ShardOf(client_id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(client_id);
+    return it != shard.entries.end() &&
+           it->second->ok.load(std::memory_order_relaxed);
+}
+
+bool ClientLeaseTable::SetOk(const UUID& client_id) {
+    Shard& shard = ShardOf(client_id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(client_id);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    return !it->second->ok.exchange(true, std::memory_order_relaxed);
+}
+
+size_t ClientLeaseTable::Expire(Clock::time_point now,
+                                std::vector<UUID>& expired) {
+    const int64_t now_ms = ToMs(now);
+    const int64_t now_tick = now_ms / tick_ms_;
+    int64_t first_tick;
+    {
+        std::lock_guard<std::mutex> lock(wheel_mutex_);
+        if (now_tick <= last_tick_) {
+            return 0;
+        }
+        // After a long stall every bucket is due, visit each once
+        const int64_t num_buckets = wheel_.size();
+        first_tick = std::max(last_tick_ + 1, now_tick - num_buckets + 1);
+        // Leases started from now on land in buckets after now_tick
+        last_tick_ = now_tick;
+    }
+
+    size_t num_ok = 0;
+    std::vector<std::pair<UUID, int64_t>> renewed;
+    for (int64_t tick = first_tick; tick <= now_tick; tick++) {
+        std::vector<UUID> due;
+        {
+            std::lock_guard<std::mutex> lock(wheel_mutex_);
+            due.swap(wheel_[tick % wheel_.size()]);
+        }
+        for (const auto& client_id : due) {
+            Shard& shard = ShardOf(client_id);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.entries.find(client_id);
+            if (it == shard.entries.end()) {
+                continue;
+            }
+            int64_t deadline_ms =
+                it->second->deadline_ms.load(std::memory_order_relaxed);
+            if (deadline_ms > now_ms) {
+                renewed.emplace_back(client_id, deadline_ms);
+                continue;
+            }
+            if (it->second->ok.load(std::memory_order_relaxed)) {
+                num_ok++;
+            }
+            shard.entries.erase(it);
+            expired.push_back(client_id);
+        }
+    }
+
+    for (const auto& [client_id, deadline_ms] : renewed) {
+        Schedule(client_id, deadline_ms);
+    }
+    return num_ok;
+}
+
+size_t ClientLeaseTable::Size() const {
+    size_t size = 0;
+    for (const auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        size += shard.entries.size();
+    }
+    return size;
+}
+
+}  // namespace mooncake
@@ -7,6 +7,8 @@
 #include <cstdlib>
 #include <thread>
 
+#include "transfer_latency_metrics.h"
+
 namespace mooncake {
 
 namespace {
@@ -85,6 +87,8 @@ std::unique_ptr<ClientMetric> ClientMetric::Create(
 void ClientMetric::serialize(std::string& str) {
     transfer_metric.serialize(str);
     master_client_metric.serialize(str);
+    // Latencies and queue depths of the transfer engine of the process
+    TransferLatencyMetrics::instance().serialize(str);
 }
 
 std::string ClientMetric::summary_metrics() {
@@ -0,0 +1,154 @@
+#include "client_object_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mooncake {
+
+namespace {
+
+uint64_t TotalSize(const std::vector<Slice>& slices) {
+    uint64_t total = 0;
+    for (const auto& slice : slices) {
+        total += slice.size;
+    }
+    return total;
+}
+
+}  // namespace
+
+ClientObjectCache::ClientObjectCache(size_t capacity, size_t max_object_size)
+    : max_object_size_(std::min(capacity, max_object_size)) {
+    if (capacity > 0 && max_object_size_ > 0) {
+        allocator_ = ClientBufferAllocator::create(capacity);
+    }
+}
+
+std::vector<ReplicaID> ClientObjectCache::CompleteReplicaIds(
+    const std::vector<Replica::Descriptor>& replicas, uint64_t object_size) {
+    std::vector<ReplicaID> ids;
+    for (const auto& replica : replicas) {
+        if (replica.status == ReplicaStatus::COMPLETE &&
+            replica.is_memory_replica() &&
+            calculate_total_size(replica) == object_size) {
+            ids.push_back(replica.id);
+        }
+    }
+    return ids;
+}
+
+bool ClientObjectCache::Read(const std::string& key,
+                             const std::vector<Replica::Descriptor>& replicas,
+                             std::vector<Slice>& slices) {
+    if (!enabled()) {
+        return false;
+    }
+    const uint64_t total_size = TotalSize(slices);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return false;
+    }
+    const CachedObject& cached = *it->second;
+    if (cached.object_size != total_size) {
+        return false;
+    }
+    const auto current_ids = CompleteReplicaIds(replicas, cached.object_size);
+    const bool valid = std::any_of(
+        current_ids.begin(), current_ids.end(), [&cached](ReplicaID id) {
+            return std::find(cached.replica_ids.begin(),
+                             cached.replica_ids.end(),
+                             id) != cached.replica_ids.end();
+        });
+    if (!valid) {
+        // The object was replaced or its replicas are gone
+        EraseLocked(it->second);
+        return false;
+    }
+
+    const char* src = static_cast<const char*>(cached.buffer.ptr());
+    for (auto& slice : slices) {
+        memcpy(slice.ptr, src, slice.size);
+        src += slice.size;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return true;
+}
+
+void ClientObjectCache::Put(const std::string& key,
+                            const std::vector<Replica::Descriptor>& replicas,
+                            const std::vector<Slice>& slices) {
+    if (!enabled()) {
+        return;
+    }
+    const uint64_t object_size = TotalSize(slices);
+    if (object_size == 0 || object_size > max_object_size_) {
+        return;
+    }
+    auto replica_ids = CompleteReplicaIds(replicas, object_size);
+    if (replica_ids.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = entries_.find(key); it != entries_.end()) {
+        EraseLocked(it->second);
+    }
+    auto buffer = allocator_->allocate(object_size);
+    while (!buffer && !lru_.empty()) {
+        EraseLocked(std::prev(lru_.end()));
+        buffer = allocator_->allocate(object_size);
+    }
+    if (!buffer) {
+        return;
+    }
+
+    char* dst = static_cast<char*>(buffer->ptr());
+    for (const auto& slice : slices) {
+        memcpy(dst, slice.ptr, slice.size);
+        dst += slice.size;
+    }
+    lru_.push_front(CachedObject{key, std::move(replica_ids), object_size,
+                                 std::move(*buffer)});
+    entries_[key] = lru_.begin();
+}
+
+void ClientObjectCache::Invalidate(const std::string& key) {
+    if (!enabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = entries_.find(key); it != entries_.end()) {
+        EraseLocked(it->second);
+    }
+}
+
+void ClientObjectCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+}
+
+void ClientObjectCache::SyncView(uint64_t view_version) {
+    if (!enabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (view_version_ && *view_version_ != view_version) {
+        entries_.clear();
+        lru_.clear();
+    }
+    view_version_ = view_version;
+}
+
+size_t ClientObjectCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void ClientObjectCache::EraseLocked(LruList::iterator it) {
+    entries_.erase(it->key);
+    lru_.erase(it);
+}
+
+}  // namespace mooncake
@@ -8,23 +8,107 @@
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <future>
 #include <optional>
 #include <ranges>
 #include <thread>
 #include <set>
+#include <async_simple/Promise.h>
+#include <async_simple/coro/FutureAwaiter.h>
+#include <ylt/coro_io/coro_io.hpp>
 #include <ylt/struct_json/json_reader.h>
 
+#ifdef USE_CUDA
+#include <cuda_runtime.h>
+#endif
+
 #include "transfer_engine.h"
 #include "transfer_task.h"
 #include "transport/transport.h"
 #include "config.h"
 #include "types.h"
+#include "bundle_index.h"
 #include "client_buffer.hpp"
+#include "content_index.h"
+#include "request_trace.h"
 #include "utils.h"
 #include "rpc_types.h"
 
 namespace mooncake {
 
+namespace {
+
+size_t ParseReplicaCacheSize() {
+    const char* size_env = std::getenv("MC_STORE_REPLICA_CACHE_SIZE");
+    if (!size_env) {
+        return 0;
+    }
+    try {
+        size_t size = std::stoull(size_env);
+        LOG(INFO) << "Replica location cache size set to " << size
+                  << " via MC_STORE_REPLICA_CACHE_SIZE";
+        return size;
+    } catch (const std::exception& e) {
+        LOG(WARNING) << "Failed to parse MC_STORE_REPLICA_CACHE_SIZE: "
+                     << size_env << ", disabling replica location cache";
+        return 0;
+    }
+}
+
+// Objects are split into parts of at least this size to be read from
+// several replicas at once
+constexpr uint64_t kDefaultParallelReadMinPartSize = 4 * 1024 * 1024;
+constexpr uint64_t kParallelReadAlignment = 4096;
+
+constexpr uint64_t kDefaultObjectCacheMaxObjectSize = 4 * 1024 * 1024;
+
+// The key filter is synced on every ping, it is ignored once it missed
+// a few syncs
+constexpr auto kKeyFilterMaxAge = std::chrono::seconds(5);
+
+// A put waiting for a concurrent put of the same key polls PutStart with
+// these intervals. The wait lasts as long as the master keeps the put
+// alive by default, see DEFAULT_PUT_START_DISCARD_TIMEOUT.
+constexpr auto kPutWaitMinInterval = std::chrono::milliseconds(5);
+constexpr auto kPutWaitMaxInterval = std::chrono::milliseconds(100);
+// Readers waiting for a pending put poll faster, the put is usually a
+// transfer away from completing
+constexpr auto kQueryWaitMinInterval = std::chrono::milliseconds(1);
+constexpr auto kQueryWaitMaxInterval = std::chrono::milliseconds(20);
+// Puts back off this long until the next ping once a put start found no
+// space, as the master does while eviction has not caught up
+constexpr uint64_t kPutRejectedBackoffMs = 100;
+constexpr uint64_t kDefaultPutWaitTimeoutMs =
+    DEFAULT_PUT_START_DISCARD_TIMEOUT * 1000;
+
+constexpr uint64_t kDefaultHedgedReadMaxSize = 1024 * 1024;
+constexpr uint64_t kDefaultHedgedReadBufferSize = 64 * 1024 * 1024;
+constexpr auto kHedgedReadPollInterval = std::chrono::microseconds(10);
+
+// The content key is hashed on the CPU, slices in device memory are put as
+// they are
+bool IsHostMemory(const std::vector<Slice>& slices) {
+#ifdef USE_CUDA
+    for (const auto& slice : slices) {
+        cudaPointerAttributes attributes;
+        if (cudaPointerGetAttributes(&attributes, slice.ptr) != cudaSuccess) {
+            cudaGetLastError();  // clear the error of unregistered memory
+            continue;
+        }
+        if (attributes.type == cudaMemoryTypeDevice ||
+            attributes.type == cudaMemoryTypeManaged) {
+            return false;
+        }
+    }
+#else
+    (void)slices;
+#endif
+    return true;
+}
+
+}  // namespace
+
 [[nodiscard]] size_t CalculateSliceSize(const std::vector<Slice>& slices) {
     size_t slice_size = 0;
     for (const auto& slice : slices) {
@@ -44,18 +128,61 @@ namespace mooncake {
 Client::Client(const std::string& local_hostname,
                const std::string& metadata_connstring,
                const std::string& protocol,
-               const std::map<std::string, std::string>& labels)
-    : client_id_(generate_uuid()),
+               const std::map<std::string, std::string>& labels,
+               const std::optional<UUID>& client_id)
+    : client_id_(client_id.value_or(generate_uuid())),
       metrics_(ClientMetric::Create(merge_labels(labels))),
       master_client_(client_id_,
                      metrics_ ? &metrics_->master_client_metric : nullptr),
+      completion_queue_(std::make_unique<TransferCompletionQueue>()),
+      replica_location_cache_(ParseReplicaCacheSize()),
+      replica_cache_lookahead_(
+          GetEnvOr<uint64_t>("MC_STORE_REPLICA_CACHE_LOOKAHEAD", 0)),
+      object_cache_(GetEnvOr<uint64_t>("MC_STORE_OBJECT_CACHE_SIZE", 0),
+                    GetEnvOr<uint64_t>("MC_STORE_OBJECT_CACHE_MAX_OBJECT_SIZE",
+                                       kDefaultObjectCacheMaxObjectSize)),
+      key_filter_enabled_(GetEnvOr<int>("MC_STORE_KEY_FILTER", 0) != 0),
+      parallel_read_min_part_size_(
+          GetEnvOr<uint64_t>("MC_STORE_PARALLEL_READ_MIN_PART_SIZE",
+                             kDefaultParallelReadMinPartSize)),
+      batch_put_pipeline_size_(
+          GetEnvOr<uint64_t>("MC_STORE_BATCH_PUT_PIPELINE_SIZE", 0)),
+      hedged_read_max_size_(GetEnvOr<uint64_t>(
+          "MC_STORE_HEDGED_READ_MAX_SIZE", kDefaultHedgedReadMaxSize)),
+      dedup_enabled_(GetEnvOr<int>("MC_STORE_DEDUP", 0) != 0),
+      put_wait_timeout_(GetEnvOr<uint64_t>("MC_STORE_PUT_WAIT_TIMEOUT_MS",
+                                           kDefaultPutWaitTimeoutMs)),
       local_hostname_(local_hostname),
       metadata_connstring_(metadata_connstring),
       protocol_(protocol),
       write_thread_pool_(2),
-      task_thread_pool_(4) {
+      task_thread_pool_(4),
+      prefetch_thread_pool_(
+          std::max<size_t>(GetEnvOr<size_t>("MC_STORE_PREFETCH_THREADS", 2),
+                           1)) {
     LOG(INFO) << "client_id=" << client_id_;
 
+    if (GetEnvStringOr("MC_STORE_REPLICA_SELECTION", "first") == "fastest") {
+        const auto ttl = std::chrono::milliseconds(
+            GetEnvOr<uint64_t>("MC_STORE_REPLICA_SPEED_TTL_MS", 10000));
+        replica_speed_ = std::make_unique<ReplicaSpeedTracker>(ttl);
+        LOG(INFO) << "Fastest replica selection enabled, ttl_ms="
+                  << ttl.count();
+    }
+
+    const int hedge_percentile =
+        GetEnvOr<int>("MC_STORE_HEDGED_READ_PERCENTILE", 0);
+    if (hedge_percentile > 0) {
+        hedge_delay_ = std::make_unique<LatencyPercentile>(hedge_percentile);
+        hedge_reaper_pool_ = std::make_unique<ThreadPool>(1);
+        LOG(INFO) << "Hedged reads enabled, percentile=" << hedge_percentile
+                  << ", max_size=" << hedged_read_max_size_;
+    }
+
+    if (dedup_enabled_) {
+        LOG(INFO) << "Content-addressed deduplication of puts enabled";
+    }
+
     if (metrics_) {
         if (metrics_->GetReportingInterval() > 0) {
             LOG(INFO) << "Client metrics enabled with reporting thread started "
@@ -72,6 +199,13 @@ Client::Client(const std::string& local_hostname,
 }
 
 Client::~Client() {
+    // Completes the pending asynchronous operations
+    completion_queue_.reset();
+
+    // Promotions copy into the mounted segments, the queued ones are dropped
+    prefetch_running_ = false;
+    prefetch_thread_pool_.stop();
+
     // Make a copy of mounted_segments_ to avoid modifying while iterating
     std::vector<Segment> segments_to_unmount;
     {
@@ -101,13 +235,33 @@ Client::~Client() {
     task_running_ = false;
     task_thread_pool_.stop();
 
+    if (master_view_subscription_) {
+        MasterViewWatcher::Instance().Unsubscribe(*master_view_subscription_);
+        master_view_subscription_.reset();
+    }
+
     // Stop ping thread only after no need to contact master anymore
     if (ping_running_) {
-        ping_running_ = false;
+        {
+            std::lock_guard<std::mutex> lock(ping_mutex_);
+            ping_running_ = false;
+        }
+        ping_cv_.notify_all();
         if (ping_thread_.joinable()) {
             ping_thread_.join();
         }
     }
+
+    // Wait for the losing hedged reads before unregistering their buffers
+    hedge_reaper_pool_.reset();
+    if (hedge_buffer_allocator_) {
+        auto result =
+            unregisterLocalMemory(hedge_buffer_allocator_->getBase(), true);
+        if (!result) {
+            LOG(ERROR) << "Failed to unregister hedged read buffer: "
+                       << toString(result.error());
+        }
+    }
 }
 
 static std::optional<bool> get_auto_discover() {
@@ -211,6 +365,23 @@ ErrorCode Client::ConnectToMaster(const std::string& master_server_entry) {
             return err;
         }
 
+        // Calls that fail during a failover are retried against the new
+        // leader. Failover takes up to twice the lease TTL of the leader.
+        master_client_.SetFailoverTimeout(
+            std::chrono::milliseconds(GetEnvOr<uint64_t>(
+                "MC_STORE_FAILOVER_TIMEOUT_MS",
+                3 * ETCD_MASTER_VIEW_LEASE_TTL * 1000)));
+        // Move to a new leader as soon as it is elected, instead of after
+        // several failed pings
+        master_view_subscription_ = MasterViewWatcher::Instance().Subscribe(
+            [this](const std::string& new_master_address, ViewVersionId) {
+                {
+                    std::lock_guard<std::mutex> lock(ping_mutex_);
+                    next_master_address_ = new_master_address;
+                }
+                ping_cv_.notify_all();
+            });
+
         // Start ping thread to monitor master health and trigger remount if
         // needed.
         ping_running_ = true;
@@ -244,9 +415,15 @@ ErrorCode Client::InitTransferEngine(
     const std::string& protocol,
     const std::optional<std::string>& device_names) {
     // Check if using TENT mode - TENT handles transport configuration
-    // internally
-    bool use_tent = (std::getenv("MC_USE_TENT") != nullptr) ||
-                    (std::getenv("MC_USE_TEV1") != nullptr);
+    // internally. Ask the engine, since only builds with USE_TENT honor
+    // MC_USE_TENT.
+    bool use_tent = transfer_engine_->isUsingTent();
+    if (!use_tent && (std::getenv("MC_USE_TENT") != nullptr ||
+                      std::getenv("MC_USE_TEV1") != nullptr)) {
+        LOG(WARNING) << "MC_USE_TENT is set but the transfer engine is built "
+                        "without TENT (-DUSE_TENT=ON); using the classic "
+                        "transfer engine";
+    }
 
     bool auto_discover = false;
     if (!use_tent) {
@@ -282,6 +459,15 @@ ErrorCode Client::InitTransferEngine(
                     << "ignoring whitelist: " << env_filters;
             }
         }
+    } else {
+        // TENT always discovers the topology; the devices (or MC_MS_FILTERS)
+        // only restrict the NICs its scheduler may pick
+        auto filters =
+            device_names.has_value()
+                ? splitString(device_names.value(), ',', /*skip_empty=*/true)
+                : get_auto_discover_filters();
+        if (!filters.empty())
+            transfer_engine_->setWhitelistFilters(std::move(filters));
     }
 
     if (protocol == "ascend") {
@@ -304,12 +490,6 @@ ErrorCode Client::InitTransferEngine(
     if (use_tent) {
         LOG(INFO)
             << "Using TENT mode - transport configuration handled internally";
-        if (device_names.has_value()) {
-            LOG(INFO)
-                << "Note: device_names parameter is ignored in TENT mode. "
-                << "Configure devices via TENT config file or environment "
-                   "variables.";
-        }
         return ErrorCode::OK;
     }
 
@@ -415,7 +595,22 @@ void Client::InitTransferSubmitter() {
     // used separately where needed.
     transfer_submitter_ = std::make_unique<TransferSubmitter>(
         *transfer_engine_, storage_backend_,
-        metrics_ ? &metrics_->transfer_metric : nullptr);
+        metrics_ ? &metrics_->transfer_metric : nullptr, &transferred_bytes_);
+
+    if (hedge_delay_) {
+        const uint64_t size = GetEnvOr<uint64_t>(
+            "MC_STORE_HEDGED_READ_BUFFER_SIZE", kDefaultHedgedReadBufferSize);
+        hedge_buffer_allocator_ =
+            ClientBufferAllocator::create(size, protocol_);
+        auto result = RegisterLocalMemory(hedge_buffer_allocator_->getBase(),
+                                          size, kWildcardLocation, false, true);
+        if (!result) {
+            // Reads are not hedged without staging buffers
+            LOG(ERROR) << "Failed to register hedged read buffer, size="
+                       << size << ", error=" << toString(result.error());
+            hedge_buffer_allocator_.reset();
+        }
+    }
 }
 
 std::optional<std::shared_ptr<Client>> Client::Create(
@@ -423,9 +618,10 @@ std::optional<std::shared_ptr<Client>> Client::Create(
     const std::string& protocol, const std::optional<std::string>& device_names,
     const std::string& master_server_entry,
     const std::shared_ptr<TransferEngine>& transfer_engine,
-    std::map<std::string, std::string> labels) {
-    auto client = std::shared_ptr<Client>(
-        new Client(local_hostname, metadata_connstring, protocol, labels));
+    std::map<std::string, std::string> labels,
+    const std::optional<UUID>& client_id) {
+    auto client = std::shared_ptr<Client>(new Client(
+        local_hostname, metadata_connstring, protocol, labels, client_id));
 
     ErrorCode err = client->ConnectToMaster(master_server_entry);
     if (err != ErrorCode::OK) {
@@ -513,11 +709,18 @@ std::optional<std::shared_ptr<Client>> Client::Create(
 
 tl::expected<void, ErrorCode> Client::Get(const std::string& object_key,
                                           std::vector<Slice>& slices) {
+    TraceSpan span("Client::Get", TraceSpan::Kind::ROOT);
+    span.SetAttribute("key", object_key);
     auto query_result = Query(object_key);
     if (!query_result) {
+        span.SetAttribute("error", toString(query_result.error()));
         return tl::unexpected(query_result.error());
     }
-    return Get(object_key, query_result.value(), slices);
+    auto result = Get(object_key, query_result.value(), slices);
+    if (!result) {
+        span.SetAttribute("error", toString(result.error()));
+    }
+    return result;
 }
 
 std::vector<tl::expected<void, ErrorCode>> Client::BatchGet(
@@ -585,19 +788,58 @@ Client::QueryByRegex(const std::string& str) {
 
 tl::expected<QueryResult, ErrorCode> Client::Query(
     const std::string& object_key) {
+    TraceSpan span("Client::Query", TraceSpan::Kind::ROOT);
+    if (auto cached = replica_location_cache_.Get(object_key)) {
+        span.SetAttribute("cached", int64_t{1});
+        return QueryResult(std::move(cached->replicas), cached->lease_timeout);
+    }
+    if (replica_location_cache_.enabled() && replica_cache_lookahead_ > 0) {
+        return std::move(
+            BatchQueryWithCache({object_key}, replica_cache_lookahead_)[0]);
+    }
+    const uint64_t cache_generation = replica_location_cache_.generation();
     std::chrono::steady_clock::time_point start_time =
         std::chrono::steady_clock::now();
     auto result = master_client_.GetReplicaList(object_key);
     if (!result) {
         return tl::unexpected(result.error());
     }
-    return QueryResult(
-        std::move(result.value().replicas),
-        start_time + std::chrono::milliseconds(result.value().lease_ttl_ms));
+    const auto lease_timeout =
+        start_time + std::chrono::milliseconds(result.value().lease_ttl_ms);
+    replica_location_cache_.Put(object_key, cache_generation,
+                                result.value().replicas, start_time,
+                                lease_timeout);
+    return QueryResult(std::move(result.value().replicas), lease_timeout);
+}
+
+tl::expected<QueryResult, ErrorCode> Client::QueryWait(
+    const std::string& object_key, std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto interval = kQueryWaitMinInterval;
+    // QueryResult cannot be assigned, so each attempt returns its own
+    while (true) {
+        auto result = Query(object_key);
+        if (result || result.error() != ErrorCode::REPLICA_IS_NOT_READY) {
+            return result;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            VLOG(1) << "key=" << object_key
+                    << ", timeout_ms=" << timeout.count()
+                    << ", error=pending_put_not_finished";
+            return result;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(
+            interval, deadline - now));
+        interval = std::min(interval * 2, kQueryWaitMaxInterval);
+    }
 }
 
 std::vector<tl::expected<QueryResult, ErrorCode>> Client::BatchQuery(
     const std::vector<std::string>& object_keys) {
+    if (replica_location_cache_.enabled()) {
+        return BatchQueryWithCache(object_keys, replica_cache_lookahead_);
+    }
     std::chrono::steady_clock::time_point start_time =
         std::chrono::steady_clock::now();
     auto response = master_client_.BatchGetReplicaList(object_keys);
@@ -629,6 +871,83 @@ std::vector<tl::expected<QueryResult, ErrorCode>> Client::BatchQuery(
     return results;
 }
 
+std::vector<tl::expected<QueryResult, ErrorCode>>
+Client::BatchQueryWithCache(const std::vector<std::string>& object_keys,
+                            size_t lookahead) {
+    std::vector<std::optional<tl::expected<QueryResult, ErrorCode>>> results(
+        object_keys.size());
+    std::vector<std::string> missed_keys;
+    std::vector<size_t> missed_indices;
+    for (size_t i = 0; i < object_keys.size(); ++i) {
+        if (auto cached = replica_location_cache_.Get(object_keys[i])) {
+            results[i].emplace(QueryResult(std::move(cached->replicas),
+                                           cached->lease_timeout));
+        } else {
+            missed_keys.emplace_back(object_keys[i]);
+            missed_indices.emplace_back(i);
+        }
+    }
+
+    // Successors are only cached, the misses come first in missed_keys
+    const size_t num_missed = missed_keys.size();
+    if (num_missed > 0 && lookahead > 0) {
+        const std::unordered_set<std::string> requested(object_keys.begin(),
+                                                        object_keys.end());
+        for (auto& key : ChainSuccessorKeys(object_keys.back(), lookahead)) {
+            if (!requested.contains(key) &&
+                !replica_location_cache_.Get(key)) {
+                missed_keys.emplace_back(std::move(key));
+            }
+        }
+    }
+
+    if (!missed_keys.empty()) {
+        const uint64_t cache_generation =
+            replica_location_cache_.generation();
+        std::chrono::steady_clock::time_point start_time =
+            std::chrono::steady_clock::now();
+        auto response = master_client_.BatchGetReplicaList(missed_keys);
+        if (response.size() != missed_keys.size()) {
+            LOG(ERROR) << "BatchQuery response size mismatch. Expected: "
+                       << missed_keys.size() << ", Got: " << response.size();
+        }
+        for (size_t i = 0; i < missed_keys.size(); ++i) {
+            if (i >= num_missed) {
+                if (i < response.size() && response[i]) {
+                    replica_location_cache_.Put(
+                        missed_keys[i], cache_generation,
+                        response[i].value().replicas, start_time,
+                        start_time + std::chrono::milliseconds(
+                                         response[i].value().lease_ttl_ms));
+                }
+                continue;
+            }
+            auto& result = results[missed_indices[i]];
+            if (i >= response.size()) {
+                result.emplace(tl::unexpected(ErrorCode::RPC_FAIL));
+            } else if (!response[i]) {
+                result.emplace(tl::unexpected(response[i].error()));
+            } else {
+                const auto lease_timeout =
+                    start_time +
+                    std::chrono::milliseconds(response[i].value().lease_ttl_ms);
+                replica_location_cache_.Put(missed_keys[i], cache_generation,
+                                            response[i].value().replicas,
+                                            start_time, lease_timeout);
+                result.emplace(QueryResult(
+                    std::move(response[i].value().replicas), lease_timeout));
+            }
+        }
+    }
+
+    std::vector<tl::expected<QueryResult, ErrorCode>> query_results;
+    query_results.reserve(results.size());
+    for (auto& result : results) {
+        query_results.emplace_back(std::move(*result));
+    }
+    return query_results;
+}
+
 tl::expected<std::vector<std::string>, ErrorCode> Client::BatchReplicaClear(
     const std::vector<std::string>& object_keys, const UUID& client_id,
     const std::string& segment_name) {
@@ -640,9 +959,17 @@ tl::expected<std::vector<std::string>, ErrorCode> Client::BatchReplicaClear(
 tl::expected<void, ErrorCode> Client::Get(const std::string& object_key,
                                           const QueryResult& query_result,
                                           std::vector<Slice>& slices) {
-    // Find the first complete replica
     Replica::Descriptor replica;
-    ErrorCode err = FindFirstCompleteReplica(query_result.replicas, replica);
+    ErrorCode err;
+    {
+        TraceSpan span("Client::SelectReplica");
+        err = SelectReplica(query_result.replicas, replica);
+        if (span.active() && replica.is_memory_replica()) {
+            span.SetAttribute("endpoint", replica.get_memory_descriptor()
+                                              .buffer_descriptor
+                                              .transport_endpoint_);
+        }
+    }
     if (err != ErrorCode::OK) {
         if (err == ErrorCode::INVALID_REPLICA) {
             LOG(ERROR) << "no_complete_replicas_found key=" << object_key;
@@ -650,11 +977,33 @@ tl::expected<void, ErrorCode> Client::Get(const std::string& object_key,
         return tl::unexpected(err);
     }
 
+    // Local replicas are read with a memcpy anyway
+    const bool cacheable =
+        object_cache_.enabled() && !IsReplicaOnLocalMemory(replica);
+    if (cacheable &&
+        object_cache_.Read(object_key, query_result.replicas, slices)) {
+        if (metrics_) {
+            metrics_->transfer_metric.object_cache_hits.inc();
+        }
+        return {};
+    }
+
     auto t0_get = std::chrono::steady_clock::now();
-    err = TransferRead(replica, slices);
+    auto parts = SplitRead(query_result.replicas, slices);
+    std::optional<ErrorCode> hedged;
+    if (!parts.empty()) {
+        err = TransferReadParts(parts);
+    } else if ((hedged = HedgedRead(query_result.replicas, slices))) {
+        err = *hedged;
+    } else {
+        err = TransferRead(replica, slices);
+    }
     auto us_get = std::chrono::duration_cast<std::chrono::microseconds>(
                       std::chrono::steady_clock::now() - t0_get)
                       .count();
+    if (parts.empty() && !hedged) {
+        RecordReplicaRead(replica, err, us_get);
+    }
     if (metrics_) {
         metrics_->transfer_metric.get_latency_us.observe(us_get);
     }
@@ -668,9 +1017,447 @@ tl::expected<void, ErrorCode> Client::Get(const std::string& object_key,
                      << object_key;
         return tl::unexpected(ErrorCode::LEASE_EXPIRED);
     }
+    if (cacheable) {
+        if (metrics_) {
+            metrics_->transfer_metric.object_cache_misses.inc();
+        }
+        object_cache_.Put(object_key, query_result.replicas, slices);
+    }
+    return {};
+}
+
+tl::expected<void, ErrorCode> Client::GetRanges(
+    const std::string& object_key, const QueryResult& query_result,
+    const std::vector<ObjectRange>& ranges) {
+    Replica::Descriptor replica;
+    ErrorCode err = SelectReplica(query_result.replicas, replica);
+    if (err != ErrorCode::OK) {
+        if (err == ErrorCode::INVALID_REPLICA) {
+            LOG(ERROR) << "no_complete_replicas_found key=" << object_key;
+        }
+        return tl::unexpected(err);
+    }
+    if (replica.is_disk_replica()) {
+        return GetDiskRanges(object_key, query_result, replica, ranges);
+    }
+    if (!replica.is_memory_replica()) {
+        LOG(ERROR) << "range_read_unsupported_replica key=" << object_key;
+        return tl::unexpected(ErrorCode::INVALID_REPLICA);
+    }
+    auto result =
+        TransferRanges(object_key, replica, ranges, TransferRequest::READ);
+    if (!result) {
+        return result;
+    }
+    if (query_result.IsLeaseExpired()) {
+        LOG(WARNING) << "lease_expired_before_data_transfer_completed key="
+                     << object_key;
+        return tl::unexpected(ErrorCode::LEASE_EXPIRED);
+    }
+    return {};
+}
+
+tl::expected<std::vector<Replica::Descriptor>, ErrorCode>
+Client::ChunkedPutStart(const ObjectKey& key, size_t size,
+                        const ReplicateConfig& config) {
+    auto start_result = PutStartOrWait(key, {size}, config);
+    if (!start_result) {
+        return start_result;
+    }
+    for (const auto& replica : start_result.value()) {
+        if (replica.is_striped_replica()) {
+            LOG(ERROR) << "chunked_put_unsupported_replica key=" << key;
+            auto revoke_result = ChunkedPutRevoke(key, start_result.value());
+            if (!revoke_result) {
+                return tl::unexpected(revoke_result.error());
+            }
+            return tl::unexpected(ErrorCode::INVALID_REPLICA);
+        }
+    }
+    return start_result;
+}
+
+tl::expected<void, ErrorCode> Client::ChunkedPutAppend(
+    const ObjectKey& key, const std::vector<Replica::Descriptor>& replicas,
+    uint64_t offset, const Slice& chunk) {
+    const std::vector<ObjectRange> ranges{{offset, chunk}};
+    for (const auto& replica : replicas) {
+        if (!replica.is_memory_replica()) {
+            continue;
+        }
+        auto result =
+            TransferRanges(key, replica, ranges, TransferRequest::WRITE);
+        if (!result) {
+            return result;
+        }
+    }
+    return master_client_.PutCommit(key, offset + chunk.size);
+}
+
+namespace {
+
+bool HasDiskReplica(const std::vector<Replica::Descriptor>& replicas) {
+    return std::any_of(replicas.begin(), replicas.end(),
+                       [](const Replica::Descriptor& replica) {
+                           return replica.is_disk_replica();
+                       });
+}
+
+}  // namespace
+
+tl::expected<void, ErrorCode> Client::ChunkedPutEnd(
+    const ObjectKey& key, const std::vector<Replica::Descriptor>& replicas) {
+    // Chunks are not written to the storage backend
+    if (HasDiskReplica(replicas)) {
+        auto revoke_result = master_client_.PutRevoke(key, ReplicaType::DISK);
+        if (!revoke_result) {
+            LOG(WARNING) << "Failed to revoke disk replica of chunked put key="
+                         << key << ": " << revoke_result.error();
+        }
+    }
+    return master_client_.PutEnd(key, ReplicaType::MEMORY);
+}
+
+tl::expected<void, ErrorCode> Client::ChunkedPutRevoke(
+    const ObjectKey& key, const std::vector<Replica::Descriptor>& replicas) {
+    if (HasDiskReplica(replicas)) {
+        auto revoke_result = master_client_.PutRevoke(key, ReplicaType::DISK);
+        if (!revoke_result) {
+            LOG(WARNING) << "Failed to revoke disk replica of chunked put key="
+                         << key << ": " << revoke_result.error();
+        }
+    }
+    return master_client_.PutRevoke(key, ReplicaType::MEMORY);
+}
+
+tl::expected<Client::CommittedQueryResult, ErrorCode> Client::WaitCommitted(
+    const std::string& object_key, uint64_t min_bytes,
+    std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto interval = kQueryWaitMinInterval;
+    while (true) {
+        const auto start_time = std::chrono::steady_clock::now();
+        auto result = master_client_.GetCommittedReplicaList(object_key);
+        if (result &&
+            (result->complete || result->committed_bytes >= min_bytes)) {
+            return CommittedQueryResult{
+                std::move(result->replicas), result->committed_bytes,
+                result->complete,
+                start_time + std::chrono::milliseconds(result->lease_ttl_ms)};
+        }
+        // The writer may not have started, or committed enough, yet
+        if (!result && result.error() != ErrorCode::REPLICA_IS_NOT_READY &&
+            result.error() != ErrorCode::OBJECT_NOT_FOUND) {
+            return tl::unexpected(result.error());
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            VLOG(1) << "key=" << object_key << ", min_bytes=" << min_bytes
+                    << ", timeout_ms=" << timeout.count()
+                    << ", error=bytes_not_committed";
+            return tl::unexpected(result ? ErrorCode::REPLICA_IS_NOT_READY
+                                         : result.error());
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(
+            interval, deadline - now));
+        interval = std::min(interval * 2, kQueryWaitMaxInterval);
+    }
+}
+
+tl::expected<void, ErrorCode> Client::GetCommittedRanges(
+    const std::string& object_key, const CommittedQueryResult& committed,
+    const std::vector<ObjectRange>& ranges) {
+    if (committed.complete) {
+        return GetRanges(object_key,
+                         QueryResult(std::vector<Replica::Descriptor>(
+                                         committed.replicas),
+                                     committed.lease_timeout),
+                         ranges);
+    }
+    for (const auto& range : ranges) {
+        if (range.offset > committed.committed_bytes ||
+            range.slice.size > committed.committed_bytes - range.offset) {
+            LOG(ERROR) << "range_not_committed key=" << object_key
+                       << " offset=" << range.offset
+                       << " size=" << range.slice.size
+                       << " committed_bytes=" << committed.committed_bytes;
+            return tl::unexpected(ErrorCode::INVALID_PARAMS);
+        }
+    }
+    // Every memory replica holds the committed bytes
+    auto replica = std::find_if(committed.replicas.begin(),
+                                committed.replicas.end(),
+                                [](const Replica::Descriptor& replica) {
+                                    return replica.is_memory_replica();
+                                });
+    if (replica == committed.replicas.end()) {
+        LOG(ERROR) << "no_memory_replica_found key=" << object_key;
+        return tl::unexpected(ErrorCode::INVALID_REPLICA);
+    }
+    return TransferRanges(object_key, *replica, ranges, TransferRequest::READ);
+}
+
+tl::expected<void, ErrorCode> Client::TransferRanges(
+    const std::string& object_key, const Replica::Descriptor& replica,
+    const std::vector<ObjectRange>& ranges, TransferRequest::OpCode op_code) {
+    if (!transfer_submitter_) {
+        LOG(ERROR) << "TransferSubmitter not initialized";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    // Each range is transferred with a replica narrowed to its bytes
+    const auto& buffer = replica.get_memory_descriptor().buffer_descriptor;
+    std::vector<Replica::Descriptor> range_replicas;
+    std::vector<std::vector<Slice>> range_slices;
+    range_replicas.reserve(ranges.size());
+    range_slices.reserve(ranges.size());
+    for (const auto& range : ranges) {
+        if (range.offset > buffer.size_ ||
+            range.slice.size > buffer.size_ - range.offset) {
+            LOG(ERROR) << "range_out_of_object key=" << object_key
+                       << " offset=" << range.offset
+                       << " size=" << range.slice.size
+                       << " object_size=" << buffer.size_;
+            return tl::unexpected(ErrorCode::INVALID_PARAMS);
+        }
+        if (range.slice.size == 0) {
+            continue;
+        }
+        auto& range_replica = range_replicas.emplace_back(replica);
+        auto& range_buffer =
+            range_replica.get_memory_descriptor().buffer_descriptor;
+        range_buffer.buffer_address_ += range.offset;
+        range_buffer.size_ = range.slice.size;
+        range_slices.push_back({range.slice});
+    }
+    if (range_replicas.empty()) {
+        return {};
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto future = transfer_submitter_->submit_batch(range_replicas,
+                                                    range_slices, op_code);
+    const ErrorCode err = future ? future->get() : ErrorCode::TRANSFER_FAIL;
+    if (metrics_ && op_code == TransferRequest::READ) {
+        metrics_->transfer_metric.get_latency_us.observe(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - t0)
+                .count());
+    }
+    if (err != ErrorCode::OK) {
+        LOG(ERROR) << "range_transfer_failed key=" << object_key
+                   << " op_code=" << static_cast<int>(op_code);
+        return tl::unexpected(err);
+    }
+    return {};
+}
+
+tl::expected<void, ErrorCode> Client::GetDiskRanges(
+    const std::string& object_key, const QueryResult& query_result,
+    const Replica::Descriptor& replica,
+    const std::vector<ObjectRange>& ranges) {
+    if (!storage_backend_) {
+        LOG(ERROR) << "storage_backend_not_initialized key=" << object_key;
+        return tl::unexpected(ErrorCode::INVALID_REPLICA);
+    }
+    const auto& disk = replica.get_disk_descriptor();
+    for (const auto& range : ranges) {
+        if (range.offset > disk.object_size ||
+            range.slice.size > disk.object_size - range.offset) {
+            LOG(ERROR) << "range_out_of_object key=" << object_key
+                       << " offset=" << range.offset
+                       << " size=" << range.slice.size
+                       << " object_size=" << disk.object_size;
+            return tl::unexpected(ErrorCode::INVALID_PARAMS);
+        }
+    }
+    for (const auto& range : ranges) {
+        if (range.slice.size == 0) {
+            continue;
+        }
+        auto result = storage_backend_->LoadObjectRange(
+            disk.file_path, {range.slice}, range.offset);
+        if (!result) {
+            LOG(ERROR) << "file_range_read_failed key=" << object_key;
+            return tl::unexpected(result.error());
+        }
+    }
+    if (query_result.IsLeaseExpired()) {
+        LOG(WARNING) << "lease_expired_before_data_transfer_completed key="
+                     << object_key;
+        return tl::unexpected(ErrorCode::LEASE_EXPIRED);
+    }
     return {};
 }
 
+namespace {
+
+// Callback fulfilling the future of an asynchronous operation
+Client::AsyncCallback MakePromiseCallback(Client::AsyncResult& future) {
+    auto promise =
+        std::make_shared<std::promise<tl::expected<void, ErrorCode>>>();
+    future = promise->get_future();
+    return [promise](tl::expected<void, ErrorCode> result) {
+        promise->set_value(std::move(result));
+    };
+}
+
+}  // namespace
+
+void Client::AsyncGet(const std::string& object_key,
+                      std::vector<Slice>& slices, AsyncCallback callback) {
+    auto query_result = Query(object_key);
+    if (!query_result) {
+        callback(tl::unexpected(query_result.error()));
+        return;
+    }
+    AsyncGet(object_key, query_result.value(), slices, std::move(callback));
+}
+
+void Client::AsyncGet(const std::string& object_key,
+                      const QueryResult& query_result,
+                      std::vector<Slice>& slices, AsyncCallback callback) {
+    Replica::Descriptor replica;
+    ErrorCode err = SelectReplica(query_result.replicas, replica);
+    if (err != ErrorCode::OK) {
+        if (err == ErrorCode::INVALID_REPLICA) {
+            LOG(ERROR) << "no_complete_replicas_found key=" << object_key;
+        }
+        callback(tl::unexpected(err));
+        return;
+    }
+
+    auto t0_get = std::chrono::steady_clock::now();
+    auto future = SubmitRead(replica, slices);
+    if (!future) {
+        LOG(ERROR) << "transfer_read_failed key=" << object_key;
+        callback(tl::unexpected(future.error()));
+        return;
+    }
+    std::vector<TransferFuture> futures;
+    futures.emplace_back(std::move(*future));
+    completion_queue_->Add(
+        std::move(futures),
+        [this, object_key, replica, t0_get,
+         lease_timeout = query_result.lease_timeout,
+         callback = std::move(callback)](ErrorCode err) {
+            auto now = std::chrono::steady_clock::now();
+            const auto us_get =
+                std::chrono::duration_cast<std::chrono::microseconds>(now -
+                                                                      t0_get)
+                    .count();
+            if (metrics_) {
+                metrics_->transfer_metric.get_latency_us.observe(us_get);
+            }
+            RecordReplicaRead(replica, err, us_get);
+            if (err != ErrorCode::OK) {
+                LOG(ERROR) << "transfer_read_failed key=" << object_key;
+                callback(tl::unexpected(err));
+            } else if (now >= lease_timeout) {
+                LOG(WARNING)
+                    << "lease_expired_before_data_transfer_completed key="
+                    << object_key;
+                callback(tl::unexpected(ErrorCode::LEASE_EXPIRED));
+            } else {
+                callback({});
+            }
+        });
+}
+
+Client::AsyncResult Client::AsyncGet(const std::string& object_key,
+                                     std::vector<Slice>& slices) {
+    AsyncResult future;
+    AsyncGet(object_key, slices, MakePromiseCallback(future));
+    return future;
+}
+
+std::vector<Client::AsyncResult> Client::AsyncBatchGet(
+    const std::vector<std::string>& object_keys,
+    std::unordered_map<std::string, std::vector<Slice>>& slices) {
+    auto query_results = BatchQuery(object_keys);
+    std::vector<AsyncResult> futures(object_keys.size());
+    for (size_t i = 0; i < object_keys.size(); ++i) {
+        auto callback = MakePromiseCallback(futures[i]);
+        auto it = slices.find(object_keys[i]);
+        if (i >= query_results.size() || it == slices.end()) {
+            callback(tl::unexpected(ErrorCode::INVALID_PARAMS));
+        } else if (!query_results[i]) {
+            callback(tl::unexpected(query_results[i].error()));
+        } else {
+            AsyncGet(object_keys[i], query_results[i].value(), it->second,
+                     std::move(callback));
+        }
+    }
+    return futures;
+}
+
+namespace {
+
+// Delivers results completed in any order to a StreamCallback in index order
+class InOrderDelivery {
+   public:
+    InOrderDelivery(size_t count, Client::StreamCallback callback)
+        : results_(count), callback_(std::move(callback)) {}
+
+    void Complete(size_t index, tl::expected<void, ErrorCode> result) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        results_[index] = std::move(result);
+        // A single thread runs the callbacks at a time, which keeps them in
+        // order without holding the lock while they run.
+        if (delivering_) {
+            return;
+        }
+        delivering_ = true;
+        while (next_ < results_.size() && results_[next_].has_value()) {
+            const size_t index_to_deliver = next_++;
+            auto result_to_deliver = std::move(*results_[index_to_deliver]);
+            lock.unlock();
+            callback_(index_to_deliver, std::move(result_to_deliver));
+            lock.lock();
+        }
+        delivering_ = false;
+    }
+
+   private:
+    std::mutex mutex_;
+    std::vector<std::optional<tl::expected<void, ErrorCode>>> results_;
+    size_t next_{0};
+    bool delivering_{false};
+    Client::StreamCallback callback_;
+};
+
+}  // namespace
+
+void Client::StreamingBatchGet(
+    const std::vector<std::string>& object_keys,
+    std::unordered_map<std::string, std::vector<Slice>>& slices,
+    StreamCallback callback) {
+    StreamingBatchGet(object_keys, BatchQuery(object_keys), slices,
+                      std::move(callback));
+}
+
+void Client::StreamingBatchGet(
+    const std::vector<std::string>& object_keys,
+    const std::vector<tl::expected<QueryResult, ErrorCode>>& query_results,
+    std::unordered_map<std::string, std::vector<Slice>>& slices,
+    StreamCallback callback) {
+    auto delivery = std::make_shared<InOrderDelivery>(object_keys.size(),
+                                                      std::move(callback));
+    for (size_t i = 0; i < object_keys.size(); ++i) {
+        auto it = slices.find(object_keys[i]);
+        if (i >= query_results.size() || it == slices.end()) {
+            delivery->Complete(i, tl::unexpected(ErrorCode::INVALID_PARAMS));
+        } else if (!query_results[i]) {
+            delivery->Complete(i, tl::unexpected(query_results[i].error()));
+        } else {
+            AsyncGet(object_keys[i], query_results[i].value(), it->second,
+                     [delivery, i](tl::expected<void, ErrorCode> result) {
+                         delivery->Complete(i, std::move(result));
+                     });
+        }
+    }
+}
+
 struct BatchGetOperation {
     std::vector<Replica::Descriptor> replicas;
     std::vector<std::vector<Slice>> batched_slices;
@@ -696,7 +1483,7 @@ std::vector<tl::expected<void, ErrorCode>> Client::BatchGetWhenPreferSameNode(
             continue;
         }
         Replica::Descriptor replica;
-        ErrorCode err = FindFirstCompleteReplica(replica_list, replica);
+        ErrorCode err = SelectReplica(replica_list, replica);
         if (err != ErrorCode::OK) {
             if (err == ErrorCode::INVALID_REPLICA) {
                 LOG(ERROR) << "no_complete_replicas_found key=" << key;
@@ -795,6 +1582,12 @@ std::vector<tl::expected<void, ErrorCode>> Client::BatchGet(
     // Record batch get transfer latency (Submit + Wait)
     auto t0_batch_get = std::chrono::steady_clock::now();
 
+    // Objects read whole from one replica, submitted together so that the
+    // ones adjacent in both memories become one transfer
+    std::vector<size_t> coalesced_indices;
+    std::vector<Replica::Descriptor> coalesced_replicas;
+    std::vector<std::vector<Slice>*> coalesced_slices;
+
     // Submit all transfers in parallel
     for (size_t i = 0; i < object_keys.size(); ++i) {
         const auto& key = object_keys[i];
@@ -807,10 +1600,8 @@ std::vector<tl::expected<void, ErrorCode>> Client::BatchGet(
             continue;
         }
 
-        // Find the first complete replica for this key
         Replica::Descriptor replica;
-        ErrorCode err =
-            FindFirstCompleteReplica(query_result.replicas, replica);
+        ErrorCode err = SelectReplica(query_result.replicas, replica);
         if (err != ErrorCode::OK) {
             if (err == ErrorCode::INVALID_REPLICA) {
                 LOG(ERROR) << "no_complete_replicas_found key=" << key;
@@ -819,20 +1610,45 @@ std::vector<tl::expected<void, ErrorCode>> Client::BatchGet(
             continue;
         }
 
-        // Submit transfer operation asynchronously
-        auto future = transfer_submitter_->submit(replica, slices_it->second,
-                                                  TransferRequest::READ);
-        if (!future) {
+        // Large objects are read from all their replicas at once
+        auto parts = SplitRead(query_result.replicas, slices_it->second);
+        for (auto& part : parts) {
+            auto future = transfer_submitter_->submit(
+                part.replica, part.slices, TransferRequest::READ);
+            if (!future) {
+                LOG(ERROR) << "Failed to submit transfer operation for key: "
+                           << key;
+                results[i] = tl::unexpected(ErrorCode::TRANSFER_FAIL);
+                break;
+            }
+            pending_transfers.emplace_back(i, key, std::move(*future));
+        }
+        if (!parts.empty()) {
+            continue;
+        }
+
+        coalesced_indices.push_back(i);
+        coalesced_replicas.push_back(std::move(replica));
+        coalesced_slices.push_back(&slices_it->second);
+    }
+
+    // Submit transfer operations asynchronously
+    auto futures = transfer_submitter_->submit_coalesced(
+        coalesced_replicas, coalesced_slices, TransferRequest::READ);
+    for (size_t j = 0; j < coalesced_indices.size(); ++j) {
+        const size_t i = coalesced_indices[j];
+        const auto& key = object_keys[i];
+        if (!futures[j]) {
             LOG(ERROR) << "Failed to submit transfer operation for key: "
                        << key;
             results[i] = tl::unexpected(ErrorCode::TRANSFER_FAIL);
             continue;
         }
 
-        VLOG(1) << "Submitted transfer for key " << key
-                << " using strategy: " << static_cast<int>(future->strategy());
+        VLOG(1) << "Submitted transfer for key " << key << " using strategy: "
+                << static_cast<int>(futures[j]->strategy());
 
-        pending_transfers.emplace_back(i, key, std::move(*future));
+        pending_transfers.emplace_back(i, key, std::move(*futures[j]));
     }
 
     // Wait for all transfers to complete
@@ -843,8 +1659,8 @@ std::vector<tl::expected<void, ErrorCode>> Client::BatchGet(
                        << " with error: " << static_cast<int>(result);
             results[index] = tl::unexpected(result);
         } else {
+            // A key read in parts may have failed in another part
             VLOG(1) << "Transfer completed successfully for key: " << key;
-            results[index] = {};
         }
     }
 
@@ -871,9 +1687,207 @@ std::vector<tl::expected<void, ErrorCode>> Client::BatchGet(
     return results;
 }
 
-tl::expected<void, ErrorCode> Client::Put(const ObjectKey& key,
-                                          std::vector<Slice>& slices,
-                                          const ReplicateConfig& config) {
+tl::expected<void, ErrorCode> Client::Put(
+    const ObjectKey& key, std::vector<Slice>& slices,
+    const ReplicateConfig& config,
+    const std::function<void()>& fill_slices) {
+    TraceSpan span("Client::Put", TraceSpan::Kind::ROOT);
+    span.SetAttribute("key", key);
+    if (dedup_enabled_ && !ContentIndex::IsContentKey(key) &&
+        IsHostMemory(slices)) {
+        // The content key is computed from the data
+        if (fill_slices) {
+            fill_slices();
+        }
+        return PutDeduplicated(key, slices, config);
+    }
+    return PutObject(key, slices, config, fill_slices);
+}
+
+tl::expected<void, ErrorCode> Client::PutDeduplicated(
+    const ObjectKey& key, std::vector<Slice>& slices,
+    const ReplicateConfig& config) {
+    const std::string content_key = ContentIndex::ContentKey(slices);
+    auto link_result = master_client_.LinkContent(key, content_key);
+    if (!link_result && link_result.error() == ErrorCode::OBJECT_NOT_FOUND) {
+        // First put of this content
+        auto put_result = PutObject(content_key, slices, config);
+        if (!put_result) {
+            return put_result;
+        }
+        link_result = master_client_.LinkContent(key, content_key);
+    }
+    if (link_result) {
+        VLOG(1) << "key=" << key << ", content_key=" << content_key
+                << ", info=linked_to_content";
+        return {};
+    }
+    if (link_result.error() == ErrorCode::OBJECT_ALREADY_EXISTS) {
+        VLOG(1) << "object_already_exists key=" << key;
+        return {};
+    }
+    // E.g. the content object is still being put by another client, or
+    // lives on another master
+    VLOG(1) << "key=" << key << ", content_key=" << content_key
+            << ", error=" << link_result.error() << ", info=put_without_dedup";
+    return PutObject(key, slices, config);
+}
+
+tl::expected<void, ErrorCode> Client::PutBundle(
+    const std::string& bundle_name, const std::vector<ObjectKey>& keys,
+    std::vector<std::vector<Slice>>& batched_slices,
+    const ReplicateConfig& config) {
+    if (bundle_name.empty() || keys.empty() ||
+        keys.size() != batched_slices.size()) {
+        LOG(ERROR) << "bundle_name=" << bundle_name
+                   << ", keys_count=" << keys.size()
+                   << ", slices_count=" << batched_slices.size()
+                   << ", error=invalid_params";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    const std::string bundle_key =
+        std::string(BundleIndex::kBundleKeyPrefix) + bundle_name;
+
+    // The values follow each other in the bundle object, in key order
+    std::vector<Slice> slices;
+    std::vector<uint64_t> sizes;
+    sizes.reserve(keys.size());
+    for (auto& value : batched_slices) {
+        uint64_t size = 0;
+        for (const auto& slice : value) {
+            size += slice.size;
+        }
+        sizes.push_back(size);
+        slices.insert(slices.end(), value.begin(), value.end());
+    }
+
+    auto put_result = PutObject(bundle_key, slices, config);
+    if (!put_result) {
+        return put_result;
+    }
+    auto link_result = master_client_.LinkBundle(bundle_key, keys, sizes);
+    if (!link_result) {
+        // No key refers to the bundle object
+        auto remove_result = master_client_.Remove(bundle_key, true);
+        if (!remove_result) {
+            LOG(WARNING) << "bundle_key=" << bundle_key
+                         << ", error=" << remove_result.error()
+                         << ", info=unlinked_bundle_not_removed";
+        }
+        return tl::unexpected(link_result.error());
+    }
+    return {};
+}
+
+std::vector<tl::expected<void, ErrorCode>> Client::GetBundled(
+    const std::vector<std::string>& keys,
+    std::unordered_map<std::string, std::vector<Slice>>& slices) {
+    std::vector<tl::expected<void, ErrorCode>> results(keys.size());
+    auto members = master_client_.BatchResolveBundle(keys);
+    if (members.size() != keys.size()) {
+        LOG(ERROR) << "keys_count=" << keys.size()
+                   << ", members_count=" << members.size()
+                   << ", error=bundle_resolve_size_mismatch";
+        for (auto& result : results) {
+            result = tl::unexpected(ErrorCode::RPC_FAIL);
+        }
+        return results;
+    }
+
+    // Keys grouped by bundle, so that each bundle is queried and read once
+    std::vector<std::string> bundle_keys;
+    std::unordered_map<std::string, std::vector<size_t>> bundle_members;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (!members[i]) {
+            results[i] = tl::unexpected(members[i].error());
+            continue;
+        }
+        auto it = slices.find(keys[i]);
+        uint64_t size = 0;
+        if (it != slices.end()) {
+            for (const auto& slice : it->second) {
+                size += slice.size;
+            }
+        }
+        if (it == slices.end() || size > members[i]->size) {
+            LOG(ERROR) << "key=" << keys[i] << ", slices_size=" << size
+                       << ", value_size=" << members[i]->size
+                       << ", error=invalid_slices";
+            results[i] = tl::unexpected(ErrorCode::INVALID_PARAMS);
+            continue;
+        }
+        auto [group, inserted] =
+            bundle_members.try_emplace(members[i]->bundle_key);
+        if (inserted) {
+            bundle_keys.push_back(members[i]->bundle_key);
+        }
+        group->second.push_back(i);
+    }
+    if (bundle_keys.empty()) {
+        return results;
+    }
+
+    auto query_results = BatchQuery(bundle_keys);
+    for (size_t b = 0; b < bundle_keys.size(); b++) {
+        const auto& indices = bundle_members[bundle_keys[b]];
+        tl::expected<void, ErrorCode> result;
+        if (!query_results[b]) {
+            result = tl::unexpected(query_results[b].error());
+        } else {
+            std::vector<ObjectRange> ranges;
+            for (size_t i : indices) {
+                uint64_t offset = members[i]->offset;
+                for (const auto& slice : slices[keys[i]]) {
+                    ranges.push_back({offset, slice});
+                    offset += slice.size;
+                }
+            }
+            result = GetRanges(bundle_keys[b], query_results[b].value(),
+                               ranges);
+        }
+        if (!result) {
+            for (size_t i : indices) {
+                results[i] = result;
+            }
+        }
+    }
+    return results;
+}
+
+tl::expected<std::vector<Replica::Descriptor>, ErrorCode>
+Client::PutStartOrWait(const ObjectKey& key,
+                       const std::vector<size_t>& slice_lengths,
+                       const ReplicateConfig& config) {
+    TraceSpan span("Client::PutStart");
+    WaitForPutBackoff();
+    auto result = master_client_.PutStart(key, slice_lengths, config);
+    if (!result) {
+        OnPutStartResult(result.error());
+    }
+    if (!config.wait_for_concurrent_put) {
+        return result;
+    }
+    // Ends with OBJECT_ALREADY_EXISTS once the other put completes, or with
+    // the replicas to write if it was revoked
+    const auto deadline = std::chrono::steady_clock::now() + put_wait_timeout_;
+    auto interval = kPutWaitMinInterval;
+    while (!result && result.error() == ErrorCode::OBJECT_PUT_IN_PROGRESS &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(interval);
+        interval = std::min(interval * 2, kPutWaitMaxInterval);
+        result = master_client_.PutStart(key, slice_lengths, config);
+    }
+    if (!result && result.error() == ErrorCode::OBJECT_PUT_IN_PROGRESS) {
+        LOG(WARNING) << "key=" << key << ", timeout_ms="
+                     << put_wait_timeout_.count()
+                     << ", error=concurrent_put_not_finished";
+    }
+    return result;
+}
+
+tl::expected<void, ErrorCode> Client::PutObject(
+    const ObjectKey& key, std::vector<Slice>& slices,
+    const ReplicateConfig& config, const std::function<void()>& fill_slices) {
     // Prepare slice lengths
     std::vector<size_t> slice_lengths;
     for (size_t i = 0; i < slices.size(); ++i) {
@@ -886,7 +1900,7 @@ tl::expected<void, ErrorCode> Client::Put(const ObjectKey& key,
     }
 
     // Start put operation
-    auto start_result = master_client_.PutStart(key, slice_lengths, client_cfg);
+    auto start_result = PutStartOrWait(key, slice_lengths, client_cfg);
     if (!start_result) {
         ErrorCode err = start_result.error();
         if (err == ErrorCode::OBJECT_ALREADY_EXISTS) {
@@ -902,6 +1916,9 @@ tl::expected<void, ErrorCode> Client::Put(const ObjectKey& key,
         }
         return tl::unexpected(err);
     }
+    if (fill_slices) {
+        fill_slices();
+    }
 
     // Record Put transfer latency (all replicas)
     auto t0_put = std::chrono::steady_clock::now();
@@ -922,7 +1939,7 @@ tl::expected<void, ErrorCode> Client::Put(const ObjectKey& key,
     }
 
     for (const auto& replica : start_result.value()) {
-        if (replica.is_memory_replica()) {
+        if (replica.is_memory_replica() || replica.is_striped_replica()) {
             // Transfer data using allocated handles from all replicas
             ErrorCode transfer_err = TransferWrite(replica, slices);
             if (transfer_err != ErrorCode::OK) {
@@ -946,6 +1963,7 @@ tl::expected<void, ErrorCode> Client::Put(const ObjectKey& key,
     }
 
     // End put operation
+    TraceSpan end_span("Client::PutEnd");
     auto end_result = master_client_.PutEnd(key, ReplicaType::MEMORY);
     if (!end_result) {
         ErrorCode err = end_result.error();
@@ -956,6 +1974,259 @@ tl::expected<void, ErrorCode> Client::Put(const ObjectKey& key,
     return {};
 }
 
+void Client::AsyncPut(const ObjectKey& key, std::vector<Slice>& slices,
+                      const ReplicateConfig& config, AsyncCallback callback) {
+    std::vector<size_t> slice_lengths;
+    for (size_t i = 0; i < slices.size(); ++i) {
+        slice_lengths.emplace_back(slices[i].size);
+    }
+
+    ReplicateConfig client_cfg = config;
+    if (protocol_ == "cxl") {
+        client_cfg.preferred_segment = local_hostname_;
+    }
+
+    auto start_result = PutStartOrWait(key, slice_lengths, client_cfg);
+    if (!start_result) {
+        ErrorCode err = start_result.error();
+        if (err == ErrorCode::OBJECT_ALREADY_EXISTS) {
+            VLOG(1) << "object_already_exists key=" << key;
+            callback({});
+            return;
+        }
+        if (err == ErrorCode::NO_AVAILABLE_HANDLE) {
+            LOG(WARNING) << "Failed to start put operation for key=" << key
+                         << PUT_NO_SPACE_HELPER_STR;
+        } else {
+            LOG(ERROR) << "Failed to start put operation for key=" << key
+                       << ": " << toString(err);
+        }
+        callback(tl::unexpected(err));
+        return;
+    }
+
+    auto t0_put = std::chrono::steady_clock::now();
+    SubmitPut(
+        key, slices, start_result.value(),
+        [this, key, t0_put, callback = std::move(callback)](ErrorCode err) {
+            if (err != ErrorCode::OK) {
+                auto revoke_result =
+                    master_client_.PutRevoke(key, ReplicaType::MEMORY);
+                if (!revoke_result) {
+                    LOG(ERROR) << "Failed to revoke put operation";
+                    callback(tl::unexpected(revoke_result.error()));
+                } else {
+                    callback(tl::unexpected(err));
+                }
+                return;
+            }
+
+            if (metrics_) {
+                metrics_->transfer_metric.put_latency_us.observe(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - t0_put)
+                        .count());
+            }
+            auto end_result = master_client_.PutEnd(key, ReplicaType::MEMORY);
+            if (!end_result) {
+                LOG(ERROR) << "Failed to end put operation: "
+                           << end_result.error();
+                callback(tl::unexpected(end_result.error()));
+                return;
+            }
+            callback({});
+        });
+}
+
+void Client::SubmitPut(const ObjectKey& key, std::vector<Slice>& slices,
+                       const std::vector<Replica::Descriptor>& replicas,
+                       TransferCompletionQueue::Callback done) {
+    // The disk replica is written first, as in Put
+    if (storage_backend_) {
+        for (auto it = replicas.rbegin(); it != replicas.rend(); ++it) {
+            if (it->is_disk_replica()) {
+                PutToLocalFile(key, slices, it->get_disk_descriptor());
+                break;
+            }
+        }
+    }
+
+    // A failed submission still waits for the transfers already submitted
+    // before revoking the put
+    std::vector<TransferFuture> futures;
+    ErrorCode submit_err = ErrorCode::OK;
+    for (const auto& replica : replicas) {
+        if (replica.is_memory_replica() || replica.is_striped_replica()) {
+            auto future =
+                SubmitTransfer(replica, slices, TransferRequest::WRITE);
+            if (!future) {
+                submit_err = future.error();
+                break;
+            }
+            futures.emplace_back(std::move(*future));
+        }
+    }
+
+    completion_queue_->Add(
+        std::move(futures),
+        [submit_err, done = std::move(done)](ErrorCode err) {
+            done(err == ErrorCode::OK ? submit_err : err);
+        });
+}
+
+Client::AsyncResult Client::AsyncPut(const ObjectKey& key,
+                                     std::vector<Slice>& slices,
+                                     const ReplicateConfig& config) {
+    AsyncResult future;
+    AsyncPut(key, slices, config, MakePromiseCallback(future));
+    return future;
+}
+
+async_simple::coro::Lazy<tl::expected<QueryResult, ErrorCode>>
+Client::CoroQuery(const std::string& object_key) {
+    if (auto cached = replica_location_cache_.Get(object_key)) {
+        co_return QueryResult(std::move(cached->replicas),
+                              cached->lease_timeout);
+    }
+    const uint64_t cache_generation = replica_location_cache_.generation();
+    auto start_time = std::chrono::steady_clock::now();
+    auto result = co_await master_client_.CoroGetReplicaList(object_key);
+    if (!result) {
+        co_return tl::unexpected(result.error());
+    }
+    const auto lease_timeout =
+        start_time + std::chrono::milliseconds(result.value().lease_ttl_ms);
+    replica_location_cache_.Put(object_key, cache_generation,
+                                result.value().replicas, start_time,
+                                lease_timeout);
+    co_return QueryResult(std::move(result.value().replicas), lease_timeout);
+}
+
+async_simple::coro::Lazy<
+    tl::expected<std::vector<Replica::Descriptor>, ErrorCode>>
+Client::CoroPutStartOrWait(const ObjectKey& key,
+                           const std::vector<size_t>& slice_lengths,
+                           const ReplicateConfig& config) {
+    if (const uint64_t backoff_ms = put_backoff_ms_.load(); backoff_ms > 0) {
+        co_await coro_io::sleep_for(std::chrono::milliseconds(backoff_ms));
+    }
+    auto result =
+        co_await master_client_.CoroPutStart(key, slice_lengths, config);
+    if (!result) {
+        OnPutStartResult(result.error());
+    }
+    if (!config.wait_for_concurrent_put) {
+        co_return result;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + put_wait_timeout_;
+    auto interval = kPutWaitMinInterval;
+    while (!result && result.error() == ErrorCode::OBJECT_PUT_IN_PROGRESS &&
+           std::chrono::steady_clock::now() < deadline) {
+        co_await coro_io::sleep_for(interval);
+        interval = std::min(interval * 2, kPutWaitMaxInterval);
+        result =
+            co_await master_client_.CoroPutStart(key, slice_lengths, config);
+    }
+    if (!result && result.error() == ErrorCode::OBJECT_PUT_IN_PROGRESS) {
+        LOG(WARNING) << "key=" << key << ", timeout_ms="
+                     << put_wait_timeout_.count()
+                     << ", error=concurrent_put_not_finished";
+    }
+    co_return result;
+}
+
+void Client::WaitForPutBackoff() {
+    if (const uint64_t backoff_ms = put_backoff_ms_.load(); backoff_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+    }
+}
+
+void Client::OnPutStartResult(ErrorCode error) {
+    if (error != ErrorCode::NO_AVAILABLE_HANDLE) {
+        return;
+    }
+    uint64_t backoff_ms = put_backoff_ms_.load();
+    while (backoff_ms < kPutRejectedBackoffMs &&
+           !put_backoff_ms_.compare_exchange_weak(backoff_ms,
+                                                  kPutRejectedBackoffMs)) {
+    }
+}
+
+async_simple::coro::Lazy<tl::expected<void, ErrorCode>> Client::CoroGet(
+    std::string object_key, std::vector<Slice>& slices) {
+    auto query_result = co_await CoroQuery(object_key);
+    if (!query_result) {
+        co_return tl::unexpected(query_result.error());
+    }
+    // Resumed by the callback once the transfer completes
+    async_simple::Promise<tl::expected<void, ErrorCode>> promise;
+    auto done = promise.getFuture();
+    AsyncGet(object_key, query_result.value(), slices,
+             [promise](tl::expected<void, ErrorCode> result) mutable {
+                 promise.setValue(std::move(result));
+             });
+    co_return co_await std::move(done);
+}
+
+async_simple::coro::Lazy<tl::expected<void, ErrorCode>> Client::CoroPut(
+    ObjectKey key, std::vector<Slice>& slices, ReplicateConfig config) {
+    std::vector<size_t> slice_lengths;
+    for (const auto& slice : slices) {
+        slice_lengths.emplace_back(slice.size);
+    }
+    if (protocol_ == "cxl") {
+        config.preferred_segment = local_hostname_;
+    }
+
+    auto start_result =
+        co_await CoroPutStartOrWait(key, slice_lengths, config);
+    if (!start_result) {
+        ErrorCode err = start_result.error();
+        if (err == ErrorCode::OBJECT_ALREADY_EXISTS) {
+            VLOG(1) << "object_already_exists key=" << key;
+            co_return tl::expected<void, ErrorCode>{};
+        }
+        if (err == ErrorCode::NO_AVAILABLE_HANDLE) {
+            LOG(WARNING) << "Failed to start put operation for key=" << key
+                         << PUT_NO_SPACE_HELPER_STR;
+        } else {
+            LOG(ERROR) << "Failed to start put operation for key=" << key
+                       << ": " << toString(err);
+        }
+        co_return tl::unexpected(err);
+    }
+
+    auto t0_put = std::chrono::steady_clock::now();
+    async_simple::Promise<ErrorCode> promise;
+    auto transferred = promise.getFuture();
+    SubmitPut(key, slices, start_result.value(),
+              [promise](ErrorCode err) mutable { promise.setValue(err); });
+    ErrorCode err = co_await std::move(transferred);
+    if (err != ErrorCode::OK) {
+        auto revoke_result =
+            co_await master_client_.CoroPutRevoke(key, ReplicaType::MEMORY);
+        if (!revoke_result) {
+            LOG(ERROR) << "Failed to revoke put operation";
+            co_return tl::unexpected(revoke_result.error());
+        }
+        co_return tl::unexpected(err);
+    }
+
+    if (metrics_) {
+        metrics_->transfer_metric.put_latency_us.observe(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - t0_put)
+                .count());
+    }
+    auto end_result =
+        co_await master_client_.CoroPutEnd(key, ReplicaType::MEMORY);
+    if (!end_result) {
+        LOG(ERROR) << "Failed to end put operation: " << end_result.error();
+        co_return tl::unexpected(end_result.error());
+    }
+    co_return tl::expected<void, ErrorCode>{};
+}
+
 // TODO: `client.cpp` is too long, consider split it into multiple files
 enum class PutOperationState {
     PENDING,
@@ -1030,7 +2301,7 @@ std::vector<PutOperation> Client::CreatePutOperations(
     return ops;
 }
 
-void Client::StartBatchPut(std::vector<PutOperation>& ops,
+void Client::StartBatchPut(std::span<PutOperation> ops,
                            const ReplicateConfig& config) {
     std::vector<std::string> keys;
     std::vector<std::vector<uint64_t>> slice_lengths;
@@ -1049,6 +2320,8 @@ void Client::StartBatchPut(std::vector<PutOperation>& ops,
         slice_lengths.emplace_back(std::move(slice_sizes));
     }
 
+    // The whole batch waits once
+    WaitForPutBackoff();
     auto start_responses =
         master_client_.BatchPutStart(keys, slice_lengths, config);
 
@@ -1066,6 +2339,7 @@ void Client::StartBatchPut(std::vector<PutOperation>& ops,
     // Process individual responses with robust error handling
     for (size_t i = 0; i < ops.size(); ++i) {
         if (!start_responses[i]) {
+            OnPutStartResult(start_responses[i].error());
             ops[i].SetError(start_responses[i].error(),
                             "Master failed to start put operation");
         } else {
@@ -1078,7 +2352,7 @@ void Client::StartBatchPut(std::vector<PutOperation>& ops,
     }
 }
 
-void Client::SubmitTransfers(std::vector<PutOperation>& ops) {
+void Client::SubmitTransfers(std::span<PutOperation> ops) {
     if (!transfer_submitter_) {
         LOG(ERROR) << "TransferSubmitter not initialized";
         for (auto& op : ops) {
@@ -1088,7 +2362,15 @@ void Client::SubmitTransfers(std::vector<PutOperation>& ops) {
         return;
     }
 
-    for (auto& op : ops) {
+    // The replicas of all operations are submitted together, so that the
+    // ones adjacent in both memories become one transfer
+    std::vector<Replica::Descriptor> replicas;
+    std::vector<std::vector<Slice>*> replica_slices;
+    // Operation and replica index of each of them
+    std::vector<std::pair<size_t, size_t>> owners;
+
+    for (size_t op_idx = 0; op_idx < ops.size(); ++op_idx) {
+        auto& op = ops[op_idx];
         // Skip operations that already failed in previous stages
         if (op.IsResolved()) {
             continue;
@@ -1101,9 +2383,6 @@ void Client::SubmitTransfers(std::vector<PutOperation>& ops) {
             continue;
         }
 
-        bool all_transfers_submitted = true;
-        std::string failure_context;
-
         // We must deal with disk replica first, then the disk putrevoke/putend
         // can be called surely
         if (storage_backend_) {
@@ -1121,35 +2400,44 @@ void Client::SubmitTransfers(std::vector<PutOperation>& ops) {
         for (size_t replica_idx = 0; replica_idx < op.replicas.size();
              ++replica_idx) {
             const auto& replica = op.replicas[replica_idx];
-            if (replica.is_memory_replica()) {
-                auto submit_result = transfer_submitter_->submit(
-                    replica, op.slices, TransferRequest::WRITE);
-
-                if (!submit_result) {
-                    failure_context = "Failed to submit transfer for replica " +
-                                      std::to_string(replica_idx);
-                    all_transfers_submitted = false;
-                    break;
-                }
-
-                op.pending_transfers.emplace_back(
-                    std::move(submit_result.value()));
+            if (replica.is_memory_replica() || replica.is_striped_replica()) {
+                replicas.push_back(replica);
+                replica_slices.push_back(&op.slices);
+                owners.emplace_back(op_idx, replica_idx);
             }
         }
+    }
 
-        if (!all_transfers_submitted) {
+    auto futures = transfer_submitter_->submit_coalesced(
+        replicas, replica_slices, TransferRequest::WRITE);
+    for (size_t i = 0; i < futures.size(); ++i) {
+        auto& op = ops[owners[i].first];
+        // Failed on an earlier replica
+        if (op.IsResolved()) {
+            continue;
+        }
+        if (!futures[i]) {
+            std::string failure_context =
+                "Failed to submit transfer for replica " +
+                std::to_string(owners[i].second);
             LOG(ERROR) << "Transfer submission failed for key " << op.key
                        << ": " << failure_context;
             op.SetError(ErrorCode::TRANSFER_FAIL, failure_context);
             op.pending_transfers.clear();
-        } else {
+            continue;
+        }
+        op.pending_transfers.emplace_back(std::move(*futures[i]));
+    }
+
+    for (auto& op : ops) {
+        if (!op.IsResolved()) {
             VLOG(1) << "Successfully submitted " << op.pending_transfers.size()
                     << " transfers for key " << op.key;
         }
     }
 }
 
-void Client::WaitForTransfers(std::vector<PutOperation>& ops) {
+void Client::WaitForTransfers(std::span<PutOperation> ops) {
     for (auto& op : ops) {
         // Skip operations that already failed or completed
         if (op.IsResolved()) {
@@ -1195,7 +2483,7 @@ void Client::WaitForTransfers(std::vector<PutOperation>& ops) {
     }
 }
 
-void Client::FinalizeBatchPut(std::vector<PutOperation>& ops) {
+void Client::FinalizeBatchPut(std::span<PutOperation> ops) {
     // For each operation,
     // If transfers completed successfully, we need to call BatchPutEnd
     // If the operation failed but has allocated replicas, we need to call
@@ -1452,26 +2740,101 @@ std::vector<tl::expected<void, ErrorCode>> Client::BatchPut(
             return std::vector<tl::expected<void, ErrorCode>>(
                 keys.size(), tl::unexpected(ErrorCode::INVALID_PARAMS));
         }
-        StartBatchPut(ops, client_cfg);
-        return BatchPutWhenPreferSameNode(ops);
-    }
-    StartBatchPut(ops, client_cfg);
+        StartBatchPut(ops, client_cfg);
+        return BatchPutWhenPreferSameNode(ops);
+    }
+    if (batch_put_pipeline_size_ > 0 &&
+        ops.size() > batch_put_pipeline_size_) {
+        PipelinedBatchPut(ops, client_cfg);
+        PutAfterConcurrentPuts(ops, client_cfg);
+        return CollectResults(ops);
+    }
+    StartBatchPut(ops, client_cfg);
+
+    auto t0 = std::chrono::steady_clock::now();
+    SubmitTransfers(ops);
+    WaitForTransfers(ops);
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - t0)
+                  .count();
+    if (metrics_) {
+        metrics_->transfer_metric.batch_put_latency_us.observe(us);
+    }
+
+    FinalizeBatchPut(ops);
+    PutAfterConcurrentPuts(ops, client_cfg);
+    return CollectResults(ops);
+}
+
+void Client::PutAfterConcurrentPuts(std::span<PutOperation> ops,
+                                    const ReplicateConfig& config) {
+    if (!config.wait_for_concurrent_put) {
+        return;
+    }
+    for (auto& op : ops) {
+        if (op.result.has_value() ||
+            op.result.error() != ErrorCode::OBJECT_PUT_IN_PROGRESS) {
+            continue;
+        }
+        // Waits for the other put, and writes the object only if it failed
+        auto result = PutObject(op.key, op.slices, config);
+        if (result) {
+            op.SetSuccess();
+        } else {
+            op.SetError(result.error(), "put after concurrent put");
+        }
+    }
+}
+
+void Client::PipelinedBatchPut(std::vector<PutOperation>& ops,
+                               const ReplicateConfig& config) {
+    const size_t batch_size = batch_put_pipeline_size_;
+    auto sub_batch = [&](size_t begin) {
+        return std::span<PutOperation>(ops).subspan(
+            begin, std::min(batch_size, ops.size() - begin));
+    };
+
+    auto start_async = [&](size_t begin) {
+        return std::async(std::launch::async,
+                          [this, &config, batch = sub_batch(begin)] {
+                              StartBatchPut(batch, config);
+                          });
+    };
+
+    auto start_future = start_async(0);
+    std::future<void> finalize_future;
+    for (size_t begin = 0; begin < ops.size(); begin += batch_size) {
+        auto batch = sub_batch(begin);
+        start_future.get();
+        if (begin + batch_size < ops.size()) {
+            start_future = start_async(begin + batch_size);
+        }
 
-    auto t0 = std::chrono::steady_clock::now();
-    SubmitTransfers(ops);
-    WaitForTransfers(ops);
-    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
-                  std::chrono::steady_clock::now() - t0)
-                  .count();
-    if (metrics_) {
-        metrics_->transfer_metric.batch_put_latency_us.observe(us);
-    }
+        auto t0 = std::chrono::steady_clock::now();
+        SubmitTransfers(batch);
+        WaitForTransfers(batch);
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - t0)
+                      .count();
+        if (metrics_) {
+            metrics_->transfer_metric.batch_put_latency_us.observe(us);
+        }
 
-    FinalizeBatchPut(ops);
-    return CollectResults(ops);
+        // One PutEnd in flight at a time, in the order of the sub-batches
+        if (finalize_future.valid()) {
+            finalize_future.get();
+        }
+        finalize_future = std::async(
+            std::launch::async, [this, batch] { FinalizeBatchPut(batch); });
+    }
+    if (finalize_future.valid()) {
+        finalize_future.get();
+    }
 }
 
 tl::expected<void, ErrorCode> Client::Remove(const ObjectKey& key, bool force) {
+    replica_location_cache_.Invalidate(key);
+    object_cache_.Invalidate(key);
     auto result = master_client_.Remove(key, force);
     // if (storage_backend_) {
     //     storage_backend_->RemoveFile(key);
@@ -1484,6 +2847,8 @@ tl::expected<void, ErrorCode> Client::Remove(const ObjectKey& key, bool force) {
 
 tl::expected<long, ErrorCode> Client::RemoveByRegex(const ObjectKey& str,
                                                     bool force) {
+    replica_location_cache_.Clear();
+    object_cache_.Clear();
     auto result = master_client_.RemoveByRegex(str, force);
     // if (storage_backend_) {
     //     storage_backend_->RemoveByRegex(str);
@@ -1494,7 +2859,21 @@ tl::expected<long, ErrorCode> Client::RemoveByRegex(const ObjectKey& str,
     return result.value();
 }
 
+tl::expected<std::vector<UUID>, ErrorCode> Client::RemoveByPrefix(
+    const std::string& prefix, bool force) {
+    replica_location_cache_.Clear();
+    object_cache_.Clear();
+    return master_client_.RemoveByPrefix(prefix, force);
+}
+
+tl::expected<ScanKeysResponse, ErrorCode> Client::ScanKeys(
+    const std::string& prefix, uint64_t cursor, uint64_t limit) {
+    return master_client_.ScanKeys(prefix, cursor, limit);
+}
+
 tl::expected<long, ErrorCode> Client::RemoveAll(bool force) {
+    replica_location_cache_.Clear();
+    object_cache_.Clear();
     // if (storage_backend_) {
     //     storage_backend_->RemoveAll();
     // }
@@ -1502,7 +2881,8 @@ tl::expected<long, ErrorCode> Client::RemoveAll(bool force) {
 }
 
 tl::expected<void, ErrorCode> Client::MountSegment(
-    const void* buffer, size_t size, const std::string& protocol) {
+    const void* buffer, size_t size, const std::string& protocol,
+    const std::string& location, const std::optional<UUID>& segment_id) {
     auto check_result = CheckRegisterMemoryParams(buffer, size);
     if (!check_result) {
         return tl::unexpected(check_result.error());
@@ -1525,21 +2905,27 @@ tl::expected<void, ErrorCode> Client::MountSegment(
         }
     }
 
-    int rc = transfer_engine_->registerLocalMemory(
-        (void*)buffer, size, kWildcardLocation, true, true);
+    int rc = transfer_engine_->registerLocalMemory((void*)buffer, size,
+                                                   location, true, true);
     if (rc != 0) {
         LOG(ERROR) << "register_local_memory_failed base=" << buffer
-                   << " size=" << size << ", error=" << rc;
+                   << " size=" << size << " location=" << location
+                   << ", error=" << rc;
         return tl::unexpected(ErrorCode::INVALID_PARAMS);
     }
 
     // Build segment with logical name; attach TE endpoint for transport
     Segment segment;
-    segment.id = generate_uuid();
+    segment.id = segment_id.value_or(generate_uuid());
     segment.name = local_hostname_;
     segment.base = reinterpret_cast<uintptr_t>(buffer);
     segment.size = size;
     segment.protocol = protocol;
+    if (const char* locality = std::getenv("MC_STORE_LOCALITY")) {
+        segment.locality = locality;
+    }
+    segment.slab_block_size =
+        GetEnvOr<uint64_t>("MC_STORE_SLAB_BLOCK_SIZE", 0);
     // For P2P handshake mode, publish the actual transport endpoint that was
     // negotiated by the transfer engine. Otherwise, keep the logical hostname
     // so metadata backends (HTTP/etcd/redis) can resolve the segment by name.
@@ -1561,6 +2947,11 @@ tl::expected<void, ErrorCode> Client::MountSegment(
     return {};
 }
 
+void Client::DetachSegments() {
+    std::lock_guard<std::mutex> lock(mounted_segments_mutex_);
+    mounted_segments_.clear();
+}
+
 tl::expected<void, ErrorCode> Client::UnmountSegment(const void* buffer,
                                                      size_t size) {
     std::lock_guard<std::mutex> lock(mounted_segments_mutex_);
@@ -1604,6 +2995,51 @@ tl::expected<void, ErrorCode> Client::UnmountSegment(const void* buffer,
     return {};
 }
 
+tl::expected<void, ErrorCode> Client::DrainSegment(
+    const void* buffer, size_t size, std::chrono::milliseconds timeout) {
+    UUID segment_id;
+    {
+        std::lock_guard<std::mutex> lock(mounted_segments_mutex_);
+        auto segment = std::find_if(
+            mounted_segments_.begin(), mounted_segments_.end(),
+            [&](const auto& entry) {
+                return entry.second.base ==
+                           reinterpret_cast<uintptr_t>(buffer) &&
+                       entry.second.size == size;
+            });
+        if (segment == mounted_segments_.end()) {
+            LOG(ERROR) << "segment_not_found base=" << buffer
+                       << " size=" << size;
+            return tl::unexpected(ErrorCode::INVALID_PARAMS);
+        }
+        segment_id = segment->first;
+    }
+
+    // The objects are moved by the master, this only waits for them
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    uint64_t remaining = 0;
+    while (true) {
+        auto drain_result = master_client_.DrainSegment(segment_id);
+        if (!drain_result) {
+            LOG(ERROR) << "Failed to drain segment on master: "
+                       << toString(drain_result.error());
+            return tl::unexpected(drain_result.error());
+        }
+        remaining = drain_result.value();
+        if (remaining == 0 || std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        std::this_thread::sleep_for(kDrainPollInterval);
+    }
+    if (remaining > 0) {
+        LOG(WARNING) << "action=drain_segment_timeout, segment_id="
+                     << segment_id << ", remaining_bytes=" << remaining;
+    } else {
+        LOG(INFO) << "action=drain_segment_done, segment_id=" << segment_id;
+    }
+    return UnmountSegment(buffer, size);
+}
+
 tl::expected<void, ErrorCode> Client::RegisterLocalMemory(
     void* addr, size_t length, const std::string& location,
     bool remote_accessible, bool update_metadata) {
@@ -1627,12 +3063,67 @@ tl::expected<void, ErrorCode> Client::unregisterLocalMemory(
     return {};
 }
 
+void Client::SyncKeyFilter() {
+    const auto since = key_filter_.SyncPoints(master_client_.NumMasters());
+    key_filter_.Apply(since, master_client_.GetKeyFilter(since));
+    if (key_filter_.usable()) {
+        key_filter_synced_ns_.store(
+            std::chrono::steady_clock::now().time_since_epoch().count(),
+            std::memory_order_relaxed);
+    }
+}
+
+bool Client::KeyFilterExcludes(const std::string& key) const {
+    if (!key_filter_enabled_) {
+        return false;
+    }
+    // Stop trusting the filter after a few missed syncs
+    const int64_t synced_ns =
+        key_filter_synced_ns_.load(std::memory_order_relaxed);
+    const auto age = std::chrono::steady_clock::now().time_since_epoch() -
+                     std::chrono::nanoseconds(synced_ns);
+    if (synced_ns == 0 || age > kKeyFilterMaxAge) {
+        return false;
+    }
+    return !key_filter_.MayContain(key);
+}
+
 tl::expected<bool, ErrorCode> Client::IsExist(const std::string& key) {
+    if (KeyFilterExcludes(key)) {
+        return false;
+    }
     auto result = master_client_.ExistKey(key);
     return result;
 }
 
 std::vector<tl::expected<bool, ErrorCode>> Client::BatchIsExist(
+    const std::vector<std::string>& keys) {
+    if (key_filter_enabled_) {
+        // Only the keys the filter cannot exclude are sent to the master
+        std::vector<tl::expected<bool, ErrorCode>> results(keys.size(), false);
+        std::vector<size_t> maybe_indices;
+        std::vector<std::string> maybe_keys;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!KeyFilterExcludes(keys[i])) {
+                maybe_indices.push_back(i);
+                maybe_keys.push_back(keys[i]);
+            }
+        }
+        if (maybe_keys.size() < keys.size()) {
+            if (maybe_keys.empty()) {
+                return results;
+            }
+            auto maybe_results = BatchIsExistOnMaster(maybe_keys);
+            for (size_t i = 0; i < maybe_indices.size(); ++i) {
+                results[maybe_indices[i]] = std::move(maybe_results[i]);
+            }
+            return results;
+        }
+    }
+    return BatchIsExistOnMaster(keys);
+}
+
+std::vector<tl::expected<bool, ErrorCode>> Client::BatchIsExistOnMaster(
     const std::vector<std::string>& keys) {
     auto response = master_client_.BatchExistKey(keys);
 
@@ -1670,9 +3161,10 @@ tl::expected<void, ErrorCode> Client::MountLocalDiskSegment(
 
 tl::expected<void, ErrorCode> Client::OffloadObjectHeartbeat(
     bool enable_offloading,
-    std::unordered_map<std::string, int64_t>& offloading_objects) {
-    auto response =
-        master_client_.OffloadObjectHeartbeat(client_id_, enable_offloading);
+    std::unordered_map<std::string, int64_t>& offloading_objects,
+    uint64_t max_objects) {
+    auto response = master_client_.OffloadObjectHeartbeat(
+        client_id_, enable_offloading, max_objects);
     if (!response) {
         LOG(ERROR) << "OffloadObjectHeartbeat failed, error code is "
                    << response.error();
@@ -1870,6 +3362,143 @@ tl::expected<void, ErrorCode> Client::Move(const std::string& key,
     return result;
 }
 
+tl::expected<void, ErrorCode> Client::Promote(const std::string& key,
+                                              const std::string& target) {
+    LOG(INFO) << "action=replica_promote_start" << ", key=" << key
+              << ", target_segment=" << target;
+
+    // An empty source copies from the disk replica
+    auto start_result = master_client_.CopyStart(key, "", {target});
+    if (!start_result.has_value()) {
+        ErrorCode error = start_result.error();
+        LOG(ERROR) << "action=replica_promote_failed" << ", key=" << key
+                   << ", error=copy_start_failed" << ", error_code=" << error;
+        return tl::unexpected(error);
+    }
+
+    const auto& response = start_result.value();
+    if (response.targets.empty()) {
+        LOG(INFO) << "action=replica_promote_skipped" << ", key=" << key
+                  << ", info=target_replica_already_exists";
+        auto copy_end_result = master_client_.CopyEnd(key);
+        if (!copy_end_result.has_value()) {
+            ErrorCode error = copy_end_result.error();
+            LOG(ERROR) << "action=replica_promote_failed" << ", key=" << key
+                       << ", error=copy_end_failed" << ", error_code=" << error;
+            return tl::unexpected(error);
+        }
+        return {};
+    }
+
+    auto revoke = [&]() {
+        auto revoke_result = master_client_.CopyRevoke(key);
+        if (!revoke_result.has_value()) {
+            LOG(WARNING) << "action=replica_promote_revoke_failed"
+                         << ", key=" << key
+                         << ", error_code=" << revoke_result.error();
+        }
+    };
+
+    const auto& target_replica = response.targets[0];
+    if (!response.source.is_disk_replica() ||
+        !IsReplicaOnLocalMemory(target_replica)) {
+        LOG(ERROR) << "action=replica_promote_failed" << ", key=" << key
+                   << ", error=invalid_replica_type";
+        revoke();
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    // Read the file straight into the new replica
+    const auto& buffer_descriptor =
+        target_replica.get_memory_descriptor().buffer_descriptor;
+    void* buffer = reinterpret_cast<void*>(buffer_descriptor.buffer_address_);
+    auto slices = split_into_slices(buffer, buffer_descriptor.size_);
+    if (TransferRead(response.source, slices) != ErrorCode::OK) {
+        revoke();
+        return tl::unexpected(ErrorCode::TRANSFER_FAIL);
+    }
+
+    auto end_result = master_client_.CopyEnd(key);
+    if (!end_result.has_value()) {
+        revoke();
+        return tl::unexpected(end_result.error());
+    }
+
+    LOG(INFO) << "action=replica_promote_success" << ", key=" << key
+              << ", target_segment=" << target;
+    return {};
+}
+
+tl::expected<void, ErrorCode> Client::Prefetch(
+    const std::vector<std::string>& keys) {
+    std::vector<std::string> targets;
+    {
+        std::lock_guard<std::mutex> lock(mounted_segments_mutex_);
+        targets.reserve(mounted_segments_.size());
+        for (const auto& [id, segment] : mounted_segments_) {
+            targets.push_back(segment.name);
+        }
+    }
+    if (targets.empty()) {
+        LOG(ERROR) << "action=prefetch_failed, error=no_mounted_segment";
+        return tl::unexpected(ErrorCode::SEGMENT_NOT_FOUND);
+    }
+
+    std::vector<std::string> new_keys;
+    {
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        for (const auto& key : keys) {
+            if (prefetching_keys_.insert(key).second) {
+                new_keys.push_back(key);
+            }
+        }
+    }
+    // Batches of keys are queried and promoted by the threads in parallel
+    for (size_t begin = 0; begin < new_keys.size();
+         begin += kPrefetchBatchSize) {
+        const size_t end =
+            std::min(begin + kPrefetchBatchSize, new_keys.size());
+        std::vector<std::string> batch(
+            std::make_move_iterator(new_keys.begin() + begin),
+            std::make_move_iterator(new_keys.begin() + end));
+        prefetch_thread_pool_.enqueue(
+            [this, batch = std::move(batch), targets] {
+                PrefetchKeys(batch, targets);
+            });
+    }
+    return {};
+}
+
+void Client::PrefetchKeys(const std::vector<std::string>& keys,
+                          const std::vector<std::string>& targets) {
+    std::vector<tl::expected<GetReplicaListResponse, ErrorCode>> responses;
+    if (prefetch_running_) {
+        // Asks the master rather than the replica location cache, which may
+        // not know of a replica that was promoted or evicted since
+        responses = master_client_.BatchGetReplicaList(keys);
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const auto& key = keys[i];
+        if (prefetch_running_ && i < responses.size() && responses[i]) {
+            bool in_memory = false;
+            bool on_disk = false;
+            for (const auto& replica : responses[i].value().replicas) {
+                in_memory |= replica.is_memory_replica() ||
+                             replica.is_striped_replica();
+                on_disk |= replica.is_disk_replica();
+            }
+            const auto& target =
+                targets[std::hash<std::string>{}(key) % targets.size()];
+            if (!in_memory && on_disk && Promote(key, target)) {
+                replica_location_cache_.Invalidate(key);
+                object_cache_.Invalidate(key);
+            }
+        }
+        std::lock_guard<std::mutex> lock(prefetch_mutex_);
+        prefetching_keys_.erase(key);
+    }
+}
+
 tl::expected<QueryTaskResponse, ErrorCode> Client::QueryTask(
     const UUID& task_id) {
     return master_client_.QueryTask(task_id);
@@ -1952,21 +3581,31 @@ void Client::PutToLocalFile(const std::string& key,
 ErrorCode Client::TransferData(const Replica::Descriptor& replica_descriptor,
                                std::vector<Slice>& slices,
                                TransferRequest::OpCode op_code) {
+    auto future = SubmitTransfer(replica_descriptor, slices, op_code);
+    if (!future) {
+        return future.error();
+    }
+    return future->get();
+}
+
+tl::expected<TransferFuture, ErrorCode> Client::SubmitTransfer(
+    const Replica::Descriptor& replica_descriptor, std::vector<Slice>& slices,
+    TransferRequest::OpCode op_code) {
     if (!transfer_submitter_) {
         LOG(ERROR) << "TransferSubmitter not initialized";
-        return ErrorCode::INVALID_PARAMS;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
     }
 
     auto future =
         transfer_submitter_->submit(replica_descriptor, slices, op_code);
     if (!future) {
         LOG(ERROR) << "Failed to submit transfer operation";
-        return ErrorCode::TRANSFER_FAIL;
+        return tl::unexpected(ErrorCode::TRANSFER_FAIL);
     }
 
     VLOG(1) << "Using transfer strategy: " << future->strategy();
 
-    return future->get();
+    return std::move(*future);
 }
 
 ErrorCode Client::TransferWrite(const Replica::Descriptor& replica_descriptor,
@@ -1976,10 +3615,22 @@ ErrorCode Client::TransferWrite(const Replica::Descriptor& replica_descriptor,
 
 ErrorCode Client::TransferRead(const Replica::Descriptor& replica_descriptor,
                                std::vector<Slice>& slices) {
+    auto future = SubmitRead(replica_descriptor, slices);
+    if (!future) {
+        return future.error();
+    }
+    return future->get();
+}
+
+tl::expected<TransferFuture, ErrorCode> Client::SubmitRead(
+    const Replica::Descriptor& replica_descriptor,
+    std::vector<Slice>& slices) {
     size_t total_size = 0;
     if (replica_descriptor.is_memory_replica()) {
         auto& mem_desc = replica_descriptor.get_memory_descriptor();
         total_size = mem_desc.buffer_descriptor.size_;
+    } else if (replica_descriptor.is_striped_replica()) {
+        total_size = replica_descriptor.get_striped_descriptor().object_size;
     } else {
         auto& disk_desc = replica_descriptor.get_disk_descriptor();
         total_size = disk_desc.object_size;
@@ -1989,10 +3640,10 @@ ErrorCode Client::TransferRead(const Replica::Descriptor& replica_descriptor,
     if (slices_size < total_size) {
         LOG(ERROR) << "Slice size " << slices_size << " is smaller than total "
                    << "size " << total_size;
-        return ErrorCode::INVALID_PARAMS;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
     }
 
-    return TransferData(replica_descriptor, slices, TransferRequest::READ);
+    return SubmitTransfer(replica_descriptor, slices, TransferRequest::READ);
 }
 
 void Client::PollAndDispatchTasks() {
@@ -2065,6 +3716,17 @@ void Client::ExecuteTask(const ClientTask& client_task) {
                 }
                 break;
             }
+            case TaskType::REPLICA_PROMOTE: {
+                ReplicaPromotePayload payload;
+                struct_json::from_json(payload, assignment.payload);
+                auto promote_result = Promote(payload.key, payload.target);
+                if (promote_result.has_value()) {
+                    result = ErrorCode::OK;
+                } else {
+                    result = promote_result.error();
+                }
+                break;
+            }
             default:
                 LOG(ERROR) << "action=task_execution_failed"
                            << ", task_id=" << assignment.id
@@ -2152,6 +3814,9 @@ void Client::PingThreadMain(bool is_ha_mode,
     const int fail_ping_interval_ms = 1000;
     // Increment after a ping failure, reset after a ping success
     int ping_fail_count = 0;
+    // To report the transfer throughput since the previous ping
+    uint64_t last_transferred_bytes = 0;
+    auto last_ping_time = std::chrono::steady_clock::now();
 
     auto remount_segment = [this]() {
         // This lock must be held until the remount rpc is finished,
@@ -2174,6 +3839,15 @@ void Client::PingThreadMain(bool is_ha_mode,
     // thread
     std::future<void> remount_segment_future;
 
+    // Sleeps until the next ping, waking up early on shutdown or when a new
+    // leader is elected
+    auto wait_for_next_ping = [this](int interval_ms) {
+        std::unique_lock<std::mutex> lock(ping_mutex_);
+        ping_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] {
+            return !ping_running_ || !next_master_address_.empty();
+        });
+    };
+
     while (ping_running_) {
         // Join the remount segment thread if it is ready
         if (remount_segment_future.valid() &&
@@ -2182,12 +3856,45 @@ void Client::PingThreadMain(bool is_ha_mode,
             remount_segment_future = std::future<void>();
         }
 
+        // Connect to the leader reported by the master view watcher
+        std::string next_master_address;
+        {
+            std::lock_guard<std::mutex> lock(ping_mutex_);
+            next_master_address.swap(next_master_address_);
+        }
+        if (!next_master_address.empty() &&
+            next_master_address != current_master_address) {
+            // Connect switches to the new leader even if it is not serving
+            // yet, so calls in flight are retried against it
+            auto err = master_client_.Connect(next_master_address);
+            LOG(INFO) << "Switched to new master " << next_master_address
+                      << ": " << toString(err);
+            current_master_address = next_master_address;
+            ping_fail_count = 0;
+        }
+
         // Ping master
-        auto ping_result = master_client_.Ping();
+        const uint64_t transferred_bytes = transferred_bytes_.load();
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed_sec =
+            std::chrono::duration<double>(now - last_ping_time).count();
+        const uint64_t transfer_bytes_per_sec =
+            elapsed_sec > 0
+                ? (transferred_bytes - last_transferred_bytes) / elapsed_sec
+                : 0;
+        last_transferred_bytes = transferred_bytes;
+        last_ping_time = now;
+        auto ping_result = master_client_.Ping(transfer_bytes_per_sec);
         if (ping_result) {
             // Reset ping failure count
             ping_fail_count = 0;
             auto& ping_response = ping_result.value();
+            replica_location_cache_.SyncEpoch(
+                ping_response.view_version_id,
+                ping_response.replica_invalidation_epoch);
+            mem_used_ratio_ = ping_response.mem_used_ratio;
+            put_backoff_ms_ = ping_response.put_backoff_ms;
+            object_cache_.SyncView(ping_response.view_version_id);
             if (ping_response.client_status == ClientStatus::NEED_REMOUNT &&
                 !remount_segment_future.valid()) {
                 // Ensure at most one remount segment thread is running
@@ -2197,17 +3904,18 @@ void Client::PingThreadMain(bool is_ha_mode,
 
             // Poll for tasks and dispatch to task thread pool
             PollAndDispatchTasks();
+            if (key_filter_enabled_) {
+                SyncKeyFilter();
+            }
 
-            std::this_thread::sleep_for(
-                std::chrono::milliseconds(success_ping_interval_ms));
+            wait_for_next_ping(success_ping_interval_ms);
             continue;
         }
 
         ping_fail_count++;
         if (ping_fail_count < max_ping_fail_count) {
             LOG(ERROR) << "Failed to ping master";
-            std::this_thread::sleep_for(
-                std::chrono::milliseconds(fail_ping_interval_ms));
+            wait_for_next_ping(fail_ping_interval_ms);
             continue;
         }
 
@@ -2223,8 +3931,7 @@ void Client::PingThreadMain(bool is_ha_mode,
             if (err != ErrorCode::OK) {
                 LOG(ERROR) << "Failed to get new master view: "
                            << toString(err);
-                std::this_thread::sleep_for(
-                    std::chrono::milliseconds(fail_ping_interval_ms));
+                wait_for_next_ping(fail_ping_interval_ms);
                 continue;
             }
 
@@ -2232,8 +3939,7 @@ void Client::PingThreadMain(bool is_ha_mode,
             if (err != ErrorCode::OK) {
                 LOG(ERROR) << "Failed to connect to master " << master_address
                            << ": " << toString(err);
-                std::this_thread::sleep_for(
-                    std::chrono::milliseconds(fail_ping_interval_ms));
+                wait_for_next_ping(fail_ping_interval_ms);
                 continue;
             }
 
@@ -2248,8 +3954,7 @@ void Client::PingThreadMain(bool is_ha_mode,
             if (err != ErrorCode::OK) {
                 LOG(ERROR) << "Reconnect failed to " << current_master_address
                            << ": " << toString(err);
-                std::this_thread::sleep_for(
-                    std::chrono::milliseconds(fail_ping_interval_ms));
+                wait_for_next_ping(fail_ping_interval_ms);
                 continue;
             }
             LOG(INFO) << "Reconnected to master " << current_master_address;
@@ -2277,6 +3982,265 @@ ErrorCode Client::FindFirstCompleteReplica(
     return ErrorCode::INVALID_REPLICA;
 }
 
+ErrorCode Client::SelectReplica(
+    const std::vector<Replica::Descriptor>& replica_list,
+    Replica::Descriptor& replica) {
+    if (!replica_speed_) {
+        return FindFirstCompleteReplica(replica_list, replica);
+    }
+
+    std::vector<const Replica::Descriptor*> candidates;
+    std::vector<std::string> endpoints;
+    for (const auto& rep : replica_list) {
+        if (rep.status != ReplicaStatus::COMPLETE ||
+            !rep.is_memory_replica()) {
+            continue;
+        }
+        if (IsReplicaOnLocalMemory(rep)) {
+            replica = rep;  // memcpy beats any remote NIC
+            return ErrorCode::OK;
+        }
+        candidates.push_back(&rep);
+        endpoints.push_back(
+            rep.get_memory_descriptor().buffer_descriptor.transport_endpoint_);
+    }
+    if (candidates.size() < 2) {
+        return FindFirstCompleteReplica(replica_list, replica);
+    }
+
+    const uint64_t size =
+        candidates[0]->get_memory_descriptor().buffer_descriptor.size_;
+    replica = *candidates[replica_speed_->PickFastest(endpoints, size)];
+    return ErrorCode::OK;
+}
+
+void Client::RecordReplicaRead(const Replica::Descriptor& replica,
+                               ErrorCode result, uint64_t latency_us) {
+    if (!replica_speed_ || !replica.is_memory_replica() ||
+        IsReplicaOnLocalMemory(replica)) {
+        return;
+    }
+    const auto& buffer = replica.get_memory_descriptor().buffer_descriptor;
+    if (result == ErrorCode::OK) {
+        replica_speed_->Record(buffer.transport_endpoint_, buffer.size_,
+                               latency_us);
+    } else {
+        replica_speed_->RecordFailure(buffer.transport_endpoint_);
+    }
+}
+
+std::vector<Client::ReadPart> Client::SplitRead(
+    const std::vector<Replica::Descriptor>& replica_list,
+    const std::vector<Slice>& slices) {
+    if (parallel_read_min_part_size_ == 0) {
+        return {};
+    }
+    std::vector<const Replica::Descriptor*> sources;
+    for (const auto& replica : replica_list) {
+        if (replica.status != ReplicaStatus::COMPLETE ||
+            !replica.is_memory_replica()) {
+            continue;
+        }
+        if (IsReplicaOnLocalMemory(replica)) {
+            return {};  // memcpy beats any remote NIC
+        }
+        sources.push_back(&replica);
+    }
+    if (sources.size() < 2) {
+        return {};
+    }
+
+    // Leave mismatching slices to the single replica read, which reports them
+    const uint64_t object_size =
+        sources[0]->get_memory_descriptor().buffer_descriptor.size_;
+    if (CalculateSliceSize(slices) != object_size ||
+        std::any_of(slices.begin(), slices.end(),
+                    [](const Slice& slice) { return slice.ptr == nullptr; })) {
+        return {};
+    }
+    const uint64_t num_parts = std::min<uint64_t>(
+        sources.size(), object_size / parallel_read_min_part_size_);
+    if (num_parts < 2) {
+        return {};
+    }
+    const uint64_t part_size =
+        align_up((object_size + num_parts - 1) / num_parts,
+                 kParallelReadAlignment);
+
+    // Cut the slices at the part boundaries
+    std::vector<ReadPart> parts;
+    size_t slice_index = 0;
+    uint64_t slice_offset = 0;
+    for (uint64_t begin = 0; begin < object_size; begin += part_size) {
+        ReadPart part{*sources[parts.size()], {}};
+        auto& buffer = part.replica.get_memory_descriptor().buffer_descriptor;
+        buffer.buffer_address_ += begin;
+        buffer.size_ = std::min(part_size, object_size - begin);
+        uint64_t remaining = buffer.size_;
+        while (remaining > 0) {
+            const Slice& slice = slices[slice_index];
+            const uint64_t length =
+                std::min<uint64_t>(remaining, slice.size - slice_offset);
+            if (length > 0) {
+                part.slices.push_back(
+                    {static_cast<char*>(slice.ptr) + slice_offset, length});
+            }
+            remaining -= length;
+            slice_offset += length;
+            if (slice_offset == slice.size) {
+                slice_index++;
+                slice_offset = 0;
+            }
+        }
+        parts.push_back(std::move(part));
+    }
+    return parts;
+}
+
+ErrorCode Client::TransferReadParts(std::vector<ReadPart>& parts) {
+    if (!transfer_submitter_) {
+        LOG(ERROR) << "TransferSubmitter not initialized";
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    ErrorCode result = ErrorCode::OK;
+    std::vector<TransferFuture> futures;
+    futures.reserve(parts.size());
+    for (auto& part : parts) {
+        auto future = transfer_submitter_->submit(part.replica, part.slices,
+                                                  TransferRequest::READ);
+        if (!future) {
+            LOG(ERROR) << "Failed to submit transfer operation";
+            result = ErrorCode::TRANSFER_FAIL;
+            break;
+        }
+        futures.push_back(std::move(*future));
+    }
+    // Wait for the submitted parts even on failure, they write the slices
+    for (auto& future : futures) {
+        ErrorCode err = future.get();
+        if (err != ErrorCode::OK && result == ErrorCode::OK) {
+            result = err;
+        }
+    }
+    return result;
+}
+
+std::optional<ErrorCode> Client::HedgedRead(
+    const std::vector<Replica::Descriptor>& replica_list,
+    std::vector<Slice>& slices) {
+    if (!hedge_delay_ || !hedge_buffer_allocator_ || !transfer_submitter_) {
+        return std::nullopt;
+    }
+    std::vector<const Replica::Descriptor*> sources;
+    for (const auto& replica : replica_list) {
+        if (replica.status != ReplicaStatus::COMPLETE ||
+            !replica.is_memory_replica()) {
+            continue;
+        }
+        if (IsReplicaOnLocalMemory(replica)) {
+            return std::nullopt;
+        }
+        sources.push_back(&replica);
+        if (sources.size() == 2) {
+            break;
+        }
+    }
+    if (sources.size() < 2) {
+        return std::nullopt;
+    }
+    const uint64_t size =
+        sources[0]->get_memory_descriptor().buffer_descriptor.size_;
+    if (size == 0 || size > hedged_read_max_size_ ||
+        CalculateSliceSize(slices) != size ||
+        std::any_of(slices.begin(), slices.end(),
+                    [](const Slice& slice) { return slice.ptr == nullptr; })) {
+        return std::nullopt;
+    }
+
+    // Both reads go to staging buffers, the losing one still writes its
+    // buffer after Get returns
+    std::optional<BufferHandle> buffers[2] = {
+        hedge_buffer_allocator_->allocate(size),
+        hedge_buffer_allocator_->allocate(size)};
+    if (!buffers[0] || !buffers[1]) {
+        return std::nullopt;
+    }
+    std::optional<TransferFuture> futures[2];
+    std::optional<ErrorCode> results[2];
+    auto submit = [&](size_t i) {
+        std::vector<Slice> staging = {{buffers[i]->ptr(), size}};
+        futures[i] = transfer_submitter_->submit(*sources[i], staging,
+                                                 TransferRequest::READ);
+        if (!futures[i]) {
+            LOG(ERROR) << "Failed to submit transfer operation";
+            results[i] = ErrorCode::TRANSFER_FAIL;
+        }
+    };
+
+    // Without enough samples for the delay, only the first replica is read
+    const uint64_t delay_us = hedge_delay_->Get();
+    const auto start = std::chrono::steady_clock::now();
+    submit(0);
+    std::optional<size_t> winner;
+    while (!winner) {
+        for (size_t i = 0; i < 2 && !winner; i++) {
+            if (futures[i] && !results[i] && futures[i]->isReady()) {
+                results[i] = futures[i]->get();
+                if (*results[i] == ErrorCode::OK) {
+                    winner = i;
+                }
+            }
+        }
+        if (winner) {
+            break;
+        }
+        if (delay_us > 0 && !futures[1] && !results[1]) {
+            // Hedge once the delay expires, or right away if the first fails
+            const auto elapsed_us =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+            if (results[0] || static_cast<uint64_t>(elapsed_us) >= delay_us) {
+                submit(1);
+                if (metrics_) {
+                    metrics_->transfer_metric.hedged_reads.inc();
+                }
+                continue;
+            }
+        }
+        if (results[0] && (results[1] || delay_us == 0)) {
+            break;  // every read failed
+        }
+        std::this_thread::sleep_for(kHedgedReadPollInterval);
+    }
+
+    for (size_t i = 0; i < 2; i++) {
+        if (futures[i] && !results[i]) {
+            auto loser =
+                std::make_shared<std::pair<TransferFuture, BufferHandle>>(
+                    std::move(*futures[i]), std::move(*buffers[i]));
+            hedge_reaper_pool_->enqueue([loser] { loser->first.wait(); });
+        }
+    }
+    if (!winner) {
+        return results[0];
+    }
+
+    const char* data = static_cast<const char*>(buffers[*winner]->ptr());
+    for (const auto& slice : slices) {
+        std::memcpy(slice.ptr, data, slice.size);
+        data += slice.size;
+    }
+    if (*winner == 1 && metrics_) {
+        metrics_->transfer_metric.hedged_read_wins.inc();
+    }
+    hedge_delay_->Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count());
+    return ErrorCode::OK;
+}
+
 tl::expected<Replica::Descriptor, ErrorCode> Client::GetPreferredReplica(
     const std::vector<Replica::Descriptor>& replica_list) {
     if (replica_list.empty()) {
@@ -0,0 +1,95 @@
+#include "compact_replica_list.h"
+
+#include <glog/logging.h>
+
+#include <unordered_map>
+#include <utility>
+
+namespace mooncake {
+
+namespace {
+
+// Visit the buffer descriptors of the results, in the order of the format
+template <typename Fn>
+void ForEachBuffer(
+    std::vector<tl::expected<GetReplicaListResponse, ErrorCode>>& results,
+    Fn&& fn) {
+    for (auto& result : results) {
+        if (!result) {
+            continue;
+        }
+        for (auto& replica : result->replicas) {
+            auto& variant = replica.descriptor_variant;
+            if (auto* memory = std::get_if<MemoryDescriptor>(&variant)) {
+                fn(memory->buffer_descriptor);
+            } else if (auto* striped =
+                           std::get_if<StripedDescriptor>(&variant)) {
+                for (auto& chunk : striped->chunk_descriptors) {
+                    fn(chunk);
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+CompactReplicaLists EncodeReplicaLists(
+    std::vector<tl::expected<GetReplicaListResponse, ErrorCode>> results) {
+    CompactReplicaLists compact;
+    compact.results = std::move(results);
+
+    // An endpoint is assumed to use a single protocol, the buffers of an
+    // endpoint seen with another protocol keep their strings.
+    std::unordered_map<std::string, uint32_t> endpoint_index;
+    ForEachBuffer(compact.results, [&](AllocatedBuffer::Descriptor& buffer) {
+        auto [it, inserted] = endpoint_index.try_emplace(
+            buffer.transport_endpoint_,
+            static_cast<uint32_t>(compact.endpoints.size()));
+        if (inserted) {
+            compact.endpoints.push_back({std::move(buffer.protocol_),
+                                         std::move(buffer.transport_endpoint_)});
+        } else if (compact.endpoints[it->second].protocol != buffer.protocol_) {
+            compact.endpoint_indices.push_back(
+                CompactReplicaLists::kInlineEndpoint);
+            return;
+        }
+        buffer.protocol_.clear();
+        buffer.transport_endpoint_.clear();
+        compact.endpoint_indices.push_back(it->second);
+    });
+    return compact;
+}
+
+tl::expected<std::vector<tl::expected<GetReplicaListResponse, ErrorCode>>,
+             ErrorCode>
+DecodeReplicaLists(CompactReplicaLists compact) {
+    size_t next = 0;
+    bool valid = true;
+    ForEachBuffer(compact.results, [&](AllocatedBuffer::Descriptor& buffer) {
+        if (!valid || next >= compact.endpoint_indices.size()) {
+            valid = false;
+            return;
+        }
+        const uint32_t index = compact.endpoint_indices[next++];
+        if (index == CompactReplicaLists::kInlineEndpoint) {
+            return;
+        }
+        if (index >= compact.endpoints.size()) {
+            valid = false;
+            return;
+        }
+        const auto& endpoint = compact.endpoints[index];
+        buffer.protocol_ = endpoint.protocol;
+        buffer.transport_endpoint_ = endpoint.transport_endpoint;
+    });
+    if (!valid || next != compact.endpoint_indices.size()) {
+        LOG(ERROR) << "endpoints=" << compact.endpoints.size()
+                   << ", endpoint_indices=" << compact.endpoint_indices.size()
+                   << ", error=endpoint_table_mismatch";
+        return tl::make_unexpected(ErrorCode::RPC_FAIL);
+    }
+    return std::move(compact.results);
+}
+
+}  // namespace mooncake
@@ -0,0 +1,246 @@
+#include "content_index.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "master_metric_manager.h"
+
+namespace mooncake {
+
+namespace {
+
+constexpr uint32_t kSha256Init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                     0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                     0x1f83d9ab, 0x5be0cd19};
+
+constexpr uint32_t kSha256Rounds[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+inline uint32_t Rotr(uint32_t x, int r) { return (x >> r) | (x << (32 - r)); }
+
+// SHA-256 (FIPS 180-4) of the slices fed as one stream. The content key is
+// the only identity check of the data shared between keys, so it must be
+// collision resistant even against crafted data.
+class ContentHasher {
+   public:
+    void Update(const char* data, size_t size) {
+        total_ += size;
+        if (buffered_ > 0) {
+            size_t n = std::min(size, kBlock - buffered_);
+            memcpy(buffer_ + buffered_, data, n);
+            buffered_ += n;
+            data += n;
+            size -= n;
+            if (buffered_ < kBlock) {
+                return;
+            }
+            Block(reinterpret_cast<const uint8_t*>(buffer_));
+            buffered_ = 0;
+        }
+        for (; size >= kBlock; data += kBlock, size -= kBlock) {
+            Block(reinterpret_cast<const uint8_t*>(data));
+        }
+        memcpy(buffer_, data, size);
+        buffered_ = size;
+    }
+
+    // Returns the digest as 64 hex digits
+    std::string Finish() {
+        const uint64_t bits = total_ * 8;
+        const char pad = static_cast<char>(0x80);
+        Update(&pad, 1);
+        const char zero[kBlock] = {};
+        Update(zero, (kBlock + kBlock - 8 - buffered_) % kBlock);
+        char length[8];
+        for (int i = 0; i < 8; ++i) {
+            length[i] = static_cast<char>(bits >> (56 - 8 * i));
+        }
+        Update(length, 8);
+
+        char hex[65];
+        for (int i = 0; i < 8; ++i) {
+            snprintf(hex + 8 * i, 9, "%08x", state_[i]);
+        }
+        return std::string(hex, 64);
+    }
+
+   private:
+    static constexpr size_t kBlock = 64;
+
+    void Block(const uint8_t* data) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t{data[4 * i]} << 24) |
+                   (uint32_t{data[4 * i + 1]} << 16) |
+                   (uint32_t{data[4 * i + 2]} << 8) | data[4 * i + 3];
+        }
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 =
+                Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 =
+                Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t v[8];
+        memcpy(v, state_, sizeof(v));
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t s1 = Rotr(v[4], 6) ^ Rotr(v[4], 11) ^ Rotr(v[4], 25);
+            const uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+            const uint32_t t1 = v[7] + s1 + ch + kSha256Rounds[i] + w[i];
+            const uint32_t s0 = Rotr(v[0], 2) ^ Rotr(v[0], 13) ^ Rotr(v[0], 22);
+            const uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+            const uint32_t t2 = s0 + maj;
+            memmove(v + 1, v, 7 * sizeof(uint32_t));
+            v[4] += t1;
+            v[0] = t1 + t2;
+        }
+        for (int i = 0; i < 8; ++i) {
+            state_[i] += v[i];
+        }
+    }
+
+    uint32_t state_[8] = {kSha256Init[0], kSha256Init[1], kSha256Init[2],
+                          kSha256Init[3], kSha256Init[4], kSha256Init[5],
+                          kSha256Init[6], kSha256Init[7]};
+    char buffer_[kBlock];
+    size_t buffered_ = 0;
+    uint64_t total_ = 0;
+};
+
+}  // namespace
+
+bool ContentIndex::IsContentKey(const std::string& key) {
+    return key.starts_with(kContentKeyPrefix);
+}
+
+std::string ContentIndex::ContentKey(const std::vector<Slice>& slices) {
+    ContentHasher hasher;
+    uint64_t size = 0;
+    for (const auto& slice : slices) {
+        hasher.Update(static_cast<const char*>(slice.ptr), slice.size);
+        size += slice.size;
+    }
+    return std::string(kContentKeyPrefix) + hasher.Finish() + "-" +
+           std::to_string(size);
+}
+
+ErrorCode ContentIndex::Link(const std::string& key,
+                             const std::string& content_key, uint64_t size) {
+    auto& shard = GetLinkShard(key);
+    std::lock_guard lock(shard.mutex);
+    auto [it, inserted] = shard.links.try_emplace(key, content_key);
+    if (!inserted) {
+        return it->second == content_key ? ErrorCode::OK
+                                         : ErrorCode::OBJECT_ALREADY_EXISTS;
+    }
+    Acquire(content_key, size);
+    num_linked_keys_.fetch_add(1, std::memory_order_relaxed);
+    UpdateMetrics();
+    return ErrorCode::OK;
+}
+
+std::optional<std::string> ContentIndex::Resolve(const std::string& key) const {
+    auto& shard = GetLinkShard(key);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.links.find(key);
+    if (it == shard.links.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+bool ContentIndex::Unlink(const std::string& key,
+                          std::optional<std::string>& orphaned) {
+    auto& shard = GetLinkShard(key);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.links.find(key);
+    if (it == shard.links.end()) {
+        return false;
+    }
+    std::string content_key = std::move(it->second);
+    shard.links.erase(it);
+    if (Release(content_key)) {
+        orphaned = std::move(content_key);
+    }
+    num_linked_keys_.fetch_sub(1, std::memory_order_relaxed);
+    UpdateMetrics();
+    return true;
+}
+
+size_t ContentIndex::UnlinkIf(
+    const std::function<bool(const std::string&)>& pred,
+    std::vector<std::string>& orphaned) {
+    size_t unlinked = 0;
+    for (auto& shard : link_shards_) {
+        std::lock_guard lock(shard.mutex);
+        for (auto it = shard.links.begin(); it != shard.links.end();) {
+            if (!pred(it->first)) {
+                ++it;
+                continue;
+            }
+            if (Release(it->second)) {
+                orphaned.push_back(it->second);
+            }
+            it = shard.links.erase(it);
+            unlinked++;
+        }
+    }
+    if (unlinked > 0) {
+        num_linked_keys_.fetch_sub(unlinked, std::memory_order_relaxed);
+        UpdateMetrics();
+    }
+    return unlinked;
+}
+
+ContentIndex::Stats ContentIndex::GetStats() const {
+    return Stats{num_linked_keys_.load(std::memory_order_relaxed),
+                 num_contents_.load(std::memory_order_relaxed),
+                 saved_bytes_.load(std::memory_order_relaxed)};
+}
+
+void ContentIndex::Acquire(const std::string& content_key, uint64_t size) {
+    auto& shard = GetContentShard(content_key);
+    std::lock_guard lock(shard.mutex);
+    auto& content = shard.contents[content_key];
+    content.size = size;
+    if (content.refs++ > 0) {
+        saved_bytes_.fetch_add(size, std::memory_order_relaxed);
+    } else {
+        num_contents_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool ContentIndex::Release(const std::string& content_key) {
+    auto& shard = GetContentShard(content_key);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.contents.find(content_key);
+    if (it == shard.contents.end()) {
+        return false;
+    }
+    if (--it->second.refs > 0) {
+        saved_bytes_.fetch_sub(it->second.size, std::memory_order_relaxed);
+        return false;
+    }
+    shard.contents.erase(it);
+    num_contents_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ContentIndex::UpdateMetrics() {
+    const auto stats = GetStats();
+    MasterMetricManager::instance().set_dedup_stats(
+        stats.linked_keys, stats.content_objects, stats.saved_bytes);
+}
+
+}  // namespace mooncake
@@ -0,0 +1,118 @@
+#include "copy_engine.h"
+
+#include <glog/logging.h>
+
+#include <cstring>
+
+#ifdef USE_CUDA
+#include <cuda_runtime.h>
+
+#include <unordered_map>
+#endif
+
+namespace mooncake {
+
+std::unique_ptr<CopyEngine> CopyEngine::Create(const std::string& name) {
+#ifdef USE_CUDA
+    if (name == "cuda") {
+        return std::make_unique<CudaCopyEngine>();
+    }
+#endif
+    if (!name.empty() && name != "cpu") {
+        LOG(WARNING) << "copy_engine=" << name
+                     << ", error=unsupported_copy_engine, using cpu";
+    }
+    return std::make_unique<CpuCopyEngine>();
+}
+
+ErrorCode CpuCopyEngine::Copy(void* dest, const void* src, size_t size) {
+    std::memcpy(dest, src, size);
+    return ErrorCode::OK;
+}
+
+#ifdef USE_CUDA
+namespace {
+
+bool IsCudaMemory(const void* ptr, int& device) {
+    cudaPointerAttributes attributes;
+    if (cudaPointerGetAttributes(&attributes, ptr) != cudaSuccess) {
+        cudaGetLastError();  // clear the error of unregistered memory
+        return false;
+    }
+    if (attributes.type == cudaMemoryTypeDevice ||
+        attributes.type == cudaMemoryTypeManaged) {
+        device = attributes.device;
+        return true;
+    }
+    return attributes.type == cudaMemoryTypeHost;
+}
+
+// Stream and blocking-sync event of a worker thread on one device
+struct CudaCopyStream {
+    cudaStream_t stream = nullptr;
+    cudaEvent_t event = nullptr;
+
+    ~CudaCopyStream() {
+        if (event) {
+            cudaEventDestroy(event);
+        }
+        if (stream) {
+            cudaStreamDestroy(stream);
+        }
+    }
+};
+
+CudaCopyStream* GetCopyStream(int device) {
+    thread_local std::unordered_map<int, CudaCopyStream> streams;
+    auto [it, inserted] = streams.try_emplace(device);
+    if (inserted) {
+        cudaSetDevice(device);
+        if (cudaStreamCreateWithFlags(&it->second.stream,
+                                      cudaStreamNonBlocking) != cudaSuccess ||
+            cudaEventCreateWithFlags(
+                &it->second.event,
+                cudaEventBlockingSync | cudaEventDisableTiming) !=
+                cudaSuccess) {
+            LOG(ERROR) << "device=" << device
+                       << ", error=cuda_copy_stream_creation_failed";
+            streams.erase(it);
+            return nullptr;
+        }
+    }
+    return &it->second;
+}
+
+}  // namespace
+
+ErrorCode CudaCopyEngine::Copy(void* dest, const void* src, size_t size) {
+    int device = 0;
+    const bool dest_cuda = IsCudaMemory(dest, device);
+    const bool src_cuda = IsCudaMemory(src, device);
+    if (!dest_cuda && !src_cuda) {
+        std::memcpy(dest, src, size);
+        return ErrorCode::OK;
+    }
+
+    auto* copy_stream = GetCopyStream(device);
+    if (!copy_stream) {
+        return ErrorCode::TRANSFER_FAIL;
+    }
+    cudaError_t err = cudaMemcpyAsync(dest, src, size, cudaMemcpyDefault,
+                                      copy_stream->stream);
+    if (err == cudaSuccess) {
+        err = cudaEventRecord(copy_stream->event, copy_stream->stream);
+    }
+    if (err == cudaSuccess) {
+        // Sleeps until the copy is done thanks to cudaEventBlockingSync
+        err = cudaEventSynchronize(copy_stream->event);
+    }
+    if (err != cudaSuccess) {
+        LOG(ERROR) << "size=" << size
+                   << ", error=cuda_copy_failed: " << cudaGetErrorString(err);
+        return ErrorCode::TRANSFER_FAIL;
+    }
+    return ErrorCode::OK;
+}
+#endif
+
+}  // namespace mooncake
@@ -0,0 +1,166 @@
+#include "crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define MOONCAKE_CRC32C_X86 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define MOONCAKE_CRC32C_ARM 1
+#endif
+
+namespace mooncake {
+
+namespace {
+
+// Reflected Castagnoli polynomial
+constexpr uint32_t kPolynomial = 0x82F63B78u;
+
+constexpr std::array<uint32_t, 256> MakeTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (kPolynomial ^ (crc >> 1)) : (crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr auto kTable = MakeTable();
+
+// The functions below update the CRC register, without the inversions
+// before and after
+[[maybe_unused]] uint32_t UpdateSoftware(uint32_t crc, const uint8_t* data,
+                                        size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        crc = kTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(MOONCAKE_CRC32C_X86)
+
+// Bytes each of the three streams covers per round. The register update is
+// linear, so the CRC of a||b||c is that of a shifted over b and c, xor that
+// of b shifted over c, xor that of c, where shifting over n bytes is the
+// update by n zero bytes.
+constexpr size_t kStripe = 8192;
+
+uint64_t Load64(const uint8_t* data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+__attribute__((target("sse4.2"))) uint32_t UpdateSse42(uint32_t crc,
+                                                        const uint8_t* data,
+                                                        size_t size) {
+    uint64_t crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        crc64 = _mm_crc32_u64(crc64, Load64(data));
+    }
+    crc = static_cast<uint32_t>(crc64);
+    for (; size > 0; ++data, --size) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+
+// Shifts a register over kStripe zero bytes, one table per byte of it
+struct StripeShift {
+    std::array<std::array<uint32_t, 256>, 4> tables{};
+
+    StripeShift() {
+        static const uint8_t zeros[kStripe] = {};
+        std::array<uint32_t, 32> bits;
+        for (int bit = 0; bit < 32; ++bit) {
+            bits[bit] = UpdateSse42(1u << bit, zeros, kStripe);
+        }
+        for (int byte = 0; byte < 4; ++byte) {
+            for (uint32_t value = 0; value < 256; ++value) {
+                uint32_t shifted = 0;
+                for (int bit = 0; bit < 8; ++bit) {
+                    if (value & (1u << bit)) shifted ^= bits[byte * 8 + bit];
+                }
+                tables[byte][value] = shifted;
+            }
+        }
+    }
+
+    uint32_t operator()(uint32_t crc) const {
+        return tables[0][crc & 0xFF] ^ tables[1][(crc >> 8) & 0xFF] ^
+               tables[2][(crc >> 16) & 0xFF] ^ tables[3][crc >> 24];
+    }
+};
+
+__attribute__((target("sse4.2"))) uint32_t UpdateSse42Parallel(
+    uint32_t crc, const uint8_t* data, size_t size) {
+    if (size >= 3 * kStripe) {
+        static const StripeShift shift;
+        for (; size >= 3 * kStripe; data += 3 * kStripe, size -= 3 * kStripe) {
+            uint64_t a = crc, b = 0, c = 0;
+            for (size_t i = 0; i < kStripe; i += 8) {
+                a = _mm_crc32_u64(a, Load64(data + i));
+                b = _mm_crc32_u64(b, Load64(data + kStripe + i));
+                c = _mm_crc32_u64(c, Load64(data + 2 * kStripe + i));
+            }
+            crc = shift(shift(static_cast<uint32_t>(a)) ^
+                        static_cast<uint32_t>(b)) ^
+                  static_cast<uint32_t>(c);
+        }
+    }
+    return UpdateSse42(crc, data, size);
+}
+
+bool HasSse42() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+const bool kHardware = HasSse42();
+
+#elif defined(MOONCAKE_CRC32C_ARM)
+
+uint32_t UpdateArm(uint32_t crc, const uint8_t* data, size_t size) {
+    for (; size >= 8; data += 8, size -= 8) {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        crc = __crc32cd(crc, value);
+    }
+    for (; size > 0; ++data, --size) {
+        crc = __crc32cb(crc, *data);
+    }
+    return crc;
+}
+
+const bool kHardware = true;
+
+#else
+
+const bool kHardware = false;
+
+#endif
+
+}  // namespace
+
+uint32_t Crc32c(uint32_t crc, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+#if defined(MOONCAKE_CRC32C_X86)
+    crc = kHardware ? UpdateSse42Parallel(crc, bytes, size)
+                    : UpdateSoftware(crc, bytes, size);
+#elif defined(MOONCAKE_CRC32C_ARM)
+    crc = UpdateArm(crc, bytes, size);
+#else
+    crc = UpdateSoftware(crc, bytes, size);
+#endif
+    return ~crc;
+}
+
+bool Crc32cIsHardwareAccelerated() { return kHardware; }
+
+}  // namespace mooncake
@@ -0,0 +1,51 @@
+#include "disk_promotion_tracker.h"
+
+#include <utility>
+
+namespace mooncake {
+
+DiskPromotionTracker::DiskPromotionTracker(uint32_t reads,
+                                           std::chrono::seconds window,
+                                           size_t capacity)
+    : reads_(reads), window_(window), capacity_(capacity) {}
+
+bool DiskPromotionTracker::Record(const std::string& key,
+                                  Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    auto it = keys_.find(key);
+    if (it == keys_.end()) {
+        if (keys_.size() >= capacity_) {
+            return false;
+        }
+        it = keys_.emplace(key, Reads{.first_read = now}).first;
+    } else if (now - it->second.first_read > window_) {
+        it->second = Reads{.first_read = now};
+    }
+
+    auto& reads = it->second;
+    if (reads.due || ++reads.count < reads_) {
+        return false;
+    }
+    reads.due = true;
+    due_.push_back(key);
+    return true;
+}
+
+std::vector<std::string> DiskPromotionTracker::TakeDue() {
+    std::lock_guard lock(mutex_);
+    return std::move(due_);
+}
+
+void DiskPromotionTracker::Prune(Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    std::erase_if(keys_, [&](const auto& entry) {
+        return now - entry.second.first_read > window_;
+    });
+}
+
+size_t DiskPromotionTracker::size() const {
+    std::lock_guard lock(mutex_);
+    return keys_.size();
+}
+
+}  // namespace mooncake
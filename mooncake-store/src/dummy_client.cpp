@@ -169,6 +169,33 @@ static int send_fd(int socket, int fd, void* data, size_t data_len) {
     return sendmsg(socket, &msg, 0);
 }
 
+static int recv_fd(int socket, void* data, size_t data_len) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    struct iovec iov;
+    char buf[CMSG_SPACE(sizeof(int))];
+    memset(buf, 0, sizeof(buf));
+
+    iov.iov_base = data;
+    iov.iov_len = data_len;
+
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+
+    if (recvmsg(socket, &msg, MSG_WAITALL) < 0) return -1;
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET &&
+        cmsg->cmsg_type == SCM_RIGHTS) {
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        return fd;
+    }
+    return -1;
+}
+
 template <auto ServiceMethod, typename ReturnType, typename... Args>
 tl::expected<ReturnType, ErrorCode> DummyClient::invoke_rpc(Args&&... args) {
     auto pool = client_accessor_.GetClientPool();
@@ -288,13 +315,7 @@ ErrorCode DummyClient::connect(const std::string& server_address) {
     return ErrorCode::OK;
 }
 
-int DummyClient::register_shm_via_ipc(const ShmHelper::ShmSegment* shm,
-                                      bool is_local) {
-    if (shm->fd < 0) {
-        LOG(ERROR) << "Invalid shm_fd during IPC registration";
-        return -1;
-    }
-
+int DummyClient::connect_ipc() {
     int sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
     if (sock_fd < 0) {
         LOG(ERROR) << "Failed to create IPC socket: " << strerror(errno);
@@ -323,6 +344,20 @@ int DummyClient::register_shm_via_ipc(const ShmHelper::ShmSegment* shm,
         close(sock_fd);
         return -1;
     }
+    return sock_fd;
+}
+
+int DummyClient::register_shm_via_ipc(const ShmHelper::ShmSegment* shm,
+                                      bool is_local) {
+    if (shm->fd < 0) {
+        LOG(ERROR) << "Invalid shm_fd during IPC registration";
+        return -1;
+    }
+
+    int sock_fd = connect_ipc();
+    if (sock_fd < 0) {
+        return -1;
+    }
 
     ShmRegisterRequest req;
     req.client_id_first = client_id_.first;
@@ -357,6 +392,56 @@ int DummyClient::register_shm_via_ipc(const ShmHelper::ShmSegment* shm,
     return 0;
 }
 
+int DummyClient::import_segments_via_ipc() {
+    int sock_fd = connect_ipc();
+    if (sock_fd < 0) {
+        return -1;
+    }
+
+    ShmRegisterRequest req{};
+    req.client_id_first = client_id_.first;
+    req.client_id_second = client_id_.second;
+    req.op = kShmIpcExportSegments;
+    if (send(sock_fd, &req, sizeof(req), 0) < 0) {
+        LOG(ERROR) << "Failed to request segments from RealClient: "
+                   << strerror(errno);
+        close(sock_fd);
+        return -1;
+    }
+
+    uint32_t count = 0;
+    if (recv(sock_fd, &count, sizeof(count), MSG_WAITALL) != sizeof(count)) {
+        LOG(ERROR) << "Failed to receive segment count from RealClient";
+        close(sock_fd);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        SegmentExportEntry entry;
+        int fd = recv_fd(sock_fd, &entry, sizeof(entry));
+        if (fd < 0) {
+            LOG(ERROR) << "Failed to receive segment from RealClient";
+            close(sock_fd);
+            return -1;
+        }
+        // Read-only: the bytes belong to the store
+        void* base = mmap(nullptr, entry.size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            LOG(ERROR) << "Failed to map segment of RealClient: "
+                       << strerror(errno);
+            close(sock_fd);
+            return -1;
+        }
+        imported_segments_.push_back(
+            {entry.real_base_addr, base, entry.size});
+    }
+    close(sock_fd);
+
+    LOG(INFO) << "Mapped " << count << " segments of RealClient";
+    return 0;
+}
+
 int DummyClient::setup_dummy(size_t mem_pool_size, size_t local_buffer_size,
                              const std::string& server_address,
                              const std::string& ipc_socket_path) {
@@ -403,6 +488,15 @@ int DummyClient::setup_dummy(size_t mem_pool_size, size_t local_buffer_size,
 int DummyClient::tearDownAll() {
     unregister_shm();
 
+    {
+        std::lock_guard<std::mutex> lock(imported_segments_mutex_);
+        for (auto& seg : imported_segments_) {
+            munmap(seg.base, seg.size);
+        }
+        imported_segments_.clear();
+        segments_imported_ = false;
+    }
+
     if (ping_running_) {
         ping_running_ = false;
         if (ping_thread_.joinable()) {
@@ -455,6 +549,13 @@ int DummyClient::register_buffer(void* buffer, size_t size) {
     return 0;
 }
 
+int DummyClient::register_device_buffer(void* buffer, size_t size,
+                                        int device_id) {
+    // GPU memory of this process cannot be shared with the real client
+    LOG(ERROR) << "register_device_buffer is not supported for dummy client";
+    return -1;
+}
+
 int DummyClient::unregister_buffer(void* buffer) {
     if (buffer == nullptr) {
         LOG(ERROR) << "Invalid buffer pointer";
@@ -483,6 +584,12 @@ int DummyClient::unregister_buffer(void* buffer) {
     return to_py_ret(ret);
 }
 
+int DummyClient::invalidate_buffer(void* buffer, size_t size) {
+    // The shared memory is registered by the real client, which caches no
+    // registration of it
+    return 0;
+}
+
 uint64_t DummyClient::alloc_from_mem_pool(size_t size) {
     try {
         void* addr = shm_helper_->allocate(size);
@@ -538,6 +645,10 @@ int DummyClient::isExist(const std::string& key) {
     }
 }
 
+int DummyClient::prefetch(const std::vector<std::string>& keys) {
+    return to_py_ret(invoke_rpc<&RealClient::prefetch_internal, void>(keys));
+}
+
 std::vector<int> DummyClient::batchIsExist(
     const std::vector<std::string>& keys) {
     auto internal_results =
@@ -578,6 +689,38 @@ std::tuple<uint64_t, size_t> DummyClient::get_buffer_info(
     return result.value();
 }
 
+std::tuple<uint64_t, size_t, uint64_t> DummyClient::get_zero_copy_info(
+    const std::string& key) {
+    auto result =
+        invoke_rpc<&RealClient::get_zero_copy_dummy_helper, ZeroCopyLease>(
+            key);
+    if (!result.has_value()) {
+        VLOG(1) << "No zero copy replica for key: " << key
+                << ", error: " << toString(result.error());
+        return std::make_tuple(0, 0, 0);
+    }
+    const auto& lease = result.value();
+
+    std::lock_guard<std::mutex> lock(imported_segments_mutex_);
+    if (!segments_imported_) {
+        if (import_segments_via_ipc() != 0) {
+            return std::make_tuple(0, 0, 0);
+        }
+        segments_imported_ = true;
+    }
+    for (const auto& seg : imported_segments_) {
+        if (lease.real_addr >= seg.real_base_addr &&
+            lease.real_addr + lease.size <= seg.real_base_addr + seg.size) {
+            uint64_t addr = reinterpret_cast<uint64_t>(seg.base) +
+                            (lease.real_addr - seg.real_base_addr);
+            return std::make_tuple(addr, lease.size, lease.lease_ttl_ms);
+        }
+    }
+    LOG(ERROR) << "Replica of key " << key
+               << " is not in any mapped segment of RealClient";
+    return std::make_tuple(0, 0, 0);
+}
+
 std::vector<std::shared_ptr<BufferHandle>> DummyClient::batch_get_buffer(
     const std::vector<std::string>& keys) {
     // TODO: implement this function
@@ -590,6 +733,62 @@ int64_t DummyClient::get_into(const std::string& key, void* buffer,
     return -1;
 }
 
+int64_t DummyClient::get_into_ranges(const std::string& key,
+                                     const std::vector<void*>& buffer_ptrs,
+                                     const std::vector<size_t>& sizes) {
+    std::vector<uint64_t> buffers;
+    for (auto ptr : buffer_ptrs) {
+        buffers.push_back(reinterpret_cast<uint64_t>(ptr));
+    }
+    return to_py_ret(
+        invoke_rpc<&RealClient::get_into_ranges_dummy_helper, int64_t>(
+            key, buffers, sizes, client_id_));
+}
+
+int64_t DummyClient::get_object_ranges_into(
+    const std::string& key, const std::vector<uint64_t>& offsets,
+    const std::vector<void*>& buffer_ptrs, const std::vector<size_t>& sizes) {
+    std::vector<uint64_t> buffers;
+    for (auto ptr : buffer_ptrs) {
+        buffers.push_back(reinterpret_cast<uint64_t>(ptr));
+    }
+    return to_py_ret(
+        invoke_rpc<&RealClient::get_object_ranges_into_dummy_helper, int64_t>(
+            key, offsets, buffers, sizes, client_id_));
+}
+
+int DummyClient::put_from_ranges(const std::string& key,
+                                 const std::vector<void*>& buffer_ptrs,
+                                 const std::vector<size_t>& sizes,
+                                 const ReplicateConfig& config) {
+    std::vector<uint64_t> buffers;
+    for (auto ptr : buffer_ptrs) {
+        buffers.push_back(reinterpret_cast<uint64_t>(ptr));
+    }
+    return to_py_ret(
+        invoke_rpc<&RealClient::put_from_ranges_dummy_helper, void>(
+            key, buffers, sizes, config, client_id_));
+}
+
+int DummyClient::broadcast_publish(const std::string& key, void* buffer,
+                                   size_t size, size_t chunk_size,
+                                   const ReplicateConfig& config) {
+    return to_py_ret(
+        invoke_rpc<&RealClient::broadcast_publish_dummy_helper, void>(
+            key, reinterpret_cast<uint64_t>(buffer), size, chunk_size, config,
+            client_id_));
+}
+
+int64_t DummyClient::broadcast_receive(const std::string& key, void* buffer,
+                                       size_t size, int rank,
+                                       int num_subscribers, int fanout,
+                                       int64_t timeout_ms) {
+    return to_py_ret(
+        invoke_rpc<&RealClient::broadcast_receive_dummy_helper, int64_t>(
+            key, reinterpret_cast<uint64_t>(buffer), size, rank,
+            num_subscribers, fanout, timeout_ms, client_id_));
+}
+
 std::string DummyClient::get_hostname() const {
     // Dummy client does not have a hostname
     return "";
@@ -621,6 +820,29 @@ int DummyClient::put_from(const std::string& key, void* buffer, size_t size,
     return -1;
 }
 
+void DummyClient::get_into_async(const std::string& key, void* buffer,
+                                 size_t size,
+                                 std::function<void(int64_t)> callback) {
+    callback(get_into(key, buffer, size));
+}
+
+void DummyClient::batch_get_into_stream(
+    const std::vector<std::string>& keys, const std::vector<void*>& buffers,
+    const std::vector<size_t>& sizes,
+    std::function<void(size_t, int64_t)> callback) {
+    // The real client runs the whole batch within one RPC
+    auto results = batch_get_into(keys, buffers, sizes);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        callback(i, i < results.size() ? results[i] : -1);
+    }
+}
+
+void DummyClient::put_from_async(const std::string& key, void* buffer,
+                                 size_t size, const ReplicateConfig& config,
+                                 std::function<void(int)> callback) {
+    callback(put_from(key, buffer, size, config));
+}
+
 std::vector<int64_t> DummyClient::batch_get_into(
     const std::vector<std::string>& keys, const std::vector<void*>& buffer_ptrs,
     const std::vector<size_t>& sizes) {
@@ -0,0 +1,129 @@
+#include "epoch_manager.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace mooncake {
+
+struct EpochManager::ReaderRecord {
+    // Epoch in which the owning thread entered its guard, 0 if outside
+    alignas(64) std::atomic<uint64_t> epoch{0};
+    std::atomic<bool> in_use{false};
+    // Only accessed by the owning thread
+    uint32_t depth{0};
+    ReaderRecord* next{nullptr};
+};
+
+EpochManager::Guard::Guard(EpochManager& manager)
+    : record_(manager.AcquireRecord()) {
+    if (record_->depth++ == 0) {
+        // Must be ordered before the loads of the protected pointers, which
+        // is why both sides use seq_cst.
+        record_->epoch.store(manager.global_epoch_.load(),
+                             std::memory_order_seq_cst);
+    }
+}
+
+EpochManager::Guard::~Guard() {
+    if (--record_->depth == 0) {
+        record_->epoch.store(0, std::memory_order_release);
+    }
+}
+
+EpochManager& EpochManager::instance() {
+    static EpochManager manager;
+    return manager;
+}
+
+EpochManager::~EpochManager() {
+    // No reader is left when static objects are destroyed
+    for (auto& retired : retired_) {
+        retired.deleter();
+    }
+    auto* record = records_.load();
+    while (record) {
+        auto* next = record->next;
+        delete record;
+        record = next;
+    }
+}
+
+EpochManager::ReaderRecord* EpochManager::AcquireRecord() {
+    struct ThreadRecord {
+        ReaderRecord* record{nullptr};
+        ~ThreadRecord() {
+            if (record) {
+                record->in_use.store(false, std::memory_order_release);
+            }
+        }
+    };
+    thread_local ThreadRecord thread_record;
+    if (thread_record.record) {
+        return thread_record.record;
+    }
+
+    for (auto* record = records_.load(std::memory_order_acquire); record;
+         record = record->next) {
+        bool expected = false;
+        if (!record->in_use.load(std::memory_order_relaxed) &&
+            record->in_use.compare_exchange_strong(expected, true,
+                                                   std::memory_order_acq_rel)) {
+            thread_record.record = record;
+            return record;
+        }
+    }
+
+    auto* record = new ReaderRecord();
+    record->in_use.store(true, std::memory_order_relaxed);
+    auto* head = records_.load(std::memory_order_relaxed);
+    do {
+        record->next = head;
+    } while (!records_.compare_exchange_weak(head, record,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+    thread_record.record = record;
+    return record;
+}
+
+void EpochManager::Retire(std::function<void()> deleter) {
+    // Readers entering from now on can no longer reach the object
+    const uint64_t epoch = global_epoch_.fetch_add(1);
+    bool need_reclaim = false;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        retired_.push_back({epoch, std::move(deleter)});
+        need_reclaim = retired_.size() >= kReclaimThreshold;
+    }
+    if (need_reclaim) {
+        Reclaim();
+    }
+}
+
+void EpochManager::Reclaim() {
+    std::vector<Retired> reclaimable;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        uint64_t min_epoch = std::numeric_limits<uint64_t>::max();
+        for (auto* record = records_.load(std::memory_order_acquire); record;
+             record = record->next) {
+            const uint64_t epoch = record->epoch.load();
+            if (epoch != 0) {
+                min_epoch = std::min(min_epoch, epoch);
+            }
+        }
+
+        // A reader that entered in epoch e may still hold objects retired
+        // in epoch e or later.
+        auto it = std::partition(
+            retired_.begin(), retired_.end(),
+            [min_epoch](const Retired& r) { return r.epoch >= min_epoch; });
+        std::move(it, retired_.end(), std::back_inserter(reclaimable));
+        retired_.erase(it, retired_.end());
+    }
+    for (auto& retired : reclaimable) {
+        retired.deleter();
+    }
+}
+
+}  // namespace mooncake
@@ -0,0 +1,173 @@
+#include "erasure_code.h"
+
+#include <glog/logging.h>
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+namespace mooncake {
+
+namespace {
+
+// GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1 and generator 2
+struct GaloisField {
+    std::array<uint8_t, 512> exp{};
+    std::array<uint8_t, 256> log{};
+
+    GaloisField() {
+        unsigned x = 1;
+        for (size_t i = 0; i < 255; i++) {
+            exp[i] = static_cast<uint8_t>(x);
+            log[x] = static_cast<uint8_t>(i);
+            x <<= 1;
+            if (x & 0x100) {
+                x ^= 0x11d;
+            }
+        }
+        // Spare the modulo in Mul
+        for (size_t i = 255; i < exp.size(); i++) {
+            exp[i] = exp[i - 255];
+        }
+    }
+
+    uint8_t Mul(uint8_t a, uint8_t b) const {
+        if (a == 0 || b == 0) {
+            return 0;
+        }
+        return exp[log[a] + log[b]];
+    }
+
+    uint8_t Inv(uint8_t a) const { return exp[255 - log[a]]; }
+};
+
+const GaloisField& Field() {
+    static const GaloisField field;
+    return field;
+}
+
+}  // namespace
+
+ReedSolomonCode::ReedSolomonCode(size_t data_chunks, size_t parity_chunks)
+    : data_chunks_(data_chunks),
+      parity_chunks_(parity_chunks),
+      parity_matrix_(data_chunks * parity_chunks) {
+    CHECK(data_chunks > 0 && data_chunks + parity_chunks <= kMaxChunks)
+        << "data_chunks=" << data_chunks << ", parity_chunks=" << parity_chunks;
+    const auto& field = Field();
+    for (size_t j = 0; j < parity_chunks_; j++) {
+        for (size_t i = 0; i < data_chunks_; i++) {
+            // x_j = k + j and y_i = i are distinct, so x_j + y_i != 0
+            parity_matrix_[j * data_chunks_ + i] =
+                field.Inv(static_cast<uint8_t>((data_chunks_ + j) ^ i));
+        }
+    }
+}
+
+void ReedSolomonCode::MulAdd(uint8_t coefficient, const uint8_t* src,
+                             uint8_t* dst, size_t length) {
+    if (coefficient == 0) {
+        return;
+    }
+    if (coefficient == 1) {
+        for (size_t i = 0; i < length; i++) {
+            dst[i] ^= src[i];
+        }
+        return;
+    }
+    const auto& field = Field();
+    std::array<uint8_t, 256> products;
+    for (size_t x = 0; x < products.size(); x++) {
+        products[x] = field.Mul(coefficient, static_cast<uint8_t>(x));
+    }
+    for (size_t i = 0; i < length; i++) {
+        dst[i] ^= products[src[i]];
+    }
+}
+
+void ReedSolomonCode::Encode(size_t data_index, const uint8_t* data,
+                             size_t length, size_t offset,
+                             const std::vector<uint8_t*>& parity) const {
+    for (size_t j = 0; j < parity_chunks_; j++) {
+        MulAdd(parity_matrix_[j * data_chunks_ + data_index], data,
+               parity[j] + offset, length);
+    }
+}
+
+bool ReedSolomonCode::Reconstruct(const std::vector<uint8_t*>& chunks,
+                                  const std::vector<bool>& present,
+                                  size_t chunk_size) const {
+    const size_t k = data_chunks_;
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < k; i++) {
+        if (!present[i]) {
+            missing.push_back(i);
+        }
+    }
+    if (missing.empty()) {
+        return true;
+    }
+
+    // Decode from the present data chunks and as few parity chunks as needed
+    std::vector<size_t> sources;
+    for (size_t c = 0; c < k + parity_chunks_ && sources.size() < k; c++) {
+        if (present[c]) {
+            sources.push_back(c);
+        }
+    }
+    if (sources.size() < k) {
+        return false;
+    }
+
+    // Rows of the generator matrix of the sources, inverted by Gauss-Jordan
+    const auto& field = Field();
+    std::vector<uint8_t> matrix(k * k, 0);
+    std::vector<uint8_t> inverse(k * k, 0);
+    for (size_t r = 0; r < k; r++) {
+        if (sources[r] < k) {
+            matrix[r * k + sources[r]] = 1;
+        } else {
+            std::memcpy(&matrix[r * k],
+                        &parity_matrix_[(sources[r] - k) * k], k);
+        }
+        inverse[r * k + r] = 1;
+    }
+    for (size_t col = 0; col < k; col++) {
+        size_t pivot = col;
+        while (matrix[pivot * k + col] == 0) {
+            pivot++;  // always found, the matrix is invertible
+        }
+        if (pivot != col) {
+            for (size_t c = 0; c < k; c++) {
+                std::swap(matrix[pivot * k + c], matrix[col * k + c]);
+                std::swap(inverse[pivot * k + c], inverse[col * k + c]);
+            }
+        }
+        const uint8_t scale = field.Inv(matrix[col * k + col]);
+        for (size_t c = 0; c < k; c++) {
+            matrix[col * k + c] = field.Mul(matrix[col * k + c], scale);
+            inverse[col * k + c] = field.Mul(inverse[col * k + c], scale);
+        }
+        for (size_t r = 0; r < k; r++) {
+            const uint8_t factor = matrix[r * k + col];
+            if (r == col || factor == 0) {
+                continue;
+            }
+            for (size_t c = 0; c < k; c++) {
+                matrix[r * k + c] ^= field.Mul(factor, matrix[col * k + c]);
+                inverse[r * k + c] ^= field.Mul(factor, inverse[col * k + c]);
+            }
+        }
+    }
+
+    for (size_t i : missing) {
+        std::memset(chunks[i], 0, chunk_size);
+        for (size_t r = 0; r < k; r++) {
+            MulAdd(inverse[i * k + r], chunks[sources[r]], chunks[i],
+                   chunk_size);
+        }
+    }
+    return true;
+}
+
+}  // namespace mooncake
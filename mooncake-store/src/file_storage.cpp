@@ -1,5 +1,7 @@
 #include "file_storage.h"
 
+#include <algorithm>
+#include <condition_variable>
 #include <memory>
 #include <vector>
 
@@ -21,6 +23,8 @@ FileStorageConfig FileStorageConfig::FromEnvironment() {
     } else if (storage_backend_descriptor ==
                "offset_allocator_storage_backend") {
         config.storage_backend_type = StorageBackendType::kOffsetAllocator;
+    } else if (storage_backend_descriptor == "log_structured_storage_backend") {
+        config.storage_backend_type = StorageBackendType::kLogStructured;
     } else {
         LOG(ERROR) << "Unknown storage backend.";
     }
@@ -44,14 +48,25 @@ FileStorageConfig FileStorageConfig::FromEnvironment() {
     config.heartbeat_interval_seconds =
         GetEnvOr<uint32_t>("MOONCAKE_OFFLOAD_HEARTBEAT_INTERVAL_SECONDS",
                            config.heartbeat_interval_seconds);
-    config.client_buffer_gc_interval_seconds =
-        GetEnvOr<uint32_t>("MOONCAKE_OFFLOAD_CLIENT_BUFFER_GC_INTERVAL_SECONDS",
-                           config.heartbeat_interval_seconds);
 
+    config.heartbeat_max_interval_seconds =
+        GetEnvOr<uint32_t>("MOONCAKE_OFFLOAD_HEARTBEAT_MAX_INTERVAL_SECONDS",
+                           config.heartbeat_max_interval_seconds);
+
+    config.heartbeat_max_objects =
+        GetEnvOr<uint64_t>("MOONCAKE_OFFLOAD_HEARTBEAT_MAX_OBJECTS",
+                           config.heartbeat_max_objects);
+
+    config.enable_checksum = GetEnvOr<bool>("MOONCAKE_OFFLOAD_ENABLE_CHECKSUM",
+                                            config.enable_checksum);
     config.client_buffer_gc_ttl_ms =
         GetEnvOr<uint64_t>("MOONCAKE_OFFLOAD_CLIENT_BUFFER_GC_TTL_MS",
                            config.client_buffer_gc_ttl_ms);
 
+    config.client_buffer_wait_timeout_ms =
+        GetEnvOr<uint64_t>("MOONCAKE_OFFLOAD_CLIENT_BUFFER_WAIT_TIMEOUT_MS",
+                           config.client_buffer_wait_timeout_ms);
+
     return config;
 }
 
@@ -132,6 +147,11 @@ bool FileStorageConfig::Validate() const {
         LOG(ERROR) << "FileStorageConfig: heartbeat_interval_seconds must > 0";
         return false;
     }
+    if (heartbeat_max_interval_seconds < heartbeat_interval_seconds) {
+        LOG(ERROR) << "FileStorageConfig: heartbeat_max_interval_seconds must "
+                      ">= heartbeat_interval_seconds";
+        return false;
+    }
     return true;
 }
 
@@ -157,14 +177,14 @@ FileStorage::FileStorage(const FileStorageConfig& config,
 
 FileStorage::~FileStorage() {
     LOG(INFO) << "Shutdown FileStorage...";
-    heartbeat_running_ = false;
+    {
+        MutexLocker locker(&heartbeat_mutex_);
+        heartbeat_running_ = false;
+    }
+    heartbeat_cv_.notify_all();
     if (heartbeat_thread_.joinable()) {
         heartbeat_thread_.join();
     }
-    client_buffer_gc_running_ = false;
-    if (client_buffer_gc_thread_.joinable()) {
-        client_buffer_gc_thread_.join();
-    }
 }
 
 tl::expected<void, ErrorCode> FileStorage::Init() {
@@ -223,22 +243,27 @@ tl::expected<void, ErrorCode> FileStorage::Init() {
     heartbeat_running_.store(true);
     heartbeat_thread_ = std::thread([this]() {
         LOG(INFO) << "Starting periodic task with interval: "
-                  << config_.heartbeat_interval_seconds
+                  << config_.heartbeat_interval_seconds << "s to "
+                  << config_.heartbeat_max_interval_seconds
                   << "s, running is: " << heartbeat_running_.load();
+        uint32_t interval_seconds = config_.heartbeat_interval_seconds;
         while (heartbeat_running_.load()) {
-            Heartbeat();
-            std::this_thread::sleep_for(
-                std::chrono::seconds(config_.heartbeat_interval_seconds));
+            auto heartbeat_result = Heartbeat();
+            interval_seconds = NextHeartbeatInterval(
+                interval_seconds,
+                heartbeat_result ? heartbeat_result.value() : 0);
+            MutexLocker locker(&heartbeat_mutex_);
+            heartbeat_cv_.wait_for(
+                locker, std::chrono::seconds(interval_seconds),
+                [this]() { return !heartbeat_running_.load(); });
         }
     });
-    client_buffer_gc_running_.store(true);
-    client_buffer_gc_thread_ =
-        std::thread(&FileStorage::ClientBufferGCThreadFunc, this);
     return {};
 }
 
 tl::expected<std::vector<uint64_t>, ErrorCode> FileStorage::BatchGet(
-    const std::vector<std::string>& keys, const std::vector<int64_t>& sizes) {
+    const std::vector<std::string>& keys, const std::vector<int64_t>& sizes,
+    uint64_t& batch_id) {
     auto start_time = std::chrono::steady_clock::now();
     auto allocate_res = AllocateBatch(keys, sizes);
     if (!allocate_res) {
@@ -251,15 +276,36 @@ tl::expected<std::vector<uint64_t>, ErrorCode> FileStorage::BatchGet(
         LOG(ERROR) << "Batch load object failed,err_code = " << result.error();
         return tl::make_unexpected(result.error());
     }
-    MutexLocker locker(&client_buffer_mutex_);
-    client_buffer_allocated_batches_.emplace_back(std::move(allocated_batch));
+    allocated_batch->lease_timeout =
+        std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(config_.client_buffer_gc_ttl_ms);
+    {
+        MutexLocker locker(&client_buffer_mutex_);
+        batch_id = next_batch_id_++;
+        client_buffer_leased_batches_.emplace(batch_id, allocated_batch);
+    }
     auto end_time = std::chrono::steady_clock::now();
     auto elapsed_time = std::chrono::duration_cast<std::chrono::microseconds>(
                             end_time - start_time)
                             .count();
     VLOG(1) << "Time taken for FileStorage::BatchGet: " << elapsed_time
             << "us, key size: " << keys.size();
-    return allocate_res.value<>()->pointers;
+    return allocated_batch->pointers;
+}
+
+void FileStorage::ReleaseBatch(uint64_t batch_id) {
+    std::shared_ptr<AllocatedBatch> released;
+    {
+        MutexLocker locker(&client_buffer_mutex_);
+        auto it = client_buffer_leased_batches_.find(batch_id);
+        if (it == client_buffer_leased_batches_.end()) {
+            VLOG(1) << "Batch " << batch_id << " is not leased";
+            return;
+        }
+        released = std::move(it->second);
+        client_buffer_leased_batches_.erase(it);
+    }
+    // The buffer is freed here, unless a BatchGet still loads into it
 }
 
 tl::expected<void, ErrorCode> FileStorage::OffloadObjects(
@@ -339,7 +385,21 @@ tl::expected<bool, ErrorCode> FileStorage::IsEnableOffloading() {
     return enable_offloading;
 }
 
-tl::expected<void, ErrorCode> FileStorage::Heartbeat() {
+uint32_t FileStorage::NextHeartbeatInterval(uint32_t interval_seconds,
+                                            size_t received_objects) const {
+    if (config_.heartbeat_max_objects > 0 &&
+        received_objects >= config_.heartbeat_max_objects) {
+        // The master has more queued than one heartbeat returns
+        return 0;
+    }
+    if (received_objects > 0 || interval_seconds == 0) {
+        return config_.heartbeat_interval_seconds;
+    }
+    return std::min(interval_seconds * 2,
+                    config_.heartbeat_max_interval_seconds);
+}
+
+tl::expected<size_t, ErrorCode> FileStorage::Heartbeat() {
     if (client_ == nullptr) {
         LOG(ERROR) << "client is nullptr";
         return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
@@ -351,11 +411,12 @@ tl::expected<void, ErrorCode> FileStorage::Heartbeat() {
     {
         MutexLocker locker(&offloading_mutex_);
         auto heartbeat_result = client_->OffloadObjectHeartbeat(
-            enable_offloading_, offloading_objects);
+            enable_offloading_, offloading_objects,
+            config_.heartbeat_max_objects);
         if (!heartbeat_result) {
             LOG(ERROR) << "Failed to send heartbeat with error: "
                        << heartbeat_result.error();
-            return heartbeat_result;
+            return tl::make_unexpected(heartbeat_result.error());
         }
     }
 
@@ -364,12 +425,12 @@ tl::expected<void, ErrorCode> FileStorage::Heartbeat() {
     if (!offload_result) {
         LOG(ERROR) << "Failed to persist objects with error: "
                    << offload_result.error();
-        return offload_result;
+        return tl::make_unexpected(offload_result.error());
     }
 
     // TODO(eviction): Implement an LRU eviction mechanism to manage local
     // storage capacity.
-    return {};
+    return offloading_objects.size();
 }
 
 tl::expected<void, ErrorCode> FileStorage::BatchLoad(
@@ -436,76 +497,107 @@ tl::expected<void, ErrorCode> FileStorage::RegisterLocalMemory() {
         LOG(ERROR) << "Failed to register local memory: " << error_code.error();
         return error_code;
     }
+    storage_backend_->RegisterLoadBuffer(client_buffer_allocator_->getBase(),
+                                         config_.local_buffer_size);
     return {};
 }
 
 tl::expected<std::shared_ptr<FileStorage::AllocatedBatch>, ErrorCode>
 FileStorage::AllocateBatch(const std::vector<std::string>& keys,
                            const std::vector<int64_t>& sizes) {
-    auto result = std::make_shared<AllocatedBatch>();
-    std::chrono::steady_clock::time_point now =
-        std::chrono::steady_clock::now();
-    auto lease_timeout =
-        now + std::chrono::milliseconds(config_.client_buffer_gc_ttl_ms);
-    u_int64_t total_size = 0;
-    bool gc_triggered = false;
+    uint64_t total_size = 0;
     for (size_t i = 0; i < keys.size(); ++i) {
         assert(sizes[i] <= kMaxSliceSize);
-        auto alloc_result = client_buffer_allocator_->allocate(sizes[i]);
-        if (!alloc_result && !gc_triggered) {
-            gc_triggered = true;
-            {
-                MutexLocker locker(&client_buffer_mutex_);
-                auto gc_now = std::chrono::steady_clock::now();
-                auto it = client_buffer_allocated_batches_.begin();
-                while (it != client_buffer_allocated_batches_.end()) {
-                    if (gc_now >= (*it)->lease_timeout) {
-                        it = client_buffer_allocated_batches_.erase(it);
-                    } else {
-                        ++it;
-                    }
+        total_size += sizes[i];
+    }
+    if (total_size > static_cast<uint64_t>(config_.local_buffer_size)) {
+        LOG(ERROR) << "Batch of " << total_size
+                   << " bytes exceeds the client buffer of "
+                   << config_.local_buffer_size << " bytes";
+        return tl::make_unexpected(ErrorCode::BUFFER_OVERFLOW);
+    }
+
+    const auto deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(config_.client_buffer_wait_timeout_ms);
+    while (true) {
+        uint64_t release_seq;
+        {
+            MutexLocker locker(&client_buffer_mutex_);
+            release_seq = client_buffer_release_seq_;
+        }
+        // The deleter hands the buffer back and wakes up the batches waiting
+        // for it, as soon as the last reference to the batch is dropped
+        std::shared_ptr<AllocatedBatch> result(
+            new AllocatedBatch(), [this](AllocatedBatch* batch) {
+                delete batch;
+                {
+                    MutexLocker locker(&client_buffer_mutex_);
+                    ++client_buffer_release_seq_;
                 }
+                client_buffer_released_cv_.notify_all();
+            });
+        size_t failed_index = keys.size();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto alloc_result = client_buffer_allocator_->allocate(sizes[i]);
+            if (!alloc_result) {
+                failed_index = i;
+                break;
             }
-            alloc_result = client_buffer_allocator_->allocate(sizes[i]);
+            result->slices.emplace(
+                keys[i],
+                Slice{alloc_result->ptr(), static_cast<size_t>(sizes[i])});
+            result->pointers.emplace_back(
+                reinterpret_cast<uintptr_t>(alloc_result->ptr()));
+            result->handles.emplace_back(std::move(alloc_result.value()));
         }
-        if (!alloc_result) {
-            LOG(ERROR) << "Failed to allocate slice buffer, size = " << sizes[i]
-                       << ", key = " << keys[i];
-            return tl::make_unexpected(ErrorCode::BUFFER_OVERFLOW);
+        if (failed_index == keys.size()) {
+            result->total_size = total_size;
+            return result;
         }
-        total_size += sizes[i];
-        result->slices.emplace(
-            keys[i], Slice{alloc_result->ptr(), static_cast<size_t>(sizes[i])});
-        result->pointers.emplace_back(
-            reinterpret_cast<uintptr_t>(alloc_result->ptr()));
-        result->handles.emplace_back(std::move(alloc_result.value()));
-        result->lease_timeout = lease_timeout;
-    }
-    result->total_size = total_size;
-    return result;
-}
 
-void FileStorage::ClientBufferGCThreadFunc() {
-    LOG(INFO) << "action=client_buffer_gc_thread_started";
-    while (client_buffer_gc_running_) {
-        {
-            MutexLocker locker(&client_buffer_mutex_);
-            if (!client_buffer_allocated_batches_.empty()) {
-                auto now = std::chrono::steady_clock::now();
-                client_buffer_allocated_batches_.erase(
-                    std::remove_if(
-                        client_buffer_allocated_batches_.begin(),
-                        client_buffer_allocated_batches_.end(),
-                        [&](const std::shared_ptr<AllocatedBatch>& batch) {
-                            return now >= batch->lease_timeout;
-                        }),
-                    client_buffer_allocated_batches_.end());
+        // Give back what was allocated rather than holding it while waiting,
+        // so that concurrent batches cannot starve each other. This release
+        // counts itself, it must not wake this batch up.
+        result.reset();
+        ++release_seq;
+        std::vector<std::shared_ptr<AllocatedBatch>> expired;
+        MutexLocker locker(&client_buffer_mutex_);
+        expired = TakeExpiredBatches();
+        if (!expired.empty()) {
+            LOG(WARNING) << "Reclaimed " << expired.size()
+                         << " client buffer batches with expired leases";
+            locker.unlock();
+            expired.clear();
+            continue;
+        }
+        while (client_buffer_release_seq_ == release_seq) {
+            if (client_buffer_released_cv_.wait_until(locker, deadline) ==
+                    std::cv_status::timeout &&
+                client_buffer_release_seq_ == release_seq) {
+                LOG(ERROR) << "Failed to allocate slice buffer, size = "
+                           << sizes[failed_index]
+                           << ", key = " << keys[failed_index];
+                return tl::make_unexpected(ErrorCode::BUFFER_OVERFLOW);
             }
         }
-        std::this_thread::sleep_for(
-            std::chrono::seconds(config_.client_buffer_gc_interval_seconds));
     }
-    LOG(INFO) << "action=client_buffer_gc_thread_stopped";
+}
+
+std::vector<std::shared_ptr<FileStorage::AllocatedBatch>>
+FileStorage::TakeExpiredBatches() {
+    std::vector<std::shared_ptr<AllocatedBatch>> expired;
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = client_buffer_leased_batches_.begin();
+         it != client_buffer_leased_batches_.end();) {
+        if (now >= it->second->lease_timeout) {
+            expired.emplace_back(std::move(it->second));
+            it = client_buffer_leased_batches_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return expired;
 }
 
 }  // namespace mooncake
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "frequency_sketch.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace mooncake {
+
+FrequencySketch::FrequencySketch(size_t width)
+    : width_(std::bit_ceil(std::max<size_t>(width, 64))),
+      sample_size_(kSampleFactor * width_),
+      counters_(std::make_unique<std::atomic<uint8_t>[]>(kDepth * width_)) {}
+
+size_t FrequencySketch::Index(size_t key_hash, size_t row) const {
+    // Derive an independent hash per row from the key hash
+    uint64_t h = key_hash + (row + 1) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return row * width_ + (h & (width_ - 1));
+}
+
+void FrequencySketch::Increment(size_t key_hash) {
+    for (size_t row = 0; row < kDepth; row++) {
+        auto& counter = counters_[Index(key_hash, row)];
+        uint8_t count = counter.load(std::memory_order_relaxed);
+        if (count < kMaxCount) {
+            counter.compare_exchange_weak(count, count + 1,
+                                          std::memory_order_relaxed);
+        }
+    }
+    num_increments_.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint8_t FrequencySketch::Estimate(size_t key_hash) const {
+    uint8_t estimate = kMaxCount;
+    for (size_t row = 0; row < kDepth; row++) {
+        estimate = std::min(
+            estimate,
+            counters_[Index(key_hash, row)].load(std::memory_order_relaxed));
+    }
+    return estimate;
+}
+
+bool FrequencySketch::Age() {
+    const size_t num_increments =
+        num_increments_.load(std::memory_order_relaxed);
+    if (num_increments < sample_size_) {
+        return false;
+    }
+    for (size_t i = 0; i < kDepth * width_; i++) {
+        counters_[i].store(counters_[i].load(std::memory_order_relaxed) / 2,
+                           std::memory_order_relaxed);
+    }
+    // Like the counters, the accesses counted so far weigh half
+    num_increments_.fetch_sub(num_increments - num_increments / 2,
+                              std::memory_order_relaxed);
+    return true;
+}
+
+}  // namespace mooncake
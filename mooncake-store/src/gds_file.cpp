@@ -0,0 +1,230 @@
+#include "gds_file.h"
+
+#include <cuda_runtime.h>
+#include <cufile.h>
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace mooncake {
+
+namespace {
+
+// Device reads without cuFile are staged through host memory in chunks of
+// this size
+constexpr size_t kStagingChunkSize = 8 * 1024 * 1024;
+
+bool OpenCuFileDriver() {
+    static const bool opened = [] {
+        CUfileError_t status = cuFileDriverOpen();
+        if (status.err != CU_FILE_SUCCESS) {
+            LOG(WARNING) << "error=cufile_driver_open_failed, code="
+                         << status.err
+                         << ", staging device I/O through host memory";
+            return false;
+        }
+        return true;
+    }();
+    return opened;
+}
+
+}  // namespace
+
+GdsFile::GdsFile(const std::string& filename, int fd, int direct_fd)
+    : PosixFile(filename, fd), direct_fd_(direct_fd) {
+    if (direct_fd_ < 0 || !OpenCuFileDriver()) {
+        return;
+    }
+    CUfileDescr_t descr{};
+    descr.handle.fd = direct_fd_;
+    descr.type = CU_FILE_HANDLE_TYPE_OPAQUE_FD;
+    CUfileHandle_t handle;
+    CUfileError_t status = cuFileHandleRegister(&handle, &descr);
+    if (status.err != CU_FILE_SUCCESS) {
+        VLOG(1) << "file=" << filename << ", code=" << status.err
+                << ", info=cufile_handle_register_failed";
+        return;
+    }
+    handle_ = handle;
+}
+
+GdsFile::~GdsFile() {
+    if (handle_ != nullptr) {
+        cuFileHandleDeregister(static_cast<CUfileHandle_t>(handle_));
+    }
+    if (direct_fd_ >= 0 && close(direct_fd_) != 0) {
+        LOG(WARNING) << "Failed to close file: " << filename_;
+    }
+}
+
+bool GdsFile::IsDeviceMemory(const void* ptr) {
+    cudaPointerAttributes attributes;
+    if (cudaPointerGetAttributes(&attributes, ptr) != cudaSuccess) {
+        cudaGetLastError();  // clear the error of unregistered memory
+        return false;
+    }
+    return attributes.type == cudaMemoryTypeDevice;
+}
+
+tl::expected<size_t, ErrorCode> GdsFile::ReadHost(void* dst, size_t length,
+                                                  off_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pread(fd_, static_cast<char*>(dst) + done, length - done,
+                            offset + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
+        }
+        if (n == 0) {
+            break;  // EOF
+        }
+        done += n;
+    }
+    return done;
+}
+
+tl::expected<size_t, ErrorCode> GdsFile::WriteHost(const void* src,
+                                                   size_t length,
+                                                   off_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pwrite(fd_, static_cast<const char*>(src) + done,
+                             length - done, offset + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
+        }
+        done += n;
+    }
+    return done;
+}
+
+tl::expected<size_t, ErrorCode> GdsFile::ReadDevice(void* dst, size_t length,
+                                                    off_t offset) {
+    if (handle_ != nullptr) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t n = cuFileRead(static_cast<CUfileHandle_t>(handle_), dst,
+                                   length - done, offset + done, done);
+            if (n < 0) {
+                LOG(ERROR) << "file=" << filename_
+                           << ", error=cufile_read_failed, code=" << n;
+                return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
+            }
+            if (n == 0) {
+                break;  // EOF
+            }
+            done += n;
+        }
+        return done;
+    }
+
+    std::vector<char> staging(std::min(length, kStagingChunkSize));
+    size_t done = 0;
+    while (done < length) {
+        const size_t chunk = std::min(length - done, staging.size());
+        auto result = ReadHost(staging.data(), chunk, offset + done);
+        if (!result) {
+            return result;
+        }
+        if (cudaMemcpy(static_cast<char*>(dst) + done, staging.data(),
+                       result.value(),
+                       cudaMemcpyHostToDevice) != cudaSuccess) {
+            LOG(ERROR) << "file=" << filename_ << ", error=cuda_memcpy_failed";
+            return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
+        }
+        done += result.value();
+        if (result.value() < chunk) {
+            break;  // EOF
+        }
+    }
+    return done;
+}
+
+tl::expected<size_t, ErrorCode> GdsFile::WriteDevice(const void* src,
+                                                     size_t length,
+                                                     off_t offset) {
+    if (handle_ != nullptr) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t n = cuFileWrite(static_cast<CUfileHandle_t>(handle_), src,
+                                    length - done, offset + done, done);
+            if (n <= 0) {
+                LOG(ERROR) << "file=" << filename_
+                           << ", error=cufile_write_failed, code=" << n;
+                return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
+            }
+            done += n;
+        }
+        return done;
+    }
+
+    std::vector<char> staging(std::min(length, kStagingChunkSize));
+    size_t done = 0;
+    while (done < length) {
+        const size_t chunk = std::min(length - done, staging.size());
+        if (cudaMemcpy(staging.data(), static_cast<const char*>(src) + done,
+                       chunk, cudaMemcpyDeviceToHost) != cudaSuccess) {
+            LOG(ERROR) << "file=" << filename_ << ", error=cuda_memcpy_failed";
+            return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
+        }
+        auto result = WriteHost(staging.data(), chunk, offset + done);
+        if (!result) {
+            return result;
+        }
+        done += chunk;
+    }
+    return done;
+}
+
+tl::expected<size_t, ErrorCode> GdsFile::vector_read(const iovec* iov,
+                                                     int iovcnt,
+                                                     off_t offset) {
+    if (fd_ < 0) {
+        return make_error<size_t>(ErrorCode::FILE_NOT_FOUND);
+    }
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        auto result =
+            IsDeviceMemory(iov[i].iov_base)
+                ? ReadDevice(iov[i].iov_base, iov[i].iov_len, offset + total)
+                : ReadHost(iov[i].iov_base, iov[i].iov_len, offset + total);
+        if (!result) {
+            return result;
+        }
+        total += result.value();
+        if (result.value() < iov[i].iov_len) {
+            break;  // EOF, as preadv
+        }
+    }
+    return total;
+}
+
+tl::expected<size_t, ErrorCode> GdsFile::vector_write(const iovec* iov,
+                                                      int iovcnt,
+                                                      off_t offset) {
+    if (fd_ < 0) {
+        return make_error<size_t>(ErrorCode::FILE_NOT_FOUND);
+    }
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        auto result =
+            IsDeviceMemory(iov[i].iov_base)
+                ? WriteDevice(iov[i].iov_base, iov[i].iov_len, offset + total)
+                : WriteHost(iov[i].iov_base, iov[i].iov_len, offset + total);
+        if (!result) {
+            return result;
+        }
+        total += result.value();
+    }
+    return total;
+}
+
+}  // namespace mooncake
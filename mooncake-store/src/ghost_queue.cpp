@@ -0,0 +1,31 @@
+#include "ghost_queue.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace mooncake {
+
+GhostQueue::GhostQueue(size_t capacity)
+    : capacity_(std::bit_ceil(std::max<size_t>(capacity, 64))),
+      slots_(std::make_unique<std::atomic<size_t>[]>(capacity_)) {}
+
+size_t GhostQueue::Index(size_t key_hash) const {
+    // Mix the bits, std::hash of integers is the identity
+    uint64_t h = key_hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h & (capacity_ - 1);
+}
+
+void GhostQueue::Insert(size_t key_hash) {
+    slots_[Index(key_hash)].store(Tag(key_hash), std::memory_order_relaxed);
+}
+
+bool GhostQueue::Remove(size_t key_hash) {
+    size_t tag = Tag(key_hash);
+    return slots_[Index(key_hash)].compare_exchange_strong(
+        tag, 0, std::memory_order_relaxed);
+}
+
+}  // namespace mooncake
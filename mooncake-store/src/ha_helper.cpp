@@ -1,10 +1,16 @@
 #include "ha_helper.h"
+
+#include <string_view>
+
 #include "etcd_helper.h"
+#include "metadata_follower.h"
 #include "rpc_service.h"
 
 namespace mooncake {
 
-MasterViewHelper::MasterViewHelper() {
+namespace {
+
+std::string MasterViewKey() {
     std::string cluster_id;
     const char* cluster_id_env = std::getenv("MC_STORE_CLUSTER_ID");
     if (cluster_id_env != nullptr && strlen(cluster_id_env) > 0) {
@@ -16,7 +22,19 @@ MasterViewHelper::MasterViewHelper() {
     if (!cluster_id.empty() && cluster_id.back() != '/') {
         cluster_id += '/';
     }
-    master_view_key_ = "mooncake-store/" + cluster_id + "master_view";
+    return "mooncake-store/" + cluster_id + "master_view";
+}
+
+// Event types of EtcdHelper::WatchWithPrefixFromRevision
+constexpr int kWatchEventPut = 0;
+constexpr int kWatchEventBroken = 2;
+
+constexpr int kWatchStopTimeoutMs = 5000;
+constexpr auto kWatchRetryInterval = std::chrono::seconds(1);
+
+}  // namespace
+
+MasterViewHelper::MasterViewHelper() : master_view_key_(MasterViewKey()) {
     LOG(INFO) << "Master view key: " << master_view_key_;
 }
 
@@ -26,7 +44,7 @@ ErrorCode MasterViewHelper::ConnectToEtcd(const std::string& etcd_endpoints) {
 
 void MasterViewHelper::ElectLeader(const std::string& master_address,
                                    ViewVersionId& version,
-                                   EtcdLeaseId& lease_id) {
+                                   EtcdLeaseId& lease_id, int64_t lease_ttl) {
     while (true) {
         // Check if there is already a leader
         ViewVersionId current_version = 0;
@@ -61,7 +79,7 @@ void MasterViewHelper::ElectLeader(const std::string& master_address,
         // try to elect ourselves as the leader. We vote ourselfves
         // as the leader by trying to creating the key in a transaction.
         // The one who successfully creates the key is the leader.
-        ret = EtcdHelper::GrantLease(ETCD_MASTER_VIEW_LEASE_TTL, lease_id);
+        ret = EtcdHelper::GrantLease(lease_ttl, lease_id);
         if (ret != ErrorCode::OK) {
             LOG(ERROR) << "Failed to grant lease: " << ret;
             std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -109,6 +127,118 @@ ErrorCode MasterViewHelper::GetMasterView(std::string& master_address,
     }
 }
 
+MasterViewWatcher& MasterViewWatcher::Instance() {
+    // Never destroyed, so that it outlives the etcd watch at exit
+    static MasterViewWatcher* watcher = new MasterViewWatcher();
+    return *watcher;
+}
+
+MasterViewWatcher::MasterViewWatcher() : master_view_key_(MasterViewKey()) {}
+
+uint64_t MasterViewWatcher::Subscribe(Callback callback) {
+    std::lock_guard<std::mutex> subscribe_lock(subscribe_mutex_);
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        callbacks_.emplace(id, std::move(callback));
+    }
+    if (!watch_thread_.joinable()) {
+        watch_thread_ = std::thread(&MasterViewWatcher::WatchThreadMain, this);
+    }
+    return id;
+}
+
+void MasterViewWatcher::Unsubscribe(uint64_t id) {
+    std::lock_guard<std::mutex> subscribe_lock(subscribe_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callbacks_.erase(id);
+        if (!callbacks_.empty()) {
+            return;
+        }
+    }
+    cv_.notify_all();
+    if (watch_thread_.joinable()) {
+        watch_thread_.join();
+    }
+}
+
+void MasterViewWatcher::OnWatchEvent(void* context, const char* key,
+                                     size_t key_size, const char* value,
+                                     size_t value_size, int event_type,
+                                     int64_t revision) {
+    auto* watcher = static_cast<MasterViewWatcher*>(context);
+    if (event_type == kWatchEventBroken) {
+        std::lock_guard<std::mutex> lock(watcher->mutex_);
+        watcher->watch_broken_ = true;
+        watcher->cv_.notify_all();
+        return;
+    }
+    // The watch is on a prefix, skip longer keys. A deleted view only means
+    // the election is under way.
+    if (event_type != kWatchEventPut ||
+        std::string_view(key, key_size) != watcher->master_view_key_) {
+        return;
+    }
+    watcher->Notify(std::string(value, value_size), revision);
+}
+
+void MasterViewWatcher::Notify(const std::string& master_address,
+                               ViewVersionId version) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (version <= last_version_) {
+        return;
+    }
+    last_version_ = version;
+    LOG(INFO) << "New master view: " << master_address
+              << ", version: " << version;
+    for (auto& [id, callback] : callbacks_) {
+        callback(master_address, version);
+    }
+}
+
+void MasterViewWatcher::WatchThreadMain() {
+    bool watched_before = false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!callbacks_.empty()) {
+        watch_broken_ = false;
+        lock.unlock();
+        auto err = EtcdHelper::WatchWithPrefixFromRevision(
+            master_view_key_.c_str(), master_view_key_.size(), 0, this,
+            &MasterViewWatcher::OnWatchEvent);
+        if (err == ErrorCode::OK && watched_before) {
+            // A leader elected while the watch was down is not reported
+            std::string master_address;
+            ViewVersionId version = 0;
+            if (EtcdHelper::Get(master_view_key_.c_str(),
+                                master_view_key_.size(), master_address,
+                                version) == ErrorCode::OK) {
+                Notify(master_address, version);
+            }
+        }
+        lock.lock();
+
+        if (err == ErrorCode::OK) {
+            watched_before = true;
+            cv_.wait(lock,
+                     [this] { return watch_broken_ || callbacks_.empty(); });
+            const bool broken = watch_broken_;
+            lock.unlock();
+            if (!broken) {
+                EtcdHelper::CancelWatchWithPrefix(master_view_key_.c_str(),
+                                                  master_view_key_.size());
+            }
+            EtcdHelper::WaitWatchWithPrefixStopped(master_view_key_.c_str(),
+                                                   master_view_key_.size(),
+                                                   kWatchStopTimeoutMs);
+            lock.lock();
+        }
+        cv_.wait_for(lock, kWatchRetryInterval,
+                     [this] { return callbacks_.empty(); });
+    }
+}
+
 MasterServiceSupervisor::MasterServiceSupervisor(
     const MasterServiceSupervisorConfig& config)
     : config_(config) {}
@@ -131,12 +261,57 @@ int MasterServiceSupervisor::Start() {
                        << config_.etcd_endpoints;
             return -1;
         }
+        // A hot standby tails the leader's persisted metadata while waiting
+        // for leadership, and optionally serves read-only queries from it.
+        std::shared_ptr<MetadataFollower> metadata_follower;
+        std::unique_ptr<WrappedMasterService> standby_master_service;
+        std::unique_ptr<coro_rpc::coro_rpc_server> standby_server;
+        if (config_.enable_hot_standby) {
+            if (config_.metadata_persist_dir.empty()) {
+                LOG(WARNING) << "Hot standby requires metadata_persist_dir, "
+                                "running as a cold standby";
+            } else {
+                metadata_follower = std::make_shared<MetadataFollower>(
+                    config_.metadata_persist_dir);
+                metadata_follower->Start();
+            }
+        }
+        if (metadata_follower && config_.standby_rpc_port > 0) {
+            standby_master_service =
+                std::make_unique<WrappedMasterService>(metadata_follower);
+            standby_server = std::make_unique<coro_rpc::coro_rpc_server>(
+                config_.rpc_thread_num, config_.standby_rpc_port,
+                config_.rpc_address, config_.rpc_conn_timeout,
+                config_.rpc_enable_tcp_no_delay);
+            RegisterStandbyRpcService(*standby_server,
+                                      *standby_master_service);
+            auto standby_ec = standby_server->async_start();
+            if (standby_ec.hasResult()) {
+                LOG(ERROR) << "Failed to start standby service on port "
+                           << config_.standby_rpc_port << ": "
+                           << standby_ec.result().value();
+                standby_server.reset();
+            } else {
+                LOG(INFO) << "Standby service started on port "
+                          << config_.standby_rpc_port;
+            }
+        }
+
         LOG(INFO) << "Trying to elect self as leader...";
         EtcdLeaseId lease_id = 0;
         // view_version will be updated by ElectLeader and then used in
         // WrappedMasterService
         ViewVersionId view_version = 0;
-        mv_helper.ElectLeader(config_.local_hostname, view_version, lease_id);
+        mv_helper.ElectLeader(config_.local_hostname, view_version, lease_id,
+                              config_.etcd_lease_ttl_sec);
+
+        // Reads must not be served from the copy once this master may start
+        // accepting writes.
+        if (standby_server) {
+            standby_server->stop();
+            standby_server.reset();
+        }
+        standby_master_service.reset();
 
         // Start a thread to keep the leader alive
         auto keep_leader_thread =
@@ -147,15 +322,27 @@ int MasterServiceSupervisor::Start() {
             });
 
         // To prevent potential split-brain, wait long enough for the old leader
-        // to retire.
-        const int waiting_time = ETCD_MASTER_VIEW_LEASE_TTL;
-        std::this_thread::sleep_for(std::chrono::seconds(waiting_time));
+        // to retire. It stops serving once its lease can no longer be kept
+        // alive, which takes at most one lease TTL.
+        std::this_thread::sleep_for(
+            std::chrono::seconds(config_.etcd_lease_ttl_sec));
 
         LOG(INFO) << "Starting master service...";
-        mooncake::WrappedMasterService wrapped_master_service(
-            mooncake::WrappedMasterServiceConfig(config_, view_version));
+        mooncake::WrappedMasterServiceConfig wrapped_config(config_,
+                                                            view_version);
+        // The follower keeps tailing until here, so the writes of the old
+        // leader made during the waiting time are not missed.
+        wrapped_config.metadata_follower = std::move(metadata_follower);
+        mooncake::WrappedMasterService wrapped_master_service(wrapped_config);
         mooncake::RegisterRpcService(server, wrapped_master_service);
         // Metric reporting is now handled by WrappedMasterService.
+        // Stopped before the service it calls is destroyed
+        std::unique_ptr<coro_rpc::coro_rpc_server> rdma_server;
+        if (config_.rdma_rpc_port > 0) {
+            rdma_server = StartRdmaRpcServer(
+                config_.rpc_thread_num, config_.rdma_rpc_port,
+                config_.rpc_address, wrapped_master_service);
+        }
 
         async_simple::Future<coro_rpc::err_code> ec =
             server.async_start();  // won't block here
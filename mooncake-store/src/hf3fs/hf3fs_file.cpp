@@ -5,6 +5,9 @@
 #include <unistd.h>
 #include <sys/file.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace mooncake {
 
 ThreeFSFile::ThreeFSFile(const std::string& filename, int fd,
@@ -49,57 +52,18 @@ tl::expected<size_t, ErrorCode> ThreeFSFile::write(std::span<const char> data,
         return make_error<size_t>(ErrorCode::FILE_OPEN_FAIL);
     }
 
-    // 3. Write in chunks
-    auto& threefs_iov = resource->iov_;
-    auto& ior_write = resource->ior_write_;
+    // 3. Write in batches of blocks
     const char* data_ptr = data.data();
-    size_t total_bytes_written = 0;
-    off_t current_offset = 0;
-    const size_t max_chunk_size = resource->config_.iov_size;
-
-    while (total_bytes_written < length) {
-        // Calculate current chunk size
-        size_t chunk_size =
-            std::min(length - total_bytes_written, max_chunk_size);
-
-        // Copy data to shared buffer
-        memcpy(threefs_iov.base, data_ptr + total_bytes_written, chunk_size);
-
-        // Prepare IO request
-        int ret =
-            hf3fs_prep_io(&ior_write, &threefs_iov, false, threefs_iov.base,
-                          fd_, current_offset, chunk_size, nullptr);
-        if (ret < 0) {
-            return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
-        }
-
-        // Submit IO request
-        ret = hf3fs_submit_ios(&ior_write);
-        if (ret < 0) {
-            return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
-        }
-
-        // Wait for IO completion
-        struct hf3fs_cqe cqe;
-        ret = hf3fs_wait_for_ios(&ior_write, &cqe, 1, 1, nullptr);
-        if (ret < 0 || cqe.result < 0) {
-            return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
-        }
-
-        size_t bytes_written = cqe.result;
-        total_bytes_written += bytes_written;
-        current_offset += bytes_written;
-
-        if (bytes_written < chunk_size) {
-            break;  // Short write, possibly disk full
-        }
-    }
-
-    if (total_bytes_written != length) {
+    auto result = resource->BatchIO(
+        fd_, false, {{0, length}},
+        [&](char* buffer, size_t, size_t pos, size_t size) {
+            memcpy(buffer, data_ptr + pos, size);
+        });
+    if (!result || (*result)[0] != length) {
         return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
     }
 
-    return total_bytes_written;
+    return length;
 }
 
 tl::expected<size_t, ErrorCode> ThreeFSFile::read(std::string& buffer,
@@ -115,62 +79,67 @@ tl::expected<size_t, ErrorCode> ThreeFSFile::read(std::string& buffer,
         return make_error<size_t>(ErrorCode::FILE_OPEN_FAIL);
     }
 
-    // 3. Prepare buffer
-    buffer.clear();
-    buffer.reserve(length);
-    size_t total_bytes_read = 0;
-    off_t current_offset = 0;
-    auto& threefs_iov = resource->iov_;
-    auto& ior_read = resource->ior_read_;
-
-    // 5. Read in chunks
-    while (total_bytes_read < length) {
-        // Calculate current chunk size
-        size_t chunk_size = std::min<size_t>(length - total_bytes_read,
-                                             resource->config_.iov_size);
-
-        // Prepare IO request
-        int ret = hf3fs_prep_io(&ior_read, &threefs_iov, true, threefs_iov.base,
-                                fd_, current_offset, chunk_size, nullptr);
-        if (ret < 0) {
-            return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
-        }
-
-        // Submit IO request
-        ret = hf3fs_submit_ios(&ior_read);
-        if (ret < 0) {
-            return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
-        }
-
-        // Wait for IO completion
-        struct hf3fs_cqe cqe;
-        ret = hf3fs_wait_for_ios(&ior_read, &cqe, 1, 1, nullptr);
-        if (ret < 0 || cqe.result < 0) {
-            return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
-        }
-
-        size_t bytes_read = cqe.result;
-        if (bytes_read == 0) {  // EOF
-            break;
-        }
+    // 3. Read in batches of blocks
+    buffer.resize(length);
+    auto result = resource->BatchIO(
+        fd_, true, {{0, length}},
+        [&](char* iov_buffer, size_t, size_t pos, size_t size) {
+            memcpy(buffer.data() + pos, iov_buffer, size);
+        });
+    if (!result || (*result)[0] != length) {
+        buffer.clear();
+        return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
+    }
 
-        // Append data to buffer
-        buffer.append(reinterpret_cast<char*>(threefs_iov.base), bytes_read);
-        total_bytes_read += bytes_read;
-        current_offset += bytes_read;
+    return length;
+}
 
-        if (bytes_read < chunk_size) {  // Short read
-            break;
+namespace {
+
+// Copies between consecutive positions of the caller's iovecs and the
+// blocks of the 3FS iov
+class IovecCursor {
+   public:
+    IovecCursor(const iovec* iov, int iovcnt) : iov_(iov), iovcnt_(iovcnt) {}
+
+    void copy(char* buffer, size_t size, bool to_iovecs) {
+        while (size > 0 && index_ < iovcnt_) {
+            const iovec& current = iov_[index_];
+            const size_t copy_size =
+                std::min(size, current.iov_len - offset_);
+            char* user = static_cast<char*>(current.iov_base) + offset_;
+            if (to_iovecs) {
+                memcpy(user, buffer, copy_size);
+            } else {
+                memcpy(buffer, user, copy_size);
+            }
+            buffer += copy_size;
+            size -= copy_size;
+            offset_ += copy_size;
+            if (offset_ >= current.iov_len) {
+                index_++;
+                offset_ = 0;
+            }
         }
     }
 
-    if (total_bytes_read != length) {
-        return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
-    }
+   private:
+    const iovec* iov_;
+    int iovcnt_;
+    int index_ = 0;
+    size_t offset_ = 0;
+};
 
-    return total_bytes_read;
+size_t TotalLength(const iovec* iov, int iovcnt) {
+    size_t total_length = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        total_length += iov[i].iov_len;
+    }
+    return total_length;
 }
 
+}  // namespace
+
 tl::expected<size_t, ErrorCode> ThreeFSFile::vector_write(const iovec* iov,
                                                           int iovcnt,
                                                           off_t offset) {
@@ -179,83 +148,16 @@ tl::expected<size_t, ErrorCode> ThreeFSFile::vector_write(const iovec* iov,
         return make_error<size_t>(ErrorCode::FILE_OPEN_FAIL);
     }
 
-    auto& threefs_iov = resource->iov_;
-    auto& ior_write = resource->ior_write_;
-
-    // 1. Calculate total length
-    size_t total_length = 0;
-    for (int i = 0; i < iovcnt; ++i) {
-        total_length += iov[i].iov_len;
+    IovecCursor cursor(iov, iovcnt);
+    auto result = resource->BatchIO(
+        fd_, false, {{offset, TotalLength(iov, iovcnt)}},
+        [&](char* buffer, size_t, size_t, size_t size) {
+            cursor.copy(buffer, size, false);
+        });
+    if (!result) {
+        return make_error<size_t>(result.error());
     }
-
-    size_t total_bytes_written = 0;
-    off_t current_offset = offset;
-    size_t bytes_remaining = total_length;
-    int current_iov_index = 0;
-    size_t current_iov_offset = 0;
-
-    while (bytes_remaining > 0) {
-        // 2. Determine current write chunk size (not exceeding shared buffer
-        // size)
-        size_t current_chunk_size =
-            std::min<size_t>(bytes_remaining, resource->config_.iov_size);
-
-        // 3. Copy data from user IOV to shared buffer
-        size_t bytes_copied = 0;
-        char* dest_ptr = reinterpret_cast<char*>(threefs_iov.base);
-
-        while (bytes_copied < current_chunk_size &&
-               current_iov_index < iovcnt) {
-            const iovec* current_iov = &iov[current_iov_index];
-            size_t copy_size =
-                std::min(current_chunk_size - bytes_copied,
-                         current_iov->iov_len - current_iov_offset);
-
-            memcpy(dest_ptr + bytes_copied,
-                   reinterpret_cast<char*>(current_iov->iov_base) +
-                       current_iov_offset,
-                   copy_size);
-
-            bytes_copied += copy_size;
-            current_iov_offset += copy_size;
-
-            if (current_iov_offset >= current_iov->iov_len) {
-                current_iov_index++;
-                current_iov_offset = 0;
-            }
-        }
-
-        // 4. Prepare and submit IO request
-        int ret =
-            hf3fs_prep_io(&ior_write, &threefs_iov, false, threefs_iov.base,
-                          fd_, current_offset, current_chunk_size, nullptr);
-        if (ret < 0) {
-            return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
-        }
-
-        ret = hf3fs_submit_ios(&ior_write);
-        if (ret < 0) {
-            return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
-        }
-
-        // 5. Wait for IO completion
-        struct hf3fs_cqe cqe;
-        ret = hf3fs_wait_for_ios(&ior_write, &cqe, 1, 1, nullptr);
-        if (ret < 0 || cqe.result < 0) {
-            return make_error<size_t>(ErrorCode::FILE_WRITE_FAIL);
-        }
-
-        size_t bytes_written = cqe.result;
-        total_bytes_written += bytes_written;
-        bytes_remaining -= bytes_written;
-        current_offset += bytes_written;
-
-        if (bytes_written < current_chunk_size) {
-            break;  // Short write, possibly disk full
-        }
-    }
-
-    return total_bytes_written;
+    return (*result)[0];
 }
 
 tl::expected<size_t, ErrorCode> ThreeFSFile::vector_read(const iovec* iov,
@@ -266,81 +168,45 @@ tl::expected<size_t, ErrorCode> ThreeFSFile::vector_read(const iovec* iov,
         return make_error<size_t>(ErrorCode::FILE_OPEN_FAIL);
     }
 
-    auto& threefs_iov = resource->iov_;
-    auto& ior_read = resource->ior_read_;
-
-    // Calculate total length
-    size_t total_length = 0;
-    for (int i = 0; i < iovcnt; ++i) {
-        total_length += iov[i].iov_len;
+    IovecCursor cursor(iov, iovcnt);
+    auto result = resource->BatchIO(
+        fd_, true, {{offset, TotalLength(iov, iovcnt)}},
+        [&](char* buffer, size_t, size_t, size_t size) {
+            cursor.copy(buffer, size, true);
+        });
+    if (!result) {
+        return make_error<size_t>(result.error());
     }
+    return (*result)[0];
+}
 
-    size_t total_bytes_read = 0;
-    off_t current_offset = offset;
-    size_t bytes_remaining = total_length;
-    int current_iov_index = 0;
-    size_t current_iov_offset = 0;
-
-    while (bytes_remaining > 0) {
-        // Determine current block size
-        size_t current_chunk_size =
-            std::min<size_t>(bytes_remaining, resource->config_.iov_size);
-
-        // Prepare IO request
-        int ret =
-            hf3fs_prep_io(&ior_read, &threefs_iov, true, threefs_iov.base, fd_,
-                          current_offset, current_chunk_size, nullptr);
-        if (ret < 0) {
-            return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
-        }
-
-        // Submit IO request
-        ret = hf3fs_submit_ios(&ior_read);
-        if (ret < 0) {
-            return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
-        }
-
-        // Wait for IO completion
-        struct hf3fs_cqe cqe;
-        ret = hf3fs_wait_for_ios(&ior_read, &cqe, 1, 1, nullptr);
-        size_t bytes_read = cqe.result;
-        if (ret < 0) {
-            return make_error<size_t>(ErrorCode::FILE_READ_FAIL);
-        }
-
-        // Copy data from shared buffer to user IOV
-        size_t bytes_to_copy = bytes_read;
-        char* src_ptr = reinterpret_cast<char*>(threefs_iov.base);
-
-        while (bytes_to_copy > 0 && current_iov_index < iovcnt) {
-            const iovec* current_iov = &iov[current_iov_index];
-            size_t copy_size = std::min(
-                bytes_to_copy, current_iov->iov_len - current_iov_offset);
-
-            memcpy(
-                static_cast<char*>(current_iov->iov_base) + current_iov_offset,
-                src_ptr, copy_size);
-
-            src_ptr += copy_size;
-            bytes_to_copy -= copy_size;
-            total_bytes_read += copy_size;
-            bytes_remaining -= copy_size;
-            current_offset += copy_size;
+tl::expected<void, ErrorCode> ThreeFSFile::batch_read(
+    const std::vector<FileReadRequest>& requests) {
+    auto* resource = resource_manager_->getThreadResource();
+    if (!resource || !resource->initialized) {
+        return make_error<void>(ErrorCode::FILE_OPEN_FAIL);
+    }
 
-            current_iov_offset += copy_size;
-            if (current_iov_offset >= current_iov->iov_len) {
-                current_iov_index++;
-                current_iov_offset = 0;
-            }
-        }
-        if (bytes_read < current_chunk_size) {
-            // If bytes read is less than requested chunk size, we've reached
-            // EOF
-            break;
+    std::vector<ThreadUSRBIOResource::IoRange> ranges;
+    ranges.reserve(requests.size());
+    for (const auto& request : requests) {
+        ranges.push_back({request.offset, request.length});
+    }
+    auto result = resource->BatchIO(
+        fd_, true, ranges,
+        [&](char* buffer, size_t range, size_t pos, size_t size) {
+            memcpy(static_cast<char*>(requests[range].buffer) + pos, buffer,
+                   size);
+        });
+    if (!result) {
+        return make_error<void>(result.error());
+    }
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if ((*result)[i] != requests[i].length) {
+            return make_error<void>(ErrorCode::FILE_READ_FAIL);
         }
     }
-
-    return total_bytes_read;
+    return {};
 }
 
 }  // namespace mooncake
\ No newline at end of file
@@ -1,6 +1,23 @@
 #include "file_interface.h"
 
+#include <algorithm>
+#include <vector>
+
+#include "utils.h"
+
 namespace mooncake {
+Hf3fsConfig Hf3fsConfig::FromEnv(const std::string &mount_root) {
+    Hf3fsConfig config;
+    config.mount_root = mount_root;
+    config.iov_size =
+        GetEnvOr<size_t>("MC_STORE_3FS_IOV_SIZE", config.iov_size);
+    config.ior_entries =
+        GetEnvOr<size_t>("MC_STORE_3FS_IOR_ENTRIES", config.ior_entries);
+    config.io_block_size =
+        GetEnvOr<size_t>("MC_STORE_3FS_IO_BLOCK_SIZE", config.io_block_size);
+    return config;
+}
+
 // ============================================================================
 // USRBIO Resource manager Implementation
 // ============================================================================
@@ -54,6 +71,108 @@ void ThreadUSRBIOResource::Cleanup() {
     initialized = false;
 }
 
+tl::expected<std::vector<size_t>, ErrorCode> ThreadUSRBIOResource::BatchIO(
+    int fd, bool read, const std::vector<IoRange> &ranges,
+    const std::function<void(char *, size_t, size_t, size_t)> &copy) {
+    const ErrorCode io_error =
+        read ? ErrorCode::FILE_READ_FAIL : ErrorCode::FILE_WRITE_FAIL;
+    auto &ior = read ? ior_read_ : ior_write_;
+    char *base = reinterpret_cast<char *>(iov_.base);
+    const size_t block_size = std::max<size_t>(
+        1, std::min(config_.io_block_size, config_.iov_size));
+    const size_t max_ios = std::max<size_t>(
+        1, std::min(config_.iov_size / block_size, config_.ior_entries));
+    struct Block {
+        size_t range;
+        size_t pos;
+        size_t size;
+    };
+    std::vector<Block> blocks(max_ios);
+    std::vector<int64_t> results(max_ios);
+    std::vector<struct hf3fs_cqe> cqes(max_ios);
+
+    std::vector<size_t> done(ranges.size(), 0);
+    // Ranges cut short stop at their first short block
+    std::vector<bool> finished(ranges.size(), false);
+    size_t range = 0;
+    size_t pos = 0;  // Of the next block to prepare in range
+    while (range < ranges.size()) {
+        // Prepare a batch of I/Os, each in its own block of the iov
+        size_t num_ios = 0;
+        bool prep_failed = false;
+        while (num_ios < max_ios && range < ranges.size()) {
+            if (finished[range] || pos >= ranges[range].length) {
+                range++;
+                pos = 0;
+                continue;
+            }
+            const size_t size =
+                std::min(block_size, ranges[range].length - pos);
+            char *buffer = base + num_ios * block_size;
+            if (!read) {
+                copy(buffer, range, pos, size);
+            }
+            int ret = hf3fs_prep_io(&ior, &iov_, read, buffer, fd,
+                                    ranges[range].offset + pos, size,
+                                    reinterpret_cast<void *>(num_ios));
+            if (ret < 0) {
+                prep_failed = true;
+                break;
+            }
+            blocks[num_ios++] = Block{range, pos, size};
+            pos += size;
+        }
+        if (num_ios == 0) {
+            if (prep_failed) {
+                return tl::make_unexpected(io_error);
+            }
+            break;
+        }
+
+        // Submit them at once and wait for all, the ring must be drained
+        // even if one fails
+        if (hf3fs_submit_ios(&ior) < 0) {
+            return tl::make_unexpected(io_error);
+        }
+        size_t completed = 0;
+        bool io_failed = prep_failed;
+        while (completed < num_ios) {
+            int ret = hf3fs_wait_for_ios(&ior, cqes.data(),
+                                         num_ios - completed, 1, nullptr);
+            if (ret < 0) {
+                return tl::make_unexpected(io_error);
+            }
+            for (int i = 0; i < ret; ++i) {
+                const size_t index =
+                    reinterpret_cast<size_t>(cqes[i].userdata);
+                results[index] = cqes[i].result;
+                io_failed |= cqes[i].result < 0;
+            }
+            completed += ret;
+        }
+        if (io_failed) {
+            return tl::make_unexpected(io_error);
+        }
+
+        // Blocks complete in any order, consume them in file order
+        for (size_t i = 0; i < num_ios; ++i) {
+            const Block &block = blocks[i];
+            if (finished[block.range]) {
+                continue;
+            }
+            const size_t bytes = static_cast<size_t>(results[i]);
+            if (read && bytes > 0) {
+                copy(base + i * block_size, block.range, block.pos, bytes);
+            }
+            done[block.range] += bytes;
+            if (bytes < block.size) {
+                finished[block.range] = true;
+            }
+        }
+    }
+    return done;
+}
+
 // Resource manager implementation
 struct ThreadUSRBIOResource *USRBIOResourceManager::getThreadResource(
     const Hf3fsConfig &config) {
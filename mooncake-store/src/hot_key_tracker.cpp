@@ -0,0 +1,102 @@
+#include "hot_key_tracker.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace mooncake {
+
+namespace {
+
+bool IsColder(const HotKeyTracker::HotKey& a, const HotKeyTracker::HotKey& b) {
+    return a.count < b.count;
+}
+
+}  // namespace
+
+HotKeyTracker::HotKeyTracker(size_t top_n, size_t width)
+    : top_n_(top_n),
+      width_(std::bit_ceil(std::max<size_t>(width, 64))),
+      sample_size_(kSampleFactor * width_),
+      counters_(std::make_unique<std::atomic<uint32_t>[]>(kDepth * width_)) {
+    top_keys_.reserve(top_n_);
+}
+
+size_t HotKeyTracker::Index(size_t key_hash, size_t row) const {
+    // Derive an independent hash per row from the key hash
+    uint64_t h = key_hash + (row + 1) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return row * width_ + (h & (width_ - 1));
+}
+
+void HotKeyTracker::Record(const std::string& key, size_t key_hash) {
+    if (num_records_.fetch_add(1, std::memory_order_relaxed) + 1 ==
+        sample_size_) {
+        Decay();
+    }
+
+    uint64_t estimate = std::numeric_limits<uint64_t>::max();
+    for (size_t row = 0; row < kDepth; row++) {
+        auto& counter = counters_[Index(key_hash, row)];
+        const uint64_t count =
+            counter.fetch_add(1, std::memory_order_relaxed) + 1;
+        estimate = std::min(estimate, count);
+    }
+    if (top_n_ == 0 ||
+        estimate <= admit_count_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    auto it = std::find_if(
+        top_keys_.begin(), top_keys_.end(),
+        [&key](const HotKey& hot) { return hot.key == key; });
+    if (it != top_keys_.end()) {
+        it->count = estimate;
+    } else if (top_keys_.size() < top_n_) {
+        top_keys_.push_back({key, estimate});
+    } else {
+        auto coldest =
+            std::min_element(top_keys_.begin(), top_keys_.end(), IsColder);
+        if (estimate <= coldest->count) {
+            return;
+        }
+        *coldest = {key, estimate};
+    }
+    if (top_keys_.size() == top_n_) {
+        auto coldest =
+            std::min_element(top_keys_.begin(), top_keys_.end(), IsColder);
+        admit_count_.store(coldest->count, std::memory_order_relaxed);
+    }
+}
+
+std::vector<HotKeyTracker::HotKey> HotKeyTracker::TopKeys() const {
+    std::vector<HotKey> result;
+    {
+        std::lock_guard lock(mutex_);
+        result = top_keys_;
+    }
+    std::sort(result.begin(), result.end(),
+              [](const HotKey& a, const HotKey& b) { return IsColder(b, a); });
+    return result;
+}
+
+void HotKeyTracker::Decay() {
+    for (size_t i = 0; i < kDepth * width_; i++) {
+        counters_[i].store(counters_[i].load(std::memory_order_relaxed) / 2,
+                           std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard lock(mutex_);
+        for (auto& hot : top_keys_) {
+            hot.count /= 2;
+        }
+        admit_count_.store(admit_count_.load(std::memory_order_relaxed) / 2,
+                           std::memory_order_relaxed);
+    }
+    num_records_.fetch_sub(sample_size_ / 2, std::memory_order_relaxed);
+}
+
+}  // namespace mooncake
@@ -0,0 +1,74 @@
+#include "hot_replica_cache.h"
+
+#include "epoch_manager.h"
+
+namespace mooncake {
+
+HotReplicaCache::HotReplicaCache(size_t num_slots, size_t num_shards)
+    : slots_(num_slots), shard_versions_(num_slots > 0 ? num_shards : 0) {
+    for (auto& slot : slots_) {
+        slot.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+HotReplicaCache::~HotReplicaCache() {
+    // The owner guarantees that no reader is left
+    for (auto& slot : slots_) {
+        delete slot.load(std::memory_order_relaxed);
+    }
+}
+
+size_t HotReplicaCache::SlotIndex(size_t key_hash) const {
+    // The low bits of the hash already select the shard, mix the rest so
+    // that keys of the same shard spread over the slots.
+    uint64_t h = key_hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h % slots_.size();
+}
+
+std::optional<GetReplicaListResponse> HotReplicaCache::Get(
+    const std::string& key, size_t key_hash, size_t shard_idx,
+    uint64_t min_lease_ms) const {
+    EpochManager::Guard guard(EpochManager::instance());
+    const Entry* entry = slots_[SlotIndex(key_hash)].load();
+    if (!entry || entry->key != key ||
+        entry->shard_version !=
+            shard_versions_[shard_idx].value.load(std::memory_order_acquire) ||
+        entry->generation != generation_.load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (entry->lease_timeout <= now) {
+        return std::nullopt;
+    }
+    const uint64_t lease_left_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            entry->lease_timeout - now)
+            .count();
+    if (lease_left_ms < min_lease_ms) {
+        // Let the slow path extend the lease
+        return std::nullopt;
+    }
+
+    std::vector<Replica::Descriptor> replicas = entry->replicas;
+    return GetReplicaListResponse(std::move(replicas), lease_left_ms);
+}
+
+void HotReplicaCache::Publish(
+    const std::string& key, size_t key_hash, size_t shard_idx,
+    uint64_t generation, const std::vector<Replica::Descriptor>& replicas,
+    std::chrono::steady_clock::time_point lease_timeout) {
+    auto* entry = new Entry{
+        key, replicas, lease_timeout,
+        shard_versions_[shard_idx].value.load(std::memory_order_acquire),
+        generation};
+    Entry* old = slots_[SlotIndex(key_hash)].exchange(entry);
+    if (old) {
+        EpochManager::instance().Retire([old] { delete old; });
+    }
+}
+
+}  // namespace mooncake
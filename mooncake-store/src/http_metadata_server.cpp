@@ -4,21 +4,60 @@
 #include <ylt/coro_http/coro_http_server.hpp>
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <functional>
 #include <mutex>
 #include <string>
+#include <thread>
 
 namespace mooncake {
 
 HttpMetadataServer::HttpMetadataServer(uint16_t port, const std::string& host)
     : port_(port),
       host_(host),
-      server_(std::make_unique<coro_http::coro_http_server>(4, port)),
+      // Many ranks fetch their peers at once during job start
+      server_(std::make_unique<coro_http::coro_http_server>(
+          std::max(4u, std::thread::hardware_concurrency()), port)),
       running_(false) {
     init_server();
 }
 
 HttpMetadataServer::~HttpMetadataServer() { stop(); }
 
+HttpMetadataServer::Shard& HttpMetadataServer::shard_of(
+    const std::string& key) const {
+    return shards_[std::hash<std::string>{}(key) % kNumShards];
+}
+
+bool HttpMetadataServer::get(const std::string& key,
+                             std::string& value) const {
+    auto& shard = shard_of(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
+
+bool HttpMetadataServer::put(const std::string& key, std::string value) {
+    auto& shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (key.find("rpc_meta") != std::string::npos &&
+        shard.entries.count(key)) {
+        return false;
+    }
+    shard.entries[key] = std::move(value);
+    return true;
+}
+
+bool HttpMetadataServer::remove(const std::string& key) {
+    auto& shard = shard_of(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.entries.erase(key) > 0;
+}
+
 void HttpMetadataServer::init_server() {
     using namespace coro_http;
 
@@ -32,16 +71,15 @@ void HttpMetadataServer::init_server() {
                 return;
             }
 
-            std::lock_guard<std::mutex> lock(store_mutex_);
-            auto it = store_.find(std::string(key));
-            if (it == store_.end()) {
+            std::string value;
+            if (!get(std::string(key), value)) {
                 resp.set_status_and_content(status_type::not_found,
                                             "metadata not found");
                 return;
             }
 
             resp.add_header("Content-Type", "application/json");
-            resp.set_status_and_content(status_type::ok, it->second);
+            resp.set_status_and_content(status_type::ok, std::move(value));
         });
 
     // PUT /metadata?key=<key>
@@ -54,17 +92,11 @@ void HttpMetadataServer::init_server() {
                 return;
             }
 
-            std::string body(req.get_body());
-            {
-                std::lock_guard<std::mutex> lock(store_mutex_);
-                if (key.find("rpc_meta") != std::string::npos &&
-                    store_.find(std::string(key)) != store_.end()) {
-                    resp.set_status_and_content(
-                        status_type::bad_request,
-                        "Duplicate rpc_meta key not allowed");
-                    return;
-                }
-                store_[std::string(key)] = body;
+            if (!put(std::string(key), std::string(req.get_body()))) {
+                resp.set_status_and_content(
+                    status_type::bad_request,
+                    "Duplicate rpc_meta key not allowed");
+                return;
             }
 
             resp.set_status_and_content(status_type::ok, "metadata updated");
@@ -80,18 +112,75 @@ void HttpMetadataServer::init_server() {
                 return;
             }
 
-            std::lock_guard<std::mutex> lock(store_mutex_);
-            auto it = store_.find(std::string(key));
-            if (it == store_.end()) {
+            if (!remove(std::string(key))) {
                 resp.set_status_and_content(status_type::not_found,
                                             "metadata not found");
                 return;
             }
 
-            store_.erase(it);
             resp.set_status_and_content(status_type::ok, "metadata deleted");
         });
 
+    // POST /metadata/batch_get with {"keys": [...]}, answers
+    // {"values": {key: value, ...}} without the keys that are not found
+    server_->set_http_handler<POST>(
+        "/metadata/batch_get",
+        [this](coro_http_request& req, coro_http_response& resp) {
+            MetadataBatchGetRequest request;
+            std::error_code ec;
+            struct_json::from_json(request, req.get_body(), ec);
+            if (ec) {
+                resp.set_status_and_content(status_type::bad_request,
+                                            "Invalid batch_get body");
+                return;
+            }
+
+            MetadataBatchGetResponse response;
+            response.values.reserve(request.keys.size());
+            for (auto& key : request.keys) {
+                std::string value;
+                if (get(key, value)) {
+                    response.values.emplace(std::move(key), std::move(value));
+                }
+            }
+
+            std::string body;
+            struct_json::to_json(response, body);
+            resp.add_header("Content-Type", "application/json");
+            resp.set_status_and_content(status_type::ok, std::move(body));
+        });
+
+    // POST /metadata/batch_put with {"entries": [{"key", "value"}, ...]},
+    // stores the entries in order and stops at a duplicate rpc_meta key
+    server_->set_http_handler<POST>(
+        "/metadata/batch_put",
+        [this](coro_http_request& req, coro_http_response& resp) {
+            MetadataBatchPutRequest request;
+            std::error_code ec;
+            struct_json::from_json(request, req.get_body(), ec);
+            if (ec) {
+                resp.set_status_and_content(status_type::bad_request,
+                                            "Invalid batch_put body");
+                return;
+            }
+
+            for (auto& entry : request.entries) {
+                if (entry.key.empty()) {
+                    resp.set_status_and_content(status_type::bad_request,
+                                                "Missing key in entry");
+                    return;
+                }
+                if (!put(entry.key, std::move(entry.value))) {
+                    resp.set_status_and_content(
+                        status_type::bad_request,
+                        "Duplicate rpc_meta key not allowed: " + entry.key);
+                    return;
+                }
+            }
+
+            resp.set_status_and_content(status_type::ok, "metadata updated");
+        });
+
     // Health check endpoint
     server_->set_http_handler<GET>(
         "/health", [](coro_http_request& req, coro_http_response& resp) {
@@ -0,0 +1,182 @@
+#include "key_filter.h"
+
+#include <functional>
+#include <mutex>
+
+namespace mooncake {
+
+namespace {
+
+// Positions of the bits of a key, by double hashing. The low bits of the
+// hash select the metadata shard, so the hash is mixed first.
+template <typename Fn>
+void ForEachPosition(size_t key_hash, size_t num_bits, Fn&& fn) {
+    uint64_t h = key_hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    const uint64_t h1 = h;
+    const uint64_t h2 = (h * 0xc4ceb9fe1a85ec53ULL) | 1;
+    for (size_t i = 0; i < KeyFilterShard::kNumHashes; ++i) {
+        fn((h1 + i * h2) % num_bits);
+    }
+}
+
+}  // namespace
+
+KeyFilterShard::KeyFilterShard(size_t num_bits, std::atomic<uint64_t>* seq,
+                               FlatKeyMapObserver* next)
+    : counters_((num_bits + 7) / 8 * 8, 0),
+      bits_(counters_.size() / 8, '\0'),
+      seq_(seq),
+      next_(next) {}
+
+void KeyFilterShard::SetBit(size_t pos, bool value) {
+    const char mask = static_cast<char>(1u << (pos % 8));
+    if (value) {
+        bits_[pos / 8] |= mask;
+    } else {
+        bits_[pos / 8] &= ~mask;
+    }
+    version_ = seq_->fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void KeyFilterShard::OnInsert(const std::string& key) {
+    ForEachPosition(std::hash<std::string>{}(key), counters_.size(),
+                    [this](size_t pos) {
+                        uint8_t& counter = counters_[pos];
+                        if (counter == UINT8_MAX) {
+                            return;
+                        }
+                        if (counter++ == 0) {
+                            SetBit(pos, true);
+                        }
+                    });
+    if (next_) {
+        next_->OnInsert(key);
+    }
+}
+
+void KeyFilterShard::OnErase(const std::string& key) {
+    ForEachPosition(std::hash<std::string>{}(key), counters_.size(),
+                    [this](size_t pos) {
+                        uint8_t& counter = counters_[pos];
+                        if (counter == UINT8_MAX || counter == 0) {
+                            return;
+                        }
+                        if (--counter == 0) {
+                            SetBit(pos, false);
+                        }
+                    });
+    if (next_) {
+        next_->OnErase(key);
+    }
+}
+
+bool KeyFilterShard::MayContain(const std::string& bits, size_t key_hash) {
+    if (bits.empty()) {
+        return false;
+    }
+    bool may_contain = true;
+    ForEachPosition(key_hash, bits.size() * 8, [&](size_t pos) {
+        if (!(static_cast<uint8_t>(bits[pos / 8]) & (1u << (pos % 8)))) {
+            may_contain = false;
+        }
+    });
+    return may_contain;
+}
+
+std::vector<uint64_t> KeyFilterView::SyncPoints(size_t num_masters) const {
+    std::shared_lock lock(mutex_);
+    std::vector<uint64_t> points(num_masters, 0);
+    if (masters_.size() != num_masters) {
+        return points;
+    }
+    for (size_t i = 0; i < num_masters; ++i) {
+        if (masters_[i].synced) {
+            points[i] = masters_[i].seq;
+        }
+    }
+    return points;
+}
+
+void KeyFilterView::Apply(
+    const std::vector<uint64_t>& sync_points,
+    const std::vector<tl::expected<GetKeyFilterResponse, ErrorCode>>&
+        responses) {
+    std::unique_lock lock(mutex_);
+    if (masters_.size() != responses.size() ||
+        sync_points.size() != responses.size()) {
+        masters_.assign(responses.size(), MasterFilter{});
+        if (sync_points.size() != responses.size()) {
+            return;
+        }
+    }
+    for (size_t i = 0; i < responses.size(); ++i) {
+        auto& master = masters_[i];
+        const auto& response = responses[i];
+        if (!response || response->num_shards == 0) {
+            master = MasterFilter{};
+            continue;
+        }
+        if (sync_points[i] == 0) {
+            master = MasterFilter{};
+            master.synced = true;
+            master.filter_id = response->filter_id;
+            master.num_shards = response->num_shards;
+            master.shard_bits.resize(response->num_shards);
+        } else if (!master.synced ||
+                   master.filter_id != response->filter_id ||
+                   master.num_shards != response->num_shards ||
+                   master.seq != sync_points[i]) {
+            // A delta against a state this view does not have
+            master = MasterFilter{};
+            continue;
+        }
+        for (const auto& shard : response->shards) {
+            if (shard.shard < master.num_shards) {
+                master.shard_bits[shard.shard] = shard.bits;
+            }
+        }
+        master.seq = response->seq;
+    }
+}
+
+bool KeyFilterView::MayContain(const std::string& key) const {
+    std::shared_lock lock(mutex_);
+    if (masters_.empty()) {
+        return true;
+    }
+    const size_t key_hash = std::hash<std::string>{}(key);
+    for (const auto& master : masters_) {
+        if (!master.synced) {
+            return true;
+        }
+        // The key is in one master only, the others add false positives
+        if (KeyFilterShard::MayContain(
+                master.shard_bits[key_hash % master.num_shards], key_hash)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool KeyFilterView::usable() const {
+    std::shared_lock lock(mutex_);
+    if (masters_.empty()) {
+        return false;
+    }
+    for (const auto& master : masters_) {
+        if (!master.synced) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void KeyFilterView::Reset() {
+    std::unique_lock lock(mutex_);
+    masters_.clear();
+}
+
+}  // namespace mooncake
@@ -0,0 +1,239 @@
+#include "key_radix_tree.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace mooncake {
+
+struct KeyRadixTree::Node {
+    // Label of the edge from the parent, only empty for the root
+    std::string label;
+    bool terminal{false};
+    // Children start with distinct characters
+    std::vector<std::unique_ptr<Node>> children;
+
+    size_t FindChild(char c) const {
+        for (size_t i = 0; i < children.size(); i++) {
+            if (children[i]->label[0] == c) {
+                return i;
+            }
+        }
+        return children.size();
+    }
+
+    // Absorb the only child, which keeps the tree compressed
+    void MergeWithChild() {
+        std::unique_ptr<Node> child = std::move(children[0]);
+        label += child->label;
+        terminal = child->terminal;
+        children = std::move(child->children);
+    }
+};
+
+namespace {
+
+size_t CommonPrefixLength(std::string_view a, std::string_view b) {
+    const size_t length = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < length && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+}  // namespace
+
+KeyRadixTree::KeyRadixTree() : root_(std::make_unique<Node>()) {}
+
+KeyRadixTree::~KeyRadixTree() = default;
+
+bool KeyRadixTree::Insert(std::string_view key) {
+    Node* node = root_.get();
+    while (!key.empty()) {
+        const size_t index = node->FindChild(key[0]);
+        if (index == node->children.size()) {
+            auto leaf = std::make_unique<Node>();
+            leaf->label = key;
+            leaf->terminal = true;
+            node->children.push_back(std::move(leaf));
+            size_++;
+            return true;
+        }
+
+        auto& child = node->children[index];
+        const size_t common = CommonPrefixLength(child->label, key);
+        if (common < child->label.size()) {
+            // Split the edge at the end of the common part
+            auto middle = std::make_unique<Node>();
+            middle->label = child->label.substr(0, common);
+            child->label.erase(0, common);
+            middle->children.push_back(std::move(child));
+            child = std::move(middle);
+        }
+        key.remove_prefix(common);
+        node = child.get();
+    }
+
+    if (node->terminal) {
+        return false;
+    }
+    node->terminal = true;
+    size_++;
+    return true;
+}
+
+bool KeyRadixTree::Erase(std::string_view key) {
+    Node* parent = nullptr;
+    Node* node = root_.get();
+    size_t index_in_parent = 0;
+    bool parent_is_root = false;
+    while (!key.empty()) {
+        const size_t index = node->FindChild(key[0]);
+        if (index == node->children.size()) {
+            return false;
+        }
+        Node* child = node->children[index].get();
+        if (key.substr(0, child->label.size()) != child->label) {
+            return false;
+        }
+        key.remove_prefix(child->label.size());
+        parent_is_root = node == root_.get();
+        parent = node;
+        index_in_parent = index;
+        node = child;
+    }
+
+    if (!node->terminal) {
+        return false;
+    }
+    node->terminal = false;
+    size_--;
+
+    if (!parent) {
+        return true;  // the empty key
+    }
+    if (node->children.empty()) {
+        parent->children.erase(parent->children.begin() + index_in_parent);
+        if (!parent_is_root && !parent->terminal &&
+            parent->children.size() == 1) {
+            parent->MergeWithChild();
+        }
+    } else if (node->children.size() == 1) {
+        node->MergeWithChild();
+    }
+    return true;
+}
+
+bool KeyRadixTree::Contains(std::string_view key) const {
+    const Node* node = root_.get();
+    while (!key.empty()) {
+        const size_t index = node->FindChild(key[0]);
+        if (index == node->children.size()) {
+            return false;
+        }
+        const Node* child = node->children[index].get();
+        if (key.substr(0, child->label.size()) != child->label) {
+            return false;
+        }
+        key.remove_prefix(child->label.size());
+        node = child;
+    }
+    return node->terminal;
+}
+
+void KeyRadixTree::CollectWithPrefix(std::string_view prefix,
+                                     std::vector<std::string>& keys) const {
+    const Node* node = root_.get();
+    std::string path;
+    while (!prefix.empty()) {
+        const size_t index = node->FindChild(prefix[0]);
+        if (index == node->children.size()) {
+            return;
+        }
+        const Node* child = node->children[index].get();
+        const size_t common = CommonPrefixLength(child->label, prefix);
+        if (common < prefix.size() && common < child->label.size()) {
+            return;  // diverges in the middle of the edge
+        }
+        path += child->label;
+        prefix.remove_prefix(common);
+        node = child;
+    }
+    CollectAll(node, path, keys);
+}
+
+void KeyRadixTree::CollectAll(const Node* node, std::string& path,
+                              std::vector<std::string>& keys) {
+    if (node->terminal) {
+        keys.push_back(path);
+    }
+    for (const auto& child : node->children) {
+        const size_t length = path.size();
+        path += child->label;
+        CollectAll(child.get(), path, keys);
+        path.resize(length);
+    }
+}
+
+std::string GetRegexLiteralPrefix(const std::string& regex_pattern) {
+    if (regex_pattern.empty() || regex_pattern[0] != '^') {
+        return "";
+    }
+
+    // A top level alternation may match without the anchored prefix, only
+    // accept patterns without any alternation.
+    bool escaped = false;
+    bool in_class = false;
+    for (char c : regex_pattern) {
+        if (escaped) {
+            escaped = false;
+        } else if (c == '\\') {
+            escaped = true;
+        } else if (in_class) {
+            in_class = c != ']';
+        } else if (c == '[') {
+            in_class = true;
+        } else if (c == '|') {
+            return "";
+        }
+    }
+
+    static constexpr const char* kSpecialChars = ".[]{}()*+?|^$";
+    std::string prefix;
+    size_t i = 1;
+    while (i < regex_pattern.size()) {
+        char literal;
+        size_t length;
+        if (regex_pattern[i] == '\\') {
+            if (i + 1 >= regex_pattern.size()) {
+                break;
+            }
+            literal = regex_pattern[i + 1];
+            if (std::isalnum(static_cast<unsigned char>(literal))) {
+                break;  // a character class like \d or an escape sequence
+            }
+            length = 2;
+        } else if (std::strchr(kSpecialChars, regex_pattern[i])) {
+            break;
+        } else {
+            literal = regex_pattern[i];
+            length = 1;
+        }
+
+        const char next = i + length < regex_pattern.size()
+                              ? regex_pattern[i + length]
+                              : '\0';
+        if (next == '*' || next == '?' || next == '{') {
+            break;  // the literal may not appear at all
+        }
+        prefix += literal;
+        if (next == '+') {
+            break;
+        }
+        i += length;
+    }
+    return prefix;
+}
+
+}  // namespace mooncake
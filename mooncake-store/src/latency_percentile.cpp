@@ -0,0 +1,34 @@
+#include "latency_percentile.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mooncake {
+
+LatencyPercentile::LatencyPercentile(double percentile)
+    : percentile_(std::clamp(percentile, 0.0, 100.0)) {
+    samples_.reserve(kWindowSize);
+}
+
+void LatencyPercentile::Record(uint64_t latency_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (samples_.size() < kWindowSize) {
+        samples_.push_back(latency_us);
+    } else {
+        samples_[next_] = latency_us;
+    }
+    next_ = (next_ + 1) % kWindowSize;
+    if (++num_samples_ % kRecomputeInterval != 0) {
+        return;
+    }
+
+    scratch_.assign(samples_.begin(), samples_.end());
+    const size_t rank = static_cast<size_t>(
+        std::ceil(percentile_ / 100.0 * static_cast<double>(scratch_.size())));
+    const size_t index = std::min(rank, scratch_.size()) - (rank > 0);
+    std::nth_element(scratch_.begin(), scratch_.begin() + index,
+                     scratch_.end());
+    value_.store(scratch_[index], std::memory_order_relaxed);
+}
+
+}  // namespace mooncake
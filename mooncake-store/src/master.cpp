@@ -67,6 +67,10 @@ DEFINE_bool(enable_offload, false, "Enable offload availability");
 DEFINE_string(
     etcd_endpoints, "",
     "Endpoints of ETCD server, separated by semicolon, required in HA mode");
+DEFINE_int64(etcd_lease_ttl_sec, mooncake::ETCD_MASTER_VIEW_LEASE_TTL,
+             "TTL in seconds of the etcd lease held by the leader master. A "
+             "failed leader is replaced after about twice this time, only "
+             "used in HA mode");
 DEFINE_int64(client_ttl, mooncake::DEFAULT_CLIENT_LIVE_TTL_SEC,
              "How long a client is considered alive after the last ping, only "
              "used in HA mode");
@@ -115,11 +119,115 @@ DEFINE_uint64(processing_task_timeout_sec, 300,
               "Timeout in seconds for processing tasks (0 = no timeout)");
 DEFINE_uint32(max_retry_attempts, 10,
               "Maximum number of retry attempts for failed tasks");
+DEFINE_uint64(max_task_bytes_per_client,
+              mooncake::DEFAULT_MAX_TASK_BYTES_PER_CLIENT,
+              "Bytes of copy/move tasks a client processes at once, higher "
+              "priority tasks go first (0 = no limit)");
 
 DEFINE_string(cxl_path, mooncake::DEFAULT_CXL_PATH,
               "DAX device path for CXL memory");
 DEFINE_uint64(cxl_size, mooncake::DEFAULT_CXL_SIZE, "CXL memory size in bytes");
 DEFINE_bool(enable_cxl, false, "Whether to enable CXL memory support");
+DEFINE_string(metadata_persist_dir, mooncake::DEFAULT_METADATA_PERSIST_DIR,
+              "Directory for master metadata snapshots and WAL, empty to "
+              "disable persistence");
+DEFINE_uint64(metadata_snapshot_interval_sec,
+              mooncake::DEFAULT_METADATA_SNAPSHOT_INTERVAL_SEC,
+              "Interval in seconds between two metadata snapshots");
+DEFINE_bool(enable_hot_standby, false,
+            "Whether a standby master tails the metadata WAL in "
+            "metadata_persist_dir while waiting for leadership, so that "
+            "promotion does not reload it");
+DEFINE_int32(standby_rpc_port, 0,
+             "Port on which a hot standby master serves read-only metadata "
+             "RPCs, for clients setting MC_STORE_STANDBY_MASTER, 0 to "
+             "disable");
+DEFINE_int32(rdma_rpc_port, 0,
+             "Port on which the master also serves ExistKey and GetReplicaList "
+             "over RDMA, for clients setting MC_MASTER_RDMA_RPC_PORT, 0 to "
+             "disable");
+DEFINE_uint64(hot_replica_cache_size, 0,
+              "Number of slots of the lock-free read cache for hot keys, 0 to "
+              "disable");
+DEFINE_uint64(key_filter_bits_per_shard, 0,
+              "Bits of the key filter of each of the 1024 metadata shards, "
+              "synced by clients to answer existence queries of missing keys "
+              "locally, 0 to disable");
+DEFINE_bool(enable_key_prefix_index, false,
+            "Index keys in a radix tree per shard to speed up anchored regex "
+            "queries, at the cost of extra memory per key");
+DEFINE_string(eviction_policy, "lru",
+              "Eviction policy of memory replicas: lru, sieve, s3fifo, lfu "
+              "or cost_aware");
+DEFINE_bool(enable_tinylfu_admission, false,
+            "Let inline PutStart eviction only evict objects that were "
+            "accessed less often than the new key (TinyLFU admission)");
+DEFINE_uint32(put_start_eviction_retries, 0,
+              "Times PutStart evicts objects from the target segments and "
+              "retries inline when allocation fails, 0 to only trigger the "
+              "eviction thread");
+DEFINE_bool(batch_put_contiguous, false,
+            "Allocate the objects of a BatchPutStart with one replica in one "
+            "contiguous extent, so that their transfers coalesce");
+DEFINE_string(allocation_strategy, "random",
+              "Allocation strategy of replicas: random or load_aware");
+DEFINE_double(compaction_fragmentation_threshold,
+              mooncake::DEFAULT_COMPACTION_FRAGMENTATION_THRESHOLD,
+              "Fragmentation (1 - largest free region / free space) of a "
+              "segment above which small objects are moved out of it, 0 to "
+              "disable compaction");
+DEFINE_uint32(compaction_moves_per_sec,
+              mooncake::DEFAULT_COMPACTION_MOVES_PER_SEC,
+              "Maximum number of compaction moves scheduled per second");
+DEFINE_double(rebalance_utilization_gap,
+              mooncake::DEFAULT_REBALANCE_UTILIZATION_GAP,
+              "Difference between the most and the least utilized segments "
+              "above which objects are moved to even them out, 0 to only "
+              "move objects off draining segments");
+DEFINE_uint32(rebalance_moves_per_sec,
+              mooncake::DEFAULT_REBALANCE_MOVES_PER_SEC,
+              "Maximum number of rebalancing and draining moves in flight, 0 "
+              "to disable the rebalancer");
+DEFINE_string(tenant_quotas, "",
+              "Per-tenant limits as tenant=quota_bytes[:put_starts_per_sec],"
+              "...; tenant * applies to unlisted tenants");
+DEFINE_double(lazy_lease_renewal_ratio,
+              mooncake::DEFAULT_LAZY_LEASE_RENEWAL_RATIO,
+              "Fraction of default_kv_lease_ttl a read may leave unrenewed, "
+              "in [0, 1). 0 renews the lease on every read");
+DEFINE_bool(enable_async_replica_reclaim,
+            mooncake::DEFAULT_ENABLE_ASYNC_REPLICA_RECLAIM,
+            "Free the memory of removed and evicted replicas on a background "
+            "thread instead of the RPC threads");
+DEFINE_uint32(hot_key_top_n, mooncake::DEFAULT_HOT_KEY_TOP_N,
+              "Number of most read keys tracked and served on "
+              "/metrics/hot_keys, 0 disables the tracking");
+DEFINE_uint32(hot_key_replica_reads_per_sec,
+              mooncake::DEFAULT_HOT_KEY_REPLICA_READS_PER_SEC,
+              "Reads per second of a hot key above which the master adds "
+              "replicas, 0 to disable");
+DEFINE_uint32(hot_key_max_replicas, mooncake::DEFAULT_HOT_KEY_MAX_REPLICAS,
+              "Memory replicas a hot key is amplified to at most");
+DEFINE_uint32(disk_promotion_reads, mooncake::DEFAULT_DISK_PROMOTION_READS,
+              "Reads of an object only held on disk within "
+              "--disk_promotion_window_sec after which it is copied back into "
+              "memory, 0 to disable");
+DEFINE_uint32(disk_promotion_window_sec,
+              mooncake::DEFAULT_DISK_PROMOTION_WINDOW_SEC,
+              "Window in seconds in which the reads of --disk_promotion_reads "
+              "are counted");
+DEFINE_double(memory_tier_target_ratio,
+              mooncake::DEFAULT_MEMORY_TIER_TARGET_RATIO,
+              "Memory usage ratio above which the coldest objects are "
+              "offloaded to the local disk tier, 0 offloads every object at "
+              "PutEnd");
+DEFINE_uint32(tier_demotion_min_idle_sec,
+              mooncake::DEFAULT_TIER_DEMOTION_MIN_IDLE_SEC,
+              "Seconds an object must be unread before it is offloaded to the "
+              "local disk tier");
+DEFINE_uint64(cxl_min_object_size, mooncake::DEFAULT_CXL_MIN_OBJECT_SIZE,
+              "With enable_cxl, minimum object size placed on the CXL tier "
+              "instead of DRAM");
 void InitMasterConf(const mooncake::DefaultConfig& default_config,
                     mooncake::MasterConfig& master_config) {
     // Initialize the master service configuration from the default config
@@ -170,6 +278,9 @@ void InitMasterConf(const mooncake::DefaultConfig& default_config,
                            FLAGS_enable_offload);
     default_config.GetString("etcd_endpoints", &master_config.etcd_endpoints,
                              FLAGS_etcd_endpoints);
+    default_config.GetInt64("etcd_lease_ttl_sec",
+                            &master_config.etcd_lease_ttl_sec,
+                            FLAGS_etcd_lease_ttl_sec);
     default_config.GetString("cluster_id", &master_config.cluster_id,
                              FLAGS_cluster_id);
     default_config.GetString("root_fs_dir", &master_config.root_fs_dir,
@@ -218,6 +329,88 @@ void InitMasterConf(const mooncake::DefaultConfig& default_config,
     default_config.GetUInt32("max_retry_attempts",
                              &master_config.max_retry_attempts,
                              FLAGS_max_retry_attempts);
+    default_config.GetUInt64("max_task_bytes_per_client",
+                             &master_config.max_task_bytes_per_client,
+                             FLAGS_max_task_bytes_per_client);
+    default_config.GetString("metadata_persist_dir",
+                             &master_config.metadata_persist_dir,
+                             FLAGS_metadata_persist_dir);
+    default_config.GetUInt64("metadata_snapshot_interval_sec",
+                             &master_config.metadata_snapshot_interval_sec,
+                             FLAGS_metadata_snapshot_interval_sec);
+    default_config.GetBool("enable_hot_standby",
+                           &master_config.enable_hot_standby,
+                           FLAGS_enable_hot_standby);
+    default_config.GetInt32("standby_rpc_port", &master_config.standby_rpc_port,
+                            FLAGS_standby_rpc_port);
+    default_config.GetInt32("rdma_rpc_port", &master_config.rdma_rpc_port,
+                            FLAGS_rdma_rpc_port);
+    default_config.GetUInt64("hot_replica_cache_size",
+                             &master_config.hot_replica_cache_size,
+                             FLAGS_hot_replica_cache_size);
+    default_config.GetUInt64("key_filter_bits_per_shard",
+                             &master_config.key_filter_bits_per_shard,
+                             FLAGS_key_filter_bits_per_shard);
+    default_config.GetBool("enable_key_prefix_index",
+                           &master_config.enable_key_prefix_index,
+                           FLAGS_enable_key_prefix_index);
+    default_config.GetString("eviction_policy", &master_config.eviction_policy,
+                             FLAGS_eviction_policy);
+    default_config.GetBool("enable_tinylfu_admission",
+                           &master_config.enable_tinylfu_admission,
+                           FLAGS_enable_tinylfu_admission);
+    default_config.GetUInt32("put_start_eviction_retries",
+                             &master_config.put_start_eviction_retries,
+                             FLAGS_put_start_eviction_retries);
+    default_config.GetBool("batch_put_contiguous",
+                           &master_config.batch_put_contiguous,
+                           FLAGS_batch_put_contiguous);
+    default_config.GetString("allocation_strategy",
+                             &master_config.allocation_strategy,
+                             FLAGS_allocation_strategy);
+    default_config.GetDouble("compaction_fragmentation_threshold",
+                             &master_config.compaction_fragmentation_threshold,
+                             FLAGS_compaction_fragmentation_threshold);
+    default_config.GetUInt32("compaction_moves_per_sec",
+                             &master_config.compaction_moves_per_sec,
+                             FLAGS_compaction_moves_per_sec);
+    default_config.GetDouble("rebalance_utilization_gap",
+                             &master_config.rebalance_utilization_gap,
+                             FLAGS_rebalance_utilization_gap);
+    default_config.GetUInt32("rebalance_moves_per_sec",
+                             &master_config.rebalance_moves_per_sec,
+                             FLAGS_rebalance_moves_per_sec);
+    default_config.GetString("tenant_quotas", &master_config.tenant_quotas,
+                             FLAGS_tenant_quotas);
+    default_config.GetDouble("lazy_lease_renewal_ratio",
+                             &master_config.lazy_lease_renewal_ratio,
+                             FLAGS_lazy_lease_renewal_ratio);
+    default_config.GetBool("enable_async_replica_reclaim",
+                           &master_config.enable_async_replica_reclaim,
+                           FLAGS_enable_async_replica_reclaim);
+    default_config.GetUInt32("hot_key_top_n", &master_config.hot_key_top_n,
+                             FLAGS_hot_key_top_n);
+    default_config.GetUInt32("hot_key_replica_reads_per_sec",
+                             &master_config.hot_key_replica_reads_per_sec,
+                             FLAGS_hot_key_replica_reads_per_sec);
+    default_config.GetUInt32("hot_key_max_replicas",
+                             &master_config.hot_key_max_replicas,
+                             FLAGS_hot_key_max_replicas);
+    default_config.GetUInt32("disk_promotion_reads",
+                             &master_config.disk_promotion_reads,
+                             FLAGS_disk_promotion_reads);
+    default_config.GetUInt32("disk_promotion_window_sec",
+                             &master_config.disk_promotion_window_sec,
+                             FLAGS_disk_promotion_window_sec);
+    default_config.GetDouble("memory_tier_target_ratio",
+                             &master_config.memory_tier_target_ratio,
+                             FLAGS_memory_tier_target_ratio);
+    default_config.GetUInt32("tier_demotion_min_idle_sec",
+                             &master_config.tier_demotion_min_idle_sec,
+                             FLAGS_tier_demotion_min_idle_sec);
+    default_config.GetUInt64("cxl_min_object_size",
+                             &master_config.cxl_min_object_size,
+                             FLAGS_cxl_min_object_size);
 }
 
 void LoadConfigFromCmdline(mooncake::MasterConfig& master_config,
@@ -351,6 +544,11 @@ void LoadConfigFromCmdline(mooncake::MasterConfig& master_config,
         !conf_set) {
         master_config.etcd_endpoints = FLAGS_etcd_endpoints;
     }
+    if ((google::GetCommandLineFlagInfo("etcd_lease_ttl_sec", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.etcd_lease_ttl_sec = FLAGS_etcd_lease_ttl_sec;
+    }
     if ((google::GetCommandLineFlagInfo("client_live_ttl_sec", &info) &&
          !info.is_default) ||
         !conf_set) {
@@ -450,6 +648,167 @@ void LoadConfigFromCmdline(mooncake::MasterConfig& master_config,
         !conf_set) {
         master_config.max_retry_attempts = FLAGS_max_retry_attempts;
     }
+    if ((google::GetCommandLineFlagInfo("max_task_bytes_per_client", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.max_task_bytes_per_client =
+            FLAGS_max_task_bytes_per_client;
+    }
+    if ((google::GetCommandLineFlagInfo("metadata_persist_dir", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.metadata_persist_dir = FLAGS_metadata_persist_dir;
+    }
+    if ((google::GetCommandLineFlagInfo("metadata_snapshot_interval_sec",
+                                        &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.metadata_snapshot_interval_sec =
+            FLAGS_metadata_snapshot_interval_sec;
+    }
+    if ((google::GetCommandLineFlagInfo("enable_hot_standby", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.enable_hot_standby = FLAGS_enable_hot_standby;
+    }
+    if ((google::GetCommandLineFlagInfo("standby_rpc_port", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.standby_rpc_port = FLAGS_standby_rpc_port;
+    }
+    if ((google::GetCommandLineFlagInfo("rdma_rpc_port", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.rdma_rpc_port = FLAGS_rdma_rpc_port;
+    }
+    if ((google::GetCommandLineFlagInfo("hot_replica_cache_size", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.hot_replica_cache_size = FLAGS_hot_replica_cache_size;
+    }
+    if ((google::GetCommandLineFlagInfo("key_filter_bits_per_shard",
+                                        &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.key_filter_bits_per_shard =
+            FLAGS_key_filter_bits_per_shard;
+    }
+    if ((google::GetCommandLineFlagInfo("enable_key_prefix_index", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.enable_key_prefix_index = FLAGS_enable_key_prefix_index;
+    }
+    if ((google::GetCommandLineFlagInfo("eviction_policy", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.eviction_policy = FLAGS_eviction_policy;
+    }
+    if ((google::GetCommandLineFlagInfo("enable_tinylfu_admission", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.enable_tinylfu_admission =
+            FLAGS_enable_tinylfu_admission;
+    }
+    if ((google::GetCommandLineFlagInfo("put_start_eviction_retries", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.put_start_eviction_retries =
+            FLAGS_put_start_eviction_retries;
+    }
+    if ((google::GetCommandLineFlagInfo("batch_put_contiguous", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.batch_put_contiguous = FLAGS_batch_put_contiguous;
+    }
+    if ((google::GetCommandLineFlagInfo("allocation_strategy", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.allocation_strategy = FLAGS_allocation_strategy;
+    }
+    if ((google::GetCommandLineFlagInfo("compaction_fragmentation_threshold",
+                                        &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.compaction_fragmentation_threshold =
+            FLAGS_compaction_fragmentation_threshold;
+    }
+    if ((google::GetCommandLineFlagInfo("compaction_moves_per_sec", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.compaction_moves_per_sec = FLAGS_compaction_moves_per_sec;
+    }
+    if ((google::GetCommandLineFlagInfo("rebalance_utilization_gap", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.rebalance_utilization_gap =
+            FLAGS_rebalance_utilization_gap;
+    }
+    if ((google::GetCommandLineFlagInfo("rebalance_moves_per_sec", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.rebalance_moves_per_sec = FLAGS_rebalance_moves_per_sec;
+    }
+    if ((google::GetCommandLineFlagInfo("tenant_quotas", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.tenant_quotas = FLAGS_tenant_quotas;
+    }
+    if ((google::GetCommandLineFlagInfo("lazy_lease_renewal_ratio", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.lazy_lease_renewal_ratio = FLAGS_lazy_lease_renewal_ratio;
+    }
+    if ((google::GetCommandLineFlagInfo("enable_async_replica_reclaim",
+                                        &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.enable_async_replica_reclaim =
+            FLAGS_enable_async_replica_reclaim;
+    }
+    if ((google::GetCommandLineFlagInfo("hot_key_top_n", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.hot_key_top_n = FLAGS_hot_key_top_n;
+    }
+    if ((google::GetCommandLineFlagInfo("hot_key_replica_reads_per_sec",
+                                        &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.hot_key_replica_reads_per_sec =
+            FLAGS_hot_key_replica_reads_per_sec;
+    }
+    if ((google::GetCommandLineFlagInfo("hot_key_max_replicas", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.hot_key_max_replicas = FLAGS_hot_key_max_replicas;
+    }
+    if ((google::GetCommandLineFlagInfo("disk_promotion_reads", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.disk_promotion_reads = FLAGS_disk_promotion_reads;
+    }
+    if ((google::GetCommandLineFlagInfo("disk_promotion_window_sec", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.disk_promotion_window_sec =
+            FLAGS_disk_promotion_window_sec;
+    }
+    if ((google::GetCommandLineFlagInfo("memory_tier_target_ratio", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.memory_tier_target_ratio = FLAGS_memory_tier_target_ratio;
+    }
+    if ((google::GetCommandLineFlagInfo("tier_demotion_min_idle_sec", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.tier_demotion_min_idle_sec =
+            FLAGS_tier_demotion_min_idle_sec;
+    }
+    if ((google::GetCommandLineFlagInfo("cxl_min_object_size", &info) &&
+         !info.is_default) ||
+        !conf_set) {
+        master_config.cxl_min_object_size = FLAGS_cxl_min_object_size;
+    }
 }
 
 // Function to start HTTP metadata server
@@ -505,6 +864,10 @@ int main(int argc, char* argv[]) {
         LOG(FATAL) << "Etcd endpoints must be set when enable_ha is true";
         return 1;
     }
+    if (master_config.enable_ha && master_config.etcd_lease_ttl_sec <= 0) {
+        LOG(FATAL) << "etcd_lease_ttl_sec must be positive";
+        return 1;
+    }
     if (!master_config.enable_ha && !master_config.etcd_endpoints.empty()) {
         LOG(WARNING)
             << "Etcd endpoints are set but will not be used in non-HA mode";
@@ -516,6 +879,20 @@ int main(int argc, char* argv[]) {
                    << ", must be 'cachelib' or 'offset'";
         return 1;
     }
+    if (!mooncake::ParseEvictionPolicy(master_config.eviction_policy)) {
+        LOG(FATAL) << "Invalid eviction policy: "
+                   << master_config.eviction_policy
+                   << ", must be 'lru', 'sieve', 's3fifo', 'lfu' or "
+                      "'cost_aware'";
+        return 1;
+    }
+    if (!mooncake::ParseAllocationStrategyType(
+            master_config.allocation_strategy)) {
+        LOG(FATAL) << "Invalid allocation strategy: "
+                   << master_config.allocation_strategy
+                   << ", must be 'random' or 'load_aware'";
+        return 1;
+    }
 
     const char* value = std::getenv("MC_RPC_PROTOCOL");
     std::string protocol = "tcp";
@@ -537,6 +914,7 @@ int main(int argc, char* argv[]) {
         << ", enable_ha=" << master_config.enable_ha
         << ", enable_offload=" << master_config.enable_offload
         << ", etcd_endpoints=" << master_config.etcd_endpoints
+        << ", etcd_lease_ttl_sec=" << master_config.etcd_lease_ttl_sec
         << ", client_ttl=" << master_config.client_live_ttl_sec
         << ", rpc_thread_num=" << master_config.rpc_thread_num
         << ", rpc_port=" << master_config.rpc_port
@@ -570,9 +948,54 @@ int main(int argc, char* argv[]) {
         << ", processing_task_timeout_sec="
         << master_config.processing_task_timeout_sec
         << ", max_retry_attempts=" << master_config.max_retry_attempts
+        << ", max_task_bytes_per_client="
+        << master_config.max_task_bytes_per_client
         << ", enable_cxl=" << master_config.enable_cxl
         << ", cxl_path=" << master_config.cxl_path
-        << ", cxl_size=" << master_config.cxl_size;
+        << ", cxl_size=" << master_config.cxl_size
+        << ", metadata_persist_dir=" << master_config.metadata_persist_dir
+        << ", metadata_snapshot_interval_sec="
+        << master_config.metadata_snapshot_interval_sec
+        << ", enable_hot_standby=" << master_config.enable_hot_standby
+        << ", standby_rpc_port=" << master_config.standby_rpc_port
+        << ", rdma_rpc_port=" << master_config.rdma_rpc_port
+        << ", hot_replica_cache_size=" << master_config.hot_replica_cache_size
+        << ", key_filter_bits_per_shard="
+        << master_config.key_filter_bits_per_shard
+        << ", enable_key_prefix_index="
+        << master_config.enable_key_prefix_index
+        << ", eviction_policy=" << master_config.eviction_policy
+        << ", enable_tinylfu_admission="
+        << master_config.enable_tinylfu_admission
+        << ", put_start_eviction_retries="
+        << master_config.put_start_eviction_retries
+        << ", batch_put_contiguous=" << master_config.batch_put_contiguous
+        << ", allocation_strategy=" << master_config.allocation_strategy
+        << ", compaction_fragmentation_threshold="
+        << master_config.compaction_fragmentation_threshold
+        << ", compaction_moves_per_sec="
+        << master_config.compaction_moves_per_sec
+        << ", rebalance_utilization_gap="
+        << master_config.rebalance_utilization_gap
+        << ", rebalance_moves_per_sec="
+        << master_config.rebalance_moves_per_sec
+        << ", tenant_quotas=" << master_config.tenant_quotas
+        << ", lazy_lease_renewal_ratio="
+        << master_config.lazy_lease_renewal_ratio
+        << ", enable_async_replica_reclaim="
+        << master_config.enable_async_replica_reclaim
+        << ", hot_key_top_n=" << master_config.hot_key_top_n
+        << ", hot_key_replica_reads_per_sec="
+        << master_config.hot_key_replica_reads_per_sec
+        << ", hot_key_max_replicas=" << master_config.hot_key_max_replicas
+        << ", disk_promotion_reads=" << master_config.disk_promotion_reads
+        << ", disk_promotion_window_sec="
+        << master_config.disk_promotion_window_sec
+        << ", memory_tier_target_ratio="
+        << master_config.memory_tier_target_ratio
+        << ", tier_demotion_min_idle_sec="
+        << master_config.tier_demotion_min_idle_sec
+        << ", cxl_min_object_size=" << master_config.cxl_min_object_size;
 
     // Start HTTP metadata server if enabled
     std::unique_ptr<mooncake::HttpMetadataServer> http_metadata_server;
@@ -610,6 +1033,12 @@ int main(int argc, char* argv[]) {
             mooncake::WrappedMasterServiceConfig(master_config, version));
 
         mooncake::RegisterRpcService(server, wrapped_master_service);
+        std::unique_ptr<coro_rpc::coro_rpc_server> rdma_server;
+        if (master_config.rdma_rpc_port > 0) {
+            rdma_server = mooncake::StartRdmaRpcServer(
+                master_config.rpc_thread_num, master_config.rdma_rpc_port,
+                master_config.rpc_address, wrapped_master_service);
+        }
         return server.start();
     }
 }
@@ -1,18 +1,28 @@
 #include "master_client.h"
 
+#include <async_simple/coro/Collect.h>
 #include <async_simple/coro/FutureAwaiter.h>
 #include <async_simple/coro/Lazy.h>
 #include <async_simple/coro/SyncAwait.h>
 
+#include <algorithm>
+#include <chrono>
 #include <csignal>
+#include <functional>
+#include <regex>
 #include <string>
+#include <thread>
 #include <vector>
+#include <ylt/coro_io/coro_io.hpp>
 #include <ylt/coro_rpc/impl/coro_rpc_client.hpp>
 #include <ylt/util/tl/expected.hpp>
 
+#include "compact_replica_list.h"
+#include "key_radix_tree.h"
 #include "mutex.h"
 #include "rpc_service.h"
 #include "types.h"
+#include "utils.h"
 #include "utils/scoped_vlog_timer.h"
 #include "master_metric_manager.h"
 #include "version.h"
@@ -57,11 +67,42 @@ struct RpcNameTraits<&WrappedMasterService::GetReplicaListByRegex> {
     static constexpr const char* value = "GetReplicaListByRegex";
 };
 
+template <>
+struct RpcNameTraits<&WrappedMasterService::ScanKeys> {
+    static constexpr const char* value = "ScanKeys";
+};
+
 template <>
 struct RpcNameTraits<&WrappedMasterService::BatchGetReplicaList> {
     static constexpr const char* value = "BatchGetReplicaList";
 };
 
+// Counted as the BatchGetReplicaList it replaces
+template <>
+struct RpcNameTraits<&WrappedMasterService::BatchGetReplicaListCompact> {
+    static constexpr const char* value = "BatchGetReplicaList";
+};
+
+template <>
+struct RpcNameTraits<&WrappedMasterService::LongestCachedPrefix> {
+    static constexpr const char* value = "LongestCachedPrefix";
+};
+
+template <>
+struct RpcNameTraits<&WrappedMasterService::LinkContent> {
+    static constexpr const char* value = "LinkContent";
+};
+
+template <>
+struct RpcNameTraits<&WrappedMasterService::LinkBundle> {
+    static constexpr const char* value = "LinkBundle";
+};
+
+template <>
+struct RpcNameTraits<&WrappedMasterService::BatchResolveBundle> {
+    static constexpr const char* value = "BatchResolveBundle";
+};
+
 template <>
 struct RpcNameTraits<&WrappedMasterService::PutStart> {
     static constexpr const char* value = "PutStart";
@@ -77,6 +118,16 @@ struct RpcNameTraits<&WrappedMasterService::PutEnd> {
     static constexpr const char* value = "PutEnd";
 };
 
+template <>
+struct RpcNameTraits<&WrappedMasterService::PutCommit> {
+    static constexpr const char* value = "PutCommit";
+};
+
+template <>
+struct RpcNameTraits<&WrappedMasterService::GetCommittedReplicaList> {
+    static constexpr const char* value = "GetCommittedReplicaList";
+};
+
 template <>
 struct RpcNameTraits<&WrappedMasterService::BatchPutEnd> {
     static constexpr const char* value = "BatchPutEnd";
@@ -107,6 +158,11 @@ struct RpcNameTraits<&WrappedMasterService::RemoveAll> {
     static constexpr const char* value = "RemoveAll";
 };
 
+template <>
+struct RpcNameTraits<&WrappedMasterService::RemoveByPrefix> {
+    static constexpr const char* value = "RemoveByPrefix";
+};
+
 template <>
 struct RpcNameTraits<&WrappedMasterService::MountSegment> {
     static constexpr const char* value = "MountSegment";
@@ -122,6 +178,16 @@ struct RpcNameTraits<&WrappedMasterService::UnmountSegment> {
     static constexpr const char* value = "UnmountSegment";
 };
 
+template <>
+struct RpcNameTraits<&WrappedMasterService::DrainSegment> {
+    static constexpr const char* value = "DrainSegment";
+};
+
+template <>
+struct RpcNameTraits<&WrappedMasterService::GetKeyFilter> {
+    static constexpr const char* value = "GetKeyFilter";
+};
+
 template <>
 struct RpcNameTraits<&WrappedMasterService::Ping> {
     static constexpr const char* value = "Ping";
@@ -212,9 +278,116 @@ struct RpcNameTraits<&WrappedMasterService::MarkTaskToComplete> {
     static constexpr const char* value = "MarkTaskToComplete";
 };
 
+namespace {
+
+template <typename T>
+std::vector<T> Select(const std::vector<T>& values,
+                      const std::vector<size_t>& indices) {
+    std::vector<T> selected;
+    selected.reserve(indices.size());
+    for (size_t index : indices) {
+        selected.push_back(values[index]);
+    }
+    return selected;
+}
+
+// Merge the results of several masters, failing if any of them failed
+template <typename T, typename MergeFn>
+tl::expected<T, ErrorCode> MergeResults(
+    std::vector<tl::expected<T, ErrorCode>> results, MergeFn merge) {
+    for (const auto& result : results) {
+        if (!result) {
+            return tl::make_unexpected(result.error());
+        }
+    }
+    if (results.empty()) {
+        return T{};
+    }
+    T merged = std::move(results[0].value());
+    for (size_t i = 1; i < results.size(); i++) {
+        merge(merged, std::move(results[i].value()));
+    }
+    return merged;
+}
+
+tl::expected<void, ErrorCode> FirstError(
+    const std::vector<tl::expected<void, ErrorCode>>& results) {
+    for (const auto& result : results) {
+        if (!result) {
+            return result;
+        }
+    }
+    return {};
+}
+
+template <typename Map>
+void MergeMaps(Map& merged, Map&& other) {
+    merged.merge(other);
+}
+
+/**
+ * @brief Split a segment in one contiguous part per master, so that every
+ * master allocates from the memory of every client. The parts keep the id of
+ * the segment, the masters have separate namespaces. Returns no parts if the
+ * segment has fewer slabs than masters, or is not aligned to slabs.
+ */
+std::vector<Segment> SplitSegment(const Segment& segment, size_t num_parts) {
+    constexpr size_t kSlabSize = facebook::cachelib::Slab::kSize;
+    const size_t num_slabs = segment.size / kSlabSize;
+    if (num_slabs < num_parts || segment.base % kSlabSize ||
+        segment.size % kSlabSize) {
+        return {};
+    }
+    std::vector<Segment> parts;
+    parts.reserve(num_parts);
+    uintptr_t base = segment.base;
+    for (size_t i = 0; i < num_parts; i++) {
+        Segment part = segment;
+        part.base = base;
+        part.size =
+            (num_slabs / num_parts + (i < num_slabs % num_parts)) * kSlabSize;
+        base += part.size;
+        parts.push_back(std::move(part));
+    }
+    return parts;
+}
+
+constexpr auto kFailoverRetryInterval = std::chrono::milliseconds(100);
+
+// Whether a call could not reach the master at all
+template <typename T>
+bool IsRpcFailure(const tl::expected<T, ErrorCode>& result) {
+    return !result && result.error() == ErrorCode::RPC_FAIL;
+}
+
+template <typename T>
+bool IsRpcFailure(const std::vector<tl::expected<T, ErrorCode>>& results) {
+    return !results.empty() &&
+           std::all_of(results.begin(), results.end(),
+                       [](const auto& result) { return IsRpcFailure(result); });
+}
+
+// Arguments of rpc_on are owned values, or references to the arguments of
+// synchronous calls
+template <typename T>
+const T& Unwrap(const T& value) {
+    return value;
+}
+
+template <typename T>
+T& Unwrap(std::reference_wrapper<T> ref) {
+    return ref.get();
+}
+
+}  // namespace
+
 template <auto ServiceMethod, typename ReturnType, typename... Args>
-tl::expected<ReturnType, ErrorCode> MasterClient::invoke_rpc(Args&&... args) {
-    auto pool = client_accessor_.GetClientPool();
+async_simple::coro::Lazy<tl::expected<ReturnType, ErrorCode>>
+MasterClient::rpc_on(std::shared_ptr<ClientPool> pool, Args... args) {
+    if (!pool) {
+        LOG(ERROR) << "Not connected to the master";
+        co_return tl::make_unexpected(ErrorCode::RPC_FAIL);
+    }
 
     // Increment RPC counter
     if (metrics_) {
@@ -222,114 +395,375 @@ tl::expected<ReturnType, ErrorCode> MasterClient::invoke_rpc(Args&&... args) {
     }
 
     auto start_time = std::chrono::steady_clock::now();
-    return async_simple::coro::syncAwait(
-        [&]() -> async_simple::coro::Lazy<tl::expected<ReturnType, ErrorCode>> {
-            auto ret = co_await pool->send_request(
-                [&](coro_io::client_reuse_hint,
-                    coro_rpc::coro_rpc_client& client) {
-                    return client.send_request<ServiceMethod>(
-                        std::forward<Args>(args)...);
-                });
-            if (!ret.has_value()) {
-                LOG(ERROR) << "Client not available";
-                co_return tl::make_unexpected(ErrorCode::RPC_FAIL);
-            }
-            auto result = co_await std::move(ret.value());
-            if (!result) {
-                LOG(ERROR) << "RPC call failed: " << result.error().msg;
-                co_return tl::make_unexpected(ErrorCode::RPC_FAIL);
-            }
-            if (metrics_) {
-                auto end_time = std::chrono::steady_clock::now();
-                auto latency =
-                    std::chrono::duration_cast<std::chrono::microseconds>(
-                        end_time - start_time);
-                metrics_->rpc_latency.observe(
-                    {RpcNameTraits<ServiceMethod>::value}, latency.count());
-            }
-            co_return result->result();
-        }());
+    auto ret = co_await pool->send_request(
+        [&](coro_io::client_reuse_hint, coro_rpc::coro_rpc_client& client) {
+            return client.send_request<ServiceMethod>(Unwrap(args)...);
+        });
+    if (!ret.has_value()) {
+        LOG(ERROR) << "Client not available";
+        co_return tl::make_unexpected(ErrorCode::RPC_FAIL);
+    }
+    auto result = co_await std::move(ret.value());
+    if (!result) {
+        LOG(ERROR) << "RPC call failed: " << result.error().msg;
+        co_return tl::make_unexpected(ErrorCode::RPC_FAIL);
+    }
+    if (metrics_) {
+        auto end_time = std::chrono::steady_clock::now();
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+            end_time - start_time);
+        metrics_->rpc_latency.observe({RpcNameTraits<ServiceMethod>::value},
+                                      latency.count());
+    }
+    co_return result->result();
+}
+
+template <auto ServiceMethod, typename ResultType, typename... Args>
+async_simple::coro::Lazy<std::vector<tl::expected<ResultType, ErrorCode>>>
+MasterClient::batch_rpc_on(std::shared_ptr<ClientPool> pool,
+                           size_t input_size, Args... args) {
+    auto result =
+        co_await rpc_on<ServiceMethod,
+                        std::vector<tl::expected<ResultType, ErrorCode>>>(
+            std::move(pool), std::move(args)...);
+    if (!result) {
+        std::vector<tl::expected<ResultType, ErrorCode>> error_results;
+        error_results.reserve(input_size);
+        for (size_t i = 0; i < input_size; ++i) {
+            error_results.emplace_back(tl::make_unexpected(result.error()));
+        }
+        co_return error_results;
+    }
+    co_return std::move(result.value());
+}
+
+template <typename CallFn>
+auto MasterClient::call_with_failover(CallFn call)
+    -> decltype(call(std::shared_ptr<const MasterShards>())) {
+    auto shards = client_accessor_.GetShards();
+    auto result = call(shards);
+    const auto timeout = std::chrono::milliseconds(
+        failover_timeout_ms_.load(std::memory_order_relaxed));
+    if (timeout.count() == 0 || !IsRpcFailure(result)) {
+        return result;
+    }
+    // Wait for the client to move to the new leader, which may still be
+    // starting when it is connected, so keep retrying it until the timeout
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool switched = false;
+    while (IsRpcFailure(result) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(kFailoverRetryInterval);
+        auto current = client_accessor_.GetShards();
+        if (!switched && current == shards) {
+            continue;
+        }
+        switched = true;
+        shards = std::move(current);
+        result = call(shards);
+    }
+    return result;
+}
+
+template <typename Result, typename SendFn>
+Result MasterClient::with_standby_fallback(Result result, SendFn send) {
+    if (!standby_pool_ || !IsRpcFailure(result) || IsSharded()) {
+        return result;
+    }
+    VLOG(1) << "action=query_standby_master, info=leader_unreachable";
+    return async_simple::coro::syncAwait(send(standby_pool_));
+}
+
+template <auto ServiceMethod, typename ReturnType, typename... Args>
+tl::expected<ReturnType, ErrorCode> MasterClient::invoke_rpc(Args&&... args) {
+    return call_with_failover([&](std::shared_ptr<const MasterShards> shards) {
+        return async_simple::coro::syncAwait(rpc_on<ServiceMethod, ReturnType>(
+            shards ? shards->pools[0] : nullptr, std::cref(args)...));
+    });
+}
+
+template <auto ServiceMethod, typename ReturnType, typename... Args>
+tl::expected<ReturnType, ErrorCode> MasterClient::invoke_key_rpc(
+    const std::string& key, Args&&... args) {
+    return call_with_failover([&](std::shared_ptr<const MasterShards> shards) {
+        return async_simple::coro::syncAwait(rpc_on<ServiceMethod, ReturnType>(
+            shards ? shards->pools[shards->ring.ShardOf(key)] : nullptr,
+            std::cref(args)...));
+    });
+}
+
+template <auto ServiceMethod, typename ReturnType, typename... Args>
+async_simple::coro::Lazy<tl::expected<ReturnType, ErrorCode>>
+MasterClient::co_invoke_key_rpc(const std::string& key, const Args&... args) {
+    auto send = [&](const std::shared_ptr<const MasterShards>& shards) {
+        return rpc_on<ServiceMethod, ReturnType>(
+            shards ? shards->pools[shards->ring.ShardOf(key)] : nullptr,
+            std::cref(args)...);
+    };
+    // Same retries as call_with_failover
+    auto shards = client_accessor_.GetShards();
+    auto result = co_await send(shards);
+    const auto timeout = std::chrono::milliseconds(
+        failover_timeout_ms_.load(std::memory_order_relaxed));
+    if (timeout.count() == 0 || !IsRpcFailure(result)) {
+        co_return result;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool switched = false;
+    while (IsRpcFailure(result) &&
+           std::chrono::steady_clock::now() < deadline) {
+        co_await coro_io::sleep_for(kFailoverRetryInterval);
+        auto current = client_accessor_.GetShards();
+        if (!switched && current == shards) {
+            continue;
+        }
+        switched = true;
+        shards = std::move(current);
+        result = co_await send(shards);
+    }
+    co_return result;
+}
+
+template <auto ServiceMethod, typename ReturnType, typename... Args>
+tl::expected<ReturnType, ErrorCode> MasterClient::invoke_rdma_key_rpc(
+    const std::string& key, Args&&... args) {
+    auto shards = client_accessor_.GetShards();
+    const int64_t now_ns =
+        std::chrono::steady_clock::now().time_since_epoch().count();
+    if (shards && !shards->rdma_pools.empty() &&
+        now_ns >= rdma_rpc_retry_at_ns_.load(std::memory_order_relaxed)) {
+        auto result = async_simple::coro::syncAwait(
+            rpc_on<ServiceMethod, ReturnType>(
+                shards->rdma_pools[shards->ring.ShardOf(key)],
+                std::cref(args)...));
+        if (!IsRpcFailure(result)) {
+            return result;
+        }
+        LOG(WARNING) << "action=rdma_rpc_fallback_to_tcp, retry_after_sec="
+                     << kRdmaRpcRetryInterval.count();
+        rdma_rpc_retry_at_ns_.store(
+            now_ns + std::chrono::nanoseconds(kRdmaRpcRetryInterval).count(),
+            std::memory_order_relaxed);
+    }
+    return invoke_key_rpc<ServiceMethod, ReturnType>(
+        key, std::forward<Args>(args)...);
+}
+
+template <auto ServiceMethod, typename ReturnType, typename... Args>
+std::vector<tl::expected<ReturnType, ErrorCode>>
+MasterClient::invoke_rpc_on_all(Args&&... args) {
+    auto shards = client_accessor_.GetShards();
+    if (!shards) {
+        return {tl::make_unexpected(ErrorCode::RPC_FAIL)};
+    }
+    std::vector<async_simple::coro::Lazy<tl::expected<ReturnType, ErrorCode>>>
+        requests;
+    requests.reserve(shards->pools.size());
+    for (const auto& pool : shards->pools) {
+        requests.push_back(
+            rpc_on<ServiceMethod, ReturnType>(pool, std::cref(args)...));
+    }
+    auto responses = async_simple::coro::syncAwait(
+        async_simple::coro::collectAll(std::move(requests)));
+    std::vector<tl::expected<ReturnType, ErrorCode>> results;
+    results.reserve(responses.size());
+    for (auto& response : responses) {
+        results.push_back(std::move(response.value()));
+    }
+    return results;
 }
 
 template <auto ServiceMethod, typename ResultType, typename... Args>
 std::vector<tl::expected<ResultType, ErrorCode>> MasterClient::invoke_batch_rpc(
     size_t input_size, Args&&... args) {
-    auto pool = client_accessor_.GetClientPool();
+    return call_with_failover([&](std::shared_ptr<const MasterShards> shards) {
+        return async_simple::coro::syncAwait(
+            batch_rpc_on<ServiceMethod, ResultType>(
+                shards ? shards->pools[0] : nullptr, input_size,
+                std::cref(args)...));
+    });
+}
 
-    // Increment RPC counter
-    if (metrics_) {
-        metrics_->rpc_count.inc({RpcNameTraits<ServiceMethod>::value});
+template <typename ResultType, typename SendFn>
+std::vector<tl::expected<ResultType, ErrorCode>>
+MasterClient::invoke_sharded_batch_rpc(const std::vector<std::string>& keys,
+                                       SendFn send) {
+    auto shards = client_accessor_.GetShards();
+    const auto shard_indices = shards->Split(keys);
+
+    using BatchResult = std::vector<tl::expected<ResultType, ErrorCode>>;
+    std::vector<async_simple::coro::Lazy<BatchResult>> requests;
+    std::vector<size_t> request_shards;
+    for (size_t shard = 0; shard < shard_indices.size(); shard++) {
+        if (!shard_indices[shard].empty()) {
+            requests.push_back(
+                send(shards->pools[shard], shard_indices[shard]));
+            request_shards.push_back(shard);
+        }
+    }
+    auto responses = async_simple::coro::syncAwait(
+        async_simple::coro::collectAll(std::move(requests)));
+
+    BatchResult results(keys.size(), tl::make_unexpected(ErrorCode::RPC_FAIL));
+    for (size_t r = 0; r < responses.size(); r++) {
+        const auto& indices = shard_indices[request_shards[r]];
+        auto& response = responses[r].value();
+        if (response.size() != indices.size()) {
+            LOG(ERROR) << "shard=" << request_shards[r]
+                       << ", error=batch_result_size_mismatch";
+            continue;
+        }
+        for (size_t j = 0; j < indices.size(); j++) {
+            results[indices[j]] = std::move(response[j]);
+        }
     }
+    return results;
+}
 
-    auto start_time = std::chrono::steady_clock::now();
-    return async_simple::coro::syncAwait(
-        [&]() -> async_simple::coro::Lazy<
-                  std::vector<tl::expected<ResultType, ErrorCode>>> {
-            auto ret = co_await pool->send_request(
-                [&](coro_io::client_reuse_hint,
-                    coro_rpc::coro_rpc_client& client) {
-                    return client.send_request<ServiceMethod>(
-                        std::forward<Args>(args)...);
-                });
-            if (!ret.has_value()) {
-                LOG(ERROR) << "Client not available";
-                co_return std::vector<tl::expected<ResultType, ErrorCode>>(
-                    input_size, tl::make_unexpected(ErrorCode::RPC_FAIL));
-            }
-            auto result = co_await std::move(ret.value());
-            if (!result) {
-                LOG(ERROR) << "Batch RPC call failed: " << result.error().msg;
-                std::vector<tl::expected<ResultType, ErrorCode>> error_results;
-                error_results.reserve(input_size);
-                for (size_t i = 0; i < input_size; ++i) {
-                    error_results.emplace_back(
-                        tl::make_unexpected(ErrorCode::RPC_FAIL));
-                }
-                co_return error_results;
-            }
-            if (metrics_) {
-                auto end_time = std::chrono::steady_clock::now();
-                auto latency =
-                    std::chrono::duration_cast<std::chrono::microseconds>(
-                        end_time - start_time);
-                metrics_->rpc_latency.observe(
-                    {RpcNameTraits<ServiceMethod>::value}, latency.count());
-            }
-            co_return result->result();
-        }());
+template <typename ReturnType, typename SendFn>
+std::vector<tl::expected<ReturnType, ErrorCode>>
+MasterClient::invoke_sharded_rpc(const std::vector<std::string>& keys,
+                                 SendFn send) {
+    auto shards = client_accessor_.GetShards();
+    const auto shard_indices = shards->Split(keys);
+    std::vector<async_simple::coro::Lazy<tl::expected<ReturnType, ErrorCode>>>
+        requests;
+    for (size_t shard = 0; shard < shard_indices.size(); shard++) {
+        if (!shard_indices[shard].empty()) {
+            requests.push_back(
+                send(shards->pools[shard], shard_indices[shard]));
+        }
+    }
+    auto responses = async_simple::coro::syncAwait(
+        async_simple::coro::collectAll(std::move(requests)));
+    std::vector<tl::expected<ReturnType, ErrorCode>> results;
+    results.reserve(responses.size());
+    for (auto& response : responses) {
+        results.push_back(std::move(response.value()));
+    }
+    return results;
+}
+
+template <typename Keys>
+async_simple::coro::Lazy<
+    std::vector<tl::expected<GetReplicaListResponse, ErrorCode>>>
+MasterClient::batch_get_replica_list_on(std::shared_ptr<ClientPool> pool,
+                                        size_t input_size, Keys keys) {
+    auto compact =
+        co_await rpc_on<&WrappedMasterService::BatchGetReplicaListCompact,
+                        CompactReplicaLists>(std::move(pool), std::move(keys));
+    using Results =
+        std::vector<tl::expected<GetReplicaListResponse, ErrorCode>>;
+    if (!compact) {
+        co_return Results(input_size, tl::make_unexpected(compact.error()));
+    }
+    auto results = DecodeReplicaLists(std::move(compact.value()));
+    if (!results) {
+        co_return Results(input_size, tl::make_unexpected(results.error()));
+    }
+    co_return std::move(results.value());
 }
 
 MasterClient::~MasterClient() = default;
 
+void MasterClient::InitCoalescers() {
+    const auto window = std::chrono::microseconds(
+        GetEnvOr<uint64_t>("MC_STORE_RPC_COALESCE_WINDOW_US", 0));
+    if (window.count() == 0) {
+        return;
+    }
+    const size_t max_batch_size =
+        GetEnvOr<uint64_t>("MC_STORE_RPC_COALESCE_MAX_BATCH", 128);
+    LOG(INFO) << "Coalescing ExistKey and GetReplicaList calls, window_us="
+              << window.count() << ", max_batch_size=" << max_batch_size;
+    exist_key_coalescer_ =
+        std::make_unique<RpcCoalescer<tl::expected<bool, ErrorCode>>>(
+            window, max_batch_size,
+            [this](const std::vector<std::string>& keys) {
+                return BatchExistKey(keys);
+            });
+    replica_list_coalescer_ = std::make_unique<
+        RpcCoalescer<tl::expected<GetReplicaListResponse, ErrorCode>>>(
+        window, max_batch_size, [this](const std::vector<std::string>& keys) {
+            return BatchGetReplicaList(keys);
+        });
+}
+
+void MasterClient::InitRdmaRpc() {
+    rdma_rpc_port_ = GetEnvOr<int>("MC_MASTER_RDMA_RPC_PORT", 0);
+    if (rdma_rpc_port_ <= 0) {
+        return;
+    }
+    coro_io::client_pool<coro_rpc::coro_rpc_client>::pool_config pool_conf{};
+    pool_conf.client_config.socket_config = coro_io::ib_socket_t::config_t{};
+    rdma_client_pools_ =
+        std::make_shared<coro_io::client_pools<coro_rpc::coro_rpc_client>>(
+            pool_conf);
+    LOG(INFO) << "Sending ExistKey and GetReplicaList over RDMA, port="
+              << rdma_rpc_port_;
+}
+
+void MasterClient::InitStandbyRpc() {
+    const char* standby_addr = std::getenv("MC_STORE_STANDBY_MASTER");
+    if (!standby_addr || *standby_addr == '\0') {
+        return;
+    }
+    standby_pool_ = client_pools_->at(standby_addr);
+    LOG(INFO) << "Sending ExistKey and GetReplicaList to the standby master "
+              << standby_addr << " when the leader cannot be reached";
+}
+
 ErrorCode MasterClient::Connect(const std::string& master_addr) {
     ScopedVLogTimer timer(1, "MasterClient::Connect");
     timer.LogRequest("master_addr=", master_addr);
 
     MutexLocker lock(&connect_mutex_);
     if (client_addr_param_ != master_addr) {
+        auto addresses = MasterShardRing::ParseMasters(master_addr);
+        if (addresses.empty()) {
+            LOG(ERROR) << "master_addr=" << master_addr
+                       << ", error=no_master_address";
+            timer.LogResponse("error_code=", ErrorCode::INVALID_PARAMS);
+            return ErrorCode::INVALID_PARAMS;
+        }
         // WARNING: The existing client pool cannot be erased. So if there are a
         // lot of different addresses, there will be resource leak problems.
-        auto client_pool = client_pools_->at(master_addr);
-        client_accessor_.SetClientPool(client_pool);
+        auto shards = std::make_shared<MasterShards>(addresses);
+        for (const auto& address : addresses) {
+            shards->pools.push_back(client_pools_->at(address));
+            if (rdma_client_pools_) {
+                // Same host, the port of the RDMA server
+                const std::string host = address.substr(0, address.rfind(':'));
+                shards->rdma_pools.push_back(rdma_client_pools_->at(
+                    host + ":" + std::to_string(rdma_rpc_port_)));
+            }
+        }
+        if (addresses.size() > 1) {
+            LOG(INFO) << "Partitioning the keys over " << addresses.size()
+                      << " masters, master_addr=" << master_addr;
+        }
+        client_accessor_.SetShards(std::move(shards));
         client_addr_param_ = master_addr;
     }
-    auto pool = client_accessor_.GetClientPool();
-    // The client pool does not have native connection check method, so we need
-    // to use custom ServiceReady API.
-    auto result =
-        invoke_rpc<&WrappedMasterService::ServiceReady, std::string>();
-    if (!result.has_value()) {
-        timer.LogResponse("error_code=", result.error());
-        return result.error();
-    }
-    // Check if server version matches client version
-    std::string server_version = result.value();
-    std::string client_version = GetMooncakeStoreVersion();
-    if (server_version != client_version) {
-        LOG(ERROR) << "Version mismatch: server=" << server_version
-                   << " client=" << client_version;
-        timer.LogResponse("error_code=", ErrorCode::INVALID_VERSION);
-        return ErrorCode::INVALID_VERSION;
+    auto shards = client_accessor_.GetShards();
+    for (const auto& pool : shards->pools) {
+        // The client pool does not have native connection check method, so we
+        // need to use custom ServiceReady API.
+        auto result = async_simple::coro::syncAwait(
+            rpc_on<&WrappedMasterService::ServiceReady, std::string>(pool));
+        if (!result.has_value()) {
+            timer.LogResponse("error_code=", result.error());
+            return result.error();
+        }
+        // Check if server version matches client version
+        std::string server_version = result.value();
+        std::string client_version = GetMooncakeStoreVersion();
+        if (server_version != client_version) {
+            LOG(ERROR) << "Version mismatch: server=" << server_version
+                       << " client=" << client_version;
+            timer.LogResponse("error_code=", ErrorCode::INVALID_VERSION);
+            return ErrorCode::INVALID_VERSION;
+        }
     }
     timer.LogResponse("error_code=", ErrorCode::OK);
     return ErrorCode::OK;
@@ -340,7 +774,18 @@ tl::expected<bool, ErrorCode> MasterClient::ExistKey(
     ScopedVLogTimer timer(1, "MasterClient::ExistKey");
     timer.LogRequest("object_key=", object_key);
 
-    auto result = invoke_rpc<&WrappedMasterService::ExistKey, bool>(object_key);
+    if (exist_key_coalescer_) {
+        auto result = exist_key_coalescer_->Call(object_key);
+        timer.LogResponseExpected(result);
+        return result;
+    }
+    auto result = with_standby_fallback(
+        invoke_rdma_key_rpc<&WrappedMasterService::ExistKey, bool>(object_key,
+                                                                   object_key),
+        [&](auto pool) {
+            return rpc_on<&WrappedMasterService::ExistKey, bool>(
+                pool, std::cref(object_key));
+        });
     timer.LogResponseExpected(result);
     return result;
 }
@@ -350,14 +795,30 @@ std::vector<tl::expected<bool, ErrorCode>> MasterClient::BatchExistKey(
     ScopedVLogTimer timer(1, "MasterClient::BatchExistKey");
     timer.LogRequest("keys_count=", object_keys.size());
 
-    auto result = invoke_batch_rpc<&WrappedMasterService::BatchExistKey, bool>(
-        object_keys.size(), object_keys);
+    auto result =
+        IsSharded()
+            ? invoke_sharded_batch_rpc<bool>(
+                  object_keys,
+                  [&](auto pool, const std::vector<size_t>& indices) {
+                      return batch_rpc_on<&WrappedMasterService::BatchExistKey,
+                                          bool>(pool, indices.size(),
+                                                Select(object_keys, indices));
+                  })
+            : with_standby_fallback(
+                  invoke_batch_rpc<&WrappedMasterService::BatchExistKey, bool>(
+                      object_keys.size(), object_keys),
+                  [&](auto pool) {
+                      return batch_rpc_on<&WrappedMasterService::BatchExistKey,
+                                          bool>(pool, object_keys.size(),
+                                                std::cref(object_keys));
+                  });
     timer.LogResponse("result=", result.size(), " keys");
     return result;
 }
 
 tl::expected<MasterMetricManager::CacheHitStatDict, ErrorCode>
 MasterClient::CalcCacheStats() {
+    // Only the first master of a sharded deployment is asked
     return invoke_rpc<&WrappedMasterService::CalcCacheStats,
                       MasterMetricManager::CacheHitStatDict>();
 }
@@ -369,10 +830,12 @@ MasterClient::BatchQueryIp(const std::vector<UUID>& client_ids) {
     ScopedVLogTimer timer(1, "MasterClient::BatchQueryIp");
     timer.LogRequest("client_ids_count=", client_ids.size());
 
-    auto result = invoke_rpc<
-        &WrappedMasterService::BatchQueryIp,
-        std::unordered_map<UUID, std::vector<std::string>, boost::hash<UUID>>>(
-        client_ids);
+    using IpMap =
+        std::unordered_map<UUID, std::vector<std::string>, boost::hash<UUID>>;
+    auto result = MergeResults(
+        invoke_rpc_on_all<&WrappedMasterService::BatchQueryIp, IpMap>(
+            client_ids),
+        MergeMaps<IpMap>);
 
     timer.LogResponseExpected(result);
     return result;
@@ -386,6 +849,25 @@ MasterClient::BatchReplicaClear(const std::vector<std::string>& object_keys,
     timer.LogRequest("object_keys_count=", object_keys.size(),
                      ", client_id=", client_id,
                      ", segment_name=", segment_name);
+    if (IsSharded()) {
+        auto result = MergeResults(
+            invoke_sharded_rpc<std::vector<std::string>>(
+                object_keys,
+                [&](auto pool, const std::vector<size_t>& indices) {
+                    return rpc_on<&WrappedMasterService::BatchReplicaClear,
+                                  std::vector<std::string>>(
+                        pool, Select(object_keys, indices), client_id,
+                        segment_name);
+                }),
+            [](std::vector<std::string>& merged,
+               std::vector<std::string>&& other) {
+                merged.insert(merged.end(),
+                              std::make_move_iterator(other.begin()),
+                              std::make_move_iterator(other.end()));
+            });
+        timer.LogResponseExpected(result);
+        return result;
+    }
     auto result = invoke_rpc<&WrappedMasterService::BatchReplicaClear,
                              std::vector<std::string>>(object_keys, client_id,
                                                        segment_name);
@@ -399,10 +881,79 @@ MasterClient::GetReplicaListByRegex(const std::string& str) {
     ScopedVLogTimer timer(1, "MasterClient::GetReplicaListByRegex");
     timer.LogRequest("Regex=", str);
 
-    auto result = invoke_rpc<
-        &WrappedMasterService::GetReplicaListByRegex,
-        std::unordered_map<std::string, std::vector<Replica::Descriptor>>>(str);
+    std::regex pattern;
+    try {
+        pattern = std::regex(str, std::regex::ECMAScript);
+    } catch (const std::regex_error& e) {
+        LOG(ERROR) << "regex=" << str << ", error=" << e.what();
+        return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+    }
 
+    // Page through the keys with the literal prefix of the pattern, so that
+    // no master has to build the whole result in one response
+    const std::string prefix = GetRegexLiteralPrefix(str);
+    std::unordered_map<std::string, std::vector<Replica::Descriptor>> result;
+    uint64_t cursor = 0;
+    do {
+        auto page = ScanKeys(prefix, cursor);
+        if (!page) {
+            timer.LogResponse("error_code=", page.error());
+            return tl::make_unexpected(page.error());
+        }
+        std::vector<std::string> matched;
+        for (auto& key : page->keys) {
+            if (std::regex_search(key, pattern)) {
+                matched.push_back(std::move(key));
+            }
+        }
+        if (!matched.empty()) {
+            auto replica_lists = BatchGetReplicaList(matched);
+            for (size_t i = 0; i < matched.size(); i++) {
+                // Objects removed or not complete since the scan are skipped
+                if (replica_lists[i]) {
+                    result.emplace(std::move(matched[i]),
+                                   std::move(replica_lists[i]->replicas));
+                }
+            }
+        }
+        cursor = page->next_cursor;
+    } while (cursor != 0);
+
+    timer.LogResponse("keys_count=", result.size());
+    return result;
+}
+
+tl::expected<ScanKeysResponse, ErrorCode> MasterClient::ScanKeys(
+    const std::string& prefix, uint64_t cursor, uint64_t limit) {
+    ScopedVLogTimer timer(1, "MasterClient::ScanKeys");
+    timer.LogRequest("prefix=", prefix, ", cursor=", cursor,
+                     ", limit=", limit);
+
+    // The upper bits of the cursor select the master, the lower ones are
+    // the cursor of that master
+    constexpr int kMasterShift = 48;
+    constexpr uint64_t kMasterCursorMask = (1ULL << kMasterShift) - 1;
+    auto shards = client_accessor_.GetShards();
+    const size_t num_masters = shards ? shards->pools.size() : 1;
+    const size_t master = cursor >> kMasterShift;
+    if (master >= num_masters) {
+        timer.LogResponse("error_code=", ErrorCode::INVALID_PARAMS);
+        return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    const uint64_t master_cursor = cursor & kMasterCursorMask;
+    auto result = async_simple::coro::syncAwait(
+        rpc_on<&WrappedMasterService::ScanKeys, ScanKeysResponse>(
+            shards ? shards->pools[master] : nullptr, prefix, master_cursor,
+            limit));
+    if (result) {
+        if (result->next_cursor != 0) {
+            result->next_cursor |= static_cast<uint64_t>(master)
+                                   << kMasterShift;
+        } else if (master + 1 < num_masters) {
+            result->next_cursor = static_cast<uint64_t>(master + 1)
+                                  << kMasterShift;
+        }
+    }
     timer.LogResponseExpected(result);
     return result;
 }
@@ -412,8 +963,18 @@ tl::expected<GetReplicaListResponse, ErrorCode> MasterClient::GetReplicaList(
     ScopedVLogTimer timer(1, "MasterClient::GetReplicaList");
     timer.LogRequest("object_key=", object_key);
 
-    auto result = invoke_rpc<&WrappedMasterService::GetReplicaList,
-                             GetReplicaListResponse>(object_key);
+    if (replica_list_coalescer_) {
+        auto result = replica_list_coalescer_->Call(object_key);
+        timer.LogResponseExpected(result);
+        return result;
+    }
+    auto result = with_standby_fallback(
+        invoke_rdma_key_rpc<&WrappedMasterService::GetReplicaList,
+                            GetReplicaListResponse>(object_key, object_key),
+        [&](auto pool) {
+            return rpc_on<&WrappedMasterService::GetReplicaList,
+                          GetReplicaListResponse>(pool, std::cref(object_key));
+        });
     timer.LogResponseExpected(result);
     return result;
 }
@@ -423,13 +984,76 @@ MasterClient::BatchGetReplicaList(const std::vector<std::string>& object_keys) {
     ScopedVLogTimer timer(1, "MasterClient::BatchGetReplicaList");
     timer.LogRequest("keys_count=", object_keys.size());
 
-    auto result = invoke_batch_rpc<&WrappedMasterService::BatchGetReplicaList,
-                                   GetReplicaListResponse>(object_keys.size(),
-                                                           object_keys);
+    if (IsSharded()) {
+        auto result = invoke_sharded_batch_rpc<GetReplicaListResponse>(
+            object_keys, [&](auto pool, const std::vector<size_t>& indices) {
+                return batch_get_replica_list_on(pool, indices.size(),
+                                                 Select(object_keys, indices));
+            });
+        timer.LogResponse("result=", result.size(), " operations");
+        return result;
+    }
+    auto shards = client_accessor_.GetShards();
+    auto result = with_standby_fallback(
+        async_simple::coro::syncAwait(batch_get_replica_list_on(
+            shards ? shards->pools[0] : nullptr, object_keys.size(),
+            std::cref(object_keys))),
+        [&](auto pool) {
+            return batch_get_replica_list_on(pool, object_keys.size(),
+                                             std::cref(object_keys));
+        });
     timer.LogResponse("result=", result.size(), " operations");
     return result;
 }
 
+tl::expected<std::vector<GetReplicaListResponse>, ErrorCode>
+MasterClient::LongestCachedPrefix(const std::vector<std::string>& object_keys) {
+    ScopedVLogTimer timer(1, "MasterClient::LongestCachedPrefix");
+    timer.LogRequest("keys_count=", object_keys.size());
+
+    if (!IsSharded()) {
+        auto result =
+            invoke_rpc<&WrappedMasterService::LongestCachedPrefix,
+                       std::vector<GetReplicaListResponse>>(object_keys);
+        timer.LogResponse("hit_count=", result ? result->size() : 0);
+        return result;
+    }
+
+    // Ask the owners of the consecutive runs of keys in turn, until a run is
+    // not fully cached
+    auto shards = client_accessor_.GetShards();
+    std::vector<GetReplicaListResponse> hits;
+    size_t begin = 0;
+    while (begin < object_keys.size()) {
+        const size_t shard = shards->ring.ShardOf(object_keys[begin]);
+        size_t end = begin + 1;
+        while (end < object_keys.size() &&
+               shards->ring.ShardOf(object_keys[end]) == shard) {
+            end++;
+        }
+        auto result = async_simple::coro::syncAwait(
+            rpc_on<&WrappedMasterService::LongestCachedPrefix,
+                   std::vector<GetReplicaListResponse>>(
+                shards->pools[shard],
+                std::vector<std::string>(object_keys.begin() + begin,
+                                         object_keys.begin() + end)));
+        if (!result) {
+            if (hits.empty()) {
+                return tl::make_unexpected(result.error());
+            }
+            break;  // the hits so far are still a cached prefix
+        }
+        const size_t hit_count = result->size();
+        std::move(result->begin(), result->end(), std::back_inserter(hits));
+        if (hit_count < end - begin) {
+            break;
+        }
+        begin = end;
+    }
+    timer.LogResponse("hit_count=", hits.size());
+    return hits;
+}
+
 tl::expected<std::vector<Replica::Descriptor>, ErrorCode>
 MasterClient::PutStart(const std::string& key,
                        const std::vector<size_t>& slice_lengths,
@@ -442,9 +1066,9 @@ MasterClient::PutStart(const std::string& key,
         total_slice_length += slice_length;
     }
 
-    auto result = invoke_rpc<&WrappedMasterService::PutStart,
-                             std::vector<Replica::Descriptor>>(
-        client_id_, key, total_slice_length, config);
+    auto result = invoke_key_rpc<&WrappedMasterService::PutStart,
+                                 std::vector<Replica::Descriptor>>(
+        key, client_id_, key, total_slice_length, config);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -467,6 +1091,18 @@ MasterClient::BatchPutStart(
         total_slice_lengths.emplace_back(total_slice_length);
     }
 
+    if (IsSharded()) {
+        using Replicas = std::vector<Replica::Descriptor>;
+        auto result = invoke_sharded_batch_rpc<Replicas>(
+            keys, [&](auto pool, const std::vector<size_t>& indices) {
+                return batch_rpc_on<&WrappedMasterService::BatchPutStart,
+                                    Replicas>(
+                    pool, indices.size(), client_id_, Select(keys, indices),
+                    Select(total_slice_lengths, indices), config);
+            });
+        timer.LogResponse("result=", result.size(), " operations");
+        return result;
+    }
     auto result = invoke_batch_rpc<&WrappedMasterService::BatchPutStart,
                                    std::vector<Replica::Descriptor>>(
         keys.size(), client_id_, keys, total_slice_lengths, config);
@@ -479,8 +1115,31 @@ tl::expected<void, ErrorCode> MasterClient::PutEnd(const std::string& key,
     ScopedVLogTimer timer(1, "MasterClient::PutEnd");
     timer.LogRequest("key=", key);
 
-    auto result = invoke_rpc<&WrappedMasterService::PutEnd, void>(
-        client_id_, key, replica_type);
+    auto result = invoke_key_rpc<&WrappedMasterService::PutEnd, void>(
+        key, client_id_, key, replica_type);
+    timer.LogResponseExpected(result);
+    return result;
+}
+
+tl::expected<void, ErrorCode> MasterClient::PutCommit(
+    const std::string& key, uint64_t committed_bytes) {
+    ScopedVLogTimer timer(1, "MasterClient::PutCommit");
+    timer.LogRequest("key=", key, ", committed_bytes=", committed_bytes);
+
+    auto result = invoke_key_rpc<&WrappedMasterService::PutCommit, void>(
+        key, client_id_, key, committed_bytes);
+    timer.LogResponseExpected(result);
+    return result;
+}
+
+tl::expected<GetCommittedReplicaListResponse, ErrorCode>
+MasterClient::GetCommittedReplicaList(const std::string& key) {
+    ScopedVLogTimer timer(1, "MasterClient::GetCommittedReplicaList");
+    timer.LogRequest("key=", key);
+
+    auto result =
+        invoke_key_rpc<&WrappedMasterService::GetCommittedReplicaList,
+                       GetCommittedReplicaListResponse>(key, key);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -490,8 +1149,18 @@ std::vector<tl::expected<void, ErrorCode>> MasterClient::BatchPutEnd(
     ScopedVLogTimer timer(1, "MasterClient::BatchPutEnd");
     timer.LogRequest("keys_count=", keys.size());
 
-    auto result = invoke_batch_rpc<&WrappedMasterService::BatchPutEnd, void>(
-        keys.size(), client_id_, keys);
+    auto result =
+        IsSharded()
+            ? invoke_sharded_batch_rpc<void>(
+                  keys,
+                  [&](auto pool, const std::vector<size_t>& indices) {
+                      return batch_rpc_on<&WrappedMasterService::BatchPutEnd,
+                                          void>(pool, indices.size(),
+                                                client_id_,
+                                                Select(keys, indices));
+                  })
+            : invoke_batch_rpc<&WrappedMasterService::BatchPutEnd, void>(
+                  keys.size(), client_id_, keys);
     timer.LogResponse("result=", result.size(), " operations");
     return result;
 }
@@ -501,19 +1170,62 @@ tl::expected<void, ErrorCode> MasterClient::PutRevoke(
     ScopedVLogTimer timer(1, "MasterClient::PutRevoke");
     timer.LogRequest("key=", key);
 
-    auto result = invoke_rpc<&WrappedMasterService::PutRevoke, void>(
-        client_id_, key, replica_type);
+    auto result = invoke_key_rpc<&WrappedMasterService::PutRevoke, void>(
+        key, client_id_, key, replica_type);
     timer.LogResponseExpected(result);
     return result;
 }
 
+async_simple::coro::Lazy<tl::expected<GetReplicaListResponse, ErrorCode>>
+MasterClient::CoroGetReplicaList(std::string object_key) {
+    co_return co_await co_invoke_key_rpc<&WrappedMasterService::GetReplicaList,
+                                         GetReplicaListResponse>(object_key,
+                                                                 object_key);
+}
+
+async_simple::coro::Lazy<
+    tl::expected<std::vector<Replica::Descriptor>, ErrorCode>>
+MasterClient::CoroPutStart(std::string key, std::vector<size_t> slice_lengths,
+                           ReplicateConfig config) {
+    uint64_t total_slice_length = 0;
+    for (const auto& slice_length : slice_lengths) {
+        total_slice_length += slice_length;
+    }
+    co_return co_await co_invoke_key_rpc<&WrappedMasterService::PutStart,
+                                         std::vector<Replica::Descriptor>>(
+        key, client_id_, key, total_slice_length, config);
+}
+
+async_simple::coro::Lazy<tl::expected<void, ErrorCode>>
+MasterClient::CoroPutEnd(std::string key, ReplicaType replica_type) {
+    co_return co_await co_invoke_key_rpc<&WrappedMasterService::PutEnd, void>(
+        key, client_id_, key, replica_type);
+}
+
+async_simple::coro::Lazy<tl::expected<void, ErrorCode>>
+MasterClient::CoroPutRevoke(std::string key, ReplicaType replica_type) {
+    co_return co_await co_invoke_key_rpc<&WrappedMasterService::PutRevoke,
+                                         void>(key, client_id_, key,
+                                               replica_type);
+}
+
 std::vector<tl::expected<void, ErrorCode>> MasterClient::BatchPutRevoke(
     const std::vector<std::string>& keys) {
     ScopedVLogTimer timer(1, "MasterClient::BatchPutRevoke");
     timer.LogRequest("keys_count=", keys.size());
 
-    auto result = invoke_batch_rpc<&WrappedMasterService::BatchPutRevoke, void>(
-        keys.size(), client_id_, keys);
+    auto result =
+        IsSharded()
+            ? invoke_sharded_batch_rpc<void>(
+                  keys,
+                  [&](auto pool, const std::vector<size_t>& indices) {
+                      return batch_rpc_on<&WrappedMasterService::BatchPutRevoke,
+                                          void>(pool, indices.size(),
+                                                client_id_,
+                                                Select(keys, indices));
+                  })
+            : invoke_batch_rpc<&WrappedMasterService::BatchPutRevoke, void>(
+                  keys.size(), client_id_, keys);
     timer.LogResponse("result=", result.size(), " operations");
     return result;
 }
@@ -523,27 +1235,115 @@ tl::expected<void, ErrorCode> MasterClient::Remove(const std::string& key,
     ScopedVLogTimer timer(1, "MasterClient::Remove");
     timer.LogRequest("key=", key, ", force=", force);
 
-    auto result = invoke_rpc<&WrappedMasterService::Remove, void>(key, force);
+    auto result =
+        invoke_key_rpc<&WrappedMasterService::Remove, void>(key, key, force);
     timer.LogResponseExpected(result);
     return result;
 }
 
+tl::expected<void, ErrorCode> MasterClient::LinkContent(
+    const std::string& key, const std::string& content_key) {
+    ScopedVLogTimer timer(1, "MasterClient::LinkContent");
+    timer.LogRequest("key=", key, ", content_key=", content_key);
+
+    // The content object must live on the master of the key
+    if (IsSharded()) {
+        auto shards = client_accessor_.GetShards();
+        if (shards->ring.ShardOf(key) != shards->ring.ShardOf(content_key)) {
+            return tl::make_unexpected(ErrorCode::UNAVAILABLE_IN_CURRENT_MODE);
+        }
+    }
+
+    auto result = invoke_key_rpc<&WrappedMasterService::LinkContent, void>(
+        key, key, content_key);
+    timer.LogResponseExpected(result);
+    return result;
+}
+
+tl::expected<void, ErrorCode> MasterClient::LinkBundle(
+    const std::string& bundle_key, const std::vector<std::string>& keys,
+    const std::vector<uint64_t>& sizes) {
+    ScopedVLogTimer timer(1, "MasterClient::LinkBundle");
+    timer.LogRequest("bundle_key=", bundle_key, ", keys_count=", keys.size());
+
+    // The bundle object must live on the master of its keys
+    if (IsSharded()) {
+        auto shards = client_accessor_.GetShards();
+        const size_t shard = shards->ring.ShardOf(bundle_key);
+        for (const auto& key : keys) {
+            if (shards->ring.ShardOf(key) != shard) {
+                return tl::make_unexpected(
+                    ErrorCode::UNAVAILABLE_IN_CURRENT_MODE);
+            }
+        }
+    }
+
+    auto result = invoke_key_rpc<&WrappedMasterService::LinkBundle, void>(
+        bundle_key, bundle_key, keys, sizes);
+    timer.LogResponseExpected(result);
+    return result;
+}
+
+std::vector<tl::expected<BundleMember, ErrorCode>>
+MasterClient::BatchResolveBundle(const std::vector<std::string>& keys) {
+    ScopedVLogTimer timer(1, "MasterClient::BatchResolveBundle");
+    timer.LogRequest("keys_count=", keys.size());
+
+    auto result =
+        IsSharded()
+            ? invoke_sharded_batch_rpc<BundleMember>(
+                  keys,
+                  [&](auto pool, const std::vector<size_t>& indices) {
+                      return batch_rpc_on<
+                          &WrappedMasterService::BatchResolveBundle,
+                          BundleMember>(pool, indices.size(),
+                                        Select(keys, indices));
+                  })
+            : invoke_batch_rpc<&WrappedMasterService::BatchResolveBundle,
+                               BundleMember>(keys.size(), keys);
+    timer.LogResponse("result=", result.size(), " keys");
+    return result;
+}
+
 tl::expected<long, ErrorCode> MasterClient::RemoveByRegex(
     const std::string& str, bool force) {
     ScopedVLogTimer timer(1, "MasterClient::RemoveByRegex");
     timer.LogRequest("key=", str, ", force=", force);
 
-    auto result =
-        invoke_rpc<&WrappedMasterService::RemoveByRegex, long>(str, force);
+    auto result = MergeResults(
+        invoke_rpc_on_all<&WrappedMasterService::RemoveByRegex, long>(str,
+                                                                      force),
+        [](long& merged, long other) { merged += other; });
     timer.LogResponseExpected(result);
     return result;
 }
 
+tl::expected<std::vector<UUID>, ErrorCode> MasterClient::RemoveByPrefix(
+    const std::string& prefix, bool force) {
+    ScopedVLogTimer timer(1, "MasterClient::RemoveByPrefix");
+    timer.LogRequest("prefix=", prefix, ", force=", force);
+
+    std::vector<UUID> task_ids;
+    for (auto& result :
+         invoke_rpc_on_all<&WrappedMasterService::RemoveByPrefix, UUID>(
+             prefix, force)) {
+        if (!result) {
+            timer.LogResponse("error_code=", result.error());
+            return tl::make_unexpected(result.error());
+        }
+        task_ids.push_back(result.value());
+    }
+    timer.LogResponse("task_count=", task_ids.size());
+    return task_ids;
+}
+
 tl::expected<long, ErrorCode> MasterClient::RemoveAll(bool force) {
     ScopedVLogTimer timer(1, "MasterClient::RemoveAll");
     timer.LogRequest("action=remove_all_objects, force=", force);
 
-    auto result = invoke_rpc<&WrappedMasterService::RemoveAll, long>(force);
+    auto result = MergeResults(
+        invoke_rpc_on_all<&WrappedMasterService::RemoveAll, long>(force),
+        [](long& merged, long other) { merged += other; });
     timer.LogResponseExpected(result);
     return result;
 }
@@ -555,8 +1355,37 @@ tl::expected<void, ErrorCode> MasterClient::MountSegment(
                      ", name=", segment.name, ", id=", segment.id,
                      ", client_id=", client_id_);
 
-    auto result = invoke_rpc<&WrappedMasterService::MountSegment, void>(
-        segment, client_id_);
+    if (!IsSharded()) {
+        auto result = invoke_rpc<&WrappedMasterService::MountSegment, void>(
+            segment, client_id_);
+        timer.LogResponseExpected(result);
+        return result;
+    }
+
+    auto shards = client_accessor_.GetShards();
+    auto parts = SplitSegment(segment, shards->pools.size());
+    if (parts.empty()) {
+        // Too small to split, all of it goes to a single master
+        auto result = invoke_key_rpc<&WrappedMasterService::MountSegment, void>(
+            segment.name, segment, client_id_);
+        timer.LogResponseExpected(result);
+        return result;
+    }
+    std::vector<async_simple::coro::Lazy<tl::expected<void, ErrorCode>>>
+        requests;
+    for (size_t shard = 0; shard < parts.size(); shard++) {
+        requests.push_back(rpc_on<&WrappedMasterService::MountSegment, void>(
+            shards->pools[shard], parts[shard], client_id_));
+    }
+    auto responses = async_simple::coro::syncAwait(
+        async_simple::coro::collectAll(std::move(requests)));
+    tl::expected<void, ErrorCode> result;
+    for (auto& response : responses) {
+        if (!response.value()) {
+            result = response.value();
+            break;
+        }
+    }
     timer.LogResponseExpected(result);
     return result;
 }
@@ -567,8 +1396,44 @@ tl::expected<void, ErrorCode> MasterClient::ReMountSegment(
     timer.LogRequest("segments_num=", segments.size(),
                      ", client_id=", client_id_);
 
-    auto result = invoke_rpc<&WrappedMasterService::ReMountSegment, void>(
-        segments, client_id_);
+    if (!IsSharded()) {
+        auto result = invoke_rpc<&WrappedMasterService::ReMountSegment, void>(
+            segments, client_id_);
+        timer.LogResponseExpected(result);
+        return result;
+    }
+
+    // Split the segments as MountSegment did, every master is sent its
+    // parts, possibly none, so that it marks the client as remounted
+    auto shards = client_accessor_.GetShards();
+    std::vector<std::vector<Segment>> shard_segments(shards->pools.size());
+    for (const auto& segment : segments) {
+        auto parts = SplitSegment(segment, shards->pools.size());
+        if (parts.empty()) {
+            shard_segments[shards->ring.ShardOf(segment.name)].push_back(
+                segment);
+            continue;
+        }
+        for (size_t shard = 0; shard < parts.size(); shard++) {
+            shard_segments[shard].push_back(std::move(parts[shard]));
+        }
+    }
+    std::vector<async_simple::coro::Lazy<tl::expected<void, ErrorCode>>>
+        requests;
+    for (size_t shard = 0; shard < shard_segments.size(); shard++) {
+        requests.push_back(rpc_on<&WrappedMasterService::ReMountSegment, void>(
+            shards->pools[shard], std::move(shard_segments[shard]),
+            client_id_));
+    }
+    auto responses = async_simple::coro::syncAwait(
+        async_simple::coro::collectAll(std::move(requests)));
+    tl::expected<void, ErrorCode> result;
+    for (auto& response : responses) {
+        if (!response.value()) {
+            result = response.value();
+            break;
+        }
+    }
     timer.LogResponseExpected(result);
     return result;
 }
@@ -578,18 +1443,78 @@ tl::expected<void, ErrorCode> MasterClient::UnmountSegment(
     ScopedVLogTimer timer(1, "MasterClient::UnmountSegment");
     timer.LogRequest("segment_id=", segment_id, ", client_id=", client_id_);
 
-    auto result = invoke_rpc<&WrappedMasterService::UnmountSegment, void>(
-        segment_id, client_id_);
+    auto result = FirstError(
+        invoke_rpc_on_all<&WrappedMasterService::UnmountSegment, void>(
+            segment_id, client_id_));
     timer.LogResponseExpected(result);
     return result;
 }
 
-tl::expected<PingResponse, ErrorCode> MasterClient::Ping() {
-    ScopedVLogTimer timer(1, "MasterClient::Ping");
-    timer.LogRequest("client_id=", client_id_);
+tl::expected<uint64_t, ErrorCode> MasterClient::DrainSegment(
+    const UUID& segment_id) {
+    ScopedVLogTimer timer(1, "MasterClient::DrainSegment");
+    timer.LogRequest("segment_id=", segment_id, ", client_id=", client_id_);
 
-    auto result =
-        invoke_rpc<&WrappedMasterService::Ping, PingResponse>(client_id_);
+    // Every master holds a part of the segment
+    auto result = MergeResults(
+        invoke_rpc_on_all<&WrappedMasterService::DrainSegment, uint64_t>(
+            segment_id, client_id_),
+        [](uint64_t& merged, uint64_t&& other) { merged += other; });
+    timer.LogResponseExpected(result);
+    return result;
+}
+
+std::vector<tl::expected<GetKeyFilterResponse, ErrorCode>>
+MasterClient::GetKeyFilter(const std::vector<uint64_t>& since) {
+    ScopedVLogTimer timer(1, "MasterClient::GetKeyFilter");
+    timer.LogRequest("num_masters=", since.size());
+
+    // Every master has its own sequence numbers
+    auto shards = client_accessor_.GetShards();
+    const size_t num_masters = shards ? shards->pools.size() : 1;
+    std::vector<async_simple::coro::Lazy<
+        tl::expected<GetKeyFilterResponse, ErrorCode>>>
+        requests;
+    requests.reserve(num_masters);
+    for (size_t i = 0; i < num_masters; i++) {
+        requests.push_back(
+            rpc_on<&WrappedMasterService::GetKeyFilter, GetKeyFilterResponse>(
+                shards ? shards->pools[i] : nullptr,
+                i < since.size() ? since[i] : 0));
+    }
+    auto responses = async_simple::coro::syncAwait(
+        async_simple::coro::collectAll(std::move(requests)));
+    std::vector<tl::expected<GetKeyFilterResponse, ErrorCode>> results;
+    results.reserve(responses.size());
+    for (auto& response : responses) {
+        results.push_back(std::move(response.value()));
+    }
+    return results;
+}
+
+tl::expected<PingResponse, ErrorCode> MasterClient::Ping(
+    uint64_t transfer_bytes_per_sec) {
+    ScopedVLogTimer timer(1, "MasterClient::Ping");
+    timer.LogRequest("client_id=", client_id_,
+                     ", transfer_bytes_per_sec=", transfer_bytes_per_sec);
+
+    // The combined view changes whenever the view of a master changes
+    auto result = MergeResults(
+        invoke_rpc_on_all<&WrappedMasterService::Ping, PingResponse>(
+            client_id_, transfer_bytes_per_sec),
+        [](PingResponse& merged, PingResponse&& other) {
+            merged.view_version_id += other.view_version_id;
+            merged.replica_invalidation_epoch +=
+                other.replica_invalidation_epoch;
+            // The fullest master throttles the puts
+            merged.mem_used_ratio =
+                std::max(merged.mem_used_ratio, other.mem_used_ratio);
+            merged.put_backoff_ms =
+                std::max(merged.put_backoff_ms, other.put_backoff_ms);
+            if (other.client_status == ClientStatus::NEED_REMOUNT) {
+                merged.client_status = ClientStatus::NEED_REMOUNT;
+            }
+        });
     timer.LogResponseExpected(result);
     return result;
 }
@@ -620,9 +1545,9 @@ tl::expected<void, ErrorCode> MasterClient::MountLocalDiskSegment(
     timer.LogRequest("client_id=", client_id,
                      ", enable_offloading=", enable_offloading);
 
-    auto result =
-        invoke_rpc<&WrappedMasterService::MountLocalDiskSegment, void>(
-            client_id, enable_offloading);
+    auto result = FirstError(
+        invoke_rpc_on_all<&WrappedMasterService::MountLocalDiskSegment, void>(
+            client_id, enable_offloading));
     timer.LogResponseExpected(result);
     return result;
 }
@@ -632,8 +1557,8 @@ tl::expected<UUID, ErrorCode> MasterClient::CreateCopyTask(
     ScopedVLogTimer timer(1, "MasterClient::CreateCopyTask");
     timer.LogRequest("key=", key, ", targets_size=", targets.size());
 
-    auto result =
-        invoke_rpc<&WrappedMasterService::CreateCopyTask, UUID>(key, targets);
+    auto result = invoke_key_rpc<&WrappedMasterService::CreateCopyTask, UUID>(
+        key, key, targets);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -644,22 +1569,26 @@ tl::expected<UUID, ErrorCode> MasterClient::CreateMoveTask(
     ScopedVLogTimer timer(1, "MasterClient::CreateMoveTask");
     timer.LogRequest("key=", key, ", source=", source, ", target=", target);
 
-    auto result = invoke_rpc<&WrappedMasterService::CreateMoveTask, UUID>(
-        key, source, target);
+    auto result = invoke_key_rpc<&WrappedMasterService::CreateMoveTask, UUID>(
+        key, key, source, target);
     timer.LogResponseExpected(result);
     return result;
 }
 
 tl::expected<std::unordered_map<std::string, int64_t>, ErrorCode>
 MasterClient::OffloadObjectHeartbeat(const UUID& client_id,
-                                     bool enable_offloading) {
+                                     bool enable_offloading,
+                                     uint64_t max_objects) {
     ScopedVLogTimer timer(1, "MasterClient::OffloadObjectHeartbeat");
     timer.LogRequest("client_id=", client_id,
-                     ", enable_offloading=", enable_offloading);
-
-    auto result = invoke_rpc<&WrappedMasterService::OffloadObjectHeartbeat,
-                             std::unordered_map<std::string, int64_t>>(
-        client_id, enable_offloading);
+                     ", enable_offloading=", enable_offloading,
+                     ", max_objects=", max_objects);
+
+    using ObjectMap = std::unordered_map<std::string, int64_t>;
+    auto result = MergeResults(
+        invoke_rpc_on_all<&WrappedMasterService::OffloadObjectHeartbeat,
+                          ObjectMap>(client_id, enable_offloading, max_objects),
+        MergeMaps<ObjectMap>);
     return result;
 }
 
@@ -670,6 +1599,16 @@ tl::expected<void, ErrorCode> MasterClient::NotifyOffloadSuccess(
     timer.LogRequest("client_id=", client_id, ", keys_count=", keys.size(),
                      ", metadatas_count=", metadatas.size());
 
+    if (IsSharded()) {
+        auto result = FirstError(invoke_sharded_rpc<void>(
+            keys, [&](auto pool, const std::vector<size_t>& indices) {
+                return rpc_on<&WrappedMasterService::NotifyOffloadSuccess,
+                              void>(pool, client_id, Select(keys, indices),
+                                    Select(metadatas, indices));
+            }));
+        timer.LogResponseExpected(result);
+        return result;
+    }
     auto result = invoke_rpc<&WrappedMasterService::NotifyOffloadSuccess, void>(
         client_id, keys, metadatas);
     timer.LogResponseExpected(result);
@@ -684,8 +1623,8 @@ tl::expected<CopyStartResponse, ErrorCode> MasterClient::CopyStart(
                      ", tgt_segments_count=", tgt_segments.size());
 
     auto result =
-        invoke_rpc<&WrappedMasterService::CopyStart, CopyStartResponse>(
-            client_id_, key, src_segment, tgt_segments);
+        invoke_key_rpc<&WrappedMasterService::CopyStart, CopyStartResponse>(
+            key, client_id_, key, src_segment, tgt_segments);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -695,9 +1634,19 @@ tl::expected<QueryTaskResponse, ErrorCode> MasterClient::QueryTask(
     ScopedVLogTimer timer(1, "MasterClient::QueryTask");
     timer.LogRequest("task_id=", task_id);
 
-    auto result =
-        invoke_rpc<&WrappedMasterService::QueryTask, QueryTaskResponse>(
-            task_id);
+    // Task ids are not routed, ask the masters until one knows the task
+    tl::expected<QueryTaskResponse, ErrorCode> result =
+        tl::make_unexpected(ErrorCode::TASK_NOT_FOUND);
+    auto shards = client_accessor_.GetShards();
+    const size_t num_shards = shards ? shards->pools.size() : 1;
+    for (size_t shard = 0; shard < num_shards; shard++) {
+        result = async_simple::coro::syncAwait(
+            rpc_on<&WrappedMasterService::QueryTask, QueryTaskResponse>(
+                shards ? shards->pools[shard] : nullptr, task_id));
+        if (result || result.error() != ErrorCode::TASK_NOT_FOUND) {
+            break;
+        }
+    }
     timer.LogResponseExpected(result);
     return result;
 }
@@ -706,8 +1655,8 @@ tl::expected<void, ErrorCode> MasterClient::CopyEnd(const std::string& key) {
     ScopedVLogTimer timer(1, "MasterClient::CopyEnd");
     timer.LogRequest("key=", key);
 
-    auto result =
-        invoke_rpc<&WrappedMasterService::CopyEnd, void>(client_id_, key);
+    auto result = invoke_key_rpc<&WrappedMasterService::CopyEnd, void>(
+        key, client_id_, key);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -716,9 +1665,15 @@ tl::expected<std::vector<TaskAssignment>, ErrorCode> MasterClient::FetchTasks(
     size_t batch_size) {
     ScopedVLogTimer timer(1, "MasterClient::FetchTasks");
     timer.LogRequest("client_id=", client_id_, ", batch_size=", batch_size);
-    auto result =
-        invoke_rpc<&WrappedMasterService::FetchTasks,
-                   std::vector<TaskAssignment>>(client_id_, batch_size);
+    // Up to batch_size tasks from every master
+    auto result = MergeResults(
+        invoke_rpc_on_all<&WrappedMasterService::FetchTasks,
+                          std::vector<TaskAssignment>>(client_id_, batch_size),
+        [](std::vector<TaskAssignment>& merged,
+           std::vector<TaskAssignment>&& other) {
+            merged.insert(merged.end(), std::make_move_iterator(other.begin()),
+                          std::make_move_iterator(other.end()));
+        });
     timer.LogResponseExpected(result);
     return result;
 }
@@ -727,8 +1682,8 @@ tl::expected<void, ErrorCode> MasterClient::CopyRevoke(const std::string& key) {
     ScopedVLogTimer timer(1, "MasterClient::CopyRevoke");
     timer.LogRequest("key=", key);
 
-    auto result =
-        invoke_rpc<&WrappedMasterService::CopyRevoke, void>(client_id_, key);
+    auto result = invoke_key_rpc<&WrappedMasterService::CopyRevoke, void>(
+        key, client_id_, key);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -741,8 +1696,8 @@ tl::expected<MoveStartResponse, ErrorCode> MasterClient::MoveStart(
                      ", tgt_segment=", tgt_segment);
 
     auto result =
-        invoke_rpc<&WrappedMasterService::MoveStart, MoveStartResponse>(
-            client_id_, key, src_segment, tgt_segment);
+        invoke_key_rpc<&WrappedMasterService::MoveStart, MoveStartResponse>(
+            key, client_id_, key, src_segment, tgt_segment);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -751,8 +1706,8 @@ tl::expected<void, ErrorCode> MasterClient::MoveEnd(const std::string& key) {
     ScopedVLogTimer timer(1, "MasterClient::MoveEnd");
     timer.LogRequest("key=", key);
 
-    auto result =
-        invoke_rpc<&WrappedMasterService::MoveEnd, void>(client_id_, key);
+    auto result = invoke_key_rpc<&WrappedMasterService::MoveEnd, void>(
+        key, client_id_, key);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -761,8 +1716,8 @@ tl::expected<void, ErrorCode> MasterClient::MoveRevoke(const std::string& key) {
     ScopedVLogTimer timer(1, "MasterClient::MoveRevoke");
     timer.LogRequest("key=", key);
 
-    auto result =
-        invoke_rpc<&WrappedMasterService::MoveRevoke, void>(client_id_, key);
+    auto result = invoke_key_rpc<&WrappedMasterService::MoveRevoke, void>(
+        key, client_id_, key);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -771,8 +1726,19 @@ tl::expected<void, ErrorCode> MasterClient::MarkTaskToComplete(
     const TaskCompleteRequest& task_update) {
     ScopedVLogTimer timer(1, "MasterClient::MarkTaskToComplete");
     timer.LogRequest("client_id=", client_id_, ", task_id=", task_update.id);
-    auto result = invoke_rpc<&WrappedMasterService::MarkTaskToComplete, void>(
-        client_id_, task_update);
+    tl::expected<void, ErrorCode> result =
+        tl::make_unexpected(ErrorCode::TASK_NOT_FOUND);
+    auto shards = client_accessor_.GetShards();
+    const size_t num_shards = shards ? shards->pools.size() : 1;
+    for (size_t shard = 0; shard < num_shards; shard++) {
+        result = async_simple::coro::syncAwait(
+            rpc_on<&WrappedMasterService::MarkTaskToComplete, void>(
+                shards ? shards->pools[shard] : nullptr, client_id_,
+                task_update));
+        if (result || result.error() != ErrorCode::TASK_NOT_FOUND) {
+            break;
+        }
+    }
     timer.LogResponseExpected(result);
     return result;
 }
@@ -1,11 +1,13 @@
 #include "master_metric_manager.h"
 
 #include <glog/logging.h>
+#include <algorithm>
 #include <iomanip>  // For std::fixed, std::setprecision
 #include <sstream>  // For string building during serialization
 #include <vector>   // Required by histogram serialization
 #include <cmath>
 
+#include "allocator.h"
 #include "utils.h"
 
 namespace mooncake {
@@ -41,6 +43,12 @@ MasterMetricManager::MasterMetricManager()
       soft_pin_key_count_(
           "master_soft_pin_key_count",
           "Total number of soft-pinned keys managed by the master"),
+      metadata_index_bytes_(
+          "master_metadata_index_bytes",
+          "Memory bytes used by the key index of the master metadata"),
+      metadata_index_bytes_per_key_(
+          "master_metadata_index_bytes_per_key",
+          "Average memory bytes used by the key index per key"),
       // Initialize Histogram (4KB, 64KB, 256KB, 1MB, 4MB, 16MB, 64MB)
       value_size_distribution_(
           "master_value_size_bytes", "Distribution of object value sizes",
@@ -49,6 +57,60 @@ MasterMetricManager::MasterMetricManager()
       active_clients_("master_active_clients",
                       "Total number of active clients"),
 
+      // Initialize Tenant Metrics
+      tenant_used_bytes_("tenant_used_bytes",
+                         "Memory bytes charged to the tenant", {"tenant"}),
+      tenant_quota_exceeded_(
+          "tenant_quota_exceeded_total",
+          "PutStart requests rejected by the memory quota of the tenant",
+          {"tenant"}),
+      tenant_rate_limited_(
+          "tenant_rate_limited_total",
+          "PutStart requests rejected by the rate limit of the tenant",
+          {"tenant"}),
+      tenant_evicted_bytes_("tenant_evicted_bytes_total",
+                            "Memory bytes of the tenant freed by eviction",
+                            {"tenant"}),
+
+      // Initialize Latency Metrics
+      rpc_latency_us_("master_rpc_latency_us",
+                      "Latency of the RPCs served by the master (in us)",
+                      {50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000,
+                       50000, 100000, 200000, 500000, 1000000},
+                      {}, {"rpc"}),
+      shard_lock_contended_(
+          "master_shard_lock_contended",
+          "Metadata shard lock acquisitions that had to wait"),
+      shard_lock_wait_us_(
+          "master_shard_lock_wait_us",
+          "Total time spent waiting for metadata shard locks (in us)"),
+
+      // Initialize Allocator Metrics
+      segment_free_bytes_("segment_free_bytes",
+                          "Memory bytes of the segment left for new buffers",
+                          {"segment"}),
+      segment_largest_free_region_(
+          "segment_largest_free_region_bytes",
+          "Largest buffer that can be allocated on the segment", {"segment"}),
+      segment_free_regions_("segment_free_regions",
+                            "Number of free regions of the segment, 0 if "
+                            "its allocator does not track them",
+                            {"segment"}),
+      segment_fragmentation_percent_(
+          "segment_fragmentation_percent",
+          "Share of the free bytes of the segment that cannot serve its "
+          "largest allocations",
+          {"segment"}),
+      segment_allocation_latency_ns_(
+          "segment_allocation_latency_ns",
+          "Latency of the buffer allocations on the segment (in ns)",
+          {250, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 1000000},
+          {}, {"segment"}),
+      segment_allocation_failures_(
+          "segment_allocation_failures_total",
+          "Buffer allocations on the segment that found no room",
+          {"segment"}),
+
       // Initialize Request Counters
       put_start_requests_("master_put_start_requests_total",
                           "Total number of PutStart requests received"),
@@ -74,6 +136,26 @@ MasterMetricManager::MasterMetricManager()
       get_replica_list_by_regex_failures_(
           "master_get_replica_list_by_regex_failures_total",
           "Total number of failed GetReplicaListByRegex requests"),
+      longest_cached_prefix_requests_(
+          "master_longest_cached_prefix_requests_total",
+          "Total number of LongestCachedPrefix requests received"),
+      longest_cached_prefix_failures_(
+          "master_longest_cached_prefix_failures_total",
+          "Total number of failed LongestCachedPrefix requests"),
+      link_content_requests_("master_link_content_requests_total",
+                             "Total number of LinkContent requests received"),
+      link_content_failures_("master_link_content_failures_total",
+                             "Total number of failed LinkContent requests"),
+      link_bundle_requests_("master_link_bundle_requests_total",
+                            "Total number of LinkBundle requests received"),
+      link_bundle_failures_("master_link_bundle_failures_total",
+                            "Total number of failed LinkBundle requests"),
+      resolve_bundle_requests_(
+          "master_resolve_bundle_requests_total",
+          "Total number of keys received by BatchResolveBundle requests"),
+      resolve_bundle_failures_(
+          "master_resolve_bundle_failures_total",
+          "Total number of keys BatchResolveBundle failed to resolve"),
       exist_key_requests_("master_exist_key_requests_total",
                           "Total number of ExistKey requests received"),
       exist_key_failures_("master_exist_key_failures_total",
@@ -88,6 +170,16 @@ MasterMetricManager::MasterMetricManager()
       remove_by_regex_failures_(
           "master_remove_by_regex_failures_total",
           "Total number of failed RemoveByRegex requests"),
+      remove_by_prefix_requests_(
+          "master_remove_by_prefix_requests_total",
+          "Total number of RemoveByPrefix requests received"),
+      remove_by_prefix_failures_(
+          "master_remove_by_prefix_failures_total",
+          "Total number of failed RemoveByPrefix requests"),
+      scan_keys_requests_("master_scan_keys_requests_total",
+                          "Total number of ScanKeys requests received"),
+      scan_keys_failures_("master_scan_keys_failures_total",
+                          "Total number of failed ScanKeys requests"),
       remove_all_requests_("master_remove_all_requests_total",
                            "Total number of Remove all requests received"),
       remove_all_failures_("master_remove_all_failures_total",
@@ -109,6 +201,30 @@ MasterMetricManager::MasterMetricManager()
       remount_segment_failures_(
           "master_remount_segment_failures_total",
           "Total number of failed RemountSegment requests"),
+      drain_segment_requests_(
+          "master_drain_segment_requests_total",
+          "Total number of DrainSegment requests received"),
+      drain_segment_failures_(
+          "master_drain_segment_failures_total",
+          "Total number of failed DrainSegment requests"),
+      get_key_filter_requests_(
+          "master_get_key_filter_requests_total",
+          "Total number of GetKeyFilter requests received"),
+      get_key_filter_failures_(
+          "master_get_key_filter_failures_total",
+          "Total number of failed GetKeyFilter requests"),
+      put_commit_requests_(
+          "master_put_commit_requests_total",
+          "Total number of PutCommit requests received"),
+      put_commit_failures_(
+          "master_put_commit_failures_total",
+          "Total number of failed PutCommit requests"),
+      get_committed_replica_list_requests_(
+          "master_get_committed_replica_list_requests_total",
+          "Total number of GetCommittedReplicaList requests received"),
+      get_committed_replica_list_failures_(
+          "master_get_committed_replica_list_failures_total",
+          "Total number of failed GetCommittedReplicaList requests"),
       ping_requests_("master_ping_requests_total",
                      "Total number of ping requests received"),
       ping_failures_("master_ping_failures_total",
@@ -240,6 +356,26 @@ MasterMetricManager::MasterMetricManager()
                          "Total number of keys evicted"),
       evicted_size_("master_evicted_size_bytes",
                     "Total bytes of evicted objects"),
+      ttl_expired_key_count_("master_ttl_expired_key_count",
+                             "Total number of keys removed by their TTL"),
+
+      // Initialize Tiering Counters
+      demoted_key_count_("master_demoted_key_count",
+                         "Total number of keys demoted to the local disk tier"),
+      demoted_size_("master_demoted_size_bytes",
+                    "Total bytes of objects demoted to the local disk tier"),
+
+      // Initialize Deduplication Gauges
+      dedup_linked_keys_("master_dedup_linked_keys",
+                         "Number of keys linked to content-addressed objects"),
+      dedup_content_objects_(
+          "master_dedup_content_objects",
+          "Number of content-addressed objects with linked keys"),
+      dedup_saved_bytes_("master_dedup_saved_bytes",
+                         "Bytes saved by sharing content-addressed objects"),
+      dedup_ratio_percent_(
+          "master_dedup_ratio_percent",
+          "Linked keys per content-addressed object, in percent"),
 
       // Initialize Discarded Replicas Counters
       put_start_discard_cnt_("master_put_start_discard_cnt",
@@ -318,6 +454,8 @@ void MasterMetricManager::update_metrics_for_zero_output() {
     file_total_capacity_.update(0);
     key_count_.update(0);
     soft_pin_key_count_.update(0);
+    metadata_index_bytes_.update(0);
+    metadata_index_bytes_per_key_.update(0);
     active_clients_.update(0);
     mem_cache_nums_.update(0);
     file_cache_nums_.update(0);
@@ -334,12 +472,24 @@ void MasterMetricManager::update_metrics_for_zero_output() {
     get_replica_list_failures_.inc(0);
     get_replica_list_by_regex_requests_.inc(0);
     get_replica_list_by_regex_failures_.inc(0);
+    longest_cached_prefix_requests_.inc(0);
+    longest_cached_prefix_failures_.inc(0);
+    link_content_requests_.inc(0);
+    link_content_failures_.inc(0);
+    link_bundle_requests_.inc(0);
+    link_bundle_failures_.inc(0);
+    resolve_bundle_requests_.inc(0);
+    resolve_bundle_failures_.inc(0);
     exist_key_requests_.inc(0);
     exist_key_failures_.inc(0);
     remove_requests_.inc(0);
     remove_failures_.inc(0);
     remove_by_regex_requests_.inc(0);
     remove_by_regex_failures_.inc(0);
+    remove_by_prefix_requests_.inc(0);
+    remove_by_prefix_failures_.inc(0);
+    scan_keys_requests_.inc(0);
+    scan_keys_failures_.inc(0);
     remove_all_requests_.inc(0);
     remove_all_failures_.inc(0);
     mount_segment_requests_.inc(0);
@@ -348,6 +498,14 @@ void MasterMetricManager::update_metrics_for_zero_output() {
     unmount_segment_failures_.inc(0);
     remount_segment_requests_.inc(0);
     remount_segment_failures_.inc(0);
+    drain_segment_requests_.inc(0);
+    drain_segment_failures_.inc(0);
+    get_key_filter_requests_.inc(0);
+    get_key_filter_failures_.inc(0);
+    put_commit_requests_.inc(0);
+    put_commit_failures_.inc(0);
+    get_committed_replica_list_requests_.inc(0);
+    get_committed_replica_list_failures_.inc(0);
     ping_requests_.inc(0);
     ping_failures_.inc(0);
     create_copy_task_requests_.inc(0);
@@ -424,6 +582,17 @@ void MasterMetricManager::update_metrics_for_zero_output() {
     eviction_attempts_.inc(0);
     evicted_key_count_.inc(0);
     evicted_size_.inc(0);
+    ttl_expired_key_count_.inc(0);
+
+    // Update Tiering Counters
+    demoted_key_count_.inc(0);
+    demoted_size_.inc(0);
+
+    // Update Deduplication Gauges
+    dedup_linked_keys_.update(0);
+    dedup_content_objects_.update(0);
+    dedup_saved_bytes_.update(0);
+    dedup_ratio_percent_.update(0);
 
     // Update PutStart Discard Metrics
     put_start_discard_cnt_.inc(0);
@@ -561,6 +730,25 @@ int64_t MasterMetricManager::get_soft_pin_key_count() {
     return soft_pin_key_count_.value();
 }
 
+void MasterMetricManager::inc_metadata_index_bytes(int64_t val) {
+    metadata_index_bytes_.inc(val);
+}
+void MasterMetricManager::dec_metadata_index_bytes(int64_t val) {
+    metadata_index_bytes_.dec(val);
+}
+
+int64_t MasterMetricManager::get_metadata_index_bytes() {
+    return metadata_index_bytes_.value();
+}
+
+double MasterMetricManager::get_metadata_index_bytes_per_key() {
+    int64_t keys = key_count_.value();
+    if (keys <= 0) {
+        return 0.0;
+    }
+    return static_cast<double>(metadata_index_bytes_.value()) / keys;
+}
+
 // Cluster Metrics
 void MasterMetricManager::inc_active_clients(int64_t val) {
     active_clients_.inc(val);
@@ -574,6 +762,154 @@ int64_t MasterMetricManager::get_active_clients() {
     return active_clients_.value();
 }
 
+// Tenant Metrics
+void MasterMetricManager::inc_tenant_used_bytes(const std::string& tenant,
+                                                int64_t val) {
+    tenant_used_bytes_.inc({tenant}, val);
+}
+
+void MasterMetricManager::dec_tenant_used_bytes(const std::string& tenant,
+                                                int64_t val) {
+    tenant_used_bytes_.dec({tenant}, val);
+}
+
+int64_t MasterMetricManager::get_tenant_used_bytes(const std::string& tenant) {
+    return tenant_used_bytes_.value({tenant});
+}
+
+void MasterMetricManager::inc_tenant_quota_exceeded(
+    const std::string& tenant) {
+    tenant_quota_exceeded_.inc({tenant});
+}
+
+void MasterMetricManager::inc_tenant_rate_limited(const std::string& tenant) {
+    tenant_rate_limited_.inc({tenant});
+}
+
+void MasterMetricManager::inc_tenant_evicted_bytes(const std::string& tenant,
+                                                   int64_t val) {
+    tenant_evicted_bytes_.inc({tenant}, val);
+}
+
+// Latency Metrics
+namespace {
+struct StringViewHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view value) const {
+        return std::hash<std::string_view>{}(value);
+    }
+};
+}  // namespace
+
+struct MasterMetricManager::RpcLatencyBuffer {
+    struct Pending {
+        std::vector<int64_t> bucket_counts;
+        int64_t sum = 0;
+    };
+    std::mutex mutex;  // only contended while serializing
+    std::unordered_map<std::string, Pending, StringViewHash, std::equal_to<>>
+        pending;
+    size_t num_samples = 0;
+    std::chrono::steady_clock::time_point first_sample_at;
+};
+
+MasterMetricManager::RpcLatencyBuffer&
+MasterMetricManager::local_rpc_latency_buffer() {
+    thread_local std::shared_ptr<RpcLatencyBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<RpcLatencyBuffer>();
+        std::lock_guard<std::mutex> lock(rpc_latency_buffers_mutex_);
+        rpc_latency_buffers_.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void MasterMetricManager::observe_rpc_latency(std::string_view rpc,
+                                              int64_t latency_us) {
+    const auto now = std::chrono::steady_clock::now();
+    RpcLatencyBuffer& buffer = local_rpc_latency_buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    auto it = buffer.pending.find(rpc);
+    if (it == buffer.pending.end()) {
+        it = buffer.pending.try_emplace(std::string(rpc)).first;
+        it->second.bucket_counts.resize(rpc_latency_us_.bucket_count());
+    }
+    it->second.bucket_counts[rpc_latency_us_.bucket_index(latency_us)]++;
+    it->second.sum += latency_us;
+    if (buffer.num_samples++ == 0) {
+        buffer.first_sample_at = now;
+    }
+    if (buffer.num_samples >= kRpcLatencyFlushSamples ||
+        now - buffer.first_sample_at >= kRpcLatencyFlushInterval) {
+        flush_rpc_latency(buffer);
+    }
+}
+
+void MasterMetricManager::flush_rpc_latency(RpcLatencyBuffer& buffer) {
+    for (auto& [rpc, pending] : buffer.pending) {
+        if (pending.sum == 0 &&
+            std::all_of(pending.bucket_counts.begin(),
+                        pending.bucket_counts.end(),
+                        [](int64_t count) { return count == 0; })) {
+            continue;
+        }
+        rpc_latency_us_.observe_counts({rpc}, pending.bucket_counts,
+                                       pending.sum);
+        std::fill(pending.bucket_counts.begin(), pending.bucket_counts.end(),
+                  0);
+        pending.sum = 0;
+    }
+    buffer.num_samples = 0;
+}
+
+void MasterMetricManager::flush_rpc_latencies() {
+    std::lock_guard<std::mutex> lock(rpc_latency_buffers_mutex_);
+    for (const auto& buffer : rpc_latency_buffers_) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        flush_rpc_latency(*buffer);
+    }
+}
+
+void MasterMetricManager::set_shard_lock_contention(int64_t contended,
+                                                    int64_t wait_us) {
+    shard_lock_contended_.update(contended);
+    shard_lock_wait_us_.update(wait_us);
+}
+
+// Allocator Metrics
+void MasterMetricManager::observe_segment_allocation(
+    const std::string& segment, int64_t latency_ns, bool success) {
+    segment_allocation_latency_ns_.observe({segment}, latency_ns);
+    if (!success) {
+        segment_allocation_failures_.inc({segment});
+    }
+}
+
+void MasterMetricManager::set_segment_allocator_stats(
+    const std::unordered_map<std::string, AllocatorStats>& stats) {
+    std::lock_guard lock(segment_allocator_stats_mutex_);
+    for (const auto& name : segment_allocator_stats_names_) {
+        if (stats.contains(name)) {
+            continue;
+        }
+        const std::map<std::string, std::string> labels{{"segment", name}};
+        segment_free_bytes_.remove_label_value(labels);
+        segment_largest_free_region_.remove_label_value(labels);
+        segment_free_regions_.remove_label_value(labels);
+        segment_fragmentation_percent_.remove_label_value(labels);
+    }
+    segment_allocator_stats_names_.clear();
+    for (const auto& [name, segment_stats] : stats) {
+        segment_free_bytes_.update({name}, segment_stats.free);
+        segment_largest_free_region_.update({name},
+                                            segment_stats.largest_free_region);
+        segment_free_regions_.update({name}, segment_stats.free_regions);
+        segment_fragmentation_percent_.update(
+            {name}, std::lround(segment_stats.fragmentation * 100));
+        segment_allocator_stats_names_.insert(name);
+    }
+}
+
 // cache hit rate metrics
 void MasterMetricManager::inc_mem_cache_hit_nums(int64_t val) {
     mem_cache_hit_nums_.inc(val);
@@ -637,6 +973,30 @@ void MasterMetricManager::inc_get_replica_list_by_regex_requests(int64_t val) {
 void MasterMetricManager::inc_get_replica_list_by_regex_failures(int64_t val) {
     get_replica_list_by_regex_failures_.inc(val);
 }
+void MasterMetricManager::inc_longest_cached_prefix_requests(int64_t val) {
+    longest_cached_prefix_requests_.inc(val);
+}
+void MasterMetricManager::inc_longest_cached_prefix_failures(int64_t val) {
+    longest_cached_prefix_failures_.inc(val);
+}
+void MasterMetricManager::inc_link_content_requests(int64_t val) {
+    link_content_requests_.inc(val);
+}
+void MasterMetricManager::inc_link_content_failures(int64_t val) {
+    link_content_failures_.inc(val);
+}
+void MasterMetricManager::inc_link_bundle_requests(int64_t val) {
+    link_bundle_requests_.inc(val);
+}
+void MasterMetricManager::inc_link_bundle_failures(int64_t val) {
+    link_bundle_failures_.inc(val);
+}
+void MasterMetricManager::inc_resolve_bundle_requests(int64_t val) {
+    resolve_bundle_requests_.inc(val);
+}
+void MasterMetricManager::inc_resolve_bundle_failures(int64_t val) {
+    resolve_bundle_failures_.inc(val);
+}
 void MasterMetricManager::inc_remove_requests(int64_t val) {
     remove_requests_.inc(val);
 }
@@ -649,6 +1009,18 @@ void MasterMetricManager::inc_remove_by_regex_requests(int64_t val) {
 void MasterMetricManager::inc_remove_by_regex_failures(int64_t val) {
     remove_by_regex_failures_.inc(val);
 }
+void MasterMetricManager::inc_remove_by_prefix_requests(int64_t val) {
+    remove_by_prefix_requests_.inc(val);
+}
+void MasterMetricManager::inc_remove_by_prefix_failures(int64_t val) {
+    remove_by_prefix_failures_.inc(val);
+}
+void MasterMetricManager::inc_scan_keys_requests(int64_t val) {
+    scan_keys_requests_.inc(val);
+}
+void MasterMetricManager::inc_scan_keys_failures(int64_t val) {
+    scan_keys_failures_.inc(val);
+}
 void MasterMetricManager::inc_remove_all_requests(int64_t val) {
     remove_all_requests_.inc(val);
 }
@@ -673,6 +1045,30 @@ void MasterMetricManager::inc_remount_segment_requests(int64_t val) {
 void MasterMetricManager::inc_remount_segment_failures(int64_t val) {
     remount_segment_failures_.inc(val);
 }
+void MasterMetricManager::inc_drain_segment_requests(int64_t val) {
+    drain_segment_requests_.inc(val);
+}
+void MasterMetricManager::inc_drain_segment_failures(int64_t val) {
+    drain_segment_failures_.inc(val);
+}
+void MasterMetricManager::inc_get_key_filter_requests(int64_t val) {
+    get_key_filter_requests_.inc(val);
+}
+void MasterMetricManager::inc_get_key_filter_failures(int64_t val) {
+    get_key_filter_failures_.inc(val);
+}
+void MasterMetricManager::inc_put_commit_requests(int64_t val) {
+    put_commit_requests_.inc(val);
+}
+void MasterMetricManager::inc_put_commit_failures(int64_t val) {
+    put_commit_failures_.inc(val);
+}
+void MasterMetricManager::inc_get_committed_replica_list_requests(int64_t val) {
+    get_committed_replica_list_requests_.inc(val);
+}
+void MasterMetricManager::inc_get_committed_replica_list_failures(int64_t val) {
+    get_committed_replica_list_failures_.inc(val);
+}
 void MasterMetricManager::inc_ping_requests(int64_t val) {
     ping_requests_.inc(val);
 }
@@ -828,6 +1224,38 @@ int64_t MasterMetricManager::get_get_replica_list_by_regex_failures() {
     return get_replica_list_by_regex_failures_.value();
 }
 
+int64_t MasterMetricManager::get_longest_cached_prefix_requests() {
+    return longest_cached_prefix_requests_.value();
+}
+
+int64_t MasterMetricManager::get_longest_cached_prefix_failures() {
+    return longest_cached_prefix_failures_.value();
+}
+
+int64_t MasterMetricManager::get_link_content_requests() {
+    return link_content_requests_.value();
+}
+
+int64_t MasterMetricManager::get_link_content_failures() {
+    return link_content_failures_.value();
+}
+
+int64_t MasterMetricManager::get_link_bundle_requests() {
+    return link_bundle_requests_.value();
+}
+
+int64_t MasterMetricManager::get_link_bundle_failures() {
+    return link_bundle_failures_.value();
+}
+
+int64_t MasterMetricManager::get_resolve_bundle_requests() {
+    return resolve_bundle_requests_.value();
+}
+
+int64_t MasterMetricManager::get_resolve_bundle_failures() {
+    return resolve_bundle_failures_.value();
+}
+
 int64_t MasterMetricManager::get_exist_key_requests() {
     return exist_key_requests_.value();
 }
@@ -844,6 +1272,22 @@ int64_t MasterMetricManager::get_remove_by_regex_failures() {
     return remove_by_regex_failures_.value();
 }
 
+int64_t MasterMetricManager::get_remove_by_prefix_requests() {
+    return remove_by_prefix_requests_.value();
+}
+
+int64_t MasterMetricManager::get_remove_by_prefix_failures() {
+    return remove_by_prefix_failures_.value();
+}
+
+int64_t MasterMetricManager::get_scan_keys_requests() {
+    return scan_keys_requests_.value();
+}
+
+int64_t MasterMetricManager::get_scan_keys_failures() {
+    return scan_keys_failures_.value();
+}
+
 int64_t MasterMetricManager::get_remove_requests() {
     return remove_requests_.value();
 }
@@ -884,6 +1328,38 @@ int64_t MasterMetricManager::get_remount_segment_failures() {
     return remount_segment_failures_.value();
 }
 
+int64_t MasterMetricManager::get_drain_segment_requests() {
+    return drain_segment_requests_.value();
+}
+
+int64_t MasterMetricManager::get_drain_segment_failures() {
+    return drain_segment_failures_.value();
+}
+
+int64_t MasterMetricManager::get_get_key_filter_requests() {
+    return get_key_filter_requests_.value();
+}
+
+int64_t MasterMetricManager::get_get_key_filter_failures() {
+    return get_key_filter_failures_.value();
+}
+
+int64_t MasterMetricManager::get_put_commit_requests() {
+    return put_commit_requests_.value();
+}
+
+int64_t MasterMetricManager::get_put_commit_failures() {
+    return put_commit_failures_.value();
+}
+
+int64_t MasterMetricManager::get_get_committed_replica_list_requests() {
+    return get_committed_replica_list_requests_.value();
+}
+
+int64_t MasterMetricManager::get_get_committed_replica_list_failures() {
+    return get_committed_replica_list_failures_.value();
+}
+
 int64_t MasterMetricManager::get_ping_requests() {
     return ping_requests_.value();
 }
@@ -1059,6 +1535,57 @@ int64_t MasterMetricManager::get_evicted_size() {
     return evicted_size_.value();
 }
 
+void MasterMetricManager::inc_ttl_expired_keys(int64_t val) {
+    ttl_expired_key_count_.inc(val);
+}
+
+int64_t MasterMetricManager::get_ttl_expired_key_count() {
+    return ttl_expired_key_count_.value();
+}
+
+// Tiering Metrics
+void MasterMetricManager::inc_tier_demotion(int64_t key_count, int64_t size) {
+    demoted_key_count_.inc(key_count);
+    demoted_size_.inc(size);
+}
+
+int64_t MasterMetricManager::get_demoted_key_count() {
+    return demoted_key_count_.value();
+}
+
+int64_t MasterMetricManager::get_demoted_size() {
+    return demoted_size_.value();
+}
+
+// Deduplication Metrics
+void MasterMetricManager::set_dedup_stats(int64_t linked_keys,
+                                          int64_t content_objects,
+                                          int64_t saved_bytes) {
+    dedup_linked_keys_.update(linked_keys);
+    dedup_content_objects_.update(content_objects);
+    dedup_saved_bytes_.update(saved_bytes);
+}
+
+int64_t MasterMetricManager::get_dedup_linked_keys() {
+    return dedup_linked_keys_.value();
+}
+
+int64_t MasterMetricManager::get_dedup_content_objects() {
+    return dedup_content_objects_.value();
+}
+
+int64_t MasterMetricManager::get_dedup_saved_bytes() {
+    return dedup_saved_bytes_.value();
+}
+
+double MasterMetricManager::get_dedup_ratio() {
+    int64_t contents = dedup_content_objects_.value();
+    if (contents <= 0) {
+        return 0.0;
+    }
+    return static_cast<double>(dedup_linked_keys_.value()) / contents;
+}
+
 // PutStart Discard Metrics Getters
 int64_t MasterMetricManager::get_put_start_discard_cnt() {
     return put_start_discard_cnt_.value();
@@ -1236,10 +1763,28 @@ std::string MasterMetricManager::serialize_metrics() {
     serialize_metric(file_total_capacity_);
     serialize_metric(key_count_);
     serialize_metric(soft_pin_key_count_);
+    serialize_metric(metadata_index_bytes_);
+    metadata_index_bytes_per_key_.update(
+        static_cast<int64_t>(get_metadata_index_bytes_per_key()));
+    serialize_metric(metadata_index_bytes_per_key_);
     serialize_metric(active_clients_);
+    serialize_metric(tenant_used_bytes_);
+    serialize_metric(tenant_quota_exceeded_);
+    serialize_metric(tenant_rate_limited_);
+    serialize_metric(tenant_evicted_bytes_);
+    serialize_metric(shard_lock_contended_);
+    serialize_metric(shard_lock_wait_us_);
+    serialize_metric(segment_free_bytes_);
+    serialize_metric(segment_largest_free_region_);
+    serialize_metric(segment_free_regions_);
+    serialize_metric(segment_fragmentation_percent_);
+    serialize_metric(segment_allocation_failures_);
 
     // Serialize Histogram
     serialize_metric(value_size_distribution_);
+    flush_rpc_latencies();
+    serialize_metric(rpc_latency_us_);
+    serialize_metric(segment_allocation_latency_ns_);
 
     // Serialize Request Counters
     serialize_metric(exist_key_requests_);
@@ -1254,10 +1799,22 @@ std::string MasterMetricManager::serialize_metrics() {
     serialize_metric(get_replica_list_failures_);
     serialize_metric(get_replica_list_by_regex_requests_);
     serialize_metric(get_replica_list_by_regex_failures_);
+    serialize_metric(longest_cached_prefix_requests_);
+    serialize_metric(longest_cached_prefix_failures_);
+    serialize_metric(link_content_requests_);
+    serialize_metric(link_content_failures_);
+    serialize_metric(link_bundle_requests_);
+    serialize_metric(link_bundle_failures_);
+    serialize_metric(resolve_bundle_requests_);
+    serialize_metric(resolve_bundle_failures_);
     serialize_metric(remove_requests_);
     serialize_metric(remove_failures_);
     serialize_metric(remove_by_regex_requests_);
     serialize_metric(remove_by_regex_failures_);
+    serialize_metric(remove_by_prefix_requests_);
+    serialize_metric(remove_by_prefix_failures_);
+    serialize_metric(scan_keys_requests_);
+    serialize_metric(scan_keys_failures_);
     serialize_metric(remove_all_requests_);
     serialize_metric(remove_all_failures_);
     serialize_metric(mount_segment_requests_);
@@ -1266,6 +1823,14 @@ std::string MasterMetricManager::serialize_metrics() {
     serialize_metric(unmount_segment_failures_);
     serialize_metric(remount_segment_requests_);
     serialize_metric(remount_segment_failures_);
+    serialize_metric(drain_segment_requests_);
+    serialize_metric(drain_segment_failures_);
+    serialize_metric(get_key_filter_requests_);
+    serialize_metric(get_key_filter_failures_);
+    serialize_metric(put_commit_requests_);
+    serialize_metric(put_commit_failures_);
+    serialize_metric(get_committed_replica_list_requests_);
+    serialize_metric(get_committed_replica_list_failures_);
     serialize_metric(ping_requests_);
     serialize_metric(ping_failures_);
 
@@ -1318,6 +1883,15 @@ std::string MasterMetricManager::serialize_metrics() {
     serialize_metric(eviction_attempts_);
     serialize_metric(evicted_key_count_);
     serialize_metric(evicted_size_);
+    serialize_metric(ttl_expired_key_count_);
+    serialize_metric(demoted_key_count_);
+    serialize_metric(demoted_size_);
+    serialize_metric(dedup_linked_keys_);
+    serialize_metric(dedup_content_objects_);
+    serialize_metric(dedup_saved_bytes_);
+    dedup_ratio_percent_.update(
+        static_cast<int64_t>(get_dedup_ratio() * 100.0));
+    serialize_metric(dedup_ratio_percent_);
 
     // Serialize PutStart Discard Metrics
     serialize_metric(put_start_discard_cnt_);
@@ -1401,6 +1975,11 @@ std::string MasterMetricManager::get_summary_string() {
     int64_t file_capacity = file_total_capacity_.value();
     int64_t keys = key_count_.value();
     int64_t soft_pin_keys = soft_pin_key_count_.value();
+    double index_bytes_per_key = get_metadata_index_bytes_per_key();
+    int64_t dedup_linked_keys = dedup_linked_keys_.value();
+    int64_t dedup_content_objects = dedup_content_objects_.value();
+    int64_t dedup_saved_bytes = dedup_saved_bytes_.value();
+    double dedup_ratio = get_dedup_ratio();
     int64_t active_clients = active_clients_.value();
 
     // Request counters
@@ -1519,8 +2098,16 @@ std::string MasterMetricManager::get_summary_string() {
     }
     ss << " | SSD Storage: " << byte_size_to_string(file_allocated) << " / "
        << byte_size_to_string(file_capacity);
-    ss << " | Keys: " << keys << " (soft-pinned: " << soft_pin_keys << ")";
+    ss << " | Keys: " << keys << " (soft-pinned: " << soft_pin_keys
+       << ", index bytes/key: " << std::fixed << std::setprecision(1)
+       << index_bytes_per_key << ")";
     ss << " | Clients: " << active_clients;
+    if (dedup_linked_keys > 0) {
+        ss << " | Dedup: " << dedup_linked_keys << " keys -> "
+           << dedup_content_objects << " objects (ratio " << std::fixed
+           << std::setprecision(2) << dedup_ratio << ", saved "
+           << byte_size_to_string(dedup_saved_bytes) << ")";
+    }
 
     // Request summary - focus on the most important metrics
     ss << " | Requests (Success/Total): ";
@@ -1,27 +1,66 @@
 #include "master_service.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <shared_mutex>
 #include <regex>
+#include <tuple>
 #include <unordered_set>
 #include <ylt/util/tl/expected.hpp>
 
+#include "erasure_code.h"
 #include "master_metric_manager.h"
+#include "metadata_follower.h"
 #include "segment.h"
 #include "types.h"
 
 namespace mooncake {
 
+namespace {
+
+// Striped replicas are written, completed and revoked along with the memory
+// replicas
+bool MatchesReplicaType(const Replica& replica, ReplicaType replica_type) {
+    return replica.type() == replica_type ||
+           (replica_type == ReplicaType::MEMORY &&
+            replica.is_striped_replica());
+}
+
+// Gather popped replicas to reclaim them in a single batch
+void AppendReplicas(std::vector<Replica>& out, std::vector<Replica>&& in) {
+    std::move(in.begin(), in.end(), std::back_inserter(out));
+}
+
+}  // namespace
+
 MasterService::MasterService() : MasterService(MasterServiceConfig()) {}
 
 MasterService::MasterService(const MasterServiceConfig& config)
     : default_kv_lease_ttl_(config.default_kv_lease_ttl),
       default_kv_soft_pin_ttl_(config.default_kv_soft_pin_ttl),
+      lease_renewal_min_ttl_(static_cast<uint64_t>(
+          config.default_kv_lease_ttl *
+          (1.0 - config.lazy_lease_renewal_ratio))),
       allow_evict_soft_pinned_objects_(config.allow_evict_soft_pinned_objects),
       eviction_ratio_(config.eviction_ratio),
       eviction_high_watermark_ratio_(config.eviction_high_watermark_ratio),
-      client_live_ttl_sec_(config.client_live_ttl_sec),
+      eviction_policy_(config.eviction_policy),
+      tinylfu_admission_(config.enable_tinylfu_admission),
+      put_start_eviction_retries_(config.put_start_eviction_retries),
+      batch_put_contiguous_(config.batch_put_contiguous),
+      compaction_fragmentation_threshold_(
+          config.compaction_fragmentation_threshold),
+      compaction_moves_per_sec_(config.compaction_moves_per_sec),
+      rebalance_utilization_gap_(config.rebalance_utilization_gap),
+      rebalance_moves_per_sec_(config.rebalance_moves_per_sec),
+      enable_async_replica_reclaim_(config.enable_async_replica_reclaim),
+      hot_key_replica_reads_per_sec_(config.hot_key_replica_reads_per_sec),
+      hot_key_max_replicas_(config.hot_key_max_replicas),
+      memory_tier_target_ratio_(config.memory_tier_target_ratio),
+      tier_demotion_min_idle_(config.tier_demotion_min_idle_sec),
+      client_leases_(std::chrono::seconds(config.client_live_ttl_sec),
+                     std::chrono::milliseconds(kClientMonitorSleepMs)),
       enable_ha_(config.enable_ha),
       enable_offload_(config.enable_offload),
       cluster_id_(config.cluster_id),
@@ -31,13 +70,16 @@ MasterService::MasterService(const MasterServiceConfig& config)
       quota_bytes_(config.quota_bytes),
       segment_manager_(config.memory_allocator, config.enable_cxl),
       memory_allocator_type_(config.memory_allocator),
+      allocation_strategy_type_(config.allocation_strategy),
       allocation_strategy_(std::make_shared<RandomAllocationStrategy>()),
       put_start_discard_timeout_sec_(config.put_start_discard_timeout_sec),
       put_start_release_timeout_sec_(config.put_start_release_timeout_sec),
       task_manager_(config.task_manager_config),
       cxl_path_(config.cxl_path),
       cxl_size_(config.cxl_size),
-      enable_cxl_(config.enable_cxl) {
+      enable_cxl_(config.enable_cxl),
+      metadata_snapshot_interval_sec_(config.metadata_snapshot_interval_sec),
+      hot_replica_cache_(config.hot_replica_cache_size, kNumShards) {
     if (eviction_ratio_ < 0.0 || eviction_ratio_ > 1.0) {
         LOG(ERROR) << "Eviction ratio must be between 0.0 and 1.0, "
                    << "current value: " << eviction_ratio_;
@@ -51,6 +93,19 @@ MasterService::MasterService(const MasterServiceConfig& config)
         throw std::invalid_argument("Invalid eviction high watermark ratio");
     }
 
+    if (memory_tier_target_ratio_ < 0.0 || memory_tier_target_ratio_ >= 1.0) {
+        LOG(ERROR) << "Memory tier target ratio must be in [0.0, 1.0), "
+                   << "current value: " << memory_tier_target_ratio_;
+        throw std::invalid_argument("Invalid memory tier target ratio");
+    }
+
+    if (config.lazy_lease_renewal_ratio < 0.0 ||
+        config.lazy_lease_renewal_ratio >= 1.0) {
+        LOG(ERROR) << "Lazy lease renewal ratio must be in [0.0, 1.0), "
+                   << "current value: " << config.lazy_lease_renewal_ratio;
+        throw std::invalid_argument("Invalid lazy lease renewal ratio");
+    }
+
     if (put_start_release_timeout_sec_ <= put_start_discard_timeout_sec_) {
         LOG(ERROR) << "put_start_release_timeout="
                    << put_start_release_timeout_sec_.count()
@@ -61,6 +116,80 @@ MasterService::MasterService(const MasterServiceConfig& config)
             "put_start_discard_timeout_sec");
     }
 
+    if (eviction_policy_ == EvictionPolicy::LFU || tinylfu_admission_) {
+        frequency_sketch_ =
+            std::make_unique<FrequencySketch>(kFrequencySketchWidth);
+    }
+    if (eviction_policy_ == EvictionPolicy::S3FIFO) {
+        ghost_queue_ = std::make_unique<GhostQueue>(kGhostQueueCapacity);
+    }
+    if (config.hot_key_top_n > 0) {
+        hot_key_tracker_ = std::make_unique<HotKeyTracker>(config.hot_key_top_n,
+                                                           kHotKeySketchWidth);
+    }
+    if (hot_key_replica_reads_per_sec_ > 0 && !hot_key_tracker_) {
+        LOG(ERROR) << "hot_key_replica_reads_per_sec="
+                   << hot_key_replica_reads_per_sec_
+                   << " requires hot_key_top_n to be larger than 0";
+        throw std::invalid_argument(
+            "hot_key_replica_reads_per_sec requires hot_key_top_n");
+    }
+    if (config.disk_promotion_reads > 0) {
+        disk_promotion_tracker_ = std::make_unique<DiskPromotionTracker>(
+            config.disk_promotion_reads,
+            std::chrono::seconds(config.disk_promotion_window_sec),
+            kDiskPromotionMaxTrackedKeys);
+    }
+
+    auto tenant_limits = TenantQuotaManager::ParseLimits(config.tenant_quotas);
+    if (!tenant_limits) {
+        LOG(ERROR) << "tenant_quotas=" << config.tenant_quotas
+                   << ", error=invalid_tenant_quotas";
+        throw std::invalid_argument("Invalid tenant quotas");
+    }
+    tenant_quota_manager_ =
+        std::make_unique<TenantQuotaManager>(std::move(tenant_limits.value()));
+
+    if (config.enable_key_prefix_index) {
+        for (size_t i = 0; i < kNumShards; ++i) {
+            MetadataShardAccessorRW shard(this, i);
+            shard->key_index = std::make_unique<KeyRadixTree>();
+            shard->metadata.set_observer(shard->key_index.get());
+        }
+    }
+
+    if (config.key_filter_bits_per_shard > 0) {
+        enable_key_filter_ = true;
+        // Tells clients that the sequence numbers restarted
+        key_filter_id_ = generate_uuid().first;
+        for (size_t i = 0; i < kNumShards; ++i) {
+            MetadataShardAccessorRW shard(this, i);
+            shard->key_filter = std::make_unique<KeyFilterShard>(
+                config.key_filter_bits_per_shard, &key_filter_seq_,
+                shard->key_index.get());
+            shard->metadata.set_observer(shard->key_filter.get());
+        }
+    }
+
+    // Restore the persisted metadata before any background thread starts.
+    if (!config.metadata_persist_dir.empty()) {
+        metadata_persistence_ =
+            std::make_unique<MetadataPersistence>(config.metadata_persist_dir);
+        // A promoted hot standby only needs to replay the latest records
+        MetadataReplayState replay_state;
+        if (config.metadata_follower) {
+            replay_state = config.metadata_follower->Detach();
+        }
+        auto objects = metadata_persistence_->Load(std::move(replay_state));
+        if (!objects) {
+            LOG(ERROR) << "metadata_persist_dir="
+                       << config.metadata_persist_dir
+                       << ", error=failed_to_load_metadata";
+            throw std::runtime_error("Failed to load persisted metadata");
+        }
+        RestoreMetadata(std::move(objects.value()));
+    }
+
     eviction_running_ = true;
     eviction_thread_ = std::thread(&MasterService::EvictionThreadFunc, this);
     VLOG(1) << "action=start_eviction_thread";
@@ -77,17 +206,75 @@ MasterService::MasterService(const MasterServiceConfig& config)
         std::thread(&MasterService::TaskCleanupThreadFunc, this);
     VLOG(1) << "action=start_task_cleanup_thread";
 
+    master_task_running_ = true;
+    master_task_thread_ =
+        std::thread(&MasterService::MasterTaskThreadFunc, this);
+    VLOG(1) << "action=start_master_task_thread";
+
+    if (compaction_fragmentation_threshold_ > 0.0 &&
+        compaction_moves_per_sec_ > 0 &&
+        memory_allocator_type_ == BufferAllocatorType::OFFSET) {
+        compaction_running_ = true;
+        compaction_thread_ =
+            std::thread(&MasterService::CompactionThreadFunc, this);
+        VLOG(1) << "action=start_compaction_thread";
+    }
+
+    if (rebalance_moves_per_sec_ > 0) {
+        rebalance_running_ = true;
+        rebalance_thread_ =
+            std::thread(&MasterService::RebalanceThreadFunc, this);
+        VLOG(1) << "action=start_rebalance_thread";
+    }
+
+    if (enable_async_replica_reclaim_) {
+        reclaim_running_ = true;
+        reclaim_thread_ = std::thread(&MasterService::ReclaimThreadFunc, this);
+        VLOG(1) << "action=start_reclaim_thread";
+    }
+
+    if (hot_key_replica_reads_per_sec_ > 0) {
+        hot_key_replication_running_ = true;
+        hot_key_replication_thread_ =
+            std::thread(&MasterService::HotKeyReplicationThreadFunc, this);
+        VLOG(1) << "action=start_hot_key_replication_thread";
+    }
+
+    if (disk_promotion_tracker_) {
+        disk_promotion_running_ = true;
+        disk_promotion_thread_ =
+            std::thread(&MasterService::DiskPromotionThreadFunc, this);
+        VLOG(1) << "action=start_disk_promotion_thread";
+    }
+
+    if (enable_offload_ && memory_tier_target_ratio_ > 0.0) {
+        tiering_running_ = true;
+        tiering_thread_ = std::thread(&MasterService::TieringThreadFunc, this);
+        VLOG(1) << "action=start_tiering_thread";
+    }
+
+    if (metadata_persistence_ && metadata_snapshot_interval_sec_ > 0) {
+        metadata_snapshot_running_ = true;
+        metadata_snapshot_thread_ =
+            std::thread(&MasterService::MetadataSnapshotThreadFunc, this);
+        VLOG(1) << "action=start_metadata_snapshot_thread";
+    }
+
     if (!root_fs_dir_.empty()) {
         use_disk_replica_ = true;
         MasterMetricManager::instance().inc_total_file_capacity(
             global_file_segment_size_);
     }
+    if (allocation_strategy_type_ == AllocationStrategyType::LOAD_AWARE) {
+        allocation_strategy_ = std::make_shared<LoadAwareAllocationStrategy>();
+    } else {
+        allocation_strategy_ = std::make_shared<RandomAllocationStrategy>();
+    }
     if (enable_cxl_) {
-        allocation_strategy_ = std::make_shared<CxlAllocationStrategy>();
+        allocation_strategy_ = std::make_shared<CxlAllocationStrategy>(
+            allocation_strategy_, cxl_path_, config.cxl_min_object_size);
         segment_manager_.initializeCxlAllocator(cxl_path_, cxl_size_);
         VLOG(1) << "action=start_cxl_global_allocator";
-    } else {
-        allocation_strategy_ = std::make_shared<RandomAllocationStrategy>();
     }
 }
 
@@ -96,9 +283,28 @@ MasterService::~MasterService() {
     eviction_running_ = false;
     client_monitor_running_ = false;
     task_cleanup_running_ = false;
+    master_task_running_ = false;
+    compaction_running_ = false;
+    rebalance_running_ = false;
+    hot_key_replication_running_ = false;
+    disk_promotion_running_ = false;
+    tiering_running_ = false;
+    metadata_snapshot_running_ = false;
+    {
+        std::lock_guard<std::mutex> lk(reclaim_mutex_);
+        reclaim_running_ = false;
+    }
 
     // Wake sleepers so join() doesn't block for long sleep intervals.
     task_cleanup_cv_.notify_all();
+    master_task_cv_.notify_all();
+    compaction_cv_.notify_all();
+    rebalance_cv_.notify_all();
+    hot_key_replication_cv_.notify_all();
+    disk_promotion_cv_.notify_all();
+    tiering_cv_.notify_all();
+    reclaim_cv_.notify_all();
+    metadata_snapshot_cv_.notify_all();
 
     if (eviction_thread_.joinable()) {
         eviction_thread_.join();
@@ -109,33 +315,41 @@ MasterService::~MasterService() {
     if (task_cleanup_thread_.joinable()) {
         task_cleanup_thread_.join();
     }
+    if (master_task_thread_.joinable()) {
+        master_task_thread_.join();
+    }
+    if (compaction_thread_.joinable()) {
+        compaction_thread_.join();
+    }
+    if (rebalance_thread_.joinable()) {
+        rebalance_thread_.join();
+    }
+    if (hot_key_replication_thread_.joinable()) {
+        hot_key_replication_thread_.join();
+    }
+    if (disk_promotion_thread_.joinable()) {
+        disk_promotion_thread_.join();
+    }
+    if (tiering_thread_.joinable()) {
+        tiering_thread_.join();
+    }
+    if (reclaim_thread_.joinable()) {
+        reclaim_thread_.join();
+    }
+    if (metadata_snapshot_thread_.joinable()) {
+        metadata_snapshot_thread_.join();
+    }
 }
 
 auto MasterService::MountSegment(const Segment& segment, const UUID& client_id)
     -> tl::expected<void, ErrorCode> {
     ScopedSegmentAccess segment_access = segment_manager_.getSegmentAccess();
 
-    // Tell the client monitor thread to start timing for this client. To
-    // avoid the following undesired situations, this message must be sent
-    // after locking the segment mutex and before the mounting operation
-    // completes:
-    // 1. Sending the message before the lock: the client expires and
-    // unmouting invokes before this mounting are completed, which prevents
-    // this segment being able to be unmounted forever;
-    // 2. Sending the message after mounting the segment: After mounting
-    // this segment, when trying to push id to the queue, the queue is
-    // already full. However, at this point, the message must be sent,
-    // otherwise this client cannot be monitored and expired.
-    {
-        PodUUID pod_client_id;
-        pod_client_id.first = client_id.first;
-        pod_client_id.second = client_id.second;
-        if (!client_ping_queue_.push(pod_client_id)) {
-            LOG(ERROR) << "segment_name=" << segment.name
-                       << ", error=client_ping_queue_full";
-            return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
-        }
-    }
+    // Start the lease of this client. It must start after locking the
+    // segment mutex: otherwise the client may expire and its segments be
+    // unmounted before this mounting completes, and this segment would
+    // never be unmounted.
+    client_leases_.Renew(client_id);
 
     LOG(INFO) << "client_id=" << client_id
               << ", action=mount_segment, segment_name=" << segment.name;
@@ -147,6 +361,11 @@ auto MasterService::MountSegment(const Segment& segment, const UUID& client_id)
     } else if (err != ErrorCode::OK) {
         return tl::make_unexpected(err);
     }
+    if (metadata_persistence_) {
+        DropPendingRestoreOnSegment(segment.name);
+    }
+    // New capacity takes objects from the fuller segments at once
+    WakeRebalancer();
     return {};
 }
 
@@ -154,64 +373,73 @@ auto MasterService::ReMountSegment(const std::vector<Segment>& segments,
                                    const UUID& client_id)
     -> tl::expected<void, ErrorCode> {
     std::unique_lock<std::shared_mutex> lock(client_mutex_);
-    if (ok_client_.contains(client_id)) {
+    if (client_leases_.IsOk(client_id)) {
         LOG(WARNING) << "client_id=" << client_id
                      << ", warn=client_already_remounted";
         // Return OK because this is an idempotent operation
         return {};
     }
 
-    ScopedSegmentAccess segment_access = segment_manager_.getSegmentAccess();
+    {
+        ScopedSegmentAccess segment_access =
+            segment_manager_.getSegmentAccess();
 
-    // Tell the client monitor thread to start timing for this client. To
-    // avoid the following undesired situations, this message must be sent
-    // after locking the segment mutex or client mutex and before the remounting
-    // operation completes:
-    // 1. Sending the message before the lock: the client expires and
-    // unmouting invokes before this remounting are completed, which prevents
-    // this segment being able to be unmounted forever;
-    // 2. Sending the message after remounting the segments: After remounting
-    // these segments, when trying to push id to the queue, the queue is
-    // already full. However, at this point, the message must be sent,
-    // otherwise this client cannot be monitored and expired.
-    PodUUID pod_client_id;
-    pod_client_id.first = client_id.first;
-    pod_client_id.second = client_id.second;
-    if (!client_ping_queue_.push(pod_client_id)) {
-        LOG(ERROR) << "client_id=" << client_id
-                   << ", error=client_ping_queue_full";
-        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
-    }
+        // Renew the lease of this client. Expiry holds the client mutex,
+        // so the lease cannot run out before the client is marked OK.
+        client_leases_.Renew(client_id);
 
-    ErrorCode err = segment_access.ReMountSegment(segments, client_id);
-    if (err != ErrorCode::OK) {
-        return tl::make_unexpected(err);
-    }
+        ErrorCode err = segment_access.ReMountSegment(segments, client_id);
+        if (err != ErrorCode::OK) {
+            return tl::make_unexpected(err);
+        }
+    }  // Release the segment mutex before restoring replicas, which needs
+       // the shard locks
 
     // Change the client status to OK
-    ok_client_.insert(client_id);
-    MasterMetricManager::instance().inc_active_clients();
+    if (client_leases_.SetOk(client_id)) {
+        MasterMetricManager::instance().inc_active_clients();
+    }
+    lock.unlock();
+
+    // Re-attach the persisted memory replicas living on these segments
+    if (metadata_persistence_) {
+        std::vector<std::string> segment_names;
+        segment_names.reserve(segments.size());
+        for (const auto& segment : segments) {
+            segment_names.push_back(segment.name);
+        }
+        RestorePendingReplicas(segment_names);
+    }
 
     return {};
 }
 
 void MasterService::ClearInvalidHandles() {
+    // The replicas on the segments being unmounted must not be served by the
+    // lock-free read path in the meantime.
+    hot_replica_cache_.InvalidateAll();
     for (size_t i = 0; i < kNumShards; i++) {
         MetadataShardAccessorRW shard(this, i);
         auto it = shard->metadata.begin();
         while (it != shard->metadata.end()) {
+            const size_t replica_num = it->second.CountReplicas();
             if (CleanupStaleHandles(it->second)) {
                 // If the object is empty, we need to erase the iterator and
                 // also erase the key from processing_keys and
                 // replication_tasks.
+                PersistRemove(it->first);
                 shard->processing_keys.erase(it->first);
                 shard->replication_tasks.erase(it->first);
                 it = shard->metadata.erase(it);
             } else {
+                if (it->second.CountReplicas() != replica_num) {
+                    PersistPutEnd(it->first, it->second);
+                }
                 ++it;
             }
         }
     }
+    replica_invalidation_epoch_++;
 }
 
 void MasterService::TaskCleanupThreadFunc() {
@@ -236,15 +464,808 @@ void MasterService::TaskCleanupThreadFunc() {
     LOG(INFO) << "Task cleanup thread stopped";
 }
 
+void MasterService::MasterTaskThreadFunc() {
+    LOG(INFO) << "Master task thread started";
+    while (master_task_running_) {
+        auto tasks = task_manager_.get_write_access().pop_tasks(
+            kMasterTaskClient, /*batch_size=*/1);
+        if (tasks.empty()) {
+            std::unique_lock<std::mutex> lk(master_task_mutex_);
+            master_task_cv_.wait_for(
+                lk, std::chrono::milliseconds(kMasterTaskThreadSleepMs),
+                [&] { return !master_task_running_.load(); });
+            continue;
+        }
+        for (const auto& task : tasks) {
+            switch (task.type) {
+                case TaskType::PREFIX_REMOVE:
+                    RunPrefixRemoval(task);
+                    break;
+                default:
+                    LOG(ERROR) << "task_id=" << task.id
+                               << ", task_type=" << task.type
+                               << ", error=unknown_master_task_type";
+                    task_manager_.get_write_access().complete_task(
+                        kMasterTaskClient, task.id, TaskStatus::FAILED,
+                        "unknown task type");
+                    break;
+            }
+        }
+    }
+    LOG(INFO) << "Master task thread stopped";
+}
+
+void MasterService::CompactionThreadFunc() {
+    LOG(INFO) << "Compaction thread started";
+    while (compaction_running_) {
+        {
+            std::unique_lock<std::mutex> lk(compaction_mutex_);
+            compaction_cv_.wait_for(
+                lk, std::chrono::milliseconds(kCompactionThreadSleepMs),
+                [&] { return !compaction_running_.load(); });
+        }
+
+        if (!compaction_running_) {
+            break;
+        }
+        CompactSegments();
+    }
+    LOG(INFO) << "Compaction thread stopped";
+}
+
+void MasterService::WakeRebalancer() {
+    if (rebalance_running_) {
+        rebalance_pending_ = true;
+        rebalance_cv_.notify_one();
+    }
+}
+
+void MasterService::RebalanceThreadFunc() {
+    LOG(INFO) << "Rebalance thread started";
+    while (rebalance_running_) {
+        {
+            std::unique_lock<std::mutex> lk(rebalance_mutex_);
+            rebalance_cv_.wait_for(
+                lk, std::chrono::milliseconds(kRebalanceThreadSleepMs), [&] {
+                    return rebalance_pending_.load() ||
+                           !rebalance_running_.load();
+                });
+            rebalance_pending_ = false;
+        }
+
+        if (!rebalance_running_) {
+            break;
+        }
+        RebalanceSegments();
+    }
+    LOG(INFO) << "Rebalance thread stopped";
+}
+
+void MasterService::ReclaimThreadFunc() {
+    LOG(INFO) << "Reclaim thread started";
+    while (true) {
+        std::vector<std::unique_ptr<AllocatedBuffer>> batch;
+        {
+            std::unique_lock<std::mutex> lk(reclaim_mutex_);
+            reclaim_cv_.wait(lk, [&] {
+                return !reclaim_queue_.empty() || !reclaim_running_.load();
+            });
+            if (reclaim_queue_.empty()) {
+                break;  // stopped and drained
+            }
+            batch.swap(reclaim_queue_);
+        }
+        VLOG(1) << "action=reclaim_buffers, count=" << batch.size();
+        AllocatedBuffer::DeallocateBatch(std::move(batch));
+    }
+    LOG(INFO) << "Reclaim thread stopped";
+}
+
+void MasterService::ReclaimReplicas(std::vector<Replica>&& replicas,
+                                    bool allow_async) {
+    std::vector<std::unique_ptr<AllocatedBuffer>> buffers;
+    for (auto& replica : replicas) {
+        auto replica_buffers = replica.take_buffers();
+        std::move(replica_buffers.begin(), replica_buffers.end(),
+                  std::back_inserter(buffers));
+    }
+    replicas.clear();
+    if (buffers.empty()) {
+        return;
+    }
+
+    if (allow_async && reclaim_running_) {
+        {
+            std::lock_guard<std::mutex> lk(reclaim_mutex_);
+            if (reclaim_running_) {
+                std::move(buffers.begin(), buffers.end(),
+                          std::back_inserter(reclaim_queue_));
+                buffers.clear();
+            }
+        }
+        reclaim_cv_.notify_one();
+    }
+    // Freed inline without the reclaim thread, or once it is stopped
+    AllocatedBuffer::DeallocateBatch(std::move(buffers));
+}
+
+void MasterService::CompactSegments() {
+    // Moves of the previous rounds still in flight count against the budget
+    {
+        auto read_access = task_manager_.get_read_access();
+        std::erase_if(compaction_tasks_, [&](const UUID& task_id) {
+            auto task = read_access.find_task_by_id(task_id);
+            return !task.has_value() || task->is_finished();
+        });
+    }
+    if (compaction_tasks_.size() >= compaction_moves_per_sec_) {
+        return;
+    }
+    const size_t budget = compaction_moves_per_sec_ - compaction_tasks_.size();
+
+    // A segment whose free space is split into many small regions can fail
+    // large allocations even though it has room. Moving small objects to
+    // another segment frees the space between the remaining ones.
+    std::string source;
+    std::string target;
+    double worst_fragmentation = compaction_fragmentation_threshold_;
+    size_t target_free_region = 0;
+    {
+        ScopedAllocatorAccess allocator_access =
+            segment_manager_.getAllocatorAccess();
+        const auto& allocator_manager = allocator_access.getAllocatorManager();
+        std::vector<std::pair<std::string, size_t>> free_regions;
+        for (const auto& name : allocator_manager.getNames()) {
+            const auto allocators = allocator_manager.getAllocators(name);
+            if (allocators == nullptr) {
+                continue;
+            }
+            size_t largest_free_region = 0;
+            for (const auto& allocator : *allocators) {
+                // Slab blocks never fragment and only fit one size
+                if (allocator->getBlockSize() != 0) {
+                    continue;
+                }
+                const AllocatorStats stats = allocator->getStats();
+                largest_free_region =
+                    std::max(largest_free_region, stats.largest_free_region);
+                // Nearly full allocators have little to gain
+                if (stats.free == 0 || stats.free * 20 < stats.capacity) {
+                    continue;
+                }
+                if (stats.fragmentation > worst_fragmentation) {
+                    worst_fragmentation = stats.fragmentation;
+                    source = name;
+                }
+            }
+            free_regions.emplace_back(name, largest_free_region);
+        }
+        for (const auto& [name, region] : free_regions) {
+            if (name != source && region > target_free_region) {
+                target_free_region = region;
+                target = name;
+            }
+        }
+    }
+    if (source.empty() || target.empty()) {
+        return;
+    }
+
+    auto on_source = [&source](const Replica& replica) {
+        if (!replica.is_memory_replica() || !replica.is_completed()) {
+            return false;
+        }
+        for (const auto& name : replica.get_segment_names()) {
+            if (name && *name == source) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<std::pair<uint64_t, std::string>> candidates;
+    for (size_t i = 0; i < kCompactionMaxShards; i++) {
+        MetadataShardAccessorRO shard(this, compaction_cursor_++ % kNumShards);
+        for (const auto& [key, metadata] : shard->metadata) {
+            if (metadata.size <= target_free_region &&
+                !shard->replication_tasks.contains(key) &&
+                metadata.HasReplica(on_source)) {
+                candidates.emplace_back(metadata.size, key);
+            }
+        }
+    }
+    if (candidates.empty()) {
+        return;
+    }
+
+    // Small objects are the cheapest to move and the most likely to sit
+    // between free regions
+    const size_t moves = std::min(budget, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + moves,
+                      candidates.end());
+    size_t scheduled = 0;
+    for (size_t i = 0; i < moves; i++) {
+        auto task_id = CreateMoveTask(candidates[i].second, source, target,
+                                      TaskPriority::LOW);
+        if (task_id) {
+            compaction_tasks_.push_back(task_id.value());
+            scheduled++;
+        }
+    }
+    LOG(INFO) << "action=compact_segment, source_segment=" << source
+              << ", target_segment=" << target
+              << ", fragmentation=" << worst_fragmentation
+              << ", scheduled_moves=" << scheduled;
+}
+
+void MasterService::RebalanceSegments() {
+    // Moves of the previous rounds still in flight count against the budget
+    {
+        auto read_access = task_manager_.get_read_access();
+        std::erase_if(rebalance_tasks_, [&](const UUID& task_id) {
+            auto task = read_access.find_task_by_id(task_id);
+            return !task.has_value() || task->is_finished();
+        });
+    }
+    if (rebalance_tasks_.size() >= rebalance_moves_per_sec_) {
+        return;
+    }
+    const size_t budget = rebalance_moves_per_sec_ - rebalance_tasks_.size();
+
+    std::vector<SegmentUsage> usage;
+    {
+        ScopedSegmentAccess segment_access =
+            segment_manager_.getSegmentAccess();
+        segment_access.GetSegmentUsage(usage);
+    }
+    auto utilization = [](const SegmentUsage* segment) {
+        return static_cast<double>(segment->used) / segment->capacity;
+    };
+
+    // Draining segments go first, to the least utilized segment taking new
+    // objects. Otherwise the most utilized one gives to it.
+    const SegmentUsage* drained = nullptr;
+    const SegmentUsage* fullest = nullptr;
+    const SegmentUsage* target = nullptr;
+    for (const auto& segment : usage) {
+        if (segment.capacity == 0) {
+            continue;
+        }
+        if (segment.draining) {
+            if (segment.used > 0 &&
+                (!drained || segment.used > drained->used)) {
+                drained = &segment;
+            }
+            continue;
+        }
+        if (!target || utilization(&segment) < utilization(target)) {
+            target = &segment;
+        }
+        if (!fullest || utilization(&segment) > utilization(fullest)) {
+            fullest = &segment;
+        }
+    }
+    if (target == nullptr) {
+        return;
+    }
+
+    const SegmentUsage* source = drained;
+    uint64_t bytes_to_move = target->capacity - target->used;
+    TaskPriority priority = TaskPriority::NORMAL;
+    if (source == nullptr) {
+        if (rebalance_utilization_gap_ <= 0.0 || fullest == target ||
+            utilization(fullest) - utilization(target) <=
+                rebalance_utilization_gap_) {
+            return;
+        }
+        source = fullest;
+        // Until both reach the utilization they would have together
+        const double even = static_cast<double>(source->used + target->used) /
+                            (source->capacity + target->capacity);
+        bytes_to_move = std::min<uint64_t>(
+            bytes_to_move, source->used - even * source->capacity);
+        priority = TaskPriority::LOW;
+    }
+    const std::string source_name = source->name;
+    const std::string target_name = target->name;
+
+    auto on_segment = [](const std::string& segment) {
+        return [&segment](const Replica& replica) {
+            if (!replica.is_memory_replica() || !replica.is_completed()) {
+                return false;
+            }
+            for (const auto& name : replica.get_segment_names()) {
+                if (name && *name == segment) {
+                    return true;
+                }
+            }
+            return false;
+        };
+    };
+
+    std::vector<std::string> candidates;
+    std::unordered_set<std::string> hot_candidates;
+    uint64_t candidate_bytes = 0;
+    auto movable = [&](const std::string& key, const ObjectMetadata& metadata,
+                       const MetadataShardAccessorRO& shard) {
+        return candidate_bytes + metadata.size <= bytes_to_move &&
+               !shard->replication_tasks.contains(key) &&
+               metadata.HasReplica(on_segment(source_name)) &&
+               !metadata.HasReplica(on_segment(target_name));
+    };
+
+    // The hot objects of a draining segment go first, they are the ones
+    // whose loss would cost the most recomputation
+    if (drained != nullptr && hot_key_tracker_) {
+        for (const auto& hot : hot_key_tracker_->TopKeys()) {
+            if (candidates.size() >= budget) {
+                break;
+            }
+            MetadataAccessorRO accessor(this, hot.key);
+            if (!accessor.Exists() ||
+                !movable(hot.key, accessor.Get(), accessor.GetShard())) {
+                continue;
+            }
+            candidates.push_back(hot.key);
+            hot_candidates.insert(hot.key);
+            candidate_bytes += accessor.Get().size;
+        }
+    }
+
+    for (size_t i = 0; i < kRebalanceMaxShards && candidates.size() < budget;
+         i++) {
+        MetadataShardAccessorRO shard(this, rebalance_cursor_++ % kNumShards);
+        for (const auto& [key, metadata] : shard->metadata) {
+            if (candidates.size() >= budget) {
+                break;
+            }
+            if (hot_candidates.contains(key) ||
+                !movable(key, metadata, shard)) {
+                continue;
+            }
+            candidates.push_back(key);
+            candidate_bytes += metadata.size;
+        }
+    }
+    if (candidates.empty()) {
+        return;
+    }
+
+    size_t scheduled = 0;
+    for (const auto& key : candidates) {
+        auto task_id = CreateMoveTask(key, source_name, target_name, priority);
+        if (task_id) {
+            rebalance_tasks_.push_back(task_id.value());
+            scheduled++;
+        }
+    }
+    LOG(INFO) << "action=" << (drained ? "drain_segment" : "rebalance_segment")
+              << ", source_segment=" << source_name
+              << ", target_segment=" << target_name
+              << ", scheduled_moves=" << scheduled
+              << ", hot_moves=" << hot_candidates.size()
+              << ", scheduled_bytes=" << candidate_bytes;
+}
+
+void MasterService::HotKeyReplicationThreadFunc() {
+    LOG(INFO) << "Hot key replication thread started";
+    while (hot_key_replication_running_) {
+        {
+            std::unique_lock<std::mutex> lk(hot_key_replication_mutex_);
+            hot_key_replication_cv_.wait_for(
+                lk, std::chrono::milliseconds(kHotKeyReplicationThreadSleepMs),
+                [&] { return !hot_key_replication_running_.load(); });
+        }
+
+        if (!hot_key_replication_running_) {
+            break;
+        }
+        AmplifyHotKeys();
+        SyncMetadata();
+    }
+    LOG(INFO) << "Hot key replication thread stopped";
+}
+
+void MasterService::AmplifyHotKeys() {
+    // Read rates of the top keys since the last round. Keys entering the top
+    // list get a rate from the next round on.
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed_sec =
+        std::chrono::duration<double>(now - hot_key_counted_at_).count();
+    hot_key_counted_at_ = now;
+    std::unordered_map<std::string, uint64_t> counts;
+    std::unordered_map<std::string, double> rates;
+    for (auto& hot : hot_key_tracker_->TopKeys()) {
+        auto it = hot_key_counts_.find(hot.key);
+        if (it != hot_key_counts_.end()) {
+            // The counts are halved on decay
+            const uint64_t last =
+                hot.count < it->second ? it->second / 2 : it->second;
+            rates.emplace(hot.key,
+                          (hot.count - std::min(last, hot.count)) /
+                              elapsed_sec);
+        }
+        counts.emplace(std::move(hot.key), hot.count);
+    }
+    hot_key_counts_.swap(counts);
+
+    {
+        auto read_access = task_manager_.get_read_access();
+        for (auto& [key, replicas] : hot_key_replicas_) {
+            if (!replicas.pending_task) {
+                continue;
+            }
+            auto task = read_access.find_task_by_id(*replicas.pending_task);
+            if (!task.has_value() || task->is_finished()) {
+                replicas.pending_task.reset();
+            }
+        }
+    }
+
+    // Keys read less than half the threshold, or no longer among the top
+    // keys, give their extra replicas back
+    for (auto it = hot_key_replicas_.begin(); it != hot_key_replicas_.end();) {
+        const auto& [key, replicas] = *it;
+        auto rate = rates.find(key);
+        const bool cooled =
+            rate == rates.end()
+                ? !hot_key_counts_.contains(key)
+                : rate->second * 2 < hot_key_replica_reads_per_sec_;
+        if (!cooled || replicas.pending_task ||
+            !DropHotKeyReplicas(key, replicas.segments)) {
+            ++it;
+            continue;
+        }
+        LOG(INFO) << "action=drop_hot_key_replicas, key=" << key
+                  << ", segments=" << replicas.segments.size();
+        it = hot_key_replicas_.erase(it);
+    }
+
+    // Keys above the threshold get one more replica per round, until they
+    // have hot_key_max_replicas_
+    for (const auto& [key, rate] : rates) {
+        if (rate < hot_key_replica_reads_per_sec_) {
+            continue;
+        }
+        auto& replicas = hot_key_replicas_[key];
+        if (replicas.pending_task) {
+            continue;
+        }
+        auto target = SelectReplicaTarget(key, hot_key_max_replicas_);
+        if (target) {
+            auto task_id =
+                CreateCopyTask(key, {target.value()}, TaskPriority::HIGH);
+            if (task_id) {
+                LOG(INFO) << "action=amplify_hot_key, key=" << key
+                          << ", reads_per_sec=" << rate
+                          << ", target_segment=" << target.value();
+                replicas.pending_task = task_id.value();
+                replicas.segments.push_back(std::move(target.value()));
+                continue;
+            }
+        }
+        if (replicas.segments.empty()) {
+            hot_key_replicas_.erase(key);
+        }
+    }
+}
+
+std::optional<std::string> MasterService::SelectReplicaTarget(
+    const std::string& key, size_t max_memory_replicas) {
+    std::vector<std::string> holders;
+    size_t size = 0;
+    {
+        MetadataAccessorRO accessor(this, key);
+        if (!accessor.Exists()) {
+            return std::nullopt;
+        }
+        const auto& metadata = accessor.Get();
+        if (!metadata.HasReplica(&Replica::fn_is_completed) ||
+            metadata.CountReplicas(&Replica::fn_is_memory_replica) >=
+                max_memory_replicas) {
+            return std::nullopt;
+        }
+        holders = metadata.GetReplicaSegmentNames();
+        size = metadata.size;
+    }
+
+    std::vector<std::string> candidates;
+    {
+        ScopedAllocatorAccess allocator_access =
+            segment_manager_.getAllocatorAccess();
+        const auto& allocator_manager = allocator_access.getAllocatorManager();
+        for (const auto& name : allocator_manager.getNames()) {
+            const auto allocators = allocator_manager.getAllocators(name);
+            if (allocators == nullptr ||
+                std::find(holders.begin(), holders.end(), name) !=
+                    holders.end()) {
+                continue;
+            }
+            for (const auto& allocator : *allocators) {
+                if (allocator->getLargestFreeRegion() >= size) {
+                    candidates.push_back(name);
+                    break;
+                }
+            }
+        }
+    }
+    if (candidates.empty()) {
+        return std::nullopt;
+    }
+
+    static thread_local std::mt19937 gen(std::random_device{}());
+    std::uniform_int_distribution<size_t> dis(0, candidates.size() - 1);
+    return candidates[dis(gen)];
+}
+
+bool MasterService::DropHotKeyReplicas(
+    const std::string& key, const std::vector<std::string>& segments) {
+    MetadataAccessorRW accessor(this, key);
+    if (!accessor.Exists()) {
+        return true;
+    }
+    if (accessor.HasReplicationTask()) {
+        return false;
+    }
+
+    // Replicas still read by a copy or move are kept
+    auto on_segments = [&segments](const Replica& replica) {
+        if (!replica.is_memory_replica() || !replica.is_completed() ||
+            replica.get_refcnt() > 0) {
+            return false;
+        }
+        for (const auto& name : replica.get_segment_names()) {
+            if (name && std::find(segments.begin(), segments.end(), *name) !=
+                            segments.end()) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto& metadata = accessor.Get();
+    if (!metadata.HasReplica([&on_segments](const Replica& replica) {
+            return replica.is_memory_replica() && replica.is_completed() &&
+                   !on_segments(replica);
+        })) {
+        return true;
+    }
+    auto dropped = metadata.PopReplicas(on_segments);
+    if (dropped.empty()) {
+        return true;
+    }
+
+    // Release the space later, readers may still be using the replicas
+    {
+        std::lock_guard lock(discarded_replicas_mutex_);
+        discarded_replicas_.emplace_back(
+            std::move(dropped),
+            std::chrono::steady_clock::now() + put_start_release_timeout_sec_);
+    }
+    PersistPutEnd(key, metadata);
+    // Clients may still cache the dropped replicas
+    replica_invalidation_epoch_++;
+    return true;
+}
+
+void MasterService::RecordDiskRead(
+    const std::string& key, const std::vector<Replica::Descriptor>& replicas) {
+    if (!disk_promotion_tracker_) {
+        return;
+    }
+    bool has_disk_replica = false;
+    for (const auto& replica : replicas) {
+        if (replica.is_memory_replica() || replica.is_striped_replica()) {
+            return;
+        }
+        has_disk_replica |= replica.is_disk_replica();
+    }
+    if (has_disk_replica && disk_promotion_tracker_->Record(
+                                key, std::chrono::steady_clock::now())) {
+        disk_promotion_pending_ = true;
+        disk_promotion_cv_.notify_one();
+    }
+}
+
+void MasterService::DiskPromotionThreadFunc() {
+    LOG(INFO) << "Disk promotion thread started";
+    auto last_prune = std::chrono::steady_clock::now();
+    while (disk_promotion_running_) {
+        {
+            std::unique_lock<std::mutex> lk(disk_promotion_mutex_);
+            disk_promotion_cv_.wait_for(
+                lk, std::chrono::milliseconds(kDiskPromotionThreadSleepMs),
+                [&] {
+                    return disk_promotion_pending_.load() ||
+                           !disk_promotion_running_.load();
+                });
+            disk_promotion_pending_ = false;
+        }
+
+        if (!disk_promotion_running_) {
+            break;
+        }
+        for (const auto& key : disk_promotion_tracker_->TakeDue()) {
+            PromoteDiskReplica(key);
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_prune >=
+            std::chrono::milliseconds(kDiskPromotionThreadSleepMs)) {
+            disk_promotion_tracker_->Prune(now);
+            last_prune = now;
+        }
+    }
+    LOG(INFO) << "Disk promotion thread stopped";
+}
+
+void MasterService::PromoteDiskReplica(const std::string& key) {
+    // Objects which got a memory replica in the meantime are skipped
+    auto target = SelectReplicaTarget(key, 1);
+    if (!target) {
+        VLOG(1) << "key=" << key << ", info=no_disk_promotion_target";
+        return;
+    }
+
+    uint64_t size;
+    {
+        MetadataAccessorRO accessor(this, key);
+        if (!accessor.Exists()) {
+            return;
+        }
+        size = accessor.Get().size;
+    }
+
+    UUID client_id;
+    {
+        ScopedSegmentAccess segment_accessor =
+            segment_manager_.getSegmentAccess();
+        ErrorCode error = segment_accessor.GetClientIdBySegmentName(
+            target.value(), client_id);
+        if (error != ErrorCode::OK) {
+            LOG(ERROR) << "key=" << key << ", segment_name=" << target.value()
+                       << ", error=client_id_not_found";
+            return;
+        }
+    }
+
+    // The client of the target segment reads the disk replica straight into
+    // the new memory replica
+    auto task_id =
+        task_manager_.get_write_access()
+            .submit_task_typed<TaskType::REPLICA_PROMOTE>(
+                client_id, {.key = key, .target = target.value()},
+                TaskPriority::HIGH, size);
+    if (!task_id) {
+        LOG(WARNING) << "key=" << key
+                     << ", error=submit_promotion_task_failed, error_code="
+                     << task_id.error();
+        return;
+    }
+    LOG(INFO) << "action=promote_disk_replica, key=" << key
+              << ", target_segment=" << target.value()
+              << ", task_id=" << task_id.value();
+}
+
+void MasterService::TieringThreadFunc() {
+    LOG(INFO) << "Tiering thread started";
+    while (tiering_running_) {
+        {
+            std::unique_lock<std::mutex> lk(tiering_mutex_);
+            tiering_cv_.wait_for(
+                lk, std::chrono::milliseconds(kTieringThreadSleepMs),
+                [&] { return !tiering_running_.load(); });
+        }
+
+        if (!tiering_running_) {
+            break;
+        }
+        DemoteColdObjects();
+    }
+    LOG(INFO) << "Tiering thread stopped";
+}
+
+void MasterService::DemoteColdObjects() {
+    auto now = std::chrono::steady_clock::now();
+    std::erase_if(tier_demotions_, [&now](const auto& entry) {
+        return now - entry.second > kTierDemotionRetry;
+    });
+
+    auto& metrics = MasterMetricManager::instance();
+    const double used_ratio = metrics.get_global_mem_used_ratio();
+    if (used_ratio <= memory_tier_target_ratio_) {
+        return;
+    }
+    const uint64_t excess_size = static_cast<uint64_t>(
+        (used_ratio - memory_tier_target_ratio_) *
+        metrics.get_total_mem_capacity());
+
+    // Memory beyond the target that already has, or is getting, a copy on
+    // the local disk tier needs no further demotion
+    uint64_t covered_size = 0;
+    std::vector<std::tuple<EvictionRank, uint64_t, std::string>> candidates;
+    for (size_t i = 0; i < kNumShards; i++) {
+        MetadataShardAccessorRO shard(this, i);
+        for (const auto& [key, metadata] : shard->metadata) {
+            if (!metadata.HasReplica([](const Replica& replica) {
+                    return replica.is_memory_replica() &&
+                           replica.is_completed();
+                })) {
+                continue;
+            }
+            if (tier_demotions_.contains(key) ||
+                metadata.HasReplica(&Replica::fn_is_local_disk_replica)) {
+                covered_size += metadata.size;
+                continue;
+            }
+            const auto lease_timeout =
+                metadata.lease_timeout.load(std::memory_order_relaxed);
+            if (now - lease_timeout < tier_demotion_min_idle_ ||
+                metadata.IsSoftPinned(now) ||
+                shard->replication_tasks.contains(key)) {
+                continue;
+            }
+            candidates.emplace_back(GetEvictionRank(key, metadata),
+                                    metadata.size, key);
+        }
+    }
+    if (covered_size >= excess_size) {
+        return;
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // The coldest objects go first, in the order BatchEvict would evict them
+    uint64_t demoted_size = 0;
+    int64_t demoted_count = 0;
+    for (const auto& candidate : candidates) {
+        if (covered_size + demoted_size >= excess_size) {
+            break;
+        }
+        const auto& key = std::get<2>(candidate);
+        MetadataAccessorRO accessor(this, key);
+        if (!accessor.Exists()) {
+            continue;
+        }
+        bool queued = false;
+        accessor.Get().VisitReplicas(
+            [](const Replica& replica) {
+                return replica.is_memory_replica() && replica.is_completed();
+            },
+            [&](const Replica& replica) {
+                if (!queued) {
+                    queued = PushOffloadingQueue(key, replica).has_value();
+                }
+            });
+        if (queued) {
+            tier_demotions_.emplace(key, now);
+            demoted_size += std::get<1>(candidate);
+            demoted_count++;
+        }
+    }
+    if (demoted_count > 0) {
+        metrics.inc_tier_demotion(demoted_count, demoted_size);
+    }
+    VLOG(1) << "action=demote_cold_objects, used_ratio=" << used_ratio
+            << ", candidates=" << candidates.size()
+            << ", demoted_count=" << demoted_count
+            << ", demoted_size=" << demoted_size;
+}
+
 auto MasterService::UnmountSegment(const UUID& segment_id,
                                    const UUID& client_id)
     -> tl::expected<void, ErrorCode> {
     size_t metrics_dec_capacity = 0;  // to update the metrics
+    std::string segment_name;
 
     // 1. Prepare to unmount the segment by deleting its allocator
     {
         ScopedSegmentAccess segment_access =
             segment_manager_.getSegmentAccess();
+        std::vector<Segment> segments;
+        segment_access.GetClientSegments(client_id, segments);
+        for (const auto& segment : segments) {
+            if (segment.id == segment_id) {
+                segment_name = segment.name;
+            }
+        }
         ErrorCode err = segment_access.PrepareUnmountSegment(
             segment_id, metrics_dec_capacity);
         if (err == ErrorCode::SEGMENT_NOT_FOUND) {
@@ -267,11 +1288,24 @@ auto MasterService::UnmountSegment(const UUID& segment_id,
     if (err != ErrorCode::OK) {
         return tl::make_unexpected(err);
     }
+    allocation_strategy_->RemoveSegmentLoad(segment_name);
+    WakeRebalancer();
     return {};
 }
 
 auto MasterService::ExistKey(const std::string& key)
     -> tl::expected<bool, ErrorCode> {
+    if (!content_index_.empty()) {
+        if (auto content_key = content_index_.Resolve(key)) {
+            return ExistKey(*content_key);
+        }
+    }
+    if (!bundle_index_.empty()) {
+        if (auto member = bundle_index_.Resolve(key)) {
+            return ExistKey(member->bundle_key);
+        }
+    }
+
     MetadataAccessorRO accessor(this, key);
     if (!accessor.Exists()) {
         VLOG(1) << "key=" << key << ", info=object_not_found";
@@ -282,7 +1316,9 @@ auto MasterService::ExistKey(const std::string& key)
     if (metadata.HasReplica(&Replica::fn_is_completed)) {
         // Grant a lease to the object as it may be further used by the
         // client.
-        metadata.GrantLease(default_kv_lease_ttl_, default_kv_soft_pin_ttl_);
+        metadata.RenewLease(default_kv_lease_ttl_, default_kv_soft_pin_ttl_,
+                            lease_renewal_min_ttl_);
+        RecordAccess(key, metadata);
         return true;
     }
 
@@ -299,6 +1335,29 @@ std::vector<tl::expected<bool, ErrorCode>> MasterService::BatchExistKey(
     return results;
 }
 
+auto MasterService::GetKeyFilter(uint64_t since)
+    -> tl::expected<GetKeyFilterResponse, ErrorCode> {
+    if (!enable_key_filter_) {
+        return tl::make_unexpected(ErrorCode::UNAVAILABLE_IN_CURRENT_MODE);
+    }
+    GetKeyFilterResponse response;
+    response.filter_id = key_filter_id_;
+    // Read first, shards changed during the scan are sent again next time
+    response.seq = key_filter_seq_.load(std::memory_order_acquire);
+    response.num_shards = kNumShards;
+    for (size_t i = 0; i < kNumShards; i++) {
+        MetadataShardAccessorRO shard(this, i);
+        if (shard->key_filter->version() > since) {
+            response.shards.push_back(KeyFilterShardBits{
+                static_cast<uint32_t>(i), shard->key_filter->bits()});
+        }
+    }
+    VLOG(1) << "action=get_key_filter, since=" << since
+            << ", seq=" << response.seq
+            << ", changed_shards=" << response.shards.size();
+    return response;
+}
+
 auto MasterService::GetAllKeys()
     -> tl::expected<std::vector<std::string>, ErrorCode> {
     std::vector<std::string> all_keys;
@@ -311,6 +1370,39 @@ auto MasterService::GetAllKeys()
     return all_keys;
 }
 
+auto MasterService::ScanKeys(const std::string& prefix, uint64_t cursor,
+                             size_t limit)
+    -> tl::expected<ScanKeysResponse, ErrorCode> {
+    if (cursor >= kNumShards || limit == 0) {
+        LOG(ERROR) << "cursor=" << cursor << ", limit=" << limit
+                   << ", error=invalid_scan_params";
+        return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    ScanKeysResponse response;
+    size_t shard_idx = cursor;
+    for (; shard_idx < kNumShards && response.keys.size() < limit;
+         shard_idx++) {
+        MetadataShardAccessorRO shard(this, shard_idx);
+        CollectShardKeys(shard, prefix, response.keys);
+    }
+    response.next_cursor = shard_idx == kNumShards ? 0 : shard_idx;
+    return response;
+}
+
+void MasterService::CollectShardKeys(const MetadataShardAccessorRO& shard,
+                                     const std::string& prefix,
+                                     std::vector<std::string>& keys) {
+    if (shard->key_index && !prefix.empty()) {
+        shard->key_index->CollectWithPrefix(prefix, keys);
+        return;
+    }
+    for (const auto& [key, metadata] : shard->metadata) {
+        if (key.starts_with(prefix)) {
+            keys.push_back(key);
+        }
+    }
+}
+
 auto MasterService::GetAllSegments()
     -> tl::expected<std::vector<std::string>, ErrorCode> {
     ScopedSegmentAccess segment_access = segment_manager_.getSegmentAccess();
@@ -333,6 +1425,41 @@ auto MasterService::QuerySegments(const std::string& segment)
     return std::make_pair(used, capacity);
 }
 
+auto MasterService::DrainSegment(const std::string& segment, bool draining)
+    -> tl::expected<void, ErrorCode> {
+    {
+        ScopedSegmentAccess segment_access =
+            segment_manager_.getSegmentAccess();
+        auto err = segment_access.SetSegmentDraining(segment, draining);
+        if (err != ErrorCode::OK) {
+            return tl::make_unexpected(err);
+        }
+    }
+    if (draining && !rebalance_running_) {
+        LOG(WARNING) << "segment_name=" << segment
+                     << ", warn=rebalancer_disabled_segment_not_evacuated";
+    }
+    WakeRebalancer();
+    return {};
+}
+
+auto MasterService::DrainSegment(const UUID& segment_id, const UUID& client_id)
+    -> tl::expected<uint64_t, ErrorCode> {
+    size_t used = 0;
+    {
+        ScopedSegmentAccess segment_access =
+            segment_manager_.getSegmentAccess();
+        auto err = segment_access.DrainSegment(segment_id, client_id, used);
+        if (err != ErrorCode::OK) {
+            return tl::make_unexpected(err);
+        }
+    }
+    if (used > 0) {
+        WakeRebalancer();
+    }
+    return used;
+}
+
 auto MasterService::QueryIp(const UUID& client_id)
     -> tl::expected<std::vector<std::string>, ErrorCode> {
     ScopedSegmentAccess segment_access = segment_manager_.getSegmentAccess();
@@ -440,7 +1567,7 @@ auto MasterService::BatchReplicaClear(
 
             metadata.VisitReplicas(
                 &Replica::fn_is_completed, [](Replica& replica) {
-                    if (replica.is_memory_replica()) {
+                    if (Replica::fn_is_in_memory(replica)) {
                         MasterMetricManager::instance().dec_mem_cache_nums();
                     } else if (replica.is_disk_replica()) {
                         MasterMetricManager::instance().dec_file_cache_nums();
@@ -448,6 +1575,7 @@ auto MasterService::BatchReplicaClear(
                 });
 
             // Erase the entire metadata (all replicas will be deallocated)
+            PersistRemove(key);
             accessor.Erase();
             cleared_keys.emplace_back(key);
             VLOG(1) << "BatchReplicaClear: successfully cleared all replicas "
@@ -474,7 +1602,7 @@ auto MasterService::BatchReplicaClear(
             metadata.VisitReplicas(
                 match_replica_on_segment, [&](Replica& replica) {
                     has_replica_on_segment = true;
-                    if (replica.is_memory_replica()) {
+                    if (Replica::fn_is_in_memory(replica)) {
                         MasterMetricManager::instance().dec_mem_cache_nums();
                     } else if (replica.is_disk_replica()) {
                         MasterMetricManager::instance().dec_file_cache_nums();
@@ -493,7 +1621,10 @@ auto MasterService::BatchReplicaClear(
 
             // If no valid replicas remain, erase the entire metadata
             if (!metadata.IsValid()) {
+                PersistRemove(key);
                 accessor.Erase();
+            } else {
+                PersistPutEnd(key, metadata);
             }
 
             cleared_keys.emplace_back(key);
@@ -522,28 +1653,49 @@ auto MasterService::GetReplicaListByRegex(const std::string& regex_pattern)
         return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
     }
 
+    auto collect = [&](const std::string& key,
+                       const ObjectMetadata& metadata) {
+        std::vector<Replica::Descriptor> replica_list;
+        metadata.VisitReplicas(&Replica::fn_is_completed,
+                               [&replica_list](const Replica& replica) {
+                                   replica_list.emplace_back(
+                                       replica.get_descriptor());
+                               });
+
+        if (replica_list.empty()) {
+            LOG(WARNING) << "key=" << key
+                         << " matched by regex, but has no complete replicas.";
+            return;
+        }
+
+        results.emplace(key, std::move(replica_list));
+        metadata.RenewLease(default_kv_lease_ttl_, default_kv_soft_pin_ttl_,
+                            lease_renewal_min_ttl_);
+        RecordAccess(key, metadata);
+    };
+
+    // Anchored patterns only need to look at the keys with their prefix
+    const std::string prefix = GetRegexLiteralPrefix(regex_pattern);
+    std::vector<std::string> candidates;
     for (size_t i = 0; i < kNumShards; ++i) {
         MetadataShardAccessorRO shard(this, i);
 
-        for (const auto& [key, metadata] : shard->metadata) {
-            if (std::regex_search(key, pattern)) {
-                std::vector<Replica::Descriptor> replica_list;
-                metadata.VisitReplicas(
-                    &Replica::fn_is_completed,
-                    [&replica_list](const Replica& replica) {
-                        replica_list.emplace_back(replica.get_descriptor());
-                    });
-
-                if (replica_list.empty()) {
-                    LOG(WARNING)
-                        << "key=" << key
-                        << " matched by regex, but has no complete replicas.";
-                    continue;
+        if (shard->key_index && !prefix.empty()) {
+            candidates.clear();
+            shard->key_index->CollectWithPrefix(prefix, candidates);
+            for (const auto& key : candidates) {
+                auto it = shard->metadata.find(key);
+                if (it != shard->metadata.end() &&
+                    std::regex_search(key, pattern)) {
+                    collect(it->first, it->second);
                 }
+            }
+            continue;
+        }
 
-                results.emplace(key, std::move(replica_list));
-                metadata.GrantLease(default_kv_lease_ttl_,
-                                    default_kv_soft_pin_ttl_);
+        for (const auto& [key, metadata] : shard->metadata) {
+            if (std::regex_search(key, pattern)) {
+                collect(key, metadata);
             }
         }
     }
@@ -553,11 +1705,57 @@ auto MasterService::GetReplicaListByRegex(const std::string& regex_pattern)
 
 auto MasterService::GetReplicaList(const std::string& key)
     -> tl::expected<GetReplicaListResponse, ErrorCode> {
-    MetadataAccessorRO accessor(this, key);
+    if (!content_index_.empty()) {
+        if (auto content_key = content_index_.Resolve(key)) {
+            auto result = GetReplicaList(*content_key);
+            if (!result && result.error() == ErrorCode::OBJECT_NOT_FOUND) {
+                // The content object was evicted, drop the dangling link
+                std::optional<std::string> orphaned;
+                content_index_.Unlink(key, orphaned);
+            }
+            return result;
+        }
+    }
+
+    MasterMetricManager::instance().inc_total_get_nums();
+
+    const size_t key_hash = std::hash<std::string>{}(key);
+    const size_t shard_idx = key_hash % kNumShards;
+    if (hot_key_tracker_) {
+        hot_key_tracker_->Record(key, key_hash);
+    }
+    if (hot_replica_cache_.enabled()) {
+        // Serve hot keys without the shard lock while more than half of the
+        // lease granted by the last slow path read is left. Soft pins are
+        // only extended by the slow path.
+        auto cached = hot_replica_cache_.Get(key, key_hash, shard_idx,
+                                             default_kv_lease_ttl_ / 2);
+        if (cached) {
+            // The object is not touched, only the sketch can see the read
+            if (frequency_sketch_) {
+                frequency_sketch_->Increment(key_hash);
+            }
+            if (cached->replicas[0].is_memory_replica() ||
+                cached->replicas[0].is_striped_replica()) {
+                MasterMetricManager::instance().inc_mem_cache_hit_nums();
+            } else if (cached->replicas[0].is_disk_replica()) {
+                MasterMetricManager::instance().inc_file_cache_hit_nums();
+            }
+            MasterMetricManager::instance().inc_valid_get_nums();
+            RecordDiskRead(key, cached->replicas);
+            return std::move(*cached);
+        }
+    }
 
-    MasterMetricManager::instance().inc_total_get_nums();
+    const uint64_t cache_generation = hot_replica_cache_.generation();
+    MetadataAccessorRO accessor(this, key);
 
     if (!accessor.Exists()) {
+        // Misses count too, so that admission sees keys that keep coming
+        // back after eviction
+        if (frequency_sketch_) {
+            frequency_sketch_->Increment(key_hash);
+        }
         VLOG(1) << "key=" << key << ", info=object_not_found";
         return tl::make_unexpected(ErrorCode::OBJECT_NOT_FOUND);
     }
@@ -574,7 +1772,8 @@ auto MasterService::GetReplicaList(const std::string& key)
         return tl::make_unexpected(ErrorCode::REPLICA_IS_NOT_READY);
     }
 
-    if (replica_list[0].is_memory_replica()) {
+    if (replica_list[0].is_memory_replica() ||
+        replica_list[0].is_striped_replica()) {
         MasterMetricManager::instance().inc_mem_cache_hit_nums();
     } else if (replica_list[0].is_disk_replica()) {
         MasterMetricManager::instance().inc_file_cache_hit_nums();
@@ -582,16 +1781,248 @@ auto MasterService::GetReplicaList(const std::string& key)
     MasterMetricManager::instance().inc_valid_get_nums();
     // Grant a lease to the object so it will not be removed
     // when the client is reading it.
-    metadata.GrantLease(default_kv_lease_ttl_, default_kv_soft_pin_ttl_);
+    // A lease with enough time left is not renewed, the client is told how
+    // much is left instead.
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t lease_ttl =
+        metadata.RenewLease(default_kv_lease_ttl_, default_kv_soft_pin_ttl_,
+                            lease_renewal_min_ttl_);
+    RecordAccess(key, metadata);
+    RecordDiskRead(key, replica_list);
+    if (hot_replica_cache_.enabled()) {
+        hot_replica_cache_.Publish(key, key_hash, shard_idx, cache_generation,
+                                   replica_list,
+                                   now + std::chrono::milliseconds(lease_ttl));
+    }
+
+    return GetReplicaListResponse(std::move(replica_list), lease_ttl);
+}
+
+auto MasterService::LongestCachedPrefix(const std::vector<std::string>& keys)
+    -> tl::expected<std::vector<GetReplicaListResponse>, ErrorCode> {
+    std::vector<GetReplicaListResponse> results;
+    results.reserve(keys.size());
+    for (const auto& key : keys) {
+        auto result = GetReplicaList(key);
+        if (!result) {
+            break;
+        }
+        results.emplace_back(std::move(result.value()));
+    }
+    VLOG(1) << "action=longest_cached_prefix, keys_count=" << keys.size()
+            << ", hit_count=" << results.size();
+    return results;
+}
+
+auto MasterService::LinkContent(const std::string& key,
+                                const std::string& content_key)
+    -> tl::expected<void, ErrorCode> {
+    if (!ContentIndex::IsContentKey(content_key) ||
+        ContentIndex::IsContentKey(key)) {
+        LOG(ERROR) << "key=" << key << ", content_key=" << content_key
+                   << ", error=invalid_content_key";
+        return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (metadata_persistence_) {
+        // Links are not in the WAL, the linked key would be lost on restart
+        VLOG(1) << "key=" << key << ", error=links_not_persisted";
+        return tl::make_unexpected(ErrorCode::UNAVAILABLE_IN_CURRENT_MODE);
+    }
+
+    uint64_t size = 0;
+    {
+        MetadataAccessorRO content(this, content_key);
+        if (!content.Exists() ||
+            !content.Get().HasReplica(&Replica::fn_is_completed)) {
+            VLOG(1) << "content_key=" << content_key
+                    << ", info=content_not_found";
+            return tl::make_unexpected(ErrorCode::OBJECT_NOT_FOUND);
+        }
+        size = content.Get().size;
+    }
+
+    // Under the shard lock of the key, so that PutStart of the key either
+    // sees the link or is seen here
+    MetadataAccessorRW accessor(this, key);
+    if (accessor.Exists()) {
+        VLOG(1) << "key=" << key << ", info=object_already_exists";
+        return tl::make_unexpected(ErrorCode::OBJECT_ALREADY_EXISTS);
+    }
+    auto err = content_index_.Link(key, content_key, size);
+    if (err != ErrorCode::OK) {
+        VLOG(1) << "key=" << key << ", content_key=" << content_key
+                << ", error=" << err;
+        return tl::make_unexpected(err);
+    }
+    return {};
+}
+
+auto MasterService::LinkBundle(const std::string& bundle_key,
+                               const std::vector<std::string>& keys,
+                               const std::vector<uint64_t>& sizes)
+    -> tl::expected<void, ErrorCode> {
+    if (!BundleIndex::IsBundleKey(bundle_key) || keys.empty() ||
+        keys.size() != sizes.size()) {
+        LOG(ERROR) << "bundle_key=" << bundle_key
+                   << ", keys_count=" << keys.size()
+                   << ", sizes_count=" << sizes.size()
+                   << ", error=invalid_params";
+        return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (metadata_persistence_) {
+        // Links are not in the WAL, the linked keys would be lost on restart
+        VLOG(1) << "bundle_key=" << bundle_key
+                << ", error=links_not_persisted";
+        return tl::make_unexpected(ErrorCode::UNAVAILABLE_IN_CURRENT_MODE);
+    }
+    std::unordered_set<std::string_view> unique_keys;
+    unique_keys.reserve(keys.size());
+    uint64_t total_size = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i].empty() || sizes[i] == 0 ||
+            BundleIndex::IsBundleKey(keys[i]) ||
+            ContentIndex::IsContentKey(keys[i]) ||
+            !unique_keys.insert(keys[i]).second) {
+            LOG(ERROR) << "bundle_key=" << bundle_key << ", key=" << keys[i]
+                       << ", size=" << sizes[i] << ", error=invalid_member";
+            return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+        }
+        total_size += sizes[i];
+    }
+
+    {
+        MetadataAccessorRO bundle(this, bundle_key);
+        if (!bundle.Exists() ||
+            !bundle.Get().HasReplica(&Replica::fn_is_completed)) {
+            VLOG(1) << "bundle_key=" << bundle_key
+                    << ", info=bundle_not_found";
+            return tl::make_unexpected(ErrorCode::OBJECT_NOT_FOUND);
+        }
+        if (total_size > bundle.Get().size) {
+            LOG(ERROR) << "bundle_key=" << bundle_key
+                       << ", bundle_size=" << bundle.Get().size
+                       << ", members_size=" << total_size
+                       << ", error=members_exceed_bundle";
+            return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+        }
+    }
+
+    bool inserted = false;
+    auto err = bundle_index_.Link(bundle_key, keys, sizes, inserted);
+    if (err != ErrorCode::OK) {
+        VLOG(1) << "bundle_key=" << bundle_key << ", error=" << err;
+        return tl::make_unexpected(err);
+    }
+    if (!inserted) {
+        // Linked by an earlier call, which checked the keys
+        return {};
+    }
+    // Checked under the shard lock of each key once linked, so that PutStart
+    // of the key either sees the link or is seen here
+    for (const auto& key : keys) {
+        bool exists = !content_index_.empty() && content_index_.Resolve(key);
+        if (!exists) {
+            MetadataAccessorRO accessor(this, key);
+            exists = accessor.Exists();
+        }
+        if (exists) {
+            VLOG(1) << "bundle_key=" << bundle_key << ", key=" << key
+                    << ", info=object_already_exists";
+            std::optional<std::string> orphaned;
+            bundle_index_.UnlinkFrom(bundle_key, keys, orphaned);
+            if (orphaned) {
+                RemoveOrphanedContents({*orphaned}, true);
+            }
+            return tl::make_unexpected(ErrorCode::OBJECT_ALREADY_EXISTS);
+        }
+    }
+    return {};
+}
 
-    return GetReplicaListResponse(std::move(replica_list),
-                                  default_kv_lease_ttl_);
+std::vector<tl::expected<BundleMember, ErrorCode>>
+MasterService::BatchResolveBundle(const std::vector<std::string>& keys) {
+    std::vector<tl::expected<BundleMember, ErrorCode>> results;
+    results.reserve(keys.size());
+    // Whether the object of each bundle is readable, looked up once
+    std::unordered_map<std::string, ErrorCode> bundles;
+    for (const auto& key : keys) {
+        auto member =
+            bundle_index_.empty() ? std::nullopt : bundle_index_.Resolve(key);
+        if (!member) {
+            results.emplace_back(
+                tl::make_unexpected(ErrorCode::OBJECT_NOT_FOUND));
+            continue;
+        }
+        auto [it, inserted] =
+            bundles.try_emplace(member->bundle_key, ErrorCode::OK);
+        if (inserted) {
+            {
+                MetadataAccessorRO bundle(this, member->bundle_key);
+                if (!bundle.Exists()) {
+                    it->second = ErrorCode::OBJECT_NOT_FOUND;
+                } else if (!bundle.Get().HasReplica(
+                               &Replica::fn_is_completed)) {
+                    it->second = ErrorCode::REPLICA_IS_NOT_READY;
+                }
+            }
+            if (it->second == ErrorCode::OBJECT_NOT_FOUND) {
+                // The bundle object was evicted, drop the dangling links
+                bundle_index_.Drop(member->bundle_key);
+            }
+        }
+        if (it->second != ErrorCode::OK) {
+            results.emplace_back(tl::make_unexpected(it->second));
+            continue;
+        }
+        results.emplace_back(BundleMember{std::move(member->bundle_key),
+                                          member->offset, member->size});
+    }
+    return results;
 }
 
 auto MasterService::PutStart(const UUID& client_id, const std::string& key,
                              const uint64_t slice_length,
                              const ReplicateConfig& config)
     -> tl::expected<std::vector<Replica::Descriptor>, ErrorCode> {
+    auto result = PutStartOnce(client_id, key, slice_length, config);
+    if (result.has_value() || put_start_eviction_retries_ == 0) {
+        return result;
+    }
+
+    std::vector<std::string> segment_names;
+    if (!config.preferred_segment.empty()) {
+        segment_names.push_back(config.preferred_segment);
+    } else {
+        segment_names = config.preferred_segments;
+    }
+    // TinyLFU admission: the new key may only displace colder objects
+    std::optional<uint8_t> admission_freq;
+    if (tinylfu_admission_) {
+        admission_freq =
+            frequency_sketch_->Estimate(std::hash<std::string>{}(key));
+    }
+    // Evict outside the shard lock of the key, as eviction locks the other
+    // shards one by one.
+    for (uint32_t retry = 0; retry < put_start_eviction_retries_ &&
+                             !result.has_value() &&
+                             result.error() == ErrorCode::NO_AVAILABLE_HANDLE;
+         retry++) {
+        if (EvictFromSegments(segment_names, slice_length * config.replica_num,
+                              admission_freq) == 0) {
+            VLOG_IF(1, admission_freq.has_value())
+                << "key=" << key << ", admission_freq=" << +*admission_freq
+                << ", info=put_not_admitted";
+            break;
+        }
+        result = PutStartOnce(client_id, key, slice_length, config);
+    }
+    return result;
+}
+
+auto MasterService::ValidatePutStart(const std::string& key,
+                                     const uint64_t slice_length,
+                                     const ReplicateConfig& config) const
+    -> tl::expected<void, ErrorCode> {
     if (config.replica_num == 0 || key.empty() || slice_length == 0) {
         LOG(ERROR) << "key=" << key << ", replica_num=" << config.replica_num
                    << ", slice_length=" << slice_length
@@ -600,7 +2031,6 @@ auto MasterService::PutStart(const UUID& client_id, const std::string& key,
     }
 
     // Validate slice lengths
-    uint64_t total_length = 0;
     if ((memory_allocator_type_ == BufferAllocatorType::CACHELIB) &&
         (slice_length > kMaxSliceSize)) {
         LOG(ERROR) << "key=" << key << ", slice_length=" << slice_length
@@ -608,16 +2038,56 @@ auto MasterService::PutStart(const UUID& client_id, const std::string& key,
                    << ", error=invalid_slice_size";
         return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
     }
-    total_length += slice_length;
 
-    VLOG(1) << "key=" << key << ", value_length=" << total_length
+    if ((config.stripe_data_chunks == 0 && config.stripe_parity_chunks != 0) ||
+        config.stripe_data_chunks + uint64_t{config.stripe_parity_chunks} >
+            ReedSolomonCode::kMaxChunks) {
+        LOG(ERROR) << "key=" << key
+                   << ", stripe_data_chunks=" << config.stripe_data_chunks
+                   << ", stripe_parity_chunks=" << config.stripe_parity_chunks
+                   << ", error=invalid_stripe";
+        return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    VLOG(1) << "key=" << key << ", value_length=" << slice_length
             << ", slice_length=" << slice_length << ", config=" << config
             << ", action=put_start_begin";
+    return {};
+}
+
+auto MasterService::PutStartOnce(const UUID& client_id, const std::string& key,
+                                 const uint64_t slice_length,
+                                 const ReplicateConfig& config)
+    -> tl::expected<std::vector<Replica::Descriptor>, ErrorCode> {
+    auto valid = ValidatePutStart(key, slice_length, config);
+    if (!valid) {
+        return tl::make_unexpected(valid.error());
+    }
 
     // Lock the shard and check if object already exists
     MetadataShardAccessorRW shard(this, getShardIndex(key));
+    ScopedAllocatorAccess allocator_access =
+        segment_manager_.getAllocatorAccess();
+    return PutStartLocked(shard, allocator_access.getAllocatorManager(),
+                          client_id, key, slice_length, config,
+                          std::chrono::steady_clock::now());
+}
 
-    const auto now = std::chrono::steady_clock::now();
+auto MasterService::PutStartLocked(MetadataShardAccessorRW& shard,
+                                   const AllocatorManager& allocator_manager,
+                                   const UUID& client_id,
+                                   const std::string& key,
+                                   const uint64_t slice_length,
+                                   const ReplicateConfig& config,
+                                   std::chrono::steady_clock::time_point now,
+                                   std::unique_ptr<AllocatedBuffer>* buffer)
+    -> tl::expected<std::vector<Replica::Descriptor>, ErrorCode> {
+    const uint64_t total_length = slice_length;
+    if ((!content_index_.empty() && content_index_.Resolve(key)) ||
+        (!bundle_index_.empty() && bundle_index_.Resolve(key))) {
+        LOG(INFO) << "key=" << key << ", info=object_already_exists";
+        return tl::make_unexpected(ErrorCode::OBJECT_ALREADY_EXISTS);
+    }
     auto it = shard->metadata.find(key);
     if (it != shard->metadata.end() && !CleanupStaleHandles(it->second)) {
         auto& metadata = it->second;
@@ -635,19 +2105,46 @@ auto MasterService::PutStart(const UUID& client_id, const std::string& key,
             }
             shard->processing_keys.erase(key);
             shard->metadata.erase(it);
+        } else if (config.wait_for_concurrent_put &&
+                   !metadata.HasReplica(&Replica::fn_is_completed)) {
+            VLOG(1) << "key=" << key << ", info=object_put_in_progress";
+            return tl::make_unexpected(ErrorCode::OBJECT_PUT_IN_PROGRESS);
         } else {
             LOG(INFO) << "key=" << key << ", info=object_already_exists";
             return tl::make_unexpected(ErrorCode::OBJECT_ALREADY_EXISTS);
         }
     }
 
+    // A striped object gets one chunk per segment instead of full copies
+    const uint32_t data_chunks = config.stripe_data_chunks;
+    const size_t num_chunks = data_chunks == 0
+                                  ? config.replica_num
+                                  : data_chunks + config.stripe_parity_chunks;
+    const uint64_t chunk_size =
+        data_chunks == 0 ? slice_length
+                         : (slice_length + data_chunks - 1) / data_chunks;
+
+    // Charge the tenant up front, the metadata returns the charge once the
+    // object is erased
+    std::shared_ptr<TenantUsage> tenant;
+    uint64_t tenant_bytes = 0;
+    if (!config.tenant.empty()) {
+        tenant = tenant_quota_manager_->GetUsage(config.tenant);
+        tenant_bytes = chunk_size * num_chunks;
+        ErrorCode err = tenant->TryCharge(tenant_bytes, now);
+        if (err != ErrorCode::OK) {
+            VLOG(1) << "key=" << key << ", tenant=" << config.tenant
+                    << ", bytes=" << tenant_bytes << ", used_bytes="
+                    << tenant->used_bytes() << ", error=" << err;
+            return tl::make_unexpected(err);
+        }
+    }
+
     // Allocate replicas
     std::vector<Replica> replicas;
-    {
-        ScopedAllocatorAccess allocator_access =
-            segment_manager_.getAllocatorAccess();
-        const auto& allocator_manager = allocator_access.getAllocatorManager();
-
+    if (buffer && *buffer && (*buffer)->isAllocatorValid()) {
+        replicas.emplace_back(std::move(*buffer), ReplicaStatus::PROCESSING);
+    } else {
         std::vector<std::string> preferred_segments;
         if (!config.preferred_segment.empty()) {
             preferred_segments.push_back(config.preferred_segment);
@@ -656,12 +2153,21 @@ auto MasterService::PutStart(const UUID& client_id, const std::string& key,
         }
 
         auto allocation_result = allocation_strategy_->Allocate(
-            allocator_manager, slice_length, config.replica_num,
-            preferred_segments);
-
+            allocator_manager, chunk_size, num_chunks, preferred_segments,
+            std::set<std::string>(), config.reader_locality);
+
+        if (allocation_result.has_value() && data_chunks != 0 &&
+            allocation_result.value().size() < num_chunks) {
+            // Best effort does not apply, every chunk is needed
+            allocation_result =
+                tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
+        }
         if (!allocation_result.has_value()) {
             VLOG(1) << "Failed to allocate all replicas for key=" << key
                     << ", error: " << allocation_result.error();
+            if (tenant) {
+                tenant->Release(tenant_bytes);
+            }
             if (allocation_result.error() == ErrorCode::INVALID_PARAMS) {
                 return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
             }
@@ -669,7 +2175,20 @@ auto MasterService::PutStart(const UUID& client_id, const std::string& key,
             return tl::make_unexpected(ErrorCode::NO_AVAILABLE_HANDLE);
         }
 
-        replicas = std::move(allocation_result.value());
+        if (data_chunks == 0) {
+            replicas = std::move(allocation_result.value());
+            if (tenant && replicas.size() < num_chunks) {
+                // Best effort allocated fewer replicas than charged
+                const uint64_t unused =
+                    chunk_size * (num_chunks - replicas.size());
+                tenant->Release(unused);
+                tenant_bytes -= unused;
+            }
+        } else {
+            replicas.push_back(Replica::MakeStriped(
+                std::move(allocation_result.value()), data_chunks,
+                slice_length, ReplicaStatus::PROCESSING));
+        }
     }
 
     // If disk replica is enabled, allocate a disk replica
@@ -688,16 +2207,159 @@ auto MasterService::PutStart(const UUID& client_id, const std::string& key,
 
     // No need to set lease here. The object will not be evicted until
     // PutEnd is called.
-    shard->metadata.emplace(
+    auto emplaced = shard->metadata.emplace(
         std::piecewise_construct, std::forward_as_tuple(key),
         std::forward_as_tuple(client_id, now, total_length, std::move(replicas),
-                              config.with_soft_pin));
+                              config.with_soft_pin, config.recompute_cost,
+                              std::move(tenant), tenant_bytes));
+    emplaced.first->second.ttl = std::chrono::milliseconds(config.ttl_ms);
+    // A key evicted from the small queue not long ago skips it
+    if (ghost_queue_ && ghost_queue_->Remove(std::hash<std::string>{}(key))) {
+        emplaced.first->second.EnterMainQueue();
+    }
     // Also insert the metadata into processing set for monitoring.
     shard->processing_keys.insert(key);
 
     return replica_list;
 }
 
+std::vector<tl::expected<std::vector<Replica::Descriptor>, ErrorCode>>
+MasterService::BatchPutStart(const UUID& client_id,
+                             const std::vector<std::string>& keys,
+                             const std::vector<uint64_t>& slice_lengths,
+                             const ReplicateConfig& config) {
+    std::vector<tl::expected<std::vector<Replica::Descriptor>, ErrorCode>>
+        results(keys.size(),
+                tl::make_unexpected(ErrorCode::INVALID_PARAMS));
+    if (keys.size() != slice_lengths.size()) {
+        LOG(ERROR) << "keys_count=" << keys.size()
+                   << ", slice_lengths_count=" << slice_lengths.size()
+                   << ", error=invalid_params";
+        return results;
+    }
+
+    // Group the keys by shard, so that each shard is locked once
+    std::vector<std::pair<size_t, size_t>> shard_keys;
+    shard_keys.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (ValidatePutStart(keys[i], slice_lengths[i], config)) {
+            shard_keys.emplace_back(getShardIndex(keys[i]), i);
+        }
+    }
+    std::sort(shard_keys.begin(), shard_keys.end());
+
+    // Place the objects in one extent, in key order, so that the client
+    // transfers them as one
+    std::vector<std::unique_ptr<AllocatedBuffer>> extent_buffers;
+    if (batch_put_contiguous_ && config.replica_num == 1 &&
+        config.stripe_data_chunks == 0 && shard_keys.size() > 1) {
+        std::vector<size_t> indices;
+        indices.reserve(shard_keys.size());
+        for (const auto& shard_key : shard_keys) {
+            indices.push_back(shard_key.second);
+        }
+        std::sort(indices.begin(), indices.end());
+        extent_buffers = AllocateBatchExtent(slice_lengths, indices, config);
+    }
+
+    bool need_retry = false;
+    for (size_t begin = 0; begin < shard_keys.size();) {
+        const size_t shard_index = shard_keys[begin].first;
+        size_t end = begin;
+        while (end < shard_keys.size() &&
+               shard_keys[end].first == shard_index) {
+            end++;
+        }
+
+        MetadataShardAccessorRW shard(this, shard_index);
+        ScopedAllocatorAccess allocator_access =
+            segment_manager_.getAllocatorAccess();
+        const auto& allocator_manager = allocator_access.getAllocatorManager();
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t j = begin; j < end; j++) {
+            const size_t i = shard_keys[j].second;
+            results[i] = PutStartLocked(
+                shard, allocator_manager, client_id, keys[i], slice_lengths[i],
+                config, now,
+                extent_buffers.empty() ? nullptr : &extent_buffers[i]);
+            if (!results[i] &&
+                results[i].error() == ErrorCode::NO_AVAILABLE_HANDLE) {
+                need_retry = true;
+            }
+        }
+        begin = end;
+    }
+
+    // Keys that did not fit go through the inline eviction of PutStart
+    if (need_retry && put_start_eviction_retries_ > 0) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (!results[i] &&
+                results[i].error() == ErrorCode::NO_AVAILABLE_HANDLE) {
+                results[i] =
+                    PutStart(client_id, keys[i], slice_lengths[i], config);
+            }
+        }
+    }
+    return results;
+}
+
+auto MasterService::AllocateBatchExtent(
+    const std::vector<uint64_t>& slice_lengths,
+    const std::vector<size_t>& indices, const ReplicateConfig& config)
+    -> std::vector<std::unique_ptr<AllocatedBuffer>> {
+    std::vector<std::unique_ptr<AllocatedBuffer>> buffers(
+        slice_lengths.size());
+    std::vector<size_t> sizes;
+    sizes.reserve(indices.size());
+    uint64_t total_length = 0;
+    for (size_t i : indices) {
+        sizes.push_back(slice_lengths[i]);
+        total_length += slice_lengths[i];
+    }
+
+    std::vector<std::string> preferred_segments;
+    if (!config.preferred_segment.empty()) {
+        preferred_segments.push_back(config.preferred_segment);
+    } else {
+        preferred_segments = config.preferred_segments;
+    }
+
+    std::vector<std::unique_ptr<AllocatedBuffer>> extent;
+    {
+        ScopedAllocatorAccess allocator_access =
+            segment_manager_.getAllocatorAccess();
+        auto allocation_result = allocation_strategy_->Allocate(
+            allocator_access.getAllocatorManager(), total_length, 1,
+            preferred_segments, std::set<std::string>(),
+            config.reader_locality);
+        if (!allocation_result.has_value() ||
+            allocation_result.value().empty()) {
+            VLOG(1) << "keys=" << indices.size()
+                    << ", total_length=" << total_length
+                    << ", info=batch_extent_not_allocated";
+            return buffers;
+        }
+        extent = allocation_result.value().front().take_buffers();
+    }
+    if (extent.size() != 1) {
+        AllocatedBuffer::DeallocateBatch(std::move(extent));
+        return buffers;
+    }
+
+    // Allocators that cannot split leave the extent, which is freed here
+    auto pieces = AllocatedBuffer::Split(extent.front(), sizes);
+    if (pieces.size() != indices.size()) {
+        VLOG(1) << "keys=" << indices.size()
+                << ", total_length=" << total_length
+                << ", info=batch_extent_not_split";
+        return buffers;
+    }
+    for (size_t j = 0; j < indices.size(); j++) {
+        buffers[indices[j]] = std::move(pieces[j]);
+    }
+    return buffers;
+}
+
 auto MasterService::PutEnd(const UUID& client_id, const std::string& key,
                            ReplicaType replica_type)
     -> tl::expected<void, ErrorCode> {
@@ -716,15 +2378,19 @@ auto MasterService::PutEnd(const UUID& client_id, const std::string& key,
 
     metadata.VisitReplicas(
         [replica_type](const Replica& replica) {
-            return replica.type() == replica_type;
+            return MatchesReplicaType(replica, replica_type);
         },
         [](Replica& replica) { replica.mark_complete(); });
 
-    if (enable_offload_) {
-        metadata.VisitReplicas(&Replica::fn_is_completed,
-                               [this, &key](const Replica& replica) {
-                                   PushOffloadingQueue(key, replica);
-                               });
+    // With a memory tier target objects are only offloaded once cold
+    if (enable_offload_ && memory_tier_target_ratio_ == 0.0) {
+        metadata.VisitReplicas(
+            [](const Replica& replica) {
+                return replica.is_completed() && !replica.is_striped_replica();
+            },
+            [this, &key](const Replica& replica) {
+                PushOffloadingQueue(key, replica);
+            });
     }
 
     // If the object is completed, remove it from the processing set.
@@ -742,9 +2408,80 @@ auto MasterService::PutEnd(const UUID& client_id, const std::string& key,
     // at beginning. 2. If this object has soft pin enabled, set it to be soft
     // pinned.
     metadata.GrantLease(0, default_kv_soft_pin_ttl_);
+    if (metadata.ttl.count() > 0 && !metadata.expire_time) {
+        metadata.expire_time = std::chrono::steady_clock::now() + metadata.ttl;
+        ttl_wheel_.Schedule(key, *metadata.expire_time);
+    }
+    PersistPutEnd(key, metadata);
+    return {};
+}
+
+auto MasterService::PutCommit(const UUID& client_id, const std::string& key,
+                              uint64_t committed_bytes)
+    -> tl::expected<void, ErrorCode> {
+    MetadataAccessorRW accessor(this, key);
+    if (!accessor.Exists()) {
+        LOG(ERROR) << "key=" << key << ", error=object_not_found";
+        return tl::make_unexpected(ErrorCode::OBJECT_NOT_FOUND);
+    }
+
+    auto& metadata = accessor.Get();
+    if (client_id != metadata.client_id) {
+        LOG(ERROR) << "Illegal client " << client_id << " to PutCommit key "
+                   << key << ", was PutStart-ed by " << metadata.client_id;
+        return tl::make_unexpected(ErrorCode::ILLEGAL_CLIENT);
+    }
+    if (committed_bytes > metadata.size ||
+        committed_bytes < metadata.committed_bytes) {
+        LOG(ERROR) << "key=" << key << ", committed_bytes=" << committed_bytes
+                   << ", already_committed=" << metadata.committed_bytes
+                   << ", size=" << metadata.size
+                   << ", error=invalid_committed_bytes";
+        return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    metadata.committed_bytes = committed_bytes;
     return {};
 }
 
+auto MasterService::GetCommittedReplicaList(const std::string& key)
+    -> tl::expected<GetCommittedReplicaListResponse, ErrorCode> {
+    GetCommittedReplicaListResponse response;
+    auto completed = GetReplicaList(key);
+    if (completed) {
+        response.replicas = std::move(completed->replicas);
+        response.lease_ttl_ms = completed->lease_ttl_ms;
+        response.complete = true;
+        return response;
+    }
+    if (completed.error() != ErrorCode::REPLICA_IS_NOT_READY) {
+        return tl::make_unexpected(completed.error());
+    }
+
+    // Still being put, only the committed prefix of the memory replicas is
+    // readable. Replicas being put are not evicted, so no lease is needed.
+    MetadataAccessorRO accessor(this, key);
+    if (!accessor.Exists()) {
+        return tl::make_unexpected(ErrorCode::OBJECT_NOT_FOUND);
+    }
+    const auto& metadata = accessor.Get();
+    if (metadata.committed_bytes == 0) {
+        return tl::make_unexpected(ErrorCode::REPLICA_IS_NOT_READY);
+    }
+    metadata.VisitReplicas(
+        [](const Replica& replica) {
+            return replica.is_memory_replica() &&
+                   (replica.is_processing() || replica.is_completed());
+        },
+        [&response](const Replica& replica) {
+            response.replicas.emplace_back(replica.get_descriptor());
+        });
+    if (response.replicas.empty()) {
+        return tl::make_unexpected(ErrorCode::REPLICA_IS_NOT_READY);
+    }
+    response.committed_bytes = metadata.committed_bytes;
+    return response;
+}
+
 auto MasterService::AddReplica(const UUID& client_id, const std::string& key,
                                Replica& replica)
     -> tl::expected<void, ErrorCode> {
@@ -807,7 +2544,8 @@ auto MasterService::PutRevoke(const UUID& client_id, const std::string& key,
 
     auto processing_rep =
         metadata.GetFirstReplica([replica_type](const Replica& replica) {
-            return replica.type() == replica_type && !replica.is_processing();
+            return MatchesReplicaType(replica, replica_type) &&
+                   !replica.is_processing();
         });
     if (processing_rep != nullptr) {
         LOG(ERROR) << "key=" << key << ", status=" << processing_rep->status()
@@ -821,9 +2559,10 @@ auto MasterService::PutRevoke(const UUID& client_id, const std::string& key,
         MasterMetricManager::instance().dec_file_cache_nums();
     }
 
-    metadata.EraseReplicas([replica_type](const Replica& replica) {
-        return replica.type() == replica_type;
-    });
+    ReclaimReplicas(
+        metadata.PopReplicas([replica_type](const Replica& replica) {
+            return MatchesReplicaType(replica, replica_type);
+        }));
 
     // If the object is completed, remove it from the processing set.
     if (metadata.AllReplicas(&Replica::fn_is_completed) &&
@@ -832,6 +2571,7 @@ auto MasterService::PutRevoke(const UUID& client_id, const std::string& key,
     }
 
     if (metadata.IsValid() == false) {
+        PersistRemove(key);
         accessor.Erase();
     }
     return {};
@@ -874,7 +2614,12 @@ tl::expected<CopyStartResponse, ErrorCode> MasterService::CopyStart(
     }
 
     auto& metadata = accessor.Get();
-    auto source = metadata.GetReplicaBySegmentName(src_segment);
+    auto source = src_segment.empty()
+                      ? metadata.GetFirstReplica([](const Replica& replica) {
+                            return replica.is_completed() &&
+                                   replica.is_disk_replica();
+                        })
+                      : metadata.GetReplicaBySegmentName(src_segment);
     if (source == nullptr || !source->is_completed() ||
         source->has_invalid_mem_handle()) {
         LOG(ERROR) << "key=" << key << ", src_segment=" << src_segment
@@ -977,6 +2722,7 @@ tl::expected<void, ErrorCode> MasterService::CopyEnd(const UUID& client_id,
         accessor.EraseReplicationTask();
         if (!metadata.IsValid()) {
             // Remove the object if it does not have any replicas.
+            PersistRemove(key);
             accessor.Erase();
         }
         return tl::make_unexpected(ErrorCode::REPLICA_IS_GONE);
@@ -1000,6 +2746,7 @@ tl::expected<void, ErrorCode> MasterService::CopyEnd(const UUID& client_id,
     }
 
     accessor.EraseReplicationTask();
+    PersistPutEnd(key, metadata);
 
     return all_complete ? tl::expected<void, ErrorCode>()
                         : tl::make_unexpected(ErrorCode::REPLICA_IS_GONE);
@@ -1174,6 +2921,7 @@ tl::expected<void, ErrorCode> MasterService::MoveEnd(const UUID& client_id,
         accessor.EraseReplicationTask();
         if (!metadata.IsValid()) {
             // Remove the object if it does not have any replicas.
+            PersistRemove(key);
             accessor.Erase();
         }
         return tl::make_unexpected(ErrorCode::REPLICA_IS_GONE);
@@ -1213,6 +2961,9 @@ tl::expected<void, ErrorCode> MasterService::MoveEnd(const UUID& client_id,
     }
 
     accessor.EraseReplicationTask();
+    PersistPutEnd(key, metadata);
+    // Clients may still cache the source replica
+    replica_invalidation_epoch_++;
 
     return {};
 }
@@ -1271,6 +3022,26 @@ tl::expected<void, ErrorCode> MasterService::MoveRevoke(
 
 auto MasterService::Remove(const std::string& key, bool force)
     -> tl::expected<void, ErrorCode> {
+    if (!content_index_.empty()) {
+        // Linked keys have no metadata of their own
+        std::optional<std::string> orphaned;
+        if (content_index_.Unlink(key, orphaned)) {
+            if (orphaned) {
+                RemoveOrphanedContents({*orphaned}, force);
+            }
+            return {};
+        }
+    }
+    if (!bundle_index_.empty()) {
+        std::optional<std::string> orphaned;
+        if (bundle_index_.Unlink(key, orphaned)) {
+            if (orphaned) {
+                RemoveOrphanedContents({*orphaned}, force);
+            }
+            return {};
+        }
+    }
+
     MetadataAccessorRW accessor(this, key);
     if (!accessor.Exists()) {
         VLOG(1) << "key=" << key << ", error=object_not_found";
@@ -1301,7 +3072,12 @@ auto MasterService::Remove(const std::string& key, bool force)
     }
 
     // Remove object metadata
+    PersistRemove(key);
+    ReclaimReplicas(metadata.PopReplicas());
     accessor.Erase();
+    if (force) {
+        replica_invalidation_epoch_++;
+    }
     return {};
 }
 
@@ -1318,42 +3094,69 @@ auto MasterService::RemoveByRegex(const std::string& regex_pattern, bool force)
         return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
     }
 
+    auto can_remove = [&](size_t shard_idx, const std::string& key,
+                          const ObjectMetadata& metadata) {
+        if (!force && !metadata.IsLeaseExpired()) {
+            VLOG(1) << "key=" << key
+                    << " matched by regex, but has lease. Skipping "
+                    << "removal.";
+            return false;
+        }
+        /**
+         * The reason the force operation here does not bypass the
+         * replica check is that put operations (which could also be
+         * copy or move) and remove operations might be happening
+         * concurrently, making it extremely dangerous to perform a
+         * direct removal at this point.
+         */
+        if (!metadata.AllReplicas(&Replica::fn_is_completed)) {
+            LOG(WARNING) << "key=" << key
+                         << " matched by regex, but not all replicas "
+                            "are complete. Skipping removal.";
+            return false;
+        }
+        if (metadata_shards_[shard_idx].replication_tasks.contains(key)) {
+            LOG(WARNING) << "key=" << key
+                         << ", matched by regex, but has replication "
+                            "task. Skipping removal.";
+            return false;
+        }
+        return true;
+    };
+
+    // Anchored patterns only need to look at the keys with their prefix
+    const std::string prefix = GetRegexLiteralPrefix(regex_pattern);
+    std::vector<std::string> candidates;
+    std::vector<Replica> reclaimed;
     for (size_t i = 0; i < kNumShards; ++i) {
         MetadataShardAccessorRW shard(this, i);
 
-        for (auto it = shard->metadata.begin(); it != shard->metadata.end();) {
-            if (std::regex_search(it->first, pattern)) {
-                if (!force && !it->second.IsLeaseExpired()) {
-                    VLOG(1) << "key=" << it->first
-                            << " matched by regex, but has lease. Skipping "
-                            << "removal.";
-                    ++it;
-                    continue;
-                }
-                /**
-                 * The reason the force operation here does not bypass the
-                 * replica check is that put operations (which could also be
-                 * copy or move) and remove operations might be happening
-                 * concurrently, making it extremely dangerous to perform a
-                 * direct removal at this point.
-                 */
-                if (!it->second.AllReplicas(&Replica::fn_is_completed)) {
-                    LOG(WARNING) << "key=" << it->first
-                                 << " matched by regex, but not all replicas "
-                                    "are complete. Skipping removal.";
-                    ++it;
-                    continue;
-                }
-                if (metadata_shards_[i].replication_tasks.contains(it->first)) {
-                    LOG(WARNING) << "key=" << it->first
-                                 << ", matched by regex, but has replication "
-                                    "task. Skipping removal.";
-                    ++it;
+        if (shard->key_index && !prefix.empty()) {
+            candidates.clear();
+            shard->key_index->CollectWithPrefix(prefix, candidates);
+            for (const auto& key : candidates) {
+                auto it = shard->metadata.find(key);
+                if (it == shard->metadata.end() ||
+                    !std::regex_search(key, pattern) ||
+                    !can_remove(i, key, it->second)) {
                     continue;
                 }
+                VLOG(1) << "key=" << key << " matched by regex. Removing.";
+                PersistRemove(key);
+                AppendReplicas(reclaimed, it->second.PopReplicas());
+                shard->metadata.erase(it);
+                removed_count++;
+            }
+            continue;
+        }
 
+        for (auto it = shard->metadata.begin(); it != shard->metadata.end();) {
+            if (std::regex_search(it->first, pattern) &&
+                can_remove(i, it->first, it->second)) {
                 VLOG(1) << "key=" << it->first
                         << " matched by regex. Removing.";
+                PersistRemove(it->first);
+                AppendReplicas(reclaimed, it->second.PopReplicas());
                 it = shard->metadata.erase(it);
                 removed_count++;
             } else {
@@ -1362,6 +3165,28 @@ auto MasterService::RemoveByRegex(const std::string& regex_pattern, bool force)
         }
     }
 
+    ReclaimReplicas(std::move(reclaimed));
+    if (force && removed_count > 0) {
+        replica_invalidation_epoch_++;
+    }
+    if (!content_index_.empty()) {
+        std::vector<std::string> orphaned;
+        removed_count += content_index_.UnlinkIf(
+            [&](const std::string& key) {
+                return std::regex_search(key, pattern);
+            },
+            orphaned);
+        RemoveOrphanedContents(orphaned, force);
+    }
+    if (!bundle_index_.empty()) {
+        std::vector<std::string> orphaned;
+        removed_count += bundle_index_.UnlinkIf(
+            [&](const std::string& key) {
+                return std::regex_search(key, pattern);
+            },
+            orphaned);
+        RemoveOrphanedContents(orphaned, force);
+    }
     VLOG(1) << "action=remove_by_regex, pattern=" << regex_pattern
             << ", removed_count=" << removed_count;
     return removed_count;
@@ -1373,6 +3198,7 @@ long MasterService::RemoveAll(bool force) {
     // Store the current time to avoid repeatedly
     // calling std::chrono::steady_clock::now()
     auto now = std::chrono::steady_clock::now();
+    std::vector<Replica> reclaimed;
 
     for (size_t i = 0; i < kNumShards; i++) {
         MetadataShardAccessorRW shard(this, i);
@@ -1393,8 +3219,10 @@ long MasterService::RemoveAll(bool force) {
                 it->second.AllReplicas(&Replica::fn_is_completed) &&
                 !shard->replication_tasks.contains(it->first)) {
                 auto mem_rep_count =
-                    it->second.CountReplicas(&Replica::fn_is_memory_replica);
+                    it->second.CountReplicas(&Replica::fn_is_in_memory);
                 total_freed_size += it->second.size * mem_rep_count;
+                PersistRemove(it->first);
+                AppendReplicas(reclaimed, it->second.PopReplicas());
                 it = shard->metadata.erase(it);
                 removed_count++;
             } else {
@@ -1403,10 +3231,206 @@ long MasterService::RemoveAll(bool force) {
         }
     }
 
-    VLOG(1) << "action=remove_all_objects"
-            << ", removed_count=" << removed_count
-            << ", total_freed_size=" << total_freed_size;
-    return removed_count;
+    ReclaimReplicas(std::move(reclaimed));
+    if (force && removed_count > 0) {
+        replica_invalidation_epoch_++;
+    }
+    if (!content_index_.empty()) {
+        std::vector<std::string> orphaned;
+        removed_count += content_index_.UnlinkIf(
+            [](const std::string&) { return true; }, orphaned);
+        RemoveOrphanedContents(orphaned, force);
+    }
+    if (!bundle_index_.empty()) {
+        std::vector<std::string> orphaned;
+        removed_count += bundle_index_.UnlinkIf(
+            [](const std::string&) { return true; }, orphaned);
+        RemoveOrphanedContents(orphaned, force);
+    }
+    VLOG(1) << "action=remove_all_objects"
+            << ", removed_count=" << removed_count
+            << ", total_freed_size=" << total_freed_size;
+    return removed_count;
+}
+
+auto MasterService::RemoveByPrefix(const std::string& prefix, bool force)
+    -> tl::expected<UUID, ErrorCode> {
+    auto task_id =
+        task_manager_.get_write_access()
+            .submit_task_typed<TaskType::PREFIX_REMOVE>(
+                kMasterTaskClient, {.prefix = prefix, .force = force});
+    if (!task_id) {
+        LOG(ERROR) << "prefix=" << prefix << ", error=" << task_id.error();
+        return task_id;
+    }
+    master_task_cv_.notify_all();
+    VLOG(1) << "action=remove_by_prefix, prefix=" << prefix
+            << ", force=" << force << ", task_id=" << task_id.value();
+    return task_id;
+}
+
+void MasterService::RemoveOrphanedContents(
+    const std::vector<std::string>& content_keys, bool force) {
+    for (const auto& content_key : content_keys) {
+        auto result = Remove(content_key, force);
+        if (!result) {
+            VLOG(1) << "content_key=" << content_key
+                    << ", info=orphaned_content_not_removed, error="
+                    << result.error();
+        }
+    }
+}
+
+void MasterService::RunPrefixRemoval(const Task& task) {
+    PrefixRemovePayload payload;
+    struct_json::from_json(payload, task.payload);
+
+    long removed_count = 0;
+    size_t shard_idx = 0;
+    auto progress = [&] {
+        return "processed_shards=" + std::to_string(shard_idx) + "/" +
+               std::to_string(kNumShards) +
+               ", removed_count=" + std::to_string(removed_count);
+    };
+
+    std::vector<std::string> keys;
+    for (; shard_idx < kNumShards && master_task_running_; shard_idx++) {
+        keys.clear();
+        {
+            MetadataShardAccessorRO shard(this, shard_idx);
+            CollectShardKeys(shard, payload.prefix, keys);
+        }
+
+        // Release the shard between batches so that RPCs on it get through
+        for (size_t begin = 0; begin < keys.size();
+             begin += kPrefixRemovalBatchSize) {
+            const size_t end =
+                std::min(keys.size(), begin + kPrefixRemovalBatchSize);
+            long batch_removed = 0;
+            std::vector<Replica> reclaimed;
+            {
+                MetadataShardAccessorRW shard(this, shard_idx);
+                auto now = std::chrono::steady_clock::now();
+                for (size_t i = begin; i < end; i++) {
+                    auto it = shard->metadata.find(keys[i]);
+                    // As in RemoveAll, force does not bypass the replica and
+                    // replication task checks
+                    if (it == shard->metadata.end() ||
+                        (!payload.force && !it->second.IsLeaseExpired(now)) ||
+                        !it->second.AllReplicas(&Replica::fn_is_completed) ||
+                        shard->replication_tasks.contains(keys[i])) {
+                        continue;
+                    }
+                    PersistRemove(keys[i]);
+                    AppendReplicas(reclaimed, it->second.PopReplicas());
+                    shard->metadata.erase(it);
+                    batch_removed++;
+                }
+            }
+            ReclaimReplicas(std::move(reclaimed));
+            if (payload.force && batch_removed > 0) {
+                replica_invalidation_epoch_++;
+            }
+            removed_count += batch_removed;
+        }
+        task_manager_.get_write_access().update_task_message(task.id,
+                                                             progress());
+    }
+
+    const bool finished = shard_idx == kNumShards;
+    if (finished && !content_index_.empty()) {
+        std::vector<std::string> orphaned;
+        removed_count += content_index_.UnlinkIf(
+            [&](const std::string& key) {
+                return key.starts_with(payload.prefix);
+            },
+            orphaned);
+        RemoveOrphanedContents(orphaned, payload.force);
+    }
+    if (finished && !bundle_index_.empty()) {
+        std::vector<std::string> orphaned;
+        removed_count += bundle_index_.UnlinkIf(
+            [&](const std::string& key) {
+                return key.starts_with(payload.prefix);
+            },
+            orphaned);
+        RemoveOrphanedContents(orphaned, payload.force);
+    }
+    // The task is reported done once the removals are on disk
+    SyncMetadata();
+    task_manager_.get_write_access().complete_task(
+        kMasterTaskClient, task.id,
+        finished ? TaskStatus::SUCCESS : TaskStatus::FAILED,
+        finished ? progress() : progress() + ", error=master_stopped");
+    VLOG(1) << "action=remove_by_prefix_finished, task_id=" << task.id
+            << ", prefix=" << payload.prefix << ", " << progress();
+}
+
+void MasterService::RecordAccess(const std::string& key,
+                                 const ObjectMetadata& metadata) {
+    if (frequency_sketch_) {
+        frequency_sketch_->Increment(std::hash<std::string>{}(key));
+    }
+    switch (eviction_policy_) {
+        case EvictionPolicy::SIEVE:
+        case EvictionPolicy::S3FIFO:
+        case EvictionPolicy::COST_AWARE:
+            metadata.RecordAccess();
+            break;
+        case EvictionPolicy::LFU:
+        case EvictionPolicy::LRU:
+            break;
+    }
+}
+
+void MasterService::OnObjectEvicted(const std::string& key,
+                                    const ObjectMetadata& metadata) {
+    if (ghost_queue_ && !metadata.InMainQueue()) {
+        ghost_queue_->Insert(std::hash<std::string>{}(key));
+    }
+}
+
+auto MasterService::GetEvictionRank(const std::string& key,
+                                    const ObjectMetadata& metadata) const
+    -> EvictionRank {
+    const auto lease_timeout =
+        metadata.lease_timeout.load(std::memory_order_relaxed);
+    switch (eviction_policy_) {
+        case EvictionPolicy::SIEVE:
+            // Objects read since the last pass are spared. Among the others
+            // the oldest lease goes first, which for objects never read is
+            // the insertion order.
+            return {metadata.GetAccessFreq() > 0 ? 1 : 0, lease_timeout};
+        case EvictionPolicy::S3FIFO: {
+            // Read objects are spared and move on. Of the others, those of
+            // the queue over its share go first, each queue in FIFO order.
+            if (metadata.GetAccessFreq() > 0) {
+                return {2, lease_timeout};
+            }
+            const bool small_first =
+                s3fifo_small_first_.load(std::memory_order_relaxed);
+            return {metadata.InMainQueue() == small_first ? 1 : 0,
+                    lease_timeout};
+        }
+        case EvictionPolicy::LFU:
+            return {frequency_sketch_->Estimate(std::hash<std::string>{}(key)),
+                    lease_timeout};
+        case EvictionPolicy::COST_AWARE: {
+            // Hits lost by evicting the object, weighted by the cost of
+            // recomputing it, per byte freed. All memory replicas are
+            // evicted at once, so extra replicas free more bytes.
+            const double expected_hits = metadata.GetAccessFreq() + 1;
+            const double cost = std::max<uint32_t>(metadata.recompute_cost, 1);
+            const size_t num_memory_replicas = std::max<size_t>(
+                metadata.CountReplicas(&Replica::fn_is_in_memory), 1);
+            const double freed_bytes = static_cast<double>(
+                std::max<size_t>(metadata.size, 1) * num_memory_replicas);
+            return {expected_hits * cost / freed_bytes, lease_timeout};
+        }
+        case EvictionPolicy::LRU:
+            break;
+    }
+    return {0, lease_timeout};
 }
 
 bool MasterService::CleanupStaleHandles(ObjectMetadata& metadata) {
@@ -1428,24 +3452,101 @@ size_t MasterService::GetKeyCount() const {
     return total;
 }
 
-auto MasterService::Ping(const UUID& client_id)
+std::vector<HotKeyTracker::HotKey> MasterService::GetHotKeys() const {
+    if (!hot_key_tracker_) {
+        return {};
+    }
+    return hot_key_tracker_->TopKeys();
+}
+
+std::vector<std::pair<size_t, SharedMutex::ContentionStats>>
+MasterService::GetShardLockStats() const {
+    std::vector<std::pair<size_t, SharedMutex::ContentionStats>> stats;
+    stats.reserve(kNumShards);
+    for (size_t i = 0; i < kNumShards; i++) {
+        // Atomic counters, readable without the lock
+        stats.emplace_back(i, metadata_shards_[i].mutex.contention_stats());
+    }
+    std::sort(stats.begin(), stats.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second.wait_us > rhs.second.wait_us;
+    });
+    return stats;
+}
+
+std::unordered_map<std::string, AllocatorStats>
+MasterService::GetSegmentAllocatorStats() {
+    std::unordered_map<std::string, AllocatorStats> result;
+    ScopedAllocatorAccess allocator_access =
+        segment_manager_.getAllocatorAccess();
+    const auto& allocator_manager = allocator_access.getAllocatorManager();
+    for (const auto& name : allocator_manager.getNames()) {
+        const auto allocators = allocator_manager.getAllocators(name);
+        if (allocators == nullptr) {
+            continue;
+        }
+        AllocatorStats& total = result[name];
+        double unusable = 0.0;
+        for (const auto& allocator : *allocators) {
+            const AllocatorStats stats = allocator->getStats();
+            total.capacity += stats.capacity;
+            total.allocated += stats.allocated;
+            total.free += stats.free;
+            total.largest_free_region =
+                std::max(total.largest_free_region, stats.largest_free_region);
+            total.free_regions += stats.free_regions;
+            unusable += stats.fragmentation * stats.free;
+        }
+        if (total.free > 0) {
+            total.fragmentation = unusable / total.free;
+        }
+    }
+    return result;
+}
+
+auto MasterService::Ping(const UUID& client_id,
+                         uint64_t transfer_bytes_per_sec)
     -> tl::expected<PingResponse, ErrorCode> {
-    std::shared_lock<std::shared_mutex> lock(client_mutex_);
-    ClientStatus client_status;
-    auto it = ok_client_.find(client_id);
-    if (it != ok_client_.end()) {
-        client_status = ClientStatus::OK;
-    } else {
-        client_status = ClientStatus::NEED_REMOUNT;
+    // All segments of a client share its lease, so one ping keeps them all
+    ClientStatus client_status = client_leases_.Renew(client_id)
+                                     ? ClientStatus::OK
+                                     : ClientStatus::NEED_REMOUNT;
+    if (allocation_strategy_type_ == AllocationStrategyType::LOAD_AWARE &&
+        client_status == ClientStatus::OK) {
+        // The segments of a client share the NIC of its host
+        std::vector<Segment> segments;
+        {
+            ScopedSegmentAccess segment_access =
+                segment_manager_.getSegmentAccess();
+            segment_access.GetClientSegments(client_id, segments);
+        }
+        for (const auto& segment : segments) {
+            allocation_strategy_->UpdateSegmentLoad(segment.name,
+                                                    transfer_bytes_per_sec);
+        }
     }
-    PodUUID pod_client_id = {client_id.first, client_id.second};
-    if (!client_ping_queue_.push(pod_client_id)) {
-        // Queue is full
-        LOG(ERROR) << "client_id=" << client_id
-                   << ", error=client_ping_queue_full";
-        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
+    PingResponse response(view_version_, client_status,
+                          replica_invalidation_epoch_.load());
+    response.mem_used_ratio =
+        MasterMetricManager::instance().get_global_mem_used_ratio();
+    response.put_backoff_ms = PutBackoffMs(response.mem_used_ratio);
+    return response;
+}
+
+uint64_t MasterService::PutBackoffMs(double used_ratio) const {
+    if (need_eviction_) {
+        return kMaxPutBackoffMs;
+    }
+    if (used_ratio <= eviction_high_watermark_ratio_) {
+        return 0;
     }
-    return PingResponse(view_version_, client_status);
+    if (eviction_high_watermark_ratio_ >= 1.0) {
+        return kMaxPutBackoffMs;
+    }
+    const double pressure = (used_ratio - eviction_high_watermark_ratio_) /
+                            (1.0 - eviction_high_watermark_ratio_);
+    const auto backoff_ms =
+        static_cast<uint64_t>(std::ceil(pressure * kMaxPutBackoffMs));
+    return std::min(kMaxPutBackoffMs, backoff_ms);
 }
 
 tl::expected<std::string, ErrorCode> MasterService::GetFsdir() const {
@@ -1492,7 +3593,8 @@ auto MasterService::MountLocalDiskSegment(const UUID& client_id,
 }
 
 auto MasterService::OffloadObjectHeartbeat(const UUID& client_id,
-                                           bool enable_offloading)
+                                           bool enable_offloading,
+                                           uint64_t max_objects)
     -> tl::expected<std::unordered_map<std::string, int64_t>, ErrorCode> {
     ScopedLocalDiskSegmentAccess local_disk_segment_access =
         segment_manager_.getLocalDiskSegmentAccess();
@@ -1506,10 +3608,20 @@ auto MasterService::OffloadObjectHeartbeat(const UUID& client_id,
     }
     MutexLocker locker(&local_disk_segment_it->second->offloading_mutex_);
     local_disk_segment_it->second->enable_offloading = enable_offloading;
-    if (enable_offloading) {
-        return std::move(local_disk_segment_it->second->offloading_objects);
+    if (!enable_offloading) {
+        return {};
     }
-    return {};
+    auto& offloading_objects =
+        local_disk_segment_it->second->offloading_objects;
+    if (max_objects == 0 || offloading_objects.size() <= max_objects) {
+        return std::move(offloading_objects);
+    }
+    std::unordered_map<std::string, int64_t> batch;
+    batch.reserve(max_objects);
+    while (batch.size() < max_objects) {
+        batch.insert(offloading_objects.extract(offloading_objects.begin()));
+    }
+    return batch;
 }
 
 auto MasterService::NotifyOffloadSuccess(
@@ -1573,6 +3685,97 @@ tl::expected<void, ErrorCode> MasterService::PushOffloadingQueue(
     return {};
 }
 
+uint64_t MasterService::EvictFromSegments(
+    const std::vector<std::string>& segment_names, uint64_t required_size,
+    std::optional<uint8_t> admission_freq) {
+    auto in_segments = [&segment_names](const Replica& replica) {
+        if (!Replica::fn_is_in_memory(replica) || !replica.is_completed() ||
+            replica.get_refcnt() != 0) {
+            return false;
+        }
+        if (segment_names.empty()) {
+            return true;
+        }
+        for (const auto& name : replica.get_segment_names()) {
+            if (name && std::find(segment_names.begin(), segment_names.end(),
+                                  *name) != segment_names.end()) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto now = std::chrono::steady_clock::now();
+    long evicted_count = 0;
+    uint64_t freed_size = 0;
+    size_t evicted_shards = 0;
+    std::vector<Replica> reclaimed;
+    for (size_t i = 0; i < kNumShards && freed_size < required_size &&
+                       evicted_shards < kSegmentEvictionMaxShards;
+         i++) {
+        MetadataShardAccessorRW shard(
+            this, segment_eviction_cursor_.fetch_add(1) % kNumShards);
+
+        std::vector<std::pair<EvictionRank, MetadataMap::iterator>>
+            candidates;
+        for (auto it = shard->metadata.begin(); it != shard->metadata.end();
+             ++it) {
+            if (it->second.IsLeaseExpired(now) &&
+                !it->second.IsSoftPinned(now) &&
+                it->second.HasReplica(in_segments)) {
+                candidates.emplace_back(GetEvictionRank(it->first, it->second),
+                                        it);
+            }
+        }
+        if (candidates.empty()) {
+            continue;
+        }
+        evicted_shards++;
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const auto& lhs, const auto& rhs) {
+                      return lhs.first < rhs.first;
+                  });
+
+        // Erasing entries does not invalidate the other iterators
+        for (auto& candidate : candidates) {
+            if (freed_size >= required_size) {
+                break;
+            }
+            auto it = candidate.second;
+            // The new key only displaces objects accessed less often
+            if (admission_freq &&
+                frequency_sketch_->Estimate(std::hash<std::string>{}(
+                    it->first)) >= *admission_freq) {
+                continue;
+            }
+            auto evicted = it->second.PopReplicas(in_segments);
+            const size_t num_evicted = evicted.size();
+            AppendReplicas(reclaimed, std::move(evicted));
+            it->second.OnMemoryReplicasEvicted(num_evicted);
+            freed_size += it->second.size * num_evicted;
+            PersistEvict(it->first, it->second);
+            OnObjectEvicted(it->first, it->second);
+            evicted_count++;
+            if (!it->second.IsValid()) {
+                shard->metadata.erase(it);
+            }
+        }
+    }
+
+    // The caller retries its allocation right away, so the memory has to be
+    // free by the time this returns
+    ReclaimReplicas(std::move(reclaimed), /*allow_async=*/false);
+    if (evicted_count > 0) {
+        MasterMetricManager::instance().inc_eviction_success(evicted_count,
+                                                             freed_size);
+    }
+    VLOG(1) << "action=evict_from_segments"
+            << ", required_size=" << required_size
+            << ", evicted_count=" << evicted_count
+            << ", freed_size=" << freed_size;
+    return freed_size;
+}
+
 void MasterService::EvictionThreadFunc() {
     VLOG(1) << "action=eviction_thread_started";
 
@@ -1601,6 +3804,12 @@ void MasterService::EvictionThreadFunc() {
             ReleaseExpiredDiscardedReplicas(now);
             last_discard_time = now;
         }
+        ExpireObjects(now);
+        SyncMetadata();
+        if (frequency_sketch_) {
+            // Off the read path, which only increments the sketch
+            frequency_sketch_->Age();
+        }
 
         std::this_thread::sleep_for(
             std::chrono::milliseconds(kEvictionThreadSleepMs));
@@ -1609,6 +3818,39 @@ void MasterService::EvictionThreadFunc() {
     VLOG(1) << "action=eviction_thread_stopped";
 }
 
+void MasterService::ExpireObjects(
+    const std::chrono::steady_clock::time_point& now) {
+    for (auto& entry : ttl_wheel_.Advance(now)) {
+        MetadataAccessorRW accessor(this, entry.key);
+        if (!accessor.Exists()) {
+            continue;
+        }
+        auto& metadata = accessor.Get();
+        // The key may have been removed and put again since it was scheduled
+        if (!metadata.expire_time || *metadata.expire_time != entry.deadline) {
+            continue;
+        }
+        // Expire leased or busy objects later
+        std::optional<std::chrono::steady_clock::time_point> retry_at;
+        if (!metadata.IsLeaseExpired()) {
+            retry_at = metadata.lease_timeout.load(std::memory_order_relaxed);
+        } else if (!metadata.AllReplicas(&Replica::fn_is_completed) ||
+                   accessor.HasReplicationTask()) {
+            retry_at = now + kTtlRetryInterval;
+        }
+        if (retry_at) {
+            metadata.expire_time = retry_at;
+            ttl_wheel_.Schedule(entry.key, *retry_at);
+            continue;
+        }
+        VLOG(1) << "key=" << entry.key << ", action=ttl_expired";
+        PersistRemove(entry.key);
+        ReclaimReplicas(metadata.PopReplicas());
+        accessor.Erase();
+        MasterMetricManager::instance().inc_ttl_expired_keys();
+    }
+}
+
 void MasterService::DiscardExpiredProcessingReplicas(
     MetadataShardAccessorRW& shard,
     const std::chrono::steady_clock::time_point& now) {
@@ -1724,15 +3966,27 @@ void MasterService::DiscardExpiredProcessingReplicas(
 uint64_t MasterService::ReleaseExpiredDiscardedReplicas(
     const std::chrono::steady_clock::time_point& now) {
     uint64_t released_cnt = 0;
-    std::lock_guard lock(discarded_replicas_mutex_);
-    discarded_replicas_.remove_if(
-        [&now, &released_cnt](const DiscardedReplicas& item) {
-            const bool expired = item.isExpired(now);
-            if (expired && item.memSize() > 0) {
-                released_cnt++;
-            }
-            return expired;
-        });
+    std::list<DiscardedReplicas> expired;
+    {
+        std::lock_guard lock(discarded_replicas_mutex_);
+        for (auto it = discarded_replicas_.begin();
+             it != discarded_replicas_.end();) {
+            auto next = std::next(it);
+            if (it->isExpired(now)) {
+                if (it->memSize() > 0) {
+                    released_cnt++;
+                }
+                expired.splice(expired.end(), discarded_replicas_, it);
+            }
+            it = next;
+        }
+    }
+    // Freed outside of the list lock, which PutStart takes as well
+    std::vector<Replica> reclaimed;
+    for (auto& item : expired) {
+        AppendReplicas(reclaimed, item.TakeReplicas());
+    }
+    ReclaimReplicas(std::move(reclaimed));
     return released_cnt;
 }
 
@@ -1751,23 +4005,48 @@ void MasterService::BatchEvict(double evict_ratio_target,
     uint64_t total_freed_size = 0;
 
     // Candidates for second pass eviction
-    std::vector<std::chrono::steady_clock::time_point> no_pin_objects;
-    std::vector<std::chrono::steady_clock::time_point> soft_pin_objects;
+    std::vector<EvictionRank> no_pin_objects;
+    std::vector<EvictionRank> soft_pin_objects;
 
     auto can_evict_replicas = [](const ObjectMetadata& metadata) {
         return metadata.HasReplica([](const Replica& replica) {
-            return replica.is_memory_replica() && replica.is_completed() &&
-                   replica.get_refcnt() == 0;
+            return Replica::fn_is_in_memory(replica) &&
+                   replica.is_completed() && replica.get_refcnt() == 0;
         });
     };
 
-    auto evict_replicas = [](ObjectMetadata& metadata) {
-        return metadata.EraseReplicas([](const Replica& replica) {
-            return replica.is_memory_replica() && replica.is_completed() &&
-                   replica.get_refcnt() == 0;
+    // Freed together once all passes are done
+    std::vector<Replica> reclaimed;
+    auto evict_replicas = [this, &reclaimed](const std::string& key,
+                                             ObjectMetadata& metadata) {
+        auto evicted = metadata.PopReplicas([](const Replica& replica) {
+            return Replica::fn_is_in_memory(replica) &&
+                   replica.is_completed() && replica.get_refcnt() == 0;
         });
+        const size_t num_evicted = evicted.size();
+        AppendReplicas(reclaimed, std::move(evicted));
+        metadata.OnMemoryReplicasEvicted(num_evicted);
+        PersistEvict(key, metadata);
+        OnObjectEvicted(key, metadata);
+        return num_evicted;
     };
 
+    // SIEVE and S3FIFO skip the objects read since the hand last passed
+    // them in the first pass, and age them instead.
+    auto has_second_chance = [this](const EvictionRank& rank) {
+        switch (eviction_policy_) {
+            case EvictionPolicy::SIEVE:
+                return rank.first > 0;
+            case EvictionPolicy::S3FIFO:
+                return rank.first > 1;
+            default:
+                return false;
+        }
+    };
+    // Objects in the small and main queues of S3FIFO
+    size_t s3fifo_small_count = 0;
+    size_t s3fifo_total_count = 0;
+
     // Randomly select a starting shard to avoid imbalance eviction between
     // shards. No need to use expensive random_device here.
     size_t start_idx = rand() % kNumShards;
@@ -1789,28 +4068,38 @@ void MasterService::BatchEvict(double evict_ratio_target,
         const long ideal_evict_num =
             std::ceil(object_count * evict_ratio_target) - evicted_count;
 
-        std::vector<std::chrono::steady_clock::time_point>
-            candidates;  // can be removed
+        std::vector<EvictionRank> candidates;  // can be removed
+        // Spared by the eviction policy, aged after this pass
+        std::vector<ObjectMetadata*> second_chances;
         for (auto it = shard->metadata.begin(); it != shard->metadata.end();
              it++) {
+            if (ghost_queue_) {
+                s3fifo_small_count += it->second.InMainQueue() ? 0 : 1;
+                s3fifo_total_count++;
+            }
             // Skip objects that are not expired or have incomplete replicas
             if (!it->second.IsLeaseExpired(now) ||
                 !can_evict_replicas(it->second)) {
                 continue;
             }
+            const EvictionRank rank = GetEvictionRank(it->first, it->second);
             if (!it->second.IsSoftPinned(now)) {
-                if (ideal_evict_num > 0) {
+                if (ideal_evict_num > 0 && !has_second_chance(rank)) {
                     // first pass candidates
-                    candidates.push_back(it->second.lease_timeout);
+                    candidates.push_back(rank);
+                } else if (ideal_evict_num > 0) {
+                    // Second pass candidates, metadata entries never move
+                    second_chances.push_back(&it->second);
+                    no_pin_objects.push_back(rank);
                 } else {
                     // No need to evict any object in this shard, put to
                     // second pass candidates
-                    no_pin_objects.push_back(it->second.lease_timeout);
+                    no_pin_objects.push_back(rank);
                 }
             } else if (allow_evict_soft_pinned_objects_) {
                 // second pass candidates, only if
                 // allow_evict_soft_pinned_objects_ is true
-                soft_pin_objects.push_back(it->second.lease_timeout);
+                soft_pin_objects.push_back(rank);
             }
         }
 
@@ -1821,8 +4110,8 @@ void MasterService::BatchEvict(double evict_ratio_target,
             std::nth_element(candidates.begin(),
                              candidates.begin() + (evict_num - 1),
                              candidates.end());
-            auto target_timeout = candidates[evict_num - 1];
-            // Evict objects with lease timeout less than or equal to target.
+            const EvictionRank target_rank = candidates[evict_num - 1];
+            // Evict objects with rank less than or equal to target.
             auto it = shard->metadata.begin();
             while (it != shard->metadata.end()) {
                 // Skip objects that are not allowed to be evicted in the first
@@ -1833,11 +4122,18 @@ void MasterService::BatchEvict(double evict_ratio_target,
                     ++it;
                     continue;
                 }
-                if (it->second.lease_timeout <= target_timeout) {
+                const EvictionRank rank =
+                    GetEvictionRank(it->first, it->second);
+                if (has_second_chance(rank)) {
+                    ++it;  // already a second pass candidate
+                    continue;
+                }
+                if (rank <= target_rank) {
                     // Evict this object
                     total_freed_size +=
                         it->second.size *
-                        evict_replicas(it->second);  // Erase memory replicas
+                        evict_replicas(it->first,
+                                       it->second);  // Erase memory replicas
                     if (it->second.IsValid() == false) {
                         it = shard->metadata.erase(it);
                     } else {
@@ -1845,13 +4141,33 @@ void MasterService::BatchEvict(double evict_ratio_target,
                     }
                     shard_evicted_count++;
                 } else {
+                    // Let the popularity of surviving objects fade, or they
+                    // would outrank new objects forever
+                    if (eviction_policy_ == EvictionPolicy::COST_AWARE) {
+                        it->second.DecayAccessFreq(false);
+                    }
                     // second pass candidates
-                    no_pin_objects.push_back(it->second.lease_timeout);
+                    no_pin_objects.push_back(rank);
                     ++it;
                 }
             }
             evicted_count += shard_evicted_count;
         }
+        for (ObjectMetadata* metadata : second_chances) {
+            if (eviction_policy_ == EvictionPolicy::S3FIFO) {
+                metadata->S3FifoSecondChance();
+            } else {
+                metadata->DecayAccessFreq(/*reset=*/true);
+            }
+        }
+    }
+
+    // S3FIFO evicts from the small queue while it holds more than its share
+    if (ghost_queue_ && s3fifo_total_count > 0) {
+        s3fifo_small_first_.store(
+            s3fifo_small_count * 100 >=
+                s3fifo_total_count * kS3FifoSmallQueuePercent,
+            std::memory_order_relaxed);
     }
 
     // Try releasing discarded replicas before we decide whether to do the
@@ -1881,22 +4197,25 @@ void MasterService::BatchEvict(double evict_ratio_target,
             std::nth_element(no_pin_objects.begin(),
                              no_pin_objects.begin() + (target_evict_num - 1),
                              no_pin_objects.end());
-            auto target_timeout = no_pin_objects[target_evict_num - 1];
+            const EvictionRank target_rank =
+                no_pin_objects[target_evict_num - 1];
 
-            // Evict objects with lease timeout less than or equal to target.
+            // Evict objects with rank less than or equal to target.
             // Stop when the target is reached.
             for (size_t i = 0; i < kNumShards && target_evict_num > 0; i++) {
                 MetadataShardAccessorRW shard(this,
                                               (start_idx + i) % kNumShards);
                 auto it = shard->metadata.begin();
                 while (it != shard->metadata.end() && target_evict_num > 0) {
-                    if (it->second.lease_timeout <= target_timeout &&
-                        !it->second.IsSoftPinned(now) &&
-                        can_evict_replicas(it->second)) {
+                    if (!it->second.IsSoftPinned(now) &&
+                        can_evict_replicas(it->second) &&
+                        GetEvictionRank(it->first, it->second) <=
+                            target_rank) {
                         // Evict this object
                         total_freed_size +=
                             it->second.size *
                             evict_replicas(
+                                it->first,
                                 it->second);  // Erase memory replicas
                         if (it->second.IsValid() == false) {
                             it = shard->metadata.erase(it);
@@ -1918,12 +4237,13 @@ void MasterService::BatchEvict(double evict_ratio_target,
             const long soft_pin_evict_num =
                 target_evict_num - static_cast<long>(no_pin_objects.size());
             // For soft pin objects, prioritize to evict the ones with smaller
-            // lease timeout.
+            // rank.
             std::nth_element(
                 soft_pin_objects.begin(),
                 soft_pin_objects.begin() + (soft_pin_evict_num - 1),
                 soft_pin_objects.end());
-            auto soft_target_timeout = soft_pin_objects[soft_pin_evict_num - 1];
+            const EvictionRank soft_target_rank =
+                soft_pin_objects[soft_pin_evict_num - 1];
 
             // Stop when the target is reached.
             for (size_t i = 0; i < kNumShards && target_evict_num > 0; i++) {
@@ -1940,12 +4260,14 @@ void MasterService::BatchEvict(double evict_ratio_target,
                         continue;
                     }
                     // Evict objects with 1). no soft pin OR 2). with soft pin
-                    // and lease timeout less than or equal to target.
+                    // and rank less than or equal to target.
                     if (!it->second.IsSoftPinned(now) ||
-                        it->second.lease_timeout <= soft_target_timeout) {
+                        GetEvictionRank(it->first, it->second) <=
+                            soft_target_rank) {
                         total_freed_size +=
                             it->second.size *
                             evict_replicas(
+                                it->first,
                                 it->second);  // Erase memory replicas
                         if (it->second.IsValid() == false) {
                             it = shard->metadata.erase(it);
@@ -1973,6 +4295,7 @@ void MasterService::BatchEvict(double evict_ratio_target,
         }
     }
 
+    ReclaimReplicas(std::move(reclaimed));
     if (evicted_count > 0 || released_discarded_cnt > 0) {
         need_eviction_ = false;
         MasterMetricManager::instance().inc_eviction_success(evicted_count,
@@ -1990,52 +4313,31 @@ void MasterService::BatchEvict(double evict_ratio_target,
 }
 
 void MasterService::ClientMonitorFunc() {
-    std::unordered_map<UUID, std::chrono::steady_clock::time_point,
-                       boost::hash<UUID>>
-        client_ttl;
     while (client_monitor_running_) {
         auto now = std::chrono::steady_clock::now();
 
-        // Update the client ttl
-        PodUUID pod_client_id;
-        while (client_ping_queue_.pop(pod_client_id)) {
-            UUID client_id = {pod_client_id.first, pod_client_id.second};
-            client_ttl[client_id] =
-                now + std::chrono::seconds(client_live_ttl_sec_);
-        }
-
-        // Find out expired clients
+        // Record which segments are unmounted, will be used in the commit
+        // phase.
+        std::vector<UUID> unmount_segments;
+        std::vector<size_t> dec_capacities;
+        std::vector<UUID> client_ids;
+        std::vector<std::string> segment_names;
         std::vector<UUID> expired_clients;
-        for (auto it = client_ttl.begin(); it != client_ttl.end();) {
-            if (it->second < now) {
-                LOG(INFO) << "client_id=" << it->first
+        {
+            // Lock client_mutex so that no remount runs between the expiry
+            // of a client and the unmounting of its segments. Only the
+            // leases due since the last check are visited.
+            std::unique_lock<std::shared_mutex> lock(client_mutex_);
+            size_t num_ok = client_leases_.Expire(now, expired_clients);
+            for (size_t i = 0; i < num_ok; i++) {
+                MasterMetricManager::instance().dec_active_clients();
+            }
+            for (auto& client_id : expired_clients) {
+                LOG(INFO) << "client_id=" << client_id
                           << ", action=client_expired";
-                expired_clients.push_back(it->first);
-                it = client_ttl.erase(it);
-            } else {
-                ++it;
             }
-        }
-
-        // Update the client status to NEED_REMOUNT
-        if (!expired_clients.empty()) {
-            // Record which segments are unmounted, will be used in the commit
-            // phase.
-            std::vector<UUID> unmount_segments;
-            std::vector<size_t> dec_capacities;
-            std::vector<UUID> client_ids;
-            std::vector<std::string> segment_names;
-            {
-                // Lock client_mutex and segment_mutex
-                std::unique_lock<std::shared_mutex> lock(client_mutex_);
-                for (auto& client_id : expired_clients) {
-                    auto it = ok_client_.find(client_id);
-                    if (it != ok_client_.end()) {
-                        ok_client_.erase(it);
-                        MasterMetricManager::instance().dec_active_clients();
-                    }
-                }
 
+            if (!expired_clients.empty()) {
                 ScopedSegmentAccess segment_access =
                     segment_manager_.getSegmentAccess();
                 for (auto& client_id : expired_clients) {
@@ -2059,21 +4361,23 @@ void MasterService::ClientMonitorFunc() {
                         }
                     }
                 }
-            }  // Release the mutex before long-running ClearInvalidHandles and
-               // avoid deadlocks
-
-            if (!unmount_segments.empty()) {
-                ClearInvalidHandles();
-
-                ScopedSegmentAccess segment_access =
-                    segment_manager_.getSegmentAccess();
-                for (size_t i = 0; i < unmount_segments.size(); i++) {
-                    segment_access.CommitUnmountSegment(
-                        unmount_segments[i], client_ids[i], dec_capacities[i]);
-                    LOG(INFO) << "client_id=" << client_ids[i]
-                              << ", segment_name=" << segment_names[i]
-                              << ", action=unmount_expired_segment";
-                }
+            }
+        }  // Release the mutex before long-running ClearInvalidHandles and
+           // avoid deadlocks
+
+        if (!unmount_segments.empty()) {
+            ClearInvalidHandles();
+            SyncMetadata();
+
+            ScopedSegmentAccess segment_access =
+                segment_manager_.getSegmentAccess();
+            for (size_t i = 0; i < unmount_segments.size(); i++) {
+                segment_access.CommitUnmountSegment(
+                    unmount_segments[i], client_ids[i], dec_capacities[i]);
+                allocation_strategy_->RemoveSegmentLoad(segment_names[i]);
+                LOG(INFO) << "client_id=" << client_ids[i]
+                          << ", segment_name=" << segment_names[i]
+                          << ", action=unmount_expired_segment";
             }
         }
 
@@ -2118,7 +4422,8 @@ std::string MasterService::ResolvePath(const std::string& key) const {
 }
 
 tl::expected<UUID, ErrorCode> MasterService::CreateCopyTask(
-    const std::string& key, const std::vector<std::string>& targets) {
+    const std::string& key, const std::vector<std::string>& targets,
+    TaskPriority priority) {
     if (targets.empty()) {
         LOG(ERROR) << "key=" << key << ", error=empty_targets";
         return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
@@ -2160,14 +4465,16 @@ tl::expected<UUID, ErrorCode> MasterService::CreateCopyTask(
     }
     return task_manager_.get_write_access()
         .submit_task_typed<TaskType::REPLICA_COPY>(
-            select_client, {.key = key,
-                            .source = selected_source_segment,
-                            .targets = targets});
+            select_client,
+            {.key = key,
+             .source = selected_source_segment,
+             .targets = targets},
+            priority, metadata.size * targets.size());
 }
 
 tl::expected<UUID, ErrorCode> MasterService::CreateMoveTask(
     const std::string& key, const std::string& source,
-    const std::string& target) {
+    const std::string& target, TaskPriority priority) {
     MetadataAccessorRO accessor(this, key);
     if (!accessor.Exists()) {
         VLOG(1) << "key=" << key << ", info=object_not_found";
@@ -2209,7 +4516,8 @@ tl::expected<UUID, ErrorCode> MasterService::CreateMoveTask(
 
     return task_manager_.get_write_access()
         .submit_task_typed<TaskType::REPLICA_MOVE>(
-            select_client, {.key = key, .source = source, .target = target});
+            select_client, {.key = key, .source = source, .target = target},
+            priority, metadata.size);
 }
 
 tl::expected<QueryTaskResponse, ErrorCode> MasterService::QueryTask(
@@ -2247,4 +4555,396 @@ tl::expected<void, ErrorCode> MasterService::MarkTaskToComplete(
     return {};
 }
 
+PersistedObject MasterService::ToPersistedObject(
+    const std::string& key, const ObjectMetadata& metadata) const {
+    PersistedObject object;
+    object.key = key;
+    object.client_id = metadata.client_id;
+    object.size = metadata.size;
+    {
+        SpinLocker locker(&metadata.lock);
+        const auto now = std::chrono::steady_clock::now();
+        object.soft_pin = metadata.soft_pin_timeout.has_value();
+        const auto lease_timeout =
+            metadata.lease_timeout.load(std::memory_order_relaxed);
+        if (lease_timeout > now) {
+            object.lease_remaining_ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    lease_timeout - now)
+                    .count();
+        }
+    }
+
+    metadata.VisitReplicas(
+        &Replica::fn_is_completed, [&object](const Replica& replica) {
+            PersistedReplica persisted;
+            persisted.type = replica.type();
+            auto desc = replica.get_descriptor();
+            if (replica.is_memory_replica()) {
+                auto segment_names = replica.get_segment_names();
+                if (segment_names.empty() || !segment_names[0].has_value()) {
+                    // The segment is gone, nothing to restore
+                    return;
+                }
+                const auto& buffer =
+                    std::get<MemoryDescriptor>(desc.descriptor_variant)
+                        .buffer_descriptor;
+                persisted.segment_name = segment_names[0].value();
+                persisted.buffer_address = buffer.buffer_address_;
+                persisted.size = buffer.size_;
+                persisted.protocol = buffer.protocol_;
+                persisted.transport_endpoint = buffer.transport_endpoint_;
+            } else if (replica.is_disk_replica()) {
+                const auto& disk =
+                    std::get<DiskDescriptor>(desc.descriptor_variant);
+                persisted.file_path = disk.file_path;
+                persisted.size = disk.object_size;
+            } else if (replica.is_local_disk_replica()) {
+                const auto& local_disk =
+                    std::get<LocalDiskDescriptor>(desc.descriptor_variant);
+                persisted.client_id = local_disk.client_id;
+                persisted.transport_endpoint = local_disk.transport_endpoint;
+                persisted.size = local_disk.object_size;
+            } else {
+                // Striped replicas are not persisted
+                return;
+            }
+            object.replicas.push_back(std::move(persisted));
+        });
+    return object;
+}
+
+ErrorCode MasterService::SyncMetadata() {
+    if (!metadata_persistence_) {
+        return ErrorCode::OK;
+    }
+    auto err = metadata_persistence_->Sync();
+    if (err != ErrorCode::OK) {
+        LOG(ERROR) << "error=metadata_sync_failed, reason=" << err;
+    }
+    return err;
+}
+
+void MasterService::PersistPutEnd(const std::string& key,
+                                  const ObjectMetadata& metadata) {
+    if (!metadata_persistence_) {
+        return;
+    }
+    DropPendingRestore(key);
+    auto object = ToPersistedObject(key, metadata);
+    if (object.replicas.empty()) {
+        // Nothing committed, the object is not recoverable
+        metadata_persistence_->AppendRemove(key);
+        return;
+    }
+    metadata_persistence_->AppendPutEnd(std::move(object));
+}
+
+void MasterService::PersistRemove(const std::string& key) {
+    if (!metadata_persistence_) {
+        return;
+    }
+    DropPendingRestore(key);
+    metadata_persistence_->AppendRemove(key);
+}
+
+void MasterService::PersistEvict(const std::string& key,
+                                 const ObjectMetadata& metadata) {
+    if (!metadata_persistence_) {
+        return;
+    }
+    DropPendingRestore(key);
+    std::optional<PersistedObject> remaining;
+    if (metadata.IsValid()) {
+        remaining = ToPersistedObject(key, metadata);
+        if (remaining->replicas.empty()) {
+            remaining.reset();
+        }
+    }
+    metadata_persistence_->AppendEvict(key, std::move(remaining));
+}
+
+void MasterService::DropPendingRestore(const std::string& key) {
+    MutexLocker locker(&pending_restore_mutex_);
+    if (!pending_restore_.empty()) {
+        pending_restore_.erase(key);
+    }
+}
+
+void MasterService::DropPendingRestoreOnSegment(
+    const std::string& segment_name) {
+    MutexLocker locker(&pending_restore_mutex_);
+    auto keys_it = pending_restore_by_segment_.find(segment_name);
+    if (keys_it == pending_restore_by_segment_.end()) {
+        return;
+    }
+    size_t dropped_num = 0;
+    for (const auto& key : keys_it->second) {
+        auto it = pending_restore_.find(key);
+        if (it == pending_restore_.end()) {
+            continue;
+        }
+        auto& replicas = it->second.replicas;
+        const auto old_size = replicas.size();
+        replicas.erase(std::remove_if(replicas.begin(), replicas.end(),
+                                      [&](const PersistedReplica& replica) {
+                                          return replica.segment_name ==
+                                                 segment_name;
+                                      }),
+                       replicas.end());
+        dropped_num += old_size - replicas.size();
+        if (replicas.empty()) {
+            pending_restore_.erase(it);
+        }
+    }
+    pending_restore_by_segment_.erase(keys_it);
+    LOG(INFO) << "segment_name=" << segment_name
+              << ", action=drop_pending_replicas, count=" << dropped_num;
+}
+
+void MasterService::RestoreMetadata(std::vector<PersistedObject>&& objects) {
+    size_t restored_num = 0;
+    size_t pending_num = 0;
+    for (auto& object : objects) {
+        std::vector<Replica> replicas;
+        PersistedObject pending = object;
+        pending.replicas.clear();
+        for (auto& persisted : object.replicas) {
+            switch (persisted.type) {
+                case ReplicaType::MEMORY:
+                    pending.replicas.push_back(std::move(persisted));
+                    break;
+                case ReplicaType::DISK:
+                    replicas.emplace_back(std::move(persisted.file_path),
+                                          persisted.size,
+                                          ReplicaStatus::COMPLETE);
+                    MasterMetricManager::instance().inc_file_cache_nums();
+                    break;
+                case ReplicaType::LOCAL_DISK:
+                    replicas.emplace_back(
+                        persisted.client_id, persisted.size,
+                        std::move(persisted.transport_endpoint),
+                        ReplicaStatus::COMPLETE);
+                    break;
+                default:
+                    LOG(WARNING) << "key=" << object.key
+                                 << ", warn=unknown_persisted_replica_type";
+                    break;
+            }
+        }
+
+        if (!replicas.empty()) {
+            MetadataAccessorRW accessor(this, object.key);
+            accessor.Create(object.client_id, object.size, std::move(replicas),
+                            object.soft_pin);
+            accessor.Get().GrantLease(object.lease_remaining_ms,
+                                      default_kv_soft_pin_ttl_);
+            restored_num++;
+        }
+
+        if (!pending.replicas.empty()) {
+            MutexLocker locker(&pending_restore_mutex_);
+            for (const auto& persisted : pending.replicas) {
+                auto& keys =
+                    pending_restore_by_segment_[persisted.segment_name];
+                if (keys.empty() || keys.back() != object.key) {
+                    keys.push_back(object.key);
+                }
+            }
+            pending_restore_.emplace(object.key, std::move(pending));
+            pending_num++;
+        }
+    }
+    LOG(INFO) << "action=restore_metadata, restored_objects=" << restored_num
+              << ", objects_waiting_for_segments=" << pending_num;
+}
+
+void MasterService::RestorePendingReplicas(
+    const std::vector<std::string>& segment_names) {
+    std::vector<std::string> keys;
+    {
+        MutexLocker locker(&pending_restore_mutex_);
+        if (pending_restore_.empty()) {
+            return;
+        }
+        for (const auto& name : segment_names) {
+            auto it = pending_restore_by_segment_.find(name);
+            if (it != pending_restore_by_segment_.end()) {
+                keys.insert(keys.end(), it->second.begin(), it->second.end());
+                pending_restore_by_segment_.erase(it);
+            }
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    const auto on_segments = [&segment_names](const PersistedReplica& replica) {
+        return std::find(segment_names.begin(), segment_names.end(),
+                         replica.segment_name) != segment_names.end();
+    };
+
+    size_t restored_num = 0;
+    for (const auto& key : keys) {
+        MetadataAccessorRW accessor(this, key);
+
+        // Take the replicas on these segments out of the pending set
+        PersistedObject object;
+        {
+            MutexLocker locker(&pending_restore_mutex_);
+            auto it = pending_restore_.find(key);
+            if (it == pending_restore_.end()) {
+                // The key is mutated after the master restarted
+                continue;
+            }
+            auto& pending_replicas = it->second.replicas;
+            auto partition_point =
+                std::partition(pending_replicas.begin(), pending_replicas.end(),
+                               [&](const PersistedReplica& replica) {
+                                   return !on_segments(replica);
+                               });
+            object.key = key;
+            object.client_id = it->second.client_id;
+            object.size = it->second.size;
+            object.soft_pin = it->second.soft_pin;
+            object.lease_remaining_ms = it->second.lease_remaining_ms;
+            std::move(partition_point, pending_replicas.end(),
+                      std::back_inserter(object.replicas));
+            pending_replicas.erase(partition_point, pending_replicas.end());
+            if (pending_replicas.empty()) {
+                pending_restore_.erase(it);
+            }
+        }
+
+        // The key is being written again, the old content is obsolete
+        if (accessor.InProcessing() || accessor.HasReplicationTask() ||
+            (accessor.Exists() && accessor.Get().size != object.size)) {
+            continue;
+        }
+
+        std::vector<Replica> replicas;
+        {
+            ScopedAllocatorAccess allocator_access =
+                segment_manager_.getAllocatorAccess();
+            const auto& allocator_manager =
+                allocator_access.getAllocatorManager();
+            for (const auto& persisted : object.replicas) {
+                const auto allocators =
+                    allocator_manager.getAllocators(persisted.segment_name);
+                std::unique_ptr<AllocatedBuffer> buffer;
+                if (allocators != nullptr) {
+                    for (const auto& allocator : *allocators) {
+                        buffer = allocator->reserve(persisted.buffer_address,
+                                                    persisted.size);
+                        if (buffer) {
+                            break;
+                        }
+                    }
+                }
+                if (!buffer) {
+                    LOG(WARNING) << "key=" << key
+                                 << ", segment_name=" << persisted.segment_name
+                                 << ", buffer_address="
+                                 << persisted.buffer_address
+                                 << ", warn=failed_to_reserve_buffer";
+                    continue;
+                }
+                replicas.emplace_back(std::move(buffer),
+                                      ReplicaStatus::COMPLETE);
+                MasterMetricManager::instance().inc_mem_cache_nums();
+            }
+        }
+        if (replicas.empty()) {
+            continue;
+        }
+
+        if (accessor.Exists()) {
+            accessor.Get().AddReplicas(std::move(replicas));
+        } else {
+            accessor.Create(object.client_id, object.size, std::move(replicas),
+                            object.soft_pin);
+        }
+        accessor.Get().GrantLease(object.lease_remaining_ms,
+                                  default_kv_soft_pin_ttl_);
+        restored_num++;
+    }
+    if (restored_num > 0) {
+        LOG(INFO) << "action=restore_pending_replicas, restored_objects="
+                  << restored_num;
+    }
+}
+
+ErrorCode MasterService::WriteMetadataSnapshot() {
+    // Records appended after the rotation are replayed on top of the
+    // snapshot, so objects mutated during the scan are still consistent.
+    const uint64_t last_sequence = metadata_persistence_->RotateWal();
+
+    std::unordered_map<std::string, PersistedObject> pending;
+    {
+        MutexLocker locker(&pending_restore_mutex_);
+        pending = pending_restore_;
+    }
+
+    std::vector<PersistedObject> objects;
+    std::unordered_map<std::string, size_t> object_index;
+    for (size_t i = 0; i < kNumShards; i++) {
+        MetadataShardAccessorRO shard(this, i);
+        for (const auto& [key, metadata] : shard->metadata) {
+            auto object = ToPersistedObject(key, metadata);
+            if (object.replicas.empty()) {
+                continue;
+            }
+            object_index.emplace(key, objects.size());
+            objects.push_back(std::move(object));
+        }
+    }
+
+    // Keep the replicas that are not restored yet
+    for (auto& [key, object] : pending) {
+        auto it = object_index.find(key);
+        if (it == object_index.end()) {
+            objects.push_back(std::move(object));
+            continue;
+        }
+        auto& replicas = objects[it->second].replicas;
+        for (auto& persisted : object.replicas) {
+            bool duplicated = std::any_of(
+                replicas.begin(), replicas.end(),
+                [&persisted](const PersistedReplica& replica) {
+                    return replica.type == ReplicaType::MEMORY &&
+                           replica.segment_name == persisted.segment_name &&
+                           replica.buffer_address == persisted.buffer_address;
+                });
+            if (!duplicated) {
+                replicas.push_back(std::move(persisted));
+            }
+        }
+    }
+
+    return metadata_persistence_->WriteSnapshot(last_sequence,
+                                                std::move(objects));
+}
+
+void MasterService::MetadataSnapshotThreadFunc() {
+    LOG(INFO) << "Metadata snapshot thread started";
+    while (metadata_snapshot_running_) {
+        {
+            std::unique_lock<std::mutex> lk(metadata_snapshot_mutex_);
+            metadata_snapshot_cv_.wait_for(
+                lk, std::chrono::seconds(metadata_snapshot_interval_sec_),
+                [&] { return !metadata_snapshot_running_.load(); });
+        }
+
+        if (!metadata_snapshot_running_) {
+            break;
+        }
+
+        auto err = WriteMetadataSnapshot();
+        if (err != ErrorCode::OK) {
+            LOG(ERROR) << "error=failed_to_write_metadata_snapshot, code="
+                       << err;
+        }
+    }
+    LOG(INFO) << "Metadata snapshot thread stopped";
+}
+
 }  // namespace mooncake
@@ -0,0 +1,65 @@
+#include "master_shard_ring.h"
+
+#include <algorithm>
+
+namespace mooncake {
+
+MasterShardRing::MasterShardRing(const std::vector<std::string>& masters)
+    : num_masters_(masters.size()) {
+    points_.reserve(masters.size() * kVirtualNodes);
+    for (size_t i = 0; i < masters.size(); i++) {
+        for (size_t v = 0; v < kVirtualNodes; v++) {
+            points_.emplace_back(Hash(masters[i] + "#" + std::to_string(v)),
+                                 i);
+        }
+    }
+    std::sort(points_.begin(), points_.end());
+}
+
+size_t MasterShardRing::ShardOf(std::string_view key) const {
+    if (num_masters_ <= 1) {
+        return 0;
+    }
+    const uint64_t hash = Hash(key);
+    auto it = std::lower_bound(
+        points_.begin(), points_.end(), hash,
+        [](const auto& point, uint64_t value) { return point.first < value; });
+    if (it == points_.end()) {
+        it = points_.begin();  // wrap around
+    }
+    return it->second;
+}
+
+std::vector<std::string> MasterShardRing::ParseMasters(
+    const std::string& entry) {
+    std::vector<std::string> masters;
+    size_t begin = 0;
+    while (begin <= entry.size()) {
+        size_t end = entry.find(',', begin);
+        if (end == std::string::npos) {
+            end = entry.size();
+        }
+        if (end > begin) {
+            masters.push_back(entry.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return masters;
+}
+
+uint64_t MasterShardRing::Hash(std::string_view data) {
+    // FNV-1a, then a finalizer to spread the nearby inputs of virtual nodes
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+}  // namespace mooncake
@@ -0,0 +1,138 @@
+#include "metadata_follower.h"
+
+#include <glog/logging.h>
+
+#include <chrono>
+
+namespace mooncake {
+
+MetadataFollower::MetadataFollower(std::string persist_dir)
+    : persist_dir_(std::move(persist_dir)) {}
+
+MetadataFollower::~MetadataFollower() {
+    tail_running_ = false;
+    tail_cv_.notify_all();
+    if (tail_thread_.joinable()) {
+        tail_thread_.join();
+    }
+}
+
+void MetadataFollower::Start() {
+    tail_running_ = true;
+    tail_thread_ = std::thread(&MetadataFollower::TailThreadFunc, this);
+    VLOG(1) << "action=start_metadata_follower_thread, persist_dir="
+            << persist_dir_;
+}
+
+void MetadataFollower::TailThreadFunc() {
+    LOG(INFO) << "Metadata follower thread started";
+    while (tail_running_) {
+        auto err = CatchUp();
+        if (err != ErrorCode::OK) {
+            // Retry on the next round, e.g. the segment being read has just
+            // been compacted into a snapshot.
+            LOG(WARNING) << "persist_dir=" << persist_dir_
+                         << ", warn=failed_to_catch_up, error=" << err;
+        }
+
+        std::unique_lock<std::mutex> lk(tail_mutex_);
+        tail_cv_.wait_for(lk, std::chrono::milliseconds(kTailIntervalMs),
+                          [&] { return !tail_running_.load(); });
+    }
+    LOG(INFO) << "Metadata follower thread stopped";
+}
+
+ErrorCode MetadataFollower::CatchUp() {
+    SharedMutexLocker lock(&mutex_);
+    if (detached_) {
+        return ErrorCode::OK;
+    }
+    size_t replayed = 0;
+    auto err = MetadataPersistence::CatchUp(persist_dir_, state_, &replayed);
+    if (replayed > 0) {
+        VLOG(1) << "action=follow_metadata, replayed_wal_records=" << replayed
+                << ", last_sequence=" << state_.last_sequence;
+    }
+    return err;
+}
+
+MetadataReplayState MetadataFollower::Detach() {
+    tail_running_ = false;
+    tail_cv_.notify_all();
+    if (tail_thread_.joinable()) {
+        tail_thread_.join();
+    }
+
+    SharedMutexLocker lock(&mutex_);
+    detached_ = true;
+    LOG(INFO) << "action=detach_metadata_follower, objects="
+              << state_.objects.size()
+              << ", last_sequence=" << state_.last_sequence;
+    return std::move(state_);
+}
+
+tl::expected<bool, ErrorCode> MetadataFollower::ExistKey(
+    const std::string& key) const {
+    SharedMutexLocker lock(&mutex_, shared_lock);
+    if (detached_) {
+        return tl::make_unexpected(ErrorCode::UNAVAILABLE_IN_CURRENT_STATUS);
+    }
+    return state_.objects.contains(key);
+}
+
+std::vector<tl::expected<bool, ErrorCode>> MetadataFollower::BatchExistKey(
+    const std::vector<std::string>& keys) const {
+    std::vector<tl::expected<bool, ErrorCode>> results;
+    results.reserve(keys.size());
+    SharedMutexLocker lock(&mutex_, shared_lock);
+    for (const auto& key : keys) {
+        if (detached_) {
+            results.emplace_back(
+                tl::make_unexpected(ErrorCode::UNAVAILABLE_IN_CURRENT_STATUS));
+        } else {
+            results.emplace_back(state_.objects.contains(key));
+        }
+    }
+    return results;
+}
+
+tl::expected<GetReplicaListResponse, ErrorCode>
+MetadataFollower::GetReplicaList(const std::string& key) const {
+    SharedMutexLocker lock(&mutex_, shared_lock);
+    if (detached_) {
+        return tl::make_unexpected(ErrorCode::UNAVAILABLE_IN_CURRENT_STATUS);
+    }
+    auto it = state_.objects.find(key);
+    if (it == state_.objects.end()) {
+        VLOG(1) << "key=" << key << ", info=object_not_found";
+        return tl::make_unexpected(ErrorCode::OBJECT_NOT_FOUND);
+    }
+
+    // Only disk replicas are returned: the standby cannot take a lease on
+    // the leader, which may evict a memory replica while the client reads it
+    std::vector<Replica::Descriptor> replica_list;
+    for (const auto& persisted : it->second.replicas) {
+        if (persisted.type != ReplicaType::DISK) {
+            continue;
+        }
+        Replica::Descriptor desc;
+        desc.id = 0;
+        desc.status = ReplicaStatus::COMPLETE;
+        DiskDescriptor disk_desc;
+        disk_desc.file_path = persisted.file_path;
+        disk_desc.object_size = persisted.size;
+        desc.descriptor_variant = std::move(disk_desc);
+        replica_list.push_back(std::move(desc));
+    }
+    if (replica_list.empty()) {
+        return tl::make_unexpected(ErrorCode::REPLICA_IS_NOT_READY);
+    }
+    return GetReplicaListResponse(std::move(replica_list), 0);
+}
+
+uint64_t MetadataFollower::last_sequence() const {
+    SharedMutexLocker lock(&mutex_, shared_lock);
+    return state_.last_sequence;
+}
+
+}  // namespace mooncake
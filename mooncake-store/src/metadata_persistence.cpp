@@ -0,0 +1,480 @@
+#include "metadata_persistence.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#include "serializer.h"
+
+namespace mooncake {
+
+namespace {
+
+constexpr const char* kSnapshotFileName = "metadata.snapshot";
+constexpr const char* kWalFilePrefix = "metadata.wal.";
+
+constexpr std::array<uint32_t, 256> MakeCrc32Table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 1) ? (0xEDB88320u ^ (crc >> 1)) : (crc >> 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr auto kCrc32Table = MakeCrc32Table();
+
+// Read a file from the given offset to its end into memory. Returns false if
+// the file cannot be read.
+bool ReadFile(const std::string& path, uint64_t offset,
+              std::vector<SerializedByte>& buffer) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    auto size = file.tellg();
+    if (size < 0 || static_cast<uint64_t>(size) < offset) {
+        return false;
+    }
+    buffer.resize(static_cast<size_t>(size) - offset);
+    file.seekg(offset, std::ios::beg);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(buffer.data()),
+                                       buffer.size()));
+}
+
+bool WriteAndSync(std::FILE* file, const void* data, size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+        return false;
+    }
+    return std::fflush(file) == 0 && ::fsync(::fileno(file)) == 0;
+}
+
+void ApplyRecord(std::unordered_map<std::string, PersistedObject>& objects,
+                 MetadataWalRecord& record) {
+    switch (record.op) {
+        case MetadataWalOp::PUT_END:
+            if (record.object) {
+                objects[record.key] = std::move(*record.object);
+            }
+            break;
+        case MetadataWalOp::REMOVE:
+            objects.erase(record.key);
+            break;
+        case MetadataWalOp::EVICT:
+            if (record.object) {
+                objects[record.key] = std::move(*record.object);
+            } else {
+                objects.erase(record.key);
+            }
+            break;
+        default:
+            LOG(WARNING) << "sequence=" << record.sequence
+                         << ", warn=unknown_wal_op, op="
+                         << static_cast<int>(record.op);
+            break;
+    }
+}
+
+}  // namespace
+
+uint32_t Crc32(const void* data, size_t size, uint32_t crc) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    crc ^= 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = kCrc32Table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+MetadataPersistence::MetadataPersistence(std::string persist_dir)
+    : persist_dir_(std::move(persist_dir)) {}
+
+MetadataPersistence::~MetadataPersistence() {
+    // Records appended without a Sync
+    Sync();
+    MutexLocker lock(&wal_mutex_);
+    if (wal_file_) {
+        std::fclose(wal_file_);
+        wal_file_ = nullptr;
+    }
+}
+
+std::string MetadataPersistence::SnapshotPath(
+    const std::string& persist_dir) {
+    return (std::filesystem::path(persist_dir) / kSnapshotFileName).string();
+}
+
+std::vector<std::pair<uint64_t, std::string>>
+MetadataPersistence::ListWalSegments(const std::string& persist_dir) {
+    std::vector<std::pair<uint64_t, std::string>> segments;
+    std::error_code ec;
+    for (const auto& entry :
+         std::filesystem::directory_iterator(persist_dir, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind(kWalFilePrefix, 0) != 0) {
+            continue;
+        }
+        try {
+            uint64_t first_sequence =
+                std::stoull(name.substr(std::strlen(kWalFilePrefix)));
+            segments.emplace_back(first_sequence, entry.path().string());
+        } catch (const std::exception&) {
+            LOG(WARNING) << "file=" << name << ", warn=unrecognized_wal_file";
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+ErrorCode MetadataPersistence::LoadSnapshot(const std::string& persist_dir,
+                                            MetadataReplayState& state) {
+    state = MetadataReplayState();
+    state.initialized = true;
+
+    // The snapshot is written via rename, so a broken one means the directory
+    // was tampered with; refuse to continue rather than silently dropping all
+    // metadata.
+    const std::string path = SnapshotPath(persist_dir);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return ErrorCode::OK;
+    }
+    std::vector<SerializedByte> buffer;
+    if (!ReadFile(path, 0, buffer) || buffer.size() < sizeof(uint32_t)) {
+        LOG(ERROR) << "path=" << path << ", error=failed_to_read_snapshot";
+        return ErrorCode::FILE_READ_FAIL;
+    }
+    uint32_t expected_crc;
+    std::memcpy(&expected_crc, buffer.data() + buffer.size() - 4, 4);
+    buffer.resize(buffer.size() - 4);
+    if (Crc32(buffer.data(), buffer.size()) != expected_crc) {
+        LOG(ERROR) << "path=" << path << ", error=snapshot_checksum_mismatch";
+        return ErrorCode::FILE_INVALID_BUFFER;
+    }
+    auto snapshot = deserialize_from<MetadataSnapshot>(buffer);
+    if (!snapshot) {
+        LOG(ERROR) << "path=" << path
+                   << ", error=failed_to_deserialize_snapshot";
+        return ErrorCode::FILE_INVALID_BUFFER;
+    }
+    state.last_sequence = snapshot->last_sequence;
+    state.objects.reserve(snapshot->objects.size());
+    for (auto& object : snapshot->objects) {
+        std::string key = object.key;
+        state.objects.emplace(std::move(key), std::move(object));
+    }
+    return ErrorCode::OK;
+}
+
+ErrorCode MetadataPersistence::CatchUp(const std::string& persist_dir,
+                                       MetadataReplayState& state,
+                                       size_t* replayed) {
+    size_t replayed_num = 0;
+    auto segments = ListWalSegments(persist_dir);
+
+    // 1. Find where to continue. If the segment being replayed is gone and
+    // the next one does not follow it directly, the records in between only
+    // exist in a newer snapshot.
+    auto it = std::lower_bound(
+        segments.begin(), segments.end(),
+        std::make_pair(state.segment_first_sequence, std::string()));
+    const bool segment_lost =
+        state.initialized && state.segment_first_sequence != 0 &&
+        (it == segments.end() || it->first != state.segment_first_sequence);
+    if (!state.initialized ||
+        (segment_lost &&
+         (it == segments.end() || it->first > state.last_sequence + 1))) {
+        auto err = LoadSnapshot(persist_dir, state);
+        if (err != ErrorCode::OK) {
+            return err;
+        }
+        segments = ListWalSegments(persist_dir);
+        it = segments.begin();
+    }
+
+    // 2. Replay the WAL segments in order. A torn or corrupted record ends
+    // the segment it belongs to.
+    std::vector<SerializedByte> buffer;
+    for (; it != segments.end(); ++it) {
+        const auto& [first_sequence, path] = *it;
+        const bool is_last = std::next(it) == segments.end();
+        const uint64_t start = first_sequence == state.segment_first_sequence
+                                   ? state.segment_offset
+                                   : 0;
+        if (!ReadFile(path, start, buffer)) {
+            LOG(ERROR) << "path=" << path << ", error=failed_to_read_wal";
+            return ErrorCode::FILE_READ_FAIL;
+        }
+        size_t offset = 0;
+        while (offset + 2 * sizeof(uint32_t) <= buffer.size()) {
+            uint32_t length, crc;
+            std::memcpy(&length, buffer.data() + offset, sizeof(length));
+            std::memcpy(&crc, buffer.data() + offset + 4, sizeof(crc));
+            const size_t payload_offset = offset + 2 * sizeof(uint32_t);
+            if (payload_offset + length > buffer.size() ||
+                Crc32(buffer.data() + payload_offset, length) != crc) {
+                break;
+            }
+            std::vector<SerializedByte> payload(
+                buffer.begin() + payload_offset,
+                buffer.begin() + payload_offset + length);
+            auto record = deserialize_from<MetadataWalRecord>(payload);
+            if (!record) {
+                break;
+            }
+            offset = payload_offset + length;
+            if (record->sequence <= state.last_sequence) {
+                continue;  // already covered by the snapshot
+            }
+            ApplyRecord(state.objects, *record);
+            state.last_sequence = record->sequence;
+            replayed_num++;
+        }
+        if (offset < buffer.size() && !is_last) {
+            LOG(WARNING) << "path=" << path << ", offset=" << start + offset
+                         << ", warn=truncated_or_corrupted_wal_tail";
+        }
+        state.segment_first_sequence = first_sequence;
+        state.segment_offset = start + offset;
+    }
+
+    if (replayed) {
+        *replayed = replayed_num;
+    }
+    return ErrorCode::OK;
+}
+
+auto MetadataPersistence::Load(MetadataReplayState state)
+    -> tl::expected<std::vector<PersistedObject>, ErrorCode> {
+    std::error_code ec;
+    std::filesystem::create_directories(persist_dir_, ec);
+    if (ec) {
+        LOG(ERROR) << "persist_dir=" << persist_dir_
+                   << ", error=failed_to_create_directory, reason="
+                   << ec.message();
+        return tl::make_unexpected(ErrorCode::FILE_OPEN_FAIL);
+    }
+
+    const size_t preloaded_objects = state.objects.size();
+    size_t replayed = 0;
+    auto err = CatchUp(persist_dir_, state, &replayed);
+    if (err != ErrorCode::OK) {
+        return tl::make_unexpected(err);
+    }
+
+    {
+        std::lock_guard pending_lock(pending_mutex_);
+        next_sequence_ = state.last_sequence + 1;
+        synced_sequence_ = state.last_sequence;
+        MutexLocker lock(&wal_mutex_);
+        err = OpenWalSegment(next_sequence_);
+        if (err != ErrorCode::OK) {
+            return tl::make_unexpected(err);
+        }
+    }
+
+    LOG(INFO) << "persist_dir=" << persist_dir_
+              << ", preloaded_objects=" << preloaded_objects
+              << ", replayed_wal_records=" << replayed
+              << ", restored_objects=" << state.objects.size()
+              << ", last_sequence=" << state.last_sequence;
+
+    std::vector<PersistedObject> result;
+    result.reserve(state.objects.size());
+    for (auto& [key, object] : state.objects) {
+        result.push_back(std::move(object));
+    }
+    return result;
+}
+
+ErrorCode MetadataPersistence::OpenWalSegment(uint64_t first_sequence) {
+    if (wal_file_) {
+        std::fclose(wal_file_);
+        wal_file_ = nullptr;
+    }
+    auto path = (std::filesystem::path(persist_dir_) /
+                 (kWalFilePrefix + std::to_string(first_sequence)))
+                    .string();
+    // A fresh segment never holds valid records: any earlier file with the
+    // same name only contains a torn tail.
+    wal_file_ = std::fopen(path.c_str(), "wb");
+    if (!wal_file_) {
+        LOG(ERROR) << "path=" << path << ", error=failed_to_open_wal";
+        return ErrorCode::FILE_OPEN_FAIL;
+    }
+    wal_file_first_sequence_ = first_sequence;
+    return ErrorCode::OK;
+}
+
+ErrorCode MetadataPersistence::Append(MetadataWalRecord& record) {
+    // Serialized before the sequence number is known, which is the first
+    // field of the payload
+    record.sequence = 0;
+    std::vector<SerializedByte> payload;
+    auto err = serialize_to(record, payload);
+    if (err != ErrorCode::OK) {
+        return err;
+    }
+
+    std::lock_guard lock(pending_mutex_);
+    if (wal_error_ != ErrorCode::OK) {
+        return wal_error_;
+    }
+    record.sequence = next_sequence_;
+    std::memcpy(payload.data(), &record.sequence, sizeof(record.sequence));
+    uint32_t header[2] = {static_cast<uint32_t>(payload.size()),
+                          Crc32(payload.data(), payload.size())};
+    const auto* header_bytes = reinterpret_cast<const SerializedByte*>(header);
+    pending_.insert(pending_.end(), header_bytes,
+                    header_bytes + sizeof(header));
+    pending_.insert(pending_.end(), payload.begin(), payload.end());
+    next_sequence_++;
+    return ErrorCode::OK;
+}
+
+ErrorCode MetadataPersistence::Sync() {
+    std::unique_lock lock(pending_mutex_);
+    const uint64_t sequence = next_sequence_ - 1;
+    while (synced_sequence_ < sequence && wal_error_ == ErrorCode::OK) {
+        if (flushing_) {
+            // Waits for the running flush, then writes what it missed
+            flushed_cv_.wait(lock);
+        } else {
+            Flush(lock, false);
+        }
+    }
+    return wal_error_;
+}
+
+void MetadataPersistence::Flush(std::unique_lock<std::mutex>& lock,
+                                bool rotate) {
+    flushing_ = true;
+    std::vector<SerializedByte> batch;
+    batch.swap(pending_);
+    const uint64_t last_sequence = next_sequence_ - 1;
+    lock.unlock();
+
+    ErrorCode err = ErrorCode::OK;
+    {
+        MutexLocker file_lock(&wal_mutex_);
+        if (!wal_file_) {
+            // Not loaded yet
+            if (!batch.empty()) {
+                err = ErrorCode::FILE_INVALID_HANDLE;
+            }
+        } else if (!WriteAndSync(wal_file_, batch.data(), batch.size())) {
+            LOG(ERROR) << "last_sequence=" << last_sequence
+                       << ", error=failed_to_append_wal";
+            err = ErrorCode::FILE_WRITE_FAIL;
+        } else if (rotate && last_sequence + 1 != wal_file_first_sequence_) {
+            err = OpenWalSegment(last_sequence + 1);
+        }
+    }
+
+    lock.lock();
+    flushing_ = false;
+    synced_sequence_ = last_sequence;
+    if (err != ErrorCode::OK) {
+        wal_error_ = err;
+    }
+    flushed_cv_.notify_all();
+}
+
+ErrorCode MetadataPersistence::AppendPutEnd(PersistedObject object) {
+    MetadataWalRecord record;
+    record.op = MetadataWalOp::PUT_END;
+    record.key = object.key;
+    record.object = std::move(object);
+    return Append(record);
+}
+
+ErrorCode MetadataPersistence::AppendRemove(const std::string& key) {
+    MetadataWalRecord record;
+    record.op = MetadataWalOp::REMOVE;
+    record.key = key;
+    return Append(record);
+}
+
+ErrorCode MetadataPersistence::AppendEvict(
+    const std::string& key, std::optional<PersistedObject> remaining) {
+    MetadataWalRecord record;
+    record.op = MetadataWalOp::EVICT;
+    record.key = key;
+    record.object = std::move(remaining);
+    return Append(record);
+}
+
+uint64_t MetadataPersistence::RotateWal() {
+    std::unique_lock lock(pending_mutex_);
+    flushed_cv_.wait(lock, [this] { return !flushing_; });
+    // The buffered records go to the segment being closed
+    Flush(lock, true);
+    return synced_sequence_;
+}
+
+ErrorCode MetadataPersistence::WriteSnapshot(
+    uint64_t last_sequence, std::vector<PersistedObject> objects) {
+    MetadataSnapshot snapshot;
+    snapshot.last_sequence = last_sequence;
+    snapshot.objects = std::move(objects);
+
+    // Serialized in one pass into chunks and written with writev, so large
+    // snapshots need neither a sizing pass nor one contiguous buffer
+    SerializeChunkWriter writer;
+    auto err = serialize_to(snapshot, writer);
+    if (err != ErrorCode::OK) {
+        return err;
+    }
+    uint32_t crc = 0;
+    writer.for_each_chunk([&crc](const void* data, size_t size) {
+        crc = Crc32(data, size, crc);
+    });
+
+    const std::string tmp_path = SnapshotPath(persist_dir_) + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+    if (fd < 0) {
+        LOG(ERROR) << "path=" << tmp_path << ", error=failed_to_open_snapshot";
+        return ErrorCode::FILE_OPEN_FAIL;
+    }
+    bool ok = writer.write_to_fd(fd, &crc, sizeof(crc)) && ::fsync(fd) == 0;
+    ::close(fd);
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmp_path, SnapshotPath(persist_dir_), ec);
+    }
+    if (!ok || ec) {
+        LOG(ERROR) << "path=" << tmp_path
+                   << ", error=failed_to_write_snapshot";
+        std::filesystem::remove(tmp_path, ec);
+        return ErrorCode::FILE_WRITE_FAIL;
+    }
+
+    // Remove WAL segments whose records are all covered by the snapshot,
+    // i.e. every segment followed by one starting at or before
+    // last_sequence + 1.
+    auto segments = ListWalSegments(persist_dir_);
+    for (size_t i = 0; i + 1 < segments.size(); i++) {
+        if (segments[i + 1].first <= last_sequence + 1) {
+            std::filesystem::remove(segments[i].second, ec);
+        }
+    }
+
+    VLOG(1) << "action=metadata_snapshot_written, objects="
+            << snapshot.objects.size()
+            << ", last_sequence=" << last_sequence
+            << ", bytes=" << writer.size();
+    return ErrorCode::OK;
+}
+
+}  // namespace mooncake
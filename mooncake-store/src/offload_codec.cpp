@@ -0,0 +1,247 @@
+#include "offload_codec.h"
+
+#include <glog/logging.h>
+
+#include <cstring>
+#include <limits>
+
+#ifdef STORE_USE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef STORE_USE_LZ4
+#include <lz4.h>
+#endif
+
+#include "utils.h"
+
+namespace mooncake {
+
+class NoneCodec : public OffloadCodec {
+   public:
+    OffloadCodecType type() const override { return OffloadCodecType::kNone; }
+
+    const char* name() const override { return "none"; }
+
+    ErrorCode Decode(const char* src, size_t src_size, char* dst,
+                     size_t dst_size) const override {
+        if (src_size != dst_size) {
+            return ErrorCode::FILE_READ_FAIL;
+        }
+        std::memcpy(dst, src, src_size);
+        return ErrorCode::OK;
+    }
+
+   protected:
+    bool EncodeContiguous(const char*, size_t,
+                          std::vector<char>&) const override {
+        return false;
+    }
+};
+
+#ifdef STORE_USE_ZSTD
+class ZstdCodec : public OffloadCodec {
+   public:
+    ZstdCodec()
+        : level_(GetEnvOr<int>("MOONCAKE_OFFLOAD_CODEC_LEVEL", 1)) {}
+
+    OffloadCodecType type() const override { return OffloadCodecType::kZstd; }
+
+    const char* name() const override { return "zstd"; }
+
+    ErrorCode Decode(const char* src, size_t src_size, char* dst,
+                     size_t dst_size) const override {
+        size_t n = ZSTD_decompress(dst, dst_size, src, src_size);
+        if (ZSTD_isError(n) || n != dst_size) {
+            LOG(ERROR) << "codec=zstd, error=decode_failed, expected="
+                       << dst_size;
+            return ErrorCode::FILE_READ_FAIL;
+        }
+        return ErrorCode::OK;
+    }
+
+   protected:
+    bool EncodeContiguous(const char* src, size_t size,
+                          std::vector<char>& out) const override {
+        out.resize(ZSTD_compressBound(size));
+        size_t n = ZSTD_compress(out.data(), out.size(), src, size, level_);
+        if (ZSTD_isError(n) || n >= size) {
+            return false;
+        }
+        out.resize(n);
+        return true;
+    }
+
+   private:
+    const int level_;
+};
+#endif
+
+#ifdef STORE_USE_LZ4
+class Lz4Codec : public OffloadCodec {
+   public:
+    OffloadCodecType type() const override { return OffloadCodecType::kLz4; }
+
+    const char* name() const override { return "lz4"; }
+
+    ErrorCode Decode(const char* src, size_t src_size, char* dst,
+                     size_t dst_size) const override {
+        if (src_size > static_cast<size_t>(std::numeric_limits<int>::max()) ||
+            dst_size > static_cast<size_t>(std::numeric_limits<int>::max())) {
+            return ErrorCode::FILE_READ_FAIL;
+        }
+        int n = LZ4_decompress_safe(src, dst, static_cast<int>(src_size),
+                                    static_cast<int>(dst_size));
+        if (n < 0 || static_cast<size_t>(n) != dst_size) {
+            LOG(ERROR) << "codec=lz4, error=decode_failed, expected="
+                       << dst_size;
+            return ErrorCode::FILE_READ_FAIL;
+        }
+        return ErrorCode::OK;
+    }
+
+   protected:
+    bool EncodeContiguous(const char* src, size_t size,
+                          std::vector<char>& out) const override {
+        if (size > LZ4_MAX_INPUT_SIZE) {
+            return false;
+        }
+        out.resize(LZ4_compressBound(static_cast<int>(size)));
+        int n = LZ4_compress_default(src, out.data(), static_cast<int>(size),
+                                     static_cast<int>(out.size()));
+        if (n <= 0 || static_cast<size_t>(n) >= size) {
+            return false;
+        }
+        out.resize(n);
+        return true;
+    }
+};
+#endif
+
+class BytePlane16Codec : public OffloadCodec {
+   public:
+    explicit BytePlane16Codec(const OffloadCodec* inner) : inner_(inner) {}
+
+    OffloadCodecType type() const override {
+        return OffloadCodecType::kBytePlane16;
+    }
+
+    const char* name() const override { return "byteplane16"; }
+
+    ErrorCode Decode(const char* src, size_t src_size, char* dst,
+                     size_t dst_size) const override {
+        std::vector<char> planes(dst_size);
+        auto err = inner_->Decode(src, src_size, planes.data(), dst_size);
+        if (err != ErrorCode::OK) {
+            return err;
+        }
+        MergeBytePlanes(planes.data(), dst_size, dst);
+        return ErrorCode::OK;
+    }
+
+   protected:
+    bool EncodeContiguous(const char* src, size_t size,
+                          std::vector<char>& out) const override {
+        std::vector<char> planes(size);
+        SplitBytePlanes(src, size, planes.data());
+        return inner_->EncodeContiguous(planes.data(), size, out);
+    }
+
+   private:
+    const OffloadCodec* const inner_;
+};
+
+bool OffloadCodec::Encode(const std::vector<Slice>& slices, size_t size,
+                          std::vector<char>& out) const {
+    if (size == 0) {
+        return false;
+    }
+    if (slices.size() == 1) {
+        return EncodeContiguous(static_cast<const char*>(slices[0].ptr), size,
+                                out);
+    }
+    std::vector<char> buffer(size);
+    size_t offset = 0;
+    for (const auto& slice : slices) {
+        std::memcpy(buffer.data() + offset, slice.ptr, slice.size);
+        offset += slice.size;
+    }
+    return EncodeContiguous(buffer.data(), size, out);
+}
+
+const OffloadCodec* OffloadCodec::Get(OffloadCodecType type) {
+    static const NoneCodec none;
+#ifdef STORE_USE_ZSTD
+    static const ZstdCodec zstd;
+#endif
+#ifdef STORE_USE_LZ4
+    static const Lz4Codec lz4;
+#endif
+    switch (type) {
+        case OffloadCodecType::kNone:
+            return &none;
+#ifdef STORE_USE_ZSTD
+        case OffloadCodecType::kZstd:
+            return &zstd;
+#endif
+#ifdef STORE_USE_LZ4
+        case OffloadCodecType::kLz4:
+            return &lz4;
+#endif
+        case OffloadCodecType::kBytePlane16: {
+#if defined(STORE_USE_ZSTD)
+            static const BytePlane16Codec byte_plane(&zstd);
+            return &byte_plane;
+#elif defined(STORE_USE_LZ4)
+            static const BytePlane16Codec byte_plane(&lz4);
+            return &byte_plane;
+#else
+            return nullptr;
+#endif
+        }
+        default:
+            return nullptr;
+    }
+}
+
+const OffloadCodec* OffloadCodec::FromName(const std::string& name) {
+    const OffloadCodec* codec = nullptr;
+    if (name == "zstd") {
+        codec = Get(OffloadCodecType::kZstd);
+    } else if (name == "lz4") {
+        codec = Get(OffloadCodecType::kLz4);
+    } else if (name == "byteplane16") {
+        codec = Get(OffloadCodecType::kBytePlane16);
+    }
+    if (codec == nullptr) {
+        if (!name.empty() && name != "none") {
+            LOG(WARNING) << "offload_codec=" << name
+                         << ", error=unsupported_offload_codec, using none";
+        }
+        codec = Get(OffloadCodecType::kNone);
+    }
+    return codec;
+}
+
+void OffloadCodec::SplitBytePlanes(const char* src, size_t size, char* dst) {
+    size_t n = size / 2;
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = src[2 * i];
+        dst[n + i] = src[2 * i + 1];
+    }
+    if (size % 2 != 0) {
+        dst[size - 1] = src[size - 1];
+    }
+}
+
+void OffloadCodec::MergeBytePlanes(const char* src, size_t size, char* dst) {
+    size_t n = size / 2;
+    for (size_t i = 0; i < n; ++i) {
+        dst[2 * i] = src[i];
+        dst[2 * i + 1] = src[n + i];
+    }
+    if (size % 2 != 0) {
+        dst[size - 1] = src[size - 1];
+    }
+}
+
+}  // namespace mooncake
@@ -3,9 +3,13 @@
 
 #include "offset_allocator/offset_allocator.hpp"
 
+#include <sched.h>
+
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <thread>
 
 #include "mutex.h"
 #include "utils.h"
@@ -144,13 +148,15 @@ __Allocator::__Allocator(__Allocator&& other)
       m_usedBinsTop(other.m_usedBinsTop),
       m_nodes(std::move(other.m_nodes)),
       m_freeNodes(std::move(other.m_freeNodes)),
-      m_freeOffset(other.m_freeOffset) {
+      m_freeOffset(other.m_freeOffset),
+      m_freeRegions(other.m_freeRegions) {
     memcpy(m_usedBins, other.m_usedBins, sizeof(uint8) * NUM_TOP_BINS);
     memcpy(m_binIndices, other.m_binIndices, sizeof(NodeIndex) * NUM_LEAF_BINS);
 
     other.m_nodes.clear();
     other.m_freeNodes.clear();
     other.m_freeOffset = 0;
+    other.m_freeRegions = 0;
     other.m_current_capacity = 0;
     other.m_max_capacity = 0;
     other.m_usedBinsTop = 0;
@@ -160,6 +166,7 @@ void __Allocator::reset() {
     m_freeStorage = 0;
     m_usedBinsTop = 0;
     m_freeOffset = 0;
+    m_freeRegions = 0;
 
     for (uint32 i = 0; i < NUM_TOP_BINS; i++) m_usedBins[i] = 0;
 
@@ -249,6 +256,7 @@ OffsetAllocation __Allocator::allocate(uint32 size) {
     if (node.binListNext != Node::unused)
         m_nodes[node.binListNext].binListPrev = Node::unused;
     m_freeStorage -= nodeTotalSize;
+    m_freeRegions--;
 #ifdef DEBUG_VERBOSE
     printf("Free storage: %u (-%u) (allocate)\n", m_freeStorage, nodeTotalSize);
 #endif
@@ -284,6 +292,96 @@ OffsetAllocation __Allocator::allocate(uint32 size) {
     return OffsetAllocation(node.dataOffset, nodeIndex);
 }
 
+// Added in Mooncake project: carve a used node for [offset, offset + size)
+// out of the free node that covers it. This is only used to rebuild
+// allocations from persisted metadata and to split allocations, so a linear
+// scan of the bins is fine.
+OffsetAllocation __Allocator::allocateAt(uint32 offset, uint32 size,
+                                         bool exact) {
+    if (size == 0 || offset >= m_size || size > m_size - offset) {
+        return OffsetAllocation(OffsetAllocation::NO_SPACE,
+                                OffsetAllocation::NO_SPACE);
+    }
+
+    // Find the free node containing the requested range
+    uint32 freeIndex = Node::unused;
+    for (uint32 i = 0; i < NUM_LEAF_BINS && freeIndex == Node::unused; i++) {
+        for (uint32 nodeIndex = m_binIndices[i]; nodeIndex != Node::unused;
+             nodeIndex = m_nodes[nodeIndex].binListNext) {
+            const Node& node = m_nodes[nodeIndex];
+            if (node.dataOffset <= offset &&
+                offset + size <= node.dataOffset + node.dataSize) {
+                freeIndex = nodeIndex;
+                break;
+            }
+        }
+    }
+    if (freeIndex == Node::unused) {
+        return OffsetAllocation(OffsetAllocation::NO_SPACE,
+                                OffsetAllocation::NO_SPACE);
+    }
+
+    // The free node is replaced by up to three nodes: head, used, tail
+    if (!reserveFreeNodes(2)) {
+        return OffsetAllocation(OffsetAllocation::NO_SPACE,
+                                OffsetAllocation::NO_SPACE);
+    }
+
+    const Node freeNode = m_nodes[freeIndex];
+    const uint32 freeEnd = freeNode.dataOffset + freeNode.dataSize;
+
+    // Keep the same footprint as allocate() when the free node allows it
+    uint32 usedSize = size;
+#ifndef OFFSET_ALLOCATOR_NOT_ROUND_UP
+    if (!exact) {
+        usedSize =
+            SmallFloat::floatToUint(SmallFloat::uintToFloatRoundUp(size));
+        if (usedSize > freeEnd - offset) usedSize = freeEnd - offset;
+    }
+#endif
+
+    removeNodeFromBin(freeIndex);
+
+    uint32 prevIndex = freeNode.neighborPrev;
+    if (offset > freeNode.dataOffset) {
+        uint32 headIndex =
+            insertNodeIntoBin(offset - freeNode.dataOffset, freeNode.dataOffset);
+        linkNeighbors(prevIndex, headIndex);
+        prevIndex = headIndex;
+    }
+
+    uint32 usedIndex = m_freeNodes[m_freeOffset++];
+    m_nodes[usedIndex] = {.dataOffset = offset, .dataSize = usedSize};
+    m_nodes[usedIndex].used = true;
+    linkNeighbors(prevIndex, usedIndex);
+    prevIndex = usedIndex;
+
+    if (offset + usedSize < freeEnd) {
+        uint32 tailIndex =
+            insertNodeIntoBin(freeEnd - offset - usedSize, offset + usedSize);
+        linkNeighbors(prevIndex, tailIndex);
+        prevIndex = tailIndex;
+    }
+    linkNeighbors(prevIndex, freeNode.neighborNext);
+
+    return OffsetAllocation(offset, usedIndex);
+}
+
+bool __Allocator::reserveFreeNodes(uint32 count) {
+    while (m_current_capacity - m_freeOffset < count) {
+        if (m_current_capacity == m_max_capacity) return false;
+        m_freeNodes.push_back(m_current_capacity);
+        m_nodes.emplace_back();
+        m_current_capacity++;
+    }
+    return true;
+}
+
+void __Allocator::linkNeighbors(uint32 prevIndex, uint32 nextIndex) {
+    if (prevIndex != Node::unused) m_nodes[prevIndex].neighborNext = nextIndex;
+    if (nextIndex != Node::unused) m_nodes[nextIndex].neighborPrev = prevIndex;
+}
+
 void __Allocator::free(OffsetAllocation allocation) {
     ASSERT(allocation.metadata != OffsetAllocation::NO_SPACE);
     if (m_nodes.empty()) return;
@@ -379,6 +477,7 @@ uint32 __Allocator::insertNodeIntoBin(uint32 size, uint32 dataOffset) {
     m_binIndices[binIndex] = nodeIndex;
 
     m_freeStorage += size;
+    m_freeRegions++;
 #ifdef DEBUG_VERBOSE
     printf("Free storage: %u (+%u) (insertNodeIntoBin)\n", m_freeStorage, size);
 #endif
@@ -429,6 +528,7 @@ void __Allocator::removeNodeFromBin(uint32 nodeIndex) {
     m_freeNodes[--m_freeOffset] = nodeIndex;
 
     m_freeStorage -= node.dataSize;
+    m_freeRegions--;
 #ifdef DEBUG_VERBOSE
     printf("Free storage: %u (-%u) (removeNodeFromBin)\n", m_freeStorage,
            node.dataSize);
@@ -459,7 +559,8 @@ OffsetAllocStorageReport __Allocator::storageReport() const {
     }
 
     return {.totalFreeSpace = freeStorage,
-            .largestFreeRegion = largestFreeRegion};
+            .largestFreeRegion = largestFreeRegion,
+            .freeRegions = m_freeRegions};
 }
 
 OffsetAllocStorageReportFull __Allocator::storageReportFull() const {
@@ -491,7 +592,8 @@ OffsetAllocationHandle::OffsetAllocationHandle(
     : m_allocator(std::move(other.m_allocator)),
       m_allocation(other.m_allocation),
       real_base(other.real_base),
-      requested_size(other.requested_size) {
+      requested_size(other.requested_size),
+      m_cacheable(other.m_cacheable) {
     other.m_allocation = {OffsetAllocation::NO_SPACE,
                           OffsetAllocation::NO_SPACE};
     other.real_base = 0;
@@ -504,7 +606,8 @@ OffsetAllocationHandle& OffsetAllocationHandle::operator=(
         // Free current allocation if valid{
         auto allocator = m_allocator.lock();
         if (allocator) {
-            allocator->freeAllocation(m_allocation, requested_size);
+            allocator->freeAllocation(m_allocation, requested_size,
+                                      m_cacheable);
         }
 
         // Move from other
@@ -512,6 +615,7 @@ OffsetAllocationHandle& OffsetAllocationHandle::operator=(
         m_allocation = other.m_allocation;
         real_base = other.real_base;
         requested_size = other.requested_size;
+        m_cacheable = other.m_cacheable;
 
         // Reset other
         other.m_allocation = {OffsetAllocation::NO_SPACE,
@@ -525,7 +629,7 @@ OffsetAllocationHandle& OffsetAllocationHandle::operator=(
 OffsetAllocationHandle::~OffsetAllocationHandle() {
     auto allocator = m_allocator.lock();
     if (allocator) {
-        allocator->freeAllocation(m_allocation, requested_size);
+        allocator->freeAllocation(m_allocation, requested_size, m_cacheable);
     }
 }
 
@@ -539,22 +643,112 @@ static uint64_t calculateMultiplier(size_t size) {
 }
 
 // Thread-safe OffsetAllocator implementation
-std::shared_ptr<OffsetAllocator> OffsetAllocator::create(uint64_t base,
-                                                         size_t size,
-                                                         uint32 init_capacity,
-                                                         uint32 max_capacity) {
+std::shared_ptr<OffsetAllocator> OffsetAllocator::create(
+    uint64_t base, size_t size, uint32 init_capacity, uint32 max_capacity,
+    uint64_t magazine_bytes) {
     // Use a custom deleter to allow private constructor
-    return std::shared_ptr<OffsetAllocator>(
-        new OffsetAllocator(base, size, init_capacity, max_capacity));
+    return std::shared_ptr<OffsetAllocator>(new OffsetAllocator(
+        base, size, init_capacity, max_capacity, magazine_bytes));
 }
 
 OffsetAllocator::OffsetAllocator(uint64_t base, size_t size,
-                                 uint32 init_capacity, uint32 max_capacity)
+                                 uint32 init_capacity, uint32 max_capacity,
+                                 uint64_t magazine_bytes)
     : m_base(base),
       m_multiplier_bits(calculateMultiplier(size)),
       m_capacity(size) {
     m_allocator = std::make_unique<__Allocator>(size >> m_multiplier_bits,
                                                 init_capacity, max_capacity);
+#ifndef OFFSET_ALLOCATOR_NOT_ROUND_UP
+    // Without the round up, blocks of a bin differ in size and cannot be
+    // handed out for each other
+    if (magazine_bytes > 0) {
+        m_num_magazines = std::clamp<size_t>(
+            std::thread::hardware_concurrency(), 1, 256);
+        m_magazines = std::make_unique<Magazine[]>(m_num_magazines);
+        m_magazine_bytes = magazine_bytes;
+    }
+#endif
+}
+
+bool OffsetAllocator::magazineBin(uint64_t size, uint32& bin) const {
+    if (!m_magazines || size == 0 || size > kMagazineMaxSize) {
+        return false;
+    }
+    const uint64_t unit_mask =
+        (static_cast<uint64_t>(1) << m_multiplier_bits) - 1;
+    bin = SmallFloat::uintToFloatRoundUp(
+        static_cast<uint32>((size + unit_mask) >> m_multiplier_bits));
+    return bin < kMagazineBins;
+}
+
+OffsetAllocator::Magazine& OffsetAllocator::currentMagazine() const {
+    const int cpu = sched_getcpu();
+    return m_magazines[cpu < 0 ? 0 : cpu % m_num_magazines];
+}
+
+std::optional<OffsetAllocation> OffsetAllocator::popMagazine(uint32 bin) {
+    Magazine& magazine = currentMagazine();
+    MutexLocker lock(&magazine.lock);
+    auto& blocks = magazine.bins[bin];
+    if (blocks.empty()) {
+        return std::nullopt;
+    }
+    OffsetAllocation allocation = blocks.back();
+    blocks.pop_back();
+    magazine.cached_bytes -=
+        static_cast<uint64_t>(SmallFloat::floatToUint(bin))
+        << m_multiplier_bits;
+    return allocation;
+}
+
+bool OffsetAllocator::pushMagazine(const OffsetAllocation& allocation,
+                                   uint32 bin) {
+    const uint64_t block_size = static_cast<uint64_t>(
+                                    SmallFloat::floatToUint(bin))
+                                << m_multiplier_bits;
+    Magazine& magazine = currentMagazine();
+    MutexLocker lock(&magazine.lock);
+    auto& blocks = magazine.bins[bin];
+    if (blocks.size() >= kMagazineMaxBlocks ||
+        magazine.cached_bytes + block_size > m_magazine_bytes) {
+        return false;
+    }
+    blocks.push_back(allocation);
+    magazine.cached_bytes += block_size;
+    return true;
+}
+
+bool OffsetAllocator::flushMagazinesLocked() const {
+    if (!m_magazines) {
+        return false;
+    }
+    bool flushed = false;
+    std::vector<OffsetAllocation> blocks;
+    for (size_t i = 0; i < m_num_magazines; i++) {
+        Magazine& magazine = m_magazines[i];
+        {
+            MutexLocker lock(&magazine.lock);
+            for (auto& bin : magazine.bins) {
+                blocks.insert(blocks.end(), bin.begin(), bin.end());
+                bin.clear();
+            }
+            magazine.cached_bytes = 0;
+        }
+        for (const auto& allocation : blocks) {
+            m_allocator->free(allocation);
+        }
+        flushed = flushed || !blocks.empty();
+        blocks.clear();
+    }
+    return flushed;
+}
+
+void OffsetAllocator::flushMagazines() {
+    MutexLocker guard(&m_mutex);
+    if (m_allocator) {
+        flushMagazinesLocked();
+    }
 }
 
 std::optional<OffsetAllocationHandle> OffsetAllocator::allocate(size_t size) {
@@ -562,6 +756,21 @@ std::optional<OffsetAllocationHandle> OffsetAllocator::allocate(size_t size) {
         return std::nullopt;
     }
 
+    uint32 bin = 0;
+    const bool cacheable = magazineBin(size, bin);
+    if (cacheable) {
+        auto cached = popMagazine(bin);
+        if (cached) {
+            m_magazine_size_delta.fetch_add(size, std::memory_order_relaxed);
+            m_magazine_num_delta.fetch_add(1, std::memory_order_relaxed);
+            OffsetAllocationHandle handle(
+                shared_from_this(), *cached,
+                m_base + (cached->getOffset() << m_multiplier_bits), size);
+            handle.m_cacheable = true;
+            return handle;
+        }
+    }
+
     MutexLocker guard(&m_mutex);
     if (!m_allocator) {
         return std::nullopt;
@@ -578,6 +787,9 @@ std::optional<OffsetAllocationHandle> OffsetAllocator::allocate(size_t size) {
     }
 
     OffsetAllocation allocation = m_allocator->allocate(fake_size);
+    if (allocation.isNoSpace() && flushMagazinesLocked()) {
+        allocation = m_allocator->allocate(fake_size);
+    }
     if (allocation.isNoSpace()) {
         // Log metrics to help understand why allocation failed
         // Note: We're already holding m_mutex, so use internal method
@@ -591,20 +803,156 @@ std::optional<OffsetAllocationHandle> OffsetAllocator::allocate(size_t size) {
     m_allocated_size += size;
     m_allocated_num++;
 
+    if (cacheable) {
+        // Take a few more blocks of the bin for the next allocations
+        for (size_t i = 1; i < kMagazineRefill; i++) {
+            OffsetAllocation extra = m_allocator->allocate(fake_size);
+            if (extra.isNoSpace()) {
+                break;
+            }
+            if (!pushMagazine(extra, bin)) {
+                m_allocator->free(extra);
+                break;
+            }
+        }
+    }
+
     // Use shared_from_this to get a shared_ptr to this OffsetAllocator
-    return OffsetAllocationHandle(
+    OffsetAllocationHandle handle(
         shared_from_this(), allocation,
         m_base + (allocation.getOffset() << m_multiplier_bits), size);
+    handle.m_cacheable = cacheable;
+    return handle;
+}
+
+std::optional<OffsetAllocationHandle> OffsetAllocator::allocateAt(
+    uint64_t address, size_t size) {
+    if (size == 0 || address < m_base) {
+        return std::nullopt;
+    }
+
+    MutexLocker guard(&m_mutex);
+    if (!m_allocator) {
+        return std::nullopt;
+    }
+
+    // Only addresses produced by allocate() can be restored, and those are
+    // always aligned to the multiplier.
+    const uint64_t relative = address - m_base;
+    const uint64_t unit_mask =
+        (static_cast<uint64_t>(1) << m_multiplier_bits) - 1;
+    if (relative & unit_mask) {
+        return std::nullopt;
+    }
+    size_t fake_size = (size + unit_mask) >> m_multiplier_bits;
+    uint64_t fake_offset = relative >> m_multiplier_bits;
+    if (fake_size > SmallFloat::MAX_BIN_SIZE ||
+        fake_offset > SmallFloat::MAX_BIN_SIZE) {
+        return std::nullopt;
+    }
+
+    OffsetAllocation allocation = m_allocator->allocateAt(
+        static_cast<uint32>(fake_offset), static_cast<uint32>(fake_size));
+    if (allocation.isNoSpace() && flushMagazinesLocked()) {
+        allocation = m_allocator->allocateAt(static_cast<uint32>(fake_offset),
+                                             static_cast<uint32>(fake_size));
+    }
+    if (allocation.isNoSpace()) {
+        VLOG(1) << "OffsetAllocator allocateAt failed: address=" << address
+                << ", size=" << size;
+        return std::nullopt;
+    }
+
+    m_allocated_size += size;
+    m_allocated_num++;
+
+    return OffsetAllocationHandle(shared_from_this(), allocation, address,
+                                  size);
+}
+
+std::vector<OffsetAllocationHandle> OffsetAllocator::split(
+    OffsetAllocationHandle& handle, const std::vector<size_t>& sizes) {
+    std::vector<OffsetAllocationHandle> handles;
+    if (sizes.empty() || handle.m_allocator.lock().get() != this) {
+        return handles;
+    }
+
+    MutexLocker guard(&m_mutex);
+    if (!m_allocator) {
+        return handles;
+    }
+
+    const uint64_t unit_mask =
+        (static_cast<uint64_t>(1) << m_multiplier_bits) - 1;
+    uint64_t total_units = 0;
+    for (size_t size : sizes) {
+        if (size == 0) {
+            return handles;
+        }
+        total_units += (size + unit_mask) >> m_multiplier_bits;
+    }
+    const uint32 offset = static_cast<uint32>(handle.m_allocation.getOffset());
+    const uint32 units = m_allocator->allocationSize(handle.m_allocation);
+    if (total_units > units) {
+        return handles;
+    }
+
+    // Free the allocation and carve the pieces out of the same range, which
+    // only fails if the node pool is exhausted
+    m_allocator->free(handle.m_allocation);
+    std::vector<OffsetAllocation> allocations;
+    allocations.reserve(sizes.size());
+    uint32 piece_offset = offset;
+    for (size_t size : sizes) {
+        const uint32 piece_units =
+            static_cast<uint32>((size + unit_mask) >> m_multiplier_bits);
+        OffsetAllocation allocation =
+            m_allocator->allocateAt(piece_offset, piece_units, true);
+        if (allocation.isNoSpace()) {
+            for (const auto& piece : allocations) {
+                m_allocator->free(piece);
+            }
+            handle.m_allocation = m_allocator->allocateAt(offset, units, true);
+            if (handle.m_allocation.isNoSpace()) {
+                LOG(ERROR) << "OffsetAllocator failed to restore a split "
+                              "allocation, offset="
+                           << offset << ", units=" << units;
+                m_allocated_size -= handle.requested_size;
+                m_allocated_num--;
+                handle.m_allocator.reset();
+            }
+            return handles;
+        }
+        allocations.push_back(allocation);
+        piece_offset += piece_units;
+    }
+
+    m_allocated_size -= handle.requested_size;
+    m_allocated_num--;
+    handle.m_allocator.reset();
+    handle.m_allocation = {OffsetAllocation::NO_SPACE,
+                           OffsetAllocation::NO_SPACE};
+    handles.reserve(sizes.size());
+    for (size_t i = 0; i < sizes.size(); i++) {
+        m_allocated_size += sizes[i];
+        m_allocated_num++;
+        handles.emplace_back(
+            shared_from_this(), allocations[i],
+            m_base + (allocations[i].getOffset() << m_multiplier_bits),
+            sizes[i]);
+    }
+    return handles;
 }
 
 OffsetAllocStorageReport OffsetAllocator::storageReport() const {
     MutexLocker guard(&m_mutex);
     if (!m_allocator) {
-        return {0, 0};
+        return {0, 0, 0};
     }
     OffsetAllocStorageReport report = m_allocator->storageReport();
     return {report.totalFreeSpace << m_multiplier_bits,
-            report.largestFreeRegion << m_multiplier_bits};
+            report.largestFreeRegion << m_multiplier_bits,
+            report.freeRegions};
 }
 
 OffsetAllocStorageReportFull OffsetAllocator::storageReportFull() const {
@@ -630,8 +978,8 @@ OffsetAllocatorMetrics OffsetAllocator::get_metrics_internal() const {
     // Get basic storage report
     OffsetAllocStorageReport basic_report = m_allocator->storageReport();
     return {
-        m_allocated_size,  // allocated_size_
-        m_allocated_num,   // allocated_num_
+        m_allocated_size + m_magazine_size_delta.load(),  // allocated_size_
+        m_allocated_num + m_magazine_num_delta.load(),    // allocated_num_
         basic_report.largestFreeRegion
             << m_multiplier_bits,  // largest_free_region_
         basic_report.totalFreeSpace << m_multiplier_bits,  // total_free_space_
@@ -645,7 +993,13 @@ OffsetAllocatorMetrics OffsetAllocator::get_metrics() const {
 }
 
 void OffsetAllocator::freeAllocation(const OffsetAllocation& allocation,
-                                     uint64_t size) {
+                                     uint64_t size, bool cacheable) {
+    uint32 bin = 0;
+    if (cacheable && magazineBin(size, bin) && pushMagazine(allocation, bin)) {
+        m_magazine_size_delta.fetch_sub(size, std::memory_order_relaxed);
+        m_magazine_num_delta.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
     MutexLocker lock(&m_mutex);
     if (m_allocator) {
         m_allocator->free(allocation);
@@ -655,6 +1009,33 @@ void OffsetAllocator::freeAllocation(const OffsetAllocation& allocation,
     }
 }
 
+void OffsetAllocator::freeAllocations(
+    std::vector<OffsetAllocationHandle>& handles) {
+    uint32 bin = 0;
+    for (auto& handle : handles) {
+        if (handle.m_cacheable && magazineBin(handle.requested_size, bin) &&
+            handle.m_allocator.lock().get() == this &&
+            pushMagazine(handle.m_allocation, bin)) {
+            m_magazine_size_delta.fetch_sub(handle.requested_size,
+                                            std::memory_order_relaxed);
+            m_magazine_num_delta.fetch_sub(1, std::memory_order_relaxed);
+            handle.m_allocator.reset();
+        }
+    }
+    MutexLocker lock(&m_mutex);
+    for (auto& handle : handles) {
+        if (handle.m_allocator.lock().get() != this) {
+            continue;
+        }
+        if (m_allocator) {
+            m_allocator->free(handle.m_allocation);
+            m_allocated_size -= handle.requested_size;
+            m_allocated_num--;
+        }
+        handle.m_allocator.reset();
+    }
+}
+
 // Stream output operator implementation
 std::ostream& operator<<(std::ostream& os,
                          const OffsetAllocatorMetrics& metrics) {
@@ -1,8 +1,10 @@
 #include <netinet/in.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
 #include <numa.h>
+#include <numaif.h>  // For mbind
 #include <pthread.h>
 #include <signal.h>
 #include <thread>
@@ -160,6 +162,154 @@ std::shared_ptr<RealClient> RealClient::create() {
     return sp;
 }
 
+namespace {
+
+// NUMA nodes the global segment is split over, 1 unless MC_STORE_SEGMENT_NUMA
+// is set on a host with several nodes
+int GetSegmentNumaNodes(const std::string &protocol) {
+    if (!GetEnvOr<bool>("MC_STORE_SEGMENT_NUMA", false) ||
+        protocol == "ascend" || numa_available() < 0) {
+        return 1;
+    }
+    const int nodes = numa_num_configured_nodes();
+    return nodes > 1 && nodes <= 64 ? nodes : 1;
+}
+
+// Move the pages of a segment to the NUMA node, pages faulted later are
+// placed there too. Pages shared with other allocations are left alone.
+void BindSegmentToNumaNode(void *ptr, size_t size, int node) {
+    const size_t page = getpagesize();
+    const uint64_t begin = align_up(reinterpret_cast<uint64_t>(ptr), page);
+    const uint64_t end = (reinterpret_cast<uint64_t>(ptr) + size) / page * page;
+    unsigned long mask = 1UL << node;
+    if (end > begin &&
+        mbind(reinterpret_cast<void *>(begin), end - begin, MPOL_PREFERRED,
+              &mask, sizeof(mask) * 8, MPOL_MF_MOVE) != 0) {
+        LOG(WARNING) << "Failed to bind segment to NUMA node " << node
+                     << ", errno=" << errno << " (" << strerror(errno) << ")";
+    }
+}
+
+}  // namespace
+
+tl::expected<void, ErrorCode> RealClient::mount_segment_chunk(
+    const SegmentChunk &chunk, bool use_hugepage) {
+    if (warm_restart_) {
+        auto mapping =
+            warm_restart_->CreateSegment(chunk.size, chunk.numa_node);
+        if (!mapping) {
+            return tl::unexpected(ErrorCode::INVALID_PARAMS);
+        }
+        if (chunk.numa_node >= 0) {
+            BindSegmentToNumaNode(mapping->base, mapping->size,
+                                  chunk.numa_node);
+        }
+        return mount_warm_segment(*mapping);
+    }
+
+    size_t mapped_size = chunk.size;
+    void *ptr = nullptr;
+    if (!ipc_socket_path_.empty() && this->protocol != "ascend") {
+        // Backed by a memfd so that co-located dummy clients can map
+        // it and read objects without copying them.
+        ptr = allocate_exported_segment(mapped_size, use_hugepage);
+    } else if (use_hugepage) {
+        mapped_size = align_up(chunk.size, get_hugepage_size_from_env());
+        ptr = allocate_buffer_mmap_memory(mapped_size,
+                                          get_hugepage_size_from_env());
+    } else {
+        ptr = allocate_buffer_allocator_memory(chunk.size, this->protocol);
+    }
+
+    if (!ptr) {
+        LOG(ERROR) << "Failed to allocate segment memory";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    std::string location = kWildcardLocation;
+    if (chunk.numa_node >= 0) {
+        BindSegmentToNumaNode(ptr, mapped_size, chunk.numa_node);
+        location = "cpu:" + std::to_string(chunk.numa_node);
+    }
+    {
+        std::lock_guard lock(segment_ptrs_mutex_);
+        if (!ipc_socket_path_.empty() && this->protocol != "ascend") {
+            // Owned by exported_segments_
+        } else if (this->protocol == "ascend") {
+            ascend_segment_ptrs_.emplace_back(ptr);
+        } else if (use_hugepage) {
+            hugepage_segment_ptrs_.emplace_back(
+                ptr, HugepageSegmentDeleter{mapped_size});
+        } else {
+            segment_ptrs_.emplace_back(ptr);
+        }
+    }
+    auto mount_result =
+        client_->MountSegment(ptr, mapped_size, this->protocol, location);
+    if (!mount_result.has_value()) {
+        LOG(ERROR) << "Failed to mount segment: "
+                   << toString(mount_result.error());
+        return tl::unexpected(mount_result.error());
+    }
+    return {};
+}
+
+tl::expected<void, ErrorCode> RealClient::mount_warm_segment(
+    const WarmRestartState::Mapping &mapping) {
+    {
+        std::lock_guard lock(segment_ptrs_mutex_);
+        exported_segments_.push_back({mapping.fd, mapping.base, mapping.size});
+    }
+    const std::string location =
+        mapping.numa_node >= 0 ? "cpu:" + std::to_string(mapping.numa_node)
+                               : kWildcardLocation;
+    // Under the id of the previous process, the master keeps its objects if
+    // it still has the segment
+    auto mount_result = client_->MountSegment(
+        mapping.base, mapping.size, this->protocol, location,
+        mapping.segment_id);
+    if (!mount_result.has_value()) {
+        LOG(ERROR) << "Failed to mount segment: "
+                   << toString(mount_result.error());
+        return tl::unexpected(mount_result.error());
+    }
+    return {};
+}
+
+void RealClient::start_segment_warmup(std::vector<SegmentChunk> chunks,
+                                      bool use_hugepage) {
+    const size_t threads = std::clamp<size_t>(
+        GetEnvOr<size_t>("MC_STORE_SEGMENT_WARMUP_THREADS", 4), 1,
+        chunks.size());
+    LOG(INFO) << "Mounting " << chunks.size() << " segment chunks with "
+              << threads << " background threads";
+    auto pending =
+        std::make_shared<const std::vector<SegmentChunk>>(std::move(chunks));
+    auto next = std::make_shared<std::atomic<size_t>>(0);
+    auto left = std::make_shared<std::atomic<size_t>>(pending->size());
+    for (size_t i = 0; i < threads; ++i) {
+        segment_warmup_threads_.emplace_back(
+            [this, pending, next, left, use_hugepage](std::stop_token stop) {
+                while (!stop.stop_requested()) {
+                    const size_t index = next->fetch_add(1);
+                    if (index >= pending->size()) {
+                        return;
+                    }
+                    const auto &chunk = (*pending)[index];
+                    auto result = mount_segment_chunk(chunk, use_hugepage);
+                    if (!result) {
+                        LOG(ERROR) << "Failed to mount segment chunk of "
+                                   << chunk.size << " bytes in background: "
+                                   << toString(result.error());
+                        continue;
+                    }
+                    if (left->fetch_sub(1) == 1) {
+                        LOG(INFO) << "All segment chunks mounted";
+                    }
+                }
+            });
+    }
+}
+
 tl::expected<void, ErrorCode> RealClient::setup_internal(
     const std::string &local_hostname, const std::string &metadata_server,
     size_t global_segment_size, size_t local_buffer_size,
@@ -182,6 +332,26 @@ tl::expected<void, ErrorCode> RealClient::setup_internal(
     size_t colon_pos = hostname.find(":");
     bool user_specified_port = (colon_pos != std::string::npos);
 
+    // The segments of a restarted client are found by its hostname, which
+    // must not change
+    const std::string warm_restart_dir =
+        GetEnvStringOr("MC_STORE_WARM_RESTART_DIR", "");
+    std::vector<WarmRestartState::Mapping> warm_segments;
+    if (!warm_restart_dir.empty()) {
+        if (!user_specified_port || protocol == "cxl" ||
+            protocol == "ascend") {
+            LOG(WARNING) << "Warm restart needs a local hostname with a port "
+                            "and host memory segments, disabling it";
+        } else {
+            if (should_use_hugepage) {
+                LOG(WARNING) << "Warm restart segments do not use hugepages";
+            }
+            warm_restart_ = std::make_unique<WarmRestartState>(
+                warm_restart_dir, local_hostname, global_segment_size);
+            warm_segments = warm_restart_->Restore();
+        }
+    }
+
     if (user_specified_port) {
         // User specified port, no retry needed
         this->local_hostname = local_hostname;
@@ -189,7 +359,9 @@ tl::expected<void, ErrorCode> RealClient::setup_internal(
             hostname.substr(0, colon_pos + 1) + std::to_string(local_rpc_port);
         auto client_opt = mooncake::Client::Create(
             this->local_hostname, metadata_server, protocol, device_name,
-            master_server_addr, transfer_engine);
+            master_server_addr, transfer_engine, {},
+            warm_restart_ ? std::make_optional(warm_restart_->client_id())
+                          : std::nullopt);
         if (!client_opt) {
             LOG(ERROR) << "Failed to create client";
             return tl::unexpected(ErrorCode::INVALID_PARAMS);
@@ -242,13 +414,24 @@ tl::expected<void, ErrorCode> RealClient::setup_internal(
         }
     }
 
+    // Released user buffers stay registered up to this many bytes, off by
+    // default as their memory stays pinned
+    registration_cache_ = std::make_unique<RegistrationCache>(
+        [this](void *addr, size_t length, const std::string &location) {
+            return client_->RegisterLocalMemory(addr, length, location, false,
+                                                true);
+        },
+        [this](void *addr) { return client_->unregisterLocalMemory(addr); },
+        GetEnvOr<size_t>("MC_STORE_REGISTRATION_CACHE_BYTES", 0));
+
     // Local_buffer_size is allowed to be 0, but we only register memory when
     // local_buffer_size > 0. Invoke ibv_reg_mr() with size=0 is UB, and may
     // fail in some rdma implementations.
     // Dummy Client can create shm and share it with Real Client, so Real Client
     // can create client buffer allocator on the shared memory later.
     client_buffer_allocator_ = ClientBufferAllocator::create(
-        local_buffer_size, this->protocol, should_use_hugepage);
+        local_buffer_size, this->protocol, should_use_hugepage,
+        ClientBufferArenaConfig::FromEnvironment());
     if (local_buffer_size > 0) {
         LOG(INFO) << "Registering local memory: " << local_buffer_size
                   << " bytes";
@@ -290,53 +473,95 @@ tl::expected<void, ErrorCode> RealClient::setup_internal(
             return tl::unexpected(mount_result.error());
         }
 
+    } else if (warm_restart_ && warm_restart_->restored()) {
+        for (const auto &mapping : warm_segments) {
+            LOG(INFO) << "Mounting restored segment: " << mapping.size
+                      << " bytes at " << mapping.base;
+            auto mount_result = mount_warm_segment(mapping);
+            if (!mount_result) {
+                return mount_result;
+            }
+        }
     } else {
         auto max_mr_size = globalConfig().max_mr_size;     // Max segment size
         uint64_t total_glbseg_size = global_segment_size;  // For logging
         uint64_t current_glbseg_size = 0;                  // For logging
+        // Split evenly over the NUMA nodes, each part bound to its node and
+        // registered with its location, so that transfers of the part use
+        // the NICs of the same node
+        const int numa_nodes = GetSegmentNumaNodes(this->protocol);
+        if (numa_nodes > 1) {
+            LOG(INFO) << "Splitting global segment over " << numa_nodes
+                      << " NUMA nodes";
+        }
+        // With a warm-up chunk size, only the first chunk is mounted here
+        // and the others by background threads, so the capacity of the
+        // segment grows while their pages are faulted and registered
+        size_t warmup_chunk_size =
+            GetEnvOr<size_t>("MC_STORE_SEGMENT_WARMUP_CHUNK_SIZE", 0);
+        if (warmup_chunk_size > 0 &&
+            (!ipc_socket_path_.empty() || this->protocol == "ascend" ||
+             warm_restart_)) {
+            LOG(WARNING) << "Segment warm-up is not supported with the IPC "
+                            "server, ascend or warm restart, mounting all at "
+                            "setup";
+            warmup_chunk_size = 0;
+        }
+        const size_t chunk_limit =
+            warmup_chunk_size > 0 ? std::min(warmup_chunk_size, max_mr_size)
+                                  : max_mr_size;
+        // Each mounted segment has its own allocator in the master, so
+        // splitting a node's part lets puts to this client allocate
+        // concurrently
+        const size_t split = std::max<size_t>(
+            GetEnvOr<size_t>("MC_STORE_SEGMENT_SPLIT", 1), 1);
+        std::vector<SegmentChunk> chunks;
+        size_t node_remaining = 0;
+        size_t node_chunk_limit = chunk_limit;
+        int node = -1;
         while (global_segment_size > 0) {
-            size_t segment_size = std::min(global_segment_size, max_mr_size);
+            while (node_remaining == 0) {
+                node++;
+                node_remaining = node == numa_nodes - 1
+                                     ? global_segment_size
+                                     : total_glbseg_size / numa_nodes;
+                node_chunk_limit = std::min(
+                    chunk_limit,
+                    align_up((node_remaining + split - 1) / split,
+                             facebook::cachelib::Slab::kSize));
+            }
+            size_t segment_size = std::min(node_remaining, node_chunk_limit);
+            node_remaining -= segment_size;
             global_segment_size -= segment_size;
-            current_glbseg_size += segment_size;
-            LOG(INFO) << "Mounting segment: " << segment_size << " bytes, "
+            chunks.push_back({segment_size, numa_nodes > 1 ? node : -1});
+        }
+        const size_t sync_chunks =
+            warmup_chunk_size > 0 ? std::min<size_t>(1, chunks.size())
+                                  : chunks.size();
+        for (size_t i = 0; i < sync_chunks; ++i) {
+            current_glbseg_size += chunks[i].size;
+            LOG(INFO) << "Mounting segment: " << chunks[i].size << " bytes, "
                       << current_glbseg_size << " of " << total_glbseg_size;
-
-            size_t mapped_size = segment_size;
-            void *ptr = nullptr;
-            if (should_use_hugepage) {
-                mapped_size =
-                    align_up(segment_size, get_hugepage_size_from_env());
-                ptr = allocate_buffer_mmap_memory(mapped_size,
-                                                  get_hugepage_size_from_env());
-            } else {
-                ptr = allocate_buffer_allocator_memory(segment_size,
-                                                       this->protocol);
-            }
-
-            if (!ptr) {
-                LOG(ERROR) << "Failed to allocate segment memory";
-                return tl::unexpected(ErrorCode::INVALID_PARAMS);
-            }
-            if (this->protocol == "ascend") {
-                ascend_segment_ptrs_.emplace_back(ptr);
-            } else if (should_use_hugepage) {
-                hugepage_segment_ptrs_.emplace_back(
-                    ptr, HugepageSegmentDeleter{mapped_size});
-            } else {
-                segment_ptrs_.emplace_back(ptr);
-            }
             auto mount_result =
-                client_->MountSegment(ptr, mapped_size, protocol);
-            if (!mount_result.has_value()) {
-                LOG(ERROR) << "Failed to mount segment: "
-                           << toString(mount_result.error());
-                return tl::unexpected(mount_result.error());
+                mount_segment_chunk(chunks[i], should_use_hugepage);
+            if (!mount_result) {
+                return mount_result;
             }
         }
+        if (sync_chunks < chunks.size()) {
+            start_segment_warmup(
+                std::vector<SegmentChunk>(chunks.begin() + sync_chunks,
+                                          chunks.end()),
+                should_use_hugepage);
+        }
         if (total_glbseg_size == 0) {
             LOG(INFO) << "Global segment size is 0, skip mounting segment";
         }
     }
+    if (warm_restart_ && !warm_restart_->Save()) {
+        LOG(WARNING) << "Failed to save the warm restart state, the next "
+                        "process of this client starts cold";
+    }
 
     // Start IPC server to accept FD from dummy clients
     if (!ipc_socket_path_.empty()) {
@@ -496,6 +721,8 @@ tl::expected<void, ErrorCode> RealClient::tearDownAll_internal() {
     }
 
     stop_ipc_server();
+    // Stop mounting before the client and the segments go away
+    segment_warmup_threads_.clear();
 
     if (!client_) {
         // Not initialized or already cleaned; treat as success for idempotence
@@ -510,12 +737,29 @@ tl::expected<void, ErrorCode> RealClient::tearDownAll_internal() {
                 << toString(unregister_result.error());
         }
     }
+    if (registration_cache_) {
+        registration_cache_->Clear();
+        registration_cache_.reset();
+    }
+    if (warm_restart_) {
+        // Left mounted for the next process of this client
+        client_->DetachSegments();
+    }
     // Reset all resources
     client_.reset();
     client_buffer_allocator_.reset();
     port_binder_.reset();
     hugepage_segment_ptrs_.clear();
     segment_ptrs_.clear();
+    for (auto &seg : exported_segments_) {
+        if (munmap(seg.base, seg.size) != 0) {
+            LOG(ERROR) << "Failed to unmap exported segment, error: "
+                       << strerror(errno);
+        }
+        close(seg.fd);
+    }
+    exported_segments_.clear();
+    warm_restart_.reset();
     local_hostname = "";
     device_name = "";
     protocol = "";
@@ -568,11 +812,12 @@ tl::expected<void, ErrorCode> RealClient::put_internal(
         return tl::unexpected(ErrorCode::INVALID_PARAMS);
     }
     auto &buffer_handle = *alloc_result;
-    memcpy(buffer_handle.ptr(), value.data(), value.size_bytes());
-
     std::vector<Slice> slices = split_into_slices(buffer_handle);
 
-    auto put_result = client_->Put(key, slices, config);
+    // Copied only if the key is not already put
+    auto put_result = client_->Put(key, slices, config, [&] {
+        memcpy(buffer_handle.ptr(), value.data(), value.size_bytes());
+    });
     if (!put_result) {
         return tl::unexpected(put_result.error());
     }
@@ -850,6 +1095,22 @@ std::vector<int> RealClient::batchIsExist(
     return results;
 }
 
+tl::expected<void, ErrorCode> RealClient::prefetch_internal(
+    const std::vector<std::string> &keys) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (keys.empty()) {
+        return {};
+    }
+    return client_->Prefetch(keys);
+}
+
+int RealClient::prefetch(const std::vector<std::string> &keys) {
+    return to_py_ret(prefetch_internal(keys));
+}
+
 tl::expected<int64_t, ErrorCode> RealClient::getSize_internal(
     const std::string &key) {
     if (!client_) {
@@ -879,6 +1140,35 @@ tl::expected<int64_t, ErrorCode> RealClient::getSize_internal(
     return total_size;
 }
 
+void *RealClient::allocate_exported_segment(size_t &mapped_size,
+                                            bool use_hugepage) {
+    unsigned int flags = MFD_CLOEXEC;
+    if (use_hugepage) {
+        mapped_size = align_up(mapped_size,
+                               get_hugepage_size_from_env(&flags, true));
+    }
+    int fd = memfd_create(MOONCAKE_SHM_NAME, flags);
+    if (fd == -1) {
+        LOG(ERROR) << "Failed to create memfd for segment: "
+                   << strerror(errno);
+        return nullptr;
+    }
+    if (ftruncate(fd, mapped_size) == -1) {
+        LOG(ERROR) << "Failed to set segment size: " << strerror(errno);
+        close(fd);
+        return nullptr;
+    }
+    void *ptr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fd, 0);
+    if (ptr == MAP_FAILED) {
+        LOG(ERROR) << "Failed to map segment: " << strerror(errno);
+        close(fd);
+        return nullptr;
+    }
+    exported_segments_.push_back({fd, ptr, mapped_size});
+    return ptr;
+}
+
 int64_t RealClient::getSize(const std::string &key) {
     return to_py_ret(getSize_internal(key));
 }
@@ -948,8 +1238,9 @@ tl::expected<void, ErrorCode> RealClient::map_shm_internal(
             munmap(shm_buffer, shm_size);
             return tl::make_unexpected(ErrorCode::OBJECT_ALREADY_EXISTS);
         }
-        context.client_buffer_allocator =
-            ClientBufferAllocator::create(shm_buffer, shm_size, this->protocol);
+        context.client_buffer_allocator = ClientBufferAllocator::create(
+            shm_buffer, shm_size, this->protocol,
+            ClientBufferArenaConfig::FromEnvironment());
     }
 
     context.mapped_shms.push_back(std::move(shm));
@@ -1171,6 +1462,67 @@ RealClient::get_buffer_info_dummy_helper(const std::string &key,
     return tl::unexpected(ErrorCode::INTERNAL_ERROR);
 }
 
+tl::expected<ZeroCopyLease, ErrorCode> RealClient::get_zero_copy_internal(
+    const std::string &key) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    // The query grants the lease, which keeps the replica from being evicted
+    // or removed until it expires.
+    auto query_result = client_->Query(key);
+    if (!query_result) {
+        return tl::unexpected(query_result.error());
+    }
+    auto lease_ttl = std::chrono::duration_cast<std::chrono::milliseconds>(
+        query_result->lease_timeout - std::chrono::steady_clock::now());
+    if (lease_ttl.count() <= 0) {
+        return tl::unexpected(ErrorCode::LEASE_EXPIRED);
+    }
+
+    for (const auto &replica : query_result->replicas) {
+        if (replica.status != ReplicaStatus::COMPLETE ||
+            !client_->IsReplicaOnLocalMemory(replica)) {
+            continue;
+        }
+        const auto &buffer =
+            replica.get_memory_descriptor().buffer_descriptor;
+        ZeroCopyLease lease;
+        lease.real_addr = buffer.buffer_address_;
+        lease.size = buffer.size_;
+        lease.lease_ttl_ms = lease_ttl.count();
+        return lease;
+    }
+    return tl::unexpected(ErrorCode::REPLICA_NOT_FOUND);
+}
+
+std::tuple<uint64_t, size_t, uint64_t> RealClient::get_zero_copy_info(
+    const std::string &key) {
+    auto result = get_zero_copy_internal(key);
+    if (!result) {
+        return std::make_tuple(0, 0, 0);
+    }
+    return std::make_tuple(result->real_addr, result->size,
+                           result->lease_ttl_ms);
+}
+
+tl::expected<ZeroCopyLease, ErrorCode> RealClient::get_zero_copy_dummy_helper(
+    const std::string &key) {
+    auto result = get_zero_copy_internal(key);
+    if (!result) {
+        return result;
+    }
+    // Only exported segments can be mapped by the dummy client
+    for (const auto &seg : exported_segments_) {
+        uint64_t seg_start = reinterpret_cast<uint64_t>(seg.base);
+        if (result->real_addr >= seg_start &&
+            result->real_addr + result->size <= seg_start + seg.size) {
+            return result;
+        }
+    }
+    return tl::unexpected(ErrorCode::REPLICA_NOT_FOUND);
+}
+
 // Implementation of batch_get_buffer_internal method
 std::vector<std::shared_ptr<BufferHandle>>
 RealClient::batch_get_buffer_internal(const std::vector<std::string> &keys) {
@@ -1290,21 +1642,40 @@ tl::expected<void, ErrorCode> RealClient::register_buffer_internal(
         LOG(ERROR) << "Client is not initialized";
         return tl::unexpected(ErrorCode::INVALID_PARAMS);
     }
-    return client_->RegisterLocalMemory(buffer, size, kWildcardLocation, false,
-                                        true);
+    return registration_cache_->Register(buffer, size, kWildcardLocation);
 }
 
 int RealClient::register_buffer(void *buffer, size_t size) {
     return to_py_ret(register_buffer_internal(buffer, size));
 }
 
+tl::expected<void, ErrorCode> RealClient::register_device_buffer_internal(
+    void *buffer, size_t size, int device_id) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (device_id < 0) {
+        LOG(ERROR) << "Invalid device id: " << device_id;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    // The location lets the transfer engine pick the NICs close to the GPU
+    return registration_cache_->Register(buffer, size,
+                                         "cuda:" + std::to_string(device_id));
+}
+
+int RealClient::register_device_buffer(void *buffer, size_t size,
+                                       int device_id) {
+    return to_py_ret(register_device_buffer_internal(buffer, size, device_id));
+}
+
 tl::expected<void, ErrorCode> RealClient::unregister_buffer_internal(
     void *buffer) {
     if (!client_) {
         LOG(ERROR) << "Client is not initialized";
         return tl::unexpected(ErrorCode::INVALID_PARAMS);
     }
-    auto unregister_result = client_->unregisterLocalMemory(buffer, true);
+    auto unregister_result = registration_cache_->Unregister(buffer);
     if (!unregister_result) {
         LOG(ERROR) << "Unregister buffer failed with error: "
                    << toString(unregister_result.error());
@@ -1317,6 +1688,15 @@ int RealClient::unregister_buffer(void *buffer) {
     return to_py_ret(unregister_buffer_internal(buffer));
 }
 
+int RealClient::invalidate_buffer(void *buffer, size_t size) {
+    if (!registration_cache_) {
+        LOG(ERROR) << "Client is not initialized";
+        return toInt(ErrorCode::INVALID_PARAMS);
+    }
+    registration_cache_->Invalidate(buffer, size);
+    return 0;
+}
+
 tl::expected<int64_t, ErrorCode> RealClient::get_into_internal(
     const std::string &key, void *buffer, size_t size) {
     // NOTE: The buffer address must be previously registered with
@@ -1339,8 +1719,29 @@ tl::expected<int64_t, ErrorCode> RealClient::get_into_internal(
         return tl::unexpected(query_result.error());
     }
 
+    std::vector<mooncake::Slice> slices;
+    auto total_size =
+        prepare_get_into_slices(query_result.value(), buffer, size, slices);
+    if (!total_size) {
+        return tl::unexpected(total_size.error());
+    }
+
+    // Step 3: Read data directly into user buffer
+    auto get_result = client_->Get(key, query_result.value(), slices);
+    if (!get_result) {
+        LOG(ERROR) << "Get failed for key: " << key
+                   << " with error: " << toString(get_result.error());
+        return tl::unexpected(get_result.error());
+    }
+
+    return static_cast<int64_t>(total_size.value());
+}
+
+tl::expected<uint64_t, ErrorCode> RealClient::prepare_get_into_slices(
+    const QueryResult &query_result, void *buffer, size_t size,
+    std::vector<Slice> &slices) {
     const std::vector<Replica::Descriptor> &replica_list =
-        query_result.value().replicas;
+        query_result.replicas;
 
     // Calculate total size from replica list
     if (replica_list.empty()) {
@@ -1366,18 +1767,8 @@ tl::expected<int64_t, ErrorCode> RealClient::get_into_internal(
 
     // Step 2: Split user buffer according to object info and create
     // slices
-    std::vector<mooncake::Slice> slices;
     allocateSlices(slices, replica, buffer);
-
-    // Step 3: Read data directly into user buffer
-    auto get_result = client_->Get(key, query_result.value(), slices);
-    if (!get_result) {
-        LOG(ERROR) << "Get failed for key: " << key
-                   << " with error: " << toString(get_result.error());
-        return tl::unexpected(get_result.error());
-    }
-
-    return static_cast<int64_t>(total_size);
+    return total_size;
 }
 
 int64_t RealClient::get_into(const std::string &key, void *buffer,
@@ -1385,6 +1776,80 @@ int64_t RealClient::get_into(const std::string &key, void *buffer,
     return to_py_ret(get_into_internal(key, buffer, size));
 }
 
+void RealClient::get_into_async(const std::string &key, void *buffer,
+                                size_t size,
+                                std::function<void(int64_t)> callback) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        callback(toInt(ErrorCode::INVALID_PARAMS));
+        return;
+    }
+    auto query_result = client_->Query(key);
+    if (!query_result) {
+        callback(toInt(query_result.error()));
+        return;
+    }
+    std::vector<mooncake::Slice> slices;
+    auto total_size =
+        prepare_get_into_slices(query_result.value(), buffer, size, slices);
+    if (!total_size) {
+        callback(toInt(total_size.error()));
+        return;
+    }
+    client_->AsyncGet(
+        key, query_result.value(), slices,
+        [total_size = total_size.value(),
+         callback = std::move(callback)](tl::expected<void, ErrorCode> result) {
+            callback(result ? static_cast<int64_t>(total_size)
+                            : to_py_ret(result));
+        });
+}
+
+void RealClient::batch_get_into_stream(
+    const std::vector<std::string> &keys, const std::vector<void *> &buffers,
+    const std::vector<size_t> &sizes,
+    std::function<void(size_t, int64_t)> callback) {
+    if (!client_ || keys.size() != buffers.size() ||
+        keys.size() != sizes.size()) {
+        LOG(ERROR) << "Client is not initialized or input sizes mismatch";
+        for (size_t i = 0; i < keys.size(); ++i) {
+            callback(i, toInt(ErrorCode::INVALID_PARAMS));
+        }
+        return;
+    }
+
+    auto query_results = client_->BatchQuery(keys);
+    std::unordered_map<std::string, std::vector<Slice>> slices;
+    std::vector<uint64_t> total_sizes(keys.size(), 0);
+    for (size_t i = 0; i < keys.size() && i < query_results.size(); ++i) {
+        if (!query_results[i]) {
+            continue;
+        }
+        if (slices.contains(keys[i])) {
+            LOG(ERROR) << "Duplicate key in batch_get_into_stream: " << keys[i];
+            query_results[i] = tl::unexpected(ErrorCode::INVALID_PARAMS);
+            continue;
+        }
+        std::vector<Slice> key_slices;
+        auto total_size = prepare_get_into_slices(
+            query_results[i].value(), buffers[i], sizes[i], key_slices);
+        if (!total_size) {
+            query_results[i] = tl::unexpected(total_size.error());
+            continue;
+        }
+        total_sizes[i] = total_size.value();
+        slices.emplace(keys[i], std::move(key_slices));
+    }
+
+    client_->StreamingBatchGet(
+        keys, query_results, slices,
+        [total_sizes = std::move(total_sizes), callback = std::move(callback)](
+            size_t index, tl::expected<void, ErrorCode> result) {
+            callback(index, result ? static_cast<int64_t>(total_sizes[index])
+                                   : to_py_ret(result));
+        });
+}
+
 std::string RealClient::get_hostname() const { return local_hostname; }
 
 std::vector<int> RealClient::batch_put_from(
@@ -1556,6 +2021,371 @@ int RealClient::put_from(const std::string &key, void *buffer, size_t size,
     return to_py_ret(put_from_internal(key, buffer, size, config));
 }
 
+namespace {
+
+// Layout of a broadcast, stored under its key
+struct BroadcastManifest {
+    uint64_t size;
+    uint64_t chunk_size;
+};
+
+// Chunk of a broadcast held by a node of the tree, the publisher is node 0
+// and subscriber rank r is node r + 1
+std::string BroadcastChunkKey(const std::string &key, int node, size_t chunk) {
+    if (node == 0) {
+        return key + "#" + std::to_string(chunk);
+    }
+    return key + "@" + std::to_string(node) + "#" + std::to_string(chunk);
+}
+
+}  // namespace
+
+tl::expected<QueryResult, ErrorCode> RealClient::wait_for_object(
+    const std::string &key, std::chrono::steady_clock::time_point deadline) {
+    auto backoff = std::chrono::microseconds(100);
+    while (true) {
+        auto query_result = client_->Query(key);
+        if (query_result) {
+            return query_result;
+        }
+        if (query_result.error() != ErrorCode::OBJECT_NOT_FOUND &&
+            query_result.error() != ErrorCode::REPLICA_IS_NOT_READY) {
+            LOG(ERROR) << "Query failed for key: " << key
+                       << " with error: " << toString(query_result.error());
+            return query_result;
+        }
+        if (std::chrono::steady_clock::now() + backoff > deadline) {
+            LOG(ERROR) << "Timed out waiting for key: " << key;
+            return query_result;
+        }
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min<std::chrono::microseconds>(
+            backoff * 2, std::chrono::milliseconds(10));
+    }
+}
+
+tl::expected<void, ErrorCode> RealClient::broadcast_publish_internal(
+    const std::string &key, void *buffer, size_t size, size_t chunk_size,
+    const ReplicateConfig &config) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (size == 0 || chunk_size == 0) {
+        LOG(ERROR) << "Invalid broadcast size " << size << " or chunk size "
+                   << chunk_size << " of key: " << key;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    // The manifest goes first so that subscribers start while the chunks
+    // are put
+    BroadcastManifest manifest{size, chunk_size};
+    auto result = put_internal(
+        key,
+        std::span<const char>(reinterpret_cast<const char *>(&manifest),
+                              sizeof(manifest)),
+        config, client_buffer_allocator_);
+    if (!result) {
+        return result;
+    }
+    for (size_t chunk = 0, offset = 0; offset < size;
+         ++chunk, offset += chunk_size) {
+        result = put_from_internal(BroadcastChunkKey(key, 0, chunk),
+                                   static_cast<char *>(buffer) + offset,
+                                   std::min(chunk_size, size - offset), config);
+        if (!result) {
+            LOG(ERROR) << "Failed to publish chunk " << chunk
+                       << " of key: " << key;
+            return result;
+        }
+    }
+    return {};
+}
+
+int RealClient::broadcast_publish(const std::string &key, void *buffer,
+                                  size_t size, size_t chunk_size,
+                                  const ReplicateConfig &config) {
+    return to_py_ret(
+        broadcast_publish_internal(key, buffer, size, chunk_size, config));
+}
+
+tl::expected<int64_t, ErrorCode> RealClient::broadcast_receive_internal(
+    const std::string &key, void *buffer, size_t size, int rank,
+    int num_subscribers, int fanout, int64_t timeout_ms) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (rank < 0 || rank >= num_subscribers || fanout < 1 || timeout_ms < 0) {
+        LOG(ERROR) << "Invalid rank " << rank << " of " << num_subscribers
+                   << " subscribers or fanout " << fanout;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    const auto timeout = std::chrono::milliseconds(timeout_ms);
+
+    auto manifest_query =
+        wait_for_object(key, std::chrono::steady_clock::now() + timeout);
+    if (!manifest_query) {
+        return tl::unexpected(manifest_query.error());
+    }
+    auto manifest_buffer = get_buffer_internal(key, client_buffer_allocator_);
+    if (!manifest_buffer ||
+        manifest_buffer->size() != sizeof(BroadcastManifest)) {
+        LOG(ERROR) << "Invalid broadcast manifest of key: " << key;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    BroadcastManifest manifest;
+    memcpy(&manifest, manifest_buffer->ptr(), sizeof(manifest));
+    if (manifest.size > size || manifest.chunk_size == 0) {
+        LOG(ERROR) << "Buffer of " << size << " bytes is too small for the "
+                   << "broadcast of " << manifest.size << " bytes of " << key;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    const int node = rank + 1;
+    const int parent = (node - 1) / fanout;
+    const bool has_children =
+        static_cast<int64_t>(node) * fanout + 1 <= num_subscribers;
+    // Forwarded chunks live in this client's segment, so that the children
+    // read them from its NIC
+    ReplicateConfig forward_config;
+    forward_config.replica_num = 1;
+    forward_config.preferred_segments = {local_hostname};
+
+    for (size_t chunk = 0, offset = 0; offset < manifest.size;
+         ++chunk, offset += manifest.chunk_size) {
+        const auto chunk_key = BroadcastChunkKey(key, parent, chunk);
+        const size_t chunk_size =
+            std::min<uint64_t>(manifest.chunk_size, manifest.size - offset);
+        char *chunk_ptr = static_cast<char *>(buffer) + offset;
+
+        auto query_result = wait_for_object(
+            chunk_key, std::chrono::steady_clock::now() + timeout);
+        if (!query_result) {
+            return tl::unexpected(query_result.error());
+        }
+        std::vector<Slice> slices;
+        for (size_t sliced = 0; sliced < chunk_size;) {
+            const size_t length = std::min(chunk_size - sliced, kMaxSliceSize);
+            slices.emplace_back(Slice{chunk_ptr + sliced, length});
+            sliced += length;
+        }
+        auto get_result = client_->Get(chunk_key, *query_result, slices);
+        if (!get_result) {
+            LOG(ERROR) << "Failed to receive chunk " << chunk
+                       << " of key: " << key;
+            return tl::unexpected(get_result.error());
+        }
+
+        if (has_children) {
+            auto put_result = put_from_internal(
+                BroadcastChunkKey(key, node, chunk), chunk_ptr, chunk_size,
+                forward_config);
+            if (!put_result &&
+                put_result.error() != ErrorCode::OBJECT_ALREADY_EXISTS) {
+                LOG(ERROR) << "Failed to forward chunk " << chunk
+                           << " of key: " << key;
+                return tl::unexpected(put_result.error());
+            }
+        }
+    }
+    return static_cast<int64_t>(manifest.size);
+}
+
+int64_t RealClient::broadcast_receive(const std::string &key, void *buffer,
+                                      size_t size, int rank,
+                                      int num_subscribers, int fanout,
+                                      int64_t timeout_ms) {
+    return to_py_ret(broadcast_receive_internal(
+        key, buffer, size, rank, num_subscribers, fanout, timeout_ms));
+}
+
+tl::expected<int64_t, ErrorCode> RealClient::get_into_ranges_internal(
+    const std::string &key, const std::vector<void *> &buffers,
+    const std::vector<size_t> &sizes) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (buffers.size() != sizes.size()) {
+        LOG(ERROR) << "Mismatched buffers and sizes of key: " << key;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    auto query_result = client_->Query(key);
+    if (!query_result) {
+        if (query_result.error() != ErrorCode::OBJECT_NOT_FOUND &&
+            query_result.error() != ErrorCode::REPLICA_IS_NOT_READY) {
+            LOG(ERROR) << "Query failed for key: " << key
+                       << " with error: " << toString(query_result.error());
+        }
+        return tl::unexpected(query_result.error());
+    }
+    const auto &replica = client_->GetPreferredReplica(
+        query_result.value().replicas);
+    if (!replica) {
+        LOG(ERROR) << "Empty replica list for key: " << key;
+        return tl::unexpected(ErrorCode::INVALID_REPLICA);
+    }
+    const uint64_t total_size = calculate_total_size(replica.value());
+
+    // The slices must cover the object exactly
+    std::vector<Slice> slices;
+    slices.reserve(buffers.size());
+    uint64_t remaining = total_size;
+    for (size_t i = 0; i < buffers.size() && remaining > 0; ++i) {
+        const uint64_t size = std::min<uint64_t>(sizes[i], remaining);
+        slices.emplace_back(Slice{buffers[i], size});
+        remaining -= size;
+    }
+    if (remaining > 0) {
+        LOG(ERROR) << "Ranges too small for key '" << key
+                   << "': required=" << total_size
+                   << ", available=" << total_size - remaining;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    auto get_result = client_->Get(key, query_result.value(), slices);
+    if (!get_result) {
+        LOG(ERROR) << "Get failed for key: " << key
+                   << " with error: " << toString(get_result.error());
+        return tl::unexpected(get_result.error());
+    }
+    return static_cast<int64_t>(total_size);
+}
+
+int64_t RealClient::get_into_ranges(const std::string &key,
+                                    const std::vector<void *> &buffers,
+                                    const std::vector<size_t> &sizes) {
+    return to_py_ret(get_into_ranges_internal(key, buffers, sizes));
+}
+
+tl::expected<int64_t, ErrorCode> RealClient::get_object_ranges_into_internal(
+    const std::string &key, const std::vector<uint64_t> &offsets,
+    const std::vector<void *> &buffers, const std::vector<size_t> &sizes) {
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (offsets.size() != buffers.size() || buffers.size() != sizes.size()) {
+        LOG(ERROR) << "Mismatched offsets, buffers and sizes of key: " << key;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    auto query_result = client_->Query(key);
+    if (!query_result) {
+        if (query_result.error() != ErrorCode::OBJECT_NOT_FOUND &&
+            query_result.error() != ErrorCode::REPLICA_IS_NOT_READY) {
+            LOG(ERROR) << "Query failed for key: " << key
+                       << " with error: " << toString(query_result.error());
+        }
+        return tl::unexpected(query_result.error());
+    }
+    const auto &replica =
+        client_->GetPreferredReplica(query_result.value().replicas);
+    if (!replica) {
+        LOG(ERROR) << "Empty replica list for key: " << key;
+        return tl::unexpected(ErrorCode::INVALID_REPLICA);
+    }
+
+    std::vector<Client::ObjectRange> ranges;
+    ranges.reserve(offsets.size());
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        ranges.push_back({offsets[i], Slice{buffers[i], sizes[i]}});
+    }
+    auto get_result = client_->GetRanges(key, query_result.value(), ranges);
+    if (!get_result) {
+        return tl::unexpected(get_result.error());
+    }
+    return static_cast<int64_t>(calculate_total_size(replica.value()));
+}
+
+int64_t RealClient::get_object_ranges_into(const std::string &key,
+                                           const std::vector<uint64_t> &offsets,
+                                           const std::vector<void *> &buffers,
+                                           const std::vector<size_t> &sizes) {
+    return to_py_ret(
+        get_object_ranges_into_internal(key, offsets, buffers, sizes));
+}
+
+tl::expected<void, ErrorCode> RealClient::put_from_ranges_internal(
+    const std::string &key, const std::vector<void *> &buffers,
+    const std::vector<size_t> &sizes, const ReplicateConfig &config) {
+    if (config.prefer_alloc_in_same_node) {
+        LOG(ERROR) << "prefer_alloc_in_same_node is not supported.";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (!client_) {
+        LOG(ERROR) << "Client is not initialized";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (buffers.size() != sizes.size()) {
+        LOG(ERROR) << "Mismatched buffers and sizes of key: " << key;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    std::vector<Slice> slices;
+    slices.reserve(buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        // Regions larger than a slice are split like in put_from
+        uint64_t offset = 0;
+        while (offset < sizes[i]) {
+            auto chunk_size = std::min(sizes[i] - offset, kMaxSliceSize);
+            slices.emplace_back(
+                Slice{static_cast<char *>(buffers[i]) + offset, chunk_size});
+            offset += chunk_size;
+        }
+    }
+    if (slices.empty()) {
+        LOG(WARNING) << "Attempting to put empty data for key: " << key;
+        return {};
+    }
+
+    auto put_result = client_->Put(key, slices, config);
+    if (!put_result) {
+        return tl::unexpected(put_result.error());
+    }
+    return {};
+}
+
+int RealClient::put_from_ranges(const std::string &key,
+                                const std::vector<void *> &buffers,
+                                const std::vector<size_t> &sizes,
+                                const ReplicateConfig &config) {
+    return to_py_ret(put_from_ranges_internal(key, buffers, sizes, config));
+}
+
+void RealClient::put_from_async(const std::string &key, void *buffer,
+                                size_t size, const ReplicateConfig &config,
+                                std::function<void(int)> callback) {
+    if (config.prefer_alloc_in_same_node || !client_) {
+        LOG(ERROR) << "prefer_alloc_in_same_node is not supported or client "
+                      "is not initialized";
+        callback(toInt(ErrorCode::INVALID_PARAMS));
+        return;
+    }
+    if (size == 0) {
+        LOG(WARNING) << "Attempting to put empty data for key: " << key;
+        callback(0);
+        return;
+    }
+
+    std::vector<mooncake::Slice> slices;
+    uint64_t offset = 0;
+    while (offset < size) {
+        auto chunk_size = std::min(size - offset, kMaxSliceSize);
+        void *chunk_ptr = static_cast<char *>(buffer) + offset;
+        slices.emplace_back(Slice{chunk_ptr, chunk_size});
+        offset += chunk_size;
+    }
+
+    client_->AsyncPut(key, slices, config,
+                      [callback = std::move(callback)](
+                          tl::expected<void, ErrorCode> result) {
+                          callback(to_py_ret(result));
+                      });
+}
+
 std::vector<int64_t> RealClient::batch_get_into(
     const std::vector<std::string> &keys, const std::vector<void *> &buffers,
     const std::vector<size_t> &sizes) {
@@ -1624,6 +2454,108 @@ RealClient::batch_get_into_dummy_helper(
     return batch_get_into_internal(keys, buffers, sizes);
 }
 
+tl::expected<std::vector<void *>, ErrorCode> RealClient::map_dummy_buffers(
+    const UUID &client_id, const std::vector<uint64_t> &dummy_buffers,
+    const std::vector<size_t> &sizes) const {
+    auto it = shm_contexts_.find(client_id);
+    if (it == shm_contexts_.end()) {
+        LOG(ERROR) << "client_id=" << client_id << ", error=shm_not_mapped";
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    if (dummy_buffers.size() != sizes.size()) {
+        LOG(ERROR) << "Mismatched buffers and sizes of client " << client_id;
+        return tl::unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    std::vector<void *> buffers;
+    buffers.reserve(dummy_buffers.size());
+    for (size_t i = 0; i < dummy_buffers.size(); ++i) {
+        const uint64_t dummy_addr = dummy_buffers[i];
+        const auto &mapped_shms = it->second.mapped_shms;
+        auto shm = std::find_if(
+            mapped_shms.begin(), mapped_shms.end(),
+            [&](const MappedShm &mapped) {
+                return dummy_addr >= mapped.dummy_base_addr &&
+                       dummy_addr + sizes[i] <=
+                           mapped.dummy_base_addr + mapped.shm_size;
+            });
+        if (shm == mapped_shms.end()) {
+            LOG(ERROR) << "Dummy buffer at " << dummy_addr << " (size "
+                       << sizes[i] << ") "
+                       << "not found in any mapped shared memory for client "
+                       << client_id;
+            return tl::unexpected(ErrorCode::INVALID_PARAMS);
+        }
+        buffers.push_back(
+            reinterpret_cast<void *>(dummy_addr + shm->shm_addr_offset));
+    }
+    return buffers;
+}
+
+tl::expected<int64_t, ErrorCode> RealClient::get_into_ranges_dummy_helper(
+    const std::string &key, const std::vector<uint64_t> &dummy_buffers,
+    const std::vector<size_t> &sizes, const UUID &client_id) {
+    std::shared_lock<std::shared_mutex> lock(dummy_client_mutex_);
+    auto buffers = map_dummy_buffers(client_id, dummy_buffers, sizes);
+    if (!buffers) {
+        return tl::unexpected(buffers.error());
+    }
+    return get_into_ranges_internal(key, buffers.value(), sizes);
+}
+
+tl::expected<void, ErrorCode> RealClient::broadcast_publish_dummy_helper(
+    const std::string &key, uint64_t dummy_buffer, size_t size,
+    size_t chunk_size, const ReplicateConfig &config, const UUID &client_id) {
+    std::shared_lock<std::shared_mutex> lock(dummy_client_mutex_);
+    auto buffers = map_dummy_buffers(client_id, {dummy_buffer}, {size});
+    if (!buffers) {
+        return tl::unexpected(buffers.error());
+    }
+    return broadcast_publish_internal(key, buffers.value()[0], size,
+                                      chunk_size, config);
+}
+
+tl::expected<int64_t, ErrorCode> RealClient::broadcast_receive_dummy_helper(
+    const std::string &key, uint64_t dummy_buffer, size_t size, int rank,
+    int num_subscribers, int fanout, int64_t timeout_ms,
+    const UUID &client_id) {
+    // Held while waiting for the chunks, which only delays the unmapping of
+    // the dummy client's shared memory
+    std::shared_lock<std::shared_mutex> lock(dummy_client_mutex_);
+    auto buffers = map_dummy_buffers(client_id, {dummy_buffer}, {size});
+    if (!buffers) {
+        return tl::unexpected(buffers.error());
+    }
+    return broadcast_receive_internal(key, buffers.value()[0], size, rank,
+                                      num_subscribers, fanout, timeout_ms);
+}
+
+tl::expected<int64_t, ErrorCode>
+RealClient::get_object_ranges_into_dummy_helper(
+    const std::string &key, const std::vector<uint64_t> &offsets,
+    const std::vector<uint64_t> &dummy_buffers,
+    const std::vector<size_t> &sizes, const UUID &client_id) {
+    std::shared_lock<std::shared_mutex> lock(dummy_client_mutex_);
+    auto buffers = map_dummy_buffers(client_id, dummy_buffers, sizes);
+    if (!buffers) {
+        return tl::unexpected(buffers.error());
+    }
+    return get_object_ranges_into_internal(key, offsets, buffers.value(),
+                                           sizes);
+}
+
+tl::expected<void, ErrorCode> RealClient::put_from_ranges_dummy_helper(
+    const std::string &key, const std::vector<uint64_t> &dummy_buffers,
+    const std::vector<size_t> &sizes, const ReplicateConfig &config,
+    const UUID &client_id) {
+    std::shared_lock<std::shared_mutex> lock(dummy_client_mutex_);
+    auto buffers = map_dummy_buffers(client_id, dummy_buffers, sizes);
+    if (!buffers) {
+        return tl::unexpected(buffers.error());
+    }
+    return put_from_ranges_internal(key, buffers.value(), sizes, config);
+}
+
 std::vector<tl::expected<int64_t, ErrorCode>>
 RealClient::batch_get_into_internal(const std::vector<std::string> &keys,
                                     const std::vector<void *> &buffers,
@@ -2037,7 +2969,7 @@ RealClient::batch_get_into_multi_buffers_internal(
         const auto &buffers = all_buffers[i];
         std::vector<Slice> key_slices;
         key_slices.reserve(buffers.size());
-        if (replica.is_memory_replica()) {
+        if (replica.is_memory_replica() || replica.is_striped_replica()) {
             for (size_t j = 0; j < buffers.size(); ++j) {
                 key_slices.emplace_back(Slice{buffers[j], sizes[j]});
             }
@@ -2214,6 +3146,48 @@ static int recv_fd(int socket, void *data, size_t data_len) {
     return -1;
 }
 
+static int send_fd(int socket, int fd, const void *data, size_t data_len) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    struct iovec iov;
+    char buf[CMSG_SPACE(sizeof(int))];
+    memset(buf, 0, sizeof(buf));
+
+    iov.iov_base = const_cast<void *>(data);
+    iov.iov_len = data_len;
+
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    return sendmsg(socket, &msg, 0);
+}
+
+void RealClient::export_segments_via_ipc(int client_sock) {
+    uint32_t count = exported_segments_.size();
+    if (send(client_sock, &count, sizeof(count), 0) < 0) {
+        LOG(ERROR) << "Failed to send segment count to client";
+        return;
+    }
+    for (const auto &seg : exported_segments_) {
+        SegmentExportEntry entry;
+        entry.real_base_addr = reinterpret_cast<uint64_t>(seg.base);
+        entry.size = seg.size;
+        if (send_fd(client_sock, seg.fd, &entry, sizeof(entry)) < 0) {
+            LOG(ERROR) << "Failed to send segment to client: "
+                       << strerror(errno);
+            return;
+        }
+    }
+}
+
 void RealClient::ipc_server_func() {
     int server_sock = socket(AF_UNIX, SOCK_STREAM, 0);
     if (server_sock < 0) {
@@ -2257,9 +3231,16 @@ void RealClient::ipc_server_func() {
             break;
         }
 
-        ShmRegisterRequest req;
+        ShmRegisterRequest req{};
         int fd = recv_fd(client_sock, &req, sizeof(req));
 
+        if (req.op == kShmIpcExportSegments) {
+            if (fd >= 0) close(fd);
+            export_segments_via_ipc(client_sock);
+            close(client_sock);
+            continue;
+        }
+
         int status = 0;
         if (fd < 0) {
             LOG(ERROR) << "Failed to receive FD from client";
@@ -2347,7 +3328,8 @@ tl::expected<QueryTaskResponse, ErrorCode> RealClient::query_task(
 tl::expected<BatchGetOffloadObjectResponse, ErrorCode>
 RealClient::batch_get_offload_object(const std::vector<std::string> &keys,
                                      const std::vector<int64_t> &sizes) {
-    auto result = file_storage_->BatchGet(keys, sizes);
+    uint64_t batch_id = 0;
+    auto result = file_storage_->BatchGet(keys, sizes, batch_id);
     if (!result) {
         LOG(ERROR) << "Batch get offload object failed,err_code = "
                    << result.error();
@@ -2355,7 +3337,16 @@ RealClient::batch_get_offload_object(const std::vector<std::string> &keys,
     }
     return BatchGetOffloadObjectResponse(
         std::move(result.value()), client_->GetTransportEndpoint(),
-        file_storage_->config_.client_buffer_gc_ttl_ms);
+        file_storage_->config_.client_buffer_gc_ttl_ms, batch_id);
+}
+
+tl::expected<void, ErrorCode> RealClient::release_offload_object(
+    uint64_t batch_id) {
+    if (!file_storage_) {
+        return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+    }
+    file_storage_->ReleaseBatch(batch_id);
+    return {};
 }
 
 tl::expected<void, ErrorCode>
@@ -2379,6 +3370,15 @@ RealClient::batch_get_into_offload_object_internal(
     auto result =
         client_->BatchGetOffloadObject(batchGetResp->transfer_engine_addr, keys,
                                        batchGetResp->pointers, objects);
+    // Hand the staging buffer back whether or not the transfer succeeded,
+    // the remote client reclaims it on lease expiry if this is lost
+    auto release_result = client_requester_->release_offload_object(
+        target_rpc_service_addr, batchGetResp->batch_id);
+    if (!release_result) {
+        LOG(WARNING) << "Failed to release offload batch "
+                     << batchGetResp->batch_id << " on "
+                     << target_rpc_service_addr;
+    }
     auto end_time = std::chrono::steady_clock::now();
     auto elapsed_time = static_cast<uint64_t>(
         std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
@@ -2427,6 +3427,17 @@ ClientRequester::batch_get_offload_object(const std::string &client_addr,
     return result;
 }
 
+tl::expected<void, ErrorCode> ClientRequester::release_offload_object(
+    const std::string &client_addr, uint64_t batch_id) {
+    auto result = invoke_rpc<&RealClient::release_offload_object, void>(
+        client_addr, batch_id);
+    if (!result) {
+        LOG(ERROR) << "Failed to invoke release_offload_object, client_addr = "
+                   << client_addr << ", error is: " << result.error();
+    }
+    return result;
+}
+
 template <auto ServiceMethod, typename ReturnType, typename... Args>
 tl::expected<ReturnType, ErrorCode> ClientRequester::invoke_rpc(
     const std::string &client_addr, Args &&...args) {
@@ -30,13 +30,26 @@ void RegisterClientRpcService(coro_rpc::coro_rpc_server &server,
     server.register_handler<&RealClient::removeAll_internal>(&real_client);
     server.register_handler<&RealClient::isExist_internal>(&real_client);
     server.register_handler<&RealClient::batchIsExist_internal>(&real_client);
+    server.register_handler<&RealClient::prefetch_internal>(&real_client);
     server.register_handler<&RealClient::getSize_internal>(&real_client);
     server.register_handler<&RealClient::get_buffer_info_dummy_helper>(
         &real_client);
+    server.register_handler<&RealClient::get_zero_copy_dummy_helper>(
+        &real_client);
     server.register_handler<&RealClient::batch_put_from_dummy_helper>(
         &real_client);
     server.register_handler<&RealClient::batch_get_into_dummy_helper>(
         &real_client);
+    server.register_handler<&RealClient::get_into_ranges_dummy_helper>(
+        &real_client);
+    server.register_handler<&RealClient::get_object_ranges_into_dummy_helper>(
+        &real_client);
+    server.register_handler<&RealClient::put_from_ranges_dummy_helper>(
+        &real_client);
+    server.register_handler<&RealClient::broadcast_publish_dummy_helper>(
+        &real_client);
+    server.register_handler<&RealClient::broadcast_receive_dummy_helper>(
+        &real_client);
     server.register_handler<&RealClient::map_shm_internal>(&real_client);
     server.register_handler<&RealClient::unmap_shm_internal>(&real_client);
     server.register_handler<&RealClient::unregister_shm_buffer_internal>(
@@ -48,6 +61,8 @@ void RegisterClientRpcService(coro_rpc::coro_rpc_server &server,
     server.register_handler<&RealClient::query_task>(&real_client);
     server.register_handler<&RealClient::batch_get_offload_object>(
         &real_client);
+    server.register_handler<&RealClient::release_offload_object>(
+        &real_client);
 }
 }  // namespace mooncake
 
@@ -0,0 +1,175 @@
+#include "registration_cache.h"
+
+#include <glog/logging.h>
+
+#include <utility>
+
+namespace mooncake {
+
+RegistrationCache::RegistrationCache(RegisterFunc register_func,
+                                     UnregisterFunc unregister_func,
+                                     size_t idle_capacity)
+    : register_func_(std::move(register_func)),
+      unregister_func_(std::move(unregister_func)),
+      idle_capacity_(idle_capacity) {}
+
+RegistrationCache::RegionMap::iterator RegistrationCache::FindContaining(
+    uintptr_t begin, size_t length) {
+    auto it = regions_.upper_bound(begin);
+    if (it == regions_.begin()) {
+        return regions_.end();
+    }
+    --it;
+    if (begin - it->first > it->second.length ||
+        length > it->second.length - (begin - it->first)) {
+        return regions_.end();
+    }
+    return it;
+}
+
+tl::expected<void, ErrorCode> RegistrationCache::Register(
+    void* addr, size_t length, const std::string& location) {
+    const auto begin = reinterpret_cast<uintptr_t>(addr);
+    MutexLocker lock(&mutex_);
+    auto it = FindContaining(begin, length);
+    if (it != regions_.end() && !it->second.stale &&
+        it->second.location == location) {
+        Region& region = it->second;
+        if (region.idle) {
+            idle_.erase(region.idle_it);
+            idle_bytes_ -= region.length;
+            region.idle = false;
+        }
+        region.refs++;
+        auto& handle = handles_[begin];
+        handle.first = it->first;
+        handle.second++;
+        hits_++;
+        return {};
+    }
+    misses_++;
+
+    // Idle regions in the way belong to memory that has been remapped
+    bool busy_overlap = false;
+    auto next = regions_.upper_bound(begin);
+    if (next != regions_.begin()) {
+        --next;
+    }
+    while (next != regions_.end() && next->first < begin + length) {
+        auto current = next++;
+        if (current->first + current->second.length <= begin) {
+            continue;
+        }
+        if (current->second.idle) {
+            DeregisterLocked(current);
+        } else {
+            busy_overlap = true;
+        }
+    }
+
+    auto result = register_func_(addr, length, location);
+    if (!result) {
+        return result;
+    }
+    if (busy_overlap) {
+        // Left to the transfer engine, released by Unregister directly
+        VLOG(1) << "addr=" << addr << ", length=" << length
+                << ", info=registration_overlaps_busy_region";
+        return {};
+    }
+    Region region;
+    region.length = length;
+    region.location = location;
+    region.refs = 1;
+    regions_.emplace(begin, std::move(region));
+    auto& handle = handles_[begin];
+    handle.first = begin;
+    handle.second++;
+    return {};
+}
+
+tl::expected<void, ErrorCode> RegistrationCache::Unregister(void* addr) {
+    const auto begin = reinterpret_cast<uintptr_t>(addr);
+    MutexLocker lock(&mutex_);
+    auto handle_it = handles_.find(begin);
+    if (handle_it == handles_.end()) {
+        return unregister_func_(addr);
+    }
+    auto it = regions_.find(handle_it->second.first);
+    if (--handle_it->second.second == 0) {
+        handles_.erase(handle_it);
+    }
+    if (it == regions_.end()) {
+        return {};
+    }
+    Region& region = it->second;
+    if (--region.refs > 0) {
+        return {};
+    }
+    if (region.stale || idle_capacity_ == 0) {
+        DeregisterLocked(it);
+        return {};
+    }
+    region.idle = true;
+    region.idle_it = idle_.insert(idle_.end(), it->first);
+    idle_bytes_ += region.length;
+    EvictIdleLocked();
+    return {};
+}
+
+void RegistrationCache::Invalidate(void* addr, size_t length) {
+    const auto begin = reinterpret_cast<uintptr_t>(addr);
+    MutexLocker lock(&mutex_);
+    auto next = regions_.upper_bound(begin);
+    if (next != regions_.begin()) {
+        --next;
+    }
+    while (next != regions_.end() && next->first < begin + length) {
+        auto current = next++;
+        if (current->first + current->second.length <= begin) {
+            continue;
+        }
+        if (current->second.idle) {
+            DeregisterLocked(current);
+        } else {
+            current->second.stale = true;
+        }
+    }
+}
+
+void RegistrationCache::Clear() {
+    MutexLocker lock(&mutex_);
+    while (!regions_.empty()) {
+        DeregisterLocked(regions_.begin());
+    }
+    handles_.clear();
+}
+
+RegistrationCache::Stats RegistrationCache::GetStats() const {
+    MutexLocker lock(&mutex_);
+    return Stats{hits_, misses_, regions_.size(), idle_bytes_};
+}
+
+void RegistrationCache::DeregisterLocked(RegionMap::iterator it) {
+    Region& region = it->second;
+    if (region.idle) {
+        idle_.erase(region.idle_it);
+        idle_bytes_ -= region.length;
+    }
+    auto result = unregister_func_(reinterpret_cast<void*>(it->first));
+    if (!result) {
+        LOG(WARNING) << "addr=" << reinterpret_cast<void*>(it->first)
+                     << ", length=" << region.length
+                     << ", error=unregister_failed, code="
+                     << toString(result.error());
+    }
+    regions_.erase(it);
+}
+
+void RegistrationCache::EvictIdleLocked() {
+    while (idle_bytes_ > idle_capacity_ && !idle_.empty()) {
+        DeregisterLocked(regions_.find(idle_.front()));
+    }
+}
+
+}  // namespace mooncake
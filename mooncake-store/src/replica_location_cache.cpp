@@ -0,0 +1,135 @@
+#include "replica_location_cache.h"
+
+#include <cctype>
+
+namespace mooncake {
+
+ReplicaLocationCache::ReplicaLocationCache(size_t capacity)
+    : capacity_per_shard_(capacity == 0 ? 0
+                                        : (capacity + kNumShards - 1) /
+                                              kNumShards) {}
+
+uint64_t ReplicaLocationCache::generation() const {
+    std::lock_guard<std::mutex> lock(epoch_mutex_);
+    return generation_;
+}
+
+std::optional<ReplicaLocationCache::Entry> ReplicaLocationCache::Get(
+    const std::string& key) const {
+    if (!enabled()) {
+        return std::nullopt;
+    }
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        return std::nullopt;
+    }
+    if (std::chrono::steady_clock::now() >= it->second.serve_until) {
+        shard.entries.erase(it);
+        return std::nullopt;
+    }
+    return it->second.entry;
+}
+
+void ReplicaLocationCache::Put(
+    const std::string& key, uint64_t generation,
+    const std::vector<Replica::Descriptor>& replicas,
+    std::chrono::steady_clock::time_point query_time,
+    std::chrono::steady_clock::time_point lease_timeout) {
+    if (!enabled() || lease_timeout <= query_time) {
+        return;
+    }
+    Shard& shard = GetShard(key);
+    // Hold the epoch lock so that no invalidation can be missed between
+    // the generation check and the insertion.
+    std::lock_guard<std::mutex> epoch_lock(epoch_mutex_);
+    if (generation != generation_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto now = std::chrono::steady_clock::now();
+    if (shard.entries.size() >= capacity_per_shard_ &&
+        !shard.entries.contains(key)) {
+        std::erase_if(shard.entries, [&now](const auto& item) {
+            return now >= item.second.serve_until;
+        });
+        if (shard.entries.size() >= capacity_per_shard_) {
+            shard.entries.erase(shard.entries.begin());
+        }
+    }
+    shard.entries.insert_or_assign(
+        key, CachedEntry{Entry{replicas, lease_timeout},
+                         query_time + (lease_timeout - query_time) / 2});
+}
+
+void ReplicaLocationCache::Invalidate(const std::string& key) {
+    if (!enabled()) {
+        return;
+    }
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> epoch_lock(epoch_mutex_);
+    generation_++;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.erase(key);
+}
+
+void ReplicaLocationCache::Clear() {
+    std::lock_guard<std::mutex> epoch_lock(epoch_mutex_);
+    generation_++;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+    }
+}
+
+void ReplicaLocationCache::SyncEpoch(uint64_t view_version,
+                                     uint64_t invalidation_epoch) {
+    {
+        std::lock_guard<std::mutex> epoch_lock(epoch_mutex_);
+        const std::pair<uint64_t, uint64_t> epoch{view_version,
+                                                  invalidation_epoch};
+        if (last_epoch_ == epoch) {
+            return;
+        }
+        last_epoch_ = epoch;
+    }
+    Clear();
+}
+
+size_t ReplicaLocationCache::size() const {
+    size_t size = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.entries.size();
+    }
+    return size;
+}
+
+std::vector<std::string> ChainSuccessorKeys(const std::string& key,
+                                            size_t count) {
+    std::vector<std::string> successors;
+    size_t digits_begin = key.size();
+    while (digits_begin > 0 &&
+           std::isdigit(static_cast<unsigned char>(key[digits_begin - 1]))) {
+        digits_begin--;
+    }
+    // Numbers too long for uint64_t are hashes rather than indexes
+    const size_t width = key.size() - digits_begin;
+    if (width == 0 || width > 18) {
+        return successors;
+    }
+    const uint64_t index = std::stoull(key.substr(digits_begin));
+    successors.reserve(count);
+    for (uint64_t i = 1; i <= count; i++) {
+        std::string number = std::to_string(index + i);
+        if (number.size() < width) {
+            // Keep the zero padding
+            number.insert(0, width - number.size(), '0');
+        }
+        successors.push_back(key.substr(0, digits_begin) + number);
+    }
+    return successors;
+}
+
+}  // namespace mooncake
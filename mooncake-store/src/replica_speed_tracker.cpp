@@ -0,0 +1,94 @@
+#include "replica_speed_tracker.h"
+
+#include <algorithm>
+
+namespace mooncake {
+
+namespace {
+
+double Ewma(const std::optional<double>& average, double sample) {
+    if (!average) {
+        return sample;
+    }
+    return ReplicaSpeedTracker::kAlpha * sample +
+           (1 - ReplicaSpeedTracker::kAlpha) * *average;
+}
+
+}  // namespace
+
+ReplicaSpeedTracker::ReplicaSpeedTracker(std::chrono::milliseconds ttl)
+    : ttl_(ttl) {}
+
+void ReplicaSpeedTracker::Record(const std::string& endpoint, uint64_t size,
+                                 uint64_t latency_us) {
+    Update(endpoint, size, static_cast<double>(std::max<uint64_t>(
+                               latency_us, 1)));
+}
+
+void ReplicaSpeedTracker::RecordFailure(const std::string& endpoint) {
+    // Penalize the latency whatever the size, a failure says nothing about
+    // the bandwidth
+    Update(endpoint, 0, static_cast<double>(kFailurePenaltyUs));
+}
+
+void ReplicaSpeedTracker::Update(const std::string& endpoint, uint64_t size,
+                                 double latency_us) {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& speed = speeds_[endpoint];
+    if (now - speed.updated > ttl_) {
+        speed = Speed{};
+    }
+    if (size <= kLatencyBoundSize) {
+        speed.latency_us = Ewma(speed.latency_us, latency_us);
+    } else {
+        speed.bytes_per_us =
+            Ewma(speed.bytes_per_us, static_cast<double>(size) / latency_us);
+    }
+    speed.updated = now;
+}
+
+std::optional<double> ReplicaSpeedTracker::Estimate(
+    const std::string& endpoint, uint64_t size) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return EstimateLocked(endpoint, size);
+}
+
+std::optional<double> ReplicaSpeedTracker::EstimateLocked(
+    const std::string& endpoint, uint64_t size) const {
+    auto it = speeds_.find(endpoint);
+    if (it == speeds_.end() ||
+        std::chrono::steady_clock::now() - it->second.updated > ttl_) {
+        return std::nullopt;
+    }
+    const auto& speed = it->second;
+    // A small read costs its latency, a large one its size at the bandwidth
+    if (size <= kLatencyBoundSize || !speed.bytes_per_us) {
+        if (!speed.latency_us) {
+            return std::nullopt;
+        }
+        return *speed.latency_us;
+    }
+    return speed.latency_us.value_or(0) +
+           static_cast<double>(size) / *speed.bytes_per_us;
+}
+
+size_t ReplicaSpeedTracker::PickFastest(
+    const std::vector<std::string>& endpoints, uint64_t size) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t fastest = 0;
+    std::optional<double> fastest_us;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        auto estimate = EstimateLocked(endpoints[i], size);
+        if (!estimate) {
+            return i;
+        }
+        if (!fastest_us || *estimate < *fastest_us) {
+            fastest = i;
+            fastest_us = estimate;
+        }
+    }
+    return fastest;
+}
+
+}  // namespace mooncake
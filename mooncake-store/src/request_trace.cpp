@@ -0,0 +1,194 @@
+#include "request_trace.h"
+
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <random>
+
+namespace mooncake {
+
+namespace {
+
+class SpanExporter {
+   public:
+    SpanExporter() {
+        const char* rate = std::getenv("MC_STORE_TRACE_SAMPLE_RATE");
+        const char* path = std::getenv("MC_STORE_TRACE_FILE");
+        Configure(rate ? std::atof(rate) : 0.0,
+                  path ? path
+                       : "mooncake_trace_" + std::to_string(getpid()) +
+                             ".jsonl");
+    }
+
+    ~SpanExporter() {
+        if (file_) {
+            fclose(file_);
+        }
+    }
+
+    void Configure(double sample_rate, const std::string& path) {
+        std::lock_guard lock(mutex_);
+        if (file_) {
+            fclose(file_);
+            file_ = nullptr;
+        }
+        if (sample_rate > 0) {
+            file_ = fopen(path.c_str(), "a");
+            if (!file_) {
+                LOG(ERROR) << "Failed to open trace file " << path
+                           << ", tracing disabled";
+                sample_rate = 0;
+            } else {
+                LOG(INFO) << "Tracing " << sample_rate
+                          << " of the requests to " << path;
+            }
+        }
+        threshold_.store(
+            sample_rate >= 1 ? std::numeric_limits<uint64_t>::max()
+            : sample_rate <= 0
+                ? 0
+                : static_cast<uint64_t>(
+                      sample_rate *
+                      static_cast<double>(
+                          std::numeric_limits<uint64_t>::max())),
+            std::memory_order_relaxed);
+    }
+
+    uint64_t threshold() const {
+        return threshold_.load(std::memory_order_relaxed);
+    }
+
+    void Write(const std::string& line) {
+        std::lock_guard lock(mutex_);
+        if (file_) {
+            fputs(line.c_str(), file_);
+            fflush(file_);
+        }
+    }
+
+   private:
+    std::mutex mutex_;
+    FILE* file_ = nullptr;
+    std::atomic<uint64_t> threshold_{0};
+};
+
+SpanExporter& Exporter() {
+    static SpanExporter exporter;
+    return exporter;
+}
+
+uint64_t RandomId() {
+    static thread_local std::mt19937_64 generator(std::random_device{}());
+    uint64_t id;
+    do {
+        id = generator();
+    } while (id == 0);
+    return id;
+}
+
+uint64_t NowUnixNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+void AppendHex(std::string& out, uint64_t value) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx",
+             static_cast<unsigned long long>(value));
+    out += buffer;
+}
+
+void AppendJsonString(std::string& out, std::string_view value) {
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buffer[7];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            out += buffer;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+}  // namespace
+
+void TraceSpan::Configure(double sample_rate, const std::string& path) {
+    Exporter().Configure(sample_rate, path);
+}
+
+bool TraceSpan::Sample() {
+    const uint64_t threshold = Exporter().threshold();
+    if (threshold == 0) {
+        return false;
+    }
+    return threshold == std::numeric_limits<uint64_t>::max() ||
+           RandomId() < threshold;
+}
+
+void TraceSpan::Begin() {
+    parent_ = current_;
+    if (parent_) {
+        trace_id_high_ = parent_->trace_id_high_;
+        trace_id_low_ = parent_->trace_id_low_;
+        parent_span_id_ = parent_->span_id_;
+    } else {
+        trace_id_high_ = RandomId();
+        trace_id_low_ = RandomId();
+    }
+    span_id_ = RandomId();
+    start_ns_ = NowUnixNs();
+    active_ = true;
+    current_ = this;
+}
+
+void TraceSpan::End() {
+    const uint64_t end_ns = NowUnixNs();
+    current_ = parent_;
+    active_ = false;
+
+    std::string line = "{\"traceId\":\"";
+    AppendHex(line, trace_id_high_);
+    AppendHex(line, trace_id_low_);
+    line += "\",\"spanId\":\"";
+    AppendHex(line, span_id_);
+    line += "\",";
+    if (parent_span_id_ != 0) {
+        line += "\"parentSpanId\":\"";
+        AppendHex(line, parent_span_id_);
+        line += "\",";
+    }
+    line += "\"name\":";
+    AppendJsonString(line, name_);
+    line += ",\"startTimeUnixNano\":\"" + std::to_string(start_ns_) +
+            "\",\"endTimeUnixNano\":\"" + std::to_string(end_ns) +
+            "\",\"attributes\":[" + attributes_ + "]}\n";
+    Exporter().Write(line);
+}
+
+void TraceSpan::AddAttribute(const char* key, std::string_view value,
+                             bool is_string) {
+    if (!attributes_.empty()) {
+        attributes_ += ',';
+    }
+    attributes_ += "{\"key\":";
+    AppendJsonString(attributes_, key);
+    // OTLP JSON encodes 64-bit integers as strings too
+    attributes_ += is_string ? ",\"value\":{\"stringValue\":"
+                             : ",\"value\":{\"intValue\":";
+    AppendJsonString(attributes_, value);
+    attributes_ += "}}";
+}
+
+}  // namespace mooncake
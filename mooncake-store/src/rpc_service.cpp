@@ -17,6 +17,7 @@
 
 #include "master_metric_manager.h"
 #include "master_service.h"
+#include "metadata_follower.h"
 #include "rpc_helper.h"
 #include "types.h"
 #include "utils/scoped_vlog_timer.h"
@@ -25,10 +26,43 @@
 namespace mooncake {
 
 const uint64_t kMetricReportIntervalSeconds = 10;
+// Number of most contended metadata shards served on /metrics/hot_shards
+const size_t kHotShardsReported = 16;
+
+namespace {
+
+// A change is acked once it is in the metadata WAL on disk, see
+// MasterService::SyncMetadata
+template <typename T>
+tl::expected<T, ErrorCode> Synced(MasterService& service,
+                                  tl::expected<T, ErrorCode> result) {
+    auto err = service.SyncMetadata();
+    if (err != ErrorCode::OK && result.has_value()) {
+        return tl::make_unexpected(err);
+    }
+    return result;
+}
+
+template <typename T>
+void Synced(MasterService& service,
+            std::vector<tl::expected<T, ErrorCode>>& results) {
+    auto err = service.SyncMetadata();
+    if (err == ErrorCode::OK) {
+        return;
+    }
+    for (auto& result : results) {
+        if (result.has_value()) {
+            result = tl::make_unexpected(err);
+        }
+    }
+}
+
+}  // namespace
 
 WrappedMasterService::WrappedMasterService(
     const WrappedMasterServiceConfig& config)
-    : master_service_(MasterServiceConfig(config)),
+    : master_service_(
+          std::make_unique<MasterService>(MasterServiceConfig(config))),
       http_server_(4, config.http_port),
       metric_report_running_(config.enable_metric_reporting) {
     init_http_server();
@@ -46,6 +80,12 @@ WrappedMasterService::WrappedMasterService(
     }
 }
 
+WrappedMasterService::WrappedMasterService(
+    std::shared_ptr<MetadataFollower> standby_follower)
+    : standby_follower_(std::move(standby_follower)),
+      http_server_(1, 0),
+      metric_report_running_(false) {}
+
 WrappedMasterService::~WrappedMasterService() {
     metric_report_running_ = false;
     if (metric_report_thread_.joinable()) {
@@ -58,7 +98,18 @@ void WrappedMasterService::init_http_server() {
     using namespace coro_http;
 
     http_server_.set_http_handler<GET>(
-        "/metrics", [](coro_http_request& req, coro_http_response& resp) {
+        "/metrics", [&](coro_http_request& req, coro_http_response& resp) {
+            int64_t contended = 0;
+            int64_t wait_us = 0;
+            for (const auto& [shard, stats] :
+                 master_service_->GetShardLockStats()) {
+                contended += stats.contended;
+                wait_us += stats.wait_us;
+            }
+            MasterMetricManager::instance().set_shard_lock_contention(
+                contended, wait_us);
+            MasterMetricManager::instance().set_segment_allocator_stats(
+                master_service_->GetSegmentAllocatorStats());
             std::string metrics =
                 MasterMetricManager::instance().serialize_metrics();
             resp.add_header("Content-Type", "text/plain; version=0.0.4");
@@ -74,6 +125,37 @@ void WrappedMasterService::init_http_server() {
             resp.set_status_and_content(status_type::ok, std::move(summary));
         });
 
+    http_server_.set_http_handler<GET>(
+        "/metrics/hot_keys",
+        [&](coro_http_request& req, coro_http_response& resp) {
+            std::string ss;
+            for (const auto& hot : master_service_->GetHotKeys()) {
+                ss += "key=" + hot.key + ", count=" +
+                      std::to_string(hot.count) + "\n";
+            }
+            resp.add_header("Content-Type", "text/plain; version=0.0.4");
+            resp.set_status_and_content(status_type::ok, std::move(ss));
+        });
+
+    http_server_.set_http_handler<GET>(
+        "/metrics/hot_shards",
+        [&](coro_http_request& req, coro_http_response& resp) {
+            std::string ss;
+            auto shard_stats = master_service_->GetShardLockStats();
+            for (size_t i = 0;
+                 i < shard_stats.size() && i < kHotShardsReported; i++) {
+                const auto& [shard, stats] = shard_stats[i];
+                if (stats.wait_us == 0) {
+                    break;
+                }
+                ss += "shard=" + std::to_string(shard) +
+                      ", contended=" + std::to_string(stats.contended) +
+                      ", wait_us=" + std::to_string(stats.wait_us) + "\n";
+            }
+            resp.add_header("Content-Type", "text/plain; version=0.0.4");
+            resp.set_status_and_content(status_type::ok, std::move(ss));
+        });
+
     http_server_.set_http_handler<GET>(
         "/query_key", [&](coro_http_request& req, coro_http_response& resp) {
             auto key = req.get_query_value("key");
@@ -105,26 +187,33 @@ void WrappedMasterService::init_http_server() {
         "/get_all_keys", [&](coro_http_request& req, coro_http_response& resp) {
             resp.add_header("Content-Type", "text/plain; version=0.0.4");
 
-            auto result = master_service_.GetAllKeys();
-            if (result) {
-                std::string ss = "";
-                auto keys = result.value();
-                for (const auto& key : keys) {
+            // Page through the shards so that the keys are only held once,
+            // in the response
+            std::string ss = "";
+            uint64_t cursor = 0;
+            do {
+                auto page =
+                    master_service_->ScanKeys("", cursor, kScanKeysPageSize);
+                if (!page) {
+                    resp.set_status_and_content(
+                        status_type::internal_server_error,
+                        "Failed to get all keys");
+                    return;
+                }
+                for (const auto& key : page->keys) {
                     ss += key;
                     ss += "\n";
                 }
-                resp.set_status_and_content(status_type::ok, std::move(ss));
-            } else {
-                resp.set_status_and_content(status_type::internal_server_error,
-                                            "Failed to get all keys");
-            }
+                cursor = page->next_cursor;
+            } while (cursor != 0);
+            resp.set_status_and_content(status_type::ok, std::move(ss));
         });
 
     http_server_.set_http_handler<GET>(
         "/get_all_segments",
         [&](coro_http_request& req, coro_http_response& resp) {
             resp.add_header("Content-Type", "text/plain; version=0.0.4");
-            auto result = master_service_.GetAllSegments();
+            auto result = master_service_->GetAllSegments();
             if (result) {
                 std::string ss = "";
                 auto segments = result.value();
@@ -144,7 +233,7 @@ void WrappedMasterService::init_http_server() {
         [&](coro_http_request& req, coro_http_response& resp) {
             auto segment = req.get_query_value("segment");
             resp.add_header("Content-Type", "text/plain; version=0.0.4");
-            auto result = master_service_.QuerySegments(std::string(segment));
+            auto result = master_service_->QuerySegments(std::string(segment));
 
             if (result) {
                 std::string ss = "";
@@ -163,6 +252,26 @@ void WrappedMasterService::init_http_server() {
             }
         });
 
+    // Draining a segment before unmounting it moves its objects away first
+    for (bool draining : {true, false}) {
+        http_server_.set_http_handler<GET>(
+            draining ? "/drain_segment" : "/undrain_segment",
+            [this, draining](coro_http_request& req,
+                             coro_http_response& resp) {
+                auto segment = req.get_query_value("segment");
+                resp.add_header("Content-Type", "text/plain; version=0.0.4");
+                auto result = master_service_->DrainSegment(
+                    std::string(segment), draining);
+                if (result) {
+                    resp.set_status_and_content(status_type::ok, "OK");
+                } else {
+                    resp.set_status_and_content(
+                        status_type::not_found,
+                        std::string(toString(result.error())));
+                }
+            });
+    }
+
     http_server_.set_http_handler<GET>(
         "/health", [](coro_http_request& req, coro_http_response& resp) {
             resp.add_header("Content-Type", "text/plain; version=0.0.4");
@@ -259,7 +368,11 @@ WrappedMasterService::CalcCacheStats() {
 tl::expected<bool, ErrorCode> WrappedMasterService::ExistKey(
     const std::string& key) {
     return execute_rpc(
-        "ExistKey", [&] { return master_service_.ExistKey(key); },
+        "ExistKey",
+        [&] {
+            return standby_follower_ ? standby_follower_->ExistKey(key)
+                                     : master_service_->ExistKey(key);
+        },
         [&](auto& timer) { timer.LogRequest("key=", key); },
         [] { MasterMetricManager::instance().inc_exist_key_requests(); },
         [] { MasterMetricManager::instance().inc_exist_key_failures(); });
@@ -267,12 +380,14 @@ tl::expected<bool, ErrorCode> WrappedMasterService::ExistKey(
 
 std::vector<tl::expected<bool, ErrorCode>> WrappedMasterService::BatchExistKey(
     const std::vector<std::string>& keys) {
+    ScopedRpcLatency latency("BatchExistKey");
     ScopedVLogTimer timer(1, "BatchExistKey");
     const size_t total_keys = keys.size();
     timer.LogRequest("keys_count=", total_keys);
     MasterMetricManager::instance().inc_batch_exist_key_requests(total_keys);
 
-    auto result = master_service_.BatchExistKey(keys);
+    auto result = standby_follower_ ? standby_follower_->BatchExistKey(keys)
+                                    : master_service_->BatchExistKey(keys);
 
     size_t failure_count = 0;
     for (size_t i = 0; i < result.size(); ++i) {
@@ -302,13 +417,14 @@ tl::expected<
     std::unordered_map<UUID, std::vector<std::string>, boost::hash<UUID>>,
     ErrorCode>
 WrappedMasterService::BatchQueryIp(const std::vector<UUID>& client_ids) {
+    ScopedRpcLatency latency("BatchQueryIp");
     ScopedVLogTimer timer(1, "BatchQueryIp");
     const size_t total_client_ids = client_ids.size();
     timer.LogRequest("client_ids_count=", total_client_ids);
     MasterMetricManager::instance().inc_batch_query_ip_requests(
         total_client_ids);
 
-    auto result = master_service_.BatchQueryIp(client_ids);
+    auto result = master_service_->BatchQueryIp(client_ids);
 
     size_t failure_count = 0;
     if (!result.has_value()) {
@@ -342,6 +458,7 @@ tl::expected<std::vector<std::string>, ErrorCode>
 WrappedMasterService::BatchReplicaClear(
     const std::vector<std::string>& object_keys, const UUID& client_id,
     const std::string& segment_name) {
+    ScopedRpcLatency latency("BatchReplicaClear");
     ScopedVLogTimer timer(1, "BatchReplicaClear");
     const size_t total_keys = object_keys.size();
     timer.LogRequest("object_keys_count=", total_keys,
@@ -351,7 +468,9 @@ WrappedMasterService::BatchReplicaClear(
         total_keys);
 
     auto result =
-        master_service_.BatchReplicaClear(object_keys, client_id, segment_name);
+        Synced(*master_service_,
+               master_service_->BatchReplicaClear(object_keys, client_id,
+                                                  segment_name));
 
     size_t failure_count = 0;
     if (!result.has_value()) {
@@ -382,7 +501,7 @@ tl::expected<std::unordered_map<std::string, std::vector<Replica::Descriptor>>,
 WrappedMasterService::GetReplicaListByRegex(const std::string& str) {
     return execute_rpc(
         "GetReplicaListByRegex",
-        [&] { return master_service_.GetReplicaListByRegex(str); },
+        [&] { return master_service_->GetReplicaListByRegex(str); },
         [&](auto& timer) { timer.LogRequest("Regex=", str); },
         [] {
             MasterMetricManager::instance()
@@ -397,7 +516,11 @@ WrappedMasterService::GetReplicaListByRegex(const std::string& str) {
 tl::expected<GetReplicaListResponse, ErrorCode>
 WrappedMasterService::GetReplicaList(const std::string& key) {
     return execute_rpc(
-        "GetReplicaList", [&] { return master_service_.GetReplicaList(key); },
+        "GetReplicaList",
+        [&] {
+            return standby_follower_ ? standby_follower_->GetReplicaList(key)
+                                     : master_service_->GetReplicaList(key);
+        },
         [&](auto& timer) { timer.LogRequest("key=", key); },
         [] { MasterMetricManager::instance().inc_get_replica_list_requests(); },
         [] {
@@ -408,6 +531,7 @@ WrappedMasterService::GetReplicaList(const std::string& key) {
 std::vector<tl::expected<GetReplicaListResponse, ErrorCode>>
 WrappedMasterService::BatchGetReplicaList(
     const std::vector<std::string>& keys) {
+    ScopedRpcLatency latency("BatchGetReplicaList");
     ScopedVLogTimer timer(1, "BatchGetReplicaList");
     const size_t total_keys = keys.size();
     timer.LogRequest("keys_count=", total_keys);
@@ -418,7 +542,9 @@ WrappedMasterService::BatchGetReplicaList(
     results.reserve(keys.size());
 
     for (const auto& key : keys) {
-        results.emplace_back(master_service_.GetReplicaList(key));
+        results.emplace_back(standby_follower_
+                                 ? standby_follower_->GetReplicaList(key)
+                                 : master_service_->GetReplicaList(key));
     }
 
     size_t failure_count = 0;
@@ -451,6 +577,28 @@ WrappedMasterService::BatchGetReplicaList(
     return results;
 }
 
+CompactReplicaLists WrappedMasterService::BatchGetReplicaListCompact(
+    const std::vector<std::string>& keys) {
+    return EncodeReplicaLists(BatchGetReplicaList(keys));
+}
+
+tl::expected<std::vector<GetReplicaListResponse>, ErrorCode>
+WrappedMasterService::LongestCachedPrefix(
+    const std::vector<std::string>& keys) {
+    return execute_rpc(
+        "LongestCachedPrefix",
+        [&] { return master_service_->LongestCachedPrefix(keys); },
+        [&](auto& timer) { timer.LogRequest("keys_count=", keys.size()); },
+        [] {
+            MasterMetricManager::instance()
+                .inc_longest_cached_prefix_requests();
+        },
+        [] {
+            MasterMetricManager::instance()
+                .inc_longest_cached_prefix_failures();
+        });
+}
+
 tl::expected<std::vector<Replica::Descriptor>, ErrorCode>
 WrappedMasterService::PutStart(const UUID& client_id, const std::string& key,
                                const uint64_t slice_length,
@@ -458,7 +606,7 @@ WrappedMasterService::PutStart(const UUID& client_id, const std::string& key,
     return execute_rpc(
         "PutStart",
         [&] {
-            return master_service_.PutStart(client_id, key, slice_length,
+            return master_service_->PutStart(client_id, key, slice_length,
                                             config);
         },
         [&](auto& timer) {
@@ -473,7 +621,11 @@ tl::expected<void, ErrorCode> WrappedMasterService::PutEnd(
     const UUID& client_id, const std::string& key, ReplicaType replica_type) {
     return execute_rpc(
         "PutEnd",
-        [&] { return master_service_.PutEnd(client_id, key, replica_type); },
+        [&] {
+            return Synced(*master_service_,
+                          master_service_->PutEnd(client_id, key,
+                                                  replica_type));
+        },
         [&](auto& timer) {
             timer.LogRequest("client_id=", client_id, ", key=", key,
                              ", replica_type=", replica_type);
@@ -482,11 +634,46 @@ tl::expected<void, ErrorCode> WrappedMasterService::PutEnd(
         [] { MasterMetricManager::instance().inc_put_end_failures(); });
 }
 
+tl::expected<void, ErrorCode> WrappedMasterService::PutCommit(
+    const UUID& client_id, const std::string& key, uint64_t committed_bytes) {
+    return execute_rpc(
+        "PutCommit",
+        [&] {
+            return master_service_->PutCommit(client_id, key, committed_bytes);
+        },
+        [&](auto& timer) {
+            timer.LogRequest("client_id=", client_id, ", key=", key,
+                             ", committed_bytes=", committed_bytes);
+        },
+        [] { MasterMetricManager::instance().inc_put_commit_requests(); },
+        [] { MasterMetricManager::instance().inc_put_commit_failures(); });
+}
+
+tl::expected<GetCommittedReplicaListResponse, ErrorCode>
+WrappedMasterService::GetCommittedReplicaList(const std::string& key) {
+    return execute_rpc(
+        "GetCommittedReplicaList",
+        [&] { return master_service_->GetCommittedReplicaList(key); },
+        [&](auto& timer) { timer.LogRequest("key=", key); },
+        [] {
+            MasterMetricManager::instance()
+                .inc_get_committed_replica_list_requests();
+        },
+        [] {
+            MasterMetricManager::instance()
+                .inc_get_committed_replica_list_failures();
+        });
+}
+
 tl::expected<void, ErrorCode> WrappedMasterService::PutRevoke(
     const UUID& client_id, const std::string& key, ReplicaType replica_type) {
     return execute_rpc(
         "PutRevoke",
-        [&] { return master_service_.PutRevoke(client_id, key, replica_type); },
+        [&] {
+            return Synced(*master_service_,
+                          master_service_->PutRevoke(client_id, key,
+                                                     replica_type));
+        },
         [&](auto& timer) {
             timer.LogRequest("client_id=", client_id, ", key=", key,
                              ", replica_type=", replica_type);
@@ -500,6 +687,7 @@ WrappedMasterService::BatchPutStart(const UUID& client_id,
                                     const std::vector<std::string>& keys,
                                     const std::vector<uint64_t>& slice_lengths,
                                     const ReplicateConfig& config) {
+    ScopedRpcLatency latency("BatchPutStart");
     ScopedVLogTimer timer(1, "BatchPutStart");
     const size_t total_keys = keys.size();
     timer.LogRequest("client_id=", client_id, ", keys_count=", total_keys);
@@ -512,7 +700,7 @@ WrappedMasterService::BatchPutStart(const UUID& client_id,
     if (config.prefer_alloc_in_same_node) {
         ReplicateConfig new_config = config;
         for (size_t i = 0; i < keys.size(); ++i) {
-            auto result = master_service_.PutStart(
+            auto result = master_service_->PutStart(
                 client_id, keys[i], slice_lengths[i], new_config);
             results.emplace_back(result);
             if ((i == 0) && result.has_value()) {
@@ -532,10 +720,8 @@ WrappedMasterService::BatchPutStart(const UUID& client_id,
             }
         }
     } else {
-        for (size_t i = 0; i < keys.size(); ++i) {
-            results.emplace_back(master_service_.PutStart(
-                client_id, keys[i], slice_lengths[i], config));
-        }
+        results = master_service_->BatchPutStart(client_id, keys,
+                                                 slice_lengths, config);
     }
 
     size_t failure_count = 0;
@@ -577,6 +763,7 @@ WrappedMasterService::BatchPutStart(const UUID& client_id,
 
 std::vector<tl::expected<void, ErrorCode>> WrappedMasterService::BatchPutEnd(
     const UUID& client_id, const std::vector<std::string>& keys) {
+    ScopedRpcLatency latency("BatchPutEnd");
     ScopedVLogTimer timer(1, "BatchPutEnd");
     const size_t total_keys = keys.size();
     timer.LogRequest("client_id=", client_id, ", keys_count=", total_keys);
@@ -587,8 +774,10 @@ std::vector<tl::expected<void, ErrorCode>> WrappedMasterService::BatchPutEnd(
 
     for (const auto& key : keys) {
         results.emplace_back(
-            master_service_.PutEnd(client_id, key, ReplicaType::MEMORY));
+            master_service_->PutEnd(client_id, key, ReplicaType::MEMORY));
     }
+    // One sync for the batch
+    Synced(*master_service_, results);
 
     size_t failure_count = 0;
     for (size_t i = 0; i < results.size(); ++i) {
@@ -616,6 +805,7 @@ std::vector<tl::expected<void, ErrorCode>> WrappedMasterService::BatchPutEnd(
 
 std::vector<tl::expected<void, ErrorCode>> WrappedMasterService::BatchPutRevoke(
     const UUID& client_id, const std::vector<std::string>& keys) {
+    ScopedRpcLatency latency("BatchPutRevoke");
     ScopedVLogTimer timer(1, "BatchPutRevoke");
     const size_t total_keys = keys.size();
     timer.LogRequest("client_id=", client_id, ", keys_count=", total_keys);
@@ -626,8 +816,10 @@ std::vector<tl::expected<void, ErrorCode>> WrappedMasterService::BatchPutRevoke(
 
     for (const auto& key : keys) {
         results.emplace_back(
-            master_service_.PutRevoke(client_id, key, ReplicaType::MEMORY));
+            master_service_->PutRevoke(client_id, key, ReplicaType::MEMORY));
     }
+    // One sync for the batch
+    Synced(*master_service_, results);
 
     size_t failure_count = 0;
     for (size_t i = 0; i < results.size(); ++i) {
@@ -656,17 +848,90 @@ std::vector<tl::expected<void, ErrorCode>> WrappedMasterService::BatchPutRevoke(
 tl::expected<void, ErrorCode> WrappedMasterService::Remove(
     const std::string& key, bool force) {
     return execute_rpc(
-        "Remove", [&] { return master_service_.Remove(key, force); },
+        "Remove",
+        [&] {
+            return Synced(*master_service_,
+                          master_service_->Remove(key, force));
+        },
         [&](auto& timer) { timer.LogRequest("key=", key, ", force=", force); },
         [] { MasterMetricManager::instance().inc_remove_requests(); },
         [] { MasterMetricManager::instance().inc_remove_failures(); });
 }
 
+tl::expected<void, ErrorCode> WrappedMasterService::LinkContent(
+    const std::string& key, const std::string& content_key) {
+    return execute_rpc(
+        "LinkContent",
+        [&] { return master_service_->LinkContent(key, content_key); },
+        [&](auto& timer) {
+            timer.LogRequest("key=", key, ", content_key=", content_key);
+        },
+        [] { MasterMetricManager::instance().inc_link_content_requests(); },
+        [] { MasterMetricManager::instance().inc_link_content_failures(); });
+}
+
+tl::expected<void, ErrorCode> WrappedMasterService::LinkBundle(
+    const std::string& bundle_key, const std::vector<std::string>& keys,
+    const std::vector<uint64_t>& sizes) {
+    return execute_rpc(
+        "LinkBundle",
+        [&] { return master_service_->LinkBundle(bundle_key, keys, sizes); },
+        [&](auto& timer) {
+            timer.LogRequest("bundle_key=", bundle_key,
+                             ", keys_count=", keys.size());
+        },
+        [] { MasterMetricManager::instance().inc_link_bundle_requests(); },
+        [] { MasterMetricManager::instance().inc_link_bundle_failures(); });
+}
+
+std::vector<tl::expected<BundleMember, ErrorCode>>
+WrappedMasterService::BatchResolveBundle(const std::vector<std::string>& keys) {
+    ScopedRpcLatency latency("BatchResolveBundle");
+    ScopedVLogTimer timer(1, "BatchResolveBundle");
+    timer.LogRequest("keys_count=", keys.size());
+    MasterMetricManager::instance().inc_resolve_bundle_requests(keys.size());
+
+    auto result = master_service_->BatchResolveBundle(keys);
+
+    // Keys not found are misses rather than errors, so not logged
+    size_t failure_count = 0;
+    for (const auto& member : result) {
+        if (!member.has_value()) {
+            failure_count++;
+        }
+    }
+    if (failure_count != 0) {
+        MasterMetricManager::instance().inc_resolve_bundle_failures(
+            failure_count);
+    }
+
+    timer.LogResponse("total=", result.size(),
+                      ", success=", result.size() - failure_count,
+                      ", failures=", failure_count);
+    return result;
+}
+
+tl::expected<ScanKeysResponse, ErrorCode> WrappedMasterService::ScanKeys(
+    const std::string& prefix, uint64_t cursor, uint64_t limit) {
+    return execute_rpc(
+        "ScanKeys",
+        [&] { return master_service_->ScanKeys(prefix, cursor, limit); },
+        [&](auto& timer) {
+            timer.LogRequest("prefix=", prefix, ", cursor=", cursor,
+                             ", limit=", limit);
+        },
+        [] { MasterMetricManager::instance().inc_scan_keys_requests(); },
+        [] { MasterMetricManager::instance().inc_scan_keys_failures(); });
+}
+
 tl::expected<long, ErrorCode> WrappedMasterService::RemoveByRegex(
     const std::string& str, bool force) {
     return execute_rpc(
         "RemoveByRegex",
-        [&] { return master_service_.RemoveByRegex(str, force); },
+        [&] {
+            return Synced(*master_service_,
+                          master_service_->RemoveByRegex(str, force));
+        },
         [&](auto& timer) {
             timer.LogRequest("regex=", str, ", force=", force);
         },
@@ -674,11 +939,27 @@ tl::expected<long, ErrorCode> WrappedMasterService::RemoveByRegex(
         [] { MasterMetricManager::instance().inc_remove_by_regex_failures(); });
 }
 
+tl::expected<UUID, ErrorCode> WrappedMasterService::RemoveByPrefix(
+    const std::string& prefix, bool force) {
+    return execute_rpc(
+        "RemoveByPrefix",
+        [&] { return master_service_->RemoveByPrefix(prefix, force); },
+        [&](auto& timer) {
+            timer.LogRequest("prefix=", prefix, ", force=", force);
+        },
+        [] { MasterMetricManager::instance().inc_remove_by_prefix_requests(); },
+        [] {
+            MasterMetricManager::instance().inc_remove_by_prefix_failures();
+        });
+}
+
 long WrappedMasterService::RemoveAll(bool force) {
+    ScopedRpcLatency latency("RemoveAll");
     ScopedVLogTimer timer(1, "RemoveAll");
     timer.LogRequest("action=remove_all_objects, force=", force);
     MasterMetricManager::instance().inc_remove_all_requests();
-    long result = master_service_.RemoveAll(force);
+    long result = master_service_->RemoveAll(force);
+    master_service_->SyncMetadata();
     timer.LogResponse("items_removed=", result);
     return result;
 }
@@ -687,7 +968,7 @@ tl::expected<void, ErrorCode> WrappedMasterService::MountSegment(
     const Segment& segment, const UUID& client_id) {
     return execute_rpc(
         "MountSegment",
-        [&] { return master_service_.MountSegment(segment, client_id); },
+        [&] { return master_service_->MountSegment(segment, client_id); },
         [&](auto& timer) {
             timer.LogRequest("base=", segment.base, ", size=", segment.size,
                              ", segment_name=", segment.name,
@@ -701,7 +982,7 @@ tl::expected<void, ErrorCode> WrappedMasterService::ReMountSegment(
     const std::vector<Segment>& segments, const UUID& client_id) {
     return execute_rpc(
         "ReMountSegment",
-        [&] { return master_service_.ReMountSegment(segments, client_id); },
+        [&] { return master_service_->ReMountSegment(segments, client_id); },
         [&](auto& timer) {
             timer.LogRequest("segments_count=", segments.size(),
                              ", client_id=", client_id);
@@ -714,7 +995,11 @@ tl::expected<void, ErrorCode> WrappedMasterService::UnmountSegment(
     const UUID& segment_id, const UUID& client_id) {
     return execute_rpc(
         "UnmountSegment",
-        [&] { return master_service_.UnmountSegment(segment_id, client_id); },
+        [&] {
+            return Synced(*master_service_,
+                          master_service_->UnmountSegment(segment_id,
+                                                          client_id));
+        },
         [&](auto& timer) {
             timer.LogRequest("segment_id=", segment_id,
                              ", client_id=", client_id);
@@ -723,6 +1008,28 @@ tl::expected<void, ErrorCode> WrappedMasterService::UnmountSegment(
         [] { MasterMetricManager::instance().inc_unmount_segment_failures(); });
 }
 
+tl::expected<uint64_t, ErrorCode> WrappedMasterService::DrainSegment(
+    const UUID& segment_id, const UUID& client_id) {
+    return execute_rpc(
+        "DrainSegment",
+        [&] { return master_service_->DrainSegment(segment_id, client_id); },
+        [&](auto& timer) {
+            timer.LogRequest("segment_id=", segment_id,
+                             ", client_id=", client_id);
+        },
+        [] { MasterMetricManager::instance().inc_drain_segment_requests(); },
+        [] { MasterMetricManager::instance().inc_drain_segment_failures(); });
+}
+
+tl::expected<GetKeyFilterResponse, ErrorCode>
+WrappedMasterService::GetKeyFilter(uint64_t since) {
+    return execute_rpc(
+        "GetKeyFilter", [&] { return master_service_->GetKeyFilter(since); },
+        [&](auto& timer) { timer.LogRequest("since=", since); },
+        [] { MasterMetricManager::instance().inc_get_key_filter_requests(); },
+        [] { MasterMetricManager::instance().inc_get_key_filter_failures(); });
+}
+
 tl::expected<CopyStartResponse, ErrorCode> WrappedMasterService::CopyStart(
     const UUID& client_id, const std::string& key,
     const std::string& src_segment,
@@ -730,7 +1037,7 @@ tl::expected<CopyStartResponse, ErrorCode> WrappedMasterService::CopyStart(
     return execute_rpc(
         "CopyStart",
         [&] {
-            return master_service_.CopyStart(client_id, key, src_segment,
+            return master_service_->CopyStart(client_id, key, src_segment,
                                              tgt_segments);
         },
         [&](auto& timer) {
@@ -745,7 +1052,11 @@ tl::expected<CopyStartResponse, ErrorCode> WrappedMasterService::CopyStart(
 tl::expected<void, ErrorCode> WrappedMasterService::CopyEnd(
     const UUID& client_id, const std::string& key) {
     return execute_rpc(
-        "CopyEnd", [&] { return master_service_.CopyEnd(client_id, key); },
+        "CopyEnd",
+        [&] {
+            return Synced(*master_service_,
+                          master_service_->CopyEnd(client_id, key));
+        },
         [&](auto& timer) {
             timer.LogRequest("client_id=", client_id, ", key=", key);
         },
@@ -757,7 +1068,7 @@ tl::expected<void, ErrorCode> WrappedMasterService::CopyRevoke(
     const UUID& client_id, const std::string& key) {
     return execute_rpc(
         "CopyRevoke",
-        [&] { return master_service_.CopyRevoke(client_id, key); },
+        [&] { return master_service_->CopyRevoke(client_id, key); },
         [&](auto& timer) {
             timer.LogRequest("client_id=", client_id, ", key=", key);
         },
@@ -771,7 +1082,7 @@ tl::expected<MoveStartResponse, ErrorCode> WrappedMasterService::MoveStart(
     return execute_rpc(
         "MoveStart",
         [&] {
-            return master_service_.MoveStart(client_id, key, src_segment,
+            return master_service_->MoveStart(client_id, key, src_segment,
                                              tgt_segment);
         },
         [&](auto& timer) {
@@ -786,7 +1097,11 @@ tl::expected<MoveStartResponse, ErrorCode> WrappedMasterService::MoveStart(
 tl::expected<void, ErrorCode> WrappedMasterService::MoveEnd(
     const UUID& client_id, const std::string& key) {
     return execute_rpc(
-        "MoveEnd", [&] { return master_service_.MoveEnd(client_id, key); },
+        "MoveEnd",
+        [&] {
+            return Synced(*master_service_,
+                          master_service_->MoveEnd(client_id, key));
+        },
         [&](auto& timer) {
             timer.LogRequest("client_id=", client_id, ", key=", key);
         },
@@ -798,7 +1113,7 @@ tl::expected<void, ErrorCode> WrappedMasterService::MoveRevoke(
     const UUID& client_id, const std::string& key) {
     return execute_rpc(
         "MoveRevoke",
-        [&] { return master_service_.MoveRevoke(client_id, key); },
+        [&] { return master_service_->MoveRevoke(client_id, key); },
         [&](auto& timer) {
             timer.LogRequest("client_id=", client_id, ", key=", key);
         },
@@ -810,7 +1125,7 @@ tl::expected<UUID, ErrorCode> WrappedMasterService::CreateCopyTask(
     const std::string& key, const std::vector<std::string>& targets) {
     return execute_rpc(
         "CreateCopyTask",
-        [&] { return master_service_.CreateCopyTask(key, targets); },
+        [&] { return master_service_->CreateCopyTask(key, targets); },
         [&](auto& timer) {
             timer.LogRequest("key=", key, ", targets_size=", targets.size());
         },
@@ -825,7 +1140,7 @@ tl::expected<UUID, ErrorCode> WrappedMasterService::CreateMoveTask(
     const std::string& target) {
     return execute_rpc(
         "CreateMoveTask",
-        [&] { return master_service_.CreateMoveTask(key, source, target); },
+        [&] { return master_service_->CreateMoveTask(key, source, target); },
         [&](auto& timer) {
             timer.LogRequest("key=", key, ", source=", source,
                              ", target=", target);
@@ -839,7 +1154,7 @@ tl::expected<UUID, ErrorCode> WrappedMasterService::CreateMoveTask(
 tl::expected<QueryTaskResponse, ErrorCode> WrappedMasterService::QueryTask(
     const UUID& task_id) {
     return execute_rpc(
-        "QueryTask", [&] { return master_service_.QueryTask(task_id); },
+        "QueryTask", [&] { return master_service_->QueryTask(task_id); },
         [&](auto& timer) { timer.LogRequest("task_id=", task_id); },
         [] { MasterMetricManager::instance().inc_query_task_requests(); },
         [] { MasterMetricManager::instance().inc_query_task_failures(); });
@@ -849,7 +1164,7 @@ tl::expected<std::vector<TaskAssignment>, ErrorCode>
 WrappedMasterService::FetchTasks(const UUID& client_id, size_t batch_size) {
     return execute_rpc(
         "FetchTasks",
-        [&] { return master_service_.FetchTasks(client_id, batch_size); },
+        [&] { return master_service_->FetchTasks(client_id, batch_size); },
         [&](auto& timer) {
             timer.LogRequest("client_id=", client_id,
                              ", batch_size=", batch_size);
@@ -862,7 +1177,7 @@ tl::expected<void, ErrorCode> WrappedMasterService::MarkTaskToComplete(
     const UUID& client_id, const TaskCompleteRequest& request) {
     return execute_rpc(
         "MarkTaskToComplete",
-        [&] { return master_service_.MarkTaskToComplete(client_id, request); },
+        [&] { return master_service_->MarkTaskToComplete(client_id, request); },
         [&](auto& timer) {
             timer.LogRequest("client_id=", client_id, ", task_id=", request.id);
         },
@@ -871,10 +1186,11 @@ tl::expected<void, ErrorCode> WrappedMasterService::MarkTaskToComplete(
 }
 
 tl::expected<std::string, ErrorCode> WrappedMasterService::GetFsdir() {
+    ScopedRpcLatency latency("GetFsdir");
     ScopedVLogTimer timer(1, "GetFsdir");
     timer.LogRequest("action=get_fsdir");
 
-    auto result = master_service_.GetFsdir();
+    auto result = master_service_->GetFsdir();
 
     timer.LogResponseExpected(result);
     return result;
@@ -882,23 +1198,26 @@ tl::expected<std::string, ErrorCode> WrappedMasterService::GetFsdir() {
 
 tl::expected<GetStorageConfigResponse, ErrorCode>
 WrappedMasterService::GetStorageConfig() {
+    ScopedRpcLatency latency("GetStorageConfig");
     ScopedVLogTimer timer(1, "GetStorageConfig");
     timer.LogRequest("action=get_storage_config");
 
-    auto result = master_service_.GetStorageConfig();
+    auto result = master_service_->GetStorageConfig();
 
     timer.LogResponseExpected(result);
     return result;
 }
 
 tl::expected<PingResponse, ErrorCode> WrappedMasterService::Ping(
-    const UUID& client_id) {
+    const UUID& client_id, uint64_t transfer_bytes_per_sec) {
+    ScopedRpcLatency latency("Ping");
     ScopedVLogTimer timer(1, "Ping");
-    timer.LogRequest("client_id=", client_id);
+    timer.LogRequest("client_id=", client_id,
+                     ", transfer_bytes_per_sec=", transfer_bytes_per_sec);
 
     MasterMetricManager::instance().inc_ping_requests();
 
-    auto result = master_service_.Ping(client_id);
+    auto result = master_service_->Ping(client_id, transfer_bytes_per_sec);
 
     timer.LogResponseExpected(result);
     return result;
@@ -910,12 +1229,13 @@ tl::expected<std::string, ErrorCode> WrappedMasterService::ServiceReady() {
 
 tl::expected<void, ErrorCode> WrappedMasterService::MountLocalDiskSegment(
     const UUID& client_id, bool enable_offloading) {
+    ScopedRpcLatency latency("MountLocalDiskSegment");
     ScopedVLogTimer timer(1, "MountLocalDiskSegment");
     timer.LogRequest("action=mount_local_disk_segment");
     LOG(INFO) << "Mount local disk segment with client id is : " << client_id
               << ", enable offloading is: " << enable_offloading;
     auto result =
-        master_service_.MountLocalDiskSegment(client_id, enable_offloading);
+        master_service_->MountLocalDiskSegment(client_id, enable_offloading);
 
     timer.LogResponseExpected(result);
     return result;
@@ -924,22 +1244,25 @@ tl::expected<void, ErrorCode> WrappedMasterService::MountLocalDiskSegment(
 tl::expected<std::unordered_map<std::string, int64_t, std::hash<std::string>>,
              ErrorCode>
 WrappedMasterService::OffloadObjectHeartbeat(const UUID& client_id,
-                                             bool enable_offloading) {
+                                             bool enable_offloading,
+                                             uint64_t max_objects) {
+    ScopedRpcLatency latency("OffloadObjectHeartbeat");
     ScopedVLogTimer timer(1, "OffloadObjectHeartbeat");
     timer.LogRequest("action=offload_object_heartbeat");
-    auto result =
-        master_service_.OffloadObjectHeartbeat(client_id, enable_offloading);
+    auto result = master_service_->OffloadObjectHeartbeat(
+        client_id, enable_offloading, max_objects);
     return result;
 }
 
 tl::expected<void, ErrorCode> WrappedMasterService::NotifyOffloadSuccess(
     const UUID& client_id, const std::vector<std::string>& keys,
     const std::vector<StorageObjectMetadata>& metadatas) {
+    ScopedRpcLatency latency("NotifyOffloadSuccess");
     ScopedVLogTimer timer(1, "NotifyOffloadSuccess");
     timer.LogRequest("action=notify_offload_success");
 
     auto result =
-        master_service_.NotifyOffloadSuccess(client_id, keys, metadatas);
+        master_service_->NotifyOffloadSuccess(client_id, keys, metadatas);
     timer.LogResponseExpected(result);
     return result;
 }
@@ -961,12 +1284,30 @@ void RegisterRpcService(
     server
         .register_handler<&mooncake::WrappedMasterService::BatchGetReplicaList>(
             &wrapped_master_service);
+    server.register_handler<
+        &mooncake::WrappedMasterService::BatchGetReplicaListCompact>(
+        &wrapped_master_service);
+    server
+        .register_handler<&mooncake::WrappedMasterService::LongestCachedPrefix>(
+            &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::LinkContent>(
+        &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::LinkBundle>(
+        &wrapped_master_service);
+    server
+        .register_handler<&mooncake::WrappedMasterService::BatchResolveBundle>(
+            &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::PutStart>(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::PutEnd>(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::PutRevoke>(
         &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::PutCommit>(
+        &wrapped_master_service);
+    server.register_handler<
+        &mooncake::WrappedMasterService::GetCommittedReplicaList>(
+        &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::BatchPutStart>(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::BatchPutEnd>(
@@ -979,12 +1320,20 @@ void RegisterRpcService(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::RemoveAll>(
         &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::RemoveByPrefix>(
+        &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::ScanKeys>(
+        &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::MountSegment>(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::ReMountSegment>(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::UnmountSegment>(
         &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::DrainSegment>(
+        &wrapped_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::GetKeyFilter>(
+        &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::Ping>(
         &wrapped_master_service);
     server.register_handler<&mooncake::WrappedMasterService::GetFsdir>(
@@ -1029,4 +1378,42 @@ void RegisterRpcService(
             &wrapped_master_service);
 }
 
+void RegisterStandbyRpcService(
+    coro_rpc::coro_rpc_server& server,
+    mooncake::WrappedMasterService& standby_master_service) {
+    server.register_handler<&mooncake::WrappedMasterService::ExistKey>(
+        &standby_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::BatchExistKey>(
+        &standby_master_service);
+    server.register_handler<&mooncake::WrappedMasterService::GetReplicaList>(
+        &standby_master_service);
+    server
+        .register_handler<&mooncake::WrappedMasterService::BatchGetReplicaList>(
+            &standby_master_service);
+    server.register_handler<
+        &mooncake::WrappedMasterService::BatchGetReplicaListCompact>(
+        &standby_master_service);
+}
+
+std::unique_ptr<coro_rpc::coro_rpc_server> StartRdmaRpcServer(
+    size_t thread_num, int port, const std::string& address,
+    mooncake::WrappedMasterService& wrapped_master_service) {
+    auto server = std::make_unique<coro_rpc::coro_rpc_server>(
+        thread_num, port, address, std::chrono::seconds(0),
+        /*tcp_no_delay=*/true);
+    server->init_ibv();
+    server->register_handler<&mooncake::WrappedMasterService::ExistKey>(
+        &wrapped_master_service);
+    server->register_handler<&mooncake::WrappedMasterService::GetReplicaList>(
+        &wrapped_master_service);
+    auto ec = server->async_start();
+    if (ec.hasResult()) {
+        LOG(ERROR) << "Failed to start the RDMA RPC server on port " << port
+                   << ": " << ec.result().value();
+        return nullptr;
+    }
+    LOG(INFO) << "RDMA RPC server started on port " << port;
+    return server;
+}
+
 }  // namespace mooncake
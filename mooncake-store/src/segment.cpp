@@ -1,5 +1,7 @@
 #include "segment.h"
 
+#include <algorithm>
+
 #include "master_metric_manager.h"
 
 namespace mooncake {
@@ -43,7 +45,13 @@ ErrorCode ScopedSegmentAccess::MountSegment(const Segment& segment,
         return ErrorCode::INVALID_PARAMS;
     }
 
-    if (segment_manager_->memory_allocator_ == BufferAllocatorType::CACHELIB &&
+    // Slab segments are cut into blocks of their own size, whichever
+    // allocator the master uses for the others
+    const BufferAllocatorType allocator_type =
+        segment.slab_block_size > 0 ? BufferAllocatorType::SLAB
+                                    : segment_manager_->memory_allocator_;
+
+    if (allocator_type == BufferAllocatorType::CACHELIB &&
         (buffer % facebook::cachelib::Slab::kSize ||
          size % facebook::cachelib::Slab::kSize)) {
         LOG(ERROR) << "buffer=" << buffer << " or size=" << size
@@ -57,7 +65,8 @@ ErrorCode ScopedSegmentAccess::MountSegment(const Segment& segment,
         segment_manager_->mounted_segments_.find(segment.id);
     if (exist_segment_it != segment_manager_->mounted_segments_.end()) {
         auto& exist_segment = exist_segment_it->second;
-        if (exist_segment.status == SegmentStatus::OK) {
+        if (exist_segment.status == SegmentStatus::OK ||
+            exist_segment.status == SegmentStatus::DRAINING) {
             LOG(WARNING) << "segment_name=" << segment.name
                          << ", warn=segment_already_exists";
             return ErrorCode::SEGMENT_ALREADY_EXISTS;
@@ -74,7 +83,7 @@ ErrorCode ScopedSegmentAccess::MountSegment(const Segment& segment,
     // invalid for the slab allocator.
     try {
         // Create allocator based on the configured type
-        switch (segment_manager_->memory_allocator_) {
+        switch (allocator_type) {
             case BufferAllocatorType::CACHELIB:
                 allocator = std::make_shared<CachelibBufferAllocator>(
                     segment.name, buffer, size, segment.te_endpoint);
@@ -83,11 +92,15 @@ ErrorCode ScopedSegmentAccess::MountSegment(const Segment& segment,
                 allocator = std::make_shared<OffsetBufferAllocator>(
                     segment.name, buffer, size, segment.te_endpoint);
                 break;
+            case BufferAllocatorType::SLAB:
+                allocator = std::make_shared<SlabBufferAllocator>(
+                    segment.name, buffer, size, segment.slab_block_size,
+                    segment.te_endpoint);
+                break;
             default:
                 LOG(ERROR) << "segment_name=" << segment.name
                            << ", error=unknown_memory_allocator="
-                           << static_cast<int>(
-                                  segment_manager_->memory_allocator_);
+                           << static_cast<int>(allocator_type);
                 return ErrorCode::INVALID_PARAMS;
         }
 
@@ -102,7 +115,8 @@ ErrorCode ScopedSegmentAccess::MountSegment(const Segment& segment,
         return ErrorCode::INVALID_PARAMS;
     }
 
-    segment_manager_->allocator_manager_.addAllocator(segment.name, allocator);
+    segment_manager_->allocator_manager_.addAllocator(segment.name, allocator,
+                                                      segment.locality);
     segment_manager_->client_segments_[client_id].push_back(segment.id);
     segment_manager_->mounted_segments_[segment.id] = {
         segment, SegmentStatus::OK, std::move(allocator)};
@@ -178,8 +192,9 @@ ErrorCode ScopedSegmentAccess::PrepareUnmountSegment(
     std::shared_ptr<BufferAllocatorBase> allocator =
         mounted_segment.buf_allocator;
 
-    // 1. Remove from allocators
-    if (!segment_manager_->allocator_manager_.removeAllocator(segment.name,
+    // 1. Remove from allocators, draining segments already are
+    if (mounted_segment.status == SegmentStatus::OK &&
+        !segment_manager_->allocator_manager_.removeAllocator(segment.name,
                                                               allocator)) {
         LOG(ERROR) << "Allocator " << segment.id << " of segment "
                    << segment.name << " not found in allocator manager";
@@ -258,7 +273,9 @@ ErrorCode ScopedSegmentAccess::GetAllSegments(
     std::vector<std::string>& all_segments) {
     all_segments.clear();
     for (auto& segment : segment_manager_->mounted_segments_) {
-        if (segment.second.status == SegmentStatus::OK) {
+        // Draining segments are listed until they are unmounted
+        if (segment.second.status == SegmentStatus::OK ||
+            segment.second.status == SegmentStatus::DRAINING) {
             all_segments.push_back(segment.second.segment.name);
         }
     }
@@ -277,6 +294,17 @@ ErrorCode ScopedSegmentAccess::QuerySegments(const std::string& segment,
         }
     }
 
+    if (allocators == nullptr) {
+        // Draining segments are no longer in the allocator manager
+        for (const auto& [id, mounted] : segment_manager_->mounted_segments_) {
+            if (mounted.status == SegmentStatus::DRAINING &&
+                mounted.segment.name == segment && mounted.buf_allocator) {
+                total_used += mounted.buf_allocator->size();
+                total_capacity += mounted.buf_allocator->capacity();
+            }
+        }
+    }
+
     if (total_capacity == 0) {
         VLOG(1) << "### DEBUG ### MasterService::QuerySegments(" << segment
                 << ") not found!";
@@ -307,6 +335,89 @@ bool ScopedSegmentAccess::ExistsSegmentName(
     return it != segment_manager_->client_by_name_.end();
 }
 
+ErrorCode ScopedSegmentAccess::SetSegmentDraining(
+    const std::string& segment_name, bool draining) {
+    bool found = false;
+    for (auto& [id, mounted] : segment_manager_->mounted_segments_) {
+        if (mounted.segment.name != segment_name ||
+            mounted.status == SegmentStatus::UNMOUNTING) {
+            continue;
+        }
+        found = true;
+        if (draining && mounted.status == SegmentStatus::OK) {
+            segment_manager_->allocator_manager_.removeAllocator(
+                segment_name, mounted.buf_allocator);
+            mounted.status = SegmentStatus::DRAINING;
+        } else if (!draining && mounted.status == SegmentStatus::DRAINING) {
+            segment_manager_->allocator_manager_.addAllocator(
+                segment_name, mounted.buf_allocator, mounted.segment.locality);
+            mounted.status = SegmentStatus::OK;
+        }
+    }
+    if (!found) {
+        LOG(ERROR) << "segment_name=" << segment_name
+                   << ", error=segment_not_found";
+        return ErrorCode::SEGMENT_NOT_FOUND;
+    }
+    LOG(INFO) << "segment_name=" << segment_name
+              << ", action=" << (draining ? "drain" : "undrain") << "_segment";
+    return ErrorCode::OK;
+}
+
+ErrorCode ScopedSegmentAccess::DrainSegment(const UUID& segment_id,
+                                            const UUID& client_id,
+                                            size_t& used) {
+    auto it = segment_manager_->mounted_segments_.find(segment_id);
+    if (it == segment_manager_->mounted_segments_.end() ||
+        it->second.status == SegmentStatus::UNMOUNTING) {
+        LOG(ERROR) << "segment_id=" << segment_id
+                   << ", error=segment_not_found";
+        return ErrorCode::SEGMENT_NOT_FOUND;
+    }
+    auto client_it = segment_manager_->client_segments_.find(client_id);
+    if (client_it == segment_manager_->client_segments_.end() ||
+        std::find(client_it->second.begin(), client_it->second.end(),
+                  segment_id) == client_it->second.end()) {
+        LOG(ERROR) << "segment_id=" << segment_id
+                   << ", client_id=" << client_id
+                   << ", error=segment_not_owned_by_client";
+        return ErrorCode::INVALID_PARAMS;
+    }
+
+    auto& mounted = it->second;
+    if (mounted.status == SegmentStatus::OK) {
+        segment_manager_->allocator_manager_.removeAllocator(
+            mounted.segment.name, mounted.buf_allocator);
+        mounted.status = SegmentStatus::DRAINING;
+        LOG(INFO) << "segment_name=" << mounted.segment.name
+                  << ", segment_id=" << segment_id
+                  << ", action=drain_segment";
+    }
+    used = mounted.buf_allocator ? mounted.buf_allocator->size() : 0;
+    return ErrorCode::OK;
+}
+
+void ScopedSegmentAccess::GetSegmentUsage(
+    std::vector<SegmentUsage>& usage) const {
+    std::unordered_map<std::string, size_t> index;
+    usage.clear();
+    for (const auto& [id, mounted] : segment_manager_->mounted_segments_) {
+        if (mounted.status == SegmentStatus::UNMOUNTING ||
+            !mounted.buf_allocator || mounted.segment.protocol == "cxl") {
+            continue;
+        }
+        auto [it, inserted] = index.try_emplace(mounted.segment.name,
+                                                usage.size());
+        if (inserted) {
+            usage.push_back({.name = mounted.segment.name});
+        }
+        auto& entry = usage[it->second];
+        entry.used += mounted.buf_allocator->size();
+        entry.capacity += mounted.buf_allocator->capacity();
+        entry.draining |= mounted.status == SegmentStatus::DRAINING;
+    }
+}
+
 void SegmentManager::initializeCxlAllocator(const std::string& cxl_path,
                                             const size_t cxl_size) {
     LOG(INFO) << "Init CXL global allocator.";
@@ -2,13 +2,16 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
 #include <errno.h>
+#include <climits>
 #include <cstring>
 
 #include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <chrono>
@@ -16,13 +19,90 @@
 
 #include <ylt/struct_pb.hpp>
 
+#include "crc32c.h"
+#include "gds_file.h"
 #include "mutex.h"
+#include "thread_pool.h"
+#include "uring_file.h"
 #include "utils.h"
 
 #include <ylt/util/tl/expected.hpp>
 
 namespace mooncake {
 
+namespace {
+
+// Leads the index checkpoint, changed whenever its encoding changes
+constexpr std::string_view kIndexCheckpointMagic = "MCBKTIDX1";
+
+// Read-only mapping of a whole file, so that metadata is parsed straight
+// from the page cache instead of being copied into a buffer first
+class MappedFile {
+   public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (addr_ != nullptr) {
+            munmap(addr_, size_);
+        }
+    }
+
+    tl::expected<void, ErrorCode> Open(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            LOG(ERROR) << "Failed to open file for reading: " << path
+                       << ", error: " << strerror(errno);
+            return tl::make_unexpected(ErrorCode::FILE_OPEN_FAIL);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            LOG(ERROR) << "Failed to stat file: " << path
+                       << ", error: " << strerror(errno);
+            close(fd);
+            return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                LOG(ERROR) << "Failed to map file: " << path
+                           << ", error: " << strerror(errno);
+                close(fd);
+                return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
+            }
+            addr_ = addr;
+            madvise(addr_, size_, MADV_SEQUENTIAL);
+        }
+        close(fd);
+        return {};
+    }
+
+    std::string_view data() const {
+        return {static_cast<const char*>(addr_), size_};
+    }
+
+   private:
+    void* addr_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace
+
+#ifdef STORE_USE_GDS
+namespace {
+
+// Disk replicas are read into and written from GPU memory with GPUDirect
+// Storage unless MC_STORE_DISK_GDS=0
+bool UseGds() {
+    static const bool use_gds = GetEnvOr<bool>("MC_STORE_DISK_GDS", true);
+    return use_gds;
+}
+
+}  // namespace
+#endif
+
 bool FilePerKeyConfig::Validate() const {
     if (fsdir.empty()) {
         LOG(ERROR) << "FilePerKeyConfig: fsdir is invalid";
@@ -40,6 +120,15 @@ bool BucketBackendConfig::Validate() const {
         LOG(ERROR) << "BucketBackendConfig: bucket_size_limit must > 0";
         return false;
     }
+    if (index_checkpoint_interval_sec < 0) {
+        LOG(ERROR)
+            << "BucketBackendConfig: index_checkpoint_interval_sec must >= 0";
+        return false;
+    }
+    if (group_commit_window_us < 0) {
+        LOG(ERROR) << "BucketBackendConfig: group_commit_window_us must >= 0";
+        return false;
+    }
     return true;
 }
 
@@ -63,6 +152,60 @@ BucketBackendConfig BucketBackendConfig::FromEnvironment() {
     config.bucket_size_limit = GetEnvOr<int64_t>(
         "MOONCAKE_OFFLOAD_BUCKET_SIZE_LIMIT_BYTES", config.bucket_size_limit);
 
+    config.codec = GetEnvStringOr("MOONCAKE_OFFLOAD_CODEC", config.codec);
+
+    config.use_uring =
+        GetEnvOr<bool>("MOONCAKE_OFFLOAD_USE_URING", config.use_uring);
+
+    config.direct_io =
+        GetEnvOr<bool>("MOONCAKE_OFFLOAD_DIRECT_IO", config.direct_io);
+
+    config.scan_threads =
+        GetEnvOr<int64_t>("MOONCAKE_OFFLOAD_SCAN_THREADS", config.scan_threads);
+
+    config.index_checkpoint_interval_sec =
+        GetEnvOr<int64_t>("MOONCAKE_OFFLOAD_INDEX_CHECKPOINT_INTERVAL_SEC",
+                          config.index_checkpoint_interval_sec);
+
+    config.group_commit_window_us =
+        GetEnvOr<int64_t>("MOONCAKE_OFFLOAD_GROUP_COMMIT_WINDOW_US",
+                          config.group_commit_window_us);
+
+    return config;
+}
+
+bool LogStructuredConfig::Validate() const {
+    if (segment_size_limit <= 0) {
+        LOG(ERROR) << "LogStructuredConfig: segment_size_limit must > 0";
+        return false;
+    }
+    if (compaction_live_percent < 0 || compaction_live_percent > 100) {
+        LOG(ERROR) << "LogStructuredConfig: compaction_live_percent must be "
+                      "in [0, 100]";
+        return false;
+    }
+    if (compaction_interval_ms <= 0) {
+        LOG(ERROR) << "LogStructuredConfig: compaction_interval_ms must > 0";
+        return false;
+    }
+    return true;
+}
+
+LogStructuredConfig LogStructuredConfig::FromEnvironment() {
+    LogStructuredConfig config;
+
+    config.segment_size_limit =
+        GetEnvOr<int64_t>("MOONCAKE_OFFLOAD_SEGMENT_SIZE_LIMIT_BYTES",
+                          config.segment_size_limit);
+
+    config.compaction_live_percent =
+        GetEnvOr<int64_t>("MOONCAKE_OFFLOAD_COMPACTION_LIVE_PERCENT",
+                          config.compaction_live_percent);
+
+    config.compaction_interval_ms =
+        GetEnvOr<int64_t>("MOONCAKE_OFFLOAD_COMPACTION_INTERVAL_MS",
+                          config.compaction_interval_ms);
+
     return config;
 }
 
@@ -437,6 +580,39 @@ tl::expected<void, ErrorCode> StorageBackend::LoadObject(
     return {};
 }
 
+tl::expected<void, ErrorCode> StorageBackend::LoadObjectRange(
+    const std::string& path, const std::vector<Slice>& slices,
+    int64_t offset) {
+    ResolvePath(path);
+    auto file = create_file(path, FileMode::Read);
+    if (!file) {
+        LOG(ERROR) << "Failed to open file for reading: " << path;
+        return tl::make_unexpected(ErrorCode::FILE_OPEN_FAIL);
+    }
+
+    std::vector<iovec> iovs;
+    iovs.reserve(slices.size());
+    size_t length = 0;
+    for (const auto& slice : slices) {
+        iovs.push_back({slice.ptr, slice.size});
+        length += slice.size;
+    }
+    auto read_result = file->vector_read(
+        iovs.data(), static_cast<int>(iovs.size()), offset);
+    if (!read_result) {
+        LOG(ERROR) << "vector_read failed at offset " << offset
+                   << " for path: " << path
+                   << ", error: " << read_result.error();
+        return tl::make_unexpected(read_result.error());
+    }
+    if (*read_result != length) {
+        LOG(ERROR) << "Read size mismatch for range of path: " << path
+                   << ", expected: " << length << ", got: " << *read_result;
+        return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
+    }
+    return {};
+}
+
 tl::expected<void, ErrorCode> StorageBackend::LoadObject(
     const std::string& path, std::string& str, int64_t length) {
     ResolvePath(path);
@@ -766,6 +942,18 @@ std::unique_ptr<StorageFile> StorageBackend::create_file(
     }
 #endif
 
+#ifdef STORE_USE_GDS
+    if (UseGds()) {
+        // Opened after fd, which created and truncated the file. cuFile
+        // needs O_DIRECT to bypass host memory.
+        int direct_fd =
+            open(path.c_str(), flags | O_DIRECT |
+                                   (mode == FileMode::Read ? O_RDONLY
+                                                           : O_WRONLY));
+        return std::make_unique<GdsFile>(path, fd, direct_fd);
+    }
+#endif
+
     return std::make_unique<PosixFile>(path, fd);
 }
 
@@ -1230,7 +1418,8 @@ BucketStorageBackend::BucketStorageBackend(
     const BucketBackendConfig& bucket_backend_config_)
     : StorageBackendInterface(file_storage_config_),
       storage_path_(file_storage_config_.storage_filepath),
-      bucket_backend_config_(bucket_backend_config_) {}
+      bucket_backend_config_(bucket_backend_config_),
+      codec_(OffloadCodec::FromName(bucket_backend_config_.codec)) {}
 
 tl::expected<int64_t, ErrorCode> BucketStorageBackend::BatchOffload(
     const std::unordered_map<std::string, std::vector<Slice>>& batch_object,
@@ -1254,11 +1443,15 @@ tl::expected<int64_t, ErrorCode> BucketStorageBackend::BatchOffload(
     if (!enable_offloading_res.value()) {
         return tl::make_unexpected(ErrorCode::KEYS_ULTRA_LIMIT);
     }
+    if (bucket_backend_config_.group_commit_window_us > 0) {
+        return GroupOffload(batch_object, complete_handler);
+    }
     auto bucket_id = bucket_id_generator_->NextId();
     std::vector<iovec> iovs;
+    std::vector<std::vector<char>> encoded;
     std::vector<StorageObjectMetadata> metadatas;
     auto build_bucket_result =
-        BuildBucket(bucket_id, batch_object, iovs, metadatas);
+        BuildBucket(bucket_id, batch_object, iovs, encoded, metadatas);
     if (!build_bucket_result) {
         LOG(ERROR) << "Failed to build bucket with id: " << bucket_id;
         return tl::make_unexpected(build_bucket_result.error());
@@ -1285,6 +1478,155 @@ tl::expected<int64_t, ErrorCode> BucketStorageBackend::BatchOffload(
         object_bucket_map_.emplace(bucket->keys[i], std::move(metadatas[i]));
     }
     buckets_.emplace(bucket_id, std::move(bucket));
+    buckets_since_checkpoint_.fetch_add(1, std::memory_order_relaxed);
+    return bucket_id;
+}
+
+struct BucketStorageBackend::OffloadWriter {
+    // Built as a bucket of its own, moved into the bucket of the group
+    std::shared_ptr<BucketMetadata> bucket;
+    std::vector<iovec> iovs;
+    std::vector<std::vector<char>> encoded;
+    std::vector<StorageObjectMetadata> metadatas;
+    bool leader = false;
+    bool done = false;
+    tl::expected<int64_t, ErrorCode> result;  // Bucket id of the group
+};
+
+tl::expected<int64_t, ErrorCode> BucketStorageBackend::GroupOffload(
+    const std::unordered_map<std::string, std::vector<Slice>>& batch_object,
+    const std::function<ErrorCode(
+        const std::vector<std::string>& keys,
+        std::vector<StorageObjectMetadata>& metadatas)>& complete_handler) {
+    OffloadWriter writer;
+    // The bucket id and the offsets are assigned when the group is written
+    auto build_bucket_result = BuildBucket(0, batch_object, writer.iovs,
+                                           writer.encoded, writer.metadatas);
+    if (!build_bucket_result) {
+        LOG(ERROR) << "Failed to build bucket for group commit";
+        return tl::make_unexpected(build_bucket_result.error());
+    }
+    writer.bucket = build_bucket_result.value();
+
+    {
+        std::unique_lock lock(group_mutex_);
+        group_queue_.push_back(&writer);
+        writer.leader = group_queue_.size() == 1;
+        group_cv_.notify_all();
+        group_cv_.wait(lock, [&] { return writer.leader || writer.done; });
+        if (!writer.done) {
+            CommitGroup(lock);
+        }
+    }
+    if (!writer.result) {
+        return tl::make_unexpected(writer.result.error());
+    }
+
+    const int64_t bucket_id = writer.result.value();
+    if (complete_handler != nullptr) {
+        auto error_code =
+            complete_handler(writer.bucket->keys, writer.metadatas);
+        if (error_code != ErrorCode::OK) {
+            LOG(ERROR) << "Complete handler failed: " << error_code
+                       << ", Key count: " << writer.bucket->keys.size()
+                       << ", Bucket id: " << bucket_id;
+            return tl::make_unexpected(error_code);
+        }
+    }
+    SharedMutexLocker lock(&mutex_);
+    object_bucket_map_.reserve(object_bucket_map_.size() +
+                               writer.bucket->keys.size());
+    for (size_t i = 0; i < writer.bucket->keys.size(); ++i) {
+        object_bucket_map_.emplace(writer.bucket->keys[i],
+                                   std::move(writer.metadatas[i]));
+    }
+    return bucket_id;
+}
+
+void BucketStorageBackend::CommitGroup(std::unique_lock<std::mutex>& lock) {
+    const int64_t keys_limit = bucket_backend_config_.bucket_keys_limit;
+    const int64_t size_limit = bucket_backend_config_.bucket_size_limit;
+    auto group_full = [&] {
+        int64_t keys = 0;
+        int64_t size = 0;
+        for (const auto* writer : group_queue_) {
+            keys += writer->bucket->keys.size();
+            size += writer->bucket->data_size;
+        }
+        return keys >= keys_limit || size >= size_limit;
+    };
+    group_cv_.wait_for(lock,
+                       std::chrono::microseconds(
+                           bucket_backend_config_.group_commit_window_us),
+                       group_full);
+
+    // The head always goes, the others as long as the bucket stays within
+    // the limits
+    std::vector<OffloadWriter*> group;
+    int64_t keys = 0;
+    int64_t size = 0;
+    while (!group_queue_.empty()) {
+        auto* writer = group_queue_.front();
+        const int64_t writer_keys = writer->bucket->keys.size();
+        if (!group.empty() && (keys + writer_keys > keys_limit ||
+                               size + writer->bucket->data_size > size_limit)) {
+            break;
+        }
+        keys += writer_keys;
+        size += writer->bucket->data_size;
+        group.push_back(writer);
+        group_queue_.pop_front();
+    }
+
+    lock.unlock();
+    auto result = WriteGroup(group);
+    lock.lock();
+
+    for (auto* writer : group) {
+        writer->result = result;
+        writer->done = true;
+    }
+    if (!group_queue_.empty()) {
+        group_queue_.front()->leader = true;
+    }
+    group_cv_.notify_all();
+}
+
+tl::expected<int64_t, ErrorCode> BucketStorageBackend::WriteGroup(
+    const std::vector<OffloadWriter*>& group) {
+    const int64_t bucket_id = bucket_id_generator_->NextId();
+    auto bucket = std::make_shared<BucketMetadata>();
+    std::vector<iovec> iovs;
+    for (auto* writer : group) {
+        const int64_t base = bucket->data_size;
+        for (size_t i = 0; i < writer->bucket->keys.size(); ++i) {
+            auto object_metadata = writer->bucket->metadatas[i];
+            object_metadata.offset += base;
+            bucket->metadatas.emplace_back(std::move(object_metadata));
+            bucket->keys.push_back(writer->bucket->keys[i]);
+            writer->metadatas[i].bucket_id = bucket_id;
+            writer->metadatas[i].offset += base;
+        }
+        bucket->data_size += writer->bucket->data_size;
+        iovs.insert(iovs.end(), writer->iovs.begin(), writer->iovs.end());
+    }
+    auto write_bucket_result = WriteBucket(bucket_id, bucket, iovs);
+    if (!write_bucket_result) {
+        LOG(ERROR) << "Failed to write bucket with id: " << bucket_id
+                   << ", offloads in group: " << group.size();
+        return tl::make_unexpected(write_bucket_result.error());
+    }
+    VLOG(1) << "action=group_commit, bucket_id=" << bucket_id
+            << ", offloads=" << group.size()
+            << ", keys=" << bucket->keys.size()
+            << ", size=" << bucket->data_size;
+
+    // The keys are indexed by their own offloads, once their complete
+    // handler has succeeded
+    SharedMutexLocker lock(&mutex_);
+    total_size_ += bucket->data_size + bucket->meta_size;
+    buckets_.emplace(bucket_id, std::move(bucket));
+    buckets_since_checkpoint_.fetch_add(1, std::memory_order_relaxed);
     return bucket_id;
 }
 
@@ -1352,6 +1694,17 @@ tl::expected<void, ErrorCode> BucketStorageBackend::GetBucketKeys(
     return {};
 }
 
+BucketStorageBackend::~BucketStorageBackend() {
+    {
+        std::lock_guard lock(checkpoint_wait_mutex_);
+        checkpoint_running_.store(false);
+    }
+    checkpoint_cv_.notify_all();
+    if (checkpoint_thread_.joinable()) {
+        checkpoint_thread_.join();
+    }
+}
+
 tl::expected<void, ErrorCode> BucketStorageBackend::Init() {
     namespace fs = std::filesystem;
     try {
@@ -1359,145 +1712,176 @@ tl::expected<void, ErrorCode> BucketStorageBackend::Init() {
             LOG(ERROR) << "Storage backend already initialized";
             return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
         }
+        auto start_time = std::chrono::steady_clock::now();
         SharedMutexLocker lock(&mutex_);
         object_bucket_map_.clear();
         buckets_.clear();
         total_size_ = 0;
         int64_t max_bucket_id = BucketIdGenerator::INIT_NEW_START_ID;
+
+        // A single walk collects the metadata and the data files
+        std::vector<int64_t> meta_bucket_ids;
+        std::vector<fs::path> data_files;
         for (const auto& entry :
              fs::recursive_directory_iterator(storage_path_)) {
-            if (entry.is_regular_file() &&
-                entry.path().extension() == BUCKET_METADATA_FILE_SUFFIX) {
-                const auto& bucket_id_str = entry.path().stem();
-                int64_t bucket_id = std::stoll(bucket_id_str);
-                auto [metadata_it, success] = buckets_.try_emplace(
-                    bucket_id, std::make_shared<BucketMetadata>());
-                if (!success) {
-                    LOG(ERROR) << "Failed to load bucket " << bucket_id_str;
-                    return tl::make_unexpected(
-                        ErrorCode::BUCKET_ALREADY_EXISTS);
-                }
-                auto load_bucket_metadata_result =
-                    LoadBucketMetadata(bucket_id, metadata_it->second);
-                if (!load_bucket_metadata_result) {
-                    LOG(ERROR)
-                        << "Failed to load metadata for bucket: "
-                        << bucket_id_str
-                        << ", will delete the bucket's data and metadata";
-
-                    auto bucket_data_path_res = GetBucketDataPath(bucket_id);
-                    if (bucket_data_path_res) {
-                        fs::remove(bucket_data_path_res.value());
-                    }
+            if (!entry.is_regular_file()) {
+                continue;
+            }
+            const auto extension = entry.path().extension();
+            if (extension == BUCKET_METADATA_FILE_SUFFIX) {
+                meta_bucket_ids.push_back(std::stoll(entry.path().stem()));
+            } else if (extension == BUCKET_DATA_FILE_SUFFIX) {
+                data_files.push_back(entry.path());
+            }
+        }
 
-                    auto bucket_meta_path_res =
-                        GetBucketMetadataPath(bucket_id);
-                    if (bucket_meta_path_res) {
-                        fs::remove(bucket_meta_path_res.value());
-                    }
+        // Buckets are never modified once written, so those in the index
+        // checkpoint need not have their metadata file read
+        std::unordered_map<int64_t, BucketIndexEntry> checkpoint;
+        if (bucket_backend_config_.index_checkpoint_interval_sec > 0) {
+            auto load_checkpoint_result = LoadIndexCheckpoint(checkpoint);
+            if (!load_checkpoint_result) {
+                LOG(WARNING) << "Ignoring the bucket index checkpoint, error: "
+                             << load_checkpoint_result.error();
+                checkpoint.clear();
+            }
+        }
 
-                    buckets_.erase(bucket_id);
-                    continue;
-                }
-                auto& meta = *(metadata_it->second);
-                if (meta.data_size == 0 || meta.meta_size == 0 ||
-                    meta.metadatas.empty() || meta.keys.empty()) {
-                    LOG(ERROR) << "Metadata validation failed for bucket: "
-                               << bucket_id_str
-                               << ", will delete the bucket's data and "
-                                  "metadata. Detailed values:";
-                    LOG(ERROR) << "  data_size: " << meta.data_size
-                               << " (should not be 0)";
-                    LOG(ERROR) << "  meta_size: " << meta.meta_size
-                               << " (should not be 0)";
-                    LOG(ERROR)
-                        << "  object_metadata.size(): " << meta.metadatas.size()
-                        << " (empty: "
-                        << (meta.metadatas.empty() ? "true" : "false") << ")";
-
-                    LOG(ERROR)
-                        << "  keys.size(): " << meta.keys.size()
-                        << " (empty: " << (meta.keys.empty() ? "true" : "false")
-                        << ")";
-                    auto bucket_data_path_res = GetBucketDataPath(bucket_id);
-                    if (bucket_data_path_res) {
-                        fs::remove(bucket_data_path_res.value());
-                    }
+        std::vector<std::pair<int64_t, std::shared_ptr<BucketMetadata>>>
+            loaded(meta_bucket_ids.size());
+        std::vector<size_t> to_read;
+        for (size_t i = 0; i < meta_bucket_ids.size(); ++i) {
+            const int64_t bucket_id = meta_bucket_ids[i];
+            auto checkpoint_it = checkpoint.find(bucket_id);
+            if (checkpoint_it == checkpoint.end() ||
+                checkpoint_it->second.metadata.keys.size() !=
+                    checkpoint_it->second.metadata.metadatas.size()) {
+                to_read.push_back(i);
+                continue;
+            }
+            auto metadata = std::make_shared<BucketMetadata>(
+                std::move(checkpoint_it->second.metadata));
+            metadata->meta_size = checkpoint_it->second.meta_size;
+            loaded[i] = {bucket_id, std::move(metadata)};
+            checkpoint.erase(checkpoint_it);
+        }
+
+        // The other metadata files are read in parallel
+        const size_t num_threads = std::min<size_t>(
+            std::max<int64_t>(bucket_backend_config_.scan_threads, 1),
+            to_read.size());
+        std::atomic<size_t> next_to_read{0};
+        auto read_metadata_files = [&]() {
+            for (size_t n = next_to_read++; n < to_read.size();
+                 n = next_to_read++) {
+                const size_t i = to_read[n];
+                auto metadata = std::make_shared<BucketMetadata>();
+                auto load_bucket_metadata_result =
+                    LoadBucketMetadata(meta_bucket_ids[i], metadata);
+                loaded[i] = {meta_bucket_ids[i], load_bucket_metadata_result
+                                                     ? std::move(metadata)
+                                                     : nullptr};
+            }
+        };
+        if (num_threads > 1) {
+            ThreadPool pool(num_threads);
+            for (size_t i = 0; i < num_threads; ++i) {
+                pool.enqueue(read_metadata_files);
+            }
+            pool.stop();
+        } else {
+            read_metadata_files();
+        }
 
-                    auto bucket_meta_path_res =
-                        GetBucketMetadataPath(bucket_id);
-                    if (bucket_meta_path_res) {
-                        fs::remove(bucket_meta_path_res.value());
-                    }
+        auto remove_bucket_files = [this](int64_t bucket_id) {
+            auto bucket_data_path_res = GetBucketDataPath(bucket_id);
+            if (bucket_data_path_res) {
+                fs::remove(bucket_data_path_res.value());
+            }
+            auto bucket_meta_path_res = GetBucketMetadataPath(bucket_id);
+            if (bucket_meta_path_res) {
+                fs::remove(bucket_meta_path_res.value());
+            }
+        };
 
-                    buckets_.erase(bucket_id);
-                    continue;
-                }
-                if (bucket_id > max_bucket_id) {
-                    max_bucket_id = bucket_id;
-                }
-                total_size_ += metadata_it->second->data_size +
-                               metadata_it->second->meta_size;
-                for (size_t i = 0; i < metadata_it->second->keys.size(); i++) {
-                    object_bucket_map_.emplace(
-                        metadata_it->second->keys[i],
-                        StorageObjectMetadata{
-                            metadata_it->first,
-                            metadata_it->second->metadatas[i].offset,
-                            metadata_it->second->metadatas[i].key_size,
-                            metadata_it->second->metadatas[i].data_size, ""});
-                }
+        for (auto& [bucket_id, metadata] : loaded) {
+            if (!metadata) {
+                LOG(ERROR) << "Failed to load metadata for bucket: "
+                           << bucket_id
+                           << ", will delete the bucket's data and metadata";
+                remove_bucket_files(bucket_id);
+                continue;
+            }
+            const auto& meta = *metadata;
+            if (meta.data_size == 0 || meta.meta_size == 0 ||
+                meta.metadatas.empty() || meta.keys.empty()) {
+                LOG(ERROR) << "Metadata validation failed for bucket: "
+                           << bucket_id
+                           << ", will delete the bucket's data and "
+                              "metadata. Detailed values:";
+                LOG(ERROR) << "  data_size: " << meta.data_size
+                           << " (should not be 0)";
+                LOG(ERROR) << "  meta_size: " << meta.meta_size
+                           << " (should not be 0)";
+                LOG(ERROR) << "  object_metadata.size(): "
+                           << meta.metadatas.size() << " (empty: "
+                           << (meta.metadatas.empty() ? "true" : "false")
+                           << ")";
+                LOG(ERROR) << "  keys.size(): " << meta.keys.size()
+                           << " (empty: "
+                           << (meta.keys.empty() ? "true" : "false") << ")";
+                remove_bucket_files(bucket_id);
+                continue;
+            }
+            auto [metadata_it, success] =
+                buckets_.try_emplace(bucket_id, metadata);
+            if (!success) {
+                LOG(ERROR) << "Failed to load bucket " << bucket_id;
+                return tl::make_unexpected(ErrorCode::BUCKET_ALREADY_EXISTS);
+            }
+            if (bucket_id > max_bucket_id) {
+                max_bucket_id = bucket_id;
+            }
+            total_size_ += meta.data_size + meta.meta_size;
+            for (size_t i = 0; i < meta.keys.size(); i++) {
+                object_bucket_map_.emplace(
+                    meta.keys[i],
+                    StorageObjectMetadata{bucket_id, meta.metadatas[i].offset,
+                                          meta.metadatas[i].key_size,
+                                          meta.metadatas[i].data_size, ""});
             }
         }
 
         // Clean up orphaned bucket files (.bucket files without corresponding
         // .meta files) This handles the crash consistency case where data write
         // succeeded but metadata write failed
-        std::unordered_set<int64_t> valid_bucket_ids;
-        for (const auto& [id, _] : buckets_) {
-            valid_bucket_ids.insert(id);
-        }
-
         uint64_t orphaned_files_count = 0;
         uint64_t orphaned_space_freed = 0;
 
-        for (const auto& entry :
-             fs::recursive_directory_iterator(storage_path_)) {
-            if (!entry.is_regular_file()) {
-                continue;
-            }
-
-            std::string extension = entry.path().extension().string();
-
-            // Only process .bucket files
-            if (extension != BUCKET_DATA_FILE_SUFFIX) {
-                continue;
-            }
-
+        for (const auto& data_file : data_files) {
             // Extract bucket ID from filename (e.g., "12345.bucket" ->
             // "12345")
-            auto bucket_id_str = entry.path().stem();
-            int64_t bucket_id = std::stoll(bucket_id_str);
+            int64_t bucket_id = std::stoll(data_file.stem());
 
             // Check if this bucket has valid metadata
-            if (valid_bucket_ids.find(bucket_id) != valid_bucket_ids.end()) {
+            if (buckets_.find(bucket_id) != buckets_.end()) {
                 // Valid bucket, skip it
                 continue;
             }
 
             // This is an orphaned .bucket file without metadata
             std::error_code cleanup_ec;
-            uint64_t file_size = entry.file_size(cleanup_ec);
-            if (!cleanup_ec && fs::remove(entry.path(), cleanup_ec)) {
+            uint64_t file_size = fs::file_size(data_file, cleanup_ec);
+            if (!cleanup_ec && fs::remove(data_file, cleanup_ec)) {
                 orphaned_files_count++;
                 orphaned_space_freed += file_size;
                 LOG(WARNING) << "Removed orphaned bucket file (no metadata): "
-                             << entry.path().string() << " (size: " << file_size
+                             << data_file.string() << " (size: " << file_size
                              << " bytes, "
                              << "bucket_id: " << bucket_id << ")";
             } else if (cleanup_ec) {
                 LOG(ERROR) << "Failed to remove orphaned bucket file: "
-                           << entry.path().string()
+                           << data_file.string()
                            << ", error: " << cleanup_ec.message();
             }
         }
@@ -1509,6 +1893,19 @@ tl::expected<void, ErrorCode> BucketStorageBackend::Init() {
                       << orphaned_space_freed << " bytes";
         }
 
+        // Buckets not in the checkpoint make it stale
+        buckets_since_checkpoint_.store(static_cast<int64_t>(to_read.size()));
+
+        LOG(INFO) << "Loaded " << buckets_.size() << " buckets ("
+                  << meta_bucket_ids.size() - to_read.size()
+                  << " from the index checkpoint, " << to_read.size()
+                  << " metadata files read by "
+                  << std::max<size_t>(num_threads, 1) << " threads) in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start_time)
+                         .count()
+                  << " ms";
+
         bucket_id_generator_.emplace(max_bucket_id);
         if (max_bucket_id == BucketIdGenerator::INIT_NEW_START_ID) {
             LOG(INFO) << "Initialized BucketIdGenerator with fresh start. "
@@ -1525,6 +1922,12 @@ tl::expected<void, ErrorCode> BucketStorageBackend::Init() {
         return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
     }
 
+    if (bucket_backend_config_.index_checkpoint_interval_sec > 0) {
+        checkpoint_running_.store(true);
+        checkpoint_thread_ =
+            std::thread(&BucketStorageBackend::IndexCheckpointThreadFunc, this);
+    }
+
     return {};
 }
 
@@ -1728,30 +2131,46 @@ tl::expected<std::shared_ptr<BucketMetadata>, ErrorCode>
 BucketStorageBackend::BuildBucket(
     int64_t bucket_id,
     const std::unordered_map<std::string, std::vector<Slice>>& batch_object,
-    std::vector<iovec>& iovs, std::vector<StorageObjectMetadata>& metadatas) {
+    std::vector<iovec>& iovs, std::vector<std::vector<char>>& encoded,
+    std::vector<StorageObjectMetadata>& metadatas) {
     auto bucket = std::make_shared<BucketMetadata>();
     int64_t storage_offset = 0;
+    // The iovecs point into the encoded buffers, which must not move
+    encoded.reserve(batch_object.size());
     for (const auto& object : batch_object) {
         if (object.second.empty()) {
             LOG(ERROR) << "Failed to create bucket, object is empty";
             return tl::make_unexpected(ErrorCode::INVALID_KEY);
         }
         int64_t object_total_size = 0;
-        iovs.emplace_back(
-            iovec{const_cast<char*>(object.first.data()), object.first.size()});
         for (const auto& slice : object.second) {
             object_total_size += slice.size;
-            iovs.emplace_back(iovec{slice.ptr, slice.size});
         }
-        bucket->data_size += object_total_size + object.first.size();
-        bucket->metadatas.emplace_back(BucketObjectMetadata{
+        iovs.emplace_back(
+            iovec{const_cast<char*>(object.first.data()), object.first.size()});
+        BucketObjectMetadata object_metadata{
             storage_offset, static_cast<int64_t>(object.first.size()),
-            object_total_size});
+            object_total_size};
+        std::vector<char> buffer;
+        if (codec_->type() != OffloadCodecType::kNone &&
+            codec_->Encode(object.second, object_total_size, buffer)) {
+            object_metadata.codec = static_cast<int32_t>(codec_->type());
+            object_metadata.stored_size = buffer.size();
+            iovs.emplace_back(iovec{buffer.data(), buffer.size()});
+            encoded.emplace_back(std::move(buffer));
+        } else {
+            object_metadata.stored_size = object_total_size;
+            for (const auto& slice : object.second) {
+                iovs.emplace_back(iovec{slice.ptr, slice.size});
+            }
+        }
+        bucket->data_size += object_metadata.stored_size + object.first.size();
         metadatas.emplace_back(StorageObjectMetadata{
             bucket_id, storage_offset,
             static_cast<int64_t>(object.first.size()), object_total_size, ""});
         bucket->keys.push_back(object.first);
-        storage_offset += object_total_size + object.first.size();
+        storage_offset += object_metadata.stored_size + object.first.size();
+        bucket->metadatas.emplace_back(std::move(object_metadata));
     }
     return bucket;
 }
@@ -1850,39 +2269,158 @@ tl::expected<void, ErrorCode> BucketStorageBackend::LoadBucketMetadata(
         return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
     }
     auto meta_path = meta_path_res.value();
-    auto open_file_result = OpenFile(meta_path, FileMode::Read);
-    if (!open_file_result) {
-        LOG(ERROR) << "Failed to open file for reading: " << meta_path;
-        return tl::make_unexpected(open_file_result.error());
+    MappedFile file;
+    auto open_result = file.Open(meta_path);
+    if (!open_result) {
+        return tl::make_unexpected(open_result.error());
     }
-    auto file = std::move(open_file_result.value());
-    std::string str;
-    int64_t size = std::filesystem::file_size(meta_path);
-    auto read_result = file->read(str, size);
-    if (!read_result) {
-        LOG(ERROR) << "read failed for: " << meta_path
-                   << ", error: " << read_result.error();
-        return tl::make_unexpected(read_result.error());
+    try {
+        struct_pb::from_pb(*metadata, file.data());
+        metadata->meta_size = static_cast<int64_t>(file.data().size());
+    } catch (const std::exception& e) {
+        LOG(ERROR) << "Metadata parsing failed with exception: " << e.what();
+        return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
+    } catch (...) {
+        LOG(ERROR) << "Metadata parsing failed with unknown exception";
+        return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
+    }
+    return {};
+}
+
+std::string BucketStorageBackend::GetIndexCheckpointPath() const {
+    return (std::filesystem::path(storage_path_) / INDEX_CHECKPOINT_FILE_NAME)
+        .string();
+}
+
+tl::expected<void, ErrorCode> BucketStorageBackend::LoadIndexCheckpoint(
+    std::unordered_map<int64_t, BucketIndexEntry>& entries) {
+    const auto path = GetIndexCheckpointPath();
+    if (!std::filesystem::exists(path)) {
+        return {};
     }
-    if (static_cast<int64_t>(read_result.value()) != size) {
-        LOG(ERROR) << "Read size mismatch for: " << meta_path
-                   << ", expected: " << size
-                   << ", got: " << read_result.value();
+    MappedFile file;
+    auto open_result = file.Open(path);
+    if (!open_result) {
+        return tl::make_unexpected(open_result.error());
+    }
+    // The protobuf encoding does not reject every kind of garbage, a
+    // checkpoint without the magic is not parsed at all
+    const std::string_view data = file.data();
+    if (!data.starts_with(kIndexCheckpointMagic)) {
+        LOG(ERROR) << "Index checkpoint has no valid header: " << path;
         return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
     }
+    BucketIndexCheckpoint checkpoint;
     try {
-        struct_pb::from_pb(*metadata, str);
-        metadata->meta_size = size;
+        struct_pb::from_pb(checkpoint,
+                           data.substr(kIndexCheckpointMagic.size()));
     } catch (const std::exception& e) {
-        LOG(ERROR) << "Metadata parsing failed with exception: " << e.what();
+        LOG(ERROR) << "Index checkpoint parsing failed with exception: "
+                   << e.what();
         return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
     } catch (...) {
-        LOG(ERROR) << "Metadata parsing failed with unknown exception";
+        LOG(ERROR) << "Index checkpoint parsing failed with unknown exception";
         return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
     }
+    entries.reserve(checkpoint.buckets.size());
+    for (auto& entry : checkpoint.buckets) {
+        const int64_t bucket_id = entry.bucket_id;
+        entries.emplace(bucket_id, std::move(entry));
+    }
+    return {};
+}
+
+tl::expected<void, ErrorCode> BucketStorageBackend::WriteIndexCheckpoint() {
+    MutexLocker checkpoint_lock(&checkpoint_mutex_);
+    const int64_t pending = buckets_since_checkpoint_.exchange(0);
+
+    // Bucket metadata is immutable, only the map is copied under the lock
+    std::vector<std::pair<int64_t, std::shared_ptr<BucketMetadata>>> buckets;
+    {
+        SharedMutexLocker lock(&mutex_, shared_lock);
+        buckets.assign(buckets_.begin(), buckets_.end());
+    }
+    BucketIndexCheckpoint checkpoint;
+    checkpoint.buckets.reserve(buckets.size());
+    for (const auto& [bucket_id, metadata] : buckets) {
+        checkpoint.buckets.push_back(
+            BucketIndexEntry{bucket_id, metadata->meta_size, *metadata});
+    }
+    std::string pb;
+    struct_pb::to_pb(checkpoint, pb);
+    std::string buffer;
+    buffer.reserve(kIndexCheckpointMagic.size() + pb.size());
+    buffer.append(kIndexCheckpointMagic).append(pb);
+
+    // Written aside and renamed over the previous one, so that a crash
+    // leaves either of them whole
+    const auto path = GetIndexCheckpointPath();
+    const auto tmp_path = path + ".tmp";
+    auto fail = [&](const char* what) -> tl::expected<void, ErrorCode> {
+        LOG(ERROR) << "Failed to " << what
+                   << " index checkpoint: " << tmp_path
+                   << ", error: " << strerror(errno);
+        unlink(tmp_path.c_str());
+        buckets_since_checkpoint_.fetch_add(pending);
+        return tl::make_unexpected(ErrorCode::FILE_WRITE_FAIL);
+    };
+    int fd = open(tmp_path.c_str(), O_CLOEXEC | O_WRONLY | O_CREAT | O_TRUNC,
+                  0644);
+    if (fd < 0) {
+        return fail("open");
+    }
+    size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t n = ::write(fd, buffer.data() + written,
+                            buffer.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            close(fd);
+            return fail("write");
+        }
+        written += n;
+    }
+    if (fsync(fd) != 0) {
+        close(fd);
+        return fail("sync");
+    }
+    close(fd);
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+        return fail("rename");
+    }
+    VLOG(1) << "action=write_index_checkpoint, buckets=" << buckets.size()
+            << ", size=" << buffer.size();
     return {};
 }
 
+void BucketStorageBackend::IndexCheckpointThreadFunc() {
+    LOG(INFO) << "action=index_checkpoint_thread_started";
+    std::unique_lock lock(checkpoint_wait_mutex_);
+    while (true) {
+        // Also runs once more on shutdown, for the buckets added last
+        if (buckets_since_checkpoint_.load() > 0) {
+            lock.unlock();
+            auto result = WriteIndexCheckpoint();
+            if (!result) {
+                LOG(WARNING) << "action=write_index_checkpoint_failed, error="
+                             << result.error();
+            }
+            lock.lock();
+        }
+        if (!checkpoint_running_.load()) {
+            break;
+        }
+        checkpoint_cv_.wait_for(
+            lock,
+            std::chrono::seconds(
+                bucket_backend_config_.index_checkpoint_interval_sec),
+            [this] { return !checkpoint_running_.load(); });
+    }
+    LOG(INFO) << "action=index_checkpoint_thread_stopped";
+}
+
 tl::expected<void, ErrorCode> BucketStorageBackend::BatchLoadBucket(
     int64_t bucket_id, const std::vector<std::string>& keys,
     const std::vector<StorageObjectMetadata>& metadatas,
@@ -1900,6 +2438,17 @@ tl::expected<void, ErrorCode> BucketStorageBackend::BatchLoadBucket(
         return tl::make_unexpected(open_file_result.error());
     }
     auto file = std::move(open_file_result.value());
+    auto bucket_it = buckets_.find(bucket_id);
+    if (bucket_it == buckets_.end()) {
+        LOG(ERROR) << "Bucket " << bucket_id << " does not exist";
+        return tl::make_unexpected(ErrorCode::BUCKET_NOT_FOUND);
+    }
+    const auto& bucket_objects = bucket_it->second->metadatas;
+    // All the objects are read in one batch, then the encoded ones decoded
+    std::vector<FileReadRequest> requests;
+    requests.reserve(keys.size());
+    std::vector<std::vector<char>> encoded(keys.size());
+    std::vector<const OffloadCodec*> codecs(keys.size(), nullptr);
     for (size_t i = 0; i < keys.size(); i++) {
         const auto& key = keys[i];
         int64_t offset;
@@ -1912,21 +2461,56 @@ tl::expected<void, ErrorCode> BucketStorageBackend::BatchLoadBucket(
             return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
         }
         offset = object_metadata.offset;
-        std::vector<iovec> iovs;
-        iovs.emplace_back(iovec{slice.ptr, slice.size});
-        auto read_result = file->vector_read(
-            iovs.data(), static_cast<int>(iovs.size()), offset + key.size());
-        if (!read_result) {
-            LOG(ERROR) << "vector_read failed for: " << storage_filepath
-                       << ", error: " << read_result.error();
-            return tl::make_unexpected(read_result.error());
+        // Objects are laid out in the order of their offsets
+        auto bucket_object_it = std::lower_bound(
+            bucket_objects.begin(), bucket_objects.end(), offset,
+            [](const BucketObjectMetadata& m, int64_t value) {
+                return m.offset < value;
+            });
+        auto codec_type = OffloadCodecType::kNone;
+        if (bucket_object_it != bucket_objects.end() &&
+            bucket_object_it->offset == offset) {
+            codec_type =
+                static_cast<OffloadCodecType>(bucket_object_it->codec);
+        }
+        const off_t data_offset = offset + key.size();
+        if (codec_type == OffloadCodecType::kNone) {
+            requests.push_back(
+                FileReadRequest{slice.ptr, slice.size, data_offset});
+            continue;
         }
-        if (read_result.value() != slice.size) {
-            LOG(ERROR) << "Read size mismatch for: " << storage_filepath
-                       << ", expected: " << slice.size
-                       << ", got: " << read_result.value();
+        codecs[i] = OffloadCodec::Get(codec_type);
+        if (codecs[i] == nullptr) {
+            LOG(ERROR) << "Key " << key << " is stored with codec "
+                       << static_cast<int32_t>(codec_type)
+                       << ", which is not built in";
             return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
         }
+        encoded[i].resize(bucket_object_it->stored_size);
+        requests.push_back(FileReadRequest{encoded[i].data(),
+                                           encoded[i].size(), data_offset});
+    }
+
+    auto read_result = file->batch_read(requests);
+    if (!read_result) {
+        LOG(ERROR) << "batch_read failed for: " << storage_filepath
+                   << ", keys: " << keys.size()
+                   << ", error: " << read_result.error();
+        return tl::make_unexpected(read_result.error());
+    }
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (codecs[i] == nullptr) {
+            continue;
+        }
+        const auto& slice = batched_slices.at(keys[i]);
+        auto err = codecs[i]->Decode(encoded[i].data(), encoded[i].size(),
+                                     static_cast<char*>(slice.ptr), slice.size);
+        if (err != ErrorCode::OK) {
+            LOG(ERROR) << "Failed to decode key " << keys[i] << " from "
+                       << storage_filepath << ", codec: " << codecs[i]->name();
+            return tl::make_unexpected(err);
+        }
     }
     return {};
 }
@@ -1964,9 +2548,36 @@ BucketStorageBackend::OpenFile(const std::string& path, FileMode mode) const {
     if (fd < 0) {
         return tl::make_unexpected(ErrorCode::FILE_OPEN_FAIL);
     }
+#ifdef STORE_USE_URING
+    if (bucket_backend_config_.use_uring) {
+        int direct_fd = -1;
+        if (bucket_backend_config_.direct_io) {
+            // Opened after fd, which created and truncated the file
+            direct_fd = open(path.c_str(),
+                             flags | O_DIRECT |
+                                 (mode == FileMode::Read ? O_RDONLY : O_WRONLY));
+            if (direct_fd < 0) {
+                VLOG(1) << "path=" << path << ", errno=" << errno
+                        << ", info=direct_io_unsupported";
+            }
+        }
+        return std::make_unique<UringFile>(path, fd, direct_fd);
+    }
+#endif
     return std::make_unique<PosixFile>(path, fd);
 }
 
+void BucketStorageBackend::RegisterLoadBuffer(void* addr, size_t length) {
+#ifdef STORE_USE_URING
+    if (bucket_backend_config_.use_uring) {
+        UringFile::RegisterBuffer(addr, length);
+    }
+#else
+    (void)addr;
+    (void)length;
+#endif
+}
+
 tl::expected<void, ErrorCode> BucketStorageBackend::HandleNext(
     const std::function<
         ErrorCode(const std::vector<std::string>& keys,
@@ -2155,10 +2766,15 @@ tl::expected<int64_t, ErrorCode> OffsetAllocatorStorageBackend::BatchOffload(
             continue;  // Simulate allocation/write failure
         }
 
-        // Calculate total value size
+        // Calculate total value size, and the checksum while the slices are
+        // read anyway
         uint32_t value_size = 0;
+        uint32_t checksum = 0;
         for (const auto& slice : slices) {
             value_size += static_cast<uint32_t>(slice.size);
+            if (file_storage_config_.enable_checksum) {
+                checksum = Crc32c(checksum, slice.ptr, slice.size);
+            }
         }
 
         // Prepare record header
@@ -2250,7 +2866,7 @@ tl::expected<int64_t, ErrorCode> OffsetAllocatorStorageBackend::BatchOffload(
             // Update map (insert_or_assign handles both insert and overwrite)
             shard.map.insert_or_assign(
                 key, ObjectEntry(offset, record_size, value_size,
-                                 std::move(allocation_ptr)));
+                                 std::move(allocation_ptr), checksum));
 
             // Update total size atomically (lock-free, separate from map
             // updates)
@@ -2302,6 +2918,7 @@ tl::expected<void, ErrorCode> OffsetAllocatorStorageBackend::BatchLoad(
         std::string key;
         uint64_t offset;
         uint32_t value_size;
+        uint32_t checksum;
         AllocationPtr allocation;  // Refcounted handle keeps allocation alive
         Slice dest_slice;
     };
@@ -2334,7 +2951,7 @@ tl::expected<void, ErrorCode> OffsetAllocatorStorageBackend::BatchLoad(
         // Copy metadata and increment refcount on allocation
         // This keeps the physical extent alive even if key is evicted
         read_plans.push_back(
-            ReadPlan{key, entry.offset, entry.value_size,
+            ReadPlan{key, entry.offset, entry.value_size, entry.checksum,
                      entry.allocation,  // shared_ptr copy, increments refcount
                      dest_slice});
 
@@ -2407,6 +3024,18 @@ tl::expected<void, ErrorCode> OffsetAllocatorStorageBackend::BatchLoad(
                        << ", got: " << read_value_result.value();
             return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
         }
+
+        // Verified while the value just read is still in the cache
+        if (file_storage_config_.enable_checksum) {
+            uint32_t checksum =
+                Crc32c(0, plan.dest_slice.ptr, plan.dest_slice.size);
+            if (checksum != plan.checksum) {
+                LOG(ERROR) << "Checksum mismatch for key: " << plan.key
+                           << ", stored: " << plan.checksum
+                           << ", read: " << checksum;
+                return tl::make_unexpected(ErrorCode::FILE_CHECKSUM_MISMATCH);
+            }
+        }
     }
 
     // read_plans destructor releases all AllocationPtr references
@@ -2540,6 +3169,653 @@ tl::expected<void, ErrorCode> OffsetAllocatorStorageBackend::ScanMeta(
 
 //-----------------------------------------------------------------------------
 
+namespace {
+
+// Largest pwritev of an append, and read buffer of the compaction
+constexpr size_t kMaxAppendRunSize = 64 * kMB;
+constexpr size_t kCompactionChunkSize = 8 * kMB;
+
+}  // namespace
+
+LogStructuredStorageBackend::Segment::~Segment() {
+    if (!obsolete.load(std::memory_order_acquire)) {
+        return;
+    }
+    file.reset();
+    std::error_code ec;
+    if (!std::filesystem::remove(path, ec) && ec) {
+        LOG(WARNING) << "Failed to remove segment: " << path
+                     << ", error: " << ec.message();
+    }
+}
+
+LogStructuredStorageBackend::LogStructuredStorageBackend(
+    const FileStorageConfig& file_storage_config,
+    const LogStructuredConfig& log_config)
+    : StorageBackendInterface(file_storage_config),
+      storage_path_(file_storage_config.storage_filepath),
+      log_config_(log_config) {}
+
+LogStructuredStorageBackend::~LogStructuredStorageBackend() {
+    {
+        std::lock_guard lock(compaction_wait_mutex_);
+        compaction_running_.store(false);
+    }
+    compaction_cv_.notify_all();
+    if (compaction_thread_.joinable()) {
+        compaction_thread_.join();
+    }
+}
+
+std::string LogStructuredStorageBackend::GetSegmentPath(uint64_t id) const {
+    return (std::filesystem::path(storage_path_) /
+            ("kv_segment_" + std::to_string(id) + ".log"))
+        .string();
+}
+
+size_t LogStructuredStorageBackend::GetSegmentCount() const {
+    MutexLocker lock(&segments_mutex_);
+    return segments_.size();
+}
+
+//-----------------------------------------------------------------------------
+
+tl::expected<void, ErrorCode> LogStructuredStorageBackend::Init() {
+    namespace fs = std::filesystem;
+    if (initialized_.load(std::memory_order_acquire)) {
+        LOG(ERROR) << "Storage backend already initialized";
+        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
+    }
+    if (file_storage_config_.total_size_limit <= 0) {
+        LOG(ERROR) << "Invalid capacity for LogStructuredStorageBackend: "
+                   << file_storage_config_.total_size_limit
+                   << ". Capacity must be > 0";
+        return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+    }
+
+    try {
+        // V1: no persistence, the segments of a previous run are dropped
+        for (const auto& entry : fs::directory_iterator(storage_path_)) {
+            const auto name = entry.path().filename().string();
+            if (entry.is_regular_file() && name.starts_with("kv_segment_") &&
+                name.ends_with(".log")) {
+                fs::remove(entry.path());
+            }
+        }
+    } catch (const std::exception& e) {
+        LOG(ERROR) << "LogStructuredStorageBackend initialize error: "
+                   << e.what();
+        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
+    }
+
+    compaction_running_.store(true);
+    compaction_thread_ =
+        std::thread(&LogStructuredStorageBackend::CompactionThreadFunc, this);
+
+    initialized_.store(true, std::memory_order_release);
+    LOG(INFO) << "LogStructuredStorageBackend initialized, capacity: "
+              << file_storage_config_.total_size_limit
+              << " bytes, segment size: " << log_config_.segment_size_limit
+              << " bytes, path: " << storage_path_;
+    return {};
+}
+
+//-----------------------------------------------------------------------------
+
+tl::expected<LogStructuredStorageBackend::SegmentPtr, ErrorCode>
+LogStructuredStorageBackend::SegmentForAppend(size_t record_size,
+                                              bool for_compaction) {
+    if (active_segment_) {
+        const uint64_t size = active_segment_->size.load();
+        const auto limit =
+            static_cast<uint64_t>(log_config_.segment_size_limit);
+        if (size > 0 && size + record_size > limit) {
+            active_segment_.reset();  // Sealed, takes no more appends
+        }
+    }
+
+    if (!for_compaction &&
+        disk_size_.load(std::memory_order_relaxed) +
+                static_cast<int64_t>(record_size) >
+            file_storage_config_.total_size_limit) {
+        return tl::make_unexpected(ErrorCode::KEYS_ULTRA_LIMIT);
+    }
+
+    if (!active_segment_) {
+        const uint64_t id = next_segment_id_++;
+        std::string path = GetSegmentPath(id);
+        int fd = open(path.c_str(), O_CLOEXEC | O_RDWR | O_CREAT | O_TRUNC,
+                      0644);
+        if (fd < 0) {
+            LOG(ERROR) << "Failed to open segment: " << path
+                       << ", error: " << strerror(errno);
+            return tl::make_unexpected(ErrorCode::FILE_OPEN_FAIL);
+        }
+        auto segment = std::make_shared<Segment>();
+        segment->id = id;
+        segment->path = std::move(path);
+        segment->file = std::make_unique<PosixFile>(segment->path, fd);
+        {
+            MutexLocker lock(&segments_mutex_);
+            segments_.emplace(id, segment);
+        }
+        active_segment_ = std::move(segment);
+    }
+    return active_segment_;
+}
+
+void LogStructuredStorageBackend::AppendRecords(
+    std::vector<AppendRecord>& records, bool for_compaction) {
+    MutexLocker lock(&append_mutex_);
+    size_t begin = 0;
+    while (begin < records.size()) {
+        auto segment_result =
+            SegmentForAppend(records[begin].record_size, for_compaction);
+        if (!segment_result) {
+            LOG(ERROR) << "Failed to append " << records.size() - begin
+                       << " records, error: " << segment_result.error();
+            return;
+        }
+        SegmentPtr segment = std::move(segment_result.value());
+
+        // Gather the records that fit in the segment into one write
+        const uint64_t run_offset = segment->size.load();
+        std::vector<iovec> iovs;
+        size_t run_size = 0;
+        size_t end = begin;
+        while (end < records.size()) {
+            const auto& record = records[end];
+            if (end > begin &&
+                (run_offset + run_size + record.record_size >
+                     static_cast<uint64_t>(log_config_.segment_size_limit) ||
+                 run_size + record.record_size > kMaxAppendRunSize ||
+                 iovs.size() + record.iovs.size() > IOV_MAX ||
+                 (!for_compaction &&
+                  disk_size_.load(std::memory_order_relaxed) +
+                          static_cast<int64_t>(run_size + record.record_size) >
+                      file_storage_config_.total_size_limit))) {
+                break;
+            }
+            iovs.insert(iovs.end(), record.iovs.begin(), record.iovs.end());
+            run_size += record.record_size;
+            end++;
+        }
+
+        segment->size.store(run_offset + run_size);
+        disk_size_.fetch_add(run_size, std::memory_order_relaxed);
+
+        auto write_result =
+            segment->file->vector_write(iovs.data(), iovs.size(), run_offset);
+        if (!write_result || write_result.value() != run_size) {
+            // The run is left in the segment as dead bytes
+            LOG(ERROR) << "Failed to append " << end - begin
+                       << " records to segment: " << segment->path
+                       << ", offset: " << run_offset << ", size: " << run_size;
+            active_segment_.reset();
+        } else {
+            uint64_t offset = run_offset;
+            for (size_t i = begin; i < end; ++i) {
+                records[i].segment = segment;
+                records[i].offset = offset;
+                records[i].written = true;
+                offset += records[i].record_size;
+            }
+        }
+        begin = end;
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+tl::expected<int64_t, ErrorCode> LogStructuredStorageBackend::BatchOffload(
+    const std::unordered_map<std::string, std::vector<Slice>>& batch_object,
+    std::function<ErrorCode(const std::vector<std::string>& keys,
+                            std::vector<StorageObjectMetadata>& metadatas)>
+        complete_handler) {
+    static_assert(sizeof(RecordHeader) == RecordHeader::SIZE,
+                  "RecordHeader must not be padded");
+    if (!initialized_.load(std::memory_order_acquire)) {
+        LOG(ERROR)
+            << "Storage backend is not initialized. Call Init() before use.";
+        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
+    }
+    if (batch_object.empty()) {
+        LOG(ERROR) << "BatchOffload called with empty batch";
+        return tl::make_unexpected(ErrorCode::INVALID_KEY);
+    }
+
+    auto enable_offloading_res = IsEnableOffloading();
+    if (!enable_offloading_res) {
+        return tl::make_unexpected(enable_offloading_res.error());
+    }
+    if (!enable_offloading_res.value()) {
+        return tl::make_unexpected(ErrorCode::KEYS_ULTRA_LIMIT);
+    }
+
+    // Headers are referenced by the iovecs, so they must not move
+    std::vector<RecordHeader> headers;
+    std::vector<const std::string*> record_keys;
+    std::vector<AppendRecord> records;
+    headers.reserve(batch_object.size());
+    record_keys.reserve(batch_object.size());
+    records.reserve(batch_object.size());
+
+    for (const auto& [key, slices] : batch_object) {
+        if (slices.empty()) {
+            // Skip empty slices (empty values are allowed but not stored)
+            continue;
+        }
+
+        if (test_failure_predicate_ && test_failure_predicate_(key)) {
+            LOG(INFO) << "[TEST] Injecting failure for key: " << key
+                      << " (test failure predicate)";
+            continue;
+        }
+
+        uint64_t value_size = 0;
+        for (const auto& slice : slices) {
+            value_size += slice.size;
+        }
+        if (key.size() > UINT32_MAX || value_size > UINT32_MAX) {
+            LOG(ERROR) << "Record too large for key: " << key
+                       << ", value size: " << value_size;
+            continue;
+        }
+
+        headers.push_back(
+            RecordHeader{.key_len = static_cast<uint32_t>(key.size()),
+                         .value_len = static_cast<uint32_t>(value_size)});
+        AppendRecord record;
+        record.record_size = RecordHeader::SIZE + key.size() + value_size;
+        record.iovs.reserve(2 + slices.size());
+        record.iovs.push_back({&headers.back(), RecordHeader::SIZE});
+        record.iovs.push_back({const_cast<char*>(key.data()), key.size()});
+        for (const auto& slice : slices) {
+            record.iovs.push_back({slice.ptr, slice.size});
+        }
+        records.push_back(std::move(record));
+        record_keys.push_back(&key);
+    }
+
+    AppendRecords(records, /*for_compaction=*/false);
+
+    std::vector<std::string> keys;
+    std::vector<StorageObjectMetadata> metadatas;
+    keys.reserve(records.size());
+    metadatas.reserve(records.size());
+
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto& record = records[i];
+        if (!record.written) {
+            continue;
+        }
+        const std::string& key = *record_keys[i];
+        const uint32_t value_size = headers[i].value_len;
+        {
+            auto& shard = shards_[ShardForKey(key)];
+            SharedMutexLocker lock(&shard.mutex);
+
+            int64_t size_delta = static_cast<int64_t>(record.record_size);
+            ObjectEntry entry{record.segment, record.offset,
+                              static_cast<uint32_t>(record.record_size),
+                              value_size};
+            auto it = shard.map.find(key);
+            if (it != shard.map.end()) {
+                // Overwrite: the old record becomes dead bytes of its segment
+                size_delta -= static_cast<int64_t>(it->second.total_size);
+                it->second.segment->live_bytes.fetch_sub(
+                    it->second.total_size);
+                it->second = std::move(entry);
+            } else {
+                shard.map.emplace(key, std::move(entry));
+                total_keys_.fetch_add(1, std::memory_order_relaxed);
+            }
+            record.segment->live_bytes.fetch_add(record.record_size);
+            total_size_.fetch_add(size_delta, std::memory_order_relaxed);
+        }
+
+        keys.push_back(key);
+        metadatas.push_back(StorageObjectMetadata{
+            static_cast<int64_t>(record.segment->id),
+            static_cast<int64_t>(record.offset),
+            static_cast<int64_t>(key.size()), static_cast<int64_t>(value_size),
+            ""});
+    }
+
+    if (complete_handler != nullptr && !keys.empty()) {
+        auto error_code = complete_handler(keys, metadatas);
+        if (error_code != ErrorCode::OK) {
+            LOG(ERROR) << "Complete handler failed: " << error_code << " - "
+                       << keys.size()
+                       << " keys were successfully written to disk but master "
+                          "was not notified.";
+            return tl::make_unexpected(error_code);
+        }
+    }
+
+    return static_cast<int64_t>(keys.size());
+}
+
+//-----------------------------------------------------------------------------
+
+tl::expected<void, ErrorCode> LogStructuredStorageBackend::BatchLoad(
+    const std::unordered_map<std::string, Slice>& batched_slices) {
+    if (!initialized_.load(std::memory_order_acquire)) {
+        LOG(ERROR)
+            << "Storage backend is not initialized. Call Init() before use.";
+        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
+    }
+
+    // Copy the entries under the shard locks; the segment pointers keep the
+    // files open even if the segments are compacted during the reads
+    struct ReadPlan {
+        const std::string* key;
+        ObjectEntry entry;
+        Slice dest_slice;
+    };
+    std::vector<ReadPlan> read_plans;
+    read_plans.reserve(batched_slices.size());
+
+    for (const auto& [key, dest_slice] : batched_slices) {
+        auto& shard = shards_[ShardForKey(key)];
+        SharedMutexLocker lock(&shard.mutex, shared_lock);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            LOG(ERROR) << "Key not found: " << key;
+            return tl::make_unexpected(ErrorCode::OBJECT_NOT_FOUND);
+        }
+        if (dest_slice.size != it->second.value_size) {
+            LOG(ERROR) << "Size mismatch for key: " << key
+                       << ", expected: " << it->second.value_size
+                       << ", got: " << dest_slice.size;
+            return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+        }
+        read_plans.push_back(ReadPlan{&key, it->second, dest_slice});
+    }
+
+    // One read per record: header, key and value
+    for (const auto& plan : read_plans) {
+        const auto& entry = plan.entry;
+        const uint32_t key_len =
+            entry.total_size - RecordHeader::SIZE - entry.value_size;
+        RecordHeader header;
+        std::string stored_key(key_len, '\0');
+        iovec iovs[3] = {{&header, RecordHeader::SIZE},
+                         {stored_key.data(), key_len},
+                         {plan.dest_slice.ptr, plan.dest_slice.size}};
+        auto read_result = entry.segment->file->vector_read(iovs, 3,
+                                                            entry.offset);
+        if (!read_result) {
+            LOG(ERROR) << "Failed to read record for key: " << *plan.key
+                       << ", error: " << read_result.error();
+            return tl::make_unexpected(read_result.error());
+        }
+        if (read_result.value() != entry.total_size) {
+            LOG(ERROR) << "Record read size mismatch for key: " << *plan.key
+                       << ", expected: " << entry.total_size
+                       << ", got: " << read_result.value();
+            return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
+        }
+        if (header.key_len != key_len ||
+            header.value_len != entry.value_size || stored_key != *plan.key) {
+            LOG(ERROR) << "Stored record mismatch for key: " << *plan.key
+                       << ", segment: " << entry.segment->path
+                       << ", offset: " << entry.offset;
+            return tl::make_unexpected(ErrorCode::FILE_READ_FAIL);
+        }
+    }
+
+    return {};
+}
+
+//-----------------------------------------------------------------------------
+
+tl::expected<bool, ErrorCode> LogStructuredStorageBackend::IsExist(
+    const std::string& key) {
+    if (!initialized_.load(std::memory_order_acquire)) {
+        LOG(ERROR)
+            << "Storage backend is not initialized. Call Init() before use.";
+        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
+    }
+
+    auto& shard = shards_[ShardForKey(key)];
+    SharedMutexLocker lock(&shard.mutex, shared_lock);
+    return shard.map.find(key) != shard.map.end();
+}
+
+//-----------------------------------------------------------------------------
+
+tl::expected<bool, ErrorCode>
+LogStructuredStorageBackend::IsEnableOffloading() {
+    if (!initialized_.load(std::memory_order_acquire)) {
+        LOG(ERROR)
+            << "Storage backend is not initialized. Call Init() before use.";
+        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
+    }
+
+    // Dead bytes count against the disk until their segment is compacted
+    const int64_t limit = file_storage_config_.total_size_limit;
+    return total_size_.load(std::memory_order_relaxed) < limit &&
+           disk_size_.load(std::memory_order_relaxed) < limit &&
+           total_keys_.load(std::memory_order_relaxed) <
+               file_storage_config_.total_keys_limit;
+}
+
+//-----------------------------------------------------------------------------
+
+tl::expected<void, ErrorCode> LogStructuredStorageBackend::ScanMeta(
+    const std::function<
+        ErrorCode(const std::vector<std::string>& keys,
+                  std::vector<StorageObjectMetadata>& metadatas)>& handler) {
+    if (!initialized_.load(std::memory_order_acquire)) {
+        LOG(ERROR)
+            << "Storage backend is not initialized. Call Init() before use.";
+        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
+    }
+
+    std::vector<std::string> keys;
+    std::vector<StorageObjectMetadata> metadatas;
+    auto flush = [&]() -> tl::expected<void, ErrorCode> {
+        if (keys.empty()) return {};
+        auto error_code = handler(keys, metadatas);
+        if (error_code != ErrorCode::OK) {
+            LOG(ERROR) << "ScanMeta handler failed: " << error_code;
+            return tl::make_unexpected(error_code);
+        }
+        keys.clear();
+        metadatas.clear();
+        return {};
+    };
+
+    // One shard at a time: compaction only moves records, so a key seen in
+    // a shard stays valid
+    for (size_t i = 0; i < kNumShards; ++i) {
+        {
+            SharedMutexLocker lock(&shards_[i].mutex, shared_lock);
+            for (const auto& [key, entry] : shards_[i].map) {
+                keys.push_back(key);
+                metadatas.push_back(StorageObjectMetadata{
+                    static_cast<int64_t>(entry.segment->id),
+                    static_cast<int64_t>(entry.offset),
+                    static_cast<int64_t>(entry.total_size - RecordHeader::SIZE -
+                                         entry.value_size),
+                    static_cast<int64_t>(entry.value_size), ""});
+            }
+        }
+        if (static_cast<int64_t>(keys.size()) >=
+            file_storage_config_.scanmeta_iterator_keys_limit) {
+            auto flush_result = flush();
+            if (!flush_result) {
+                return flush_result;
+            }
+        }
+    }
+    return flush();
+}
+
+//-----------------------------------------------------------------------------
+
+tl::expected<size_t, ErrorCode> LogStructuredStorageBackend::Compact() {
+    if (!initialized_.load(std::memory_order_acquire)) {
+        LOG(ERROR)
+            << "Storage backend is not initialized. Call Init() before use.";
+        return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
+    }
+    MutexLocker compaction_lock(&compaction_mutex_);
+
+    // Sealed segments below the live ratio, the active one never is
+    std::vector<SegmentPtr> victims;
+    {
+        MutexLocker append_lock(&append_mutex_);
+        MutexLocker lock(&segments_mutex_);
+        for (const auto& [id, segment] : segments_) {
+            if (segment == active_segment_) {
+                continue;
+            }
+            const int64_t size = static_cast<int64_t>(segment->size.load());
+            const int64_t live = segment->live_bytes.load();
+            if (live == 0 ||
+                live * 100 < size * log_config_.compaction_live_percent) {
+                victims.push_back(segment);
+            }
+        }
+    }
+    if (victims.empty()) {
+        return 0;
+    }
+
+    // Collect the records the index still points to in one sweep
+    std::unordered_map<const Segment*, std::vector<LiveRecord>> live_records;
+    for (const auto& victim : victims) {
+        live_records[victim.get()];
+    }
+    for (auto& shard : shards_) {
+        SharedMutexLocker lock(&shard.mutex, shared_lock);
+        for (const auto& [key, entry] : shard.map) {
+            auto it = live_records.find(entry.segment.get());
+            if (it != live_records.end()) {
+                it->second.push_back(
+                    LiveRecord{key, entry.offset, entry.total_size});
+            }
+        }
+    }
+
+    size_t deleted = 0;
+    for (const auto& victim : victims) {
+        auto& records = live_records[victim.get()];
+        if (!MoveLiveRecords(victim, records)) {
+            continue;
+        }
+        if (victim->live_bytes.load() != 0) {
+            LOG(WARNING) << "Segment still has live records after compaction: "
+                         << victim->path;
+            continue;
+        }
+        {
+            MutexLocker lock(&segments_mutex_);
+            segments_.erase(victim->id);
+        }
+        disk_size_.fetch_sub(static_cast<int64_t>(victim->size.load()),
+                             std::memory_order_relaxed);
+        victim->obsolete.store(true, std::memory_order_release);
+        deleted++;
+    }
+    return deleted;
+}
+
+bool LogStructuredStorageBackend::MoveLiveRecords(
+    const SegmentPtr& segment, std::vector<LiveRecord>& records) {
+    // In file order, so that the segment is read sequentially
+    std::sort(records.begin(), records.end(),
+              [](const LiveRecord& a, const LiveRecord& b) {
+                  return a.offset < b.offset;
+              });
+
+    size_t begin = 0;
+    while (begin < records.size()) {
+        size_t end = begin;
+        size_t chunk_size = 0;
+        while (end < records.size() &&
+               (end == begin ||
+                chunk_size + records[end].total_size <= kCompactionChunkSize)) {
+            chunk_size += records[end].total_size;
+            end++;
+        }
+
+        std::vector<char> buffer(chunk_size);
+        std::vector<AppendRecord> appends;
+        appends.reserve(end - begin);
+        char* cursor = buffer.data();
+        for (size_t i = begin; i < end; ++i) {
+            const auto& record = records[i];
+            iovec iov = {cursor, record.total_size};
+            auto read_result = segment->file->vector_read(&iov, 1,
+                                                          record.offset);
+            if (!read_result || read_result.value() != record.total_size) {
+                LOG(ERROR) << "Failed to read record for compaction, key: "
+                           << record.key << ", segment: " << segment->path;
+                return false;
+            }
+            AppendRecord append;
+            append.iovs.push_back(iov);
+            append.record_size = record.total_size;
+            appends.push_back(std::move(append));
+            cursor += record.total_size;
+        }
+
+        AppendRecords(appends, /*for_compaction=*/true);
+
+        bool moved_all = true;
+        for (size_t i = begin; i < end; ++i) {
+            const auto& record = records[i];
+            const auto& append = appends[i - begin];
+            if (!append.written) {
+                moved_all = false;
+                continue;
+            }
+            auto& shard = shards_[ShardForKey(record.key)];
+            SharedMutexLocker lock(&shard.mutex);
+            auto it = shard.map.find(record.key);
+            if (it == shard.map.end() || it->second.segment != segment ||
+                it->second.offset != record.offset) {
+                continue;  // Overwritten meanwhile, the copy is dead
+            }
+            segment->live_bytes.fetch_sub(record.total_size);
+            append.segment->live_bytes.fetch_add(record.total_size);
+            it->second.segment = append.segment;
+            it->second.offset = append.offset;
+        }
+        if (!moved_all) {
+            return false;
+        }
+        begin = end;
+    }
+    return true;
+}
+
+void LogStructuredStorageBackend::CompactionThreadFunc() {
+    LOG(INFO) << "action=compaction_thread_started";
+    std::unique_lock lock(compaction_wait_mutex_);
+    while (compaction_running_.load()) {
+        compaction_cv_.wait_for(
+            lock, std::chrono::milliseconds(log_config_.compaction_interval_ms),
+            [this] { return !compaction_running_.load(); });
+        if (!compaction_running_.load()) {
+            break;
+        }
+        lock.unlock();
+        auto result = Compact();
+        if (result && result.value() > 0) {
+            VLOG(1) << "action=segments_compacted, count=" << result.value()
+                    << ", disk_size=" << GetDiskSize();
+        }
+        lock.lock();
+    }
+    LOG(INFO) << "action=compaction_thread_stopped";
+}
+
+//-----------------------------------------------------------------------------
+
 tl::expected<std::shared_ptr<StorageBackendInterface>, ErrorCode>
 CreateStorageBackend(const FileStorageConfig& config) {
     switch (config.storage_backend_type) {
@@ -2565,6 +3841,15 @@ CreateStorageBackend(const FileStorageConfig& config) {
         case StorageBackendType::kOffsetAllocator: {
             return std::make_shared<OffsetAllocatorStorageBackend>(config);
         }
+        case StorageBackendType::kLogStructured: {
+            auto log_config = LogStructuredConfig::FromEnvironment();
+            if (!log_config.Validate()) {
+                throw std::invalid_argument(
+                    "Invalid StorageBackend configuration");
+            }
+            return std::make_shared<LogStructuredStorageBackend>(config,
+                                                                 log_config);
+        }
         default: {
             LOG(FATAL) << "Unsupported backend type";
             return tl::make_unexpected(ErrorCode::INTERNAL_ERROR);
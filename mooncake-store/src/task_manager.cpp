@@ -13,7 +13,8 @@ std::optional<Task> ScopedTaskReadAccess::find_task_by_id(
 }
 
 tl::expected<UUID, ErrorCode> ScopedTaskWriteAccess::submit_task(
-    const UUID& client_id, TaskType type, const std::string& payload) {
+    const UUID& client_id, TaskType type, const std::string& payload,
+    TaskPriority priority, uint64_t size) {
     if (manager_->total_pending_tasks_ >= manager_->max_total_pending_tasks_) {
         LOG(ERROR) << "Cannot submit new task: pending task limit reached ("
                    << manager_->total_pending_tasks_ << "/"
@@ -33,10 +34,13 @@ tl::expected<UUID, ErrorCode> ScopedTaskWriteAccess::submit_task(
                  .last_updated_at = now,
                  .message = "",
                  .assigned_client = client_id,
-                 .max_retry_attempts = manager_->max_retry_attempts_};
+                 .max_retry_attempts = manager_->max_retry_attempts_,
+                 .priority = priority,
+                 .size = size};
     manager_->total_pending_tasks_++;
     manager_->all_tasks_[task.id] = task;
-    manager_->pending_tasks_[client_id].push(task.id);
+    manager_->pending_tasks_[client_id][static_cast<size_t>(priority)].push(
+        task.id);
 
     return task.id;
 }
@@ -50,47 +54,83 @@ std::vector<Task> ScopedTaskWriteAccess::pop_tasks(const UUID& client_id,
         return result;
     }
 
-    auto& queue = pit->second;
     auto& processing_set = manager_->processing_tasks_[client_id];
+    uint64_t processing_bytes = 0;
+    auto bit = manager_->processing_bytes_.find(client_id);
+    if (bit != manager_->processing_bytes_.end()) {
+        processing_bytes = bit->second;
+    }
+    const uint64_t max_bytes = manager_->max_task_bytes_per_client_;
 
-    while (!queue.empty() && result.size() < batch_size) {
-        if (manager_->total_processing_tasks_ >=
-            manager_->max_total_processing_tasks_) {
-            break;
-        }
+    for (auto& queue : pit->second) {
+        while (!queue.empty() && result.size() < batch_size) {
+            if (manager_->total_processing_tasks_ >=
+                manager_->max_total_processing_tasks_) {
+                break;
+            }
 
-        const UUID task_id = queue.front();
-        queue.pop();
+            const UUID task_id = queue.front();
+            auto it = manager_->all_tasks_.find(task_id);
+            if (it == manager_->all_tasks_.end()) {
+                LOG(ERROR) << "Task " << task_id
+                           << " not found in all_tasks_ while popping";
+                queue.pop();
+                if (manager_->total_pending_tasks_ > 0) {
+                    manager_->total_pending_tasks_--;
+                }
+                continue;
+            }
 
-        if (manager_->total_pending_tasks_ > 0) {
-            manager_->total_pending_tasks_--;
-        }
+            Task& task = it->second;
+            // Lower priorities wait too, they must not take the bytes that
+            // free up for this task
+            if (max_bytes > 0 && processing_bytes > 0 &&
+                processing_bytes + task.size > max_bytes) {
+                break;
+            }
 
-        auto it = manager_->all_tasks_.find(task_id);
-        if (it == manager_->all_tasks_.end()) {
-            LOG(ERROR) << "Task " << task_id
-                       << " not found in all_tasks_ while popping";
-            continue;
-        }
+            queue.pop();
+            if (manager_->total_pending_tasks_ > 0) {
+                manager_->total_pending_tasks_--;
+            }
 
-        Task& task = it->second;
-        task.mark_processing();
+            task.mark_processing();
 
-        const auto [_, inserted] = processing_set.insert(task_id);
-        if (!inserted) {
-            LOG(WARNING) << "Task " << task_id
-                         << " is already in processing set for client "
-                         << client_id;
-        } else {
-            manager_->total_processing_tasks_++;
-        }
+            const auto [_, inserted] = processing_set.insert(task_id);
+            if (!inserted) {
+                LOG(WARNING) << "Task " << task_id
+                             << " is already in processing set for client "
+                             << client_id;
+            } else {
+                manager_->total_processing_tasks_++;
+                processing_bytes += task.size;
+            }
 
-        result.push_back(task);
+            result.push_back(task);
+        }
+        if (!queue.empty()) {
+            break;
+        }
     }
 
+    if (processing_bytes > 0) {
+        manager_->processing_bytes_[client_id] = processing_bytes;
+    }
     return result;
 }
 
+void ScopedTaskWriteAccess::release_processing_bytes(const Task& task) {
+    auto it = manager_->processing_bytes_.find(task.assigned_client);
+    if (it == manager_->processing_bytes_.end()) {
+        return;
+    }
+    if (it->second > task.size) {
+        it->second -= task.size;
+    } else {
+        manager_->processing_bytes_.erase(it);
+    }
+}
+
 ErrorCode ScopedTaskWriteAccess::complete_task(const UUID& client_id,
                                                const UUID& task_id,
                                                TaskStatus status,
@@ -127,8 +167,11 @@ ErrorCode ScopedTaskWriteAccess::complete_task(const UUID& client_id,
     if (ps_it != manager_->processing_tasks_.end()) {
         auto& processing_set = ps_it->second;
         const size_t erased = processing_set.erase(task_id);
-        if (erased == 1 && manager_->total_processing_tasks_ > 0) {
-            manager_->total_processing_tasks_--;
+        if (erased == 1) {
+            release_processing_bytes(task);
+            if (manager_->total_processing_tasks_ > 0) {
+                manager_->total_processing_tasks_--;
+            }
         }
     }
 
@@ -137,6 +180,22 @@ ErrorCode ScopedTaskWriteAccess::complete_task(const UUID& client_id,
     return ErrorCode::OK;
 }
 
+ErrorCode ScopedTaskWriteAccess::update_task_message(
+    const UUID& task_id, const std::string& message) {
+    auto it = manager_->all_tasks_.find(task_id);
+    if (it == manager_->all_tasks_.end()) {
+        LOG(ERROR) << "Task " << task_id << " not found for update";
+        return ErrorCode::TASK_NOT_FOUND;
+    }
+    Task& task = it->second;
+    if (task.is_finished()) {
+        return ErrorCode::OK;
+    }
+    task.message = message;
+    task.last_updated_at = std::chrono::system_clock::now();
+    return ErrorCode::OK;
+}
+
 void ScopedTaskWriteAccess::prune_finished_tasks() {
     while (manager_->finished_task_history_.size() >
            manager_->max_total_finished_tasks_) {
@@ -153,41 +212,44 @@ void ScopedTaskWriteAccess::prune_expired_tasks() {
         const auto pending_timeout_duration =
             std::chrono::seconds(manager_->pending_task_timeout_sec_);
 
-        for (auto& [client_id, task_queue] : manager_->pending_tasks_) {
-            std::queue<UUID> keep_queue;
-            while (!task_queue.empty()) {
-                const UUID task_id = task_queue.front();
-                task_queue.pop();
-
-                auto it = manager_->all_tasks_.find(task_id);
-                if (it == manager_->all_tasks_.end()) {
-                    // Drop dangling id;
-                    if (manager_->total_pending_tasks_ > 0) {
-                        manager_->total_pending_tasks_--;
+        for (auto& [client_id, task_queues] : manager_->pending_tasks_) {
+            for (auto& task_queue : task_queues) {
+                std::queue<UUID> keep_queue;
+                while (!task_queue.empty()) {
+                    const UUID task_id = task_queue.front();
+                    task_queue.pop();
+
+                    auto it = manager_->all_tasks_.find(task_id);
+                    if (it == manager_->all_tasks_.end()) {
+                        // Drop dangling id;
+                        if (manager_->total_pending_tasks_ > 0) {
+                            manager_->total_pending_tasks_--;
+                        }
+                        continue;
                     }
-                    continue;
-                }
 
-                Task& task = it->second;
+                    Task& task = it->second;
 
-                // If this task is no longer pending don't keep it in pending
-                // queue.
-                if (task.status != TaskStatus::PENDING) {
-                    continue;
-                }
+                    // If this task is no longer pending don't keep it in
+                    // pending queue.
+                    if (task.status != TaskStatus::PENDING) {
+                        continue;
+                    }
 
-                if (now - task.created_at > pending_timeout_duration) {
-                    task.mark_complete(TaskStatus::FAILED, "pending timeout");
-                    if (manager_->total_pending_tasks_ > 0) {
-                        manager_->total_pending_tasks_--;
+                    if (now - task.created_at > pending_timeout_duration) {
+                        task.mark_complete(TaskStatus::FAILED,
+                                           "pending timeout");
+                        if (manager_->total_pending_tasks_ > 0) {
+                            manager_->total_pending_tasks_--;
+                        }
+                        manager_->finished_task_history_.push_back(task_id);
+                        continue;
                     }
-                    manager_->finished_task_history_.push_back(task_id);
-                    continue;
-                }
 
-                keep_queue.push(task_id);
+                    keep_queue.push(task_id);
+                }
+                task_queue = std::move(keep_queue);
             }
-            task_queue = std::move(keep_queue);
         }
     }
 
@@ -215,6 +277,7 @@ void ScopedTaskWriteAccess::prune_expired_tasks() {
                 // set.
                 if (task.status != TaskStatus::PROCESSING) {
                     to_remove.push_back(task_id);
+                    release_processing_bytes(task);
                     if (manager_->total_processing_tasks_ > 0) {
                         manager_->total_processing_tasks_--;
                     }
@@ -225,6 +288,7 @@ void ScopedTaskWriteAccess::prune_expired_tasks() {
                     task.mark_complete(TaskStatus::FAILED,
                                        "processing timeout");
                     to_remove.push_back(task_id);
+                    release_processing_bytes(task);
                     if (manager_->total_processing_tasks_ > 0) {
                         manager_->total_processing_tasks_--;
                     }
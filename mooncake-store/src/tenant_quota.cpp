@@ -0,0 +1,138 @@
+#include "tenant_quota.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <charconv>
+
+#include "master_metric_manager.h"
+
+namespace mooncake {
+
+namespace {
+
+template <typename T>
+bool ParseNumber(const std::string& text, T& value) {
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+}  // namespace
+
+TenantUsage::TenantUsage(std::string name, TenantLimit limit)
+    : name_(std::move(name)),
+      limit_(limit),
+      tokens_(limit.put_starts_per_sec) {}
+
+uint64_t TenantUsage::used_bytes() const {
+    std::lock_guard lock(mutex_);
+    return used_bytes_;
+}
+
+ErrorCode TenantUsage::TryCharge(uint64_t bytes,
+                                 std::chrono::steady_clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    if (limit_.put_starts_per_sec > 0) {
+        // Bursts of up to one second worth of PutStarts are allowed
+        if (last_refill_ != std::chrono::steady_clock::time_point{}) {
+            const double elapsed_sec =
+                std::chrono::duration<double>(now - last_refill_).count();
+            tokens_ = std::min<double>(
+                limit_.put_starts_per_sec,
+                tokens_ + elapsed_sec * limit_.put_starts_per_sec);
+        }
+        last_refill_ = now;
+        if (tokens_ < 1.0) {
+            MasterMetricManager::instance().inc_tenant_rate_limited(name_);
+            return ErrorCode::TENANT_RATE_LIMITED;
+        }
+    }
+    if (limit_.quota_bytes > 0 && used_bytes_ + bytes > limit_.quota_bytes) {
+        MasterMetricManager::instance().inc_tenant_quota_exceeded(name_);
+        return ErrorCode::TENANT_QUOTA_EXCEEDED;
+    }
+    if (limit_.put_starts_per_sec > 0) {
+        tokens_ -= 1.0;
+    }
+    used_bytes_ += bytes;
+    MasterMetricManager::instance().inc_tenant_used_bytes(name_, bytes);
+    return ErrorCode::OK;
+}
+
+void TenantUsage::Release(uint64_t bytes) {
+    std::lock_guard lock(mutex_);
+    bytes = std::min(bytes, used_bytes_);
+    used_bytes_ -= bytes;
+    MasterMetricManager::instance().dec_tenant_used_bytes(name_, bytes);
+}
+
+void TenantUsage::RecordEviction(uint64_t bytes) {
+    MasterMetricManager::instance().inc_tenant_evicted_bytes(name_, bytes);
+}
+
+TenantQuotaManager::TenantQuotaManager(
+    std::unordered_map<std::string, TenantLimit> limits)
+    : limits_(std::move(limits)) {}
+
+tl::expected<std::unordered_map<std::string, TenantLimit>, ErrorCode>
+TenantQuotaManager::ParseLimits(const std::string& spec) {
+    std::unordered_map<std::string, TenantLimit> limits;
+    size_t begin = 0;
+    while (begin <= spec.size()) {
+        size_t end = spec.find(',', begin);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        const std::string entry = spec.substr(begin, end - begin);
+        begin = end + 1;
+        if (entry.empty()) {
+            continue;
+        }
+
+        const size_t equal = entry.find('=');
+        const size_t colon = entry.find(':', equal);
+        TenantLimit limit;
+        bool valid = equal != std::string::npos && equal > 0;
+        if (valid) {
+            const size_t quota_end =
+                colon == std::string::npos ? entry.size() : colon;
+            valid = ParseNumber(
+                entry.substr(equal + 1, quota_end - equal - 1),
+                limit.quota_bytes);
+        }
+        if (valid && colon != std::string::npos) {
+            valid = ParseNumber(entry.substr(colon + 1),
+                                limit.put_starts_per_sec);
+        }
+        if (!valid ||
+            !limits.emplace(entry.substr(0, equal), limit).second) {
+            LOG(ERROR) << "tenant_quota=" << entry
+                       << ", error=invalid_tenant_quota";
+            return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+        }
+    }
+    return limits;
+}
+
+std::shared_ptr<TenantUsage> TenantQuotaManager::GetUsage(
+    const std::string& tenant) {
+    std::lock_guard lock(mutex_);
+    auto it = usages_.find(tenant);
+    if (it != usages_.end()) {
+        return it->second;
+    }
+    TenantLimit limit;
+    auto limit_it = limits_.find(tenant);
+    if (limit_it == limits_.end()) {
+        limit_it = limits_.find(kDefaultTenant);
+    }
+    if (limit_it != limits_.end()) {
+        limit = limit_it->second;
+    }
+    auto usage = std::make_shared<TenantUsage>(tenant, limit);
+    usages_.emplace(tenant, usage);
+    return usage;
+}
+
+}  // namespace mooncake
@@ -0,0 +1,102 @@
+#include "timing_wheel.h"
+
+#include <algorithm>
+
+namespace mooncake {
+
+TimingWheel::TimingWheel(std::chrono::milliseconds tick,
+                         Clock::time_point start)
+    : tick_(std::max(tick, std::chrono::milliseconds(1))), start_(start) {}
+
+uint64_t TimingWheel::ToTick(Clock::time_point deadline) const {
+    if (deadline <= start_) {
+        return 0;
+    }
+    const uint64_t tick_ns = std::chrono::nanoseconds(tick_).count();
+    const uint64_t elapsed_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - start_)
+            .count();
+    return (elapsed_ns + tick_ns - 1) / tick_ns;
+}
+
+void TimingWheel::Place(TickEntry&& entry) {
+    if (entry.tick <= current_tick_) {
+        due_.push_back(std::move(entry.entry));
+        return;
+    }
+    const uint64_t delta = entry.tick - current_tick_;
+    for (size_t level = 0; level < kLevels; ++level) {
+        if (delta >> (kSlotBits * (level + 1)) == 0) {
+            const size_t slot =
+                (entry.tick >> (kSlotBits * level)) & (kSlots - 1);
+            levels_[level][slot].push_back(std::move(entry));
+            return;
+        }
+    }
+    // Past the top level, placed again when its slot is reached
+    const uint64_t last_tick =
+        current_tick_ + (uint64_t{1} << (kSlotBits * kLevels)) - 1;
+    const size_t slot =
+        (last_tick >> (kSlotBits * (kLevels - 1))) & (kSlots - 1);
+    levels_[kLevels - 1][slot].push_back(std::move(entry));
+}
+
+void TimingWheel::Schedule(std::string key, Clock::time_point deadline) {
+    std::lock_guard lock(mutex_);
+    const uint64_t tick = ToTick(deadline);
+    Place(TickEntry{Entry{std::move(key), deadline}, tick});
+    size_++;
+}
+
+std::vector<TimingWheel::Entry> TimingWheel::Advance(Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    const uint64_t tick_ns = std::chrono::nanoseconds(tick_).count();
+    const uint64_t target =
+        now <= start_
+            ? 0
+            : std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_)
+                      .count() /
+                  tick_ns;
+    if (size_ == 0) {
+        current_tick_ = std::max(current_tick_, target);
+        return {};
+    }
+    while (current_tick_ < target) {
+        current_tick_++;
+        // Move the higher level slots reached down first, their entries may
+        // land in the level 0 slot of this tick
+        for (size_t level = kLevels - 1; level > 0; --level) {
+            const size_t shift = kSlotBits * level;
+            if ((current_tick_ & ((uint64_t{1} << shift) - 1)) != 0) {
+                continue;
+            }
+            const size_t index = (current_tick_ >> shift) & (kSlots - 1);
+            auto& upper = levels_[level][index];
+            auto entries = std::move(upper);
+            upper.clear();
+            for (auto& entry : entries) {
+                Place(std::move(entry));
+            }
+        }
+        auto& slot = levels_[0][current_tick_ & (kSlots - 1)];
+        for (auto& entry : slot) {
+            due_.push_back(std::move(entry.entry));
+        }
+        slot.clear();
+        if (due_.size() == size_) {
+            // Nothing left to wait for
+            current_tick_ = target;
+        }
+    }
+    std::vector<Entry> expired = std::move(due_);
+    due_.clear();
+    size_ -= expired.size();
+    return expired;
+}
+
+size_t TimingWheel::size() const {
+    std::lock_guard lock(mutex_);
+    return size_;
+}
+
+}  // namespace mooncake
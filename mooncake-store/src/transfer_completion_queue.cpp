@@ -0,0 +1,91 @@
+#include "transfer_completion_queue.h"
+
+#include <glog/logging.h>
+
+namespace mooncake {
+
+TransferCompletionQueue::TransferCompletionQueue()
+    : thread_(&TransferCompletionQueue::ThreadFunc, this) {}
+
+TransferCompletionQueue::~TransferCompletionQueue() {
+    {
+        std::lock_guard lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+void TransferCompletionQueue::Add(std::vector<TransferFuture> futures,
+                                  Callback callback) {
+    {
+        std::lock_guard lock(mutex_);
+        incoming_.push_back({std::move(futures), std::move(callback)});
+        pending_++;
+    }
+    cv_.notify_one();
+}
+
+size_t TransferCompletionQueue::pending() const {
+    std::lock_guard lock(mutex_);
+    return pending_;
+}
+
+bool TransferCompletionQueue::TryComplete(Entry& entry, bool wait) {
+    ErrorCode result = ErrorCode::OK;
+    for (auto& future : entry.futures) {
+        if (!wait && !future.isReady()) {
+            return false;
+        }
+    }
+    for (auto& future : entry.futures) {
+        ErrorCode error = future.get();
+        if (result == ErrorCode::OK) {
+            result = error;
+        }
+    }
+    entry.callback(result);
+    return true;
+}
+
+void TransferCompletionQueue::ThreadFunc() {
+    std::vector<Entry> entries;
+    bool running = true;
+    while (running || !entries.empty()) {
+        {
+            std::unique_lock lock(mutex_);
+            if (entries.empty()) {
+                cv_.wait(lock,
+                         [this] { return !incoming_.empty() || !running_; });
+            } else {
+                cv_.wait_for(lock, kPollInterval, [this] {
+                    return !incoming_.empty() || !running_;
+                });
+            }
+            for (auto& entry : incoming_) {
+                entries.push_back(std::move(entry));
+            }
+            incoming_.clear();
+            running = running_;
+        }
+
+        // After shutdown the remaining transfers are waited for
+        size_t completed = 0;
+        for (size_t i = 0; i < entries.size();) {
+            if (TryComplete(entries[i], !running)) {
+                entries[i] = std::move(entries.back());
+                entries.pop_back();
+                completed++;
+            } else {
+                i++;
+            }
+        }
+        if (completed > 0) {
+            std::lock_guard lock(mutex_);
+            pending_ -= completed;
+        }
+    }
+    VLOG(1) << "action=transfer_completion_queue_stopped";
+}
+
+}  // namespace mooncake
@@ -1,11 +1,20 @@
 #include "transfer_task.h"
 
 #include <glog/logging.h>
+#include <numa.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <tuple>
+#include <unordered_map>
+
+#include "erasure_code.h"
+#include "request_trace.h"
 #include "transfer_engine.h"
 #include "transport/transport.h"
+#include "utils.h"
 
 namespace mooncake {
 
@@ -13,17 +22,19 @@ namespace mooncake {
 // FilereadWorkerPool Implementation
 // ============================================================================
 // to fully utilize the available ssd bandwidth, we use a default of 10 worker
-// threads.
+// threads. Loads of different files run in parallel on the workers, more of
+// them help on distributed filesystems such as 3FS.
 constexpr int kDefaultFilereadWorkers = 10;
 
 FilereadWorkerPool::FilereadWorkerPool(std::shared_ptr<StorageBackend>& backend)
     : shutdown_(false) {
-    VLOG(1) << "Creating FilereadWorkerPool with " << kDefaultFilereadWorkers
-            << " workers";
+    const int num_workers = std::max(
+        1, GetEnvOr<int>("MC_STORE_FILEREAD_THREADS", kDefaultFilereadWorkers));
+    VLOG(1) << "Creating FilereadWorkerPool with " << num_workers << " workers";
 
     // Start worker threads
-    workers_.reserve(kDefaultFilereadWorkers);
-    for (int i = 0; i < kDefaultFilereadWorkers; ++i) {
+    workers_.reserve(num_workers);
+    for (int i = 0; i < num_workers; ++i) {
         workers_.emplace_back(&FilereadWorkerPool::workerThread, this);
     }
     backend_ = backend;
@@ -119,27 +130,39 @@ void FilereadWorkerPool::workerThread() {
 // ============================================================================
 // MemcpyWorkerPool Implementation
 // ============================================================================
-// Since memcpy is bound by memory bandwidth, we only need one worker thread.
-constexpr int kDefaultMemcpyWorkers = 1;
-
-MemcpyWorkerPool::MemcpyWorkerPool() : shutdown_(false) {
-    VLOG(1) << "Creating MemcpyWorkerPool with " << kDefaultMemcpyWorkers
-            << " workers";
-
-    // Start worker threads
-    workers_.reserve(kDefaultMemcpyWorkers);
-    for (int i = 0; i < kDefaultMemcpyWorkers; ++i) {
-        workers_.emplace_back(&MemcpyWorkerPool::workerThread, this);
+MemcpyWorkerPool::MemcpyWorkerPool(size_t threads_per_node,
+                                   std::unique_ptr<CopyEngine> copy_engine)
+    : threads_per_node_(std::max<size_t>(threads_per_node, 1)),
+      copy_engine_(copy_engine ? std::move(copy_engine)
+                               : std::make_unique<CpuCopyEngine>()),
+      shutdown_(false) {
+    const int nodes = numa_available() < 0 ? 1 : numa_num_configured_nodes();
+    const size_t num_nodes = std::max(nodes, 1);
+    VLOG(1) << "Creating MemcpyWorkerPool with " << threads_per_node_
+            << " workers on each of " << num_nodes << " NUMA nodes, "
+            << copy_engine_->name() << " copy engine";
+
+    queues_.reserve(num_nodes);
+    for (size_t node = 0; node < num_nodes; ++node) {
+        queues_.emplace_back(std::make_unique<NodeQueue>());
+    }
+    workers_.reserve(num_nodes * threads_per_node_);
+    for (size_t node = 0; node < num_nodes; ++node) {
+        for (size_t i = 0; i < threads_per_node_; ++i) {
+            workers_.emplace_back(&MemcpyWorkerPool::workerThread, this, node);
+        }
     }
 }
 
 MemcpyWorkerPool::~MemcpyWorkerPool() {
     // Signal shutdown
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
+    for (auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
         shutdown_.store(true);
     }
-    queue_cv_.notify_all();
+    for (auto& queue : queues_) {
+        queue->cv.notify_all();
+    }
 
     // Wait for all workers to finish
     for (auto& worker : workers_) {
@@ -151,56 +174,111 @@ MemcpyWorkerPool::~MemcpyWorkerPool() {
     VLOG(1) << "MemcpyWorkerPool destroyed";
 }
 
+size_t MemcpyWorkerPool::nodeOf(void* dest) const {
+    if (queues_.size() == 1) {
+        return 0;
+    }
+    void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(dest) &
+                                         ~(uintptr_t(getpagesize()) - 1));
+    int status = -1;
+    if (numa_move_pages(0, 1, &page, nullptr, &status, 0) != 0 ||
+        status < 0 || static_cast<size_t>(status) >= queues_.size()) {
+        // Not faulted in yet, the first worker to write it places it
+        return 0;
+    }
+    return status;
+}
+
 void MemcpyWorkerPool::submitTask(MemcpyTask task) {
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        if (shutdown_.load()) {
-            LOG(WARNING)
-                << "Attempting to submit task to shutdown MemcpyWorkerPool";
-            task.state->set_completed(ErrorCode::TRANSFER_FAIL);
-            return;
+    if (shutdown_.load()) {
+        LOG(WARNING)
+            << "Attempting to submit task to shutdown MemcpyWorkerPool";
+        task.state->set_completed(ErrorCode::TRANSFER_FAIL);
+        return;
+    }
+
+    // Small copies stay in one job on the node of the first destination,
+    // large ones are split among the workers of the node of theirs
+    std::vector<std::pair<size_t, Job>> jobs;
+    std::vector<MemcpyOperation> small;
+    for (const auto& op : task.operations) {
+        const size_t chunks = std::min(threads_per_node_,
+                                       op.size / kMinSplitChunkSize);
+        if (chunks < 2) {
+            small.push_back(op);
+            continue;
+        }
+        const size_t node = nodeOf(op.dest);
+        const size_t chunk_size = (op.size + chunks - 1) / chunks;
+        for (size_t offset = 0; offset < op.size; offset += chunk_size) {
+            Job job;
+            job.operations.emplace_back(
+                static_cast<char*>(op.dest) + offset,
+                static_cast<const char*>(op.src) + offset,
+                std::min(chunk_size, op.size - offset));
+            jobs.emplace_back(node, std::move(job));
         }
-        task_queue_.push(std::move(task));
     }
-    queue_cv_.notify_one();
+    if (!small.empty() || jobs.empty()) {
+        const size_t node = small.empty() ? 0 : nodeOf(small.front().dest);
+        Job job;
+        job.operations = std::move(small);
+        jobs.emplace_back(node, std::move(job));
+    }
+
+    auto progress = std::make_shared<Progress>();
+    progress->remaining = jobs.size();
+    for (auto& [node, job] : jobs) {
+        job.state = task.state;
+        job.progress = progress;
+        auto& queue = *queues_[node];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push(std::move(job));
+        }
+        queue.cv.notify_one();
+    }
 }
 
-void MemcpyWorkerPool::workerThread() {
+void MemcpyWorkerPool::workerThread(size_t node) {
     VLOG(2) << "MemcpyWorkerPool worker thread started";
+    if (queues_.size() > 1) {
+        bindToSocket(static_cast<int>(node));
+    }
 
+    auto& queue = *queues_[node];
     while (true) {
-        MemcpyTask task({}, nullptr);
+        Job job;
 
         // Wait for task or shutdown signal
         {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cv_.wait(lock, [this] {
-                return shutdown_.load() || !task_queue_.empty();
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.cv.wait(lock, [this, &queue] {
+                return shutdown_.load() || !queue.jobs.empty();
             });
 
-            if (shutdown_.load() && task_queue_.empty()) {
+            if (shutdown_.load() && queue.jobs.empty()) {
                 break;
             }
 
-            if (!task_queue_.empty()) {
-                task = std::move(task_queue_.front());
-                task_queue_.pop();
-            }
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop();
         }
 
-        // Execute the task if we have one
-        if (task.state) {
-            try {
-                for (const auto& op : task.operations) {
-                    std::memcpy(op.dest, op.src, op.size);
-                }
-
-                VLOG(2) << "Memcpy task completed successfully with "
-                        << task.operations.size() << " operations";
-                task.state->set_completed(ErrorCode::OK);
-            } catch (const std::exception& e) {
-                LOG(ERROR) << "Exception during async memcpy: " << e.what();
-                task.state->set_completed(ErrorCode::TRANSFER_FAIL);
+        for (const auto& op : job.operations) {
+            if (copy_engine_->Copy(op.dest, op.src, op.size) !=
+                ErrorCode::OK) {
+                job.progress->failed = true;
+                break;
+            }
+        }
+        if (job.progress->remaining.fetch_sub(1) == 1) {
+            if (job.progress->failed) {
+                LOG(ERROR) << "Memcpy task failed";
+                job.state->set_completed(ErrorCode::TRANSFER_FAIL);
+            } else {
+                VLOG(2) << "Memcpy task completed successfully";
+                job.state->set_completed(ErrorCode::OK);
             }
         }
     }
@@ -287,6 +365,9 @@ void TransferEngineOperationState::set_result_internal(ErrorCode error_code) {
     VLOG(1) << "Setting transfer result for batch " << batch_id_ << " to "
             << static_cast<int>(error_code);
     result_.emplace(error_code);
+    if (window_lease_) {
+        window_lease_->Finish(error_code == ErrorCode::OK);
+    }
 }
 
 void TransferEngineOperationState::wait_for_completion() {
@@ -296,79 +377,30 @@ void TransferEngineOperationState::wait_for_completion() {
 
     constexpr int64_t timeout_seconds = 60;
 
-#ifdef USE_EVENT_DRIVEN_COMPLETION
     VLOG(1) << "Waiting for transfer engine completion for batch " << batch_id_;
 
-    // Wait directly on BatchDesc's condition variable.
-    auto& batch_desc = Transport::toBatchDesc(batch_id_);
-    bool completed;
-    bool failed = false;
-
-    // Fast path: if already finished, avoid taking the mutex and waiting.
-    // Use acquire here to pair with the writer's release-store, because this
-    // path may skip taking the mutex. It ensures all prior updates are visible.
-    completed = batch_desc.is_finished.load(std::memory_order_acquire);
-    if (!completed) {
-        // Use the same mutex as the notifier when updating the predicate to
-        // avoid missed notifications. The predicate is re-checked under the
-        // lock. Under the mutex, relaxed is sufficient; the mutex acquire
-        // orders prior writes.
-        std::unique_lock<std::mutex> lock(batch_desc.completion_mutex);
-        completed = batch_desc.completion_cv.wait_for(
-            lock, std::chrono::seconds(timeout_seconds), [&batch_desc] {
-                return batch_desc.is_finished.load(std::memory_order_relaxed);
-            });
-    }  // Explicitly release completion_mutex before acquiring mutex_
-
-    // Once completion is observed, read failure flag.
-    if (completed) {
-        failed = batch_desc.has_failure.load(std::memory_order_relaxed);
-    }
+    size_t index;
+    Status s =
+        engine_.waitAnyBatch({batch_id_}, index, timeout_seconds * 1000);
 
-    ErrorCode error_code =
-        completed ? (failed ? ErrorCode::TRANSFER_FAIL : ErrorCode::OK)
-                  : ErrorCode::TRANSFER_FAIL;
-
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        set_result_internal(error_code);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (result_.has_value()) {
+        return;
     }
-
-    if (completed) {
-        VLOG(1) << "Transfer engine operation completed for batch " << batch_id_
-                << " with result: " << static_cast<int>(error_code);
-    } else {
+    if (!s.ok() || index != 0) {
         LOG(ERROR) << "Failed to complete transfers after " << timeout_seconds
                    << " seconds for batch " << batch_id_;
+        set_result_internal(ErrorCode::TRANSFER_FAIL);
+        return;
     }
-#else
-    VLOG(1) << "Starting transfer engine polling for batch " << batch_id_;
 
-    constexpr int64_t kOneSecondInNano = 1000 * 1000 * 1000;
-    const int64_t start_ts = getCurrentTimeInNano();
-
-    while (true) {
-        if (getCurrentTimeInNano() - start_ts >
-            timeout_seconds * kOneSecondInNano) {
-            LOG(ERROR) << "Failed to complete transfers after "
-                       << timeout_seconds << " seconds for batch " << batch_id_;
-            set_result_internal(ErrorCode::TRANSFER_FAIL);
-            return;
-        }
-
-        std::unique_lock<std::mutex> lock(mutex_);
-        check_task_status();
-        if (result_.has_value()) {
-            VLOG(1) << "Transfer engine operation completed for batch "
-                    << batch_id_
-                    << " with result: " << static_cast<int>(result_.value());
-            break;
-        }
-        // Continue polling
-        VLOG(1) << "Transfer engine operation still pending for batch "
-                << batch_id_;
+    // The batch is done, so this sees the final status of every task
+    check_task_status();
+    if (!result_.has_value()) {
+        set_result_internal(ErrorCode::TRANSFER_FAIL);
     }
-#endif
+    VLOG(1) << "Transfer engine operation completed for batch " << batch_id_
+            << " with result: " << static_cast<int>(result_.value());
 }
 
 // ============================================================================
@@ -386,10 +418,15 @@ TransferFuture::TransferFuture(std::shared_ptr<OperationState> state)
 bool TransferFuture::isReady() const { return state_->is_completed(); }
 
 ErrorCode TransferFuture::wait() {
+    TraceSpan span("TransferFuture::wait");
     if (!isReady()) {
         state_->wait_for_completion();
     }
-    return state_->get_result();
+    const ErrorCode result = state_->get_result();
+    if (span.active() && result != ErrorCode::OK) {
+        span.SetAttribute("error", toString(result));
+    }
+    return result;
 }
 
 ErrorCode TransferFuture::get() { return wait(); }
@@ -398,17 +435,50 @@ TransferStrategy TransferFuture::strategy() const {
     return state_->get_strategy();
 }
 
+TransferFuture TransferFuture::share() const { return TransferFuture(state_); }
+
+void CoalesceTransferRequests(std::vector<TransferRequest>& requests) {
+    if (requests.size() < 2) {
+        return;
+    }
+    std::sort(requests.begin(), requests.end(),
+              [](const TransferRequest& a, const TransferRequest& b) {
+                  return std::tie(a.target_id, a.target_offset) <
+                         std::tie(b.target_id, b.target_offset);
+              });
+    size_t last = 0;
+    for (size_t i = 1; i < requests.size(); ++i) {
+        auto& prev = requests[last];
+        const auto& request = requests[i];
+        if (prev.opcode == request.opcode &&
+            prev.priority == request.priority &&
+            prev.target_id == request.target_id &&
+            prev.target_offset + prev.length == request.target_offset &&
+            static_cast<char*>(prev.source) + prev.length == request.source) {
+            prev.length += request.length;
+        } else {
+            requests[++last] = request;
+        }
+    }
+    requests.resize(last + 1);
+}
+
 // ============================================================================
 // TransferSubmitter Implementation
 // ============================================================================
 
 TransferSubmitter::TransferSubmitter(TransferEngine& engine,
                                      std::shared_ptr<StorageBackend>& backend,
-                                     TransferMetric* transfer_metric)
+                                     TransferMetric* transfer_metric,
+                                     std::atomic<uint64_t>* transferred_bytes)
     : engine_(engine),
-      memcpy_pool_(std::make_unique<MemcpyWorkerPool>()),
+      memcpy_pool_(std::make_unique<MemcpyWorkerPool>(
+          GetEnvOr<uint64_t>("MC_STORE_MEMCPY_THREADS",
+                             MemcpyWorkerPool::kDefaultThreadsPerNode),
+          CopyEngine::Create(GetEnvStringOr("MC_STORE_COPY_ENGINE", "cpu")))),
       fileread_pool_(std::make_unique<FilereadWorkerPool>(backend)),
-      transfer_metric_(transfer_metric) {
+      transfer_metric_(transfer_metric),
+      transferred_bytes_(transferred_bytes) {
     // Read MC_STORE_MEMCPY environment variable, default to false (disabled)
     const char* env_value = std::getenv("MC_STORE_MEMCPY");
     if (env_value == nullptr) {
@@ -431,13 +501,19 @@ TransferSubmitter::TransferSubmitter(TransferEngine& engine,
         }
     }
 
+    if (GetEnvOr<int>("MC_STORE_TRANSFER_WINDOW", 0)) {
+        windows_ = std::make_unique<TransferWindows>(
+            TransferWindows::Config::FromEnv());
+    }
+
     VLOG(1) << "TransferSubmitter initialized with memcpy_enabled="
-            << memcpy_enabled_;
+            << memcpy_enabled_ << ", transfer_window=" << (windows_ != nullptr);
 }
 
 std::optional<TransferFuture> TransferSubmitter::submit(
     const Replica::Descriptor& replica, std::vector<Slice>& slices,
     TransferRequest::OpCode op_code) {
+    TraceSpan span("TransferSubmitter::submit");
     std::optional<TransferFuture> future;
 
     if (replica.is_memory_replica()) {
@@ -461,6 +537,9 @@ std::optional<TransferFuture> TransferSubmitter::submit(
                 LOG(ERROR) << "Unknown transfer strategy: " << strategy;
                 return std::nullopt;
         }
+    } else if (replica.is_striped_replica()) {
+        future = submitStripedOperation(replica.get_striped_descriptor(),
+                                        slices, op_code);
     } else {
         future = submitFileReadOperation(replica, slices, op_code);
     }
@@ -469,6 +548,16 @@ std::optional<TransferFuture> TransferSubmitter::submit(
     if (future.has_value()) {
         updateTransferMetrics(slices, op_code);
     }
+    if (span.active()) {
+        std::ostringstream strategy;
+        if (future.has_value()) {
+            strategy << future->strategy();
+        }
+        span.SetAttribute("strategy", strategy.str());
+        span.SetAttribute("slices", static_cast<int64_t>(slices.size()));
+        span.SetAttribute(
+            "op", op_code == TransferRequest::READ ? "read" : "write");
+    }
 
     return future;
 }
@@ -515,6 +604,68 @@ std::optional<TransferFuture> TransferSubmitter::submit_batch(
     return future;
 }
 
+std::vector<std::optional<TransferFuture>> TransferSubmitter::submit_coalesced(
+    const std::vector<Replica::Descriptor>& replicas,
+    const std::vector<std::vector<Slice>*>& all_slices,
+    TransferRequest::OpCode op_code) {
+    std::vector<std::optional<TransferFuture>> futures(replicas.size());
+    // The requests to each segment and the objects they carry
+    struct SegmentBatch {
+        std::vector<TransferRequest> requests;
+        std::vector<size_t> objects;
+        uint64_t bytes = 0;
+    };
+    std::unordered_map<SegmentHandle, SegmentBatch> batches;
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        const auto& replica = replicas[i];
+        auto& slices = *all_slices[i];
+        if (replica.is_memory_replica()) {
+            const auto& handle =
+                replica.get_memory_descriptor().buffer_descriptor;
+            if (validateTransferParams(handle, slices) &&
+                selectStrategy(handle, slices) ==
+                    TransferStrategy::TRANSFER_ENGINE) {
+                SegmentHandle seg;
+                std::vector<TransferRequest> requests;
+                auto bytes = appendTransferEngineRequests(handle, slices,
+                                                          op_code, seg,
+                                                          requests);
+                if (!bytes) {
+                    continue;
+                }
+                auto& batch = batches[seg];
+                batch.requests.insert(batch.requests.end(), requests.begin(),
+                                      requests.end());
+                batch.objects.push_back(i);
+                batch.bytes += *bytes;
+                continue;
+            }
+        }
+        futures[i] = submit(replica, slices, op_code);
+    }
+
+    for (auto& [seg, batch] : batches) {
+        const size_t request_count = batch.requests.size();
+        CoalesceTransferRequests(batch.requests);
+        VLOG(1) << "Coalesced " << request_count << " requests of "
+                << batch.objects.size() << " objects into "
+                << batch.requests.size() << " to segment " << seg;
+        std::unique_ptr<TransferWindows::Lease> window_lease;
+        if (windows_) {
+            window_lease = windows_->Acquire(seg, batch.bytes);
+        }
+        auto future = submitTransfer(batch.requests, std::move(window_lease));
+        if (!future) {
+            continue;
+        }
+        for (size_t i : batch.objects) {
+            futures[i] = future->share();
+            updateTransferMetrics(*all_slices[i], op_code);
+        }
+    }
+    return futures;
+}
+
 std::optional<TransferFuture>
 TransferSubmitter::submit_batch_get_offload_object(
     const std::string& transfer_engine_addr,
@@ -551,6 +702,9 @@ std::optional<TransferFuture> TransferSubmitter::submitMemcpyOperation(
     std::vector<MemcpyOperation> operations;
     operations.reserve(slices.size());
     uint64_t base_address = static_cast<uint64_t>(handle.buffer_address_);
+    if (handle.protocol_ == "cxl") {
+        base_address += reinterpret_cast<uint64_t>(engine_.getBaseAddr());
+    }
     uint64_t offset = 0;
 
     for (size_t i = 0; i < slices.size(); ++i) {
@@ -588,7 +742,8 @@ std::optional<TransferFuture> TransferSubmitter::submitMemcpyOperation(
 }
 
 std::optional<TransferFuture> TransferSubmitter::submitTransfer(
-    std::vector<TransferRequest>& requests) {
+    std::vector<TransferRequest>& requests,
+    std::unique_ptr<TransferWindows::Lease> window_lease) {
     // Allocate batch ID
     const size_t batch_size = requests.size();
     BatchID batch_id = engine_.allocateBatchID(batch_size);
@@ -618,19 +773,30 @@ std::optional<TransferFuture> TransferSubmitter::submitTransfer(
     // needed
     auto state = std::make_shared<TransferEngineOperationState>(
         engine_, batch_id, batch_size);
+    if (window_lease) {
+        // Lets submitters waiting for room notice the completion
+        window_lease->SetPoller(
+            [weak = std::weak_ptr<TransferEngineOperationState>(state)] {
+                if (auto state = weak.lock()) {
+                    state->is_completed();
+                }
+            });
+        state->set_window_lease(std::move(window_lease));
+    }
 
     return TransferFuture(state);
 }
 
-std::optional<TransferFuture> TransferSubmitter::submitTransferEngineOperation(
+std::optional<uint64_t> TransferSubmitter::appendTransferEngineRequests(
     const AllocatedBuffer::Descriptor& handle, const std::vector<Slice>& slices,
-    const TransferRequest::OpCode op_code) {
+    TransferRequest::OpCode op_code, SegmentHandle& seg,
+    std::vector<TransferRequest>& requests) {
     if (handle.transport_endpoint_.empty()) {
         LOG(ERROR) << "Transport endpoint is empty for handle with address "
                    << handle.buffer_address_;
         return std::nullopt;
     }
-    SegmentHandle seg = engine_.openSegment(handle.transport_endpoint_);
+    seg = engine_.openSegment(handle.transport_endpoint_);
 
     if (seg == static_cast<uint64_t>(ERR_INVALID_ARGUMENT)) {
         LOG(ERROR) << "Failed to open segment for endpoint='"
@@ -639,15 +805,30 @@ std::optional<TransferFuture> TransferSubmitter::submitTransferEngineOperation(
     }
 
     // Create transfer requests
-    std::vector<TransferRequest> requests;
-    requests.reserve(slices.size());
+    const size_t first = requests.size();
+    requests.reserve(first + slices.size());
     uint64_t base_address = static_cast<uint64_t>(handle.buffer_address_);
+    if (handle.protocol_ == "cxl") {
+        base_address += reinterpret_cast<uint64_t>(engine_.getBaseAddr());
+    }
     uint64_t offset = 0;
 
     for (size_t i = 0; i < slices.size(); ++i) {
         const auto& slice = slices[i];
         if (slice.ptr == nullptr) continue;
 
+        // Slices of adjacent pages, e.g. of a paged KV cache, are sent as
+        // one request
+        if (requests.size() > first) {
+            auto& last = requests.back();
+            if (static_cast<char*>(last.source) + last.length == slice.ptr &&
+                last.target_offset + last.length == base_address + offset) {
+                last.length += slice.size;
+                offset += slice.size;
+                continue;
+            }
+        }
+
         TransferRequest request;
         request.opcode = op_code;
         request.source = static_cast<char*>(slice.ptr);
@@ -658,7 +839,24 @@ std::optional<TransferFuture> TransferSubmitter::submitTransferEngineOperation(
         offset += slice.size;
         requests.emplace_back(request);
     }
-    return submitTransfer(requests);
+    return offset;
+}
+
+std::optional<TransferFuture> TransferSubmitter::submitTransferEngineOperation(
+    const AllocatedBuffer::Descriptor& handle, const std::vector<Slice>& slices,
+    const TransferRequest::OpCode op_code) {
+    SegmentHandle seg;
+    std::vector<TransferRequest> requests;
+    auto bytes =
+        appendTransferEngineRequests(handle, slices, op_code, seg, requests);
+    if (!bytes) {
+        return std::nullopt;
+    }
+    std::unique_ptr<TransferWindows::Lease> window_lease;
+    if (windows_) {
+        window_lease = windows_->Acquire(seg, *bytes);
+    }
+    return submitTransfer(requests, std::move(window_lease));
 }
 
 std::optional<TransferFuture> TransferSubmitter::submitFileReadOperation(
@@ -678,9 +876,243 @@ std::optional<TransferFuture> TransferSubmitter::submitFileReadOperation(
     return TransferFuture(state);
 }
 
+namespace {
+
+// Slices covering [offset, offset + length) of the data held by slices
+std::vector<Slice> SliceRange(const std::vector<Slice>& slices,
+                              uint64_t offset, uint64_t length) {
+    std::vector<Slice> range;
+    for (const auto& slice : slices) {
+        if (length == 0) {
+            break;
+        }
+        if (offset >= slice.size) {
+            offset -= slice.size;
+            continue;
+        }
+        const uint64_t size = std::min<uint64_t>(slice.size - offset, length);
+        range.push_back({static_cast<char*>(slice.ptr) + offset, size});
+        length -= size;
+        offset = 0;
+    }
+    return range;
+}
+
+// Memory for chunks that are not in the slices, registered for transfers
+class StagingBuffer {
+   public:
+    StagingBuffer(TransferEngine& engine, size_t size)
+        : engine_(engine), data_(std::make_unique<uint8_t[]>(size)) {
+        registered_ = engine_.registerLocalMemory(data_.get(), size,
+                                                  kWildcardLocation, false,
+                                                  true) == 0;
+    }
+
+    ~StagingBuffer() {
+        if (registered_) {
+            engine_.unregisterLocalMemory(data_.get());
+        }
+    }
+
+    StagingBuffer(const StagingBuffer&) = delete;
+    StagingBuffer& operator=(const StagingBuffer&) = delete;
+
+    bool registered() const { return registered_; }
+    uint8_t* data() { return data_.get(); }
+
+   private:
+    TransferEngine& engine_;
+    std::unique_ptr<uint8_t[]> data_;
+    bool registered_{false};
+};
+
+}  // namespace
+
+bool TransferSubmitter::appendChunkRequests(
+    const AllocatedBuffer::Descriptor& handle, const std::vector<Slice>& slices,
+    TransferRequest::OpCode op_code, std::vector<TransferRequest>& requests) {
+    SegmentHandle seg = engine_.openSegment(handle.transport_endpoint_);
+    if (seg == static_cast<uint64_t>(ERR_INVALID_ARGUMENT)) {
+        LOG(ERROR) << "Failed to open segment " << handle.transport_endpoint_;
+        return false;
+    }
+    uint64_t offset = 0;
+    for (const auto& slice : slices) {
+        TransferRequest request;
+        request.opcode = op_code;
+        request.source = static_cast<char*>(slice.ptr);
+        request.target_id = seg;
+        request.target_offset = handle.buffer_address_ + offset;
+        request.length = slice.size;
+        requests.emplace_back(request);
+        offset += slice.size;
+    }
+    return true;
+}
+
+ErrorCode TransferSubmitter::runTransfer(
+    std::vector<TransferRequest>& requests) {
+    if (requests.empty()) {
+        return ErrorCode::OK;
+    }
+    auto future = submitTransfer(requests);
+    if (!future) {
+        return ErrorCode::TRANSFER_FAIL;
+    }
+    return future->get();
+}
+
+std::optional<TransferFuture> TransferSubmitter::submitStripedOperation(
+    const StripedDescriptor& striped, std::vector<Slice>& slices,
+    TransferRequest::OpCode op_code) {
+    const size_t data_chunks = striped.data_chunks;
+    const auto& chunks = striped.chunk_descriptors;
+    if (data_chunks == 0 || chunks.size() < data_chunks ||
+        chunks.size() > ReedSolomonCode::kMaxChunks) {
+        LOG(ERROR) << "data_chunks=" << data_chunks
+                   << ", num_chunks=" << chunks.size()
+                   << ", error=invalid_striped_descriptor";
+        return std::nullopt;
+    }
+    uint64_t slices_size = 0;
+    for (const auto& slice : slices) {
+        slices_size += slice.size;
+    }
+    if (slices_size != striped.object_size) {
+        LOG(ERROR) << "object_size=" << striped.object_size
+                   << ", all_slice_len=" << slices_size;
+        return std::nullopt;
+    }
+
+    const ReedSolomonCode code(data_chunks, chunks.size() - data_chunks);
+    const uint64_t chunk_size = striped.chunk_size();
+    // Bytes of the object in data chunk i, the last ones may be short
+    auto data_length = [&](size_t i) -> uint64_t {
+        const uint64_t begin = i * chunk_size;
+        return begin >= striped.object_size
+                   ? 0
+                   : std::min(chunk_size, striped.object_size - begin);
+    };
+    auto present = [&](size_t i) { return chunks[i].size_ != 0; };
+
+    std::vector<TransferRequest> requests;
+    ErrorCode result = ErrorCode::OK;
+    if (op_code == TransferRequest::WRITE) {
+        for (size_t i = 0; i < chunks.size(); i++) {
+            if (!present(i)) {
+                LOG(ERROR) << "chunk=" << i << ", error=chunk_missing";
+                return std::nullopt;
+            }
+        }
+        const size_t parity_chunks = chunks.size() - data_chunks;
+        StagingBuffer staging(engine_, parity_chunks * chunk_size);
+        if (!staging.registered()) {
+            LOG(ERROR) << "size=" << parity_chunks * chunk_size
+                       << ", error=staging_buffer_registration_failed";
+            return std::nullopt;
+        }
+        std::vector<uint8_t*> parity;
+        for (size_t j = 0; j < parity_chunks; j++) {
+            parity.push_back(staging.data() + j * chunk_size);
+        }
+        for (size_t i = 0; i < data_chunks; i++) {
+            auto data = SliceRange(slices, i * chunk_size, data_length(i));
+            uint64_t offset = 0;
+            for (const auto& piece : data) {
+                code.Encode(i, static_cast<const uint8_t*>(piece.ptr),
+                            piece.size, offset, parity);
+                offset += piece.size;
+            }
+            if (!appendChunkRequests(chunks[i], data, op_code, requests)) {
+                return std::nullopt;
+            }
+        }
+        for (size_t j = 0; j < parity_chunks; j++) {
+            std::vector<Slice> chunk = {{parity[j], chunk_size}};
+            if (!appendChunkRequests(chunks[data_chunks + j], chunk, op_code,
+                                     requests)) {
+                return std::nullopt;
+            }
+        }
+        result = runTransfer(requests);
+    } else {
+        bool all_data_present = true;
+        for (size_t i = 0; i < data_chunks; i++) {
+            all_data_present = all_data_present && present(i);
+        }
+        if (all_data_present) {
+            for (size_t i = 0; i < data_chunks; i++) {
+                if (!appendChunkRequests(
+                        chunks[i],
+                        SliceRange(slices, i * chunk_size, data_length(i)),
+                        op_code, requests)) {
+                    return std::nullopt;
+                }
+            }
+            result = runTransfer(requests);
+        } else {
+            // Degraded read of k present chunks into a staging buffer
+            StagingBuffer staging(engine_, chunks.size() * chunk_size);
+            if (!staging.registered()) {
+                LOG(ERROR) << "size=" << chunks.size() * chunk_size
+                           << ", error=staging_buffer_registration_failed";
+                return std::nullopt;
+            }
+            std::vector<uint8_t*> buffers;
+            std::vector<bool> sources(chunks.size(), false);
+            size_t num_sources = 0;
+            for (size_t c = 0; c < chunks.size(); c++) {
+                buffers.push_back(staging.data() + c * chunk_size);
+                if (num_sources == data_chunks || !present(c)) {
+                    continue;
+                }
+                // The tail of a short data chunk stays zero, as encoded
+                const uint64_t length =
+                    c < data_chunks ? data_length(c) : chunk_size;
+                std::vector<Slice> chunk = {{buffers[c], length}};
+                if (length > 0 &&
+                    !appendChunkRequests(chunks[c], chunk, op_code,
+                                         requests)) {
+                    return std::nullopt;
+                }
+                sources[c] = true;
+                num_sources++;
+            }
+            if (num_sources < data_chunks) {
+                LOG(ERROR) << "present_chunks=" << num_sources
+                           << ", data_chunks=" << data_chunks
+                           << ", error=too_many_chunks_lost";
+                return std::nullopt;
+            }
+            result = runTransfer(requests);
+            if (result == ErrorCode::OK) {
+                code.Reconstruct(buffers, sources, chunk_size);
+                uint64_t offset = 0;
+                for (const auto& slice : slices) {
+                    std::memcpy(slice.ptr, staging.data() + offset,
+                                slice.size);
+                    offset += slice.size;
+                }
+            }
+        }
+    }
+
+    VLOG(1) << "Striped transfer of " << chunks.size() << " chunks, result="
+            << result;
+    return TransferFuture(std::make_shared<StripedOperationState>(result));
+}
+
 TransferStrategy TransferSubmitter::selectStrategy(
     const AllocatedBuffer::Descriptor& handle,
     const std::vector<Slice>& slices) const {
+    // A CXL replica is at an offset of the shared device. When this client
+    // maps the device it is accessed with plain loads and stores.
+    if (handle.protocol_ == "cxl") {
+        return engine_.getBaseAddr() != nullptr
+                   ? TransferStrategy::LOCAL_MEMCPY
+                   : TransferStrategy::TRANSFER_ENGINE;
+    }
+
     // Check if memcpy operations are enabled via environment variable
     if (!memcpy_enabled_) {
         VLOG(2) << "Memcpy operations disabled via MC_STORE_MEMCPY environment "
@@ -731,6 +1163,10 @@ void TransferSubmitter::updateTransferMetrics(const std::vector<Slice>& slices,
         total_bytes += slice.size;
     }
 
+    if (transferred_bytes_ != nullptr) {
+        transferred_bytes_->fetch_add(total_bytes, std::memory_order_relaxed);
+    }
+
     if (transfer_metric_ == nullptr) {
         return;
     }
@@ -0,0 +1,161 @@
+#include "transfer_window.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "utils.h"
+
+namespace mooncake {
+
+namespace {
+
+// How often a thread waiting for room polls the transfers in flight
+constexpr auto kPollInterval = std::chrono::microseconds(100);
+
+}  // namespace
+
+TransferWindows::Config TransferWindows::Config::FromEnv() {
+    Config config;
+    config.initial_bytes = GetEnvOr<uint64_t>(
+        "MC_STORE_TRANSFER_WINDOW_INITIAL_BYTES", config.initial_bytes);
+    config.min_bytes = GetEnvOr<uint64_t>("MC_STORE_TRANSFER_WINDOW_MIN_BYTES",
+                                          config.min_bytes);
+    config.max_bytes = GetEnvOr<uint64_t>("MC_STORE_TRANSFER_WINDOW_MAX_BYTES",
+                                          config.max_bytes);
+    config.increase_bytes = GetEnvOr<uint64_t>(
+        "MC_STORE_TRANSFER_WINDOW_INCREASE_BYTES", config.increase_bytes);
+    config.decrease_factor =
+        GetEnvOr<uint64_t>("MC_STORE_TRANSFER_WINDOW_DECREASE_PERCENT", 70) /
+        100.0;
+    config.target_delay_us = GetEnvOr<int64_t>(
+        "MC_STORE_TRANSFER_WINDOW_TARGET_DELAY_US", config.target_delay_us);
+    config.link_gbps = GetEnvOr<uint64_t>("MC_STORE_TRANSFER_WINDOW_LINK_GBPS",
+                                          config.link_gbps);
+    config.min_bytes = std::max<uint64_t>(config.min_bytes, 1);
+    config.max_bytes = std::max(config.max_bytes, config.min_bytes);
+    config.initial_bytes =
+        std::clamp(config.initial_bytes, config.min_bytes, config.max_bytes);
+    config.decrease_factor = std::clamp(config.decrease_factor, 0.01, 1.0);
+    config.link_gbps = std::max<uint64_t>(config.link_gbps, 1);
+    return config;
+}
+
+TransferWindows::Lease::Lease(TransferWindows* owner, uint64_t segment,
+                              uint64_t bytes)
+    : owner_(owner), segment_(segment), bytes_(bytes) {}
+
+TransferWindows::Lease::~Lease() {
+    if (!finished_) {
+        owner_->Release(this, false, false, 0);
+    }
+}
+
+void TransferWindows::Lease::SetPoller(std::function<void()> poller) {
+    std::lock_guard<std::mutex> lock(owner_->mutex_);
+    poller_ = std::move(poller);
+}
+
+void TransferWindows::Lease::Finish(bool ok) {
+    Finish(ok, std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now() - start_)
+                   .count());
+}
+
+void TransferWindows::Lease::Finish(bool ok, int64_t latency_us) {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    owner_->Release(this, true, ok, latency_us);
+}
+
+TransferWindows::TransferWindows(const Config& config) : config_(config) {}
+
+std::unique_ptr<TransferWindows::Lease> TransferWindows::Acquire(
+    uint64_t segment, uint64_t bytes) {
+    std::unique_ptr<Lease> lease(new Lease(this, segment, bytes));
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto [it, inserted] = windows_.try_emplace(segment);
+    Window& window = it->second;
+    if (inserted) {
+        window.window_bytes = config_.initial_bytes;
+    }
+    auto has_room = [&] {
+        return window.inflight_bytes == 0 ||
+               window.inflight_bytes + bytes <= window.window_bytes;
+    };
+    std::vector<std::function<void()>> pollers;
+    while (!has_room()) {
+        pollers.clear();
+        for (auto* other : window.leases) {
+            if (other->poller_) {
+                pollers.push_back(other->poller_);
+            }
+        }
+        lock.unlock();
+        for (auto& poller : pollers) {
+            poller();
+        }
+        lock.lock();
+        if (has_room()) {
+            break;
+        }
+        cv_.wait_for(lock, kPollInterval);
+    }
+    window.inflight_bytes += bytes;
+    lease->position_ = window.leases.insert(window.leases.end(), lease.get());
+    lease->start_ = std::chrono::steady_clock::now();
+    return lease;
+}
+
+void TransferWindows::Release(Lease* lease, bool adjust, bool ok,
+                              int64_t latency_us) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Window& window = windows_.at(lease->segment_);
+        window.inflight_bytes -= lease->bytes_;
+        window.leases.erase(lease->position_);
+        if (adjust) {
+            // Gbps is bits per nanosecond, i.e. 1000 bits per microsecond
+            const double wire_us =
+                lease->bytes_ * 8.0 / (config_.link_gbps * 1000.0);
+            const bool congested =
+                !ok || latency_us - wire_us > config_.target_delay_us;
+            const auto now = std::chrono::steady_clock::now();
+            if (!congested) {
+                // increase_bytes per window of bytes completed
+                window.window_bytes = std::min(
+                    config_.max_bytes,
+                    window.window_bytes +
+                        std::max<uint64_t>(1, config_.increase_bytes *
+                                                  lease->bytes_ /
+                                                  window.window_bytes));
+            } else if (now - window.last_decrease >=
+                       std::chrono::microseconds(latency_us)) {
+                // Transfers in flight when the window shrank report the
+                // same congestion, so it shrinks once per latency
+                window.window_bytes = std::max(
+                    config_.min_bytes,
+                    static_cast<uint64_t>(window.window_bytes *
+                                          config_.decrease_factor));
+                window.last_decrease = now;
+            }
+        }
+    }
+    cv_.notify_all();
+}
+
+uint64_t TransferWindows::WindowBytes(uint64_t segment) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = windows_.find(segment);
+    return it == windows_.end() ? config_.initial_bytes
+                                : it->second.window_bytes;
+}
+
+uint64_t TransferWindows::InflightBytes(uint64_t segment) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = windows_.find(segment);
+    return it == windows_.end() ? 0 : it->second.inflight_bytes;
+}
+
+}  // namespace mooncake
@@ -34,6 +34,7 @@ const std::string& toString(ErrorCode errorCode) noexcept {
         {ErrorCode::REPLICA_NOT_FOUND, "REPLICA_NOT_FOUND"},
         {ErrorCode::REPLICA_ALREADY_EXISTS, "REPLICA_ALREADY_EXISTS"},
         {ErrorCode::REPLICA_IS_GONE, "REPLICA_IS_GONE"},
+        {ErrorCode::OBJECT_PUT_IN_PROGRESS, "OBJECT_PUT_IN_PROGRESS"},
         {ErrorCode::TRANSFER_FAIL, "TRANSFER_FAIL"},
         {ErrorCode::RPC_FAIL, "RPC_FAIL"},
         {ErrorCode::ETCD_OPERATION_ERROR, "ETCD_OPERATION_ERROR"},
@@ -50,12 +51,15 @@ const std::string& toString(ErrorCode errorCode) noexcept {
         {ErrorCode::FILE_INVALID_BUFFER, "FILE_INVALID_BUFFER"},
         {ErrorCode::FILE_LOCK_FAIL, "FILE_LOCK_FAIL"},
         {ErrorCode::FILE_INVALID_HANDLE, "FILE_INVALID_HANDLE"},
+        {ErrorCode::FILE_CHECKSUM_MISMATCH, "FILE_CHECKSUM_MISMATCH"},
         {ErrorCode::BUCKET_NOT_FOUND, "BUCKET_NOT_FOUND"},
         {ErrorCode::BUCKET_ALREADY_EXISTS, "BUCKET_ALREADY_EXISTS"},
         {ErrorCode::KEYS_EXCEED_BUCKET_LIMIT, "KEYS_EXCEED_BUCKET_LIMIT"},
         {ErrorCode::KEYS_ULTRA_LIMIT, "KEYS_ULTRA_LIMIT"},
         {ErrorCode::UNABLE_OFFLOAD, "UNABLE_OFFLOAD"},
-        {ErrorCode::UNABLE_OFFLOADING, "UNABLE_OFFLOADING"}};
+        {ErrorCode::UNABLE_OFFLOADING, "UNABLE_OFFLOADING"},
+        {ErrorCode::TENANT_QUOTA_EXCEEDED, "TENANT_QUOTA_EXCEEDED"},
+        {ErrorCode::TENANT_RATE_LIMITED, "TENANT_RATE_LIMITED"}};
 
     auto it = errorCodeMap.find(errorCode);
     static const std::string unknownError = "UNKNOWN_ERROR";
@@ -0,0 +1,347 @@
+#include "uring_file.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <liburing.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <shared_mutex>
+
+#include "utils.h"
+
+namespace mooncake {
+
+namespace {
+
+// io_uring refuses registered buffers larger than 1 GB
+constexpr size_t kMaxRegisteredBufferSize = 1ULL << 30;
+
+struct BufferRegistry {
+    std::shared_mutex mutex;
+    std::vector<iovec> buffers;
+    uint64_t generation = 0;
+};
+
+BufferRegistry& GetBufferRegistry() {
+    static BufferRegistry registry;
+    return registry;
+}
+
+class ThreadRing {
+   public:
+    ThreadRing()
+        : depth_(GetEnvOr<unsigned>("MOONCAKE_OFFLOAD_URING_QUEUE_DEPTH", 64)) {
+        Init();
+    }
+
+    ~ThreadRing() {
+        if (ready_) {
+            io_uring_queue_exit(&ring_);
+        }
+    }
+
+    ThreadRing(const ThreadRing&) = delete;
+    ThreadRing& operator=(const ThreadRing&) = delete;
+
+    bool ready() const { return ready_; }
+
+    io_uring* get() { return &ring_; }
+
+    unsigned depth() const { return depth_; }
+
+    // Index of the registered buffer holding [addr, addr + length), or -1
+    int BufferIndex(const void* addr, size_t length) const {
+        auto begin = reinterpret_cast<uintptr_t>(addr);
+        for (size_t i = 0; i < buffers_.size(); ++i) {
+            auto base = reinterpret_cast<uintptr_t>(buffers_[i].iov_base);
+            if (begin >= base && begin + length <= base + buffers_[i].iov_len) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Picks up the buffers registered since the last submission
+    void SyncBuffers() {
+        auto& registry = GetBufferRegistry();
+        std::shared_lock lock(registry.mutex);
+        if (registry.generation == generation_) {
+            return;
+        }
+        generation_ = registry.generation;
+        if (!buffers_.empty()) {
+            io_uring_unregister_buffers(&ring_);
+            buffers_.clear();
+        }
+        int ret = io_uring_register_buffers(&ring_, registry.buffers.data(),
+                                            registry.buffers.size());
+        if (ret < 0) {
+            LOG(WARNING) << "error=io_uring_register_buffers_failed, errno="
+                         << -ret << ", using unregistered buffers";
+            return;
+        }
+        buffers_ = registry.buffers;
+    }
+
+    // Drops a ring that failed to submit, its pending requests included
+    void Reset() {
+        if (ready_) {
+            io_uring_queue_exit(&ring_);
+            ready_ = false;
+        }
+        buffers_.clear();
+        generation_ = 0;
+        Init();
+    }
+
+   private:
+    void Init() {
+        int ret = io_uring_queue_init(depth_, &ring_, 0);
+        if (ret < 0) {
+            LOG(ERROR) << "error=io_uring_queue_init_failed, errno=" << -ret
+                       << ", using synchronous I/O";
+            return;
+        }
+        ready_ = true;
+    }
+
+    io_uring ring_{};
+    bool ready_ = false;
+    const unsigned depth_;
+    uint64_t generation_ = 0;
+    std::vector<iovec> buffers_;
+};
+
+ThreadRing& GetThreadRing() {
+    thread_local ThreadRing ring;
+    return ring;
+}
+
+bool IsAligned(uint64_t value) {
+    return value % UringFile::kDirectIoAlignment == 0;
+}
+
+}  // namespace
+
+struct UringFile::Op {
+    char* buffer;
+    size_t length;
+    off_t offset;
+    int fd;
+    size_t done = 0;
+};
+
+UringFile::UringFile(const std::string& filename, int fd, int direct_fd)
+    : PosixFile(filename, fd), direct_fd_(direct_fd) {}
+
+UringFile::~UringFile() {
+    if (direct_fd_ >= 0 && close(direct_fd_) != 0) {
+        LOG(WARNING) << "Failed to close file: " << filename_;
+    }
+}
+
+void UringFile::RegisterBuffer(void* addr, size_t length) {
+    auto& registry = GetBufferRegistry();
+    std::unique_lock lock(registry.mutex);
+    auto* base = static_cast<char*>(addr);
+    for (size_t offset = 0; offset < length;
+         offset += kMaxRegisteredBufferSize) {
+        registry.buffers.push_back(
+            iovec{base + offset,
+                  std::min(kMaxRegisteredBufferSize, length - offset)});
+    }
+    registry.generation++;
+}
+
+int UringFile::FdFor(const void* buffer, size_t length, off_t offset) const {
+    if (direct_fd_ >= 0 && IsAligned(reinterpret_cast<uintptr_t>(buffer)) &&
+        IsAligned(length) && IsAligned(offset)) {
+        return direct_fd_;
+    }
+    return fd_;
+}
+
+tl::expected<size_t, ErrorCode> UringFile::Submit(std::vector<Op>& ops,
+                                                  bool is_write) {
+    const ErrorCode fail_code =
+        is_write ? ErrorCode::FILE_WRITE_FAIL : ErrorCode::FILE_READ_FAIL;
+    auto& ring = GetThreadRing();
+    bool failed = false;
+
+    if (!ring.ready()) {
+        for (auto& op : ops) {
+            while (op.done < op.length) {
+                ssize_t n =
+                    is_write ? ::pwrite(op.fd, op.buffer + op.done,
+                                        op.length - op.done,
+                                        op.offset + op.done)
+                             : ::pread(op.fd, op.buffer + op.done,
+                                       op.length - op.done,
+                                       op.offset + op.done);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    failed = n < 0 || is_write;
+                    break;
+                }
+                op.done += n;
+            }
+        }
+    } else {
+        ring.SyncBuffers();
+        io_uring* r = ring.get();
+        std::vector<Op*> queue;
+        queue.reserve(ops.size());
+        for (auto& op : ops) {
+            queue.push_back(&op);
+        }
+        size_t next = 0;
+        unsigned inflight = 0;
+        while ((!failed && next < queue.size()) || inflight > 0) {
+            while (!failed && next < queue.size() &&
+                   inflight < ring.depth()) {
+                io_uring_sqe* sqe = io_uring_get_sqe(r);
+                if (sqe == nullptr) {
+                    break;
+                }
+                Op* op = queue[next++];
+                char* buffer = op->buffer + op->done;
+                const size_t length = op->length - op->done;
+                const off_t offset = op->offset + op->done;
+                const int index = ring.BufferIndex(buffer, length);
+                if (is_write) {
+                    if (index >= 0) {
+                        io_uring_prep_write_fixed(sqe, op->fd, buffer, length,
+                                                  offset, index);
+                    } else {
+                        io_uring_prep_write(sqe, op->fd, buffer, length,
+                                            offset);
+                    }
+                } else {
+                    if (index >= 0) {
+                        io_uring_prep_read_fixed(sqe, op->fd, buffer, length,
+                                                 offset, index);
+                    } else {
+                        io_uring_prep_read(sqe, op->fd, buffer, length,
+                                           offset);
+                    }
+                }
+                io_uring_sqe_set_data(sqe, op);
+                inflight++;
+            }
+
+            int ret = io_uring_submit_and_wait(r, 1);
+            if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+                LOG(ERROR) << "file=" << filename_
+                           << ", error=io_uring_submit_failed, errno=" << -ret;
+                ring.Reset();
+                return make_error<size_t>(fail_code);
+            }
+
+            io_uring_cqe* cqe;
+            unsigned head;
+            unsigned seen = 0;
+            io_uring_for_each_cqe(r, head, cqe) {
+                auto* op = static_cast<Op*>(io_uring_cqe_get_data(cqe));
+                const int res = cqe->res;
+                seen++;
+                inflight--;
+                if (res == -EINTR || res == -EAGAIN) {
+                    queue.push_back(op);
+                } else if (res < 0) {
+                    LOG(ERROR) << "file=" << filename_
+                               << ", error=io_failed, errno=" << -res
+                               << ", offset=" << op->offset + op->done;
+                    failed = true;
+                } else if (res == 0) {
+                    // End of file, the short read is left to the caller
+                    failed = failed || is_write;
+                } else {
+                    op->done += res;
+                    if (op->done < op->length) {
+                        queue.push_back(op);
+                    }
+                }
+            }
+            io_uring_cq_advance(r, seen);
+        }
+    }
+
+    size_t total = 0;
+    for (const auto& op : ops) {
+        total += op.done;
+        // Keep the offloaded data out of the page cache when O_DIRECT is
+        // asked for but the request is not aligned for it
+        if (direct_fd_ >= 0 && op.fd != direct_fd_ && op.done > 0) {
+            posix_fadvise(op.fd, op.offset, op.done, POSIX_FADV_DONTNEED);
+        }
+    }
+    if (failed) {
+        return make_error<size_t>(fail_code);
+    }
+    return total;
+}
+
+tl::expected<size_t, ErrorCode> UringFile::vector_write(const iovec* iov,
+                                                        int iovcnt,
+                                                        off_t offset) {
+    if (fd_ < 0) {
+        return make_error<size_t>(ErrorCode::FILE_NOT_FOUND);
+    }
+    std::vector<Op> ops;
+    ops.reserve(iovcnt);
+    for (int i = 0; i < iovcnt; ++i) {
+        auto* buffer = static_cast<char*>(iov[i].iov_base);
+        ops.push_back(Op{buffer, iov[i].iov_len, offset,
+                         FdFor(buffer, iov[i].iov_len, offset)});
+        offset += iov[i].iov_len;
+    }
+    return Submit(ops, true);
+}
+
+tl::expected<size_t, ErrorCode> UringFile::vector_read(const iovec* iov,
+                                                       int iovcnt,
+                                                       off_t offset) {
+    if (fd_ < 0) {
+        return make_error<size_t>(ErrorCode::FILE_NOT_FOUND);
+    }
+    std::vector<Op> ops;
+    ops.reserve(iovcnt);
+    for (int i = 0; i < iovcnt; ++i) {
+        auto* buffer = static_cast<char*>(iov[i].iov_base);
+        ops.push_back(Op{buffer, iov[i].iov_len, offset,
+                         FdFor(buffer, iov[i].iov_len, offset)});
+        offset += iov[i].iov_len;
+    }
+    return Submit(ops, false);
+}
+
+tl::expected<void, ErrorCode> UringFile::batch_read(
+    const std::vector<FileReadRequest>& requests) {
+    if (fd_ < 0) {
+        return make_error<void>(ErrorCode::FILE_NOT_FOUND);
+    }
+    std::vector<Op> ops;
+    ops.reserve(requests.size());
+    size_t expected = 0;
+    for (const auto& request : requests) {
+        auto* buffer = static_cast<char*>(request.buffer);
+        ops.push_back(Op{buffer, request.length, request.offset,
+                         FdFor(buffer, request.length, request.offset)});
+        expected += request.length;
+    }
+    auto result = Submit(ops, false);
+    if (!result) {
+        return tl::make_unexpected(result.error());
+    }
+    if (result.value() != expected) {
+        return make_error<void>(ErrorCode::FILE_READ_FAIL);
+    }
+    return {};
+}
+
+}  // namespace mooncake
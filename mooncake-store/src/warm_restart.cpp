@@ -0,0 +1,224 @@
+#include "warm_restart.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+namespace mooncake {
+
+namespace {
+
+constexpr const char* kStateHeader = "mooncake_warm_restart_v1";
+
+std::string ShmPrefix(const std::string& dir,
+                      const std::string& local_hostname) {
+    std::ostringstream prefix;
+    prefix << "/mooncake_warm_" << std::hex
+           << std::hash<std::string>{}(dir + "|" + local_hostname);
+    return prefix.str();
+}
+
+// Maps the shared memory at base if given, nullptr if it cannot be mapped
+// there
+void* MapShm(int fd, size_t size, void* base) {
+    const int flags = MAP_SHARED | (base ? MAP_FIXED_NOREPLACE : 0);
+    void* ptr = mmap(base, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+    if (base && ptr != base) {
+        // Kernels before 4.17 take the address as a hint only
+        munmap(ptr, size);
+        return nullptr;
+    }
+    return ptr;
+}
+
+}  // namespace
+
+WarmRestartState::WarmRestartState(std::string dir, std::string local_hostname,
+                                   size_t total_size)
+    : dir_(std::move(dir)),
+      local_hostname_(std::move(local_hostname)),
+      total_size_(total_size),
+      shm_prefix_(ShmPrefix(dir_, local_hostname_)),
+      client_id_(generate_uuid()) {}
+
+std::string WarmRestartState::StatePath() const {
+    // One state per client, named like its shared memory
+    return dir_ + "/" + shm_prefix_.substr(1) + ".state";
+}
+
+bool WarmRestartState::Load(std::vector<Segment>& segments,
+                            UUID& client_id) const {
+    std::ifstream in(StatePath());
+    if (!in) {
+        return false;
+    }
+    std::string header;
+    std::string hostname;
+    size_t count = 0;
+    in >> header >> hostname >> client_id.first >> client_id.second >> count;
+    if (!in || header != kStateHeader) {
+        LOG(WARNING) << "Ignoring invalid warm restart state " << StatePath();
+        return false;
+    }
+    uint64_t total_size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Segment segment;
+        in >> segment.shm_name >> segment.base >> segment.size >>
+            segment.numa_node >> segment.id.first >> segment.id.second;
+        if (!in) {
+            LOG(WARNING) << "Ignoring truncated warm restart state "
+                         << StatePath();
+            return false;
+        }
+        total_size += segment.size;
+        segments.push_back(std::move(segment));
+    }
+    if (hostname != local_hostname_ || total_size != total_size_ ||
+        count == 0) {
+        LOG(INFO) << "Warm restart state of " << hostname << " with "
+                  << total_size << " bytes does not match " << local_hostname_
+                  << " with " << total_size_ << " bytes";
+        return false;
+    }
+    return true;
+}
+
+std::vector<WarmRestartState::Mapping> WarmRestartState::Restore() {
+    std::vector<Mapping> mappings;
+    std::vector<Segment> saved;
+    UUID saved_client_id;
+    bool ok = Load(saved, saved_client_id);
+    for (size_t i = 0; ok && i < saved.size(); ++i) {
+        const auto& segment = saved[i];
+        const int fd = shm_open(segment.shm_name.c_str(), O_RDWR | O_CLOEXEC,
+                                0600);
+        struct stat st {};
+        void* base = reinterpret_cast<void*>(segment.base);
+        void* ptr = nullptr;
+        if (fd != -1 && fstat(fd, &st) == 0 &&
+            static_cast<uint64_t>(st.st_size) == segment.size) {
+            ptr = MapShm(fd, segment.size, base);
+        }
+        if (!ptr) {
+            LOG(WARNING) << "Failed to map " << segment.shm_name << " at "
+                         << base << ", errno=" << errno << " ("
+                         << strerror(errno) << ")";
+            if (fd != -1) {
+                close(fd);
+            }
+            ok = false;
+            break;
+        }
+        mappings.push_back(
+            {fd, ptr, segment.size, segment.numa_node, segment.id});
+    }
+
+    if (!ok) {
+        // Start over, the master drops the segments of the old client id
+        // once its lease expires
+        for (auto& mapping : mappings) {
+            munmap(mapping.base, mapping.size);
+            close(mapping.fd);
+        }
+        mappings.clear();
+        segments_ = std::move(saved);
+        Destroy();
+        return mappings;
+    }
+
+    client_id_ = saved_client_id;
+    segments_ = std::move(saved);
+    restored_ = true;
+    LOG(INFO) << "Restored " << segments_.size()
+              << " warm restart segments of " << local_hostname_;
+    return mappings;
+}
+
+std::optional<WarmRestartState::Mapping> WarmRestartState::CreateSegment(
+    size_t size, int numa_node) {
+    Segment segment;
+    segment.shm_name = shm_prefix_ + "_" + std::to_string(segments_.size());
+    segment.size = size;
+    segment.numa_node = numa_node;
+    segment.id = generate_uuid();
+
+    // Left by a state that was dropped
+    shm_unlink(segment.shm_name.c_str());
+    const int fd = shm_open(segment.shm_name.c_str(),
+                            O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        LOG(ERROR) << "Failed to create " << segment.shm_name
+                   << ", errno=" << errno << " (" << strerror(errno) << ")";
+        return std::nullopt;
+    }
+    void* ptr = nullptr;
+    if (ftruncate(fd, size) == 0) {
+        ptr = MapShm(fd, size, nullptr);
+    }
+    if (!ptr) {
+        LOG(ERROR) << "Failed to map " << segment.shm_name << " of " << size
+                   << " bytes, errno=" << errno << " (" << strerror(errno)
+                   << ")";
+        close(fd);
+        shm_unlink(segment.shm_name.c_str());
+        return std::nullopt;
+    }
+    segment.base = reinterpret_cast<uint64_t>(ptr);
+    segments_.push_back(segment);
+    return Mapping{fd, ptr, size, numa_node, segment.id};
+}
+
+bool WarmRestartState::Save() const {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    const std::string path = StatePath();
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        out << kStateHeader << "\n"
+            << local_hostname_ << "\n"
+            << client_id_.first << " " << client_id_.second << "\n"
+            << segments_.size() << "\n";
+        for (const auto& segment : segments_) {
+            out << segment.shm_name << " " << segment.base << " "
+                << segment.size << " " << segment.numa_node << " "
+                << segment.id.first << " " << segment.id.second << "\n";
+        }
+        out.flush();
+        if (!out) {
+            LOG(ERROR) << "Failed to write warm restart state " << tmp_path;
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LOG(ERROR) << "Failed to save warm restart state " << path
+                   << ", errno=" << errno << " (" << strerror(errno) << ")";
+        return false;
+    }
+    return true;
+}
+
+void WarmRestartState::Destroy() {
+    for (const auto& segment : segments_) {
+        shm_unlink(segment.shm_name.c_str());
+    }
+    segments_.clear();
+    restored_ = false;
+    std::error_code ec;
+    std::filesystem::remove(StatePath(), ec);
+}
+
+}  // namespace mooncake
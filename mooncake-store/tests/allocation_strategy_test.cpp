@@ -569,6 +569,317 @@ TEST_F(AllocationStrategyTest, PerformanceTest) {
               << "Time elapsed: " << elapsed_us.count() << " us\n\n";
 }
 
+namespace {
+
+// Count the allocated replicas per segment name
+std::unordered_map<std::string, size_t> CountBySegment(
+    const std::vector<std::vector<Replica>>& replicas) {
+    std::unordered_map<std::string, size_t> counts;
+    for (const auto& slice_replicas : replicas) {
+        for (const auto& replica : slice_replicas) {
+            counts[replica.get_descriptor()
+                       .get_memory_descriptor()
+                       .buffer_descriptor.transport_endpoint_]++;
+        }
+    }
+    return counts;
+}
+
+}  // namespace
+
+TEST(LoadAwareAllocationStrategyTest, PrefersFreeSegments) {
+    LoadAwareAllocationStrategy strategy;
+    AllocatorManager allocator_manager;
+    auto full = std::make_shared<OffsetBufferAllocator>(
+        "full", 0x100000000ULL, 64 * MiB, "full");
+    auto empty = std::make_shared<OffsetBufferAllocator>(
+        "empty", 0x200000000ULL, 64 * MiB, "empty");
+    allocator_manager.addAllocator("full", full);
+    allocator_manager.addAllocator("empty", empty);
+    auto occupied = full->allocate(48 * MiB);
+    ASSERT_NE(occupied, nullptr);
+
+    std::vector<std::vector<Replica>> replicas;
+    for (int i = 0; i < 40; i++) {
+        auto result = strategy.Allocate(allocator_manager, MiB);
+        ASSERT_TRUE(result.has_value());
+        replicas.emplace_back(std::move(result.value()));
+    }
+    auto counts = CountBySegment(replicas);
+    EXPECT_GT(counts["empty"], counts["full"]);
+}
+
+TEST(LoadAwareAllocationStrategyTest, AvoidsLoadedSegments) {
+    LoadAwareAllocationStrategy strategy;
+    AllocatorManager allocator_manager;
+    allocator_manager.addAllocator(
+        "busy", std::make_shared<OffsetBufferAllocator>("busy", 0x100000000ULL,
+                                                        64 * MiB, "busy"));
+    allocator_manager.addAllocator(
+        "idle", std::make_shared<OffsetBufferAllocator>("idle", 0x200000000ULL,
+                                                        64 * MiB, "idle"));
+    strategy.UpdateSegmentLoad("busy", 10ULL << 30);
+    strategy.UpdateSegmentLoad("idle", 1ULL << 30);
+
+    std::vector<std::vector<Replica>> replicas;
+    for (int i = 0; i < 40; i++) {
+        auto result = strategy.Allocate(allocator_manager, MiB);
+        ASSERT_TRUE(result.has_value());
+        replicas.emplace_back(std::move(result.value()));
+    }
+    auto counts = CountBySegment(replicas);
+    EXPECT_GT(counts["idle"], counts["busy"]);
+
+    // Replicas still go to distinct segments
+    auto result = strategy.Allocate(allocator_manager, MiB, 2);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(2, result.value().size());
+    EXPECT_NE(result.value()[0].get_segment_names(),
+              result.value()[1].get_segment_names());
+}
+
+TEST(LoadAwareAllocationStrategyTest, ForgetsUnmountedSegments) {
+    LoadAwareAllocationStrategy strategy;
+    strategy.UpdateSegmentLoad("a", 1000);
+    strategy.UpdateSegmentLoad("b", 3000);
+    EXPECT_DOUBLE_EQ(2000.0, strategy.MeanLoad());
+
+    strategy.RemoveSegmentLoad("b");
+    EXPECT_DOUBLE_EQ(1000.0, strategy.MeanLoad());
+    strategy.RemoveSegmentLoad("unknown");
+    EXPECT_DOUBLE_EQ(1000.0, strategy.MeanLoad());
+
+    // Reported again, e.g. by a remount
+    strategy.UpdateSegmentLoad("b", 5000);
+    EXPECT_DOUBLE_EQ(3000.0, strategy.MeanLoad());
+    strategy.RemoveSegmentLoad("a");
+    strategy.RemoveSegmentLoad("b");
+    EXPECT_DOUBLE_EQ(0.0, strategy.MeanLoad());
+}
+
+TEST(LoadAwareAllocationStrategyTest, SkipsSegmentsWithoutLargeFreeRegion) {
+    LoadAwareAllocationStrategy strategy;
+    AllocatorManager allocator_manager;
+    auto small = std::make_shared<OffsetBufferAllocator>(
+        "small", 0x100000000ULL, 16 * MiB, "small");
+    allocator_manager.addAllocator("small", small);
+    allocator_manager.addAllocator(
+        "large", std::make_shared<OffsetBufferAllocator>(
+                     "large", 0x200000000ULL, 128 * MiB, "large"));
+
+    for (int i = 0; i < 3; i++) {
+        auto result = strategy.Allocate(allocator_manager, 32 * MiB);
+        ASSERT_TRUE(result.has_value());
+        EXPECT_EQ("large", result.value()[0]
+                               .get_descriptor()
+                               .get_memory_descriptor()
+                               .buffer_descriptor.transport_endpoint_);
+    }
+    // Preferred segments are still tried first
+    auto result = strategy.Allocate(allocator_manager, MiB, 1, {"small"});
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ("small", result.value()[0]
+                           .get_descriptor()
+                           .get_memory_descriptor()
+                           .buffer_descriptor.transport_endpoint_);
+}
+
+TEST(LocalityAllocationTest, SharedLocalityDepth) {
+    EXPECT_EQ(2, SharedLocalityDepth("zone-a/rack-3/host-7",
+                                     "zone-a/rack-3/host-9"));
+    EXPECT_EQ(3, SharedLocalityDepth("zone-a/rack-3/host-7",
+                                     "zone-a/rack-3/host-7"));
+    EXPECT_EQ(1, SharedLocalityDepth("zone-a/rack-3", "zone-a/rack-30"));
+    EXPECT_EQ(1, SharedLocalityDepth("zone-a", "zone-a/rack-3"));
+    EXPECT_EQ(0, SharedLocalityDepth("zone-a/rack-3", "zone-b/rack-3"));
+    EXPECT_EQ(0, SharedLocalityDepth("", "zone-a"));
+}
+
+TEST(LocalityAllocationTest, SpreadsReplicasAcrossFailureDomains) {
+    AllocatorManager allocator_manager;
+    const std::vector<std::pair<std::string, std::string>> segments = {
+        {"a1", "zone-a/rack-1/host-1"}, {"a2", "zone-a/rack-1/host-2"},
+        {"a3", "zone-a/rack-2/host-3"}, {"b1", "zone-b/rack-3/host-4"},
+        {"b2", "zone-b/rack-3/host-5"},
+    };
+    size_t base = 0x100000000ULL;
+    for (const auto& [name, locality] : segments) {
+        allocator_manager.addAllocator(
+            name,
+            std::make_shared<OffsetBufferAllocator>(name, base, 64 * MiB, name),
+            locality);
+        base += 0x100000000ULL;
+    }
+    auto segment_of = [](const Replica& replica) {
+        return replica.get_descriptor()
+            .get_memory_descriptor()
+            .buffer_descriptor.transport_endpoint_;
+    };
+
+    RandomAllocationStrategy random_strategy;
+    LoadAwareAllocationStrategy load_aware_strategy;
+    for (AllocationStrategy* strategy :
+         {static_cast<AllocationStrategy*>(&random_strategy),
+          static_cast<AllocationStrategy*>(&load_aware_strategy)}) {
+        for (int i = 0; i < 20; i++) {
+            auto result = strategy->Allocate(allocator_manager, MiB, 3, {},
+                                             {}, "zone-a/rack-1/host-2");
+            ASSERT_TRUE(result.has_value());
+            ASSERT_EQ(3, result.value().size());
+            // The first replica is on the host of the reader, the second in
+            // the other zone and the third on the other rack of zone a.
+            EXPECT_EQ("a2", segment_of(result.value()[0]));
+            EXPECT_EQ('b', segment_of(result.value()[1])[0]);
+            EXPECT_EQ("a3", segment_of(result.value()[2]));
+        }
+    }
+
+    // Without a reader the replicas still land in different zones
+    auto result = random_strategy.Allocate(allocator_manager, MiB, 2);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(2, result.value().size());
+    EXPECT_NE(segment_of(result.value()[0])[0],
+              segment_of(result.value()[1])[0]);
+}
+
+TEST(SlabAllocationTest, RoutesMatchingSlicesToSlabs) {
+    constexpr size_t kBlockSize = 512 * 1024;
+    auto endpoint_of = [](const Replica& replica) {
+        return replica.get_descriptor()
+            .get_memory_descriptor()
+            .buffer_descriptor.transport_endpoint_;
+    };
+    RandomAllocationStrategy random_strategy;
+    LoadAwareAllocationStrategy load_aware_strategy;
+    for (AllocationStrategy* strategy :
+         std::initializer_list<AllocationStrategy*>{&random_strategy,
+                                                    &load_aware_strategy}) {
+        AllocatorManager allocator_manager;
+        for (int i = 0; i < 4; i++) {
+            const std::string name = "general_" + std::to_string(i);
+            allocator_manager.addAllocator(
+                name, std::make_shared<OffsetBufferAllocator>(
+                          name, 0x100000000ULL * (i + 1), 64 * MiB, name));
+        }
+        auto slab = std::make_shared<SlabBufferAllocator>(
+            "slab", 0x800000000ULL, 16 * kBlockSize, kBlockSize, "slab");
+        allocator_manager.addAllocator("slab", slab);
+        ASSERT_NE(allocator_manager.getSlabNames(kBlockSize), nullptr);
+        EXPECT_EQ(allocator_manager.getSlabNames(kBlockSize / 2), nullptr);
+
+        // Matching slices fill the slab segment first
+        std::vector<std::vector<Replica>> replicas;
+        for (int i = 0; i < 16; i++) {
+            auto result = strategy->Allocate(allocator_manager, kBlockSize);
+            ASSERT_TRUE(result.has_value());
+            EXPECT_EQ("slab", endpoint_of(result.value()[0]));
+            replicas.emplace_back(std::move(result.value()));
+        }
+        // Then spill over to the other segments
+        auto spilled = strategy->Allocate(allocator_manager, kBlockSize);
+        ASSERT_TRUE(spilled.has_value());
+        EXPECT_NE("slab", endpoint_of(spilled.value()[0]));
+
+        replicas.clear();
+        // Other sizes never land on the slab segment
+        for (int i = 0; i < 16; i++) {
+            auto result = strategy->Allocate(allocator_manager, MiB);
+            ASSERT_TRUE(result.has_value());
+            EXPECT_NE("slab", endpoint_of(result.value()[0]));
+        }
+        EXPECT_EQ(slab->size(), 0u);
+
+        EXPECT_TRUE(allocator_manager.removeAllocator("slab", slab));
+        EXPECT_EQ(allocator_manager.getSlabNames(kBlockSize), nullptr);
+    }
+}
+
+TEST(SplitSegmentAllocationTest, SpreadsOverAllocatorsOfOneSegment) {
+    // A client that mounted its memory as several segments
+    RandomAllocationStrategy random_strategy;
+    LoadAwareAllocationStrategy load_aware_strategy;
+    for (AllocationStrategy* strategy :
+         std::initializer_list<AllocationStrategy*>{&random_strategy,
+                                                    &load_aware_strategy}) {
+        AllocatorManager allocator_manager;
+        std::vector<std::shared_ptr<BufferAllocatorBase>> allocators;
+        for (int i = 0; i < 4; i++) {
+            allocators.push_back(std::make_shared<OffsetBufferAllocator>(
+                "host", 0x100000000ULL * (i + 1), 64 * MiB, "host"));
+            allocator_manager.addAllocator("host", allocators.back());
+        }
+        ASSERT_EQ(allocator_manager.getNames().size(), 1u);
+
+        std::vector<std::vector<Replica>> replicas;
+        for (int i = 0; i < 100; i++) {
+            auto result = strategy->Allocate(allocator_manager, MiB);
+            ASSERT_TRUE(result.has_value());
+            replicas.emplace_back(std::move(result.value()));
+        }
+        for (const auto& allocator : allocators) {
+            EXPECT_GT(allocator->size(), 0u);
+        }
+        // A slice larger than the free space of any of them fails
+        EXPECT_FALSE(
+            strategy->Allocate(allocator_manager, 64 * MiB).has_value());
+    }
+}
+
+TEST(CxlAllocationStrategyTest, PlacesLargeObjectsOnCxl) {
+    CxlAllocationStrategy strategy(
+        std::make_shared<RandomAllocationStrategy>(), "/dev/dax0.0", MiB);
+    AllocatorManager allocator_manager;
+    // Both CXL segments are windows onto the same device allocator
+    auto cxl = std::make_shared<OffsetBufferAllocator>(
+        "/dev/dax0.0", DEFAULT_CXL_BASE, 64 * MiB, "/dev/dax0.0");
+    allocator_manager.addAllocator("cxl_host_a", cxl);
+    allocator_manager.addAllocator("cxl_host_b", cxl);
+    allocator_manager.addAllocator(
+        "dram", std::make_shared<OffsetBufferAllocator>(
+                    "dram", 0x300000000ULL, 4 * MiB, "dram"));
+
+    auto endpoint_of = [](const Replica& replica) {
+        return replica.get_descriptor()
+            .get_memory_descriptor()
+            .buffer_descriptor.transport_endpoint_;
+    };
+    auto protocol_of = [](const Replica& replica) {
+        return replica.get_descriptor()
+            .get_memory_descriptor()
+            .buffer_descriptor.protocol_;
+    };
+
+    // Small objects stay in DRAM
+    auto small = strategy.Allocate(allocator_manager, 64 * 1024);
+    ASSERT_TRUE(small.has_value());
+    ASSERT_EQ(1, small.value().size());
+    EXPECT_EQ("dram", endpoint_of(small.value()[0]));
+
+    // Large objects go to the preferred CXL segment, further replicas to DRAM
+    auto large =
+        strategy.Allocate(allocator_manager, 2 * MiB, 2, {"cxl_host_b"});
+    ASSERT_TRUE(large.has_value());
+    ASSERT_EQ(2, large.value().size());
+    EXPECT_EQ("cxl_host_b", endpoint_of(large.value()[0]));
+    EXPECT_EQ("cxl", protocol_of(large.value()[0]));
+    EXPECT_EQ("dram", endpoint_of(large.value()[1]));
+
+    // Small objects spill over to CXL once DRAM is full
+    auto filler = strategy.Allocate(allocator_manager, MiB - 1, 1, {"dram"});
+    ASSERT_TRUE(filler.has_value());
+    std::vector<std::vector<Replica>> spilled;
+    for (int i = 0; i < 4; i++) {
+        auto result = strategy.Allocate(allocator_manager, MiB - 1);
+        ASSERT_TRUE(result.has_value());
+        spilled.emplace_back(std::move(result.value()));
+    }
+    EXPECT_EQ("cxl", protocol_of(spilled.back()[0]));
+
+    auto from = strategy.AllocateFrom(allocator_manager, MiB, "cxl_host_a");
+    ASSERT_TRUE(from.has_value());
+    EXPECT_EQ("cxl_host_a", endpoint_of(from.value()));
+}
+
 // Note: The following unit tests for internal helper methods have been removed
 // because those methods (allocateSingleBuffer, tryRandomAllocate,
 // allocateSlice, resetRetryCount, getRetryCount) are no longer part of the
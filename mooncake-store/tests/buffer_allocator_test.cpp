@@ -146,6 +146,38 @@ TEST_F(BufferAllocatorTest, RepeatAllocateAndDeallocate) {
     }
 }
 
+// Test freeing buffers of several allocators in one batch
+TEST_F(BufferAllocatorTest, DeallocateBatch) {
+    for (const auto& allocator_type : allocator_types_) {
+        size_t size = 1024 * 1024 * 16;  // 16MB (must be multiple of 4MB)
+        auto allocator1 = CreateTestAllocator("1", 0, size, allocator_type);
+        auto allocator2 = CreateTestAllocator("2", 0x20000000ULL, size,
+                                              allocator_type);
+
+        size_t alloc_size = 1024 * 1024;
+        std::vector<std::unique_ptr<AllocatedBuffer>> buffers;
+        for (int i = 0; i < 4; ++i) {
+            buffers.push_back(allocator1->allocate(alloc_size));
+            buffers.push_back(allocator2->allocate(alloc_size));
+            ASSERT_NE(buffers[buffers.size() - 2], nullptr);
+            ASSERT_NE(buffers.back(), nullptr);
+        }
+        EXPECT_EQ(allocator1->size(), 4 * alloc_size);
+        EXPECT_EQ(allocator2->size(), 4 * alloc_size);
+
+        AllocatedBuffer::DeallocateBatch(std::move(buffers));
+        EXPECT_TRUE(buffers.empty());
+        EXPECT_EQ(allocator1->size(), 0u);
+        EXPECT_EQ(allocator2->size(), 0u);
+
+        // The freed space can be allocated again
+        for (int i = 0; i < 8; ++i) {
+            buffers.push_back(allocator1->allocate(alloc_size));
+            ASSERT_NE(buffers.back(), nullptr);
+        }
+    }
+}
+
 // Test parallel allocation and deallocation
 TEST_F(BufferAllocatorTest, ParallelAllocation) {
     for (const auto& allocator_type : allocator_types_) {
@@ -190,6 +222,121 @@ TEST_F(BufferAllocatorTest, ParallelAllocation) {
     }
 }
 
+// Test that a slab allocator hands out whole blocks of one size only
+TEST_F(BufferAllocatorTest, SlabAllocateBlocks) {
+    const size_t base = 0x100000000ULL;
+    const size_t block_size = 256 * 1024;
+    // The tail shorter than a block is not used
+    auto allocator = std::make_shared<SlabBufferAllocator>(
+        "slab", base, 4 * block_size + 1000, block_size, "slab");
+    EXPECT_EQ(allocator->capacity(), 4 * block_size);
+    EXPECT_EQ(allocator->getBlockSize(), block_size);
+
+    EXPECT_EQ(allocator->allocate(block_size - 1), nullptr);
+    EXPECT_EQ(allocator->allocate(block_size + 1), nullptr);
+
+    std::vector<std::unique_ptr<AllocatedBuffer>> buffers;
+    for (int i = 0; i < 4; ++i) {
+        buffers.push_back(allocator->allocate(block_size));
+        ASSERT_NE(buffers.back(), nullptr);
+        VerifyAllocatedBuffer(*buffers.back(), block_size, "slab", "slab");
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buffers.back()->data()),
+                  base + i * block_size);
+    }
+    EXPECT_EQ(allocator->size(), 4 * block_size);
+    EXPECT_EQ(allocator->getLargestFreeRegion(), 0u);
+    EXPECT_EQ(allocator->allocate(block_size), nullptr);
+
+    // The last freed block is reused first
+    void* freed = buffers[1]->data();
+    buffers[1].reset();
+    EXPECT_EQ(allocator->getLargestFreeRegion(), block_size);
+    buffers[1] = allocator->allocate(block_size);
+    ASSERT_NE(buffers[1], nullptr);
+    EXPECT_EQ(buffers[1]->data(), freed);
+
+    AllocatedBuffer::DeallocateBatch(std::move(buffers));
+    EXPECT_EQ(allocator->size(), 0u);
+}
+
+// Test re-claiming slab blocks at fixed addresses
+TEST_F(BufferAllocatorTest, SlabReserve) {
+    const size_t base = 0x100000000ULL;
+    const size_t block_size = 64 * 1024;
+    auto allocator = std::make_shared<SlabBufferAllocator>(
+        "slab", base, 8 * block_size, block_size, "slab");
+
+    auto reserved = allocator->reserve(base + 3 * block_size, block_size);
+    ASSERT_NE(reserved, nullptr);
+    EXPECT_EQ(allocator->size(), block_size);
+    // Taken, unaligned, partial or out of range blocks are refused
+    EXPECT_EQ(allocator->reserve(base + 3 * block_size, block_size), nullptr);
+    EXPECT_EQ(allocator->reserve(base + 100, block_size), nullptr);
+    EXPECT_EQ(allocator->reserve(base, block_size / 2), nullptr);
+    EXPECT_EQ(allocator->reserve(base + 8 * block_size, block_size), nullptr);
+
+    // Allocation skips the reserved block
+    std::vector<std::unique_ptr<AllocatedBuffer>> buffers;
+    while (auto buffer = allocator->allocate(block_size)) {
+        EXPECT_NE(buffer->data(), reserved->data());
+        buffers.push_back(std::move(buffer));
+    }
+    EXPECT_EQ(buffers.size(), 7u);
+
+    reserved.reset();
+    EXPECT_NE(allocator->allocate(block_size), nullptr);
+    EXPECT_THROW(SlabBufferAllocator("slab", base, block_size, 2 * block_size,
+                                     "slab"),
+                 std::invalid_argument);
+}
+
+// Test the free space reported by getStats
+TEST_F(BufferAllocatorTest, AllocatorStats) {
+    const size_t base = 0x100000000ULL;
+    const size_t block_size = 1024 * 1024;
+    auto allocator = std::make_shared<OffsetBufferAllocator>(
+        "offset", base, 8 * block_size, "offset");
+    AllocatorStats stats = allocator->getStats();
+    EXPECT_EQ(stats.capacity, 8 * block_size);
+    EXPECT_EQ(stats.allocated, 0u);
+    EXPECT_EQ(stats.free, 8 * block_size);
+    EXPECT_EQ(stats.free_regions, 1u);
+    EXPECT_DOUBLE_EQ(stats.fragmentation, 0.0);
+
+    std::vector<std::unique_ptr<AllocatedBuffer>> buffers;
+    for (int i = 0; i < 8; ++i) {
+        buffers.push_back(allocator->allocate(block_size));
+        ASSERT_NE(buffers.back(), nullptr);
+    }
+    // Every other block free leaves no room for two blocks in a row
+    for (int i = 0; i < 8; i += 2) {
+        buffers[i].reset();
+    }
+    stats = allocator->getStats();
+    EXPECT_EQ(stats.allocated, 4 * block_size);
+    EXPECT_EQ(stats.free, 4 * block_size);
+    EXPECT_EQ(stats.free_regions, 4u);
+    EXPECT_EQ(stats.largest_free_region, block_size);
+    EXPECT_DOUBLE_EQ(stats.fragmentation, 0.75);
+
+    buffers.clear();
+    stats = allocator->getStats();
+    EXPECT_EQ(stats.free_regions, 1u);
+    EXPECT_DOUBLE_EQ(stats.fragmentation, 0.0);
+
+    // Slab blocks are interchangeable and never fragment
+    auto slab = std::make_shared<SlabBufferAllocator>(
+        "slab", base, 4 * block_size, block_size, "slab");
+    auto buffer = slab->allocate(block_size);
+    ASSERT_NE(buffer, nullptr);
+    stats = slab->getStats();
+    EXPECT_EQ(stats.allocated, block_size);
+    EXPECT_EQ(stats.free, 3 * block_size);
+    EXPECT_EQ(stats.free_regions, 3u);
+    EXPECT_EQ(stats.largest_free_region, block_size);
+    EXPECT_DOUBLE_EQ(stats.fragmentation, 0.0);
+}
+
 // Test fixture for SimpleAllocator tests
 class SimpleAllocatorTest : public ::testing::Test {
    protected:
@@ -0,0 +1,102 @@
+#include "bundle_index.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+TEST(BundleIndexTest, LinkAndUnlink) {
+    BundleIndex index;
+    EXPECT_TRUE(index.empty());
+    const std::string bundle =
+        std::string(BundleIndex::kBundleKeyPrefix) + "request_1";
+    EXPECT_TRUE(BundleIndex::IsBundleKey(bundle));
+    EXPECT_FALSE(BundleIndex::IsBundleKey("page_0"));
+
+    bool inserted = false;
+    ASSERT_EQ(ErrorCode::OK,
+              index.Link(bundle, {"page_0", "page_1", "page_2"}, {4, 8, 16},
+                         inserted));
+    EXPECT_TRUE(inserted);
+    // Linking the same ranges again does nothing
+    EXPECT_EQ(ErrorCode::OK,
+              index.Link(bundle, {"page_0", "page_1", "page_2"}, {4, 8, 16},
+                         inserted));
+    EXPECT_FALSE(inserted);
+    // A key of another bundle fails the whole link
+    EXPECT_EQ(ErrorCode::OBJECT_ALREADY_EXISTS,
+              index.Link(bundle + "x", {"page_3", "page_2"}, {4, 4},
+                         inserted));
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(std::nullopt, index.Resolve("page_3"));
+
+    auto member = index.Resolve("page_2");
+    ASSERT_TRUE(member.has_value());
+    EXPECT_EQ(bundle, member->bundle_key);
+    EXPECT_EQ(12u, member->offset);
+    EXPECT_EQ(16u, member->size);
+    EXPECT_EQ(3u, index.GetStats().member_keys);
+    EXPECT_EQ(1u, index.GetStats().bundles);
+
+    std::optional<std::string> orphaned;
+    EXPECT_TRUE(index.Unlink("page_0", orphaned));
+    EXPECT_EQ(std::nullopt, orphaned);
+    EXPECT_FALSE(index.Unlink("page_0", orphaned));
+
+    std::vector<std::string> orphans;
+    EXPECT_EQ(2u, index.UnlinkIf(
+                      [](const std::string& key) {
+                          return key.starts_with("page_");
+                      },
+                      orphans));
+    EXPECT_EQ(std::vector<std::string>{bundle}, orphans);
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ(0u, index.GetStats().bundles);
+}
+
+TEST(BundleIndexTest, Drop) {
+    BundleIndex index;
+    const std::string first = std::string(BundleIndex::kBundleKeyPrefix) + "1";
+    const std::string second = std::string(BundleIndex::kBundleKeyPrefix) + "2";
+    bool inserted = false;
+    ASSERT_EQ(ErrorCode::OK, index.Link(first, {"a", "b"}, {1, 1}, inserted));
+    ASSERT_EQ(ErrorCode::OK, index.Link(second, {"c"}, {1}, inserted));
+
+    std::optional<std::string> orphaned;
+    ASSERT_TRUE(index.Unlink("a", orphaned));
+    EXPECT_EQ(1u, index.Drop(first));
+    EXPECT_EQ(0u, index.Drop(first));
+    EXPECT_EQ(std::nullopt, index.Resolve("b"));
+    EXPECT_TRUE(index.Resolve("c").has_value());
+    EXPECT_EQ(1u, index.GetStats().member_keys);
+    EXPECT_EQ(1u, index.GetStats().bundles);
+
+    // A bundle linked again under the key of a dropped one is its own
+    ASSERT_EQ(ErrorCode::OK, index.Link(second, {"d"}, {1}, inserted));
+    EXPECT_EQ(2u, index.Drop(second));
+    ASSERT_EQ(ErrorCode::OK, index.Link(second, {"e"}, {1}, inserted));
+    EXPECT_EQ(1u, index.GetStats().bundles);
+}
+
+TEST(BundleIndexTest, UnlinkFrom) {
+    BundleIndex index;
+    const std::string first = std::string(BundleIndex::kBundleKeyPrefix) + "1";
+    const std::string second = std::string(BundleIndex::kBundleKeyPrefix) + "2";
+    bool inserted = false;
+    ASSERT_EQ(ErrorCode::OK, index.Link(first, {"a", "b"}, {1, 1}, inserted));
+    ASSERT_EQ(ErrorCode::OK, index.Link(second, {"c"}, {1}, inserted));
+
+    // Keys of other bundles are left alone
+    std::optional<std::string> orphaned;
+    EXPECT_EQ(1u, index.UnlinkFrom(first, {"a", "c", "x"}, orphaned));
+    EXPECT_EQ(std::nullopt, orphaned);
+    EXPECT_TRUE(index.Resolve("c").has_value());
+    EXPECT_EQ(1u, index.UnlinkFrom(first, {"a", "b"}, orphaned));
+    EXPECT_EQ(first, orphaned);
+    EXPECT_EQ(1u, index.GetStats().member_keys);
+    EXPECT_EQ(1u, index.GetStats().bundles);
+}
+
+}  // namespace mooncake::test
@@ -287,6 +287,122 @@ TEST_F(ClientBufferTest, MemoryExhaustion) {
     EXPECT_TRUE(new_handle_opt.has_value());
 }
 
+// Freed small blocks are reused from the arena cache
+TEST_F(ClientBufferTest, ArenaCacheReuse) {
+    ClientBufferArenaConfig config;
+    config.cache_bytes = 256 * 1024;
+    auto allocator =
+        ClientBufferAllocator::create(4 * 1024 * 1024, "", false, config);
+    ASSERT_NE(allocator, nullptr);
+
+    void* first_ptr = nullptr;
+    {
+        auto handle = allocator->allocate(5000);
+        ASSERT_TRUE(handle.has_value());
+        VerifyBufferHandle(handle.value(), 5000);
+        first_ptr = handle->ptr();
+    }
+    auto stats = allocator->GetStats();
+    EXPECT_EQ(stats.cache_misses, 1);
+    EXPECT_EQ(stats.cached_bytes, 5 * 1024);  // rounded up to its class
+
+    // Same class, different size
+    auto handle = allocator->allocate(4500);
+    ASSERT_TRUE(handle.has_value());
+    EXPECT_EQ(handle->ptr(), first_ptr);
+    EXPECT_EQ(handle->size(), 4500);
+    stats = allocator->GetStats();
+    EXPECT_EQ(stats.cache_hits, 1);
+    EXPECT_EQ(stats.cached_bytes, 0);
+
+    // Large blocks bypass the caches
+    {
+        auto large =
+            allocator->allocate(ClientBufferAllocator::kMaxCachedSize + 1);
+        ASSERT_TRUE(large.has_value());
+    }
+    EXPECT_EQ(allocator->GetStats().cached_bytes, 0);
+
+    // A moved-from handle gives nothing back
+    BufferHandle moved(std::move(handle.value()));
+    EXPECT_EQ(handle->size(), 0);
+    handle.reset();
+    EXPECT_EQ(allocator->GetStats().cached_bytes, 0);
+}
+
+// Cached blocks are given back when the buffer runs out
+TEST_F(ClientBufferTest, ArenaCacheFlushOnExhaustion) {
+    const size_t buffer_size = 64 * 1024;
+    ClientBufferArenaConfig config;
+    config.cache_bytes = buffer_size;
+    auto allocator =
+        ClientBufferAllocator::create(buffer_size, "", false, config);
+    ASSERT_NE(allocator, nullptr);
+
+    {
+        std::vector<BufferHandle> handles;
+        for (int i = 0; i < 8; ++i) {
+            auto handle = allocator->allocate(8 * 1024);
+            ASSERT_TRUE(handle.has_value());
+            handles.push_back(std::move(handle.value()));
+        }
+        EXPECT_FALSE(allocator->allocate(8 * 1024).has_value());
+    }
+    EXPECT_EQ(allocator->GetStats().cached_bytes, buffer_size);
+
+    // Another class only fits once the cache is flushed
+    auto handle = allocator->allocate(32 * 1024);
+    ASSERT_TRUE(handle.has_value());
+    EXPECT_EQ(allocator->GetStats().cached_bytes, 0);
+}
+
+// Threads allocating and freeing small blocks concurrently
+TEST_F(ClientBufferTest, ArenaCacheMultiThreaded) {
+    ClientBufferArenaConfig config;
+    config.cache_bytes = 1024 * 1024;
+    config.arenas = 4;
+    auto allocator =
+        ClientBufferAllocator::create(64 * 1024 * 1024, "", false, config);
+    ASSERT_NE(allocator, nullptr);
+
+    constexpr int kThreads = 8;
+    constexpr int kIterations = 2000;
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            std::vector<BufferHandle> held;
+            for (int i = 0; i < kIterations; ++i) {
+                const size_t size = 1024 + ((i * 7919 + t) % 64) * 1024;
+                auto handle = allocator->allocate(size);
+                if (!handle.has_value()) {
+                    failures++;
+                    continue;
+                }
+                std::memset(handle->ptr(), t, size);
+                held.push_back(std::move(handle.value()));
+                if (held.size() > 16) {
+                    held.erase(held.begin(), held.begin() + 8);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+
+    auto stats = allocator->GetStats();
+    EXPECT_EQ(stats.cache_hits + stats.cache_misses, kThreads * kIterations);
+    EXPECT_GT(stats.cache_hits, 0);
+    EXPECT_LE(stats.cached_bytes, config.cache_bytes * config.arenas);
+
+    allocator->FlushCaches();
+    EXPECT_EQ(allocator->GetStats().cached_bytes, 0);
+    // Everything is back: the whole buffer fits in one piece again
+    EXPECT_TRUE(allocator->allocate(32 * 1024 * 1024).has_value());
+}
+
 // Test calculate_total_size function with memory replica
 TEST_F(ClientBufferTest, CalculateTotalSizeMemoryReplica) {
     // Create a memory replica descriptor
@@ -2,6 +2,9 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <async_simple/coro/Collect.h>
+#include <async_simple/coro/SyncAwait.h>
+
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -340,6 +343,56 @@ TEST_F(ClientIntegrationTest, BasicPutGetOperations) {
     client_buffer_allocator_->deallocate(buffer, test_data.size());
 }
 
+// Puts and gets many objects concurrently as coroutines from one thread
+TEST_F(ClientIntegrationTest, CoroutinePutGetOperations) {
+    constexpr size_t kObjects = 32;
+    constexpr size_t kSize = 4096;
+    std::vector<void*> buffers;
+    std::vector<std::vector<Slice>> slices(kObjects);
+    for (size_t i = 0; i < kObjects; ++i) {
+        void* buffer = client_buffer_allocator_->allocate(kSize);
+        memset(buffer, static_cast<int>('a' + i % 26), kSize);
+        buffers.push_back(buffer);
+        slices[i].emplace_back(Slice{buffer, kSize});
+    }
+    ReplicateConfig config;
+    config.replica_num = 1;
+
+    std::vector<async_simple::coro::Lazy<tl::expected<void, ErrorCode>>> puts;
+    for (size_t i = 0; i < kObjects; ++i) {
+        puts.push_back(test_client_->CoroPut("coro_key_" + std::to_string(i),
+                                             slices[i], config));
+    }
+    auto put_results = async_simple::coro::syncAwait(
+        async_simple::coro::collectAll(std::move(puts)));
+    for (auto& result : put_results) {
+        ASSERT_TRUE(result.value().has_value())
+            << "CoroPut failed: " << toString(result.value().error());
+    }
+
+    std::vector<async_simple::coro::Lazy<tl::expected<void, ErrorCode>>> gets;
+    for (size_t i = 0; i < kObjects; ++i) {
+        memset(buffers[i], 0, kSize);
+        gets.push_back(
+            test_client_->CoroGet("coro_key_" + std::to_string(i), slices[i]));
+    }
+    auto get_results = async_simple::coro::syncAwait(
+        async_simple::coro::collectAll(std::move(gets)));
+    for (size_t i = 0; i < kObjects; ++i) {
+        ASSERT_TRUE(get_results[i].value().has_value())
+            << "CoroGet failed: " << toString(get_results[i].value().error());
+        std::string expected(kSize, static_cast<char>('a' + i % 26));
+        EXPECT_EQ(memcmp(buffers[i], expected.data(), kSize), 0);
+    }
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(default_kv_lease_ttl_));
+    for (size_t i = 0; i < kObjects; ++i) {
+        test_client_->Remove("coro_key_" + std::to_string(i));
+        client_buffer_allocator_->deallocate(buffers[i], kSize);
+    }
+}
+
 // Test Remove operation
 TEST_F(ClientIntegrationTest, RemoveOperation) {
     const std::string test_data = "Test data for removal";
@@ -563,6 +616,120 @@ TEST_F(ClientIntegrationTest, LargeAllocateTest) {
         << "Remove operation failed: " << toString(remove_result.error());
 }
 
+// A large object with several remote replicas is read from all of them
+TEST_F(ClientIntegrationTest, ParallelReadFromAllReplicas) {
+    const size_t data_size = 4 * 1024 * 1024;  // 4MB
+    const size_t kNumBuffers = 4;
+    const std::string key = "parallel_read_key";
+
+    // One replica on each mounted segment
+    ReplicateConfig config;
+    config.replica_num = 2;
+    std::vector<void*> buffers(kNumBuffers);
+    std::vector<Slice> slices;
+    for (size_t i = 0; i < kNumBuffers; ++i) {
+        buffers[i] = client_buffer_allocator_->allocate(data_size);
+        ASSERT_NE(buffers[i], nullptr);
+        memset(buffers[i], 'A' + i, data_size);
+        slices.emplace_back(Slice{buffers[i], data_size});
+    }
+    auto put_result = test_client_->Put(key, slices, config);
+    ASSERT_TRUE(put_result.has_value())
+        << "Put operation failed: " << toString(put_result.error());
+    auto query_result = test_client_->Query(key);
+    ASSERT_TRUE(query_result.has_value());
+    ASSERT_EQ(query_result.value().replicas.size(), 2);
+
+    // Both replicas are remote to a client without a segment
+    auto reader = CreateClient("localhost:17814");
+    ASSERT_TRUE(reader != nullptr);
+    const size_t total_size = data_size * kNumBuffers;
+    void* read_buffer = allocate_buffer_allocator_memory(total_size);
+    ASSERT_NE(read_buffer, nullptr);
+    ASSERT_TRUE(reader
+                    ->RegisterLocalMemory(read_buffer, total_size, "cpu:0",
+                                          false, false)
+                    .has_value());
+
+    // Slices of uneven sizes, cut at the part boundaries
+    std::vector<Slice> read_slices = {
+        {read_buffer, data_size - 1},
+        {static_cast<char*>(read_buffer) + data_size - 1,
+         total_size - data_size + 1}};
+    auto get_result = reader->Get(key, read_slices);
+    ASSERT_TRUE(get_result.has_value())
+        << "Get operation failed: " << toString(get_result.error());
+    for (size_t i = 0; i < kNumBuffers; ++i) {
+        std::string expected_data(data_size, 'A' + i);
+        EXPECT_EQ(memcmp(static_cast<char*>(read_buffer) + i * data_size,
+                         expected_data.data(), data_size),
+                  0);
+    }
+
+    ASSERT_TRUE(reader->unregisterLocalMemory(read_buffer, false).has_value());
+    reader.reset();
+    free(read_buffer);
+    for (size_t i = 0; i < kNumBuffers; ++i) {
+        client_buffer_allocator_->deallocate(buffers[i], data_size);
+    }
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(default_kv_lease_ttl_));
+    auto remove_result = test_client_->Remove(key);
+    ASSERT_TRUE(remove_result.has_value())
+        << "Remove operation failed: " << toString(remove_result.error());
+}
+
+// Hedged reads go through staging buffers and still return the object
+TEST_F(ClientIntegrationTest, HedgedReadsReturnTheObject) {
+    const size_t data_size = 64 * 1024;
+    const std::string key = "hedged_read_key";
+
+    ReplicateConfig config;
+    config.replica_num = 2;
+    void* buffer = client_buffer_allocator_->allocate(data_size);
+    ASSERT_NE(buffer, nullptr);
+    for (size_t i = 0; i < data_size; ++i) {
+        static_cast<char*>(buffer)[i] = static_cast<char>(i * 7);
+    }
+    std::vector<Slice> slices = {{buffer, data_size}};
+    auto put_result = test_client_->Put(key, slices, config);
+    ASSERT_TRUE(put_result.has_value())
+        << "Put operation failed: " << toString(put_result.error());
+
+    // Both replicas are remote to a client without a segment
+    setenv("MC_STORE_HEDGED_READ_PERCENTILE", "50", 1);
+    auto reader = CreateClient("localhost:17815");
+    unsetenv("MC_STORE_HEDGED_READ_PERCENTILE");
+    ASSERT_TRUE(reader != nullptr);
+    void* read_buffer = allocate_buffer_allocator_memory(data_size);
+    ASSERT_NE(read_buffer, nullptr);
+    ASSERT_TRUE(reader
+                    ->RegisterLocalMemory(read_buffer, data_size, "cpu:0",
+                                          false, false)
+                    .has_value());
+
+    // Enough reads for the delay to be set, half of them then get hedged
+    for (size_t round = 0; round < 2 * LatencyPercentile::kRecomputeInterval;
+         ++round) {
+        memset(read_buffer, 0, data_size);
+        std::vector<Slice> read_slices = {{read_buffer, data_size}};
+        auto get_result = reader->Get(key, read_slices);
+        ASSERT_TRUE(get_result.has_value())
+            << "Get operation failed: " << toString(get_result.error());
+        ASSERT_EQ(memcmp(read_buffer, buffer, data_size), 0);
+    }
+
+    ASSERT_TRUE(reader->unregisterLocalMemory(read_buffer, false).has_value());
+    reader.reset();
+    free(read_buffer);
+    client_buffer_allocator_->deallocate(buffer, data_size);
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(default_kv_lease_ttl_));
+    auto remove_result = test_client_->Remove(key);
+    ASSERT_TRUE(remove_result.has_value())
+        << "Remove operation failed: " << toString(remove_result.error());
+}
+
 // Test batch Put/Get operations through the client
 TEST_F(ClientIntegrationTest, BatchPutGetOperations) {
     int batch_sz = 100;
@@ -875,6 +1042,83 @@ TEST_F(ClientIntegrationTest, BatchPutDuplicateKeys) {
     ASSERT_TRUE(remove_result);
 }
 
+// A batch put in sub-batches reports the failures of the middle one and
+// still writes every other key
+TEST_F(ClientIntegrationTest, PipelinedBatchPutOperations) {
+    const size_t kBatchSize = 20;
+    const size_t kPipelineSize = 8;
+    const size_t data_size = 4096;
+    // Empty keys fail PutStart, both in the second sub-batch
+    const std::unordered_set<size_t> failing = {9, 12};
+
+    setenv("MC_STORE_BATCH_PUT_PIPELINE_SIZE",
+           std::to_string(kPipelineSize).c_str(), 1);
+    auto writer = CreateClient("localhost:17816");
+    unsetenv("MC_STORE_BATCH_PUT_PIPELINE_SIZE");
+    ASSERT_TRUE(writer != nullptr);
+    void* write_buffer =
+        allocate_buffer_allocator_memory(kBatchSize * data_size);
+    ASSERT_NE(write_buffer, nullptr);
+    ASSERT_TRUE(writer
+                    ->RegisterLocalMemory(write_buffer, kBatchSize * data_size,
+                                          "cpu:0", false, false)
+                    .has_value());
+
+    std::vector<std::string> keys;
+    std::vector<std::vector<Slice>> batched_slices;
+    for (size_t i = 0; i < kBatchSize; ++i) {
+        keys.push_back(failing.count(i)
+                           ? std::string()
+                           : "test_key_pipelined_put_" + std::to_string(i));
+        char* data = static_cast<char*>(write_buffer) + i * data_size;
+        memset(data, 'a' + i % 26, data_size);
+        batched_slices.push_back({Slice{data, data_size}});
+    }
+    ReplicateConfig config;
+    config.replica_num = 1;
+    auto batch_put_results = writer->BatchPut(keys, batched_slices, config);
+    ASSERT_EQ(batch_put_results.size(), kBatchSize);
+    for (size_t i = 0; i < kBatchSize; ++i) {
+        if (failing.count(i)) {
+            ASSERT_FALSE(batch_put_results[i].has_value())
+                << "Put of an empty key succeeded at " << i;
+            EXPECT_EQ(batch_put_results[i].error(),
+                      ErrorCode::INVALID_PARAMS);
+        } else {
+            ASSERT_TRUE(batch_put_results[i].has_value())
+                << "BatchPut failed for key " << keys[i] << ": "
+                << toString(batch_put_results[i].error());
+        }
+    }
+
+    for (size_t i = 0; i < kBatchSize; ++i) {
+        if (failing.count(i)) continue;
+        void* target_buffer = client_buffer_allocator_->allocate(data_size);
+        ASSERT_NE(target_buffer, nullptr);
+        std::vector<Slice> slices = {{target_buffer, data_size}};
+        auto get_result = test_client_->Get(keys[i], slices);
+        ASSERT_TRUE(get_result.has_value())
+            << "Get operation failed for key " << keys[i] << ": "
+            << toString(get_result.error());
+        std::string expected_data(data_size, 'a' + i % 26);
+        EXPECT_EQ(memcmp(target_buffer, expected_data.data(), data_size), 0)
+            << "Data mismatch for key " << keys[i];
+        client_buffer_allocator_->deallocate(target_buffer, data_size);
+    }
+
+    ASSERT_TRUE(writer->unregisterLocalMemory(write_buffer, false).has_value());
+    writer.reset();
+    free(write_buffer);
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(default_kv_lease_ttl_));
+    for (size_t i = 0; i < kBatchSize; ++i) {
+        if (failing.count(i)) continue;
+        auto remove_result = test_client_->Remove(keys[i]);
+        ASSERT_TRUE(remove_result.has_value())
+            << "Remove operation failed: " << toString(remove_result.error());
+    }
+}
+
 // Test BatchReplicaClear operations through the client
 TEST_F(ClientIntegrationTest, BatchReplicaClearOperations) {
     // Skip test if we couldn't capture client_id
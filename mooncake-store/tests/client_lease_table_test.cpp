@@ -0,0 +1,69 @@
+#include "client_lease_table.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+namespace mooncake::test {
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+TEST(ClientLeaseTableTest, ExpiresClientsThatStopPinging) {
+    auto now = ClientLeaseTable::Clock::now();
+    ClientLeaseTable leases(seconds(10), seconds(1), now);
+    UUID alive{1, 1};
+    UUID dead{2, 2};
+    EXPECT_FALSE(leases.Renew(alive, now));
+    EXPECT_FALSE(leases.Renew(dead, now));
+    EXPECT_EQ(2u, leases.Size());
+
+    std::vector<UUID> expired;
+    for (int i = 1; i <= 20; i++) {
+        now += seconds(1);
+        leases.Renew(alive, now);
+        leases.Expire(now, expired);
+        if (i < 10) {
+            EXPECT_TRUE(expired.empty()) << i;
+        }
+    }
+    ASSERT_EQ(1u, expired.size());
+    EXPECT_EQ(dead, expired[0]);
+    EXPECT_EQ(1u, leases.Size());
+}
+
+TEST(ClientLeaseTableTest, TracksOkStatus) {
+    auto now = ClientLeaseTable::Clock::now();
+    ClientLeaseTable leases(seconds(5), seconds(1), now);
+    UUID client{3, 4};
+    EXPECT_FALSE(leases.SetOk(client));  // no lease yet
+    EXPECT_FALSE(leases.Renew(client, now));
+    EXPECT_FALSE(leases.IsOk(client));
+    EXPECT_TRUE(leases.SetOk(client));
+    EXPECT_FALSE(leases.SetOk(client));
+    EXPECT_TRUE(leases.Renew(client, now));
+    EXPECT_TRUE(leases.IsOk(client));
+
+    std::vector<UUID> expired;
+    EXPECT_EQ(1u, leases.Expire(now + seconds(7), expired));
+    ASSERT_EQ(1u, expired.size());
+    EXPECT_FALSE(leases.IsOk(client));
+
+    // A ping after expiry starts a new lease, the client has to remount
+    EXPECT_FALSE(leases.Renew(client, now + seconds(8)));
+}
+
+TEST(ClientLeaseTableTest, CatchesUpAfterStall) {
+    auto now = ClientLeaseTable::Clock::now();
+    ClientLeaseTable leases(seconds(3), milliseconds(100), now);
+    for (uint64_t i = 0; i < 100; i++) {
+        leases.Renew({i, i}, now + milliseconds(i * 10));
+    }
+    std::vector<UUID> expired;
+    EXPECT_EQ(0u, leases.Expire(now + seconds(60), expired));
+    EXPECT_EQ(100u, expired.size());
+    EXPECT_EQ(0u, leases.Size());
+}
+
+}  // namespace mooncake::test
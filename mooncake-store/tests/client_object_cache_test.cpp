@@ -0,0 +1,110 @@
+#include "client_object_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+Replica::Descriptor MakeReplica(ReplicaID id, uint64_t size) {
+    Replica::Descriptor desc;
+    desc.id = id;
+    desc.status = ReplicaStatus::COMPLETE;
+    MemoryDescriptor mem;
+    mem.buffer_descriptor.size_ = size;
+    desc.descriptor_variant = mem;
+    return desc;
+}
+
+std::vector<Slice> MakeSlices(std::string& data, size_t split) {
+    return {Slice{data.data(), split},
+            Slice{data.data() + split, data.size() - split}};
+}
+
+}  // namespace
+
+TEST(ClientObjectCacheTest, ServesMatchingReplica) {
+    ClientObjectCache cache(1024, 256);
+    ASSERT_TRUE(cache.enabled());
+
+    std::string data(100, 'a');
+    auto slices = MakeSlices(data, 30);
+    const std::vector<Replica::Descriptor> replicas = {MakeReplica(1, 100)};
+    cache.Put("key", replicas, slices);
+    EXPECT_EQ(1, cache.size());
+
+    std::string out(100, 'x');
+    auto out_slices = MakeSlices(out, 60);
+    ASSERT_TRUE(cache.Read("key", replicas, out_slices));
+    EXPECT_EQ(data, out);
+
+    // Another replica of the same object was added
+    const std::vector<Replica::Descriptor> more = {MakeReplica(2, 100),
+                                                   MakeReplica(1, 100)};
+    EXPECT_TRUE(cache.Read("key", more, out_slices));
+
+    // The object was put again
+    const std::vector<Replica::Descriptor> replaced = {MakeReplica(3, 100)};
+    EXPECT_FALSE(cache.Read("key", replaced, out_slices));
+    EXPECT_EQ(0, cache.size());
+}
+
+TEST(ClientObjectCacheTest, EvictsLeastRecentlyUsed) {
+    // Room for two of the objects only
+    constexpr size_t kSize = 400 * 1024;
+    ClientObjectCache cache(1024 * 1024, kSize);
+    std::string a(kSize, 'a'), b(kSize, 'b'), c(kSize, 'c');
+    const std::vector<Replica::Descriptor> ra = {MakeReplica(1, kSize)};
+    const std::vector<Replica::Descriptor> rb = {MakeReplica(2, kSize)};
+    const std::vector<Replica::Descriptor> rc = {MakeReplica(3, kSize)};
+    cache.Put("a", ra, MakeSlices(a, 4096));
+    cache.Put("b", rb, MakeSlices(b, 4096));
+
+    std::string out(kSize, 'x');
+    auto out_slices = MakeSlices(out, 4096);
+    ASSERT_TRUE(cache.Read("a", ra, out_slices));
+
+    cache.Put("c", rc, MakeSlices(c, 4096));
+    EXPECT_EQ(2, cache.size());
+    EXPECT_TRUE(cache.Read("a", ra, out_slices));
+    EXPECT_FALSE(cache.Read("b", rb, out_slices));
+    EXPECT_TRUE(cache.Read("c", rc, out_slices));
+    EXPECT_EQ(c, out);
+}
+
+TEST(ClientObjectCacheTest, SkipsLargeObjectsAndInvalidates) {
+    ClientObjectCache cache(1024, 64);
+    std::string large(100, 'l');
+    const std::vector<Replica::Descriptor> replicas = {MakeReplica(1, 100)};
+    cache.Put("large", replicas, MakeSlices(large, 50));
+    EXPECT_EQ(0, cache.size());
+
+    std::string small(40, 's');
+    const std::vector<Replica::Descriptor> small_replicas = {
+        MakeReplica(2, 40)};
+    cache.Put("small", small_replicas, MakeSlices(small, 20));
+    EXPECT_EQ(1, cache.size());
+    cache.Invalidate("small");
+    EXPECT_EQ(0, cache.size());
+
+    cache.Put("small", small_replicas, MakeSlices(small, 20));
+    cache.SyncView(1);
+    EXPECT_EQ(1, cache.size());
+    cache.SyncView(2);
+    EXPECT_EQ(0, cache.size());
+}
+
+TEST(ClientObjectCacheTest, Disabled) {
+    ClientObjectCache cache(0, 64);
+    EXPECT_FALSE(cache.enabled());
+    std::string data(10, 'd');
+    const std::vector<Replica::Descriptor> replicas = {MakeReplica(1, 10)};
+    cache.Put("key", replicas, MakeSlices(data, 5));
+    auto slices = MakeSlices(data, 5);
+    EXPECT_FALSE(cache.Read("key", replicas, slices));
+}
+
+}  // namespace mooncake::test
@@ -0,0 +1,123 @@
+#include "compact_replica_list.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+AllocatedBuffer::Descriptor MakeBuffer(uintptr_t address,
+                                       const std::string& endpoint,
+                                       const std::string& protocol = "rdma") {
+    AllocatedBuffer::Descriptor buffer;
+    buffer.size_ = 4096;
+    buffer.buffer_address_ = address;
+    buffer.protocol_ = protocol;
+    buffer.transport_endpoint_ = endpoint;
+    return buffer;
+}
+
+Replica::Descriptor MakeMemoryReplica(uintptr_t address,
+                                      const std::string& endpoint) {
+    Replica::Descriptor replica;
+    replica.status = ReplicaStatus::COMPLETE;
+    MemoryDescriptor memory;
+    memory.buffer_descriptor = MakeBuffer(address, endpoint);
+    replica.descriptor_variant = std::move(memory);
+    return replica;
+}
+
+std::vector<tl::expected<GetReplicaListResponse, ErrorCode>> MakeResults() {
+    std::vector<tl::expected<GetReplicaListResponse, ErrorCode>> results;
+    for (uintptr_t i = 0; i < 100; i++) {
+        std::vector<Replica::Descriptor> replicas;
+        replicas.push_back(MakeMemoryReplica(i * 4096, "10.0.0.1:12345"));
+        replicas.push_back(MakeMemoryReplica(i * 4096, "10.0.0.2:12345"));
+        results.emplace_back(GetReplicaListResponse(std::move(replicas), 5000));
+    }
+    results.emplace_back(tl::make_unexpected(ErrorCode::OBJECT_NOT_FOUND));
+
+    StripedDescriptor chunks;
+    chunks.data_chunks = 2;
+    chunks.object_size = 8192;
+    chunks.chunk_descriptors = {MakeBuffer(0, "10.0.0.1:12345"),
+                                MakeBuffer(0, "10.0.0.3:12345"),
+                                MakeBuffer(0, "10.0.0.2:12345", "tcp")};
+    Replica::Descriptor striped;
+    striped.status = ReplicaStatus::COMPLETE;
+    striped.descriptor_variant = std::move(chunks);
+    std::vector<Replica::Descriptor> replicas = {striped};
+    results.emplace_back(GetReplicaListResponse(std::move(replicas), 5000));
+    return results;
+}
+
+void ExpectSameBuffer(const AllocatedBuffer::Descriptor& expected,
+                      const AllocatedBuffer::Descriptor& actual) {
+    EXPECT_EQ(expected.size_, actual.size_);
+    EXPECT_EQ(expected.buffer_address_, actual.buffer_address_);
+    EXPECT_EQ(expected.protocol_, actual.protocol_);
+    EXPECT_EQ(expected.transport_endpoint_, actual.transport_endpoint_);
+}
+
+}  // namespace
+
+TEST(CompactReplicaListTest, RoundTrip) {
+    const auto results = MakeResults();
+    auto compact = EncodeReplicaLists(MakeResults());
+    // Three endpoints, the tcp chunk of 10.0.0.2 keeps its strings
+    EXPECT_EQ(3, compact.endpoints.size());
+    EXPECT_EQ(203, compact.endpoint_indices.size());
+    EXPECT_EQ(CompactReplicaLists::kInlineEndpoint,
+              compact.endpoint_indices.back());
+    const auto& first = compact.results[0]->replicas[0].get_memory_descriptor();
+    EXPECT_TRUE(first.buffer_descriptor.transport_endpoint_.empty());
+
+    auto decoded = DecodeReplicaLists(std::move(compact));
+    ASSERT_TRUE(decoded.has_value());
+    ASSERT_EQ(results.size(), decoded->size());
+    for (size_t i = 0; i < results.size(); i++) {
+        ASSERT_EQ(results[i].has_value(), (*decoded)[i].has_value());
+        if (!results[i]) {
+            EXPECT_EQ(results[i].error(), (*decoded)[i].error());
+            continue;
+        }
+        const auto& expected = results[i]->replicas;
+        const auto& actual = (*decoded)[i]->replicas;
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t r = 0; r < expected.size(); r++) {
+            if (expected[r].is_memory_replica()) {
+                ExpectSameBuffer(
+                    std::get<MemoryDescriptor>(expected[r].descriptor_variant)
+                        .buffer_descriptor,
+                    std::get<MemoryDescriptor>(actual[r].descriptor_variant)
+                        .buffer_descriptor);
+                continue;
+            }
+            const auto& expected_chunks =
+                std::get<StripedDescriptor>(expected[r].descriptor_variant)
+                    .chunk_descriptors;
+            const auto& actual_chunks =
+                std::get<StripedDescriptor>(actual[r].descriptor_variant)
+                    .chunk_descriptors;
+            ASSERT_EQ(expected_chunks.size(), actual_chunks.size());
+            for (size_t c = 0; c < expected_chunks.size(); c++) {
+                ExpectSameBuffer(expected_chunks[c], actual_chunks[c]);
+            }
+        }
+    }
+}
+
+TEST(CompactReplicaListTest, RejectsMismatchedTable) {
+    auto compact = EncodeReplicaLists(MakeResults());
+    compact.endpoint_indices.pop_back();
+    EXPECT_FALSE(DecodeReplicaLists(std::move(compact)).has_value());
+
+    compact = EncodeReplicaLists(MakeResults());
+    compact.endpoint_indices[0] = 7;
+    EXPECT_FALSE(DecodeReplicaLists(std::move(compact)).has_value());
+}
+
+}  // namespace mooncake::test
@@ -0,0 +1,109 @@
+#include "content_index.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+TEST(ContentIndexTest, ContentKeyIgnoresSliceBoundaries) {
+    std::string data(1000, '\0');
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 31 + 7);
+    }
+    const std::string whole = ContentIndex::ContentKey(
+        {Slice{data.data(), data.size()}});
+    EXPECT_TRUE(ContentIndex::IsContentKey(whole));
+    EXPECT_TRUE(whole.ends_with("-1000"));
+
+    for (size_t split : {1, 55, 56, 63, 64, 65, 500, 999}) {
+        EXPECT_EQ(whole, ContentIndex::ContentKey(
+                             {Slice{data.data(), split},
+                              Slice{data.data() + split, data.size() - split}}))
+            << "split=" << split;
+    }
+
+    std::string other = data;
+    other[500] ^= 1;
+    EXPECT_NE(whole, ContentIndex::ContentKey(
+                         {Slice{other.data(), other.size()}}));
+    EXPECT_NE(whole, ContentIndex::ContentKey({Slice{data.data(), 999}}));
+    EXPECT_FALSE(ContentIndex::IsContentKey("key"));
+}
+
+TEST(ContentIndexTest, ContentKeyIsSha256) {
+    const std::string prefix = ContentIndex::kContentKeyPrefix;
+    EXPECT_EQ(prefix +
+                  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b"
+                  "7852b855-0",
+              ContentIndex::ContentKey({}));
+    std::string abc = "abc";
+    EXPECT_EQ(prefix +
+                  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61"
+                  "f20015ad-3",
+              ContentIndex::ContentKey({Slice{abc.data(), abc.size()}}));
+    // Two blocks after padding
+    std::string two_blocks =
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    EXPECT_EQ(prefix +
+                  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd4"
+                  "19db06c1-56",
+              ContentIndex::ContentKey(
+                  {Slice{two_blocks.data(), two_blocks.size()}}));
+}
+
+TEST(ContentIndexTest, LinkAndUnlink) {
+    ContentIndex index;
+    EXPECT_TRUE(index.empty());
+    const std::string content = std::string(ContentIndex::kContentKeyPrefix) +
+                                "0123-100";
+
+    EXPECT_EQ(ErrorCode::OK, index.Link("a", content, 100));
+    EXPECT_EQ(ErrorCode::OK, index.Link("b", content, 100));
+    EXPECT_EQ(ErrorCode::OK, index.Link("b", content, 100));
+    EXPECT_EQ(ErrorCode::OBJECT_ALREADY_EXISTS,
+              index.Link("b", content + "0", 100));
+    EXPECT_FALSE(index.empty());
+    EXPECT_EQ(content, index.Resolve("a"));
+    EXPECT_EQ(std::nullopt, index.Resolve("c"));
+
+    auto stats = index.GetStats();
+    EXPECT_EQ(2u, stats.linked_keys);
+    EXPECT_EQ(1u, stats.content_objects);
+    EXPECT_EQ(100u, stats.saved_bytes);
+
+    std::optional<std::string> orphaned;
+    EXPECT_TRUE(index.Unlink("a", orphaned));
+    EXPECT_EQ(std::nullopt, orphaned);
+    EXPECT_EQ(0u, index.GetStats().saved_bytes);
+    EXPECT_FALSE(index.Unlink("a", orphaned));
+
+    EXPECT_TRUE(index.Unlink("b", orphaned));
+    EXPECT_EQ(content, orphaned);
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ(0u, index.GetStats().content_objects);
+}
+
+TEST(ContentIndexTest, UnlinkIf) {
+    ContentIndex index;
+    const std::string first =
+        std::string(ContentIndex::kContentKeyPrefix) + "1-10";
+    const std::string second =
+        std::string(ContentIndex::kContentKeyPrefix) + "2-10";
+    ASSERT_EQ(ErrorCode::OK, index.Link("x/1", first, 10));
+    ASSERT_EQ(ErrorCode::OK, index.Link("y/1", first, 10));
+    ASSERT_EQ(ErrorCode::OK, index.Link("x/2", second, 10));
+
+    std::vector<std::string> orphaned;
+    EXPECT_EQ(2u, index.UnlinkIf(
+                      [](const std::string& key) {
+                          return key.starts_with("x/");
+                      },
+                      orphaned));
+    EXPECT_EQ(std::vector<std::string>{second}, orphaned);
+    EXPECT_EQ(first, index.Resolve("y/1"));
+    EXPECT_EQ(1u, index.GetStats().linked_keys);
+}
+
+}  // namespace mooncake::test
@@ -0,0 +1,79 @@
+#include "crc32c.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+// Bitwise reference
+uint32_t ReferenceCrc32c(const uint8_t* data, size_t size) {
+    uint32_t crc = ~0u;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (0x82F63B78u ^ (crc >> 1)) : (crc >> 1);
+        }
+    }
+    return ~crc;
+}
+
+}  // namespace
+
+TEST(Crc32cTest, KnownValues) {
+    const std::string check = "123456789";
+    EXPECT_EQ(Crc32c(0, check.data(), check.size()), 0xE3069283u);
+    EXPECT_EQ(Crc32c(0, nullptr, 0), 0u);
+
+    // RFC 3720 appendix B.4
+    uint8_t buffer[32];
+    std::memset(buffer, 0, sizeof(buffer));
+    EXPECT_EQ(Crc32c(0, buffer, sizeof(buffer)), 0x8A9136AAu);
+    std::memset(buffer, 0xFF, sizeof(buffer));
+    EXPECT_EQ(Crc32c(0, buffer, sizeof(buffer)), 0x62A8AB43u);
+    for (int i = 0; i < 32; ++i) {
+        buffer[i] = static_cast<uint8_t>(i);
+    }
+    EXPECT_EQ(Crc32c(0, buffer, sizeof(buffer)), 0x46DD794Eu);
+}
+
+TEST(Crc32cTest, MatchesReferenceAcrossSizes) {
+    std::mt19937 rng(42);
+    std::vector<uint8_t> data(200 * 1024 + 13);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    // Small tails, the parallel rounds and what is left after them, from
+    // unaligned offsets
+    for (size_t size : {size_t{1}, size_t{7}, size_t{8}, size_t{100},
+                        size_t{24575}, size_t{24576}, size_t{24583},
+                        size_t{3 * 24576 + 5}, data.size() - 3}) {
+        for (size_t offset : {size_t{0}, size_t{3}}) {
+            ASSERT_LE(offset + size, data.size());
+            EXPECT_EQ(Crc32c(0, data.data() + offset, size),
+                      ReferenceCrc32c(data.data() + offset, size))
+                << "size " << size << ", offset " << offset;
+        }
+    }
+}
+
+TEST(Crc32cTest, ContinuesAcrossSlices) {
+    std::mt19937 rng(7);
+    std::vector<uint8_t> data(100 * 1024);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    const uint32_t whole = Crc32c(0, data.data(), data.size());
+    for (size_t split : {size_t{1}, size_t{4096}, size_t{30000}}) {
+        uint32_t crc = Crc32c(0, data.data(), split);
+        crc = Crc32c(crc, data.data() + split, data.size() - split);
+        EXPECT_EQ(crc, whole) << "split " << split;
+    }
+}
+
+}  // namespace mooncake::test
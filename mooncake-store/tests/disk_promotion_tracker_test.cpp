@@ -0,0 +1,44 @@
+#include "disk_promotion_tracker.h"
+
+#include <gtest/gtest.h>
+
+namespace mooncake::test {
+
+using std::chrono::seconds;
+
+TEST(DiskPromotionTrackerTest, ReportsKeysReadWithinWindow) {
+    DiskPromotionTracker tracker(2, seconds(10), 16);
+    const auto now = DiskPromotionTracker::Clock::now();
+    EXPECT_FALSE(tracker.Record("a", now));
+    EXPECT_FALSE(tracker.Record("b", now));
+    EXPECT_TRUE(tracker.Record("a", now + seconds(5)));
+    // Reported once per window
+    EXPECT_FALSE(tracker.Record("a", now + seconds(6)));
+    EXPECT_EQ(std::vector<std::string>{"a"}, tracker.TakeDue());
+    EXPECT_TRUE(tracker.TakeDue().empty());
+
+    // The first read of b is too old to count
+    EXPECT_FALSE(tracker.Record("b", now + seconds(11)));
+    EXPECT_TRUE(tracker.Record("b", now + seconds(12)));
+
+    // a is counted again once its window passed
+    EXPECT_FALSE(tracker.Record("a", now + seconds(11)));
+    EXPECT_TRUE(tracker.Record("a", now + seconds(12)));
+}
+
+TEST(DiskPromotionTrackerTest, PruneMakesRoom) {
+    DiskPromotionTracker tracker(2, seconds(10), 2);
+    const auto now = DiskPromotionTracker::Clock::now();
+    tracker.Record("a", now);
+    tracker.Record("b", now + seconds(5));
+    EXPECT_FALSE(tracker.Record("c", now + seconds(5)));
+    EXPECT_FALSE(tracker.Record("c", now + seconds(5)));
+    EXPECT_EQ(2u, tracker.size());
+
+    tracker.Prune(now + seconds(11));
+    EXPECT_EQ(1u, tracker.size());
+    EXPECT_FALSE(tracker.Record("c", now + seconds(11)));
+    EXPECT_TRUE(tracker.Record("c", now + seconds(12)));
+}
+
+}  // namespace mooncake::test
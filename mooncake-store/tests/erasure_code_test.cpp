@@ -0,0 +1,112 @@
+#include "erasure_code.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+struct Stripe {
+    std::vector<std::vector<uint8_t>> chunks;
+
+    std::vector<uint8_t*> Pointers() {
+        std::vector<uint8_t*> pointers;
+        for (auto& chunk : chunks) {
+            pointers.push_back(chunk.data());
+        }
+        return pointers;
+    }
+};
+
+Stripe Encode(const ReedSolomonCode& code, size_t chunk_size,
+              std::mt19937& generator) {
+    Stripe stripe;
+    const size_t k = code.data_chunks();
+    for (size_t c = 0; c < k + code.parity_chunks(); c++) {
+        stripe.chunks.emplace_back(chunk_size, 0);
+    }
+    const std::vector<uint8_t*> pointers = stripe.Pointers();
+    const std::vector<uint8_t*> parity(pointers.begin() + k, pointers.end());
+    for (size_t i = 0; i < k; i++) {
+        for (auto& byte : stripe.chunks[i]) {
+            byte = generator();
+        }
+        code.Encode(i, stripe.chunks[i].data(), chunk_size, 0, parity);
+    }
+    return stripe;
+}
+
+}  // namespace
+
+TEST(ReedSolomonCodeTest, RecoversFromAnyLossOfParityCount) {
+    std::mt19937 generator(42);
+    const ReedSolomonCode code(4, 2);
+    const size_t chunk_size = 1000;
+    const Stripe original = Encode(code, chunk_size, generator);
+
+    // Every pair of lost chunks
+    for (size_t a = 0; a < 6; a++) {
+        for (size_t b = a + 1; b < 6; b++) {
+            Stripe stripe = original;
+            std::vector<bool> present(6, true);
+            present[a] = present[b] = false;
+            std::fill(stripe.chunks[a].begin(), stripe.chunks[a].end(), 0xff);
+            std::fill(stripe.chunks[b].begin(), stripe.chunks[b].end(), 0xff);
+            ASSERT_TRUE(code.Reconstruct(stripe.Pointers(), present,
+                                         chunk_size));
+            for (size_t i = 0; i < 4; i++) {
+                EXPECT_EQ(original.chunks[i], stripe.chunks[i])
+                    << "lost " << a << " and " << b;
+            }
+        }
+    }
+
+    // Three lost chunks are too many
+    Stripe stripe = original;
+    std::vector<bool> present = {false, false, true, true, false, true};
+    EXPECT_FALSE(code.Reconstruct(stripe.Pointers(), present, chunk_size));
+}
+
+TEST(ReedSolomonCodeTest, EncodesPieceByPiece) {
+    std::mt19937 generator(7);
+    const ReedSolomonCode code(3, 2);
+    const size_t chunk_size = 256;
+    const Stripe whole = Encode(code, chunk_size, generator);
+
+    // The same data chunks split at odd offsets give the same parity
+    std::vector<std::vector<uint8_t>> parity(2,
+                                             std::vector<uint8_t>(chunk_size));
+    std::vector<uint8_t*> parity_pointers = {parity[0].data(),
+                                             parity[1].data()};
+    for (size_t i = 0; i < 3; i++) {
+        const auto& data = whole.chunks[i];
+        code.Encode(i, data.data(), 17, 0, parity_pointers);
+        code.Encode(i, data.data() + 17, chunk_size - 17, 17, parity_pointers);
+    }
+    EXPECT_EQ(whole.chunks[3], parity[0]);
+    EXPECT_EQ(whole.chunks[4], parity[1]);
+}
+
+TEST(ReedSolomonCodeTest, WideStripes) {
+    std::mt19937 generator(1);
+    const ReedSolomonCode code(10, 4);
+    const size_t chunk_size = 64;
+    const Stripe original = Encode(code, chunk_size, generator);
+
+    for (int round = 0; round < 20; round++) {
+        Stripe stripe = original;
+        std::vector<bool> present(14, true);
+        for (int lost = 0; lost < 4; lost++) {
+            present[generator() % 14] = false;
+        }
+        ASSERT_TRUE(code.Reconstruct(stripe.Pointers(), present, chunk_size));
+        for (size_t i = 0; i < 10; i++) {
+            EXPECT_EQ(original.chunks[i], stripe.chunks[i]);
+        }
+    }
+}
+
+}  // namespace mooncake::test
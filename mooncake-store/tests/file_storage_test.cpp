@@ -80,6 +80,13 @@ class FileStorageTest : public ::testing::Test {
                                                          buckets_keys);
     }
 
+    uint32_t FileStorageNextHeartbeatInterval(FileStorage& fileStorage,
+                                              uint32_t interval_seconds,
+                                              size_t received_objects) {
+        return fileStorage.NextHeartbeatInterval(interval_seconds,
+                                                 received_objects);
+    }
+
     size_t GetUngroupedOffloadingObjectsSize(FileStorage& fileStorage) {
         auto bucket_backend = std::dynamic_pointer_cast<BucketStorageBackend>(
             fileStorage.storage_backend_);
@@ -278,6 +285,8 @@ TEST_F(FileStorageTest, DefaultValuesWhenNoEnvSet) {
     EXPECT_EQ(config.total_keys_limit, 10'000'000);
     EXPECT_EQ(config.total_size_limit, 2ULL * 1024 * 1024 * 1024 * 1024);
     EXPECT_EQ(config.heartbeat_interval_seconds, 10u);
+    EXPECT_EQ(config.heartbeat_max_interval_seconds, 60u);
+    EXPECT_EQ(config.heartbeat_max_objects, 20000u);
 }
 
 TEST_F(FileStorageTest, ReadStringFromEnv) {
@@ -426,4 +435,84 @@ TEST_F(FileStorageTest, BatchLoad_WithStorageBackendAdaptor) {
     }
 }
 
+TEST_F(FileStorageTest, AllocateBatchWaitsForReleasedBuffer) {
+    auto file_storage_config = FileStorageConfig::FromEnvironment();
+    file_storage_config.storage_filepath = data_path;
+    file_storage_config.local_buffer_size = 12 * kMB;
+    file_storage_config.client_buffer_wait_timeout_ms = 5000;
+    FileStorage fileStorage(file_storage_config, nullptr, "localhost:9003");
+
+    std::vector<std::string> keys = {"key_0", "key_1", "key_2", "key_3"};
+    std::vector<int64_t> sizes(keys.size(), 2 * kMB);
+    auto first = FileStorageAllocateBatch(fileStorage, keys, sizes);
+    ASSERT_TRUE(first);
+
+    // The second batch does not fit until the first one is dropped
+    auto batch = std::move(first.value());
+    std::thread releaser([&batch]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        batch.reset();
+    });
+    auto start = std::chrono::steady_clock::now();
+    auto second = FileStorageAllocateBatch(fileStorage, keys, sizes);
+    auto waited = std::chrono::steady_clock::now() - start;
+    releaser.join();
+    ASSERT_TRUE(second);
+    EXPECT_GE(waited, std::chrono::milliseconds(100));
+    EXPECT_EQ(second.value()->total_size, 8 * kMB);
+}
+
+TEST_F(FileStorageTest, AllocateBatchFailsWhenBufferStaysFull) {
+    auto file_storage_config = FileStorageConfig::FromEnvironment();
+    file_storage_config.storage_filepath = data_path;
+    file_storage_config.local_buffer_size = 12 * kMB;
+    file_storage_config.client_buffer_wait_timeout_ms = 50;
+    FileStorage fileStorage(file_storage_config, nullptr, "localhost:9003");
+
+    std::vector<std::string> keys = {"key_0", "key_1", "key_2", "key_3"};
+    std::vector<int64_t> sizes(keys.size(), 2 * kMB);
+    auto first = FileStorageAllocateBatch(fileStorage, keys, sizes);
+    ASSERT_TRUE(first);
+    auto second = FileStorageAllocateBatch(fileStorage, keys, sizes);
+    ASSERT_FALSE(second);
+    EXPECT_EQ(second.error(), ErrorCode::BUFFER_OVERFLOW);
+
+    // A batch larger than the whole buffer fails without waiting
+    std::vector<std::string> many_keys;
+    for (int i = 0; i < 8; ++i) {
+        many_keys.emplace_back("key_" + std::to_string(i));
+    }
+    std::vector<int64_t> many_sizes(many_keys.size(), 2 * kMB);
+    first.value().reset();
+    auto oversized =
+        FileStorageAllocateBatch(fileStorage, many_keys, many_sizes);
+    ASSERT_FALSE(oversized);
+    EXPECT_EQ(oversized.error(), ErrorCode::BUFFER_OVERFLOW);
+
+    // Space freed by the failed attempts is usable again
+    EXPECT_TRUE(FileStorageAllocateBatch(fileStorage, keys, sizes));
+}
+
+TEST_F(FileStorageTest, HeartbeatIntervalAdaptsToOffloadBacklog) {
+    auto file_storage_config = FileStorageConfig::FromEnvironment();
+    file_storage_config.storage_filepath = data_path;
+    file_storage_config.heartbeat_interval_seconds = 5;
+    file_storage_config.heartbeat_max_interval_seconds = 30;
+    file_storage_config.heartbeat_max_objects = 100;
+    FileStorage fileStorage(file_storage_config, nullptr, "localhost:9003");
+
+    // Idle heartbeats back off up to the max interval
+    EXPECT_EQ(FileStorageNextHeartbeatInterval(fileStorage, 5, 0), 10u);
+    EXPECT_EQ(FileStorageNextHeartbeatInterval(fileStorage, 10, 0), 20u);
+    EXPECT_EQ(FileStorageNextHeartbeatInterval(fileStorage, 20, 0), 30u);
+    EXPECT_EQ(FileStorageNextHeartbeatInterval(fileStorage, 30, 0), 30u);
+
+    // A full batch means more is queued on the master
+    EXPECT_EQ(FileStorageNextHeartbeatInterval(fileStorage, 30, 100), 0u);
+    // The backlog drained, or work after an idle period
+    EXPECT_EQ(FileStorageNextHeartbeatInterval(fileStorage, 0, 0), 5u);
+    EXPECT_EQ(FileStorageNextHeartbeatInterval(fileStorage, 0, 40), 5u);
+    EXPECT_EQ(FileStorageNextHeartbeatInterval(fileStorage, 30, 1), 5u);
+}
+
 }  // namespace mooncake
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "flat_key_map.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+// Like ObjectMetadata, values can neither be copied nor moved
+struct PinnedValue {
+    PinnedValue(int value_param, std::vector<int>&& data_param)
+        : value(value_param), data(std::move(data_param)) {}
+    PinnedValue(const PinnedValue&) = delete;
+    PinnedValue(PinnedValue&&) = delete;
+
+    int value;
+    std::vector<int> data;
+};
+
+struct CountingTracker {
+    static inline int64_t bytes = 0;
+    static void Add(int64_t delta) { bytes += delta; }
+};
+
+template <typename Map>
+bool Emplace(Map& map, const std::string& key, int value) {
+    return map
+        .emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                 std::forward_as_tuple(value, std::vector<int>{value}))
+        .second;
+}
+
+}  // namespace
+
+TEST(FlatKeyMapTest, BasicOperations) {
+    FlatKeyMap<PinnedValue> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find("key"), map.end());
+
+    EXPECT_TRUE(Emplace(map, "key", 1));
+    EXPECT_FALSE(Emplace(map, "key", 2));
+    EXPECT_EQ(1, map.size());
+
+    auto it = map.find("key");
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ("key", it->first);
+    EXPECT_EQ(1, it->second.value);
+
+    // References survive growing the index
+    PinnedValue* value = &it->second;
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(Emplace(map, "key_" + std::to_string(i), i));
+    }
+    EXPECT_EQ(value, &map.find("key")->second);
+
+    EXPECT_EQ(1, map.erase("key"));
+    EXPECT_EQ(0, map.erase("key"));
+    EXPECT_EQ(map.find("key"), map.end());
+    EXPECT_EQ(1000, map.size());
+}
+
+TEST(FlatKeyMapTest, EraseWhileIterating) {
+    FlatKeyMap<PinnedValue> map;
+    for (int i = 0; i < 1000; i++) {
+        Emplace(map, "key_" + std::to_string(i), i);
+    }
+
+    size_t visited = 0;
+    for (auto it = map.begin(); it != map.end();) {
+        visited++;
+        if (it->second.value % 2 == 0) {
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    EXPECT_EQ(1000, visited);
+    EXPECT_EQ(500, map.size());
+
+    const auto& const_map = map;
+    for (const auto& [key, value] : const_map) {
+        EXPECT_EQ(1, value.value % 2);
+        EXPECT_EQ("key_" + std::to_string(value.value), key);
+    }
+}
+
+TEST(FlatKeyMapTest, MatchesUnorderedMap) {
+    FlatKeyMap<PinnedValue> map;
+    std::unordered_map<std::string, int> expected;
+    std::mt19937 generator(42);
+
+    for (int i = 0; i < 100000; i++) {
+        // Mix inline and heap allocated keys
+        std::string key = "model/0/" + std::to_string(generator() % 4096);
+        if (i % 3 == 0) {
+            key += std::string(32, 'x');
+        }
+        if (generator() % 3 != 0) {
+            EXPECT_EQ(expected.emplace(key, i).second, Emplace(map, key, i));
+        } else {
+            EXPECT_EQ(expected.erase(key), map.erase(key));
+        }
+    }
+
+    ASSERT_EQ(expected.size(), map.size());
+    size_t visited = 0;
+    for (const auto& [key, value] : map) {
+        ASSERT_TRUE(expected.contains(key));
+        EXPECT_EQ(expected[key], value.value);
+        visited++;
+    }
+    EXPECT_EQ(expected.size(), visited);
+}
+
+TEST(FlatKeyMapTest, TracksMemory) {
+    CountingTracker::bytes = 0;
+    {
+        FlatKeyMap<PinnedValue, CountingTracker> map;
+        EXPECT_EQ(0, map.memory_usage());
+        for (int i = 0; i < 100; i++) {
+            Emplace(map, "key_" + std::to_string(i) + std::string(32, 'x'),
+                    i);
+        }
+        EXPECT_GT(map.memory_usage(), 100 * sizeof(PinnedValue));
+        EXPECT_EQ(CountingTracker::bytes, map.memory_usage());
+
+        const size_t memory_usage = map.memory_usage();
+        map.erase(map.begin());
+        EXPECT_LT(map.memory_usage(), memory_usage);
+        EXPECT_EQ(CountingTracker::bytes, map.memory_usage());
+    }
+    EXPECT_EQ(0, CountingTracker::bytes);
+}
+
+}  // namespace mooncake::test
@@ -0,0 +1,68 @@
+#include "frequency_sketch.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <string>
+
+namespace mooncake::test {
+
+namespace {
+
+size_t KeyHash(const std::string& key) { return std::hash<std::string>{}(key); }
+
+}  // namespace
+
+TEST(FrequencySketchTest, EstimatesAccessCount) {
+    FrequencySketch sketch(1024);
+    EXPECT_EQ(0, sketch.Estimate(KeyHash("key")));
+
+    for (int i = 0; i < 5; i++) {
+        sketch.Increment(KeyHash("key"));
+    }
+    EXPECT_EQ(5, sketch.Estimate(KeyHash("key")));
+    EXPECT_EQ(0, sketch.Estimate(KeyHash("other_key")));
+
+    // Counters saturate
+    for (int i = 0; i < 100; i++) {
+        sketch.Increment(KeyHash("key"));
+    }
+    EXPECT_EQ(FrequencySketch::kMaxCount, sketch.Estimate(KeyHash("key")));
+}
+
+TEST(FrequencySketchTest, HotKeysOutrankColdKeys) {
+    FrequencySketch sketch(1024);
+    for (int i = 0; i < 1000; i++) {
+        sketch.Increment(KeyHash("cold_key" + std::to_string(i)));
+        if (i % 10 == 0) {
+            sketch.Increment(KeyHash("hot_key"));
+        }
+    }
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_LT(sketch.Estimate(KeyHash("cold_key" + std::to_string(i))),
+                  sketch.Estimate(KeyHash("hot_key")));
+    }
+}
+
+TEST(FrequencySketchTest, HistoryFades) {
+    FrequencySketch sketch(64);
+    for (int i = 0; i < 8; i++) {
+        sketch.Increment(KeyHash("key"));
+    }
+    ASSERT_EQ(8, sketch.Estimate(KeyHash("key")));
+
+    // Increments never age the counters themselves
+    for (int i = 0; i < 10 * 64 - 9; i++) {
+        sketch.Increment(KeyHash("other_key"));
+    }
+    EXPECT_FALSE(sketch.Age());
+    sketch.Increment(KeyHash("other_key"));
+    EXPECT_EQ(8, sketch.Estimate(KeyHash("key")));
+
+    // Counters are halved once 10 * width increments were recorded
+    EXPECT_TRUE(sketch.Age());
+    EXPECT_EQ(4, sketch.Estimate(KeyHash("key")));
+    EXPECT_FALSE(sketch.Age());
+}
+
+}  // namespace mooncake::test
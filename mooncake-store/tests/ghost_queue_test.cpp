@@ -0,0 +1,44 @@
+#include "ghost_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <string>
+
+namespace mooncake::test {
+
+namespace {
+
+size_t KeyHash(const std::string& key) { return std::hash<std::string>{}(key); }
+
+}  // namespace
+
+TEST(GhostQueueTest, RemovesInsertedKeysOnce) {
+    GhostQueue queue(1024);
+    EXPECT_FALSE(queue.Remove(KeyHash("key")));
+
+    queue.Insert(KeyHash("key"));
+    EXPECT_FALSE(queue.Remove(KeyHash("other_key")));
+    EXPECT_TRUE(queue.Remove(KeyHash("key")));
+    EXPECT_FALSE(queue.Remove(KeyHash("key")));
+}
+
+TEST(GhostQueueTest, ForgetsOldKeysWhenFull) {
+    GhostQueue queue(64);
+    for (int i = 0; i < 64 * 16; i++) {
+        queue.Insert(KeyHash("key" + std::to_string(i)));
+    }
+    // The queue holds at most its capacity, the most recent keys win
+    int old_found = 0;
+    for (int i = 0; i < 64 * 8; i++) {
+        old_found += queue.Remove(KeyHash("key" + std::to_string(i)));
+    }
+    int found = 0;
+    for (int i = 0; i < 64 * 16; i++) {
+        found += queue.Remove(KeyHash("key" + std::to_string(i)));
+    }
+    EXPECT_LE(old_found + found, 64);
+    EXPECT_LT(old_found, found);
+}
+
+}  // namespace mooncake::test
@@ -2,8 +2,13 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "etcd_helper.h"
 #include "ha_helper.h"
@@ -227,6 +232,56 @@ TEST_F(HighAvailabilityTest, BasicMasterViewOperations) {
     keep_alive_thread.join();
 }
 
+TEST_F(HighAvailabilityTest, MasterViewWatcherReportsNewLeader) {
+    MasterViewHelper mv_helper;
+    ASSERT_EQ(ErrorCode::OK, mv_helper.ConnectToEtcd(FLAGS_etcd_endpoints));
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> leaders;
+    auto subscription = MasterViewWatcher::Instance().Subscribe(
+        [&](const std::string& master_address, ViewVersionId) {
+            std::lock_guard<std::mutex> lock(mutex);
+            leaders.push_back(master_address);
+            cv.notify_all();
+        });
+    auto wait_for_leaders = [&](size_t count, std::chrono::seconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, timeout,
+                           [&] { return leaders.size() >= count; });
+    };
+    // Let the watch start
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    const int64_t lease_ttl = 2;
+    ViewVersionId version = 0;
+    EtcdLeaseId lease_id = 0;
+    mv_helper.ElectLeader("0.0.0.0:7001", version, lease_id, lease_ttl);
+    std::thread keep_alive_thread([&]() { mv_helper.KeepLeader(lease_id); });
+    ASSERT_TRUE(wait_for_leaders(1, std::chrono::seconds(lease_ttl)));
+    EXPECT_EQ("0.0.0.0:7001", leaders.back());
+
+    // The leader stops renewing its lease, another master takes over once
+    // it expires, and the subscribers learn about it right away
+    auto failover_start = std::chrono::steady_clock::now();
+    ASSERT_EQ(ErrorCode::OK, EtcdHelper::CancelKeepAlive(lease_id));
+    keep_alive_thread.join();
+    mv_helper.ElectLeader("0.0.0.0:7002", version, lease_id, lease_ttl);
+    keep_alive_thread = std::thread([&]() { mv_helper.KeepLeader(lease_id); });
+    ASSERT_TRUE(wait_for_leaders(2, std::chrono::seconds(lease_ttl)));
+    EXPECT_EQ("0.0.0.0:7002", leaders.back());
+    auto failover_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - failover_start)
+                           .count();
+    LOG(INFO) << "New leader reported " << failover_ms
+              << " ms after the old one stopped";
+    EXPECT_LE(failover_ms, 3 * lease_ttl * 1000);
+
+    MasterViewWatcher::Instance().Unsubscribe(subscription);
+    EtcdHelper::CancelKeepAlive(lease_id);
+    keep_alive_thread.join();
+}
+
 TEST_F(HighAvailabilityTest, OpLogPersistenceInterfaces) {
     // 1. Basic Put & Get
     std::string key = FLAGS_etcd_test_key_prefix + "oplog_test_1";
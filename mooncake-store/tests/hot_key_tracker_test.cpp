@@ -0,0 +1,61 @@
+#include "hot_key_tracker.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <string>
+
+namespace mooncake::test {
+
+namespace {
+
+void Read(HotKeyTracker& tracker, const std::string& key) {
+    tracker.Record(key, std::hash<std::string>{}(key));
+}
+
+}  // namespace
+
+TEST(HotKeyTrackerTest, KeepsHottestKeys) {
+    HotKeyTracker tracker(3, 4096);
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 50; i++) {
+            Read(tracker, "cold_key" + std::to_string(round * 50 + i));
+        }
+        for (int i = 0; i < 3; i++) {
+            Read(tracker, "hot_key1");
+            Read(tracker, "hot_key2");
+        }
+        Read(tracker, "hot_key3");
+        Read(tracker, "hot_key3");
+    }
+
+    auto top = tracker.TopKeys();
+    ASSERT_EQ(3u, top.size());
+    EXPECT_TRUE((top[0].key == "hot_key1" && top[1].key == "hot_key2") ||
+                (top[0].key == "hot_key2" && top[1].key == "hot_key1"));
+    EXPECT_EQ("hot_key3", top[2].key);
+    EXPECT_GE(top[0].count, top[1].count);
+    EXPECT_GT(top[1].count, top[2].count);
+}
+
+TEST(HotKeyTrackerTest, FollowsTheCurrentHotSet) {
+    HotKeyTracker tracker(1, 64);
+    for (int i = 0; i < 200; i++) {
+        Read(tracker, "old_hot_key");
+    }
+    ASSERT_EQ("old_hot_key", tracker.TopKeys().at(0).key);
+
+    // The counts of old_hot_key decay while new_hot_key is read
+    for (int i = 0; i < 2000; i++) {
+        Read(tracker, "new_hot_key");
+    }
+    EXPECT_EQ("new_hot_key", tracker.TopKeys().at(0).key);
+}
+
+TEST(HotKeyTrackerTest, DisabledListStaysEmpty) {
+    HotKeyTracker tracker(0, 64);
+    Read(tracker, "key");
+    EXPECT_TRUE(tracker.TopKeys().empty());
+}
+
+}  // namespace mooncake::test
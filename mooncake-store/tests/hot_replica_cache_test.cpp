@@ -0,0 +1,185 @@
+#include "hot_replica_cache.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "epoch_manager.h"
+#include "master_service.h"
+#include "types.h"
+
+namespace mooncake::test {
+
+class HotReplicaCacheTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        google::InitGoogleLogging("HotReplicaCacheTest");
+        FLAGS_logtostderr = true;
+    }
+
+    void TearDown() override { google::ShutdownGoogleLogging(); }
+
+    static std::vector<Replica::Descriptor> MakeReplicas(
+        uint64_t buffer_address) {
+        Replica::Descriptor desc;
+        MemoryDescriptor mem_desc;
+        mem_desc.buffer_descriptor.size_ = 1024;
+        mem_desc.buffer_descriptor.buffer_address_ = buffer_address;
+        desc.descriptor_variant = std::move(mem_desc);
+        desc.status = ReplicaStatus::COMPLETE;
+        return {desc};
+    }
+
+    static uint64_t BufferAddress(const GetReplicaListResponse& response) {
+        return response.replicas[0]
+            .get_memory_descriptor()
+            .buffer_descriptor.buffer_address_;
+    }
+
+    static constexpr size_t kNumShards = 16;
+};
+
+TEST_F(HotReplicaCacheTest, PublishAndGet) {
+    HotReplicaCache cache(64, kNumShards);
+    ASSERT_TRUE(cache.enabled());
+    const std::string key = "key";
+    const size_t hash = std::hash<std::string>{}(key);
+    const size_t shard = hash % kNumShards;
+
+    EXPECT_FALSE(cache.Get(key, hash, shard, 0).has_value());
+
+    const auto lease_timeout =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    cache.Publish(key, hash, shard, cache.generation(), MakeReplicas(0x1000),
+                  lease_timeout);
+    auto cached = cache.Get(key, hash, shard, 1000);
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(0x1000, BufferAddress(*cached));
+    EXPECT_GT(cached->lease_ttl_ms, 1000);
+    EXPECT_LE(cached->lease_ttl_ms, 10000);
+
+    // Not enough of the lease is left
+    EXPECT_FALSE(cache.Get(key, hash, shard, 20000).has_value());
+    // Another key in the same slot
+    EXPECT_FALSE(cache.Get("other_key", hash, shard, 0).has_value());
+}
+
+TEST_F(HotReplicaCacheTest, Invalidate) {
+    HotReplicaCache cache(64, kNumShards);
+    const std::string key = "key";
+    const size_t hash = std::hash<std::string>{}(key);
+    const size_t shard = hash % kNumShards;
+    const auto lease_timeout =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    cache.Publish(key, hash, shard, cache.generation(), MakeReplicas(0x1000),
+                  lease_timeout);
+    cache.InvalidateShard((shard + 1) % kNumShards);
+    EXPECT_TRUE(cache.Get(key, hash, shard, 0).has_value());
+    cache.InvalidateShard(shard);
+    EXPECT_FALSE(cache.Get(key, hash, shard, 0).has_value());
+
+    // A snapshot taken before InvalidateAll is never served
+    const uint64_t generation = cache.generation();
+    cache.InvalidateAll();
+    cache.Publish(key, hash, shard, generation, MakeReplicas(0x1000),
+                  lease_timeout);
+    EXPECT_FALSE(cache.Get(key, hash, shard, 0).has_value());
+    cache.Publish(key, hash, shard, cache.generation(), MakeReplicas(0x1000),
+                  lease_timeout);
+    EXPECT_TRUE(cache.Get(key, hash, shard, 0).has_value());
+}
+
+TEST_F(HotReplicaCacheTest, ConcurrentReadersAndPublishers) {
+    HotReplicaCache cache(4, kNumShards);
+    const std::string key = "key";
+    const size_t hash = std::hash<std::string>{}(key);
+    const size_t shard = hash % kNumShards;
+    const auto lease_timeout =
+        std::chrono::steady_clock::now() + std::chrono::seconds(60);
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> bad_reads{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            while (running.load()) {
+                auto cached = cache.Get(key, hash, shard, 0);
+                if (cached && (cached->replicas.size() != 1 ||
+                               BufferAddress(*cached) % 0x1000 != 0)) {
+                    bad_reads++;
+                }
+            }
+        });
+    }
+    for (uint64_t i = 1; i <= 10000; i++) {
+        cache.Publish(key, hash, shard, cache.generation(),
+                      MakeReplicas(i * 0x1000), lease_timeout);
+        if (i % 100 == 0) {
+            cache.InvalidateShard(shard);
+        }
+    }
+    running = false;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(0, bad_reads.load());
+    EpochManager::instance().Reclaim();
+}
+
+TEST_F(HotReplicaCacheTest, MasterServiceServesHotKeys) {
+    constexpr uint64_t kLeaseTtlMs = 500;
+    auto service_config = MasterServiceConfig::builder()
+                              .set_default_kv_lease_ttl(kLeaseTtlMs)
+                              .set_hot_replica_cache_size(1024)
+                              .build();
+    auto service = std::make_unique<MasterService>(service_config);
+
+    Segment segment;
+    segment.id = generate_uuid();
+    segment.name = "test_segment";
+    segment.base = 0x300000000;
+    segment.size = 1024 * 1024 * 16;
+    segment.te_endpoint = segment.name;
+    const UUID client_id = generate_uuid();
+    ASSERT_TRUE(service->MountSegment(segment, client_id).has_value());
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    ASSERT_TRUE(service->PutStart(client_id, "key", 1024, config).has_value());
+    ASSERT_TRUE(
+        service->PutEnd(client_id, "key", ReplicaType::MEMORY).has_value());
+
+    auto first = service->GetReplicaList("key");
+    ASSERT_TRUE(first.has_value());
+    auto second = service->GetReplicaList("key");
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(BufferAddress(*first), BufferAddress(*second));
+    EXPECT_GT(second->lease_ttl_ms, kLeaseTtlMs / 2);
+    EXPECT_LE(second->lease_ttl_ms, kLeaseTtlMs);
+
+    // Writes must not be hidden by the cache
+    std::this_thread::sleep_for(std::chrono::milliseconds(kLeaseTtlMs + 10));
+    ASSERT_TRUE(service->Remove("key").has_value());
+    EXPECT_FALSE(service->GetReplicaList("key").has_value());
+
+    ASSERT_TRUE(service->PutStart(client_id, "key", 1024, config).has_value());
+    ASSERT_TRUE(
+        service->PutEnd(client_id, "key", ReplicaType::MEMORY).has_value());
+    ASSERT_TRUE(service->GetReplicaList("key").has_value());
+    ASSERT_TRUE(service->UnmountSegment(segment.id, client_id).has_value());
+    EXPECT_FALSE(service->GetReplicaList("key").has_value());
+}
+
+}  // namespace mooncake::test
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
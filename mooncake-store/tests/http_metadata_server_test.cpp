@@ -0,0 +1,86 @@
+#include "http_metadata_server.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <ylt/coro_http/coro_http_client.hpp>
+
+#include "utils.h"
+
+namespace mooncake::test {
+
+class HttpMetadataServerTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        int port = getFreeTcpPort();
+        ASSERT_GT(port, 0);
+        server_ = std::make_unique<HttpMetadataServer>(
+            static_cast<uint16_t>(port), "127.0.0.1");
+        ASSERT_TRUE(server_->start());
+        base_url_ = "http://127.0.0.1:" + std::to_string(port) + "/metadata";
+    }
+
+    void TearDown() override { server_->stop(); }
+
+    coro_http::resp_data Post(const std::string& endpoint,
+                              const std::string& body) {
+        return client_.post(base_url_ + "/" + endpoint, body,
+                            coro_http::req_content_type::json);
+    }
+
+    std::unique_ptr<HttpMetadataServer> server_;
+    std::string base_url_;
+    coro_http::coro_http_client client_;
+};
+
+TEST_F(HttpMetadataServerTest, BatchPutThenBatchGet) {
+    MetadataBatchPutRequest put;
+    for (int i = 0; i < 100; i++) {
+        put.entries.push_back({"key" + std::to_string(i),
+                               "{\"id\":" + std::to_string(i) + "}"});
+    }
+    std::string body;
+    struct_json::to_json(put, body);
+    ASSERT_EQ(200, Post("batch_put", body).status);
+
+    auto single = client_.get(base_url_ + "?key=key42");
+    ASSERT_EQ(200, single.status);
+    EXPECT_EQ("{\"id\":42}", std::string(single.resp_body));
+
+    MetadataBatchGetRequest get{{"key1", "missing", "key99"}};
+    body.clear();
+    struct_json::to_json(get, body);
+    auto result = Post("batch_get", body);
+    ASSERT_EQ(200, result.status);
+
+    MetadataBatchGetResponse response;
+    struct_json::from_json(response, std::string(result.resp_body));
+    ASSERT_EQ(2u, response.values.size());
+    EXPECT_EQ("{\"id\":1}", response.values["key1"]);
+    EXPECT_EQ("{\"id\":99}", response.values["key99"]);
+}
+
+TEST_F(HttpMetadataServerTest, BatchPutRejectsDuplicateRpcMeta) {
+    MetadataBatchPutRequest put;
+    put.entries.push_back({"rpc_meta/a", "{}"});
+    std::string body;
+    struct_json::to_json(put, body);
+    ASSERT_EQ(200, Post("batch_put", body).status);
+
+    put.entries.insert(put.entries.begin(), MetadataEntry{"before", "{}"});
+    put.entries.push_back({"after", "{}"});
+    body.clear();
+    struct_json::to_json(put, body);
+    EXPECT_EQ(400, Post("batch_put", body).status);
+
+    // The entries before the duplicate are stored, the ones after are not
+    EXPECT_EQ(200, client_.get(base_url_ + "?key=before").status);
+    EXPECT_EQ(404, client_.get(base_url_ + "?key=after").status);
+}
+
+TEST_F(HttpMetadataServerTest, RejectsMalformedBatch) {
+    EXPECT_EQ(400, Post("batch_get", "not json").status);
+    EXPECT_EQ(400, Post("batch_put", "{\"entries\": 3}").status);
+}
+
+}  // namespace mooncake::test
@@ -0,0 +1,186 @@
+#include "key_filter.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "key_radix_tree.h"
+#include "master_service.h"
+#include "types.h"
+
+namespace mooncake::test {
+
+class KeyFilterTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        google::InitGoogleLogging("KeyFilterTest");
+        FLAGS_logtostderr = true;
+    }
+
+    void TearDown() override { google::ShutdownGoogleLogging(); }
+
+    static size_t Hash(const std::string& key) {
+        return std::hash<std::string>{}(key);
+    }
+};
+
+TEST_F(KeyFilterTest, InsertAndErase) {
+    std::atomic<uint64_t> seq{0};
+    KeyRadixTree key_index;
+    KeyFilterShard filter(1 << 12, &seq, &key_index);
+    EXPECT_EQ(0, filter.version());
+    EXPECT_FALSE(KeyFilterShard::MayContain(filter.bits(), Hash("key")));
+
+    filter.OnInsert("key");
+    EXPECT_TRUE(KeyFilterShard::MayContain(filter.bits(), Hash("key")));
+    EXPECT_GT(filter.version(), 0);
+    EXPECT_EQ(filter.version(), seq.load());
+    // Forwarded to the next observer
+    EXPECT_TRUE(key_index.Contains("key"));
+
+    filter.OnInsert("other");
+    filter.OnErase("key");
+    EXPECT_FALSE(KeyFilterShard::MayContain(filter.bits(), Hash("key")));
+    EXPECT_TRUE(KeyFilterShard::MayContain(filter.bits(), Hash("other")));
+    EXPECT_FALSE(key_index.Contains("key"));
+
+    // Few false positives with 16 bits per key
+    for (int i = 0; i < 256; ++i) {
+        filter.OnInsert("present_" + std::to_string(i));
+    }
+    int false_positives = 0;
+    for (int i = 0; i < 1000; ++i) {
+        if (KeyFilterShard::MayContain(filter.bits(),
+                                       Hash("missing_" + std::to_string(i)))) {
+            false_positives++;
+        }
+    }
+    EXPECT_LT(false_positives, 50);
+}
+
+TEST_F(KeyFilterTest, ViewAppliesDeltas) {
+    constexpr uint32_t kNumShards = 4;
+    std::atomic<uint64_t> seq{0};
+    std::vector<std::unique_ptr<KeyFilterShard>> shards;
+    for (uint32_t i = 0; i < kNumShards; ++i) {
+        shards.push_back(std::make_unique<KeyFilterShard>(1 << 10, &seq));
+    }
+    auto insert = [&](const std::string& key) {
+        shards[Hash(key) % kNumShards]->OnInsert(key);
+    };
+    auto respond = [&](uint64_t since) {
+        GetKeyFilterResponse response;
+        response.filter_id = 42;
+        response.seq = seq.load();
+        response.num_shards = kNumShards;
+        for (uint32_t i = 0; i < kNumShards; ++i) {
+            if (shards[i]->version() > since) {
+                response.shards.push_back({i, shards[i]->bits()});
+            }
+        }
+        return response;
+    };
+
+    KeyFilterView view;
+    EXPECT_FALSE(view.usable());
+    EXPECT_TRUE(view.MayContain("key"));
+
+    insert("key");
+    auto since = view.SyncPoints(1);
+    ASSERT_EQ(std::vector<uint64_t>{0}, since);
+    view.Apply(since, {respond(since[0])});
+    ASSERT_TRUE(view.usable());
+    EXPECT_TRUE(view.MayContain("key"));
+    EXPECT_FALSE(view.MayContain("missing"));
+
+    // Only the changed shard is sent
+    const uint64_t synced_seq = seq.load();
+    insert("new_key");
+    since = view.SyncPoints(1);
+    EXPECT_EQ(synced_seq, since[0]);
+    auto delta = respond(since[0]);
+    EXPECT_EQ(1, delta.shards.size());
+    view.Apply(since, {delta});
+    EXPECT_TRUE(view.MayContain("key"));
+    EXPECT_TRUE(view.MayContain("new_key"));
+
+    // A restarted master is not trusted until a full sync
+    auto restarted = respond(since[0]);
+    restarted.filter_id = 43;
+    view.Apply(view.SyncPoints(1), {restarted});
+    EXPECT_FALSE(view.usable());
+    EXPECT_TRUE(view.MayContain("missing"));
+    since = view.SyncPoints(1);
+    EXPECT_EQ(std::vector<uint64_t>{0}, since);
+
+    // Neither is a master that did not answer
+    view.Apply(since, {respond(0)});
+    EXPECT_TRUE(view.usable());
+    view.Apply(view.SyncPoints(1),
+               {tl::make_unexpected(ErrorCode::RPC_FAIL)});
+    EXPECT_FALSE(view.usable());
+}
+
+TEST_F(KeyFilterTest, MasterServiceExportsFilter) {
+    auto service_config = MasterServiceConfig::builder()
+                              .set_key_filter_bits_per_shard(1 << 10)
+                              .set_enable_key_prefix_index(true)
+                              .build();
+    auto service = std::make_unique<MasterService>(service_config);
+
+    Segment segment;
+    segment.id = generate_uuid();
+    segment.name = "test_segment";
+    segment.base = 0x300000000;
+    segment.size = 1024 * 1024 * 16;
+    segment.te_endpoint = segment.name;
+    const UUID client_id = generate_uuid();
+    ASSERT_TRUE(service->MountSegment(segment, client_id).has_value());
+
+    KeyFilterView view;
+    auto sync = [&] {
+        const auto since = view.SyncPoints(1);
+        view.Apply(since, {service->GetKeyFilter(since[0])});
+    };
+    sync();
+    ASSERT_TRUE(view.usable());
+    EXPECT_FALSE(view.MayContain("key"));
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    ASSERT_TRUE(service->PutStart(client_id, "key", 1024, config).has_value());
+    ASSERT_TRUE(
+        service->PutEnd(client_id, "key", ReplicaType::MEMORY).has_value());
+    EXPECT_FALSE(view.MayContain("key"));
+    sync();
+    EXPECT_TRUE(view.MayContain("key"));
+    // The prefix index still sees the keys
+    auto scan = service->ScanKeys("k", 0, 10);
+    ASSERT_TRUE(scan.has_value());
+    EXPECT_EQ(std::vector<std::string>{"key"}, scan->keys);
+
+    // Nothing changed, nothing is sent
+    auto unchanged = service->GetKeyFilter(view.SyncPoints(1)[0]);
+    ASSERT_TRUE(unchanged.has_value());
+    EXPECT_TRUE(unchanged->shards.empty());
+
+    ASSERT_TRUE(service->Remove("key", true).has_value());
+    sync();
+    EXPECT_FALSE(view.MayContain("key"));
+
+    auto disabled = std::make_unique<MasterService>(
+        MasterServiceConfig::builder().build());
+    auto response = disabled->GetKeyFilter(0);
+    ASSERT_FALSE(response.has_value());
+    EXPECT_EQ(ErrorCode::UNAVAILABLE_IN_CURRENT_MODE, response.error());
+}
+
+}  // namespace mooncake::test
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
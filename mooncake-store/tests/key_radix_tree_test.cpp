@@ -0,0 +1,137 @@
+#include "key_radix_tree.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <regex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+std::vector<std::string> Collect(const KeyRadixTree& tree,
+                                 const std::string& prefix) {
+    std::vector<std::string> keys;
+    tree.CollectWithPrefix(prefix, keys);
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+}  // namespace
+
+TEST(KeyRadixTreeTest, InsertEraseAndCollect) {
+    KeyRadixTree tree;
+    EXPECT_TRUE(tree.Insert("model/0/abc"));
+    EXPECT_TRUE(tree.Insert("model/0/abd"));
+    EXPECT_TRUE(tree.Insert("model/1/abc"));
+    EXPECT_TRUE(tree.Insert("model"));
+    EXPECT_FALSE(tree.Insert("model/0/abc"));
+    EXPECT_EQ(4, tree.size());
+
+    EXPECT_TRUE(tree.Contains("model"));
+    EXPECT_FALSE(tree.Contains("model/"));
+    EXPECT_FALSE(tree.Contains("model/0/ab"));
+
+    using Keys = std::vector<std::string>;
+    EXPECT_EQ((Keys{"model/0/abc", "model/0/abd"}), Collect(tree, "model/0"));
+    EXPECT_EQ((Keys{"model/0/abc", "model/0/abd"}), Collect(tree, "model/0/a"));
+    EXPECT_EQ((Keys{"model/1/abc"}), Collect(tree, "model/1/abc"));
+    EXPECT_EQ(4, Collect(tree, "").size());
+    EXPECT_TRUE(Collect(tree, "model/2").empty());
+    EXPECT_TRUE(Collect(tree, "model/0/abcd").empty());
+
+    EXPECT_FALSE(tree.Erase("model/0/ab"));
+    EXPECT_TRUE(tree.Erase("model/0/abc"));
+    EXPECT_FALSE(tree.Erase("model/0/abc"));
+    EXPECT_TRUE(tree.Erase("model"));
+    EXPECT_EQ((Keys{"model/0/abd", "model/1/abc"}), Collect(tree, "model"));
+    EXPECT_EQ(2, tree.size());
+}
+
+TEST(KeyRadixTreeTest, MatchesSortedSet) {
+    KeyRadixTree tree;
+    std::set<std::string> expected;
+    std::mt19937 generator(42);
+
+    for (int i = 0; i < 20000; i++) {
+        std::string key = "model/" + std::to_string(generator() % 4) + "/";
+        const int depth = generator() % 4;
+        for (int j = 0; j < depth; j++) {
+            key += std::to_string(generator() % 8);
+        }
+        if (generator() % 3 != 0) {
+            EXPECT_EQ(expected.insert(key).second, tree.Insert(key));
+        } else {
+            EXPECT_EQ(expected.erase(key) == 1, tree.Erase(key));
+        }
+    }
+    ASSERT_EQ(expected.size(), tree.size());
+
+    for (const std::string prefix : {"", "model/", "model/1/", "model/2/3"}) {
+        std::vector<std::string> expected_keys;
+        for (const auto& key : expected) {
+            if (key.compare(0, prefix.size(), prefix) == 0) {
+                expected_keys.push_back(key);
+            }
+        }
+        EXPECT_EQ(expected_keys, Collect(tree, prefix)) << prefix;
+    }
+}
+
+TEST(KeyRadixTreeTest, ObservesFlatKeyMap) {
+    FlatKeyMap<int> map;
+    KeyRadixTree tree;
+    map.set_observer(&tree);
+
+    for (int i = 0; i < 100; i++) {
+        map.emplace(std::piecewise_construct,
+                    std::forward_as_tuple("key/" + std::to_string(i)),
+                    std::forward_as_tuple(i));
+    }
+    EXPECT_EQ(100, tree.size());
+    map.erase("key/1");
+    EXPECT_FALSE(tree.Contains("key/1"));
+    EXPECT_EQ(10, Collect(tree, "key/1").size());
+    map.clear();
+    EXPECT_EQ(0, tree.size());
+}
+
+TEST(KeyRadixTreeTest, RegexLiteralPrefix) {
+    EXPECT_EQ("model/0/", GetRegexLiteralPrefix("^model/0/.*"));
+    EXPECT_EQ("model/0/", GetRegexLiteralPrefix("^model/0/[0-9]+"));
+    EXPECT_EQ("a.b", GetRegexLiteralPrefix("^a\\.b\\d"));
+    EXPECT_EQ("mode", GetRegexLiteralPrefix("^model?"));
+    EXPECT_EQ("model", GetRegexLiteralPrefix("^modelx*"));
+    EXPECT_EQ("model", GetRegexLiteralPrefix("^model+"));
+    EXPECT_EQ("model", GetRegexLiteralPrefix("^model$"));
+    EXPECT_EQ("a|", GetRegexLiteralPrefix("^a\\|"));
+    EXPECT_EQ("a", GetRegexLiteralPrefix("^a[|]"));
+
+    // No usable prefix
+    EXPECT_EQ("", GetRegexLiteralPrefix("model/0/.*"));
+    EXPECT_EQ("", GetRegexLiteralPrefix("^.*"));
+    EXPECT_EQ("", GetRegexLiteralPrefix("^model|other"));
+    EXPECT_EQ("", GetRegexLiteralPrefix("^(model)"));
+    EXPECT_EQ("", GetRegexLiteralPrefix(""));
+
+    // Every match starts with the prefix
+    const std::vector<std::string> keys = {"model", "model/0/1", "mode",
+                                           "modelmodel", "a.b1", "a|"};
+    for (const std::string pattern :
+         {"^model/0/.*", "^model?", "^model+", "^a\\.b\\d", "^a\\|"}) {
+        const std::string prefix = GetRegexLiteralPrefix(pattern);
+        std::regex regex(pattern, std::regex::ECMAScript);
+        for (const auto& key : keys) {
+            if (std::regex_search(key, regex)) {
+                EXPECT_EQ(0, key.compare(0, prefix.size(), prefix))
+                    << pattern << " " << key;
+            }
+        }
+    }
+}
+
+}  // namespace mooncake::test
@@ -0,0 +1,43 @@
+#include "latency_percentile.h"
+
+#include <gtest/gtest.h>
+
+namespace mooncake::test {
+
+TEST(LatencyPercentileTest, UnsetUntilEnoughSamples) {
+    LatencyPercentile p99(99);
+    for (size_t i = 1; i < LatencyPercentile::kRecomputeInterval; i++) {
+        p99.Record(i);
+    }
+    EXPECT_EQ(0, p99.Get());
+    p99.Record(LatencyPercentile::kRecomputeInterval);
+    EXPECT_EQ(LatencyPercentile::kRecomputeInterval * 99 / 100 + 1,
+              p99.Get());
+}
+
+TEST(LatencyPercentileTest, NearestRankOfTheWindow) {
+    LatencyPercentile p50(50);
+    LatencyPercentile p100(100);
+    for (uint64_t i = 1; i <= LatencyPercentile::kWindowSize; i++) {
+        p50.Record(i);
+        p100.Record(i);
+    }
+    EXPECT_EQ(LatencyPercentile::kWindowSize / 2, p50.Get());
+    EXPECT_EQ(LatencyPercentile::kWindowSize, p100.Get());
+}
+
+TEST(LatencyPercentileTest, OldSamplesLeaveTheWindow) {
+    LatencyPercentile p90(90);
+    for (size_t i = 0; i < LatencyPercentile::kWindowSize; i++) {
+        p90.Record(1000);
+    }
+    EXPECT_EQ(1000, p90.Get());
+
+    // The latency dropped, a full window later the slow samples are gone
+    for (size_t i = 0; i < LatencyPercentile::kWindowSize; i++) {
+        p90.Record(10);
+    }
+    EXPECT_EQ(10, p90.Get());
+}
+
+}  // namespace mooncake::test
@@ -427,6 +427,30 @@ TEST_F(MasterMetricsTest, BatchRequestTest) {
     ASSERT_EQ(metrics.get_batch_put_start_failed_items(), 3);
 }
 
+TEST_F(MasterMetricsTest, RpcLatencyBufferedPerThread) {
+    auto& metrics = MasterMetricManager::instance();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 3; i++) {
+        threads.emplace_back([&metrics] {
+            for (int j = 0; j < 10; j++) {
+                metrics.observe_rpc_latency("LatencyTestRpc", 150);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Fewer samples than a batch, serializing adds them all
+    std::string serialized = metrics.serialize_metrics();
+    EXPECT_NE(std::string::npos,
+              serialized.find(
+                  "master_rpc_latency_us_sum{rpc=\"LatencyTestRpc\"} 4500"));
+    EXPECT_NE(std::string::npos,
+              serialized.find(
+                  "master_rpc_latency_us_count{rpc=\"LatencyTestRpc\"} 30"));
+}
+
 }  // namespace mooncake::test
 
 int main(int argc, char** argv) {
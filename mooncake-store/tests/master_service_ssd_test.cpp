@@ -405,6 +405,68 @@ TEST_F(MasterServiceSSDTest, PutStartExpires) {
     test_discard_replica(ReplicaType::MEMORY);
 }
 
+TEST_F(MasterServiceSSDTest, PromotesRereadDiskOnlyObject) {
+    auto service_ = std::make_unique<MasterService>(
+        MasterServiceConfig::builder()
+            .set_root_fs_dir("/mnt/ssd")
+            .set_disk_promotion_reads(2)
+            .build());
+
+    std::string segment_name = "test_segment";
+    Segment segment;
+    segment.id = generate_uuid();
+    segment.name = segment_name;
+    segment.base = 0x300000000;
+    segment.size = 1024 * 1024 * 64;
+    segment.te_endpoint = segment.name;
+    UUID client_id = generate_uuid();
+    ASSERT_TRUE(service_->MountSegment(segment, client_id).has_value());
+
+    // Only the disk replica is kept
+    std::string key = "promote_key";
+    ReplicateConfig config;
+    config.replica_num = 1;
+    ASSERT_TRUE(service_->PutStart(client_id, key, 1024, config).has_value());
+    ASSERT_TRUE(
+        service_->PutEnd(client_id, key, ReplicaType::DISK).has_value());
+    ASSERT_TRUE(
+        service_->PutRevoke(client_id, key, ReplicaType::MEMORY).has_value());
+
+    ASSERT_TRUE(service_->GetReplicaList(key).has_value());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto fetch = service_->FetchTasks(client_id, /*batch_size=*/16);
+    ASSERT_TRUE(fetch.has_value());
+    EXPECT_TRUE(fetch->empty());
+
+    // The second read schedules the promotion
+    ASSERT_TRUE(service_->GetReplicaList(key).has_value());
+    std::vector<TaskAssignment> tasks;
+    for (int i = 0; i < 50 && tasks.empty(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        fetch = service_->FetchTasks(client_id, /*batch_size=*/16);
+        ASSERT_TRUE(fetch.has_value());
+        tasks = std::move(fetch.value());
+    }
+    ASSERT_EQ(1u, tasks.size());
+    EXPECT_EQ(TaskType::REPLICA_PROMOTE, tasks[0].type);
+
+    // The client copies from the disk replica
+    auto copy_start = service_->CopyStart(client_id, key, "", {segment_name});
+    ASSERT_TRUE(copy_start.has_value());
+    EXPECT_TRUE(copy_start->source.is_disk_replica());
+    ASSERT_EQ(1u, copy_start->targets.size());
+    ASSERT_TRUE(service_->CopyEnd(client_id, key).has_value());
+
+    auto get_result = service_->GetReplicaList(key);
+    ASSERT_TRUE(get_result.has_value());
+    ASSERT_EQ(2u, get_result->replicas.size());
+    size_t memory_replicas = 0;
+    for (const auto& replica : get_result->replicas) {
+        memory_replicas += replica.is_memory_replica();
+    }
+    EXPECT_EQ(1u, memory_replicas);
+}
+
 }  // namespace mooncake::test
 
 int main(int argc, char** argv) {
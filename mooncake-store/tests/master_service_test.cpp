@@ -8,6 +8,7 @@
 #include <random>
 #include <thread>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 
@@ -376,6 +377,224 @@ TEST_F(MasterServiceTest, PutStartEndFlow) {
     EXPECT_EQ(ReplicaStatus::COMPLETE, replica_list[0].status);
 }
 
+TEST_F(MasterServiceTest, PutStartReportsConcurrentPut) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID writer = generate_uuid();
+    const UUID waiter = generate_uuid();
+    const std::string key = "test_key";
+    ReplicateConfig config;
+    config.replica_num = 1;
+    ReplicateConfig wait_config = config;
+    wait_config.wait_for_concurrent_put = true;
+
+    ASSERT_TRUE(service_->PutStart(writer, key, 1024, config).has_value());
+    // Without the option, a put in progress looks like an existing object
+    auto result = service_->PutStart(waiter, key, 1024, config);
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(ErrorCode::OBJECT_ALREADY_EXISTS, result.error());
+    result = service_->PutStart(waiter, key, 1024, wait_config);
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(ErrorCode::OBJECT_PUT_IN_PROGRESS, result.error());
+
+    // The waiter takes over a revoked put
+    ASSERT_TRUE(
+        service_->PutRevoke(writer, key, ReplicaType::MEMORY).has_value());
+    ASSERT_TRUE(service_->PutStart(waiter, key, 1024, wait_config).has_value());
+    ASSERT_TRUE(service_->PutEnd(waiter, key, ReplicaType::MEMORY).has_value());
+
+    // and does not write a completed one
+    result = service_->PutStart(writer, key, 1024, wait_config);
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(ErrorCode::OBJECT_ALREADY_EXISTS, result.error());
+}
+
+TEST_F(MasterServiceTest, PutCommitMakesPrefixReadable) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID writer = generate_uuid();
+    const std::string key = "test_key";
+    ReplicateConfig config;
+    config.replica_num = 1;
+
+    auto missing = service_->GetCommittedReplicaList(key);
+    ASSERT_FALSE(missing.has_value());
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND, missing.error());
+
+    ASSERT_TRUE(service_->PutStart(writer, key, 1024, config).has_value());
+    auto result = service_->GetCommittedReplicaList(key);
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(ErrorCode::REPLICA_IS_NOT_READY, result.error());
+
+    ASSERT_TRUE(service_->PutCommit(writer, key, 256).has_value());
+    result = service_->GetCommittedReplicaList(key);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_FALSE(result->complete);
+    EXPECT_EQ(256, result->committed_bytes);
+    ASSERT_EQ(1, result->replicas.size());
+    EXPECT_EQ(ReplicaStatus::PROCESSING, result->replicas[0].status);
+    // Plain readers still wait for PutEnd
+    EXPECT_FALSE(service_->GetReplicaList(key).has_value());
+
+    // Only the writer commits, forward and within the object
+    EXPECT_EQ(ErrorCode::ILLEGAL_CLIENT,
+              service_->PutCommit(generate_uuid(), key, 512).error());
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS,
+              service_->PutCommit(writer, key, 128).error());
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS,
+              service_->PutCommit(writer, key, 2048).error());
+
+    ASSERT_TRUE(service_->PutEnd(writer, key, ReplicaType::MEMORY));
+    result = service_->GetCommittedReplicaList(key);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->complete);
+    ASSERT_EQ(1, result->replicas.size());
+    EXPECT_EQ(ReplicaStatus::COMPLETE, result->replicas[0].status);
+}
+
+TEST_F(MasterServiceTest, BatchPutStartGroupsKeysByShard) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+
+    ASSERT_TRUE(service_->PutStart(client_id, "existing", 1024, config));
+
+    std::vector<std::string> keys;
+    std::vector<uint64_t> slice_lengths;
+    for (int i = 0; i < 256; i++) {
+        keys.push_back("batch_key_" + std::to_string(i));
+        slice_lengths.push_back(1024);
+    }
+    keys.push_back("existing");
+    slice_lengths.push_back(1024);
+    keys.push_back("");
+    slice_lengths.push_back(1024);
+    keys.push_back("batch_key_0");
+    slice_lengths.push_back(1024);
+
+    auto results =
+        service_->BatchPutStart(client_id, keys, slice_lengths, config);
+    ASSERT_EQ(keys.size(), results.size());
+    // Results stay in the order of the keys
+    for (int i = 0; i < 256; i++) {
+        ASSERT_TRUE(results[i].has_value()) << keys[i];
+        EXPECT_EQ(ReplicaStatus::PROCESSING, results[i].value()[0].status);
+    }
+    EXPECT_EQ(ErrorCode::OBJECT_ALREADY_EXISTS, results[256].error());
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS, results[257].error());
+    EXPECT_EQ(ErrorCode::OBJECT_ALREADY_EXISTS, results[258].error());
+
+    auto end_results = service_->BatchPutEnd(
+        client_id, std::vector<std::string>(keys.begin(), keys.begin() + 256));
+    for (const auto& result : end_results) {
+        EXPECT_TRUE(result.has_value());
+    }
+    EXPECT_TRUE(service_->GetReplicaList("batch_key_255").has_value());
+
+    // Mismatched lengths fail every key
+    slice_lengths.pop_back();
+    results = service_->BatchPutStart(client_id, keys, slice_lengths, config);
+    ASSERT_EQ(keys.size(), results.size());
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS, results[0].error());
+}
+
+TEST_F(MasterServiceTest, BatchPutStartContiguous) {
+    auto service_config =
+        MasterServiceConfig::builder().set_batch_put_contiguous(true).build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+
+    std::vector<std::string> keys;
+    std::vector<uint64_t> slice_lengths;
+    for (int i = 0; i < 16; i++) {
+        keys.push_back("contiguous_key_" + std::to_string(i));
+        slice_lengths.push_back(4096 * (1 + i % 3));
+    }
+    auto results =
+        service_->BatchPutStart(client_id, keys, slice_lengths, config);
+    ASSERT_EQ(keys.size(), results.size());
+    // The objects follow each other in the order of the keys
+    uint64_t next_address = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        ASSERT_TRUE(results[i].has_value()) << keys[i];
+        const auto& buffer =
+            results[i].value()[0].get_memory_descriptor().buffer_descriptor;
+        EXPECT_EQ(slice_lengths[i], buffer.size_);
+        if (i > 0) {
+            EXPECT_EQ(next_address, buffer.buffer_address_) << keys[i];
+        }
+        next_address = buffer.buffer_address_ + buffer.size_;
+    }
+
+    auto end_results = service_->BatchPutEnd(client_id, keys);
+    for (const auto& result : end_results) {
+        EXPECT_TRUE(result.has_value());
+    }
+    // Each object is removed on its own
+    ASSERT_TRUE(service_->Remove(keys[3]).has_value());
+    EXPECT_FALSE(service_->GetReplicaList(keys[3]).has_value());
+    EXPECT_TRUE(service_->GetReplicaList(keys[4]).has_value());
+}
+
+TEST_F(MasterServiceTest, LinkBundle) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+    const std::string bundle =
+        std::string(BundleIndex::kBundleKeyPrefix) + "request_1";
+    const std::vector<std::string> keys = {"page_0", "page_1", "page_2"};
+    const std::vector<uint64_t> sizes = {1024, 2048, 1024};
+
+    // The bundle object must be complete
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND,
+              service_->LinkBundle(bundle, keys, sizes).error());
+    ASSERT_TRUE(service_->PutStart(client_id, bundle, 4096, config));
+    ASSERT_TRUE(service_->PutEnd(client_id, bundle, ReplicaType::MEMORY));
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS,
+              service_->LinkBundle(bundle, keys, {1024, 2048, 2048}).error());
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS,
+              service_->LinkBundle(bundle, {"a", "a"}, {1, 1}).error());
+
+    // Keys that are objects already are not linked
+    ASSERT_TRUE(service_->PutStart(client_id, "page_2", 1024, config));
+    EXPECT_EQ(ErrorCode::OBJECT_ALREADY_EXISTS,
+              service_->LinkBundle(bundle, keys, sizes).error());
+    EXPECT_FALSE(service_->BatchResolveBundle({"page_0"})[0].has_value());
+    ASSERT_TRUE(service_->PutRevoke(client_id, "page_2", ReplicaType::MEMORY));
+
+    ASSERT_TRUE(service_->LinkBundle(bundle, keys, sizes));
+    auto members = service_->BatchResolveBundle({"page_1", "other", "page_2"});
+    ASSERT_EQ(3u, members.size());
+    ASSERT_TRUE(members[0].has_value());
+    EXPECT_EQ(bundle, members[0]->bundle_key);
+    EXPECT_EQ(1024u, members[0]->offset);
+    EXPECT_EQ(2048u, members[0]->size);
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND, members[1].error());
+    ASSERT_TRUE(members[2].has_value());
+    EXPECT_EQ(3072u, members[2]->offset);
+
+    // Linked keys exist but cannot be put
+    EXPECT_TRUE(service_->ExistKey("page_0").value());
+    EXPECT_EQ(ErrorCode::OBJECT_ALREADY_EXISTS,
+              service_->PutStart(client_id, "page_0", 1024, config).error());
+
+    // The bundle object goes with its last key
+    ASSERT_TRUE(service_->Remove("page_0"));
+    ASSERT_TRUE(service_->Remove("page_1"));
+    EXPECT_TRUE(service_->GetReplicaList(bundle).has_value());
+    ASSERT_TRUE(service_->Remove("page_2", true));
+    EXPECT_FALSE(service_->BatchResolveBundle({"page_2"})[0].has_value());
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND,
+              service_->GetReplicaList(bundle).error());
+}
+
 TEST_F(MasterServiceTest, PutWithPreferredSegment) {
     // For backward compatibility, test the deprecated single preferred_segment
     std::unique_ptr<MasterService> service_(new MasterService());
@@ -506,6 +725,42 @@ TEST_F(MasterServiceTest, RandomPutStartEndFlow) {
     }
 }
 
+TEST_F(MasterServiceTest, TtlRemovesExpiredObjects) {
+    const uint64_t kv_lease_ttl = 50;
+    auto service_config = MasterServiceConfig::builder()
+                              .set_default_kv_lease_ttl(kv_lease_ttl)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+    ReplicateConfig ttl_config = config;
+    ttl_config.ttl_ms = 200;
+
+    ASSERT_TRUE(service_->PutStart(client_id, "ttl_key", 1024, ttl_config));
+    ASSERT_TRUE(service_->PutEnd(client_id, "ttl_key", ReplicaType::MEMORY));
+    ASSERT_TRUE(service_->PutStart(client_id, "kept_key", 1024, config));
+    ASSERT_TRUE(service_->PutEnd(client_id, "kept_key", ReplicaType::MEMORY));
+    const int64_t expired_before =
+        MasterMetricManager::instance().get_ttl_expired_key_count();
+
+    // Leased by the check, which only delays the expiry
+    auto exist_result = service_->ExistKey("ttl_key");
+    ASSERT_TRUE(exist_result.has_value());
+    EXPECT_TRUE(exist_result.value());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    exist_result = service_->ExistKey("ttl_key");
+    ASSERT_TRUE(exist_result.has_value());
+    EXPECT_FALSE(exist_result.value());
+    exist_result = service_->ExistKey("kept_key");
+    ASSERT_TRUE(exist_result.has_value());
+    EXPECT_TRUE(exist_result.value());
+    EXPECT_EQ(expired_before + 1,
+              MasterMetricManager::instance().get_ttl_expired_key_count());
+}
+
 TEST_F(MasterServiceTest, GetReplicaListByRegex) {
     const uint64_t kv_lease_ttl = 50;
     auto service_config = MasterServiceConfig::builder()
@@ -709,6 +964,40 @@ TEST_F(MasterServiceTest, GetReplicaList) {
     EXPECT_FALSE(replica_list_local.empty());
 }
 
+TEST_F(MasterServiceTest, GetReplicaListRenewsLeaseLazily) {
+    const uint64_t kv_lease_ttl = 1000;
+    auto service_config = MasterServiceConfig::builder()
+                              .set_default_kv_lease_ttl(kv_lease_ttl)
+                              .set_lazy_lease_renewal_ratio(0.5)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+
+    const UUID client_id = generate_uuid();
+    const std::string key = "test_key";
+    ReplicateConfig config;
+    config.replica_num = 1;
+    ASSERT_TRUE(service_->PutStart(client_id, key, 1024, config));
+    ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY));
+
+    auto first = service_->GetReplicaList(key);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(kv_lease_ttl, first->lease_ttl_ms);
+
+    // More than half of the lease is left, it is reported but not renewed
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto second = service_->GetReplicaList(key);
+    ASSERT_TRUE(second.has_value());
+    EXPECT_LE(second->lease_ttl_ms, kv_lease_ttl - 200);
+    EXPECT_GE(second->lease_ttl_ms, kv_lease_ttl / 2);
+
+    // Less than half is left, the lease is renewed
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    auto third = service_->GetReplicaList(key);
+    ASSERT_TRUE(third.has_value());
+    EXPECT_EQ(kv_lease_ttl, third->lease_ttl_ms);
+}
+
 TEST_F(MasterServiceTest, RemoveObject) {
     std::unique_ptr<MasterService> service_(new MasterService());
     [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
@@ -739,6 +1028,50 @@ TEST_F(MasterServiceTest, RemoveObject) {
     EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND, remove_result2.error());
 }
 
+TEST_F(MasterServiceTest, RemoveReclaimsMemoryAsynchronously) {
+    auto service_config = MasterServiceConfig::builder()
+                              .set_enable_async_replica_reclaim(true)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const size_t kSegmentSize = 16 * 1024 * 1024;
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(
+        *service_, "test_segment", kDefaultSegmentBase, kSegmentSize);
+    const UUID client_id = generate_uuid();
+    const uint64_t value_length = 1024 * 1024;
+    ReplicateConfig config;
+    config.replica_num = 1;
+
+    // Fill the segment
+    std::vector<std::string> keys;
+    for (int i = 0; i < 64; i++) {
+        std::string key = "key_" + std::to_string(i);
+        if (!service_->PutStart(client_id, key, value_length, config)) {
+            break;
+        }
+        ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY));
+        keys.push_back(key);
+    }
+    ASSERT_FALSE(keys.empty());
+    ASSERT_LT(keys.size(), 64u);
+
+    for (const auto& key : keys) {
+        ASSERT_TRUE(service_->Remove(key));
+    }
+
+    // All the memory comes back once the reclaim thread has run
+    for (const auto& key : keys) {
+        bool put = false;
+        for (int retry = 0; retry < 100 && !put; retry++) {
+            put = service_->PutStart(client_id, key, value_length, config)
+                      .has_value();
+            if (!put) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        ASSERT_TRUE(put) << "key=" << key;
+    }
+}
+
 TEST_F(MasterServiceTest, RandomRemoveObject) {
     std::unique_ptr<MasterService> service_(new MasterService());
     [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
@@ -807,6 +1140,155 @@ TEST_F(MasterServiceTest, RemoveByRegex) {
     }
 }
 
+TEST_F(MasterServiceTest, LongestCachedPrefix) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+    for (const std::string key : {"block_0", "block_1", "block_3"}) {
+        ASSERT_TRUE(
+            service_->PutStart(client_id, key, 1024, config).has_value());
+        ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY)
+                        .has_value());
+    }
+    // Not yet complete
+    ASSERT_TRUE(
+        service_->PutStart(client_id, "block_4", 1024, config).has_value());
+
+    const std::vector<std::string> keys = {"block_0", "block_1", "block_2",
+                                           "block_3"};
+    auto result = service_->LongestCachedPrefix(keys);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(2, result->size());
+    EXPECT_FALSE(result->at(0).replicas.empty());
+    EXPECT_GT(result->at(1).lease_ttl_ms, 0);
+
+    result = service_->LongestCachedPrefix({"block_3", "block_4"});
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(1, result->size());
+
+    result = service_->LongestCachedPrefix({"block_2", "block_0"});
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->empty());
+    result = service_->LongestCachedPrefix({});
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->empty());
+}
+
+TEST_F(MasterServiceTest, RegexWithKeyPrefixIndex) {
+    const uint64_t kv_lease_ttl = 50;
+    auto service_config = MasterServiceConfig::builder()
+                              .set_default_kv_lease_ttl(kv_lease_ttl)
+                              .set_enable_key_prefix_index(true)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    const std::vector<std::string> keys = {"model/0/a", "model/0/b",
+                                           "model/1/a", "other/0/a"};
+    for (const auto& key : keys) {
+        ReplicateConfig config;
+        config.replica_num = 1;
+        ASSERT_TRUE(
+            service_->PutStart(client_id, key, 1024, config).has_value());
+        ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY)
+                        .has_value());
+    }
+
+    auto get_result = service_->GetReplicaListByRegex("^model/0/.$");
+    ASSERT_TRUE(get_result.has_value());
+    EXPECT_EQ(2, get_result->size());
+    EXPECT_TRUE(get_result->contains("model/0/a"));
+    // Patterns without a literal prefix still scan every key
+    get_result = service_->GetReplicaListByRegex("/0/a$");
+    ASSERT_TRUE(get_result.has_value());
+    EXPECT_EQ(2, get_result->size());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    auto remove_result = service_->RemoveByRegex("^model/\\d/a");
+    ASSERT_TRUE(remove_result.has_value());
+    EXPECT_EQ(2, remove_result.value());
+    EXPECT_FALSE(service_->ExistKey("model/1/a").value());
+    EXPECT_TRUE(service_->ExistKey("model/0/b").value());
+
+    // Removed keys are dropped from the index
+    get_result = service_->GetReplicaListByRegex("^model/");
+    ASSERT_TRUE(get_result.has_value());
+    EXPECT_EQ(1, get_result->size());
+}
+
+TEST_F(MasterServiceTest, PingReportsReplicaInvalidationEpoch) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+    for (const std::string key : {"key_0", "key_1"}) {
+        ASSERT_TRUE(
+            service_->PutStart(client_id, key, 1024, config).has_value());
+        ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY)
+                        .has_value());
+    }
+    auto ping = service_->Ping(client_id);
+    ASSERT_TRUE(ping.has_value());
+    const uint64_t epoch = ping->replica_invalidation_epoch;
+
+    // Removals that respect leases keep cached locations valid
+    ASSERT_TRUE(service_->GetReplicaList("key_0").has_value());
+    EXPECT_FALSE(service_->Remove("key_0").has_value());
+    EXPECT_EQ(epoch, service_->Ping(client_id)->replica_invalidation_epoch);
+
+    ASSERT_TRUE(service_->Remove("key_0", true).has_value());
+    EXPECT_GT(service_->Ping(client_id)->replica_invalidation_epoch, epoch);
+}
+
+TEST_F(MasterServiceTest, PingReportsPutBackoff) {
+    auto service_config = MasterServiceConfig::builder()
+                              .set_eviction_high_watermark_ratio(0.0)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+    // Objects being put are not evicted, so the usage stays above the mark
+    ASSERT_TRUE(service_->PutStart(client_id, "key", 1024 * 1024, config)
+                    .has_value());
+
+    auto ping = service_->Ping(client_id);
+    ASSERT_TRUE(ping.has_value());
+    EXPECT_GT(ping->mem_used_ratio, 0.0);
+    EXPECT_GT(ping->put_backoff_ms, 0u);
+}
+
+TEST_F(MasterServiceTest, LoadAwareAllocationAvoidsBusyClients) {
+    auto service_config =
+        MasterServiceConfig::builder()
+            .set_allocation_strategy(AllocationStrategyType::LOAD_AWARE)
+            .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const auto busy = PrepareSimpleSegment(*service_, "busy", 0x300000000);
+    const auto idle = PrepareSimpleSegment(*service_, "idle", 0x400000000);
+    // The load reported in Ping applies to the segments of the client
+    ASSERT_TRUE(service_->Ping(busy.client_id, 10ULL << 30).has_value());
+    ASSERT_TRUE(service_->Ping(idle.client_id, 1ULL << 30).has_value());
+
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+    std::unordered_map<std::string, int> counts;
+    for (int i = 0; i < 40; i++) {
+        auto result = service_->PutStart(client_id, "key_" + std::to_string(i),
+                                         1024, config);
+        ASSERT_TRUE(result.has_value());
+        counts[result.value()[0]
+                   .get_memory_descriptor()
+                   .buffer_descriptor.transport_endpoint_]++;
+    }
+    EXPECT_GT(counts["idle"], counts["busy"]);
+}
+
 TEST_F(MasterServiceTest, CopyStart) {
     const uint64_t kv_lease_ttl = 50;
     auto service_config = MasterServiceConfig::builder()
@@ -1822,6 +2304,90 @@ TEST_F(MasterServiceTest, RemoveAll) {
     }
 }
 
+TEST_F(MasterServiceTest, RemoveByPrefix) {
+    const uint64_t kv_lease_ttl = 500;
+    auto service_config = MasterServiceConfig::builder()
+                              .set_default_kv_lease_ttl(kv_lease_ttl)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    std::vector<std::string> keys;
+    for (int i = 0; i < 10; i++) {
+        keys.push_back("model_a/layer" + std::to_string(i));
+    }
+    keys.push_back("model_b/layer0");
+    for (const auto& key : keys) {
+        ReplicateConfig config;
+        config.replica_num = 1;
+        ASSERT_TRUE(service_->PutStart(client_id, key, 1024, config));
+        ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY));
+    }
+    // Once the leases expired, read to hold a lease on one of the objects
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    ASSERT_TRUE(service_->GetReplicaList("model_a/layer1"));
+
+    auto task_id = service_->RemoveByPrefix("model_a/");
+    ASSERT_TRUE(task_id.has_value());
+    tl::expected<QueryTaskResponse, ErrorCode> task =
+        tl::make_unexpected(ErrorCode::TASK_NOT_FOUND);
+    for (int i = 0; i < 50; i++) {
+        task = service_->QueryTask(task_id.value());
+        ASSERT_TRUE(task.has_value());
+        if (is_finished_status(task->status)) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ASSERT_EQ(TaskStatus::SUCCESS, task->status);
+    EXPECT_EQ(TaskType::PREFIX_REMOVE, task->type);
+    EXPECT_NE(std::string::npos, task->message.find("removed_count=9"));
+
+    // The leased object and the other prefix are kept
+    for (const auto& key : keys) {
+        auto exist_result = service_->ExistKey(key);
+        ASSERT_TRUE(exist_result.has_value());
+        EXPECT_EQ(key == "model_a/layer1" || key == "model_b/layer0",
+                  exist_result.value())
+            << key;
+    }
+}
+
+TEST_F(MasterServiceTest, ScanKeys) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = generate_uuid();
+    std::unordered_set<std::string> expected;
+    for (int i = 0; i < 100; i++) {
+        const std::string key = (i % 2 ? "odd/" : "even/") + std::to_string(i);
+        ReplicateConfig config;
+        config.replica_num = 1;
+        ASSERT_TRUE(service_->PutStart(client_id, key, 1024, config));
+        ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY));
+        if (i % 2) {
+            expected.insert(key);
+        }
+    }
+
+    std::unordered_set<std::string> scanned;
+    uint64_t cursor = 0;
+    size_t pages = 0;
+    do {
+        auto page = service_->ScanKeys("odd/", cursor, 8);
+        ASSERT_TRUE(page.has_value());
+        for (const auto& key : page->keys) {
+            EXPECT_TRUE(scanned.insert(key).second) << key;
+        }
+        cursor = page->next_cursor;
+        pages++;
+    } while (cursor != 0);
+    EXPECT_EQ(expected, scanned);
+    EXPECT_GT(pages, 1u);
+
+    EXPECT_FALSE(service_->ScanKeys("", 0, 0).has_value());
+    EXPECT_FALSE(service_->ScanKeys("", 1 << 20, 8).has_value());
+}
+
 TEST_F(MasterServiceTest, SingleSliceMultiReplicaFlow) {
     const uint64_t kv_lease_ttl = 50;
     auto service_config = MasterServiceConfig::builder()
@@ -1889,6 +2455,86 @@ TEST_F(MasterServiceTest, SingleSliceMultiReplicaFlow) {
     }
 }
 
+TEST_F(MasterServiceTest, StripedPutSurvivesParityCountSegmentLosses) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+    const UUID client_id = generate_uuid();
+
+    // Mount 6 segments for a 4+2 stripe
+    constexpr size_t kBaseAddr = 0x300000000;
+    constexpr size_t kSegmentSize = 1024 * 1024 * 16;  // 16MB
+    std::vector<MountedSegmentContext> contexts;
+    for (int i = 0; i < 6; ++i) {
+        contexts.push_back(PrepareSimpleSegment(
+            *service_, "segment_" + std::to_string(i),
+            kBaseAddr + static_cast<size_t>(i) * kSegmentSize, kSegmentSize));
+    }
+
+    const std::string key = "striped_object";
+    constexpr size_t kObjectSize = 1024 * 1024 + 3;
+    constexpr size_t kChunkSize = (kObjectSize + 3) / 4;
+    ReplicateConfig config;
+    config.stripe_data_chunks = 4;
+    config.stripe_parity_chunks = 2;
+
+    auto put_start_result =
+        service_->PutStart(client_id, key, kObjectSize, config);
+    ASSERT_TRUE(put_start_result.has_value());
+    ASSERT_EQ(1, put_start_result->size());
+    const auto& replica = put_start_result->front();
+    ASSERT_TRUE(replica.is_striped_replica());
+    const auto& striped = replica.get_striped_descriptor();
+    EXPECT_EQ(4, striped.data_chunks);
+    EXPECT_EQ(kObjectSize, striped.object_size);
+    ASSERT_EQ(6, striped.chunk_descriptors.size());
+    std::unordered_set<std::string> endpoints;
+    for (const auto& chunk : striped.chunk_descriptors) {
+        EXPECT_EQ(kChunkSize, chunk.size_);
+        endpoints.insert(chunk.transport_endpoint_);
+    }
+    // Each chunk is on its own segment
+    EXPECT_EQ(6, endpoints.size());
+
+    ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY));
+    auto get_result = service_->GetReplicaList(key);
+    ASSERT_TRUE(get_result.has_value());
+    ASSERT_EQ(1, get_result->replicas.size());
+    EXPECT_EQ(ReplicaStatus::COMPLETE, get_result->replicas[0].status);
+
+    // Losing as many segments as there are parity chunks keeps the object
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_TRUE(service_->UnmountSegment(contexts[i].segment_id,
+                                             contexts[i].client_id));
+    }
+    get_result = service_->GetReplicaList(key);
+    ASSERT_TRUE(get_result.has_value());
+    size_t lost_chunks = 0;
+    for (const auto& chunk :
+         get_result->replicas[0].get_striped_descriptor().chunk_descriptors) {
+        lost_chunks += chunk.size_ == 0;
+    }
+    EXPECT_EQ(2, lost_chunks);
+
+    // One more and the object is gone
+    ASSERT_TRUE(service_->UnmountSegment(contexts[2].segment_id,
+                                         contexts[2].client_id));
+    get_result = service_->GetReplicaList(key);
+    ASSERT_FALSE(get_result.has_value());
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND, get_result.error());
+
+    // Every chunk needs a segment of its own
+    put_start_result =
+        service_->PutStart(client_id, "too_wide", kObjectSize, config);
+    ASSERT_FALSE(put_start_result.has_value());
+    EXPECT_EQ(ErrorCode::NO_AVAILABLE_HANDLE, put_start_result.error());
+
+    // Parity chunks without data chunks
+    config.stripe_data_chunks = 0;
+    put_start_result =
+        service_->PutStart(client_id, "invalid", kObjectSize, config);
+    ASSERT_FALSE(put_start_result.has_value());
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS, put_start_result.error());
+}
+
 TEST_F(MasterServiceTest, CleanupStaleHandlesTest) {
     std::unique_ptr<MasterService> service_(new MasterService());
 
@@ -2282,6 +2928,49 @@ TEST_F(MasterServiceTest, ReadableAfterPartialUnmountWithReplication) {
         << "Object should remain accessible with surviving replica";
 }
 
+TEST_F(MasterServiceTest, DrainSegmentBeforeUnmount) {
+    std::unique_ptr<MasterService> service_(new MasterService());
+
+    constexpr size_t buffer1 = 0x300000000;
+    constexpr size_t buffer2 = 0x400000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    auto segment1 = MakeSegment("segment1", buffer1, size);
+    auto segment2 = MakeSegment("segment2", buffer2, size);
+    UUID client_id = generate_uuid();
+    ASSERT_TRUE(service_->MountSegment(segment1, client_id).has_value());
+    ASSERT_TRUE(service_->MountSegment(segment2, client_id).has_value());
+    std::string key1 =
+        GenerateKeyForSegment(client_id, service_, segment1.name);
+
+    // Only the owner can drain a segment
+    auto other_result = service_->DrainSegment(segment1.id, generate_uuid());
+    ASSERT_FALSE(other_result.has_value());
+    EXPECT_EQ(ErrorCode::INVALID_PARAMS, other_result.error());
+
+    auto drain_result = service_->DrainSegment(segment1.id, client_id);
+    ASSERT_TRUE(drain_result.has_value());
+    EXPECT_GT(drain_result.value(), 0u);
+
+    // The draining segment stays readable but takes no new objects
+    EXPECT_TRUE(service_->GetReplicaList(key1).has_value());
+    for (int i = 0; i < 10; i++) {
+        std::string key = "drain_key_" + std::to_string(i);
+        auto put_result =
+            service_->PutStart(client_id, key, 1024, {.replica_num = 1});
+        ASSERT_TRUE(put_result.has_value());
+        EXPECT_EQ(segment2.name, put_result.value()[0]
+                                     .get_memory_descriptor()
+                                     .buffer_descriptor.transport_endpoint_);
+        ASSERT_TRUE(
+            service_->PutEnd(client_id, key, ReplicaType::MEMORY).has_value());
+    }
+
+    // Draining again is idempotent
+    EXPECT_EQ(drain_result, service_->DrainSegment(segment1.id, client_id));
+    ASSERT_TRUE(service_->UnmountSegment(segment1.id, client_id).has_value());
+    EXPECT_FALSE(service_->DrainSegment(segment1.id, client_id).has_value());
+}
+
 TEST_F(MasterServiceTest, UnmountSegmentPerformance) {
     std::unique_ptr<MasterService> service_(new MasterService());
     constexpr size_t kBufferAddress = 0x300000000;
@@ -2564,11 +3253,62 @@ TEST_F(MasterServiceTest, TryEvictLeasedObject) {
     service_->RemoveAll();
 }
 
-TEST_F(MasterServiceTest, RemoveSoftPinObject) {
-    const uint64_t kv_lease_ttl = 200;
-    // set a large soft_pin_ttl so the granted soft pin will not quickly expire
-    const uint64_t kv_soft_pin_ttl = 10000;
-    const bool allow_evict_soft_pinned_objects = true;
+TEST_F(MasterServiceTest, PutStartEvictsInline) {
+    const uint64_t kv_lease_ttl = 500;
+    auto service_config = MasterServiceConfig::builder()
+                              .set_default_kv_lease_ttl(kv_lease_ttl)
+                              .set_put_start_eviction_retries(2)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const UUID client_id = generate_uuid();
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    constexpr size_t object_size = 1024 * 1024;
+    [[maybe_unused]] const auto context =
+        PrepareSimpleSegment(*service_, "test_segment", buffer, size);
+
+    // Objects without lease are evicted by the PutStart that needs space,
+    // so puts never fail.
+    ReplicateConfig config;
+    config.replica_num = 1;
+    for (int i = 0; i < 16 * 3; ++i) {
+        std::string key = "test_key" + std::to_string(i);
+        ASSERT_TRUE(service_->PutStart(client_id, key, object_size, config)
+                        .has_value());
+        ASSERT_TRUE(
+            service_->PutEnd(client_id, key, ReplicaType::MEMORY).has_value());
+    }
+    // Leased objects are not evicted
+    std::vector<std::string> keys = service_->GetAllKeys().value();
+    for (const auto& key : keys) {
+        ASSERT_TRUE(service_->GetReplicaList(key).has_value());
+    }
+    bool put_failed = false;
+    for (int i = 0; i < 16 && !put_failed; ++i) {
+        std::string key = "leased_test_key" + std::to_string(i);
+        auto result = service_->PutStart(client_id, key, object_size, config);
+        if (result.has_value()) {
+            ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY)
+                            .has_value());
+            ASSERT_TRUE(service_->GetReplicaList(key).has_value());
+        } else {
+            EXPECT_EQ(ErrorCode::NO_AVAILABLE_HANDLE, result.error());
+            put_failed = true;
+        }
+    }
+    EXPECT_TRUE(put_failed);
+    for (const auto& key : keys) {
+        EXPECT_TRUE(service_->GetReplicaList(key).has_value());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+    service_->RemoveAll();
+}
+
+TEST_F(MasterServiceTest, RemoveSoftPinObject) {
+    const uint64_t kv_lease_ttl = 200;
+    // set a large soft_pin_ttl so the granted soft pin will not quickly expire
+    const uint64_t kv_soft_pin_ttl = 10000;
+    const bool allow_evict_soft_pinned_objects = true;
     auto service_config = MasterServiceConfig::builder()
                               .set_default_kv_lease_ttl(kv_lease_ttl)
                               .set_default_kv_soft_pin_ttl(kv_soft_pin_ttl)
@@ -2679,6 +3419,318 @@ TEST_F(MasterServiceTest, SoftPinObjectsNotEvictedBeforeOtherObjects) {
     }
 }
 
+TEST_F(MasterServiceTest, SieveEvictionSparesReadObjects) {
+    const uint64_t kv_lease_ttl = 200;
+    const double eviction_ratio = 0.5;
+    auto service_config = MasterServiceConfig::builder()
+                              .set_default_kv_lease_ttl(kv_lease_ttl)
+                              .set_eviction_ratio(eviction_ratio)
+                              .set_eviction_policy(EvictionPolicy::SIEVE)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const UUID client_id = generate_uuid();
+
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t segment_size = 1024 * 1024 * 16;
+    constexpr size_t value_size = 1024 * 1024;
+    [[maybe_unused]] const auto context =
+        PrepareSimpleSegment(*service_, "test_segment", buffer, segment_size);
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    // The eviction has random factors, so test 3 times
+    for (int test_i = 0; test_i < 3; test_i++) {
+        // Put and read hot_key first, so it has the oldest lease
+        for (int i = 0; i < 2; i++) {
+            std::string hot_key = "hot_key" + std::to_string(i);
+            ASSERT_TRUE(
+                service_->PutStart(client_id, hot_key, value_size, config)
+                    .has_value());
+            ASSERT_TRUE(
+                service_->PutEnd(client_id, hot_key, ReplicaType::MEMORY)
+                    .has_value());
+            ASSERT_TRUE(service_->GetReplicaList(hot_key).has_value());
+        }
+        // wait for the lease to expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+
+        // Fill the segment with objects that are never read
+        bool put_failed = false;
+        for (int i = 0; i < 20 && !put_failed; i++) {
+            std::string key = "key" + std::to_string(i);
+            if (service_->PutStart(client_id, key, value_size, config)
+                    .has_value()) {
+                ASSERT_TRUE(
+                    service_->PutEnd(client_id, key, ReplicaType::MEMORY)
+                        .has_value());
+            } else {
+                put_failed = true;
+            }
+        }
+        ASSERT_TRUE(put_failed);
+        // wait for eviction to do eviction
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(kv_lease_ttl + 1000));
+        // hot_key should still be accessible
+        for (int i = 0; i < 2; i++) {
+            std::string hot_key = "hot_key" + std::to_string(i);
+            ASSERT_TRUE(service_->GetReplicaList(hot_key).has_value());
+        }
+
+        // wait for the lease to expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+        // remove all objects before the next turn
+        service_->RemoveAll();
+    }
+}
+
+TEST_F(MasterServiceTest, CostAwareEvictionPrefersLargeCheapObjects) {
+    const double eviction_ratio = 0.5;
+    auto service_config = MasterServiceConfig::builder()
+                              .set_eviction_ratio(eviction_ratio)
+                              .set_eviction_policy(EvictionPolicy::COST_AWARE)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const UUID client_id = generate_uuid();
+
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t segment_size = 1024 * 1024 * 16;
+    constexpr size_t value_size = 1024 * 1024;
+    constexpr size_t small_value_size = 64 * 1024;
+    [[maybe_unused]] const auto context =
+        PrepareSimpleSegment(*service_, "test_segment", buffer, segment_size);
+
+    // The policy ranks objects within a shard, so use keys of one shard
+    std::vector<std::string> shard_keys;
+    for (int i = 0; shard_keys.size() < 9; i++) {
+        std::string key = "shard_key" + std::to_string(i);
+        if (std::hash<std::string>{}(key) % 1024 == 0) {
+            shard_keys.push_back(key);
+        }
+    }
+    auto put = [&](const std::string& key, uint64_t size,
+                   uint32_t recompute_cost) {
+        ReplicateConfig config;
+        config.replica_num = 1;
+        config.recompute_cost = recompute_cost;
+        if (!service_->PutStart(client_id, key, size, config).has_value()) {
+            return false;
+        }
+        EXPECT_TRUE(
+            service_->PutEnd(client_id, key, ReplicaType::MEMORY).has_value());
+        return true;
+    };
+    // Two small objects, one large object that is expensive to recompute,
+    // and large cheap ones that should be evicted first.
+    ASSERT_TRUE(put(shard_keys[0], small_value_size, 0));
+    ASSERT_TRUE(put(shard_keys[1], small_value_size, 0));
+    ASSERT_TRUE(put(shard_keys[2], value_size, 1000));
+    for (size_t i = 3; i < shard_keys.size(); i++) {
+        ASSERT_TRUE(put(shard_keys[i], value_size, 0));
+    }
+
+    // Fill the segment to trigger eviction
+    bool put_failed = false;
+    for (int i = 0; i < 20 && !put_failed; i++) {
+        put_failed = !put("key" + std::to_string(i), value_size, 0);
+    }
+    ASSERT_TRUE(put_failed);
+    // wait for eviction to do eviction
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_TRUE(service_->ExistKey(shard_keys[i]).value());
+    }
+    size_t evicted = 0;
+    for (size_t i = 3; i < shard_keys.size(); i++) {
+        evicted += !service_->ExistKey(shard_keys[i]).value();
+    }
+    EXPECT_GT(evicted, 0);
+}
+
+TEST_F(MasterServiceTest, S3FifoEvictionSparesReadObjects) {
+    const uint64_t kv_lease_ttl = 200;
+    const double eviction_ratio = 0.5;
+    auto service_config = MasterServiceConfig::builder()
+                              .set_default_kv_lease_ttl(kv_lease_ttl)
+                              .set_eviction_ratio(eviction_ratio)
+                              .set_eviction_policy(EvictionPolicy::S3FIFO)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const UUID client_id = generate_uuid();
+
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t segment_size = 1024 * 1024 * 16;
+    constexpr size_t value_size = 1024 * 1024;
+    [[maybe_unused]] const auto context =
+        PrepareSimpleSegment(*service_, "test_segment", buffer, segment_size);
+
+    ReplicateConfig config;
+    config.replica_num = 1;
+    // The eviction has random factors, so test 3 times
+    for (int test_i = 0; test_i < 3; test_i++) {
+        // Put and read hot_key first, so it has the oldest lease
+        for (int i = 0; i < 2; i++) {
+            std::string hot_key = "hot_key" + std::to_string(i);
+            ASSERT_TRUE(
+                service_->PutStart(client_id, hot_key, value_size, config)
+                    .has_value());
+            ASSERT_TRUE(
+                service_->PutEnd(client_id, hot_key, ReplicaType::MEMORY)
+                    .has_value());
+            ASSERT_TRUE(service_->GetReplicaList(hot_key).has_value());
+        }
+        // wait for the lease to expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+
+        // Fill the segment with objects that are never read
+        bool put_failed = false;
+        for (int i = 0; i < 20 && !put_failed; i++) {
+            std::string key = "key" + std::to_string(i);
+            if (service_->PutStart(client_id, key, value_size, config)
+                    .has_value()) {
+                ASSERT_TRUE(
+                    service_->PutEnd(client_id, key, ReplicaType::MEMORY)
+                        .has_value());
+            } else {
+                put_failed = true;
+            }
+        }
+        ASSERT_TRUE(put_failed);
+        // wait for eviction to do eviction
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(kv_lease_ttl + 1000));
+        // hot_key moved to the main queue and should still be accessible
+        for (int i = 0; i < 2; i++) {
+            std::string hot_key = "hot_key" + std::to_string(i);
+            ASSERT_TRUE(service_->GetReplicaList(hot_key).has_value());
+        }
+
+        // wait for the lease to expire
+        std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+        // remove all objects before the next turn
+        service_->RemoveAll();
+    }
+}
+
+TEST_F(MasterServiceTest, S3FifoGhostKeysSkipSmallQueue) {
+    // Only the inline eviction of PutStart runs, so that the order of the
+    // evictions is deterministic
+    auto service_config = MasterServiceConfig::builder()
+                              .set_eviction_ratio(0.0)
+                              .set_eviction_high_watermark_ratio(1.0)
+                              .set_put_start_eviction_retries(1)
+                              .set_eviction_policy(EvictionPolicy::S3FIFO)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const UUID client_id = generate_uuid();
+
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t segment_size = 1024 * 1024 * 16;
+    constexpr size_t value_size = 1024 * 1024;
+    [[maybe_unused]] const auto context =
+        PrepareSimpleSegment(*service_, "test_segment", buffer, segment_size);
+
+    // The policy ranks objects within a shard, so use keys of one shard
+    std::vector<std::string> shard_keys;
+    for (int i = 0; shard_keys.size() < 40; i++) {
+        std::string key = "shard_key" + std::to_string(i);
+        if (std::hash<std::string>{}(key) % 1024 == 0) {
+            shard_keys.push_back(key);
+        }
+    }
+    ReplicateConfig config;
+    config.replica_num = 1;
+    auto put = [&](const std::string& key) {
+        ASSERT_TRUE(
+            service_->PutStart(client_id, key, value_size, config).has_value());
+        ASSERT_TRUE(
+            service_->PutEnd(client_id, key, ReplicaType::MEMORY).has_value());
+    };
+
+    // Fill the segment, then evict the never read ghost_key from the small
+    // queue by putting one more object
+    const std::string& ghost_key = shard_keys[0];
+    size_t next = 0;
+    while (next < 17) {
+        put(shard_keys[next++]);
+    }
+    ASSERT_FALSE(service_->ExistKey(ghost_key).value());
+
+    // Put back, ghost_key enters the main queue and outlives the objects
+    // put after it, which stay in the small queue
+    put(ghost_key);
+    const std::string& control_key = shard_keys[next++];
+    put(control_key);
+    for (int i = 0; i < 15; i++) {
+        put(shard_keys[next++]);
+    }
+    EXPECT_TRUE(service_->ExistKey(ghost_key).value());
+    EXPECT_FALSE(service_->ExistKey(control_key).value());
+}
+
+TEST_F(MasterServiceTest, TinyLfuAdmissionKeepsHotObjects) {
+    const uint64_t kv_lease_ttl = 200;
+    // Only the inline eviction of PutStart runs, which admission applies to
+    auto service_config = MasterServiceConfig::builder()
+                              .set_default_kv_lease_ttl(kv_lease_ttl)
+                              .set_eviction_ratio(0.0)
+                              .set_eviction_high_watermark_ratio(1.0)
+                              .set_put_start_eviction_retries(1)
+                              .set_enable_tinylfu_admission(true)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const UUID client_id = generate_uuid();
+
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t segment_size = 1024 * 1024 * 16;
+    constexpr size_t value_size = 1024 * 1024;
+    [[maybe_unused]] const auto context =
+        PrepareSimpleSegment(*service_, "test_segment", buffer, segment_size);
+
+    // Fill the segment with objects read twice
+    ReplicateConfig config;
+    config.replica_num = 1;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 20; i++) {
+        std::string key = "key" + std::to_string(i);
+        if (!service_->PutStart(client_id, key, value_size, config)) {
+            break;
+        }
+        ASSERT_TRUE(
+            service_->PutEnd(client_id, key, ReplicaType::MEMORY).has_value());
+        keys.push_back(key);
+    }
+    ASSERT_FALSE(keys.empty());
+    ASSERT_LT(keys.size(), 20u);
+    for (int i = 0; i < 2; i++) {
+        for (const auto& key : keys) {
+            ASSERT_TRUE(service_->GetReplicaList(key).has_value());
+        }
+    }
+    // wait for the lease to expire
+    std::this_thread::sleep_for(std::chrono::milliseconds(kv_lease_ttl));
+
+    // A key never accessed does not displace them
+    auto result = service_->PutStart(client_id, "cold_key", value_size, config);
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(ErrorCode::NO_AVAILABLE_HANDLE, result.error());
+
+    // A key missed more often than they were read does
+    for (int i = 0; i < 5; i++) {
+        EXPECT_FALSE(service_->GetReplicaList("hot_key").has_value());
+    }
+    ASSERT_TRUE(service_->PutStart(client_id, "hot_key", value_size, config)
+                    .has_value());
+    ASSERT_TRUE(service_->PutEnd(client_id, "hot_key", ReplicaType::MEMORY)
+                    .has_value());
+    size_t evicted = 0;
+    for (const auto& key : keys) {
+        evicted += !service_->ExistKey(key).value();
+    }
+    EXPECT_EQ(1, evicted);
+}
+
 TEST_F(MasterServiceTest, SoftPinObjectsCanBeEvicted) {
     const uint64_t kv_lease_ttl = 200;
     // set a large soft_pin_ttl so the granted soft pin will not quickly expire
@@ -3350,6 +4402,82 @@ TEST_F(MasterServiceTest, OffloadObjectHeartbeat) {
     }
 }
 
+TEST_F(MasterServiceTest, OffloadObjectHeartbeatReturnsBoundedBatches) {
+    constexpr size_t key_cnt = 250;
+    constexpr uint64_t max_objects = 100;
+    MasterServiceConfig config;
+    config.enable_offload = true;
+    std::unique_ptr<MasterService> service_(new MasterService(config));
+    UUID client_id = generate_uuid();
+    constexpr size_t buffer = 0x300000000;
+    constexpr size_t size = 1024 * 1024 * 16;
+    auto segment = MakeSegment("segment", buffer, size);
+    ASSERT_TRUE(service_->MountSegment(segment, client_id).has_value());
+    ASSERT_TRUE(service_->MountLocalDiskSegment(client_id, true).has_value());
+    std::unordered_set<std::string> keys;
+    for (size_t i = 0; i < key_cnt; i++) {
+        keys.insert(GenerateKeyForSegment(client_id, service_, segment.name));
+    }
+
+    // The queue drains over several heartbeats, each object exactly once
+    std::vector<size_t> batch_sizes;
+    std::unordered_set<std::string> offloaded;
+    for (int i = 0; i < 4; i++) {
+        auto res =
+            service_->OffloadObjectHeartbeat(client_id, true, max_objects);
+        ASSERT_TRUE(res.has_value());
+        batch_sizes.push_back(res->size());
+        for (const auto& [key, object_size] : res.value()) {
+            EXPECT_TRUE(offloaded.insert(key).second) << key;
+        }
+    }
+    EXPECT_EQ(batch_sizes, (std::vector<size_t>{100, 100, 50, 0}));
+    EXPECT_EQ(offloaded, keys);
+}
+
+TEST_F(MasterServiceTest, TieringOffloadsColdObjectsAboveTarget) {
+    auto service_config = MasterServiceConfig::builder()
+                              .set_enable_offload(true)
+                              .set_memory_tier_target_ratio(0.1)
+                              .set_tier_demotion_min_idle_sec(0)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const UUID client_id = generate_uuid();
+    constexpr size_t size = 1024 * 1024 * 16;
+    auto segment = MakeSegment("segment", 0x300000000, size);
+    ASSERT_TRUE(service_->MountSegment(segment, client_id).has_value());
+    ASSERT_TRUE(service_->MountLocalDiskSegment(client_id, true).has_value());
+
+    constexpr size_t value_size = 1024 * 1024;
+    ReplicateConfig config;
+    config.replica_num = 1;
+    for (int i = 0; i < 4; i++) {
+        const std::string key = "key_" + std::to_string(i);
+        ASSERT_TRUE(
+            service_->PutStart(client_id, key, value_size, config).has_value());
+        ASSERT_TRUE(
+            service_->PutEnd(client_id, key, ReplicaType::MEMORY).has_value());
+    }
+    // The lease of a read object keeps it in memory
+    ASSERT_TRUE(service_->GetReplicaList("key_0").has_value());
+
+    // Objects are no longer offloaded on PutEnd but once memory exceeds the
+    // target, and only as many as needed to get back under it
+    std::unordered_map<std::string, int64_t> offloaded;
+    for (int i = 0; i < 50; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto res = service_->OffloadObjectHeartbeat(client_id, true);
+        ASSERT_TRUE(res.has_value());
+        offloaded.insert(res->begin(), res->end());
+    }
+    EXPECT_FALSE(offloaded.contains("key_0"));
+    EXPECT_GE(offloaded.size(), 1u);
+    EXPECT_LE(offloaded.size(), 3u);
+    for (const auto& [key, object_size] : offloaded) {
+        EXPECT_EQ(static_cast<int64_t>(value_size), object_size) << key;
+    }
+}
+
 TEST_F(MasterServiceTest, BatchReplicaClearAllSegments) {
     const uint64_t kv_lease_ttl = 50;
     auto service_config = MasterServiceConfig::builder()
@@ -3958,6 +5086,280 @@ TEST_F(MasterServiceTest, FetchTasksReturnsAssignedTasksOnlyAndDrainsQueue) {
     EXPECT_TRUE(fetch0_again->empty());
 }
 
+TEST_F(MasterServiceTest, CompactionMovesObjectsOutOfFragmentedSegment) {
+    auto service_config = MasterServiceConfig::builder()
+                              .set_compaction_fragmentation_threshold(0.3)
+                              .set_compaction_moves_per_sec(64)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const auto ctx0 = PrepareSimpleSegment(*service_, "segment_0", 0x300000000,
+                                           kDefaultSegmentSize);
+    const auto ctx1 = PrepareSimpleSegment(*service_, "segment_1", 0x400000000,
+                                           kDefaultSegmentSize);
+
+    // Leave holes between the objects of segment_0
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+    config.preferred_segment = "segment_0";
+    constexpr int kNumObjects = 48;
+    for (int i = 0; i < kNumObjects; i++) {
+        const std::string key = "compaction_key_" + std::to_string(i);
+        ASSERT_TRUE(
+            service_->PutStart(client_id, key, 256 * 1024, config).has_value());
+        ASSERT_TRUE(
+            service_->PutEnd(client_id, key, ReplicaType::MEMORY).has_value());
+    }
+    for (int i = 0; i < kNumObjects; i += 2) {
+        ASSERT_TRUE(
+            service_->Remove("compaction_key_" + std::to_string(i), true)
+                .has_value());
+    }
+
+    // Each round scans a part of the shards, wait for a few rounds
+    std::vector<TaskAssignment> moves;
+    for (int i = 0; i < 100 && moves.empty(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto fetch = service_->FetchTasks(ctx0.client_id, /*batch_size=*/64);
+        ASSERT_TRUE(fetch.has_value());
+        moves = std::move(fetch.value());
+    }
+    ASSERT_FALSE(moves.empty());
+    for (const auto& move : moves) {
+        EXPECT_EQ(move.type, TaskType::REPLICA_MOVE);
+    }
+
+    // Nothing is moved out of segment_1
+    auto fetch1 = service_->FetchTasks(ctx1.client_id, /*batch_size=*/64);
+    ASSERT_TRUE(fetch1.has_value());
+    EXPECT_TRUE(fetch1->empty());
+}
+
+TEST_F(MasterServiceTest, HotKeyGetsReplicasWhileHot) {
+    auto service_config = MasterServiceConfig::builder()
+                              .set_hot_key_top_n(4)
+                              .set_hot_key_replica_reads_per_sec(100)
+                              .set_hot_key_max_replicas(2)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    const auto ctx0 = PrepareSimpleSegment(*service_, "segment_0", 0x300000000,
+                                           kDefaultSegmentSize);
+    [[maybe_unused]] const auto ctx1 = PrepareSimpleSegment(
+        *service_, "segment_1", 0x400000000, kDefaultSegmentSize);
+
+    const UUID client_id = generate_uuid();
+    const std::string key = "hot_key";
+    ReplicateConfig config;
+    config.replica_num = 1;
+    config.preferred_segment = "segment_0";
+    ASSERT_TRUE(service_->PutStart(client_id, key, 1024, config).has_value());
+    ASSERT_TRUE(
+        service_->PutEnd(client_id, key, ReplicaType::MEMORY).has_value());
+
+    // Read far above the threshold until a copy is scheduled
+    std::vector<TaskAssignment> copies;
+    for (int i = 0; i < 100 && copies.empty(); i++) {
+        for (int j = 0; j < 100; j++) {
+            ASSERT_TRUE(service_->GetReplicaList(key).has_value());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto fetch = service_->FetchTasks(ctx0.client_id, /*batch_size=*/16);
+        ASSERT_TRUE(fetch.has_value());
+        copies = std::move(fetch.value());
+    }
+    ASSERT_EQ(1u, copies.size());
+    EXPECT_EQ(TaskType::REPLICA_COPY, copies[0].type);
+
+    ASSERT_TRUE(
+        service_->CopyStart(ctx0.client_id, key, "segment_0", {"segment_1"})
+            .has_value());
+    ASSERT_TRUE(service_->CopyEnd(ctx0.client_id, key).has_value());
+    auto get_result = service_->GetReplicaList(key);
+    ASSERT_TRUE(get_result.has_value());
+    EXPECT_EQ(2u, get_result->replicas.size());
+
+    TaskCompleteRequest req{};
+    req.id = copies[0].id;
+    req.status = TaskStatus::SUCCESS;
+    ASSERT_TRUE(service_->MarkTaskToComplete(ctx0.client_id, req).has_value());
+
+    // Once the reads stop the added replica is dropped again
+    size_t replica_num = 2;
+    for (int i = 0; i < 50 && replica_num > 1; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        get_result = service_->GetReplicaList(key);
+        ASSERT_TRUE(get_result.has_value());
+        replica_num = get_result->replicas.size();
+    }
+    EXPECT_EQ(1u, replica_num);
+    EXPECT_EQ("segment_0",
+              get_result->replicas[0]
+                  .get_memory_descriptor()
+                  .buffer_descriptor.transport_endpoint_);
+}
+
+TEST_F(MasterServiceTest, TenantQuotaLimitsPutStart) {
+    auto service_config =
+        MasterServiceConfig::builder().set_tenant_quotas("a=4096").build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    [[maybe_unused]] const auto context = PrepareSimpleSegment(*service_);
+
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 1;
+    config.tenant = "a";
+    ASSERT_TRUE(service_->PutStart(client_id, "key_0", 3072, config));
+    ASSERT_TRUE(service_->PutEnd(client_id, "key_0", ReplicaType::MEMORY));
+    EXPECT_EQ(3072,
+              MasterMetricManager::instance().get_tenant_used_bytes("a"));
+
+    auto rejected = service_->PutStart(client_id, "key_1", 2048, config);
+    ASSERT_FALSE(rejected.has_value());
+    EXPECT_EQ(ErrorCode::TENANT_QUOTA_EXCEEDED, rejected.error());
+
+    // Other tenants and untagged objects are not limited
+    config.tenant = "b";
+    EXPECT_TRUE(service_->PutStart(client_id, "key_2", 2048, config));
+    config.tenant.clear();
+    EXPECT_TRUE(service_->PutStart(client_id, "key_3", 2048, config));
+
+    // Removing the object returns its bytes to the tenant
+    ASSERT_TRUE(service_->Remove("key_0", true));
+    EXPECT_EQ(0, MasterMetricManager::instance().get_tenant_used_bytes("a"));
+    config.tenant = "a";
+    EXPECT_TRUE(service_->PutStart(client_id, "key_1", 2048, config));
+}
+
+TEST_F(MasterServiceTest, TenantQuotaReleasedPerEvictedReplica) {
+    // Only PutStart evicts, not the eviction thread
+    auto service_config = MasterServiceConfig::builder()
+                              .set_tenant_quotas("evicted=16777216")
+                              .set_default_kv_lease_ttl(10000)
+                              .set_put_start_eviction_retries(1)
+                              .set_eviction_ratio(0.0)
+                              .set_eviction_high_watermark_ratio(1.0)
+                              .build();
+    std::unique_ptr<MasterService> service_(new MasterService(service_config));
+    constexpr size_t object_size = 1024 * 1024;
+    [[maybe_unused]] const auto ctx0 =
+        PrepareSimpleSegment(*service_, "segment_0", 0x300000000);
+    [[maybe_unused]] const auto ctx1 =
+        PrepareSimpleSegment(*service_, "segment_1", 0x400000000);
+
+    auto used_bytes = [] {
+        return MasterMetricManager::instance().get_tenant_used_bytes("evicted");
+    };
+
+    const UUID client_id = generate_uuid();
+    ReplicateConfig config;
+    config.replica_num = 2;
+    config.tenant = "evicted";
+    ASSERT_TRUE(service_->PutStart(client_id, "key", object_size, config));
+    ASSERT_TRUE(service_->PutEnd(client_id, "key", ReplicaType::MEMORY));
+    EXPECT_EQ(static_cast<int64_t>(2 * object_size), used_bytes());
+
+    // Fill both segments with leased objects of no tenant
+    ReplicateConfig filler_config;
+    filler_config.replica_num = 1;
+    for (const std::string segment : {"segment_0", "segment_1"}) {
+        filler_config.preferred_segment = segment;
+        for (int i = 0; i < 15; ++i) {
+            const std::string key = segment + "_" + std::to_string(i);
+            ASSERT_TRUE(
+                service_->PutStart(client_id, key, object_size, filler_config));
+            ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::MEMORY));
+            ASSERT_TRUE(service_->GetReplicaList(key).has_value());
+        }
+    }
+
+    // Evicts the replica of the key in segment_0 only
+    filler_config.preferred_segment = "segment_0";
+    ASSERT_TRUE(
+        service_->PutStart(client_id, "new_key", object_size, filler_config));
+    auto get_result = service_->GetReplicaList("key");
+    ASSERT_TRUE(get_result.has_value());
+    EXPECT_EQ(1, get_result->replicas.size());
+    EXPECT_EQ(static_cast<int64_t>(object_size), used_bytes());
+
+    ASSERT_TRUE(service_->Remove("key", true));
+    EXPECT_EQ(0, used_bytes());
+}
+
+// Master side of Client::Prefetch: objects held only by a disk replica are
+// copied from it into a segment of the client
+TEST_F(MasterServiceTest, PrefetchPromotesDiskReplica) {
+    std::unique_ptr<MasterService> service_(new MasterService(
+        MasterServiceConfig::builder().set_root_fs_dir("/mnt/ssd").build()));
+    const auto context = PrepareSimpleSegment(*service_);
+    const UUID client_id = context.client_id;
+
+    auto put_on_disk = [&](const std::string& key) {
+        ReplicateConfig config;
+        config.replica_num = 1;
+        ASSERT_TRUE(service_->PutStart(client_id, key, 1024, config));
+        ASSERT_TRUE(service_->PutRevoke(client_id, key, ReplicaType::MEMORY));
+        ASSERT_TRUE(service_->PutEnd(client_id, key, ReplicaType::DISK));
+    };
+    auto count_replicas = [&](const std::string& key) {
+        std::pair<int, int> memory_and_disk{0, 0};
+        auto get_result = service_->GetReplicaList(key);
+        EXPECT_TRUE(get_result.has_value());
+        if (get_result) {
+            for (const auto& replica : get_result->replicas) {
+                memory_and_disk.first += replica.is_memory_replica();
+                memory_and_disk.second += replica.is_disk_replica();
+            }
+        }
+        return memory_and_disk;
+    };
+
+    put_on_disk("key");
+    EXPECT_EQ(std::make_pair(0, 1), count_replicas("key"));
+
+    // An empty source segment copies from the disk replica
+    auto copy_result =
+        service_->CopyStart(client_id, "key", "", {"test_segment"});
+    ASSERT_TRUE(copy_result.has_value());
+    EXPECT_TRUE(copy_result->source.is_disk_replica());
+    ASSERT_EQ(1, copy_result->targets.size());
+    EXPECT_TRUE(copy_result->targets[0].is_memory_replica());
+    // Readers do not see the target before the copy ends
+    EXPECT_EQ(std::make_pair(0, 1), count_replicas("key"));
+    // The same key prefetched twice at once is refused
+    auto concurrent =
+        service_->CopyStart(client_id, "key", "", {"test_segment"});
+    ASSERT_FALSE(concurrent.has_value());
+    EXPECT_EQ(ErrorCode::OBJECT_HAS_REPLICATION_TASK, concurrent.error());
+    ASSERT_TRUE(service_->CopyEnd(client_id, "key"));
+    EXPECT_EQ(std::make_pair(1, 1), count_replicas("key"));
+
+    // Prefetching a key already in the segment has nothing to copy
+    copy_result = service_->CopyStart(client_id, "key", "", {"test_segment"});
+    ASSERT_TRUE(copy_result.has_value());
+    EXPECT_TRUE(copy_result->targets.empty());
+    ASSERT_TRUE(service_->CopyEnd(client_id, "key"));
+    EXPECT_EQ(std::make_pair(1, 1), count_replicas("key"));
+
+    // A failed read of the file leaves the disk replica only
+    put_on_disk("revoked_key");
+    ASSERT_TRUE(
+        service_->CopyStart(client_id, "revoked_key", "", {"test_segment"}));
+    ASSERT_TRUE(service_->CopyRevoke(client_id, "revoked_key"));
+    EXPECT_EQ(std::make_pair(0, 1), count_replicas("revoked_key"));
+
+    // Objects without a disk replica cannot be promoted
+    ReplicateConfig config;
+    config.replica_num = 1;
+    ASSERT_TRUE(service_->PutStart(client_id, "memory_key", 1024, config));
+    ASSERT_TRUE(
+        service_->PutRevoke(client_id, "memory_key", ReplicaType::DISK));
+    ASSERT_TRUE(service_->PutEnd(client_id, "memory_key", ReplicaType::MEMORY));
+    copy_result =
+        service_->CopyStart(client_id, "memory_key", "", {"test_segment"});
+    ASSERT_FALSE(copy_result.has_value());
+    EXPECT_EQ(ErrorCode::REPLICA_NOT_FOUND, copy_result.error());
+}
+
 TEST_F(MasterServiceTest, FetchTasksRespectsBatchSize) {
     std::unique_ptr<MasterService> service_(new MasterService());
 
@@ -0,0 +1,57 @@
+#include "master_shard_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+TEST(MasterShardRingTest, ParseMasters) {
+    EXPECT_EQ(std::vector<std::string>({"localhost:50051"}),
+              MasterShardRing::ParseMasters("localhost:50051"));
+    EXPECT_EQ(std::vector<std::string>({"a:1", "b:2", "c:3"}),
+              MasterShardRing::ParseMasters("a:1,b:2,,c:3,"));
+}
+
+TEST(MasterShardRingTest, SpreadsKeysEvenly) {
+    const std::vector<std::string> masters = {"a:1", "b:2", "c:3", "d:4"};
+    MasterShardRing ring(masters);
+    constexpr size_t kNumKeys = 40000;
+    std::vector<size_t> counts(masters.size(), 0);
+    for (size_t i = 0; i < kNumKeys; i++) {
+        counts[ring.ShardOf("key_" + std::to_string(i))]++;
+    }
+    for (size_t count : counts) {
+        EXPECT_GT(count, kNumKeys / masters.size() * 3 / 4);
+        EXPECT_LT(count, kNumKeys / masters.size() * 5 / 4);
+    }
+}
+
+TEST(MasterShardRingTest, OwnersDoNotDependOnTheOrder) {
+    MasterShardRing ring({"a:1", "b:2", "c:3"});
+    MasterShardRing reversed({"c:3", "b:2", "a:1"});
+    for (size_t i = 0; i < 1000; i++) {
+        const std::string key = "key_" + std::to_string(i);
+        EXPECT_EQ(ring.ShardOf(key), 2 - reversed.ShardOf(key));
+    }
+}
+
+TEST(MasterShardRingTest, AddingAMasterMovesFewKeys) {
+    MasterShardRing ring({"a:1", "b:2", "c:3"});
+    MasterShardRing grown({"a:1", "b:2", "c:3", "d:4"});
+    constexpr size_t kNumKeys = 10000;
+    size_t moved = 0;
+    for (size_t i = 0; i < kNumKeys; i++) {
+        const std::string key = "key_" + std::to_string(i);
+        const size_t owner = grown.ShardOf(key);
+        if (owner != ring.ShardOf(key)) {
+            // Keys only move to the new master
+            EXPECT_EQ(3, owner);
+            moved++;
+        }
+    }
+    EXPECT_LT(moved, kNumKeys / 3);
+}
+
+}  // namespace mooncake::test
@@ -0,0 +1,487 @@
+#include "metadata_persistence.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ylt/coro_rpc/coro_rpc_server.hpp>
+
+#include "master_client.h"
+#include "master_service.h"
+#include "metadata_follower.h"
+#include "rpc_service.h"
+#include "types.h"
+#include "utils.h"
+
+namespace mooncake::test {
+
+namespace fs = std::filesystem;
+
+class MetadataPersistenceTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        google::InitGoogleLogging("MetadataPersistenceTest");
+        FLAGS_logtostderr = true;
+        persist_dir_ = (fs::temp_directory_path() /
+                        ("mooncake_metadata_persistence_test_" +
+                         std::to_string(::getpid())))
+                           .string();
+        fs::remove_all(persist_dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(persist_dir_);
+        google::ShutdownGoogleLogging();
+    }
+
+    static PersistedObject MakeObject(const std::string& key,
+                                      uint64_t buffer_address) {
+        PersistedObject object;
+        object.key = key;
+        object.client_id = {1, 2};
+        object.size = 1024;
+        object.lease_remaining_ms = 100;
+
+        PersistedReplica memory_replica;
+        memory_replica.type = ReplicaType::MEMORY;
+        memory_replica.size = 1024;
+        memory_replica.segment_name = "segment";
+        memory_replica.buffer_address = buffer_address;
+        object.replicas.push_back(memory_replica);
+
+        PersistedReplica disk_replica;
+        disk_replica.type = ReplicaType::DISK;
+        disk_replica.size = 1024;
+        disk_replica.file_path = "/mnt/" + key;
+        object.replicas.push_back(disk_replica);
+        return object;
+    }
+
+    std::vector<fs::path> WalFiles() const {
+        std::vector<fs::path> files;
+        for (const auto& entry : fs::directory_iterator(persist_dir_)) {
+            if (entry.path().filename().string().starts_with("metadata.wal.")) {
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    std::string persist_dir_;
+};
+
+TEST_F(MetadataPersistenceTest, ReplayWal) {
+    {
+        MetadataPersistence persistence(persist_dir_);
+        auto objects = persistence.Load();
+        ASSERT_TRUE(objects.has_value());
+        EXPECT_TRUE(objects->empty());
+
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_a", 0x1000)));
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_b", 0x2000)));
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_c", 0x3000)));
+        ASSERT_EQ(ErrorCode::OK, persistence.AppendRemove("key_b"));
+
+        // key_a keeps only its disk replica, key_c is dropped entirely
+        auto remaining = MakeObject("key_a", 0x1000);
+        remaining.replicas.erase(remaining.replicas.begin());
+        ASSERT_EQ(ErrorCode::OK, persistence.AppendEvict("key_a", remaining));
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendEvict("key_c", std::nullopt));
+    }
+
+    MetadataPersistence persistence(persist_dir_);
+    auto objects = persistence.Load();
+    ASSERT_TRUE(objects.has_value());
+    ASSERT_EQ(1, objects->size());
+    const auto& object = objects->front();
+    EXPECT_EQ("key_a", object.key);
+    EXPECT_EQ(1024, object.size);
+    EXPECT_EQ(100, object.lease_remaining_ms);
+    ASSERT_EQ(1, object.replicas.size());
+    EXPECT_EQ(ReplicaType::DISK, object.replicas[0].type);
+    EXPECT_EQ("/mnt/key_a", object.replicas[0].file_path);
+}
+
+TEST_F(MetadataPersistenceTest, IgnoreTornWalTail) {
+    {
+        MetadataPersistence persistence(persist_dir_);
+        ASSERT_TRUE(persistence.Load().has_value());
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_a", 0x1000)));
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_b", 0x2000)));
+    }
+
+    // Simulate a crash in the middle of writing the last record
+    auto wal_files = WalFiles();
+    ASSERT_EQ(1, wal_files.size());
+    fs::resize_file(wal_files[0], fs::file_size(wal_files[0]) - 3);
+
+    {
+        MetadataPersistence persistence(persist_dir_);
+        auto objects = persistence.Load();
+        ASSERT_TRUE(objects.has_value());
+        ASSERT_EQ(1, objects->size());
+        EXPECT_EQ("key_a", objects->front().key);
+
+        // Records appended after the torn tail must survive the next load
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_c", 0x3000)));
+    }
+
+    MetadataPersistence persistence(persist_dir_);
+    auto objects = persistence.Load();
+    ASSERT_TRUE(objects.has_value());
+    EXPECT_EQ(2, objects->size());
+}
+
+TEST_F(MetadataPersistenceTest, GroupCommit) {
+    constexpr int kThreads = 8;
+    constexpr int kKeysPerThread = 100;
+    {
+        MetadataPersistence persistence(persist_dir_);
+        ASSERT_TRUE(persistence.Load().has_value());
+        std::vector<std::thread> threads;
+        std::atomic<int> failures{0};
+        for (int t = 0; t < kThreads; t++) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < kKeysPerThread; i++) {
+                    const auto key = "key_" + std::to_string(t) + "_" +
+                                     std::to_string(i);
+                    if (persistence.AppendPutEnd(MakeObject(key, i)) !=
+                            ErrorCode::OK ||
+                        persistence.Sync() != ErrorCode::OK) {
+                        failures++;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(0, failures.load());
+        // Synced records are on disk before the persistence goes away
+        MetadataFollower follower(persist_dir_);
+        ASSERT_EQ(ErrorCode::OK, follower.CatchUp());
+        EXPECT_EQ(kThreads * kKeysPerThread, follower.last_sequence());
+    }
+
+    MetadataPersistence persistence(persist_dir_);
+    auto objects = persistence.Load();
+    ASSERT_TRUE(objects.has_value());
+    EXPECT_EQ(kThreads * kKeysPerThread, objects->size());
+}
+
+TEST_F(MetadataPersistenceTest, SnapshotCoversWal) {
+    {
+        MetadataPersistence persistence(persist_dir_);
+        ASSERT_TRUE(persistence.Load().has_value());
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_a", 0x1000)));
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_b", 0x2000)));
+
+        auto last_sequence = persistence.RotateWal();
+        EXPECT_EQ(2, last_sequence);
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.WriteSnapshot(
+                      last_sequence, {MakeObject("key_a", 0x1000),
+                                      MakeObject("key_b", 0x2000)}));
+
+        // Only the segment opened by the rotation is left
+        EXPECT_EQ(1, WalFiles().size());
+
+        ASSERT_EQ(ErrorCode::OK, persistence.AppendRemove("key_a"));
+    }
+
+    MetadataPersistence persistence(persist_dir_);
+    auto objects = persistence.Load();
+    ASSERT_TRUE(objects.has_value());
+    ASSERT_EQ(1, objects->size());
+    EXPECT_EQ("key_b", objects->front().key);
+}
+
+TEST_F(MetadataPersistenceTest, RejectCorruptedSnapshot) {
+    {
+        MetadataPersistence persistence(persist_dir_);
+        ASSERT_TRUE(persistence.Load().has_value());
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.WriteSnapshot(0, {MakeObject("key_a", 0x1000)}));
+    }
+
+    const auto snapshot_path = fs::path(persist_dir_) / "metadata.snapshot";
+    fs::resize_file(snapshot_path, fs::file_size(snapshot_path) - 1);
+
+    MetadataPersistence persistence(persist_dir_);
+    auto objects = persistence.Load();
+    ASSERT_FALSE(objects.has_value());
+    EXPECT_EQ(ErrorCode::FILE_INVALID_BUFFER, objects.error());
+}
+
+TEST_F(MetadataPersistenceTest, MasterServiceRestoresReplicasOnRemount) {
+    auto service_config = MasterServiceConfig::builder()
+                              .set_memory_allocator(BufferAllocatorType::OFFSET)
+                              .set_metadata_persist_dir(persist_dir_)
+                              .set_metadata_snapshot_interval_sec(0)
+                              .build();
+
+    Segment segment;
+    segment.id = generate_uuid();
+    segment.name = "test_segment";
+    segment.base = 0x300000000;
+    segment.size = 1024 * 1024 * 16;
+    const UUID client_id = generate_uuid();
+
+    uint64_t buffer_address = 0;
+    {
+        auto service = std::make_unique<MasterService>(service_config);
+        ASSERT_TRUE(service->MountSegment(segment, client_id).has_value());
+        ReplicateConfig config;
+        config.replica_num = 1;
+        ASSERT_TRUE(
+            service->PutStart(client_id, "key_a", 1024, config).has_value());
+        ASSERT_TRUE(
+            service->PutEnd(client_id, "key_a", ReplicaType::MEMORY)
+                .has_value());
+        ASSERT_TRUE(
+            service->PutStart(client_id, "key_b", 1024, config).has_value());
+        ASSERT_TRUE(
+            service->PutEnd(client_id, "key_b", ReplicaType::MEMORY)
+                .has_value());
+        ASSERT_TRUE(service->Remove("key_b").has_value());
+
+        auto get_result = service->GetReplicaList("key_a");
+        ASSERT_TRUE(get_result.has_value());
+        buffer_address = get_result->replicas[0]
+                             .get_memory_descriptor()
+                             .buffer_descriptor.buffer_address_;
+    }
+
+    // The new master waits for the client to re-mount its segment
+    auto service = std::make_unique<MasterService>(service_config);
+    EXPECT_FALSE(service->GetReplicaList("key_a").has_value());
+    ASSERT_TRUE(service->ReMountSegment({segment}, client_id).has_value());
+
+    auto get_result = service->GetReplicaList("key_a");
+    ASSERT_TRUE(get_result.has_value());
+    ASSERT_EQ(1, get_result->replicas.size());
+    EXPECT_EQ(buffer_address, get_result->replicas[0]
+                                  .get_memory_descriptor()
+                                  .buffer_descriptor.buffer_address_);
+    EXPECT_FALSE(service->GetReplicaList("key_b").has_value());
+
+    // The restored buffer is reserved, new allocations must not overlap it
+    ReplicateConfig config;
+    config.replica_num = 1;
+    auto put_result = service->PutStart(client_id, "key_c", 1024, config);
+    ASSERT_TRUE(put_result.has_value());
+    const auto new_address = put_result->front()
+                                 .get_memory_descriptor()
+                                 .buffer_descriptor.buffer_address_;
+    EXPECT_TRUE(new_address >= buffer_address + 1024 ||
+                new_address + 1024 <= buffer_address);
+}
+
+TEST_F(MetadataPersistenceTest, MasterServiceRefusesLinks) {
+    auto service_config = MasterServiceConfig::builder()
+                              .set_metadata_persist_dir(persist_dir_)
+                              .set_metadata_snapshot_interval_sec(0)
+                              .build();
+    auto service = std::make_unique<MasterService>(service_config);
+
+    // Links are not in the WAL
+    const std::string content_key =
+        std::string(ContentIndex::kContentKeyPrefix) + "0123-100";
+    auto result = service->LinkContent("key", content_key);
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(ErrorCode::UNAVAILABLE_IN_CURRENT_MODE, result.error());
+    const std::string bundle_key =
+        std::string(BundleIndex::kBundleKeyPrefix) + "bundle";
+    result = service->LinkBundle(bundle_key, {"key"}, {100});
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(ErrorCode::UNAVAILABLE_IN_CURRENT_MODE, result.error());
+}
+
+TEST_F(MetadataPersistenceTest, FollowerTailsWal) {
+    MetadataPersistence persistence(persist_dir_);
+    ASSERT_TRUE(persistence.Load().has_value());
+    ASSERT_EQ(ErrorCode::OK,
+              persistence.AppendPutEnd(MakeObject("key_a", 0x1000)));
+    // Only synced records are visible to the follower
+    MetadataFollower follower(persist_dir_);
+    ASSERT_EQ(ErrorCode::OK, follower.CatchUp());
+    EXPECT_EQ(0, follower.last_sequence());
+    ASSERT_EQ(ErrorCode::OK, persistence.Sync());
+    ASSERT_EQ(ErrorCode::OK, follower.CatchUp());
+    EXPECT_EQ(1, follower.last_sequence());
+    auto exist = follower.ExistKey("key_a");
+    ASSERT_TRUE(exist.has_value());
+    EXPECT_TRUE(exist.value());
+
+    auto get_result = follower.GetReplicaList("key_a");
+    ASSERT_TRUE(get_result.has_value());
+    // Only the disk replica, the memory one is not protected by a lease
+    ASSERT_EQ(1, get_result->replicas.size());
+    EXPECT_EQ("/mnt/key_a",
+              get_result->replicas[0].get_disk_descriptor().file_path);
+    // A standby never hands out leases
+    EXPECT_EQ(0, get_result->lease_ttl_ms);
+
+    auto memory_only = MakeObject("key_m", 0x3000);
+    memory_only.replicas.pop_back();
+    ASSERT_EQ(ErrorCode::OK, persistence.AppendPutEnd(memory_only));
+    ASSERT_EQ(ErrorCode::OK, persistence.Sync());
+    ASSERT_EQ(ErrorCode::OK, follower.CatchUp());
+    EXPECT_TRUE(follower.ExistKey("key_m").value());
+    get_result = follower.GetReplicaList("key_m");
+    ASSERT_FALSE(get_result.has_value());
+    EXPECT_EQ(ErrorCode::REPLICA_IS_NOT_READY, get_result.error());
+
+    ASSERT_EQ(ErrorCode::OK,
+              persistence.AppendPutEnd(MakeObject("key_b", 0x2000)));
+    ASSERT_EQ(ErrorCode::OK, persistence.AppendRemove("key_a"));
+    ASSERT_EQ(ErrorCode::OK, persistence.Sync());
+    ASSERT_EQ(ErrorCode::OK, follower.CatchUp());
+    EXPECT_EQ(4, follower.last_sequence());
+    auto batch_exist = follower.BatchExistKey({"key_a", "key_b"});
+    ASSERT_EQ(2, batch_exist.size());
+    EXPECT_FALSE(batch_exist[0].value());
+    EXPECT_TRUE(batch_exist[1].value());
+}
+
+TEST_F(MetadataPersistenceTest, ClientQueriesStandbyWhenLeaderIsDown) {
+    MetadataPersistence persistence(persist_dir_);
+    ASSERT_TRUE(persistence.Load().has_value());
+    ASSERT_EQ(ErrorCode::OK,
+              persistence.AppendPutEnd(MakeObject("key_a", 0x1000)));
+    ASSERT_EQ(ErrorCode::OK, persistence.Sync());
+
+    auto follower = std::make_shared<MetadataFollower>(persist_dir_);
+    ASSERT_EQ(ErrorCode::OK, follower->CatchUp());
+    WrappedMasterService standby_service(follower);
+    const int standby_port = getFreeTcpPort();
+    coro_rpc::coro_rpc_server standby_server(1, standby_port);
+    RegisterStandbyRpcService(standby_server, standby_service);
+    ASSERT_FALSE(standby_server.async_start().hasResult());
+
+    const std::string standby_addr =
+        "127.0.0.1:" + std::to_string(standby_port);
+    setenv("MC_STORE_STANDBY_MASTER", standby_addr.c_str(), 1);
+    MasterClient client(generate_uuid());
+    unsetenv("MC_STORE_STANDBY_MASTER");
+    // No leader listens there
+    const std::string leader_addr =
+        "127.0.0.1:" + std::to_string(getFreeTcpPort());
+    EXPECT_NE(ErrorCode::OK, client.Connect(leader_addr));
+
+    auto exist = client.ExistKey("key_a");
+    ASSERT_TRUE(exist.has_value()) << exist.error();
+    EXPECT_TRUE(exist.value());
+    auto batch_exist = client.BatchExistKey({"key_a", "key_b"});
+    ASSERT_EQ(2, batch_exist.size());
+    EXPECT_TRUE(batch_exist[0].value());
+    EXPECT_FALSE(batch_exist[1].value());
+
+    auto get_result = client.GetReplicaList("key_a");
+    ASSERT_TRUE(get_result.has_value()) << get_result.error();
+    ASSERT_EQ(1, get_result->replicas.size());
+    EXPECT_TRUE(get_result->replicas[0].is_disk_replica());
+    auto batch_get = client.BatchGetReplicaList({"key_a", "key_b"});
+    ASSERT_EQ(2, batch_get.size());
+    EXPECT_TRUE(batch_get[0].has_value());
+    EXPECT_EQ(ErrorCode::OBJECT_NOT_FOUND, batch_get[1].error());
+
+    // Writes are not sent to the standby
+    EXPECT_EQ(ErrorCode::RPC_FAIL, client.Remove("key_a").error());
+    standby_server.stop();
+}
+
+TEST_F(MetadataPersistenceTest, FollowerSurvivesCompaction) {
+    MetadataPersistence persistence(persist_dir_);
+    ASSERT_TRUE(persistence.Load().has_value());
+    ASSERT_EQ(ErrorCode::OK,
+              persistence.AppendPutEnd(MakeObject("key_a", 0x1000)));
+    ASSERT_EQ(ErrorCode::OK, persistence.Sync());
+
+    MetadataFollower follower(persist_dir_);
+    ASSERT_EQ(ErrorCode::OK, follower.CatchUp());
+
+    // The segment the follower is reading is compacted away together with
+    // records it has not seen yet.
+    ASSERT_EQ(ErrorCode::OK,
+              persistence.AppendPutEnd(MakeObject("key_b", 0x2000)));
+    auto last_sequence = persistence.RotateWal();
+    ASSERT_EQ(ErrorCode::OK,
+              persistence.WriteSnapshot(last_sequence,
+                                        {MakeObject("key_a", 0x1000),
+                                         MakeObject("key_b", 0x2000)}));
+    ASSERT_EQ(ErrorCode::OK,
+              persistence.AppendPutEnd(MakeObject("key_c", 0x3000)));
+    ASSERT_EQ(ErrorCode::OK, persistence.Sync());
+
+    ASSERT_EQ(ErrorCode::OK, follower.CatchUp());
+    EXPECT_EQ(4, follower.last_sequence());
+    for (const auto& key : {"key_a", "key_b", "key_c"}) {
+        auto exist = follower.ExistKey(key);
+        ASSERT_TRUE(exist.has_value());
+        EXPECT_TRUE(exist.value()) << key;
+    }
+}
+
+TEST_F(MetadataPersistenceTest, LoadFromDetachedFollower) {
+    {
+        MetadataPersistence persistence(persist_dir_);
+        ASSERT_TRUE(persistence.Load().has_value());
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_a", 0x1000)));
+    }
+
+    MetadataFollower follower(persist_dir_);
+    ASSERT_EQ(ErrorCode::OK, follower.CatchUp());
+
+    // The old leader keeps writing until it retires
+    {
+        MetadataPersistence persistence(persist_dir_);
+        ASSERT_TRUE(persistence.Load().has_value());
+        ASSERT_EQ(ErrorCode::OK,
+                  persistence.AppendPutEnd(MakeObject("key_b", 0x2000)));
+    }
+
+    auto state = follower.Detach();
+    auto exist = follower.ExistKey("key_a");
+    ASSERT_FALSE(exist.has_value());
+    EXPECT_EQ(ErrorCode::UNAVAILABLE_IN_CURRENT_STATUS, exist.error());
+
+    MetadataPersistence persistence(persist_dir_);
+    auto objects = persistence.Load(std::move(state));
+    ASSERT_TRUE(objects.has_value());
+    EXPECT_EQ(2, objects->size());
+
+    // New records continue the sequence of the old leader
+    ASSERT_EQ(ErrorCode::OK, persistence.AppendRemove("key_a"));
+    ASSERT_EQ(ErrorCode::OK, persistence.Sync());
+    MetadataFollower new_follower(persist_dir_);
+    ASSERT_EQ(ErrorCode::OK, new_follower.CatchUp());
+    EXPECT_EQ(3, new_follower.last_sequence());
+    EXPECT_FALSE(new_follower.ExistKey("key_a").value());
+}
+
+}  // namespace mooncake::test
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
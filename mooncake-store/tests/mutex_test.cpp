@@ -163,6 +163,29 @@ TEST(SharedMutexTest, TryLockSharedSuccess) {
     EXPECT_FALSE(locker.try_lock_shared());  // Should not allow re-locking
 }
 
+TEST(SharedMutexTest, CountsContendedAcquisitions) {
+    SharedMutex mtx;
+    {
+        SharedMutexLocker locker(&mtx);
+    }
+    {
+        SharedMutexLocker locker(&mtx, shared_lock);
+    }
+    EXPECT_EQ(0u, mtx.contention_stats().contended);
+
+    mtx.lock();
+    std::thread reader([&mtx] {
+        SharedMutexLocker locker(&mtx, shared_lock);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    mtx.unlock();
+    reader.join();
+
+    auto stats = mtx.contention_stats();
+    EXPECT_EQ(1u, stats.contended);
+    EXPECT_GE(stats.wait_us, 40000u);
+}
+
 TEST(SharedMutexTest, HandlesNullptrSafely) {
     SharedMutexLocker locker(nullptr);
     EXPECT_NO_THROW(locker.lock());
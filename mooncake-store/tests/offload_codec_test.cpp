@@ -0,0 +1,89 @@
+#include "offload_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace mooncake::test {
+
+// FP16-like values whose high bytes repeat
+static std::vector<char> MakeHalfValues(size_t count) {
+    std::vector<char> data(count * 2);
+    for (size_t i = 0; i < count; ++i) {
+        data[2 * i] = static_cast<char>(i * 37);
+        data[2 * i + 1] = static_cast<char>(0x3c + i % 2);
+    }
+    return data;
+}
+
+TEST(OffloadCodecTest, BytePlanesRoundTrip) {
+    for (size_t size : {0, 1, 2, 7, 1024}) {
+        std::vector<char> src(size);
+        for (size_t i = 0; i < size; ++i) {
+            src[i] = static_cast<char>(i * 13 + 5);
+        }
+        std::vector<char> planes(size);
+        std::vector<char> dst(size);
+        OffloadCodec::SplitBytePlanes(src.data(), size, planes.data());
+        OffloadCodec::MergeBytePlanes(planes.data(), size, dst.data());
+        EXPECT_EQ(src, dst) << "size=" << size;
+    }
+
+    std::vector<char> src = {1, 2, 3, 4, 5};
+    std::vector<char> planes(src.size());
+    OffloadCodec::SplitBytePlanes(src.data(), src.size(), planes.data());
+    EXPECT_EQ((std::vector<char>{1, 3, 2, 4, 5}), planes);
+}
+
+TEST(OffloadCodecTest, FromNameFallsBackToNone) {
+    EXPECT_EQ(OffloadCodecType::kNone, OffloadCodec::FromName("")->type());
+    EXPECT_EQ(OffloadCodecType::kNone, OffloadCodec::FromName("none")->type());
+    EXPECT_EQ(OffloadCodecType::kNone,
+              OffloadCodec::FromName("unknown")->type());
+    EXPECT_EQ(nullptr,
+              OffloadCodec::Get(static_cast<OffloadCodecType>(100)));
+}
+
+TEST(OffloadCodecTest, NoneDoesNotEncode) {
+    auto data = MakeHalfValues(1024);
+    std::vector<char> out;
+    EXPECT_FALSE(OffloadCodec::Get(OffloadCodecType::kNone)
+                     ->Encode({Slice{data.data(), data.size()}}, data.size(),
+                              out));
+}
+
+TEST(OffloadCodecTest, RoundTrip) {
+    auto data = MakeHalfValues(64 * 1024);
+    size_t half = data.size() / 2;
+    for (auto type : {OffloadCodecType::kZstd, OffloadCodecType::kLz4,
+                      OffloadCodecType::kBytePlane16}) {
+        const OffloadCodec* codec = OffloadCodec::Get(type);
+        if (codec == nullptr) {
+            continue;
+        }
+        // Split into two slices, as for objects put from several buffers
+        std::vector<char> encoded;
+        ASSERT_TRUE(codec->Encode({Slice{data.data(), half},
+                                   Slice{data.data() + half, half}},
+                                  data.size(), encoded))
+            << codec->name();
+        EXPECT_LT(encoded.size(), data.size()) << codec->name();
+
+        std::vector<char> decoded(data.size());
+        ASSERT_EQ(ErrorCode::OK,
+                  codec->Decode(encoded.data(), encoded.size(),
+                                decoded.data(), decoded.size()))
+            << codec->name();
+        EXPECT_EQ(data, decoded) << codec->name();
+
+        // A wrong size is rejected rather than leaving bytes unwritten
+        std::vector<char> shorter(data.size() - 1);
+        EXPECT_NE(ErrorCode::OK,
+                  codec->Decode(encoded.data(), encoded.size(),
+                                shorter.data(), shorter.size()))
+            << codec->name();
+    }
+}
+
+}  // namespace mooncake::test
@@ -5,9 +5,11 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <random>
+#include <thread>
 
 namespace mooncake::offset_allocator {
 
@@ -504,6 +506,59 @@ TEST_F(OffsetAllocatorTest, BasicAllocation) {
     EXPECT_NE(handle2->address(), OffsetAllocation::NO_SPACE);
 }
 
+// Test re-claiming allocations at fixed addresses
+TEST_F(OffsetAllocatorTest, AllocateAtFixedAddress) {
+    constexpr uint64_t BASE = 0x100000000;
+    constexpr size_t ALLOCATOR_SIZE = 64 * 1024 * 1024;  // 64MB
+    constexpr uint32 MAX_ALLOCS = 1000;
+
+    // Record the addresses handed out by one allocator
+    std::vector<std::pair<uint64_t, size_t>> ranges;
+    {
+        auto allocator =
+            OffsetAllocator::create(BASE, ALLOCATOR_SIZE, 16, MAX_ALLOCS);
+        std::vector<OffsetAllocationHandle> handles;
+        for (size_t size : {4096, 1000, 65536, 12345, 1 << 20}) {
+            auto handle = allocator->allocate(size);
+            ASSERT_TRUE(handle.has_value());
+            ranges.emplace_back(handle->address(), size);
+            handles.push_back(std::move(*handle));
+        }
+    }
+
+    // Rebuild them, out of order, on a fresh allocator
+    auto allocator =
+        OffsetAllocator::create(BASE, ALLOCATOR_SIZE, 16, MAX_ALLOCS);
+    std::vector<OffsetAllocationHandle> restored;
+    for (auto it = ranges.rbegin(); it != ranges.rend(); ++it) {
+        auto handle = allocator->allocateAt(it->first, it->second);
+        ASSERT_TRUE(handle.has_value());
+        EXPECT_EQ(handle->address(), it->first);
+        EXPECT_EQ(handle->size(), it->second);
+        restored.push_back(std::move(*handle));
+    }
+
+    // Overlapping and out-of-range requests are rejected
+    EXPECT_FALSE(allocator->allocateAt(ranges[0].first, 1).has_value());
+    EXPECT_FALSE(allocator->allocateAt(BASE - 4096, 4096).has_value());
+    EXPECT_FALSE(
+        allocator->allocateAt(BASE + ALLOCATOR_SIZE, 4096).has_value());
+
+    // New allocations do not overlap the restored ranges
+    auto handle = allocator->allocate(4096);
+    ASSERT_TRUE(handle.has_value());
+    for (const auto& [address, size] : ranges) {
+        EXPECT_TRUE(handle->address() + 4096 <= address ||
+                    address + size <= handle->address());
+    }
+
+    // Freeing everything merges back into a single free region
+    handle.reset();
+    restored.clear();
+    EXPECT_EQ(allocator->storageReport().totalFreeSpace, ALLOCATOR_SIZE);
+    EXPECT_TRUE(allocator->allocate(ALLOCATOR_SIZE).has_value());
+}
+
 // Test allocation failure when out of space
 TEST_F(OffsetAllocatorTest, AllocationFailure) {
     constexpr uint32 ALLOCATOR_SIZE = 1024 * 1024 * 1024;  // 1GB
@@ -1603,6 +1658,162 @@ TEST_F(OffsetAllocatorTest, ChainedAllocationAndDeserialization) {
     }
 }
 
+// Freed small blocks are handed out again from the per-CPU magazines
+TEST_F(OffsetAllocatorTest, MagazineReuse) {
+    constexpr uint64_t BASE = 0x100000000;
+    constexpr size_t ALLOCATOR_SIZE = 64 * 1024 * 1024;
+    auto allocator = OffsetAllocator::create(BASE, ALLOCATOR_SIZE, 1024,
+                                             1 << 20, 1024 * 1024);
+
+    uint64_t address = 0;
+    {
+        auto handle = allocator->allocate(20000);
+        ASSERT_TRUE(handle.has_value());
+        address = handle->address();
+    }
+    {
+        auto metrics = allocator->get_metrics();
+        EXPECT_EQ(metrics.allocated_num_, 0);
+        EXPECT_EQ(metrics.allocated_size_, 0);
+    }
+
+    // Any size of the same bin gets the cached block
+    auto handle = allocator->allocate(19000);
+    ASSERT_TRUE(handle.has_value());
+    EXPECT_EQ(handle->address(), address);
+    {
+        auto metrics = allocator->get_metrics();
+        EXPECT_EQ(metrics.allocated_num_, 1);
+        EXPECT_EQ(metrics.allocated_size_, 19000);
+    }
+    handle.reset();
+
+    // Cached blocks are given back when the whole allocator is asked for
+    auto full = allocator->allocate(ALLOCATOR_SIZE);
+    ASSERT_TRUE(full.has_value());
+    full.reset();
+
+    allocator->flushMagazines();
+    EXPECT_EQ(allocator->storageReport().totalFreeSpace, ALLOCATOR_SIZE);
+}
+
+// Fixed-address allocations are never cached, and cached blocks do not get
+// in the way of them
+TEST_F(OffsetAllocatorTest, MagazineAllocateAt) {
+    constexpr uint64_t BASE = 0x100000000;
+    constexpr size_t ALLOCATOR_SIZE = 64 * 1024 * 1024;
+    auto allocator = OffsetAllocator::create(BASE, ALLOCATOR_SIZE, 1024,
+                                             1 << 20, 1024 * 1024);
+
+    uint64_t address = 0;
+    {
+        auto handle = allocator->allocate(4096);
+        ASSERT_TRUE(handle.has_value());
+        address = handle->address();
+    }
+    auto restored = allocator->allocateAt(address, 4000);
+    ASSERT_TRUE(restored.has_value());
+    restored.reset();
+
+    allocator->flushMagazines();
+    EXPECT_EQ(allocator->storageReport().totalFreeSpace, ALLOCATOR_SIZE);
+}
+
+// A split allocation becomes consecutive allocations freed one by one, and
+// sizes that do not fit leave the allocation as is
+TEST_F(OffsetAllocatorTest, SplitAllocation) {
+    constexpr uint64_t BASE = 0x100000000;
+    constexpr size_t ALLOCATOR_SIZE = 64 * 1024 * 1024;
+    auto allocator = OffsetAllocator::create(BASE, ALLOCATOR_SIZE);
+
+    auto handle = allocator->allocate(3 * 4096 + 100);
+    ASSERT_TRUE(handle.has_value());
+    const uint64_t address = handle->address();
+
+    EXPECT_TRUE(allocator->split(*handle, {4096, 1 << 20}).empty());
+    EXPECT_TRUE(handle->isValid());
+
+    auto pieces = allocator->split(*handle, {4096, 4096, 4096, 100});
+    ASSERT_EQ(pieces.size(), 4u);
+    EXPECT_FALSE(handle->isValid());
+    for (size_t i = 0; i < pieces.size(); i++) {
+        EXPECT_TRUE(pieces[i].isValid());
+        EXPECT_EQ(pieces[i].address(), address + i * 4096);
+    }
+    EXPECT_EQ(pieces[3].size(), 100u);
+    EXPECT_EQ(allocator->get_metrics().allocated_num_, 4u);
+    EXPECT_EQ(allocator->get_metrics().allocated_size_, 3 * 4096 + 100u);
+
+    handle.reset();
+    pieces.erase(pieces.begin() + 1);
+    EXPECT_EQ(allocator->get_metrics().allocated_num_, 3u);
+    pieces.clear();
+    EXPECT_EQ(allocator->storageReport().totalFreeSpace, ALLOCATOR_SIZE);
+    EXPECT_EQ(allocator->get_metrics().allocated_size_, 0u);
+}
+
+TEST_F(OffsetAllocatorTest, MagazineMultiThreaded) {
+    constexpr size_t ALLOCATOR_SIZE = 1ull << 30;
+    auto allocator = OffsetAllocator::create(0, ALLOCATOR_SIZE, 1024, 1 << 20,
+                                             4 * 1024 * 1024);
+
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{0};
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<size_t> kv(16 * 1024, 64 * 1024);
+            std::vector<OffsetAllocationHandle> held;
+            for (int i = 0; i < 5000; i++) {
+                auto handle = allocator->allocate(
+                    i % 10 == 0 ? 2 * 1024 * 1024 : kv(gen));
+                if (!handle.has_value()) {
+                    failures++;
+                    continue;
+                }
+                held.push_back(std::move(*handle));
+                if (held.size() > 32) {
+                    // Odd threads free in batches, even ones one by one
+                    if (t % 2) {
+                        allocator->freeAllocations(held);
+                        held.clear();
+                    } else {
+                        held.erase(held.begin(), held.begin() + 16);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+
+    auto metrics = allocator->get_metrics();
+    EXPECT_EQ(metrics.allocated_num_, 0);
+    EXPECT_EQ(metrics.allocated_size_, 0);
+    allocator->flushMagazines();
+    EXPECT_EQ(allocator->storageReport().totalFreeSpace, ALLOCATOR_SIZE);
+}
+
+// Cached blocks are not allocations of a deserialized allocator
+TEST_F(OffsetAllocatorTest, MagazineSerialization) {
+    auto allocator = OffsetAllocator::create(1024 * 16, 1024 * 1024 * 64, 1024,
+                                             1 << 20, 1024 * 1024);
+    auto kept = allocator->allocate(4096);
+    ASSERT_TRUE(kept.has_value());
+    allocator->allocate(30000).reset();
+
+    std::vector<SerializedByte> buffer;
+    ASSERT_EQ(serialize_to(allocator, buffer), ErrorCode::OK);
+    std::shared_ptr<OffsetAllocator> restored =
+        deserialize_from<OffsetAllocator>(buffer);
+    ASSERT_NE(restored, nullptr);
+    EXPECT_EQ(restored->get_metrics().allocated_num_, 1);
+    EXPECT_EQ(restored->storageReport().totalFreeSpace,
+              allocator->storageReport().totalFreeSpace);
+}
+
 }  // namespace mooncake::offset_allocator
 
 int main(int argc, char** argv) {
@@ -0,0 +1,229 @@
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "allocator.h"
+#include "client_service.h"
+#include "default_config.h"
+#include "test_server_helpers.h"
+#include "types.h"
+#include "utils.h"
+
+namespace mooncake {
+namespace testing {
+
+namespace fs = std::filesystem;
+
+// Client::GetRanges against the memory and the disk replica of an object
+class RangeReadTest : public ::testing::Test {
+   protected:
+    static constexpr size_t kSegmentSize = 64 * 1024 * 1024;
+    static constexpr size_t kBufferSize = 16 * 1024 * 1024;
+    static constexpr size_t kObjectSize = 64 * 1024;
+
+    static void SetUpTestSuite() {
+        google::InitGoogleLogging("RangeReadTest");
+        FLAGS_logtostderr = 1;
+
+        // Puts also write a disk replica under the root fs dir
+        root_fs_dir_ = (fs::temp_directory_path() /
+                        ("mooncake_range_read_test_" +
+                         std::to_string(::getpid())))
+                           .string();
+        fs::create_directories(root_fs_dir_);
+        ASSERT_TRUE(master_.Start(
+            InProcMasterConfigBuilder().set_root_fs_dir(root_fs_dir_).build()));
+
+        auto client_opt =
+            Client::Create("localhost:17830", "P2PHANDSHAKE", "tcp",
+                           std::nullopt, master_.master_address());
+        ASSERT_TRUE(client_opt.has_value());
+        client_ = client_opt.value();
+
+        segment_ptr_ = allocate_buffer_allocator_memory(kSegmentSize);
+        ASSERT_NE(nullptr, segment_ptr_);
+        ASSERT_TRUE(client_->MountSegment(segment_ptr_, kSegmentSize, "tcp")
+                        .has_value());
+        buffer_allocator_ = std::make_unique<SimpleAllocator>(kBufferSize);
+        ASSERT_TRUE(client_
+                        ->RegisterLocalMemory(buffer_allocator_->getBase(),
+                                              kBufferSize, "cpu:0", false,
+                                              false)
+                        .has_value());
+    }
+
+    static void TearDownTestSuite() {
+        if (client_) {
+            client_->UnmountSegment(segment_ptr_, kSegmentSize);
+            client_.reset();
+        }
+        buffer_allocator_.reset();
+        free(segment_ptr_);
+        master_.Stop();
+        fs::remove_all(root_fs_dir_);
+        google::ShutdownGoogleLogging();
+    }
+
+    static std::string Pattern() {
+        std::string data(kObjectSize, '\0');
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = static_cast<char>(i * 31 + i / 251);
+        }
+        return data;
+    }
+
+    // Puts the pattern and waits for its disk replica to be written
+    static void PutObject(const std::string& key) {
+        const std::string data = Pattern();
+        void* buffer = buffer_allocator_->allocate(data.size());
+        ASSERT_NE(nullptr, buffer);
+        memcpy(buffer, data.data(), data.size());
+        std::vector<Slice> slices{Slice{buffer, data.size()}};
+        ReplicateConfig config;
+        config.replica_num = 1;
+        auto put_result = client_->Put(key, slices, config);
+        buffer_allocator_->deallocate(buffer, data.size());
+        ASSERT_TRUE(put_result.has_value()) << put_result.error();
+
+        for (int i = 0; i < 100 && !FindReplica(key, true); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        ASSERT_TRUE(FindReplica(key, true).has_value());
+        ASSERT_TRUE(FindReplica(key, false).has_value());
+    }
+
+    // Query result of the key holding only its disk or its memory replica
+    static std::optional<QueryResult> FindReplica(const std::string& key,
+                                                  bool disk) {
+        auto query_result = client_->Query(key);
+        if (!query_result) {
+            return std::nullopt;
+        }
+        for (const auto& replica : query_result->replicas) {
+            if (disk ? replica.is_disk_replica()
+                     : replica.is_memory_replica()) {
+                return QueryResult({replica}, query_result->lease_timeout);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Empty ranges still get a buffer
+    static size_t AllocSize(size_t size) { return std::max<size_t>(size, 1); }
+
+    // Reads the ranges, given as (offset, size), of the replica and checks
+    // them against the pattern
+    static void ExpectRanges(
+        const std::string& key, bool disk,
+        const std::vector<std::pair<uint64_t, size_t>>& offsets) {
+        auto query_result = FindReplica(key, disk);
+        ASSERT_TRUE(query_result.has_value());
+        std::vector<Client::ObjectRange> ranges;
+        for (const auto& [offset, size] : offsets) {
+            void* buffer = buffer_allocator_->allocate(AllocSize(size));
+            ASSERT_NE(nullptr, buffer);
+            memset(buffer, 0, size);
+            ranges.push_back({offset, Slice{buffer, size}});
+        }
+        auto result = client_->GetRanges(key, *query_result, ranges);
+        ASSERT_TRUE(result.has_value()) << result.error();
+        const std::string data = Pattern();
+        for (const auto& range : ranges) {
+            EXPECT_EQ(0, memcmp(range.slice.ptr, data.data() + range.offset,
+                                range.slice.size))
+                << "offset=" << range.offset << ", size=" << range.slice.size;
+            buffer_allocator_->deallocate(range.slice.ptr,
+                                          AllocSize(range.slice.size));
+        }
+    }
+
+    static void ExpectOutOfBounds(const std::string& key, bool disk) {
+        auto query_result = FindReplica(key, disk);
+        ASSERT_TRUE(query_result.has_value());
+        void* buffer = buffer_allocator_->allocate(2 * kObjectSize);
+        ASSERT_NE(nullptr, buffer);
+        const std::vector<std::vector<Client::ObjectRange>> invalid = {
+            // Past the end
+            {{kObjectSize - 10, Slice{buffer, 20}}},
+            // Starting after the end
+            {{kObjectSize + 1, Slice{buffer, 1}}},
+            // Longer than the object
+            {{0, Slice{buffer, 2 * kObjectSize}}},
+            // One valid range does not save the others
+            {{0, Slice{buffer, 100}}, {kObjectSize, Slice{buffer, 1}}},
+        };
+        for (const auto& ranges : invalid) {
+            auto result = client_->GetRanges(key, *query_result, ranges);
+            ASSERT_FALSE(result.has_value());
+            EXPECT_EQ(ErrorCode::INVALID_PARAMS, result.error());
+        }
+        buffer_allocator_->deallocate(buffer, 2 * kObjectSize);
+    }
+
+    static InProcMaster master_;
+    static std::string root_fs_dir_;
+    static std::shared_ptr<Client> client_;
+    static void* segment_ptr_;
+    static std::unique_ptr<SimpleAllocator> buffer_allocator_;
+};
+
+InProcMaster RangeReadTest::master_;
+std::string RangeReadTest::root_fs_dir_;
+std::shared_ptr<Client> RangeReadTest::client_ = nullptr;
+void* RangeReadTest::segment_ptr_ = nullptr;
+std::unique_ptr<SimpleAllocator> RangeReadTest::buffer_allocator_ = nullptr;
+
+TEST_F(RangeReadTest, PartialRange) {
+    PutObject("partial_key");
+    for (bool disk : {false, true}) {
+        SCOPED_TRACE(disk ? "disk" : "memory");
+        ExpectRanges("partial_key", disk, {{0, 1}});
+        ExpectRanges("partial_key", disk, {{1000, 4096}});
+        // The tail, up to the last byte
+        ExpectRanges("partial_key", disk, {{kObjectSize - 333, 333}});
+        ExpectRanges("partial_key", disk, {{0, kObjectSize}});
+    }
+}
+
+TEST_F(RangeReadTest, MultipleRanges) {
+    PutObject("multi_key");
+    for (bool disk : {false, true}) {
+        SCOPED_TRACE(disk ? "disk" : "memory");
+        // Disjoint, out of order, overlapping and empty ranges
+        ExpectRanges("multi_key", disk,
+                     {{8192, 100},
+                      {0, 512},
+                      {kObjectSize - 1, 1},
+                      {300, 1024},
+                      {4096, 0},
+                      {16384, 16384}});
+    }
+}
+
+TEST_F(RangeReadTest, OutOfBoundsRange) {
+    PutObject("out_of_bounds_key");
+    for (bool disk : {false, true}) {
+        SCOPED_TRACE(disk ? "disk" : "memory");
+        ExpectOutOfBounds("out_of_bounds_key", disk);
+    }
+}
+
+}  // namespace testing
+}  // namespace mooncake
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    mooncake::init_ylt_log_level();
+    return RUN_ALL_TESTS();
+}
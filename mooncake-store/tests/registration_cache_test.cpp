@@ -0,0 +1,111 @@
+#include "registration_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace mooncake::test {
+
+namespace {
+
+// Stands in for the transfer engine, recording the registered ranges
+struct FakeEngine {
+    std::map<uintptr_t, size_t> registered;
+    int registrations = 0;
+
+    RegistrationCache MakeCache(size_t idle_capacity) {
+        return RegistrationCache(
+            [this](void* addr, size_t length,
+                   const std::string&) -> tl::expected<void, ErrorCode> {
+                registrations++;
+                registered[reinterpret_cast<uintptr_t>(addr)] = length;
+                return {};
+            },
+            [this](void* addr) -> tl::expected<void, ErrorCode> {
+                if (registered.erase(reinterpret_cast<uintptr_t>(addr)) ==
+                    0) {
+                    return tl::make_unexpected(ErrorCode::INVALID_PARAMS);
+                }
+                return {};
+            },
+            idle_capacity);
+    }
+};
+
+void* Addr(uintptr_t value) { return reinterpret_cast<void*>(value); }
+
+}  // namespace
+
+TEST(RegistrationCacheTest, RegisteredRangesAreShared) {
+    FakeEngine engine;
+    auto cache = engine.MakeCache(0);
+    ASSERT_TRUE(cache.Register(Addr(0x10000), 4096, "cpu:0"));
+    // Inside the registered range
+    ASSERT_TRUE(cache.Register(Addr(0x10000), 4096, "cpu:0"));
+    ASSERT_TRUE(cache.Register(Addr(0x10800), 1024, "cpu:0"));
+    EXPECT_EQ(engine.registrations, 1);
+    // Another location is registered on its own
+    ASSERT_TRUE(cache.Register(Addr(0x20000), 4096, "cuda:0"));
+    EXPECT_EQ(engine.registrations, 2);
+    EXPECT_EQ(cache.GetStats().hits, 2u);
+
+    ASSERT_TRUE(cache.Unregister(Addr(0x10800)));
+    ASSERT_TRUE(cache.Unregister(Addr(0x10000)));
+    EXPECT_EQ(engine.registered.count(0x10000), 1u);
+    // Without idle capacity the last release deregisters
+    ASSERT_TRUE(cache.Unregister(Addr(0x10000)));
+    EXPECT_EQ(engine.registered.count(0x10000), 0u);
+    // Unknown addresses go to the engine
+    EXPECT_FALSE(cache.Unregister(Addr(0x30000)));
+}
+
+TEST(RegistrationCacheTest, ReleasedRangesStayRegistered) {
+    FakeEngine engine;
+    auto cache = engine.MakeCache(8192);
+    for (int step = 0; step < 10; ++step) {
+        ASSERT_TRUE(cache.Register(Addr(0x10000), 4096, "cpu:0"));
+        ASSERT_TRUE(cache.Unregister(Addr(0x10000)));
+    }
+    EXPECT_EQ(engine.registrations, 1);
+    EXPECT_EQ(cache.GetStats().idle_bytes, 4096u);
+
+    // The least recently released range goes over the capacity
+    ASSERT_TRUE(cache.Register(Addr(0x20000), 4096, "cpu:0"));
+    ASSERT_TRUE(cache.Register(Addr(0x30000), 4096, "cpu:0"));
+    ASSERT_TRUE(cache.Unregister(Addr(0x20000)));
+    ASSERT_TRUE(cache.Unregister(Addr(0x30000)));
+    EXPECT_EQ(engine.registered.count(0x10000), 0u);
+    EXPECT_EQ(engine.registered.size(), 2u);
+    EXPECT_EQ(cache.GetStats().idle_bytes, 8192u);
+
+    cache.Clear();
+    EXPECT_TRUE(engine.registered.empty());
+}
+
+TEST(RegistrationCacheTest, RemappedRangesAreDeregistered) {
+    FakeEngine engine;
+    auto cache = engine.MakeCache(1 << 20);
+    ASSERT_TRUE(cache.Register(Addr(0x10000), 4096, "cpu:0"));
+    ASSERT_TRUE(cache.Unregister(Addr(0x10000)));
+    // A larger buffer at the same address replaces the idle range
+    ASSERT_TRUE(cache.Register(Addr(0x10000), 8192, "cpu:0"));
+    EXPECT_EQ(engine.registrations, 2);
+    EXPECT_EQ(engine.registered.at(0x10000), 8192u);
+    EXPECT_EQ(cache.GetStats().regions, 1u);
+
+    // Busy ranges are only deregistered once released
+    cache.Invalidate(Addr(0x11000), 1);
+    EXPECT_EQ(engine.registered.count(0x10000), 1u);
+    ASSERT_TRUE(cache.Unregister(Addr(0x10000)));
+    EXPECT_EQ(engine.registered.count(0x10000), 0u);
+
+    ASSERT_TRUE(cache.Register(Addr(0x20000), 4096, "cpu:0"));
+    ASSERT_TRUE(cache.Unregister(Addr(0x20000)));
+    cache.Invalidate(Addr(0x20000), 4096);
+    EXPECT_TRUE(engine.registered.empty());
+    EXPECT_EQ(cache.GetStats().idle_bytes, 0u);
+}
+
+}  // namespace mooncake::test
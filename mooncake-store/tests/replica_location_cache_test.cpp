@@ -0,0 +1,101 @@
+#include "replica_location_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<Replica::Descriptor> MakeReplicas() {
+    Replica::Descriptor desc;
+    desc.status = ReplicaStatus::COMPLETE;
+    return {desc};
+}
+
+}  // namespace
+
+TEST(ReplicaLocationCacheTest, ServesUntilHalfOfTheLease) {
+    ReplicaLocationCache cache(16);
+    ASSERT_TRUE(cache.enabled());
+    EXPECT_FALSE(cache.Get("key").has_value());
+
+    auto now = Clock::now();
+    cache.Put("key", cache.generation(), MakeReplicas(), now,
+              now + std::chrono::seconds(10));
+    auto cached = cache.Get("key");
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(1, cached->replicas.size());
+    EXPECT_EQ(now + std::chrono::seconds(10), cached->lease_timeout);
+
+    // Less than half of the lease is left
+    now = Clock::now();
+    cache.Put("short", cache.generation(), MakeReplicas(),
+              now - std::chrono::milliseconds(60),
+              now + std::chrono::milliseconds(40));
+    EXPECT_FALSE(cache.Get("short").has_value());
+    // No lease at all
+    cache.Put("none", cache.generation(), MakeReplicas(), now, now);
+    EXPECT_FALSE(cache.Get("none").has_value());
+}
+
+TEST(ReplicaLocationCacheTest, Invalidation) {
+    ReplicaLocationCache cache(16);
+    const auto now = Clock::now();
+    const auto lease_timeout = now + std::chrono::seconds(10);
+
+    cache.Put("key", cache.generation(), MakeReplicas(), now, lease_timeout);
+    cache.Invalidate("key");
+    EXPECT_FALSE(cache.Get("key").has_value());
+
+    // A query sent before an invalidation is not cached
+    const uint64_t generation = cache.generation();
+    cache.Invalidate("other_key");
+    cache.Put("key", generation, MakeReplicas(), now, lease_timeout);
+    EXPECT_FALSE(cache.Get("key").has_value());
+
+    // A new epoch or master view drops everything
+    cache.SyncEpoch(1, 0);
+    cache.Put("key", cache.generation(), MakeReplicas(), now, lease_timeout);
+    cache.SyncEpoch(1, 0);
+    EXPECT_TRUE(cache.Get("key").has_value());
+    cache.SyncEpoch(1, 1);
+    EXPECT_FALSE(cache.Get("key").has_value());
+    cache.Put("key", cache.generation(), MakeReplicas(), now, lease_timeout);
+    cache.SyncEpoch(2, 1);
+    EXPECT_EQ(0, cache.size());
+}
+
+TEST(ReplicaLocationCacheTest, BoundedSize) {
+    ReplicaLocationCache cache(32);
+    const auto now = Clock::now();
+    for (int i = 0; i < 1000; i++) {
+        cache.Put("key_" + std::to_string(i), cache.generation(),
+                  MakeReplicas(), now, now + std::chrono::seconds(10));
+    }
+    EXPECT_LE(cache.size(), 32);
+    EXPECT_TRUE(cache.Get("key_999").has_value());
+
+    ReplicaLocationCache disabled(0);
+    EXPECT_FALSE(disabled.enabled());
+    disabled.Put("key", disabled.generation(), MakeReplicas(), now,
+                 now + std::chrono::seconds(10));
+    EXPECT_FALSE(disabled.Get("key").has_value());
+}
+
+TEST(ReplicaLocationCacheTest, ChainSuccessorKeys) {
+    EXPECT_EQ((std::vector<std::string>{"req/0008", "req/0009", "req/0010"}),
+              ChainSuccessorKeys("req/0007", 3));
+    EXPECT_EQ((std::vector<std::string>{"block_10", "block_11"}),
+              ChainSuccessorKeys("block_9", 2));
+    EXPECT_TRUE(ChainSuccessorKeys("block", 2).empty());
+    EXPECT_TRUE(ChainSuccessorKeys("12345678901234567890", 2).empty());
+}
+
+}  // namespace mooncake::test
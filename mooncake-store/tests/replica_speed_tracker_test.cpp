@@ -0,0 +1,66 @@
+#include "replica_speed_tracker.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace mooncake::test {
+
+using namespace std::chrono_literals;
+
+TEST(ReplicaSpeedTrackerTest, NoEstimateWithoutSamples) {
+    ReplicaSpeedTracker tracker(10s);
+    EXPECT_FALSE(tracker.Estimate("a:1", 1024).has_value());
+
+    // Only the bandwidth is known, a small read needs the latency
+    tracker.Record("a:1", 1024 * 1024, 100);
+    EXPECT_FALSE(tracker.Estimate("a:1", 1024).has_value());
+    ASSERT_TRUE(tracker.Estimate("a:1", 2 * 1024 * 1024).has_value());
+    EXPECT_DOUBLE_EQ(200, *tracker.Estimate("a:1", 2 * 1024 * 1024));
+}
+
+TEST(ReplicaSpeedTrackerTest, MovingAverage) {
+    ReplicaSpeedTracker tracker(10s);
+    tracker.Record("a:1", 1024, 100);
+    EXPECT_DOUBLE_EQ(100, *tracker.Estimate("a:1", 1024));
+    tracker.Record("a:1", 1024, 200);
+    EXPECT_DOUBLE_EQ(100 + ReplicaSpeedTracker::kAlpha * 100,
+                     *tracker.Estimate("a:1", 1024));
+}
+
+TEST(ReplicaSpeedTrackerTest, PicksTheFastest) {
+    ReplicaSpeedTracker tracker(10s);
+    const uint64_t size = 4 * 1024 * 1024;
+    tracker.Record("a:1", size, 4000);
+    tracker.Record("b:1", size, 1000);
+    tracker.Record("c:1", size, 2000);
+    EXPECT_EQ(1, tracker.PickFastest({"a:1", "b:1", "c:1"}, size));
+
+    // Endpoints without an estimate are probed first
+    EXPECT_EQ(1, tracker.PickFastest({"a:1", "d:1", "b:1"}, size));
+}
+
+TEST(ReplicaSpeedTrackerTest, FailuresAvoidTheEndpoint) {
+    ReplicaSpeedTracker tracker(10s);
+    tracker.Record("a:1", 1024, 100);
+    tracker.Record("b:1", 1024, 200);
+    EXPECT_EQ(0, tracker.PickFastest({"a:1", "b:1"}, 1024));
+
+    tracker.RecordFailure("a:1");
+    EXPECT_EQ(1, tracker.PickFastest({"a:1", "b:1"}, 1024));
+}
+
+TEST(ReplicaSpeedTrackerTest, StaleEstimatesExpire) {
+    ReplicaSpeedTracker tracker(50ms);
+    tracker.RecordFailure("a:1");
+    EXPECT_TRUE(tracker.Estimate("a:1", 1024).has_value());
+
+    std::this_thread::sleep_for(100ms);
+    EXPECT_FALSE(tracker.Estimate("a:1", 1024).has_value());
+
+    // A new sample does not average with the stale one
+    tracker.Record("a:1", 1024, 100);
+    EXPECT_DOUBLE_EQ(100, *tracker.Estimate("a:1", 1024));
+}
+
+}  // namespace mooncake::test
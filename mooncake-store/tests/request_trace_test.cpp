@@ -0,0 +1,113 @@
+#include "request_trace.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+class RequestTraceTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        path_ = "/tmp/request_trace_test_" + std::to_string(getpid()) +
+                ".jsonl";
+        std::remove(path_.c_str());
+    }
+
+    void TearDown() override {
+        TraceSpan::Configure(0, path_);
+        std::remove(path_.c_str());
+    }
+
+    std::vector<std::string> Lines() const {
+        std::ifstream file(path_);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // Value of a string field of a JSON span line
+    static std::string Field(const std::string& line,
+                             const std::string& name) {
+        const std::string prefix = "\"" + name + "\":\"";
+        auto begin = line.find(prefix);
+        if (begin == std::string::npos) {
+            return "";
+        }
+        begin += prefix.size();
+        return line.substr(begin, line.find('"', begin) - begin);
+    }
+
+    std::string path_;
+};
+
+}  // namespace
+
+TEST_F(RequestTraceTest, DisabledRecordsNothing) {
+    TraceSpan::Configure(0, path_);
+    {
+        TraceSpan root("root", TraceSpan::Kind::ROOT);
+        TraceSpan child("child");
+        EXPECT_FALSE(root.active());
+        EXPECT_FALSE(child.active());
+    }
+    EXPECT_TRUE(Lines().empty());
+}
+
+TEST_F(RequestTraceTest, ChildrenShareTheTraceOfTheirParent) {
+    TraceSpan::Configure(1, path_);
+    {
+        TraceSpan orphan("orphan");
+        EXPECT_FALSE(orphan.active());
+    }
+    {
+        TraceSpan root("root", TraceSpan::Kind::ROOT);
+        root.SetAttribute("key", "a\"b");
+        {
+            TraceSpan child("child");
+            child.SetAttribute("slices", int64_t{3});
+            TraceSpan nested_root("nested", TraceSpan::Kind::ROOT);
+            EXPECT_TRUE(nested_root.active());
+        }
+    }
+    auto lines = Lines();
+    ASSERT_EQ(lines.size(), 3u);
+    // Spans are written as they end
+    EXPECT_EQ(Field(lines[0], "name"), "nested");
+    EXPECT_EQ(Field(lines[1], "name"), "child");
+    EXPECT_EQ(Field(lines[2], "name"), "root");
+
+    const std::string trace_id = Field(lines[2], "traceId");
+    EXPECT_EQ(trace_id.size(), 32u);
+    for (const auto& line : lines) {
+        EXPECT_EQ(Field(line, "traceId"), trace_id);
+    }
+    EXPECT_EQ(Field(lines[2], "parentSpanId"), "");
+    EXPECT_EQ(Field(lines[1], "parentSpanId"), Field(lines[2], "spanId"));
+    EXPECT_EQ(Field(lines[0], "parentSpanId"), Field(lines[1], "spanId"));
+
+    EXPECT_NE(lines[2].find(R"({"key":"key","value":{"stringValue":"a\"b"}})"),
+              std::string::npos);
+    EXPECT_NE(lines[1].find(R"({"key":"slices","value":{"intValue":"3"}})"),
+              std::string::npos);
+}
+
+TEST_F(RequestTraceTest, SeparateRootsStartSeparateTraces) {
+    TraceSpan::Configure(1, path_);
+    { TraceSpan first("first", TraceSpan::Kind::ROOT); }
+    { TraceSpan second("second", TraceSpan::Kind::ROOT); }
+    auto lines = Lines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_NE(Field(lines[0], "traceId"), Field(lines[1], "traceId"));
+}
+
+}  // namespace mooncake::test
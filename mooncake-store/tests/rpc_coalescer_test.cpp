@@ -0,0 +1,75 @@
+#include "rpc_coalescer.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+// Echoes the keys and counts the batches and their largest size
+struct EchoBatch {
+    std::atomic<size_t> num_batches{0};
+    std::atomic<size_t> max_batch_size{0};
+
+    std::vector<std::string> operator()(const std::vector<std::string>& keys) {
+        num_batches++;
+        size_t max_size = max_batch_size.load();
+        while (keys.size() > max_size &&
+               !max_batch_size.compare_exchange_weak(max_size, keys.size())) {
+        }
+        return keys;
+    }
+};
+
+}  // namespace
+
+TEST(RpcCoalescerTest, SingleCallerGetsItsOwnBatch) {
+    EchoBatch echo;
+    RpcCoalescer<std::string> coalescer(
+        std::chrono::microseconds(100), 16,
+        [&echo](const std::vector<std::string>& keys) { return echo(keys); });
+    EXPECT_EQ("key1", coalescer.Call("key1"));
+    EXPECT_EQ("key2", coalescer.Call("key2"));
+    EXPECT_EQ(2, echo.num_batches);
+    EXPECT_EQ(1, echo.max_batch_size);
+}
+
+TEST(RpcCoalescerTest, MergesConcurrentCalls) {
+    constexpr size_t kNumThreads = 32;
+    constexpr size_t kCallsPerThread = 100;
+    constexpr size_t kMaxBatchSize = 8;
+    EchoBatch echo;
+    RpcCoalescer<std::string> coalescer(
+        std::chrono::milliseconds(1), kMaxBatchSize,
+        [&echo](const std::vector<std::string>& keys) { return echo(keys); });
+
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kNumThreads; t++) {
+        threads.emplace_back([&, t] {
+            for (size_t i = 0; i < kCallsPerThread; i++) {
+                const std::string key =
+                    std::to_string(t) + "_" + std::to_string(i);
+                if (coalescer.Call(key) != key) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Every caller gets the result of its own key
+    EXPECT_EQ(0, mismatches);
+    EXPECT_LT(echo.num_batches, kNumThreads * kCallsPerThread);
+    EXPECT_LE(echo.max_batch_size, kMaxBatchSize);
+    EXPECT_GT(echo.max_batch_size, 1);
+}
+
+}  // namespace mooncake::test
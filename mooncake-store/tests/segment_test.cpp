@@ -460,6 +460,62 @@ TEST_F(SegmentTest, QuerySegments) {
     ASSERT_EQ(capacity, 0);
 }
 
+// DrainSegment:
+// A draining segment takes no new allocations but is still reported, and
+// can be unmounted or undrained.
+TEST_F(SegmentTest, DrainSegment) {
+    SegmentManager segment_manager;
+    auto segment_access = segment_manager.getSegmentAccess();
+
+    Segment segment;
+    segment.id = generate_uuid();
+    segment.name = "drain_segment";
+    segment.size = 1024 * 1024 * 16;
+    segment.base = 0x100000000;
+    UUID client_id = generate_uuid();
+    ASSERT_EQ(segment_access.MountSegment(segment, client_id), ErrorCode::OK);
+
+    ASSERT_EQ(segment_access.SetSegmentDraining("missing", true),
+              ErrorCode::SEGMENT_NOT_FOUND);
+    ASSERT_EQ(segment_access.SetSegmentDraining(segment.name, true),
+              ErrorCode::OK);
+
+    std::vector<SegmentUsage> usage;
+    segment_access.GetSegmentUsage(usage);
+    ASSERT_EQ(usage.size(), 1);
+    EXPECT_EQ(usage[0].name, segment.name);
+    EXPECT_EQ(usage[0].capacity, segment.size);
+    EXPECT_TRUE(usage[0].draining);
+
+    size_t used = 0, capacity = 0;
+    ASSERT_EQ(segment_access.QuerySegments(segment.name, used, capacity),
+              ErrorCode::OK);
+    EXPECT_EQ(capacity, segment.size);
+
+    // Mounting it again while draining is still a duplicate
+    ASSERT_EQ(segment_access.MountSegment(segment, client_id),
+              ErrorCode::SEGMENT_ALREADY_EXISTS);
+
+    ASSERT_EQ(segment_access.SetSegmentDraining(segment.name, false),
+              ErrorCode::OK);
+    usage.clear();
+    segment_access.GetSegmentUsage(usage);
+    ASSERT_EQ(usage.size(), 1);
+    EXPECT_FALSE(usage[0].draining);
+    ValidateMountedSegment(segment_manager, segment, client_id);
+
+    ASSERT_EQ(segment_access.SetSegmentDraining(segment.name, true),
+              ErrorCode::OK);
+    size_t metrics_dec_capacity = 0;
+    ASSERT_EQ(
+        segment_access.PrepareUnmountSegment(segment.id, metrics_dec_capacity),
+        ErrorCode::OK);
+    ASSERT_EQ(metrics_dec_capacity, segment.size);
+    ASSERT_EQ(segment_access.CommitUnmountSegment(segment.id, client_id,
+                                                  metrics_dec_capacity),
+              ErrorCode::OK);
+}
+
 // Mount Local Disk Segment Operations Tests:
 TEST_F(SegmentTest, MountLocalDiskSegmentSuccess) {
     SegmentManager segment_manager;
@@ -165,6 +165,65 @@ TEST_F(SerializerTest, ExampleClassDeserializationWithException) {
     EXPECT_EQ(restored, nullptr);
 }
 
+TEST_F(SerializerTest, ChunkWriterMatchesTwoPassSerialization) {
+    // Large enough to span several chunks, with one write larger than the
+    // largest chunk
+    for (size_t length :
+         {size_t{0}, size_t{100}, SerializeChunkWriter::kMinChunkSize * 3 + 7,
+          SerializeChunkWriter::kMaxChunkSize + 13}) {
+        std::string name(length, '\0');
+        for (size_t i = 0; i < length; i++) {
+            name[i] = static_cast<char>(i * 31 + 7);
+        }
+        ExampleClass original(5, 1.5, name);
+
+        std::vector<SerializedByte> expected;
+        ASSERT_EQ(serialize_to(original, expected), ErrorCode::OK);
+
+        SerializeChunkWriter writer;
+        ASSERT_EQ(serialize_to(original, writer), ErrorCode::OK);
+        ASSERT_EQ(writer.size(), expected.size());
+
+        std::vector<SerializedByte> gathered;
+        writer.for_each_chunk([&gathered](const void* data, size_t size) {
+            const auto* bytes = static_cast<const SerializedByte*>(data);
+            gathered.insert(gathered.end(), bytes, bytes + size);
+        });
+        EXPECT_EQ(gathered, expected);
+
+        auto restored = deserialize_from<ExampleClass>(gathered);
+        ASSERT_NE(restored, nullptr);
+        EXPECT_TRUE(*restored == original);
+    }
+}
+
+TEST_F(SerializerTest, ChunkWriterWritesToFd) {
+    const std::string name(SerializeChunkWriter::kMinChunkSize, 'x');
+    ExampleClass original(9, 2.5, name);
+    SerializeChunkWriter writer;
+    ASSERT_EQ(serialize_to(original, writer), ErrorCode::OK);
+
+    FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    const uint32_t trailer = 0xA5A5A5A5u;
+    ASSERT_TRUE(writer.write_to_fd(::fileno(file), &trailer, sizeof(trailer)));
+
+    std::vector<SerializedByte> buffer(writer.size() + sizeof(trailer));
+    std::rewind(file);
+    ASSERT_EQ(std::fread(buffer.data(), 1, buffer.size(), file),
+              buffer.size());
+    std::fclose(file);
+
+    uint32_t read_trailer;
+    std::memcpy(&read_trailer, buffer.data() + writer.size(),
+                sizeof(read_trailer));
+    EXPECT_EQ(read_trailer, trailer);
+    buffer.resize(writer.size());
+    auto restored = deserialize_from<ExampleClass>(buffer);
+    ASSERT_NE(restored, nullptr);
+    EXPECT_TRUE(*restored == original);
+}
+
 }  // namespace mooncake::test
 
 int main(int argc, char** argv) {
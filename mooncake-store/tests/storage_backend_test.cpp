@@ -4,11 +4,13 @@
 #include <gtest/gtest.h>
 
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <ranges>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <unordered_set>
 #include <fcntl.h>
 #include <unistd.h>
 #include <ylt/util/tl/expected.hpp>
@@ -507,6 +509,158 @@ TEST_F(StorageBackendTest, OrphanedBucketFileCleanup) {
     ASSERT_TRUE(is_exist.value());
 }
 
+TEST_F(StorageBackendTest, BucketIndexCheckpointRestart) {
+    FileStorageConfig config;
+    config.storage_filepath = data_path;
+    BucketBackendConfig bucket_config;
+    bucket_config.scan_threads = 4;
+    bucket_config.index_checkpoint_interval_sec = 3600;
+
+    std::vector<std::string> keys;
+    std::vector<int64_t> sizes;
+    std::vector<int64_t> buckets;
+    std::unordered_map<std::string, std::string> test_data;
+    {
+        BucketStorageBackend storage_backend(config, bucket_config);
+        ASSERT_TRUE(BatchOffloadUtil(storage_backend, keys, sizes, test_data,
+                                     buckets));
+        ASSERT_TRUE(storage_backend.WriteIndexCheckpoint());
+    }
+    const std::string checkpoint_path = data_path + "/bucket_index.ckpt";
+    ASSERT_TRUE(fs::exists(checkpoint_path));
+
+    auto verify = [&](BucketStorageBackend& storage_backend) {
+        std::shared_ptr<SimpleAllocator> client_buffer_allocator =
+            std::make_shared<SimpleAllocator>(128 * 1024 * 1024);
+        std::unordered_map<std::string, Slice> batch_object;
+        for (const auto& [key, value] : test_data) {
+            auto is_exist = storage_backend.IsExist(key);
+            ASSERT_TRUE(is_exist);
+            ASSERT_TRUE(is_exist.value());
+            batch_object.emplace(
+                key, Slice{client_buffer_allocator->allocate(value.size()),
+                           value.size()});
+        }
+        ASSERT_TRUE(storage_backend.BatchLoad(batch_object));
+        for (const auto& [key, value] : test_data) {
+            const auto& slice = batch_object.at(key);
+            ASSERT_EQ(std::string(static_cast<char*>(slice.ptr), slice.size),
+                      value);
+        }
+    };
+
+    // All buckets come from the checkpoint
+    {
+        BucketStorageBackend storage_backend(config, bucket_config);
+        ASSERT_TRUE(storage_backend.Init());
+        verify(storage_backend);
+    }
+
+    // A corrupted checkpoint falls back to reading every metadata file
+    {
+        std::ofstream checkpoint_file(checkpoint_path,
+                                      std::ios::binary | std::ios::trunc);
+        checkpoint_file << "not a checkpoint";
+    }
+    {
+        BucketStorageBackend storage_backend(config, bucket_config);
+        ASSERT_TRUE(storage_backend.Init());
+        verify(storage_backend);
+    }
+}
+
+TEST_F(StorageBackendTest, BucketGroupCommit) {
+    FileStorageConfig config;
+    config.storage_filepath = data_path;
+    BucketBackendConfig bucket_config;
+    bucket_config.group_commit_window_us = 20000;
+    BucketStorageBackend storage_backend(config, bucket_config);
+    ASSERT_TRUE(storage_backend.Init());
+
+    constexpr int kThreads = 8;
+    constexpr int kBatches = 4;
+    constexpr int kKeys = 10;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> test_data;
+    std::unordered_set<int64_t> bucket_ids;
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int b = 0; b < kBatches; ++b) {
+                std::unordered_map<std::string, std::vector<Slice>> batch;
+                std::vector<std::string> values;
+                values.reserve(kKeys);
+                for (int k = 0; k < kKeys; ++k) {
+                    std::string key = "group_key_" + std::to_string(t) + "_" +
+                                      std::to_string(b) + "_" +
+                                      std::to_string(k);
+                    values.push_back("group_value_" + key);
+                    batch.emplace(key, std::vector<Slice>{Slice{
+                                           values.back().data(),
+                                           values.back().size()}});
+                }
+                auto result = storage_backend.BatchOffload(
+                    batch, [&](const std::vector<std::string>& keys,
+                               std::vector<StorageObjectMetadata>& metadatas) {
+                        return keys.size() == batch.size() &&
+                                       metadatas.size() == batch.size()
+                                   ? ErrorCode::OK
+                                   : ErrorCode::INVALID_KEY;
+                    });
+                if (!result) {
+                    failures++;
+                    continue;
+                }
+                std::lock_guard lock(mutex);
+                bucket_ids.insert(result.value());
+                for (const auto& [key, slices] : batch) {
+                    test_data.emplace(
+                        key, std::string(static_cast<char*>(slices[0].ptr),
+                                         slices[0].size));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_EQ(test_data.size(), kThreads * kBatches * kKeys);
+
+    // One data and one metadata file per group
+    int meta_files = 0;
+    for (const auto& entry : fs::directory_iterator(data_path)) {
+        if (entry.path().extension() == ".meta") {
+            meta_files++;
+        }
+    }
+    ASSERT_EQ(meta_files, static_cast<int>(bucket_ids.size()));
+    ASSERT_LE(bucket_ids.size(), static_cast<size_t>(kThreads * kBatches));
+
+    auto verify = [&](BucketStorageBackend& backend) {
+        std::shared_ptr<SimpleAllocator> client_buffer_allocator =
+            std::make_shared<SimpleAllocator>(128 * 1024 * 1024);
+        std::unordered_map<std::string, Slice> batch_object;
+        for (const auto& [key, value] : test_data) {
+            batch_object.emplace(
+                key, Slice{client_buffer_allocator->allocate(value.size()),
+                           value.size()});
+        }
+        ASSERT_TRUE(backend.BatchLoad(batch_object));
+        for (const auto& [key, value] : test_data) {
+            const auto& slice = batch_object.at(key);
+            ASSERT_EQ(std::string(static_cast<char*>(slice.ptr), slice.size),
+                      value);
+        }
+    };
+    verify(storage_backend);
+
+    BucketStorageBackend restarted_backend(config, bucket_config);
+    ASSERT_TRUE(restarted_backend.Init());
+    verify(restarted_backend);
+}
+
 TEST_F(StorageBackendTest, AdaptorBatchOffloadAndBatchLoad) {
     FileStorageConfig cfg;
 
@@ -1318,6 +1472,57 @@ TEST_F(StorageBackendTest, OffsetAllocatorStorageBackend_CorruptedHeader) {
 
 //-----------------------------------------------------------------------------
 
+TEST_F(StorageBackendTest, OffsetAllocatorStorageBackend_ChecksumMismatch) {
+    FileStorageConfig config;
+    config.storage_filepath = data_path;
+    config.storage_backend_type = StorageBackendType::kOffsetAllocator;
+    config.total_size_limit = 10 * 1024 * 1024;
+    config.total_keys_limit = 1000;
+    config.enable_checksum = true;
+
+    OffsetAllocatorStorageBackend storage_backend(config);
+    ASSERT_TRUE(storage_backend.Init());
+
+    // The checksum covers the value across its slices
+    std::string key = "test_key";
+    std::string first = "test_", second = "value";
+    std::string value = first + second;
+    {
+        std::unordered_map<std::string, std::vector<Slice>> batch_object;
+        batch_object.emplace(
+            key, std::vector<Slice>{Slice{first.data(), first.size()},
+                                    Slice{second.data(), second.size()}});
+        auto offload_res = storage_backend.BatchOffload(
+            batch_object,
+            [](const std::vector<std::string>&,
+               std::vector<StorageObjectMetadata>&) { return ErrorCode::OK; });
+        ASSERT_TRUE(offload_res);
+    }
+
+    std::string loaded(value.size(), '\0');
+    std::unordered_map<std::string, Slice> load_slices;
+    load_slices.emplace(key, Slice{loaded.data(), loaded.size()});
+    ASSERT_TRUE(storage_backend.BatchLoad(load_slices));
+    EXPECT_EQ(loaded, value);
+
+    // Flip a bit of the value on disk, the header and key stay valid
+    std::string data_file = data_path + "/kv_cache.data";
+    int fd = open(data_file.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    const off_t value_offset = 2 * sizeof(uint32_t) + key.size();
+    char byte;
+    ASSERT_EQ(pread(fd, &byte, 1, value_offset), 1);
+    byte ^= 0x01;
+    ASSERT_EQ(pwrite(fd, &byte, 1, value_offset), 1);
+    close(fd);
+
+    auto load_res = storage_backend.BatchLoad(load_slices);
+    ASSERT_FALSE(load_res.has_value());
+    EXPECT_EQ(load_res.error(), ErrorCode::FILE_CHECKSUM_MISMATCH);
+}
+
+//-----------------------------------------------------------------------------
+
 TEST_F(StorageBackendTest,
        OffsetAllocatorStorageBackend_IsEnableOffloadingLimits) {
     FileStorageConfig config;
@@ -1750,4 +1955,99 @@ TEST_F(StorageBackendTest,
 
 //-----------------------------------------------------------------------------
 
+TEST_F(StorageBackendTest, LogStructuredStorageBackend_PartialSuccess) {
+    FileStorageConfig config;
+    config.storage_filepath = data_path;
+    config.storage_backend_type = StorageBackendType::kLogStructured;
+    config.total_size_limit = 10 * 1024 * 1024;
+    config.total_keys_limit = 1000;
+
+    LogStructuredStorageBackend storage_backend(config, LogStructuredConfig{});
+    ASSERT_TRUE(storage_backend.Init());
+
+    StorageBackendTest::TestPartialSuccessBehavior(
+        storage_backend, "LogStructuredStorageBackend");
+}
+
+//-----------------------------------------------------------------------------
+
+TEST_F(StorageBackendTest, LogStructuredStorageBackend_CompactionKeepsData) {
+    FileStorageConfig config;
+    config.storage_filepath = data_path;
+    config.storage_backend_type = StorageBackendType::kLogStructured;
+    config.total_size_limit = 10 * 1024 * 1024;
+    config.total_keys_limit = 1000;
+
+    LogStructuredConfig log_config;
+    log_config.segment_size_limit = 16 * 1024;
+    log_config.compaction_interval_ms = 3600 * 1000;  // Compact() by hand
+
+    LogStructuredStorageBackend storage_backend(config, log_config);
+    ASSERT_TRUE(storage_backend.Init());
+
+    constexpr int kNumKeys = 32;
+    constexpr size_t kValueSize = 1000;
+    auto put_all = [&](char fill) {
+        std::string value(kValueSize, fill);
+        std::unordered_map<std::string, std::vector<Slice>> batch_object;
+        for (int i = 0; i < kNumKeys; ++i) {
+            batch_object.emplace("key_" + std::to_string(i),
+                                 std::vector<Slice>{Slice{value.data(),
+                                                          value.size()}});
+        }
+        auto offload_res = storage_backend.BatchOffload(
+            batch_object,
+            [](const std::vector<std::string>&,
+               std::vector<StorageObjectMetadata>&) { return ErrorCode::OK; });
+        ASSERT_TRUE(offload_res);
+        EXPECT_EQ(offload_res.value(), kNumKeys);
+    };
+
+    // Every round overwrites all keys, leaving the previous ones dead
+    for (char fill = 'a'; fill <= 'e'; ++fill) {
+        put_all(fill);
+    }
+    const int64_t disk_size_before = storage_backend.GetDiskSize();
+    const size_t segments_before = storage_backend.GetSegmentCount();
+    EXPECT_GT(segments_before, 2u);
+
+    auto compact_res = storage_backend.Compact();
+    ASSERT_TRUE(compact_res);
+    EXPECT_GT(compact_res.value(), 0u);
+    EXPECT_LT(storage_backend.GetDiskSize(), disk_size_before);
+    EXPECT_LT(storage_backend.GetSegmentCount(), segments_before);
+
+    // The files of the compacted segments are gone
+    size_t segment_files = 0;
+    for (const auto& entry : fs::directory_iterator(data_path)) {
+        if (entry.path().extension() == ".log") {
+            segment_files++;
+        }
+    }
+    EXPECT_EQ(segment_files, storage_backend.GetSegmentCount());
+
+    // All keys still read their last value
+    std::vector<std::string> buffers(kNumKeys, std::string(kValueSize, '\0'));
+    std::unordered_map<std::string, Slice> load_slices;
+    for (int i = 0; i < kNumKeys; ++i) {
+        load_slices.emplace("key_" + std::to_string(i),
+                            Slice{buffers[i].data(), kValueSize});
+    }
+    ASSERT_TRUE(storage_backend.BatchLoad(load_slices));
+    for (const auto& buffer : buffers) {
+        EXPECT_EQ(buffer, std::string(kValueSize, 'e'));
+    }
+
+    int64_t scanned = 0;
+    ASSERT_TRUE(storage_backend.ScanMeta(
+        [&](const std::vector<std::string>& keys,
+            std::vector<StorageObjectMetadata>&) {
+            scanned += keys.size();
+            return ErrorCode::OK;
+        }));
+    EXPECT_EQ(scanned, kNumKeys);
+}
+
+//-----------------------------------------------------------------------------
+
 }  // namespace mooncake::test
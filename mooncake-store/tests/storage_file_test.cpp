@@ -0,0 +1,105 @@
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "file_interface.h"
+#include "uring_file.h"
+
+namespace mooncake::test {
+
+class StorageFileTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        char path[] = "/tmp/mooncake_storage_file_XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        path_ = path;
+        data_.resize(64 * 1024);
+        for (size_t i = 0; i < data_.size(); ++i) {
+            data_[i] = static_cast<char>(i * 131 + 17);
+        }
+        ASSERT_EQ(static_cast<ssize_t>(data_.size()),
+                  ::write(fd, data_.data(), data_.size()));
+        close(fd);
+    }
+
+    void TearDown() override { ::unlink(path_.c_str()); }
+
+    // Reads scattered ranges of the file, unaligned and aligned ones
+    void CheckBatchRead(StorageFile& file) {
+        std::vector<std::pair<off_t, size_t>> ranges = {
+            {0, 4096}, {5, 1000}, {8192, 16384}, {40000, 1}, {65000, 536}};
+        std::vector<std::vector<char>> buffers;
+        std::vector<FileReadRequest> requests;
+        for (auto [offset, length] : ranges) {
+            buffers.emplace_back(length);
+        }
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            requests.push_back(FileReadRequest{
+                buffers[i].data(), ranges[i].second, ranges[i].first});
+        }
+        ASSERT_TRUE(file.batch_read(requests).has_value());
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            EXPECT_EQ(0, memcmp(buffers[i].data(),
+                                data_.data() + ranges[i].first,
+                                ranges[i].second))
+                << "offset=" << ranges[i].first;
+        }
+
+        // Past the end of the file
+        std::vector<char> tail(1024);
+        EXPECT_FALSE(file.batch_read({FileReadRequest{tail.data(), tail.size(),
+                                                      65000}})
+                         .has_value());
+    }
+
+    std::string path_;
+    std::vector<char> data_;
+};
+
+TEST_F(StorageFileTest, PosixBatchRead) {
+    PosixFile file(path_, open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    CheckBatchRead(file);
+}
+
+#ifdef STORE_USE_URING
+TEST_F(StorageFileTest, UringBatchRead) {
+    std::vector<char> registered(128 * 1024);
+    UringFile::RegisterBuffer(registered.data(), registered.size());
+    UringFile file(path_, open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    CheckBatchRead(file);
+
+    // Into the registered buffer, in one request per iovec
+    iovec iov[2] = {{registered.data(), 100}, {registered.data() + 200, 300}};
+    auto result = file.vector_read(iov, 2, 1000);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(400u, result.value());
+    EXPECT_EQ(0, memcmp(registered.data(), data_.data() + 1000, 100));
+    EXPECT_EQ(0, memcmp(registered.data() + 200, data_.data() + 1100, 300));
+}
+
+TEST_F(StorageFileTest, UringVectorWrite) {
+    {
+        UringFile file(path_, open(path_.c_str(), O_WRONLY | O_CLOEXEC));
+        std::string first(3000, 'a');
+        std::string second(5000, 'b');
+        iovec iov[2] = {{first.data(), first.size()},
+                        {second.data(), second.size()}};
+        auto result = file.vector_write(iov, 2, 100);
+        ASSERT_TRUE(result.has_value());
+        EXPECT_EQ(8000u, result.value());
+    }
+    std::fill(data_.begin() + 100, data_.begin() + 3100, 'a');
+    std::fill(data_.begin() + 3100, data_.begin() + 8100, 'b');
+    UringFile file(path_, open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    CheckBatchRead(file);
+}
+#endif
+
+}  // namespace mooncake::test
@@ -268,4 +268,75 @@ TEST_F(ClientTaskManagerTest, PruneExpiredTasksProcessingTimeoutFreesSlot) {
     EXPECT_EQ(second[0].status, TaskStatus::PROCESSING);
 }
 
+TEST_F(ClientTaskManagerTest, PopsHigherPriorityFirst) {
+    ClientTaskManager manager({10000, 10000, 10000, 0, 0, 3});
+    UUID client_id = generate_uuid();
+    auto submit = [&](const std::string& key, TaskPriority priority) {
+        return unwrap_expected_or_fail(
+            manager.get_write_access()
+                .submit_task_typed<TaskType::REPLICA_MOVE>(
+                    client_id,
+                    ReplicaMovePayload{
+                        .key = key, .source = "seg1", .target = "seg2"},
+                    priority));
+    };
+    UUID low = submit("low", TaskPriority::LOW);
+    UUID normal = submit("normal", TaskPriority::NORMAL);
+    UUID high1 = submit("high1", TaskPriority::HIGH);
+    UUID high2 = submit("high2", TaskPriority::HIGH);
+
+    auto tasks = manager.get_write_access().pop_tasks(client_id, 3);
+    ASSERT_EQ(tasks.size(), 3u);
+    EXPECT_EQ(tasks[0].id, high1);
+    EXPECT_EQ(tasks[1].id, high2);
+    EXPECT_EQ(tasks[2].id, normal);
+
+    tasks = manager.get_write_access().pop_tasks(client_id, 3);
+    ASSERT_EQ(tasks.size(), 1u);
+    EXPECT_EQ(tasks[0].id, low);
+    EXPECT_EQ(tasks[0].priority, TaskPriority::LOW);
+}
+
+TEST_F(ClientTaskManagerTest, ByteBudgetLimitsProcessingTasks) {
+    TaskManagerConfig config{10000, 10000, 10000, 0, 0, 3};
+    config.max_task_bytes_per_client = 100;
+    ClientTaskManager manager(config);
+    UUID client_id = generate_uuid();
+    auto submit = [&](const std::string& key, TaskPriority priority,
+                      uint64_t size) {
+        return unwrap_expected_or_fail(
+            manager.get_write_access()
+                .submit_task_typed<TaskType::REPLICA_COPY>(
+                    client_id,
+                    ReplicaCopyPayload{
+                        .key = key, .source = "seg1", .targets = {"seg2"}},
+                    priority, size));
+    };
+    UUID big = submit("big", TaskPriority::NORMAL, 150);
+    UUID high = submit("high", TaskPriority::HIGH, 60);
+    UUID small = submit("small", TaskPriority::LOW, 10);
+
+    // A task larger than the budget still runs when nothing else does
+    auto tasks = manager.get_write_access().pop_tasks(client_id, 10);
+    ASSERT_EQ(tasks.size(), 1u);
+    EXPECT_EQ(tasks[0].id, high);
+
+    // The small task fits, but must not overtake the big one
+    EXPECT_TRUE(manager.get_write_access().pop_tasks(client_id, 10).empty());
+
+    ASSERT_EQ(ErrorCode::OK,
+              manager.get_write_access().complete_task(
+                  client_id, high, TaskStatus::SUCCESS, ""));
+    tasks = manager.get_write_access().pop_tasks(client_id, 10);
+    ASSERT_EQ(tasks.size(), 1u);
+    EXPECT_EQ(tasks[0].id, big);
+
+    ASSERT_EQ(ErrorCode::OK,
+              manager.get_write_access().complete_task(
+                  client_id, big, TaskStatus::SUCCESS, ""));
+    tasks = manager.get_write_access().pop_tasks(client_id, 10);
+    ASSERT_EQ(tasks.size(), 1u);
+    EXPECT_EQ(tasks[0].id, small);
+}
+
 }  // namespace mooncake
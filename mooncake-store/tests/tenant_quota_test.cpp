@@ -0,0 +1,63 @@
+#include "tenant_quota.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+namespace mooncake::test {
+
+TEST(TenantQuotaTest, ParseLimits) {
+    auto limits = TenantQuotaManager::ParseLimits("a=1024:10,*=2048,");
+    ASSERT_TRUE(limits.has_value());
+    ASSERT_EQ(2u, limits->size());
+    EXPECT_EQ(1024u, limits->at("a").quota_bytes);
+    EXPECT_EQ(10u, limits->at("a").put_starts_per_sec);
+    EXPECT_EQ(2048u, limits->at("*").quota_bytes);
+    EXPECT_EQ(0u, limits->at("*").put_starts_per_sec);
+
+    EXPECT_TRUE(TenantQuotaManager::ParseLimits("")->empty());
+    EXPECT_FALSE(TenantQuotaManager::ParseLimits("a").has_value());
+    EXPECT_FALSE(TenantQuotaManager::ParseLimits("=1").has_value());
+    EXPECT_FALSE(TenantQuotaManager::ParseLimits("a=1k").has_value());
+    EXPECT_FALSE(TenantQuotaManager::ParseLimits("a=1:").has_value());
+    EXPECT_FALSE(TenantQuotaManager::ParseLimits("a=1,a=2").has_value());
+}
+
+TEST(TenantQuotaTest, ChargesUpToQuota) {
+    TenantQuotaManager manager({{"a", {.quota_bytes = 100}},
+                                {"*", {.quota_bytes = 10}}});
+    const auto now = std::chrono::steady_clock::now();
+    auto a = manager.GetUsage("a");
+    EXPECT_EQ(a, manager.GetUsage("a"));
+    EXPECT_EQ(ErrorCode::OK, a->TryCharge(60, now));
+    EXPECT_EQ(ErrorCode::TENANT_QUOTA_EXCEEDED, a->TryCharge(50, now));
+    EXPECT_EQ(60u, a->used_bytes());
+    a->Release(60);
+    EXPECT_EQ(ErrorCode::OK, a->TryCharge(100, now));
+
+    // Unlisted tenants get the default limit
+    auto b = manager.GetUsage("b");
+    EXPECT_EQ(10u, b->limit().quota_bytes);
+    EXPECT_EQ(ErrorCode::TENANT_QUOTA_EXCEEDED, b->TryCharge(11, now));
+}
+
+TEST(TenantQuotaTest, LimitsPutStartRate) {
+    TenantQuotaManager manager({{"a", {.put_starts_per_sec = 2}}});
+    auto a = manager.GetUsage("a");
+    const auto now = std::chrono::steady_clock::now();
+    EXPECT_EQ(ErrorCode::OK, a->TryCharge(1, now));
+    EXPECT_EQ(ErrorCode::OK, a->TryCharge(1, now));
+    EXPECT_EQ(ErrorCode::TENANT_RATE_LIMITED, a->TryCharge(1, now));
+    // Refilled at 2 per second
+    const auto later = now + std::chrono::milliseconds(500);
+    EXPECT_EQ(ErrorCode::OK, a->TryCharge(1, later));
+    EXPECT_EQ(ErrorCode::TENANT_RATE_LIMITED, a->TryCharge(1, later));
+
+    // Tenants without limits are never rejected
+    auto b = manager.GetUsage("b");
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(ErrorCode::OK, b->TryCharge(1ULL << 40, now));
+    }
+}
+
+}  // namespace mooncake::test
@@ -83,7 +83,8 @@ class InProcMaster {
             wms_cfg.enable_ha = false;
             wms_cfg.http_port = static_cast<uint16_t>(http_metrics_port_);
             wms_cfg.cluster_id = DEFAULT_CLUSTER_ID;
-            wms_cfg.root_fs_dir = DEFAULT_ROOT_FS_DIR;
+            wms_cfg.root_fs_dir =
+                config.root_fs_dir.value_or(DEFAULT_ROOT_FS_DIR);
             wms_cfg.memory_allocator = BufferAllocatorType::OFFSET;
 
             wms_cfg.enable_cxl = config.enable_cxl.has_value()
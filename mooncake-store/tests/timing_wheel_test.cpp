@@ -0,0 +1,80 @@
+#include "timing_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+using std::chrono::hours;
+using std::chrono::milliseconds;
+
+namespace {
+
+std::vector<std::string> Keys(const std::vector<TimingWheel::Entry>& entries) {
+    std::vector<std::string> keys;
+    for (const auto& entry : entries) {
+        keys.push_back(entry.key);
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+}  // namespace
+
+TEST(TimingWheelTest, ReportsDeadlinesOnce) {
+    const auto start = TimingWheel::Clock::now();
+    TimingWheel wheel(milliseconds(10), start);
+    wheel.Schedule("a", start + milliseconds(15));
+    wheel.Schedule("b", start + milliseconds(30));
+    wheel.Schedule("past", start - milliseconds(1));
+    EXPECT_EQ(3u, wheel.size());
+
+    EXPECT_EQ(std::vector<std::string>{"past"}, Keys(wheel.Advance(start)));
+    // Rounded up to the next tick
+    EXPECT_TRUE(wheel.Advance(start + milliseconds(15)).empty());
+    EXPECT_EQ(std::vector<std::string>{"a"},
+              Keys(wheel.Advance(start + milliseconds(20))));
+    EXPECT_EQ(std::vector<std::string>{"b"},
+              Keys(wheel.Advance(start + milliseconds(100))));
+    EXPECT_TRUE(wheel.Advance(start + milliseconds(200)).empty());
+    EXPECT_EQ(0u, wheel.size());
+}
+
+TEST(TimingWheelTest, MovesDeadlinesDownTheLevels) {
+    const auto start = TimingWheel::Clock::now();
+    TimingWheel wheel(milliseconds(1), start);
+    // One deadline per level, and one past the top level
+    const std::vector<milliseconds> delays = {
+        milliseconds(50), milliseconds(3000), milliseconds(200000),
+        milliseconds(10000000), milliseconds(20000000)};
+    for (size_t i = 0; i < delays.size(); ++i) {
+        wheel.Schedule(std::to_string(i), start + delays[i]);
+    }
+
+    for (size_t i = 0; i < delays.size(); ++i) {
+        auto now = start + delays[i] - milliseconds(1);
+        EXPECT_TRUE(wheel.Advance(now).empty()) << i;
+        auto expired = wheel.Advance(now + milliseconds(1));
+        ASSERT_EQ(1u, expired.size()) << i;
+        EXPECT_EQ(std::to_string(i), expired[0].key);
+        EXPECT_EQ(start + delays[i], expired[0].deadline);
+    }
+    EXPECT_EQ(0u, wheel.size());
+}
+
+TEST(TimingWheelTest, ScheduleAfterIdle) {
+    const auto start = TimingWheel::Clock::now();
+    TimingWheel wheel(milliseconds(10), start);
+    // An empty wheel catches up at once
+    EXPECT_TRUE(wheel.Advance(start + hours(1)).empty());
+    wheel.Schedule("a", start + hours(1) + milliseconds(500));
+    wheel.Schedule("b", start + hours(1) + milliseconds(500));
+    EXPECT_TRUE(wheel.Advance(start + hours(1) + milliseconds(490)).empty());
+    EXPECT_EQ((std::vector<std::string>{"a", "b"}),
+              Keys(wheel.Advance(start + hours(1) + milliseconds(500))));
+}
+
+}  // namespace mooncake::test
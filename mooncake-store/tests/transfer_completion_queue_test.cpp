@@ -0,0 +1,79 @@
+#include "transfer_completion_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+namespace mooncake::test {
+
+TEST(TransferCompletionQueueTest, CompletesWhenAllTransfersFinish) {
+    TransferCompletionQueue queue;
+    auto first = std::make_shared<MemcpyOperationState>();
+    auto second = std::make_shared<MemcpyOperationState>();
+    std::vector<TransferFuture> futures;
+    futures.emplace_back(first);
+    futures.emplace_back(second);
+
+    std::promise<ErrorCode> done;
+    queue.Add(std::move(futures),
+              [&done](ErrorCode result) { done.set_value(result); });
+    auto result = done.get_future();
+    EXPECT_EQ(1u, queue.pending());
+
+    first->set_completed(ErrorCode::OK);
+    EXPECT_EQ(std::future_status::timeout,
+              result.wait_for(std::chrono::milliseconds(10)));
+    second->set_completed(ErrorCode::TRANSFER_FAIL);
+    EXPECT_EQ(ErrorCode::TRANSFER_FAIL, result.get());
+    while (queue.pending() > 0) {
+        std::this_thread::yield();
+    }
+}
+
+TEST(TransferCompletionQueueTest, ManyOperationsInFlight) {
+    TransferCompletionQueue queue;
+    std::vector<std::shared_ptr<MemcpyOperationState>> states;
+    std::atomic<int> completed{0};
+    for (int i = 0; i < 500; i++) {
+        auto state = std::make_shared<MemcpyOperationState>();
+        std::vector<TransferFuture> futures;
+        futures.emplace_back(state);
+        queue.Add(std::move(futures), [&completed](ErrorCode result) {
+            EXPECT_EQ(ErrorCode::OK, result);
+            completed++;
+        });
+        states.push_back(std::move(state));
+    }
+    // Finished in any order
+    for (auto it = states.rbegin(); it != states.rend(); ++it) {
+        (*it)->set_completed(ErrorCode::OK);
+    }
+    while (queue.pending() > 0) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(500, completed);
+}
+
+TEST(TransferCompletionQueueTest, DestructorWaitsForPendingEntries) {
+    auto state = std::make_shared<MemcpyOperationState>();
+    bool called = false;
+    std::thread finisher;
+    {
+        TransferCompletionQueue queue;
+        std::vector<TransferFuture> futures;
+        futures.emplace_back(state);
+        queue.Add(std::move(futures),
+                  [&called](ErrorCode) { called = true; });
+        finisher = std::thread([state] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            state->set_completed(ErrorCode::OK);
+        });
+    }
+    EXPECT_TRUE(called);
+    finisher.join();
+}
+
+}  // namespace mooncake::test
@@ -144,6 +144,51 @@ TEST_F(TransferTaskTest, MemcpyWorkerPoolMultipleOperations) {
     }
 }
 
+// Test large operations split among the workers, mixed with small ones
+TEST_F(TransferTaskTest, MemcpyWorkerPoolSplitsLargeOperations) {
+    MemcpyWorkerPool pool(4);
+
+    const size_t large_size = MemcpyWorkerPool::kMinSplitChunkSize * 3 + 17;
+    std::vector<char> large_src(large_size);
+    std::vector<char> large_dest(large_size, 0);
+    for (size_t i = 0; i < large_size; ++i) {
+        large_src[i] = static_cast<char>(i * 31);
+    }
+    std::vector<char> small_src(100, 'S');
+    std::vector<char> small_dest(100, 0);
+
+    auto state = std::make_shared<MemcpyOperationState>();
+    std::vector<MemcpyOperation> operations;
+    operations.emplace_back(large_dest.data(), large_src.data(), large_size);
+    operations.emplace_back(small_dest.data(), small_src.data(),
+                            small_src.size());
+    pool.submitTask(MemcpyTask(std::move(operations), state));
+
+    state->wait_for_completion();
+    EXPECT_EQ(state->get_result(), ErrorCode::OK);
+    EXPECT_EQ(large_dest, large_src);
+    EXPECT_EQ(small_dest, small_src);
+}
+
+// Test copy engine selection and a pool using an explicit engine
+TEST_F(TransferTaskTest, CopyEngineSelection) {
+    EXPECT_STREQ("cpu", CopyEngine::Create("cpu")->name());
+    EXPECT_STREQ("cpu", CopyEngine::Create("")->name());
+    // Engines that are not built in fall back to the CPU
+    EXPECT_STREQ("cpu", CopyEngine::Create("dsa")->name());
+
+    MemcpyWorkerPool pool(1, std::make_unique<CpuCopyEngine>());
+    std::vector<char> src(64, 'C');
+    std::vector<char> dest(64, 0);
+    auto state = std::make_shared<MemcpyOperationState>();
+    std::vector<MemcpyOperation> operations;
+    operations.emplace_back(dest.data(), src.data(), src.size());
+    pool.submitTask(MemcpyTask(std::move(operations), state));
+    state->wait_for_completion();
+    EXPECT_EQ(state->get_result(), ErrorCode::OK);
+    EXPECT_EQ(dest, src);
+}
+
 // Test TransferStrategy enum and stream operator
 TEST_F(TransferTaskTest, TransferStrategyEnum) {
     // Test enum values
@@ -160,6 +205,57 @@ TEST_F(TransferTaskTest, TransferStrategyEnum) {
     EXPECT_EQ(oss.str(), "TRANSFER_ENGINE");
 }
 
+// Test that futures shared between objects see the same result
+TEST_F(TransferTaskTest, SharedFutureSeesResult) {
+    auto state = std::make_shared<MemcpyOperationState>();
+    TransferFuture future(state);
+    TransferFuture shared = future.share();
+    EXPECT_FALSE(shared.isReady());
+
+    state->set_completed(ErrorCode::TRANSFER_FAIL);
+    EXPECT_EQ(future.get(), ErrorCode::TRANSFER_FAIL);
+    EXPECT_EQ(shared.get(), ErrorCode::TRANSFER_FAIL);
+}
+
+// Test merging requests contiguous in both local and remote memory
+TEST_F(TransferTaskTest, CoalesceTransferRequests) {
+    std::vector<char> local(64 * 1024);
+    auto make = [&](size_t local_offset, uint64_t target_offset,
+                    size_t length, SegmentHandle target_id = 1) {
+        TransferRequest request;
+        request.opcode = TransferRequest::WRITE;
+        request.source = local.data() + local_offset;
+        request.target_id = target_id;
+        request.target_offset = target_offset;
+        request.length = length;
+        return request;
+    };
+
+    // Three objects adjacent on both sides, submitted out of order
+    std::vector<TransferRequest> requests = {
+        make(16384, 0x10000 + 16384, 16384),
+        make(0, 0x10000, 16384),
+        make(32768, 0x10000 + 32768, 16384),
+    };
+    CoalesceTransferRequests(requests);
+    ASSERT_EQ(requests.size(), 1u);
+    EXPECT_EQ(requests[0].source, local.data());
+    EXPECT_EQ(requests[0].target_offset, 0x10000u);
+    EXPECT_EQ(requests[0].length, 3u * 16384);
+
+    // Adjacent remotely only, in another segment, or another opcode
+    requests = {
+        make(0, 0x10000, 16384),
+        make(32768, 0x10000 + 16384, 16384),
+        make(16384, 0x10000 + 32768, 16384, 2),
+    };
+    auto read = make(16384, 0x10000 + 32768, 16384);
+    read.opcode = TransferRequest::READ;
+    requests.push_back(read);
+    CoalesceTransferRequests(requests);
+    EXPECT_EQ(requests.size(), 4u);
+}
+
 }  // namespace mooncake
 
 int main(int argc, char** argv) {
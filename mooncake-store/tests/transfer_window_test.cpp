@@ -0,0 +1,105 @@
+#include "transfer_window.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace mooncake::test {
+
+namespace {
+
+constexpr uint64_t kMiB = 1ull << 20;
+
+TransferWindows::Config TestConfig() {
+    TransferWindows::Config config;
+    config.initial_bytes = 4 * kMiB;
+    config.min_bytes = 1 * kMiB;
+    config.max_bytes = 8 * kMiB;
+    config.increase_bytes = 1 * kMiB;
+    config.decrease_factor = 0.5;
+    config.target_delay_us = 500;
+    config.link_gbps = 100;
+    return config;
+}
+
+}  // namespace
+
+TEST(TransferWindowsTest, GrowsWhileTransfersAreFast) {
+    TransferWindows windows(TestConfig());
+    // About one window of bytes completed in time adds increase_bytes
+    for (int i = 0; i < 4; ++i) {
+        windows.Acquire(1, kMiB)->Finish(true, 10);
+    }
+    EXPECT_GT(windows.WindowBytes(1), 4 * kMiB + kMiB * 9 / 10);
+    EXPECT_LE(windows.WindowBytes(1), 5 * kMiB);
+    for (int i = 0; i < 100; ++i) {
+        windows.Acquire(1, kMiB)->Finish(true, 10);
+    }
+    EXPECT_EQ(windows.WindowBytes(1), 8 * kMiB);
+    EXPECT_EQ(windows.InflightBytes(1), 0u);
+    // Other segments have windows of their own
+    EXPECT_EQ(windows.WindowBytes(2), 4 * kMiB);
+}
+
+TEST(TransferWindowsTest, ShrinksOncePerLatencyWhenCongested) {
+    TransferWindows windows(TestConfig());
+    auto first = windows.Acquire(1, kMiB);
+    auto second = windows.Acquire(1, kMiB);
+    // 1 MiB takes about 84 us on the wire at 100 Gbps, so 10 ms is queueing
+    first->Finish(true, 10000);
+    EXPECT_EQ(windows.WindowBytes(1), 2 * kMiB);
+    // Reports the same congestion within the latency
+    second->Finish(true, 10000);
+    EXPECT_EQ(windows.WindowBytes(1), 2 * kMiB);
+    // Failures count as congestion, down to min_bytes
+    auto third = windows.Acquire(1, kMiB);
+    third->Finish(false, 0);
+    EXPECT_EQ(windows.WindowBytes(1), 1 * kMiB);
+    windows.Acquire(1, kMiB)->Finish(false, 0);
+    EXPECT_EQ(windows.WindowBytes(1), 1 * kMiB);
+}
+
+TEST(TransferWindowsTest, LargeTransferGoesOutWhenIdle) {
+    TransferWindows windows(TestConfig());
+    auto lease = windows.Acquire(1, 64 * kMiB);
+    EXPECT_EQ(windows.InflightBytes(1), 64 * kMiB);
+    // Destroyed without Finish, the window is left as is
+    lease.reset();
+    EXPECT_EQ(windows.InflightBytes(1), 0u);
+    EXPECT_EQ(windows.WindowBytes(1), 4 * kMiB);
+}
+
+TEST(TransferWindowsTest, AcquireWaitsForRoom) {
+    TransferWindows windows(TestConfig());
+    auto held = windows.Acquire(1, 3 * kMiB);
+    std::atomic<bool> acquired{false};
+    std::thread waiter([&] {
+        auto lease = windows.Acquire(1, 2 * kMiB);
+        acquired = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(acquired);
+    held->Finish(true, 10);
+    waiter.join();
+    EXPECT_TRUE(acquired);
+}
+
+TEST(TransferWindowsTest, WaitingPollsTransfersInFlight) {
+    TransferWindows windows(TestConfig());
+    auto held = windows.Acquire(1, 3 * kMiB);
+    // The completion is only noticed when polled, here by the same thread
+    // waiting for room
+    std::atomic<int> polls{0};
+    held->SetPoller([&] {
+        if (++polls == 3) {
+            held->Finish(true, 10);
+        }
+    });
+    auto lease = windows.Acquire(1, 2 * kMiB);
+    EXPECT_EQ(polls, 3);
+    EXPECT_EQ(windows.InflightBytes(1), 2 * kMiB);
+}
+
+}  // namespace mooncake::test
@@ -0,0 +1,87 @@
+#include "warm_restart.h"
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace mooncake::test {
+
+namespace {
+
+constexpr size_t kSegmentSize = 1 << 20;
+constexpr const char* kHostname = "localhost:17813";
+
+std::string StateDir() { return ::testing::TempDir() + "warm_restart_test"; }
+
+void Unmap(const WarmRestartState::Mapping& mapping) {
+    munmap(mapping.base, mapping.size);
+    close(mapping.fd);
+}
+
+}  // namespace
+
+TEST(WarmRestartStateTest, RestoresSegments) {
+    UUID client_id;
+    std::vector<WarmRestartState::Mapping> created;
+    {
+        WarmRestartState state(StateDir(), kHostname, 2 * kSegmentSize);
+        EXPECT_TRUE(state.Restore().empty());
+        EXPECT_FALSE(state.restored());
+        for (int numa_node : {0, 1}) {
+            auto mapping = state.CreateSegment(kSegmentSize, numa_node);
+            ASSERT_TRUE(mapping.has_value());
+            memset(mapping->base, 'a' + numa_node, kSegmentSize);
+            created.push_back(*mapping);
+        }
+        ASSERT_TRUE(state.Save());
+        client_id = state.client_id();
+        for (const auto& mapping : created) {
+            Unmap(mapping);
+        }
+    }
+
+    // The restarted process gets the data back at the same addresses
+    WarmRestartState state(StateDir(), kHostname, 2 * kSegmentSize);
+    auto restored = state.Restore();
+    ASSERT_EQ(2u, restored.size());
+    EXPECT_TRUE(state.restored());
+    EXPECT_EQ(client_id, state.client_id());
+    for (size_t i = 0; i < restored.size(); ++i) {
+        EXPECT_EQ(created[i].base, restored[i].base);
+        EXPECT_EQ(created[i].segment_id, restored[i].segment_id);
+        EXPECT_EQ(created[i].numa_node, restored[i].numa_node);
+        EXPECT_EQ('a' + static_cast<int>(i),
+                  static_cast<char*>(restored[i].base)[kSegmentSize - 1]);
+        Unmap(restored[i]);
+    }
+    state.Destroy();
+}
+
+TEST(WarmRestartStateTest, DropsMismatchingState) {
+    UUID client_id;
+    {
+        WarmRestartState state(StateDir(), kHostname, kSegmentSize);
+        state.Restore();
+        auto mapping = state.CreateSegment(kSegmentSize, -1);
+        ASSERT_TRUE(mapping.has_value());
+        ASSERT_TRUE(state.Save());
+        client_id = state.client_id();
+        Unmap(*mapping);
+    }
+
+    // Another segment size starts over under a new client id
+    WarmRestartState resized(StateDir(), kHostname, 2 * kSegmentSize);
+    EXPECT_TRUE(resized.Restore().empty());
+    EXPECT_NE(client_id, resized.client_id());
+
+    // The dropped state is gone
+    WarmRestartState state(StateDir(), kHostname, kSegmentSize);
+    EXPECT_TRUE(state.Restore().empty());
+    EXPECT_FALSE(state.restored());
+}
+
+}  // namespace mooncake::test
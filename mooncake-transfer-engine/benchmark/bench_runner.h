@@ -52,12 +52,16 @@ class BenchRunner {
     virtual uint64_t getLocalBufferBase(int thread_id, uint64_t block_size,
                                         uint64_t batch_size) const = 0;
 
-    virtual uint64_t getTargetBufferBase(int thread_id, uint64_t block_size,
+    // Number of segments in --target_seg_name, opened by startInitiator()
+    virtual int getNumTargets() const = 0;
+
+    virtual uint64_t getTargetBufferBase(int target_index, int thread_id,
+                                         uint64_t block_size,
                                          uint64_t batch_size) const = 0;
 
-    virtual double runSingleTransfer(uint64_t local_addr, uint64_t target_addr,
-                                     uint64_t block_size, uint64_t batch_size,
-                                     OpCode opcode) = 0;
+    virtual double runSingleTransfer(int target_index, uint64_t local_addr,
+                                     uint64_t target_addr, uint64_t block_size,
+                                     uint64_t batch_size, OpCode opcode) = 0;
 };
 
 }  // namespace tent
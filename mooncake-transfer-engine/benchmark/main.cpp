@@ -14,14 +14,16 @@
 
 #include "utils.h"
 
+#include <thread>
+
 #include "bench_runner.h"
 #include "te_backend.h"
 #include "tent_backend.h"
 
 using namespace mooncake::tent;
 
-void processBatchSizes(BenchRunner& runner, size_t block_size,
-                       size_t batch_size, int num_threads) {
+XferBenchResult processBatchSizes(BenchRunner& runner, size_t block_size,
+                                  size_t batch_size, int num_threads) {
     bool mixed_opcode = false;
     OpCode opcode = READ;
     if (XferBenchConfig::check_consistency || XferBenchConfig::op_type == "mix")
@@ -41,17 +43,21 @@ void processBatchSizes(BenchRunner& runner, size_t block_size,
         runner.pinThread(thread_id);
         auto max_block_size = XferBenchConfig::max_block_size;
         auto max_batch_size = XferBenchConfig::max_batch_size;
+        // Threads take the targets in turn, and the buffers of a target
+        // in turn among the threads sharing it
+        const int num_targets = runner.getNumTargets();
+        const int target = thread_id % num_targets;
         uint64_t local_addr =
             runner.getLocalBufferBase(XferBenchConfig::local_gpu_id + thread_id,
                                       max_block_size, max_batch_size);
         uint64_t target_addr = runner.getTargetBufferBase(
-            XferBenchConfig::target_gpu_id + thread_id, max_block_size,
-            max_batch_size);
+            target, XferBenchConfig::target_gpu_id + thread_id / num_targets,
+            max_block_size, max_batch_size);
 
         XferBenchTimer timer;
         while (timer.lap_us(false) < 1000000ull) {
-            runner.runSingleTransfer(local_addr, target_addr, block_size,
-                                     batch_size, opcode);
+            runner.runSingleTransfer(target, local_addr, target_addr,
+                                     block_size, batch_size, opcode);
         }
         timer.reset();
         std::vector<double> transfer_duration;
@@ -62,11 +68,12 @@ void processBatchSizes(BenchRunner& runner, size_t block_size,
                 if (XferBenchConfig::check_consistency)
                     pattern =
                         fillData((void*)local_addr, block_size * batch_size);
-                auto val = runner.runSingleTransfer(
-                    local_addr, target_addr, block_size, batch_size, WRITE);
+                auto val =
+                    runner.runSingleTransfer(target, local_addr, target_addr,
+                                             block_size, batch_size, WRITE);
                 transfer_duration.push_back(val);
                 fillData((void*)local_addr, block_size * batch_size);
-                val = runner.runSingleTransfer(local_addr, target_addr,
+                val = runner.runSingleTransfer(target, local_addr, target_addr,
                                                block_size, batch_size, READ);
                 if (XferBenchConfig::check_consistency)
                     verifyData((void*)local_addr, block_size * batch_size,
@@ -76,8 +83,9 @@ void processBatchSizes(BenchRunner& runner, size_t block_size,
         } else {
             while (timer.lap_us(false) <
                    XferBenchConfig::duration * 1000000ull) {
-                auto val = runner.runSingleTransfer(
-                    local_addr, target_addr, block_size, batch_size, opcode);
+                auto val =
+                    runner.runSingleTransfer(target, local_addr, target_addr,
+                                             block_size, batch_size, opcode);
                 transfer_duration.push_back(val);
             }
         }
@@ -89,33 +97,23 @@ void processBatchSizes(BenchRunner& runner, size_t block_size,
         return 0;
     });
 
-    printStats(block_size, batch_size, stats, num_threads);
+    auto result = printStats(block_size, batch_size, stats, num_threads);
+    result.num_targets = runner.getNumTargets();
+    return result;
 }
 
-int main(int argc, char* argv[]) {
-    gflags::SetUsageMessage(
-        "Mooncake Transfer Engine Benchmarking Tool\n"
-        "Usage: ./tebench [options]");
-    gflags::ParseCommandLineFlags(&argc, &argv, true);
-    XferBenchConfig::loadFromFlags();
-    std::unique_ptr<BenchRunner> runner;
+static std::unique_ptr<BenchRunner> createRunner(
+    const std::vector<std::string>& nic_list) {
     if (XferBenchConfig::backend == "classic")
-        runner = std::make_unique<TEBenchRunner>();
-    else
-        runner = std::make_unique<TENTBenchRunner>();
-    if (XferBenchConfig::target_seg_name.empty()) {
-        std::cout << "\033[33mTo start initiators, run " << std::endl
-                  << "  ./tebench --target_seg_name="
-                  << runner->getSegmentName()
-                  << " --seg_type=" << XferBenchConfig::seg_type
-                  << " --backend=" << XferBenchConfig::backend << std::endl
-                  << "Press Ctrl-C to terminate\033[0m" << std::endl;
-        return runner->runTarget();
-    }
-    printStatsHeader();
+        return std::make_unique<TEBenchRunner>(nic_list);
+    return std::make_unique<TENTBenchRunner>(nic_list);
+}
+
+static void runSweep(BenchRunner& runner, int num_nics,
+                     std::vector<XferBenchResult>& results) {
     for (int num_threads = XferBenchConfig::start_num_threads;
          num_threads <= XferBenchConfig::max_num_threads; num_threads *= 2) {
-        runner->startInitiator(num_threads);
+        runner.startInitiator(num_threads);
         for (size_t block_size = XferBenchConfig::start_block_size;
              block_size <= XferBenchConfig::max_block_size; block_size *= 2) {
             for (size_t batch_size = XferBenchConfig::start_batch_size;
@@ -126,12 +124,65 @@ int main(int argc, char* argv[]) {
                     LOG(INFO) << "Skipped for block_size " << block_size
                               << " batch_size " << batch_size;
                 } else {
-                    processBatchSizes(*runner, block_size, batch_size,
-                                      num_threads);
+                    results.push_back(processBatchSizes(
+                        runner, block_size, batch_size, num_threads));
+                    results.back().num_nics = num_nics;
                 }
             }
         }
-        runner->stopInitiator();
+        runner.stopInitiator();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    gflags::SetUsageMessage(
+        "Mooncake Transfer Engine Benchmarking Tool\n"
+        "Usage: ./tebench [options]");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    XferBenchConfig::loadFromFlags();
+    if (XferBenchConfig::start_block_size == 0) {
+        LOG(ERROR) << "Invalid args: start_block_size must be positive";
+        exit(EXIT_FAILURE);
+    }
+    const auto& nic_list = XferBenchConfig::nic_list;
+    if (XferBenchConfig::target_seg_name.empty()) {
+        auto runner = createRunner(nic_list);
+        std::cout << "\033[33mTo start initiators, run " << std::endl
+                  << "  ./tebench --target_seg_name="
+                  << runner->getSegmentName()
+                  << " --seg_type=" << XferBenchConfig::seg_type
+                  << " --backend=" << XferBenchConfig::backend << std::endl
+                  << "Press Ctrl-C to terminate\033[0m" << std::endl;
+        return runner->runTarget();
+    }
+    if (XferBenchConfig::nic_sweep && nic_list.empty()) {
+        LOG(ERROR) << "Invalid args: nic_sweep requires nic_list";
+        exit(EXIT_FAILURE);
+    }
+    if (XferBenchConfig::start_time > 0) {
+        std::this_thread::sleep_until(
+            std::chrono::system_clock::time_point(
+                std::chrono::seconds(XferBenchConfig::start_time)));
+    }
+    std::vector<XferBenchResult> results;
+    if (XferBenchConfig::nic_sweep) {
+        // One engine per NIC count, the NICs are picked at installation
+        size_t num_nics = 1;
+        while (true) {
+            std::cout << "NICs: " << num_nics << std::endl;
+            std::vector<std::string> nics(nic_list.begin(),
+                                          nic_list.begin() + num_nics);
+            printStatsHeader();
+            runSweep(*createRunner(nics), num_nics, results);
+            if (num_nics == nic_list.size()) break;
+            num_nics = std::min(num_nics * 2, nic_list.size());
+        }
+    } else {
+        auto runner = createRunner(nic_list);
+        printStatsHeader();
+        runSweep(*runner, nic_list.size(), results);
     }
+    if (!XferBenchConfig::json_output.empty())
+        writeJsonResults(XferBenchConfig::json_output, results);
     return 0;
 }
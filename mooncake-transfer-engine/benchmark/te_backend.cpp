@@ -155,10 +155,10 @@ int TEBenchRunner::freeBuffers() {
     return 0;
 }
 
-TEBenchRunner::TEBenchRunner() {
+TEBenchRunner::TEBenchRunner(const std::vector<std::string>& nic_list) {
     signal(SIGINT, signalHandlerV0);
     signal(SIGTERM, signalHandlerV0);
-    engine_ = std::make_unique<mooncake::TransferEngine>(true);
+    engine_ = std::make_unique<mooncake::TransferEngine>(true, nic_list);
     auto conn_str = XferBenchConfig::metadata_type == "p2p"
                         ? "P2PHANDSHAKE"
                         : XferBenchConfig::metadata_url_list;
@@ -177,12 +177,23 @@ int TEBenchRunner::runTarget() {
 }
 
 int TEBenchRunner::startInitiator(int num_threads) {
-    handle_ = engine_->openSegment(XferBenchConfig::target_seg_name);
-    info_ = engine_->getMetadata()->getSegmentDescByID(handle_);
-    std::sort(
-        info_->buffers.begin(), info_->buffers.end(),
-        [](const TransferMetadata::BufferDesc& a,
-           const TransferMetadata::BufferDesc& b) { return a.name < b.name; });
+    handles_.clear();
+    infos_.clear();
+    for (auto& name : splitList(XferBenchConfig::target_seg_name)) {
+        auto handle = engine_->openSegment(name);
+        auto info = engine_->getMetadata()->getSegmentDescByID(handle);
+        if (!info) {
+            LOG(ERROR) << "Cannot open target segment " << name;
+            exit(EXIT_FAILURE);
+        }
+        std::sort(info->buffers.begin(), info->buffers.end(),
+                  [](const TransferMetadata::BufferDesc& a,
+                     const TransferMetadata::BufferDesc& b) {
+                      return a.name < b.name;
+                  });
+        handles_.push_back(handle);
+        infos_.push_back(info);
+    }
     threads_.resize(num_threads);
     g_te_running = true;
     current_task_.resize(threads_.size());
@@ -256,7 +267,7 @@ int TEBenchRunner::runInitiatorTasks(
     return 0;
 }
 
-double TEBenchRunner::runSingleTransfer(uint64_t local_addr,
+double TEBenchRunner::runSingleTransfer(int target_index, uint64_t local_addr,
                                         uint64_t target_addr,
                                         uint64_t block_size,
                                         uint64_t batch_size, OpCode opcode) {
@@ -268,7 +279,7 @@ double TEBenchRunner::runSingleTransfer(uint64_t local_addr,
             opcode == READ ? TransferRequest::READ : TransferRequest::WRITE;
         entry.length = block_size;
         entry.source = (void*)(local_addr + block_size * i);
-        entry.target_id = handle_;
+        entry.target_id = handles_[target_index];
         entry.target_offset = target_addr + block_size * i;
         requests.emplace_back(entry);
     }
@@ -36,7 +36,8 @@ namespace mooncake {
 namespace tent {
 class TEBenchRunner : public BenchRunner {
    public:
-    TEBenchRunner();
+    // Uses only the RDMA NICs of nic_list if not empty
+    explicit TEBenchRunner(const std::vector<std::string>& nic_list = {});
     ~TEBenchRunner();
 
     TEBenchRunner(const TEBenchRunner&) = delete;
@@ -61,15 +62,19 @@ class TEBenchRunner : public BenchRunner {
                block_size * batch_size * (thread_id / num_buffers);
     }
 
-    uint64_t getTargetBufferBase(int thread_id, uint64_t block_size,
+    int getNumTargets() const { return (int)handles_.size(); }
+
+    uint64_t getTargetBufferBase(int target_index, int thread_id,
+                                 uint64_t block_size,
                                  uint64_t batch_size) const {
-        return info_->buffers[thread_id % info_->buffers.size()].addr +
-               block_size * batch_size * (thread_id / info_->buffers.size());
+        const auto& buffers = infos_[target_index]->buffers;
+        return buffers[thread_id % buffers.size()].addr +
+               block_size * batch_size * (thread_id / buffers.size());
     }
 
-    double runSingleTransfer(uint64_t local_addr, uint64_t target_addr,
-                             uint64_t block_size, uint64_t batch_size,
-                             OpCode opcode);
+    double runSingleTransfer(int target_index, uint64_t local_addr,
+                             uint64_t target_addr, uint64_t block_size,
+                             uint64_t batch_size, OpCode opcode);
 
    private:
     int allocateBuffers();
@@ -81,8 +86,8 @@ class TEBenchRunner : public BenchRunner {
    private:
     std::unique_ptr<mooncake::TransferEngine> engine_;
     std::vector<void*> pinned_buffer_list_;
-    SegmentID handle_;
-    std::shared_ptr<TransferMetadata::SegmentDesc> info_;
+    std::vector<SegmentID> handles_;
+    std::vector<std::shared_ptr<TransferMetadata::SegmentDesc>> infos_;
 
     std::vector<std::function<int(int)>> current_task_;
     std::vector<std::thread> threads_;
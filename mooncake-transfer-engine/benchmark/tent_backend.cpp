@@ -39,8 +39,9 @@ void signalHandlerV1(int signum) {
     g_tent_triggered_sig = true;
 }
 
-std::shared_ptr<Config> loadConfig() {
+std::shared_ptr<Config> loadConfig(const std::vector<std::string>& nic_list) {
     auto config = std::make_shared<Config>();
+    if (!nic_list.empty()) config->set("topology/rdma_whitelist", nic_list);
     config->set("local_segment_name", XferBenchConfig::seg_name);
     config->set("metadata_type", XferBenchConfig::metadata_type);
     config->set("metadata_servers", XferBenchConfig::metadata_url_list);
@@ -145,10 +146,10 @@ int TENTBenchRunner::freeBuffers() {
     return 0;
 }
 
-TENTBenchRunner::TENTBenchRunner() {
+TENTBenchRunner::TENTBenchRunner(const std::vector<std::string>& nic_list) {
     signal(SIGINT, signalHandlerV1);
     signal(SIGTERM, signalHandlerV1);
-    engine_ = std::make_unique<TransferEngine>(loadConfig());
+    engine_ = std::make_unique<TransferEngine>(loadConfig(nic_list));
     allocateBuffers();
 }
 
@@ -160,13 +161,21 @@ int TENTBenchRunner::runTarget() {
 }
 
 int TENTBenchRunner::startInitiator(int num_threads) {
-    CHECK_FAIL(engine_->openSegment(handle_, XferBenchConfig::target_seg_name));
-    info_.buffers.clear();
-    CHECK_FAIL(engine_->getSegmentInfo(handle_, info_));
-    std::sort(info_.buffers.begin(), info_.buffers.end(),
-              [](const SegmentInfo::Buffer& a, const SegmentInfo::Buffer& b) {
-                  return a.location < b.location;
-              });
+    handles_.clear();
+    infos_.clear();
+    for (auto& name : splitList(XferBenchConfig::target_seg_name)) {
+        SegmentID handle;
+        SegmentInfo info;
+        CHECK_FAIL(engine_->openSegment(handle, name));
+        CHECK_FAIL(engine_->getSegmentInfo(handle, info));
+        std::sort(
+            info.buffers.begin(), info.buffers.end(),
+            [](const SegmentInfo::Buffer& a, const SegmentInfo::Buffer& b) {
+                return a.location < b.location;
+            });
+        handles_.push_back(handle);
+        infos_.push_back(std::move(info));
+    }
     threads_.resize(num_threads);
     current_task_.resize(threads_.size());
     g_tent_running = true;
@@ -258,7 +267,8 @@ int TENTBenchRunner::runInitiatorTasks(
     return 0;
 }
 
-double TENTBenchRunner::runSingleTransfer(uint64_t local_addr,
+double TENTBenchRunner::runSingleTransfer(int target_index,
+                                          uint64_t local_addr,
                                           uint64_t target_addr,
                                           uint64_t block_size,
                                           uint64_t batch_size, OpCode opcode) {
@@ -269,7 +279,7 @@ double TENTBenchRunner::runSingleTransfer(uint64_t local_addr,
         entry.opcode = opcode == READ ? Request::READ : Request::WRITE;
         entry.length = block_size;
         entry.source = (void*)(local_addr + block_size * i);
-        entry.target_id = handle_;
+        entry.target_id = handles_[target_index];
         entry.target_offset = target_addr + block_size * i;
         requests.emplace_back(entry);
     }
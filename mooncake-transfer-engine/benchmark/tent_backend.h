@@ -39,7 +39,8 @@ namespace mooncake {
 namespace tent {
 class TENTBenchRunner : public BenchRunner {
    public:
-    TENTBenchRunner();
+    // Uses only the RDMA NICs of nic_list if not empty
+    explicit TENTBenchRunner(const std::vector<std::string>& nic_list = {});
     ~TENTBenchRunner();
 
     TENTBenchRunner(const TENTBenchRunner&) = delete;
@@ -64,15 +65,19 @@ class TENTBenchRunner : public BenchRunner {
                block_size * batch_size * (thread_id / num_buffers);
     }
 
-    uint64_t getTargetBufferBase(int thread_id, uint64_t block_size,
+    int getNumTargets() const { return (int)handles_.size(); }
+
+    uint64_t getTargetBufferBase(int target_index, int thread_id,
+                                 uint64_t block_size,
                                  uint64_t batch_size) const {
-        return info_.buffers[thread_id % info_.buffers.size()].base +
-               block_size * batch_size * (thread_id / info_.buffers.size());
+        const auto& buffers = infos_[target_index].buffers;
+        return buffers[thread_id % buffers.size()].base +
+               block_size * batch_size * (thread_id / buffers.size());
     }
 
-    double runSingleTransfer(uint64_t local_addr, uint64_t target_addr,
-                             uint64_t block_size, uint64_t batch_size,
-                             OpCode opcode);
+    double runSingleTransfer(int target_index, uint64_t local_addr,
+                             uint64_t target_addr, uint64_t block_size,
+                             uint64_t batch_size, OpCode opcode);
 
    private:
     int allocateBuffers();
@@ -84,8 +89,8 @@ class TENTBenchRunner : public BenchRunner {
    private:
     std::unique_ptr<TransferEngine> engine_;
     std::vector<void*> pinned_buffer_list_;
-    SegmentID handle_;
-    SegmentInfo info_;
+    std::vector<SegmentID> handles_;
+    std::vector<SegmentInfo> infos_;
 
     std::vector<std::function<int(int)>> current_task_;
     std::vector<std::thread> threads_;
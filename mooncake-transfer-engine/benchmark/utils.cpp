@@ -15,12 +15,15 @@
 #include "utils.h"
 
 #include <gflags/gflags.h>
+#include <fstream>
 #include <iostream>
 
 DEFINE_string(seg_name, "", "Memory segment name for the local side");
 DEFINE_string(seg_type, "DRAM",
               "Memory segment type for the target side: DRAM|VRAM");
-DEFINE_string(target_seg_name, "", "Memory segment name for the target side");
+DEFINE_string(target_seg_name, "",
+              "Memory segment names for the target side, comma-separated. "
+              "Threads are spread over the targets (1-to-N incast)");
 DEFINE_string(op_type, "read", "Operation type to benchmark: read|write|mix");
 DEFINE_bool(check_consistency, false,
             "Enable data consistency check after transfer.");
@@ -45,6 +48,18 @@ DEFINE_string(xport_type, "", "Transport type: rdma|shm|mnnvl|gds|iouring");
 DEFINE_string(backend, "tent", "Transport backend: classic|tent");
 DEFINE_bool(notifi, false,
             "Enable RDMA notification for performance measurement.");
+DEFINE_string(json_output, "",
+              "Append the results as JSON to this file, for regression "
+              "tracking.");
+DEFINE_string(nic_list, "",
+              "RDMA NICs to use, comma-separated. Empty for all NICs.");
+DEFINE_bool(nic_sweep, false,
+            "Repeat the sweep with the first 1, 2, 4, ... NICs of "
+            "--nic_list, for per-NIC scaling curves.");
+DEFINE_int64(start_time, 0,
+             "Unix time (in seconds) to start the sweep at, so that "
+             "initiators on several hosts run the same cases together "
+             "(N-to-1 incast). 0 to start at once.");
 
 namespace mooncake {
 namespace tent {
@@ -72,6 +87,11 @@ bool XferBenchConfig::notifi = false;
 int XferBenchConfig::local_gpu_id = 0;
 int XferBenchConfig::target_gpu_id = 0;
 
+std::string XferBenchConfig::json_output;
+std::vector<std::string> XferBenchConfig::nic_list;
+bool XferBenchConfig::nic_sweep = false;
+int64_t XferBenchConfig::start_time = 0;
+
 void XferBenchConfig::loadFromFlags() {
     seg_type = FLAGS_seg_type;
     seg_name = FLAGS_seg_name;
@@ -97,6 +117,21 @@ void XferBenchConfig::loadFromFlags() {
 
     local_gpu_id = FLAGS_local_gpu_id;
     target_gpu_id = FLAGS_target_gpu_id;
+
+    json_output = FLAGS_json_output;
+    nic_list = splitList(FLAGS_nic_list);
+    nic_sweep = FLAGS_nic_sweep;
+    start_time = FLAGS_start_time;
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
 }
 
 double XferMetricStats::percentile(double p) {
@@ -121,8 +156,10 @@ void printStatsHeader() {
               << std::setw(14) << "BlkSize (B)"
               << std::setw(8) << "Batch"
               << std::setw(14) << "BW (GB/S)"
+              << std::setw(14) << "Rate (Kop/s)"
               << std::setw(14) << "Avg Lat (us)"
               << std::setw(14) << "Avg Tx (us)"
+              << std::setw(14) << "P50 Tx (us)"
               << std::setw(14) << "P99 Tx (us)"
               << std::setw(14) << "P999 Tx (us)"
               << std::endl;
@@ -130,30 +167,81 @@ void printStatsHeader() {
     // clang-format on
 }
 
-void printStats(size_t block_size, size_t batch_size, XferBenchStats& stats,
-                int num_threads) {
-    size_t total_data_transferred = 0;
-    double avg_latency = 0, throughput_gb = 0;
+XferBenchResult printStats(size_t block_size, size_t batch_size,
+                           XferBenchStats& stats, int num_threads) {
+    XferBenchResult result;
+    result.block_size = block_size;
+    result.batch_size = batch_size;
+    result.num_threads = num_threads;
     auto num_ops = stats.transfer_duration.count();
     double total_duration = stats.total_duration.avg();
-    total_data_transferred = ((block_size * batch_size) * num_ops);
-    avg_latency = (total_duration * num_threads / num_ops);
-    throughput_gb = (((double)total_data_transferred / (1000 * 1000 * 1000)) /
-                     (total_duration / 1e6));  // In GB/Sec
+    size_t total_data_transferred = ((block_size * batch_size) * num_ops);
+    result.avg_latency = (total_duration * num_threads / num_ops);
+    result.throughput_gb =
+        (((double)total_data_transferred / (1000 * 1000 * 1000)) /
+         (total_duration / 1e6));  // In GB/Sec
+    result.msg_rate = (double)(batch_size * num_ops) / (total_duration / 1e6);
+    result.avg_tx = stats.transfer_duration.avg();
+    result.p50_tx = stats.transfer_duration.p50();
+    result.p90_tx = stats.transfer_duration.p90();
+    result.p99_tx = stats.transfer_duration.p99();
+    result.p999_tx = stats.transfer_duration.p999();
+    result.max_tx = stats.transfer_duration.max();
 
     // Tabulate print with fixed width for each string
     // clang-format off
     std::cout << std::left << std::fixed << std::setprecision(6)
               << std::setw(14) << block_size
               << std::setw(8)  << batch_size
-              << std::setw(14) << throughput_gb
+              << std::setw(14) << result.throughput_gb
               << std::setprecision(1)
-              << std::setw(14) << avg_latency
-              << std::setw(14) << stats.transfer_duration.avg()
-              << std::setw(14) << stats.transfer_duration.p99()
-              << std::setw(14) << stats.transfer_duration.p999()
+              << std::setw(14) << result.msg_rate / 1000
+              << std::setw(14) << result.avg_latency
+              << std::setw(14) << result.avg_tx
+              << std::setw(14) << result.p50_tx
+              << std::setw(14) << result.p99_tx
+              << std::setw(14) << result.p999_tx
               << std::endl;
     // clang-format on
+    return result;
+}
+
+void writeJsonResults(const std::string& path,
+                      const std::vector<XferBenchResult>& results) {
+    std::ofstream file(path, std::ios::app);
+    if (!file) {
+        LOG(ERROR) << "Cannot open " << path << " for the results";
+        return;
+    }
+    // One JSON object per run, so that runs can be appended and compared
+    file << std::fixed << std::setprecision(3) << "{\"backend\":\""
+         << XferBenchConfig::backend << "\",\"op_type\":\""
+         << XferBenchConfig::op_type << "\",\"seg_type\":\""
+         << XferBenchConfig::seg_type << "\",\"xport_type\":\""
+         << XferBenchConfig::xport_type << "\",\"duration_s\":"
+         << XferBenchConfig::duration << ",\"timestamp\":"
+         << std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count()
+         << ",\"results\":[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        file << (i ? "," : "") << "{\"block_size\":" << r.block_size
+             << ",\"batch_size\":" << r.batch_size
+             << ",\"num_threads\":" << r.num_threads
+             << ",\"num_targets\":" << r.num_targets
+             << ",\"num_nics\":" << r.num_nics
+             << ",\"bw_gbps\":" << r.throughput_gb
+             << ",\"msg_rate\":" << r.msg_rate
+             << ",\"avg_lat_us\":" << r.avg_latency
+             << ",\"avg_tx_us\":" << r.avg_tx
+             << ",\"p50_tx_us\":" << r.p50_tx
+             << ",\"p90_tx_us\":" << r.p90_tx
+             << ",\"p99_tx_us\":" << r.p99_tx
+             << ",\"p999_tx_us\":" << r.p999_tx
+             << ",\"max_tx_us\":" << r.max_tx << "}";
+    }
+    file << "]}" << std::endl;
 }
 
 }  // namespace tent
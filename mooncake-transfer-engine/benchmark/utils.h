@@ -71,8 +71,15 @@ struct XferBenchConfig {
 
     static int local_gpu_id;
     static int target_gpu_id;
+
+    static std::string json_output;
+    static std::vector<std::string> nic_list;
+    static bool nic_sweep;
+    static int64_t start_time;
 };
 
+std::vector<std::string> splitList(const std::string& list);
+
 struct XferMetricStats {
    public:
     double min() const {
@@ -91,6 +98,8 @@ struct XferMetricStats {
         return sum / samples.size();
     }
 
+    double p50() { return percentile(50.0); }
+
     double p90() { return percentile(90.0); }
 
     double p95() { return percentile(95.0); }
@@ -140,10 +149,31 @@ class XferBenchTimer {
     uint64_t start_ts_;
 };
 
+// One row of the results, as printed and written to --json_output
+struct XferBenchResult {
+    size_t block_size = 0;
+    size_t batch_size = 0;
+    int num_threads = 0;
+    int num_targets = 1;
+    int num_nics = 0;  // 0: all NICs of the host
+    double throughput_gb = 0;
+    double msg_rate = 0;  // Requests completed per second
+    double avg_latency = 0;
+    double avg_tx = 0;
+    double p50_tx = 0;
+    double p90_tx = 0;
+    double p99_tx = 0;
+    double p999_tx = 0;
+    double max_tx = 0;
+};
+
 void printStatsHeader();
 
-void printStats(size_t block_size, size_t batch_size, XferBenchStats& stats,
-                int num_threads);
+XferBenchResult printStats(size_t block_size, size_t batch_size,
+                           XferBenchStats& stats, int num_threads);
+
+void writeJsonResults(const std::string& path,
+                      const std::vector<XferBenchResult>& results);
 
 #ifdef USE_CUDA
 static inline bool isCudaMemory(void* ptr) {
@@ -3,7 +3,10 @@ package main
 import (
 	"flag"
 	"net/http"
+	"strconv"
+	"strings"
 	"sync"
+	"time"
 
 	"github.com/gin-gonic/gin"
 )
@@ -12,10 +15,27 @@ const jsonContentType = "application/json; charset=utf-8"
 
 type MetadataStore struct {
 	store sync.Map
+
+	// Recently changed keys, for clients watching them
+	mutex    sync.Mutex
+	revision uint64
+	changes  []change
+	notify   chan struct{}
+}
+
+type change struct {
+	revision uint64
+	key      string
 }
 
+// Changes kept for watching clients, older ones ask them to reload
+const maxChanges = 4096
+
+// Time a watch request waits for changes
+const watchTimeout = 30 * time.Second
+
 var (
-	metadataStore = MetadataStore{}
+	metadataStore = MetadataStore{notify: make(chan struct{})}
 )
 
 func (m *MetadataStore) Get(key string) ([]byte, bool) {
@@ -28,10 +48,41 @@ func (m *MetadataStore) Get(key string) ([]byte, bool) {
 
 func (m *MetadataStore) Set(key string, value []byte) {
 	m.store.Store(key, value)
+	m.recordChange(key)
 }
 
 func (m *MetadataStore) Delete(key string) {
 	m.store.Delete(key)
+	m.recordChange(key)
+}
+
+func (m *MetadataStore) recordChange(key string) {
+	m.mutex.Lock()
+	defer m.mutex.Unlock()
+	m.revision++
+	m.changes = append(m.changes, change{m.revision, key})
+	if len(m.changes) > maxChanges {
+		m.changes = m.changes[len(m.changes)-maxChanges:]
+	}
+	close(m.notify)
+	m.notify = make(chan struct{})
+}
+
+// Returns the keys under prefix changed after since, whether those changes
+// are no longer known, and a channel closed by the next change
+func (m *MetadataStore) changesSince(prefix string, since uint64) (uint64, []string, bool, chan struct{}) {
+	m.mutex.Lock()
+	defer m.mutex.Unlock()
+	keys := []string{}
+	if since > m.revision || (len(m.changes) > 0 && m.changes[0].revision > since+1) {
+		return m.revision, keys, true, m.notify
+	}
+	for _, c := range m.changes {
+		if c.revision > since && strings.HasPrefix(c.key, prefix) {
+			keys = append(keys, c.key)
+		}
+	}
+	return m.revision, keys, false, m.notify
 }
 
 func getQueryKey(c *gin.Context) string {
@@ -65,6 +116,31 @@ func deleteMetadata(c *gin.Context) {
 	c.Data(http.StatusOK, jsonContentType, []byte(`metadata deleted`))
 }
 
+func watchMetadata(c *gin.Context) {
+	prefix := c.Request.URL.Query().Get("prefix")
+	// Without since, only the current revision is returned
+	sinceStr := c.Request.URL.Query().Get("since")
+	since, _ := strconv.ParseUint(sinceStr, 10, 64)
+	timeout := time.After(watchTimeout)
+	for {
+		revision, keys, reset, notify := metadataStore.changesSince(prefix, since)
+		if sinceStr == "" || reset || len(keys) > 0 {
+			c.JSON(http.StatusOK, gin.H{"revision": revision, "keys": keys, "reset": reset})
+			return
+		}
+		select {
+		case <-notify:
+			// Nothing under prefix changed up to revision
+			since = revision
+		case <-timeout:
+			c.JSON(http.StatusOK, gin.H{"revision": revision, "keys": keys, "reset": false})
+			return
+		case <-c.Request.Context().Done():
+			return
+		}
+	}
+}
+
 func main() {
 	address := flag.String("addr", ":8080", "HTTP server address (default :8080)")
 	flag.Parse()
@@ -74,6 +150,7 @@ func main() {
 	r.GET("/metadata", getMetadata)
 	r.PUT("/metadata", putMetadata)
 	r.DELETE("/metadata", deleteMetadata)
+	r.GET("/metadata/watch", watchMetadata)
 
 	r.Run(*address)
 }
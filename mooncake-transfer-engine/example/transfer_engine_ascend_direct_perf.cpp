@@ -45,6 +45,10 @@ DEFINE_bool(auto_discovery, false, "Enable auto discovery");
 DEFINE_uint64(device_logicid, 0, "The device logic ID of this machine");
 DEFINE_string(report_unit, "GB", "Report unit: GB|GiB|Gb|MB|MiB|Mb|KB|KiB|Kb");
 DEFINE_uint32(report_precision, 2, "Report precision");
+DEFINE_bool(intra_roce, false,
+            "Use RoCE instead of HCCS between NPUs of the same server "
+            "(HCCL_INTRA_ROCE_ENABLE=1), set on both nodes to compare the "
+            "two links");
 
 using namespace mooncake;
 
@@ -188,6 +192,13 @@ int initiator() {
         return -1;
     }
     LOG(INFO) << "get segment desc suc.";
+    auto local_desc =
+        engine->getMetadata()->getSegmentDescByID(LOCAL_SEGMENT_ID);
+    bool same_server =
+        local_desc &&
+        local_desc->rank_info.hostIp == segment_desc->rank_info.hostIp;
+    std::string link = (same_server && !FLAGS_intra_roce) ? "HCCS" : "RoCE";
+    LOG(INFO) << "Expected link to target: " << link;
 
     Status s;
     uint64_t remote_base = 0;
@@ -265,7 +276,8 @@ int initiator() {
 
         LOG(INFO) << "Test completed: duration " << duration
                   << "us, block size " << block_size / 1024 << "KB, total size "
-                  << FLAGS_batch_size * block_size / 1024 << "KB , throughput "
+                  << FLAGS_batch_size * block_size / 1024 << "KB , link "
+                  << link << ", throughput "
                   << calculateRate(FLAGS_batch_size * block_size, duration);
         s = engine->freeBatchID(batch_id);
         LOG_ASSERT(s.ok());
@@ -347,6 +359,9 @@ int main(int argc, char **argv) {
     gflags::ParseCommandLineFlags(&argc, &argv, false);
 
     g_deviceLogicId = FLAGS_device_logicid;
+    if (FLAGS_intra_roce) {
+        setenv("HCCL_INTRA_ROCE_ENABLE", "1", 1);
+    }
     const char *aclConfigPath = NULL;
     aclError ret = aclInit(aclConfigPath);
     if (ret != ACL_ERROR_NONE) {
@@ -17,6 +17,7 @@
 #include <signal.h>
 #include <sys/time.h>
 
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <fstream>
@@ -26,6 +27,7 @@
 #include <unordered_map>
 
 #include "common.h"
+#include "config.h"
 #include "common/base/status.h"
 #include "transfer_engine.h"
 #include "transport/transport.h"
@@ -99,6 +101,9 @@ DEFINE_string(segment_id, "192.168.3.76", "Segment ID to access data");
 DEFINE_uint64(buffer_size, 1ull << 30, "total size of data buffer");
 DEFINE_int32(batch_size, 128, "Batch size");
 DEFINE_uint64(block_size, 65536, "Block size for each transfer request");
+DEFINE_int64(max_slice_size, -1,
+             "Largest RDMA slice with adaptive slicing, 0 to disable it, "
+             "-1 to keep MC_MAX_SLICE_SIZE");
 DEFINE_int32(duration, 10, "Test duration in seconds");
 DEFINE_int32(threads, 12, "Task submission threads");
 DEFINE_bool(auto_discovery, false, "Enable auto discovery");
@@ -474,6 +479,24 @@ static Transport *installTransportFromFlags(TransferEngine *engine) {
     return xport;
 }
 
+// Logs the registration time, to compare startup with and without
+// MC_IB_ODP=1
+static void registerBuffers(TransferEngine *engine,
+                            const std::vector<void *> &addr) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < buffer_num; ++i) {
+        int rc = engine->registerLocalMemory(addr[i], FLAGS_buffer_size,
+                                             getLocationName(i));
+        LOG_ASSERT(!rc);
+    }
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    LOG(INFO) << "Registered " << buffer_num << " buffers of "
+              << FLAGS_buffer_size << " bytes in " << elapsed_ms << " ms"
+              << (globalConfig().use_odp ? " (ODP requested)" : "");
+}
+
 int initiator() {
     // disable topology auto discovery for testing.
     auto engine = std::make_unique<TransferEngine>(FLAGS_auto_discovery);
@@ -486,13 +509,13 @@ int initiator() {
         Transport *xport = installTransportFromFlags(engine.get());
         LOG_ASSERT(xport);
     }
+    // Compare with --max_slice_size=0 for the gain of adaptive slicing
+    if (FLAGS_max_slice_size >= 0) {
+        globalConfig().max_slice_size = FLAGS_max_slice_size;
+    }
 
     auto addr = allocateBuffers();
-    for (int i = 0; i < buffer_num; ++i) {
-        int rc = engine->registerLocalMemory(addr[i], FLAGS_buffer_size,
-                                             getLocationName(i));
-        LOG_ASSERT(!rc);
-    }
+    registerBuffers(engine.get(), addr);
 
     auto segment_id = engine->openSegment(FLAGS_segment_id.c_str());
 
@@ -520,7 +543,8 @@ int initiator() {
               << batch_count << ", throughput "
               << calculateRate(
                      batch_count * FLAGS_batch_size * FLAGS_block_size,
-                     duration);
+                     duration)
+              << ", max slice size " << globalConfig().max_slice_size;
 
     for (int i = 0; i < buffer_num; ++i) {
         engine->unregisterLocalMemory(addr[i]);
@@ -558,11 +582,7 @@ int target() {
     installTransportFromFlags(engine.get());
 
     auto addr = allocateBuffers();
-    for (int i = 0; i < buffer_num; ++i) {
-        int rc = engine->registerLocalMemory(addr[i], FLAGS_buffer_size,
-                                             getLocationName(i));
-        LOG_ASSERT(!rc);
-    }
+    registerBuffers(engine.get(), addr);
 
     while (target_running) sleep(1);
 
@@ -60,6 +60,10 @@ enum class HandShakeRequestType {
     Connection = 0,
     Metadata = 1,
     Notify = 2,
+    // Binary counterparts of Connection and Metadata, see
+    // HandShakePlugin::sendBinary()
+    ConnectionBinary = 3,
+    MetadataBinary = 4,
     // placeholder for old protocol without RequestType
     OldProtocol = 0xff,
 };
@@ -424,7 +428,8 @@ static inline std::pair<HandShakeRequestType, std::string> readString(int fd) {
         return {type, ""};
     }
 
-    if (buffer[0] <= static_cast<char>(HandShakeRequestType::Notify)) {
+    if (buffer[0] <=
+        static_cast<char>(HandShakeRequestType::MetadataBinary)) {
         type = static_cast<HandShakeRequestType>(buffer[0]);
         str.assign(buffer.data() + sizeof(char), length - sizeof(char));
     } else {
@@ -0,0 +1,126 @@
+// Copyright 2025 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BOUNDED_MPSC_RING_H
+#define BOUNDED_MPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace mooncake {
+// Lock-free bounded ring with many producers and a single consumer. Every
+// cell carries a sequence number telling whose turn it is: a producer may
+// fill position pos once the sequence reads pos, the consumer may take it
+// once it reads pos + 1. A producer claims a whole batch of consecutive
+// cells with a single CAS on the tail, so the cost of contention is paid
+// per batch rather than per item.
+template <typename T>
+class BoundedMpscRing {
+   public:
+    // The capacity is rounded up to a power of two
+    explicit BoundedMpscRing(size_t capacity) {
+        capacity_ = 1;
+        while (capacity_ < capacity) capacity_ <<= 1;
+        mask_ = capacity_ - 1;
+        cells_.reset(new Cell[capacity_]);
+        for (uint64_t i = 0; i < capacity_; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedMpscRing(const BoundedMpscRing &) = delete;
+    BoundedMpscRing &operator=(const BoundedMpscRing &) = delete;
+
+    size_t capacity() const { return capacity_; }
+
+    // Appends items in order, waiting for the consumer while the ring is
+    // full. Batches larger than the ring are pushed in pieces.
+    void push(const T *items, size_t count) {
+        while (count) {
+            const size_t n = std::min(count, capacity_);
+            const uint64_t pos = claim(n);
+            for (size_t i = 0; i < n; ++i) {
+                Cell &cell = cells_[(pos + i) & mask_];
+                cell.data = items[i];
+                cell.sequence.store(pos + i + 1, std::memory_order_release);
+            }
+            items += n;
+            count -= n;
+        }
+    }
+
+    void push(const std::vector<T> &items) {
+        push(items.data(), items.size());
+    }
+
+    // Consumer only: moves every published item to out, in order, and
+    // returns how many were taken
+    size_t pop(std::vector<T> &out) {
+        size_t count = 0;
+        while (true) {
+            Cell &cell = cells_[head_ & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != head_ + 1)
+                break;
+            out.push_back(cell.data);
+            cell.sequence.store(head_ + capacity_, std::memory_order_release);
+            ++head_;
+            ++count;
+        }
+        return count;
+    }
+
+    // Consumer only: whether there is nothing to pop
+    bool empty() const {
+        return cells_[head_ & mask_].sequence.load(
+                   std::memory_order_acquire) != head_ + 1;
+    }
+
+   private:
+    uint64_t claim(size_t n) {
+        while (true) {
+            uint64_t pos = tail_.load(std::memory_order_relaxed);
+            // The consumer frees cells in order, so the whole range is free
+            // once its last cell is
+            const uint64_t last = pos + n - 1;
+            uint64_t seq =
+                cells_[last & mask_].sequence.load(std::memory_order_acquire);
+            auto dif = static_cast<int64_t>(seq - last);
+            if (dif == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + n,
+                                                std::memory_order_relaxed))
+                    return pos;
+            } else if (dif < 0) {
+                std::this_thread::yield();  // full
+            }
+        }
+    }
+
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t capacity_;
+    uint64_t mask_;
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    alignas(64) uint64_t head_ = 0;
+};
+}  // namespace mooncake
+
+#endif  // BOUNDED_MPSC_RING_H
@@ -0,0 +1,134 @@
+// Copyright 2025 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REMOTE_MAPPING_CACHE_H
+#define REMOTE_MAPPING_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "common.h"
+#include "common/hash_utils.h"
+
+namespace mooncake {
+// Remote GPU allocations mapped into this process, keyed by the segment
+// and the base address of the allocation in the owner process. Opening a
+// mapping takes milliseconds, so mappings outlive the transfers that use
+// them; a transfer holds a reference from acquire() until release(). Once
+// more than `capacity` mappings are open, the least recently used one that
+// no transfer holds is closed. A capacity of 0 never closes mappings.
+class RemoteMappingCache {
+   public:
+    using Key = std::pair<uint64_t, uint64_t>;
+    // Returns the local address of the mapping, or nullptr on failure
+    using Opener = std::function<void *()>;
+    using Closer = std::function<void(void *)>;
+
+    RemoteMappingCache(size_t capacity, Closer closer)
+        : capacity_(capacity), closer_(std::move(closer)) {}
+
+    ~RemoteMappingCache() { clear(); }
+
+    RemoteMappingCache(const RemoteMappingCache &) = delete;
+    RemoteMappingCache &operator=(const RemoteMappingCache &) = delete;
+
+    // Returns the local address of the mapping and takes a reference to
+    // it, calling `open` if the mapping is not cached. Returns nullptr
+    // without a reference if `open` fails.
+    void *acquire(const Key &key, const Opener &open) {
+        {
+            RWSpinlock::ReadGuard guard(lock_);
+            auto it = entries_.find(key);
+            if (it != entries_.end()) return take(*it->second);
+        }
+        RWSpinlock::WriteGuard guard(lock_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) return take(*it->second);
+        void *addr = open();
+        if (!addr) return nullptr;
+        auto entry = std::make_unique<Entry>();
+        entry->addr = addr;
+        Entry &ref = *entry;
+        entries_.emplace(key, std::move(entry));
+        take(ref);
+        evict();
+        return addr;
+    }
+
+    void release(const Key &key) {
+        RWSpinlock::ReadGuard guard(lock_);
+        auto it = entries_.find(key);
+        if (it != entries_.end())
+            it->second->refs.fetch_sub(1, std::memory_order_release);
+    }
+
+    size_t size() {
+        RWSpinlock::ReadGuard guard(lock_);
+        return entries_.size();
+    }
+
+    // Closes every mapping; no transfer may hold one
+    void clear() {
+        RWSpinlock::WriteGuard guard(lock_);
+        for (auto &entry : entries_) closer_(entry.second->addr);
+        entries_.clear();
+    }
+
+   private:
+    struct Entry {
+        void *addr = nullptr;
+        std::atomic<int> refs{0};
+        std::atomic<uint64_t> last_use{0};
+    };
+
+    void *take(Entry &entry) {
+        entry.refs.fetch_add(1, std::memory_order_acquire);
+        entry.last_use.store(clock_.fetch_add(1, std::memory_order_relaxed),
+                             std::memory_order_relaxed);
+        return entry.addr;
+    }
+
+    // Called with the write lock held. Eviction is rare, so a scan is
+    // cheaper than keeping a list in order on every hit.
+    void evict() {
+        while (capacity_ && entries_.size() > capacity_) {
+            auto victim = entries_.end();
+            for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+                if (it->second->refs.load(std::memory_order_acquire))
+                    continue;
+                if (victim == entries_.end() ||
+                    it->second->last_use < victim->second->last_use)
+                    victim = it;
+            }
+            if (victim == entries_.end()) return;  // all in use
+            closer_(victim->second->addr);
+            entries_.erase(victim);
+        }
+    }
+
+    const size_t capacity_;
+    const Closer closer_;
+    RWSpinlock lock_;
+    std::atomic<uint64_t> clock_{0};
+    std::unordered_map<Key, std::unique_ptr<Entry>, PairHash> entries_;
+};
+
+}  // namespace mooncake
+
+#endif  // REMOTE_MAPPING_CACHE_H
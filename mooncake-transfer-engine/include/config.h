@@ -42,13 +42,30 @@ struct GlobalConfig {
     size_t max_sge = 4;
     size_t max_wr = 256;
     size_t max_inline = 64;
+    // Only every signal_interval-th RDMA WR of a post is signaled
+    size_t signal_interval = 16;
     ibv_mtu mtu_length = IBV_MTU_4096;
     uint16_t handshake_port = 12001;
     int workers_per_ctx = 2;
+    // A worker out of work keeps polling for worker_spin_us, then yields
+    // the CPU between polls until worker_yield_us, then sleeps until its
+    // completion queues or the submitters wake it up
+    uint64_t worker_spin_us = 50;
+    uint64_t worker_yield_us = 1000;
     size_t slice_size = 65536;
+    // Slices of large RDMA requests grow up to this size with the measured
+    // NIC throughput, no larger than slice_size disables it
+    size_t max_slice_size = 1024 * 1024;
     int retry_cnt = 9;
     int handshake_listen_backlog = 128;
     bool metacache = true;
+    // Publish single buffer registrations to the metadata server as deltas
+    // next to the segment descriptor, instead of re-publishing it whole
+    bool metadata_incremental = false;
+    // In P2P handshake mode, interval of refreshing a random known peer and
+    // exchanging the peers each side knows, 0 to only learn peers from the
+    // descriptors fetched
+    uint64_t p2p_gossip_interval_ms = 5000;
     int log_level = google::INFO;
     bool trace = false;
     int64_t slice_timeout = -1;
@@ -58,6 +75,55 @@ struct GlobalConfig {
     size_t fragment_limit = 16384;
     bool enable_dest_device_affinity = false;
     int parallel_reg_mr = -1;
+    // Cover host memory with one implicit on-demand paging MR per device
+    bool use_odp = false;
+    // Spread the slices of RDMA requests over the local NICs by the bytes
+    // each has in flight, rather than sending a request through one NIC
+    bool rail_load_balance = true;
+    // Reach peers through the dynamically connected transport of mlx5
+    // devices, so the QPs of a NIC no longer grow with the cluster size
+    bool use_dc = false;
+    size_t num_dci_per_ctx = 16;
+    // Send the notifications of submitTransferWithNotify() over the RC QPs
+    // of peers taking them, instead of by RPC
+    bool rdma_notify = true;
+    // How RDMA workers share a peer NIC between the priority classes of
+    // TransferRequest: strictly, where a class only posts once the ones
+    // above it have nothing queued for the NIC, or else weighted, where
+    // each class posts up to its share of slices per round
+    bool rdma_strict_priority = false;
+    // Slices of the BULK class a worker posts per peer NIC per round, so
+    // that higher classes get in between the slices of large transfers
+    size_t rdma_bulk_burst = 16;
+    // Persistent connections kept to each TCP peer, 0 for one per slice
+    size_t tcp_connections_per_peer = 4;
+    // Requests larger than this are striped over the connections to the
+    // peer, 0 to send each request as one slice
+    size_t tcp_stripe_size = 4ull * 1024 * 1024;
+    // Threads running the TCP io_context, pinned to tcp_numa_node if >= 0
+    size_t tcp_io_threads = 4;
+    int tcp_numa_node = -1;
+    // CUDA streams per local GPU that NvlinkTransport spreads peers over
+    size_t nvlink_streams_per_device = 4;
+    // Remote GPU allocations the NVLink transports keep mapped, 0 for no
+    // limit
+    size_t nvlink_max_open_mappings = 4096;
+    // Threads CxlTransport splits one copy over, and the smallest copy
+    // that is split
+    size_t cxl_copy_threads = 4;
+    size_t cxl_parallel_copy_threshold = 4ull * 1024 * 1024;
+    // IOs per cuFile batch of NVMeoFTransport, which tunes the size below
+    // this bound, and cuFile batches it keeps in flight
+    size_t nvmeof_max_batch_size = 128;
+    size_t nvmeof_max_inflight_batches = 32;
+    // Requests to RDMA segments of at least this many bytes are split
+    // between the RDMA and NVLink transports, 0 never splits. The NVLink
+    // transport moves multi_path_nvlink_percent of the bytes.
+    size_t multi_path_threshold = 0;
+    int multi_path_nvlink_percent = 75;
+    // Peers whose RDMA transfers fail are served by the TCP transport for
+    // this long before RDMA is tried again, 0 never falls back
+    int transport_fallback_ms = 0;
     size_t eic_max_block_size = 64UL * 1024 * 1024;
     EndpointStoreType endpoint_store_type = EndpointStoreType::SIEVE;
     int ib_traffic_class = -1;
@@ -55,7 +55,16 @@ const static std::string GPU_PREFIX = "musa:";
 #define cudaDeviceEnablePeerAccess musaDeviceEnablePeerAccess
 #define cudaDeviceGetPCIBusId musaDeviceGetPCIBusId
 #define cudaErrorPeerAccessAlreadyEnabled musaErrorPeerAccessAlreadyEnabled
+#define cudaErrorNotReady musaErrorNotReady
 #define cudaError_t musaError_t
+#define cudaEventBlockingSync musaEventBlockingSync
+#define cudaEventCreateWithFlags musaEventCreateWithFlags
+#define cudaEventDestroy musaEventDestroy
+#define cudaEventDisableTiming musaEventDisableTiming
+#define cudaEventQuery musaEventQuery
+#define cudaEventRecord musaEventRecord
+#define cudaEventSynchronize musaEventSynchronize
+#define cudaEvent_t musaEvent_t
 #define cudaFree musaFree
 #define cudaFreeHost musaFreeHost
 #define cudaGetDevice musaGetDevice
@@ -86,6 +95,8 @@ const static std::string GPU_PREFIX = "musa:";
 #define cudaPointerGetAttributes musaPointerGetAttributes
 #define cudaSetDevice musaSetDevice
 #define cudaStreamCreate musaStreamCreate
+#define cudaStreamCreateWithFlags musaStreamCreateWithFlags
+#define cudaStreamNonBlocking musaStreamNonBlocking
 #define cudaStreamDestroy musaStreamDestroy
 #define cudaStreamSynchronize musaStreamSynchronize
 #define cudaStream_t musaStream_t
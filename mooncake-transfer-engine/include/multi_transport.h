@@ -15,11 +15,14 @@
 #ifndef MULTI_TRANSPORT_H_
 #define MULTI_TRANSPORT_H_
 
+#include <atomic>
 #include <unordered_map>
 
 #include "transport/transport.h"
 
 namespace mooncake {
+class RdmaTransport;
+
 class MultiTransport {
    public:
     using BatchID = Transport::BatchID;
@@ -44,6 +47,11 @@ class MultiTransport {
 
     Status getBatchTransferStatus(BatchID batch_id, TransferStatus &status);
 
+    // Waits until one of the batches is done and sets index to its position,
+    // or to batch_ids.size() if none is within timeout_ms (-1 waits forever)
+    Status waitAnyBatch(const std::vector<BatchID> &batch_ids, size_t &index,
+                        int64_t timeout_ms);
+
     Transport *installTransport(const std::string &proto,
                                 std::shared_ptr<Topology> topo);
 
@@ -56,12 +64,39 @@ class MultiTransport {
    private:
     Status selectTransport(const TransferRequest &entry, Transport *&transport);
 
+    // Whether a request for the RDMA transport is large enough to be split
+    // with the NVLink transport, see globalConfig().multi_path_threshold
+    bool isMultiPath(const TransferRequest &request, Transport *transport);
+
+    // Submits the head of the request to the NVLink transport and the rest
+    // to the RDMA transport, as slices of the same task
+    Status submitMultiPath(Transport::TransferTask &task,
+                           const TransferRequest &request,
+                           Transport *transport);
+
+    // Whether a request for the RDMA transport goes to the TCP transport
+    // instead, as RDMA transfers to its peer failed recently
+    bool fallsBack(const TransferRequest &request, Transport *transport);
+
+    // Called with the outcome of a finished task. A failure moves the peer
+    // to TCP for globalConfig().transport_fallback_ms, and a success after
+    // that moves it back to RDMA.
+    void updateFallback(Transport::SegmentID target_id, bool failed);
+
    private:
     std::shared_ptr<TransferMetadata> metadata_;
     std::string local_server_name_;
     std::map<std::string, std::shared_ptr<Transport>> transport_map_;
+    // Compared against on the submit path instead of the transport names,
+    // and called directly when built with USE_RDMA_ONLY
+    RdmaTransport *rdma_transport_{nullptr};
     RWSpinlock batch_desc_lock_;
     std::unordered_map<BatchID, std::shared_ptr<BatchDesc>> batch_desc_set_;
+    // Peers served by the TCP transport, with the time at which requests
+    // probe RDMA again
+    RWSpinlock fallback_lock_;
+    std::unordered_map<Transport::SegmentID, int64_t> fallback_peers_;
+    std::atomic<size_t> fallback_count_{0};
 };
 }  // namespace mooncake
 
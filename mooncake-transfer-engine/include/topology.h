@@ -87,6 +87,11 @@ class Topology {
     int selectDevice(const std::string storage_type, std::string_view hint,
                      int retry_count = 0);
 
+    // Devices serving the storage type: the preferred ones, or else the
+    // available ones. Empty if the storage type is unknown.
+    const std::vector<int> &candidateDevices(
+        const std::string &storage_type) const;
+
     TopologyMatrix getMatrix() const { return matrix_; }
 
     const std::vector<std::string> &getHcaList() const { return hca_list_; }
@@ -31,6 +31,7 @@ using TransferStatusEnum = Transport::TransferStatusEnum;
 using SegmentHandle = Transport::SegmentHandle;
 using SegmentID = Transport::SegmentID;
 using BatchID = Transport::BatchID;
+using BatchCompletionCallback = Transport::BatchCompletionCallback;
 const static BatchID INVALID_BATCH_ID = UINT64_MAX;
 using BufferEntry = Transport::BufferEntry;
 
@@ -59,6 +60,12 @@ class TransferEngine {
 
     SegmentHandle openSegment(const std::string& segment_name);
 
+    // Opens the segments and sets up their connections ahead of the first
+    // transfer, with at most concurrency segments in flight. Returns the
+    // number of segments that failed.
+    int warmupSegments(const std::vector<std::string>& segment_names,
+                       size_t concurrency = 16);
+
     Status CheckSegmentStatus(SegmentID sid);
 
     int closeSegment(SegmentHandle handle);
@@ -101,6 +108,24 @@ class TransferEngine {
 
     Status getBatchTransferStatus(BatchID batch_id, TransferStatus& status);
 
+    // Completion notification, instead of polling the status of each task.
+    // A batch is done once batch_size of its tasks are finished; their status
+    // is then read as usual.
+
+    // Returns an eventfd turning readable once the batch is done, or a
+    // negative error code. It is closed by freeBatchID().
+    int getBatchCompletionFd(BatchID batch_id);
+
+    // Runs callback once the batch is done, on the thread completing its last
+    // task, or right away if it already is done. It must not block.
+    Status setBatchCompletionCallback(BatchID batch_id,
+                                      BatchCompletionCallback callback);
+
+    // Waits until one of the batches is done and sets index to its position,
+    // or to batch_ids.size() if none is within timeout_ms (-1 waits forever)
+    Status waitAnyBatch(const std::vector<BatchID>& batch_ids, size_t& index,
+                        int64_t timeout_ms = -1);
+
     Transport* getTransport(const std::string& proto);
 
     int syncSegmentCache(const std::string& segment_name = "");
@@ -119,10 +144,16 @@ class TransferEngine {
 
     std::shared_ptr<Topology> getLocalTopology();
 
+    // True if the transfers are driven by the TENT runtime, i.e. the build
+    // has USE_TENT and MC_USE_TENT (or MC_USE_TEV1) is set
+    bool isUsingTent() const { return use_tent_; }
+
    private:
     std::shared_ptr<TransferEngineImpl> impl_;
     std::shared_ptr<mooncake::tent::TransferEngine> impl_tent_;
     bool use_tent_{false};
+    // NIC whitelist handed to the TENT topology at init
+    std::vector<std::string> tent_filters_;
 };
 }  // namespace mooncake
 
@@ -45,6 +45,7 @@ using TransferStatusEnum = Transport::TransferStatusEnum;
 using SegmentHandle = Transport::SegmentHandle;
 using SegmentID = Transport::SegmentID;
 using BatchID = Transport::BatchID;
+using BatchCompletionCallback = Transport::BatchCompletionCallback;
 using BufferEntry = Transport::BufferEntry;
 
 class TransferEngineImpl {
@@ -96,6 +97,12 @@ class TransferEngineImpl {
 
     SegmentHandle openSegment(const std::string& segment_name);
 
+    // Opens the segments and sets up their connections ahead of the first
+    // transfer, with at most concurrency segments in flight. Returns the
+    // number of segments that failed.
+    int warmupSegments(const std::vector<std::string>& segment_names,
+                       size_t concurrency = 16);
+
     Status CheckSegmentStatus(SegmentID sid);
 
     int closeSegment(SegmentHandle handle);
@@ -265,6 +272,28 @@ class TransferEngineImpl {
         return result;
     }
 
+    int getBatchCompletionFd(BatchID batch_id) {
+        return Transport::getBatchCompletionFd(batch_id);
+    }
+
+    Status setBatchCompletionCallback(BatchID batch_id,
+                                      BatchCompletionCallback callback) {
+        return Transport::setBatchCompletionCallback(batch_id,
+                                                     std::move(callback));
+    }
+
+    Status waitAnyBatch(const std::vector<BatchID>& batch_ids, size_t& index,
+                        int64_t timeout_ms) {
+        Status result =
+            multi_transports_->waitAnyBatch(batch_ids, index, timeout_ms);
+        if (result.ok() && index < batch_ids.size()) {
+            // Posts the notify message of submitTransferWithNotify()
+            TransferStatus dummy_status;
+            getBatchTransferStatus(batch_ids[index], dummy_status, true);
+        }
+        return result;
+    }
+
     Transport* getTransport(const std::string& proto) {
         return multi_transports_->getTransport(proto);
     }
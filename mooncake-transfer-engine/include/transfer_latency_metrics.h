@@ -0,0 +1,134 @@
+// Copyright 2025 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSFER_LATENCY_METRICS_H
+#define TRANSFER_LATENCY_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mooncake {
+// Log-linear histogram of latencies in microseconds, as HdrHistogram: values
+// below kSubBuckets have a bucket each, every larger power of two is split
+// into kSubBuckets buckets, so the relative error stays under 1/kSubBuckets.
+// Threads record into one of kShards cache-line aligned copies of the
+// counters with relaxed atomic adds, so recording takes no lock and threads
+// rarely share a cache line.
+class LatencyHistogram {
+   public:
+    static constexpr int kSubBucketBits = 2;
+    static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+    // Values from 2^kMaxExponent us (about 9.5 hours) on share the last
+    // bucket
+    static constexpr int kMaxExponent = 35;
+    static constexpr size_t kBuckets =
+        (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+    static constexpr size_t kShards = 8;
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;
+        uint64_t count = 0;
+        uint64_t sum = 0;
+    };
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < kSubBuckets) return value;
+        const int exponent = 63 - __builtin_clzll(value);
+        if (exponent >= kMaxExponent) return kBuckets - 1;
+        const size_t sub =
+            (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+        return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+    }
+
+    // Largest value of the bucket
+    static uint64_t bucketMax(size_t index) {
+        if (index < kSubBuckets) return index;
+        const int exponent = index / kSubBuckets + kSubBucketBits - 1;
+        const uint64_t sub = kSubBuckets + index % kSubBuckets;
+        return ((sub + 1) << (exponent - kSubBucketBits)) - 1;
+    }
+
+    void record(uint64_t value_us) {
+        auto &shard = shards_[shardIndex()];
+        shard.counts[bucketIndex(value_us)].fetch_add(
+            1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value_us, std::memory_order_relaxed);
+    }
+
+    Snapshot snapshot() const;
+
+   private:
+    static size_t shardIndex() {
+        static std::atomic<size_t> next_shard{0};
+        static thread_local size_t shard =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return shard;
+    }
+
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, kBuckets> counts{};
+        std::atomic<uint64_t> sum{0};
+    };
+    std::array<Shard, kShards> shards_;
+};
+
+// Latency histograms and queue depth gauges of the transfers of this
+// process, in the Prometheus text format for the metrics of the store
+// client. Histograms live as long as the process, so that hot paths can
+// keep pointers to them and record without a lookup.
+class TransferLatencyMetrics {
+   public:
+    static TransferLatencyMetrics &instance();
+
+    // The histogram of the metric with the labels, e.g. `nic="mlx5_0"`,
+    // created on first use
+    LatencyHistogram *histogram(const std::string &name,
+                                const std::string &help,
+                                const std::string &labels);
+
+    // Gauges read on serialization, until removed by their owner
+    void addGauge(const void *owner, const std::string &name,
+                  const std::string &help, const std::string &labels,
+                  std::function<uint64_t()> read);
+    void removeGauges(const void *owner);
+
+    void serialize(std::string &out) const;
+
+   private:
+    struct Histogram {
+        std::string help;
+        std::map<std::string, std::unique_ptr<LatencyHistogram>> series;
+    };
+    struct Gauge {
+        const void *owner;
+        std::string help;
+        std::string labels;
+        std::function<uint64_t()> read;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Histogram> histograms_;
+    std::multimap<std::string, Gauge> gauges_;
+};
+}  // namespace mooncake
+
+#endif  // TRANSFER_LATENCY_METRICS_H
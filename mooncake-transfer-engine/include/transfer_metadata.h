@@ -24,12 +24,16 @@
 #include <netdb.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "common.h"
 #include "topology.h"
@@ -46,6 +50,8 @@ class TransferMetadata {
         std::string name;
         uint16_t lid;
         std::string gid;
+        // DC target serving the NIC, 0 if it only accepts RC connections
+        uint32_t dct_num = 0;
     };
 
     struct BufferDesc {
@@ -55,7 +61,8 @@ class TransferMetadata {
         std::vector<uint32_t> lkey;  // for rdma
         std::vector<uint32_t> rkey;  // for rdma
         std::string shm_name;        // for nvlink and hip
-        uint64_t offset;             // for cxl
+        // for cxl; for nvlink, offset of addr in its GPU allocation
+        uint64_t offset = 0;
     };
 
     struct NVMeoFBufferDesc {
@@ -96,6 +103,13 @@ class TransferMetadata {
         RankInfoDesc rank_info;
 
         int tcp_data_port;
+        // The TCP data port serves several requests per connection
+        bool tcp_persistent = false;
+
+        // Version of the descriptor, lets P2P peers ask only for the buffers
+        // registered or removed since the copy they cache
+        uint64_t instance_id = 0;
+        uint64_t generation = 0;
 
         void dump() const;
     };
@@ -117,6 +131,8 @@ class TransferMetadata {
 #endif
         std::vector<uint32_t> qp_num;
         std::string reply_msg;  // on error
+        // Whether the QPs take notifications sent as RDMA SENDs
+        bool notify_recv = false;
 #ifdef USE_EFA
         std::string efa_addr;  // EFA endpoint address (hex encoded)
 #endif
@@ -130,6 +146,11 @@ class TransferMetadata {
    public:
     TransferMetadata(const std::string &conn_string);
 
+    // Keeps the metadata in storage_plugin instead of the store named by
+    // conn_string, if not null
+    TransferMetadata(const std::string &conn_string,
+                     std::shared_ptr<MetadataStoragePlugin> storage_plugin);
+
     ~TransferMetadata();
 
     std::shared_ptr<SegmentDesc> getSegmentDescByName(
@@ -169,6 +190,9 @@ class TransferMetadata {
     int getRpcMetaEntry(const std::string &server_name, RpcMetaDesc &desc);
     int getNotifies(std::vector<NotifyDesc> &notifies);
 
+    // Queues a notification received from a peer for getNotifies()
+    void addNotify(NotifyDesc notify);
+
     const RpcMetaDesc &localRpcMeta() const { return local_rpc_meta_; }
 
     using OnReceiveHandShake = std::function<int(const HandShakeDesc &peer_desc,
@@ -180,6 +204,13 @@ class TransferMetadata {
                       const HandShakeDesc &local_desc,
                       HandShakeDesc &peer_desc);
 
+    // Exchanges the handshakes of many endpoints to the same server in one
+    // round trip. peer_desc_list[i] answers local_desc_list[i], and carries
+    // its own reply_msg if rejected.
+    int sendHandshakeBatch(const std::string &peer_server_name,
+                           const std::vector<HandShakeDesc> &local_desc_list,
+                           std::vector<HandShakeDesc> &peer_desc_list);
+
     int sendNotify(const std::string &peer_server_name,
                    const NotifyDesc &local_desc, NotifyDesc &peer_desc);
 
@@ -188,6 +219,10 @@ class TransferMetadata {
 
     void dumpMetadataContentUnlocked();
 
+    // Segments known in P2P handshake mode, learned from the seeds in
+    // MC_P2P_SEEDS and from the peers exchanging descriptors with us
+    std::vector<std::string> getKnownSegments();
+
    private:
     int encodeSegmentDesc(const SegmentDesc &desc, Json::Value &segmentJSON);
     std::shared_ptr<TransferMetadata::SegmentDesc> decodeSegmentDesc(
@@ -196,6 +231,34 @@ class TransferMetadata {
                             Json::Value &local_json);
     int receivePeerNotify(const Json::Value &peer_json,
                           Json::Value &local_json);
+    int receivePeerMetadataBinary(const std::string &peer,
+                                  std::string &local);
+    int getSegmentDescBinary(const std::string &segment_name,
+                             const std::string &ip, uint16_t port,
+                             std::shared_ptr<SegmentDesc> &desc);
+    int sendHandshakeBinary(const RpcMetaDesc &peer_location,
+                            const std::vector<HandShakeDesc> &local_desc_list,
+                            std::vector<HandShakeDesc> &peer_desc_list);
+    void recordLocalBufferChange(bool removed, const BufferDesc &buffer);
+    std::shared_ptr<SegmentDesc> getCachedPeerSegmentDesc(
+        const std::string &segment_name);
+    std::shared_ptr<SegmentDesc> getSegmentDescFromStorage(
+        const std::string &segment_name);
+    int applyBufferDeltas(const std::string &segment_name, SegmentDesc &desc,
+                          uint64_t generation);
+    int publishLocalBufferChanges();
+    int publishLocalSegmentDescUnlocked();
+    std::string getDeltaKey(const std::string &segment_name,
+                            const std::string &suffix) const;
+    void onMetadataChanged(const std::string &key);
+    void markSegmentStale(const std::string &segment_name);
+    bool takeStaleSegment(const std::string &segment_name);
+    void addKnownSegments(const std::vector<std::string> &segment_names);
+    std::vector<std::string> sampleKnownSegments(size_t count);
+    std::string localSegmentName();
+    void runGossip();
+    bool isJsonOnlyPeer(const std::string &ip, uint16_t port);
+    void markJsonOnlyPeer(const std::string &ip, uint16_t port);
     std::string getFullMetadataKey(const std::string &segment_name) const;
 
     bool p2p_handshake_mode_{false};
@@ -207,6 +270,42 @@ class TransferMetadata {
         segment_id_to_desc_map_;
     std::unordered_map<std::string, uint64_t> segment_name_to_id_map_;
 
+    struct BufferChange {
+        uint64_t generation;
+        bool removed;
+        BufferDesc buffer;
+    };
+    // Recent changes of the local buffer list, guarded by segment_lock_
+    uint64_t local_instance_id_;
+    uint64_t local_generation_ = 0;
+    std::deque<BufferChange> local_buffer_changes_;
+
+    // Range of generations published as deltas to the metadata server, on
+    // top of the descriptor published at published_snapshot_
+    std::mutex publish_mutex_;
+    uint64_t published_snapshot_ = 0;
+    uint64_t published_generation_ = 0;
+
+    // Cached peer segments changed on the metadata server, when it notifies
+    // changes. Others are served from the cache without asking it.
+    bool watching_ = false;
+    RWSpinlock stale_lock_;
+    std::unordered_set<std::string> stale_segments_;
+    std::atomic<size_t> num_stale_segments_{0};
+
+    // Segments discovered in P2P handshake mode, and the thread refreshing
+    // them in turn
+    RWSpinlock known_segments_lock_;
+    std::unordered_set<std::string> known_segments_;
+    std::thread gossip_thread_;
+    std::mutex gossip_mutex_;
+    std::condition_variable gossip_cv_;
+    bool gossip_stopped_ = false;
+
+    // Peers that only understand JSON handshake messages
+    RWSpinlock json_only_lock_;
+    std::unordered_set<std::string> json_only_peers_;
+
     RWSpinlock notify_lock_;
     std::vector<NotifyDesc> notifys;
     RWSpinlock rpc_meta_lock_;
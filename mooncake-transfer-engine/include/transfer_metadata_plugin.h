@@ -28,6 +28,34 @@ struct MetadataStoragePlugin {
     virtual bool get(const std::string &key, Json::Value &value) = 0;
     virtual bool set(const std::string &key, const Json::Value &value) = 0;
     virtual bool remove(const std::string &key) = 0;
+
+    // Fetches several keys at once, fails if any of them is missing
+    virtual bool getBatch(const std::vector<std::string> &keys,
+                          std::vector<Json::Value> &values) {
+        values.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+            if (!get(keys[i], values[i])) return false;
+        return true;
+    }
+
+    // Stores the entries in order, a reader that sees an entry also sees
+    // the ones before it
+    virtual bool setBatch(
+        const std::vector<std::pair<std::string, Json::Value>> &entries) {
+        for (const auto &entry : entries)
+            if (!set(entry.first, entry.second)) return false;
+        return true;
+    }
+
+    // Called with the key of every entry put or removed under the watched
+    // prefix, or with an empty key when changes may have been missed
+    using OnChangeCallBack = std::function<void(const std::string &key)>;
+
+    // Returns false if the store cannot notify changes, the callback is
+    // no longer called once the plugin is destroyed
+    virtual bool watch(const std::string &prefix, OnChangeCallBack callback) {
+        return false;
+    }
 };
 
 struct HandShakePlugin {
@@ -65,6 +93,23 @@ struct HandShakePlugin {
 
     // Register callback function for receiving metadata exchange request.
     virtual void registerOnNotifyCallBack(OnReceiveCallBack callback) = 0;
+
+    // Binary messages, of type ConnectionBinary or MetadataBinary. The
+    // payloads are opaque to the plugin.
+    using OnReceiveBinaryCallBack =
+        std::function<int(const std::string &, std::string &)>;
+
+    // Sends a binary message and waits for the reply of the peer. Returns
+    // ERR_NOT_IMPLEMENTED if the plugin or the peer does not support
+    // binary messages, in which case the JSON ones should be used.
+    virtual int sendBinary(std::string ip_or_host_name, uint16_t rpc_port,
+                           HandShakeRequestType type, const std::string &local,
+                           std::string &peer) {
+        return ERR_NOT_IMPLEMENTED;
+    }
+
+    virtual void registerOnBinaryCallBack(HandShakeRequestType type,
+                                          OnReceiveBinaryCallBack callback) {}
 };
 
 std::vector<std::string> findLocalIpAddresses();
@@ -75,8 +75,21 @@ class AscendDirectTransport : public Transport {
         const std::vector<void *> &addr_list) override;
 
    private:
+    // Link a peer is reached over. HCCS connects the NPUs of one server;
+    // every other peer, or any peer with HCCL_INTRA_ROCE_ENABLE=1, is
+    // reached over RoCE.
+    enum class LinkPath { kLocal, kHccs, kRoce };
+
     int allocateLocalSegmentID();
 
+    LinkPath getLinkPath(SegmentID target_id);
+
+    int createCopyStreams();
+
+    aclrtEvent acquireEvent();
+
+    void releaseEvent(aclrtEvent event);
+
     void queryThread();
 
     void processSliceList(const std::vector<Slice *> &slice_list);
@@ -122,6 +135,8 @@ class AscendDirectTransport : public Transport {
 
     void submitSlices(std::vector<Slice *> &slice_list);
 
+    void enqueueSlices(std::vector<Slice *> slice_list);
+
     std::atomic_bool running_;
     std::unique_ptr<adxl::AdxlEngine> adxl_;
     std::map<void *, adxl::MemHandle> addr_to_mem_handle_;
@@ -132,17 +147,29 @@ class AscendDirectTransport : public Transport {
     std::mutex connection_mutex_;
 
     int32_t device_logic_id_{};
+    int32_t device_phy_id_{};
     aclrtContext rt_context_{nullptr};
     int32_t connect_timeout_ = 10000;
     int32_t transfer_timeout_ = 10000;
     std::string local_adxl_engine_name_{};
-    aclrtStream stream_{};
+    // Streams for copies within this process, used round robin
+    std::vector<aclrtStream> copy_streams_;
+    std::atomic<size_t> next_copy_stream_{0};
+    std::vector<aclrtEvent> free_events_;
+    std::mutex event_mutex_;
     bool use_buffer_pool_{false};
     bool auto_connect_{false};
     int32_t base_port_ = 20000;
     std::unordered_set<SegmentID> need_update_metadata_segs_;
     bool use_short_connection_{false};
 
+    std::unordered_map<SegmentID, LinkPath> link_paths_;
+    std::mutex link_path_mutex_;
+    bool intra_roce_{false};
+    // NPUs per HCCS group on a server, 0 if all NPUs of a server are linked
+    int32_t hccs_group_size_{0};
+    size_t roce_split_bytes_{0};
+
     // add for async transfer
     std::thread query_thread_;
     std::queue<std::vector<Slice *>> query_slice_queue_;
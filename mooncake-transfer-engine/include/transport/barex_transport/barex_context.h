@@ -17,6 +17,7 @@
 
 #include <infiniband/verbs.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <map>
@@ -101,6 +102,16 @@ class ChannelCache {
         return true;
     }
 
+    // number of channels to a peer nic
+    size_t count(SegmentID key, int nic_id) {
+        RWSpinlock::ReadGuard guard(lock_);
+        auto it = cache_.find(key);
+        if (it == cache_.end()) return 0;
+        auto ch_it = it->second.find(nic_id);
+        if (ch_it == it->second.end()) return 0;
+        return ch_it->second.size();
+    }
+
     // get channel state
     bool CheckAllChannels(SegmentID segment_id) {
         RWSpinlock::ReadGuard guard(lock_);
@@ -163,6 +174,14 @@ class ChannelCache {
 };
 class BarexContext {
    public:
+    // Counters of the slices posted through this context
+    struct Stats {
+        uint64_t submitted_slices = 0;
+        uint64_t completed_slices = 0;
+        uint64_t failed_slices = 0;
+        uint64_t outstanding_bytes = 0;
+    };
+
     int submitPostSend(const std::vector<Transport::Slice*>& slice_list);
     int addChannel(SegmentID sid, int device_id, XChannel* ch);
     XChannel* getChannel(SegmentID sid, int device_id, int idx);
@@ -173,6 +192,9 @@ class BarexContext {
     bool active() const { return active_; }
     void setQpNum(int qp_num) { qp_num_per_ctx_ = qp_num; }
     int getQpNum() const { return qp_num_per_ctx_; }
+    size_t channelCount(SegmentID sid, int device_id);
+    bool allChannelsActive(SegmentID sid);
+    Stats getStats() const;
 
    public:
     BarexContext(XContext* xcontext, bool use_cpu, int device_id);
@@ -184,9 +206,18 @@ class BarexContext {
     int barex_local_device_;
 
    private:
+    void completeSlices(const std::vector<Transport::Slice*>& slices,
+                        bool success);
+
     ChannelCache channel_cache_;
     bool active_ = true;
     int qp_num_per_ctx_ = 2;
+    // Threads submitting at the same time start at different channels
+    std::atomic<uint64_t> next_channel_{0};
+    std::atomic<uint64_t> submitted_slice_count_{0};
+    std::atomic<uint64_t> completed_slice_count_{0};
+    std::atomic<uint64_t> failed_slice_count_{0};
+    std::atomic<uint64_t> outstanding_bytes_{0};
 };
 #endif
 }  // namespace mooncake
@@ -126,6 +126,11 @@ class BarexTransport : public Transport {
     Status OpenChannel(const std::string &segment_name, SegmentID sid) override;
     Status CheckStatus(SegmentID sid) override;
 
+#ifdef USE_BAREX
+    // Counters summed over the client contexts
+    BarexContext::Stats getStats();
+#endif
+
    private:
     int allocateLocalSegmentID();
 
@@ -158,6 +163,11 @@ class BarexTransport : public Transport {
     std::shared_ptr<XSimpleMempool> mempool_;
     std::shared_ptr<XListener> listener_;
     std::shared_ptr<XConnector> connector_;
+    // Serializes opening channels to one peer, so that threads opening the
+    // same segment share one set of channels
+    std::mutex open_channel_mutex_;
+    std::unordered_map<SegmentID, std::shared_ptr<std::mutex>>
+        open_channel_locks_;
 #endif
     std::shared_ptr<Topology> local_topology_;
     std::mutex buf_mutex_;
@@ -16,11 +16,14 @@
 #define CXL_TRANSPORT_H_
 
 #include <atomic>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -52,6 +55,14 @@ class CxlTransport : public Transport {
 
     void *getCxlBaseAddr() { return cxl_base_addr; }
 
+    // Address of [offset, offset + length) of the CXL device in this
+    // process, or nullptr if the range is not inside the device. Hosts
+    // attached to the same CXL pool map the same device, so a client can
+    // load and store objects in place instead of copying them through a
+    // transfer. Writes of CxlTransport bypass the cache of the writer, but
+    // a reader on another host must not hold stale lines of the range.
+    void *getCxlAddress(uint64_t offset, size_t length);
+
    private:
     int install(std::string &local_server_name,
                 std::shared_ptr<TransferMetadata> meta,
@@ -84,10 +95,33 @@ class CxlTransport : public Transport {
 
     bool validateMemoryBounds(void *dest, void *src, size_t size);
 
+    // Splits a copy over the calling thread and the copy workers
+    void parallelCopy(char *dest, const char *src, size_t size, bool stream);
+
+    void startCopyWorkers(size_t count);
+
+    void stopCopyWorkers();
+
+    void copyWorker();
+
    private:
-    void *cxl_base_addr;
-    size_t cxl_dev_size;
-    char *cxl_dev_path;
+    struct CopyChunk {
+        char *dest;
+        const char *src;
+        size_t size;
+        bool stream;  // use non-temporal stores
+        std::atomic<size_t> *pending;
+    };
+
+    void *cxl_base_addr = nullptr;
+    size_t cxl_dev_size = 0;
+    char *cxl_dev_path = nullptr;
+
+    std::vector<std::thread> copy_workers_;
+    std::mutex copy_mutex_;
+    std::condition_variable copy_cv_;
+    std::deque<CopyChunk> copy_queue_;
+    bool copy_stop_ = false;
 };
 }  // namespace mooncake
 
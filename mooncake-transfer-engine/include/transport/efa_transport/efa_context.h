@@ -124,9 +124,17 @@ class EfaContext {
     // Poll completion queue for completed operations
     int pollCq(int max_entries, int cq_index = 0);
 
+    // Largest number of completions pollCq reads in one fi_cq_read call
+    static const int kMaxPollBatch = 256;
+
     // Get CQ count
     size_t cqCount() const { return cq_list_.size(); }
 
+    struct fid_cq *cq(int cq_index) const {
+        if (cq_index < 0 || (size_t)cq_index >= cq_list_.size()) return nullptr;
+        return cq_list_[cq_index]->cq;
+    }
+
     // Get CQ outstanding count pointer
     volatile int *cqOutstandingCount(int cq_index) {
         if (cq_index < 0 || (size_t)cq_index >= cq_list_.size()) return nullptr;
@@ -167,6 +175,8 @@ class EfaContext {
 
     std::shared_ptr<EfaEndpointStore> endpoint_store_;
     std::vector<std::shared_ptr<EfaCq>> cq_list_;
+    // New endpoints are spread over the CQs round-robin
+    std::atomic<size_t> next_cq_index_{0};
 
     RWSpinlock mr_lock_;
     std::unordered_map<uint64_t, EfaMemoryRegionMeta> mr_map_;
@@ -44,6 +44,7 @@ struct EfaOpContext {
     Transport::Slice *slice;   // Slice pointer for completion handling
     volatile int *wr_depth;    // Pointer to endpoint's wr_depth_ for CQ
                                // completion decrement
+    void *local_desc;          // MR descriptor of the local buffer
 };
 
 // EfaEndPoint represents a libfabric endpoint for EFA communication.
@@ -58,8 +59,8 @@ class EfaEndPoint {
     EfaEndPoint(EfaContext &context);
     ~EfaEndPoint();
 
-    // Construct endpoint with specified completion queue
-    int construct(struct fid_cq *cq, size_t num_qp_list = 1, size_t max_sge = 4,
+    // Construct endpoint on the given completion queue of the context
+    int construct(int cq_index, size_t num_qp_list = 1, size_t max_sge = 4,
                   size_t max_wr = 256, size_t max_inline = 64);
 
    private:
@@ -130,6 +131,17 @@ class EfaEndPoint {
     // Insert peer address into address vector
     int insertPeerAddr(const std::string &peer_addr);
 
+    // Reserves a WR slot and a CQ slot for one more operation, waiting
+    // for completions while either is full. False on timeout.
+    bool reserveSlot();
+
+    void releaseSlot();
+
+    // Posts the operations under post_lock_ as one doorbell batch: all but
+    // the last are flagged FI_MORE. Returns the number posted; the rest
+    // hit a hard error and their contexts are freed.
+    size_t postBatch(EfaOpContext **ops, size_t count);
+
    private:
     EfaContext &context_;
     std::atomic<Status> status_;
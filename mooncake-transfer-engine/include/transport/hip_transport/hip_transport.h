@@ -12,7 +12,7 @@
 #include <vector>
 #include <utility>
 
-#include "common/hash_utils.h"
+#include "common/remote_mapping_cache.h"
 #include "topology.h"
 #include "transfer_metadata.h"
 #include "transport/transport.h"
@@ -38,6 +38,9 @@ class HipTransport : public Transport {
     Status getTransferStatus(BatchID batch_id, size_t task_id,
                              TransferStatus& status) override;
 
+    // Maps every buffer of the segment ahead of its first transfer
+    int warmupSegment(SegmentID target_id) override;
+
     static void* allocatePinnedLocalMemory(size_t length);
 
     static void freePinnedLocalMemory(void* addr);
@@ -59,35 +62,43 @@ class HipTransport : public Transport {
     int unregisterLocalMemoryBatch(
         const std::vector<void*>& addr_list) override;
 
+    // Takes a reference to the mapping of the buffer, to be released with
+    // releaseMapping() once the copy is done
     int relocateSharedMemoryAddress(uint64_t& dest_addr, uint64_t length,
-                                    uint64_t target_id);
+                                    uint64_t target_id, uint64_t& remote_base);
 
     const char* getName() const override { return "hip"; }
 
    private:
-    struct OpenedShmEntry {
-        void* shm_addr;
-        uint64_t length;
-    };
-
+    // Copies issued on one stream, completed by a single event
     struct PendingTransfer {
-        hipEvent_t event;
+        hipStream_t stream;
         int device_id;
-        Slice* slice;
+        hipEvent_t event;
+        std::vector<Slice*> slices;
     };
 
-    // Start async transfer and return pending transfer info
+    // Splits the request into slices and issues their copies; a large
+    // request is striped over several streams
     Status startAsyncTransfer(const TransferRequest& request,
-                              TransferTask& task, PendingTransfer& pending);
+                              TransferTask& task,
+                              std::vector<PendingTransfer>& pending_transfers);
+
+    Status issueCopy(Slice* slice, int device_id,
+                     std::vector<PendingTransfer>& pending_transfers);
 
     // Synchronize pending transfers
     void synchronizePendingTransfers(
         std::vector<PendingTransfer>& pending_transfers);
 
-    std::unordered_map<std::pair<uint64_t, uint64_t>, OpenedShmEntry, PairHash>
-        remap_entries_;
-    RWSpinlock remap_lock_;
+    void* openRemoteMemory(const BufferDesc& entry, uint64_t length);
+
+    void releaseMapping(Slice* slice);
+
     bool use_fabric_mem_;
+    RemoteMappingCache mappings_;
+    size_t stripe_size_;
+    size_t max_stripes_;
 
     std::mutex register_mutex_;
 
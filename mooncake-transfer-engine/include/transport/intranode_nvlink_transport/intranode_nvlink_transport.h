@@ -15,6 +15,7 @@
 #include <utility>
 
 #include "common/hash_utils.h"
+#include "common/remote_mapping_cache.h"
 #include "topology.h"
 #include "transfer_metadata.h"
 #include "transport/transport.h"
@@ -38,6 +39,10 @@ class IntraNodeNvlinkTransport : public Transport {
     Status getTransferStatus(BatchID batch_id, size_t task_id,
                              TransferStatus& status) override;
 
+    // Maps every GPU allocation the segment has registered, so that the
+    // first transfers to it do not have to
+    int warmupSegment(SegmentID target_id) override;
+
     static void* allocatePinnedLocalMemory(size_t length);
 
     static void freePinnedLocalMemory(void* addr);
@@ -59,22 +64,19 @@ class IntraNodeNvlinkTransport : public Transport {
     int unregisterLocalMemoryBatch(
         const std::vector<void*>& addr_list) override;
 
+    // Translates dest_addr to the local mapping of the remote buffer and
+    // takes a reference to the mapping, which the caller releases
     int relocateSharedMemoryAddress(uint64_t& dest_addr, uint64_t length,
-                                    uint64_t target_id);
+                                    uint64_t target_id, uint64_t& remote_base);
 
     const char* getName() const override { return "nvlink_intraNode"; }
 
    private:
     std::atomic_bool running_;
 
-    struct OpenedShmEntry {
-        void* shm_addr;
-        uint64_t length;
-    };
+    void copySlice(Slice* slice);
 
-    std::unordered_map<std::pair<uint64_t, uint64_t>, OpenedShmEntry, PairHash>
-        remap_entries_;
-    RWSpinlock remap_lock_;
+    RemoteMappingCache mappings_;
     // bool use_fabric_mem_;
 
     std::mutex register_mutex_;
@@ -5,16 +5,21 @@
 
 #include "cuda_alike.h"
 
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 
 #include "common/hash_utils.h"
+#include "common/remote_mapping_cache.h"
 #include "topology.h"
 #include "transfer_metadata.h"
 #include "transport/transport.h"
@@ -38,6 +43,10 @@ class NvlinkTransport : public Transport {
     Status getTransferStatus(BatchID batch_id, size_t task_id,
                              TransferStatus& status) override;
 
+    // Maps every GPU allocation the segment has registered, so that the
+    // first transfers to it do not have to
+    int warmupSegment(SegmentID target_id) override;
+
     static void* allocatePinnedLocalMemory(size_t length);
 
     static void freePinnedLocalMemory(void* addr);
@@ -59,23 +68,52 @@ class NvlinkTransport : public Transport {
     int unregisterLocalMemoryBatch(
         const std::vector<void*>& addr_list) override;
 
+    // Translates dest_addr to the local mapping of the remote buffer and
+    // takes a reference to the mapping, which releaseMapping drops
     int relocateSharedMemoryAddress(uint64_t& dest_addr, uint64_t length,
-                                    uint64_t target_id);
+                                    uint64_t target_id, uint64_t& remote_base);
 
     const char* getName() const override { return "nvlink"; }
 
    private:
+    // Copies enqueued on one stream, completed together by one event
+    struct PendingCopy {
+        cudaEvent_t event;
+        int device_id;
+        std::vector<Slice*> slices;
+    };
+
+    // Enqueues the copies of the slices and returns without waiting. Slices
+    // are grouped by local device and peer segment; each group goes to one
+    // stream and is completed by the completion thread.
+    void submitSlices(const std::vector<Slice*>& slices);
+
+    // Must be called with `device_id` as the current device
+    cudaStream_t getStream(int device_id, uint64_t target_id);
+
+    cudaEvent_t getEvent(int device_id);
+
+    void retireCopy(PendingCopy& copy, cudaError_t result);
+
+    void completionWorker();
+
+    void* openRemoteMemory(const BufferDesc& entry, uint64_t length);
+
+    void releaseMapping(Slice* slice);
+
     std::atomic_bool running_;
 
-    struct OpenedShmEntry {
-        void* shm_addr;
-        uint64_t length;
-    };
+    std::mutex stream_mutex_;
+    std::unordered_map<int, std::vector<cudaStream_t>> streams_;
+    std::unordered_map<int, std::vector<cudaEvent_t>> free_events_;
+
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::deque<PendingCopy> pending_;
+    std::thread completion_thread_;
 
-    std::unordered_map<std::pair<uint64_t, uint64_t>, OpenedShmEntry, PairHash>
-        remap_entries_;
-    RWSpinlock remap_lock_;
     bool use_fabric_mem_;
+    RemoteMappingCache mappings_;
 
     std::mutex register_mutex_;
 };
@@ -0,0 +1,95 @@
+// Copyright 2025 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BATCH_SIZE_TUNER_H_
+#define BATCH_SIZE_TUNER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace mooncake {
+
+// Picks the number of IOs per cuFile batch from the throughput the device
+// delivers. Small batches complete sooner and keep more of them in flight,
+// while large ones cost fewer submissions and polls. After every window of
+// completed batches the size moves one step (x2 or /2), and turns around
+// when the throughput of the window dropped. Throughput is counted over
+// the time at least one batch was in flight, so idle gaps between
+// transfers do not count against a size.
+class BatchSizeTuner {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    static const int kWindowBatches = 32;
+
+    // Starts at max_size, which is where the first step goes down from
+    BatchSizeTuner(size_t min_size, size_t max_size)
+        : min_size_(std::min(min_size, max_size)),
+          max_size_(max_size),
+          size_(max_size) {}
+
+    size_t batchSize() const { return size_.load(std::memory_order_relaxed); }
+
+    void onSubmit(Clock::time_point now = Clock::now()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (inflight_++ == 0) busy_since_ = now;
+    }
+
+    // All IOs of a batch finished, moving `bytes` in total
+    void onComplete(uint64_t bytes, Clock::time_point now = Clock::now()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bytes_ += bytes;
+        if (inflight_ > 0 && --inflight_ == 0) busy_ += now - busy_since_;
+        if (++batches_ < kWindowBatches) return;
+
+        auto busy = busy_;
+        if (inflight_) busy += now - busy_since_;
+        double seconds = std::chrono::duration<double>(busy).count();
+        if (seconds > 0) {
+            double throughput = bytes_ / seconds;
+            if (throughput < last_throughput_) growing_ = !growing_;
+            last_throughput_ = throughput;
+            size_t size = size_.load(std::memory_order_relaxed);
+            size = growing_ ? std::min(size * 2, max_size_)
+                            : std::max(size / 2, min_size_);
+            size_.store(size, std::memory_order_relaxed);
+        }
+        bytes_ = 0;
+        batches_ = 0;
+        busy_ = Clock::duration::zero();
+        busy_since_ = now;
+    }
+
+   private:
+    const size_t min_size_;
+    const size_t max_size_;
+    std::atomic<size_t> size_;
+
+    std::mutex mutex_;
+    int inflight_ = 0;
+    int batches_ = 0;
+    uint64_t bytes_ = 0;
+    Clock::time_point busy_since_;
+    Clock::duration busy_ = Clock::duration::zero();
+    double last_throughput_ = 0;
+    bool growing_ = false;
+};
+
+}  // namespace mooncake
+
+#endif
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "transfer_engine.h"
+#include "transport/nvmeof_transport/batch_size_tuner.h"
 
 namespace mooncake {
 
@@ -41,19 +42,29 @@ struct CUFileBatchDesc {
     BatchHandle* batch_handle;  // Pointer to reusable handle from pool
     std::vector<CUfileIOParams_t> io_params;
     std::vector<CUfileIOEvents_t> io_events;
+    size_t completed = 0;  // IOs returned by pollBatch
+    uint64_t bytes = 0;    // bytes moved by the completed IOs
 };
 
 class CUFileDescPool {
    public:
-    explicit CUFileDescPool(size_t max_batch_size = 128);
+    // At most max_inflight descriptors are allocated at a time, each
+    // holding up to max_batch_size IOs
+    explicit CUFileDescPool(size_t max_batch_size = 128,
+                            size_t max_inflight = MAX_NR_DESC);
     ~CUFileDescPool();
 
     CUFileDescPool(const CUFileDescPool&) = delete;
     CUFileDescPool& operator=(const CUFileDescPool&) = delete;
     CUFileDescPool(CUFileDescPool&&) = delete;
 
+    // Number of IOs the next batch should hold, tuned on the throughput
+    // of the completed batches
+    size_t batchSize() const { return tuner_.batchSize(); }
+
     // Allocate a new batch descriptor with independent io_params/io_events
-    // Returns descriptor index, or -1 on failure
+    // Returns descriptor index, or -1 if max_inflight descriptors are in
+    // use; the caller keeps its IOs queued and retries later
     int allocCUfileDesc(size_t batch_size);
 
     // Add params to the descriptor
@@ -62,8 +73,9 @@ class CUFileDescPool {
     // Submit the batch
     int submitBatch(int idx);
 
-    // Get transfer status for a specific slice
-    CUfileIOEvents_t getTransferStatus(int idx, int slice_id);
+    // Appends the events of the IOs that finished since the last call.
+    // Returns the number of IOs still in flight, or -1 on error
+    int pollBatch(int idx, std::vector<CUfileIOEvents_t>& events);
 
     // Get current number of slices in the descriptor
     int getSliceNum(int idx);
@@ -76,7 +88,10 @@ class CUFileDescPool {
 
    private:
     static const size_t MAX_NR_DESC = 256;  // Max number of descriptors
+    static const size_t MIN_BATCH_SIZE = 4;
     size_t max_batch_size_;
+    size_t max_inflight_;
+    BatchSizeTuner tuner_;
 
     // Object pool for BatchHandle to avoid frequent cuFileBatchIOSetUp/Destroy
     std::vector<BatchHandle*> handle_pool_;
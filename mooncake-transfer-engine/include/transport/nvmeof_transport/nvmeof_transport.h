@@ -18,10 +18,14 @@
 #include <bits/stdint-uintn.h>
 
 #include <cstddef>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "cufile_context.h"
 #include "cufile_desc_pool.h"
@@ -30,10 +34,13 @@
 
 namespace mooncake {
 
+// The IOs of a batch are spread over several cuFile batches, which are in
+// flight at the same time. IOs wait in `pending` while no cuFile batch
+// descriptor is free, and are submitted as polling frees descriptors.
 struct NVMeoFBatchDesc {
-    int desc_idx_;
-    std::vector<TransferStatus> transfer_status;
-    std::vector<std::tuple<size_t, uint64_t>> task_to_slices;
+    std::mutex mutex;  // serializes progress()
+    std::vector<int> inflight;  // descriptors submitted to cuFile
+    std::deque<CUfileIOParams_t> pending;
 };
 
 class NVMeoFTransport : public Transport {
@@ -55,13 +62,17 @@ class NVMeoFTransport : public Transport {
 
     Status freeBatchID(BatchID batch_id) override;
 
-    void addSliceToTask(void *source_addr, uint64_t slice_len,
-                        uint64_t target_start, TransferRequest::OpCode op,
-                        TransferTask &task, const char *file_path);
+    Slice *addSliceToTask(void *source_addr, uint64_t slice_len,
+                          uint64_t target_start, TransferRequest::OpCode op,
+                          TransferTask &task, const char *file_path);
 
    private:
     void startTransfer(Slice *slice);
 
+    // Retires the finished IOs of the batch, then submits queued IOs while
+    // descriptors are free
+    void progress(NVMeoFBatchDesc &nvmeof_desc);
+
    private:
     struct pair_hash {
         template <class T1, class T2>
@@ -94,9 +105,8 @@ class NVMeoFTransport : public Transport {
         return 0;
     }
 
-    void addSliceToCUFileBatch(void *source_addr, uint64_t file_offset,
-                               uint64_t slice_len, uint64_t desc_id,
-                               TransferRequest::OpCode op, CUfileHandle_t fh);
+    void addSliceToCUFileBatch(Slice *slice, CUfileHandle_t fh,
+                               NVMeoFBatchDesc &nvmeof_desc);
 
     const char *getName() const override { return "nvmeof"; }
 
@@ -50,6 +50,10 @@ class EndpointStore {
 
     // Get the total number of QPs across all endpoints
     virtual size_t getTotalQPNumber() = 0;
+
+    // Get the total number of outstanding work requests across all
+    // endpoints, including those waiting to be reclaimed
+    virtual size_t getTotalWrDepth() = 0;
 };
 
 // FIFO
@@ -70,6 +74,8 @@ class FIFOEndpointStore : public EndpointStore {
 
     size_t getTotalQPNumber() override;
 
+    size_t getTotalWrDepth() override;
+
    private:
     RWSpinlock endpoint_map_lock_;
     std::unordered_map<std::string, std::shared_ptr<RdmaEndPoint>>
@@ -101,6 +107,8 @@ class SIEVEEndpointStore : public EndpointStore {
 
     size_t getTotalQPNumber() override;
 
+    size_t getTotalWrDepth() override;
+
    private:
     RWSpinlock endpoint_map_lock_;
     // The bool represents visited
@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -32,6 +33,8 @@
 #include "rdma_transport.h"
 #include "transport/transport.h"
 
+struct mlx5dv_qp_ex;
+
 namespace mooncake {
 
 class RdmaEndPoint;
@@ -47,11 +50,40 @@ enum class GidNetworkState {
 };
 
 struct RdmaCq {
-    RdmaCq() : native(nullptr), outstanding(0) {}
+    RdmaCq() : native(nullptr), channel(nullptr), outstanding(0) {}
     ibv_cq *native;
+    ibv_comp_channel *channel;
     volatile int outstanding;
 };
 
+// Access key DC targets check on the work requests of DC initiators
+const static uint64_t kDcAccessKey = 0x4d6f6f6e63616b65ull;
+
+// DC initiator, a send QP able to reach any DC target, shared by the
+// endpoints of the context
+struct DcInitiator {
+    ibv_qp *qp = nullptr;
+    ibv_qp_ex *qpx = nullptr;
+    mlx5dv_qp_ex *dv_qpx = nullptr;
+    RWSpinlock lock;
+    volatile int wr_depth = 0;
+    volatile int *cq_outstanding = nullptr;
+    // Set once a work request failed, which moves the QP to the error
+    // state, cleared when the monitor brings it back
+    std::atomic<bool> failed{false};
+};
+
+// Work requests of notifications are told from those of slices, which
+// are 64-byte aligned, by the low bits of their wr_id
+const static uint64_t kNotifySendTag = 1;
+const static uint64_t kNotifyRecvTag = 2;
+const static uint64_t kNotifyTagMask = 3;
+
+// Buffers of each context for sending notifications, and as many for
+// receiving them
+const static int kNotifyBufferCount = 256;
+const static size_t kNotifyBufferSize = 4096;
+
 struct MemoryRegionMeta {
     // mr->addr is not set to starting address for iova based mr. Therefore we
     // track it ourselves.
@@ -86,10 +118,39 @@ class RdmaContext {
 
     uint32_t lkey(void *addr);
 
+    // Whether host memory is covered by the implicit ODP memory region, so
+    // that registering it costs nothing
+    bool odpEnabled() const { return implicit_mr_ != nullptr; }
+
    private:
     int registerMemoryRegionInternal(void *addr, size_t length, int access,
                                      MemoryRegionMeta &mrMeta);
 
+    // Registers the whole address space as one on-demand paging memory
+    // region, if the device supports it for RC
+    void registerImplicitMemoryRegion();
+
+    // Creates the DC target serving the peers and the DC initiators
+    // reaching them, if the device supports it
+    void setupDcTransport();
+
+    int setupDcInitiator(DcInitiator &dci);
+
+    int resetDcInitiator(DcInitiator &dci);
+
+    void destroyDcTransport();
+
+    // Creates the shared receive queue the RC QPs of the context take
+    // notifications from, along with the buffers they are sent from and
+    // received into
+    void setupNotify();
+
+    void destroyNotify();
+
+    int postNotifyRecv(int index);
+
+    bool isHostMemory(void *addr);
+
    public:
     bool active() const { return active_; }
 
@@ -99,6 +160,10 @@ class RdmaContext {
     // EndPoint Management
     std::shared_ptr<RdmaEndPoint> endpoint(const std::string &peer_nic_path);
 
+    // The endpoint to the peer NIC if there is one, without creating it
+    std::shared_ptr<RdmaEndPoint> findEndpoint(
+        const std::string &peer_nic_path);
+
     int deleteEndpoint(const std::string &peer_nic_path);
 
     int disconnectAllEndpoints();
@@ -106,6 +171,44 @@ class RdmaContext {
     // Get the total number of QPs across all endpoints in this context
     size_t getTotalQPNumber() const;
 
+    // Get the total number of outstanding work requests in this context
+    size_t getTotalWrDepth() const;
+
+   public:
+    // DC transport, see setupDcTransport()
+    bool dcEnabled() const { return dct_ != nullptr; }
+
+    // Number of the DC target, 0 if DC is not enabled
+    uint32_t dctNum() const { return dct_ ? dct_->qp_num : 0; }
+
+    // Picks a DC initiator not in the error state, nullptr if none
+    DcInitiator *selectDcInitiator();
+
+    // Marks the DC initiator the work request was posted to as failed
+    void failDcInitiator(volatile int *qp_depth);
+
+    // Returns true if qp is a DC QP of this context, marking it failed
+    bool failDcQp(ibv_qp *qp);
+
+    // Brings failed DC initiators back once their work requests flushed
+    void recoverDcInitiators();
+
+   public:
+    // Notifications over RC QPs, see setupNotify()
+    bool notifyEnabled() const { return notify_srq_ != nullptr; }
+
+    ibv_srq *notifySrq() const { return notify_srq_; }
+
+    // Sends the notification to the server through the endpoint, which
+    // must be connected by RC to a peer taking notifications. Nonzero if it
+    // cannot.
+    int postNotify(RdmaEndPoint &endpoint, const std::string &peer_server_name,
+                   const TransferMetadata::NotifyDesc &notify);
+
+    // Handles the completion of a notification WR. Returns the number of
+    // completions to take off the outstanding count of the CQ.
+    int completeNotify(const ibv_wc &wc);
+
    public:
     // Device name, such as `mlx5_3`
     std::string deviceName() const { return device_name_; }
@@ -148,8 +251,31 @@ class RdmaContext {
 
     int poll(int num_entries, ibv_wc *wc, int cq_index = 0);
 
+    // Completion channel the CQ reports its events to
+    ibv_comp_channel *cqChannel(int cq_index) const {
+        return cq_list_[cq_index].channel;
+    }
+
+    // Index of a CQ of this context, -1 if not found
+    int cqIndex(ibv_cq *cq) const;
+
+    // Requests an event on the channel of the CQ for its next completion
+    int armCq(int cq_index);
+
     int socketId();
 
+    // Accounts the bytes of the slices the NIC completed, measuring its
+    // throughput over the periods it is kept busy
+    void recordCompletion(uint64_t bytes);
+
+    // Measured throughput in bytes per second, 0 until first measured
+    uint64_t throughput() const {
+        return throughput_.load(std::memory_order_relaxed);
+    }
+
+    // Bytes submitted to the NIC and not completed yet
+    uint64_t outstandingBytes() const;
+
    private:
     int openRdmaDevice(const std::string &device_name, uint8_t port,
                        int gid_index);
@@ -164,6 +290,10 @@ class RdmaContext {
    public:
     int submitPostSend(const std::vector<Transport::Slice *> &slice_list);
 
+    // Posts a single slice from the calling thread, see
+    // WorkerPool::postSendDirect()
+    void postSendDirect(Transport::Slice *slice);
+
    private:
     const std::string device_name_;
     RdmaTransport &engine_;
@@ -185,8 +315,28 @@ class RdmaContext {
 
     RWSpinlock memory_regions_lock_;
     std::vector<struct MemoryRegionMeta> memory_region_list_;
+    ibv_mr *implicit_mr_ = nullptr;
     std::vector<RdmaCq> cq_list_;
 
+    ibv_srq *notify_srq_ = nullptr;
+    ibv_mr *notify_mr_ = nullptr;
+    // Send buffers come first, then receive buffers
+    char *notify_region_ = nullptr;
+    std::mutex notify_mutex_;
+    std::vector<int> free_notify_buffers_;
+    // A send buffer in use: the depth counter of the QP it was posted to,
+    // and what to resend by RPC if the SEND fails
+    struct NotifySend {
+        volatile int *qp_depth = nullptr;
+        uint32_t length = 0;
+        std::string peer_server_name;
+    };
+    std::vector<NotifySend> notify_send_;
+
+    ibv_srq *dc_srq_ = nullptr;
+    ibv_qp *dct_ = nullptr;
+    std::vector<std::unique_ptr<DcInitiator>> dci_list_;
+
     std::shared_ptr<EndpointStore> endpoint_store_;
 
     std::vector<std::thread> background_thread_;
@@ -199,6 +349,12 @@ class RdmaContext {
     std::shared_ptr<WorkerPool> worker_pool_;
 
     volatile bool active_;
+
+    std::mutex throughput_mutex_;
+    int64_t throughput_window_start_ = 0;
+    int64_t throughput_window_bytes_ = 0;
+    int64_t last_completion_ts_ = 0;
+    std::atomic<uint64_t> throughput_{0};
 };
 
 }  // namespace mooncake
@@ -36,6 +36,11 @@ namespace mooncake {
 // If the user initiates a disconnect() call or an error is detected internally,
 // the connection is closed and the RdmaEndPoint state is set to UNCONNECTED.
 // The handshake can be restarted at this point.
+//
+// When the context runs the DC transport, an endpoint owns no QP: it only
+// holds the address of the DC target of the peer NIC, taken from the segment
+// descriptor without a handshake, and posts through the DC initiators of the
+// context. QPs are then created only for peers serving no DC target.
 class RdmaEndPoint {
    public:
     enum Status {
@@ -69,6 +74,14 @@ class RdmaEndPoint {
     int setupConnectionsByPassive(const HandShakeDesc &peer_desc,
                                   HandShakeDesc &local_desc);
 
+    // The two halves of setupConnectionsByActive(), for handshakes sent by
+    // the caller, such as in batches: fills the handshake to send, then
+    // connects from the reply of the peer
+    void prepareHandshake(HandShakeDesc &local_desc) const;
+
+    int setupConnectionsByActive(const HandShakeDesc &local_desc,
+                                 const HandShakeDesc &peer_desc);
+
     bool hasOutstandingSlice() const;
 
     bool active() const { return active_; }
@@ -100,6 +113,19 @@ class RdmaEndPoint {
    private:
     void disconnectUnlocked();
 
+    int createQPs();
+
+    // Returns 0 once connected to the DC target of the peer NIC, 1 if the
+    // peer NIC serves none
+    int setupDcConnection();
+
+    int submitPostSendDc(std::vector<Transport::Slice *> &slice_list,
+                         std::vector<Transport::Slice *> &failed_slice_list,
+                         size_t max_wr_count);
+
+    int completeActiveSetup(const HandShakeDesc &local_desc,
+                            const HandShakeDesc &peer_desc);
+
    public:
     const std::string toString() const;
 
@@ -107,12 +133,24 @@ class RdmaEndPoint {
     // Submit some work requests to HW
     // Submitted tasks (success/failed) are removed in slice_list
     // Failed tasks (which must be submitted) are inserted in failed_slice_list
+    // At most max_wr_count slices from the front of slice_list are posted
     int submitPostSend(std::vector<Transport::Slice *> &slice_list,
-                       std::vector<Transport::Slice *> &failed_slice_list);
+                       std::vector<Transport::Slice *> &failed_slice_list,
+                       size_t max_wr_count = SIZE_MAX);
+
+    // Posts a signaled SEND of the registered buffer, for the shared receive
+    // queue of the peer NIC. qp_depth is set to the depth counter of the QP
+    // used, to release on completion. Fails unless connected by RC to a
+    // peer taking notifications, or if the QP is full.
+    int postSend(uint64_t wr_id, void *addr, uint32_t length, uint32_t lkey,
+                 volatile int *&qp_depth);
 
     // Get the number of QPs in this endpoint
     size_t getQPNumber() const;
 
+    // Get the number of work requests posted and not yet completed
+    size_t getWrDepth() const;
+
    private:
     std::vector<uint32_t> qpNum() const;
 
@@ -133,10 +171,20 @@ class RdmaEndPoint {
 
     std::string peer_nic_path_;
 
+    ibv_cq *cq_;
+    size_t num_qp_list_;
+    size_t max_sge_per_wr_;
+    size_t max_inline_bytes_;
+
     volatile int *wr_depth_list_;
     int max_wr_depth_;
 
+    ibv_ah *dc_ah_;
+    uint32_t dc_peer_dctn_;
+
     volatile bool active_;
+    // Whether the peer takes notifications, see postSend()
+    bool peer_notify_recv_;
     volatile int *cq_outstanding_;
     volatile uint64_t inactive_time_;
 };
@@ -103,6 +103,21 @@ class RdmaTransport : public Transport {
 
     int preTouchMemory(void *addr, size_t length);
 
+    // The size of the slices a request of this length is cut into, when
+    // its source is on device_id (-1 if not on a single device)
+    size_t sliceSize(size_t length, int device_id) const;
+
+    // Submits an atomic or inline write as one slice, posted right away
+    Status postSmallRequest(TransferTask &task,
+                            SegmentDesc *local_segment_desc);
+
+    // Among the active devices serving the local buffer, the one expected
+    // to drain the bytes queued on it first, with pending_bytes[i] more
+    // bytes about to be submitted to device i. -1 if none is active.
+    int selectLeastLoadedDevice(
+        SegmentDesc *desc, int buffer_id,
+        const std::vector<uint64_t> &pending_bytes) const;
+
    public:
     int onSetupRdmaConnections(const HandShakeDesc &peer_desc,
                                HandShakeDesc &local_desc);
@@ -120,8 +135,21 @@ class RdmaTransport : public Transport {
     int startHandshakeDaemon(std::string &local_server_name);
 
    public:
+    int warmupSegment(SegmentID target_id) override;
+
+    int sendNotify(SegmentID target_id, const NotifyDesc &notify) override;
+
+    // Submits slices queued on a local device that can no longer send them
+    // through the least loaded active devices instead. The slices left in
+    // slice_list found no other device.
+    void failoverSlices(RdmaContext &from, std::vector<Slice *> &slice_list);
+
     static int selectDevice(SegmentDesc *desc, uint64_t offset, size_t length,
                             int &buffer_id, int &device_id, int retry_cnt = 0);
+
+    const std::vector<std::shared_ptr<RdmaContext>> &contextList() const {
+        return context_list_;
+    }
     static int selectDevice(SegmentDesc *desc, uint64_t offset, size_t length,
                             std::string_view hint, int &buffer_id,
                             int &device_id, int retry_cnt = 0);
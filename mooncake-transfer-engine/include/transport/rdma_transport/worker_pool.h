@@ -15,9 +15,12 @@
 #ifndef WORKER_H
 #define WORKER_H
 
+#include <array>
 #include <queue>
 #include <unordered_set>
 
+#include "common/bounded_mpsc_ring.h"
+#include "transfer_latency_metrics.h"
 #include "rdma_context.h"
 
 namespace mooncake {
@@ -30,13 +33,41 @@ class WorkerPool {
     // Add slices to queue, called by Transport
     int submitPostSend(const std::vector<Transport::Slice *> &slice_list);
 
+    // Posts the slice on its endpoint from the calling thread, leaving only
+    // its completion to the workers. Slices whose endpoint is not connected
+    // yet or has no free WR slot are submitted to the workers instead.
+    void postSendDirect(Transport::Slice *slice);
+
+    // Bytes of the slices submitted and not completed yet
+    uint64_t outstandingBytes() const {
+        return outstanding_bytes_.load(std::memory_order_relaxed);
+    }
+
    private:
-    void performPostSend(int thread_id);
+    // Both return the amount of work done, 0 if there was nothing to do
+    int performPostSend(int thread_id);
+
+    int performPollCq(int thread_id);
+
+    // Records the post to completion latency of a slice completed at now_ns
+    void recordLatency(const Transport::Slice *slice, int64_t now_ns);
+
+    // Sleeps until a completion arrives on a CQ of the worker, slices are
+    // submitted to it, or some time passes. Returns whether it found work
+    // to do instead of sleeping.
+    bool waitForCompletion(int thread_id);
 
-    void performPollCq(int thread_id);
+    void wakeUp(int thread_id);
+
+    // Logs the CPU utilization of each worker since the last report
+    void reportUtilization();
 
     void redispatch(std::vector<Transport::Slice *> &slice_list, int thread_id);
 
+    // Moves the slices queued by the worker to other devices, as the one
+    // of the pool is inactive. Returns how many were moved.
+    int failover(int thread_id);
+
     void transferWorker(int thread_id);
 
     void monitorWorker();
@@ -58,17 +89,45 @@ class WorkerPool {
 
     using SliceList = std::vector<Transport::Slice *>;
 
-    const static int kShardCount = 8;
-    std::unordered_map<std::string, SliceList> slice_queue_[kShardCount];
-    std::atomic<uint64_t> slice_queue_count_[kShardCount];
-    TicketLock slice_queue_lock_[kShardCount];
+    // Submitted slices, one ring per worker. All slices of a peer NIC go
+    // through the same ring.
+    std::vector<std::unique_ptr<BoundedMpscRing<Transport::Slice *>>>
+        slice_ring_;
 
-    std::vector<std::unordered_map<std::string, SliceList>>
-        collective_slice_queue_;
+    // Slices waiting to be posted by a worker, one map per priority class
+    // of TransferRequest, each grouping them by peer NIC, see endpointKey()
+    using SliceQueue =
+        std::array<std::unordered_map<uint64_t, SliceList>,
+                   Transport::TransferRequest::kPriorityCount>;
+    std::vector<SliceQueue> collective_slice_queue_;
+
+    // Where the worker queues the slice to post it
+    SliceList &sliceQueue(int thread_id, Transport::Slice *slice);
 
     std::atomic<uint64_t> submitted_slice_count_, processed_slice_count_;
+    std::atomic<uint64_t> outstanding_bytes_;
+
+    // When the device went down, 0 once its slices are failed over
+    std::atomic<int64_t> inactive_ts_{0};
+    std::atomic<uint64_t> failover_slice_count_{0};
+
+    struct WorkerState {
+        // Written to wake the worker up from waitForCompletion()
+        int wakeup_fd = -1;
+        // kRunning, or what the worker sleeps on
+        std::atomic<int> waiting{0};
+        std::atomic<uint64_t> sleep_count{0};
+        // Used by reportUtilization() only
+        uint64_t last_cpu_ts = 0;
+        uint64_t last_sleep_count = 0;
+    };
+    enum { kRunning = 0, kWaitOwnCq = 1, kWaitAnyCq = 2 };
+    std::unique_ptr<WorkerState[]> worker_state_;
+    uint64_t last_report_ts_ = 0;
 
     uint64_t success_nr_polls = 0, failed_nr_polls = 0;
+
+    LatencyHistogram *nic_latency_ = nullptr;
 };
 }  // namespace mooncake
 
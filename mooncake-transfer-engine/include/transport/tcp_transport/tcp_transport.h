@@ -35,6 +35,7 @@
 namespace mooncake {
 class TransferMetadata;
 class TcpContext;
+class TcpConnection;
 
 class TcpTransport : public Transport {
    public:
@@ -80,14 +81,29 @@ class TcpTransport : public Transport {
 
     void worker();
 
+    // Slices the request into stripes of tcp_stripe_size, each going to
+    // the peer address at its own offset, and starts them all
+    void submitSlices(TransferTask &task, const TransferRequest &request);
+
     void startTransfer(Slice *slice);
 
+    // A pooled connection to the peer, connecting a new one while the pool
+    // is not full, or nullptr if none can be made
+    std::shared_ptr<TcpConnection> getConnection(const std::string &host,
+                                                 int port);
+
     const char *getName() const override { return "tcp"; }
 
    private:
     TcpContext *context_;
     std::atomic_bool running_;
-    std::thread thread_;
+    std::vector<std::thread> threads_;
+
+    std::mutex connections_mutex_;
+    // Connections by peer "host:port"
+    std::unordered_map<std::string,
+                       std::vector<std::shared_ptr<TcpConnection>>>
+        connections_;
 };
 }  // namespace mooncake
 
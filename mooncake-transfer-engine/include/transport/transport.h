@@ -26,6 +26,7 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <vector>
 #include <atomic>
 #include <functional>
 #include <mutex>
@@ -56,7 +57,12 @@ class Transport {
     using NotifyDesc = TransferMetadata::NotifyDesc;
 
     struct TransferRequest {
-        enum OpCode { READ, WRITE };
+        // FETCH_ADD and COMPARE_SWAP are 8-byte RDMA atomics on the target
+        // word, returning its former value into source
+        enum OpCode { READ, WRITE, FETCH_ADD, COMPARE_SWAP };
+        // Classes RdmaTransport queues apart and serves in this order, see
+        // GlobalConfig::rdma_strict_priority
+        enum Priority : uint8_t { LATENCY, NORMAL, BULK, kPriorityCount };
 
         OpCode opcode;
         void *source;
@@ -64,6 +70,15 @@ class Transport {
         uint64_t target_offset;
         size_t length;
         int advise_retry_cnt = 0;
+        // Value added by FETCH_ADD, or compared with by COMPARE_SWAP
+        uint64_t compare_add = 0;
+        // Value stored by COMPARE_SWAP if the comparison succeeds
+        uint64_t swap = 0;
+        Priority priority = NORMAL;
+
+        bool isAtomic() const {
+            return opcode == FETCH_ADD || opcode == COMPARE_SWAP;
+        }
     };
 
     enum TransferStatusEnum {
@@ -84,6 +99,17 @@ class Transport {
     struct BatchDesc;
     struct TransferTask;
 
+    // Called once with failed set if any task of the batch failed
+    using BatchCompletionCallback =
+        std::function<void(BatchID batch_id, bool failed)>;
+
+    // A thread waiting for any of several batches
+    struct CompletionWaiter {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool notified = false;
+    };
+
     // NOTE ABOUT BatchID → BatchDesc conversion:
     //
     // BatchID is an opaque 64‑bit unsigned integer that carries a
@@ -101,32 +127,49 @@ class Transport {
 
     // Slice must be allocated on heap, as it will delete self on markSuccess
     // or markFailed.
-    struct Slice {
+    //
+    // Fields are ordered by how hot they are: the ones read and written on
+    // completion come first, from the start of a cache line, and the ones
+    // only used to post the slice last.
+    struct alignas(64) Slice {
         enum SliceStatus { PENDING, POSTED, SUCCESS, TIMEOUT, FAILED };
 
-        void *source_addr;
-        size_t length;
-        TransferRequest::OpCode opcode;
-        SegmentID target_id;
-        std::string peer_nic_path;
         SliceStatus status;
+        TransferRequest::OpCode opcode;
         TransferTask *task;
-        std::vector<uint32_t> dest_rkeys;
-        bool from_cache;
+        size_t length;
 
         union {
             struct {
-                uint64_t dest_addr;
+                // Whether the WR of the slice is signaled. A signaled WR
+                // completes the unsignaled_count unsignaled WRs posted
+                // before it: its unsignaled is the first of them, linked
+                // through their own unsignaled.
+                bool signaled;
+                // Status of an unsignaled WR that completed on its own,
+                // which it only does in error
+                int wc_status;
+                uint32_t unsignaled_count;
+                uint32_t retry_cnt;
+                volatile int *qp_depth;
+                Slice *unsignaled;
+                uint32_t max_retry_cnt;
                 uint32_t source_lkey;
+                uint64_t dest_addr;
                 uint32_t dest_rkey;
                 int lkey_index;
                 int rkey_index;
-                volatile int *qp_depth;
-                uint32_t retry_cnt;
-                uint32_t max_retry_cnt;
+                // Index of the peer NIC in the segment descriptor
+                int peer_device_id;
+                // Operands of atomics
+                uint64_t compare_add;
+                uint64_t swap;
             } rdma;
             struct {
                 void *dest_addr;
+                // Allocation of the peer holding dest_addr, for transports
+                // that map it
+                uint64_t remote_base;
             } local;
             struct {
                 uint64_t dest_addr;
@@ -153,6 +196,14 @@ class Transport {
             } ubshmem;
         };
 
+        volatile int64_t ts;
+        void *source_addr;
+        SegmentID target_id;
+        bool from_cache;
+        TransferRequest::Priority priority;
+        std::string peer_nic_path;
+        std::vector<uint32_t> dest_rkeys;
+
        public:
         void markSuccess() {
             status = Slice::SUCCESS;
@@ -170,11 +221,12 @@ class Transport {
             check_batch_completion(true);
         }
 
-        volatile int64_t ts;
-
        private:
+        // Runs after the slice status is published. The task and the batch
+        // may be freed once the slice is counted as settled, so that is the
+        // last access to them and to the slice.
         inline void check_batch_completion(bool is_failed) {
-#ifdef USE_EVENT_DRIVEN_COMPLETION
+            TransferTask *task = this->task;
             auto &batch_desc = toBatchDesc(task->batch_id);
             if (is_failed) {
                 batch_desc.has_failure.store(true, std::memory_order_relaxed);
@@ -188,43 +240,28 @@ class Transport {
 
             // Only the thread completing the final slice will see prev+1 ==
             // slice_count.
+            BatchCompletionCallback callback;
+            bool batch_failed = false;
             if (prev_completed + 1 == task->slice_count) {
                 __atomic_store_n(&task->is_finished, true, __ATOMIC_RELAXED);
 
                 // Increment the number of finished tasks in the batch
                 // (relaxed). This counter does not itself publish data; only
-                // the thread that observes the last task completion performs
-                // the release-store on batch_desc.is_finished below. The waiter
-                // pairs this with an acquire load, which makes all prior writes
-                // (including relaxed increments) visible.
-                //
-                // check if this is the last task in the batch
+                // the thread that observes the last task completion publishes
+                // the completion, see notifyBatchCompletion.
                 auto prev = batch_desc.finished_task_count.fetch_add(
                     1, std::memory_order_relaxed);
 
-                // Last task in the batch: wake up waiting thread directly
+                // Last task in the batch: wake up waiting threads directly
                 if (prev + 1 == batch_desc.batch_size) {
-                    // Publish completion of the entire batch under the same
-                    // mutex used by the waiter to avoid lost notifications.
-                    //
-                    // Keep a release-store because the reader has a fast path
-                    // that may observe completion without taking the mutex. The
-                    // acquire load in that fast path pairs with this release to
-                    // make all prior updates visible. For the predicate checked
-                    // under the mutex, relaxed would suffice since the mutex
-                    // acquire provides the necessary visibility.
-                    {
-                        std::lock_guard<std::mutex> lock(
-                            batch_desc.completion_mutex);
-                        batch_desc.is_finished.store(true,
-                                                     std::memory_order_release);
-                    }
-                    // Notify after releasing the lock to avoid waking threads
-                    // only to block again on the mutex.
-                    batch_desc.completion_cv.notify_all();
+                    batch_failed =
+                        notifyBatchCompletion(batch_desc, callback);
                 }
             }
-#endif
+            BatchID batch_id = task->batch_id;
+            __atomic_fetch_add(&task->settled_slice_count, 1,
+                               __ATOMIC_RELEASE);
+            if (callback) callback(batch_id, batch_failed);
         }
     };
 
@@ -278,11 +315,19 @@ class Transport {
     };
 
     struct TransferTask {
-        volatile uint64_t slice_count = 0;
-        volatile uint64_t success_slice_count = 0;
+        // Updated by the threads completing the slices. They have a cache
+        // line of their own, so that the neighbouring tasks of the batch,
+        // completed by other threads, and the fields below, written while
+        // slices are still being submitted, do not share it.
+        alignas(64) volatile uint64_t success_slice_count = 0;
         volatile uint64_t failed_slice_count = 0;
         volatile uint64_t transferred_bytes = 0;
+        // Slices done, and slices no longer accessing the task or its batch
+        volatile uint64_t completed_slice_count = 0;
+        volatile uint64_t settled_slice_count = 0;
         volatile bool is_finished = false;
+
+        alignas(64) volatile uint64_t slice_count = 0;
         uint64_t total_bytes = 0;
         BatchID batch_id = 0;
 
@@ -290,10 +335,6 @@ class Transport {
         std::chrono::steady_clock::time_point start_time;
 #endif
 
-#ifdef USE_EVENT_DRIVEN_COMPLETION
-        volatile uint64_t completed_slice_count = 0;
-#endif
-
         // record the origin request
 #ifdef USE_ASCEND_HETEROGENEOUS
         // need to modify the request's source address, changing it from an NPU
@@ -323,14 +364,31 @@ class Transport {
             false};  // Completion flag for wait predicate
         std::atomic<uint64_t> finished_transfer_bytes{0};
 
-#ifdef USE_EVENT_DRIVEN_COMPLETION
-        // Event-driven completion: tracks batch progress and notifies waiters
+        // Completion notification: tracks batch progress and notifies
+        // waiters once batch_size tasks are finished
         std::atomic<uint64_t> finished_task_count{0};
 
-        // Synchronization primitives for direct notification
+        // Guards the completion flag and everything notified on completion.
+        // Unlike is_finished, which caches the polled status, the flag is
+        // also set when tasks failed.
         std::mutex completion_mutex;
-        std::condition_variable completion_cv;
-#endif
+        bool completion_notified = false;
+        int completion_fd = -1;  // eventfd, created on demand
+        BatchCompletionCallback completion_callback;
+        std::vector<CompletionWaiter *> completion_waiters;
+
+        // Slice lists of the tasks of a previous use of the batch, kept for
+        // their capacity
+        std::vector<std::vector<Slice *>> spare_slice_lists;
+
+        // Appends count tasks, with the spare slice lists
+        void addTasks(size_t count);
+
+        // Frees the tasks and their slices, for the batch to be reused
+        void reset();
+
+        // Waits for the slices still settling, and closes completion_fd
+        ~BatchDesc();
     };
 
    public:
@@ -363,6 +421,24 @@ class Transport {
 
     std::shared_ptr<TransferMetadata> &meta() { return metadata_; }
 
+    /// @brief Get an eventfd turning readable once the batch is done. It is
+    /// owned by the batch.
+    /// @return The eventfd on success, or a negative error code.
+    static int getBatchCompletionFd(BatchID batch_id);
+
+    /// @brief Register the callback run once the batch is done, by the thread
+    /// completing its last task, or right away if the batch is already done.
+    static Status setBatchCompletionCallback(BatchID batch_id,
+                                             BatchCompletionCallback callback);
+
+    /// @brief Wake up the waiter once the batch is done, or right away if it
+    /// already is. The waiter must be removed before it is destroyed.
+    static void addCompletionWaiter(BatchID batch_id,
+                                    CompletionWaiter *waiter);
+
+    static void removeCompletionWaiter(BatchID batch_id,
+                                       CompletionWaiter *waiter);
+
     struct BufferEntry {
         void *addr;
         size_t length;
@@ -373,6 +449,16 @@ class Transport {
     }
     virtual Status CheckStatus(SegmentID sid) { return Status::OK(); }
 
+    // Sets up the connections to the segment ahead of its first transfer,
+    // for transports that connect lazily
+    virtual int warmupSegment(SegmentID target_id) { return 0; }
+
+    // Sends the notification over the connections of the transport, saving
+    // the RPC. Nonzero if the target cannot be notified this way.
+    virtual int sendNotify(SegmentID target_id, const NotifyDesc &notify) {
+        return ERR_NOT_IMPLEMENTED;
+    }
+
    protected:
     virtual int install(std::string &local_server_name,
                         std::shared_ptr<TransferMetadata> meta,
@@ -386,6 +472,16 @@ class Transport {
 
     static ThreadLocalSliceCache &getSliceCache();
 
+    // Batches are taken from and returned to a process-wide pool, so that a
+    // steady stream of batches does not allocate
+    static BatchDesc *acquireBatchDesc(size_t batch_size);
+    static void releaseBatchDesc(BatchDesc *batch_desc);
+
+    // Publishes the completion of the batch and wakes up its waiters. Moves
+    // the registered callback out, and returns whether the batch failed.
+    static bool notifyBatchCompletion(BatchDesc &batch_desc,
+                                      BatchCompletionCallback &callback);
+
    private:
     virtual int registerLocalMemory(void *addr, size_t length,
                                     const std::string &location,
@@ -160,6 +160,26 @@ void loadGlobalConfig(GlobalConfig &config) {
                 << "Ignore value from environment variable MC_WORKERS_PER_CTX";
     }
 
+    const char *worker_spin_us_env = std::getenv("MC_WORKER_SPIN_US");
+    if (worker_spin_us_env) {
+        long long val = atoll(worker_spin_us_env);
+        if (val >= 0)
+            config.worker_spin_us = val;
+        else
+            LOG(WARNING)
+                << "Ignore value from environment variable MC_WORKER_SPIN_US";
+    }
+
+    const char *worker_yield_us_env = std::getenv("MC_WORKER_YIELD_US");
+    if (worker_yield_us_env) {
+        long long val = atoll(worker_yield_us_env);
+        if (val >= 0)
+            config.worker_yield_us = val;
+        else
+            LOG(WARNING)
+                << "Ignore value from environment variable MC_WORKER_YIELD_US";
+    }
+
     const char *slice_size_env = std::getenv("MC_SLICE_SIZE");
     if (slice_size_env) {
         size_t val = atoi(slice_size_env);
@@ -170,6 +190,26 @@ void loadGlobalConfig(GlobalConfig &config) {
                 << "Ignore value from environment variable MC_SLICE_SIZE";
     }
 
+    const char *signal_interval_env = std::getenv("MC_IB_SIGNAL_INTERVAL");
+    if (signal_interval_env) {
+        size_t val = atoi(signal_interval_env);
+        if (val > 0)
+            config.signal_interval = val;
+        else
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_IB_SIGNAL_INTERVAL";
+    }
+
+    const char *max_slice_size_env = std::getenv("MC_MAX_SLICE_SIZE");
+    if (max_slice_size_env) {
+        long long val = atoll(max_slice_size_env);
+        if (val >= 0)
+            config.max_slice_size = val;
+        else
+            LOG(WARNING)
+                << "Ignore value from environment variable MC_MAX_SLICE_SIZE";
+    }
+
     const char *min_reg_size_env = std::getenv("MC_MIN_REG_SIZE");
     if (min_reg_size_env) {
         size_t val = atoll(min_reg_size_env);
@@ -196,6 +236,23 @@ void loadGlobalConfig(GlobalConfig &config) {
         config.metacache = false;
     }
 
+    const char *metadata_incremental_env =
+        std::getenv("MC_METADATA_INCREMENTAL");
+    if (metadata_incremental_env) {
+        config.metadata_incremental = atoi(metadata_incremental_env) != 0;
+    }
+
+    const char *p2p_gossip_interval_env =
+        std::getenv("MC_P2P_GOSSIP_INTERVAL_MS");
+    if (p2p_gossip_interval_env) {
+        int val = atoi(p2p_gossip_interval_env);
+        if (val >= 0)
+            config.p2p_gossip_interval_ms = val;
+        else
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_P2P_GOSSIP_INTERVAL_MS";
+    }
+
     const char *handshake_listen_backlog =
         std::getenv("MC_HANDSHAKE_LISTEN_BACKLOG");
     if (handshake_listen_backlog) {
@@ -305,6 +362,197 @@ void loadGlobalConfig(GlobalConfig &config) {
         }
     }
 
+    const char *tcp_connections_env =
+        std::getenv("MC_TCP_CONNECTIONS_PER_PEER");
+    if (tcp_connections_env) {
+        int val = atoi(tcp_connections_env);
+        if (val >= 0) {
+            config.tcp_connections_per_peer = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_TCP_CONNECTIONS_PER_PEER";
+        }
+    }
+
+    const char *tcp_stripe_size_env = std::getenv("MC_TCP_STRIPE_SIZE");
+    if (tcp_stripe_size_env) {
+        long long val = atoll(tcp_stripe_size_env);
+        if (val >= 0) {
+            config.tcp_stripe_size = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_TCP_STRIPE_SIZE";
+        }
+    }
+
+    const char *tcp_io_threads_env = std::getenv("MC_TCP_IO_THREADS");
+    if (tcp_io_threads_env) {
+        int val = atoi(tcp_io_threads_env);
+        if (val > 0 && val <= 64) {
+            config.tcp_io_threads = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_TCP_IO_THREADS";
+        }
+    }
+
+    const char *nvlink_streams_env =
+        std::getenv("MC_NVLINK_STREAMS_PER_DEVICE");
+    if (nvlink_streams_env) {
+        int val = atoi(nvlink_streams_env);
+        if (val > 0 && val <= 64) {
+            config.nvlink_streams_per_device = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_NVLINK_STREAMS_PER_DEVICE";
+        }
+    }
+
+    const char *nvlink_mappings_env =
+        std::getenv("MC_NVLINK_MAX_OPEN_MAPPINGS");
+    if (nvlink_mappings_env) {
+        int val = atoi(nvlink_mappings_env);
+        if (val >= 0) {
+            config.nvlink_max_open_mappings = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_NVLINK_MAX_OPEN_MAPPINGS";
+        }
+    }
+
+    const char *cxl_copy_threads_env = std::getenv("MC_CXL_COPY_THREADS");
+    if (cxl_copy_threads_env) {
+        int val = atoi(cxl_copy_threads_env);
+        if (val > 0 && val <= 64) {
+            config.cxl_copy_threads = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_CXL_COPY_THREADS";
+        }
+    }
+
+    const char *cxl_threshold_env =
+        std::getenv("MC_CXL_PARALLEL_COPY_THRESHOLD");
+    if (cxl_threshold_env) {
+        long long val = atoll(cxl_threshold_env);
+        if (val > 0) {
+            config.cxl_parallel_copy_threshold = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_CXL_PARALLEL_COPY_THRESHOLD";
+        }
+    }
+
+    const char *nvmeof_batch_env = std::getenv("MC_NVMEOF_MAX_BATCH_SIZE");
+    if (nvmeof_batch_env) {
+        int val = atoi(nvmeof_batch_env);
+        if (val > 0 && val <= 256) {
+            config.nvmeof_max_batch_size = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_NVMEOF_MAX_BATCH_SIZE";
+        }
+    }
+
+    const char *nvmeof_inflight_env =
+        std::getenv("MC_NVMEOF_MAX_INFLIGHT_BATCHES");
+    if (nvmeof_inflight_env) {
+        int val = atoi(nvmeof_inflight_env);
+        if (val > 0 && val <= 256) {
+            config.nvmeof_max_inflight_batches = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_NVMEOF_MAX_INFLIGHT_BATCHES";
+        }
+    }
+
+    const char *multi_path_threshold_env =
+        std::getenv("MC_MULTI_PATH_THRESHOLD");
+    if (multi_path_threshold_env) {
+        long long val = atoll(multi_path_threshold_env);
+        if (val >= 0) {
+            config.multi_path_threshold = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_MULTI_PATH_THRESHOLD";
+        }
+    }
+
+    const char *multi_path_percent_env =
+        std::getenv("MC_MULTI_PATH_NVLINK_PERCENT");
+    if (multi_path_percent_env) {
+        int val = atoi(multi_path_percent_env);
+        if (val > 0 && val < 100) {
+            config.multi_path_nvlink_percent = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_MULTI_PATH_NVLINK_PERCENT";
+        }
+    }
+
+    const char *transport_fallback_env =
+        std::getenv("MC_TRANSPORT_FALLBACK_MS");
+    if (transport_fallback_env) {
+        int val = atoi(transport_fallback_env);
+        if (val >= 0) {
+            config.transport_fallback_ms = val;
+        } else {
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_TRANSPORT_FALLBACK_MS";
+        }
+    }
+
+    const char *tcp_numa_node_env = std::getenv("MC_TCP_NUMA_NODE");
+    if (tcp_numa_node_env) {
+        config.tcp_numa_node = atoi(tcp_numa_node_env);
+    }
+
+    const char *use_odp_env = std::getenv("MC_IB_ODP");
+    if (use_odp_env) {
+        config.use_odp = atoi(use_odp_env) != 0;
+    }
+
+    const char *rail_load_balance_env = std::getenv("MC_RAIL_LOAD_BALANCE");
+    if (rail_load_balance_env) {
+        config.rail_load_balance = atoi(rail_load_balance_env) != 0;
+    }
+
+    const char *use_dc_env = std::getenv("MC_IB_DC");
+    if (use_dc_env) {
+        config.use_dc = atoi(use_dc_env) != 0;
+    }
+
+    const char *num_dci_per_ctx_env = std::getenv("MC_NUM_DCI_PER_CTX");
+    if (num_dci_per_ctx_env) {
+        int val = atoi(num_dci_per_ctx_env);
+        if (val > 0 && val <= 1024)
+            config.num_dci_per_ctx = val;
+        else
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_NUM_DCI_PER_CTX";
+    }
+
+    const char *rdma_notify_env = std::getenv("MC_RDMA_NOTIFY");
+    if (rdma_notify_env) {
+        config.rdma_notify = atoi(rdma_notify_env) != 0;
+    }
+
+    const char *rdma_strict_priority_env =
+        std::getenv("MC_RDMA_STRICT_PRIORITY");
+    if (rdma_strict_priority_env) {
+        config.rdma_strict_priority = atoi(rdma_strict_priority_env) != 0;
+    }
+
+    const char *rdma_bulk_burst_env = std::getenv("MC_RDMA_BULK_BURST");
+    if (rdma_bulk_burst_env) {
+        int val = atoi(rdma_bulk_burst_env);
+        if (val > 0 && val <= 65536)
+            config.rdma_bulk_burst = val;
+        else
+            LOG(WARNING) << "Ignore value from environment variable "
+                            "MC_RDMA_BULK_BURST";
+    }
+
     const char *endpoint_store_type_env = std::getenv("MC_ENDPOINT_STORE_TYPE");
     if (endpoint_store_type_env) {
         if (strcmp(endpoint_store_type_env, "FIFO") == 0) {
@@ -392,9 +640,41 @@ void dumpGlobalConfig() {
     LOG(INFO) << "max_sge = " << config.max_sge;
     LOG(INFO) << "max_wr = " << config.max_wr;
     LOG(INFO) << "max_inline = " << config.max_inline;
+    LOG(INFO) << "signal_interval = " << config.signal_interval;
     LOG(INFO) << "mtu_length = " << mtuLengthToString(config.mtu_length);
     LOG(INFO) << "parallel_reg_mr = " << config.parallel_reg_mr;
+    LOG(INFO) << "max_slice_size = " << config.max_slice_size;
+    LOG(INFO) << "worker_spin_us = " << config.worker_spin_us;
+    LOG(INFO) << "worker_yield_us = " << config.worker_yield_us;
+    LOG(INFO) << "use_odp = " << config.use_odp;
+    LOG(INFO) << "rail_load_balance = " << config.rail_load_balance;
+    LOG(INFO) << "use_dc = " << config.use_dc;
+    LOG(INFO) << "num_dci_per_ctx = " << config.num_dci_per_ctx;
+    LOG(INFO) << "rdma_notify = " << config.rdma_notify;
+    LOG(INFO) << "rdma_strict_priority = " << config.rdma_strict_priority;
+    LOG(INFO) << "rdma_bulk_burst = " << config.rdma_bulk_burst;
+    LOG(INFO) << "tcp_connections_per_peer = "
+              << config.tcp_connections_per_peer;
+    LOG(INFO) << "tcp_stripe_size = " << config.tcp_stripe_size;
+    LOG(INFO) << "tcp_io_threads = " << config.tcp_io_threads;
+    LOG(INFO) << "tcp_numa_node = " << config.tcp_numa_node;
+    LOG(INFO) << "nvlink_streams_per_device = "
+              << config.nvlink_streams_per_device;
+    LOG(INFO) << "nvlink_max_open_mappings = "
+              << config.nvlink_max_open_mappings;
+    LOG(INFO) << "cxl_copy_threads = " << config.cxl_copy_threads;
+    LOG(INFO) << "cxl_parallel_copy_threshold = "
+              << config.cxl_parallel_copy_threshold;
+    LOG(INFO) << "nvmeof_max_batch_size = " << config.nvmeof_max_batch_size;
+    LOG(INFO) << "nvmeof_max_inflight_batches = "
+              << config.nvmeof_max_inflight_batches;
+    LOG(INFO) << "multi_path_threshold = " << config.multi_path_threshold;
+    LOG(INFO) << "multi_path_nvlink_percent = "
+              << config.multi_path_nvlink_percent;
+    LOG(INFO) << "transport_fallback_ms = " << config.transport_fallback_ms;
     LOG(INFO) << "ib_traffic_class = " << config.ib_traffic_class;
+    LOG(INFO) << "metadata_incremental = " << config.metadata_incremental;
+    LOG(INFO) << "p2p_gossip_interval_ms = " << config.p2p_gossip_interval_ms;
 }
 
 GlobalConfig &globalConfig() {
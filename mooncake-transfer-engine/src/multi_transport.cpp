@@ -56,7 +56,9 @@
 #include "transport/efa_transport/efa_transport.h"
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 
 namespace mooncake {
 MultiTransport::MultiTransport(std::shared_ptr<TransferMetadata> metadata,
@@ -66,12 +68,8 @@ MultiTransport::MultiTransport(std::shared_ptr<TransferMetadata> metadata,
 MultiTransport::~MultiTransport() {}
 
 MultiTransport::BatchID MultiTransport::allocateBatchID(size_t batch_size) {
-    auto batch_desc = new BatchDesc();
+    auto batch_desc = Transport::acquireBatchDesc(batch_size);
     if (!batch_desc) return ERR_MEMORY;
-    batch_desc->id = BatchID(batch_desc);
-    batch_desc->batch_size = batch_size;
-    batch_desc->task_list.reserve(batch_size);
-    batch_desc->context = NULL;
 #ifdef CONFIG_USE_BATCH_DESC_SET
     batch_desc_lock_.lock();
     batch_desc_set_[batch_desc->id] = batch_desc;
@@ -89,7 +87,7 @@ Status MultiTransport::freeBatchID(BatchID batch_id) {
                 "BatchID cannot be freed until all tasks are done");
         }
     }
-    delete &batch_desc;
+    Transport::releaseBatchDesc(&batch_desc);
 #ifdef CONFIG_USE_BATCH_DESC_SET
     RWSpinlock::WriteGuard guard(batch_desc_lock_);
     batch_desc_set_.erase(batch_id);
@@ -106,27 +104,68 @@ Status MultiTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
 
-    std::unordered_map<Transport *, std::vector<Transport::TransferTask *> >
+#ifdef USE_RDMA_ONLY
+    // Every request goes to the RDMA transport, and without TCP or NVLink
+    // there is neither fallback nor multi-path. The qualified call skips
+    // the virtual dispatch.
+    thread_local std::vector<Transport::TransferTask *> rdma_tasks;
+    rdma_tasks.clear();
+    for (auto &request : entries) {
+        Transport *transport = nullptr;
+        auto status = selectTransport(request, transport);
+        if (!status.ok()) return status;
+        auto &task = batch_desc.task_list[task_id++];
+        task.batch_id = batch_id;
+        task.request = &request;
+        rdma_tasks.push_back(&task);
+    }
+    return rdma_transport_->RdmaTransport::submitTransferTask(rdma_tasks);
+#else
+    // Tasks per transport, kept across calls so that submitting does not
+    // allocate once they have grown
+    thread_local std::vector<
+        std::pair<Transport *, std::vector<Transport::TransferTask *> > >
         submit_tasks;
+    for (auto &entry : submit_tasks) entry.second.clear();
+    Status overall_status = Status::OK();
     for (auto &request : entries) {
         Transport *transport = nullptr;
         auto status = selectTransport(request, transport);
         if (!status.ok()) return status;
         assert(transport);
+        if (request.isAtomic() && transport != rdma_transport_)
+            return Status::InvalidArgument(
+                std::string("Atomics not supported by transport ") +
+                transport->getName());
+        if (fallback_count_.load(std::memory_order_relaxed) &&
+            fallsBack(request, transport))
+            transport = getTransport("tcp");
         auto &task = batch_desc.task_list[task_id];
         task.batch_id = batch_id;
+        if (isMultiPath(request, transport)) {
+            ++task_id;
+            auto status = submitMultiPath(task, request, transport);
+            if (!status.ok()) overall_status = status;
+            continue;
+        }
 #ifdef USE_ASCEND_HETEROGENEOUS
         task.request = const_cast<Transport::TransferRequest *>(&request);
 #else
         task.request = &request;
 #endif
         ++task_id;
-        submit_tasks[transport].push_back(&task);
+        auto it = std::find_if(submit_tasks.begin(), submit_tasks.end(),
+                               [transport](const auto &entry) {
+                                   return entry.first == transport;
+                               });
+        if (it == submit_tasks.end())
+            it = submit_tasks.insert(submit_tasks.end(), {transport, {}});
+        it->second.push_back(&task);
     }
-    Status overall_status = Status::OK();
     for (auto &entry : submit_tasks) {
+        if (entry.second.empty()) continue;
         auto status = entry.first->submitTransferTask(entry.second);
         if (!status.ok()) {
             // LOG(ERROR) << "Failed to submit transfer task to "
@@ -135,6 +174,124 @@ Status MultiTransport::submitTransfer(
         }
     }
     return overall_status;
+#endif  // USE_RDMA_ONLY
+}
+
+bool MultiTransport::isMultiPath(const TransferRequest &request,
+                                 Transport *transport) {
+    const size_t threshold = globalConfig().multi_path_threshold;
+    if (!threshold || request.length < threshold || request.isAtomic() ||
+        transport != rdma_transport_)
+        return false;
+    if (!getTransport("nvlink")) return false;
+    auto desc = metadata_->getSegmentDescByID(request.target_id);
+    if (!desc) return false;
+    // Each transport registers a buffer of its own, both must cover the
+    // target range
+    bool rdma = false, nvlink = false;
+    const uint64_t addr = request.target_offset;
+    for (auto &buffer : desc->buffers) {
+        if (addr < buffer.addr ||
+            addr + request.length > buffer.addr + buffer.length)
+            continue;
+        if (!buffer.rkey.empty()) rdma = true;
+        if (!buffer.shm_name.empty()) nvlink = true;
+    }
+    return rdma && nvlink;
+}
+
+Status MultiTransport::submitMultiPath(Transport::TransferTask &task,
+                                       const TransferRequest &request,
+                                       Transport *transport) {
+    const size_t kAlignment = 4096;
+    size_t nvlink_length = request.length *
+                           globalConfig().multi_path_nvlink_percent / 100 /
+                           kAlignment * kAlignment;
+    if (!nvlink_length || nvlink_length >= request.length) {
+#ifdef USE_ASCEND_HETEROGENEOUS
+        task.request = const_cast<Transport::TransferRequest *>(&request);
+#else
+        task.request = &request;
+#endif
+        return transport->submitTransferTask({&task});
+    }
+
+    // Holds the task open until both parts are submitted, the first part
+    // could otherwise complete it alone
+    auto guard = Transport::getSliceCache().allocate();
+    guard->length = 0;
+    guard->opcode = request.opcode;
+    guard->task = &task;
+    guard->target_id = request.target_id;
+    guard->ts = 0;
+    guard->status = Transport::Slice::PENDING;
+    task.slice_list.push_back(guard);
+    __sync_fetch_and_add(&task.slice_count, 1);
+
+    // Transports copy what they need from the request while submitting,
+    // so the parts can live on the stack
+    TransferRequest nvlink_part = request;
+    nvlink_part.length = nvlink_length;
+    TransferRequest rdma_part = request;
+    rdma_part.source = (char *)request.source + nvlink_length;
+    rdma_part.target_offset = request.target_offset + nvlink_length;
+    rdma_part.length = request.length - nvlink_length;
+
+    Status status = Status::OK();
+    task.request = &nvlink_part;
+    auto nvlink_status = getTransport("nvlink")->submitTransferTask({&task});
+    if (!nvlink_status.ok()) status = nvlink_status;
+    task.request = &rdma_part;
+    auto rdma_status = transport->submitTransferTask({&task});
+    if (!rdma_status.ok()) status = rdma_status;
+#ifdef USE_ASCEND_HETEROGENEOUS
+    task.request = const_cast<Transport::TransferRequest *>(&request);
+#else
+    task.request = &request;
+#endif
+    task.total_bytes = request.length;
+    if (status.ok())
+        guard->markSuccess();
+    else
+        guard->markFailed();
+    return status;
+}
+
+bool MultiTransport::fallsBack(const TransferRequest &request,
+                               Transport *transport) {
+    if (request.isAtomic() || transport != rdma_transport_) return false;
+    RWSpinlock::ReadGuard guard(fallback_lock_);
+    auto it = fallback_peers_.find(request.target_id);
+    // Past the deadline, requests probe RDMA again
+    return it != fallback_peers_.end() && getCurrentTimeInNano() < it->second;
+}
+
+void MultiTransport::updateFallback(Transport::SegmentID target_id,
+                                    bool failed) {
+    const int64_t interval = globalConfig().transport_fallback_ms;
+    if (!interval || !getTransport("rdma") || !getTransport("tcp")) return;
+    auto now = getCurrentTimeInNano();
+    if (failed) {
+        auto desc = metadata_->getSegmentDescByID(target_id);
+        // The peer must listen for TCP transfers too
+        if (!desc || desc->protocol != "rdma" || !desc->tcp_data_port)
+            return;
+        RWSpinlock::WriteGuard guard(fallback_lock_);
+        auto &deadline = fallback_peers_[target_id];
+        // Failures of requests already sent over TCP do not count
+        if (deadline && now < deadline) return;
+        if (!deadline) fallback_count_.fetch_add(1, std::memory_order_relaxed);
+        deadline = now + interval * 1000000;
+        LOG(WARNING) << "RDMA transfers to segment " << target_id
+                     << " failed, using TCP for " << interval << " ms";
+        return;
+    }
+    RWSpinlock::WriteGuard guard(fallback_lock_);
+    auto it = fallback_peers_.find(target_id);
+    if (it == fallback_peers_.end() || now < it->second) return;
+    fallback_peers_.erase(it);
+    fallback_count_.fetch_sub(1, std::memory_order_relaxed);
+    LOG(INFO) << "RDMA transfers to segment " << target_id << " recovered";
 }
 
 Status MultiTransport::getTransferStatus(BatchID batch_id, size_t task_id,
@@ -155,6 +312,10 @@ Status MultiTransport::getTransferStatus(BatchID batch_id, size_t task_id,
         } else {
             status.s = Transport::TransferStatusEnum::COMPLETED;
         }
+        if (task.request &&
+            (failed_slice_count ||
+             fallback_count_.load(std::memory_order_relaxed)))
+            updateFallback(task.request->target_id, failed_slice_count != 0);
         task.is_finished = true;
     } else {
         if (globalConfig().slice_timeout > 0) {
@@ -222,6 +383,46 @@ Status MultiTransport::getBatchTransferStatus(BatchID batch_id,
     return Status::OK();
 }
 
+Status MultiTransport::waitAnyBatch(const std::vector<BatchID> &batch_ids,
+                                    size_t &index, int64_t timeout_ms) {
+    // Transports not completing their slices through markSuccess() and
+    // markFailed() never notify, their batches are polled at this interval
+    const auto kRecheckInterval = std::chrono::milliseconds(10);
+    index = batch_ids.size();
+    if (batch_ids.empty())
+        return Status::InvalidArgument("No batch to wait for");
+
+    Transport::CompletionWaiter waiter;
+    for (auto batch_id : batch_ids)
+        Transport::addCompletionWaiter(batch_id, &waiter);
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(timeout_ms);
+    Status status = Status::OK();
+    while (true) {
+        for (size_t i = 0; i < batch_ids.size() && index == batch_ids.size();
+             ++i) {
+            TransferStatus batch_status;
+            status = getBatchTransferStatus(batch_ids[i], batch_status);
+            if (!status.ok() ||
+                batch_status.s != Transport::TransferStatusEnum::WAITING)
+                index = i;
+        }
+        if (index < batch_ids.size()) break;
+
+        auto wakeup = std::chrono::steady_clock::now() + kRecheckInterval;
+        if (timeout_ms >= 0) {
+            if (std::chrono::steady_clock::now() >= deadline) break;
+            wakeup = std::min(wakeup, deadline);
+        }
+        std::unique_lock<std::mutex> lock(waiter.mutex);
+        waiter.cv.wait_until(lock, wakeup, [&] { return waiter.notified; });
+        waiter.notified = false;
+    }
+    for (auto batch_id : batch_ids)
+        Transport::removeCompletionWaiter(batch_id, &waiter);
+    return status;
+}
+
 Transport *MultiTransport::installTransport(const std::string &proto,
                                             std::shared_ptr<Topology> topo) {
     Transport *transport = nullptr;
@@ -337,6 +538,8 @@ Transport *MultiTransport::installTransport(const std::string &proto,
     }
 
     transport_map_[proto] = std::shared_ptr<Transport>(transport);
+    if (proto == "rdma")
+        rdma_transport_ = static_cast<RdmaTransport *>(transport);
     return transport;
 }
 
@@ -347,6 +550,14 @@ Status MultiTransport::selectTransport(const TransferRequest &entry,
         return Status::InvalidArgument("Invalid target segment ID " +
                                        std::to_string(entry.target_id));
     }
+#ifdef USE_RDMA_ONLY
+    if (!rdma_transport_ || target_segment_desc->protocol != "rdma") {
+        return Status::NotSupportedTransport(
+            "Transport " + target_segment_desc->protocol + " not installed");
+    }
+    transport = rdma_transport_;
+    return Status::OK();
+#else
     auto proto = target_segment_desc->protocol;
 #ifdef USE_ASCEND_HETEROGENEOUS
     // When USE_ASCEND_HETEROGENEOUS is enabled:
@@ -362,6 +573,7 @@ Status MultiTransport::selectTransport(const TransferRequest &entry,
     }
     transport = transport_map_[proto].get();
     return Status::OK();
+#endif  // USE_RDMA_ONLY
 }
 
 Transport *MultiTransport::getTransport(const std::string &proto) {
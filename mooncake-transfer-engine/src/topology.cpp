@@ -483,6 +483,15 @@ int Topology::selectDevice(const std::string storage_type, int retry_count) {
     return 0;
 }
 
+const std::vector<int> &Topology::candidateDevices(
+    const std::string &storage_type) const {
+    const static std::vector<int> kNoDevices;
+    auto it = resolved_matrix_.find(storage_type);
+    if (it == resolved_matrix_.end()) return kNoDevices;
+    if (!it->second.preferred_hca.empty()) return it->second.preferred_hca;
+    return it->second.avail_hca;
+}
+
 int Topology::resolve() {
     resolved_matrix_.clear();
     hca_list_.clear();
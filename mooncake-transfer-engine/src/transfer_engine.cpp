@@ -63,6 +63,11 @@ SegmentHandle TransferEngine::openSegment(const std::string& segment_name) {
     return impl_->openSegment(segment_name);
 }
 
+int TransferEngine::warmupSegments(
+    const std::vector<std::string>& segment_names, size_t concurrency) {
+    return impl_->warmupSegments(segment_names, concurrency);
+}
+
 Status TransferEngine::CheckSegmentStatus(SegmentID sid) {
     return impl_->CheckSegmentStatus(sid);
 }
@@ -141,6 +146,20 @@ Status TransferEngine::getBatchTransferStatus(BatchID batch_id,
     return impl_->getBatchTransferStatus(batch_id, status);
 }
 
+int TransferEngine::getBatchCompletionFd(BatchID batch_id) {
+    return impl_->getBatchCompletionFd(batch_id);
+}
+
+Status TransferEngine::setBatchCompletionCallback(
+    BatchID batch_id, BatchCompletionCallback callback) {
+    return impl_->setBatchCompletionCallback(batch_id, std::move(callback));
+}
+
+Status TransferEngine::waitAnyBatch(const std::vector<BatchID>& batch_ids,
+                                    size_t& index, int64_t timeout_ms) {
+    return impl_->waitAnyBatch(batch_ids, index, timeout_ms);
+}
+
 Transport* TransferEngine::getTransport(const std::string& proto) {
     return impl_->getTransport(proto);
 }
@@ -180,6 +199,8 @@ std::shared_ptr<Topology> TransferEngine::getLocalTopology() {
 #include "tent/transfer_engine.h"
 #include "tent/common/config.h"
 
+#include <chrono>
+#include <thread>
 #include <utility>
 
 namespace mooncake {
@@ -240,12 +261,18 @@ int TransferEngine::init(const std::string& metadata_conn_string,
             config->set("local_segment_name", local_server_name);
         if (metadata_conn_string == P2PHANDSHAKE) {
             config->set("metadata_type", "p2p");
+            // The segment is named after the RPC address, which must be the
+            // one the caller advertises, e.g. as the store te_endpoint
+            if (!ip_or_host_name.empty())
+                config->set("rpc_server_hostname", ip_or_host_name);
         } else {
             auto [type, servers] =
                 parseConnectionStringInternal(metadata_conn_string);
             if (!type.empty()) config->set("metadata_type", type);
             if (!servers.empty()) config->set("metadata_servers", servers);
         }
+        if (!tent_filters_.empty())
+            config->set("topology/rdma_whitelist", tent_filters_);
         impl_tent_ = std::make_shared<mooncake::tent::TransferEngine>(config);
         return impl_tent_->available() ? 0 : 1;
     }
@@ -307,6 +334,14 @@ SegmentHandle TransferEngine::openSegment(const std::string& segment_name) {
         return impl_->openSegment(segment_name);
 }
 
+int TransferEngine::warmupSegments(
+    const std::vector<std::string>& segment_names, size_t concurrency) {
+    if (use_tent_)
+        return 0;
+    else
+        return impl_->warmupSegments(segment_names, concurrency);
+}
+
 Status TransferEngine::CheckSegmentStatus(SegmentID sid) {
     if (use_tent_)
         return Status::OK();
@@ -407,6 +442,8 @@ Status TransferEngine::submitTransfer(
     if (use_tent_) {
         std::vector<mooncake::tent::Request> requests;
         for (auto& item : entries) {
+            if (item.isAtomic())
+                return Status::NotImplemented("Atomics are not supported");
             mooncake::tent::Request req;
             req.opcode = (mooncake::tent::Request::OpCode)(int)item.opcode;
             req.length = item.length;
@@ -431,6 +468,8 @@ Status TransferEngine::submitTransferWithNotify(
     if (use_tent_) {
         std::vector<mooncake::tent::Request> requests;
         for (auto& item : entries) {
+            if (item.isAtomic())
+                return Status::NotImplemented("Atomics are not supported");
             mooncake::tent::Request req;
             req.opcode = (mooncake::tent::Request::OpCode)(int)item.opcode;
             req.length = item.length;
@@ -527,6 +566,47 @@ Status TransferEngine::getBatchTransferStatus(BatchID batch_id,
         return impl_->getBatchTransferStatus(batch_id, status);
 }
 
+int TransferEngine::getBatchCompletionFd(BatchID batch_id) {
+    if (use_tent_)
+        return ERR_NOT_IMPLEMENTED;
+    else
+        return impl_->getBatchCompletionFd(batch_id);
+}
+
+Status TransferEngine::setBatchCompletionCallback(
+    BatchID batch_id, BatchCompletionCallback callback) {
+    if (use_tent_)
+        return Status::NotImplemented(
+            "Completion callbacks are not supported by TENT");
+    else
+        return impl_->setBatchCompletionCallback(batch_id, std::move(callback));
+}
+
+Status TransferEngine::waitAnyBatch(const std::vector<BatchID>& batch_ids,
+                                    size_t& index, int64_t timeout_ms) {
+    if (!use_tent_) return impl_->waitAnyBatch(batch_ids, index, timeout_ms);
+
+    // The batches of TENT do not notify their completion, so they are polled
+    const int64_t start_ts = getCurrentTimeInNano();
+    index = batch_ids.size();
+    if (batch_ids.empty())
+        return Status::InvalidArgument("No batch to wait for");
+    while (true) {
+        for (size_t i = 0; i < batch_ids.size(); ++i) {
+            TransferStatus status;
+            auto s = getBatchTransferStatus(batch_ids[i], status);
+            if (!s.ok() || status.s != TransferStatusEnum::WAITING) {
+                index = i;
+                return s;
+            }
+        }
+        if (timeout_ms >= 0 &&
+            getCurrentTimeInNano() - start_ts >= timeout_ms * 1000000)
+            return Status::OK();
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
 Transport* TransferEngine::getTransport(const std::string& proto) {
     if (use_tent_)
         return nullptr;
@@ -559,7 +639,10 @@ void TransferEngine::setAutoDiscover(bool auto_discover) {
 }
 
 void TransferEngine::setWhitelistFilters(std::vector<std::string>&& filters) {
-    if (!use_tent_) impl_->setWhitelistFilters(std::move(filters));
+    if (use_tent_)
+        tent_filters_ = std::move(filters);
+    else
+        impl_->setWhitelistFilters(std::move(filters));
 }
 
 int TransferEngine::numContexts() const {
@@ -27,6 +27,7 @@
 #include <sstream>
 #endif
 
+#include "config.h"
 #include "transfer_metadata_plugin.h"
 #include "transport/transport.h"
 #include "transport/barex_transport/barex_transport.h"
@@ -269,6 +270,18 @@ int TransferEngineImpl::init(const std::string& metadata_conn_string,
                 return -1;
             }
             LOG(INFO) << "Using RDMA transport (RoCE/iWARP)";
+#ifdef USE_MNNVL
+            if (globalConfig().multi_path_threshold > 0) {
+                // Splits large requests over RDMA and NVLink
+                if (!multi_transports_->installTransport("nvlink", nullptr)) {
+                    LOG(ERROR) << "Failed to install NVLink transport";
+                    return -1;
+                }
+                LOG(INFO) << "Using NVLink transport next to RDMA for "
+                             "requests of at least "
+                          << globalConfig().multi_path_threshold << " bytes";
+            }
+#endif
         }
 
 #else
@@ -297,6 +310,16 @@ int TransferEngineImpl::init(const std::string& metadata_conn_string,
                 LOG(INFO) << "installTransport, type="
                           << (use_barex_ ? "barex" : "rdma");
             }
+#ifdef USE_TCP
+            if (!use_barex_ && globalConfig().transport_fallback_ms > 0) {
+                // Serves the peers whose RDMA transfers fail
+                if (!multi_transports_->installTransport("tcp", nullptr)) {
+                    LOG(ERROR) << "Failed to install TCP transport";
+                    return -1;
+                }
+                LOG(INFO) << "Using TCP transport as fallback of RDMA";
+            }
+#endif
         } else {
             Transport* tcp_transport =
                 multi_transports_->installTransport("tcp", nullptr);
@@ -376,6 +399,11 @@ int TransferEngineImpl::getNotifies(
 int TransferEngineImpl::sendNotifyByID(
     SegmentID target_id, TransferMetadata::NotifyDesc notify_msg) {
     auto desc = metadata_->getSegmentDescByID(target_id);
+    if (!desc) return ERR_INVALID_ARGUMENT;
+    // Over a connection of the data path if there is one, the message then
+    // takes no extra round trip
+    auto transport = multi_transports_->getTransport(desc->protocol);
+    if (transport && !transport->sendNotify(target_id, notify_msg)) return 0;
     Transport::NotifyDesc peer_desc;
     int ret = metadata_->sendNotify(desc->name, notify_msg, peer_desc);
     return ret;
@@ -413,6 +441,38 @@ Transport::SegmentHandle TransferEngineImpl::openSegment(
     return sid;
 }
 
+int TransferEngineImpl::warmupSegments(
+    const std::vector<std::string>& segment_names, size_t concurrency) {
+    std::atomic<size_t> next_index(0);
+    std::atomic<int> failed_count(0);
+    auto worker = [&]() {
+        while (true) {
+            size_t i = next_index.fetch_add(1);
+            if (i >= segment_names.size()) return;
+            auto handle = openSegment(segment_names[i]);
+            if ((int64_t)handle < 0) {
+                failed_count++;
+                continue;
+            }
+            int ret = 0;
+            for (auto transport : multi_transports_->listTransports())
+                if (transport->warmupSegment(handle)) ret = ERR_ENDPOINT;
+            if (ret) {
+                LOG(WARNING) << "Failed to warm up segment "
+                             << segment_names[i];
+                failed_count++;
+            }
+        }
+    };
+    concurrency = std::max<size_t>(
+        1, std::min(concurrency, segment_names.size()));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < concurrency; ++i) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+    return failed_count.load();
+}
+
 Status TransferEngineImpl::CheckSegmentStatus(SegmentID sid) {
 #ifdef USE_BAREX
     if (use_barex_) {
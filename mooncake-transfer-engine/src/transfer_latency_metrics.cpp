@@ -0,0 +1,110 @@
+// Copyright 2025 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "transfer_latency_metrics.h"
+
+namespace mooncake {
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.counts.assign(kBuckets, 0);
+    for (const auto &shard : shards_) {
+        for (size_t i = 0; i < kBuckets; ++i) {
+            const uint64_t count =
+                shard.counts[i].load(std::memory_order_relaxed);
+            snapshot.counts[i] += count;
+            snapshot.count += count;
+        }
+        snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+TransferLatencyMetrics &TransferLatencyMetrics::instance() {
+    // Never destroyed, threads may record while the process exits
+    static auto *metrics = new TransferLatencyMetrics();
+    return *metrics;
+}
+
+LatencyHistogram *TransferLatencyMetrics::histogram(const std::string &name,
+                                                    const std::string &help,
+                                                    const std::string &labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &histogram = histograms_[name];
+    histogram.help = help;
+    auto &series = histogram.series[labels];
+    if (!series) series = std::make_unique<LatencyHistogram>();
+    return series.get();
+}
+
+void TransferLatencyMetrics::addGauge(const void *owner,
+                                      const std::string &name,
+                                      const std::string &help,
+                                      const std::string &labels,
+                                      std::function<uint64_t()> read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    gauges_.emplace(name, Gauge{owner, help, labels, std::move(read)});
+}
+
+void TransferLatencyMetrics::removeGauges(const void *owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = gauges_.begin(); it != gauges_.end();) {
+        if (it->second.owner == owner)
+            it = gauges_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void TransferLatencyMetrics::serialize(std::string &out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &[name, histogram] : histograms_) {
+        out += "# HELP " + name + " " + histogram.help + "\n";
+        out += "# TYPE " + name + " histogram\n";
+        for (const auto &[labels, series] : histogram.series) {
+            const auto snapshot = series->snapshot();
+            const std::string prefix = labels.empty() ? "" : labels + ",";
+            // Buckets up to the last one used, cumulative as Prometheus
+            // expects
+            size_t last = 0;
+            for (size_t i = 0; i < snapshot.counts.size(); ++i) {
+                if (snapshot.counts[i]) last = i;
+            }
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i <= last && snapshot.count; ++i) {
+                cumulative += snapshot.counts[i];
+                out += name + "_bucket{" + prefix + "le=\"" +
+                       std::to_string(LatencyHistogram::bucketMax(i)) +
+                       "\"} " + std::to_string(cumulative) + "\n";
+            }
+            out += name + "_bucket{" + prefix + "le=\"+Inf\"} " +
+                   std::to_string(snapshot.count) + "\n";
+            const std::string braces = labels.empty() ? "" : "{" + labels + "}";
+            out += name + "_sum" + braces + " " +
+                   std::to_string(snapshot.sum) + "\n";
+            out += name + "_count" + braces + " " +
+                   std::to_string(snapshot.count) + "\n";
+        }
+    }
+    std::string current;
+    for (const auto &[name, gauge] : gauges_) {
+        if (name != current) {
+            out += "# HELP " + name + " " + gauge.help + "\n";
+            out += "# TYPE " + name + " gauge\n";
+            current = name;
+        }
+        out += name + (gauge.labels.empty() ? "" : "{" + gauge.labels + "}") +
+               " " + std::to_string(gauge.read()) + "\n";
+    }
+}
+}  // namespace mooncake
@@ -16,8 +16,12 @@
 
 #include <json/value.h>
 
+#include <algorithm>
 #include <cassert>
+#include <random>
 #include <set>
+#include <sstream>
+#include <ylt/struct_pack.hpp>
 
 #include "common.h"
 #include "config.h"
@@ -62,6 +66,7 @@ struct TransferHandshakeUtil {
         for (const auto &qp : desc.qp_num) qpNums.append(qp);
         root["qp_num"] = qpNums;
         root["reply_msg"] = desc.reply_msg;
+        root["notify_recv"] = desc.notify_recv;
 #ifdef USE_EFA
         root["efa_addr"] = desc.efa_addr;  // EFA endpoint address
 #endif
@@ -77,6 +82,7 @@ struct TransferHandshakeUtil {
         for (const auto &qp : root["qp_num"])
             desc.qp_num.push_back(qp.asUInt());
         desc.reply_msg = root["reply_msg"].asString();
+        desc.notify_recv = root["notify_recv"].asBool();
 #ifdef USE_EFA
         desc.efa_addr = root["efa_addr"].asString();  // EFA endpoint address
 #endif
@@ -84,8 +90,218 @@ struct TransferHandshakeUtil {
     }
 };
 
-TransferMetadata::TransferMetadata(const std::string &conn_string) {
+struct TransferBufferUtil {
+    static Json::Value encode(const TransferMetadata::BufferDesc &desc) {
+        Json::Value root;
+        root["name"] = desc.name;
+        root["addr"] = static_cast<Json::UInt64>(desc.addr);
+        root["length"] = static_cast<Json::UInt64>(desc.length);
+        Json::Value rkeyJSON(Json::arrayValue);
+        for (auto &entry : desc.rkey) rkeyJSON.append(entry);
+        root["rkey"] = rkeyJSON;
+        Json::Value lkeyJSON(Json::arrayValue);
+        for (auto &entry : desc.lkey) lkeyJSON.append(entry);
+        root["lkey"] = lkeyJSON;
+        root["shm_name"] = desc.shm_name;
+        root["offset"] = static_cast<Json::UInt64>(desc.offset);
+        return root;
+    }
+
+    static int decode(Json::Value root, TransferMetadata::BufferDesc &desc) {
+        desc.name = root["name"].asString();
+        desc.addr = root["addr"].asUInt64();
+        desc.length = root["length"].asUInt64();
+        for (const auto &entry : root["rkey"])
+            desc.rkey.push_back(entry.asUInt());
+        for (const auto &entry : root["lkey"])
+            desc.lkey.push_back(entry.asUInt());
+        desc.shm_name = root["shm_name"].asString();
+        desc.offset = root["offset"].asUInt64();
+        return 0;
+    }
+};
+
+// Replays a registration or removal of a peer buffer on its descriptor
+static void applyBufferChange(TransferMetadata::SegmentDesc &desc,
+                              bool removed,
+                              const TransferMetadata::BufferDesc &buffer) {
+    auto &buffers = desc.buffers;
+    if (!removed) {
+        buffers.push_back(buffer);
+        return;
+    }
+    for (auto iter = buffers.begin(); iter != buffers.end(); ++iter) {
+        // CXL buffers are located by their offset in the shared region
+        bool match = desc.protocol == "cxl" ? iter->offset == buffer.offset
+                                            : iter->addr == buffer.addr;
+        if (match && iter->length == buffer.length) {
+            buffers.erase(iter);
+            return;
+        }
+    }
+}
+
+// Binary counterparts of the JSON messages exchanged with peers, encoded by
+// struct_pack. Every message carries the version of its layout, peers drop
+// the versions they do not know and the sender falls back to JSON.
+static constexpr uint32_t kMetadataWireVersion = 2;
+
+// Local buffer changes remembered for delta updates of P2P peers
+static constexpr size_t kMaxBufferChanges = 1024;
+
+// Deltas published to the metadata server are folded into the descriptor
+// once they outnumber its buffers and this bound
+static constexpr size_t kMinDeltasBeforeSnapshot = 64;
+
+// Reads of a descriptor racing with the folding of its deltas are retried
+static constexpr int kMaxSegmentDescReadAttempts = 3;
+
+// Known segments passed along with each P2P descriptor request and reply
+static constexpr size_t kMaxGossipSegments = 32;
+
+struct HandShakeWire {
+    std::string local_nic_path;
+    std::string peer_nic_path;
+    uint32_t barex_port;
+    std::vector<uint32_t> qp_num;
+    std::string reply_msg;
+    std::string efa_addr;
+    bool notify_recv;
+};
+
+struct HandShakeListWire {
+    uint32_t version;
+    std::vector<HandShakeWire> handshakes;
+};
+
+struct DeviceWire {
+    std::string name;
+    uint32_t lid;
+    std::string gid;
+    uint32_t dct_num;
+};
+
+struct BufferWire {
+    std::string name;
+    uint64_t addr;
+    uint64_t length;
+    std::vector<uint32_t> lkey;
+    std::vector<uint32_t> rkey;
+    std::string shm_name;
+    uint64_t offset;
+};
+
+struct BufferChangeWire {
+    bool removed;
+    BufferWire buffer;
+};
+
+struct SegmentRequestWire {
+    uint32_t version;
+    std::string name;
+    // Version of the copy cached by the requester, 0 if none
+    uint64_t instance_id;
+    uint64_t generation;
+    // Segment of the requester, and some of the segments it knows
+    std::string requester;
+    std::vector<std::string> segments;
+};
+
+struct SegmentWire {
+    uint32_t version;
+    uint64_t instance_id;
+    uint64_t generation;
+    // Only the buffer changes since the generation of the request are sent
+    bool delta;
+    // Descriptors of protocols without a binary layout travel as JSON
+    std::string json;
+    std::string name;
+    std::string protocol;
+    std::vector<DeviceWire> devices;
+    std::string topology;
+    std::vector<BufferWire> buffers;
+    std::vector<BufferChangeWire> changes;
+    int32_t tcp_data_port;
+    bool tcp_persistent;
+    std::string timestamp;
+    // Some of the segments the owner knows
+    std::vector<std::string> segments;
+};
+
+struct TransferWireUtil {
+    static HandShakeWire encode(const TransferMetadata::HandShakeDesc &desc) {
+        HandShakeWire wire{};
+        wire.local_nic_path = desc.local_nic_path;
+        wire.peer_nic_path = desc.peer_nic_path;
+#ifdef USE_BAREX
+        wire.barex_port = desc.barex_port;
+#endif
+        wire.qp_num = desc.qp_num;
+        wire.reply_msg = desc.reply_msg;
+        wire.notify_recv = desc.notify_recv;
+#ifdef USE_EFA
+        wire.efa_addr = desc.efa_addr;
+#endif
+        return wire;
+    }
+
+    static void decode(const HandShakeWire &wire,
+                       TransferMetadata::HandShakeDesc &desc) {
+        desc.local_nic_path = wire.local_nic_path;
+        desc.peer_nic_path = wire.peer_nic_path;
+#ifdef USE_BAREX
+        desc.barex_port = wire.barex_port;
+#endif
+        desc.qp_num = wire.qp_num;
+        desc.reply_msg = wire.reply_msg;
+        desc.notify_recv = wire.notify_recv;
+#ifdef USE_EFA
+        desc.efa_addr = wire.efa_addr;
+#endif
+    }
+
+    static BufferWire encode(const TransferMetadata::BufferDesc &desc) {
+        return BufferWire{desc.name, desc.addr,     desc.length, desc.lkey,
+                          desc.rkey, desc.shm_name, desc.offset};
+    }
+
+    static TransferMetadata::BufferDesc decode(const BufferWire &wire) {
+        return TransferMetadata::BufferDesc{wire.name, wire.addr,
+                                            wire.length, wire.lkey,
+                                            wire.rkey, wire.shm_name,
+                                            wire.offset};
+    }
+
+    // Protocols whose descriptor has a binary layout, the others are
+    // embedded as JSON
+    static bool hasBinaryLayout(const std::string &protocol) {
+        return protocol == "rdma" || protocol == "barex" ||
+               protocol == "efa" || protocol == "tcp";
+    }
+
+    template <typename T>
+    static std::string serialize(const T &message) {
+        return struct_pack::serialize<std::string>(message);
+    }
+
+    template <typename T>
+    static bool deserialize(const std::string &data, T &message) {
+        auto result = struct_pack::deserialize<T>(data);
+        if (!result) return false;
+        message = std::move(result.value());
+        return message.version == kMetadataWireVersion;
+    }
+};
+
+TransferMetadata::TransferMetadata(const std::string &conn_string)
+    : TransferMetadata(conn_string, nullptr) {}
+
+TransferMetadata::TransferMetadata(
+    const std::string &conn_string,
+    std::shared_ptr<MetadataStoragePlugin> storage_plugin) {
     next_segment_id_.store(1);
+    std::random_device rd;
+    local_instance_id_ = (uint64_t(rd()) << 32) | rd();
 
     std::string protocol = extractProtocolFromConnString(conn_string);
     std::string custom_key;
@@ -111,17 +327,106 @@ TransferMetadata::TransferMetadata(const std::string &conn_string) {
     }
     if (conn_string == P2PHANDSHAKE) {
         p2p_handshake_mode_ = true;
+        const char *seeds = std::getenv("MC_P2P_SEEDS");
+        if (seeds) {
+            std::vector<std::string> seed_list;
+            std::stringstream ss(seeds);
+            std::string seed;
+            while (std::getline(ss, seed, ','))
+                if (!seed.empty()) seed_list.push_back(seed);
+            addKnownSegments(seed_list);
+        }
         return;
     }
-    storage_plugin_ = MetadataStoragePlugin::Create(conn_string);
+    storage_plugin_ = storage_plugin
+                          ? std::move(storage_plugin)
+                          : MetadataStoragePlugin::Create(conn_string);
     if (!storage_plugin_) {
         LOG(ERROR)
             << "Unable to create metadata storage plugin with conn string "
             << conn_string;
+        return;
+    }
+    if (globalConfig().metacache) {
+        watching_ = storage_plugin_->watch(
+            common_key_prefix_,
+            [this](const std::string &key) { onMetadataChanged(key); });
+        if (!watching_)
+            LOG(INFO) << "Metadata server does not notify changes, cached "
+                         "segments are refreshed on demand";
     }
 }
 
-TransferMetadata::~TransferMetadata() { handshake_plugin_.reset(); }
+TransferMetadata::~TransferMetadata() {
+    if (gossip_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(gossip_mutex_);
+            gossip_stopped_ = true;
+        }
+        gossip_cv_.notify_all();
+        gossip_thread_.join();
+    }
+    handshake_plugin_.reset();
+    // Stops the watch calling back into this object
+    storage_plugin_.reset();
+}
+
+void TransferMetadata::onMetadataChanged(const std::string &key) {
+    if (key.empty()) {
+        // Changes may have been missed, trust nothing cached
+        std::vector<std::string> names;
+        {
+            RWSpinlock::ReadGuard guard(segment_lock_);
+            for (auto &entry : segment_name_to_id_map_)
+                if (entry.second != LOCAL_SEGMENT_ID)
+                    names.push_back(entry.first);
+        }
+        for (auto &name : names) markSegmentStale(name);
+        RWSpinlock::WriteGuard guard(rpc_meta_lock_);
+        rpc_meta_map_.clear();
+        return;
+    }
+
+    if (key.compare(0, common_key_prefix_.size(), common_key_prefix_))
+        return;
+    if (!key.compare(0, rpc_meta_prefix_.size(), rpc_meta_prefix_)) {
+        RWSpinlock::WriteGuard guard(rpc_meta_lock_);
+        rpc_meta_map_.erase(key.substr(rpc_meta_prefix_.size()));
+        return;
+    }
+    // Inverse of getFullMetadataKey() and getDeltaKey()
+    auto path = key.substr(common_key_prefix_.size());
+    std::string segment_name = path;
+    if (!path.compare(0, 4, "ram/")) {
+        segment_name = path.substr(4);
+    } else if (!path.compare(0, 6, "delta/")) {
+        auto pos = path.rfind('/');
+        segment_name = path.substr(6, pos - 6);
+    }
+    {
+        RWSpinlock::ReadGuard guard(segment_lock_);
+        auto it = segment_name_to_id_map_.find(segment_name);
+        if (it == segment_name_to_id_map_.end() ||
+            it->second == LOCAL_SEGMENT_ID)
+            return;
+    }
+    markSegmentStale(segment_name);
+}
+
+void TransferMetadata::markSegmentStale(const std::string &segment_name) {
+    RWSpinlock::WriteGuard guard(stale_lock_);
+    if (stale_segments_.insert(segment_name).second) ++num_stale_segments_;
+}
+
+// Returns whether the cached copy of the segment must be refreshed, and
+// clears the mark, which the caller restores if the refresh fails
+bool TransferMetadata::takeStaleSegment(const std::string &segment_name) {
+    if (!num_stale_segments_.load(std::memory_order_relaxed)) return false;
+    RWSpinlock::WriteGuard guard(stale_lock_);
+    if (!stale_segments_.erase(segment_name)) return false;
+    --num_stale_segments_;
+    return true;
+}
 
 std::string TransferMetadata::getFullMetadataKey(
     const std::string &segment_name) const {
@@ -142,10 +447,9 @@ std::string TransferMetadata::getFullMetadataKey(
 
 int TransferMetadata::receivePeerNotify(const Json::Value &peer_json,
                                         Json::Value &local_json) {
-    RWSpinlock::WriteGuard guard(notify_lock_);
     TransferMetadata::NotifyDesc peer_notify, local_reply;
     TransferNotifyUtil::decode(peer_json, peer_notify);
-    notifys.push_back(peer_notify);
+    addNotify(std::move(peer_notify));
     // reply
     local_reply.name = "";
     local_reply.notify_msg = "success";
@@ -153,6 +457,11 @@ int TransferMetadata::receivePeerNotify(const Json::Value &peer_json,
     return 0;
 }
 
+void TransferMetadata::addNotify(NotifyDesc notify) {
+    RWSpinlock::WriteGuard guard(notify_lock_);
+    notifys.push_back(std::move(notify));
+}
+
 int TransferMetadata::getNotifies(std::vector<NotifyDesc> &notifies) {
     RWSpinlock::WriteGuard guard(notify_lock_);
     if (notifys.size() > 0) {
@@ -167,7 +476,15 @@ int TransferMetadata::encodeSegmentDesc(const SegmentDesc &desc,
     segmentJSON["name"] = desc.name;
     segmentJSON["protocol"] = desc.protocol;
     segmentJSON["tcp_data_port"] = desc.tcp_data_port;
+    segmentJSON["tcp_persistent"] = desc.tcp_persistent;
     segmentJSON["timestamp"] = getCurrentDateTime();
+    if (globalConfig().metadata_incremental && desc.generation) {
+        // Readers look for the deltas published after this generation
+        segmentJSON["instance_id"] =
+            static_cast<Json::UInt64>(desc.instance_id);
+        segmentJSON["generation"] =
+            static_cast<Json::UInt64>(desc.generation);
+    }
 
     if (segmentJSON["protocol"] == "rdma" ||
         segmentJSON["protocol"] == "barex" ||
@@ -178,6 +495,7 @@ int TransferMetadata::encodeSegmentDesc(const SegmentDesc &desc,
             deviceJSON["name"] = device.name;
             deviceJSON["lid"] = device.lid;
             deviceJSON["gid"] = device.gid;
+            if (device.dct_num) deviceJSON["dct_num"] = device.dct_num;
             devicesJSON.append(deviceJSON);
         }
         segmentJSON["devices"] = devicesJSON;
@@ -256,6 +574,8 @@ int TransferMetadata::encodeSegmentDesc(const SegmentDesc &desc,
             bufferJSON["addr"] = static_cast<Json::UInt64>(buffer.addr);
             bufferJSON["length"] = static_cast<Json::UInt64>(buffer.length);
             bufferJSON["shm_name"] = buffer.shm_name;
+            if (buffer.offset)
+                bufferJSON["offset"] = static_cast<Json::UInt64>(buffer.offset);
             buffersJSON.append(bufferJSON);
         }
         segmentJSON["buffers"] = buffersJSON;
@@ -319,6 +639,17 @@ int TransferMetadata::removeSegmentDesc(const std::string &segment_name) {
                    << segment_name;
         return ERR_METADATA;
     }
+    if (globalConfig().metadata_incremental) {
+        std::lock_guard<std::mutex> lock(publish_mutex_);
+        if (published_generation_) {
+            storage_plugin_->remove(getDeltaKey(segment_name, "head"));
+            for (uint64_t stale = published_snapshot_ + 1;
+                 stale <= published_generation_; ++stale)
+                storage_plugin_->remove(
+                    getDeltaKey(segment_name, std::to_string(stale)));
+            published_snapshot_ = published_generation_ = 0;
+        }
+    }
     return 0;
 }
 
@@ -329,8 +660,11 @@ TransferMetadata::decodeSegmentDesc(Json::Value &segmentJSON,
     desc->name = segmentJSON["name"].asString();
     desc->protocol = segmentJSON["protocol"].asString();
     desc->tcp_data_port = segmentJSON["tcp_data_port"].asInt();
+    desc->tcp_persistent = segmentJSON.get("tcp_persistent", false).asBool();
     if (segmentJSON.isMember("timestamp"))
         desc->timestamp = segmentJSON["timestamp"].asString();
+    desc->instance_id = segmentJSON.get("instance_id", 0).asUInt64();
+    desc->generation = segmentJSON.get("generation", 0).asUInt64();
 
     if (desc->protocol == "rdma" || desc->protocol == "barex" ||
         desc->protocol == "efa") {
@@ -339,6 +673,7 @@ TransferMetadata::decodeSegmentDesc(Json::Value &segmentJSON,
             device.name = deviceJSON["name"].asString();
             device.lid = deviceJSON["lid"].asUInt();
             device.gid = deviceJSON["gid"].asString();
+            device.dct_num = deviceJSON.get("dct_num", 0).asUInt();
             if (device.name.empty() || device.gid.empty()) {
                 LOG(WARNING) << "Corrupted segment descriptor, name "
                              << segment_name << " protocol " << desc->protocol;
@@ -396,6 +731,7 @@ TransferMetadata::decodeSegmentDesc(Json::Value &segmentJSON,
             buffer.addr = bufferJSON["addr"].asUInt64();
             buffer.length = bufferJSON["length"].asUInt64();
             buffer.shm_name = bufferJSON["shm_name"].asString();
+            buffer.offset = bufferJSON["offset"].asUInt64();
             if (buffer.name.empty() || !buffer.addr || !buffer.length ||
                 buffer.shm_name.empty()) {
                 LOG(WARNING) << "Corrupted segment descriptor, name "
@@ -497,42 +833,252 @@ int TransferMetadata::receivePeerMetadata(const Json::Value &peer_json,
     return ret;
 }
 
+int TransferMetadata::receivePeerMetadataBinary(const std::string &peer,
+                                                std::string &local) {
+    SegmentRequestWire request;
+    if (!TransferWireUtil::deserialize(peer, request)) return ERR_METADATA;
+    if (!request.requester.empty()) addKnownSegments({request.requester});
+    addKnownSegments(request.segments);
+
+    SegmentWire reply{};
+    reply.version = kMetadataWireVersion;
+    std::shared_ptr<SegmentDesc> local_desc;
+    {
+        RWSpinlock::ReadGuard guard(segment_lock_);
+        auto it = segment_id_to_desc_map_.find(LOCAL_SEGMENT_ID);
+        if (it == segment_id_to_desc_map_.end() || !it->second) {
+            LOG(ERROR) << "Local segment descriptor not found";
+            return ERR_METADATA;
+        }
+        local_desc = it->second;
+        reply.instance_id = local_instance_id_;
+        reply.generation = local_generation_;
+        // A delta is possible if the history reaches back to the copy of
+        // the peer
+        bool covered = request.generation == local_generation_ ||
+                       (!local_buffer_changes_.empty() &&
+                        local_buffer_changes_.front().generation <=
+                            request.generation + 1);
+        if (request.instance_id == local_instance_id_ &&
+            request.generation <= local_generation_ && covered &&
+            TransferWireUtil::hasBinaryLayout(local_desc->protocol)) {
+            reply.delta = true;
+            for (auto &change : local_buffer_changes_) {
+                if (change.generation <= request.generation) continue;
+                reply.changes.push_back(BufferChangeWire{
+                    change.removed, TransferWireUtil::encode(change.buffer)});
+            }
+        }
+    }
+
+    if (!reply.delta) {
+        if (TransferWireUtil::hasBinaryLayout(local_desc->protocol)) {
+            reply.name = local_desc->name;
+            reply.protocol = local_desc->protocol;
+            for (auto &device : local_desc->devices)
+                reply.devices.push_back(DeviceWire{device.name, device.lid,
+                                                   device.gid, device.dct_num});
+            if (local_desc->protocol != "tcp")
+                reply.topology = local_desc->topology.toString();
+            for (auto &buffer : local_desc->buffers)
+                reply.buffers.push_back(TransferWireUtil::encode(buffer));
+            reply.tcp_data_port = local_desc->tcp_data_port;
+            reply.tcp_persistent = local_desc->tcp_persistent;
+            reply.timestamp = getCurrentDateTime();
+        } else {
+            Json::Value local_json;
+            int ret = encodeSegmentDesc(*local_desc, local_json);
+            if (ret) return ret;
+            reply.json = Json::FastWriter{}.write(local_json);
+        }
+    }
+    reply.segments = sampleKnownSegments(kMaxGossipSegments);
+    local = TransferWireUtil::serialize(reply);
+    return 0;
+}
+
+int TransferMetadata::getSegmentDescBinary(const std::string &segment_name,
+                                           const std::string &ip,
+                                           uint16_t port,
+                                           std::shared_ptr<SegmentDesc> &desc) {
+    if (isJsonOnlyPeer(ip, port)) return ERR_NOT_IMPLEMENTED;
+
+    auto cached = getCachedPeerSegmentDesc(segment_name);
+    SegmentRequestWire request{};
+    request.version = kMetadataWireVersion;
+    request.name = segment_name;
+    if (cached) {
+        request.instance_id = cached->instance_id;
+        request.generation = cached->generation;
+    }
+    request.requester = localSegmentName();
+    request.segments = sampleKnownSegments(kMaxGossipSegments);
+    std::string peer;
+    int ret = handshake_plugin_->sendBinary(
+        ip, port, HandShakeRequestType::MetadataBinary,
+        TransferWireUtil::serialize(request), peer);
+    if (ret == ERR_NOT_IMPLEMENTED) markJsonOnlyPeer(ip, port);
+    if (ret) return ret;
+
+    SegmentWire reply;
+    if (!TransferWireUtil::deserialize(peer, reply)) {
+        LOG(WARNING) << "Corrupted segment descriptor, name " << segment_name;
+        return ERR_METADATA;
+    }
+    addKnownSegments({segment_name});
+    addKnownSegments(reply.segments);
+
+    if (reply.delta) {
+        if (!cached || cached->instance_id != reply.instance_id) {
+            LOG(WARNING) << "Unexpected segment descriptor delta, name "
+                         << segment_name;
+            return ERR_METADATA;
+        }
+        desc = std::make_shared<SegmentDesc>(*cached);
+        for (auto &change : reply.changes)
+            applyBufferChange(*desc, change.removed,
+                              TransferWireUtil::decode(change.buffer));
+    } else if (!reply.json.empty()) {
+        Json::Value peer_json;
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        if (!reader->parse(reply.json.data(),
+                           reply.json.data() + reply.json.size(), &peer_json,
+                           nullptr)) {
+            LOG(WARNING) << "Corrupted segment descriptor, name "
+                         << segment_name;
+            return ERR_MALFORMED_JSON;
+        }
+        desc = decodeSegmentDesc(peer_json, segment_name);
+        if (!desc) return ERR_METADATA;
+    } else {
+        desc = std::make_shared<SegmentDesc>();
+        desc->name = reply.name;
+        desc->protocol = reply.protocol;
+        desc->tcp_data_port = reply.tcp_data_port;
+        desc->tcp_persistent = reply.tcp_persistent;
+        desc->timestamp = reply.timestamp;
+        for (auto &device : reply.devices) {
+            if (device.name.empty() || device.gid.empty()) {
+                LOG(WARNING) << "Corrupted segment descriptor, name "
+                             << segment_name << " protocol " << desc->protocol;
+                return ERR_METADATA;
+            }
+            desc->devices.push_back(DeviceDesc{
+                device.name, (uint16_t)device.lid, device.gid, device.dct_num});
+        }
+        for (auto &buffer : reply.buffers)
+            desc->buffers.push_back(TransferWireUtil::decode(buffer));
+        if (!reply.topology.empty() && desc->topology.parse(reply.topology)) {
+            LOG(WARNING) << "Corrupted segment descriptor, name "
+                         << segment_name << " protocol " << desc->protocol;
+        }
+    }
+    desc->instance_id = reply.instance_id;
+    desc->generation = reply.generation;
+    return 0;
+}
+
 std::shared_ptr<TransferMetadata::SegmentDesc> TransferMetadata::getSegmentDesc(
     const std::string &segment_name) {
     Json::Value peer_json;
 
     if (p2p_handshake_mode_) {
         auto [ip, port] = parseHostNameWithPort(segment_name);
-        Json::Value local_json;
         std::shared_ptr<SegmentDesc> desc;
-        {
-            RWSpinlock::ReadGuard guard(segment_lock_);
-            auto it = segment_id_to_desc_map_.find(LOCAL_SEGMENT_ID);
-            if (it == segment_id_to_desc_map_.end() || !it->second) {
-                LOG(ERROR) << "Local segment descriptor not found";
-                return nullptr;
-            }
-            desc = it->second;
-        }
-        int ret = encodeSegmentDesc(*desc.get(), local_json);
-        if (ret) {
-            return nullptr;
-        }
+        int ret = getSegmentDescBinary(segment_name, ip, port, desc);
+        if (ret == 0) return desc;
+        if (ret != ERR_NOT_IMPLEMENTED) return nullptr;
+        // The peer only speaks JSON and ignores the body of the request
+        Json::Value local_json;
+        local_json["name"] = segment_name;
         ret = handshake_plugin_->exchangeMetadata(ip, port, local_json,
                                                   peer_json);
         if (ret) {
             return nullptr;
         }
     } else {
+        return getSegmentDescFromStorage(segment_name);
+    }
+
+    return decodeSegmentDesc(peer_json, segment_name);
+}
+
+std::shared_ptr<TransferMetadata::SegmentDesc>
+TransferMetadata::getCachedPeerSegmentDesc(const std::string &segment_name) {
+    RWSpinlock::ReadGuard guard(segment_lock_);
+    auto it = segment_name_to_id_map_.find(segment_name);
+    if (it == segment_name_to_id_map_.end() || it->second == LOCAL_SEGMENT_ID)
+        return nullptr;
+    auto desc_it = segment_id_to_desc_map_.find(it->second);
+    if (desc_it == segment_id_to_desc_map_.end()) return nullptr;
+    return desc_it->second;
+}
+
+std::string TransferMetadata::getDeltaKey(const std::string &segment_name,
+                                          const std::string &suffix) const {
+    return common_key_prefix_ + "delta/" + segment_name + "/" + suffix;
+}
+
+int TransferMetadata::applyBufferDeltas(const std::string &segment_name,
+                                        SegmentDesc &desc,
+                                        uint64_t generation) {
+    if (generation <= desc.generation) return 0;
+    std::vector<std::string> keys;
+    for (uint64_t next = desc.generation + 1; next <= generation; ++next)
+        keys.push_back(getDeltaKey(segment_name, std::to_string(next)));
+    std::vector<Json::Value> deltas;
+    if (!storage_plugin_->getBatch(keys, deltas)) return ERR_METADATA;
+    for (auto &deltaJSON : deltas) {
+        BufferDesc buffer;
+        TransferBufferUtil::decode(deltaJSON["buffer"], buffer);
+        applyBufferChange(desc, deltaJSON["removed"].asBool(), buffer);
+        ++desc.generation;
+    }
+    return 0;
+}
+
+std::shared_ptr<TransferMetadata::SegmentDesc>
+TransferMetadata::getSegmentDescFromStorage(const std::string &segment_name) {
+    // A copy published incrementally only needs the deltas it misses
+    auto cached = getCachedPeerSegmentDesc(segment_name);
+    if (cached && !cached->generation) cached = nullptr;
+    for (int attempt = 0; attempt < kMaxSegmentDescReadAttempts; ++attempt) {
+        Json::Value headJSON;
+        if (cached &&
+            storage_plugin_->get(getDeltaKey(segment_name, "head"),
+                                 headJSON) &&
+            headJSON["instance_id"].asUInt64() == cached->instance_id &&
+            headJSON["snapshot"].asUInt64() <= cached->generation) {
+            auto generation = headJSON["generation"].asUInt64();
+            if (generation <= cached->generation) return cached;
+            auto desc = std::make_shared<SegmentDesc>(*cached);
+            if (!applyBufferDeltas(segment_name, *desc, generation))
+                return desc;
+        }
+        cached = nullptr;
+
+        Json::Value segmentJSON;
         if (!storage_plugin_->get(getFullMetadataKey(segment_name),
-                                  peer_json)) {
+                                  segmentJSON)) {
             LOG(WARNING) << "Failed to retrieve segment descriptor, name "
                          << segment_name;
             return nullptr;
         }
+        auto desc = decodeSegmentDesc(segmentJSON, segment_name);
+        if (!desc || !desc->generation) return desc;
+        if (!storage_plugin_->get(getDeltaKey(segment_name, "head"),
+                                  headJSON) ||
+            headJSON["instance_id"].asUInt64() != desc->instance_id)
+            return desc;
+        if (!applyBufferDeltas(segment_name, *desc,
+                               headJSON["generation"].asUInt64()))
+            return desc;
+        // The deltas were folded into a newer descriptor meanwhile
     }
-
-    return decodeSegmentDesc(peer_json, segment_name);
+    LOG(WARNING) << "Segment descriptor keeps changing, name "
+                 << segment_name;
+    return nullptr;
 }
 
 int TransferMetadata::syncSegmentCache(const std::string &segment_name) {
@@ -547,6 +1093,13 @@ int TransferMetadata::syncSegmentCache(const std::string &segment_name) {
             names_to_sync.push_back(entry.second->name);
         }
     }
+    // Only the segments notified as changed need a refresh
+    if (watching_) {
+        std::vector<std::string> stale_names;
+        for (auto &name : names_to_sync)
+            if (takeStaleSegment(name)) stale_names.push_back(name);
+        names_to_sync.swap(stale_names);
+    }
 
     // Fetch updates without holding lock (may involve network I/O)
     std::vector<std::pair<std::string, std::shared_ptr<SegmentDesc>>> updates;
@@ -556,6 +1109,7 @@ int TransferMetadata::syncSegmentCache(const std::string &segment_name) {
             updates.emplace_back(name, segment_desc);
         } else {
             LOG(WARNING) << "segment " << name << " is now invalid";
+            if (watching_) markSegmentStale(name);
         }
     }
 
@@ -573,7 +1127,8 @@ int TransferMetadata::syncSegmentCache(const std::string &segment_name) {
 std::shared_ptr<TransferMetadata::SegmentDesc>
 TransferMetadata::getSegmentDescByName(const std::string &segment_name,
                                        bool force_update) {
-    if (globalConfig().metacache && !force_update) {
+    bool stale = takeStaleSegment(segment_name);
+    if (globalConfig().metacache && !force_update && !stale) {
         RWSpinlock::ReadGuard guard(segment_lock_);
         auto iter = segment_name_to_id_map_.find(segment_name);
         if (iter != segment_name_to_id_map_.end())
@@ -592,7 +1147,10 @@ TransferMetadata::getSegmentDescByName(const std::string &segment_name,
 
     // Fetch segment descriptor without holding lock (may involve network I/O)
     auto segment_desc = this->getSegmentDesc(segment_name);
-    if (!segment_desc) return nullptr;
+    if (!segment_desc) {
+        if (stale) markSegmentStale(segment_name);
+        return nullptr;
+    }
 
     // Update cache with write lock
     RWSpinlock::WriteGuard guard(segment_lock_);
@@ -610,8 +1168,15 @@ TransferMetadata::getSegmentDescByName(const std::string &segment_name,
 
 std::shared_ptr<TransferMetadata::SegmentDesc>
 TransferMetadata::getSegmentDescByID(SegmentID segment_id, bool force_update) {
-    if (segment_id != LOCAL_SEGMENT_ID &&
-        (!globalConfig().metacache || force_update)) {
+    bool refresh = !globalConfig().metacache || force_update;
+    if (segment_id != LOCAL_SEGMENT_ID && !refresh &&
+        num_stale_segments_.load(std::memory_order_relaxed)) {
+        RWSpinlock::ReadGuard guard(segment_lock_);
+        auto iter = segment_id_to_desc_map_.find(segment_id);
+        if (iter != segment_id_to_desc_map_.end())
+            refresh = takeStaleSegment(iter->second->name);
+    }
+    if (segment_id != LOCAL_SEGMENT_ID && refresh) {
         // Get segment name without holding lock during network I/O
         std::string segment_name;
         {
@@ -623,7 +1188,10 @@ TransferMetadata::getSegmentDescByID(SegmentID segment_id, bool force_update) {
         // Fetch segment descriptor without holding lock (may involve network
         // I/O)
         auto segment_desc = getSegmentDesc(segment_name);
-        if (!segment_desc) return nullptr;
+        if (!segment_desc) {
+            if (watching_) markSegmentStale(segment_name);
+            return nullptr;
+        }
 
         // Update cache with write lock
         RWSpinlock::WriteGuard guard(segment_lock_);
@@ -659,17 +1227,121 @@ TransferMetadata::SegmentID TransferMetadata::getSegmentID(
 }
 
 int TransferMetadata::updateLocalSegmentDesc(uint64_t segment_id) {
+    if (segment_id == LOCAL_SEGMENT_ID && !p2p_handshake_mode_ &&
+        globalConfig().metadata_incremental) {
+        std::lock_guard<std::mutex> lock(publish_mutex_);
+        return publishLocalSegmentDescUnlocked();
+    }
     RWSpinlock::ReadGuard guard(segment_lock_);
     auto desc = segment_id_to_desc_map_[segment_id];
     return this->updateSegmentDesc(desc->name, *desc);
 }
 
+// Publishes the whole local descriptor and drops the deltas it replaces,
+// publish_mutex_ must be held
+int TransferMetadata::publishLocalSegmentDescUnlocked() {
+    std::string segment_name;
+    uint64_t instance_id, generation;
+    {
+        RWSpinlock::ReadGuard guard(segment_lock_);
+        auto desc = segment_id_to_desc_map_[LOCAL_SEGMENT_ID];
+        segment_name = desc->name;
+        instance_id = desc->instance_id;
+        generation = desc->generation;
+        int ret = updateSegmentDesc(desc->name, *desc);
+        if (ret) return ret;
+    }
+
+    Json::Value headJSON;
+    headJSON["instance_id"] = static_cast<Json::UInt64>(instance_id);
+    headJSON["snapshot"] = static_cast<Json::UInt64>(generation);
+    headJSON["generation"] = static_cast<Json::UInt64>(generation);
+    if (!storage_plugin_->set(getDeltaKey(segment_name, "head"), headJSON)) {
+        LOG(ERROR) << "Failed to register segment descriptor head, name "
+                   << segment_name;
+        return ERR_METADATA;
+    }
+    for (uint64_t stale = published_snapshot_ + 1;
+         stale <= published_generation_; ++stale)
+        storage_plugin_->remove(
+            getDeltaKey(segment_name, std::to_string(stale)));
+    published_snapshot_ = generation;
+    published_generation_ = generation;
+    return 0;
+}
+
+int TransferMetadata::publishLocalBufferChanges() {
+    if (p2p_handshake_mode_ || !globalConfig().metadata_incremental)
+        return updateLocalSegmentDesc();
+
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    std::string segment_name;
+    uint64_t instance_id;
+    size_t num_buffers;
+    std::vector<BufferChange> pending;
+    bool snapshot = !published_generation_;
+    {
+        RWSpinlock::ReadGuard guard(segment_lock_);
+        auto &desc = segment_id_to_desc_map_[LOCAL_SEGMENT_ID];
+        segment_name = desc->name;
+        instance_id = desc->instance_id;
+        num_buffers = desc->buffers.size();
+        // Changes dropped from the history can only be published whole
+        if (published_generation_ < local_generation_ &&
+            (local_buffer_changes_.empty() ||
+             local_buffer_changes_.front().generation >
+                 published_generation_ + 1))
+            snapshot = true;
+        for (auto &change : local_buffer_changes_)
+            if (change.generation > published_generation_)
+                pending.push_back(change);
+    }
+    size_t num_deltas =
+        published_generation_ - published_snapshot_ + pending.size();
+    if (num_deltas > std::max(kMinDeltasBeforeSnapshot, num_buffers))
+        snapshot = true;
+    if (snapshot) return publishLocalSegmentDescUnlocked();
+
+    if (pending.empty()) return 0;
+    std::vector<std::pair<std::string, Json::Value>> entries;
+    for (auto &change : pending) {
+        Json::Value deltaJSON;
+        deltaJSON["removed"] = change.removed;
+        deltaJSON["buffer"] = TransferBufferUtil::encode(change.buffer);
+        entries.emplace_back(
+            getDeltaKey(segment_name, std::to_string(change.generation)),
+            std::move(deltaJSON));
+    }
+    // Readers follow the head, so it moves only once the deltas are there
+    uint64_t generation = pending.back().generation;
+    Json::Value headJSON;
+    headJSON["instance_id"] = static_cast<Json::UInt64>(instance_id);
+    headJSON["snapshot"] = static_cast<Json::UInt64>(published_snapshot_);
+    headJSON["generation"] = static_cast<Json::UInt64>(generation);
+    entries.emplace_back(getDeltaKey(segment_name, "head"),
+                         std::move(headJSON));
+    if (!storage_plugin_->setBatch(entries)) {
+        LOG(ERROR) << "Failed to register segment descriptor deltas, name "
+                   << segment_name;
+        return ERR_METADATA;
+    }
+    published_generation_ = generation;
+    return 0;
+}
+
 int TransferMetadata::addLocalSegment(SegmentID segment_id,
                                       const std::string &segment_name,
                                       std::shared_ptr<SegmentDesc> &&desc) {
     RWSpinlock::WriteGuard guard(segment_lock_);
     segment_id_to_desc_map_[segment_id] = desc;
     segment_name_to_id_map_[segment_name] = segment_id;
+    if (segment_id == LOCAL_SEGMENT_ID) {
+        // Peers must fetch the new descriptor as a whole
+        ++local_generation_;
+        local_buffer_changes_.clear();
+        desc->instance_id = local_instance_id_;
+        desc->generation = local_generation_;
+    }
     return 0;
 }
 
@@ -692,8 +1364,10 @@ int TransferMetadata::addLocalMemoryBuffer(const BufferDesc &buffer_desc,
         *new_segment_desc = *segment_desc;
         segment_desc = new_segment_desc;
         segment_desc->buffers.push_back(buffer_desc);
+        recordLocalBufferChange(false, buffer_desc);
+        segment_desc->generation = local_generation_;
     }
-    if (update_metadata) return updateLocalSegmentDesc();
+    if (update_metadata) return publishLocalBufferChanges();
     return 0;
 }
 
@@ -714,6 +1388,8 @@ int TransferMetadata::removeLocalMemoryBuffer(void *addr,
                 (iter->offset + segment_desc->cxl_base_addr) == (uint64_t)addr
 #endif
             ) {
+                recordLocalBufferChange(true, *iter);
+                segment_desc->generation = local_generation_;
                 segment_desc->buffers.erase(iter);
                 addr_exist = true;
                 break;
@@ -721,12 +1397,33 @@ int TransferMetadata::removeLocalMemoryBuffer(void *addr,
         }
     }
     if (addr_exist) {
-        if (update_metadata) return updateLocalSegmentDesc();
+        if (update_metadata) return publishLocalBufferChanges();
         return 0;
     }
     return ERR_ADDRESS_NOT_REGISTERED;
 }
 
+void TransferMetadata::recordLocalBufferChange(bool removed,
+                                               const BufferDesc &buffer) {
+    local_buffer_changes_.push_back(
+        BufferChange{++local_generation_, removed, buffer});
+    if (local_buffer_changes_.size() > kMaxBufferChanges)
+        local_buffer_changes_.pop_front();
+}
+
+bool TransferMetadata::isJsonOnlyPeer(const std::string &ip, uint16_t port) {
+    RWSpinlock::ReadGuard guard(json_only_lock_);
+    return json_only_peers_.count(ip + ":" + std::to_string(port));
+}
+
+void TransferMetadata::markJsonOnlyPeer(const std::string &ip, uint16_t port) {
+    auto location = ip + ":" + std::to_string(port);
+    LOG(INFO) << "Peer " << location
+              << " does not accept binary messages, falling back to JSON";
+    RWSpinlock::WriteGuard guard(json_only_lock_);
+    json_only_peers_.insert(location);
+}
+
 int TransferMetadata::addRpcMetaEntry(const std::string &server_name,
                                       RpcMetaDesc &desc) {
     local_rpc_meta_ = desc;
@@ -736,6 +1433,11 @@ int TransferMetadata::addRpcMetaEntry(const std::string &server_name,
             [this](const Json::Value &peer, Json::Value &local) -> int {
                 return receivePeerMetadata(peer, local);
             });
+        handshake_plugin_->registerOnBinaryCallBack(
+            HandShakeRequestType::MetadataBinary,
+            [this](const std::string &peer, std::string &local) -> int {
+                return receivePeerMetadataBinary(peer, local);
+            });
         handshake_plugin_->registerOnNotifyCallBack(
             [this](const Json::Value &peer, Json::Value &local) -> int {
                 return receivePeerNotify(peer, local);
@@ -746,6 +1448,8 @@ int TransferMetadata::addRpcMetaEntry(const std::string &server_name,
             return rc;
         }
 
+        if (globalConfig().p2p_gossip_interval_ms && !gossip_thread_.joinable())
+            gossip_thread_ = std::thread(&TransferMetadata::runGossip, this);
         return 0;
     }
 
@@ -759,6 +1463,62 @@ int TransferMetadata::addRpcMetaEntry(const std::string &server_name,
     return 0;
 }
 
+std::string TransferMetadata::localSegmentName() {
+    RWSpinlock::ReadGuard guard(segment_lock_);
+    auto it = segment_id_to_desc_map_.find(LOCAL_SEGMENT_ID);
+    if (it == segment_id_to_desc_map_.end() || !it->second) return "";
+    return it->second->name;
+}
+
+void TransferMetadata::addKnownSegments(
+    const std::vector<std::string> &segment_names) {
+    if (segment_names.empty()) return;
+    auto local_name = localSegmentName();
+    RWSpinlock::WriteGuard guard(known_segments_lock_);
+    for (auto &name : segment_names)
+        if (name != local_name) known_segments_.insert(name);
+}
+
+std::vector<std::string> TransferMetadata::sampleKnownSegments(size_t count) {
+    RWSpinlock::ReadGuard guard(known_segments_lock_);
+    std::vector<std::string> names(known_segments_.begin(),
+                                   known_segments_.end());
+    if (names.size() > count) {
+        std::shuffle(names.begin(), names.end(),
+                     std::mt19937(getCurrentTimeInNano()));
+        names.resize(count);
+    }
+    return names;
+}
+
+std::vector<std::string> TransferMetadata::getKnownSegments() {
+    RWSpinlock::ReadGuard guard(known_segments_lock_);
+    return std::vector<std::string>(known_segments_.begin(),
+                                    known_segments_.end());
+}
+
+// Refreshes one random known segment per round, which spreads the known
+// segments of both sides and keeps the cache warm. Unreachable segments
+// are forgotten until some peer mentions them again.
+void TransferMetadata::runGossip() {
+    auto interval =
+        std::chrono::milliseconds(globalConfig().p2p_gossip_interval_ms);
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(gossip_mutex_);
+            if (gossip_cv_.wait_for(lock, interval,
+                                    [this] { return gossip_stopped_; }))
+                return;
+        }
+        auto sample = sampleKnownSegments(1);
+        if (sample.empty()) continue;
+        if (!getSegmentDescByName(sample[0], true)) {
+            RWSpinlock::WriteGuard guard(known_segments_lock_);
+            known_segments_.erase(sample[0]);
+        }
+    }
+}
+
 int TransferMetadata::removeRpcMetaEntry(const std::string &server_name) {
     if (p2p_handshake_mode_) {
         return 0;
@@ -803,6 +1563,22 @@ int TransferMetadata::startHandshakeDaemon(
     handshake_plugin_->registerOnConnectionCallBack(
         [on_receive_handshake](const Json::Value &peer,
                                Json::Value &local) -> int {
+            if (peer.isMember("batch")) {
+                // Every handshake of the batch gets its own reply
+                Json::Value reply_list(Json::arrayValue);
+                for (const auto &entry : peer["batch"]) {
+                    HandShakeDesc local_desc, peer_desc;
+                    TransferHandshakeUtil::decode(entry, peer_desc);
+                    if (on_receive_handshake &&
+                        on_receive_handshake(peer_desc, local_desc) &&
+                        local_desc.reply_msg.empty())
+                        local_desc.reply_msg = "Handshake failed";
+                    reply_list.append(
+                        TransferHandshakeUtil::encode(local_desc));
+                }
+                local["batch"] = reply_list;
+                return 0;
+            }
             HandShakeDesc local_desc, peer_desc;
             TransferHandshakeUtil::decode(peer, peer_desc);
             if (on_receive_handshake) {
@@ -812,6 +1588,27 @@ int TransferMetadata::startHandshakeDaemon(
             local = TransferHandshakeUtil::encode(local_desc);
             return 0;
         });
+    handshake_plugin_->registerOnBinaryCallBack(
+        HandShakeRequestType::ConnectionBinary,
+        [on_receive_handshake](const std::string &peer,
+                               std::string &local) -> int {
+            HandShakeListWire request, reply{};
+            if (!TransferWireUtil::deserialize(peer, request))
+                return ERR_METADATA;
+            reply.version = kMetadataWireVersion;
+            for (auto &entry : request.handshakes) {
+                HandShakeDesc local_desc, peer_desc;
+                TransferWireUtil::decode(entry, peer_desc);
+                if (on_receive_handshake &&
+                    on_receive_handshake(peer_desc, local_desc) &&
+                    local_desc.reply_msg.empty())
+                    local_desc.reply_msg = "Handshake failed";
+                reply.handshakes.push_back(
+                    TransferWireUtil::encode(local_desc));
+            }
+            local = TransferWireUtil::serialize(reply);
+            return 0;
+        });
     handshake_plugin_->registerOnNotifyCallBack(
         [this](const Json::Value &peer, Json::Value &local) -> int {
             return receivePeerNotify(peer, local);
@@ -824,6 +1621,34 @@ int TransferMetadata::startHandshakeDaemon(
     return 0;
 }
 
+int TransferMetadata::sendHandshakeBinary(
+    const RpcMetaDesc &peer_location,
+    const std::vector<HandShakeDesc> &local_desc_list,
+    std::vector<HandShakeDesc> &peer_desc_list) {
+    auto &ip = peer_location.ip_or_host_name;
+    if (isJsonOnlyPeer(ip, peer_location.rpc_port)) return ERR_NOT_IMPLEMENTED;
+    HandShakeListWire request{};
+    request.version = kMetadataWireVersion;
+    for (auto &local_desc : local_desc_list)
+        request.handshakes.push_back(TransferWireUtil::encode(local_desc));
+    std::string peer;
+    int ret = handshake_plugin_->sendBinary(
+        ip, peer_location.rpc_port, HandShakeRequestType::ConnectionBinary,
+        TransferWireUtil::serialize(request), peer);
+    if (ret == ERR_NOT_IMPLEMENTED)
+        markJsonOnlyPeer(ip, peer_location.rpc_port);
+    if (ret) return ret;
+    HandShakeListWire reply;
+    if (!TransferWireUtil::deserialize(peer, reply) ||
+        reply.handshakes.size() != local_desc_list.size())
+        return ERR_METADATA;
+    peer_desc_list.clear();
+    peer_desc_list.resize(local_desc_list.size());
+    for (size_t i = 0; i < reply.handshakes.size(); ++i)
+        TransferWireUtil::decode(reply.handshakes[i], peer_desc_list[i]);
+    return 0;
+}
+
 int TransferMetadata::sendHandshake(const std::string &peer_server_name,
                                     const HandShakeDesc &local_desc,
                                     HandShakeDesc &peer_desc) {
@@ -831,12 +1656,20 @@ int TransferMetadata::sendHandshake(const std::string &peer_server_name,
     if (getRpcMetaEntry(peer_server_name, peer_location)) {
         return ERR_METADATA;
     }
-    auto local = TransferHandshakeUtil::encode(local_desc);
-    Json::Value peer;
-    int ret = handshake_plugin_->send(peer_location.ip_or_host_name,
+    std::vector<HandShakeDesc> peer_desc_list;
+    int ret = sendHandshakeBinary(peer_location, {local_desc}, peer_desc_list);
+    if (ret == 0) {
+        peer_desc = peer_desc_list[0];
+    } else if (ret == ERR_NOT_IMPLEMENTED) {
+        auto local = TransferHandshakeUtil::encode(local_desc);
+        Json::Value peer;
+        ret = handshake_plugin_->send(peer_location.ip_or_host_name,
                                       peer_location.rpc_port, local, peer);
-    if (ret) return ret;
-    TransferHandshakeUtil::decode(peer, peer_desc);
+        if (ret) return ret;
+        TransferHandshakeUtil::decode(peer, peer_desc);
+    } else {
+        return ret;
+    }
     if (!peer_desc.reply_msg.empty()) {
         LOG(ERROR) << "Handshake rejected by " << peer_server_name << ": "
                    << peer_desc.reply_msg;
@@ -845,6 +1678,36 @@ int TransferMetadata::sendHandshake(const std::string &peer_server_name,
     return 0;
 }
 
+int TransferMetadata::sendHandshakeBatch(
+    const std::string &peer_server_name,
+    const std::vector<HandShakeDesc> &local_desc_list,
+    std::vector<HandShakeDesc> &peer_desc_list) {
+    RpcMetaDesc peer_location;
+    if (getRpcMetaEntry(peer_server_name, peer_location)) {
+        return ERR_METADATA;
+    }
+    int ret = sendHandshakeBinary(peer_location, local_desc_list,
+                                  peer_desc_list);
+    if (ret != ERR_NOT_IMPLEMENTED) return ret;
+    Json::Value local, peer;
+    Json::Value local_list(Json::arrayValue);
+    for (auto &local_desc : local_desc_list)
+        local_list.append(TransferHandshakeUtil::encode(local_desc));
+    local["batch"] = local_list;
+    ret = handshake_plugin_->send(peer_location.ip_or_host_name,
+                                  peer_location.rpc_port, local, peer);
+    if (ret) return ret;
+    // Servers not knowing batches do not reply with one
+    if (!peer.isMember("batch") ||
+        peer["batch"].size() != local_desc_list.size())
+        return ERR_METADATA;
+    peer_desc_list.clear();
+    peer_desc_list.resize(local_desc_list.size());
+    for (Json::ArrayIndex i = 0; i < peer["batch"].size(); ++i)
+        TransferHandshakeUtil::decode(peer["batch"][i], peer_desc_list[i]);
+    return 0;
+}
+
 int TransferMetadata::sendNotify(const std::string &peer_server_name,
                                  const NotifyDesc &local_desc,
                                  NotifyDesc &peer_desc) {
@@ -68,65 +68,72 @@ namespace mooncake {
 #ifdef USE_REDIS
 struct RedisStoragePlugin : public MetadataStoragePlugin {
     RedisStoragePlugin(const std::string &metadata_uri)
-        : client_(nullptr), metadata_uri_(metadata_uri) {
-        auto hostname_port = parseHostNameWithPort(metadata_uri);
-        client_ =
-            redisConnect(hostname_port.first.c_str(), hostname_port.second);
-        if (!client_) {
-            LOG(ERROR) << "RedisStoragePlugin: unable to connect "
-                       << metadata_uri_;
-            return;
+        : RedisStoragePlugin(metadata_uri, "", 0) {}
+
+    RedisStoragePlugin(const std::string &metadata_uri,
+                       const std::string &password, const uint8_t &db_index)
+        : client_(nullptr),
+          metadata_uri_(metadata_uri),
+          password_(password),
+          db_index_(db_index) {
+        client_ = connect();
+    }
+
+    virtual ~RedisStoragePlugin() {
+        if (watch_thread_.joinable()) {
+            watch_stopped_ = true;
+            int fd = watch_fd_.load();
+            if (fd >= 0) shutdown(fd, SHUT_RDWR);
+            watch_thread_.join();
         }
-        if (client_->err) {
-            LOG(ERROR) << "RedisStoragePlugin: unable to connect "
-                       << metadata_uri_ << ": " << client_->errstr;
+        if (client_) {
             redisFree(client_);
             client_ = nullptr;
-            return;
         }
     }
 
-    RedisStoragePlugin(const std::string &metadata_uri,
-                       const std::string &password, const uint8_t &db_index)
-        : RedisStoragePlugin(metadata_uri) {
-        if (!client_) {
-            return;
+    redisContext *connect() {
+        auto hostname_port = parseHostNameWithPort(metadata_uri_);
+        auto client =
+            redisConnect(hostname_port.first.c_str(), hostname_port.second);
+        if (!client) {
+            LOG(ERROR) << "RedisStoragePlugin: unable to connect "
+                       << metadata_uri_;
+            return nullptr;
+        }
+        if (client->err) {
+            LOG(ERROR) << "RedisStoragePlugin: unable to connect "
+                       << metadata_uri_ << ": " << client->errstr;
+            redisFree(client);
+            return nullptr;
         }
 
-        if (!password.empty()) {
+        if (!password_.empty()) {
             auto *reply = static_cast<redisReply *>(
-                redisCommand(client_, "AUTH %s", password.c_str()));
+                redisCommand(client, "AUTH %s", password_.c_str()));
             if (!reply || reply->type == REDIS_REPLY_ERROR) {
                 LOG(ERROR) << "RedisStoragePlugin: authentication failed for "
                            << metadata_uri_;
                 freeReplyObject(reply);
-                redisFree(client_);
-                client_ = nullptr;
-                return;
+                redisFree(client);
+                return nullptr;
             }
             freeReplyObject(reply);
         }
 
-        if (db_index != 0) {
+        if (db_index_ != 0) {
             auto *reply = static_cast<redisReply *>(
-                redisCommand(client_, "SELECT %d", db_index));
+                redisCommand(client, "SELECT %d", db_index_));
             if (!reply || reply->type == REDIS_REPLY_ERROR) {
                 LOG(ERROR) << "RedisStoragePlugin: failed to select database "
-                           << (int)db_index << " for " << metadata_uri_;
+                           << (int)db_index_ << " for " << metadata_uri_;
                 freeReplyObject(reply);
-                redisFree(client_);
-                client_ = nullptr;
-                return;
+                redisFree(client);
+                return nullptr;
             }
             freeReplyObject(reply);
         }
-    }
-
-    virtual ~RedisStoragePlugin() {
-        if (client_) {
-            redisFree(client_);
-            client_ = nullptr;
-        }
+        return client;
     }
 
     virtual bool get(const std::string &key, Json::Value &value) {
@@ -190,9 +197,74 @@ struct RedisStoragePlugin : public MetadataStoragePlugin {
         return true;
     }
 
+    // Follows keyspace notifications on a connection of its own
+    virtual bool watch(const std::string &prefix, OnChangeCallBack callback) {
+        {
+            std::lock_guard<std::mutex> lock(access_client_mutex_);
+            if (!client_) return false;
+            auto *reply = static_cast<redisReply *>(redisCommand(
+                client_, "CONFIG SET notify-keyspace-events K$g"));
+            if (!reply || reply->type == REDIS_REPLY_ERROR) {
+                LOG(WARNING) << "RedisStoragePlugin: unable to enable keyspace "
+                                "notifications of "
+                             << metadata_uri_
+                             << ", make sure notify-keyspace-events "
+                                "includes K$g";
+            }
+            freeReplyObject(reply);
+        }
+        auto channel_prefix = "__keyspace@" + std::to_string(db_index_) + "__:";
+        watch_thread_ = std::thread([this, prefix, channel_prefix, callback]() {
+            while (!watch_stopped_) {
+                redisContext *client = connect();
+                if (client) {
+                    auto *reply = static_cast<redisReply *>(
+                        redisCommand(client, "PSUBSCRIBE %s%s*",
+                                     channel_prefix.c_str(), prefix.c_str()));
+                    if (!reply || reply->type == REDIS_REPLY_ERROR) {
+                        redisFree(client);
+                        client = nullptr;
+                    }
+                    freeReplyObject(reply);
+                }
+                if (client) {
+                    watch_fd_ = client->fd;
+                    if (watch_stopped_) {
+                        redisFree(client);
+                        break;
+                    }
+                    // Changes may have been missed while not subscribed
+                    callback("");
+                    redisReply *reply = nullptr;
+                    while (redisGetReply(client, (void **)&reply) == REDIS_OK) {
+                        // pmessage, pattern, channel, event
+                        if (reply->type == REDIS_REPLY_ARRAY &&
+                            reply->elements == 4 && reply->element[2]->str) {
+                            std::string channel(reply->element[2]->str,
+                                                reply->element[2]->len);
+                            callback(channel.substr(channel_prefix.size()));
+                        }
+                        freeReplyObject(reply);
+                    }
+                    watch_fd_ = -1;
+                    redisFree(client);
+                }
+                for (int i = 0; i < 10 && !watch_stopped_; ++i)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        });
+        return true;
+    }
+
     redisContext *client_;
     const std::string metadata_uri_;
+    const std::string password_;
+    const uint8_t db_index_;
     std::mutex access_client_mutex_;
+
+    std::thread watch_thread_;
+    std::atomic<bool> watch_stopped_{false};
+    std::atomic<int> watch_fd_{-1};
 };
 #endif  // USE_REDIS
 
@@ -203,7 +275,12 @@ struct HTTPStoragePlugin : public MetadataStoragePlugin {
         global_init_once();
     }
 
-    ~HTTPStoragePlugin() override = default;
+    ~HTTPStoragePlugin() override {
+        if (watch_thread_.joinable()) {
+            watch_stopped_ = true;
+            watch_thread_.join();
+        }
+    }
 
     static void global_init_once() {
         static std::once_flag once;
@@ -229,6 +306,8 @@ struct HTTPStoragePlugin : public MetadataStoragePlugin {
         ThreadLocalCurl &operator=(const ThreadLocalCurl &) = delete;
     };
 
+    // curl_easy_reset() keeps the open connections of the handle, so the
+    // requests of a thread share one keep-alive connection
     static CURL *tl_easy() {
         thread_local ThreadLocalCurl tls;
         return tls.h;
@@ -378,8 +457,217 @@ struct HTTPStoragePlugin : public MetadataStoragePlugin {
         return true;
     }
 
+    // POST <metadata_uri>/batch_get with {"keys": [...]}, answered by
+    // {"values": {key: value}} without the missing keys. Servers without
+    // the endpoint are asked one key at a time.
+    bool getBatch(const std::vector<std::string> &keys,
+                  std::vector<Json::Value> &values) override {
+        if (keys.size() < 2 || batch_unsupported_)
+            return MetadataStoragePlugin::getBatch(keys, values);
+
+        Json::Value request;
+        auto &keysJSON = request["keys"];
+        keysJSON = Json::Value(Json::arrayValue);
+        for (const auto &key : keys) keysJSON.append(key);
+
+        std::string readBody;
+        if (!postBatch("batch_get", request, readBody)) {
+            if (!batch_unsupported_) return false;
+            return MetadataStoragePlugin::getBatch(keys, values);
+        }
+
+        Json::Value response;
+        std::string errs;
+        if (!parseJsonString(readBody, response, &errs)) {
+            LOG(ERROR) << "POST batch_get json parse error: " << errs;
+            return false;
+        }
+        const auto &found = response["values"];
+        values.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!found.isMember(keys[i])) {
+                LOG(ERROR) << "POST batch_get: " << keys[i] << " not found";
+                return false;
+            }
+            if (!parseJsonString(found[keys[i]].asString(), values[i],
+                                 &errs)) {
+                LOG(ERROR) << "POST batch_get " << keys[i]
+                           << " json parse error: " << errs;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // POST <metadata_uri>/batch_put with {"entries": [{"key", "value"}]}
+    bool setBatch(const std::vector<std::pair<std::string, Json::Value>>
+                      &entries) override {
+        if (entries.size() < 2 || batch_unsupported_)
+            return MetadataStoragePlugin::setBatch(entries);
+
+        Json::StreamWriterBuilder wb;
+        wb["indentation"] = "";
+        Json::Value request;
+        auto &entriesJSON = request["entries"];
+        entriesJSON = Json::Value(Json::arrayValue);
+        for (const auto &entry : entries) {
+            Json::Value entryJSON;
+            entryJSON["key"] = entry.first;
+            entryJSON["value"] = Json::writeString(wb, entry.second);
+            entriesJSON.append(entryJSON);
+        }
+
+        std::string readBody;
+        if (!postBatch("batch_put", request, readBody)) {
+            if (!batch_unsupported_) return false;
+            return MetadataStoragePlugin::setBatch(entries);
+        }
+        return true;
+    }
+
+    // Long-polls GET <metadata_uri>/watch?prefix=<prefix>&since=<revision>,
+    // answered once keys changed after the revision, or after a timeout, by
+    // {"revision": N, "keys": [...]}, with "reset": true if the changes
+    // since the revision are no longer known. Without since, the current
+    // revision is returned at once.
+    bool watch(const std::string &prefix, OnChangeCallBack callback) override {
+        Json::Value changes;
+        long code = 0;
+        if (!pollChanges(prefix, "", changes, code)) {
+            if (code == 404)
+                LOG(WARNING) << "HTTPStoragePlugin: " << metadata_uri_
+                             << " does not support watches";
+            return false;
+        }
+        auto revision = changes["revision"].asString();
+        watch_thread_ = std::thread([this, prefix, callback, revision]() {
+            std::string since = revision;
+            while (!watch_stopped_) {
+                Json::Value changes;
+                long code = 0;
+                if (!pollChanges(prefix, since, changes, code)) {
+                    for (int i = 0; i < 10 && !watch_stopped_; ++i)
+                        std::this_thread::sleep_for(
+                            std::chrono::milliseconds(100));
+                    continue;
+                }
+                if (changes["reset"].asBool()) callback("");
+                for (const auto &key : changes["keys"])
+                    callback(key.asString());
+                since = changes["revision"].asString();
+            }
+        });
+        return true;
+    }
+
    private:
+    static int abortOnStop(void *stopped, curl_off_t, curl_off_t, curl_off_t,
+                           curl_off_t) {
+        return static_cast<std::atomic<bool> *>(stopped)->load() ? 1 : 0;
+    }
+
+    // Sets batch_unsupported_ if the server has no such endpoint
+    bool postBatch(const std::string &endpoint, const Json::Value &request,
+                   std::string &readBody) {
+        CURL *h = tl_easy();
+        curl_easy_reset(h);
+
+        Json::StreamWriterBuilder wb;
+        wb["indentation"] = "";
+        const std::string payload = Json::writeString(wb, request);
+
+        char errbuf[CURL_ERROR_SIZE] = {0};
+
+        curl_easy_setopt(h, CURLOPT_TIMEOUT_MS, 3000L);
+        curl_easy_setopt(h, CURLOPT_CONNECTTIMEOUT_MS, 1500L);
+
+        const std::string url = metadata_uri_ + "/" + endpoint;
+        curl_easy_setopt(h, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(h, CURLOPT_POST, 1L);
+        curl_easy_setopt(h, CURLOPT_POSTFIELDS, payload.c_str());
+        curl_easy_setopt(h, CURLOPT_POSTFIELDSIZE, payload.size());
+        curl_easy_setopt(h, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(h, CURLOPT_WRITEDATA, &readBody);
+        curl_easy_setopt(h, CURLOPT_ERRORBUFFER, errbuf);
+
+        struct curl_slist *headers = nullptr;
+        headers = curl_slist_append(headers, "Content-Type: application/json");
+        curl_easy_setopt(h, CURLOPT_HTTPHEADER, headers);
+
+        CURLcode rc = curl_easy_perform(h);
+        curl_slist_free_all(headers);
+
+        if (rc != CURLE_OK) {
+            LOG(ERROR) << "POST " << url << " curl: " << curl_easy_strerror(rc)
+                       << " err: " << errbuf;
+            return false;
+        }
+
+        long code = 0;
+        curl_easy_getinfo(h, CURLINFO_RESPONSE_CODE, &code);
+        if (code == 404 || code == 405) {
+            LOG(INFO) << "HTTPStoragePlugin: " << metadata_uri_
+                      << " has no batch endpoints, using single requests";
+            batch_unsupported_ = true;
+            return false;
+        }
+        if (!is_200(code)) {
+            LOG(ERROR) << "POST " << url << " http=" << code
+                       << " body: " << readBody;
+            return false;
+        }
+        return true;
+    }
+
+    bool pollChanges(const std::string &prefix, const std::string &since,
+                     Json::Value &changes, long &code) {
+        CURL *h = tl_easy();
+        curl_easy_reset(h);
+
+        std::string readBody;
+        char errbuf[CURL_ERROR_SIZE] = {0};
+
+        curl_easy_setopt(h, CURLOPT_TIMEOUT_MS, 60000L);
+        curl_easy_setopt(h, CURLOPT_CONNECTTIMEOUT_MS, 1500L);
+
+        char *esc = curl_easy_escape(h, prefix.c_str(),
+                                     static_cast<int>(prefix.size()));
+        std::string url = metadata_uri_ + "/watch?prefix=" + (esc ? esc : "");
+        if (!since.empty()) url += "&since=" + since;
+        if (esc) curl_free(esc);
+        curl_easy_setopt(h, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(h, CURLOPT_HTTPGET, 1L);
+        curl_easy_setopt(h, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(h, CURLOPT_WRITEDATA, &readBody);
+        curl_easy_setopt(h, CURLOPT_ERRORBUFFER, errbuf);
+        curl_easy_setopt(h, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(h, CURLOPT_XFERINFOFUNCTION, abortOnStop);
+        curl_easy_setopt(h, CURLOPT_XFERINFODATA, &watch_stopped_);
+
+        CURLcode rc = curl_easy_perform(h);
+        if (rc != CURLE_OK) {
+            if (!watch_stopped_)
+                LOG(ERROR) << "GET " << url
+                           << " curl: " << curl_easy_strerror(rc)
+                           << " err: " << errbuf;
+            return false;
+        }
+
+        curl_easy_getinfo(h, CURLINFO_RESPONSE_CODE, &code);
+        if (!is_200(code)) return false;
+
+        std::string errs;
+        if (!parseJsonString(readBody, changes, &errs)) {
+            LOG(ERROR) << "GET " << url << " json parse error: " << errs;
+            return false;
+        }
+        return true;
+    }
+
     const std::string metadata_uri_;
+    std::thread watch_thread_;
+    std::atomic<bool> watch_stopped_{false};
+    std::atomic<bool> batch_unsupported_{false};
 };
 
 #endif  // USE_HTTP
@@ -449,7 +737,10 @@ struct EtcdStoragePlugin : public MetadataStoragePlugin {
         }
     }
 
-    virtual ~EtcdStoragePlugin() { EtcdCloseWrapper(); }
+    virtual ~EtcdStoragePlugin() {
+        if (watch_callback_) EtcdCancelWatchWithPrefixWrapper(this);
+        EtcdCloseWrapper();
+    }
 
     virtual bool get(const std::string &key, Json::Value &value) {
         char *json_data = nullptr;
@@ -506,8 +797,33 @@ struct EtcdStoragePlugin : public MetadataStoragePlugin {
         return true;
     }
 
+    virtual bool watch(const std::string &prefix, OnChangeCallBack callback) {
+        watch_callback_ = std::move(callback);
+        auto ret = EtcdWatchWithPrefixWrapper(
+            (char *)prefix.c_str(), this, (void *)&EtcdStoragePlugin::onWatch,
+            &err_msg_);
+        if (ret) {
+            LOG(ERROR) << "EtcdStoragePlugin: unable to watch " << prefix
+                       << " in " << metadata_uri_ << ": " << err_msg_;
+            // free the memory for storing error message
+            free(err_msg_);
+            err_msg_ = nullptr;
+            watch_callback_ = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    static void onWatch(void *context, const char *key, size_t key_size,
+                        const char *value, size_t value_size, int event_type,
+                        long long mod_revision) {
+        auto plugin = static_cast<EtcdStoragePlugin *>(context);
+        plugin->watch_callback_(key ? std::string(key, key_size) : "");
+    }
+
     const std::string metadata_uri_;
     char *err_msg_;
+    OnChangeCallBack watch_callback_;
 };
 #endif
 #endif  // USE_ETCD
@@ -636,6 +952,14 @@ struct SocketHandShakePlugin : public HandShakePlugin {
         on_notify_callback_ = callback;
     }
 
+    virtual void registerOnBinaryCallBack(HandShakeRequestType type,
+                                          OnReceiveBinaryCallBack callback) {
+        if (type == HandShakeRequestType::ConnectionBinary)
+            on_connection_binary_callback_ = callback;
+        else if (type == HandShakeRequestType::MetadataBinary)
+            on_metadata_binary_callback_ = callback;
+    }
+
     virtual int startDaemon(uint16_t listen_port, int sockfd) {
         if (listener_running_) {
             // LOG(INFO) << "SocketHandShakePlugin: listener already running";
@@ -742,40 +1066,27 @@ struct SocketHandShakePlugin : public HandShakePlugin {
                 auto peer_hostname =
                     getNetworkAddress((struct sockaddr *)&addr);
 
-                Json::Value local, peer;
-
                 auto [type, json_str] = readString(conn_fd);
-                std::string errs;
-                if (!parseJsonString(json_str, peer, &errs)) {
-                    LOG(ERROR)
-                        << "SocketHandShakePlugin: failed to receive "
-                           "handshake message, "
-                           "malformed json format: "
-                        << errs << ", json string length: " << json_str.size()
-                        << ", json string content: " << json_str;
-                    close(conn_fd);
-                    continue;
-                }
-
-                // old protocol equals Connection type
-                if (type == HandShakeRequestType::Connection ||
-                    type == HandShakeRequestType::OldProtocol) {
-                    if (on_connection_callback_)
-                        on_connection_callback_(peer, local);
-                } else if (type == HandShakeRequestType::Metadata) {
-                    if (on_metadata_callback_)
-                        on_metadata_callback_(peer, local);
-                } else if (type == HandShakeRequestType::Notify) {
-                    if (on_notify_callback_) on_notify_callback_(peer, local);
+                // Binary messages nobody answers are dropped without a
+                // reply, so that the client falls back to JSON
+                std::string reply;
+                int handled = ERR_NOT_IMPLEMENTED;
+                if (type == HandShakeRequestType::ConnectionBinary) {
+                    if (on_connection_binary_callback_)
+                        handled =
+                            on_connection_binary_callback_(json_str, reply);
+                } else if (type == HandShakeRequestType::MetadataBinary) {
+                    if (on_metadata_binary_callback_)
+                        handled = on_metadata_binary_callback_(json_str, reply);
                 } else {
-                    LOG(ERROR) << "SocketHandShakePlugin: unexpected handshake "
-                                  "message type";
+                    handled = handleJson(type, json_str, reply);
+                }
+                if (handled) {
                     close(conn_fd);
                     continue;
                 }
 
-                int ret =
-                    writeString(conn_fd, type, Json::FastWriter{}.write(local));
+                int ret = writeString(conn_fd, type, reply);
                 if (ret) {
                     LOG(ERROR) << "SocketHandShakePlugin: failed to send "
                                   "message: "
@@ -812,6 +1123,37 @@ struct SocketHandShakePlugin : public HandShakePlugin {
         return 0;
     }
 
+    // Serves a JSON message, returns non-zero if it cannot be answered
+    int handleJson(HandShakeRequestType type, const std::string &json_str,
+                   std::string &reply) {
+        Json::Value local, peer;
+        std::string errs;
+        if (!parseJsonString(json_str, peer, &errs)) {
+            LOG(ERROR) << "SocketHandShakePlugin: failed to receive "
+                          "handshake message, "
+                          "malformed json format: "
+                       << errs << ", json string length: " << json_str.size()
+                       << ", json string content: " << json_str;
+            return ERR_MALFORMED_JSON;
+        }
+
+        // old protocol equals Connection type
+        if (type == HandShakeRequestType::Connection ||
+            type == HandShakeRequestType::OldProtocol) {
+            if (on_connection_callback_) on_connection_callback_(peer, local);
+        } else if (type == HandShakeRequestType::Metadata) {
+            if (on_metadata_callback_) on_metadata_callback_(peer, local);
+        } else if (type == HandShakeRequestType::Notify) {
+            if (on_notify_callback_) on_notify_callback_(peer, local);
+        } else {
+            LOG(ERROR) << "SocketHandShakePlugin: unexpected handshake "
+                          "message type";
+            return ERR_SOCKET;
+        }
+        reply = Json::FastWriter{}.write(local);
+        return 0;
+    }
+
     virtual int sendNotify(std::string ip_or_host_name, uint16_t rpc_port,
                            const Json::Value &local, Json::Value &peer) {
         struct addrinfo hints;
@@ -882,6 +1224,61 @@ struct SocketHandShakePlugin : public HandShakePlugin {
         return ret;
     }
 
+    virtual int sendBinary(std::string ip_or_host_name, uint16_t rpc_port,
+                           HandShakeRequestType type, const std::string &local,
+                           std::string &peer) {
+        struct addrinfo hints;
+        struct addrinfo *result, *rp;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = globalConfig().use_ipv6 ? AF_INET6 : AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+
+        char service[16];
+        sprintf(service, "%u", rpc_port);
+        if (getaddrinfo(ip_or_host_name.c_str(), service, &hints, &result)) {
+            PLOG(ERROR)
+                << "SocketHandShakePlugin: failed to get IP address of peer "
+                   "server "
+                << ip_or_host_name << ":" << rpc_port
+                << ", check DNS and /etc/hosts, or use IPv4 address instead";
+            return ERR_DNS;
+        }
+
+        int ret = 0;
+        for (rp = result; rp; rp = rp->ai_next) {
+            ret = doSendBinary(rp, type, local, peer);
+            if (ret == 0 || ret == ERR_NOT_IMPLEMENTED) break;
+        }
+
+        freeaddrinfo(result);
+        return ret;
+    }
+
+    int doSendBinary(struct addrinfo *addr, HandShakeRequestType type,
+                     const std::string &local, std::string &peer) {
+        int conn_fd = -1;
+        int ret = doConnect(addr, conn_fd);
+        if (ret) {
+            return ret;
+        }
+
+        ret = writeString(conn_fd, type, local);
+        if (ret) {
+            LOG(ERROR) << "SocketHandShakePlugin: failed to send binary "
+                          "message, check tcp connection";
+            close(conn_fd);
+            return ret;
+        }
+
+        // Servers predating binary messages fail to parse them as JSON and
+        // close the connection without replying
+        auto [reply_type, reply] = readString(conn_fd);
+        close(conn_fd);
+        if (reply_type != type) return ERR_NOT_IMPLEMENTED;
+        peer = std::move(reply);
+        return 0;
+    }
+
     int doConnect(struct addrinfo *addr, int &conn_fd) {
         int on = 1;
         conn_fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
@@ -1082,6 +1479,8 @@ struct SocketHandShakePlugin : public HandShakePlugin {
     OnReceiveCallBack on_connection_callback_;
     OnReceiveCallBack on_metadata_callback_;
     OnReceiveCallBack on_notify_callback_;
+    OnReceiveBinaryCallBack on_connection_binary_callback_;
+    OnReceiveBinaryCallBack on_metadata_binary_callback_;
 };
 
 std::shared_ptr<HandShakePlugin> HandShakePlugin::Create(
@@ -44,9 +44,17 @@ constexpr size_t kAsyncTaskLimit = 100U;
 constexpr int32_t kPortRange = 100;
 constexpr int32_t kDefaultDisconnectTime = 1000;
 constexpr int32_t kMaxGenPortAttempts = 500;
+constexpr size_t kDefaultCopyStreams = 4U;
+constexpr size_t kMaxCopyStreams = 16U;
+constexpr size_t kDefaultRoceSplitBytes = 64ULL << 20;
 constexpr const char *kAutoConnect = "AutoConnect";
 constexpr const char *kEnabled = "1";
 constexpr const char *kDisabled = "0";
+
+std::string adxlEngineName(const std::string &host_ip, uint64_t host_port) {
+    return (globalConfig().use_ipv6 ? ("[" + host_ip + "]") : host_ip) + ":" +
+           std::to_string(host_port);
+}
 }  // namespace
 
 AscendDirectTransport::AscendDirectTransport() : running_(false) {}
@@ -86,6 +94,16 @@ AscendDirectTransport::~AscendDirectTransport() {
         connected_segments_.clear();
     }
     adxl_->Finalize();
+
+    for (auto stream : copy_streams_) {
+        (void)aclrtDestroyStream(stream);
+    }
+    copy_streams_.clear();
+    std::lock_guard<std::mutex> event_lock(event_mutex_);
+    for (auto event : free_events_) {
+        (void)aclrtDestroyEvent(event);
+    }
+    free_events_.clear();
 }
 
 int AscendDirectTransport::install(std::string &local_server_name,
@@ -148,12 +166,35 @@ int AscendDirectTransport::install(std::string &local_server_name,
         }
     }
     transfer_timeout_in_nano_ = transfer_timeout_ * kMillisToNano;
-    ret = aclrtCreateStreamWithConfig(
-        &stream_, 0, ACL_STREAM_FAST_LAUNCH | ACL_STREAM_FAST_SYNC);
-    if (ret != ACL_ERROR_NONE) {
-        LOG(ERROR) << "AscendDirectTransport: cannot create stream, ret: "
-                   << ret;
-        return FAILED;
+    char *intra_roce_str = std::getenv("HCCL_INTRA_ROCE_ENABLE");
+    if (intra_roce_str) {
+        auto intra_roce = parseFromString<int32_t>(intra_roce_str);
+        intra_roce_ = intra_roce.has_value() && intra_roce.value() == 1;
+    }
+    char *hccs_group_size_str = std::getenv("ASCEND_HCCS_GROUP_SIZE");
+    if (hccs_group_size_str) {
+        auto hccs_group_size = parseFromString<int32_t>(hccs_group_size_str);
+        if (hccs_group_size.has_value() && hccs_group_size.value() >= 0) {
+            hccs_group_size_ = hccs_group_size.value();
+            LOG(INFO) << "Set HCCS group size to:" << hccs_group_size_;
+        } else {
+            LOG(WARNING) << "Invalid HCCS group size:" << hccs_group_size_str;
+        }
+    }
+    roce_split_bytes_ = kDefaultRoceSplitBytes;
+    char *roce_split_str = std::getenv("ASCEND_ROCE_SPLIT_BYTES");
+    if (roce_split_str) {
+        auto roce_split = parseFromString<int64_t>(roce_split_str);
+        if (roce_split.has_value() && roce_split.value() >= 0) {
+            roce_split_bytes_ = static_cast<size_t>(roce_split.value());
+            LOG(INFO) << "Set RoCE split bytes to:" << roce_split_bytes_;
+        } else {
+            LOG(WARNING) << "Invalid RoCE split bytes:" << roce_split_str;
+        }
+    }
+    ret = createCopyStreams();
+    if (ret) {
+        return ret;
     }
     running_ = true;
     query_thread_ = std::thread(&AscendDirectTransport::queryThread, this);
@@ -199,6 +240,33 @@ int AscendDirectTransport::install(std::string &local_server_name,
     return 0;
 }
 
+int AscendDirectTransport::createCopyStreams() {
+    size_t num_streams = kDefaultCopyStreams;
+    char *copy_streams_str = std::getenv("ASCEND_COPY_STREAMS");
+    if (copy_streams_str) {
+        auto copy_streams = parseFromString<int32_t>(copy_streams_str);
+        if (copy_streams.has_value() && copy_streams.value() > 0 &&
+            static_cast<size_t>(copy_streams.value()) <= kMaxCopyStreams) {
+            num_streams = static_cast<size_t>(copy_streams.value());
+            LOG(INFO) << "Set copy streams to:" << num_streams;
+        } else {
+            LOG(WARNING) << "Invalid copy streams:" << copy_streams_str;
+        }
+    }
+    for (size_t i = 0; i < num_streams; ++i) {
+        aclrtStream stream = nullptr;
+        auto ret = aclrtCreateStreamWithConfig(
+            &stream, 0, ACL_STREAM_FAST_LAUNCH | ACL_STREAM_FAST_SYNC);
+        if (ret != ACL_ERROR_NONE) {
+            LOG(ERROR) << "AscendDirectTransport: cannot create stream, ret: "
+                       << ret;
+            return FAILED;
+        }
+        copy_streams_.push_back(stream);
+    }
+    return 0;
+}
+
 int AscendDirectTransport::InitAdxlEngine() {
     auto local_segment_desc = metadata_->getSegmentDescByID(LOCAL_SEGMENT_ID);
     std::string host_ip = local_segment_desc->rank_info.hostIp;
@@ -321,22 +389,47 @@ void AscendDirectTransport::submitSlices(std::vector<Slice *> &slice_list) {
         seg_to_slices[slice->target_id].push_back(slice);
     }
     for (auto &[seg_id, slices] : seg_to_slices) {
-        enqueue([this, moved_slices = std::move(slices)] {
-            static thread_local bool context_set = false;
-            if (!context_set) {
-                auto ret = aclrtSetCurrentContext(rt_context_);
-                if (ret) {
-                    LOG(ERROR)
-                        << "Call aclrtSetCurrentContext failed, ret: " << ret;
-                    return;
-                }
-                context_set = true;
+        // A batch to an HCCS peer goes out in one call. Over RoCE a large
+        // batch is cut into parts that workers transfer concurrently, so
+        // one batch does not hold a single worker while the others idle.
+        if (roce_split_bytes_ == 0 || use_short_connection_ ||
+            getLinkPath(seg_id) != LinkPath::kRoce) {
+            enqueueSlices(std::move(slices));
+            continue;
+        }
+        std::vector<Slice *> part;
+        size_t part_bytes = 0;
+        for (auto slice : slices) {
+            part.push_back(slice);
+            part_bytes += slice->length;
+            if (part_bytes >= roce_split_bytes_) {
+                enqueueSlices(std::move(part));
+                part.clear();
+                part_bytes = 0;
             }
-            processSliceList(moved_slices);
-        });
+        }
+        if (!part.empty()) {
+            enqueueSlices(std::move(part));
+        }
     }
 }
 
+void AscendDirectTransport::enqueueSlices(std::vector<Slice *> slice_list) {
+    enqueue([this, moved_slices = std::move(slice_list)] {
+        static thread_local bool context_set = false;
+        if (!context_set) {
+            auto ret = aclrtSetCurrentContext(rt_context_);
+            if (ret) {
+                LOG(ERROR) << "Call aclrtSetCurrentContext failed, ret: "
+                           << ret;
+                return;
+            }
+            context_set = true;
+        }
+        processSliceList(moved_slices);
+    });
+}
+
 Status AscendDirectTransport::submitTransfer(
     BatchID batch_id, const std::vector<TransferRequest> &entries) {
     auto &batch_desc = *((BatchDesc *)(batch_id));
@@ -350,7 +443,7 @@ Status AscendDirectTransport::submitTransfer(
     }
 
     auto cur_task_size = batch_desc.task_list.size();
-    batch_desc.task_list.resize(cur_task_size + entries.size());
+    batch_desc.addTasks(entries.size());
     std::vector<Slice *> slice_list;
     slice_list.reserve(entries.size());
 
@@ -566,6 +659,9 @@ int AscendDirectTransport::allocateLocalSegmentID() {
         LOG(ERROR) << "Find available port failed.";
         return FAILED;
     }
+    // Lets peers on the same server tell whether HCCS links the two NPUs
+    desc->rank_info.deviceLogicId = device_logic_id_;
+    desc->rank_info.devicePhyId = device_phy_id_;
     local_adxl_engine_name_ =
         (globalConfig().use_ipv6 ? ("[" + host_ip + "]") : host_ip) + ":" +
         std::to_string(desc->rank_info.hostPort);
@@ -613,6 +709,7 @@ uint16_t AscendDirectTransport::findAdxlListenPort() {
             }
         }
     }
+    device_phy_id_ = dev_id;
     static std::random_device rand_gen;
     std::uniform_int_distribution rand_dist;
     const int min_port = base_port_ + dev_id * kPortRange;
@@ -782,12 +879,13 @@ void AscendDirectTransport::processSliceList(
     }
     if (it != need_update_metadata_segs_.end()) {
         need_update_metadata_segs_.erase(it);
+        // The peer may have restarted on another NPU
+        std::lock_guard<std::mutex> lock(link_path_mutex_);
+        link_paths_.erase(slice_list[0]->target_id);
     }
     auto target_adxl_engine_name =
-        (globalConfig().use_ipv6
-             ? ("[" + target_segment_desc->rank_info.hostIp + "]")
-             : target_segment_desc->rank_info.hostIp) +
-        ":" + std::to_string(target_segment_desc->rank_info.hostPort);
+        adxlEngineName(target_segment_desc->rank_info.hostIp,
+                       target_segment_desc->rank_info.hostPort);
     adxl::TransferOp operation;
     if (slice_list[0]->opcode == TransferRequest::WRITE) {
         operation = adxl::WRITE;
@@ -813,6 +911,45 @@ void AscendDirectTransport::processSliceList(
     return connectAndTransfer(target_adxl_engine_name, operation, slice_list);
 }
 
+AscendDirectTransport::LinkPath AscendDirectTransport::getLinkPath(
+    SegmentID target_id) {
+    {
+        std::lock_guard<std::mutex> lock(link_path_mutex_);
+        auto it = link_paths_.find(target_id);
+        if (it != link_paths_.end()) {
+            return it->second;
+        }
+    }
+    auto target_desc = metadata_->getSegmentDescByID(target_id);
+    auto local_desc = metadata_->getSegmentDescByID(LOCAL_SEGMENT_ID);
+    if (!target_desc || !local_desc) {
+        // Not cached, processSliceList reports the missing segment
+        return LinkPath::kRoce;
+    }
+    const auto &peer = target_desc->rank_info;
+    LinkPath path = LinkPath::kRoce;
+    if (adxlEngineName(peer.hostIp, peer.hostPort) ==
+        local_adxl_engine_name_) {
+        path = LinkPath::kLocal;
+    } else if (!intra_roce_ && peer.hostIp == local_desc->rank_info.hostIp) {
+        auto peer_phy_id = static_cast<int32_t>(peer.devicePhyId);
+        bool same_group = hccs_group_size_ == 0 ||
+                          peer_phy_id / hccs_group_size_ ==
+                              device_phy_id_ / hccs_group_size_;
+        if (same_group) {
+            path = LinkPath::kHccs;
+        }
+    }
+    LOG(INFO) << "Segment " << target_desc->name << " (npu "
+              << peer.devicePhyId << ") is reached over "
+              << (path == LinkPath::kLocal
+                      ? "local copy"
+                      : (path == LinkPath::kHccs ? "HCCS" : "RoCE"));
+    std::lock_guard<std::mutex> lock(link_path_mutex_);
+    link_paths_[target_id] = path;
+    return path;
+}
+
 void AscendDirectTransport::connectAndTransfer(
     const std::string &target_adxl_engine_name, adxl::TransferOp operation,
     const std::vector<Slice *> &slice_list, int32_t times) {
@@ -993,7 +1130,9 @@ void AscendDirectTransport::localCopy(TransferRequest::OpCode opcode,
         auto batch_num = std::min(left_num, kMemcpyBatchLimit);
         ret = copyWithBatch(opcode, slice_list, kind, batch_num, slice_index);
         if (ret == ACL_ERROR_RT_FEATURE_NOT_SUPPORT) {
-            return copyWithAsync(opcode, slice_list, kind);
+            std::vector<Slice *> rest(slice_list.begin() + slice_index,
+                                      slice_list.end());
+            return copyWithAsync(opcode, rest, kind);
         }
         left_num -= batch_num;
         slice_index += batch_num;
@@ -1081,41 +1220,95 @@ void AscendDirectTransport::copyWithSync(TransferRequest::OpCode opcode,
     }
 }
 
+aclrtEvent AscendDirectTransport::acquireEvent() {
+    {
+        std::lock_guard<std::mutex> lock(event_mutex_);
+        if (!free_events_.empty()) {
+            auto event = free_events_.back();
+            free_events_.pop_back();
+            return event;
+        }
+    }
+    aclrtEvent event = nullptr;
+    auto ret = aclrtCreateEvent(&event);
+    if (ret != ACL_ERROR_NONE) {
+        LOG(ERROR) << "aclrtCreateEvent failed, ret:" << ret;
+        return nullptr;
+    }
+    return event;
+}
+
+void AscendDirectTransport::releaseEvent(aclrtEvent event) {
+    std::lock_guard<std::mutex> lock(event_mutex_);
+    free_events_.push_back(event);
+}
+
 void AscendDirectTransport::copyWithAsync(
     TransferRequest::OpCode opcode, const std::vector<Slice *> &slice_list,
     aclrtMemcpyKind kind) {
-    std::vector<Slice *> async_list;
+    if (slice_list.empty()) {
+        return;
+    }
+    // Stripe the copies over the stream pool, then wait for an event
+    // recorded on each stream. A worker only waits for the copies it
+    // queued, not for those other workers queued on the same stream later.
+    size_t num_streams = std::min(copy_streams_.size(), slice_list.size());
+    size_t first_stream =
+        next_copy_stream_.fetch_add(num_streams, std::memory_order_relaxed);
+    std::vector<std::vector<Slice *>> async_lists(num_streams);
     aclError ret;
-    for (auto &slice : slice_list) {
+    for (size_t i = 0; i < slice_list.size(); ++i) {
+        auto &slice = slice_list[i];
+        auto stream_index = i % num_streams;
+        auto stream =
+            copy_streams_[(first_stream + stream_index) % copy_streams_.size()];
         auto local_ptr = slice->source_addr;
         auto remote_ptr =
             reinterpret_cast<void *>(slice->ascend_direct.dest_addr);
         auto len = slice->length;
         if (opcode == TransferRequest::WRITE) {
             ret = aclrtMemcpyAsync(remote_ptr, len, local_ptr, len, kind,
-                                   stream_);
+                                   stream);
         } else {
             ret = aclrtMemcpyAsync(local_ptr, len, remote_ptr, len, kind,
-                                   stream_);
+                                   stream);
         }
         if (ret != ACL_ERROR_NONE) {
             LOG(ERROR) << "aclrtMemcpyAsync failed, ret:" << ret;
             slice->markFailed();
             continue;
         }
-        async_list.emplace_back(slice);
+        async_lists[stream_index].emplace_back(slice);
     }
-    ret = aclrtSynchronizeStreamWithTimeout(stream_, transfer_timeout_);
-    if (ret == ACL_ERROR_NONE) {
-        VLOG(1) << "Copy with aclrtMemcpyAsync suc.";
-        for (auto &slice : async_list) {
-            slice->markSuccess();
+    for (size_t i = 0; i < num_streams; ++i) {
+        if (async_lists[i].empty()) {
+            continue;
         }
-    } else {
-        LOG(ERROR) << "Memory copy failed.";
-        (void)aclrtStreamAbort(stream_);
-        for (auto &slice : async_list) {
-            slice->markFailed();
+        auto stream = copy_streams_[(first_stream + i) % copy_streams_.size()];
+        auto event = acquireEvent();
+        if (event && aclrtRecordEvent(event, stream) == ACL_ERROR_NONE) {
+            ret = aclrtSynchronizeEventWithTimeout(event, transfer_timeout_);
+        } else {
+            ret = aclrtSynchronizeStreamWithTimeout(stream, transfer_timeout_);
+        }
+        if (ret == ACL_ERROR_NONE) {
+            VLOG(1) << "Copy with aclrtMemcpyAsync suc.";
+            for (auto &slice : async_lists[i]) {
+                slice->markSuccess();
+            }
+            if (event) {
+                releaseEvent(event);
+            }
+        } else {
+            LOG(ERROR) << "Memory copy failed, ret:" << ret;
+            (void)aclrtStreamAbort(stream);
+            for (auto &slice : async_lists[i]) {
+                slice->markFailed();
+            }
+            // The event may still be pending on the aborted stream
+            if (event) {
+                (void)aclrtDestroyEvent(event);
+            }
         }
     }
 }
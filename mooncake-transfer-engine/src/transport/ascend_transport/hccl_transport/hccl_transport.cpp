@@ -467,7 +467,7 @@ Status HcclTransport::submitTransfer(
     }
 
     int task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
     std::vector<Slice *> slice_list;
     slice_list.reserve(entries.size());
     for (auto &request : entries) {
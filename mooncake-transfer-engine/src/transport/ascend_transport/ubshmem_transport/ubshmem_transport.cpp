@@ -241,7 +241,7 @@ Status UBShmemTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
 
     for (auto &request : entries) {
         TransferTask &task = batch_desc.task_list[task_id];
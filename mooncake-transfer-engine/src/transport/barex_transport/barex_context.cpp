@@ -45,6 +45,44 @@ int BarexContext::checkStatus(SegmentID sid) {
     return channel_cache_.RemoveInvalidChannels(sid);
 }
 
+size_t BarexContext::channelCount(SegmentID sid, int device_id) {
+    return channel_cache_.count(sid, device_id);
+}
+
+bool BarexContext::allChannelsActive(SegmentID sid) {
+    return channel_cache_.CheckAllChannels(sid);
+}
+
+BarexContext::Stats BarexContext::getStats() const {
+    Stats stats;
+    stats.submitted_slices =
+        submitted_slice_count_.load(std::memory_order_relaxed);
+    stats.completed_slices =
+        completed_slice_count_.load(std::memory_order_relaxed);
+    stats.failed_slices = failed_slice_count_.load(std::memory_order_relaxed);
+    stats.outstanding_bytes =
+        outstanding_bytes_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Settles all slices of one posted batch. The counters are updated once per
+// batch rather than once per slice, as the RDMA WorkerPool does per poll.
+void BarexContext::completeSlices(
+    const std::vector<Transport::Slice*>& slices, bool success) {
+    uint64_t bytes = 0;
+    for (auto slice : slices) bytes += slice->length;
+    outstanding_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    if (success) {
+        completed_slice_count_.fetch_add(slices.size(),
+                                         std::memory_order_relaxed);
+        for (auto slice : slices) slice->markSuccess();
+    } else {
+        failed_slice_count_.fetch_add(slices.size(),
+                                      std::memory_order_relaxed);
+        for (auto slice : slices) slice->markFailed();
+    }
+}
+
 XContext* BarexContext::getCtx() { return xcontext_; }
 
 std::vector<XChannel*> BarexContext::getAllChannel() {
@@ -85,10 +123,20 @@ int BarexContext::submitPostSend(
             std::vector<Transport::Slice*>& slice_vec =
                 sid_dev_slice_map[sid][dev];
             size_t data_size = data_vec.size();
-            int qp_in_use = qp_num_per_ctx_;
-            if (data_size < (size_t)qp_num_per_ctx_) {
-                qp_in_use = data_size;
+            size_t channel_count = channel_cache_.count(sid, dev);
+            if (channel_count == 0) {
+                LOG(ERROR) << "Write fail, sid " << sid << ", dev " << dev
+                           << ", no channel found";
+                return -1;
             }
+            // All submitting threads share the channels to a peer. A
+            // submission uses up to qp_num_per_ctx_ of them, starting at the
+            // next channel in turn, so small batches from many threads
+            // spread over all channels instead of landing on the first one.
+            int qp_in_use = std::min(
+                {channel_count, (size_t)qp_num_per_ctx_, data_size});
+            uint64_t first_channel =
+                next_channel_.fetch_add(qp_in_use, std::memory_order_relaxed);
             size_t begin_idx = 0;
             size_t end_idx = 0;
             size_t batch_size = data_size / qp_in_use;
@@ -98,21 +146,16 @@ int BarexContext::submitPostSend(
             for (int i = 0; i < qp_in_use; i++) {
                 XChannel* channel = nullptr;
                 for (int j = 0; j < retry_cnt; j++) {
-                    channel = channel_cache_.find(sid, dev, i);
-                    if (!channel) {
-                        LOG(ERROR)
-                            << "Write fail, sid " << sid << ", dev " << dev
-                            << ", id " << i << " not found, retry " << j << "/"
-                            << retry_cnt;
-                        break;
-                    }
-                    if (!channel->IsActive()) {
-                        LOG(WARNING)
-                            << "Write fail, channel status error " << channel
-                            << " retry " << j << "/" << retry_cnt;
-                        channel_cache_.erase(sid, dev, i);
-                        continue;
-                    }
+                    size_t count = channel_cache_.count(sid, dev);
+                    if (count == 0) break;
+                    int idx = (first_channel + i) % count;
+                    channel = channel_cache_.find(sid, dev, idx);
+                    if (!channel || channel->IsActive()) break;
+                    LOG(WARNING) << "Write fail, channel status error "
+                                 << channel << " retry " << j << "/"
+                                 << retry_cnt;
+                    channel_cache_.erase(sid, dev, idx);
+                    channel = nullptr;
                 }
                 if (!channel) {
                     LOG(ERROR) << "Write fail, no channel found";
@@ -146,46 +189,57 @@ int BarexContext::submitPostSend(
                 }
 
                 if (!data_chunk_write->empty()) {
+                    uint64_t bytes = 0;
+                    for (auto slice : *slice_chunk_write)
+                        bytes += slice->length;
+                    submitted_slice_count_.fetch_add(
+                        slice_chunk_write->size(), std::memory_order_relaxed);
+                    outstanding_bytes_.fetch_add(bytes,
+                                                 std::memory_order_relaxed);
                     BarexResult r = channel->WriteBatch(
                         data_chunk_write,
-                        [slice_chunk_write](accl::barex::Status s) {
+                        [this, slice_chunk_write](accl::barex::Status s) {
                             if (!s.IsOk()) {
                                 LOG(ERROR) << "WriteBatch fail, "
                                            << s.ErrMsg().c_str();
-                                for (auto slice : *slice_chunk_write) {
-                                    slice->markFailed();
-                                }
-                            } else {
-                                for (auto slice : *slice_chunk_write) {
-                                    slice->markSuccess();
-                                }
                             }
+                            completeSlices(*slice_chunk_write, s.IsOk());
                         },
                         true);
                     if (r != accl::barex::BAREX_SUCCESS) {
                         LOG(ERROR) << "WriteBatch fail, ret " << r;
+                        submitted_slice_count_.fetch_sub(
+                            slice_chunk_write->size(),
+                            std::memory_order_relaxed);
+                        outstanding_bytes_.fetch_sub(bytes,
+                                                     std::memory_order_relaxed);
                         return -2;
                     }
                 }
                 if (!data_chunk_read->empty()) {
+                    uint64_t bytes = 0;
+                    for (auto slice : *slice_chunk_read) bytes += slice->length;
+                    submitted_slice_count_.fetch_add(
+                        slice_chunk_read->size(), std::memory_order_relaxed);
+                    outstanding_bytes_.fetch_add(bytes,
+                                                 std::memory_order_relaxed);
                     BarexResult r = channel->ReadBatch(
                         data_chunk_read,
-                        [slice_chunk_read](accl::barex::Status s) {
+                        [this, slice_chunk_read](accl::barex::Status s) {
                             if (!s.IsOk()) {
                                 LOG(ERROR)
                                     << "ReadBatch fail, " << s.ErrMsg().c_str();
-                                for (auto slice : *slice_chunk_read) {
-                                    slice->markFailed();
-                                }
-                            } else {
-                                for (auto slice : *slice_chunk_read) {
-                                    slice->markSuccess();
-                                }
                             }
+                            completeSlices(*slice_chunk_read, s.IsOk());
                         },
                         true);
                     if (r != accl::barex::BAREX_SUCCESS) {
                         LOG(ERROR) << "ReadBatch fail, ret " << r;
+                        submitted_slice_count_.fetch_sub(
+                            slice_chunk_read->size(),
+                            std::memory_order_relaxed);
+                        outstanding_bytes_.fetch_sub(bytes,
+                                                     std::memory_order_relaxed);
                         return -2;
                     }
                 }
@@ -59,6 +59,11 @@ BarexTransport::~BarexTransport() {
             }
         }
     }
+    auto stats = getStats();
+    LOG(INFO) << "BarexTransport: submitted " << stats.submitted_slices
+              << " slices, completed " << stats.completed_slices
+              << ", failed " << stats.failed_slices << ", outstanding "
+              << stats.outstanding_bytes << " bytes";
     client_context_list_.clear();
     server_context_list_.clear();
     metadata_->removeSegmentDesc(local_server_name_);
@@ -347,7 +352,7 @@ Status BarexTransport::submitTransfer(
     std::unordered_map<std::shared_ptr<BarexContext>, std::vector<Slice *>>
         slices_to_post;
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
     auto local_segment_desc = metadata_->getSegmentDescByID(LOCAL_SEGMENT_ID);
     // const size_t kBlockSize = globalConfig().slice_size;
     const size_t kBlockMaxSize = globalConfig().eic_max_block_size;
@@ -1247,6 +1252,34 @@ Status BarexTransport::OpenChannel(const std::string &segment_name,
                                    SegmentID sid) {
     auto [ip, port] = parseHostNameWithPort(segment_name);
 
+    int client_ctx_cnt = client_context_list_.size();
+    int total_channels = client_ctx_cnt * client_context_list_[0]->getQpNum();
+    std::shared_ptr<std::mutex> open_lock;
+    {
+        std::lock_guard<std::mutex> guard(open_channel_mutex_);
+        auto &lock = open_channel_locks_[sid];
+        if (!lock) lock = std::make_shared<std::mutex>();
+        open_lock = lock;
+    }
+    std::lock_guard<std::mutex> open_guard(*open_lock);
+    // Channels are shared by all threads, reopen only if some are missing
+    // or broken
+    int open_channels = 0;
+    bool all_active = true;
+    for (auto &ctx : client_context_list_) {
+        int dev = ctx->getCtx()->GetXDevice()->GetId();
+        open_channels += ctx->channelCount(sid, dev);
+        all_active = all_active && ctx->allChannelsActive(sid);
+    }
+    if (open_channels >= total_channels && all_active) {
+        VLOG(1) << "Reuse " << open_channels << " channels to "
+                << segment_name;
+        return Status::OK();
+    }
+    if (!all_active) {
+        for (auto &ctx : client_context_list_) ctx->checkStatus(sid);
+    }
+
     HandShakeDesc local_desc, peer_desc;
 #ifdef USE_BAREX
     local_desc.barex_port = getLocalPort();
@@ -1266,8 +1299,6 @@ Status BarexTransport::OpenChannel(const std::string &segment_name,
 #endif
     }
 
-    int client_ctx_cnt = client_context_list_.size();
-    int total_channels = client_ctx_cnt * client_context_list_[0]->getQpNum();
     CountDownLatch connect_latch(total_channels);
     std::vector<XChannel *> channels;
     static std::mutex push_channel_mtx;
@@ -1309,22 +1340,34 @@ Status BarexTransport::OpenChannel(const std::string &segment_name,
 }
 
 Status BarexTransport::CheckStatus(SegmentID sid) {
-    bool status = 0;
+    bool bad_channels = false;
     for (auto ctx : client_context_list_) {
         int ret = ctx->checkStatus(sid);
         if (ret) {
             LOG(INFO) << "checkStatus failed in ctx" << ctx
                       << ", bad channel cnt=" << ret;
-            status = 1;
+            bad_channels = true;
         }
     }
-    if (!status) {
+    if (bad_channels) {
         LOG(ERROR) << "CheckStatus for sid " << sid << " failed";
         return Status::InvalidArgument("sid status error");
     }
     return Status::OK();
 }
 
+BarexContext::Stats BarexTransport::getStats() {
+    BarexContext::Stats total;
+    for (auto &ctx : client_context_list_) {
+        auto stats = ctx->getStats();
+        total.submitted_slices += stats.submitted_slices;
+        total.completed_slices += stats.completed_slices;
+        total.failed_slices += stats.failed_slices;
+        total.outstanding_bytes += stats.outstanding_bytes;
+    }
+    return total;
+}
+
 int BarexTransport::onSetupRdmaConnections(const HandShakeDesc &peer_desc,
                                            HandShakeDesc &local_desc) {
 #ifdef USE_BAREX
@@ -27,6 +27,7 @@
 #include <regex>
 
 #include "common.h"
+#include "config.h"
 #include "transfer_engine.h"
 #include "transfer_metadata.h"
 #include "transport/transport.h"
@@ -35,7 +36,78 @@
 #include <unistd.h>    // For open(), close(), read(), write()
 #include <sys/mman.h>  // For mmap, munmap
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 namespace mooncake {
+namespace {
+
+// Smaller copies go through memcpy: they gain little from streaming, and
+// the data is likely to be read back soon
+const size_t kMinStreamBytes = 4096;
+// How far ahead of the copy the source is prefetched
+const size_t kPrefetchDistance = 1024;
+
+using StreamCopyFn = void (*)(char *dest, const char *src, size_t size);
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// Copies with non-temporal stores, which write whole lines to the device
+// without reading them into the cache first and leave no dirty lines
+// behind. size must be at least 64.
+__attribute__((target("avx512f"))) void streamCopyAvx512(char *dest,
+                                                         const char *src,
+                                                         size_t size) {
+    size_t head = (64 - reinterpret_cast<uintptr_t>(dest) % 64) % 64;
+    std::memcpy(dest, src, head);
+    dest += head, src += head, size -= head;
+    for (; size >= 64; dest += 64, src += 64, size -= 64) {
+        _mm_prefetch(src + kPrefetchDistance, _MM_HINT_NTA);
+        _mm512_stream_si512(reinterpret_cast<__m512i *>(dest),
+                            _mm512_loadu_si512(src));
+    }
+    _mm_sfence();
+    std::memcpy(dest, src, size);
+}
+
+__attribute__((target("avx2"))) void streamCopyAvx2(char *dest,
+                                                    const char *src,
+                                                    size_t size) {
+    size_t head = (32 - reinterpret_cast<uintptr_t>(dest) % 32) % 32;
+    std::memcpy(dest, src, head);
+    dest += head, src += head, size -= head;
+    for (; size >= 64; dest += 64, src += 64, size -= 64) {
+        _mm_prefetch(src + kPrefetchDistance, _MM_HINT_NTA);
+        auto lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+        auto hi =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 32));
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(dest), lo);
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(dest + 32), hi);
+    }
+    _mm_sfence();
+    std::memcpy(dest, src, size);
+}
+#endif
+
+StreamCopyFn selectStreamCopy() {
+#if defined(__x86_64__) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return streamCopyAvx512;
+    if (__builtin_cpu_supports("avx2")) return streamCopyAvx2;
+#endif
+    return nullptr;
+}
+
+const StreamCopyFn kStreamCopy = selectStreamCopy();
+
+void copyRange(char *dest, const char *src, size_t size, bool stream) {
+    if (stream && kStreamCopy && size >= kMinStreamBytes)
+        kStreamCopy(dest, src, size);
+    else
+        std::memcpy(dest, src, size);
+}
+
+}  // namespace
 
 CxlTransport::CxlTransport() {
     // cxl_dev_path = "/dev/dax0.0";
@@ -51,6 +123,7 @@ CxlTransport::CxlTransport() {
 }
 
 CxlTransport::~CxlTransport() {
+    stopCopyWorkers();
     if (cxl_base_addr != nullptr && cxl_base_addr != MAP_FAILED &&
         cxl_dev_size != 0) {
         munmap(cxl_base_addr, cxl_dev_size);
@@ -119,8 +192,14 @@ int CxlTransport::cxlMemcpy(void *dest, void *src, size_t size) {
         return -1;  // validation failed
     }
 
-    // Perform the memory copy
-    std::memcpy(dest, src, size);
+    // Writes to the device stream past the cache. Reads are plain loads:
+    // the mapping is write-back, where non-temporal loads behave the same.
+    bool stream = isAddressInCxlRange(dest);
+    if (!copy_workers_.empty() &&
+        size >= globalConfig().cxl_parallel_copy_threshold)
+        parallelCopy((char *)dest, (const char *)src, size, stream);
+    else
+        copyRange((char *)dest, (const char *)src, size, stream);
 
     // Memory barriers and cache operations
     if (isAddressInCxlRange(dest) || isAddressInCxlRange(src)) {
@@ -131,6 +210,64 @@ int CxlTransport::cxlMemcpy(void *dest, void *src, size_t size) {
     return 0;  // success
 }
 
+void CxlTransport::parallelCopy(char *dest, const char *src, size_t size,
+                                bool stream) {
+    // Chunks start on cache line boundaries of the destination
+    size_t parts = copy_workers_.size() + 1;
+    size_t chunk = (size / parts + 63) & ~size_t(63);
+    std::atomic<size_t> pending(0);
+    {
+        std::lock_guard<std::mutex> lock(copy_mutex_);
+        for (size_t pos = chunk; pos < size; pos += chunk) {
+            pending.fetch_add(1, std::memory_order_relaxed);
+            copy_queue_.push_back({dest + pos, src + pos,
+                                   std::min(chunk, size - pos), stream,
+                                   &pending});
+        }
+    }
+    copy_cv_.notify_all();
+    copyRange(dest, src, std::min(chunk, size), stream);
+    while (pending.load(std::memory_order_acquire))
+        std::this_thread::yield();
+}
+
+void CxlTransport::startCopyWorkers(size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        copy_workers_.emplace_back(&CxlTransport::copyWorker, this);
+}
+
+void CxlTransport::stopCopyWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(copy_mutex_);
+        copy_stop_ = true;
+    }
+    copy_cv_.notify_all();
+    for (auto &worker : copy_workers_) worker.join();
+    copy_workers_.clear();
+}
+
+void CxlTransport::copyWorker() {
+    std::unique_lock<std::mutex> lock(copy_mutex_);
+    while (true) {
+        copy_cv_.wait(lock,
+                      [this] { return copy_stop_ || !copy_queue_.empty(); });
+        if (copy_queue_.empty()) return;
+        CopyChunk chunk = copy_queue_.front();
+        copy_queue_.pop_front();
+        lock.unlock();
+        copyRange(chunk.dest, chunk.src, chunk.size, chunk.stream);
+        chunk.pending->fetch_sub(1, std::memory_order_release);
+        lock.lock();
+    }
+}
+
+void *CxlTransport::getCxlAddress(uint64_t offset, size_t length) {
+    if (!cxl_base_addr || offset > cxl_dev_size ||
+        length > cxl_dev_size - offset)
+        return nullptr;
+    return (char *)cxl_base_addr + offset;
+}
+
 bool CxlTransport::validateMemoryBounds(void *dest, void *src, size_t size) {
     uintptr_t base = reinterpret_cast<uintptr_t>(cxl_base_addr);
     uintptr_t end = base + cxl_dev_size;
@@ -200,6 +337,7 @@ int CxlTransport::install(std::string &local_server_name,
         LOG(ERROR) << "CxlTransport: Mmap cxl device failed.";
         return -1;
     }
+    startCopyWorkers(globalConfig().cxl_copy_threads - 1);
 
     ret = allocateLocalSegmentID();
     if (ret) {
@@ -313,7 +451,7 @@ Status CxlTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
 
     for (auto &request : entries) {
         TransferTask &task = batch_desc.task_list[task_id];
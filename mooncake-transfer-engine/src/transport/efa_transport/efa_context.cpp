@@ -367,8 +367,10 @@ std::shared_ptr<EfaEndPoint> EfaContext::endpoint(
     // if another thread raced us).  getOrInsert prevents duplicate endpoints
     // and duplicate AV entries for the same peer.
     auto new_endpoint = std::make_shared<EfaEndPoint>(*this);
-    if (!cq_list_.empty() && cq_list_[0]) {
-        int ret = new_endpoint->construct(cq_list_[0]->cq);
+    if (!cq_list_.empty()) {
+        int cq_index = next_cq_index_.fetch_add(1, std::memory_order_relaxed) %
+                       cq_list_.size();
+        int ret = new_endpoint->construct(cq_index);
         if (ret != 0) {
             LOG(ERROR) << "Failed to construct EFA endpoint";
             return nullptr;
@@ -437,11 +439,14 @@ int EfaContext::submitPostSend(
             continue;
         }
 
-        // Find the buffer and device for this destination address
+        // Find the buffer and device for this destination address. The
+        // peer NIC of the same name is preferred, so that the devices of
+        // two identical instances pair up rail by rail and each endpoint
+        // keeps streaming to one peer NIC.
         int buffer_id = -1, device_id = -1;
         if (EfaTransport::selectDevice(peer_segment_desc.get(),
                                        slice->rdma.dest_addr, slice->length,
-                                       buffer_id, device_id)) {
+                                       device_name_, buffer_id, device_id)) {
             LOG(ERROR) << "Cannot select device for dest_addr "
                        << (void *)slice->rdma.dest_addr;
             slice->markFailed();
@@ -497,28 +502,31 @@ int EfaContext::pollCq(int max_entries, int cq_index) {
     if (!cq) return 0;
 
     // Use fi_cq_data format for completions
-    struct fi_cq_data_entry entries[64];
-    int to_poll = std::min(max_entries, 64);
+    struct fi_cq_data_entry entries[kMaxPollBatch];
+    int to_poll = std::min(max_entries, kMaxPollBatch);
 
     ssize_t ret = fi_cq_read(cq, entries, to_poll);
 
     if (ret > 0) {
-        // Process completions outside the lock (markSuccess / delete are safe)
-        std::unordered_map<volatile int *, int> wr_depth_set;
+        // Completions of one batch mostly come from a few endpoints, so
+        // their WR credits are returned with one atomic per run
+        volatile int *wr_depth = nullptr;
+        int wr_count = 0;
         for (ssize_t i = 0; i < ret; i++) {
             EfaOpContext *op_ctx =
                 reinterpret_cast<EfaOpContext *>(entries[i].op_context);
             if (op_ctx && op_ctx->slice) {
-                op_ctx->slice->markSuccess();
-                if (op_ctx->wr_depth) {
-                    wr_depth_set[op_ctx->wr_depth]++;
+                if (op_ctx->wr_depth != wr_depth) {
+                    if (wr_count) __sync_fetch_and_sub(wr_depth, wr_count);
+                    wr_depth = op_ctx->wr_depth;
+                    wr_count = 0;
                 }
+                if (wr_depth) wr_count++;
+                op_ctx->slice->markSuccess();
                 delete op_ctx;
             }
         }
-        for (auto &entry : wr_depth_set) {
-            __sync_fetch_and_sub(entry.first, entry.second);
-        }
+        if (wr_count) __sync_fetch_and_sub(wr_depth, wr_count);
         __sync_fetch_and_sub(&cq_list_[cq_index]->outstanding,
                              static_cast<int>(ret));
         return static_cast<int>(ret);
@@ -45,17 +45,21 @@ EfaEndPoint::~EfaEndPoint() {
     if (ep_) deconstruct();
 }
 
-int EfaEndPoint::construct(struct fid_cq *cq, size_t num_qp_list,
-                           size_t max_sge, size_t max_wr, size_t max_inline) {
+int EfaEndPoint::construct(int cq_index, size_t num_qp_list, size_t max_sge,
+                           size_t max_wr, size_t max_inline) {
     if (status_.load(std::memory_order_relaxed) != INITIALIZING) {
         LOG(ERROR) << "EFA Endpoint has already been constructed";
         return ERR_ENDPOINT;
     }
 
-    tx_cq_ = cq;
-    rx_cq_ = cq;  // Use same CQ for TX and RX
+    tx_cq_ = context_.cq(cq_index);
+    rx_cq_ = tx_cq_;  // Use same CQ for TX and RX
+    if (!tx_cq_) {
+        LOG(ERROR) << "Invalid EFA CQ index " << cq_index;
+        return ERR_ENDPOINT;
+    }
     max_wr_depth_ = max_wr;
-    cq_outstanding_ = context_.cqOutstandingCount(0);
+    cq_outstanding_ = context_.cqOutstandingCount(cq_index);
 
     // Create endpoint
     int ret = fi_endpoint(context_.domain(), context_.info(), &ep_, nullptr);
@@ -293,6 +297,101 @@ int EfaEndPoint::doSetupConnection(const std::string &peer_addr,
     return 0;
 }
 
+bool EfaEndPoint::reserveSlot() {
+    // Atomically reserve CQ and WR capacity before posting, to prevent CQ
+    // overflow when multiple threads post to endpoints sharing the same
+    // CQ. The CQ has a fixed capacity (max_cqe); if more completions
+    // arrive than it can hold, the provider silently drops them and those
+    // slices never complete (hang).
+    const int kMaxBackoffYields = 100000;
+    const int cq_limit = static_cast<int>(globalConfig().max_cqe);
+    int backoff = 0;
+    while (true) {
+        // Try to reserve one WR slot
+        int cur_wr = wr_depth_;
+        if (cur_wr >= max_wr_depth_) {
+            if (++backoff > kMaxBackoffYields) return false;
+            std::this_thread::yield();
+            continue;
+        }
+        if (!__sync_bool_compare_and_swap(&wr_depth_, cur_wr, cur_wr + 1)) {
+            continue;  // CAS failed, retry immediately
+        }
+        // WR slot reserved. Now try to reserve CQ slot.
+        if (!cq_outstanding_) return true;
+        int cur_cq = *cq_outstanding_;
+        while (cur_cq < cq_limit) {
+            if (__sync_bool_compare_and_swap(cq_outstanding_, cur_cq,
+                                             cur_cq + 1))
+                return true;
+            cur_cq = *cq_outstanding_;
+        }
+        // CQ full - release WR reservation and back off
+        __sync_fetch_and_sub(&wr_depth_, 1);
+        if (++backoff > kMaxBackoffYields) return false;
+        std::this_thread::yield();
+    }
+}
+
+void EfaEndPoint::releaseSlot() {
+    __sync_fetch_and_sub(&wr_depth_, 1);
+    if (cq_outstanding_) __sync_fetch_and_sub(cq_outstanding_, 1);
+}
+
+size_t EfaEndPoint::postBatch(EfaOpContext **ops, size_t count) {
+    size_t posted = 0;
+    // Serialize posts per-endpoint: concurrent posts on the same RDM
+    // endpoint corrupt provider state. Cross-endpoint safety is handled by
+    // the FI_THREAD_SAFE hint.
+    while (post_lock_.test_and_set(std::memory_order_acquire)) {
+    }
+    for (size_t i = 0; i < count; ++i) {
+        Transport::Slice *slice = ops[i]->slice;
+        struct iovec iov = {(void *)slice->source_addr, slice->length};
+        void *local_desc = ops[i]->local_desc;
+        struct fi_rma_iov rma_iov = {slice->rdma.dest_addr, slice->length,
+                                     slice->rdma.dest_rkey};
+        struct fi_msg_rma msg = {};
+        msg.msg_iov = &iov;
+        msg.desc = &local_desc;
+        msg.iov_count = 1;
+        msg.addr = peer_fi_addr_;
+        msg.rma_iov = &rma_iov;
+        msg.rma_iov_count = 1;
+        msg.context = &ops[i]->fi_ctx;
+        // FI_MORE lets the provider ring one doorbell for the whole batch
+        bool more = i + 1 < count;
+        ssize_t ret;
+        while (true) {
+            uint64_t flags = FI_COMPLETION | (more ? FI_MORE : 0);
+            ret = slice->opcode == Transport::TransferRequest::READ
+                      ? fi_readmsg(ep_, &msg, flags)
+                      : fi_writemsg(ep_, &msg, flags);
+            if (ret != -FI_EAGAIN) break;
+            // Provider queue full: post without FI_MORE so that the
+            // operations queued so far are flushed, then retry
+            more = false;
+            std::this_thread::yield();
+        }
+        if (ret) {
+            // Operations already queued with FI_MORE are flushed by the
+            // provider's progress engine, which the CQ pollers drive
+            LOG(ERROR) << "EFA post failed: " << fi_strerror(-ret)
+                       << " (source=" << slice->source_addr
+                       << ", len=" << slice->length
+                       << ", dest=" << (void *)slice->rdma.dest_addr
+                       << ", rkey=" << slice->rdma.dest_rkey << ")";
+            break;
+        }
+        // Do NOT mark success here! Success is marked only after CQ
+        // completion in pollCq.
+        slice->status = Transport::Slice::PENDING;
+        ++posted;
+    }
+    post_lock_.clear(std::memory_order_release);
+    return posted;
+}
+
 int EfaEndPoint::submitPostSend(
     std::vector<Transport::Slice *> &slice_list,
     std::vector<Transport::Slice *> &failed_slice_list) {
@@ -309,132 +408,60 @@ int EfaEndPoint::submitPostSend(
         }
     }
 
-    // Process slices - using fi_write for RDMA write operations.
-    // Use atomic reserve-before-post to prevent CQ overflow when multiple
-    // threads post to endpoints sharing the same CQ.  The CQ has a fixed
-    // capacity (max_cqe); if more completions arrive than it can hold, the
-    // provider silently drops them and those slices never complete (hang).
-    const int kMaxBackoffYields = 100000;
-    const int cq_limit = static_cast<int>(globalConfig().max_cqe);
-
-    for (auto it = slice_list.begin(); it != slice_list.end();) {
-        // --- Atomically reserve CQ and WR capacity before posting ---
-        // This eliminates the TOCTOU race where multiple threads pass the
-        // capacity check simultaneously and collectively overflow the CQ.
-        int backoff = 0;
-        bool reserved = false;
-        while (!reserved) {
-            // Try to reserve one WR slot
-            int cur_wr = wr_depth_;
-            if (cur_wr >= max_wr_depth_) {
-                if (++backoff > kMaxBackoffYields) goto timeout;
-                std::this_thread::yield();
-                continue;
-            }
-            if (!__sync_bool_compare_and_swap(&wr_depth_, cur_wr, cur_wr + 1)) {
-                continue;  // CAS failed, retry immediately
-            }
-            // WR slot reserved. Now try to reserve CQ slot.
-            if (cq_outstanding_) {
-                int cur_cq = *cq_outstanding_;
-                while (cur_cq < cq_limit) {
-                    if (__sync_bool_compare_and_swap(cq_outstanding_, cur_cq,
-                                                     cur_cq + 1)) {
-                        reserved = true;
-                        break;
-                    }
-                    cur_cq = *cq_outstanding_;
-                }
-                if (!reserved) {
-                    // CQ full - release WR reservation and back off
-                    __sync_fetch_and_sub(&wr_depth_, 1);
-                    if (++backoff > kMaxBackoffYields) goto timeout;
-                    std::this_thread::yield();
-                    continue;
-                }
-            } else {
-                reserved = true;
-            }
-        }
-
-        {
-            Transport::Slice *slice = *it;
-
+    // Slices are posted in batches of up to kMaxPostBatch operations, each
+    // reserved up front and posted with a single doorbell
+    const size_t kMaxPostBatch = 32;
+    EfaOpContext *batch[kMaxPostBatch];
+    size_t index = 0;
+    while (index < slice_list.size()) {
+        size_t count = 0;
+        bool timed_out = false;
+        while (count < kMaxPostBatch && index < slice_list.size()) {
+            Transport::Slice *slice = slice_list[index];
             // Get memory region descriptor for the local buffer
             void *local_desc = context_.mrDesc(slice->source_addr);
             if (!local_desc) {
                 LOG(ERROR) << "No MR descriptor found for address "
                            << slice->source_addr;
-                // Release reservations
-                __sync_fetch_and_sub(&wr_depth_, 1);
-                if (cq_outstanding_) __sync_fetch_and_sub(cq_outstanding_, 1);
                 failed_slice_list.push_back(slice);
-                it = slice_list.erase(it);
+                ++index;
                 continue;
             }
-
-            // Allocate operation context to track the slice for completion
-            // Note: This memory is freed after CQ completion in pollCq
+            if (!reserveSlot()) {
+                timed_out = true;
+                break;
+            }
+            // Allocate operation context to track the slice for
+            // completion. Note: This memory is freed after CQ completion
+            // in pollCq
             EfaOpContext *op_ctx = new EfaOpContext();
             memset(op_ctx, 0, sizeof(EfaOpContext));
             op_ctx->slice = slice;
             op_ctx->wr_depth = &wr_depth_;
+            op_ctx->local_desc = local_desc;
+            batch[count++] = op_ctx;
+            ++index;
+        }
 
-            // Serialize fi_write per-endpoint: concurrent fi_write on the
-            // same RDM endpoint corrupts provider state.  Cross-endpoint
-            // safety is handled by the FI_THREAD_SAFE hint.
-            while (post_lock_.test_and_set(std::memory_order_acquire)) {
-            }
-            ssize_t ret = fi_write(ep_,
-                                   (void *)slice->source_addr,  // local buffer
-                                   slice->length, local_desc, peer_fi_addr_,
-                                   slice->rdma.dest_addr,  // remote address
-                                   slice->rdma.dest_rkey,  // remote key
-                                   &op_ctx->fi_ctx);  // context for completion
-            post_lock_.clear(std::memory_order_release);
-
-            if (ret == 0) {
-                // Successfully posted - do NOT mark success here!
-                // Success is marked only after CQ completion in pollCq.
-                // WR and CQ reservations are already accounted for.
-                slice->status = Transport::Slice::PENDING;
-                it = slice_list.erase(it);
-            } else if (ret == -FI_EAGAIN) {
-                // Provider queue full - release reservations and retry
-                delete op_ctx;
-                __sync_fetch_and_sub(&wr_depth_, 1);
-                if (cq_outstanding_) __sync_fetch_and_sub(cq_outstanding_, 1);
-                std::this_thread::yield();
-                // Don't advance iterator - retry the same slice
-            } else {
-                // Hard error - release reservations
-                LOG(ERROR) << "fi_write failed: " << fi_strerror(-ret)
-                           << " (source=" << slice->source_addr
-                           << ", len=" << slice->length
-                           << ", dest=" << (void *)slice->rdma.dest_addr
-                           << ", rkey=" << slice->rdma.dest_rkey << ")";
-                delete op_ctx;
-                __sync_fetch_and_sub(&wr_depth_, 1);
-                if (cq_outstanding_) __sync_fetch_and_sub(cq_outstanding_, 1);
-                failed_slice_list.push_back(slice);
-                it = slice_list.erase(it);
-            }
+        size_t posted = postBatch(batch, count);
+        for (size_t i = posted; i < count; ++i) {
+            // Hard error - release reservations
+            failed_slice_list.push_back(batch[i]->slice);
+            delete batch[i];
+            releaseSlot();
         }
-        continue;
-
-    timeout:
-        LOG(WARNING) << "EFA submitPostSend: timed out waiting for CQ drain"
-                     << " (wr_depth=" << wr_depth_ << ", max=" << max_wr_depth_
-                     << ", cq_outstanding="
-                     << (cq_outstanding_ ? *cq_outstanding_ : -1)
-                     << ", max_cqe=" << cq_limit << ")";
-        for (; it != slice_list.end(); ++it) {
-            failed_slice_list.push_back(*it);
+
+        if (timed_out) {
+            LOG(WARNING) << "EFA submitPostSend: timed out waiting for CQ drain"
+                         << " (wr_depth=" << wr_depth_
+                         << ", max=" << max_wr_depth_ << ", cq_outstanding="
+                         << (cq_outstanding_ ? *cq_outstanding_ : -1)
+                         << ", max_cqe=" << globalConfig().max_cqe << ")";
+            for (; index < slice_list.size(); ++index)
+                failed_slice_list.push_back(slice_list[index]);
         }
-        slice_list.clear();
-        return 0;
     }
-
+    slice_list.clear();
     return 0;
 }
 
@@ -74,7 +74,10 @@ void EfaTransport::stopWorkerThreads() {
 }
 
 void EfaTransport::workerThreadFunc(int thread_id) {
-    const int kPollBatchSize = 64;
+    const int kPollBatchSize = EfaContext::kMaxPollBatch;
+    // Full batches mean more completions are waiting, so a CQ is read
+    // again, up to this many times, before moving on
+    const int kMaxPollRounds = 4;
 
     while (worker_running_) {
         bool did_work = false;
@@ -86,9 +89,10 @@ void EfaTransport::workerThreadFunc(int thread_id) {
             if (!context || !context->active()) continue;
 
             for (size_t cq_idx = 0; cq_idx < context->cqCount(); cq_idx++) {
-                int completed = context->pollCq(kPollBatchSize, cq_idx);
-                if (completed > 0) {
-                    did_work = true;
+                for (int round = 0; round < kMaxPollRounds; ++round) {
+                    int completed = context->pollCq(kPollBatchSize, cq_idx);
+                    if (completed > 0) did_work = true;
+                    if (completed < kPollBatchSize) break;
                 }
             }
         }
@@ -428,7 +432,7 @@ Status EfaTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
     std::vector<TransferTask *> task_list;
     for (auto &task : batch_desc.task_list) task_list.push_back(&task);
     return submitTransferTask(task_list);
@@ -445,6 +449,8 @@ Status EfaTransport::submitTransferTask(
     const size_t kFragmentSize = globalConfig().fragment_limit;
     const size_t kSubmitWatermark =
         globalConfig().max_wr * globalConfig().num_qp_per_ep;
+    thread_local size_t stripe_start = 0;
+    std::vector<int> stripe_devices;
     uint64_t nr_slices;
     for (size_t index = 0; index < task_list.size(); ++index) {
         assert(task_list[index]);
@@ -461,6 +467,27 @@ Status EfaTransport::submitTransferTask(
             request_device_id = -1;
         }
 
+        // The slices of a large request are striped over all active
+        // devices close to its buffer. SRD already sprays the packets of
+        // one device over many paths, so the bandwidth to gain is that of
+        // the other devices.
+        stripe_devices.clear();
+        if (request_buffer_id >= 0 &&
+            request.length > kBlockSize + kFragmentSize) {
+            auto &topology = local_segment_desc->topology;
+            auto *candidates = &topology.candidateDevices(
+                local_segment_desc->buffers[request_buffer_id].name);
+            if (candidates->empty())
+                candidates = &topology.candidateDevices(kWildcardLocation);
+            for (int device_id : *candidates)
+                if (device_id >= 0 &&
+                    (size_t)device_id < context_list_.size() &&
+                    context_list_[device_id]->active())
+                    stripe_devices.push_back(device_id);
+        }
+        // Requests start on different devices, so small stripes spread too
+        size_t stripe_index = stripe_start++;
+
         for (uint64_t offset = 0; offset < request.length;
              offset += kBlockSize) {
             Slice *slice = getSliceCache().allocate();
@@ -492,6 +519,9 @@ Status EfaTransport::submitTransferTask(
                 found_device = true;
                 buffer_id = request_buffer_id;
                 device_id = request_device_id;
+                if (!stripe_devices.empty())
+                    device_id = stripe_devices[stripe_index++ %
+                                               stripe_devices.size()];
             }
             while (retry_cnt < kMaxRetryCount && !found_device) {
                 if (selectDevice(local_segment_desc.get(),
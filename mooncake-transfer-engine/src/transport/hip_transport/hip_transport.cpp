@@ -16,6 +16,7 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -36,8 +37,12 @@ namespace mooncake {
 // These can be overridden via environment variables:
 // - MC_HIP_NUM_STREAMS: number of HIP streams per device
 // - MC_HIP_NUM_EVENTS: number of HIP events per device
+// - MC_HIP_STRIPE_SIZE: smallest part, in bytes, a copy is split into
+// - MC_HIP_MAX_STRIPES: number of streams a copy is split over
 constexpr int kDefaultNumStreams = 64;
 constexpr int kDefaultNumEvents = 64;
+constexpr int kDefaultStripeSize = 4 * 1024 * 1024;
+constexpr int kDefaultMaxStripes = 4;
 
 // HIP-specific type aliases
 constexpr auto HIPX_MEM_HANDLE_TYPE_FABRIC =
@@ -258,42 +263,31 @@ static void setupP2PAccess(int num_devices) {
     }
 }
 
-static int getNumStreams() {
-    const char *env = getenv("MC_HIP_NUM_STREAMS");
+static int getPositiveEnv(const char *name, int default_value) {
+    const char *env = getenv(name);
     if (env) {
         try {
             int value = std::stoi(env);
             if (value > 0) {
                 return value;
             }
-            LOG(WARNING) << "MC_HIP_NUM_STREAMS value " << value
+            LOG(WARNING) << name << " value " << value
                          << " must be positive, using default "
-                         << kDefaultNumStreams;
+                         << default_value;
         } catch (...) {
-            LOG(WARNING) << "Invalid MC_HIP_NUM_STREAMS value, using default "
-                         << kDefaultNumStreams;
+            LOG(WARNING) << "Invalid " << name << " value, using default "
+                         << default_value;
         }
     }
-    return kDefaultNumStreams;
+    return default_value;
+}
+
+static int getNumStreams() {
+    return getPositiveEnv("MC_HIP_NUM_STREAMS", kDefaultNumStreams);
 }
 
 static int getNumEvents() {
-    const char *env = getenv("MC_HIP_NUM_EVENTS");
-    if (env) {
-        try {
-            int value = std::stoi(env);
-            if (value > 0) {
-                return value;
-            }
-            LOG(WARNING) << "MC_HIP_NUM_EVENTS value " << value
-                         << " must be positive, using default "
-                         << kDefaultNumEvents;
-        } catch (...) {
-            LOG(WARNING) << "Invalid MC_HIP_NUM_EVENTS value, using default "
-                         << kDefaultNumEvents;
-        }
-    }
-    return kDefaultNumEvents;
+    return getPositiveEnv("MC_HIP_NUM_EVENTS", kDefaultNumEvents);
 }
 
 static bool supportFabricMem() {
@@ -346,6 +340,15 @@ static bool supportFabricMem() {
 
 HipTransport::HipTransport()
     : use_fabric_mem_(supportFabricMem()),
+      mappings_(globalConfig().nvlink_max_open_mappings,
+                [this](void *addr) {
+                    if (use_fabric_mem_)
+                        freePinnedLocalMemory(addr);
+                    else
+                        (void)hipIpcCloseMemHandle(addr);
+                }),
+      stripe_size_(getPositiveEnv("MC_HIP_STRIPE_SIZE", kDefaultStripeSize)),
+      max_stripes_(getPositiveEnv("MC_HIP_MAX_STRIPES", kDefaultMaxStripes)),
       stream_pool_(getNumStreams()),
       event_pool_(getNumEvents()) {
     // Enable P2P access for IPC mode
@@ -360,18 +363,7 @@ HipTransport::HipTransport()
     }
 }
 
-HipTransport::~HipTransport() {
-    if (use_fabric_mem_) {
-        for (auto &entry : remap_entries_) {
-            freePinnedLocalMemory(entry.second.shm_addr);
-        }
-    } else {
-        for (auto &entry : remap_entries_) {
-            (void)hipIpcCloseMemHandle(entry.second.shm_addr);
-        }
-    }
-    remap_entries_.clear();
-}
+HipTransport::~HipTransport() { mappings_.clear(); }
 
 int HipTransport::install(std::string &local_server_name,
                           std::shared_ptr<TransferMetadata> metadata,
@@ -390,50 +382,76 @@ int HipTransport::install(std::string &local_server_name,
     return 0;
 }
 
-Status HipTransport::startAsyncTransfer(const TransferRequest &request,
-                                        TransferTask &task,
-                                        PendingTransfer &pending) {
-    hipError_t err;
+Status HipTransport::startAsyncTransfer(
+    const TransferRequest &request, TransferTask &task,
+    std::vector<PendingTransfer> &pending_transfers) {
     int device_id;
 
     if (setDeviceContext(request.source, device_id) != 0) {
         return Status::InvalidArgument("Failed to set device context");
     }
 
-    // Relocate shared memory address if needed
-    uint64_t dest_addr = request.target_offset;
-    if (request.target_id != LOCAL_SEGMENT_ID) {
-        int rc = relocateSharedMemoryAddress(dest_addr, request.length,
-                                             request.target_id);
-        if (rc) return Status::Memory("device memory not registered");
-    }
-
     task.total_bytes = request.length;
 
-    // Allocate and configure slice
-    Slice *slice = getSliceCache().allocate();
-    slice->source_addr = (char *)request.source;
-    slice->local.dest_addr = (char *)dest_addr;
-    slice->length = request.length;
-    slice->opcode = request.opcode;
-    slice->task = &task;
-    slice->target_id = request.target_id;
-    slice->status = Slice::PENDING;
+    // Copies on different streams run on different SDMA engines, so a
+    // large copy is split to use more of the XGMI bandwidth
+    size_t stripes = 1;
+    if (request.length > stripe_size_) {
+        stripes = std::min(
+            max_stripes_, (request.length + stripe_size_ - 1) / stripe_size_);
+    }
+    uint64_t chunk = (request.length + stripes - 1) / stripes;
+    if (chunk) stripes = (request.length + chunk - 1) / chunk;
+
+    // Counted first, as a failed slice may complete the task at once
+    __sync_fetch_and_add(&task.slice_count, stripes);
+
+    Status result = Status::OK();
+    for (size_t i = 0; i < stripes; ++i) {
+        uint64_t offset = i * chunk;
+        Slice *slice = getSliceCache().allocate();
+        slice->source_addr = (char *)request.source + offset;
+        slice->local.dest_addr = (char *)(request.target_offset + offset);
+        slice->local.remote_base = 0;
+        slice->length = std::min(chunk, request.length - offset);
+        slice->opcode = request.opcode;
+        slice->task = &task;
+        slice->target_id = request.target_id;
+        slice->status = Slice::PENDING;
+        task.slice_list.push_back(slice);
+
+        if (!result.ok()) {
+            slice->markFailed();
+            continue;
+        }
+        result = issueCopy(slice, device_id, pending_transfers);
+    }
+    return result;
+}
 
-    task.slice_list.push_back(slice);
+Status HipTransport::issueCopy(
+    Slice *slice, int device_id,
+    std::vector<PendingTransfer> &pending_transfers) {
+    hipError_t err;
 
-    __sync_fetch_and_add(&task.slice_count, 1);
+    // Relocate shared memory address if needed
+    if (slice->target_id != LOCAL_SEGMENT_ID) {
+        uint64_t dest_addr = (uint64_t)slice->local.dest_addr;
+        int rc = relocateSharedMemoryAddress(dest_addr, slice->length,
+                                             slice->target_id,
+                                             slice->local.remote_base);
+        if (rc) {
+            slice->markFailed();
+            return Status::Memory("device memory not registered");
+        }
+        slice->local.dest_addr = (char *)dest_addr;
+    }
 
-    // Get event and stream from pools
-    hipEvent_t event = event_pool_.getEvent(device_id);
     hipStream_t stream = stream_pool_.getNextStream(device_id);
-
-    if (event == nullptr || stream == nullptr) {
+    if (stream == nullptr) {
+        releaseMapping(slice);
         slice->markFailed();
-        if (event != nullptr) {
-            event_pool_.putEvent(event, device_id);
-        }
-        return Status::Memory("Failed to get event or stream from pool");
+        return Status::Memory("Failed to get stream from pool");
     }
 
     // Perform async memory copy
@@ -446,38 +464,57 @@ Status HipTransport::startAsyncTransfer(const TransferRequest &request,
     }
 
     if (!checkHip(err, "HipTransport: hipMemcpyAsync failed")) {
+        releaseMapping(slice);
         slice->markFailed();
-        event_pool_.putEvent(event, device_id);
         return Status::Memory("HipTransport: Async memory copy failed");
     }
 
-    // Record event on the stream
-    err = hipEventRecord(event, stream);
-    if (!checkHip(err, "HipTransport: hipEventRecord failed")) {
-        slice->markFailed();
-        event_pool_.putEvent(event, device_id);
-        return Status::Memory("HipTransport: Failed to record event");
+    for (auto &pt : pending_transfers) {
+        if (pt.stream == stream) {
+            pt.slices.push_back(slice);
+            return Status::OK();
+        }
     }
-
-    // Store pending transfer info
-    pending.event = event;
-    pending.device_id = device_id;
-    pending.slice = slice;
-
+    pending_transfers.push_back({stream, device_id, nullptr, {slice}});
     return Status::OK();
 }
 
+void HipTransport::releaseMapping(Slice *slice) {
+    if (slice->target_id != LOCAL_SEGMENT_ID)
+        mappings_.release({slice->target_id, slice->local.remote_base});
+}
+
 void HipTransport::synchronizePendingTransfers(
     std::vector<PendingTransfer> &pending_transfers) {
+    // Record all events first, so that the streams run while we wait
     for (auto &pt : pending_transfers) {
-        // Wait for event to complete
-        hipError_t err = hipEventSynchronize(pt.event);
-        if (err == hipSuccess) {
-            pt.slice->markSuccess();
-        } else {
-            LOG(ERROR) << "HipTransport: hipEventSynchronize failed: "
+        pt.event = event_pool_.getEvent(pt.device_id);
+        if (pt.event == nullptr) continue;
+        if (!checkHip(hipSetDevice(pt.device_id),
+                      "HipTransport: failed to set device context") ||
+            !checkHip(hipEventRecord(pt.event, pt.stream),
+                      "HipTransport: hipEventRecord failed")) {
+            event_pool_.putEvent(pt.event, pt.device_id);
+            pt.event = nullptr;
+        }
+    }
+
+    for (auto &pt : pending_transfers) {
+        // Without an event, wait for everything queued on the stream
+        hipError_t err = pt.event ? hipEventSynchronize(pt.event)
+                                  : hipStreamSynchronize(pt.stream);
+        if (err != hipSuccess) {
+            LOG(ERROR) << "HipTransport: synchronize failed: "
                        << hipGetErrorString(err);
-            pt.slice->markFailed();
+        }
+
+        // A settled slice may be freed at once, so the mappings go first
+        for (auto *slice : pt.slices) releaseMapping(slice);
+        for (auto *slice : pt.slices) {
+            if (err == hipSuccess)
+                slice->markSuccess();
+            else
+                slice->markFailed();
         }
 
         // Return event to pool
@@ -497,32 +534,25 @@ Status HipTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
 
     // Submit async transfers and collect pending transfer info
     std::vector<PendingTransfer> pending_transfers;
-    pending_transfers.reserve(entries.size());
+    Status result = Status::OK();
 
     for (auto &request : entries) {
         TransferTask &task = batch_desc.task_list[task_id];
         ++task_id;
 
-        PendingTransfer pending;
-        Status status = startAsyncTransfer(request, task, pending);
-        if (!status.ok()) {
-            // Clean up any pending transfers we've already created
-            for (auto &pt : pending_transfers) {
-                event_pool_.putEvent(pt.event, pt.device_id);
-            }
-            return status;
-        }
-        pending_transfers.push_back(pending);
+        result = startAsyncTransfer(request, task, pending_transfers);
+        if (!result.ok()) break;
     }
 
-    // Synchronize all pending transfers and mark slices as complete
+    // Synchronize all pending transfers and mark slices as complete,
+    // including those issued before a failure
     synchronizePendingTransfers(pending_transfers);
 
-    return Status::OK();
+    return result;
 }
 
 Status HipTransport::getTransferStatus(BatchID batch_id, size_t task_id,
@@ -561,7 +591,7 @@ Status HipTransport::submitTransferTask(
     const std::vector<TransferTask *> &task_list) {
     // Submit async transfers and collect pending transfer info
     std::vector<PendingTransfer> pending_transfers;
-    pending_transfers.reserve(task_list.size());
+    Status result = Status::OK();
 
     for (auto *task_ptr : task_list) {
         assert(task_ptr);
@@ -569,22 +599,15 @@ Status HipTransport::submitTransferTask(
         assert(task.request);
         auto &request = *task.request;
 
-        PendingTransfer pending;
-        Status status = startAsyncTransfer(request, task, pending);
-        if (!status.ok()) {
-            // Clean up any pending transfers we've already created
-            for (auto &pt : pending_transfers) {
-                event_pool_.putEvent(pt.event, pt.device_id);
-            }
-            return status;
-        }
-        pending_transfers.push_back(pending);
+        result = startAsyncTransfer(request, task, pending_transfers);
+        if (!result.ok()) break;
     }
 
-    // Synchronize all pending transfers and mark slices as complete
+    // Synchronize all pending transfers and mark slices as complete,
+    // including those issued before a failure
     synchronizePendingTransfers(pending_transfers);
 
-    return Status::OK();
+    return result;
 }
 
 int HipTransport::registerLocalMemory(void *addr, size_t length,
@@ -612,9 +635,17 @@ int HipTransport::registerLocalMemory(void *addr, size_t length,
             return -1;
         }
 
+        // The handle covers the whole allocation, so buffers carved from
+        // one allocation are mapped once by the peers
+        void *base = addr;
+        size_t alloc_size = 0;
+        if (hipMemGetAddressRange((hipDeviceptr_t *)&base, &alloc_size,
+                                  (hipDeviceptr_t)addr) != hipSuccess)
+            base = addr;
+
         // Get IPC handle
         hipIpcMemHandle_t handle;
-        if (!checkHip(hipIpcGetMemHandle(&handle, addr),
+        if (!checkHip(hipIpcGetMemHandle(&handle, base),
                       "HipTransport: hipIpcGetMemHandle failed")) {
             return -1;
         }
@@ -624,6 +655,7 @@ int HipTransport::registerLocalMemory(void *addr, size_t length,
         BufferDesc desc;
         desc.addr = (uint64_t)addr;
         desc.length = length;
+        desc.offset = (uint64_t)addr - (uint64_t)base;
         desc.name = location;
         desc.shm_name = serializeBinaryData(&handle, sizeof(hipIpcMemHandle_t));
         return metadata_->addLocalMemoryBuffer(desc, true);
@@ -679,62 +711,46 @@ int HipTransport::unregisterLocalMemory(void *addr, bool update_metadata) {
     return metadata_->removeLocalMemoryBuffer(addr, update_metadata);
 }
 
+void *HipTransport::openRemoteMemory(const BufferDesc &entry,
+                                     uint64_t length) {
+    std::vector<unsigned char> output_buffer;
+    deserializeBinaryData(entry.shm_name, output_buffer);
+
+    void *shm_addr = nullptr;
+    int rc = -1;
+    if (output_buffer.size() == sizeof(hipIpcMemHandle_t) &&
+        !use_fabric_mem_) {
+        rc = openIPCHandle(output_buffer, &shm_addr);
+    } else if (output_buffer.size() == sizeof(hipxFabricHandle) &&
+               use_fabric_mem_) {
+        rc = openShareableHandle(output_buffer, length, &shm_addr);
+    } else {
+        LOG(ERROR) << "Mismatched HIP data transfer method";
+    }
+    return rc ? nullptr : shm_addr;
+}
+
 int HipTransport::relocateSharedMemoryAddress(uint64_t &dest_addr,
                                               uint64_t length,
-                                              uint64_t target_id) {
+                                              uint64_t target_id,
+                                              uint64_t &remote_base) {
     auto desc = metadata_->getSegmentDescByID(target_id);
+    if (!desc) return ERR_INVALID_ARGUMENT;
 
     // Search for matching buffer entry
     for (auto &entry : desc->buffers) {
         if (!entry.shm_name.empty() && entry.addr <= dest_addr &&
             dest_addr + length <= entry.addr + entry.length) {
-            // Check if already remapped (shared lock)
-            remap_lock_.lockShared();
-            if (remap_entries_.count(std::make_pair(target_id, entry.addr))) {
-                auto shm_addr =
-                    remap_entries_[std::make_pair(target_id, entry.addr)]
-                        .shm_addr;
-                remap_lock_.unlockShared();
-                dest_addr = dest_addr - entry.addr + ((uint64_t)shm_addr);
-                return 0;
-            }
-            remap_lock_.unlockShared();
-
-            RWSpinlock::WriteGuard lock_guard(remap_lock_);
-            if (!remap_entries_.count(std::make_pair(target_id, entry.addr))) {
-                std::vector<unsigned char> output_buffer;
-                deserializeBinaryData(entry.shm_name, output_buffer);
-
-                void *shm_addr = nullptr;
-                int rc = -1;
-
-                if (output_buffer.size() == sizeof(hipIpcMemHandle_t) &&
-                    !use_fabric_mem_) {
-                    rc = openIPCHandle(output_buffer, &shm_addr);
-                } else if (output_buffer.size() == sizeof(hipxFabricHandle) &&
-                           use_fabric_mem_) {
-                    rc = openShareableHandle(output_buffer, entry.length,
-                                             &shm_addr);
-                } else {
-                    LOG(ERROR) << "Mismatched HIP data transfer method";
-                    return -1;
-                }
-
-                if (rc != 0) {
-                    return -1;
-                }
-
-                OpenedShmEntry shm_entry;
-                shm_entry.shm_addr = shm_addr;
-                shm_entry.length = entry.length;
-                remap_entries_[std::make_pair(target_id, entry.addr)] =
-                    shm_entry;
-            }
+            // Buffers of one allocation share a single mapping of it
+            const uint64_t base = entry.addr - entry.offset;
+            void *shm_addr = mappings_.acquire({target_id, base}, [&] {
+                return openRemoteMemory(entry, entry.offset + entry.length);
+            });
+            if (!shm_addr) return -1;
 
             // Calculate relocated address
-            auto shm_addr =
-                remap_entries_[std::make_pair(target_id, entry.addr)].shm_addr;
-            dest_addr = dest_addr - entry.addr + ((uint64_t)shm_addr);
+            remote_base = base;
+            dest_addr = dest_addr - base + ((uint64_t)shm_addr);
             return 0;
         }
     }
@@ -743,6 +759,23 @@ int HipTransport::relocateSharedMemoryAddress(uint64_t &dest_addr,
     return ERR_INVALID_ARGUMENT;
 }
 
+int HipTransport::warmupSegment(SegmentID target_id) {
+    auto desc = metadata_->getSegmentDescByID(target_id);
+    if (!desc) return ERR_INVALID_ARGUMENT;
+    int ret = 0;
+    for (auto &entry : desc->buffers) {
+        if (entry.shm_name.empty()) continue;
+        uint64_t dest_addr = entry.addr, remote_base = 0;
+        if (relocateSharedMemoryAddress(dest_addr, entry.length, target_id,
+                                        remote_base)) {
+            ret = -1;
+            continue;
+        }
+        mappings_.release({target_id, remote_base});
+    }
+    return ret;
+}
+
 int HipTransport::registerLocalMemoryBatch(
     const std::vector<Transport::BufferEntry> &buffer_list,
     const std::string &location) {
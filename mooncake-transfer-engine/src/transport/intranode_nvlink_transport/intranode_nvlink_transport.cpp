@@ -105,7 +105,9 @@ static bool enableP2PAccess(int src_device_id, int dst_device_id) {
 
     return true;
 }
-IntraNodeNvlinkTransport::IntraNodeNvlinkTransport() {}
+IntraNodeNvlinkTransport::IntraNodeNvlinkTransport()
+    : mappings_(globalConfig().nvlink_max_open_mappings,
+                [](void *addr) { cudaIpcCloseMemHandle(addr); }) {}
 
 // IntraNodeNvlinkTransport::IntraNodeNvlinkTransport() :
 // use_fabric_mem_(supportFabricMem()) {}
@@ -138,12 +140,7 @@ IntraNodeNvlinkTransport::IntraNodeNvlinkTransport() {}
 //     }
 // }
 
-IntraNodeNvlinkTransport::~IntraNodeNvlinkTransport() {
-    for (auto &entry : remap_entries_) {
-        cudaIpcCloseMemHandle(entry.second.shm_addr);
-    }
-    remap_entries_.clear();
-}
+IntraNodeNvlinkTransport::~IntraNodeNvlinkTransport() { mappings_.clear(); }
 
 int IntraNodeNvlinkTransport::install(
     std::string &local_server_name, std::shared_ptr<TransferMetadata> metadata,
@@ -174,38 +171,31 @@ Status IntraNodeNvlinkTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
 
     for (auto &request : entries) {
         TransferTask &task = batch_desc.task_list[task_id];
         ++task_id;
         uint64_t dest_addr = request.target_offset;
+        uint64_t remote_base = 0;
         if (request.target_id != LOCAL_SEGMENT_ID) {
             int rc = relocateSharedMemoryAddress(dest_addr, request.length,
-                                                 request.target_id);
+                                                 request.target_id,
+                                                 remote_base);
             if (rc) return Status::Memory("device memory not registered");
         }
         task.total_bytes = request.length;
         Slice *slice = getSliceCache().allocate();
         slice->source_addr = (char *)request.source;
         slice->local.dest_addr = (char *)dest_addr;
+        slice->local.remote_base = remote_base;
         slice->length = request.length;
         slice->opcode = request.opcode;
         slice->task = &task;
         slice->target_id = request.target_id;
         slice->status = Slice::PENDING;
         __sync_fetch_and_add(&task.slice_count, 1);
-        cudaError_t err;
-        if (slice->opcode == TransferRequest::READ)
-            err = cudaMemcpy(slice->source_addr, (void *)slice->local.dest_addr,
-                             slice->length, cudaMemcpyDefault);
-        else
-            err = cudaMemcpy((void *)slice->local.dest_addr, slice->source_addr,
-                             slice->length, cudaMemcpyDefault);
-        if (err != cudaSuccess)
-            slice->markFailed();
-        else
-            slice->markSuccess();
+        copySlice(slice);
     }
 
     return Status::OK();
@@ -247,15 +237,18 @@ Status IntraNodeNvlinkTransport::submitTransferTask(
         assert(task.request);
         auto &request = *task.request;
         uint64_t dest_addr = request.target_offset;
+        uint64_t remote_base = 0;
         if (request.target_id != LOCAL_SEGMENT_ID) {
             int rc = relocateSharedMemoryAddress(dest_addr, request.length,
-                                                 request.target_id);
+                                                 request.target_id,
+                                                 remote_base);
             if (rc) return Status::Memory("device memory not registered");
         }
         task.total_bytes = request.length;
         Slice *slice = getSliceCache().allocate();
         slice->source_addr = (char *)request.source;
         slice->local.dest_addr = (char *)dest_addr;
+        slice->local.remote_base = remote_base;
         slice->length = request.length;
         slice->opcode = request.opcode;
         slice->task = &task;
@@ -263,21 +256,28 @@ Status IntraNodeNvlinkTransport::submitTransferTask(
         slice->status = Slice::PENDING;
         task.slice_list.push_back(slice);
         __sync_fetch_and_add(&task.slice_count, 1);
-        cudaError_t err;
-        if (slice->opcode == TransferRequest::READ)
-            err = cudaMemcpy(slice->source_addr, (void *)slice->local.dest_addr,
-                             slice->length, cudaMemcpyDefault);
-        else
-            err = cudaMemcpy((void *)slice->local.dest_addr, slice->source_addr,
-                             slice->length, cudaMemcpyDefault);
-        if (err != cudaSuccess)
-            slice->markFailed();
-        else
-            slice->markSuccess();
+        copySlice(slice);
     }
     return Status::OK();
 }
 
+void IntraNodeNvlinkTransport::copySlice(Slice *slice) {
+    cudaError_t err;
+    if (slice->opcode == TransferRequest::READ)
+        err = cudaMemcpy(slice->source_addr, (void *)slice->local.dest_addr,
+                         slice->length, cudaMemcpyDefault);
+    else
+        err = cudaMemcpy((void *)slice->local.dest_addr, slice->source_addr,
+                         slice->length, cudaMemcpyDefault);
+    // A settled slice may be freed at once, so the mapping goes first
+    if (slice->target_id != LOCAL_SEGMENT_ID)
+        mappings_.release({slice->target_id, slice->local.remote_base});
+    if (err != cudaSuccess)
+        slice->markFailed();
+    else
+        slice->markSuccess();
+}
+
 int IntraNodeNvlinkTransport::registerLocalMemory(void *addr, size_t length,
                                                   const std::string &location,
                                                   bool remote_accessible,
@@ -299,8 +299,16 @@ int IntraNodeNvlinkTransport::registerLocalMemory(void *addr, size_t length,
         return -1;
     }
 
+    // The handle covers the whole allocation, so buffers carved from one
+    // allocation are mapped once by the peers
+    void *base = addr;
+    size_t alloc_size = 0;
+    if (cuMemGetAddressRange((CUdeviceptr *)&base, &alloc_size,
+                             (CUdeviceptr)addr) != CUDA_SUCCESS)
+        base = addr;
+
     cudaIpcMemHandle_t handle;
-    err = cudaIpcGetMemHandle(&handle, addr);
+    err = cudaIpcGetMemHandle(&handle, base);
     if (err != cudaSuccess) {
         LOG(ERROR) << "IntraNodeNvlinkTransport: cudaIpcGetMemHandle failed";
         return -1;
@@ -310,6 +318,7 @@ int IntraNodeNvlinkTransport::registerLocalMemory(void *addr, size_t length,
     BufferDesc desc;
     desc.addr = (uint64_t)addr;
     desc.length = length;
+    desc.offset = (uint64_t)addr - (uint64_t)base;
     desc.name = location;
     desc.shm_name = serializeBinaryData(&handle, sizeof(cudaIpcMemHandle_t));
     return metadata_->addLocalMemoryBuffer(desc, true);
@@ -320,62 +329,64 @@ int IntraNodeNvlinkTransport::unregisterLocalMemory(void *addr,
     return metadata_->removeLocalMemoryBuffer(addr, update_metadata);
 }
 
-int IntraNodeNvlinkTransport::relocateSharedMemoryAddress(uint64_t &dest_addr,
-                                                          uint64_t length,
-                                                          uint64_t target_id) {
+int IntraNodeNvlinkTransport::relocateSharedMemoryAddress(
+    uint64_t &dest_addr, uint64_t length, uint64_t target_id,
+    uint64_t &remote_base) {
     auto desc = metadata_->getSegmentDescByID(target_id);
-    int index = 0;
+    if (!desc) return ERR_INVALID_ARGUMENT;
     for (auto &entry : desc->buffers) {
         if (!entry.shm_name.empty() && entry.addr <= dest_addr &&
             dest_addr + length <= entry.addr + entry.length) {
-            remap_lock_.lockShared();
-            if (remap_entries_.count(std::make_pair(target_id, entry.addr))) {
-                auto shm_addr =
-                    remap_entries_[std::make_pair(target_id, entry.addr)]
-                        .shm_addr;
-                remap_lock_.unlockShared();
-                dest_addr = dest_addr - entry.addr + ((uint64_t)shm_addr);
-                return 0;
-            }
-            remap_lock_.unlockShared();
-            RWSpinlock::WriteGuard lock_guard(remap_lock_);
-            if (!remap_entries_.count(std::make_pair(target_id, entry.addr))) {
+            // Buffers of one allocation share a single mapping of it
+            const uint64_t base = entry.addr - entry.offset;
+            void *shm_addr = mappings_.acquire({target_id, base}, [&]() {
                 std::vector<unsigned char> output_buffer;
                 deserializeBinaryData(entry.shm_name, output_buffer);
-                if (output_buffer.size() == sizeof(cudaIpcMemHandle_t)) {
-                    cudaIpcMemHandle_t handle;
-                    memcpy(&handle, output_buffer.data(), sizeof(handle));
-                    void *shm_addr = nullptr;
-                    cudaError_t err = cudaIpcOpenMemHandle(
-                        &shm_addr, handle, cudaIpcMemLazyEnablePeerAccess);
-                    if (err != cudaSuccess) {
-                        LOG(ERROR) << "IntraNodeNvlinkTransport: "
-                                      "cudaIpcOpenMemHandle failed: "
-                                   << cudaGetErrorString(err);
-                        return -1;
-                    }
-                    OpenedShmEntry shm_entry;
-                    shm_entry.shm_addr = shm_addr;
-                    shm_entry.length = entry.length;
-                    remap_entries_[std::make_pair(target_id, entry.addr)] =
-                        shm_entry;
-                } else {
+                if (output_buffer.size() != sizeof(cudaIpcMemHandle_t)) {
                     LOG(ERROR) << "Mismatched NVLink data transfer method";
-                    return -1;
+                    return (void *)nullptr;
+                }
+                cudaIpcMemHandle_t handle;
+                memcpy(&handle, output_buffer.data(), sizeof(handle));
+                void *addr = nullptr;
+                cudaError_t err = cudaIpcOpenMemHandle(
+                    &addr, handle, cudaIpcMemLazyEnablePeerAccess);
+                if (err != cudaSuccess) {
+                    LOG(ERROR) << "IntraNodeNvlinkTransport: "
+                                  "cudaIpcOpenMemHandle failed: "
+                               << cudaGetErrorString(err);
+                    return (void *)nullptr;
                 }
-            }
-            auto shm_addr =
-                remap_entries_[std::make_pair(target_id, entry.addr)].shm_addr;
-            dest_addr = dest_addr - entry.addr + ((uint64_t)shm_addr);
+                return addr;
+            });
+            if (!shm_addr) return -1;
+            remote_base = base;
+            dest_addr = dest_addr - base + ((uint64_t)shm_addr);
             return 0;
         }
-        index++;
     }
     LOG(ERROR) << "Requested address " << (void *)dest_addr << " to "
                << (void *)(dest_addr + length) << " not found!";
     return ERR_INVALID_ARGUMENT;
 }
 
+int IntraNodeNvlinkTransport::warmupSegment(SegmentID target_id) {
+    auto desc = metadata_->getSegmentDescByID(target_id);
+    if (!desc) return ERR_INVALID_ARGUMENT;
+    int ret = 0;
+    for (auto &entry : desc->buffers) {
+        if (entry.shm_name.empty()) continue;
+        uint64_t dest_addr = entry.addr, remote_base = 0;
+        if (relocateSharedMemoryAddress(dest_addr, entry.length, target_id,
+                                        remote_base)) {
+            ret = -1;
+            continue;
+        }
+        mappings_.release({target_id, remote_base});
+    }
+    return ret;
+}
+
 int IntraNodeNvlinkTransport::registerLocalMemoryBatch(
     const std::vector<Transport::BufferEntry> &buffer_list,
     const std::string &location) {
@@ -23,6 +23,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <iomanip>
+#include <map>
 #include <memory>
 
 #include "common.h"
@@ -132,7 +133,15 @@ static bool enableP2PAccess(int src_device_id, int dst_device_id) {
     return true;
 }
 
-NvlinkTransport::NvlinkTransport() : use_fabric_mem_(supportFabricMem()) {}
+NvlinkTransport::NvlinkTransport()
+    : running_(false),
+      use_fabric_mem_(supportFabricMem()),
+      mappings_(globalConfig().nvlink_max_open_mappings, [this](void *addr) {
+          if (use_fabric_mem_)
+              freePinnedLocalMemory(addr);
+          else
+              cudaIpcCloseMemHandle(addr);
+      }) {}
 //     int num_devices = getNumDevices();
 //     if (globalConfig().trace) {
 //         LOG(INFO) << "NvlinkTransport: use_fabric_mem_:" << use_fabric_mem_
@@ -161,16 +170,22 @@ NvlinkTransport::NvlinkTransport() : use_fabric_mem_(supportFabricMem()) {}
 // }
 
 NvlinkTransport::~NvlinkTransport() {
-    if (use_fabric_mem_) {
-        for (auto &entry : remap_entries_) {
-            freePinnedLocalMemory(entry.second.shm_addr);
-        }
-    } else {
-        for (auto &entry : remap_entries_) {
-            cudaIpcCloseMemHandle(entry.second.shm_addr);
+    // The completion thread retires all copies still in flight
+    if (running_) {
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            running_ = false;
         }
+        pending_cv_.notify_all();
+        completion_thread_.join();
+    }
+    for (auto &entry : free_events_) {
+        for (auto event : entry.second) cudaEventDestroy(event);
     }
-    remap_entries_.clear();
+    for (auto &entry : streams_) {
+        for (auto stream : entry.second) cudaStreamDestroy(stream);
+    }
+    mappings_.clear();
 }
 
 int NvlinkTransport::install(std::string &local_server_name,
@@ -179,15 +194,189 @@ int NvlinkTransport::install(std::string &local_server_name,
     metadata_ = metadata;
     local_server_name_ = local_server_name;
 
-    auto desc = std::make_shared<SegmentDesc>();
-    if (!desc) return ERR_MEMORY;
-    desc->name = local_server_name_;
-    desc->protocol = "nvlink";
-    metadata_->addLocalSegment(LOCAL_SEGMENT_ID, local_server_name_,
-                               std::move(desc));
+    // Installed next to RdmaTransport, the segment stays an RDMA segment
+    // whose buffers also carry the NVLink handles
+    if (!metadata_->getSegmentDescByID(LOCAL_SEGMENT_ID)) {
+        auto desc = std::make_shared<SegmentDesc>();
+        if (!desc) return ERR_MEMORY;
+        desc->name = local_server_name_;
+        desc->protocol = "nvlink";
+        metadata_->addLocalSegment(LOCAL_SEGMENT_ID, local_server_name_,
+                                   std::move(desc));
+    }
+
+    running_ = true;
+    completion_thread_ = std::thread(&NvlinkTransport::completionWorker, this);
     return 0;
 }
 
+static int getLocalDevice(void *addr, int default_device) {
+    cudaPointerAttributes attr;
+    if (cudaPointerGetAttributes(&attr, addr) != cudaSuccess) {
+        cudaGetLastError();
+        return default_device;
+    }
+    if (attr.type != cudaMemoryTypeDevice) return default_device;
+    return attr.device;
+}
+
+cudaStream_t NvlinkTransport::getStream(int device_id, uint64_t target_id) {
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    auto &device_streams = streams_[device_id];
+    if (device_streams.empty()) {
+        for (size_t i = 0; i < globalConfig().nvlink_streams_per_device; ++i) {
+            cudaStream_t stream;
+            if (!checkCudaErrorReturn(
+                    cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking),
+                    "NvlinkTransport: failed to create stream"))
+                break;
+            device_streams.push_back(stream);
+        }
+        if (device_streams.empty()) return nullptr;
+    }
+    // Copies to one peer stay in order, different peers overlap
+    return device_streams[target_id % device_streams.size()];
+}
+
+cudaEvent_t NvlinkTransport::getEvent(int device_id) {
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        auto &events = free_events_[device_id];
+        if (!events.empty()) {
+            auto event = events.back();
+            events.pop_back();
+            return event;
+        }
+    }
+    // Blocking sync lets the completion thread sleep on the oldest copy
+    cudaEvent_t event;
+    if (!checkCudaErrorReturn(
+            cudaEventCreateWithFlags(
+                &event, cudaEventDisableTiming | cudaEventBlockingSync),
+            "NvlinkTransport: failed to create event"))
+        return nullptr;
+    return event;
+}
+
+void NvlinkTransport::submitSlices(const std::vector<Slice *> &slices) {
+    int prev_device = 0;
+    cudaGetDevice(&prev_device);
+
+    std::map<std::pair<int, uint64_t>, std::vector<Slice *>> groups;
+    for (auto *slice : slices) {
+        int device_id = getLocalDevice(slice->source_addr, prev_device);
+        groups[{device_id, slice->target_id}].push_back(slice);
+    }
+
+    for (auto &[key, group] : groups) {
+        const int device_id = key.first;
+        cudaStream_t stream = nullptr;
+        if (checkCudaErrorReturn(cudaSetDevice(device_id),
+                                 "NvlinkTransport: failed to set device"))
+            stream = getStream(device_id, key.second);
+
+        if (!stream) {
+            for (auto *slice : group) {
+                releaseMapping(slice);
+                slice->markFailed();
+            }
+            continue;
+        }
+
+        std::vector<Slice *> issued;
+        for (auto *slice : group) {
+            cudaError_t err;
+            if (slice->opcode == TransferRequest::READ)
+                err = cudaMemcpyAsync(slice->source_addr,
+                                      (void *)slice->local.dest_addr,
+                                      slice->length, cudaMemcpyDefault, stream);
+            else
+                err = cudaMemcpyAsync((void *)slice->local.dest_addr,
+                                      slice->source_addr, slice->length,
+                                      cudaMemcpyDefault, stream);
+            if (checkCudaErrorReturn(
+                    err, "NvlinkTransport: cudaMemcpyAsync failed")) {
+                issued.push_back(slice);
+            } else {
+                releaseMapping(slice);
+                slice->markFailed();
+            }
+        }
+        if (issued.empty()) continue;
+
+        PendingCopy copy{getEvent(device_id), device_id, std::move(issued)};
+        if (!copy.event ||
+            !checkCudaErrorReturn(cudaEventRecord(copy.event, stream),
+                                  "NvlinkTransport: cudaEventRecord failed")) {
+            // Without an event, wait for the copies here
+            retireCopy(copy, cudaStreamSynchronize(stream));
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            pending_.push_back(std::move(copy));
+        }
+        pending_cv_.notify_one();
+    }
+
+    cudaSetDevice(prev_device);
+}
+
+void NvlinkTransport::releaseMapping(Slice *slice) {
+    if (slice->target_id != LOCAL_SEGMENT_ID)
+        mappings_.release({slice->target_id, slice->local.remote_base});
+}
+
+void NvlinkTransport::retireCopy(PendingCopy &copy, cudaError_t result) {
+    // A settled slice may be freed at once, so the mappings go first
+    for (auto *slice : copy.slices) releaseMapping(slice);
+    if (result == cudaSuccess) {
+        for (auto *slice : copy.slices) slice->markSuccess();
+    } else {
+        LOG(ERROR) << "NvlinkTransport: copy failed: "
+                   << cudaGetErrorString(result);
+        for (auto *slice : copy.slices) slice->markFailed();
+    }
+    if (copy.event) {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        free_events_[copy.device_id].push_back(copy.event);
+    }
+}
+
+void NvlinkTransport::completionWorker() {
+    while (true) {
+        std::deque<PendingCopy> copies;
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex_);
+            pending_cv_.wait(lock,
+                             [&] { return !running_ || !pending_.empty(); });
+            if (pending_.empty()) return;
+            copies.swap(pending_);
+        }
+
+        // Retire every finished copy, or wait for the oldest one
+        std::deque<PendingCopy> unfinished;
+        for (auto &copy : copies) {
+            cudaError_t result = cudaEventQuery(copy.event);
+            if (result == cudaErrorNotReady)
+                unfinished.push_back(std::move(copy));
+            else
+                retireCopy(copy, result);
+        }
+        if (unfinished.size() == copies.size()) {
+            auto &oldest = unfinished.front();
+            retireCopy(oldest, cudaEventSynchronize(oldest.event));
+            unfinished.pop_front();
+        }
+        if (!unfinished.empty()) {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            pending_.insert(pending_.begin(),
+                            std::make_move_iterator(unfinished.begin()),
+                            std::make_move_iterator(unfinished.end()));
+        }
+    }
+}
+
 Status NvlinkTransport::submitTransfer(
     BatchID batch_id, const std::vector<TransferRequest> &entries) {
     auto &batch_desc = *((BatchDesc *)(batch_id));
@@ -201,40 +390,39 @@ Status NvlinkTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
 
+    std::vector<Slice *> slices;
+    slices.reserve(entries.size());
     for (auto &request : entries) {
         TransferTask &task = batch_desc.task_list[task_id];
         ++task_id;
         uint64_t dest_addr = request.target_offset;
+        uint64_t remote_base = 0;
         if (request.target_id != LOCAL_SEGMENT_ID) {
             int rc = relocateSharedMemoryAddress(dest_addr, request.length,
-                                                 request.target_id);
-            if (rc) return Status::Memory("device memory not registered");
+                                                 request.target_id,
+                                                 remote_base);
+            if (rc) {
+                submitSlices(slices);
+                return Status::Memory("device memory not registered");
+            }
         }
         task.total_bytes = request.length;
         Slice *slice = getSliceCache().allocate();
         slice->source_addr = (char *)request.source;
         slice->local.dest_addr = (char *)dest_addr;
+        slice->local.remote_base = remote_base;
         slice->length = request.length;
         slice->opcode = request.opcode;
         slice->task = &task;
         slice->target_id = request.target_id;
         slice->status = Slice::PENDING;
         __sync_fetch_and_add(&task.slice_count, 1);
-        cudaError_t err;
-        if (slice->opcode == TransferRequest::READ)
-            err = cudaMemcpy(slice->source_addr, (void *)slice->local.dest_addr,
-                             slice->length, cudaMemcpyDefault);
-        else
-            err = cudaMemcpy((void *)slice->local.dest_addr, slice->source_addr,
-                             slice->length, cudaMemcpyDefault);
-        if (err != cudaSuccess)
-            slice->markFailed();
-        else
-            slice->markSuccess();
+        slices.push_back(slice);
     }
 
+    submitSlices(slices);
     return Status::OK();
 }
 
@@ -266,21 +454,29 @@ Status NvlinkTransport::getTransferStatus(BatchID batch_id, size_t task_id,
 
 Status NvlinkTransport::submitTransferTask(
     const std::vector<TransferTask *> &task_list) {
+    std::vector<Slice *> slices;
+    slices.reserve(task_list.size());
     for (size_t index = 0; index < task_list.size(); ++index) {
         assert(task_list[index]);
         auto &task = *task_list[index];
         assert(task.request);
         auto &request = *task.request;
         uint64_t dest_addr = request.target_offset;
+        uint64_t remote_base = 0;
         if (request.target_id != LOCAL_SEGMENT_ID) {
             int rc = relocateSharedMemoryAddress(dest_addr, request.length,
-                                                 request.target_id);
-            if (rc) return Status::Memory("device memory not registered");
+                                                 request.target_id,
+                                                 remote_base);
+            if (rc) {
+                submitSlices(slices);
+                return Status::Memory("device memory not registered");
+            }
         }
         task.total_bytes = request.length;
         Slice *slice = getSliceCache().allocate();
         slice->source_addr = (char *)request.source;
         slice->local.dest_addr = (char *)dest_addr;
+        slice->local.remote_base = remote_base;
         slice->length = request.length;
         slice->opcode = request.opcode;
         slice->task = &task;
@@ -288,18 +484,9 @@ Status NvlinkTransport::submitTransferTask(
         slice->status = Slice::PENDING;
         task.slice_list.push_back(slice);
         __sync_fetch_and_add(&task.slice_count, 1);
-        cudaError_t err;
-        if (slice->opcode == TransferRequest::READ)
-            err = cudaMemcpy(slice->source_addr, (void *)slice->local.dest_addr,
-                             slice->length, cudaMemcpyDefault);
-        else
-            err = cudaMemcpy((void *)slice->local.dest_addr, slice->source_addr,
-                             slice->length, cudaMemcpyDefault);
-        if (err != cudaSuccess)
-            slice->markFailed();
-        else
-            slice->markSuccess();
+        slices.push_back(slice);
     }
+    submitSlices(slices);
     return Status::OK();
 }
 
@@ -325,8 +512,16 @@ int NvlinkTransport::registerLocalMemory(void *addr, size_t length,
             return -1;
         }
 
+        // The handle covers the whole allocation, so buffers carved from
+        // one allocation are mapped once by the peers
+        void *base = addr;
+        size_t alloc_size = 0;
+        if (cuMemGetAddressRange((CUdeviceptr *)&base, &alloc_size,
+                                 (CUdeviceptr)addr) != CUDA_SUCCESS)
+            base = addr;
+
         cudaIpcMemHandle_t handle;
-        err = cudaIpcGetMemHandle(&handle, addr);
+        err = cudaIpcGetMemHandle(&handle, base);
         if (err != cudaSuccess) {
             LOG(ERROR) << "NvlinkTransport: cudaIpcGetMemHandle failed";
             return -1;
@@ -336,6 +531,7 @@ int NvlinkTransport::registerLocalMemory(void *addr, size_t length,
         BufferDesc desc;
         desc.addr = (uint64_t)addr;
         desc.length = length;
+        desc.offset = (uint64_t)addr - (uint64_t)base;
         desc.name = location;
         desc.shm_name =
             serializeBinaryData(&handle, sizeof(cudaIpcMemHandle_t));
@@ -388,117 +584,111 @@ int NvlinkTransport::unregisterLocalMemory(void *addr, bool update_metadata) {
     return metadata_->removeLocalMemoryBuffer(addr, update_metadata);
 }
 
+void *NvlinkTransport::openRemoteMemory(const BufferDesc &entry,
+                                        uint64_t length) {
+    std::vector<unsigned char> output_buffer;
+    deserializeBinaryData(entry.shm_name, output_buffer);
+    if (output_buffer.size() == sizeof(cudaIpcMemHandle_t) &&
+        !use_fabric_mem_) {
+        cudaIpcMemHandle_t handle;
+        memcpy(&handle, output_buffer.data(), sizeof(handle));
+        void *shm_addr = nullptr;
+        cudaError_t err = cudaIpcOpenMemHandle(&shm_addr, handle,
+                                               cudaIpcMemLazyEnablePeerAccess);
+        if (err != cudaSuccess) {
+            LOG(ERROR) << "NvlinkTransport: cudaIpcOpenMemHandle failed: "
+                       << cudaGetErrorString(err);
+            return nullptr;
+        }
+        return shm_addr;
+    } else if (output_buffer.size() == sizeof(CUmemFabricHandle) &&
+               use_fabric_mem_) {
+        CUmemFabricHandle export_handle;
+        memcpy(&export_handle, output_buffer.data(), sizeof(export_handle));
+        void *shm_addr = nullptr;
+        CUmemGenericAllocationHandle handle;
+        auto result = cuMemImportFromShareableHandle(
+            &handle, &export_handle, CU_MEM_HANDLE_TYPE_FABRIC);
+        if (result != CUDA_SUCCESS) {
+            LOG(ERROR) << "NvlinkTransport: "
+                          "cuMemImportFromShareableHandle failed: "
+                       << result;
+            return nullptr;
+        }
+        result = cuMemAddressReserve((CUdeviceptr *)&shm_addr, length, 0, 0, 0);
+        if (result != CUDA_SUCCESS) {
+            LOG(ERROR) << "NvlinkTransport: cuMemAddressReserve failed: "
+                       << result;
+            return nullptr;
+        }
+        result = cuMemMap((CUdeviceptr)shm_addr, length, 0, handle, 0);
+        if (result != CUDA_SUCCESS) {
+            LOG(ERROR) << "NvlinkTransport: cuMemMap failed: " << result;
+            return nullptr;
+        }
+
+        int device_count;
+        cudaGetDeviceCount(&device_count);
+        CUmemAccessDesc accessDesc[device_count];
+        for (int device_id = 0; device_id < device_count; ++device_id) {
+            accessDesc[device_id].location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+            accessDesc[device_id].location.id = device_id;
+            accessDesc[device_id].flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+        }
+        result = cuMemSetAccess((CUdeviceptr)shm_addr, length, accessDesc,
+                                device_count);
+        if (result != CUDA_SUCCESS) {
+            LOG(ERROR) << "NvlinkTransport: cuMemSetAccess failed: " << result;
+            return nullptr;
+        }
+        return shm_addr;
+    }
+    LOG(ERROR) << "Mismatched NVLink data transfer method";
+    return nullptr;
+}
+
 int NvlinkTransport::relocateSharedMemoryAddress(uint64_t &dest_addr,
                                                  uint64_t length,
-                                                 uint64_t target_id) {
+                                                 uint64_t target_id,
+                                                 uint64_t &remote_base) {
     auto desc = metadata_->getSegmentDescByID(target_id);
-    int index = 0;
+    if (!desc) return ERR_INVALID_ARGUMENT;
     for (auto &entry : desc->buffers) {
         if (!entry.shm_name.empty() && entry.addr <= dest_addr &&
             dest_addr + length <= entry.addr + entry.length) {
-            remap_lock_.lockShared();
-            if (remap_entries_.count(std::make_pair(target_id, entry.addr))) {
-                auto shm_addr =
-                    remap_entries_[std::make_pair(target_id, entry.addr)]
-                        .shm_addr;
-                remap_lock_.unlockShared();
-                dest_addr = dest_addr - entry.addr + ((uint64_t)shm_addr);
-                return 0;
-            }
-            remap_lock_.unlockShared();
-            RWSpinlock::WriteGuard lock_guard(remap_lock_);
-            if (!remap_entries_.count(std::make_pair(target_id, entry.addr))) {
-                std::vector<unsigned char> output_buffer;
-                deserializeBinaryData(entry.shm_name, output_buffer);
-                if (output_buffer.size() == sizeof(cudaIpcMemHandle_t) &&
-                    !use_fabric_mem_) {
-                    cudaIpcMemHandle_t handle;
-                    memcpy(&handle, output_buffer.data(), sizeof(handle));
-                    void *shm_addr = nullptr;
-                    cudaError_t err = cudaIpcOpenMemHandle(
-                        &shm_addr, handle, cudaIpcMemLazyEnablePeerAccess);
-                    if (err != cudaSuccess) {
-                        LOG(ERROR)
-                            << "NvlinkTransport: cudaIpcOpenMemHandle failed: "
-                            << cudaGetErrorString(err);
-                        return -1;
-                    }
-                    OpenedShmEntry shm_entry;
-                    shm_entry.shm_addr = shm_addr;
-                    shm_entry.length = entry.length;
-                    remap_entries_[std::make_pair(target_id, entry.addr)] =
-                        shm_entry;
-                } else if (output_buffer.size() == sizeof(CUmemFabricHandle) &&
-                           use_fabric_mem_) {
-                    CUmemFabricHandle export_handle;
-                    memcpy(&export_handle, output_buffer.data(),
-                           sizeof(export_handle));
-                    void *shm_addr = nullptr;
-                    CUmemGenericAllocationHandle handle;
-                    auto result = cuMemImportFromShareableHandle(
-                        &handle, &export_handle, CU_MEM_HANDLE_TYPE_FABRIC);
-                    if (result != CUDA_SUCCESS) {
-                        LOG(ERROR) << "NvlinkTransport: "
-                                      "cuMemImportFromShareableHandle failed: "
-                                   << result;
-                        return -1;
-                    }
-                    result = cuMemAddressReserve((CUdeviceptr *)&shm_addr,
-                                                 entry.length, 0, 0, 0);
-                    if (result != CUDA_SUCCESS) {
-                        LOG(ERROR)
-                            << "NvlinkTransport: cuMemAddressReserve failed: "
-                            << result;
-                        return -1;
-                    }
-                    result = cuMemMap((CUdeviceptr)shm_addr, entry.length, 0,
-                                      handle, 0);
-                    if (result != CUDA_SUCCESS) {
-                        LOG(ERROR)
-                            << "NvlinkTransport: cuMemMap failed: " << result;
-                        return -1;
-                    }
-
-                    int device_count;
-                    cudaGetDeviceCount(&device_count);
-                    CUmemAccessDesc accessDesc[device_count];
-                    for (int device_id = 0; device_id < device_count;
-                         ++device_id) {
-                        accessDesc[device_id].location.type =
-                            CU_MEM_LOCATION_TYPE_DEVICE;
-                        accessDesc[device_id].location.id = device_id;
-                        accessDesc[device_id].flags =
-                            CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
-                    }
-                    result = cuMemSetAccess((CUdeviceptr)shm_addr, entry.length,
-                                            accessDesc, device_count);
-                    if (result != CUDA_SUCCESS) {
-                        LOG(ERROR) << "NvlinkTransport: cuMemSetAccess failed: "
-                                   << result;
-                        return -1;
-                    }
-                    OpenedShmEntry shm_entry;
-                    shm_entry.shm_addr = shm_addr;
-                    shm_entry.length = entry.length;
-                    remap_entries_[std::make_pair(target_id, entry.addr)] =
-                        shm_entry;
-                } else {
-                    LOG(ERROR) << "Mismatched NVLink data transfer method";
-                    return -1;
-                }
-            }
-            auto shm_addr =
-                remap_entries_[std::make_pair(target_id, entry.addr)].shm_addr;
-            dest_addr = dest_addr - entry.addr + ((uint64_t)shm_addr);
+            // Buffers of one allocation share a single mapping of it
+            const uint64_t base = entry.addr - entry.offset;
+            void *shm_addr = mappings_.acquire({target_id, base}, [&] {
+                return openRemoteMemory(entry, entry.offset + entry.length);
+            });
+            if (!shm_addr) return -1;
+            remote_base = base;
+            dest_addr = dest_addr - base + ((uint64_t)shm_addr);
             return 0;
         }
-        index++;
     }
     LOG(ERROR) << "Requested address " << (void *)dest_addr << " to "
                << (void *)(dest_addr + length) << " not found!";
     return ERR_INVALID_ARGUMENT;
 }
 
+int NvlinkTransport::warmupSegment(SegmentID target_id) {
+    auto desc = metadata_->getSegmentDescByID(target_id);
+    if (!desc) return ERR_INVALID_ARGUMENT;
+    int ret = 0;
+    for (auto &entry : desc->buffers) {
+        if (entry.shm_name.empty()) continue;
+        uint64_t dest_addr = entry.addr, remote_base = 0;
+        if (relocateSharedMemoryAddress(dest_addr, entry.length, target_id,
+                                        remote_base)) {
+            ret = -1;
+            continue;
+        }
+        mappings_.release({target_id, remote_base});
+    }
+    return ret;
+}
+
 int NvlinkTransport::registerLocalMemoryBatch(
     const std::vector<Transport::BufferEntry> &buffer_list,
     const std::string &location) {
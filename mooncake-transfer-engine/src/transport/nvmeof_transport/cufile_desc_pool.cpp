@@ -16,6 +16,7 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <mutex>
 
@@ -24,8 +25,10 @@
 
 namespace mooncake {
 
-CUFileDescPool::CUFileDescPool(size_t max_batch_size)
-    : max_batch_size_(max_batch_size) {
+CUFileDescPool::CUFileDescPool(size_t max_batch_size, size_t max_inflight)
+    : max_batch_size_(max_batch_size),
+      max_inflight_(std::min(max_inflight, MAX_NR_DESC)),
+      tuner_(MIN_BATCH_SIZE, max_batch_size) {
     // Initialize descriptor array
     for (size_t i = 0; i < MAX_NR_DESC; ++i) {
         descs_[i] = nullptr;
@@ -63,7 +66,7 @@ int CUFileDescPool::allocCUfileDesc(size_t batch_size) {
 
     // Find a free slot (nullptr = free)
     int idx = -1;
-    for (size_t i = 0; i < MAX_NR_DESC; ++i) {
+    for (size_t i = 0; i < max_inflight_; ++i) {
         if (descs_[i] == nullptr) {
             idx = i;
             break;
@@ -71,7 +74,7 @@ int CUFileDescPool::allocCUfileDesc(size_t batch_size) {
     }
 
     if (idx < 0) {
-        LOG(ERROR) << "No Batch Descriptor Available";
+        VLOG(1) << "No Batch Descriptor Available";
         return -1;
     }
 
@@ -142,8 +145,10 @@ int CUFileDescPool::pushParams(int idx, const CUfileIOParams_t& io_params) {
     return 0;
 }
 
+// A descriptor is only used by the batch that allocated it, so submitting
+// and polling take the read lock and do not serialize other batches
 int CUFileDescPool::submitBatch(int idx) {
-    RWSpinlock::WriteGuard guard(mutex_);
+    RWSpinlock::ReadGuard guard(mutex_);
     if (idx < 0 || idx >= (int)MAX_NR_DESC || descs_[idx] == nullptr) {
         LOG(ERROR) << "Invalid descriptor index: " << idx;
         return -1;
@@ -156,37 +161,39 @@ int CUFileDescPool::submitBatch(int idx) {
     }
 
     // Submit all params in this descriptor
+    tuner_.onSubmit();
     CUFILE_CHECK(cuFileBatchIOSubmit(desc->batch_handle->handle,
                                      desc->io_params.size(),
                                      desc->io_params.data(), 0));
     return 0;
 }
 
-CUfileIOEvents_t CUFileDescPool::getTransferStatus(int idx, int slice_id) {
-    RWSpinlock::WriteGuard guard(mutex_);
+int CUFileDescPool::pollBatch(int idx, std::vector<CUfileIOEvents_t>& events) {
+    RWSpinlock::ReadGuard guard(mutex_);
     if (idx < 0 || idx >= (int)MAX_NR_DESC || descs_[idx] == nullptr) {
         LOG(ERROR) << "Invalid descriptor index: " << idx;
-        CUfileIOEvents_t event;
-        event.status = CUFILE_FAILED;
-        event.ret = -1;
-        return event;
+        return -1;
     }
 
     auto* desc = descs_[idx];
-    if (slice_id < 0 || slice_id >= (int)desc->io_params.size()) {
-        LOG(ERROR) << "Invalid slice_id " << slice_id << " for descriptor "
-                   << idx << " (size: " << desc->io_params.size() << ")";
-        CUfileIOEvents_t event;
-        event.status = CUFILE_FAILED;
-        event.ret = -1;
-        return event;
-    }
+    size_t total = desc->io_params.size();
+    if (desc->completed == total) return 0;
 
-    unsigned nr = desc->io_params.size();
+    // Each finished IO is reported once, identified by its cookie
+    unsigned nr = total - desc->completed;
     CUFILE_CHECK(cuFileBatchIOGetStatus(desc->batch_handle->handle, 0, &nr,
                                         desc->io_events.data(), nullptr));
-
-    return desc->io_events[slice_id];
+    for (unsigned i = 0; i < nr; ++i) {
+        auto& event = desc->io_events[i];
+        if (event.status == CUFILE_WAITING || event.status == CUFILE_PENDING)
+            continue;
+        if (event.status == CUFILE_COMPLETE && event.ret > 0)
+            desc->bytes += event.ret;
+        events.push_back(event);
+        ++desc->completed;
+    }
+    if (desc->completed == total) tuner_.onComplete(desc->bytes);
+    return total - desc->completed;
 }
 
 int CUFileDescPool::getSliceNum(int idx) {
@@ -209,7 +216,7 @@ int CUFileDescPool::freeCUfileDesc(int idx) {
     auto* desc = descs_[idx];
 
     // IMPORTANT: Caller should ensure all IOs are completed (via
-    // getTransferStatus) before calling freeCUfileDesc, as cuFile may still
+    // pollBatch) before calling freeCUfileDesc, as cuFile may still
     // access io_params otherwise. This is critical for the handle pooling
     // optimization - the handle will be immediately reused and could lead to
     // use-after-free bugs if IOs are in-flight.
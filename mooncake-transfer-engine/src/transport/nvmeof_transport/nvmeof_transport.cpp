@@ -27,6 +27,7 @@
 #include <tuple>
 
 #include "common.h"
+#include "config.h"
 #include "transfer_engine.h"
 #include "transfer_metadata.h"
 #include "transport/nvmeof_transport/cufile_context.h"
@@ -36,77 +37,89 @@
 namespace mooncake {
 NVMeoFTransport::NVMeoFTransport() {
     CUFILE_CHECK(cuFileDriverOpen());
-    desc_pool_ = std::make_shared<CUFileDescPool>();
+    auto &config = globalConfig();
+    desc_pool_ = std::make_shared<CUFileDescPool>(
+        config.nvmeof_max_batch_size, config.nvmeof_max_inflight_batches);
 }
 
 NVMeoFTransport::~NVMeoFTransport() {}
 
-Transport::TransferStatusEnum from_cufile_transfer_status(
-    CUfileStatus_t status) {
-    switch (status) {
-        case CUFILE_WAITING:
-            return Transport::WAITING;
-        case CUFILE_PENDING:
-            return Transport::PENDING;
-        case CUFILE_INVALID:
-            return Transport::INVALID;
-        case CUFILE_CANCELED:
-            return Transport::CANCELED;
-        case CUFILE_COMPLETE:
-            return Transport::COMPLETED;
-        case CUFILE_TIMEOUT:
-            return Transport::TIMEOUT;
-        case CUFILE_FAILED:
-            return Transport::FAILED;
-        default:
-            return Transport::FAILED;
-    }
-}
-
 NVMeoFTransport::BatchID NVMeoFTransport::allocateBatchID(size_t batch_size) {
     auto nvmeof_desc = new NVMeoFBatchDesc();
     auto batch_id = Transport::allocateBatchID(batch_size);
     auto &batch_desc = *((BatchDesc *)(batch_id));
-    nvmeof_desc->desc_idx_ = desc_pool_->allocCUfileDesc(batch_size);
-    nvmeof_desc->transfer_status.reserve(batch_size);
-    nvmeof_desc->task_to_slices.reserve(batch_size);
     batch_desc.context = nvmeof_desc;
     return batch_id;
 }
 
+void NVMeoFTransport::progress(NVMeoFBatchDesc &nvmeof_desc) {
+    std::vector<CUfileIOEvents_t> events;
+    {
+        std::lock_guard<std::mutex> lock(nvmeof_desc.mutex);
+        auto &inflight = nvmeof_desc.inflight;
+        for (auto it = inflight.begin(); it != inflight.end();) {
+            if (desc_pool_->pollBatch(*it, events) != 0) {
+                ++it;
+                continue;
+            }
+            desc_pool_->freeCUfileDesc(*it);
+            it = inflight.erase(it);
+        }
+
+        auto &pending = nvmeof_desc.pending;
+        while (!pending.empty()) {
+            size_t nr = std::min(desc_pool_->batchSize(), pending.size());
+            int idx = desc_pool_->allocCUfileDesc(nr);
+            if (idx < 0) break;  // retried on the next poll
+            for (size_t i = 0; i < nr; ++i) {
+                desc_pool_->pushParams(idx, pending.front());
+                pending.pop_front();
+            }
+            desc_pool_->submitBatch(idx);
+            inflight.push_back(idx);
+        }
+    }
+
+    // Last, as completing the batch may let its owner free it
+    for (auto &event : events) {
+        auto slice = (Slice *)event.cookie;
+        if (event.status == CUFILE_COMPLETE &&
+            event.ret == (ssize_t)slice->length)
+            slice->markSuccess();
+        else
+            slice->markFailed();
+    }
+}
+
 Status NVMeoFTransport::getTransferStatus(BatchID batch_id, size_t task_id,
                                           TransferStatus &status) {
     auto &batch_desc = *((BatchDesc *)(batch_id));
+    if (task_id >= batch_desc.task_list.size()) {
+        return Status::InvalidArgument(
+            "NVMeoFTransport::getTransferStatus invalid argument, batch id: " +
+            std::to_string(batch_id));
+    }
+    progress(*((NVMeoFBatchDesc *)(batch_desc.context)));
+
     auto &task = batch_desc.task_list[task_id];
-    auto &nvmeof_desc = *((NVMeoFBatchDesc *)(batch_desc.context));
-    // LOG(DEBUG) << "get t n " << nr;
-    // 1. get task -> id map
-    TransferStatus transfer_status = {.s = Transport::PENDING,
-                                      .transferred_bytes = 0};
-    auto [slice_id, slice_num] = nvmeof_desc.task_to_slices[task_id];
-    for (size_t i = slice_id; i < slice_id + slice_num; ++i) {
-        // LOG(INFO) << "task " << task_id << " i " << i << " upper bound " <<
-        // slice_num;
-        auto event =
-            desc_pool_->getTransferStatus(nvmeof_desc.desc_idx_, slice_id);
-        transfer_status.s = from_cufile_transfer_status(event.status);
-        // TODO(FIXME): what to do if multi slices have different status?
-        if (transfer_status.s == COMPLETED) {
-            transfer_status.transferred_bytes += event.ret;
+    status.transferred_bytes = task.transferred_bytes;
+    uint64_t success_slice_count = task.success_slice_count;
+    uint64_t failed_slice_count = task.failed_slice_count;
+    if (success_slice_count + failed_slice_count == task.slice_count) {
+        if (failed_slice_count) {
+            status.s = TransferStatusEnum::FAILED;
         } else {
-            break;
+            status.s = TransferStatusEnum::COMPLETED;
         }
-    }
-    if (transfer_status.s == COMPLETED) {
         task.is_finished = true;
+    } else {
+        status.s = TransferStatusEnum::WAITING;
     }
-    status = transfer_status;
     return Status::OK();
 }
 
 // Dummy implement for solving build issues, WIP
 Status NVMeoFTransport::submitTransferTask(
-    const std::vector<TransferRequest *> &request_list,
     const std::vector<TransferTask *> &task_list) {
     /* TBD */
     return Status::OK();
@@ -127,14 +140,14 @@ Status NVMeoFTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    size_t slice_id = desc_pool_->getSliceNum(nvmeof_desc.desc_idx_);
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
     std::unordered_map<SegmentID, std::shared_ptr<SegmentDesc>>
         segment_desc_map;
     // segment_desc_map[LOCAL_SEGMENT_ID] =
     // getSegmentDescByID(LOCAL_SEGMENT_ID);
     for (auto &request : entries) {
         TransferTask &task = batch_desc.task_list[task_id];
+        task.batch_id = batch_id;  // slices report completion to the batch
         auto target_id = request.target_id;
 
         if (!segment_desc_map.count(target_id)) {
@@ -170,8 +183,14 @@ Status NVMeoFTransport::submitTransfer(
                     (char *)request.source + slice_start - segment_start;
                 uint64_t file_offset = slice_start - current_offset;
                 uint64_t slice_len = slice_end - slice_start;
-                addSliceToTask(source_addr, slice_len, file_offset,
-                               request.opcode, task, file_path);
+                Slice *slice =
+                    addSliceToTask(source_addr, slice_len, file_offset,
+                                   request.opcode, task, file_path);
+                if (!slice) {
+                    ++buffer_id;
+                    current_offset += buffer_desc.length;
+                    continue;
+                }
                 // 4. get cufile handle
                 auto buf_key = std::make_pair(target_id, buffer_id);
                 CUfileHandle_t fh;
@@ -184,36 +203,31 @@ Status NVMeoFTransport::submitTransfer(
                     }
                     fh = segment_to_context_.at(buf_key)->getHandle();
                 }
-                // 5. add cufile request
-                addSliceToCUFileBatch(source_addr, file_offset, slice_len,
-                                      nvmeof_desc.desc_idx_, request.opcode,
-                                      fh);
+                // 5. queue cufile request
+                addSliceToCUFileBatch(slice, fh, nvmeof_desc);
             }
             ++buffer_id;
             current_offset += buffer_desc.length;
         }
 
-        nvmeof_desc.transfer_status.push_back(
-            TransferStatus{.s = PENDING, .transferred_bytes = 0});
-        nvmeof_desc.task_to_slices.push_back({slice_id, task.slice_count});
         ++task_id;
-        slice_id += task.slice_count;
     }
 
-    desc_pool_->submitBatch(nvmeof_desc.desc_idx_);
-    // LOG(INFO) << "submit nr " << slice_id << " start " << start_slice_id;
+    progress(nvmeof_desc);
     return Status::OK();
 }
 
 Status NVMeoFTransport::freeBatchID(BatchID batch_id) {
     auto &batch_desc = *((BatchDesc *)(batch_id));
-    auto &nvmeof_desc = *((NVMeoFBatchDesc *)(batch_desc.context));
-    int desc_idx = nvmeof_desc.desc_idx_;
+    auto nvmeof_desc = (NVMeoFBatchDesc *)(batch_desc.context);
     Status rc = Transport::freeBatchID(batch_id);
     if (rc != Status::OK()) {
         return rc;
     }
-    desc_pool_->freeCUfileDesc(desc_idx);
+    // Every IO finished, so its descriptor is freed; wait for a progress()
+    // call that may still be returning
+    { std::lock_guard<std::mutex> lock(nvmeof_desc->mutex); }
+    delete nvmeof_desc;
     return Status::OK();
 }
 
@@ -239,14 +253,12 @@ int NVMeoFTransport::unregisterLocalMemory(void *addr, bool update_metadata) {
     return 0;
 }
 
-void NVMeoFTransport::addSliceToTask(void *source_addr, uint64_t slice_len,
-                                     uint64_t target_start,
-                                     TransferRequest::OpCode op,
-                                     TransferTask &task,
-                                     const char *file_path) {
+Transport::Slice *NVMeoFTransport::addSliceToTask(
+    void *source_addr, uint64_t slice_len, uint64_t target_start,
+    TransferRequest::OpCode op, TransferTask &task, const char *file_path) {
     if (!source_addr || !file_path) {
         LOG(ERROR) << "Invalid source_addr or file_path";
-        return;
+        return nullptr;
     }
     Slice *slice = getSliceCache().allocate();
     slice->source_addr = (char *)source_addr;
@@ -260,23 +272,23 @@ void NVMeoFTransport::addSliceToTask(void *source_addr, uint64_t slice_len,
     task.slice_list.push_back(slice);
     task.total_bytes += slice->length;
     __sync_fetch_and_add(&task.slice_count, 1);
+    return slice;
 }
 
-void NVMeoFTransport::addSliceToCUFileBatch(
-    void *source_addr, uint64_t file_offset, uint64_t slice_len,
-    uint64_t desc_id, TransferRequest::OpCode op, CUfileHandle_t fh) {
+void NVMeoFTransport::addSliceToCUFileBatch(Slice *slice, CUfileHandle_t fh,
+                                            NVMeoFBatchDesc &nvmeof_desc) {
     CUfileIOParams_t params;
     params.mode = CUFILE_BATCH;
-    params.opcode =
-        op == Transport::TransferRequest::READ ? CUFILE_READ : CUFILE_WRITE;
-    params.cookie = (void *)0;
-    params.u.batch.devPtr_base = source_addr;
+    params.opcode = slice->opcode == Transport::TransferRequest::READ
+                        ? CUFILE_READ
+                        : CUFILE_WRITE;
+    params.cookie = slice;
+    params.u.batch.devPtr_base = slice->source_addr;
     params.u.batch.devPtr_offset = 0;
-    params.u.batch.file_offset = file_offset;
-    params.u.batch.size = slice_len;
+    params.u.batch.file_offset = slice->nvmeof.start;
+    params.u.batch.size = slice->length;
     params.fh = fh;
-    // LOG(INFO) << "params " << "base " << request.source << " offset " <<
-    // request.target_offset << " length " << request.length;
-    desc_pool_->pushParams(desc_id, params);
+    std::lock_guard<std::mutex> lock(nvmeof_desc.mutex);
+    nvmeof_desc.pending.push_back(params);
 }
 }  // namespace mooncake
@@ -123,6 +123,18 @@ size_t FIFOEndpointStore::getTotalQPNumber() {
     return total_qps;
 }
 
+size_t FIFOEndpointStore::getTotalWrDepth() {
+    RWSpinlock::ReadGuard guard(endpoint_map_lock_);
+    size_t total_wr_depth = 0;
+    for (const auto &kv : endpoint_map_) {
+        total_wr_depth += kv.second->getWrDepth();
+    }
+    for (const auto &endpoint : waiting_list_) {
+        total_wr_depth += endpoint->getWrDepth();
+    }
+    return total_wr_depth;
+}
+
 std::shared_ptr<RdmaEndPoint> SIEVEEndpointStore::getEndpoint(
     const std::string &peer_nic_path) {
     RWSpinlock::ReadGuard guard(endpoint_map_lock_);
@@ -255,4 +267,16 @@ size_t SIEVEEndpointStore::getTotalQPNumber() {
     return total_qps;
 }
 
+size_t SIEVEEndpointStore::getTotalWrDepth() {
+    RWSpinlock::ReadGuard guard(endpoint_map_lock_);
+    size_t total_wr_depth = 0;
+    for (const auto &kv : endpoint_map_) {
+        total_wr_depth += kv.second.first->getWrDepth();
+    }
+    for (const auto &endpoint : waiting_list_) {
+        total_wr_depth += endpoint->getWrDepth();
+    }
+    return total_wr_depth;
+}
+
 }  // namespace mooncake
@@ -16,9 +16,13 @@
 
 #include <fcntl.h>
 #include <sys/epoll.h>
+#ifdef USE_MLX5_DC
+#include <infiniband/mlx5dv.h>
+#endif
 
 #include <atomic>
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <memory>
 #include <thread>
@@ -90,6 +94,10 @@ int RdmaContext::construct(size_t num_cq_list, size_t num_comp_channels,
         return ERR_CONTEXT;
     }
 
+    if (config.use_odp) {
+        registerImplicitMemoryRegion();
+    }
+
     num_comp_channel_ = num_comp_channels;
     comp_channel_ = new ibv_comp_channel *[num_comp_channels];
     for (size_t i = 0; i < num_comp_channels; ++i) {
@@ -121,12 +129,20 @@ int RdmaContext::construct(size_t num_cq_list, size_t num_comp_channels,
             return ERR_CONTEXT;
         }
 
+    if (config.rdma_notify) {
+        setupNotify();
+    }
+
+    // Received notifications take CQ entries beyond the max_cqe of the
+    // outstanding WRs
+    const int kCqSize = max_cqe + (notifyEnabled() ? kNotifyBufferCount : 0);
     cq_list_.resize(num_cq_list);
     for (size_t i = 0; i < num_cq_list; ++i) {
+        cq_list_[i].channel = compChannel();
         auto cq =
-            ibv_create_cq(context_, max_cqe,
+            ibv_create_cq(context_, kCqSize,
                           (void *)&cq_list_[i].outstanding /* CQ context */,
-                          compChannel(), compVector());
+                          cq_list_[i].channel, compVector());
         if (!cq) {
             PLOG(ERROR) << "Failed to create completion queue";
             close(event_fd_);
@@ -135,6 +151,10 @@ int RdmaContext::construct(size_t num_cq_list, size_t num_comp_channels,
         cq_list_[i].native = cq;
     }
 
+    if (config.use_dc) {
+        setupDcTransport();
+    }
+
     worker_pool_ = std::make_shared<WorkerPool>(*this, socketId());
 
     LOG(INFO) << "RDMA device: " << context_->device->name << ", LID: " << lid_
@@ -161,6 +181,8 @@ int RdmaContext::deconstruct() {
     worker_pool_.reset();
 
     endpoint_store_->destroyQPs();
+    destroyDcTransport();
+    destroyNotify();
 
     for (auto &entry : memory_region_list_) {
         int ret = ibv_dereg_mr(entry.mr);
@@ -170,6 +192,13 @@ int RdmaContext::deconstruct() {
     }
     memory_region_list_.clear();
 
+    if (implicit_mr_) {
+        if (ibv_dereg_mr(implicit_mr_)) {
+            PLOG(ERROR) << "Failed to unregister implicit memory region";
+        }
+        implicit_mr_ = nullptr;
+    }
+
     for (size_t i = 0; i < cq_list_.size(); ++i) {
         if (!cq_list_[i].native) continue;
 
@@ -209,6 +238,444 @@ int RdmaContext::deconstruct() {
     return 0;
 }
 
+void RdmaContext::registerImplicitMemoryRegion() {
+    ibv_device_attr_ex attr = {};
+    if (ibv_query_device_ex(context_, nullptr, &attr)) {
+        PLOG(WARNING) << "Failed to query ODP capabilities of device "
+                      << device_name_ << ", registering memory explicitly";
+        return;
+    }
+    // RC requests are both sent and served from the registered memory
+    const uint32_t kRequiredRcCaps = IBV_ODP_SUPPORT_SEND |
+                                     IBV_ODP_SUPPORT_RECV |
+                                     IBV_ODP_SUPPORT_WRITE |
+                                     IBV_ODP_SUPPORT_READ;
+    if (!(attr.odp_caps.general_caps & IBV_ODP_SUPPORT_IMPLICIT) ||
+        (attr.odp_caps.per_transport_caps.rc_odp_caps & kRequiredRcCaps) !=
+            kRequiredRcCaps) {
+        LOG(WARNING) << "Device " << device_name_
+                     << " does not support implicit ODP for RC, registering "
+                        "memory explicitly";
+        return;
+    }
+    implicit_mr_ = ibv_reg_mr(pd_, nullptr, SIZE_MAX,
+                              IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE |
+                                  IBV_ACCESS_REMOTE_READ |
+                                  IBV_ACCESS_ON_DEMAND);
+    if (!implicit_mr_) {
+        PLOG(WARNING) << "Failed to register implicit ODP memory region on "
+                      << device_name_ << ", registering memory explicitly";
+        return;
+    }
+    LOG(INFO) << "Host memory is covered by an implicit ODP memory region on "
+              << device_name_;
+}
+
+void RdmaContext::setupDcTransport() {
+#ifdef USE_MLX5_DC
+    if (!mlx5dv_is_supported(context_->device)) {
+        LOG(WARNING) << "Device " << device_name_
+                     << " does not support DC, connecting peers by RC";
+        return;
+    }
+
+    // The target takes no receives, but DC targets require a SRQ
+    ibv_srq_init_attr srq_attr;
+    memset(&srq_attr, 0, sizeof(srq_attr));
+    srq_attr.attr.max_wr = 1;
+    srq_attr.attr.max_sge = 1;
+    dc_srq_ = ibv_create_srq(pd_, &srq_attr);
+    if (!dc_srq_) {
+        PLOG(WARNING) << "Failed to create SRQ on " << device_name_
+                      << ", connecting peers by RC";
+        return;
+    }
+
+    ibv_qp_init_attr_ex attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_type = IBV_QPT_DRIVER;
+    attr.send_cq = cq_list_[0].native;
+    attr.recv_cq = cq_list_[0].native;
+    attr.srq = dc_srq_;
+    attr.comp_mask = IBV_QP_INIT_ATTR_PD;
+    attr.pd = pd_;
+    mlx5dv_qp_init_attr dv_attr;
+    memset(&dv_attr, 0, sizeof(dv_attr));
+    dv_attr.comp_mask = MLX5DV_QP_INIT_ATTR_MASK_DC;
+    dv_attr.dc_init_attr.dc_type = MLX5DV_DCTYPE_DCT;
+    dv_attr.dc_init_attr.dct_access_key = kDcAccessKey;
+    dct_ = mlx5dv_create_qp(context_, &attr, &dv_attr);
+    if (!dct_) {
+        PLOG(WARNING) << "Failed to create DC target on " << device_name_
+                      << ", connecting peers by RC";
+        destroyDcTransport();
+        return;
+    }
+
+    ibv_qp_attr qp_attr;
+    memset(&qp_attr, 0, sizeof(qp_attr));
+    qp_attr.qp_state = IBV_QPS_INIT;
+    qp_attr.pkey_index = 0;
+    qp_attr.port_num = port_;
+    qp_attr.qp_access_flags = IBV_ACCESS_LOCAL_WRITE |
+                              IBV_ACCESS_REMOTE_READ |
+                              IBV_ACCESS_REMOTE_WRITE |
+                              IBV_ACCESS_REMOTE_ATOMIC;
+    int ret = ibv_modify_qp(dct_, &qp_attr,
+                            IBV_QP_STATE | IBV_QP_PKEY_INDEX | IBV_QP_PORT |
+                                IBV_QP_ACCESS_FLAGS);
+    if (!ret) {
+        memset(&qp_attr, 0, sizeof(qp_attr));
+        qp_attr.qp_state = IBV_QPS_RTR;
+        qp_attr.path_mtu = std::min(active_mtu_, globalConfig().mtu_length);
+        qp_attr.min_rnr_timer = 12;
+        qp_attr.ah_attr.is_global = 1;
+        qp_attr.ah_attr.grh.sgid_index = gid_index_;
+        qp_attr.ah_attr.grh.hop_limit = 16;
+        if (globalConfig().ib_traffic_class >= 0)
+            qp_attr.ah_attr.grh.traffic_class =
+                static_cast<uint8_t>(globalConfig().ib_traffic_class);
+        qp_attr.ah_attr.port_num = port_;
+        ret = ibv_modify_qp(dct_, &qp_attr,
+                            IBV_QP_STATE | IBV_QP_MIN_RNR_TIMER | IBV_QP_AV |
+                                IBV_QP_PATH_MTU);
+    }
+    if (ret) {
+        PLOG(WARNING) << "Failed to bring up DC target on " << device_name_
+                      << ", connecting peers by RC";
+        destroyDcTransport();
+        return;
+    }
+
+    for (size_t i = 0; i < globalConfig().num_dci_per_ctx; ++i) {
+        dci_list_.emplace_back(new DcInitiator());
+        if (setupDcInitiator(*dci_list_.back())) {
+            LOG(WARNING) << "Failed to create DC initiators on "
+                         << device_name_ << ", connecting peers by RC";
+            destroyDcTransport();
+            return;
+        }
+    }
+    LOG(INFO) << "Peers of " << device_name_ << " are reached through "
+              << dci_list_.size() << " DC initiators, DC target "
+              << dct_->qp_num;
+#else
+    LOG(WARNING) << "DC requires building with USE_MLX5_DC, connecting peers "
+                    "of "
+                 << device_name_ << " by RC";
+#endif
+}
+
+int RdmaContext::setupDcInitiator(DcInitiator &dci) {
+#ifdef USE_MLX5_DC
+    auto &config = globalConfig();
+    ibv_cq *send_cq = cq();
+    ibv_qp_init_attr_ex attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_type = IBV_QPT_DRIVER;
+    attr.send_cq = send_cq;
+    attr.recv_cq = send_cq;
+    attr.sq_sig_all = false;
+    attr.cap.max_send_wr = config.max_wr;
+    attr.cap.max_send_sge = config.max_sge;
+    attr.cap.max_inline_data = config.max_inline;
+    attr.comp_mask = IBV_QP_INIT_ATTR_PD | IBV_QP_INIT_ATTR_SEND_OPS_FLAGS;
+    attr.pd = pd_;
+    attr.send_ops_flags = IBV_QP_EX_WITH_RDMA_WRITE | IBV_QP_EX_WITH_RDMA_READ;
+    mlx5dv_qp_init_attr dv_attr;
+    memset(&dv_attr, 0, sizeof(dv_attr));
+    dv_attr.comp_mask = MLX5DV_QP_INIT_ATTR_MASK_DC;
+    dv_attr.dc_init_attr.dc_type = MLX5DV_DCTYPE_DCI;
+    dci.qp = mlx5dv_create_qp(context_, &attr, &dv_attr);
+    if (!dci.qp) {
+        PLOG(ERROR) << "Failed to create DC initiator";
+        return ERR_CONTEXT;
+    }
+    dci.qpx = ibv_qp_to_qp_ex(dci.qp);
+    dci.dv_qpx = mlx5dv_qp_ex_from_ibv_qp_ex(dci.qpx);
+    dci.cq_outstanding = (volatile int *)send_cq->cq_context;
+    return resetDcInitiator(dci);
+#else
+    return ERR_CONTEXT;
+#endif
+}
+
+int RdmaContext::resetDcInitiator(DcInitiator &dci) {
+    ibv_qp_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_state = IBV_QPS_RESET;
+    if (ibv_modify_qp(dci.qp, &attr, IBV_QP_STATE)) {
+        PLOG(ERROR) << "Failed to modify DC initiator to RESET";
+        return ERR_CONTEXT;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_state = IBV_QPS_INIT;
+    attr.pkey_index = 0;
+    attr.port_num = port_;
+    if (ibv_modify_qp(dci.qp, &attr,
+                      IBV_QP_STATE | IBV_QP_PKEY_INDEX | IBV_QP_PORT)) {
+        PLOG(ERROR) << "Failed to modify DC initiator to INIT";
+        return ERR_CONTEXT;
+    }
+
+    // The peer address is given per work request
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_state = IBV_QPS_RTR;
+    attr.path_mtu = std::min(active_mtu_, globalConfig().mtu_length);
+    attr.ah_attr.is_global = 1;
+    attr.ah_attr.grh.sgid_index = gid_index_;
+    attr.ah_attr.port_num = port_;
+    if (ibv_modify_qp(dci.qp, &attr,
+                      IBV_QP_STATE | IBV_QP_PATH_MTU | IBV_QP_AV)) {
+        PLOG(ERROR) << "Failed to modify DC initiator to RTR";
+        return ERR_CONTEXT;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.qp_state = IBV_QPS_RTS;
+    attr.timeout = 14;
+    attr.retry_cnt = 7;
+    attr.rnr_retry = 7;
+    attr.sq_psn = 0;
+    attr.max_rd_atomic = 16;
+    if (ibv_modify_qp(dci.qp, &attr,
+                      IBV_QP_STATE | IBV_QP_TIMEOUT | IBV_QP_RETRY_CNT |
+                          IBV_QP_RNR_RETRY | IBV_QP_SQ_PSN |
+                          IBV_QP_MAX_QP_RD_ATOMIC)) {
+        PLOG(ERROR) << "Failed to modify DC initiator to RTS";
+        return ERR_CONTEXT;
+    }
+    return 0;
+}
+
+void RdmaContext::destroyDcTransport() {
+    for (auto &dci : dci_list_) {
+        if (dci->qp && ibv_destroy_qp(dci->qp))
+            PLOG(ERROR) << "Failed to destroy DC initiator";
+    }
+    dci_list_.clear();
+    if (dct_) {
+        if (ibv_destroy_qp(dct_)) PLOG(ERROR) << "Failed to destroy DC target";
+        dct_ = nullptr;
+    }
+    if (dc_srq_) {
+        if (ibv_destroy_srq(dc_srq_)) PLOG(ERROR) << "Failed to destroy SRQ";
+        dc_srq_ = nullptr;
+    }
+}
+
+void RdmaContext::setupNotify() {
+    ibv_srq_init_attr srq_attr;
+    memset(&srq_attr, 0, sizeof(srq_attr));
+    srq_attr.attr.max_wr = kNotifyBufferCount;
+    srq_attr.attr.max_sge = 1;
+    notify_srq_ = ibv_create_srq(pd_, &srq_attr);
+    if (!notify_srq_) {
+        PLOG(WARNING) << "Failed to create SRQ on " << device_name_
+                      << ", sending notifications by RPC";
+        return;
+    }
+
+    const size_t kRegionSize = 2 * kNotifyBufferCount * kNotifyBufferSize;
+    notify_region_ = (char *)aligned_alloc(4096, kRegionSize);
+    if (notify_region_)
+        notify_mr_ = ibv_reg_mr(pd_, notify_region_, kRegionSize,
+                                IBV_ACCESS_LOCAL_WRITE);
+    if (!notify_mr_) {
+        PLOG(WARNING) << "Failed to register notification buffers on "
+                      << device_name_ << ", sending notifications by RPC";
+        destroyNotify();
+        return;
+    }
+    notify_send_.resize(kNotifyBufferCount);
+    for (int index = kNotifyBufferCount - 1; index >= 0; --index)
+        free_notify_buffers_.push_back(index);
+    for (int index = kNotifyBufferCount; index < 2 * kNotifyBufferCount;
+         ++index) {
+        if (postNotifyRecv(index)) {
+            destroyNotify();
+            return;
+        }
+    }
+}
+
+void RdmaContext::destroyNotify() {
+    if (notify_srq_) {
+        if (ibv_destroy_srq(notify_srq_))
+            PLOG(ERROR) << "Failed to destroy SRQ";
+        notify_srq_ = nullptr;
+    }
+    if (notify_mr_) {
+        if (ibv_dereg_mr(notify_mr_))
+            PLOG(ERROR) << "Failed to unregister notification buffers";
+        notify_mr_ = nullptr;
+    }
+    free(notify_region_);
+    notify_region_ = nullptr;
+    free_notify_buffers_.clear();
+    notify_send_.clear();
+}
+
+int RdmaContext::postNotifyRecv(int index) {
+    ibv_sge sge;
+    sge.addr = (uint64_t)(notify_region_ + index * kNotifyBufferSize);
+    sge.length = kNotifyBufferSize;
+    sge.lkey = notify_mr_->lkey;
+    ibv_recv_wr wr, *bad_wr = nullptr;
+    memset(&wr, 0, sizeof(wr));
+    wr.wr_id = ((uint64_t)index << 2) | kNotifyRecvTag;
+    wr.sg_list = &sge;
+    wr.num_sge = 1;
+    int ret = ibv_post_srq_recv(notify_srq_, &wr, &bad_wr);
+    if (ret) {
+        LOG(ERROR) << "Failed to post notification buffer to SRQ on "
+                   << device_name_ << ": " << strerror(ret);
+        return ERR_CONTEXT;
+    }
+    return 0;
+}
+
+// A notification is the length of its name, the name, then the message
+static bool decodeNotify(const char *buffer, uint32_t length,
+                         TransferMetadata::NotifyDesc &notify) {
+    uint32_t name_length;
+    if (length < sizeof(name_length)) return false;
+    memcpy(&name_length, buffer, sizeof(name_length));
+    if (name_length > length - sizeof(name_length)) return false;
+    buffer += sizeof(name_length);
+    notify.name.assign(buffer, name_length);
+    notify.notify_msg.assign(buffer + name_length,
+                             length - sizeof(name_length) - name_length);
+    return true;
+}
+
+int RdmaContext::postNotify(RdmaEndPoint &endpoint,
+                            const std::string &peer_server_name,
+                            const TransferMetadata::NotifyDesc &notify) {
+    const uint32_t name_length = notify.name.size();
+    const size_t length =
+        sizeof(name_length) + name_length + notify.notify_msg.size();
+    if (!notify_srq_ || length > kNotifyBufferSize) return ERR_INVALID_ARGUMENT;
+    int index;
+    {
+        std::lock_guard<std::mutex> lock(notify_mutex_);
+        if (free_notify_buffers_.empty()) return ERR_TOO_MANY_REQUESTS;
+        index = free_notify_buffers_.back();
+        free_notify_buffers_.pop_back();
+    }
+
+    char *buffer = notify_region_ + index * kNotifyBufferSize;
+    memcpy(buffer, &name_length, sizeof(name_length));
+    memcpy(buffer + sizeof(name_length), notify.name.data(), name_length);
+    memcpy(buffer + sizeof(name_length) + name_length,
+           notify.notify_msg.data(), notify.notify_msg.size());
+    auto &send = notify_send_[index];
+    send.length = length;
+    send.peer_server_name = peer_server_name;
+    int ret =
+        endpoint.postSend(((uint64_t)index << 2) | kNotifySendTag, buffer,
+                          length, notify_mr_->lkey, send.qp_depth);
+    if (ret) {
+        std::lock_guard<std::mutex> lock(notify_mutex_);
+        free_notify_buffers_.push_back(index);
+    }
+    return ret;
+}
+
+int RdmaContext::completeNotify(const ibv_wc &wc) {
+    const int index = wc.wr_id >> 2;
+    const char *buffer = notify_region_ + index * kNotifyBufferSize;
+    if ((wc.wr_id & kNotifyTagMask) == kNotifyRecvTag) {
+        if (wc.status == IBV_WC_SUCCESS) {
+            TransferMetadata::NotifyDesc notify;
+            if (decodeNotify(buffer, wc.byte_len, notify))
+                engine_.meta()->addNotify(std::move(notify));
+            else
+                LOG(ERROR) << "Malformed notification received on "
+                           << device_name_;
+        }
+        // The SRQ outlives the errors of the QPs taking from it
+        postNotifyRecv(index);
+        return 0;
+    }
+
+    auto &send = notify_send_[index];
+    __sync_fetch_and_sub(send.qp_depth, 1);
+    if (wc.status != IBV_WC_SUCCESS) {
+        LOG(WARNING) << "Failed to send notification to "
+                     << send.peer_server_name << " through " << device_name_
+                     << ": " << ibv_wc_status_str(wc.status)
+                     << ", sending it by RPC";
+        TransferMetadata::NotifyDesc notify, reply;
+        if (decodeNotify(buffer, send.length, notify))
+            engine_.meta()->sendNotify(send.peer_server_name, notify, reply);
+    }
+    std::lock_guard<std::mutex> lock(notify_mutex_);
+    free_notify_buffers_.push_back(index);
+    return 1;
+}
+
+DcInitiator *RdmaContext::selectDcInitiator() {
+    if (dci_list_.empty()) return nullptr;
+    size_t start = SimpleRandom::Get().next(dci_list_.size());
+    for (size_t i = 0; i < dci_list_.size(); ++i) {
+        auto &dci = dci_list_[(start + i) % dci_list_.size()];
+        if (!dci->failed.load(std::memory_order_relaxed)) return dci.get();
+    }
+    return nullptr;
+}
+
+void RdmaContext::failDcInitiator(volatile int *qp_depth) {
+    for (auto &dci : dci_list_) {
+        if (&dci->wr_depth != qp_depth) continue;
+        if (!dci->failed.exchange(true))
+            LOG(WARNING) << "DC initiator " << dci->qp->qp_num << " of "
+                         << device_name_ << " failed";
+        return;
+    }
+}
+
+bool RdmaContext::failDcQp(ibv_qp *qp) {
+    if (qp == dct_) {
+        LOG(ERROR) << "DC target of " << device_name_ << " failed";
+        return true;
+    }
+    for (auto &dci : dci_list_) {
+        if (dci->qp != qp) continue;
+        failDcInitiator(&dci->wr_depth);
+        return true;
+    }
+    return false;
+}
+
+void RdmaContext::recoverDcInitiators() {
+    for (auto &dci : dci_list_) {
+        // Reset only once the work requests posted before are flushed
+        if (!dci->failed.load(std::memory_order_relaxed) || dci->wr_depth)
+            continue;
+        RWSpinlock::WriteGuard guard(dci->lock);
+        if (dci->wr_depth || resetDcInitiator(*dci)) continue;
+        dci->failed.store(false);
+        LOG(INFO) << "DC initiator " << dci->qp->qp_num << " of "
+                  << device_name_ << " recovered";
+    }
+}
+
+bool RdmaContext::isHostMemory(void *addr) {
+#if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
+    cudaPointerAttributes attributes;
+    if (cudaPointerGetAttributes(&attributes, addr) != cudaSuccess) {
+        cudaGetLastError();  // clear the error of unregistered memory
+        return true;
+    }
+    return attributes.type != cudaMemoryTypeDevice;
+#else
+    (void)addr;
+    return true;
+#endif
+}
+
 int RdmaContext::registerMemoryRegionInternal(void *addr, size_t length,
                                               int access,
                                               MemoryRegionMeta &mrMeta) {
@@ -269,6 +736,10 @@ int RdmaContext::registerMemoryRegionInternal(void *addr, size_t length,
 }
 
 int RdmaContext::registerMemoryRegion(void *addr, size_t length, int access) {
+    // The NIC faults host pages in on access, nothing to pin up front
+    if (implicit_mr_ && isHostMemory(addr)) {
+        return 0;
+    }
     MemoryRegionMeta mrMeta;
     int ret = registerMemoryRegionInternal(addr, length, access, mrMeta);
     if (ret != 0) {
@@ -318,6 +789,9 @@ uint32_t RdmaContext::rkey(void *addr) {
         if (iter->addr <= addr &&
             addr < (char *)(iter->addr) + iter->mr->length)
             return iter->mr->rkey;
+    if (implicit_mr_) {
+        return implicit_mr_->rkey;
+    }
 
     LOG(ERROR) << "Address " << addr << " rkey not found for " << deviceName();
     return 0;
@@ -330,6 +804,9 @@ uint32_t RdmaContext::lkey(void *addr) {
         if (iter->addr <= addr &&
             addr < (char *)(iter->addr) + iter->mr->length)
             return iter->mr->lkey;
+    if (implicit_mr_) {
+        return implicit_mr_->lkey;
+    }
 
     LOG(ERROR) << "Address " << addr << " lkey not found for " << deviceName();
     return 0;
@@ -357,6 +834,11 @@ std::shared_ptr<RdmaEndPoint> RdmaContext::endpoint(
     return endpoint;
 }
 
+std::shared_ptr<RdmaEndPoint> RdmaContext::findEndpoint(
+    const std::string &peer_nic_path) {
+    return endpoint_store_->getEndpoint(peer_nic_path);
+}
+
 int RdmaContext::disconnectAllEndpoints() {
     return endpoint_store_->disconnectQPs();
 }
@@ -366,7 +848,14 @@ int RdmaContext::deleteEndpoint(const std::string &peer_nic_path) {
 }
 
 size_t RdmaContext::getTotalQPNumber() const {
-    return endpoint_store_->getTotalQPNumber();
+    return endpoint_store_->getTotalQPNumber() + dci_list_.size() +
+           (dct_ ? 1 : 0);
+}
+
+size_t RdmaContext::getTotalWrDepth() const {
+    size_t total_wr_depth = endpoint_store_->getTotalWrDepth();
+    for (auto &dci : dci_list_) total_wr_depth += dci->wr_depth;
+    return total_wr_depth;
 }
 
 std::string RdmaContext::nicPath() const {
@@ -660,6 +1149,32 @@ int RdmaContext::joinNonblockingPollList(int event_fd, int data_fd) {
     return 0;
 }
 
+void RdmaContext::recordCompletion(uint64_t bytes) {
+    // A sample covers at least this long, and a longer gap between
+    // completions ends it, as the NIC has gone idle
+    const int64_t kSampleTime = 10000000;
+    const int64_t kIdleGap = 1000000;
+    const int64_t now = getCurrentTimeInNano();
+    std::lock_guard<std::mutex> lock(throughput_mutex_);
+    if (now - last_completion_ts_ > kIdleGap) {
+        // Bytes completed at the start of a sample took unknown time
+        last_completion_ts_ = now;
+        throughput_window_start_ = now;
+        throughput_window_bytes_ = 0;
+        return;
+    }
+    last_completion_ts_ = now;
+    throughput_window_bytes_ += bytes;
+    const int64_t elapsed = now - throughput_window_start_;
+    if (elapsed < kSampleTime) return;
+    const uint64_t sample = throughput_window_bytes_ * 1000000000ull / elapsed;
+    const uint64_t current = throughput_.load(std::memory_order_relaxed);
+    throughput_.store(current ? (current * 7 + sample) / 8 : sample,
+                      std::memory_order_relaxed);
+    throughput_window_start_ = now;
+    throughput_window_bytes_ = 0;
+}
+
 int RdmaContext::poll(int num_entries, ibv_wc *wc, int cq_index) {
     int nr_poll = ibv_poll_cq(cq_list_[cq_index].native, num_entries, wc);
     if (nr_poll < 0) {
@@ -670,8 +1185,32 @@ int RdmaContext::poll(int num_entries, ibv_wc *wc, int cq_index) {
     return nr_poll;
 }
 
+uint64_t RdmaContext::outstandingBytes() const {
+    return worker_pool_ ? worker_pool_->outstandingBytes() : 0;
+}
+
+int RdmaContext::cqIndex(ibv_cq *cq) const {
+    for (size_t i = 0; i < cq_list_.size(); ++i)
+        if (cq_list_[i].native == cq) return i;
+    return -1;
+}
+
+int RdmaContext::armCq(int cq_index) {
+    int ret = ibv_req_notify_cq(cq_list_[cq_index].native, 0);
+    if (ret) {
+        LOG(ERROR) << "Failed to request notification on CQ " << cq_index
+                   << " of device " << device_name_ << ": " << strerror(ret);
+        return ERR_CONTEXT;
+    }
+    return 0;
+}
+
 int RdmaContext::submitPostSend(
     const std::vector<Transport::Slice *> &slice_list) {
     return worker_pool_->submitPostSend(slice_list);
 }
+
+void RdmaContext::postSendDirect(Transport::Slice *slice) {
+    worker_pool_->postSendDirect(slice);
+}
 }  // namespace mooncake
@@ -15,6 +15,9 @@
 #include "transport/rdma_transport/rdma_endpoint.h"
 
 #include <glog/logging.h>
+#ifdef USE_MLX5_DC
+#include <infiniband/mlx5dv.h>
+#endif
 
 #include <cassert>
 #include <cstddef>
@@ -26,14 +29,79 @@ const static uint8_t MAX_HOP_LIMIT = 16;
 const static uint8_t TIMEOUT = 14;
 const static uint8_t RETRY_CNT = 7;
 
+static ibv_gid parseGid(const std::string &gid) {
+    ibv_gid gid_raw;
+    std::istringstream iss(gid);
+    for (int i = 0; i < 16; ++i) {
+        int value;
+        iss >> std::hex >> value;
+        gid_raw.raw[i] = static_cast<uint8_t>(value);
+        if (i < 15) iss.ignore(1, ':');
+    }
+    return gid_raw;
+}
+
+static ibv_wr_opcode toWrOpcode(Transport::TransferRequest::OpCode opcode) {
+    switch (opcode) {
+        case Transport::TransferRequest::READ:
+            return IBV_WR_RDMA_READ;
+        case Transport::TransferRequest::FETCH_ADD:
+            return IBV_WR_ATOMIC_FETCH_AND_ADD;
+        case Transport::TransferRequest::COMPARE_SWAP:
+            return IBV_WR_ATOMIC_CMP_AND_SWP;
+        default:
+            return IBV_WR_RDMA_WRITE;
+    }
+}
+
+// Links the unsignaled slices of a post to the signaled slice after them,
+// whose completion settles them all
+struct UnsignaledChain {
+    Transport::Slice *head = nullptr, *tail = nullptr;
+    uint32_t count = 0;
+
+    void add(Transport::Slice *slice, volatile int *qp_depth, bool signaled) {
+        slice->ts = getCurrentTimeInNano();
+        slice->status = Transport::Slice::POSTED;
+        slice->rdma.qp_depth = qp_depth;
+        slice->rdma.signaled = signaled;
+        slice->rdma.wc_status = IBV_WC_SUCCESS;
+        if (signaled) {
+            slice->rdma.unsignaled = head;
+            slice->rdma.unsignaled_count = count;
+            head = tail = nullptr;
+            count = 0;
+        } else {
+            slice->rdma.unsignaled = nullptr;
+            slice->rdma.unsignaled_count = 0;
+            if (tail)
+                tail->rdma.unsignaled = slice;
+            else
+                head = slice;
+            tail = slice;
+            count++;
+        }
+    }
+};
+
 RdmaEndPoint::RdmaEndPoint(RdmaContext &context)
     : context_(context),
       status_(INITIALIZING),
+      cq_(nullptr),
+      num_qp_list_(0),
+      max_sge_per_wr_(0),
+      max_inline_bytes_(0),
+      wr_depth_list_(nullptr),
+      max_wr_depth_(0),
+      dc_ah_(nullptr),
+      dc_peer_dctn_(0),
       active_(true),
+      peer_notify_recv_(false),
       cq_outstanding_(nullptr) {}
 
 RdmaEndPoint::~RdmaEndPoint() {
     if (!qp_list_.empty()) deconstruct();
+    if (dc_ah_) ibv_destroy_ah(dc_ah_);
 }
 
 int RdmaEndPoint::construct(ibv_cq *cq, size_t num_qp_list,
@@ -44,35 +112,50 @@ int RdmaEndPoint::construct(ibv_cq *cq, size_t num_qp_list,
         return ERR_ENDPOINT;
     }
 
-    qp_list_.resize(num_qp_list);
+    cq_ = cq;
+    num_qp_list_ = num_qp_list;
+    max_sge_per_wr_ = max_sge_per_wr;
+    max_wr_depth_ = (int)max_wr_depth;
+    max_inline_bytes_ = max_inline_bytes;
     cq_outstanding_ = (volatile int *)cq->cq_context;
 
-    max_wr_depth_ = (int)max_wr_depth;
-    wr_depth_list_ = new volatile int[num_qp_list];
+    // Peers are reached through the DC initiators of the context, QPs are
+    // created only if the peer turns out to serve no DC target
+    if (!context_.dcEnabled()) {
+        int ret = createQPs();
+        if (ret) return ret;
+    }
+
+    status_.store(UNCONNECTED, std::memory_order_relaxed);
+    return 0;
+}
+
+int RdmaEndPoint::createQPs() {
+    qp_list_.resize(num_qp_list_);
+    wr_depth_list_ = new volatile int[num_qp_list_];
     if (!wr_depth_list_) {
         LOG(ERROR) << "Failed to allocate memory for work request depth list";
         return ERR_MEMORY;
     }
-    for (size_t i = 0; i < num_qp_list; ++i) {
+    for (size_t i = 0; i < num_qp_list_; ++i) {
         wr_depth_list_[i] = 0;
         ibv_qp_init_attr attr;
         memset(&attr, 0, sizeof(attr));
-        attr.send_cq = cq;
-        attr.recv_cq = cq;
+        attr.send_cq = cq_;
+        attr.recv_cq = cq_;
         attr.sq_sig_all = false;
         attr.qp_type = IBV_QPT_RC;
         attr.qp_context = this;
-        attr.cap.max_send_wr = attr.cap.max_recv_wr = max_wr_depth;
-        attr.cap.max_send_sge = attr.cap.max_recv_sge = max_sge_per_wr;
-        attr.cap.max_inline_data = max_inline_bytes;
+        attr.cap.max_send_wr = attr.cap.max_recv_wr = max_wr_depth_;
+        attr.cap.max_send_sge = attr.cap.max_recv_sge = max_sge_per_wr_;
+        attr.cap.max_inline_data = max_inline_bytes_;
+        attr.srq = context_.notifySrq();
         qp_list_[i] = ibv_create_qp(context_.pd(), &attr);
         if (!qp_list_[i]) {
             PLOG(ERROR) << "Failed to create QP";
             return ERR_ENDPOINT;
         }
     }
-
-    status_.store(UNCONNECTED, std::memory_order_relaxed);
     return 0;
 }
 
@@ -96,6 +179,7 @@ int RdmaEndPoint::deconstruct() {
     }
     qp_list_.clear();
     delete[] wr_depth_list_;
+    wr_depth_list_ = nullptr;
     return 0;
 }
 
@@ -117,11 +201,19 @@ int RdmaEndPoint::setupConnectionsByActive() {
         return 0;
     }
 
+    if (context_.dcEnabled() && qp_list_.empty()) {
+        int ret = setupDcConnection();
+        if (ret <= 0) return ret;
+        ret = createQPs();
+        if (ret) return ret;
+    }
+
     // loopback mode
     if (context_.nicPath() == peer_nic_path_) {
         auto segment_desc =
             context_.engine().meta()->getSegmentDescByID(LOCAL_SEGMENT_ID);
         if (segment_desc) {
+            peer_notify_recv_ = context_.notifyEnabled();
             for (auto &nic : segment_desc->devices)
                 if (nic.name == context_.deviceName())
                     return doSetupConnection(nic.gid, nic.lid, qpNum());
@@ -132,9 +224,7 @@ int RdmaEndPoint::setupConnectionsByActive() {
     }
 
     HandShakeDesc local_desc, peer_desc;
-    local_desc.local_nic_path = context_.nicPath();
-    local_desc.peer_nic_path = peer_nic_path_;
-    local_desc.qp_num = qpNum();
+    prepareHandshake(local_desc);
 
     auto peer_server_name = getServerNameFromNicPath(peer_nic_path_);
     auto peer_nic_name = getNicNameFromNicPath(peer_nic_path_);
@@ -146,6 +236,33 @@ int RdmaEndPoint::setupConnectionsByActive() {
     int rc = context_.engine().sendHandshake(peer_server_name, local_desc,
                                              peer_desc);
     if (rc) return rc;
+    return completeActiveSetup(local_desc, peer_desc);
+}
+
+void RdmaEndPoint::prepareHandshake(HandShakeDesc &local_desc) const {
+    local_desc.local_nic_path = context_.nicPath();
+    local_desc.peer_nic_path = peer_nic_path_;
+    local_desc.qp_num = qpNum();
+    local_desc.notify_recv = context_.notifyEnabled();
+}
+
+int RdmaEndPoint::setupConnectionsByActive(const HandShakeDesc &local_desc,
+                                           const HandShakeDesc &peer_desc) {
+    RWSpinlock::WriteGuard guard(lock_);
+    // Connected in the meantime by a transfer
+    if (connected()) return 0;
+    return completeActiveSetup(local_desc, peer_desc);
+}
+
+int RdmaEndPoint::completeActiveSetup(const HandShakeDesc &local_desc,
+                                      const HandShakeDesc &peer_desc) {
+    auto peer_server_name = getServerNameFromNicPath(peer_nic_path_);
+    auto peer_nic_name = getNicNameFromNicPath(peer_nic_path_);
+    if (peer_server_name.empty() || peer_nic_name.empty()) {
+        LOG(ERROR) << "Parse peer nic path failed: " << peer_nic_path_;
+        return ERR_INVALID_ARGUMENT;
+    }
+
     if (!peer_desc.reply_msg.empty()) {
         LOG(ERROR) << "Reject the handshake request by peer "
                    << local_desc.peer_nic_path;
@@ -163,6 +280,7 @@ int RdmaEndPoint::setupConnectionsByActive() {
         return ERR_REJECT_HANDSHAKE;
     }
 
+    peer_notify_recv_ = peer_desc.notify_recv;
     auto segment_desc =
         context_.engine().meta()->getSegmentDescByName(peer_server_name);
     if (segment_desc) {
@@ -202,9 +320,20 @@ int RdmaEndPoint::setupConnectionsByPassive(const HandShakeDesc &peer_desc,
         return ERR_INVALID_ARGUMENT;
     }
 
+    // A peer without DC connects by RC
+    if (qp_list_.empty()) {
+        int ret = createQPs();
+        if (ret) {
+            local_desc.reply_msg = "Failed to create QPs";
+            return ret;
+        }
+    }
+
     local_desc.local_nic_path = context_.nicPath();
     local_desc.peer_nic_path = peer_nic_path_;
     local_desc.qp_num = qpNum();
+    local_desc.notify_recv = context_.notifyEnabled();
+    peer_notify_recv_ = peer_desc.notify_recv;
 
     auto segment_desc =
         context_.engine().meta()->getSegmentDescByName(peer_server_name);
@@ -244,9 +373,56 @@ void RdmaEndPoint::disconnectUnlocked() {
             wr_depth_list_[i] = 0;
         }
     }
+    if (dc_ah_) {
+        if (ibv_destroy_ah(dc_ah_))
+            PLOG(ERROR) << "Failed to destroy address handle";
+        dc_ah_ = nullptr;
+    }
     status_.store(UNCONNECTED, std::memory_order_release);
 }
 
+int RdmaEndPoint::setupDcConnection() {
+    auto peer_server_name = getServerNameFromNicPath(peer_nic_path_);
+    auto peer_nic_name = getNicNameFromNicPath(peer_nic_path_);
+    if (peer_server_name.empty() || peer_nic_name.empty()) {
+        LOG(ERROR) << "Parse peer nic path failed: " << peer_nic_path_;
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    auto meta = context_.engine().meta();
+    auto segment_desc = context_.nicPath() == peer_nic_path_
+                            ? meta->getSegmentDescByID(LOCAL_SEGMENT_ID)
+                            : meta->getSegmentDescByName(peer_server_name);
+    if (segment_desc) {
+        for (auto &nic : segment_desc->devices) {
+            if (nic.name != peer_nic_name) continue;
+            if (!nic.dct_num) return 1;
+            ibv_ah_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.is_global = 1;
+            attr.grh.dgid = parseGid(nic.gid);
+            attr.grh.sgid_index = context_.gidIndex();
+            attr.grh.hop_limit = MAX_HOP_LIMIT;
+            if (globalConfig().ib_traffic_class >= 0)
+                attr.grh.traffic_class =
+                    static_cast<uint8_t>(globalConfig().ib_traffic_class);
+            attr.dlid = nic.lid;
+            attr.port_num = context_.portNum();
+            dc_ah_ = ibv_create_ah(context_.pd(), &attr);
+            if (!dc_ah_) {
+                PLOG(ERROR) << "Failed to create address handle for "
+                            << peer_nic_path_;
+                return ERR_ENDPOINT;
+            }
+            dc_peer_dctn_ = nic.dct_num;
+            status_.store(CONNECTED, std::memory_order_relaxed);
+            return 0;
+        }
+    }
+    LOG(ERROR) << "Peer nic not found in that server: " << peer_nic_path_;
+    return ERR_DEVICE_NOT_FOUND;
+}
+
 const std::string RdmaEndPoint::toString() const {
     auto status = status_.load(std::memory_order_relaxed);
     if (status == CONNECTED)
@@ -265,19 +441,27 @@ bool RdmaEndPoint::hasOutstandingSlice() const {
 
 int RdmaEndPoint::submitPostSend(
     std::vector<Transport::Slice *> &slice_list,
-    std::vector<Transport::Slice *> &failed_slice_list) {
+    std::vector<Transport::Slice *> &failed_slice_list, size_t max_wr_count) {
     RWSpinlock::WriteGuard guard(lock_);
     if (!active_) return 0;
+    if (dc_ah_)
+        return submitPostSendDc(slice_list, failed_slice_list, max_wr_count);
     int qp_index = SimpleRandom::Get().next(qp_list_.size());
     int wr_count = std::min(max_wr_depth_ - wr_depth_list_[qp_index],
-                            (int)slice_list.size());
+                            (int)std::min(slice_list.size(), max_wr_count));
     wr_count =
         std::min(int(globalConfig().max_cqe) - *cq_outstanding_, wr_count);
     if (wr_count <= 0) return 0;
 
+    // The list is posted with one doorbell. Only every signal_interval-th
+    // WR and the last one are signaled, each completing the unsignaled WRs
+    // before it, and writes small enough are sent inline.
+    const int kSignalInterval = globalConfig().signal_interval;
+    const size_t kMaxInline = globalConfig().max_inline;
     ibv_send_wr wr_list[wr_count], *bad_wr = nullptr;
     ibv_sge sge_list[wr_count];
     memset(wr_list, 0, sizeof(ibv_send_wr) * wr_count);
+    UnsignaledChain chain;
     for (int i = 0; i < wr_count; ++i) {
         auto slice = slice_list[i];
         auto &sge = sge_list[i];
@@ -287,25 +471,50 @@ int RdmaEndPoint::submitPostSend(
 
         auto &wr = wr_list[i];
         wr.wr_id = (uint64_t)slice;
-        wr.opcode = slice->opcode == Transport::TransferRequest::READ
-                        ? IBV_WR_RDMA_READ
-                        : IBV_WR_RDMA_WRITE;
+        wr.opcode = toWrOpcode(slice->opcode);
         wr.num_sge = 1;
         wr.sg_list = &sge;
-        wr.send_flags = IBV_SEND_SIGNALED;
+        bool signaled = (i + 1) % kSignalInterval == 0 || i + 1 == wr_count;
+        wr.send_flags = signaled ? IBV_SEND_SIGNALED : 0;
+        if (wr.opcode == IBV_WR_RDMA_WRITE && slice->length <= kMaxInline)
+            wr.send_flags |= IBV_SEND_INLINE;
         wr.next = (i + 1 == wr_count) ? nullptr : &wr_list[i + 1];
         wr.imm_data = 0;
-        wr.wr.rdma.remote_addr = slice->rdma.dest_addr;
-        wr.wr.rdma.rkey = slice->rdma.dest_rkey;
-        slice->ts = getCurrentTimeInNano();
-        slice->status = Transport::Slice::POSTED;
-        slice->rdma.qp_depth = &wr_depth_list_[qp_index];
+        if (wr.opcode == IBV_WR_ATOMIC_FETCH_AND_ADD ||
+            wr.opcode == IBV_WR_ATOMIC_CMP_AND_SWP) {
+            wr.wr.atomic.remote_addr = slice->rdma.dest_addr;
+            wr.wr.atomic.compare_add = slice->rdma.compare_add;
+            wr.wr.atomic.swap = slice->rdma.swap;
+            wr.wr.atomic.rkey = slice->rdma.dest_rkey;
+        } else {
+            wr.wr.rdma.remote_addr = slice->rdma.dest_addr;
+            wr.wr.rdma.rkey = slice->rdma.dest_rkey;
+        }
+        chain.add(slice, &wr_depth_list_[qp_index], signaled);
     }
     __sync_fetch_and_add(&wr_depth_list_[qp_index], wr_count);
     __sync_fetch_and_add(cq_outstanding_, wr_count);
     int rc = ibv_post_send(qp_list_[qp_index], wr_list, &bad_wr);
     if (rc) {
         PLOG(ERROR) << "Failed to ibv_post_send";
+        int posted = bad_wr ? bad_wr - wr_list : 0;
+        // Unsignaled WRs posted after the last signaled one would never be
+        // completed: they complete on their own once the QP is flushed
+        int orphan = posted;
+        while (orphan > 0 && !(wr_list[orphan - 1].send_flags &
+                               IBV_SEND_SIGNALED)) {
+            --orphan;
+        }
+        if (orphan < posted) {
+            for (int i = orphan; i < posted; ++i) {
+                slice_list[i]->rdma.signaled = true;
+                slice_list[i]->rdma.unsignaled_count = 0;
+            }
+            ibv_qp_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.qp_state = IBV_QPS_ERR;
+            ibv_modify_qp(qp_list_[qp_index], &attr, IBV_QP_STATE);
+        }
         while (bad_wr) {
             int i = bad_wr - wr_list;
             failed_slice_list.push_back(slice_list[i]);
@@ -318,8 +527,122 @@ int RdmaEndPoint::submitPostSend(
     return 0;
 }
 
+int RdmaEndPoint::postSend(uint64_t wr_id, void *addr, uint32_t length,
+                           uint32_t lkey, volatile int *&qp_depth) {
+    RWSpinlock::WriteGuard guard(lock_);
+    if (!active_ || !connected() || dc_ah_ || !peer_notify_recv_ ||
+        qp_list_.empty())
+        return ERR_ENDPOINT;
+    int qp_index = SimpleRandom::Get().next(qp_list_.size());
+    if (wr_depth_list_[qp_index] >= max_wr_depth_ ||
+        *cq_outstanding_ >= int(globalConfig().max_cqe))
+        return ERR_ENDPOINT;
+
+    ibv_sge sge;
+    sge.addr = (uint64_t)addr;
+    sge.length = length;
+    sge.lkey = lkey;
+    ibv_send_wr wr, *bad_wr = nullptr;
+    memset(&wr, 0, sizeof(wr));
+    wr.wr_id = wr_id;
+    wr.opcode = IBV_WR_SEND;
+    wr.num_sge = 1;
+    wr.sg_list = &sge;
+    wr.send_flags = IBV_SEND_SIGNALED;
+    if (length <= max_inline_bytes_) wr.send_flags |= IBV_SEND_INLINE;
+    qp_depth = &wr_depth_list_[qp_index];
+    __sync_fetch_and_add(qp_depth, 1);
+    __sync_fetch_and_add(cq_outstanding_, 1);
+    if (ibv_post_send(qp_list_[qp_index], &wr, &bad_wr)) {
+        PLOG(ERROR) << "Failed to ibv_post_send";
+        __sync_fetch_and_sub(qp_depth, 1);
+        __sync_fetch_and_sub(cq_outstanding_, 1);
+        return ERR_ENDPOINT;
+    }
+    return 0;
+}
+
+int RdmaEndPoint::submitPostSendDc(
+    std::vector<Transport::Slice *> &slice_list,
+    std::vector<Transport::Slice *> &failed_slice_list, size_t max_wr_count) {
+#ifdef USE_MLX5_DC
+    DcInitiator *dci = context_.selectDcInitiator();
+    if (!dci) return 0;
+    RWSpinlock::WriteGuard guard(dci->lock);
+    if (dci->failed.load(std::memory_order_relaxed)) return 0;
+    int wr_count = std::min(max_wr_depth_ - dci->wr_depth,
+                            (int)std::min(slice_list.size(), max_wr_count));
+    wr_count = std::min(int(globalConfig().max_cqe) - *dci->cq_outstanding,
+                        wr_count);
+    if (wr_count <= 0) return 0;
+
+    // Same signaling and inlining as the RC path, the peer address is
+    // given per work request
+    const int kSignalInterval = globalConfig().signal_interval;
+    const size_t kMaxInline = globalConfig().max_inline;
+    ibv_qp_ex *qpx = dci->qpx;
+    UnsignaledChain chain;
+    ibv_wr_start(qpx);
+    for (int i = 0; i < wr_count; ++i) {
+        auto slice = slice_list[i];
+        bool signaled = (i + 1) % kSignalInterval == 0 || i + 1 == wr_count;
+        qpx->wr_id = (uint64_t)slice;
+        qpx->wr_flags = signaled ? IBV_SEND_SIGNALED : 0;
+        bool is_write = false;
+        switch (slice->opcode) {
+            case Transport::TransferRequest::READ:
+                ibv_wr_rdma_read(qpx, slice->rdma.dest_rkey,
+                                 slice->rdma.dest_addr);
+                break;
+            case Transport::TransferRequest::FETCH_ADD:
+                ibv_wr_atomic_fetch_add(qpx, slice->rdma.dest_rkey,
+                                        slice->rdma.dest_addr,
+                                        slice->rdma.compare_add);
+                break;
+            case Transport::TransferRequest::COMPARE_SWAP:
+                ibv_wr_atomic_cmp_swp(qpx, slice->rdma.dest_rkey,
+                                      slice->rdma.dest_addr,
+                                      slice->rdma.compare_add,
+                                      slice->rdma.swap);
+                break;
+            default:
+                ibv_wr_rdma_write(qpx, slice->rdma.dest_rkey,
+                                  slice->rdma.dest_addr);
+                is_write = true;
+        }
+        mlx5dv_wr_set_dc_addr(dci->dv_qpx, dc_ah_, dc_peer_dctn_,
+                              kDcAccessKey);
+        if (is_write && slice->length <= kMaxInline)
+            ibv_wr_set_inline_data(qpx, slice->source_addr, slice->length);
+        else
+            ibv_wr_set_sge(qpx, slice->rdma.source_lkey,
+                           (uint64_t)slice->source_addr, slice->length);
+        chain.add(slice, &dci->wr_depth, signaled);
+    }
+    __sync_fetch_and_add(&dci->wr_depth, wr_count);
+    __sync_fetch_and_add(dci->cq_outstanding, wr_count);
+    // Nothing of the list is posted if it fails
+    int rc = ibv_wr_complete(qpx);
+    if (rc) {
+        LOG(ERROR) << "Failed to post to DC initiator: " << strerror(rc);
+        for (int i = 0; i < wr_count; ++i)
+            failed_slice_list.push_back(slice_list[i]);
+        __sync_fetch_and_sub(&dci->wr_depth, wr_count);
+        __sync_fetch_and_sub(dci->cq_outstanding, wr_count);
+    }
+    slice_list.erase(slice_list.begin(), slice_list.begin() + wr_count);
+#endif
+    return 0;
+}
+
 size_t RdmaEndPoint::getQPNumber() const { return qp_list_.size(); }
 
+size_t RdmaEndPoint::getWrDepth() const {
+    size_t wr_depth = 0;
+    for (size_t i = 0; i < qp_list_.size(); ++i) wr_depth += wr_depth_list_[i];
+    return wr_depth;
+}
+
 std::vector<uint32_t> RdmaEndPoint::qpNum() const {
     std::vector<uint32_t> ret;
     for (int qp_index = 0; qp_index < (int)qp_list_.size(); ++qp_index)
@@ -393,15 +716,7 @@ int RdmaEndPoint::doSetupConnection(int qp_index, const std::string &peer_gid,
     attr.path_mtu = context_.activeMTU();
     if (globalConfig().mtu_length < attr.path_mtu)
         attr.path_mtu = globalConfig().mtu_length;
-    ibv_gid peer_gid_raw;
-    std::istringstream iss(peer_gid);
-    for (int i = 0; i < 16; ++i) {
-        int value;
-        iss >> std::hex >> value;
-        peer_gid_raw.raw[i] = static_cast<uint8_t>(value);
-        if (i < 15) iss.ignore(1, ':');
-    }
-    attr.ah_attr.grh.dgid = peer_gid_raw;
+    attr.ah_attr.grh.dgid = parseGid(peer_gid);
     // TODO gidIndex and portNum must fetch from REMOTE
     attr.ah_attr.grh.sgid_index = context_.gidIndex();
     attr.ah_attr.grh.hop_limit = MAX_HOP_LIMIT;
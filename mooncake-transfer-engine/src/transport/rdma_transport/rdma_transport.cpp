@@ -18,6 +18,7 @@
 #include <sys/mman.h>
 #include <sys/time.h>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
@@ -129,6 +130,14 @@ int RdmaTransport::install(std::string &local_server_name,
     return 0;
 }
 
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+// Pre-touched blocks start on huge page boundaries, so that no two threads
+// fault in the same huge page
+static constexpr uintptr_t kPreTouchAlignment = 2 * 1024 * 1024;
+
 int RdmaTransport::preTouchMemory(void *addr, size_t length) {
     if (context_list_.size() == 0) {
         // At least one context is required for pre-touch.
@@ -140,21 +149,42 @@ int RdmaTransport::preTouchMemory(void *addr, size_t length) {
     if (length > (size_t)globalConfig().max_mr_size) {
         length = (size_t)globalConfig().max_mr_size;
     }
-    size_t block_size = length / num_threads;
-    if (block_size == 0) {
+    if (num_threads == 0 || length == 0) {
         return 0;
     }
+    const uintptr_t block_size = std::max(
+        kPreTouchAlignment, (length / num_threads + kPreTouchAlignment - 1) &
+                                ~(kPreTouchAlignment - 1));
+
+    // The blocks cover the whole range, the tail included
+    std::vector<std::pair<uintptr_t, uintptr_t>> blocks;
+    const uintptr_t end = reinterpret_cast<uintptr_t>(addr) + length;
+    for (uintptr_t begin = reinterpret_cast<uintptr_t>(addr); begin < end;) {
+        uintptr_t block_end =
+            std::min(end, (begin + block_size + kPreTouchAlignment - 1) &
+                              ~(kPreTouchAlignment - 1));
+        blocks.emplace_back(begin, block_end);
+        begin = block_end;
+    }
 
+    const uintptr_t page_mask = ~(uintptr_t)(getpagesize() - 1);
     std::vector<std::thread> threads;
-    threads.reserve(num_threads);
-    std::vector<int> thread_results(num_threads, 0);
+    threads.reserve(blocks.size());
+    std::vector<int> thread_results(blocks.size(), 0);
 
-    for (size_t thread_i = 0; thread_i < num_threads; ++thread_i) {
-        void *block_addr = static_cast<char *>(addr) + thread_i * block_size;
-        threads.emplace_back([this, thread_i, block_addr, block_size,
+    for (size_t block_i = 0; block_i < blocks.size(); ++block_i) {
+        threads.emplace_back([this, block_i, page_mask, &blocks,
                               &thread_results]() {
-            int ret = context_list_[0]->preTouchMemory(block_addr, block_size);
-            thread_results[thread_i] = ret;
+            auto [begin, end] = blocks[block_i];
+            // Populates the page tables without pinning the pages or
+            // touching the data, since Linux 5.14
+            uintptr_t page_begin = begin & page_mask;
+            if (madvise(reinterpret_cast<void *>(page_begin), end - page_begin,
+                        MADV_POPULATE_WRITE) == 0) {
+                return;
+            }
+            thread_results[block_i] = context_list_[0]->preTouchMemory(
+                reinterpret_cast<void *>(begin), end - begin);
         });
     }
 
@@ -162,7 +192,7 @@ int RdmaTransport::preTouchMemory(void *addr, size_t length) {
         thread.join();
     }
 
-    for (size_t i = 0; i < num_threads; ++i) {
+    for (size_t i = 0; i < thread_results.size(); ++i) {
         if (thread_results[i] != 0) {
             return thread_results[i];
         }
@@ -186,15 +216,17 @@ int RdmaTransport::registerLocalMemoryInternal(void *addr, size_t length,
                                                bool force_sequential) {
     (void)remote_accessible;
     BufferDesc buffer_desc;
-    const int kBaseAccessRights = IBV_ACCESS_LOCAL_WRITE |
-                                  IBV_ACCESS_REMOTE_WRITE |
-                                  IBV_ACCESS_REMOTE_READ;
+    const int kBaseAccessRights =
+        IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE |
+        IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_ATOMIC;
 
     static int access_rights = kBaseAccessRights;
     if (MCIbRelaxedOrderingEnabled) {
         access_rights |= IBV_ACCESS_RELAXED_ORDERING;
     }
+    // Memory covered by an implicit ODP MR is never pinned
     bool do_pre_touch = context_list_.size() > 0 &&
+                        !context_list_[0]->odpEnabled() &&
                         std::thread::hardware_concurrency() >= 4 &&
                         length >= (size_t)4 * 1024 * 1024 * 1024;
     if (do_pre_touch) {
@@ -364,6 +396,7 @@ int RdmaTransport::allocateLocalSegmentID() {
         device_desc.name = entry->deviceName();
         device_desc.lid = entry->lid();
         device_desc.gid = entry->gid();
+        device_desc.dct_num = entry->dctNum();
         desc->devices.push_back(device_desc);
     }
     desc->topology = *(local_topology_.get());
@@ -439,7 +472,7 @@ Status RdmaTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
     std::vector<TransferTask *> task_list;
     for (auto &task : batch_desc.task_list) task_list.push_back(&task);
     return submitTransferTask(task_list);
@@ -447,15 +480,43 @@ Status RdmaTransport::submitTransfer(
 
 Status RdmaTransport::submitTransferTask(
     const std::vector<TransferTask *> &task_list) {
-    std::unordered_map<std::shared_ptr<RdmaContext>, std::vector<Slice *>>
-        slices_to_post;
+    // Slices to post and their bytes, per device. Kept across calls so that
+    // submitting does not allocate once they have grown.
+    thread_local std::vector<std::vector<Slice *>> slices_to_post;
+    thread_local std::vector<uint64_t> pending_bytes;
+    if (slices_to_post.size() < context_list_.size())
+        slices_to_post.resize(context_list_.size());
+    pending_bytes.assign(context_list_.size(), 0);
+    auto post_slices = [&]() {
+        for (size_t id = 0; id < context_list_.size(); ++id) {
+            if (slices_to_post[id].empty()) continue;
+            context_list_[id]->submitPostSend(slices_to_post[id]);
+            slices_to_post[id].clear();
+        }
+        std::fill(pending_bytes.begin(), pending_bytes.end(), 0);
+    };
+    // Atomics operate on a single aligned word
+    for (auto task : task_list) {
+        auto &request = *task->request;
+        if (request.isAtomic() &&
+            (request.length != sizeof(uint64_t) ||
+             request.target_offset % sizeof(uint64_t) ||
+             (uint64_t)request.source % sizeof(uint64_t))) {
+            LOG(ERROR) << "RdmaTransport: Atomics need 8-byte aligned "
+                          "source and target of length 8";
+            return Status::InvalidArgument(
+                "Atomic request of length " + std::to_string(request.length) +
+                " or misaligned");
+        }
+    }
+
     auto local_segment_desc = metadata_->getSegmentDescByID(LOCAL_SEGMENT_ID);
     assert(local_segment_desc.get());
-    const size_t kBlockSize = globalConfig().slice_size;
     const int kMaxRetryCount = globalConfig().retry_cnt;
-    const size_t kFragmentSize = globalConfig().fragment_limit;
     const size_t kSubmitWatermark =
         globalConfig().max_wr * globalConfig().num_qp_per_ep;
+    const bool kRailLoadBalance = globalConfig().rail_load_balance;
+    const size_t kMaxInline = globalConfig().max_inline;
     uint64_t nr_slices;
     for (size_t index = 0; index < task_list.size(); ++index) {
         assert(task_list[index]);
@@ -464,6 +525,19 @@ Status RdmaTransport::submitTransferTask(
         assert(task.request);
         auto &request = *task.request;
 
+        // Atomics and writes small enough to be sent inline are neither
+        // sliced nor queued to the workers
+        if (request.isAtomic() ||
+            (request.opcode == TransferRequest::WRITE && request.length &&
+             request.length <= kMaxInline)) {
+            auto status = postSmallRequest(task, local_segment_desc.get());
+            if (!status.ok()) {
+                for (auto &slices : slices_to_post) slices.clear();
+                return status;
+            }
+            continue;
+        }
+
         auto request_buffer_id = -1, request_device_id = -1;
         if (selectDevice(local_segment_desc.get(), (uint64_t)request.source,
                          request.length, request_buffer_id,
@@ -471,6 +545,10 @@ Status RdmaTransport::submitTransferTask(
             request_buffer_id = -1;
             request_device_id = -1;
         }
+        const size_t kBlockSize = sliceSize(request.length, request_device_id);
+        // The tail merged into the last slice scales with it
+        const size_t kFragmentSize = globalConfig().fragment_limit *
+                                     (kBlockSize / globalConfig().slice_size);
 
         for (uint64_t offset = 0; offset < request.length;
              offset += kBlockSize) {
@@ -492,6 +570,7 @@ Status RdmaTransport::submitTransferTask(
             slice->rdma.max_retry_cnt = kMaxRetryCount;
             slice->task = &task;
             slice->target_id = request.target_id;
+            slice->priority = request.priority;
             slice->status = Slice::PENDING;
             slice->ts = 0;
             task.slice_list.push_back(slice);
@@ -503,6 +582,12 @@ Status RdmaTransport::submitTransferTask(
                 found_device = true;
                 buffer_id = request_buffer_id;
                 device_id = request_device_id;
+                // Retries keep rotating through the devices instead
+                if (kRailLoadBalance && request.advise_retry_cnt == 0) {
+                    int least_loaded_id = selectLeastLoadedDevice(
+                        local_segment_desc.get(), buffer_id, pending_bytes);
+                    if (least_loaded_id >= 0) device_id = least_loaded_id;
+                }
             }
             while (retry_cnt < kMaxRetryCount && !found_device) {
                 if (selectDevice(local_segment_desc.get(),
@@ -524,8 +609,10 @@ Status RdmaTransport::submitTransferTask(
             }
             if (!found_device) {
                 auto source_addr = slice->source_addr;
-                for (auto &entry : slices_to_post)
-                    for (auto s : entry.second) getSliceCache().deallocate(s);
+                for (auto &slices : slices_to_post) {
+                    for (auto s : slices) getSliceCache().deallocate(s);
+                    slices.clear();
+                }
                 LOG(ERROR)
                     << "Memory region not registered by any active device(s): "
                     << source_addr;
@@ -535,6 +622,7 @@ Status RdmaTransport::submitTransferTask(
             } else {
                 auto &context = context_list_[device_id];
                 if (!context->active()) {
+                    for (auto &slices : slices_to_post) slices.clear();
                     LOG(ERROR) << "Device " << device_id << " is not active";
                     return Status::InvalidArgument("Device " +
                                                    std::to_string(device_id) +
@@ -542,15 +630,14 @@ Status RdmaTransport::submitTransferTask(
                 }
                 slice->rdma.source_lkey =
                     local_segment_desc->buffers[buffer_id].lkey[device_id];
-                slices_to_post[context].push_back(slice);
+                slices_to_post[device_id].push_back(slice);
+                pending_bytes[device_id] += slice->length;
                 task.total_bytes += slice->length;
                 __sync_fetch_and_add(&task.slice_count, 1);
             }
 
             if (nr_slices >= kSubmitWatermark) {
-                for (auto &entry : slices_to_post)
-                    entry.first->submitPostSend(entry.second);
-                slices_to_post.clear();
+                post_slices();
                 nr_slices = 0;
             }
 
@@ -560,11 +647,97 @@ Status RdmaTransport::submitTransferTask(
         }
     }
 
-    for (auto &entry : slices_to_post)
-        if (!entry.second.empty()) entry.first->submitPostSend(entry.second);
+    post_slices();
+    return Status::OK();
+}
+
+Status RdmaTransport::postSmallRequest(TransferTask &task,
+                                       SegmentDesc *local_segment_desc) {
+    auto &request = *task.request;
+    int buffer_id = -1, device_id = -1;
+    bool found_device = false;
+    for (int retry_cnt = request.advise_retry_cnt;
+         retry_cnt < globalConfig().retry_cnt && !found_device; ++retry_cnt) {
+        if (selectDevice(local_segment_desc, (uint64_t)request.source,
+                         request.length, buffer_id, device_id, retry_cnt))
+            break;
+        found_device = context_list_[device_id]->active();
+    }
+    if (!found_device) {
+        // Atomics write the former value back, into registered memory. The
+        // data of inline writes is copied when posting, from anywhere.
+        if (request.isAtomic()) {
+            LOG(ERROR) << "Memory region not registered by any active "
+                          "device(s): "
+                       << request.source;
+            return Status::AddressNotRegistered(
+                "Memory region not registered by any active device(s): " +
+                std::to_string(reinterpret_cast<uintptr_t>(request.source)));
+        }
+        buffer_id = -1;
+        for (device_id = 0; device_id < (int)context_list_.size();
+             ++device_id) {
+            if (context_list_[device_id]->active()) break;
+        }
+        if (device_id == (int)context_list_.size()) {
+            LOG(ERROR) << "RdmaTransport: No active device";
+            return Status::InvalidArgument("No active device");
+        }
+    }
+
+    Slice *slice = getSliceCache().allocate();
+    slice->source_addr = request.source;
+    slice->length = request.length;
+    slice->opcode = request.opcode;
+    slice->rdma.dest_addr = request.target_offset;
+    slice->rdma.compare_add = request.compare_add;
+    slice->rdma.swap = request.swap;
+    slice->rdma.retry_cnt = request.advise_retry_cnt;
+    slice->rdma.max_retry_cnt = globalConfig().retry_cnt;
+    slice->rdma.source_lkey =
+        buffer_id >= 0 ? local_segment_desc->buffers[buffer_id].lkey[device_id]
+                       : 0;
+    slice->task = &task;
+    slice->target_id = request.target_id;
+    slice->priority = request.priority;
+    slice->status = Slice::PENDING;
+    slice->ts = 0;
+    task.slice_list.push_back(slice);
+    task.total_bytes += slice->length;
+    __sync_fetch_and_add(&task.slice_count, 1);
+    context_list_[device_id]->postSendDirect(slice);
     return Status::OK();
 }
 
+size_t RdmaTransport::sliceSize(size_t length, int device_id) const {
+    // Slices keep a NIC busy for about this long, so that large requests
+    // pay for fewer work requests and completions
+    const uint64_t kTargetSliceTime = 50000;
+    // and are cut into at least this many slices per NIC, to spread over
+    // the rails
+    const size_t kMinSlicesPerDevice = 4;
+    const size_t base = globalConfig().slice_size;
+    const size_t max = globalConfig().max_slice_size;
+    if (max <= base || length <= base * 2 || context_list_.empty()) {
+        return base;
+    }
+
+    uint64_t throughput = 0;
+    if (device_id >= 0) {
+        throughput = context_list_[device_id]->throughput();
+    } else {
+        for (auto &context : context_list_) {
+            throughput = std::max(throughput, context->throughput());
+        }
+    }
+    size_t size = throughput * kTargetSliceTime / 1000000000ull;
+    size = std::min(size, max);
+    size = std::min(size,
+                    length / (kMinSlicesPerDevice * context_list_.size()));
+    // A multiple of slice_size, which fragment_limit relates to
+    return std::max(size / base, (size_t)1) * base;
+}
+
 Status RdmaTransport::getTransferStatus(BatchID batch_id,
                                         std::vector<TransferStatus> &status) {
     auto &batch_desc = *((BatchDesc *)(batch_id));
@@ -672,6 +845,158 @@ int RdmaTransport::startHandshakeDaemon(std::string &local_server_name) {
         metadata_->localRpcMeta().rpc_port, metadata_->localRpcMeta().sockfd);
 }
 
+int RdmaTransport::warmupSegment(SegmentID target_id) {
+    auto peer_segment_desc = metadata_->getSegmentDescByID(target_id);
+    if (!peer_segment_desc) return ERR_INVALID_ARGUMENT;
+    if (peer_segment_desc->protocol != "rdma") return 0;
+
+    // Connect every local NIC to every NIC of the peer, as slices may
+    // take any pair
+    std::vector<std::shared_ptr<RdmaEndPoint>> endpoint_list;
+    std::vector<HandShakeDesc> local_desc_list;
+    int ret = 0;
+    for (auto &context : context_list_) {
+        if (!context->active()) continue;
+        for (auto &device : peer_segment_desc->devices) {
+            auto endpoint = context->endpoint(
+                MakeNicPath(peer_segment_desc->name, device.name));
+            if (!endpoint) {
+                ret = ERR_ENDPOINT;
+                continue;
+            }
+            if (endpoint->connected()) continue;
+            if (context->dcEnabled() ||
+                peer_segment_desc->name == local_server_name_) {
+                // DC or loopback, no handshake to batch
+                if (endpoint->setupConnectionsByActive()) ret = ERR_ENDPOINT;
+                continue;
+            }
+            endpoint_list.push_back(endpoint);
+            local_desc_list.emplace_back();
+            endpoint->prepareHandshake(local_desc_list.back());
+        }
+    }
+    if (endpoint_list.empty()) return ret;
+
+    std::vector<HandShakeDesc> peer_desc_list;
+    if (metadata_->sendHandshakeBatch(peer_segment_desc->name, local_desc_list,
+                                      peer_desc_list)) {
+        // The peer may predate batched handshakes
+        for (auto &endpoint : endpoint_list)
+            if (!endpoint->connected() && endpoint->setupConnectionsByActive())
+                ret = ERR_ENDPOINT;
+        return ret;
+    }
+    for (size_t i = 0; i < endpoint_list.size(); ++i)
+        if (endpoint_list[i]->setupConnectionsByActive(local_desc_list[i],
+                                                        peer_desc_list[i]))
+            ret = ERR_ENDPOINT;
+    return ret;
+}
+
+int RdmaTransport::sendNotify(SegmentID target_id, const NotifyDesc &notify) {
+    if (!globalConfig().rdma_notify) return ERR_NOT_IMPLEMENTED;
+    auto peer_segment_desc = metadata_->getSegmentDescByID(target_id);
+    if (!peer_segment_desc) return ERR_INVALID_ARGUMENT;
+    if (peer_segment_desc->protocol != "rdma") return ERR_NOT_IMPLEMENTED;
+
+    // Any endpoint to the peer will do, but only existing ones: connecting
+    // would cost more than the RPC
+    for (auto &context : context_list_) {
+        if (!context->active() || !context->notifyEnabled()) continue;
+        for (auto &device : peer_segment_desc->devices) {
+            auto endpoint = context->findEndpoint(
+                MakeNicPath(peer_segment_desc->name, device.name));
+            if (endpoint && !context->postNotify(
+                                *endpoint, peer_segment_desc->name, notify))
+                return 0;
+        }
+    }
+    return ERR_ENDPOINT;
+}
+
+void RdmaTransport::failoverSlices(RdmaContext &from,
+                                   std::vector<Slice *> &slice_list) {
+    auto local_segment_desc = metadata_->getSegmentDescByID(LOCAL_SEGMENT_ID);
+    if (!local_segment_desc) return;
+    std::vector<uint64_t> pending_bytes(context_list_.size(), 0);
+    std::vector<std::vector<Slice *>> slices_to_post(context_list_.size());
+    std::vector<Slice *> stranded_slice_list;
+    for (auto slice : slice_list) {
+        int buffer_id = -1, device_id = -1;
+        if (selectDevice(local_segment_desc.get(), (uint64_t)slice->source_addr,
+                         slice->length, buffer_id, device_id)) {
+            stranded_slice_list.push_back(slice);
+            continue;
+        }
+        device_id = selectLeastLoadedDevice(local_segment_desc.get(),
+                                            buffer_id, pending_bytes);
+        // Without preferred devices left, any device serving the buffer
+        for (int retry_cnt = 1;
+             device_id < 0 && retry_cnt <= (int)context_list_.size();
+             ++retry_cnt) {
+            if (selectDevice(local_segment_desc.get(),
+                             (uint64_t)slice->source_addr, slice->length,
+                             buffer_id, device_id, retry_cnt)) {
+                device_id = -1;
+                break;
+            }
+            if (!context_list_[device_id]->active()) device_id = -1;
+        }
+        if (device_id < 0 || context_list_[device_id].get() == &from) {
+            stranded_slice_list.push_back(slice);
+            continue;
+        }
+        slice->rdma.source_lkey =
+            local_segment_desc->buffers[buffer_id].lkey[device_id];
+        pending_bytes[device_id] += slice->length;
+        slices_to_post[device_id].push_back(slice);
+    }
+    slice_list.swap(stranded_slice_list);
+    for (size_t device_id = 0; device_id < context_list_.size(); ++device_id)
+        if (!slices_to_post[device_id].empty())
+            context_list_[device_id]->submitPostSend(slices_to_post[device_id]);
+}
+
+int RdmaTransport::selectLeastLoadedDevice(
+    SegmentDesc *desc, int buffer_id,
+    const std::vector<uint64_t> &pending_bytes) const {
+    auto *candidates =
+        &desc->topology.candidateDevices(desc->buffers[buffer_id].name);
+    if (candidates->empty())
+        candidates = &desc->topology.candidateDevices(kWildcardLocation);
+    if (candidates->empty()) return -1;
+
+    // Devices not measured yet are taken to be as fast as the fastest one
+    uint64_t max_throughput = 1;
+    for (int device_id : *candidates)
+        if (device_id >= 0 && device_id < (int)context_list_.size())
+            max_throughput = std::max(max_throughput,
+                                      context_list_[device_id]->throughput());
+
+    // Ties, such as between idle devices, go to a rotating start
+    thread_local size_t tl_start = 0;
+    tl_start++;
+    int best_device_id = -1;
+    double best_drain_time = 0;
+    for (size_t i = 0; i < candidates->size(); ++i) {
+        int device_id = (*candidates)[(tl_start + i) % candidates->size()];
+        if (device_id < 0 || device_id >= (int)context_list_.size()) continue;
+        auto &context = context_list_[device_id];
+        if (!context->active()) continue;
+        uint64_t throughput = context->throughput();
+        if (!throughput) throughput = max_throughput;
+        double drain_time =
+            double(context->outstandingBytes() + pending_bytes[device_id]) /
+            throughput;
+        if (best_device_id < 0 || drain_time < best_drain_time) {
+            best_device_id = device_id;
+            best_drain_time = drain_time;
+        }
+    }
+    return best_device_id;
+}
+
 // According to the request desc, offset and length information, find proper
 // buffer_id and device_id as output.
 // Return 0 if successful, ERR_ADDRESS_NOT_REGISTERED otherwise.
@@ -684,6 +1009,8 @@ int RdmaTransport::selectDevice(SegmentDesc *desc, uint64_t offset,
     for (buffer_id = 0; buffer_id < static_cast<int>(buffers.size());
          ++buffer_id) {
         const auto &buffer = buffers[buffer_id];
+        // Registered by another transport only, e.g. NvlinkTransport
+        if (buffer.rkey.empty()) continue;
 
         // Check if offset is within buffer range
         if (offset < buffer.addr || length > buffer.length ||
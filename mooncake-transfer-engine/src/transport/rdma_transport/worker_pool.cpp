@@ -14,11 +14,17 @@
 
 #include "transport/rdma_transport/worker_pool.h"
 
+#include <poll.h>
+#include <pthread.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
 
 #include "config.h"
+#include "transfer_latency_metrics.h"
 #include "transport/rdma_transport/rdma_context.h"
 #include "transport/rdma_transport/rdma_endpoint.h"
 #include "transport/rdma_transport/rdma_transport.h"
@@ -31,6 +37,24 @@ namespace mooncake {
 
 const static int kTransferWorkerCount = globalConfig().workers_per_ctx;
 
+// Slots of each per-worker submission ring
+const static size_t kSliceRingCapacity = 65536;
+
+// Peer NICs are told apart by the target segment and the index of the NIC
+// in its descriptor, which the slice keeps in rdma.peer_device_id. It saves
+// hashing the NIC path string for every slice.
+static inline uint64_t endpointKey(const Transport::Slice *slice) {
+    return (slice->target_id << 16) | (uint16_t)slice->rdma.peer_device_id;
+}
+
+// The low bits of endpointKey() are the NIC index alone, so peers are
+// spread over the workers with a hash mixing in the target
+static inline int workerOf(SegmentID target_id, int device_id) {
+    return (target_id * 10007 + device_id) % kTransferWorkerCount;
+}
+
+using Priority = Transport::TransferRequest::Priority;
+
 WorkerPool::WorkerPool(RdmaContext &context, int numa_socket_id)
     : context_(context),
       numa_socket_id_(numa_socket_id),
@@ -38,10 +62,34 @@ WorkerPool::WorkerPool(RdmaContext &context, int numa_socket_id)
       suspended_flag_(0),
       redispatch_counter_(0),
       submitted_slice_count_(0),
-      processed_slice_count_(0) {
-    for (int i = 0; i < kShardCount; ++i)
-        slice_queue_count_[i].store(0, std::memory_order_relaxed);
+      processed_slice_count_(0),
+      outstanding_bytes_(0) {
+    for (int i = 0; i < kTransferWorkerCount; ++i)
+        slice_ring_.emplace_back(
+            new BoundedMpscRing<Transport::Slice *>(kSliceRingCapacity));
     collective_slice_queue_.resize(kTransferWorkerCount);
+    worker_state_.reset(new WorkerState[kTransferWorkerCount]);
+    for (int i = 0; i < kTransferWorkerCount; ++i) {
+        // Without it the worker never sleeps on its CQs
+        worker_state_[i].wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (worker_state_[i].wakeup_fd < 0)
+            PLOG(WARNING) << "Worker: Failed to create wakeup eventfd";
+    }
+    auto &metrics = TransferLatencyMetrics::instance();
+    const std::string labels =
+        "transport=\"rdma\",nic=\"" + context_.deviceName() + "\"";
+    nic_latency_ = metrics.histogram(
+        "mooncake_te_slice_latency_us",
+        "Slice post to completion latency (us) by local NIC", labels);
+    metrics.addGauge(
+        this, "mooncake_te_inflight_slices",
+        "Slices submitted and not completed yet", labels, [this]() {
+            return submitted_slice_count_.load(std::memory_order_relaxed) -
+                   processed_slice_count_.load(std::memory_order_relaxed);
+        });
+    metrics.addGauge(this, "mooncake_te_outstanding_bytes",
+                     "Bytes of the slices submitted and not completed yet",
+                     labels, [this]() { return outstandingBytes(); });
     for (int i = 0; i < kTransferWorkerCount; ++i)
         worker_thread_.emplace_back(
             std::thread(std::bind(&WorkerPool::transferWorker, this, i)));
@@ -50,11 +98,16 @@ WorkerPool::WorkerPool(RdmaContext &context, int numa_socket_id)
 }
 
 WorkerPool::~WorkerPool() {
+    TransferLatencyMetrics::instance().removeGauges(this);
     if (workers_running_) {
         cond_var_.notify_all();
         workers_running_.store(false);
+        for (int i = 0; i < kTransferWorkerCount; ++i) wakeUp(i);
         for (auto &entry : worker_thread_) entry.join();
     }
+    for (int i = 0; i < kTransferWorkerCount; ++i)
+        if (worker_state_[i].wakeup_fd >= 0)
+            close(worker_state_[i].wakeup_fd);
 }
 
 int WorkerPool::submitPostSend(
@@ -95,8 +148,9 @@ int WorkerPool::submitPostSend(
     }
 #endif  // CONFIG_CACHE_SEGMENT_DESC
 
-    SliceList slice_list_map[kShardCount];
-    uint64_t submitted_slice_count = 0;
+    thread_local std::vector<SliceList> slice_list_map;
+    slice_list_map.resize(kTransferWorkerCount);
+    uint64_t submitted_slice_count = 0, submitted_bytes = 0;
     thread_local std::unordered_map<int, uint64_t> failed_target_ids;
     for (auto &slice : slice_list) {
         if (failed_target_ids.count(slice->target_id)) {
@@ -142,25 +196,20 @@ int WorkerPool::submitPostSend(
         }
         slice->rdma.dest_rkey =
             peer_segment_desc->buffers[buffer_id].rkey[device_id];
+        slice->rdma.peer_device_id = device_id;
         auto peer_nic_path =
             MakeNicPath(peer_segment_desc->name,
                         peer_segment_desc->devices[device_id].name);
         slice->peer_nic_path = peer_nic_path;
-        int shard_id = (slice->target_id * 10007 + device_id) % kShardCount;
-        slice_list_map[shard_id].push_back(slice);
+        int worker_id = workerOf(slice->target_id, device_id);
+        slice_list_map[worker_id].push_back(slice);
         submitted_slice_count++;
+        submitted_bytes += slice->length;
     }
 
-    for (int shard_id = 0; shard_id < kShardCount; ++shard_id) {
-        if (slice_list_map[shard_id].empty()) continue;
-        slice_queue_lock_[shard_id].lock();
-        for (auto &slice : slice_list_map[shard_id])
-            slice_queue_[shard_id][slice->peer_nic_path].push_back(slice);
-        slice_queue_count_[shard_id].fetch_add(slice_list_map[shard_id].size(),
-                                               std::memory_order_relaxed);
-        slice_queue_lock_[shard_id].unlock();
-    }
-
+    // Count the slices before pushing them: a push waits for the worker
+    // when the ring is full, and workers only run while slices are pending
+    outstanding_bytes_.fetch_add(submitted_bytes, std::memory_order_relaxed);
     submitted_slice_count_.fetch_add(submitted_slice_count,
                                      std::memory_order_relaxed);
     if (suspended_flag_.load(std::memory_order_relaxed)) {
@@ -168,25 +217,84 @@ int WorkerPool::submitPostSend(
         cond_var_.notify_all();
     }
 
+    for (int worker_id = 0; worker_id < kTransferWorkerCount; ++worker_id) {
+        if (slice_list_map[worker_id].empty()) continue;
+        slice_ring_[worker_id]->push(slice_list_map[worker_id]);
+        slice_list_map[worker_id].clear();
+        // Pairs with the fence in waitForCompletion(): either the worker
+        // sees the slices, or we see it waiting
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (worker_state_[worker_id].waiting.load(std::memory_order_relaxed))
+            wakeUp(worker_id);
+    }
+
     return 0;
 }
 
-void WorkerPool::performPostSend(int thread_id) {
-    auto &local_slice_queue = collective_slice_queue_[thread_id];
-    for (int shard_id = thread_id; shard_id < kShardCount;
-         shard_id += kTransferWorkerCount) {
-        if (slice_queue_count_[shard_id].load(std::memory_order_relaxed) == 0)
-            continue;
+WorkerPool::SliceList &WorkerPool::sliceQueue(int thread_id,
+                                              Transport::Slice *slice) {
+    // Unknown classes are served last
+    int priority = std::min<int>(slice->priority, Priority::BULK);
+    return collective_slice_queue_[thread_id][priority][endpointKey(slice)];
+}
 
-        slice_queue_lock_[shard_id].lock();
-        for (auto &entry : slice_queue_[shard_id]) {
-            for (auto &slice : entry.second)
-                local_slice_queue[entry.first].push_back(slice);
-            entry.second.clear();
-        }
-        slice_queue_count_[shard_id].store(0, std::memory_order_relaxed);
-        slice_queue_lock_[shard_id].unlock();
+void WorkerPool::postSendDirect(Transport::Slice *slice) {
+    thread_local SliceList slice_list, failed_slice_list;
+    slice_list.assign(1, slice);
+    auto peer_segment_desc =
+        context_.engine().meta()->getSegmentDescByID(slice->target_id);
+    auto hint =
+        globalConfig().enable_dest_device_affinity ? context_.deviceName() : "";
+    int buffer_id, device_id;
+    std::shared_ptr<RdmaEndPoint> endpoint;
+    if (peer_segment_desc &&
+        !RdmaTransport::selectDevice(peer_segment_desc.get(),
+                                     slice->rdma.dest_addr, slice->length,
+                                     hint, buffer_id, device_id)) {
+        slice->rdma.dest_rkey =
+            peer_segment_desc->buffers[buffer_id].rkey[device_id];
+        slice->rdma.peer_device_id = device_id;
+        slice->peer_nic_path =
+            MakeNicPath(peer_segment_desc->name,
+                        peer_segment_desc->devices[device_id].name);
+        endpoint = context_.endpoint(slice->peer_nic_path);
+    }
+    // Connecting, reloading the segment and failing are left to the workers
+    if (!endpoint || !endpoint->active() || !endpoint->connected()) {
+        submitPostSend(slice_list);
+        return;
+    }
+
+    // Counted first, so that the workers poll for the completion
+    outstanding_bytes_.fetch_add(slice->length, std::memory_order_relaxed);
+    submitted_slice_count_.fetch_add(1, std::memory_order_relaxed);
+    if (suspended_flag_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(cond_mutex_);
+        cond_var_.notify_all();
     }
+    failed_slice_list.clear();
+    endpoint->submitPostSend(slice_list, failed_slice_list);
+    if (slice_list.empty() && failed_slice_list.empty()) return;
+
+    outstanding_bytes_.fetch_sub(slice->length, std::memory_order_relaxed);
+    submitted_slice_count_.fetch_sub(1, std::memory_order_relaxed);
+    slice_list.assign(1, slice);
+    submitPostSend(slice_list);
+}
+
+int WorkerPool::performPostSend(int thread_id) {
+    auto &local_slice_queue = collective_slice_queue_[thread_id];
+    thread_local SliceList tl_popped_slices;
+    int progress = slice_ring_[thread_id]->pop(tl_popped_slices);
+    if (progress) {
+        for (auto &slice : tl_popped_slices)
+            sliceQueue(thread_id, slice).push_back(slice);
+        tl_popped_slices.clear();
+    }
+
+    // Slices of an inactive device move to other devices at once, instead
+    // of waiting here for it to come back
+    if (!context_.active() && failover(thread_id)) return 1;
 
     // Redispatch slices to other endpoints, for temporary failures
     thread_local int tl_redispatch_counter = 0;
@@ -195,15 +303,15 @@ void WorkerPool::performPostSend(int thread_id) {
         tl_redispatch_counter =
             redispatch_counter_.load(std::memory_order_relaxed);
         auto local_slice_queue_clone = local_slice_queue;
-        local_slice_queue.clear();
-        for (auto &entry : local_slice_queue_clone)
-            redispatch(entry.second, thread_id);
-        return;
+        for (auto &queue : local_slice_queue) queue.clear();
+        for (auto &queue : local_slice_queue_clone)
+            for (auto &entry : queue) redispatch(entry.second, thread_id);
+        return 1;
     }
 
 #ifdef CONFIG_CACHE_ENDPOINT
     thread_local uint64_t tl_last_cache_ts = getCurrentTimeInNano();
-    thread_local std::unordered_map<std::string, std::shared_ptr<RdmaEndPoint>>
+    thread_local std::unordered_map<uint64_t, std::shared_ptr<RdmaEndPoint>>
         endpoint_map;
     uint64_t current_ts = getCurrentTimeInNano();
     if (current_ts - tl_last_cache_ts > 1000000000) {
@@ -212,65 +320,176 @@ void WorkerPool::performPostSend(int thread_id) {
     }
 #endif
 
+    // Classes post in priority order, so each round the slices of higher
+    // classes go out before the ones queued behind them. BULK posts at most
+    // rdma_bulk_burst slices per peer NIC per round, which lets the slices
+    // of other classes submitted meanwhile in between those of a large
+    // transfer. Under strict priority a class skips the peer NICs a class
+    // above it still has slices queued for.
+    const bool strict_priority = globalConfig().rdma_strict_priority;
+    thread_local std::unordered_set<uint64_t> tl_backlogged_keys;
+    tl_backlogged_keys.clear();
     SliceList failed_slice_list;
-    for (auto &entry : local_slice_queue) {
-        if (entry.second.empty()) continue;
+    for (int priority = 0; priority < Priority::kPriorityCount; ++priority) {
+        const size_t burst = priority == Priority::BULK
+                                 ? globalConfig().rdma_bulk_burst
+                                 : SIZE_MAX;
+        for (auto &entry : local_slice_queue[priority]) {
+            if (entry.second.empty()) continue;
+            if (strict_priority && tl_backlogged_keys.count(entry.first))
+                continue;
+            const size_t queued = entry.second.size();
+            const size_t to_post = std::min(queued, burst);
+            progress += to_post;
+            const std::string &peer_nic_path =
+                entry.second.front()->peer_nic_path;
 
 #ifdef USE_FAKE_POST_SEND
-        for (auto &slice : entry.second) slice->markSuccess();
-        processed_slice_count_.fetch_add(entry.second.size());
-        entry.second.clear();
+            for (auto &slice : entry.second) {
+                outstanding_bytes_.fetch_sub(slice->length);
+                slice->markSuccess();
+            }
+            processed_slice_count_.fetch_add(entry.second.size());
+            entry.second.clear();
 #else
 #ifdef CONFIG_CACHE_ENDPOINT
-        auto &endpoint = endpoint_map[entry.first];
-        if (endpoint == nullptr || !endpoint->active())
-            endpoint = context_.endpoint(entry.first);
+            auto &endpoint = endpoint_map[entry.first];
+            if (endpoint == nullptr || !endpoint->active())
+                endpoint = context_.endpoint(peer_nic_path);
 #else
-        auto endpoint = context_.endpoint(entry.first);
+            auto endpoint = context_.endpoint(peer_nic_path);
 #endif
-        if (!endpoint) {
-            for (auto &slice : entry.second) failed_slice_list.push_back(slice);
-            entry.second.clear();
-            continue;
-        }
-        if (!endpoint->active()) {
-            if (endpoint->inactiveTime() > 1.0)
-                context_.deleteEndpoint(
-                    entry.first);  // enable for re-establishation
-            for (auto &slice : entry.second) failed_slice_list.push_back(slice);
-            entry.second.clear();
-            continue;
-        }
-        if (!endpoint->connected() && endpoint->setupConnectionsByActive()) {
-            LOG(ERROR) << "Worker: Cannot make connection for endpoint: "
-                       << entry.first << ", mark it inactive";
-            for (auto &slice : entry.second) failed_slice_list.push_back(slice);
-            endpoint->set_active(false);
-            failed_nr_polls++;
-            if (context_.active() && failed_nr_polls > 32 &&
-                !success_nr_polls) {
-                LOG(WARNING)
-                    << "Failed to establish peer endpoints in local RNIC "
-                    << context_.nicPath() << ", mark it inactive";
-                context_.set_active(false);
+            if (!endpoint) {
+                for (auto &slice : entry.second)
+                    failed_slice_list.push_back(slice);
+                entry.second.clear();
+                continue;
             }
-            entry.second.clear();
-            continue;
-        }
-        endpoint->submitPostSend(entry.second, failed_slice_list);
+            if (!endpoint->active()) {
+                if (endpoint->inactiveTime() > 1.0)
+                    context_.deleteEndpoint(
+                        peer_nic_path);  // enable for re-establishation
+                for (auto &slice : entry.second)
+                    failed_slice_list.push_back(slice);
+                entry.second.clear();
+                continue;
+            }
+            if (!endpoint->connected() &&
+                endpoint->setupConnectionsByActive()) {
+                LOG(ERROR) << "Worker: Cannot make connection for endpoint: "
+                           << peer_nic_path << ", mark it inactive";
+                for (auto &slice : entry.second)
+                    failed_slice_list.push_back(slice);
+                endpoint->set_active(false);
+                failed_nr_polls++;
+                if (context_.active() && failed_nr_polls > 32 &&
+                    !success_nr_polls) {
+                    LOG(WARNING)
+                        << "Failed to establish peer endpoints in local RNIC "
+                        << context_.nicPath() << ", mark it inactive";
+                    context_.set_active(false);
+                }
+                entry.second.clear();
+                continue;
+            }
+            endpoint->submitPostSend(entry.second, failed_slice_list,
+                                     to_post);
+            // Less than to_post left the queue for lack of WR slots
+            progress -= to_post - (queued - entry.second.size());
+            if (strict_priority && !entry.second.empty())
+                tl_backlogged_keys.insert(entry.first);
 #endif
+        }
     }
 
     if (!failed_slice_list.empty()) {
         for (auto &slice : failed_slice_list) slice->rdma.retry_cnt++;
         redispatch(failed_slice_list, thread_id);
     }
+    return progress;
 }
 
-void WorkerPool::performPollCq(int thread_id) {
+void WorkerPool::recordLatency(const Transport::Slice *slice, int64_t now_ns) {
+    const uint64_t latency_us =
+        now_ns > slice->ts ? (now_ns - slice->ts) / 1000 : 0;
+    nic_latency_->record(latency_us);
+    // Workers only complete slices, so the histograms of the segments they
+    // see are cached per thread and looked up once
+    thread_local std::unordered_map<SegmentID, LatencyHistogram *>
+        segment_latency;
+    auto &histogram = segment_latency[slice->target_id];
+    if (!histogram) {
+        const auto &peer_nic_path = slice->peer_nic_path;
+        const std::string segment =
+            peer_nic_path.substr(0, peer_nic_path.find('@'));
+        histogram = TransferLatencyMetrics::instance().histogram(
+            "mooncake_te_segment_latency_us",
+            "Slice post to completion latency (us) by remote segment",
+            "transport=\"rdma\",segment=\"" + segment + "\"");
+    }
+    histogram->record(latency_us);
+}
+
+int WorkerPool::performPollCq(int thread_id) {
+    int nr_polled = 0;
     int processed_slice_count = 0;
+    uint64_t completed_bytes = 0;
     const static size_t kPollCount = 64;
-    std::unordered_map<volatile int *, int> qp_depth_set;
+    // Queue entries released per QP. Few QPs show up in a poll, and the
+    // same one in a row, so a vector kept across calls beats a hash map.
+    thread_local std::vector<std::pair<volatile int *, int>> qp_depth_set;
+    qp_depth_set.clear();
+    // Read once for all the slices completed by this poll
+    int64_t now_ns = 0;
+    auto settle = [&](Transport::Slice *slice, int status) {
+        if (status != IBV_WC_SUCCESS) {
+            bool show_work_request_flushed_error = globalConfig().trace;
+            // After detect an error, subsequent work requests will result
+            // in work_request_flushed_error, we hide this by default
+            if (status != IBV_WC_WR_FLUSH_ERR ||
+                show_work_request_flushed_error)
+                LOG(ERROR) << "Worker: Process failed for slice (opcode: "
+                           << slice->opcode
+                           << ", source_addr: " << slice->source_addr
+                           << ", length: " << slice->length
+                           << ", dest_addr: " << (void *)slice->rdma.dest_addr
+                           << ", local_nic: " << context_.deviceName()
+                           << ", peer_nic: " << slice->peer_nic_path
+                           << ", dest_rkey: " << slice->rdma.dest_rkey
+                           << ", retry_cnt: " << slice->rdma.retry_cnt
+                           << "): " << ibv_wc_status_str((ibv_wc_status)status);
+            failed_nr_polls++;
+            if (context_.active() && failed_nr_polls > 32 &&
+                !success_nr_polls) {
+                LOG(WARNING) << "Too many errors found in local RNIC "
+                             << context_.nicPath() << ", mark it inactive";
+                context_.set_active(false);
+            }
+            // The DC initiator is in the error state until recovered
+            if (context_.dcEnabled())
+                context_.failDcInitiator(slice->rdma.qp_depth);
+            context_.deleteEndpoint(slice->peer_nic_path);
+            slice->rdma.retry_cnt++;
+            if (slice->rdma.retry_cnt >= slice->rdma.max_retry_cnt) {
+                outstanding_bytes_.fetch_sub(slice->length);
+                slice->markFailed();
+                processed_slice_count_++;
+            } else {
+                sliceQueue(thread_id, slice).push_back(slice);
+                redispatch_counter_++;
+            }
+        } else {
+            completed_bytes += slice->length;
+            if (slice->ts > 0) {
+                if (!now_ns) now_ns = getCurrentTimeInNano();
+                recordLatency(slice, now_ns);
+            }
+            slice->markSuccess();
+            processed_slice_count++;
+            success_nr_polls++;
+        }
+    };
+
     for (int cq_index = thread_id; cq_index < context_.cqCount();
          cq_index += kTransferWorkerCount) {
         ibv_wc wc[kPollCount];
@@ -280,59 +499,49 @@ void WorkerPool::performPollCq(int thread_id) {
             continue;
         }
 
+        nr_polled += nr_poll;
+        int nr_completed = 0;
         for (int i = 0; i < nr_poll; ++i) {
+            if (wc[i].wr_id & kNotifyTagMask) {
+                nr_completed += context_.completeNotify(wc[i]);
+                continue;
+            }
             Transport::Slice *slice = (Transport::Slice *)wc[i].wr_id;
             assert(slice);
-            if (qp_depth_set.count(slice->rdma.qp_depth))
-                qp_depth_set[slice->rdma.qp_depth]++;
-            else
-                qp_depth_set[slice->rdma.qp_depth] = 1;
-            // __sync_fetch_and_sub(slice->rdma.qp_depth, 1);
-            if (wc[i].status != IBV_WC_SUCCESS) {
-                bool show_work_request_flushed_error = globalConfig().trace;
-                // After detect an error, subsequent work requests will result
-                // in work_request_flushed_error, we hide this by default
-                if (wc[i].status != IBV_WC_WR_FLUSH_ERR ||
-                    show_work_request_flushed_error)
-                    LOG(ERROR)
-                        << "Worker: Process failed for slice (opcode: "
-                        << slice->opcode
-                        << ", source_addr: " << slice->source_addr
-                        << ", length: " << slice->length
-                        << ", dest_addr: " << (void *)slice->rdma.dest_addr
-                        << ", local_nic: " << context_.deviceName()
-                        << ", peer_nic: " << slice->peer_nic_path
-                        << ", dest_rkey: " << slice->rdma.dest_rkey
-                        << ", retry_cnt: " << slice->rdma.retry_cnt
-                        << "): " << ibv_wc_status_str(wc[i].status);
-                failed_nr_polls++;
-                if (context_.active() && failed_nr_polls > 32 &&
-                    !success_nr_polls) {
-                    LOG(WARNING) << "Too many errors found in local RNIC "
-                                 << context_.nicPath() << ", mark it inactive";
-                    context_.set_active(false);
-                }
-                context_.deleteEndpoint(slice->peer_nic_path);
-                slice->rdma.retry_cnt++;
-                if (slice->rdma.retry_cnt >= slice->rdma.max_retry_cnt) {
-                    slice->markFailed();
-                    processed_slice_count_++;
+            if (!slice->rdma.signaled) {
+                // Completed on its own, so in error: settled along with the
+                // signaled WR after it, which completes later
+                slice->rdma.wc_status = wc[i].status;
+                continue;
+            }
+            // Every WR the completion stands for releases its queue entry
+            const int wr_count = 1 + slice->rdma.unsignaled_count;
+            if (qp_depth_set.empty() ||
+                qp_depth_set.back().first != slice->rdma.qp_depth) {
+                auto it = std::find_if(
+                    qp_depth_set.begin(), qp_depth_set.end(),
+                    [slice](const std::pair<volatile int *, int> &entry) {
+                        return entry.first == slice->rdma.qp_depth;
+                    });
+                if (it == qp_depth_set.end()) {
+                    qp_depth_set.emplace_back(slice->rdma.qp_depth, 0);
                 } else {
-                    collective_slice_queue_[thread_id][slice->peer_nic_path]
-                        .push_back(slice);
-                    redispatch_counter_++;
-                    // std::vector<RdmaTransport::Slice *> slice_list { slice };
-                    // redispatch(slice_list, thread_id);
+                    std::swap(*it, qp_depth_set.back());
                 }
-            } else {
-                slice->markSuccess();
-                processed_slice_count++;
-                success_nr_polls++;
             }
+            qp_depth_set.back().second += wr_count;
+            nr_completed += wr_count;
+            Transport::Slice *covered = slice->rdma.unsignaled;
+            for (uint32_t k = 0; k < slice->rdma.unsignaled_count; ++k) {
+                Transport::Slice *next = covered->rdma.unsignaled;
+                settle(covered, covered->rdma.wc_status);
+                covered = next;
+            }
+            settle(slice, wc[i].status);
         }
-        if (nr_poll)
+        if (nr_completed)
             __sync_fetch_and_sub(context_.cqOutstandingCount(cq_index),
-                                 nr_poll);
+                                 nr_completed);
     }
 
     for (auto &entry : qp_depth_set)
@@ -340,6 +549,61 @@ void WorkerPool::performPollCq(int thread_id) {
 
     if (processed_slice_count)
         processed_slice_count_.fetch_add(processed_slice_count);
+    if (completed_bytes) {
+        outstanding_bytes_.fetch_sub(completed_bytes);
+        context_.recordCompletion(completed_bytes);
+    }
+
+    // Freed WR slots let sleeping workers post the slices they hold back
+    if (nr_polled) {
+        for (int i = 0; i < kTransferWorkerCount; ++i)
+            if (i != thread_id && worker_state_[i].waiting.load(
+                                      std::memory_order_relaxed) == kWaitAnyCq)
+                wakeUp(i);
+    }
+    return nr_polled;
+}
+
+int WorkerPool::failover(int thread_id) {
+    SliceList slice_list;
+    uint64_t bytes = 0;
+    for (auto &queue : collective_slice_queue_[thread_id]) {
+        for (auto &entry : queue) {
+            for (auto &slice : entry.second) {
+                slice_list.push_back(slice);
+                bytes += slice->length;
+            }
+            entry.second.clear();
+        }
+    }
+    if (slice_list.empty()) return 0;
+
+    // Account the slices as done here before another pool may complete
+    // them, then take back the ones no other device could take
+    const int total = slice_list.size();
+    outstanding_bytes_.fetch_sub(bytes);
+    processed_slice_count_.fetch_add(total);
+    context_.engine().failoverSlices(context_, slice_list);
+    const int moved = total - slice_list.size();
+    if (!slice_list.empty()) {
+        bytes = 0;
+        for (auto &slice : slice_list) {
+            bytes += slice->length;
+            sliceQueue(thread_id, slice).push_back(slice);
+        }
+        outstanding_bytes_.fetch_add(bytes);
+        submitted_slice_count_.fetch_add(slice_list.size());
+    }
+    if (!moved) return 0;
+
+    failover_slice_count_.fetch_add(moved, std::memory_order_relaxed);
+    int64_t inactive_ts = inactive_ts_.exchange(0);
+    if (inactive_ts)
+        LOG(WARNING) << "Worker: Moved " << moved << " slices off device "
+                     << context_.deviceName() << " in "
+                     << (getCurrentTimeInNano() - inactive_ts) / 1000
+                     << " us after it went down";
+    return moved;
 }
 
 void WorkerPool::redispatch(std::vector<Transport::Slice *> &slice_list,
@@ -356,6 +620,7 @@ void WorkerPool::redispatch(std::vector<Transport::Slice *> &slice_list,
 
     for (auto &slice : slice_list) {
         if (slice->rdma.retry_cnt >= slice->rdma.max_retry_cnt) {
+            outstanding_bytes_.fetch_sub(slice->length);
             slice->markFailed();
             processed_slice_count_++;
         } else {
@@ -366,51 +631,181 @@ void WorkerPool::redispatch(std::vector<Transport::Slice *> &slice_list,
                                             slice->rdma.dest_addr,
                                             slice->length, buffer_id, device_id,
                                             slice->rdma.retry_cnt)) {
+                outstanding_bytes_.fetch_sub(slice->length);
                 slice->markFailed();
                 processed_slice_count_++;
                 continue;
             }
             slice->rdma.dest_rkey =
                 peer_segment_desc->buffers[buffer_id].rkey[device_id];
+            slice->rdma.peer_device_id = device_id;
             auto peer_nic_path =
                 MakeNicPath(peer_segment_desc->name,
                             peer_segment_desc->devices[device_id].name);
             slice->peer_nic_path = peer_nic_path;
-            collective_slice_queue_[thread_id][peer_nic_path].push_back(slice);
+            sliceQueue(thread_id, slice).push_back(slice);
         }
     }
 }
 
 void WorkerPool::transferWorker(int thread_id) {
     bindToSocket(numa_socket_id_);
-    const static uint64_t kWaitPeriodInNano = 100000000;  // 100ms
-    uint64_t last_wait_ts = getCurrentTimeInNano();
+    // Out of work, the worker spins, then yields, then sleeps
+    const uint64_t kSpinPeriodInNano = globalConfig().worker_spin_us * 1000;
+    const uint64_t kYieldPeriodInNano = globalConfig().worker_yield_us * 1000;
+    uint64_t last_work_ts = getCurrentTimeInNano();
     while (workers_running_.load(std::memory_order_relaxed)) {
         auto processed_slice_count =
             processed_slice_count_.load(std::memory_order_relaxed);
         auto submitted_slice_count =
             submitted_slice_count_.load(std::memory_order_relaxed);
-        if (processed_slice_count == submitted_slice_count) {
-            uint64_t curr_wait_ts = getCurrentTimeInNano();
-            if (curr_wait_ts - last_wait_ts > kWaitPeriodInNano) {
-                std::unique_lock<std::mutex> lock(cond_mutex_);
-                suspended_flag_.fetch_add(1);
-                // Double-check condition after acquiring lock to avoid lost
-                // wakeup
-                if (processed_slice_count_.load(std::memory_order_relaxed) ==
-                    submitted_slice_count_.load(std::memory_order_relaxed)) {
-                    cond_var_.wait_for(lock, std::chrono::seconds(1));
-                }
-                suspended_flag_.fetch_sub(1);
-                last_wait_ts = curr_wait_ts;
+        // Notifications may arrive at any time, so the CQs are watched even
+        // without slices in flight
+        bool pending = processed_slice_count != submitted_slice_count ||
+                       context_.notifyEnabled();
+        if (pending) {
+            int progress = performPostSend(thread_id);
+#ifndef USE_FAKE_POST_SEND
+            progress += performPollCq(thread_id);
+#endif
+            if (progress) {
+                last_work_ts = getCurrentTimeInNano();
+                continue;
             }
+        }
+
+        uint64_t idle_time = getCurrentTimeInNano() - last_work_ts;
+        if (idle_time < kSpinPeriodInNano) continue;
+        if (idle_time < kYieldPeriodInNano) {
+            std::this_thread::yield();
             continue;
         }
-        performPostSend(thread_id);
-#ifndef USE_FAKE_POST_SEND
-        performPollCq(thread_id);
-#endif
+
+        auto &state = worker_state_[thread_id];
+        state.sleep_count.fetch_add(1, std::memory_order_relaxed);
+        if (pending) {
+            // Waiting for completions
+            if (waitForCompletion(thread_id))
+                last_work_ts = getCurrentTimeInNano();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(cond_mutex_);
+        suspended_flag_.fetch_add(1);
+        // Double-check condition after acquiring lock to avoid lost
+        // wakeup
+        if (processed_slice_count_.load(std::memory_order_relaxed) ==
+            submitted_slice_count_.load(std::memory_order_relaxed)) {
+            cond_var_.wait_for(lock, std::chrono::seconds(1));
+        }
+        suspended_flag_.fetch_sub(1);
+    }
+}
+
+bool WorkerPool::waitForCompletion(int thread_id) {
+    const static int kWaitTimeoutInMs = 100;
+    auto &state = worker_state_[thread_id];
+    if (state.wakeup_fd < 0) {
+        std::this_thread::yield();
+        return false;
+    }
+
+    // fds[i] watches channels[i], the first one is the wakeup eventfd
+    pollfd fds[1 + context_.cqCount()];
+    ibv_comp_channel *channels[1 + context_.cqCount()];
+    int nfds = 0;
+    fds[nfds++] = {state.wakeup_fd, POLLIN, 0};
+    for (int cq_index = thread_id; cq_index < context_.cqCount();
+         cq_index += kTransferWorkerCount) {
+        if (context_.armCq(cq_index)) {
+            std::this_thread::yield();
+            return false;
+        }
+        auto channel = context_.cqChannel(cq_index);
+        if (std::find(channels + 1, channels + nfds, channel) !=
+            channels + nfds)
+            continue;
+        channels[nfds] = channel;
+        fds[nfds++] = {channel->fd, POLLIN, 0};
+    }
+
+    // Slices held back for lack of WR slots wait for completions on any
+    // CQ, as their QPs may report to CQs of other workers
+    bool backlog = false;
+    for (auto &queue : collective_slice_queue_[thread_id])
+        for (auto &entry : queue) backlog |= !entry.second.empty();
+    state.waiting.store(backlog ? kWaitAnyCq : kWaitOwnCq,
+                        std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Completions and submissions that came before arming raise no event
+    if (performPollCq(thread_id) || !slice_ring_[thread_id]->empty()) {
+        state.waiting.store(kRunning, std::memory_order_relaxed);
+        return true;
+    }
+
+    int ret = poll(fds, nfds, kWaitTimeoutInMs);
+    state.waiting.store(kRunning, std::memory_order_relaxed);
+    if (ret < 0) {
+        if (errno != EINTR) PLOG(ERROR) << "Worker: poll()";
+        return false;
+    }
+
+    uint64_t counter;
+    if (fds[0].revents & POLLIN)
+        while (read(state.wakeup_fd, &counter, sizeof(counter)) > 0);
+
+    for (int i = 1; i < nfds; ++i) {
+        if (!(fds[i].revents & POLLIN)) continue;
+        ibv_cq *cq;
+        void *cq_context;
+        while (!ibv_get_cq_event(channels[i], &cq, &cq_context)) {
+            ibv_ack_cq_events(cq, 1);
+            // Channels may be shared, hand the event to the owner
+            int cq_index = context_.cqIndex(cq);
+            if (cq_index < 0) continue;
+            int owner = cq_index % kTransferWorkerCount;
+            if (owner != thread_id &&
+                worker_state_[owner].waiting.load(std::memory_order_relaxed))
+                wakeUp(owner);
+        }
+    }
+    return false;
+}
+
+void WorkerPool::wakeUp(int thread_id) {
+    uint64_t counter = 1;
+    int fd = worker_state_[thread_id].wakeup_fd;
+    if (fd >= 0 && write(fd, &counter, sizeof(counter)) < 0 &&
+        errno != EAGAIN)
+        PLOG(ERROR) << "Worker: Failed to wake up worker " << thread_id;
+}
+
+void WorkerPool::reportUtilization() {
+    uint64_t current_ts = getCurrentTimeInNano();
+    for (int i = 0; i < kTransferWorkerCount; ++i) {
+        auto &state = worker_state_[i];
+        clockid_t clock_id;
+        timespec ts;
+        if (pthread_getcpuclockid(worker_thread_[i].native_handle(),
+                                  &clock_id) ||
+            clock_gettime(clock_id, &ts))
+            continue;
+        uint64_t cpu_ts = ts.tv_sec * 1000000000ull + ts.tv_nsec;
+        uint64_t sleep_count =
+            state.sleep_count.load(std::memory_order_relaxed);
+        if (last_report_ts_)
+            LOG(INFO) << "Worker: Device " << context_.deviceName()
+                      << " worker " << i << " CPU utilization "
+                      << 100.0 * (cpu_ts - state.last_cpu_ts) /
+                             (current_ts - last_report_ts_)
+                      << "%, slept " << sleep_count - state.last_sleep_count
+                      << " times, " << failover_slice_count_.load()
+                      << " slices failed over in total";
+        state.last_cpu_ts = cpu_ts;
+        state.last_sleep_count = sleep_count;
     }
+    last_report_ts_ = current_ts;
 }
 
 int WorkerPool::doProcessContextEvents() {
@@ -420,18 +815,23 @@ int WorkerPool::doProcessContextEvents() {
                  << ibv_event_type_str(event.event_type) << " for context "
                  << context_.deviceName();
     if (event.event_type == IBV_EVENT_QP_FATAL) {
-        auto endpoint = (RdmaEndPoint *)event.element.qp->qp_context;
-        endpoint->set_active(false);
+        if (!context_.failDcQp(event.element.qp)) {
+            auto endpoint = (RdmaEndPoint *)event.element.qp->qp_context;
+            endpoint->set_active(false);
+        }
     } else if (event.event_type == IBV_EVENT_DEVICE_FATAL ||
                event.event_type == IBV_EVENT_CQ_ERR ||
                event.event_type == IBV_EVENT_WQ_FATAL ||
                event.event_type == IBV_EVENT_PORT_ERR ||
                event.event_type == IBV_EVENT_LID_CHANGE) {
+        int64_t expected = 0;
+        inactive_ts_.compare_exchange_strong(expected, getCurrentTimeInNano());
         context_.set_active(false);
         context_.disconnectAllEndpoints();
         LOG(INFO) << "Worker: Context " << context_.deviceName()
                   << " is now inactive";
     } else if (event.event_type == IBV_EVENT_PORT_ACTIVE) {
+        inactive_ts_.store(0);
         context_.set_active(true);
         LOG(INFO) << "Worker: Context " << context_.deviceName()
                   << " is now active";
@@ -442,13 +842,37 @@ int WorkerPool::doProcessContextEvents() {
 
 void WorkerPool::monitorWorker() {
     bindToSocket(numa_socket_id_);
+    const static int64_t kReportPeriodInNano = 10000000000ll;  // 10s
     auto last_reset_ts = getCurrentTimeInNano();
+    auto last_report_ts = last_reset_ts;
     while (workers_running_) {
         auto current_ts = getCurrentTimeInNano();
         if (current_ts - last_reset_ts > 1000000000ll) {
-            context_.set_active(true);
+            // Give the device another chance, unless its port is down
+            ibv_port_attr port_attr;
+            bool port_active =
+                ibv_query_port(context_.context(), context_.portNum(),
+                               &port_attr) == 0 &&
+                port_attr.state == IBV_PORT_ACTIVE;
+            if (port_active) {
+                inactive_ts_.store(0);
+                context_.set_active(true);
+            } else if (context_.active()) {
+                LOG(WARNING) << "Worker: Port of device "
+                             << context_.deviceName()
+                             << " is not active, mark it inactive";
+                int64_t expected = 0;
+                inactive_ts_.compare_exchange_strong(expected, current_ts);
+                context_.set_active(false);
+            }
+            context_.recoverDcInitiators();
             last_reset_ts = current_ts;
         }
+        if (globalConfig().trace &&
+            current_ts - last_report_ts > kReportPeriodInNano) {
+            reportUtilization();
+            last_report_ts = current_ts;
+        }
         struct epoll_event event;
         int num_events = epoll_wait(context_.eventFd(), &event, 1, 100);
         if (num_events < 0) {
@@ -19,13 +19,19 @@
 #include <asio/ip/v6_only.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <random>
+#include <thread>
+#include <vector>
 
 #include "common.h"
+#include "config.h"
 #include "transfer_engine.h"
 #include "transfer_metadata.h"
 #include "transfer_metadata_plugin.h"
@@ -35,13 +41,19 @@
 
 namespace mooncake {
 using tcpsocket = asio::ip::tcp::socket;
-const static size_t kDefaultBufferSize = 65536;
+// GPU memory is sent and received through pinned host buffers of this size
+const static size_t kStagingBufferSize = 1 << 20;
 
 struct SessionHeader {
     uint64_t size;
     uint64_t addr;
     uint8_t opcode;
+    uint8_t reserved[3];
+    // Numbers the requests pipelined on a pooled connection. It lives in
+    // what used to be padding, so the header layout is unchanged.
+    uint32_t request_id;
 };
+static_assert(sizeof(SessionHeader) == 24, "SessionHeader is on the wire");
 
 #if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
 static bool isCudaMemory(void *addr) {
@@ -51,6 +63,45 @@ static bool isCudaMemory(void *addr) {
     if (attributes.type == cudaMemoryTypeDevice) return true;
     return false;
 }
+
+// Pinned staging buffers, reused across transfers rather than allocated per
+// chunk. They are kept for the lifetime of the process.
+class StagingPool {
+   public:
+    static StagingPool &instance() {
+        static StagingPool pool;
+        return pool;
+    }
+
+    // Returns nullptr if no buffer can be allocated
+    char *acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                char *buffer = free_.back();
+                free_.pop_back();
+                return buffer;
+            }
+        }
+        void *buffer = nullptr;
+        if (cudaMallocHost(&buffer, kStagingBufferSize) != cudaSuccess) {
+            return nullptr;
+        }
+        return static_cast<char *>(buffer);
+    }
+
+    void release(char *buffer) {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(buffer);
+    }
+
+   private:
+    std::mutex mutex_;
+    std::vector<char *> free_;
+};
+#else
+static bool isCudaMemory(void *) { return false; }
 #endif
 
 struct Session : public std::enable_shared_from_this<Session> {
@@ -61,12 +112,16 @@ struct Session : public std::enable_shared_from_this<Session> {
     uint64_t total_transferred_bytes_;
     char *local_buffer_;
     std::function<void(TransferStatusEnum)> on_finalize_;
-    std::mutex session_mutex_;
+    // Set while a request is in flight. It is cleared by the completion
+    // handler, which may run on another io thread than the one that set it,
+    // so it is not a mutex.
+    std::atomic<bool> busy_{false};
 
     void initiate(void *buffer, uint64_t dest_addr, size_t size,
                   TransferRequest::OpCode opcode) {
-        session_mutex_.lock();
+        markBusy();
         local_buffer_ = (char *)buffer;
+        header_ = SessionHeader{};
         header_.addr = htole64(dest_addr);
         header_.size = htole64(size);
         header_.opcode = (uint8_t)opcode;
@@ -74,13 +129,32 @@ struct Session : public std::enable_shared_from_this<Session> {
         writeHeader();
     }
 
+    // Serves the requests of the connection one after another, until the
+    // peer closes it
     void onAccept() {
-        session_mutex_.lock();
+        markBusy();
+        accepted_ = true;
         total_transferred_bytes_ = 0;
         readHeader();
     }
 
    private:
+    bool accepted_ = false;
+
+    void markBusy() {
+        while (busy_.exchange(true, std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void markIdle() { busy_.store(false, std::memory_order_release); }
+
+    void finalize(TransferStatusEnum status) {
+        if (on_finalize_) on_finalize_(status);
+        markIdle();
+        if (accepted_ && status == TransferStatusEnum::COMPLETED) onAccept();
+    }
+
     void writeHeader() {
         // LOG(INFO) << "writeHeader";
         auto self(shared_from_this());
@@ -93,7 +167,7 @@ struct Session : public std::enable_shared_from_this<Session> {
                                << ")" << ", bytes written: " << len
                                << ", expected: " << sizeof(SessionHeader);
                     if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
-                    session_mutex_.unlock();
+                    markIdle();
                     return;
                 }
                 if (header_.opcode == (uint8_t)TransferRequest::WRITE)
@@ -109,6 +183,11 @@ struct Session : public std::enable_shared_from_this<Session> {
         asio::async_read(
             socket_, asio::buffer(&header_, sizeof(SessionHeader)),
             [this, self](const asio::error_code &ec, std::size_t len) {
+                if (ec == asio::error::eof && len == 0) {
+                    // The peer is done with the connection
+                    markIdle();
+                    return;
+                }
                 if (ec || len != sizeof(SessionHeader)) {
                     LOG(ERROR)
                         << "Session::readHeader failed. Error: " << ec.message()
@@ -116,7 +195,7 @@ struct Session : public std::enable_shared_from_this<Session> {
                         << ", bytes read: " << len
                         << ", expected: " << sizeof(SessionHeader);
                     if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
-                    session_mutex_.unlock();
+                    markIdle();
                     return;
                 }
 
@@ -134,42 +213,43 @@ struct Session : public std::enable_shared_from_this<Session> {
         uint64_t size = le64toh(header_.size);
         char *addr = local_buffer_;
 
-        size_t buffer_size =
-            std::min(kDefaultBufferSize, size - total_transferred_bytes_);
+        size_t buffer_size = size - total_transferred_bytes_;
         if (buffer_size == 0) {
-            if (on_finalize_) on_finalize_(TransferStatusEnum::COMPLETED);
-            session_mutex_.unlock();
+            finalize(TransferStatusEnum::COMPLETED);
             return;
         }
 
+        // Host memory is sent from where it is, GPU memory one staging
+        // buffer at a time
         char *dram_buffer = addr + total_transferred_bytes_;
-
+        char *staging = nullptr;
 #if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
         if (isCudaMemory(addr)) {
-            dram_buffer = new char[buffer_size];
+            buffer_size = std::min(kStagingBufferSize, buffer_size);
+            staging = StagingPool::instance().acquire();
             cudaError_t cuda_status =
-                cudaMemcpy(dram_buffer, addr + total_transferred_bytes_,
-                           buffer_size, cudaMemcpyDefault);
+                staging ? cudaMemcpy(staging, dram_buffer, buffer_size,
+                                     cudaMemcpyDefault)
+                        : cudaErrorMemoryAllocation;
             if (cuda_status != cudaSuccess) {
                 LOG(ERROR)
                     << "Session::writeBody failed to copy from CUDA memory. "
                     << "Error: " << cudaGetErrorString(cuda_status);
                 if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
-                session_mutex_.unlock();
-                delete[] dram_buffer;
+                markIdle();
+                StagingPool::instance().release(staging);
                 return;
             }
+            dram_buffer = staging;
         }
 #endif
 
         asio::async_write(
             socket_, asio::buffer(dram_buffer, buffer_size),
-            [this, addr, dram_buffer, self](const asio::error_code &ec,
-                                            std::size_t transferred_bytes) {
+            [this, addr, dram_buffer, staging, self](
+                const asio::error_code &ec, std::size_t transferred_bytes) {
 #if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
-                if (isCudaMemory(addr)) {
-                    delete[] dram_buffer;
-                }
+                StagingPool::instance().release(staging);
 #endif
                 if (ec) {
                     LOG(ERROR)
@@ -178,11 +258,12 @@ struct Session : public std::enable_shared_from_this<Session> {
                         << " using buffer " << static_cast<void *>(dram_buffer)
                         << ". Error: " << ec.message()
                         << " (value: " << ec.value() << ")"
+                        << ", request_id: " << le32toh(header_.request_id)
                         << ", total_transferred_bytes_: "
                         << total_transferred_bytes_
                         << ", current transferred_bytes: " << transferred_bytes;
                     if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
-                    session_mutex_.unlock();
+                    markIdle();
                     return;
                 }
                 total_transferred_bytes_ += transferred_bytes;
@@ -196,28 +277,34 @@ struct Session : public std::enable_shared_from_this<Session> {
         uint64_t size = le64toh(header_.size);
         char *addr = local_buffer_;
 
-        size_t buffer_size =
-            std::min(kDefaultBufferSize, size - total_transferred_bytes_);
+        size_t buffer_size = size - total_transferred_bytes_;
         if (buffer_size == 0) {
-            if (on_finalize_) on_finalize_(TransferStatusEnum::COMPLETED);
-            session_mutex_.unlock();
+            finalize(TransferStatusEnum::COMPLETED);
             return;
         }
 
+        // Host memory is received where it belongs, GPU memory one staging
+        // buffer at a time
         char *dram_buffer = addr + total_transferred_bytes_;
-
+        char *staging = nullptr;
 #if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
-        bool is_cuda_memory = isCudaMemory(addr);
-        if (is_cuda_memory) {
-            dram_buffer = new char[buffer_size];
+        if (isCudaMemory(addr)) {
+            buffer_size = std::min(kStagingBufferSize, buffer_size);
+            staging = StagingPool::instance().acquire();
+            if (!staging) {
+                LOG(ERROR) << "Session::readBody failed to allocate a "
+                              "staging buffer";
+                if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
+                markIdle();
+                return;
+            }
+            dram_buffer = staging;
         }
-#else
-        bool is_cuda_memory = false;
 #endif
 
         asio::async_read(
             socket_, asio::buffer(dram_buffer, buffer_size),
-            [this, addr, dram_buffer, is_cuda_memory, self](
+            [this, addr, dram_buffer, staging, self](
                 const asio::error_code &ec, std::size_t transferred_bytes) {
                 if (ec) {
                     LOG(ERROR)
@@ -226,22 +313,24 @@ struct Session : public std::enable_shared_from_this<Session> {
                         << " using buffer " << static_cast<void *>(dram_buffer)
                         << ". Error: " << ec.message()
                         << " (value: " << ec.value() << ")"
+                        << ", request_id: " << le32toh(header_.request_id)
                         << ", total_transferred_bytes_: "
                         << total_transferred_bytes_
                         << ", current transferred_bytes: " << transferred_bytes;
                     if (on_finalize_) on_finalize_(TransferStatusEnum::FAILED);
 #if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
-                    if (is_cuda_memory) delete[] dram_buffer;
+                    StagingPool::instance().release(staging);
 #endif
-                    session_mutex_.unlock();
+                    markIdle();
                     return;
                 }
 
 #if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
-                if (is_cuda_memory) {
+                if (staging) {
                     cudaError_t cuda_status =
-                        cudaMemcpy(addr + total_transferred_bytes_, dram_buffer,
+                        cudaMemcpy(addr + total_transferred_bytes_, staging,
                                    transferred_bytes, cudaMemcpyDefault);
+                    StagingPool::instance().release(staging);
                     if (cuda_status != cudaSuccess) {
                         LOG(ERROR)
                             << "Session::readBody failed to copy to CUDA "
@@ -249,11 +338,9 @@ struct Session : public std::enable_shared_from_this<Session> {
                             << "Error: " << cudaGetErrorString(cuda_status);
                         if (on_finalize_)
                             on_finalize_(TransferStatusEnum::FAILED);
-                        delete[] dram_buffer;
-                        session_mutex_.unlock();
+                        markIdle();
                         return;
                     }
-                    delete[] dram_buffer;
                 }
 #endif
                 total_transferred_bytes_ += transferred_bytes;
@@ -262,6 +349,267 @@ struct Session : public std::enable_shared_from_this<Session> {
     }
 };
 
+// A persistent connection to a peer, on which requests are pipelined: the
+// header (and data) of a request is sent without waiting for the data of
+// the previous reads to come back. The peer serves the requests in order,
+// so the data read back is matched to the requests in the order they were
+// sent.
+class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
+   public:
+    explicit TcpConnection(tcpsocket socket) : socket_(std::move(socket)) {}
+
+    bool broken() const { return broken_.load(std::memory_order_acquire); }
+
+    size_t outstanding() const {
+        return outstanding_.load(std::memory_order_relaxed);
+    }
+
+    void submit(Transport::Slice *slice) {
+        auto request = std::make_unique<Request>();
+        request->slice = slice;
+        request->header.addr = htole64(slice->tcp.dest_addr);
+        request->header.size = htole64(slice->length);
+        request->header.opcode = (uint8_t)slice->opcode;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (broken()) {
+                slice->markFailed();
+                return;
+            }
+            request->header.request_id = htole32(next_request_id_++);
+            outstanding_.fetch_add(1, std::memory_order_relaxed);
+            write_queue_.push_back(std::move(request));
+            if (writing_) return;
+            writing_ = true;
+        }
+        asio::post(socket_.get_executor(),
+                   [self = shared_from_this()]() { self->writeNext(); });
+    }
+
+   private:
+    struct Request {
+        SessionHeader header{};
+        Transport::Slice *slice = nullptr;
+        uint64_t done = 0;
+    };
+
+    // All the following runs on the strand of the socket, where the write
+    // and read chains interleave. A handler that runs after the connection
+    // broke must not touch its request, which fail() has already completed.
+
+    void writeNext() {
+        Request *request;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (broken() || write_queue_.empty()) {
+                writing_ = false;
+                return;
+            }
+            request = write_queue_.front().get();
+        }
+        auto self(shared_from_this());
+        if (request->header.opcode == (uint8_t)TransferRequest::WRITE &&
+            !isCudaMemory(request->slice->source_addr)) {
+            // Header and data leave in one gathered send, straight from the
+            // source buffer
+            std::array<asio::const_buffer, 2> buffers = {
+                asio::buffer(&request->header, sizeof(SessionHeader)),
+                asio::buffer(request->slice->source_addr,
+                             request->slice->length)};
+            asio::async_write(
+                socket_, buffers,
+                [this, self](const asio::error_code &ec, std::size_t) {
+                    if (broken()) return;
+                    if (ec) {
+                        fail("write", ec);
+                        return;
+                    }
+                    complete(write_queue_);
+                    writeNext();
+                });
+            return;
+        }
+        asio::async_write(
+            socket_, asio::buffer(&request->header, sizeof(SessionHeader)),
+            [this, self, request](const asio::error_code &ec, std::size_t) {
+                if (broken()) return;
+                if (ec) {
+                    fail("write header", ec);
+                    return;
+                }
+                if (request->header.opcode == (uint8_t)TransferRequest::WRITE) {
+                    writeBody(request);
+                    return;
+                }
+                bool start_reading;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    read_queue_.push_back(std::move(write_queue_.front()));
+                    write_queue_.pop_front();
+                    start_reading = !reading_;
+                    reading_ = true;
+                }
+                if (start_reading) readNext();
+                writeNext();
+            });
+    }
+
+    // Sends the data of a WRITE from GPU memory, one staging buffer at a time
+    void writeBody(Request *request) {
+        size_t buffer_size = std::min(
+            kStagingBufferSize, request->slice->length - request->done);
+        if (buffer_size == 0) {
+            complete(write_queue_);
+            writeNext();
+            return;
+        }
+
+        char *staging = nullptr;
+#if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
+        staging = StagingPool::instance().acquire();
+        if (!staging ||
+            cudaMemcpy(staging,
+                       static_cast<char *>(request->slice->source_addr) +
+                           request->done,
+                       buffer_size, cudaMemcpyDefault) != cudaSuccess) {
+            StagingPool::instance().release(staging);
+            fail("copy from CUDA memory", asio::error_code());
+            return;
+        }
+#endif
+        auto self(shared_from_this());
+        asio::async_write(
+            socket_, asio::buffer(staging, buffer_size),
+            [this, self, request, staging](const asio::error_code &ec,
+                                           std::size_t transferred_bytes) {
+#if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
+                StagingPool::instance().release(staging);
+#else
+                (void)staging;
+#endif
+                if (broken()) return;
+                if (ec) {
+                    fail("write body", ec);
+                    return;
+                }
+                request->done += transferred_bytes;
+                writeBody(request);
+            });
+    }
+
+    void readNext() {
+        Request *request;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (broken() || read_queue_.empty()) {
+                reading_ = false;
+                return;
+            }
+            request = read_queue_.front().get();
+        }
+        readBody(request);
+    }
+
+    // Receives the data of a READ into host memory directly, and into GPU
+    // memory one staging buffer at a time
+    void readBody(Request *request) {
+        char *addr = static_cast<char *>(request->slice->source_addr);
+        size_t buffer_size = request->slice->length - request->done;
+        if (buffer_size == 0) {
+            complete(read_queue_);
+            readNext();
+            return;
+        }
+
+        char *dram_buffer = addr + request->done;
+        char *staging = nullptr;
+#if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
+        if (isCudaMemory(addr)) {
+            buffer_size = std::min(kStagingBufferSize, buffer_size);
+            staging = StagingPool::instance().acquire();
+            if (!staging) {
+                fail("allocate a staging buffer", asio::error_code());
+                return;
+            }
+            dram_buffer = staging;
+        }
+#endif
+        auto self(shared_from_this());
+        asio::async_read(
+            socket_, asio::buffer(dram_buffer, buffer_size),
+            [this, self, request, addr, staging](
+                const asio::error_code &ec, std::size_t transferred_bytes) {
+                bool copied = true;
+#if defined(USE_CUDA) || defined(USE_MUSA) || defined(USE_HIP)
+                if (staging) {
+                    copied = ec || broken() ||
+                             cudaMemcpy(addr + request->done, staging,
+                                        transferred_bytes,
+                                        cudaMemcpyDefault) == cudaSuccess;
+                    StagingPool::instance().release(staging);
+                }
+#else
+                (void)addr;
+                (void)staging;
+#endif
+                if (broken()) return;
+                if (ec || !copied) {
+                    fail(copied ? "read body" : "copy to CUDA memory", ec);
+                    return;
+                }
+                request->done += transferred_bytes;
+                readBody(request);
+            });
+    }
+
+    void complete(std::deque<std::unique_ptr<Request>> &queue) {
+        std::unique_ptr<Request> request;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            request = std::move(queue.front());
+            queue.pop_front();
+        }
+        outstanding_.fetch_sub(1, std::memory_order_relaxed);
+        request->slice->markSuccess();
+    }
+
+    // Fails every request of the connection, which is not used again
+    void fail(const char *stage, const asio::error_code &ec) {
+        std::deque<std::unique_ptr<Request>> failed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            broken_.store(true, std::memory_order_release);
+            failed = std::move(read_queue_);
+            for (auto &request : write_queue_) {
+                failed.push_back(std::move(request));
+            }
+            write_queue_.clear();
+            read_queue_.clear();
+        }
+        LOG(ERROR) << "TcpConnection failed to " << stage
+                   << ". Error: " << ec.message() << " (value: " << ec.value()
+                   << "), failing " << failed.size() << " requests";
+        for (auto &request : failed) {
+            outstanding_.fetch_sub(1, std::memory_order_relaxed);
+            request->slice->markFailed();
+        }
+        asio::error_code ignored;
+        socket_.close(ignored);
+    }
+
+    tcpsocket socket_;
+    std::mutex mutex_;
+    std::atomic<bool> broken_{false};
+    std::atomic<size_t> outstanding_{0};
+    uint32_t next_request_id_ = 0;
+    // Requests whose header or data is still to be sent
+    std::deque<std::unique_ptr<Request>> write_queue_;
+    // Reads sent, whose data is still to come back
+    std::deque<std::unique_ptr<Request>> read_queue_;
+    bool writing_ = false;
+    bool reading_ = false;
+};
+
 struct TcpContext {
     TcpContext(short port) : acceptor(io_context) {
         std::error_code ec;
@@ -290,11 +638,18 @@ struct TcpContext {
         acceptor.listen();
     }
 
+    // Each connection gets a strand, as several threads run the io_context
     void doAccept() {
-        acceptor.async_accept([this](asio::error_code ec, tcpsocket socket) {
-            if (!ec) std::make_shared<Session>(std::move(socket))->onAccept();
-            doAccept();
-        });
+        acceptor.async_accept(
+            asio::make_strand(io_context),
+            [this](asio::error_code ec, tcpsocket socket) {
+                // Accept the next one first, so that an exception thrown by
+                // this one does not stop accepting
+                doAccept();
+                if (!ec) {
+                    std::make_shared<Session>(std::move(socket))->onAccept();
+                }
+            });
     }
 
     asio::io_context io_context;
@@ -309,9 +664,12 @@ TcpTransport::~TcpTransport() {
     if (running_) {
         running_ = false;
         context_->io_context.stop();
-        thread_.join();
+        for (auto &thread : threads_) thread.join();
     }
 
+    // The sockets must go before their io_context
+    connections_.clear();
+
     if (context_) {
         delete context_;
         context_ = nullptr;
@@ -339,16 +697,22 @@ int TcpTransport::install(std::string &local_server_name,
         return -1;
     }
 
+    // Installed as the fallback of RdmaTransport, which serves the
+    // handshakes already
+    const bool fallback = metadata_->getSegmentDescByID(LOCAL_SEGMENT_ID) !=
+                          nullptr;
     int ret = allocateLocalSegmentID(tcp_port);
     if (ret) {
         LOG(ERROR) << "TcpTransport: cannot allocate local segment";
         return -1;
     }
 
-    ret = startHandshakeDaemon();
-    if (ret) {
-        LOG(ERROR) << "TcpTransport: cannot start handshake daemon";
-        return -1;
+    if (!fallback) {
+        ret = startHandshakeDaemon();
+        if (ret) {
+            LOG(ERROR) << "TcpTransport: cannot start handshake daemon";
+            return -1;
+        }
     }
 
     ret = metadata_->updateLocalSegmentDesc();
@@ -361,17 +725,32 @@ int TcpTransport::install(std::string &local_server_name,
     close(sockfd);  // the above function has opened a socket
     LOG(INFO) << "TcpTransport: listen on port " << tcp_port;
     context_ = new TcpContext(tcp_port);
+    context_->doAccept();
     running_ = true;
-    thread_ = std::thread(&TcpTransport::worker, this);
+    for (size_t i = 0; i < globalConfig().tcp_io_threads; ++i) {
+        threads_.emplace_back(&TcpTransport::worker, this);
+    }
     return 0;
 }
 
 int TcpTransport::allocateLocalSegmentID(int tcp_data_port) {
     auto desc = std::make_shared<SegmentDesc>();
     if (!desc) return ERR_MEMORY;
+    // As the fallback of RdmaTransport, the segment stays an RDMA segment
+    // that also listens for TCP transfers
+    auto local_desc = metadata_->getSegmentDescByID(LOCAL_SEGMENT_ID);
+    if (local_desc) {
+        *desc = *local_desc;
+        desc->tcp_data_port = tcp_data_port;
+        desc->tcp_persistent = true;
+        metadata_->addLocalSegment(LOCAL_SEGMENT_ID, local_server_name_,
+                                   std::move(desc));
+        return 0;
+    }
     desc->name = local_server_name_;
     desc->protocol = "tcp";
     desc->tcp_data_port = tcp_data_port;
+    desc->tcp_persistent = true;
     metadata_->addLocalSegment(LOCAL_SEGMENT_ID, local_server_name_,
                                std::move(desc));
     return 0;
@@ -445,24 +824,13 @@ Status TcpTransport::submitTransfer(
     }
 
     size_t task_id = batch_desc.task_list.size();
-    batch_desc.task_list.resize(task_id + entries.size());
+    batch_desc.addTasks(entries.size());
 
     for (auto &request : entries) {
         TransferTask &task = batch_desc.task_list[task_id];
         ++task_id;
         task.total_bytes = request.length;
-        Slice *slice = getSliceCache().allocate();
-        slice->source_addr = (char *)request.source;
-        slice->length = request.length;
-        slice->opcode = request.opcode;
-        slice->tcp.dest_addr = request.target_offset;
-        slice->task = &task;
-        slice->target_id = request.target_id;
-        slice->status = Slice::PENDING;
-        slice->ts = 0;
-        task.slice_list.push_back(slice);
-        __sync_fetch_and_add(&task.slice_count, 1);
-        startTransfer(slice);
+        submitSlices(task, request);
     }
 
     return Status::OK();
@@ -476,30 +844,49 @@ Status TcpTransport::submitTransferTask(
         assert(task.request);
         auto &request = *task.request;
         task.total_bytes = request.length;
+        submitSlices(task, request);
+    }
+    return Status::OK();
+}
+
+void TcpTransport::submitSlices(TransferTask &task,
+                                const TransferRequest &request) {
+    const uint64_t stripe_size = globalConfig().tcp_stripe_size;
+    std::vector<Slice *> slices;
+    uint64_t offset = 0;
+    do {
+        uint64_t length = request.length - offset;
+        if (stripe_size > 0) length = std::min(length, stripe_size);
         Slice *slice = getSliceCache().allocate();
-        slice->source_addr = (char *)request.source;
-        slice->length = request.length;
+        slice->source_addr = (char *)request.source + offset;
+        slice->length = length;
         slice->opcode = request.opcode;
-        slice->tcp.dest_addr = request.target_offset;
+        slice->tcp.dest_addr = request.target_offset + offset;
         slice->task = &task;
         slice->target_id = request.target_id;
         slice->status = Slice::PENDING;
         slice->ts = 0;
-        task.slice_list.push_back(slice);
-        __sync_fetch_and_add(&task.slice_count, 1);
-        startTransfer(slice);
-    }
-    return Status::OK();
+        slices.push_back(slice);
+        offset += length;
+    } while (offset < request.length);
+
+    // Every slice is counted before the first one can complete
+    task.slice_list.insert(task.slice_list.end(), slices.begin(),
+                           slices.end());
+    __sync_fetch_and_add(&task.slice_count, slices.size());
+    for (auto slice : slices) startTransfer(slice);
 }
 
 void TcpTransport::worker() {
+    if (globalConfig().tcp_numa_node >= 0) {
+        bindToSocket(globalConfig().tcp_numa_node);
+    }
     while (running_) {
         try {
-            context_->doAccept();
             context_->io_context.run();
         } catch (std::exception &e) {
             LOG(ERROR) << "TcpTransport::worker encountered an exception "
-                          "during doAccept/run: "
+                          "during run: "
                        << e.what();
         }
     }
@@ -508,7 +895,7 @@ void TcpTransport::worker() {
 void TcpTransport::startTransfer(Slice *slice) {
     try {
         asio::ip::tcp::resolver resolver(context_->io_context);
-        asio::ip::tcp::socket socket(context_->io_context);
+        asio::ip::tcp::socket socket(asio::make_strand(context_->io_context));
         auto desc = metadata_->getSegmentDescByID(slice->target_id);
         if (!desc) {
             LOG(ERROR) << "TcpTransport::startTransfer failed to get segment "
@@ -526,6 +913,18 @@ void TcpTransport::startTransfer(Slice *slice) {
             slice->markFailed();
             return;
         }
+        if (desc->tcp_persistent &&
+            globalConfig().tcp_connections_per_peer > 0) {
+            auto connection =
+                getConnection(meta_entry.ip_or_host_name, desc->tcp_data_port);
+            if (!connection) {
+                slice->markFailed();
+                return;
+            }
+            connection->submit(slice);
+            return;
+        }
+
         auto endpoint_iterator = resolver.resolve(
             meta_entry.ip_or_host_name, std::to_string(desc->tcp_data_port));
         asio::connect(socket, endpoint_iterator);
@@ -548,4 +947,40 @@ void TcpTransport::startTransfer(Slice *slice) {
         slice->markFailed();
     }
 }
+
+std::shared_ptr<TcpConnection> TcpTransport::getConnection(
+    const std::string &host, int port) {
+    const std::string key = host + ":" + std::to_string(port);
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        auto &pool = connections_[key];
+        pool.erase(std::remove_if(pool.begin(), pool.end(),
+                                  [](const auto &connection) {
+                                      return connection->broken();
+                                  }),
+                   pool.end());
+        if (pool.size() >= globalConfig().tcp_connections_per_peer) {
+            return *std::min_element(
+                pool.begin(), pool.end(), [](const auto &a, const auto &b) {
+                    return a->outstanding() < b->outstanding();
+                });
+        }
+    }
+
+    try {
+        asio::ip::tcp::resolver resolver(context_->io_context);
+        asio::ip::tcp::socket socket(asio::make_strand(context_->io_context));
+        asio::connect(socket, resolver.resolve(host, std::to_string(port)));
+        // Headers of pipelined requests must not wait for the previous data
+        socket.set_option(asio::ip::tcp::no_delay(true));
+        auto connection = std::make_shared<TcpConnection>(std::move(socket));
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_[key].push_back(connection);
+        return connection;
+    } catch (std::exception &e) {
+        LOG(ERROR) << "TcpTransport::getConnection failed to connect to "
+                   << key << ". Exception: " << e.what();
+        return nullptr;
+    }
+}
 }  // namespace mooncake
@@ -14,6 +14,12 @@
 
 #include "transport/transport.h"
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+
 #include "error.h"
 #include "transfer_engine.h"
 
@@ -25,12 +31,8 @@ Transport::ThreadLocalSliceCache &Transport::getSliceCache() {
 }
 
 Transport::BatchID Transport::allocateBatchID(size_t batch_size) {
-    auto batch_desc = new BatchDesc();
+    auto batch_desc = acquireBatchDesc(batch_size);
     if (!batch_desc) return ERR_MEMORY;
-    batch_desc->id = BatchID(batch_desc);
-    batch_desc->batch_size = batch_size;
-    batch_desc->task_list.reserve(batch_size);
-    batch_desc->context = NULL;
 #ifdef CONFIG_USE_BATCH_DESC_SET
     batch_desc_lock_.lock();
     batch_desc_set_[batch_desc->id] = batch_desc;
@@ -49,7 +51,7 @@ Status Transport::freeBatchID(BatchID batch_id) {
                 "BatchID cannot be freed until all tasks are done");
         }
     }
-    delete &batch_desc;
+    releaseBatchDesc(&batch_desc);
 #ifdef CONFIG_USE_BATCH_DESC_SET
     RWSpinlock::WriteGuard guard(batch_desc_lock_);
     batch_desc_set_.erase(batch_id);
@@ -57,6 +59,180 @@ Status Transport::freeBatchID(BatchID batch_id) {
     return Status::OK();
 }
 
+// Every task is finished, so its slices published their status, but the last
+// of them may still be notifying
+static void waitForSettledSlices(Transport::BatchDesc &batch_desc) {
+    for (auto &task : batch_desc.task_list) {
+        while (__atomic_load_n(&task.settled_slice_count, __ATOMIC_ACQUIRE) <
+               task.success_slice_count + task.failed_slice_count)
+            std::this_thread::yield();
+    }
+}
+
+Transport::BatchDesc::~BatchDesc() {
+    waitForSettledSlices(*this);
+    if (completion_fd >= 0) close(completion_fd);
+}
+
+void Transport::BatchDesc::addTasks(size_t count) {
+    size_t task_id = task_list.size();
+    task_list.resize(task_id + count);
+    for (; task_id < task_list.size() && !spare_slice_lists.empty();
+         ++task_id) {
+        task_list[task_id].slice_list.swap(spare_slice_lists.back());
+        spare_slice_lists.pop_back();
+    }
+}
+
+void Transport::BatchDesc::reset() {
+    waitForSettledSlices(*this);
+    for (auto &task : task_list) {
+        for (auto slice : task.slice_list) getSliceCache().deallocate(slice);
+        task.slice_list.clear();
+        spare_slice_lists.push_back(std::move(task.slice_list));
+    }
+    task_list.clear();
+    context = NULL;
+    has_failure.store(false, std::memory_order_relaxed);
+    is_finished.store(false, std::memory_order_relaxed);
+    finished_transfer_bytes.store(0, std::memory_order_relaxed);
+    finished_task_count.store(0, std::memory_order_relaxed);
+    completion_notified = false;
+    completion_callback = nullptr;
+    completion_waiters.clear();
+    if (completion_fd >= 0) {
+        close(completion_fd);
+        completion_fd = -1;
+    }
+}
+
+namespace {
+// Batches kept for reuse, and the largest of them
+const size_t kMaxPooledBatches = 1024;
+const size_t kMaxPooledBatchSize = 4096;
+
+struct BatchDescPool {
+    BatchDescPool() { free_list.reserve(kMaxPooledBatches); }
+    std::mutex mutex;
+    std::vector<Transport::BatchDesc *> free_list;
+};
+
+// Never destroyed, as batches may still be freed during exit
+BatchDescPool &batchDescPool() {
+    static auto *pool = new BatchDescPool();
+    return *pool;
+}
+}  // namespace
+
+Transport::BatchDesc *Transport::acquireBatchDesc(size_t batch_size) {
+    BatchDesc *batch_desc = nullptr;
+    {
+        auto &pool = batchDescPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (!pool.free_list.empty()) {
+            batch_desc = pool.free_list.back();
+            pool.free_list.pop_back();
+        }
+    }
+    if (!batch_desc) batch_desc = new BatchDesc();
+    batch_desc->id = BatchID(batch_desc);
+    batch_desc->batch_size = batch_size;
+    batch_desc->task_list.reserve(batch_size);
+    batch_desc->context = NULL;
+    return batch_desc;
+}
+
+void Transport::releaseBatchDesc(BatchDesc *batch_desc) {
+    if (batch_desc->task_list.capacity() <= kMaxPooledBatchSize) {
+        batch_desc->reset();
+        auto &pool = batchDescPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.free_list.size() < kMaxPooledBatches) {
+            pool.free_list.push_back(batch_desc);
+            return;
+        }
+    }
+    delete batch_desc;
+}
+
+static void signalCompletionFd(int fd) {
+    uint64_t value = 1;
+    if (write(fd, &value, sizeof(value)) < 0)
+        PLOG(WARNING) << "Failed to signal batch completion";
+}
+
+static void notifyCompletionWaiter(Transport::CompletionWaiter &waiter) {
+    {
+        std::lock_guard<std::mutex> lock(waiter.mutex);
+        waiter.notified = true;
+    }
+    waiter.cv.notify_one();
+}
+
+bool Transport::notifyBatchCompletion(BatchDesc &batch_desc,
+                                      BatchCompletionCallback &callback) {
+    // Waiters remove themselves under the mutex before going away, so they
+    // are notified under it too
+    std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+    batch_desc.completion_notified = true;
+    if (batch_desc.completion_fd >= 0)
+        signalCompletionFd(batch_desc.completion_fd);
+    for (auto waiter : batch_desc.completion_waiters)
+        notifyCompletionWaiter(*waiter);
+    callback = std::move(batch_desc.completion_callback);
+    batch_desc.completion_callback = nullptr;
+    return batch_desc.has_failure.load(std::memory_order_relaxed);
+}
+
+int Transport::getBatchCompletionFd(BatchID batch_id) {
+    auto &batch_desc = toBatchDesc(batch_id);
+    std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+    if (batch_desc.completion_fd < 0) {
+        int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (fd < 0) {
+            PLOG(ERROR) << "Failed to create eventfd";
+            return ERR_CONTEXT;
+        }
+        batch_desc.completion_fd = fd;
+        if (batch_desc.completion_notified) signalCompletionFd(fd);
+    }
+    return batch_desc.completion_fd;
+}
+
+Status Transport::setBatchCompletionCallback(
+    BatchID batch_id, BatchCompletionCallback callback) {
+    auto &batch_desc = toBatchDesc(batch_id);
+    {
+        std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+        if (!batch_desc.completion_notified) {
+            batch_desc.completion_callback = std::move(callback);
+            return Status::OK();
+        }
+    }
+    if (callback) {
+        callback(batch_id,
+                 batch_desc.has_failure.load(std::memory_order_relaxed));
+    }
+    return Status::OK();
+}
+
+void Transport::addCompletionWaiter(BatchID batch_id,
+                                    CompletionWaiter *waiter) {
+    auto &batch_desc = toBatchDesc(batch_id);
+    std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+    batch_desc.completion_waiters.push_back(waiter);
+    if (batch_desc.completion_notified) notifyCompletionWaiter(*waiter);
+}
+
+void Transport::removeCompletionWaiter(BatchID batch_id,
+                                       CompletionWaiter *waiter) {
+    auto &batch_desc = toBatchDesc(batch_id);
+    std::lock_guard<std::mutex> lock(batch_desc.completion_mutex);
+    auto &waiters = batch_desc.completion_waiters;
+    waiters.erase(std::remove(waiters.begin(), waiters.end(), waiter),
+                  waiters.end());
+}
+
 int Transport::install(std::string &local_server_name,
                        std::shared_ptr<TransferMetadata> meta,
                        std::shared_ptr<Topology> topo) {
@@ -37,6 +37,12 @@ struct Notification {
 #define LOCAL_SEGMENT_ID (0ull)
 #endif
 
+// Traffic classes of the processes sharing the NICs of a node. The latency
+// critical class has strict priority; the others split the remaining
+// bandwidth by weight when the NICs are saturated.
+enum TrafficClass { kLatencyCritical = 0, kBulk, kBackground };
+const static int kNumTrafficClasses = 3;
+
 struct Request {
     enum OpCode { READ, WRITE };
     OpCode opcode;
@@ -44,6 +50,7 @@ struct Request {
     SegmentID target_id;
     uint64_t target_offset;
     size_t length;
+    TrafficClass traffic_class = kBulk;
 };
 
 enum TransferStatusEnum {
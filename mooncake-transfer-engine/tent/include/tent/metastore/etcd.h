@@ -34,6 +34,9 @@ class EtcdMetaStore : public MetaStore {
 
     virtual Status get(const std::string &key, std::string &value);
 
+    virtual Status getMany(const std::vector<std::string> &keys,
+                           std::vector<std::string> &values);
+
     virtual Status set(const std::string &key, const std::string &value);
 
     virtual Status remove(const std::string &key);
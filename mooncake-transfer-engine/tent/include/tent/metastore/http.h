@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <curl/curl.h>
+#include <vector>
 
 namespace mooncake {
 namespace tent {
@@ -34,6 +35,9 @@ class HttpMetaStore : public MetaStore {
 
     virtual Status get(const std::string &key, std::string &value);
 
+    virtual Status getMany(const std::vector<std::string> &keys,
+                           std::vector<std::string> &values);
+
     virtual Status set(const std::string &key, const std::string &value);
 
     virtual Status remove(const std::string &key);
@@ -56,6 +60,8 @@ class HttpMetaStore : public MetaStore {
    private:
     std::atomic<bool> connected_;
     CURL *client_;
+    // Shares its connection cache between the parallel GETs of getMany
+    CURLM *multi_client_ = nullptr;
     std::string endpoint_;
 };
 }  // namespace tent
@@ -0,0 +1,140 @@
+// Copyright 2025 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "tent/common/types.h"
+
+namespace mooncake::tent {
+
+/**
+ * @brief Counter written by its owner thread only
+ *
+ * Updates are plain relaxed load/store pairs, i.e. no locked instruction on
+ * the data path; the scraper reads a value that is at most one update old.
+ */
+class LocalCounter {
+   public:
+    void add(uint64_t delta) {
+        value_.store(value_.load(std::memory_order_relaxed) + delta,
+                     std::memory_order_relaxed);
+    }
+
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+   private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * @brief Single-writer histogram of microsecond values
+ *
+ * Bucket i counts values up to 2^i us, for i in [0, 20] (~1 s), and the
+ * last bucket counts the rest.
+ */
+class LocalHistogram {
+   public:
+    static const int kBuckets = 22;
+
+    void observe(double value_us);
+
+    void merge(const LocalHistogram& other) {
+        for (int i = 0; i < kBuckets; ++i) buckets_[i].add(other.bucket(i));
+        sum_ns_.add(other.sumNs());
+    }
+
+    uint64_t bucket(int index) const { return buckets_[index].value(); }
+
+    // Sum of the observed values in nanoseconds
+    uint64_t sumNs() const { return sum_ns_.value(); }
+
+    static double upperBound(int index) { return double(1ull << index); }
+
+   private:
+    std::array<LocalCounter, kBuckets> buckets_;
+    LocalCounter sum_ns_;
+};
+
+struct TransportStats {
+    LocalCounter bytes;
+    LocalCounter requests;
+    LocalCounter failures;
+    LocalCounter retries;
+    LocalHistogram latency;
+};
+
+// Slices posted from one local NIC to one NIC of a peer segment
+struct RailStats {
+    LocalCounter bytes;
+    LocalCounter slices;
+    LocalHistogram queue_delay;  // enqueue to post
+    LocalHistogram latency;      // post to completion
+};
+
+/**
+ * @brief Per-transport and per-NIC-pair statistics of TENT
+ *
+ * Every thread records into its own shard; shards are only summed up when
+ * the /metrics endpoint is scraped. Recording is a no-op unless TentMetrics
+ * is initialized and enabled.
+ */
+class TransportMetrics {
+   public:
+    static TransportMetrics& instance();
+
+    static bool active();
+
+    void recordTransfer(TransportType type, uint64_t bytes,
+                        double latency_seconds, bool failed);
+
+    void recordRetry(TransportType type);
+
+    // Stats of the calling thread for the given rail, or nullptr if
+    // metrics are disabled. The pointer is valid until the thread exits.
+    RailStats* rail(const std::string& local_nic,
+                    const std::string& remote_segment,
+                    const std::string& remote_nic);
+
+    // Appends all metrics in Prometheus text format
+    void serialize(std::string& out);
+
+   private:
+    TransportMetrics();
+
+    struct Shard;
+    struct ShardOwner;
+
+    Shard* localShard();
+
+    void retire(Shard* shard);
+
+    using RailKey = std::tuple<std::string, std::string, std::string>;
+
+    std::mutex mutex_;
+    std::vector<Shard*> shards_;
+    // Sums of the shards of exited threads, written under mutex_
+    std::unique_ptr<Shard> retired_;
+};
+
+}  // namespace mooncake::tent
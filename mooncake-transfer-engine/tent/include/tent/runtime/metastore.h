@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tent/common/status.h"
 
@@ -39,6 +40,11 @@ struct MetaStore {
 
     virtual Status get(const std::string &key, std::string &value) = 0;
 
+    // Fetches several keys at once. values[i] is left empty if keys[i] does
+    // not exist; backends override this to save per-key round trips.
+    virtual Status getMany(const std::vector<std::string> &keys,
+                           std::vector<std::string> &values);
+
     virtual Status set(const std::string &key, const std::string &value) = 0;
 
     virtual Status remove(const std::string &key) = 0;
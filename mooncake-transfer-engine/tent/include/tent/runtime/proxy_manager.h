@@ -45,7 +45,8 @@ class ProxyManager {
    public:
     explicit ProxyManager(TransferEngineImpl* impl,
                           size_t chunk_size = 8 * 1024 * 1024,
-                          size_t chunk_count = 32);
+                          size_t chunk_count = 32,
+                          size_t pipeline_depth = 4);
 
     ~ProxyManager();
 
@@ -97,6 +98,9 @@ class ProxyManager {
    private:
     const size_t chunk_size_;
     const size_t chunk_count_;
+    // Stage buffers each runner cycles through, i.e. the number of chunks
+    // of one request that can be in different stages at the same time
+    const size_t pipeline_depth_;
     TransferEngineImpl* impl_;
     std::unordered_map<std::string, StageBuffers> stage_buffers_;
     std::atomic<bool> running_;
@@ -22,10 +22,12 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 #include "tent/runtime/segment.h"
 
@@ -45,6 +47,10 @@ class SegmentManager {
    public:
     Status openRemote(SegmentID &handle, const std::string &segment_name);
 
+    // Opens all segments and prefetches their descriptors in batches
+    Status openRemote(std::vector<SegmentID> &handles,
+                      const std::vector<std::string> &segment_names);
+
     Status closeRemote(SegmentID handle);
 
     Status getRemoteCached(SegmentDesc *&desc, SegmentID handle);
@@ -66,6 +72,10 @@ class SegmentManager {
     Status makeFileRemote(SegmentDescRef &desc,
                           const std::string &segment_name);
 
+    bool lookupShared(SegmentDescRef &desc, const std::string &segment_name);
+
+    void dropShared(SegmentID handle);
+
    private:
     struct RemoteSegmentCache {
         uint64_t last_refresh = 0;
@@ -73,6 +83,11 @@ class SegmentManager {
         std::unordered_map<SegmentID, SegmentDescRef> id_to_desc_map;
     };
 
+    struct SharedSegmentEntry {
+        uint64_t fetched_at = 0;
+        SegmentDescRef desc;
+    };
+
    private:
     RWSpinlock lock_;
     std::unordered_map<SegmentID, std::string> id_to_name_map_;
@@ -84,6 +99,11 @@ class SegmentManager {
     SegmentDescRef local_desc_;
     ThreadLocalStorage<RemoteSegmentCache> tl_remote_cache_;
 
+    // Descriptors fetched by any thread, so that thread-local caches refill
+    // without a metastore round trip each
+    std::mutex shared_cache_lock_;
+    std::unordered_map<std::string, SharedSegmentEntry> shared_cache_;
+
     std::unique_ptr<SegmentRegistry> registry_;
 
     std::string file_desc_basepath_;
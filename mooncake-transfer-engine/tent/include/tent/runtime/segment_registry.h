@@ -26,6 +26,7 @@
 #include <thread>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 #include "tent/runtime/segment.h"
 
@@ -44,6 +45,11 @@ class SegmentRegistry {
     virtual Status getSegmentDesc(SegmentDescRef &desc,
                                   const std::string &segment_name) = 0;
 
+    // descs[i] is set to nullptr if segment_names[i] cannot be resolved
+    virtual Status getSegmentDescs(
+        std::vector<SegmentDescRef> &descs,
+        const std::vector<std::string> &segment_names);
+
     virtual Status putSegmentDesc(SegmentDescRef &desc) = 0;
 
     virtual Status deleteSegmentDesc(const std::string &segment_name) = 0;
@@ -62,6 +68,10 @@ class CentralSegmentRegistry : public SegmentRegistry {
     virtual Status getSegmentDesc(SegmentDescRef &desc,
                                   const std::string &segment_name);
 
+    virtual Status getSegmentDescs(
+        std::vector<SegmentDescRef> &descs,
+        const std::vector<std::string> &segment_names);
+
     virtual Status putSegmentDesc(SegmentDescRef &desc);
 
     virtual Status deleteSegmentDesc(const std::string &segment_name);
@@ -15,6 +15,8 @@
 #ifndef SLAB_H_
 #define SLAB_H_
 
+#include <atomic>
+#include <cstdint>
 #include <list>
 #include <mutex>
 #include <array>
@@ -23,55 +25,77 @@
 namespace mooncake {
 namespace tent {
 
+// Objects are cached per thread in magazines, i.e. fixed-size stacks of
+// free blocks. A thread that frees more than it allocates (e.g. a completion
+// thread) hands full magazines to a lock-free depot, where the allocating
+// thread picks them up. Objects thus move between threads 128 at a time
+// with a single CAS, and neither side takes a lock in the steady state.
 class SlabBase {
    public:
     SlabBase(size_t block_size);
 
-    ~SlabBase() {
-        for (auto entry : alloc_list_) free(entry);
-        alloc_list_.clear();
-        free_list_.clear();
-    }
+    ~SlabBase();
 
     void *allocate();
 
     void deallocate(void *object);
 
-    static const size_t kMaxFreeListSizeInThread = 128;
-    static const size_t kAllocateBatchSize = 128;
+    static const size_t kMagazineSize = 128;
+    static const size_t kAllocateBatchSize = kMagazineSize;
+
+    static const uint32_t kNilMagazine = UINT32_MAX;
+
+    struct Magazine {
+        std::atomic<uint32_t> next{kNilMagazine};  // link in the depot
+        uint32_t count = 0;
+        std::array<void *, kMagazineSize> rounds;
+
+        bool empty() const { return count == 0; }
+        bool full() const { return count == kMagazineSize; }
+    };
 
+    // Each thread holds up to two magazines per slab, so that alternating
+    // allocate/deallocate calls at a magazine boundary do not thrash the
+    // depot
     struct ThreadLocal {
+        uint32_t loaded = kNilMagazine;
+        uint32_t previous = kNilMagazine;
+    };
+
+   private:
+    // Treiber stack of magazine indices. The head packs the index with a
+    // generation tag to rule out ABA.
+    class MagazineStack {
        public:
-        bool enqueue(void *item) {
-            if (full()) return false;
-            buffer[tail] = item;
-            tail = (tail + 1) % kMaxFreeListSizeInThread;
-            ++count;
-            return true;
-        }
-
-        bool dequeue(void *&item) {
-            if (empty()) return false;
-            item = buffer[head];
-            head = (head + 1) % kMaxFreeListSizeInThread;
-            --count;
-            return true;
-        }
+        void push(SlabBase *slab, uint32_t index);
 
-        bool empty() const { return count == 0; }
-        bool full() const { return count == kMaxFreeListSizeInThread; }
-        size_t size() const { return count; }
+        uint32_t pop(SlabBase *slab);
 
        private:
-        std::array<void *, kMaxFreeListSizeInThread> buffer;
-        int head = 0, tail = 0, count = 0;
+        std::atomic<uint64_t> head_{kNilMagazine};
     };
 
+    Magazine *magazine(uint32_t index) const {
+        return &magazine_chunks_[index / kMagazinesPerChunk]
+                    .load(std::memory_order_acquire)[index %
+                                                     kMagazinesPerChunk];
+    }
+
+    uint32_t getEmptyMagazine();
+
+    uint32_t refill();
+
    private:
+    static const size_t kMagazinesPerChunk = 64;
+    static const size_t kMaxMagazineChunks = 1024;
+
     const size_t block_size_;
     int slab_index_;
-    std::mutex mutex_;
-    std::list<void *> free_list_;
+    MagazineStack full_magazines_;
+    MagazineStack empty_magazines_;
+    std::mutex mutex_;  // protects the fields below
+    uint32_t num_magazines_ = 0;
+    std::array<std::atomic<Magazine *>, kMaxMagazineChunks> magazine_chunks_;
     std::list<void *> alloc_list_;
 };
 
@@ -89,6 +89,9 @@ class TransferEngineImpl {
 
     Status openSegment(SegmentID& handle, const std::string& segment_name);
 
+    Status openSegments(std::vector<SegmentID>& handles,
+                        const std::vector<std::string>& segment_names);
+
     Status closeSegment(SegmentID handle);
 
     Status getSegmentInfo(SegmentID handle, SegmentInfo& info);
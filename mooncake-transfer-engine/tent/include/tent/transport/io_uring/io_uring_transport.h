@@ -20,9 +20,11 @@
 
 #include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "tent/runtime/control_plane.h"
 #include "tent/runtime/transport.h"
@@ -31,6 +33,7 @@ namespace mooncake {
 namespace tent {
 
 class IOUringFileContext;
+class IOUringRing;
 
 struct IOUringTask {
     Request request;
@@ -46,7 +49,8 @@ struct IOUringTask {
 struct IOUringSubBatch : public Transport::SubBatch {
     size_t max_size;
     std::vector<IOUringTask> task_list;
-    struct io_uring ring;
+    // Ring of the thread that submitted first; shared with other batches
+    std::shared_ptr<IOUringRing> ring;
     virtual size_t size() const { return task_list.size(); }
 };
 
@@ -87,6 +91,8 @@ class IOUringTransport : public Transport {
 
     Status probeCapabilities();
 
+    std::shared_ptr<IOUringRing> getRing();
+
    private:
     bool installed_;
     std::string local_segment_name_;
@@ -99,6 +105,20 @@ class IOUringTransport : public Transport {
         std::unordered_map<SegmentID, std::shared_ptr<IOUringFileContext>>;
     FileContextMap file_context_map_;
     uint64_t async_memcpy_threshold_;
+
+    const uint64_t instance_id_;
+    unsigned queue_depth_;
+    bool sqpoll_;
+    unsigned sqpoll_idle_ms_;
+    bool fixed_buffers_;
+    // Rings of other threads attach to the SQPOLL thread of this one
+    std::mutex primary_ring_mutex_;
+    std::shared_ptr<IOUringRing> primary_ring_;
+
+    // TENT-registered host memory, registered as fixed buffers by each ring
+    RWSpinlock buffer_lock_;
+    std::vector<struct iovec> buffers_;
+    uint64_t buffers_version_ = 0;
 };
 }  // namespace tent
 }  // namespace mooncake
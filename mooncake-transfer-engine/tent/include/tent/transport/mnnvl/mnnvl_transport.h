@@ -36,12 +36,16 @@ struct MnnvlTask {
     volatile size_t transferred_bytes;
     uint64_t target_addr = 0;
     int cuda_id = 0;
+    // One event per stripe of an asynchronous copy
+    static const int kMaxStripes = 8;
+    cudaEvent_t events[kMaxStripes];
+    int num_events = 0;
 };
 
 struct MnnvlSubBatch : public Transport::SubBatch {
     std::vector<MnnvlTask> task_list;
     size_t max_size;
-    cudaStream_t stream;
+    cudaStream_t *streams;  // per-thread pool, see num_streams_
     virtual size_t size() const { return task_list.size(); }
 };
 
@@ -115,6 +119,10 @@ class MnnvlTransport : public Transport {
     std::mutex allocate_mutex_;
     std::unordered_set<void *> allocate_set_;
     uint64_t async_memcpy_threshold_;
+    // Copies of at least 2 * stripe_size_ bytes are split over up to
+    // num_streams_ streams, so that several copy engines move them
+    size_t num_streams_;
+    uint64_t stripe_size_;
     bool supported_;
     CUmemAllocationHandleType handle_type_;
 
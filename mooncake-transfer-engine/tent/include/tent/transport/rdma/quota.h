@@ -25,6 +25,7 @@
 #include <mutex>
 
 #include "tent/common/status.h"
+#include "tent/common/types.h"
 #include "tent/runtime/topology.h"
 
 namespace mooncake {
@@ -63,6 +64,10 @@ class DeviceQuota {
         uint64_t padding3[7];
         std::atomic<double> beta1{1.0};  // Effective bandwidth correction
         uint64_t padding4[7];
+        // Posted bytes per traffic class, of this and of the other processes
+        std::atomic<uint64_t> class_bytes[kNumTrafficClasses]{};
+        std::atomic<uint64_t> diffusion_class_bytes[kNumTrafficClasses]{};
+        uint64_t padding5[2];
     };
 
    public:
@@ -83,6 +88,30 @@ class DeviceQuota {
 
     Status release(int dev_id, uint64_t length, double latency);
 
+    // Admits a slice of the traffic class for posting on the device, or
+    // returns false to defer it. Once the posted bytes of the device exceed
+    // the class budget, the latency critical class preempts the others and
+    // the others get shares of the budget in proportion to their weights.
+    bool admit(int dev_id, TrafficClass traffic_class, uint64_t length);
+
+    // Returns the bytes of an admitted slice once it is no longer posted
+    Status complete(int dev_id, TrafficClass traffic_class, uint64_t length);
+
+    void setDiffusionClassBytes(int dev_id, int traffic_class,
+                                uint64_t value) {
+        auto it = devices_.find(dev_id);
+        if (it != devices_.end())
+            it->second.diffusion_class_bytes[traffic_class].store(
+                value, std::memory_order_relaxed);
+    }
+
+    uint64_t getClassBytes(int dev_id, int traffic_class) {
+        auto it = devices_.find(dev_id);
+        if (it == devices_.end()) return 0;
+        return it->second.class_bytes[traffic_class].load(
+            std::memory_order_relaxed);
+    }
+
     void setDiffusionActiveBytes(int dev_id, uint64_t value) {
         devices_[dev_id].diffusion_active_bytes.store(
             value, std::memory_order_relaxed);
@@ -104,6 +133,17 @@ class DeviceQuota {
 
     void setCrossNumaAccess(bool enable = true) { allow_cross_numa_ = enable; }
 
+    void setClassWeights(double bulk_weight, double background_weight) {
+        class_weights_[kBulk] = std::max(bulk_weight, 1e-3);
+        class_weights_[kBackground] = std::max(background_weight, 1e-3);
+    }
+
+    // Zero disables the traffic class admission
+    void setClassBudget(uint64_t bytes) { class_budget_ = bytes; }
+
+   private:
+    Status diffuse();
+
    private:
     std::shared_ptr<Topology> local_topology_;
     std::unordered_map<int, DeviceInfo> devices_;
@@ -115,6 +155,8 @@ class DeviceQuota {
     std::shared_ptr<SharedQuotaManager> shared_quota_;
     bool enable_quota_ = true;
     bool update_quota_params_ = true;
+    double class_weights_[kNumTrafficClasses] = {1.0, 4.0, 1.0};
+    uint64_t class_budget_ = 64ull << 20;
 };
 
 }  // namespace tent
@@ -44,6 +44,18 @@ class RailMonitor {
 
     void markRecovered(int local_nic, int remote_nic);
 
+    // Feeds the completion latency of a slice posted on the rail. A rail
+    // whose latency per byte stays far above that of its peers is marked
+    // slow and taken out of the mapping until its probes are fast again.
+    void recordLatency(int local_nic, int remote_nic, uint64_t length,
+                       double latency);
+
+    bool slow(int local_nic, int remote_nic);
+
+    // Returns a slow remote NIC of the local NIC that is due for a probe,
+    // or -1. The caller routes one slice over the rail as the probe.
+    int takeProbe(int local_nic);
+
     int findBestRemoteDevice(int local_nic, int remote_numa);
 
     const Topology *remote() { return remote_; }
@@ -73,8 +85,16 @@ class RailMonitor {
         std::chrono::steady_clock::time_point last_error{};
         bool paused = false;
         std::chrono::steady_clock::time_point resume_time{};
+        // Smoothed completion latency per byte
+        double cost = 0.0;
+        int samples = 0;
+        bool slow = false;
+        int good_probes = 0;
+        std::chrono::steady_clock::time_point next_probe{};
     };
 
+    double baselineCost(const RailState &self);
+
     std::unordered_map<std::pair<int, int>, RailState, PairHash> rail_states_;
     std::unordered_map<int, int> direct_rails_;  // keep static after loaded
     std::unordered_map<int, int> best_mapping_[kMaxNuma];
@@ -82,6 +102,13 @@ class RailMonitor {
     int error_threshold_ = 3;
     std::chrono::seconds error_window_{10};
     std::chrono::seconds cooldown_{30};
+
+    double cost_alpha_ = 0.1;
+    int min_samples_ = 16;
+    double slow_factor_ = 3.0;
+    double recover_factor_ = 1.5;
+    int recover_probes_ = 3;
+    std::chrono::milliseconds probe_interval_{100};
 };
 
 }  // namespace tent
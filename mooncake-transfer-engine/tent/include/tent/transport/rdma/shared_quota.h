@@ -38,13 +38,16 @@ namespace tent {
 static constexpr int MAX_DEVICES = 64;
 static constexpr int MAX_PID_SLOTS = 256;
 static constexpr uint64_t SHM_MAGIC = 0x2025082772805202ULL;
-static constexpr int SHM_VERSION = 1;
+static constexpr int SHM_VERSION = 2;
 
 struct PidUsage {
     pid_t pid;                     // 0 == free slot
     volatile uint64_t used_bytes;  // local used bytes reported by this pid
-    uint8_t reserved[56];          // padding -> total 64B
+    // posted bytes per traffic class reported by this pid
+    volatile uint64_t class_bytes[kNumTrafficClasses];
+    uint8_t reserved[24];  // padding -> total 64B
 };
+static_assert(sizeof(PidUsage) == 64, "PidUsage must fill a cache line");
 
 struct SharedDeviceEntry {
     char dev_name[56];  // NUL-terminated device name, empty means unused
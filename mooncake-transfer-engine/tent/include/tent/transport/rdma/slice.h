@@ -68,6 +68,8 @@ struct RdmaSlice {
     int qp_index = 0;
     int retry_count = 0;
     bool failed = false;
+    bool quota_admitted = false;  // counted in the traffic class bytes
+    bool rail_probe = false;      // probes a rail marked slow
     uint64_t enqueue_ts = 0;
     uint64_t submit_ts = 0;
 };
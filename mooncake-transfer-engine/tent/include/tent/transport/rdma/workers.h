@@ -15,6 +15,7 @@
 #ifndef TENT_WORKERS_H
 #define TENT_WORKERS_H
 
+#include <deque>
 #include <future>
 #include <queue>
 #include <thread>
@@ -27,6 +28,7 @@
 #include "context.h"
 #include "rail_monitor.h"
 #include "tent/common/utils/os.h"
+#include "tent/metrics/transport_metrics.h"
 #include "tent/common/concurrent/bounded_mpsc_queue.h"
 
 namespace mooncake {
@@ -123,6 +125,13 @@ class Workers {
 
     void disableEndpoint(RdmaSlice *slice);
 
+    void releaseAdmission(RdmaSlice *slice);
+
+    void recordRailLatency(RdmaSlice *slice, double latency);
+
+    void recordRailMetrics(RdmaSlice *slice, double queue_us,
+                           double latency_us);
+
     using GroupedRequests =
         std::unordered_map<PostPath, std::vector<RdmaSlice *>, PostPathHash>;
 
@@ -179,6 +188,8 @@ class Workers {
         std::thread thread;
         BoundedSliceQueue queue;
         GroupedRequests requests;
+        // Slices held back by the traffic class admission, in order
+        std::deque<std::pair<PostPath, RdmaSlice *>> deferred;
         std::unordered_set<RdmaSlice *> inflight_slice_set;
         std::atomic<int64_t> inflight_slices = 0;
 
@@ -187,6 +198,9 @@ class Workers {
         volatile bool in_suspend = false;
 
         std::unordered_map<std::string, RailMonitor> rails;
+        uint64_t rail_samples = 0;
+        // Keyed by target segment and NIC pair, see recordRailMetrics()
+        std::unordered_map<uint64_t, RailStats *> rail_stats;
         PerfMetricSummary perf;
         uint64_t padding[16];
     };
@@ -17,6 +17,7 @@
 
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <queue>
 #include <string>
 
@@ -26,11 +27,16 @@
 namespace mooncake {
 namespace tent {
 
+class ShmCopyWorkers;
+
 struct ShmTask {
     Request request;
     volatile TransferStatusEnum status_word;
     volatile size_t transferred_bytes;
     uint64_t target_addr = 0;
+    // Chunks still being copied by the copy workers
+    uint32_t pending_chunks = 0;
+    bool failed = false;
 };
 
 struct ShmSubBatch : public Transport::SubBatch {
@@ -108,6 +114,12 @@ class ShmTransport : public Transport {
     std::unordered_map<void *, std::string> shm_path_map_;
 
     std::string cxl_mount_path_;
+
+    // Copies of at least offload_threshold_ bytes run on threads bound to
+    // the NUMA node of the destination
+    uint64_t offload_threshold_;
+    uint64_t split_size_;
+    std::unique_ptr<ShmCopyWorkers> copy_workers_;
 };
 }  // namespace tent
 }  // namespace mooncake
@@ -66,6 +66,35 @@ Status EtcdMetaStore::get(const std::string &key, std::string &value) {
     return Status::OK();
 }
 
+Status EtcdMetaStore::getMany(const std::vector<std::string> &keys,
+                              std::vector<std::string> &values) {
+    char *err_str;
+    if (!connected_) {
+        return Status::MetadataError("Etcd connection not available" LOC_MARK);
+    }
+    values.assign(keys.size(), std::string());
+    if (keys.empty()) return Status::OK();
+    std::vector<char *> raw_keys(keys.size());
+    std::vector<char *> raw_values(keys.size(), nullptr);
+    for (size_t i = 0; i < keys.size(); ++i)
+        raw_keys[i] = (char *)keys[i].c_str();
+    auto ret = EtcdBatchGetWrapper(raw_keys.data(), (int)keys.size(),
+                                   raw_values.data(), &err_str);
+    if (ret) {
+        std::string message = std::string("Etcd failed to get ") +
+                              std::to_string(keys.size()) +
+                              " keys: " + err_str;
+        free(err_str);  // free the memory for storing error message
+        return Status::MetadataError(message + LOC_MARK);
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (!raw_values[i]) continue;
+        values[i] = raw_values[i];
+        free(raw_values[i]);  // allocated by EtcdBatchGetWrapper
+    }
+    return Status::OK();
+}
+
 Status EtcdMetaStore::set(const std::string &key, const std::string &value) {
     char *err_str;
     if (!connected_) {
@@ -16,9 +16,14 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+
 namespace mooncake {
 namespace tent {
 
+// GETs of getMany in flight at the same time
+static const long kMaxParallelRequests = 32;
+
 HttpMetaStore::HttpMetaStore() {}
 
 HttpMetaStore::~HttpMetaStore() { disconnect(); }
@@ -34,6 +39,14 @@ Status HttpMetaStore::connect(const std::string &endpoint) {
         return Status::InternalError(
             "HTTP cannot allocate curl objects" LOC_MARK);
     }
+    multi_client_ = curl_multi_init();
+    if (!multi_client_) {
+        curl_easy_cleanup(client_);
+        return Status::InternalError(
+            "HTTP cannot allocate curl objects" LOC_MARK);
+    }
+    curl_multi_setopt(multi_client_, CURLMOPT_MAX_HOST_CONNECTIONS,
+                      kMaxParallelRequests);
     endpoint_ = endpoint;
     connected_ = true;
     return Status::OK();
@@ -41,6 +54,8 @@ Status HttpMetaStore::connect(const std::string &endpoint) {
 
 Status HttpMetaStore::disconnect() {
     if (connected_) {
+        curl_multi_cleanup(multi_client_);
+        multi_client_ = nullptr;
         curl_easy_cleanup(client_);
         curl_global_cleanup();
         connected_ = false;
@@ -85,6 +100,94 @@ Status HttpMetaStore::get(const std::string &key, std::string &value) {
     return Status::OK();
 }
 
+Status HttpMetaStore::getMany(const std::vector<std::string> &keys,
+                              std::vector<std::string> &values) {
+    if (!connected_) {
+        return Status::MetadataError("HTTP connection not available" LOC_MARK);
+    }
+
+    // The metadata server has no multi-key API, so the GETs are issued in
+    // parallel over a bounded set of kept-alive connections instead
+    struct Request {
+        CURL *handle;
+        size_t index;
+        std::string response;
+    };
+    values.assign(keys.size(), std::string());
+    std::vector<Request> requests(std::min<size_t>(keys.size(),
+                                                   kMaxParallelRequests));
+    for (auto &request : requests) {
+        request.handle = curl_easy_init();
+        if (!request.handle) {
+            for (auto &entry : requests) curl_easy_cleanup(entry.handle);
+            return Status::InternalError(
+                "HTTP cannot allocate curl objects" LOC_MARK);
+        }
+    }
+
+    Status status = Status::OK();
+    size_t next_key = 0, running = 0;
+    auto launch = [&](Request &request) {
+        request.index = next_key++;
+        request.response.clear();
+        std::string url = encodeUrl(keys[request.index]);
+        curl_easy_reset(request.handle);
+        curl_easy_setopt(request.handle, CURLOPT_TIMEOUT_MS, 3000);
+        curl_easy_setopt(request.handle, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(request.handle, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(request.handle, CURLOPT_WRITEDATA, &request.response);
+        curl_easy_setopt(request.handle, CURLOPT_PRIVATE, &request);
+        curl_multi_add_handle(multi_client_, request.handle);
+        running++;
+    };
+    for (auto &request : requests) launch(request);
+
+    while (running) {
+        int still_running = 0;
+        CURLMcode mc = curl_multi_perform(multi_client_, &still_running);
+        if (mc == CURLM_OK)
+            mc = curl_multi_poll(multi_client_, nullptr, 0, 1000, nullptr);
+        if (mc != CURLM_OK) {
+            status = Status::MetadataError(
+                std::string("HTTP failed to post request: ") +
+                curl_multi_strerror(mc) + LOC_MARK);
+            break;
+        }
+        int queued = 0;
+        while (CURLMsg *msg = curl_multi_info_read(multi_client_, &queued)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            Request *request = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &request);
+            curl_multi_remove_handle(multi_client_, request->handle);
+            running--;
+            long responseCode = 0;
+            curl_easy_getinfo(request->handle, CURLINFO_RESPONSE_CODE,
+                              &responseCode);
+            if (msg->data.result != CURLE_OK) {
+                status = Status::MetadataError(
+                    std::string("HTTP failed to post request: ") +
+                    curl_easy_strerror(msg->data.result) + LOC_MARK);
+            } else if (responseCode == 200) {
+                values[request->index] = std::move(request->response);
+            } else if (responseCode != 404) {
+                std::string message = std::to_string(responseCode) + ": " +
+                                      request->response;
+                status = Status::MetadataError(
+                    std::string("HTTP received unexpected response: ") +
+                    message + LOC_MARK);
+            }
+            if (status.ok() && next_key < keys.size()) launch(*request);
+        }
+        if (!status.ok()) break;
+    }
+
+    for (auto &request : requests) {
+        curl_multi_remove_handle(multi_client_, request.handle);
+        curl_easy_cleanup(request.handle);
+    }
+    return status;
+}
+
 Status HttpMetaStore::set(const std::string &key, const std::string &value) {
     if (!connected_) {
         return Status::MetadataError("HTTP connection not available" LOC_MARK);
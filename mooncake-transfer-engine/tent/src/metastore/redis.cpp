@@ -15,6 +15,8 @@
 #include "tent/metastore/redis.h"
 
 #include <glog/logging.h>
+
+#include <algorithm>
 #include <memory>
 
 namespace mooncake {
@@ -181,6 +183,43 @@ Status RedisMetaStore::get(const std::string &key, std::string &value) {
     return Status::OK();
 }
 
+Status RedisMetaStore::getMany(const std::vector<std::string> &keys,
+                               std::vector<std::string> &values) {
+    if (!connected_) {
+        return Status::MetadataError("Redis connection not available" LOC_MARK);
+    }
+
+    // One MGET per chunk keeps single replies bounded
+    const size_t kMaxKeysPerCommand = 1024;
+    values.assign(keys.size(), std::string());
+    for (size_t start = 0; start < keys.size(); start += kMaxKeysPerCommand) {
+        size_t end = std::min(keys.size(), start + kMaxKeysPerCommand);
+        std::vector<const char *> argv{"MGET"};
+        std::vector<size_t> argv_len{4};
+        for (size_t i = start; i < end; ++i) {
+            argv.push_back(keys[i].data());
+            argv_len.push_back(keys[i].size());
+        }
+        redisReply *resp = (redisReply *)redisCommandArgv(
+            client_, (int)argv.size(), argv.data(), argv_len.data());
+        RedisReplyGuard reply_guard(resp);
+
+        Status status = handleRedisReply(resp, "MGET");
+        if (!status.ok()) return status;
+        if (resp->type != REDIS_REPLY_ARRAY ||
+            resp->elements != end - start) {
+            return Status::MetadataError(
+                "Redis MGET failed: unexpected reply" LOC_MARK);
+        }
+        for (size_t i = 0; i < resp->elements; ++i) {
+            auto element = resp->element[i];
+            if (element->type == REDIS_REPLY_STRING)
+                values[start + i].assign(element->str, element->len);
+        }
+    }
+    return Status::OK();
+}
+
 Status RedisMetaStore::set(const std::string &key, const std::string &value) {
     if (!connected_) {
         return Status::MetadataError("Redis connection not available" LOC_MARK);
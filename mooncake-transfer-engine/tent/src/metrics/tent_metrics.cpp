@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "tent/metrics/tent_metrics.h"
+#include "tent/metrics/transport_metrics.h"
 
 #include <glog/logging.h>
 #include <tent/thirdparty/nlohmann/json.h>
@@ -264,6 +265,9 @@ std::string TentMetrics::getPrometheusMetrics() {
             histogram->serialize(result);
         }
 
+        // Per-transport and per-rail metrics
+        TransportMetrics::instance().serialize(result);
+
         return result;
     } catch (const std::exception& e) {
         LOG(ERROR) << "Failed to serialize Prometheus metrics: " << e.what();
@@ -0,0 +1,265 @@
+// Copyright 2025 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tent/metrics/transport_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "tent/metrics/tent_metrics.h"
+
+namespace mooncake::tent {
+
+void LocalHistogram::observe(double value_us) {
+    int index = 0;
+    if (value_us > 1.0)
+        index = std::min(kBuckets - 1, (int)std::ceil(std::log2(value_us)));
+    buckets_[index].add(1);
+    sum_ns_.add(value_us > 0 ? (uint64_t)(value_us * 1000.0) : 0);
+}
+
+struct TransportMetrics::Shard {
+    std::array<TransportStats, kSupportedTransportTypes> transports;
+    std::mutex rail_mutex;  // rail insertion vs. serialization
+    std::map<RailKey, std::unique_ptr<RailStats>> rails;
+};
+
+// Hands the shard over to retired_ when the thread exits
+struct TransportMetrics::ShardOwner {
+    Shard* shard = nullptr;
+    ~ShardOwner() {
+        if (shard) TransportMetrics::instance().retire(shard);
+    }
+};
+
+TransportMetrics::TransportMetrics() : retired_(new Shard()) {}
+
+TransportMetrics& TransportMetrics::instance() {
+    // Never destroyed: threads may exit after static destruction
+    static auto* metrics = new TransportMetrics();
+    return *metrics;
+}
+
+bool TransportMetrics::active() {
+#if TENT_METRICS_ENABLED
+    return TentMetrics::isEnabled() && TentMetrics::instance().isInitialized();
+#else
+    return false;
+#endif
+}
+
+TransportMetrics::Shard* TransportMetrics::localShard() {
+    thread_local ShardOwner owner;
+    if (!owner.shard) {
+        owner.shard = new Shard();
+        std::lock_guard<std::mutex> lock(mutex_);
+        shards_.push_back(owner.shard);
+    }
+    return owner.shard;
+}
+
+void TransportMetrics::retire(Shard* shard) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shards_.erase(std::remove(shards_.begin(), shards_.end(), shard),
+                  shards_.end());
+    for (int type = 0; type < kSupportedTransportTypes; ++type) {
+        auto& src = shard->transports[type];
+        auto& dst = retired_->transports[type];
+        dst.bytes.add(src.bytes.value());
+        dst.requests.add(src.requests.value());
+        dst.failures.add(src.failures.value());
+        dst.retries.add(src.retries.value());
+        dst.latency.merge(src.latency);
+    }
+    for (auto& [key, src] : shard->rails) {
+        auto& dst = retired_->rails[key];
+        if (!dst) dst = std::make_unique<RailStats>();
+        dst->bytes.add(src->bytes.value());
+        dst->slices.add(src->slices.value());
+        dst->queue_delay.merge(src->queue_delay);
+        dst->latency.merge(src->latency);
+    }
+    delete shard;
+}
+
+void TransportMetrics::recordTransfer(TransportType type, uint64_t bytes,
+                                      double latency_seconds, bool failed) {
+    if (type < 0 || type >= kSupportedTransportTypes || !active()) return;
+    auto& stats = localShard()->transports[type];
+    stats.requests.add(1);
+    if (failed) {
+        stats.failures.add(1);
+        return;
+    }
+    stats.bytes.add(bytes);
+    stats.latency.observe(latency_seconds * 1e6);
+}
+
+void TransportMetrics::recordRetry(TransportType type) {
+    if (type < 0 || type >= kSupportedTransportTypes || !active()) return;
+    localShard()->transports[type].retries.add(1);
+}
+
+RailStats* TransportMetrics::rail(const std::string& local_nic,
+                                  const std::string& remote_segment,
+                                  const std::string& remote_nic) {
+    if (!active()) return nullptr;
+    auto shard = localShard();
+    std::lock_guard<std::mutex> lock(shard->rail_mutex);
+    auto& stats = shard->rails[{local_nic, remote_segment, remote_nic}];
+    if (!stats) stats = std::make_unique<RailStats>();
+    return stats.get();
+}
+
+namespace {
+const char* kTransportNames[kSupportedTransportTypes] = {
+    "rdma", "mnnvl", "shm", "nvlink", "gds", "io_uring", "tcp",
+    "ascend_direct"};
+
+struct HistogramSum {
+    std::array<uint64_t, LocalHistogram::kBuckets> buckets{};
+    uint64_t sum_ns = 0;
+
+    void add(const LocalHistogram& hist) {
+        for (int i = 0; i < LocalHistogram::kBuckets; ++i)
+            buckets[i] += hist.bucket(i);
+        sum_ns += hist.sumNs();
+    }
+};
+
+struct TransportSum {
+    uint64_t bytes = 0, requests = 0, failures = 0, retries = 0;
+    HistogramSum latency;
+};
+
+struct RailSum {
+    uint64_t bytes = 0, slices = 0;
+    HistogramSum queue_delay, latency;
+};
+
+void writeHeader(std::ostringstream& os, const char* name, const char* type,
+                 const char* help) {
+    os << "# HELP " << name << " " << help << "\n";
+    os << "# TYPE " << name << " " << type << "\n";
+}
+
+void writeHistogram(std::ostringstream& os, const char* name,
+                    const std::string& labels, const HistogramSum& hist) {
+    uint64_t cumulative = 0;
+    for (int i = 0; i < LocalHistogram::kBuckets; ++i) {
+        cumulative += hist.buckets[i];
+        os << name << "_bucket{" << labels << ",le=\"";
+        if (i == LocalHistogram::kBuckets - 1)
+            os << "+Inf";
+        else
+            os << (uint64_t)LocalHistogram::upperBound(i);
+        os << "\"} " << cumulative << "\n";
+    }
+    os << name << "_sum{" << labels << "} " << hist.sum_ns / 1000.0 << "\n";
+    os << name << "_count{" << labels << "} " << cumulative << "\n";
+}
+}  // namespace
+
+void TransportMetrics::serialize(std::string& out) {
+    std::array<TransportSum, kSupportedTransportTypes> transports;
+    std::map<RailKey, RailSum> rails;
+    auto collect = [&](Shard* shard) {
+        for (int type = 0; type < kSupportedTransportTypes; ++type) {
+            auto& src = shard->transports[type];
+            auto& dst = transports[type];
+            dst.bytes += src.bytes.value();
+            dst.requests += src.requests.value();
+            dst.failures += src.failures.value();
+            dst.retries += src.retries.value();
+            dst.latency.add(src.latency);
+        }
+        std::lock_guard<std::mutex> lock(shard->rail_mutex);
+        for (auto& [key, src] : shard->rails) {
+            auto& dst = rails[key];
+            dst.bytes += src->bytes.value();
+            dst.slices += src->slices.value();
+            dst.queue_delay.add(src->queue_delay);
+            dst.latency.add(src->latency);
+        }
+    };
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto shard : shards_) collect(shard);
+        collect(retired_.get());
+    }
+
+    std::ostringstream os;
+    auto transport_counter = [&](const char* name, const char* help,
+                                 uint64_t TransportSum::*field) {
+        writeHeader(os, name, "counter", help);
+        for (int type = 0; type < kSupportedTransportTypes; ++type) {
+            if (!transports[type].requests) continue;
+            os << name << "{transport=\"" << kTransportNames[type] << "\"} "
+               << transports[type].*field << "\n";
+        }
+    };
+    transport_counter("tent_transport_bytes_total",
+                      "Bytes transferred per transport",
+                      &TransportSum::bytes);
+    transport_counter("tent_transport_requests_total",
+                      "Requests finished per transport",
+                      &TransportSum::requests);
+    transport_counter("tent_transport_failures_total",
+                      "Requests failed per transport",
+                      &TransportSum::failures);
+    transport_counter("tent_transport_retries_total",
+                      "Slices or requests retried per transport",
+                      &TransportSum::retries);
+    writeHeader(os, "tent_transport_latency_us", "histogram",
+                "Request latency per transport in microseconds");
+    for (int type = 0; type < kSupportedTransportTypes; ++type) {
+        if (!transports[type].requests) continue;
+        writeHistogram(os, "tent_transport_latency_us",
+                       std::string("transport=\"") + kTransportNames[type] +
+                           "\"",
+                       transports[type].latency);
+    }
+
+    if (!rails.empty()) {
+        auto rail_labels = [](const RailKey& key) {
+            return "local_nic=\"" + std::get<0>(key) +
+                   "\",remote_segment=\"" + std::get<1>(key) +
+                   "\",remote_nic=\"" + std::get<2>(key) + "\"";
+        };
+        writeHeader(os, "tent_rail_bytes_total", "counter",
+                    "RDMA bytes per local and remote NIC");
+        for (auto& [key, sum] : rails)
+            os << "tent_rail_bytes_total{" << rail_labels(key) << "} "
+               << sum.bytes << "\n";
+        writeHeader(os, "tent_rail_slices_total", "counter",
+                    "RDMA slices per local and remote NIC");
+        for (auto& [key, sum] : rails)
+            os << "tent_rail_slices_total{" << rail_labels(key) << "} "
+               << sum.slices << "\n";
+        writeHeader(os, "tent_rail_queue_delay_us", "histogram",
+                    "Time from slice enqueue to post in microseconds");
+        for (auto& [key, sum] : rails)
+            writeHistogram(os, "tent_rail_queue_delay_us", rail_labels(key),
+                           sum.queue_delay);
+        writeHeader(os, "tent_rail_slice_latency_us", "histogram",
+                    "Time from slice post to completion in microseconds");
+        for (auto& [key, sum] : rails)
+            writeHistogram(os, "tent_rail_slice_latency_us", rail_labels(key),
+                           sum.latency);
+    }
+    out += os.str();
+}
+
+}  // namespace mooncake::tent
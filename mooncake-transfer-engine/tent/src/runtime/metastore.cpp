@@ -73,5 +73,15 @@ std::shared_ptr<MetaStore> MetaStore::Create(const std::string &type,
         return nullptr;
     }
 }
+
+Status MetaStore::getMany(const std::vector<std::string> &keys,
+                          std::vector<std::string> &values) {
+    values.assign(keys.size(), std::string());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        auto status = get(keys[i], values[i]);
+        if (!status.ok() && !status.IsInvalidEntry()) return status;
+    }
+    return Status::OK();
+}
 }  // namespace tent
 }  // namespace mooncake
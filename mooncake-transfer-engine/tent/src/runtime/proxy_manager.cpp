@@ -18,12 +18,18 @@
 #include <cstring>
 #include <sstream>
 #include <mutex>
+#include <thread>
 
 namespace mooncake {
 namespace tent {
 ProxyManager::ProxyManager(TransferEngineImpl* impl, size_t chunk_size,
-                           size_t chunk_count)
-    : chunk_size_(chunk_size), chunk_count_(chunk_count), impl_(impl) {
+                           size_t chunk_count, size_t pipeline_depth)
+    : chunk_size_(chunk_size),
+      chunk_count_(chunk_count),
+      // All runners share the stage buffer pool of a location
+      pipeline_depth_(std::max<size_t>(
+          1, std::min(pipeline_depth, chunk_count / kShards))),
+      impl_(impl) {
     running_ = true;
     for (size_t i = 0; i < kShards; ++i) {
         shards_[i].thread = std::thread(&ProxyManager::runner, this, i);
@@ -238,9 +244,11 @@ Status ProxyManager::transferEventLoop(StagingTask& task,
     auto server_addr = task.params[0];
     bool local_staging = !task.params[1].empty();
     bool remote_staging = !task.params[2].empty();
-    const static size_t kStageBuffers = 4;
-    uint64_t local_stage_buffer[kStageBuffers],
-        remote_stage_buffer[kStageBuffers];
+    // With N stage buffers, the local copy of chunk i + 1, the cross-node
+    // write of chunk i and the remote copy of chunk i - 1 run concurrently
+    const size_t kStageBuffers = pipeline_depth_;
+    std::vector<uint64_t> local_stage_buffer(kStageBuffers, 0),
+        remote_stage_buffer(kStageBuffers, 0);
     if (local_staging) {
         for (size_t i = 0; i < kStageBuffers; ++i) {
             local_stage_buffer[i] =
@@ -302,10 +310,12 @@ Status ProxyManager::transferEventLoop(StagingTask& task,
     for (size_t i = 0; i < chunks.size(); ++i) event_queue.push(i);
     std::vector<std::future<Status>> remote_futures(chunks.size());
 
+    size_t idle_polls = 0;
     while (!event_queue.empty()) {
         auto id = event_queue.front();
         auto& chunk = chunks[id];
         event_queue.pop();
+        const auto last_state = chunk.state;
         switch (chunk.state) {
             case StageState::PRE: {
                 if (request.opcode == Request::WRITE && local_staging) {
@@ -366,12 +376,15 @@ Status ProxyManager::transferEventLoop(StagingTask& task,
                                       remote_futures[id]);
                     chunk.prev_state = chunk.state;
                     chunk.state = StageState::INFLIGHT_REMOTE;
+                    event_queue.push(id);
                 } else if (request.opcode == Request::READ && local_staging) {
                     chunk.batch = submitLocalStage(request, chunk.local_buf,
                                                    chunk.length, chunk.offset);
                     chunk.prev_state = chunk.state;
                     chunk.state = StageState::INFLIGHT;
                     event_queue.push(id);
+                } else {
+                    chunk.state = StageState::FINISH;
                 }
                 break;
             }
@@ -424,6 +437,7 @@ Status ProxyManager::transferEventLoop(StagingTask& task,
                 auto& fut = remote_futures[id];
                 if (!fut.valid()) {
                     chunk.state = StageState::FAILED;
+                    event_queue.push(id);
                     break;
                 }
                 if (fut.wait_for(std::chrono::seconds(0)) ==
@@ -431,6 +445,7 @@ Status ProxyManager::transferEventLoop(StagingTask& task,
                     Status rs = fut.get();
                     if (!rs.ok()) {
                         chunk.state = StageState::FAILED;
+                        event_queue.push(id);
                         break;
                     }
                     if (chunk.prev_state == StageState::PRE) {
@@ -449,6 +464,17 @@ Status ProxyManager::transferEventLoop(StagingTask& task,
                 break;
             }
         }
+
+        // Every pending chunk was polled without progress: give the CPU to
+        // the transport threads instead of spinning
+        if (chunk.state == last_state && chunk.state != StageState::FINISH)
+            ++idle_polls;
+        else
+            idle_polls = 0;
+        if (idle_polls > event_queue.size()) {
+            std::this_thread::yield();
+            idle_polls = 0;
+        }
     }
 
     return Status::OK();
@@ -47,11 +47,54 @@ Status SegmentManager::openRemote(SegmentID &handle,
     return Status::OK();
 }
 
+Status SegmentManager::openRemote(
+    std::vector<SegmentID> &handles,
+    const std::vector<std::string> &segment_names) {
+    handles.resize(segment_names.size());
+    for (size_t i = 0; i < segment_names.size(); ++i)
+        CHECK_STATUS(openRemote(handles[i], segment_names[i]));
+
+    std::vector<std::string> missing;
+    std::set<std::string> visited;
+    auto current_ts = getCurrentTimeInNano();
+    {
+        std::lock_guard<std::mutex> guard(shared_cache_lock_);
+        for (auto &segment_name : segment_names) {
+            if (segment_name.starts_with(kLocalFileSegmentPrefix)) continue;
+            if (!visited.insert(segment_name).second) continue;
+            auto iter = shared_cache_.find(segment_name);
+            if (iter != shared_cache_.end() &&
+                current_ts - iter->second.fetched_at <= ttl_ms_ * 1000000)
+                continue;
+            missing.push_back(segment_name);
+        }
+    }
+    if (missing.empty()) return Status::OK();
+
+    std::vector<SegmentDescRef> descs;
+    auto status = registry_->getSegmentDescs(descs, missing);
+    if (!status.ok()) {
+        // Not fatal: descriptors are fetched one by one on first use
+        LOG(WARNING) << "Failed to prefetch " << missing.size()
+                     << " segment descriptors: " << status.ToString();
+        return Status::OK();
+    }
+    std::lock_guard<std::mutex> guard(shared_cache_lock_);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (descs[i]) shared_cache_[missing[i]] = {current_ts, descs[i]};
+    }
+    return Status::OK();
+}
+
 Status SegmentManager::closeRemote(SegmentID handle) {
     RWSpinlock::WriteGuard guard(lock_);
     if (!id_to_name_map_.count(handle))
         return Status::InvalidArgument("Invalid segment handle" LOC_MARK);
     auto segment_name = id_to_name_map_[handle];
+    {
+        std::lock_guard<std::mutex> shared_guard(shared_cache_lock_);
+        shared_cache_.erase(segment_name);
+    }
     name_to_id_map_.erase(segment_name);
     id_to_name_map_.erase(handle);
     version_.fetch_add(1, std::memory_order_relaxed);
@@ -80,19 +123,52 @@ Status SegmentManager::getRemoteCached(SegmentDesc *&desc, SegmentID handle) {
 }
 
 Status SegmentManager::getRemote(SegmentDescRef &desc, SegmentID handle) {
-    RWSpinlock::WriteGuard guard(lock_);
-    if (!id_to_name_map_.count(handle)) {
-        return Status::InvalidArgument("Invalid segment handle" LOC_MARK);
+    std::string segment_name;
+    {
+        RWSpinlock::ReadGuard guard(lock_);
+        auto iter = id_to_name_map_.find(handle);
+        if (iter == id_to_name_map_.end()) {
+            return Status::InvalidArgument("Invalid segment handle" LOC_MARK);
+        }
+        segment_name = iter->second;
     }
-    auto segment_name = id_to_name_map_[handle];
     if (segment_name.starts_with(kLocalFileSegmentPrefix)) {
         CHECK_STATUS(makeFileRemote(desc, segment_name));
-    } else {
-        CHECK_STATUS(registry_->getSegmentDesc(desc, segment_name));
+        return Status::OK();
     }
+    if (lookupShared(desc, segment_name)) return Status::OK();
+    CHECK_STATUS(registry_->getSegmentDesc(desc, segment_name));
+    std::lock_guard<std::mutex> guard(shared_cache_lock_);
+    shared_cache_[segment_name] = {getCurrentTimeInNano(), desc};
     return Status::OK();
 }
 
+bool SegmentManager::lookupShared(SegmentDescRef &desc,
+                                  const std::string &segment_name) {
+    std::lock_guard<std::mutex> guard(shared_cache_lock_);
+    auto iter = shared_cache_.find(segment_name);
+    if (iter == shared_cache_.end()) return false;
+    if (getCurrentTimeInNano() - iter->second.fetched_at >
+        ttl_ms_ * 1000000) {
+        shared_cache_.erase(iter);
+        return false;
+    }
+    desc = iter->second.desc;
+    return true;
+}
+
+void SegmentManager::dropShared(SegmentID handle) {
+    std::string segment_name;
+    {
+        RWSpinlock::ReadGuard guard(lock_);
+        auto iter = id_to_name_map_.find(handle);
+        if (iter == id_to_name_map_.end()) return;
+        segment_name = iter->second;
+    }
+    std::lock_guard<std::mutex> guard(shared_cache_lock_);
+    shared_cache_.erase(segment_name);
+}
+
 Status SegmentManager::getRemote(SegmentDescRef &desc,
                                  const std::string &segment_name) {
     return registry_->getSegmentDesc(desc, segment_name);
@@ -102,6 +178,8 @@ Status SegmentManager::invalidateRemote(SegmentID handle) {
     if (handle == LOCAL_SEGMENT_ID) return Status::OK();
     auto &cache = tl_remote_cache_.get();
     if (cache.id_to_desc_map.count(handle)) cache.id_to_desc_map.erase(handle);
+    // The stale copy must not come back from the shared cache either
+    dropShared(handle);
     return Status::OK();
 }
 
@@ -29,6 +29,17 @@ static inline std::string getFullMetadataKey(const std::string &segment_name) {
     return kCommonKeyPrefix + segment_name;
 }
 
+Status SegmentRegistry::getSegmentDescs(
+    std::vector<SegmentDescRef> &descs,
+    const std::vector<std::string> &segment_names) {
+    descs.assign(segment_names.size(), nullptr);
+    for (size_t i = 0; i < segment_names.size(); ++i) {
+        auto status = getSegmentDesc(descs[i], segment_names[i]);
+        if (!status.ok()) descs[i] = nullptr;
+    }
+    return Status::OK();
+}
+
 CentralSegmentRegistry::CentralSegmentRegistry(const std::string &type,
                                                const std::string &servers) {
     plugin_ = MetaStore::Create(type, servers);
@@ -56,6 +67,26 @@ Status CentralSegmentRegistry::getSegmentDesc(SegmentDescRef &desc,
     return Status::OK();
 }
 
+Status CentralSegmentRegistry::getSegmentDescs(
+    std::vector<SegmentDescRef> &descs,
+    const std::vector<std::string> &segment_names) {
+    if (!plugin_)
+        return Status::MetadataError(
+            "Central metadata store not started" LOC_MARK);
+    std::vector<std::string> keys, values;
+    keys.reserve(segment_names.size());
+    for (auto &segment_name : segment_names)
+        keys.push_back(getFullMetadataKey(segment_name));
+    descs.assign(segment_names.size(), nullptr);
+    CHECK_STATUS(plugin_->getMany(keys, values));
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (values[i].empty()) continue;
+        descs[i] = std::make_shared<SegmentDesc>();
+        *descs[i] = json::parse(values[i]).get<SegmentDesc>();
+    }
+    return Status::OK();
+}
+
 Status CentralSegmentRegistry::putSegmentDesc(SegmentDescRef &desc) {
     if (!plugin_)
         return Status::MetadataError(
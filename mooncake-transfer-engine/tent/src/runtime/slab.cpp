@@ -14,8 +14,8 @@
 
 #include "tent/runtime/slab.h"
 
-#include <atomic>
 #include <unordered_map>
+#include <utility>
 
 namespace mooncake {
 namespace tent {
@@ -23,45 +23,126 @@ namespace tent {
 static std::atomic<int> g_next_slab_index(0);
 thread_local std::unordered_map<int, SlabBase::ThreadLocal> tl_slice_set;
 
+void SlabBase::MagazineStack::push(SlabBase *slab, uint32_t index) {
+    auto head = head_.load(std::memory_order_relaxed);
+    uint64_t tag;
+    do {
+        slab->magazine(index)->next.store((uint32_t)head,
+                                         std::memory_order_relaxed);
+        tag = (head >> 32) + 1;
+    } while (!head_.compare_exchange_weak(head, (tag << 32) | index,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+}
+
+uint32_t SlabBase::MagazineStack::pop(SlabBase *slab) {
+    auto head = head_.load(std::memory_order_acquire);
+    uint64_t next;
+    do {
+        auto index = (uint32_t)head;
+        if (index == kNilMagazine) return kNilMagazine;
+        // Magazines are never freed before the slab, so reading a stale
+        // next is harmless; the tag makes the CAS fail in that case
+        uint64_t tag = (head >> 32) + 1;
+        next = (tag << 32) |
+               slab->magazine(index)->next.load(std::memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(head, next,
+                                          std::memory_order_acquire,
+                                          std::memory_order_acquire));
+    return (uint32_t)head;
+}
+
 SlabBase::SlabBase(size_t block_size) : block_size_(block_size) {
     slab_index_ = g_next_slab_index.fetch_add(1);
+    for (auto &chunk : magazine_chunks_) chunk.store(nullptr);
 }
 
-void *SlabBase::allocate() {
-    auto &tl_slice = tl_slice_set[slab_index_];
-    void *object = nullptr;
-    if (tl_slice.dequeue(object)) return object;
+SlabBase::~SlabBase() {
+    for (auto entry : alloc_list_) free(entry);
+    alloc_list_.clear();
+    for (auto &chunk : magazine_chunks_) delete[] chunk.load();
+}
 
-    std::lock_guard<std::mutex> global_lock(mutex_);
-    while (!tl_slice.full() && !free_list_.empty()) {
-        tl_slice.enqueue(free_list_.front());
-        free_list_.pop_front();
-    }
+uint32_t SlabBase::getEmptyMagazine() {
+    auto index = empty_magazines_.pop(this);
+    if (index != kNilMagazine) return index;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (num_magazines_ == kMagazinesPerChunk * kMaxMagazineChunks)
+        return kNilMagazine;
+    index = num_magazines_++;
+    auto &chunk = magazine_chunks_[index / kMagazinesPerChunk];
+    if (index % kMagazinesPerChunk == 0)
+        chunk.store(new Magazine[kMagazinesPerChunk],
+                    std::memory_order_release);
+    return index;
+}
 
-    if (tl_slice.empty()) {
-        void *slab = malloc(kAllocateBatchSize * block_size_);
-        if (!slab) return nullptr;
+// Returns a full magazine, either from the depot or carved from a newly
+// allocated batch of blocks
+uint32_t SlabBase::refill() {
+    auto index = full_magazines_.pop(this);
+    if (index != kNilMagazine) return index;
+    index = getEmptyMagazine();
+    if (index == kNilMagazine) return kNilMagazine;
+    void *slab = malloc(kAllocateBatchSize * block_size_);
+    if (!slab) {
+        empty_magazines_.push(this, index);
+        return kNilMagazine;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
         alloc_list_.push_back(slab);
-        for (size_t i = 0; i < kAllocateBatchSize; ++i)
-            tl_slice.enqueue((char *)slab + i * block_size_);
     }
+    auto mag = magazine(index);
+    for (size_t i = 0; i < kAllocateBatchSize; ++i)
+        mag->rounds[i] = (char *)slab + i * block_size_;
+    mag->count = kAllocateBatchSize;
+    return index;
+}
 
-    tl_slice.dequeue(object);
-    return object;
+void *SlabBase::allocate() {
+    auto &tl = tl_slice_set[slab_index_];
+    if (tl.loaded != kNilMagazine && !magazine(tl.loaded)->empty()) {
+        auto mag = magazine(tl.loaded);
+        return mag->rounds[--mag->count];
+    }
+    if (tl.previous != kNilMagazine && !magazine(tl.previous)->empty()) {
+        std::swap(tl.loaded, tl.previous);
+    } else {
+        auto index = refill();
+        if (index == kNilMagazine) return nullptr;
+        if (tl.loaded != kNilMagazine)
+            empty_magazines_.push(this, tl.loaded);
+        tl.loaded = index;
+    }
+    auto mag = magazine(tl.loaded);
+    return mag->rounds[--mag->count];
 }
 
 void SlabBase::deallocate(void *object) {
-    auto &tl_slice = tl_slice_set[slab_index_];
-    if (tl_slice.full()) {
-        std::lock_guard<std::mutex> global_lock(mutex_);
-        while (!tl_slice.empty()) {
-            void *object = nullptr;
-            tl_slice.dequeue(object);
-            free_list_.push_back(object);
+    auto &tl = tl_slice_set[slab_index_];
+    if (tl.loaded != kNilMagazine && !magazine(tl.loaded)->full()) {
+        auto mag = magazine(tl.loaded);
+        mag->rounds[mag->count++] = object;
+        return;
+    }
+    if (tl.previous != kNilMagazine && !magazine(tl.previous)->full()) {
+        std::swap(tl.loaded, tl.previous);
+    } else {
+        auto index = getEmptyMagazine();
+        if (index == kNilMagazine) {
+            // Out of magazines: the object stays out of circulation until
+            // the slab itself is destroyed
+            return;
         }
+        if (tl.previous != kNilMagazine)
+            full_magazines_.push(this, tl.previous);
+        tl.previous = tl.loaded;
+        tl.loaded = index;
     }
-    tl_slice.enqueue(object);
+    auto mag = magazine(tl.loaded);
+    mag->rounds[mag->count++] = object;
 }
 
 }  // namespace tent
-}  // namespace mooncake
\ No newline at end of file
+}  // namespace mooncake
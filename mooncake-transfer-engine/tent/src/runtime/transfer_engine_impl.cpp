@@ -33,6 +33,7 @@
 #include "tent/common/utils/random.h"
 #include "tent/metrics/tent_metrics.h"
 #include "tent/metrics/config_loader.h"
+#include "tent/metrics/transport_metrics.h"
 
 namespace mooncake {
 namespace tent {
@@ -204,7 +205,10 @@ Status TransferEngineImpl::construct() {
         }
     }
 
-    staging_proxy_ = std::make_unique<ProxyManager>(this);
+    staging_proxy_ = std::make_unique<ProxyManager>(
+        this, conf_->get("staging/chunk_size", 8ull << 20),
+        conf_->get("staging/chunk_count", 32ull),
+        conf_->get("staging/pipeline_depth", 4ull));
 
     // Initialize and start Metrics system
     auto metrics_config = MetricsConfigLoader::loadWithDefaults(conf_.get());
@@ -305,6 +309,27 @@ Status TransferEngineImpl::openSegment(SegmentID& handle,
     return metadata_->segmentManager().openRemote(handle, segment_name);
 }
 
+Status TransferEngineImpl::openSegments(
+    std::vector<SegmentID>& handles,
+    const std::vector<std::string>& segment_names) {
+    handles.assign(segment_names.size(), LOCAL_SEGMENT_ID);
+    std::vector<size_t> remote_index;
+    std::vector<std::string> remote_names;
+    for (size_t i = 0; i < segment_names.size(); ++i) {
+        auto& segment_name = segment_names[i];
+        if (segment_name.empty() || segment_name == local_segment_name_)
+            continue;
+        remote_index.push_back(i);
+        remote_names.push_back(segment_name);
+    }
+    std::vector<SegmentID> remote_handles;
+    CHECK_STATUS(metadata_->segmentManager().openRemote(remote_handles,
+                                                        remote_names));
+    for (size_t i = 0; i < remote_index.size(); ++i)
+        handles[remote_index[i]] = remote_handles[i];
+    return Status::OK();
+}
+
 Status TransferEngineImpl::closeSegment(SegmentID handle) {
     if (handle == LOCAL_SEGMENT_ID) return Status::OK();
     return metadata_->segmentManager().closeRemote(handle);
@@ -667,6 +692,7 @@ MergeResult mergeRequests(const std::vector<Request>& requests, bool do_merge) {
             char* curr_src = static_cast<char*>(item.req.source);
             uint64_t last_tgt_end = last.target_offset + last.length;
             if (last.opcode == item.req.opcode &&
+                last.traffic_class == item.req.traffic_class &&
                 last.target_id == item.req.target_id &&
                 last_src_end == curr_src &&
                 last_tgt_end == item.req.target_offset) {
@@ -899,6 +925,7 @@ Status TransferEngineImpl::submitTransfer(
 
 Status TransferEngineImpl::resubmitTransferTask(Batch* batch, size_t task_id) {
     auto& task = batch->task_list[task_id];
+    TransportMetrics::instance().recordRetry(task.type);
     if (task.staging)
         task.staging = false;
     else
@@ -1124,6 +1151,9 @@ void TransferEngineImpl::recordTaskCompletionMetrics(
                         task.request.length);
                 }
             }
+            TransportMetrics::instance().recordTransfer(
+                task.type, task.request.length, latency_seconds,
+                new_status != COMPLETED);
             // Reset start_time to prevent duplicate recording
             task.start_time = std::chrono::steady_clock::time_point{};
         }
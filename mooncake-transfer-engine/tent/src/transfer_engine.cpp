@@ -65,6 +65,12 @@ Status TransferEngine::openSegment(SegmentID& handle,
     return impl_->openSegment(handle, segment_name);
 }
 
+Status TransferEngine::openSegments(
+    std::vector<SegmentID>& handles,
+    const std::vector<std::string>& segment_names) {
+    return impl_->openSegments(handles, segment_names);
+}
+
 Status TransferEngine::closeSegment(SegmentID handle) {
     return impl_->closeSegment(handle);
 }
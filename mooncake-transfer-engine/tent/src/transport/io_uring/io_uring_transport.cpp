@@ -18,11 +18,13 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <iomanip>
 #include <memory>
+#include <vector>
 
 #include "tent/runtime/slab.h"
 #include "tent/common/utils/os.h"
@@ -65,7 +67,154 @@ class IOUringFileContext {
     bool ready_;
 };
 
-IOUringTransport::IOUringTransport() : installed_(false) {}
+// A long-lived ring owned by one submitting thread. Completions may be
+// reaped by any thread, so all ring access is serialized by |mutex|, which
+// is uncontended in the common case.
+class IOUringRing {
+   public:
+    IOUringRing(unsigned entries, bool sqpoll, unsigned sqpoll_idle_ms,
+                IOUringRing* attach_to)
+        : ready_(false), sqpoll_(false), fixed_files_(false) {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        if (sqpoll) {
+            params.flags |= IORING_SETUP_SQPOLL;
+            params.sq_thread_idle = sqpoll_idle_ms;
+            int rc = -EINVAL;
+            if (attach_to) {
+                params.flags |= IORING_SETUP_ATTACH_WQ;
+                params.wq_fd = attach_to->ring.ring_fd;
+                rc = io_uring_queue_init_params(entries, &ring, &params);
+                params.flags &= ~IORING_SETUP_ATTACH_WQ;
+            }
+            if (rc) rc = io_uring_queue_init_params(entries, &ring, &params);
+            if (rc == 0) {
+                ready_ = sqpoll_ = true;
+            } else {
+                // SQPOLL needs CAP_SYS_NICE before Linux 5.11
+                LOG_FIRST_N(WARNING, 1)
+                    << "IOUringTransport: SQPOLL unavailable ("
+                    << strerror(-rc) << "), using interrupt-driven rings";
+                memset(&params, 0, sizeof(params));
+            }
+        }
+        if (!ready_) {
+            int rc = io_uring_queue_init_params(entries, &ring, &params);
+            if (rc) {
+                LOG(ERROR) << "IOUringTransport: io_uring_queue_init failed: "
+                           << strerror(-rc);
+                return;
+            }
+            ready_ = true;
+        }
+        std::vector<int> fds(kMaxFixedFiles, -1);
+        fixed_files_ =
+            io_uring_register_files(&ring, fds.data(), kMaxFixedFiles) == 0;
+    }
+
+    IOUringRing(const IOUringRing&) = delete;
+    IOUringRing& operator=(const IOUringRing&) = delete;
+
+    ~IOUringRing() {
+        if (ready_) io_uring_queue_exit(&ring);
+    }
+
+    bool ready() const { return ready_; }
+
+    bool sqpoll() const { return sqpoll_; }
+
+    // Returns the fixed file slot of |fd|, or -1 if it must be used as is
+    int fixedFile(int fd) {
+        if (!fixed_files_) return -1;
+        auto it = file_slots_.find(fd);
+        if (it != file_slots_.end()) return it->second;
+        int slot = (int)file_slots_.size();
+        if (slot == kMaxFixedFiles ||
+            io_uring_register_files_update(&ring, slot, &fd, 1) != 1)
+            return -1;
+        file_slots_[fd] = slot;
+        return slot;
+    }
+
+    // Re-registers the fixed buffers if the transport's set changed
+    void syncBuffers(const std::vector<struct iovec>& buffers,
+                     uint64_t version) {
+        if (version == buffers_version_) return;
+        if (!buffers_.empty()) io_uring_unregister_buffers(&ring);
+        buffers_.clear();
+        buffers_version_ = version;
+        if (buffers.empty()) return;
+        int rc = io_uring_register_buffers(&ring, buffers.data(),
+                                           buffers.size());
+        if (rc) {
+            // Usually RLIMIT_MEMLOCK; plain reads and writes still work
+            LOG_FIRST_N(WARNING, 1)
+                << "IOUringTransport: failed to register fixed buffers: "
+                << strerror(-rc);
+            return;
+        }
+        buffers_ = buffers;
+    }
+
+    // Returns the fixed buffer covering [addr, addr + length), or -1
+    int findBuffer(const void* addr, size_t length) const {
+        auto start = (uint64_t)addr;
+        for (size_t i = 0; i < buffers_.size(); ++i) {
+            auto base = (uint64_t)buffers_[i].iov_base;
+            if (start >= base && start + length <= base + buffers_[i].iov_len)
+                return (int)i;
+        }
+        return -1;
+    }
+
+    // Drains all available completions, whichever batch they belong to
+    void reap() {
+        const static unsigned kReapBatch = 64;
+        struct io_uring_cqe* cqes[kReapBatch];
+        unsigned count;
+        while ((count = io_uring_peek_batch_cqe(&ring, cqes, kReapBatch))) {
+            for (unsigned i = 0; i < count; ++i) complete(cqes[i]);
+            io_uring_cq_advance(&ring, count);
+        }
+    }
+
+    std::mutex mutex;
+    struct io_uring ring;
+
+   private:
+    static void complete(struct io_uring_cqe* cqe) {
+        auto task = (IOUringTask*)io_uring_cqe_get_data(cqe);
+        if (!task) return;
+        if (cqe->res < 0) {
+            LOG(INFO) << "Received an event with error code " << cqe->res;
+            task->status_word = TransferStatusEnum::FAILED;
+            return;
+        }
+        if (task->buffer) {
+            if (task->request.opcode == Request::READ)
+                Platform::getLoader().copy(task->request.source, task->buffer,
+                                           task->request.length);
+            free(task->buffer);
+            task->buffer = nullptr;
+        }
+        task->transferred_bytes = task->request.length;
+        task->status_word = TransferStatusEnum::COMPLETED;
+    }
+
+   private:
+    const static int kMaxFixedFiles = 64;
+    bool ready_;
+    bool sqpoll_;
+    bool fixed_files_;
+    std::unordered_map<int, int> file_slots_;
+    std::vector<struct iovec> buffers_;
+    uint64_t buffers_version_ = 0;
+};
+
+static std::atomic<uint64_t> g_next_instance_id(0);
+
+IOUringTransport::IOUringTransport()
+    : installed_(false), instance_id_(g_next_instance_id.fetch_add(1)) {}
 
 IOUringTransport::~IOUringTransport() { uninstall(); }
 
@@ -86,6 +235,10 @@ Status IOUringTransport::install(std::string& local_segment_name,
     installed_ = true;
     async_memcpy_threshold_ =
         conf_->get("transports/nvlink/async_memcpy_threshold", 1024) * 1024;
+    queue_depth_ = conf_->get("transports/io_uring/queue_depth", 256);
+    sqpoll_ = conf_->get("transports/io_uring/sqpoll", true);
+    sqpoll_idle_ms_ = conf_->get("transports/io_uring/sqpoll_idle_ms", 1000);
+    fixed_buffers_ = conf_->get("transports/io_uring/fixed_buffers", true);
     caps.dram_to_file = true;
     if (Platform::getLoader().type() == "cuda") {
         caps.gpu_to_file = true;
@@ -108,6 +261,7 @@ Status IOUringTransport::probeCapabilities() {
 Status IOUringTransport::uninstall() {
     if (installed_) {
         metadata_.reset();
+        primary_ring_.reset();
         installed_ = false;
     }
     return Status::OK();
@@ -120,11 +274,6 @@ Status IOUringTransport::allocateSubBatch(SubBatchRef& batch, size_t max_size) {
     batch = io_uring_batch;
     io_uring_batch->max_size = max_size;
     io_uring_batch->task_list.reserve(max_size);
-    int rc = io_uring_queue_init(max_size, &io_uring_batch->ring, 0);
-    if (rc)
-        return Status::InternalError(
-            std::string("io_uring_queue_init failed: ") + strerror(-rc) +
-            LOC_MARK);
     return Status::OK();
 }
 
@@ -132,12 +281,38 @@ Status IOUringTransport::freeSubBatch(SubBatchRef& batch) {
     auto io_uring_batch = dynamic_cast<IOUringSubBatch*>(batch);
     if (!io_uring_batch)
         return Status::InvalidArgument("Invalid IO Uring sub-batch" LOC_MARK);
-    io_uring_queue_exit(&io_uring_batch->ring);
+    // In-flight completions still point to the tasks of this batch
+    if (io_uring_batch->ring) {
+        auto& ring = *io_uring_batch->ring;
+        for (auto& task : io_uring_batch->task_list) {
+            while (task.status_word == TransferStatusEnum::PENDING) {
+                std::lock_guard<std::mutex> lock(ring.mutex);
+                ring.reap();
+            }
+        }
+        io_uring_batch->ring.reset();
+    }
     Slab<IOUringSubBatch>::Get().deallocate(io_uring_batch);
     batch = nullptr;
     return Status::OK();
 }
 
+std::shared_ptr<IOUringRing> IOUringTransport::getRing() {
+    thread_local std::unordered_map<uint64_t, std::shared_ptr<IOUringRing>>
+        tl_ring_map;
+    auto& ring = tl_ring_map[instance_id_];
+    if (ring) return ring;
+    std::lock_guard<std::mutex> lock(primary_ring_mutex_);
+    ring = std::make_shared<IOUringRing>(queue_depth_, sqpoll_,
+                                         sqpoll_idle_ms_, primary_ring_.get());
+    if (!ring->ready()) {
+        ring.reset();
+        return nullptr;
+    }
+    if (!primary_ring_ && ring->sqpoll()) primary_ring_ = ring;
+    return ring;
+}
+
 std::string IOUringTransport::getIOUringFilePath(SegmentID target_id) {
     SegmentDesc* desc = nullptr;
     auto status = metadata_->segmentManager().getRemoteCached(desc, target_id);
@@ -172,6 +347,18 @@ Status IOUringTransport::submitTransferTasks(
     if (request_list.size() + (int)io_uring_batch->task_list.size() >
         io_uring_batch->max_size)
         return Status::TooManyRequests("Exceed batch capacity" LOC_MARK);
+    if (!io_uring_batch->ring) {
+        io_uring_batch->ring = getRing();
+        if (!io_uring_batch->ring)
+            return Status::InternalError("io_uring ring unavailable" LOC_MARK);
+    }
+    auto& ring = *io_uring_batch->ring;
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    if (fixed_buffers_) {
+        RWSpinlock::ReadGuard guard(buffer_lock_);
+        ring.syncBuffers(buffers_, buffers_version_);
+    }
+    Status status = Status::OK();
     for (auto& request : request_list) {
         io_uring_batch->task_list.push_back(IOUringTask{});
         auto& task =
@@ -180,46 +367,80 @@ Status IOUringTransport::submitTransferTasks(
         task.status_word = TransferStatusEnum::PENDING;
 
         IOUringFileContext* context = findFileContext(request.target_id);
-        if (!context || !context->ready())
-            return Status::InvalidArgument("Invalid remote segment" LOC_MARK);
+        if (!context || !context->ready()) {
+            task.status_word = TransferStatusEnum::FAILED;
+            status = Status::InvalidArgument("Invalid remote segment" LOC_MARK);
+            break;
+        }
 
-        struct io_uring_sqe* sqe = io_uring_get_sqe(&io_uring_batch->ring);
-        if (!sqe)
-            return Status::InternalError("io_uring_get_sqe failed" LOC_MARK);
+        // The SQ only fills up when a batch exceeds the queue depth: flush
+        // it and make room in the CQ before retrying
+        struct io_uring_sqe* sqe;
+        while (!(sqe = io_uring_get_sqe(&ring.ring))) {
+            int rc = io_uring_submit(&ring.ring);
+            if (rc < 0) break;
+            ring.reap();
+        }
+        if (!sqe) {
+            task.status_word = TransferStatusEnum::FAILED;
+            status = Status::InternalError("io_uring_get_sqe failed" LOC_MARK);
+            break;
+        }
 
+        void* buffer = request.source;
         const size_t kPageSize = 4096;
         if (Platform::getLoader().getMemoryType(request.source) == MTYPE_CUDA ||
             (uint64_t)request.source % kPageSize) {
             int rc = posix_memalign(&task.buffer, kPageSize, request.length);
-            if (rc)
-                return Status::InternalError("posix_memalign failed" LOC_MARK);
-
-            if (request.opcode == Request::READ)
-                io_uring_prep_read(sqe, context->getHandle(), task.buffer,
-                                   request.length, request.target_offset);
-            else if (request.opcode == Request::WRITE) {
+            if (rc) {
+                io_uring_prep_nop(sqe);
+                io_uring_sqe_set_data(sqe, nullptr);
+                task.status_word = TransferStatusEnum::FAILED;
+                status =
+                    Status::InternalError("posix_memalign failed" LOC_MARK);
+                break;
+            }
+            if (request.opcode == Request::WRITE)
                 Platform::getLoader().copy(task.buffer, request.source,
                                            request.length);
-                io_uring_prep_write(sqe, context->getHandle(), task.buffer,
-                                    request.length, request.target_offset);
-            }
-        } else {
-            if (request.opcode == Request::READ)
-                io_uring_prep_read(sqe, context->getHandle(), request.source,
+            buffer = task.buffer;
+        }
+
+        int buf_index = ring.findBuffer(buffer, request.length);
+        if (request.opcode == Request::READ) {
+            if (buf_index >= 0)
+                io_uring_prep_read_fixed(sqe, context->getHandle(), buffer,
+                                         request.length, request.target_offset,
+                                         buf_index);
+            else
+                io_uring_prep_read(sqe, context->getHandle(), buffer,
                                    request.length, request.target_offset);
-            else if (request.opcode == Request::WRITE)
-                io_uring_prep_write(sqe, context->getHandle(), request.source,
+        } else if (request.opcode == Request::WRITE) {
+            if (buf_index >= 0)
+                io_uring_prep_write_fixed(sqe, context->getHandle(), buffer,
+                                          request.length,
+                                          request.target_offset, buf_index);
+            else
+                io_uring_prep_write(sqe, context->getHandle(), buffer,
                                     request.length, request.target_offset);
         }
-        sqe->user_data = (uintptr_t)&task;
+        int slot = ring.fixedFile(context->getHandle());
+        if (slot >= 0) {
+            sqe->fd = slot;
+            sqe->flags |= IOSQE_FIXED_FILE;
+        }
+        io_uring_sqe_set_data(sqe, &task);
     }
 
-    int rc = io_uring_submit(&io_uring_batch->ring);
-    if (rc != (int32_t)request_list.size())
+    // Prepared SQEs are submitted even on failure, so that every pending
+    // task gets its completion. With SQPOLL this only wakes up the kernel
+    // thread if it went idle.
+    int rc = io_uring_submit(&ring.ring);
+    if (rc < 0 && status.ok())
         return Status::InternalError(std::string("io_uring_submit failed: ") +
                                      strerror(-rc) + LOC_MARK);
 
-    return Status::OK();
+    return status;
 }
 
 Status IOUringTransport::getTransferStatus(SubBatchRef batch, int task_id,
@@ -228,45 +449,40 @@ Status IOUringTransport::getTransferStatus(SubBatchRef batch, int task_id,
     if (task_id < 0 || task_id >= (int)io_uring_batch->task_list.size())
         return Status::InvalidArgument("Invalid task ID");
     auto& task = io_uring_batch->task_list[task_id];
-    status = TransferStatus{task.status_word, task.transferred_bytes};
-    if (task.status_word == TransferStatusEnum::PENDING) {
-        struct io_uring_cqe* cqe = nullptr;
-        int err = io_uring_peek_cqe(&io_uring_batch->ring, &cqe);
-        if (err == -EAGAIN) return Status::OK();
-        if (err || !cqe) {
-            return Status::InternalError(
-                std::string("io_uring_peek_cqe failed: ") + strerror(-err));
-        }
-        auto task = (IOUringTask*)cqe->user_data;
-        if (task) {
-            if (cqe->res < 0) {
-                LOG(INFO) << "Received an event with error code " << cqe->res;
-                task->status_word = TransferStatusEnum::FAILED;
-            } else {
-                if (task->buffer) {
-                    if (task->request.opcode == Request::READ)
-                        Platform::getLoader().copy(task->request.source,
-                                                   task->buffer,
-                                                   task->request.length);
-
-                    free(task->buffer);
-                    task->buffer = nullptr;
-                }
-                task->status_word = TransferStatusEnum::COMPLETED;
-                task->transferred_bytes = task->request.length;
-            }
-        }
-        io_uring_cqe_seen(&io_uring_batch->ring, cqe);
+    if (task.status_word == TransferStatusEnum::PENDING &&
+        io_uring_batch->ring) {
+        auto& ring = *io_uring_batch->ring;
+        // Another thread reaping this ring completes our tasks as well
+        std::unique_lock<std::mutex> lock(ring.mutex, std::try_to_lock);
+        if (lock.owns_lock()) ring.reap();
     }
+    status = TransferStatus{task.status_word, task.transferred_bytes};
     return Status::OK();
 }
 
 Status IOUringTransport::addMemoryBuffer(BufferDesc& desc,
                                          const MemoryOptions& options) {
+    // Fixed buffers must be host memory and at most 1 GiB each
+    const static uint64_t kMaxFixedBufferSize = 1ull << 30;
+    if (!fixed_buffers_ || desc.length > kMaxFixedBufferSize ||
+        Platform::getLoader().getMemoryType((void*)desc.addr) != MTYPE_CPU)
+        return Status::OK();
+    RWSpinlock::WriteGuard guard(buffer_lock_);
+    buffers_.push_back({(void*)desc.addr, desc.length});
+    ++buffers_version_;
     return Status::OK();
 }
 
 Status IOUringTransport::removeMemoryBuffer(BufferDesc& desc) {
+    RWSpinlock::WriteGuard guard(buffer_lock_);
+    auto it = std::find_if(buffers_.begin(), buffers_.end(),
+                           [&](const struct iovec& iov) {
+                               return (uint64_t)iov.iov_base == desc.addr;
+                           });
+    if (it != buffers_.end()) {
+        buffers_.erase(it);
+        ++buffers_version_;
+    }
     return Status::OK();
 }
 
@@ -111,6 +111,10 @@ Status MnnvlTransport::install(std::string &local_segment_name,
     async_memcpy_threshold_ =
         conf_->get("transports/nvlink/async_memcpy_threshold", 1024) * 1024 *
         128;
+    num_streams_ = std::clamp<size_t>(
+        conf_->get("transports/mnnvl/num_streams", 4), 1,
+        MnnvlTask::kMaxStripes);
+    stripe_size_ = conf_->get("transports/mnnvl/stripe_size", 4ull << 20);
 
     caps.dram_to_gpu = true;
     if (Platform::getLoader().type() == "cuda") caps.gpu_to_gpu = true;
@@ -138,11 +142,14 @@ Status MnnvlTransport::uninstall() {
 }
 
 struct CudaStreamMnnvlRAII {
-    cudaStream_t stream_;
+    cudaStream_t streams_[MnnvlTask::kMaxStripes];
     CudaStreamMnnvlRAII() {
-        cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking);
+        for (auto &stream : streams_)
+            cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking);
+    }
+    ~CudaStreamMnnvlRAII() {
+        for (auto &stream : streams_) cudaStreamDestroy(stream);
     }
-    ~CudaStreamMnnvlRAII() { cudaStreamDestroy(stream_); }
 };
 
 thread_local CudaStreamMnnvlRAII tl_stream_mnnvl;
@@ -154,7 +161,7 @@ Status MnnvlTransport::allocateSubBatch(SubBatchRef &batch, size_t max_size) {
     batch = mnnvl_batch;
     mnnvl_batch->task_list.reserve(max_size);
     mnnvl_batch->max_size = max_size;
-    mnnvl_batch->stream = tl_stream_mnnvl.stream_;
+    mnnvl_batch->streams = tl_stream_mnnvl.streams_;
     // CHECK_CUDA(cudaStreamCreateWithFlags(&mnnvl_batch->stream,
     // cudaStreamNonBlocking));
     return Status::OK();
@@ -164,7 +171,13 @@ Status MnnvlTransport::freeSubBatch(SubBatchRef &batch) {
     auto mnnvl_batch = dynamic_cast<MnnvlSubBatch *>(batch);
     if (!mnnvl_batch)
         return Status::InvalidArgument("Invalid MNNVL sub-batch" LOC_MARK);
-    // CHECK_CUDA(cudaStreamDestroy(mnnvl_batch->stream));
+    for (auto &task : mnnvl_batch->task_list) {
+        for (int i = 0; i < task.num_events; ++i) {
+            cudaEventSynchronize(task.events[i]);
+            cudaEventDestroy(task.events[i]);
+        }
+        task.num_events = 0;
+    }
     Slab<MnnvlSubBatch>::Get().deallocate(mnnvl_batch);
     batch = nullptr;
     return Status::OK();
@@ -212,7 +225,10 @@ void MnnvlTransport::startTransfer(MnnvlTask *task, MnnvlSubBatch *batch) {
         dst = (void *)task->target_addr;  // to remote
     }
 
-    bool is_async = (task->request.length >= async_memcpy_threshold_);
+    auto length = task->request.length;
+    size_t stripes = std::max<size_t>(
+        1, std::min<size_t>(num_streams_, length / stripe_size_));
+    bool is_async = length >= async_memcpy_threshold_ || stripes > 1;
 
     cudaPointerAttributes src_attr_info, dst_attr_info;
     cudaMemoryType src_type = cudaMemoryTypeHost, dst_type = cudaMemoryTypeHost;
@@ -248,9 +264,25 @@ void MnnvlTransport::startTransfer(MnnvlTask *task, MnnvlSubBatch *batch) {
         return;
     }
 
-    err = cudaMemcpyAsync(dst, src, task->request.length, kind, batch->stream);
-
-    if (err != cudaSuccess) task->status_word = TransferStatusEnum::FAILED;
+    // Each stream is served by its own copy engine where available
+    size_t stripe_length = (length + stripes - 1) / stripes;
+    for (size_t offset = 0; offset < length; offset += stripe_length) {
+        auto stream = batch->streams[task->num_events];
+        err = cudaMemcpyAsync((char *)dst + offset, (char *)src + offset,
+                              std::min(stripe_length, length - offset), kind,
+                              stream);
+        cudaEvent_t event;
+        if (err == cudaSuccess)
+            err = cudaEventCreateWithFlags(&event, cudaEventDisableTiming);
+        if (err == cudaSuccess) {
+            task->events[task->num_events++] = event;
+            err = cudaEventRecord(event, stream);
+        }
+        if (err != cudaSuccess) {
+            task->status_word = TransferStatusEnum::FAILED;
+            return;
+        }
+    }
 }
 
 Status MnnvlTransport::getTransferStatus(SubBatchRef batch, int task_id,
@@ -262,14 +294,21 @@ Status MnnvlTransport::getTransferStatus(SubBatchRef batch, int task_id,
     auto &task = mnnvl_batch->task_list[task_id];
     status = TransferStatus{task.status_word, task.transferred_bytes};
     if (task.status_word == TransferStatusEnum::PENDING) {
-        auto err = cudaStreamQuery(mnnvl_batch->stream);
-        if (err == cudaSuccess) {
-            cudaStreamSynchronize(mnnvl_batch->stream);
-            task.transferred_bytes = task.request.length;
-            task.status_word = TransferStatusEnum::COMPLETED;
-        } else if (err != cudaErrorNotReady) {
-            task.status_word = TransferStatusEnum::FAILED;
+        while (task.num_events) {
+            auto event = task.events[task.num_events - 1];
+            auto err = cudaEventQuery(event);
+            if (err == cudaErrorNotReady) return Status::OK();
+            cudaEventDestroy(event);
+            task.num_events--;
+            if (err != cudaSuccess) {
+                task.status_word = TransferStatusEnum::FAILED;
+                status.s = TransferStatusEnum::FAILED;
+                return Status::OK();
+            }
         }
+        task.transferred_bytes = task.request.length;
+        task.status_word = TransferStatusEnum::COMPLETED;
+        status = TransferStatus{task.status_word, task.transferred_bytes};
     }
     return Status::OK();
 }
@@ -173,17 +173,62 @@ Status DeviceQuota::release(int dev_id, uint64_t length, double latency) {
                         std::memory_order_relaxed);
         dev.beta1.store(std::clamp(new_beta1_g, 0.5, 20.0),
                         std::memory_order_relaxed);
-        if (shared_quota_) {
-            thread_local uint64_t tl_last_ts = 0;
-            uint64_t now = getCurrentTimeInNano();
-            if (now - tl_last_ts > diffusion_interval_) {
-                tl_last_ts = now;
-                return shared_quota_->diffusion();
-            }
-        }
+        return diffuse();
     }
     return Status::OK();
 }
 
+bool DeviceQuota::admit(int dev_id, TrafficClass traffic_class,
+                        uint64_t length) {
+    auto it = devices_.find(dev_id);
+    if (it == devices_.end()) return true;
+    auto& dev = it->second;
+    if (class_budget_ && traffic_class != kLatencyCritical) {
+        uint64_t bytes[kNumTrafficClasses], total_bytes = 0;
+        for (int i = 0; i < kNumTrafficClasses; ++i) {
+            bytes[i] =
+                dev.class_bytes[i].load(std::memory_order_relaxed) +
+                dev.diffusion_class_bytes[i].load(std::memory_order_relaxed);
+            total_bytes += bytes[i];
+        }
+        if (total_bytes + length > class_budget_) {
+            if (bytes[kLatencyCritical]) return false;
+            // Split the budget among the classes with posted bytes. A class
+            // alone on the device, or with nothing posted, always proceeds.
+            double active_weight = class_weights_[traffic_class];
+            for (int i = kLatencyCritical + 1; i < kNumTrafficClasses; ++i)
+                if (i != traffic_class && bytes[i])
+                    active_weight += class_weights_[i];
+            double share =
+                class_budget_ * class_weights_[traffic_class] / active_weight;
+            bool alone = bytes[traffic_class] == total_bytes;
+            if (!alone && bytes[traffic_class] &&
+                bytes[traffic_class] + length > share)
+                return false;
+        }
+    }
+    dev.class_bytes[traffic_class].fetch_add(length,
+                                             std::memory_order_relaxed);
+    return true;
+}
+
+Status DeviceQuota::complete(int dev_id, TrafficClass traffic_class,
+                             uint64_t length) {
+    auto it = devices_.find(dev_id);
+    if (it == devices_.end()) return Status::OK();
+    it->second.class_bytes[traffic_class].fetch_sub(length,
+                                                    std::memory_order_relaxed);
+    return diffuse();
+}
+
+Status DeviceQuota::diffuse() {
+    if (!shared_quota_) return Status::OK();
+    thread_local uint64_t tl_last_ts = 0;
+    uint64_t now = getCurrentTimeInNano();
+    if (now - tl_last_ts <= diffusion_interval_) return Status::OK();
+    tl_last_ts = now;
+    return shared_quota_->diffusion();
+}
+
 }  // namespace tent
 }  // namespace mooncake
\ No newline at end of file
@@ -39,11 +39,11 @@ bool RailMonitor::available(int local_nic, int remote_nic) {
             st.paused = false;
             st.error_count = 0;
             updateBestMapping();
-            return true;
+            return !st.slow;
         }
         return false;
     }
-    return true;
+    return !st.slow;
 }
 
 void RailMonitor::markFailed(int local_nic, int remote_nic) {
@@ -81,6 +81,78 @@ void RailMonitor::markRecovered(int local_nic, int remote_nic) {
     updateBestMapping();
 }
 
+// Latency of the slices below this size is mostly fixed overhead
+static const uint64_t kMinCostBytes = 64 * 1024;
+
+void RailMonitor::recordLatency(int local_nic, int remote_nic, uint64_t length,
+                                double latency) {
+    auto it = rail_states_.find(std::make_pair(local_nic, remote_nic));
+    if (it == rail_states_.end()) return;
+    auto &st = it->second;
+    double cost = latency / std::max(length, kMinCostBytes);
+    if (st.slow) {
+        double baseline = baselineCost(st);
+        if (baseline > 0 && cost > recover_factor_ * baseline) {
+            st.good_probes = 0;
+            return;
+        }
+        if (++st.good_probes < recover_probes_) return;
+        LOG(INFO) << "Rail " << local_->getNicName(local_nic) << " -> "
+                  << remote_->getNicName(remote_nic) << " recovered";
+        st.slow = false;
+        st.good_probes = 0;
+        st.samples = 0;
+        updateBestMapping();
+        return;
+    }
+    st.cost = st.samples ? (1 - cost_alpha_) * st.cost + cost_alpha_ * cost
+                         : cost;
+    if (++st.samples < min_samples_) return;
+    double baseline = baselineCost(st);
+    if (baseline > 0 && st.cost > slow_factor_ * baseline) {
+        LOG(WARNING) << "Rail " << local_->getNicName(local_nic) << " -> "
+                     << remote_->getNicName(remote_nic) << " is slow: "
+                     << st.cost * 1e9 << " ns/B vs. " << baseline * 1e9
+                     << " ns/B";
+        st.slow = true;
+        st.good_probes = 0;
+        st.next_probe = std::chrono::steady_clock::now() + probe_interval_;
+        updateBestMapping();
+    }
+}
+
+bool RailMonitor::slow(int local_nic, int remote_nic) {
+    auto it = rail_states_.find(std::make_pair(local_nic, remote_nic));
+    return it != rail_states_.end() && it->second.slow;
+}
+
+int RailMonitor::takeProbe(int local_nic) {
+    auto now = std::chrono::steady_clock::now();
+    for (auto &[rail, st] : rail_states_) {
+        if (rail.first != local_nic || !st.slow || st.paused ||
+            now < st.next_probe)
+            continue;
+        st.next_probe = now + probe_interval_;
+        return rail.second;
+    }
+    return -1;
+}
+
+// Median latency per byte of the other healthy rails with enough samples,
+// or 0 when there is none to compare with
+double RailMonitor::baselineCost(const RailState &self) {
+    std::vector<double> costs;
+    for (auto &[rail, st] : rail_states_) {
+        if (&st != &self && !st.slow && !st.paused &&
+            st.samples >= min_samples_)
+            costs.push_back(st.cost);
+    }
+    if (costs.empty()) return 0;
+    auto mid = costs.begin() + costs.size() / 2;
+    std::nth_element(costs.begin(), mid, costs.end());
+    return *mid;
+}
+
 int RailMonitor::findBestRemoteDevice(int local_nic, int remote_numa) {
     if (remote_numa >= 0 && remote_numa < (int)kMaxNuma) {
         if (best_mapping_[remote_numa].count(local_nic))
@@ -303,6 +303,8 @@ Status RdmaTransport::submitTransferTasks(
             slice->retry_count = 0;
             slice->ep_weak_ptr = nullptr;
             slice->word = PENDING;
+            slice->quota_admitted = false;
+            slice->rail_probe = false;
             slice->next = nullptr;
             slice->enqueue_ts = enqueue_ts;
             task.num_slices++;
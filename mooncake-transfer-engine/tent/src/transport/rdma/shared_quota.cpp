@@ -163,6 +163,8 @@ void SharedQuotaManager::reclaimDeadPidsInternal() {
                 // zero out slot — we'll recompute active_bytes in diffusion
                 dev.pid_usages[s].pid = 0;
                 dev.pid_usages[s].used_bytes = 0;
+                for (int c = 0; c < kNumTrafficClasses; ++c)
+                    dev.pid_usages[s].class_bytes[c] = 0;
             }
         }
     }
@@ -200,6 +202,7 @@ PidUsage* SharedQuotaManager::findOrCreatePidSlotLocked(int dev_id, pid_t pid) {
     if (empty) {
         empty->pid = pid;
         empty->used_bytes = 0;
+        for (int c = 0; c < kNumTrafficClasses; ++c) empty->class_bytes[c] = 0;
     }
     return empty;
 }
@@ -245,6 +248,10 @@ Status SharedQuotaManager::attachProcess() {
         if (hdr_->devices[i].dev_name[0] != '\0') ++count;
     hdr_->num_devices = count;
 
+    // The posted bytes of processes that died would defer the traffic of
+    // the others for good
+    reclaimDeadPidsInternal();
+
     unlock();
     return Status::OK();
 }
@@ -262,7 +269,7 @@ Status SharedQuotaManager::diffusion() {
         std::string dev_name = hdr_->devices[d].dev_name;
         auto dev_id = local_quota_->getTopology()->getNicId(dev_name);
         if (dev_name.empty() || dev_id < 0) continue;
-        PidUsage* slot = findOrCreatePidSlotLocked(dev_id, pid);
+        PidUsage* slot = findOrCreatePidSlotLocked(d, pid);
         if (!slot) {
             unlock();
             return Status::InternalError("no free pid slot for device");
@@ -276,6 +283,17 @@ Status SharedQuotaManager::diffusion() {
             sum < used_bytes ? 0 : sum - used_bytes;
         hdr_->devices[d].active_bytes = sum;
         local_quota_->setDiffusionActiveBytes(dev_id, diffusion_active_bytes);
+        for (int c = 0; c < kNumTrafficClasses; ++c) {
+            auto class_bytes = local_quota_->getClassBytes(dev_id, c);
+            slot->class_bytes[c] = class_bytes;
+            uint64_t class_sum = 0;
+            for (int s = 0; s < MAX_PID_SLOTS; ++s)
+                class_sum += hdr_->devices[d].pid_usages[s].class_bytes[c];
+            uint64_t diffusion_class_bytes =
+                class_sum < class_bytes ? 0 : class_sum - class_bytes;
+            local_quota_->setDiffusionClassBytes(dev_id, c,
+                                                 diffusion_class_bytes);
+        }
     }
     unlock();
     return Status::OK();
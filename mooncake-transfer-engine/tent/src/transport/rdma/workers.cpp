@@ -23,6 +23,7 @@
 #include "tent/common/utils/string_builder.h"
 #include "tent/common/utils/os.h"
 #include "tent/common/utils/random.h"
+#include "tent/metrics/transport_metrics.h"
 
 namespace mooncake {
 namespace tent {
@@ -46,6 +47,13 @@ Workers::Workers(RdmaTransport* transport)
     auto diffusion_interval =
         conf->get("transports/rdma/diffusion_interval", 10);
     device_quota_->setDiffusionInterval(diffusion_interval);
+    auto bulk_weight = conf->get("transports/rdma/bulk_weight", 4.0);
+    auto background_weight =
+        conf->get("transports/rdma/background_weight", 1.0);
+    device_quota_->setClassWeights(bulk_weight, background_weight);
+    auto class_budget =
+        conf->get("transports/rdma/class_budget_bytes", 64ull << 20);
+    device_quota_->setClassBudget(class_budget);
 }
 
 Workers::~Workers() {
@@ -194,8 +202,79 @@ void Workers::disableEndpoint(RdmaSlice* slice) {
     }
 }
 
+void Workers::recordRailLatency(RdmaSlice* slice, double latency) {
+    SegmentDesc* desc = nullptr;
+    auto& segment_manager = transport_->metadata_->segmentManager();
+    auto target_id = slice->task->request.target_id;
+    if (target_id == LOCAL_SEGMENT_ID) {
+        desc = segment_manager.getLocal().get();
+    } else {
+        auto status = segment_manager.getRemoteCached(desc, target_id);
+        if (!status.ok()) return;
+    }
+    if (!desc) return;
+    auto& worker = worker_context_[tl_wid];
+    auto it = worker.rails.find(desc->machine_id);
+    if (it == worker.rails.end() || !it->second.ready()) return;
+    it->second.recordLatency(slice->source_dev_id, slice->target_dev_id,
+                             slice->length, latency);
+}
+
+void Workers::recordRailMetrics(RdmaSlice* slice, double queue_us,
+                                double latency_us) {
+    if (!TransportMetrics::active()) return;
+    auto& worker = worker_context_[tl_wid];
+    auto target_id = slice->task->request.target_id;
+    uint64_t key = (target_id << 16) |
+                   (uint64_t)(slice->source_dev_id & 0xff) << 8 |
+                   (uint64_t)(slice->target_dev_id & 0xff);
+    auto& stats = worker.rail_stats[key];
+    if (!stats) {
+        SegmentDesc* desc = nullptr;
+        auto& segment_manager = transport_->metadata_->segmentManager();
+        if (target_id == LOCAL_SEGMENT_ID) {
+            desc = segment_manager.getLocal().get();
+        } else if (!segment_manager.getRemoteCached(desc, target_id).ok()) {
+            return;
+        }
+        if (!desc || desc->type != SegmentType::Memory) return;
+        stats = TransportMetrics::instance().rail(
+            transport_->context_set_[slice->source_dev_id]->name(), desc->name,
+            desc->getMemory().topology.getNicName(slice->target_dev_id));
+        if (!stats) return;
+    }
+    stats->bytes.add(slice->length);
+    stats->slices.add(1);
+    stats->queue_delay.observe(queue_us);
+    stats->latency.observe(latency_us);
+}
+
+void Workers::releaseAdmission(RdmaSlice* slice) {
+    if (!slice->quota_admitted) return;
+    slice->quota_admitted = false;
+    device_quota_->complete(slice->source_dev_id,
+                            slice->task->request.traffic_class, slice->length);
+}
+
 void Workers::asyncPostSend() {
     auto& worker = worker_context_[tl_wid];
+    auto admit = [&](const PostPath& path, RdmaSlice* slice) -> bool {
+        if (!device_quota_->admit(slice->source_dev_id,
+                                  slice->task->request.traffic_class,
+                                  slice->length))
+            return false;
+        slice->quota_admitted = true;
+        worker.requests[path].push_back(slice);
+        return true;
+    };
+    // Deferred slices go first, so a class keeps its order
+    size_t num_deferred = worker.deferred.size();
+    for (size_t i = 0; i < num_deferred; ++i) {
+        auto [path, slice] = worker.deferred.front();
+        worker.deferred.pop_front();
+        if (!admit(path, slice)) worker.deferred.emplace_back(path, slice);
+    }
+
     std::vector<RdmaSliceList> result;
     worker.queue.pop(result);
     for (auto& slice_list : result) {
@@ -212,7 +291,8 @@ void Workers::asyncPostSend() {
                     .local_device_id = slice->source_dev_id,
                     .remote_segment_id = slice->task->request.target_id,
                     .remote_device_id = slice->target_dev_id};
-                worker.requests[path].push_back(slice);
+                if (!admit(path, slice))
+                    worker.deferred.emplace_back(path, slice);
             }
             slice = slice->next;
         }
@@ -227,7 +307,9 @@ void Workers::asyncPostSend() {
             std::vector<RdmaSlice*> clone;
             slices.swap(clone);
             for (auto slice : clone) {
+                releaseAdmission(slice);
                 slice->retry_count++;
+                TransportMetrics::instance().recordRetry(RDMA);
                 if (slice->retry_count >=
                     transport_->params_->workers.max_retry_count) {
                     LOG(WARNING)
@@ -245,7 +327,9 @@ void Workers::asyncPostSend() {
         for (int id = 0; id < num_submitted; ++id) {
             auto slice = slices[id];
             if (slice->failed) {
+                releaseAdmission(slice);
                 slice->retry_count++;
+                TransportMetrics::instance().recordRetry(RDMA);
                 if (slice->retry_count >=
                     transport_->params_->workers.max_retry_count) {
                     LOG(WARNING)
@@ -284,6 +368,7 @@ void Workers::asyncPollCq() {
             LOG(WARNING) << "Slice " << slice
                          << " failed: transfer timeout (software)";
             auto num_slices = ep->acknowledge(slice, TIMEOUT);
+            releaseAdmission(slice);
             disableEndpoint(slice);
             worker.inflight_slices.fetch_sub(num_slices);
             slice_to_remove.push_back(slice);
@@ -310,6 +395,7 @@ void Workers::asyncPollCq() {
                 device_quota_->release(slice->source_dev_id, slice->length,
                                        overall_lat_sec);
             }
+            releaseAdmission(slice);
             if (slice->word != PENDING) continue;
             if (wc[i].status != IBV_WC_SUCCESS) {
                 if (wc[i].status != IBV_WC_WR_FLUSH_ERR) {
@@ -323,6 +409,7 @@ void Workers::asyncPollCq() {
                               << "): " << ibv_wc_status_str(wc[i].status);
                 }
                 slice->retry_count++;
+                TransportMetrics::instance().recordRetry(RDMA);
                 if (slice->retry_count >=
                     transport_->params_->workers.max_retry_count) {
                     LOG(WARNING)
@@ -338,6 +425,12 @@ void Workers::asyncPollCq() {
                 num_slices += ep->acknowledge(slice, COMPLETED);
                 worker.perf.inflight_lat.add(inflight_lat);
                 worker.perf.enqueue_lat.add(enqueue_lat);
+                recordRailMetrics(slice, enqueue_lat, inflight_lat);
+                // Every probe and a sample of the other slices
+                const static uint64_t kRailSampleInterval = 16;
+                if (slice->rail_probe ||
+                    ++worker.rail_samples % kRailSampleInterval == 0)
+                    recordRailLatency(slice, inflight_lat / 1e6);
             }
         }
     }
@@ -508,6 +601,14 @@ Status Workers::selectOptimalDevice(RouteHint& source, RouteHint& target,
     auto& rail = worker.rails[target.segment->machine_id];
     if (!rail.ready() || target.topo != rail.remote())
         rail.load(source.topo, target.topo);
+    slice->rail_probe = false;
+    if (slice->target_dev_id < 0) {
+        int probe_dev_id = rail.takeProbe(slice->source_dev_id);
+        if (probe_dev_id >= 0 && getDeviceRank(target, probe_dev_id) >= 0) {
+            slice->target_dev_id = probe_dev_id;
+            slice->rail_probe = true;
+        }
+    }
     if (slice->target_dev_id < 0) {
         int mapped_dev_id = rail.findBestRemoteDevice(
             slice->source_dev_id, target.topo_entry->numa_node);
@@ -554,7 +655,8 @@ Status Workers::selectOptimalDevice(RouteHint& source, RouteHint& target,
         return Status::DeviceNotFound(
             "No device could access the slice memory region" LOC_MARK);
 
-    if (!rail.available(slice->source_dev_id, slice->target_dev_id)) {
+    if (!slice->rail_probe &&
+        !rail.available(slice->source_dev_id, slice->target_dev_id)) {
         LOG(INFO) << "Optimal device pair not available: source_dev_id "
                   << slice->source_dev_id << ", target_dev_id "
                   << slice->target_dev_id;
@@ -576,6 +678,7 @@ int Workers::getDeviceByFlatIndex(const RouteHint& hint, size_t flat_idx) {
 Status Workers::selectFallbackDevice(RouteHint& source, RouteHint& target,
                                      RdmaSlice* slice) {
     LOG_EVERY_N(INFO, 100) << "fallback device selection for slice " << slice;
+    slice->rail_probe = false;
     bool same_machine =
         (source.segment->machine_id == target.segment->machine_id);
 
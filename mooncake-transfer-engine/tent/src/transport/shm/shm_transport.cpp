@@ -16,14 +16,21 @@
 
 #include <bits/stdint-uintn.h>
 #include <glog/logging.h>
+#include <numa.h>
+#include <numaif.h>
 #include <sys/mman.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <iomanip>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "tent/common/status.h"
 #include "tent/runtime/slab.h"
@@ -34,6 +41,88 @@
 namespace mooncake {
 namespace tent {
 
+// Per NUMA node queues of copy jobs. Workers are bound to the CPUs of
+// their node, so that large copies write through the local memory
+// controller of the destination instead of crossing the interconnect.
+class ShmCopyWorkers {
+   public:
+    struct Job {
+        ShmTask *task;
+        void *dst;
+        void *src;
+        size_t length;
+    };
+
+    ShmCopyWorkers(int num_nodes, size_t threads_per_node)
+        : running_(true), nodes_(num_nodes) {
+        for (int node = 0; node < num_nodes; ++node) {
+            for (size_t i = 0; i < threads_per_node; ++i)
+                nodes_[node].threads.emplace_back(&ShmCopyWorkers::run, this,
+                                                  node);
+        }
+    }
+
+    ~ShmCopyWorkers() {
+        running_ = false;
+        for (auto &node : nodes_) {
+            node.cv.notify_all();
+            for (auto &thread : node.threads) thread.join();
+        }
+    }
+
+    size_t threadsPerNode() const { return nodes_[0].threads.size(); }
+
+    void submit(int node, const std::vector<Job> &jobs) {
+        if (node < 0 || node >= (int)nodes_.size()) node = 0;
+        auto &entry = nodes_[node];
+        {
+            std::lock_guard<std::mutex> lock(entry.mutex);
+            for (auto &job : jobs) entry.jobs.push(job);
+        }
+        entry.cv.notify_all();
+    }
+
+   private:
+    void run(int node) {
+        numa_run_on_node(node);
+        auto &entry = nodes_[node];
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(entry.mutex);
+                entry.cv.wait(
+                    lock, [&] { return !running_ || !entry.jobs.empty(); });
+                if (entry.jobs.empty()) return;
+                job = entry.jobs.front();
+                entry.jobs.pop();
+            }
+            auto status =
+                Platform::getLoader().copy(job.dst, job.src, job.length);
+            auto task = job.task;
+            if (!status.ok()) task->failed = true;
+            if (__atomic_sub_fetch(&task->pending_chunks, 1,
+                                   __ATOMIC_ACQ_REL) == 0) {
+                if (task->failed) {
+                    task->status_word = TransferStatusEnum::FAILED;
+                } else {
+                    task->transferred_bytes = task->request.length;
+                    task->status_word = TransferStatusEnum::COMPLETED;
+                }
+            }
+        }
+    }
+
+    struct Node {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::queue<Job> jobs;
+        std::vector<std::thread> threads;
+    };
+
+    std::atomic<bool> running_;
+    std::vector<Node> nodes_;
+};
+
 ShmTransport::ShmTransport() : installed_(false) {}
 
 ShmTransport::~ShmTransport() { uninstall(); }
@@ -54,12 +143,21 @@ Status ShmTransport::install(std::string &local_segment_name,
     machine_id_ = metadata->segmentManager().getLocal()->machine_id;
     installed_ = true;
     cxl_mount_path_ = conf_->get("transports/shm/cxl_mount_path", "");
+    offload_threshold_ =
+        conf_->get("transports/shm/offload_threshold", 256ull << 10);
+    split_size_ = conf_->get("transports/shm/split_size", 4ull << 20);
+    size_t threads_per_node =
+        conf_->get("transports/shm/copy_threads_per_node", 4);
+    if (threads_per_node && numa_available() >= 0)
+        copy_workers_ = std::make_unique<ShmCopyWorkers>(
+            numa_num_configured_nodes(), threads_per_node);
     caps.dram_to_dram = true;
     return Status::OK();
 }
 
 Status ShmTransport::uninstall() {
     if (installed_) {
+        copy_workers_.reset();
         metadata_.reset();
         for (auto &relocate_map : relocate_map_) {
             for (auto &entry : relocate_map.second) {
@@ -87,6 +185,11 @@ Status ShmTransport::freeSubBatch(SubBatchRef &batch) {
     auto shm_batch = dynamic_cast<ShmSubBatch *>(batch);
     if (!shm_batch)
         return Status::InvalidArgument("Invalid SHM sub-batch" LOC_MARK);
+    // Copy workers may still be writing to the tasks
+    for (auto &task : shm_batch->task_list) {
+        while (__atomic_load_n(&task.pending_chunks, __ATOMIC_ACQUIRE))
+            std::this_thread::yield();
+    }
     Slab<ShmSubBatch>::Get().deallocate(shm_batch);
     batch = nullptr;
     return Status::OK();
@@ -116,18 +219,41 @@ Status ShmTransport::submitTransferTasks(
     return Status::OK();
 }
 
+// Returns the NUMA node backing |addr|, or -1 if unknown
+static int getNumaNode(void *addr) {
+    const static uintptr_t kPageMask = ~(uintptr_t)4095;
+    void *page = (void *)((uintptr_t)addr & kPageMask);
+    int node = -1;
+    if (numa_move_pages(0, 1, &page, nullptr, &node, 0) != 0) return -1;
+    return node;
+}
+
 void ShmTransport::startTransfer(ShmTask *task, ShmSubBatch *batch) {
-    Status status;
-    if (task->request.opcode == Request::READ)
-        status = Platform::getLoader().copy(task->request.source,
-                                            (void *)task->target_addr,
-                                            task->request.length);
-    else
-        status = Platform::getLoader().copy((void *)task->target_addr,
-                                            task->request.source,
-                                            task->request.length);
+    void *dst, *src;
+    if (task->request.opcode == Request::READ) {
+        dst = task->request.source;
+        src = (void *)task->target_addr;
+    } else {
+        dst = (void *)task->target_addr;
+        src = task->request.source;
+    }
+    auto length = task->request.length;
+    if (copy_workers_ && length >= offload_threshold_) {
+        auto chunks = std::min(copy_workers_->threadsPerNode(),
+                               (length + split_size_ - 1) / split_size_);
+        auto chunk_size = (length + chunks - 1) / chunks;
+        std::vector<ShmCopyWorkers::Job> jobs;
+        for (size_t offset = 0; offset < length; offset += chunk_size)
+            jobs.push_back({task, (char *)dst + offset, (char *)src + offset,
+                            std::min(chunk_size, length - offset)});
+        task->pending_chunks = jobs.size();
+        copy_workers_->submit(getNumaNode(dst), jobs);
+        return;
+    }
+
+    auto status = Platform::getLoader().copy(dst, src, length);
     if (status.ok()) {
-        task->transferred_bytes = task->request.length;
+        task->transferred_bytes = length;
         task->status_word = TransferStatusEnum::COMPLETED;
     } else {
         task->status_word = TransferStatusEnum::FAILED;
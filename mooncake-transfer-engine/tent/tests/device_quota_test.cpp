@@ -0,0 +1,106 @@
+// Copyright 2025 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "tent/transport/rdma/quota.h"
+
+namespace mooncake {
+namespace tent {
+namespace {
+
+const uint64_t kBudget = 1000;
+
+class DeviceQuotaTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        // One RDMA NIC close to the host memory
+        auto topology = std::make_shared<Topology>();
+        ASSERT_TRUE(topology
+                        ->parse(R"({
+            "nics": [{"name": "mlx5_0", "type": 0, "numa_node": 0}],
+            "mems": [{"name": "cpu:0", "type": 0, "numa_node": 0,
+                      "device_list": {"rank0": [0]}}]
+        })")
+                        .ok());
+        ASSERT_TRUE(quota_.loadTopology(topology).ok());
+        quota_.setClassBudget(kBudget);
+        quota_.setClassWeights(3.0, 1.0);
+    }
+
+    DeviceQuota quota_;
+};
+
+TEST_F(DeviceQuotaTest, AdmitsEverythingWithinBudget) {
+    EXPECT_TRUE(quota_.admit(0, kBackground, 400));
+    EXPECT_TRUE(quota_.admit(0, kBulk, 400));
+    EXPECT_TRUE(quota_.admit(0, kLatencyCritical, 200));
+    EXPECT_EQ(quota_.getClassBytes(0, kBackground), 400u);
+    EXPECT_EQ(quota_.getClassBytes(0, kBulk), 400u);
+    EXPECT_EQ(quota_.getClassBytes(0, kLatencyCritical), 200u);
+}
+
+TEST_F(DeviceQuotaTest, ClassAloneIsNotThrottled) {
+    for (int i = 0; i < 10; ++i) EXPECT_TRUE(quota_.admit(0, kBulk, 500));
+    EXPECT_EQ(quota_.getClassBytes(0, kBulk), 5000u);
+}
+
+TEST_F(DeviceQuotaTest, LatencyClassPreemptsOthers) {
+    ASSERT_TRUE(quota_.admit(0, kLatencyCritical, 600));
+    ASSERT_TRUE(quota_.admit(0, kBulk, 300));
+    // Over the budget the latency class proceeds and the others wait
+    EXPECT_TRUE(quota_.admit(0, kLatencyCritical, 600));
+    EXPECT_FALSE(quota_.admit(0, kBulk, 300));
+    EXPECT_FALSE(quota_.admit(0, kBackground, 300));
+
+    ASSERT_TRUE(quota_.complete(0, kLatencyCritical, 600).ok());
+    ASSERT_TRUE(quota_.complete(0, kLatencyCritical, 600).ok());
+    EXPECT_TRUE(quota_.admit(0, kBulk, 300));
+}
+
+TEST_F(DeviceQuotaTest, BulkAndBackgroundShareByWeight) {
+    // Bulk owns the device, background still gets its first slice in
+    ASSERT_TRUE(quota_.admit(0, kBulk, 900));
+    EXPECT_TRUE(quota_.admit(0, kBackground, 200));
+    // Shares are 750 and 250 bytes
+    EXPECT_FALSE(quota_.admit(0, kBackground, 100));
+    EXPECT_FALSE(quota_.admit(0, kBulk, 100));
+
+    ASSERT_TRUE(quota_.complete(0, kBulk, 900).ok());
+    ASSERT_TRUE(quota_.admit(0, kBulk, 500));
+    EXPECT_TRUE(quota_.admit(0, kBulk, 250));
+    EXPECT_FALSE(quota_.admit(0, kBulk, 100));
+    EXPECT_FALSE(quota_.admit(0, kBackground, 100));
+}
+
+TEST_F(DeviceQuotaTest, OtherProcessesCount) {
+    // A bulk process elsewhere on the node keeps the device busy
+    quota_.setDiffusionClassBytes(0, kBulk, 900);
+    EXPECT_TRUE(quota_.admit(0, kBackground, 200));
+    EXPECT_FALSE(quota_.admit(0, kBackground, 100));
+    quota_.setDiffusionClassBytes(0, kLatencyCritical, 100);
+    EXPECT_FALSE(quota_.admit(0, kBulk, 1));
+}
+
+TEST_F(DeviceQuotaTest, ZeroBudgetDisablesAdmission) {
+    quota_.setClassBudget(0);
+    ASSERT_TRUE(quota_.admit(0, kLatencyCritical, 5000));
+    EXPECT_TRUE(quota_.admit(0, kBackground, 5000));
+}
+
+}  // namespace
+}  // namespace tent
+}  // namespace mooncake
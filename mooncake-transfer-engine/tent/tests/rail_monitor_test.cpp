@@ -0,0 +1,106 @@
+// Copyright 2025 KVCache.AI
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "tent/transport/rdma/rail_monitor.h"
+
+namespace mooncake {
+namespace tent {
+namespace {
+
+const uint64_t kLength = 1 << 20;
+const double kFastLatency = 100e-6, kSlowLatency = 1e-3;
+
+class RailMonitorTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        // Two RDMA NICs on each side
+        const char *topology = R"({
+            "nics": [{"name": "mlx5_0", "type": 0, "numa_node": 0},
+                     {"name": "mlx5_1", "type": 0, "numa_node": 0}]
+        })";
+        ASSERT_TRUE(local_.parse(topology).ok());
+        ASSERT_TRUE(remote_.parse(topology).ok());
+        ASSERT_TRUE(monitor_.load(&local_, &remote_).ok());
+    }
+
+    // Runs traffic over all four rails with mlx5_1 -> mlx5_1 slow
+    void degradeRail(int rounds) {
+        for (int i = 0; i < rounds; ++i) {
+            monitor_.recordLatency(0, 0, kLength, kFastLatency);
+            monitor_.recordLatency(0, 1, kLength, kFastLatency);
+            monitor_.recordLatency(1, 0, kLength, kFastLatency);
+            monitor_.recordLatency(1, 1, kLength, kSlowLatency);
+        }
+    }
+
+    Topology local_, remote_;
+    RailMonitor monitor_;
+};
+
+TEST_F(RailMonitorTest, MarksOutlierRailSlow) {
+    degradeRail(8);
+    EXPECT_FALSE(monitor_.slow(1, 1));
+    degradeRail(8);
+    EXPECT_TRUE(monitor_.slow(1, 1));
+    EXPECT_FALSE(monitor_.available(1, 1));
+    EXPECT_TRUE(monitor_.available(1, 0));
+    EXPECT_FALSE(monitor_.slow(0, 0));
+    // New slices of mlx5_1 go to the healthy remote NIC
+    EXPECT_EQ(monitor_.findBestRemoteDevice(1, 0), 0);
+}
+
+TEST_F(RailMonitorTest, SlowProbesKeepRailExcluded) {
+    degradeRail(16);
+    ASSERT_TRUE(monitor_.slow(1, 1));
+    EXPECT_EQ(monitor_.takeProbe(1), -1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    EXPECT_EQ(monitor_.takeProbe(0), -1);
+    EXPECT_EQ(monitor_.takeProbe(1), 1);
+    EXPECT_EQ(monitor_.takeProbe(1), -1);
+    for (int i = 0; i < 10; ++i)
+        monitor_.recordLatency(1, 1, kLength, kSlowLatency);
+    EXPECT_TRUE(monitor_.slow(1, 1));
+}
+
+TEST_F(RailMonitorTest, FastProbesReadmitRail) {
+    degradeRail(16);
+    ASSERT_TRUE(monitor_.slow(1, 1));
+    monitor_.recordLatency(1, 1, kLength, kFastLatency);
+    monitor_.recordLatency(1, 1, kLength, kFastLatency);
+    EXPECT_TRUE(monitor_.slow(1, 1));
+    monitor_.recordLatency(1, 1, kLength, kFastLatency);
+    EXPECT_FALSE(monitor_.slow(1, 1));
+    EXPECT_TRUE(monitor_.available(1, 1));
+}
+
+TEST_F(RailMonitorTest, UniformLatencyIsHealthy) {
+    for (int i = 0; i < 64; ++i) {
+        for (int local_nic = 0; local_nic < 2; ++local_nic)
+            for (int remote_nic = 0; remote_nic < 2; ++remote_nic)
+                monitor_.recordLatency(local_nic, remote_nic, kLength,
+                                       kFastLatency * (1 + i % 3));
+    }
+    for (int local_nic = 0; local_nic < 2; ++local_nic)
+        for (int remote_nic = 0; remote_nic < 2; ++remote_nic)
+            EXPECT_FALSE(monitor_.slow(local_nic, remote_nic));
+}
+
+}  // namespace
+}  // namespace tent
+}  // namespace mooncake
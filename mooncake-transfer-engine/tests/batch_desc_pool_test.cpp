@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "transport/transport.h"
+
+// Counts the allocations of the calling thread while enabled
+static thread_local bool count_allocations = false;
+static thread_local size_t allocation_count = 0;
+
+void *operator new(size_t size) {
+    if (count_allocations) allocation_count++;
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+// Slices and tasks are over-aligned
+void *operator new(size_t size, std::align_val_t align) {
+    if (count_allocations) allocation_count++;
+    size_t alignment = static_cast<size_t>(align);
+    size = (size + alignment - 1) / alignment * alignment;
+    void *ptr = std::aligned_alloc(alignment, size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+using namespace mooncake;
+
+// Copies local memory, completing the slices on submission the way the
+// workers of real transports do later
+class MemcpyTransport : public Transport {
+   public:
+    static const size_t kSliceSize = 4096;
+
+    Status submitTransfer(
+        BatchID batch_id,
+        const std::vector<TransferRequest> &entries) override {
+        auto &batch_desc = toBatchDesc(batch_id);
+        if (batch_desc.task_list.size() + entries.size() >
+            batch_desc.batch_size)
+            return Status::TooManyRequests("Exceed the batch capacity");
+        size_t task_id = batch_desc.task_list.size();
+        batch_desc.addTasks(entries.size());
+        for (auto &request : entries) {
+            auto &task = batch_desc.task_list[task_id++];
+            task.batch_id = batch_id;
+            task.request = &request;
+            for (uint64_t offset = 0; offset < request.length;
+                 offset += kSliceSize) {
+                Slice *slice = getSliceCache().allocate();
+                slice->source_addr = (char *)request.source + offset;
+                slice->length = std::min(kSliceSize, request.length - offset);
+                slice->task = &task;
+                slice->status = Slice::PENDING;
+                task.slice_list.push_back(slice);
+                __sync_fetch_and_add(&task.slice_count, 1);
+                task.total_bytes += slice->length;
+            }
+        }
+        for (size_t id = task_id - entries.size(); id < task_id; ++id) {
+            auto &task = batch_desc.task_list[id];
+            for (auto slice : task.slice_list) {
+                uint64_t offset =
+                    (char *)slice->source_addr - (char *)task.request->source;
+                memcpy((char *)task.request->target_offset + offset,
+                       slice->source_addr, slice->length);
+                slice->markSuccess();
+            }
+        }
+        return Status::OK();
+    }
+
+    Status getTransferStatus(BatchID batch_id, size_t task_id,
+                             TransferStatus &status) override {
+        auto &task = toBatchDesc(batch_id).task_list[task_id];
+        status.transferred_bytes = task.transferred_bytes;
+        if (task.success_slice_count + task.failed_slice_count ==
+            task.slice_count) {
+            status.s = task.failed_slice_count ? FAILED : COMPLETED;
+            task.is_finished = true;
+        } else {
+            status.s = WAITING;
+        }
+        return Status::OK();
+    }
+
+   private:
+    int registerLocalMemory(void *, size_t, const std::string &, bool,
+                            bool) override {
+        return 0;
+    }
+    int unregisterLocalMemory(void *, bool) override { return 0; }
+    int registerLocalMemoryBatch(const std::vector<BufferEntry> &,
+                                 const std::string &) override {
+        return 0;
+    }
+    int unregisterLocalMemoryBatch(const std::vector<void *> &) override {
+        return 0;
+    }
+    const char *getName() const override { return "memcpy"; }
+};
+
+// Allocates a batch, copies through it and frees it, returning whether all
+// tasks completed
+bool runCycle(Transport &transport,
+              const std::vector<Transport::TransferRequest> &requests) {
+    auto batch_id = transport.allocateBatchID(requests.size());
+    if (!transport.submitTransfer(batch_id, requests).ok()) return false;
+    bool completed = true;
+    for (size_t task_id = 0; task_id < requests.size(); ++task_id) {
+        Transport::TransferStatus status;
+        transport.getTransferStatus(batch_id, task_id, status);
+        completed &= status.s == Transport::COMPLETED;
+    }
+    return transport.freeBatchID(batch_id).ok() && completed;
+}
+
+TEST(BatchDescPoolTest, SteadyStateCycleDoesNotAllocate) {
+    const size_t kTasks = 16, kTaskLength = 4 * MemcpyTransport::kSliceSize;
+    const int kWarmupCycles = 16, kCycles = 100000;
+    std::vector<char> source(kTasks * kTaskLength, 'a');
+    std::vector<char> target(kTasks * kTaskLength, 0);
+    std::vector<Transport::TransferRequest> requests(kTasks);
+    for (size_t i = 0; i < kTasks; ++i) {
+        requests[i].opcode = Transport::TransferRequest::WRITE;
+        requests[i].source = source.data() + i * kTaskLength;
+        requests[i].target_id = 0;
+        requests[i].target_offset =
+            (uint64_t)(target.data() + i * kTaskLength);
+        requests[i].length = kTaskLength;
+    }
+
+    MemcpyTransport transport;
+    for (int i = 0; i < kWarmupCycles; ++i)
+        ASSERT_TRUE(runCycle(transport, requests));
+    EXPECT_EQ(source, target);
+
+    allocation_count = 0;
+    count_allocations = true;
+    auto start = std::chrono::steady_clock::now();
+    bool completed = true;
+    for (int i = 0; i < kCycles; ++i)
+        completed &= runCycle(transport, requests);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    count_allocations = false;
+
+    EXPECT_TRUE(completed);
+    EXPECT_EQ(allocation_count, 0u);
+    LOG(INFO) << kCycles << " cycles of " << kTasks << " tasks, "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                         .count() /
+                     kCycles
+              << " ns per cycle, " << allocation_count << " allocations";
+}
+
+}  // namespace
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "transport/nvmeof_transport/batch_size_tuner.h"
+
+namespace {
+
+using namespace mooncake;
+using Clock = BatchSizeTuner::Clock;
+
+// Runs one window of batches back to back, each moving `bytes` in `us`
+Clock::time_point runWindow(BatchSizeTuner &tuner, Clock::time_point now,
+                            uint64_t bytes, int us) {
+    for (int i = 0; i < BatchSizeTuner::kWindowBatches; ++i) {
+        tuner.onSubmit(now);
+        now += std::chrono::microseconds(us);
+        tuner.onComplete(bytes, now);
+    }
+    return now;
+}
+
+TEST(BatchSizeTunerTest, FirstWindowProbesSmallerBatches) {
+    BatchSizeTuner tuner(4, 128);
+    EXPECT_EQ(tuner.batchSize(), 128u);
+    runWindow(tuner, Clock::now(), 1 << 20, 100);
+    EXPECT_EQ(tuner.batchSize(), 64u);
+}
+
+TEST(BatchSizeTunerTest, TurnsAroundWhenThroughputDrops) {
+    BatchSizeTuner tuner(4, 128);
+    auto now = runWindow(tuner, Clock::now(), 1 << 20, 100);
+    ASSERT_EQ(tuner.batchSize(), 64u);
+    // Smaller batches are faster, keep shrinking
+    now = runWindow(tuner, now, 1 << 20, 50);
+    ASSERT_EQ(tuner.batchSize(), 32u);
+    // Slower again, go back up
+    now = runWindow(tuner, now, 1 << 20, 80);
+    EXPECT_EQ(tuner.batchSize(), 64u);
+}
+
+TEST(BatchSizeTunerTest, StaysWithinBounds) {
+    BatchSizeTuner tuner(4, 16);
+    auto now = Clock::now();
+    int us = 100;
+    for (int i = 0; i < 10; ++i) {
+        us /= 2;  // always faster, keep shrinking
+        now = runWindow(tuner, now, 1 << 20, us + 1);
+        EXPECT_GE(tuner.batchSize(), 4u);
+    }
+    EXPECT_EQ(tuner.batchSize(), 4u);
+}
+
+TEST(BatchSizeTunerTest, IdleTimeDoesNotCount) {
+    BatchSizeTuner tuner(4, 128);
+    auto now = runWindow(tuner, Clock::now(), 1 << 20, 100);
+    ASSERT_EQ(tuner.batchSize(), 64u);
+    // Same speed with long gaps between batches, no reason to turn
+    for (int i = 0; i < BatchSizeTuner::kWindowBatches; ++i) {
+        now += std::chrono::milliseconds(10);
+        tuner.onSubmit(now);
+        now += std::chrono::microseconds(99);
+        tuner.onComplete(1 << 20, now);
+    }
+    EXPECT_EQ(tuner.batchSize(), 32u);
+}
+
+}  // namespace
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "common/bounded_mpsc_ring.h"
+
+namespace {
+
+using namespace mooncake;
+
+// Items encode the producer in the high bits and a sequence in the low bits
+uint64_t makeItem(uint64_t producer, uint64_t seq) {
+    return (producer << 32) | seq;
+}
+
+// Pushes items_per_producer items from each producer in batches and checks
+// that the consumer sees every item exactly once, in per-producer order.
+// Returns the elapsed time in seconds.
+double runProducers(BoundedMpscRing<uint64_t> &ring, int producers,
+                    uint64_t items_per_producer, size_t batch_size) {
+    std::atomic<bool> start(false);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            std::vector<uint64_t> batch;
+            while (!start.load()) std::this_thread::yield();
+            for (uint64_t seq = 0; seq < items_per_producer;) {
+                batch.clear();
+                for (size_t i = 0; i < batch_size && seq < items_per_producer;
+                     ++i, ++seq)
+                    batch.push_back(makeItem(p, seq));
+                ring.push(batch);
+            }
+        });
+    }
+
+    std::vector<uint64_t> next_seq(producers, 0);
+    std::vector<uint64_t> popped;
+    const uint64_t total = items_per_producer * producers;
+    uint64_t received = 0;
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true);
+    while (received < total) {
+        popped.clear();
+        received += ring.pop(popped);
+        for (auto item : popped) {
+            uint64_t producer = item >> 32;
+            EXPECT_LT(producer, (uint64_t)producers);
+            EXPECT_EQ(next_seq[producer], item & 0xffffffffull);
+            next_seq[producer]++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    for (auto &thread : threads) thread.join();
+    popped.clear();
+    EXPECT_EQ(ring.pop(popped), 0u);
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+TEST(BoundedMpscRing, CapacityRoundsUpToPowerOfTwo) {
+    BoundedMpscRing<uint64_t> ring(1000);
+    EXPECT_EQ(ring.capacity(), 1024u);
+}
+
+TEST(BoundedMpscRing, PopsInPushOrder) {
+    BoundedMpscRing<uint64_t> ring(8);
+    std::vector<uint64_t> out;
+    EXPECT_EQ(ring.pop(out), 0u);
+    // Wrap around the ring several times
+    for (uint64_t round = 0; round < 5; ++round) {
+        std::vector<uint64_t> items = {round * 3, round * 3 + 1,
+                                       round * 3 + 2};
+        ring.push(items);
+        out.clear();
+        ASSERT_EQ(ring.pop(out), 3u);
+        EXPECT_EQ(out, items);
+    }
+}
+
+TEST(BoundedMpscRing, BatchLargerThanCapacity) {
+    BoundedMpscRing<uint64_t> ring(16);
+    runProducers(ring, 1, 10000, 100);
+}
+
+TEST(BoundedMpscRing, ManyProducers) {
+    BoundedMpscRing<uint64_t> ring(256);
+    runProducers(ring, 8, 20000, 7);
+}
+
+// Not a pass/fail check: reports how submission throughput scales with the
+// number of submitting threads, for batches the size of a typical transfer
+TEST(BoundedMpscRing, SubmissionScaling) {
+    const uint64_t kItemsPerProducer = 1 << 18;
+    const size_t kBatchSize = 16;
+    for (int producers = 1; producers <= 32; producers *= 2) {
+        BoundedMpscRing<uint64_t> ring(65536);
+        double seconds =
+            runProducers(ring, producers, kItemsPerProducer, kBatchSize);
+        LOG(INFO) << "producers=" << producers << " batch=" << kBatchSize
+                  << " throughput="
+                  << kItemsPerProducer * producers / seconds / 1e6
+                  << " Mitems/s";
+    }
+}
+
+}  // namespace
@@ -21,6 +21,7 @@
 #include <fstream>
 #include <iomanip>
 #include <memory>
+#include <vector>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -233,10 +234,39 @@ TEST_F(CXLTransportTest, MultipleRead) {
     engine->unregisterLocalMemory(addr);
 }
 
+TEST_F(CXLTransportTest, LargeWriteDirectAccess) {
+    // Larger than MC_CXL_PARALLEL_COPY_THRESHOLD, so it is split
+    std::vector<char> data(len);
+    for (auto &c : data) c = 'a' + lrand48() % 26;
+    auto batch_id = xport->allocateBatchID(1);
+    TransferRequest entry;
+    entry.opcode = TransferRequest::WRITE;
+    entry.length = len;
+    entry.source = data.data();
+    entry.target_id = segment_id;
+    entry.target_offset = offset_1;
+    Status s = engine->submitTransfer(batch_id, {entry});
+    ASSERT_EQ(s, Status::OK());
+
+    TransferStatus status;
+    s = xport->getTransferStatus(batch_id, 0, status);
+    ASSERT_EQ(s, Status::OK());
+    ASSERT_EQ(status.s, TransferStatusEnum::COMPLETED);
+    s = xport->freeBatchID(batch_id);
+    ASSERT_EQ(s, Status::OK());
+
+    void *direct = cxl_xport->getCxlAddress(offset_1, len);
+    ASSERT_EQ(direct, base_addr + offset_1);
+    EXPECT_EQ(memcmp(direct, data.data(), len), 0);
+    EXPECT_EQ(cxl_xport->getCxlAddress(FLAGS_device_size - len, len + 1),
+              nullptr);
+}
+
 }  // namespace mooncake
 
 int main(int argc, char **argv) {
     gflags::ParseCommandLineFlags(&argc, &argv, false);
+    setenv("MC_CXL_PARALLEL_COPY_THRESHOLD", "1048576", 0);
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
@@ -17,12 +17,17 @@
 #include <gtest/gtest.h>
 #include <sys/time.h>
 
+#include <chrono>
 #include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <memory>
+#include <thread>
 
+#include "config.h"
 #include "transfer_engine.h"
+#include "transport/rdma_transport/rdma_context.h"
+#include "transport/rdma_transport/rdma_transport.h"
 #include "transport/transport.h"
 
 using namespace mooncake;
@@ -90,9 +95,145 @@ TEST_F(RDMALoopbackTest, MultiWrite) {
         ASSERT_EQ(0, memcmp(addr, (char *)addr + kDataLength, kDataLength));
     }
 }
+
+TEST_F(RDMALoopbackTest, MixedPriorityWrite) {
+    // One BULK write queued with small LATENCY and NORMAL ones to the same
+    // NIC, all of which must land whatever order they are posted in
+    const size_t kBulkLength = 256ull << 20;
+    const size_t kSmallLength = 4096;
+    const int kSmallCount = 64;
+    char *source = (char *)addr;
+    char *target = source + (ram_buffer_size >> 1);
+    for (size_t offset = 0; offset < kBulkLength; offset += 4096)
+        source[offset] = 'a' + lrand48() % 26;
+    std::vector<TransferRequest> entries;
+    TransferRequest bulk;
+    bulk.opcode = TransferRequest::WRITE;
+    bulk.length = kBulkLength;
+    bulk.source = source;
+    bulk.target_id = LOCAL_SEGMENT_ID;
+    bulk.target_offset = (uint64_t)target;
+    bulk.priority = TransferRequest::BULK;
+    entries.push_back(bulk);
+    for (int i = 0; i < kSmallCount; ++i) {
+        TransferRequest entry = bulk;
+        entry.length = kSmallLength;
+        entry.source = source + kBulkLength + i * kSmallLength;
+        entry.target_offset = (uint64_t)(target + kBulkLength) +
+                              i * kSmallLength;
+        entry.priority =
+            i % 2 ? TransferRequest::LATENCY : TransferRequest::NORMAL;
+        memset(entry.source, 'A' + i % 26, kSmallLength);
+        entries.push_back(entry);
+    }
+    auto batch_id = engine->allocateBatchID(entries.size());
+    Status s = engine->submitTransfer(batch_id, entries);
+    ASSERT_TRUE(s.ok());
+    for (size_t task_id = 0; task_id < entries.size(); ++task_id) {
+        TransferStatus status;
+        do {
+            s = engine->getTransferStatus(batch_id, task_id, status);
+            ASSERT_EQ(s, Status::OK());
+            ASSERT_NE(status.s, TransferStatusEnum::FAILED);
+        } while (status.s != TransferStatusEnum::COMPLETED);
+    }
+    s = engine->freeBatchID(batch_id);
+    ASSERT_EQ(s, Status::OK());
+    const size_t total = kBulkLength + kSmallCount * kSmallLength;
+    ASSERT_EQ(0, memcmp(source, target, total));
+}
+
+TEST_F(RDMALoopbackTest, FailedSliceInUnsignaledRun) {
+    // A batch that is not a multiple of the signal interval, with one write
+    // in the middle of an unsignaled run whose remote key is stale
+    const size_t kSignalInterval = globalConfig().signal_interval;
+    ASSERT_GT(kSignalInterval, 1u);
+    const size_t kLength = 4096;
+    const size_t kCount = 2 * kSignalInterval + kSignalInterval / 2 + 1;
+    const size_t kStaleIndex = kSignalInterval + 1;
+    ASSERT_NE(kCount % kSignalInterval, 0u);
+    auto transport =
+        static_cast<RdmaTransport *>(engine->getTransport("rdma"));
+    ASSERT_NE(transport, nullptr);
+
+    const size_t kStaleSize = 1ull << 20;
+    void *stale = numa_alloc_onnode(kStaleSize, 0);
+    ASSERT_EQ(engine->registerLocalMemory(stale, kStaleSize, "cpu:0"), 0);
+    // The segment still publishes the old key, which the NICs no longer know
+    for (auto &context : transport->contextList())
+        ASSERT_EQ(context->unregisterMemoryRegion(stale), 0);
+
+    char *source = (char *)addr;
+    char *target = source + (ram_buffer_size >> 1);
+    std::vector<TransferRequest> entries;
+    for (size_t i = 0; i < kCount; ++i) {
+        TransferRequest entry;
+        entry.opcode = TransferRequest::WRITE;
+        entry.length = kLength;
+        entry.source = source + i * kLength;
+        entry.target_id = LOCAL_SEGMENT_ID;
+        entry.target_offset = (uint64_t)(target + i * kLength);
+        memset(entry.source, 'a' + i % 26, kLength);
+        if (i == kStaleIndex) {
+            entry.target_offset = (uint64_t)stale;
+            // Fail on the first error rather than flushing the other
+            // writes on every retry
+            entry.advise_retry_cnt = globalConfig().retry_cnt - 1;
+        }
+        entries.push_back(entry);
+    }
+    auto batch_id = engine->allocateBatchID(entries.size());
+    Status s = engine->submitTransfer(batch_id, entries);
+    ASSERT_TRUE(s.ok());
+    for (size_t task_id = 0; task_id < entries.size(); ++task_id) {
+        TransferStatus status;
+        do {
+            s = engine->getTransferStatus(batch_id, task_id, status);
+            ASSERT_EQ(s, Status::OK());
+        } while (status.s != TransferStatusEnum::COMPLETED &&
+                 status.s != TransferStatusEnum::FAILED);
+        if (task_id == kStaleIndex) {
+            EXPECT_EQ(status.s, TransferStatusEnum::FAILED);
+        } else {
+            EXPECT_EQ(status.s, TransferStatusEnum::COMPLETED)
+                << "task " << task_id;
+            EXPECT_EQ(0, memcmp(entries[task_id].source,
+                                (char *)entries[task_id].target_offset,
+                                kLength))
+                << "task " << task_id;
+        }
+    }
+    s = engine->freeBatchID(batch_id);
+    ASSERT_EQ(s, Status::OK());
+
+    // Every WR, signaled or not, gives back its QP and CQ entries
+    auto drained = [&]() {
+        for (auto &context : transport->contextList()) {
+            if (context->getTotalWrDepth()) return false;
+            for (int i = 0; i < context->cqCount(); ++i)
+                if (*context->cqOutstandingCount(i)) return false;
+        }
+        return true;
+    };
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!drained() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (auto &context : transport->contextList()) {
+        EXPECT_EQ(context->getTotalWrDepth(), 0u) << context->deviceName();
+        for (int i = 0; i < context->cqCount(); ++i)
+            EXPECT_EQ(*context->cqOutstandingCount(i), 0)
+                << context->deviceName() << " cq " << i;
+    }
+
+    engine->unregisterLocalMemory(stale);
+    numa_free(stale, kStaleSize);
+}
 }  // namespace mooncake
 
 int main(int argc, char **argv) {
+    // Signal every fourth WR unless told otherwise, so that batches have
+    // unsignaled runs. Must be set before the global config is loaded.
+    setenv("MC_IB_SIGNAL_INTERVAL", "4", 0);
     gflags::ParseCommandLineFlags(&argc, &argv, false);
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
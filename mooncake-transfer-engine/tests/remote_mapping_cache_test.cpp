@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "common/remote_mapping_cache.h"
+
+namespace {
+
+using namespace mooncake;
+
+// Hands out fake addresses and records which ones were closed
+class RemoteMappingCacheTest : public ::testing::Test {
+   protected:
+    RemoteMappingCache::Opener opener(uintptr_t addr) {
+        return [this, addr]() {
+            ++opens_;
+            return (void *)addr;
+        };
+    }
+
+    RemoteMappingCache::Closer closer() {
+        return [this](void *addr) { closed_.push_back((uintptr_t)addr); };
+    }
+
+    int opens_ = 0;
+    std::vector<uintptr_t> closed_;
+};
+
+TEST_F(RemoteMappingCacheTest, OpensEachMappingOnce) {
+    RemoteMappingCache cache(0, closer());
+    EXPECT_EQ(cache.acquire({1, 0x1000}, opener(0xa000)), (void *)0xa000);
+    EXPECT_EQ(cache.acquire({1, 0x1000}, opener(0xb000)), (void *)0xa000);
+    EXPECT_EQ(cache.acquire({2, 0x1000}, opener(0xc000)), (void *)0xc000);
+    EXPECT_EQ(opens_, 2);
+    EXPECT_EQ(cache.size(), 2u);
+    cache.release({1, 0x1000});
+    cache.release({1, 0x1000});
+    cache.release({2, 0x1000});
+    cache.clear();
+    EXPECT_EQ(closed_.size(), 2u);
+}
+
+TEST_F(RemoteMappingCacheTest, FailedOpenIsNotCached) {
+    RemoteMappingCache cache(0, closer());
+    EXPECT_EQ(cache.acquire({1, 0x1000}, opener(0)), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.acquire({1, 0x1000}, opener(0xa000)), (void *)0xa000);
+    EXPECT_EQ(opens_, 2);
+}
+
+TEST_F(RemoteMappingCacheTest, EvictsLeastRecentlyUsed) {
+    RemoteMappingCache cache(2, closer());
+    for (uintptr_t i = 1; i <= 2; ++i) {
+        cache.acquire({1, i}, opener(i << 12));
+        cache.release({1, i});
+    }
+    // Touch the first mapping, so the second one is the oldest
+    cache.acquire({1, 1}, opener(0));
+    cache.release({1, 1});
+    cache.acquire({1, 3}, opener(3 << 12));
+    cache.release({1, 3});
+    ASSERT_EQ(closed_.size(), 1u);
+    EXPECT_EQ(closed_[0], 2u << 12);
+    EXPECT_EQ(cache.size(), 2u);
+}
+
+TEST_F(RemoteMappingCacheTest, KeepsMappingsInUse) {
+    RemoteMappingCache cache(1, closer());
+    cache.acquire({1, 1}, opener(1 << 12));
+    cache.acquire({1, 2}, opener(2 << 12));
+    // Both are held, so the cache grows past its capacity
+    EXPECT_TRUE(closed_.empty());
+    EXPECT_EQ(cache.size(), 2u);
+    cache.release({1, 1});
+    cache.release({1, 2});
+    cache.acquire({1, 3}, opener(3 << 12));
+    EXPECT_EQ(closed_.size(), 2u);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+}  // namespace
@@ -15,8 +15,10 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <poll.h>
 #include <sys/time.h>
 
+#include <atomic>
 #include <cstdlib>
 #include <fstream>
 #include <iomanip>
@@ -144,6 +146,66 @@ TEST_F(TCPTransportTest, Writetest) {
     ASSERT_EQ(s, Status::OK());
 }
 
+TEST_F(TCPTransportTest, CompletionNotificationTest) {
+    const size_t kDataLength = 4096000;
+    const size_t ram_buffer_size = 1ull << 30;
+    // disable topology auto discovery for testing.
+    auto engine = std::make_unique<TransferEngine>(false);
+    auto hostname_port = parseHostNameWithPort(local_server_name);
+    auto rc = engine->init(metadata_server, local_server_name,
+                           hostname_port.first.c_str(), hostname_port.second);
+    LOG_ASSERT(rc == 0);
+    Transport *xport = engine->installTransport("tcp", nullptr);
+    LOG_ASSERT(xport != nullptr);
+
+    void *addr = allocateMemoryPool(ram_buffer_size, 0, false);
+    rc = engine->registerLocalMemory(addr, ram_buffer_size, "cpu:0");
+    LOG_ASSERT(!rc);
+    auto segment_id = engine->openSegment(local_server_name);
+    auto segment_desc = engine->getMetadata()->getSegmentDescByID(segment_id);
+    uint64_t remote_base = (uint64_t)segment_desc->buffers[0].addr;
+
+    std::vector<BatchID> batch_ids;
+    std::atomic<int> callbacks{0};
+    std::vector<TransferRequest> entries(2);
+    for (int i = 0; i < 2; ++i) {
+        auto batch_id = engine->allocateBatchID(1);
+        ASSERT_TRUE(engine
+                        ->setBatchCompletionCallback(
+                            batch_id,
+                            [&callbacks](BatchID, bool failed) {
+                                if (!failed) callbacks++;
+                            })
+                        .ok());
+        auto &entry = entries[i];
+        entry.opcode = TransferRequest::WRITE;
+        entry.length = kDataLength;
+        entry.source = (uint8_t *)(addr) + i * kDataLength;
+        entry.target_id = segment_id;
+        entry.target_offset = remote_base + (i + 2) * kDataLength;
+        ASSERT_TRUE(engine->submitTransfer(batch_id, {entry}).ok());
+        batch_ids.push_back(batch_id);
+    }
+
+    int fd = engine->getBatchCompletionFd(batch_ids[1]);
+    ASSERT_GE(fd, 0);
+    std::vector<BatchID> pending = batch_ids;
+    while (!pending.empty()) {
+        size_t index;
+        ASSERT_TRUE(engine->waitAnyBatch(pending, index, 10000).ok());
+        ASSERT_LT(index, pending.size());
+        TransferStatus status;
+        ASSERT_TRUE(engine->getTransferStatus(pending[index], 0, status).ok());
+        EXPECT_EQ(status.s, TransferStatusEnum::COMPLETED);
+        pending.erase(pending.begin() + index);
+    }
+    struct pollfd pfd = {fd, POLLIN, 0};
+    EXPECT_EQ(poll(&pfd, 1, 0), 1);
+    EXPECT_EQ(callbacks.load(), 2);
+    for (auto batch_id : batch_ids)
+        ASSERT_EQ(engine->freeBatchID(batch_id), Status::OK());
+}
+
 TEST_F(TCPTransportTest, WriteAndReadtest) {
     const size_t kDataLength = 4096000;
     void *addr = nullptr;
@@ -106,6 +106,23 @@ TEST(ToplogyTest, TestSelectDeviceAny) {
     ASSERT_TRUE(items.empty());
 }
 
+TEST(ToplogyTest, TestCandidateDevices) {
+    mooncake::Topology topology;
+    std::string json_str =
+        "{\"cpu:0\" : [[\"erdma_0\"],[\"erdma_1\"]], "
+        "\"cpu:1\" : [[],[\"erdma_1\"]]}";
+    topology.clear();
+    topology.parse(json_str);
+    auto &hca_list = topology.getHcaList();
+    auto &preferred = topology.candidateDevices("cpu:0");
+    ASSERT_EQ(preferred.size(), 1u);
+    ASSERT_EQ(hca_list[preferred[0]], "erdma_0");
+    auto &available = topology.candidateDevices("cpu:1");
+    ASSERT_EQ(available.size(), 1u);
+    ASSERT_EQ(hca_list[available[0]], "erdma_1");
+    ASSERT_TRUE(topology.candidateDevices("cuda:0").empty());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
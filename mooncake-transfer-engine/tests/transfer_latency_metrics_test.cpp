@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "transfer_latency_metrics.h"
+
+namespace {
+
+using namespace mooncake;
+
+TEST(LatencyHistogramTest, BucketsBoundTheirValues) {
+    size_t previous = 0;
+    for (uint64_t value = 0; value < (1u << 20); ++value) {
+        const size_t index = LatencyHistogram::bucketIndex(value);
+        ASSERT_LT(index, LatencyHistogram::kBuckets);
+        // Buckets are contiguous and ordered
+        ASSERT_TRUE(index == previous || index == previous + 1) << value;
+        previous = index;
+        ASSERT_LE(value, LatencyHistogram::bucketMax(index)) << value;
+        if (index > 0) {
+            ASSERT_GT(value, LatencyHistogram::bucketMax(index - 1)) << value;
+        }
+        // Relative error bounded by the sub-buckets
+        ASSERT_LE(LatencyHistogram::bucketMax(index) - value,
+                  value / LatencyHistogram::kSubBuckets);
+    }
+    EXPECT_EQ(LatencyHistogram::bucketIndex(UINT64_MAX),
+              LatencyHistogram::kBuckets - 1);
+}
+
+TEST(LatencyHistogramTest, MergesTheShardsOfAllThreads) {
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 16; ++t) {
+        threads.emplace_back([&histogram]() {
+            for (uint64_t i = 0; i < 1000; ++i) histogram.record(i);
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    auto snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 16000u);
+    EXPECT_EQ(snapshot.sum, 16u * 999 * 1000 / 2);
+    EXPECT_EQ(snapshot.counts[LatencyHistogram::bucketIndex(0)], 16u);
+}
+
+TEST(TransferLatencyMetricsTest, SerializesHistogramsAndGauges) {
+    auto &metrics = TransferLatencyMetrics::instance();
+    auto *histogram =
+        metrics.histogram("test_latency_us", "Test latency", "nic=\"a\"");
+    EXPECT_EQ(histogram, metrics.histogram("test_latency_us", "Test latency",
+                                           "nic=\"a\""));
+    histogram->record(3);
+    histogram->record(5);
+    int owner = 0;
+    metrics.addGauge(&owner, "test_depth", "Test depth", "nic=\"a\"",
+                     []() { return uint64_t{7}; });
+
+    std::string out;
+    metrics.serialize(out);
+    EXPECT_NE(out.find("# TYPE test_latency_us histogram\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("test_latency_us_bucket{nic=\"a\",le=\"3\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("test_latency_us_bucket{nic=\"a\",le=\"5\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("test_latency_us_bucket{nic=\"a\",le=\"+Inf\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("test_latency_us_sum{nic=\"a\"} 8\n"),
+              std::string::npos);
+    EXPECT_NE(out.find("test_depth{nic=\"a\"} 7\n"), std::string::npos);
+
+    metrics.removeGauges(&owner);
+    out.clear();
+    metrics.serialize(out);
+    EXPECT_EQ(out.find("test_depth"), std::string::npos);
+}
+
+}  // namespace
@@ -19,8 +19,13 @@
 #include <gtest/gtest.h>
 #include <sys/time.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <map>
+#include <mutex>
 
+#include "config.h"
+#include "transfer_metadata_plugin.h"
 #include "transport/transport.h"
 
 using namespace mooncake;
@@ -123,6 +128,189 @@ TEST_F(TransferMetadataTest, RpcMetaEntryTest) {
     ASSERT_EQ(re, 0);
 }
 
+// publish buffer registrations as deltas and refresh a peer copy from them
+TEST_F(TransferMetadataTest, IncrementalSegmentDescTest) {
+    globalConfig().metadata_incremental = true;
+    const std::string segment_name = "test_incremental_segment";
+    auto segment_des = std::make_shared<TransferMetadata::SegmentDesc>();
+    segment_des->name = segment_name;
+    segment_des->protocol = "tcp";
+    int re = metadata_client->addLocalSegment(LOCAL_SEGMENT_ID, segment_name,
+                                              std::move(segment_des));
+    ASSERT_EQ(re, 0);
+    ASSERT_EQ(metadata_client->updateLocalSegmentDesc(), 0);
+
+    TransferMetadata peer(metadata_server);
+    auto desc = peer.getSegmentDescByName(segment_name);
+    ASSERT_TRUE(desc);
+    EXPECT_TRUE(desc->buffers.empty());
+
+    for (int i = 0; i < 10; ++i) {
+        TransferMetadata::BufferDesc buffer_des;
+        buffer_des.name = "cpu:0";
+        buffer_des.addr = 4096 + i * 4096;
+        buffer_des.length = 1024;
+        ASSERT_EQ(metadata_client->addLocalMemoryBuffer(buffer_des, true), 0);
+    }
+    ASSERT_EQ(metadata_client->removeLocalMemoryBuffer((void*)4096, true), 0);
+    desc = peer.getSegmentDescByName(segment_name, true);
+    ASSERT_TRUE(desc);
+    ASSERT_EQ(desc->buffers.size(), 9u);
+    EXPECT_EQ(desc->buffers[0].addr, 8192u);
+
+    ASSERT_EQ(metadata_client->removeSegmentDesc(segment_name), 0);
+    ASSERT_EQ(metadata_client->removeLocalSegment(segment_name), 0);
+    globalConfig().metadata_incremental = false;
+}
+
+// fetch a peer descriptor in P2P mode, then refresh it after the peer
+// registers and removes buffers
+TEST(TransferMetadataP2PTest, SegmentDescRoundTrip) {
+    const std::string server_name = "127.0.0.1:17815";
+    TransferMetadata server(P2PHANDSHAKE), client(P2PHANDSHAKE);
+
+    auto local_desc = std::make_shared<TransferMetadata::SegmentDesc>();
+    local_desc->name = server_name;
+    local_desc->protocol = "rdma";
+    local_desc->devices.push_back({"mlx5_0", 1, "fe80::1", 0});
+    ASSERT_EQ(server.addLocalSegment(LOCAL_SEGMENT_ID, server_name,
+                                     std::move(local_desc)),
+              0);
+    auto makeBuffer = [](uint64_t addr) {
+        TransferMetadata::BufferDesc buffer;
+        buffer.name = "cpu:0";
+        buffer.addr = addr;
+        buffer.length = 4096;
+        buffer.lkey = {1};
+        buffer.rkey = {2};
+        return buffer;
+    };
+    ASSERT_EQ(server.addLocalMemoryBuffer(makeBuffer(0x10000), false), 0);
+    TransferMetadata::RpcMetaDesc rpc_desc;
+    rpc_desc.ip_or_host_name = "127.0.0.1";
+    rpc_desc.rpc_port = 17815;
+    rpc_desc.sockfd = -1;
+    ASSERT_EQ(server.addRpcMetaEntry(server_name, rpc_desc), 0);
+
+    auto desc = client.getSegmentDescByName(server_name);
+    ASSERT_TRUE(desc);
+    ASSERT_EQ(desc->devices.size(), 1u);
+    EXPECT_EQ(desc->devices[0].gid, "fe80::1");
+    ASSERT_EQ(desc->buffers.size(), 1u);
+    EXPECT_EQ(desc->buffers[0].rkey, std::vector<uint32_t>{2});
+
+    ASSERT_EQ(server.addLocalMemoryBuffer(makeBuffer(0x20000), false), 0);
+    ASSERT_EQ(server.addLocalMemoryBuffer(makeBuffer(0x30000), false), 0);
+    ASSERT_EQ(server.removeLocalMemoryBuffer((void*)0x10000, false), 0);
+    desc = client.getSegmentDescByName(server_name, true);
+    ASSERT_TRUE(desc);
+    ASSERT_EQ(desc->buffers.size(), 2u);
+    EXPECT_EQ(desc->buffers[0].addr, 0x20000u);
+    EXPECT_EQ(desc->buffers[1].addr, 0x30000u);
+    EXPECT_EQ(desc->devices.size(), 1u);
+
+    auto known = client.getKnownSegments();
+    EXPECT_NE(std::find(known.begin(), known.end(), server_name), known.end());
+}
+
+// In-memory metadata store that counts reads and notifies changes only
+// when told to
+struct FakeStoragePlugin : public MetadataStoragePlugin {
+    bool get(const std::string& key, Json::Value& value) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++reads[key];
+        auto it = entries.find(key);
+        if (it == entries.end()) return false;
+        value = it->second;
+        return true;
+    }
+    bool set(const std::string& key, const Json::Value& value) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[key] = value;
+        return true;
+    }
+    bool remove(const std::string& key) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.erase(key) > 0;
+    }
+    bool watch(const std::string& prefix, OnChangeCallBack callback) override {
+        on_change = std::move(callback);
+        return true;
+    }
+    int readCount(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return reads[key];
+    }
+
+    std::mutex mutex;
+    std::map<std::string, Json::Value> entries;
+    std::map<std::string, int> reads;
+    OnChangeCallBack on_change;
+};
+
+// map the changed keys the store notifies to the cached entries to refresh
+TEST(TransferMetadataWatchTest, ChangedKeysMarkSegmentsStale) {
+    ASSERT_TRUE(globalConfig().metacache);
+    ASSERT_EQ(std::getenv("MC_METADATA_CLUSTER_ID"), nullptr);
+    auto storage = std::make_shared<FakeStoragePlugin>();
+    TransferMetadata metadata("fake://watch", storage);
+    ASSERT_TRUE(storage->on_change);
+
+    const std::string key = "mooncake/ram/peer";
+    TransferMetadata::SegmentDesc peer_desc;
+    peer_desc.name = "peer";
+    peer_desc.protocol = "tcp";
+    ASSERT_EQ(metadata.updateSegmentDesc("peer", peer_desc), 0);
+    TransferMetadata::SegmentDesc other_desc = peer_desc;
+    other_desc.name = "other";
+    ASSERT_EQ(metadata.updateSegmentDesc("other", other_desc), 0);
+
+    const auto kNoSegment = TransferMetadata::SegmentID(-1);
+    auto peer_id = metadata.getSegmentID("peer");
+    ASSERT_NE(peer_id, kNoSegment);
+    ASSERT_NE(metadata.getSegmentID("other"), kNoSegment);
+    ASSERT_EQ(storage->readCount(key), 1);
+    // Served from the cache until the store tells otherwise
+    ASSERT_TRUE(metadata.getSegmentDescByID(peer_id));
+    EXPECT_EQ(storage->readCount(key), 1);
+
+    auto expectRefresh = [&](const std::string& changed_key, int reads) {
+        storage->on_change(changed_key);
+        ASSERT_TRUE(metadata.getSegmentDescByID(peer_id)) << changed_key;
+        EXPECT_EQ(storage->readCount(key), reads) << changed_key;
+        // The refresh clears the mark
+        ASSERT_TRUE(metadata.getSegmentDescByID(peer_id)) << changed_key;
+        EXPECT_EQ(storage->readCount(key), reads) << changed_key;
+    };
+    expectRefresh("mooncake/ram/peer", 2);
+    expectRefresh("mooncake/delta/peer/7", 3);
+    expectRefresh("mooncake/delta/peer/head", 4);
+    // Keys of other segments, unknown segments or other prefixes
+    expectRefresh("mooncake/ram/other", 4);
+    expectRefresh("mooncake/ram/unknown", 4);
+    expectRefresh("elsewhere/ram/peer", 4);
+    // A missed change may be anything
+    expectRefresh("", 5);
+
+    Json::Value rpc_meta;
+    rpc_meta["ip_or_host_name"] = "10.0.0.1";
+    rpc_meta["rpc_port"] = 12345;
+    ASSERT_TRUE(storage->set("mooncake/rpc_meta/peer", rpc_meta));
+    TransferMetadata::RpcMetaDesc desc;
+    ASSERT_EQ(metadata.getRpcMetaEntry("peer", desc), 0);
+    EXPECT_EQ(desc.ip_or_host_name, "10.0.0.1");
+    rpc_meta["ip_or_host_name"] = "10.0.0.2";
+    ASSERT_TRUE(storage->set("mooncake/rpc_meta/peer", rpc_meta));
+    ASSERT_EQ(metadata.getRpcMetaEntry("peer", desc), 0);
+    EXPECT_EQ(desc.ip_or_host_name, "10.0.0.1");
+    // The rpc_meta prefix drops the cached location, not a segment
+    storage->on_change("mooncake/rpc_meta/peer");
+    ASSERT_EQ(metadata.getRpcMetaEntry("peer", desc), 0);
+    EXPECT_EQ(desc.ip_or_host_name, "10.0.0.2");
+    ASSERT_TRUE(metadata.getSegmentDescByID(peer_id));
+    EXPECT_EQ(storage->readCount(key), 5);
+}
+
 }  // namespace mooncake
 
 int main(int argc, char** argv) {
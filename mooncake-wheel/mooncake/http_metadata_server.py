@@ -8,6 +8,7 @@ used by Mooncake. It can be used as an alternative to etcd for metadata storage.
 
 import argparse
 import asyncio
+import collections
 import logging
 import os
 import signal
@@ -30,6 +31,11 @@ class KVPoll(Enum):
 
 class KVBootstrapServer:
     """HTTP server for storing and retrieving metadata."""
+
+    # Changes kept for watching clients, older ones ask them to reload
+    MAX_CHANGES = 4096
+    # Seconds a watch request waits for changes
+    WATCH_TIMEOUT = 30
     
     def __init__(self, port: int, host: str = "0.0.0.0"):
         """Initialize the server.
@@ -43,6 +49,10 @@ class KVBootstrapServer:
         self.app = web.Application()
         self.store = dict()
         self.lock = asyncio.Lock()
+        # Recently changed keys, for clients watching them
+        self.revision = 0
+        self.changes = collections.deque(maxlen=self.MAX_CHANGES)
+        self.changed = None
         self._loop = None
         self._runner = None
         self.thread = None
@@ -58,6 +68,50 @@ class KVBootstrapServer:
     def _setup_routes(self):
         """Set up the HTTP routes."""
         self.app.router.add_route('*', '/metadata', self._handle_metadata)
+        self.app.router.add_get('/metadata/watch', self._handle_watch)
+
+    def _record_change(self, key):
+        """Record a changed key and wake up the watchers, lock held."""
+        self.revision += 1
+        self.changes.append((self.revision, key))
+        if self.changed is not None:
+            self.changed.set()
+        self.changed = asyncio.Event()
+
+    def _changes_since(self, prefix, since):
+        """Return the keys under prefix changed after since, and whether
+        those changes are no longer known."""
+        if since > self.revision or (
+                self.changes and self.changes[0][0] > since + 1):
+            return [], True
+        return [key for revision, key in self.changes
+                if revision > since and key.startswith(prefix)], False
+
+    async def _handle_watch(self, request: web.Request):
+        """Long-poll the keys under prefix changed after since. Without
+        since, only the current revision is returned."""
+        prefix = request.query.get('prefix', '')
+        since_str = request.query.get('since', '')
+        since = int(since_str) if since_str.isdigit() else 0
+        loop = asyncio.get_running_loop()
+        deadline = loop.time() + self.WATCH_TIMEOUT
+        while True:
+            async with self.lock:
+                revision = self.revision
+                keys, reset = self._changes_since(prefix, since)
+                if self.changed is None:
+                    self.changed = asyncio.Event()
+                changed = self.changed
+            timeout = deadline - loop.time()
+            if not since_str or reset or keys or timeout <= 0:
+                return web.json_response(
+                    {'revision': revision, 'keys': keys, 'reset': reset})
+            try:
+                await asyncio.wait_for(changed.wait(), timeout)
+            except asyncio.TimeoutError:
+                pass
+            # Nothing under prefix changed up to revision
+            since = revision
 
     async def _handle_metadata(self, request: web.Request):
         """Handle metadata requests."""
@@ -90,6 +144,7 @@ class KVBootstrapServer:
                 return web.Response(text='Duplicate rpc_meta key not allowed', status=400,
                                   content_type='application/json')
             self.store[key] = data
+            self._record_change(key)
         return web.Response(text='metadata updated', status=200,
                           content_type='application/json')
 
@@ -100,6 +155,7 @@ class KVBootstrapServer:
                 return web.Response(text='metadata not found', status=404,
                                   content_type='application/json')
             del self.store[key]
+            self._record_change(key)
         return web.Response(text='metadata deleted', status=200,
                           content_type='application/json')
                           
@@ -77,48 +77,35 @@ class Buffer:
         self._fallback_next_combine_buffer: Optional[torch.Tensor] = None
 
         if not self._use_fallback:
-            (raddr, rkey) = self.runtime.get_mr_info()
+            (raddr, _) = self.runtime.get_mr_info()
 
             raddr = torch.tensor([raddr], dtype=torch.int64, device='cuda')
             raddrs = [torch.empty(1, dtype=torch.int64, device='cuda') for _ in range(self.group_size)]
             dist.all_gather(raddrs, raddr, group)
             raddrs = torch.cat(raddrs).tolist()
 
-            rkey = torch.tensor([rkey], dtype=torch.int32, device='cuda')
-            rkeys = [torch.empty(1, dtype=torch.int32, device='cuda') for _ in range(self.group_size)]
-            dist.all_gather(rkeys, rkey, group)
-            rkeys = torch.cat(rkeys).tolist()
+            # Each QP is paired with the QP of the peer that has the same index in its slice, so
+            # the per-QP values are exchanged with all_to_all. `MC_EP_NUM_QP_PER_RANK` must match
+            # on all ranks.
+            all_to_all_size = self.runtime.get_num_qp_per_rank()
 
-            all_to_all_size = ep.MAX_QP_COUNT // self.group_size
+            def exchange_per_qp(local_values: list, dtype: torch.dtype) -> list:
+                local = list(torch.unbind(torch.tensor(local_values, dtype=dtype, device='cuda').view(-1, all_to_all_size)))
+                remote = [torch.empty(all_to_all_size, dtype=dtype, device='cuda') for _ in range(self.group_size)]
+                dist.all_to_all(remote, local, group)
+                return torch.cat(remote).tolist()
 
-            local_qpns = self.runtime.get_local_qpns()
-            local_qpns = list(torch.unbind(torch.tensor(local_qpns, dtype=torch.int32, device='cuda').view(-1, all_to_all_size)))
-            remote_qpns = [torch.empty(all_to_all_size, dtype=torch.int32, device='cuda') for _ in range(self.group_size)]
-            dist.all_to_all(remote_qpns, local_qpns, group)
-            remote_qpns = torch.cat(remote_qpns).tolist()
+            # Keys differ between the NICs a GPU stripes over
+            rkeys = exchange_per_qp(self.runtime.get_local_rkeys(), torch.int32)
+            remote_qpns = exchange_per_qp(self.runtime.get_local_qpns(), torch.int32)
 
             if self.runtime.is_roce():
-                (subnet_prefix, interface_id) = self.runtime.get_gid()
-
-                subnet_prefix = torch.tensor([subnet_prefix], dtype=torch.int64, device='cuda')
-                subnet_prefixes = [torch.empty(1, dtype=torch.int64, device='cuda') for _ in range(self.group_size)]
-                dist.all_gather(subnet_prefixes, subnet_prefix, group)
-                subnet_prefixes = torch.cat(subnet_prefixes).tolist()
-
-                interface_id = torch.tensor([interface_id], dtype=torch.int64, device='cuda')
-                interface_ids = [torch.empty(1, dtype=torch.int64, device='cuda') for _ in range(self.group_size)]
-                dist.all_gather(interface_ids, interface_id, group)
-                interface_ids = torch.cat(interface_ids).tolist()
-
+                (subnet_prefixes, interface_ids) = self.runtime.get_local_gids()
+                subnet_prefixes = exchange_per_qp(subnet_prefixes, torch.int64)
+                interface_ids = exchange_per_qp(interface_ids, torch.int64)
                 self.runtime.sync_roce(raddrs, rkeys, remote_qpns, subnet_prefixes, interface_ids)
             else:
-
-                local_lids = self.runtime.get_local_lids()
-                local_lids = list(torch.unbind(torch.tensor(local_lids, dtype=torch.int32, device='cuda').view(-1, all_to_all_size)))
-                remote_lids = [torch.empty(all_to_all_size, dtype=torch.int32, device='cuda') for _ in range(self.group_size)]
-                dist.all_to_all(remote_lids, local_lids, group)
-                remote_lids = torch.cat(remote_lids).tolist()
-
+                remote_lids = exchange_per_qp(self.runtime.get_local_lids(), torch.int32)
                 self.runtime.sync_ib(raddrs, rkeys, remote_qpns, remote_lids)
 
         # Exchange CUDA IPC handles for NVLink/P2P.
@@ -170,12 +157,16 @@ class Buffer:
     # noinspection PyTypeChecker
     def dispatch(self, x: torch.Tensor, topk_idx: torch.Tensor, active_ranks: torch.Tensor,
                  num_max_dispatch_tokens_per_rank: int, num_experts: int, timeout_us: int,
-                 use_fp8: bool = True, async_finish: bool = False, return_recv_hook: bool = False) -> \
+                 use_fp8: bool = True, async_finish: bool = False, return_recv_hook: bool = False,
+                 cumulative_local_expert_recv_stats: Optional[torch.Tensor] = None,
+                 dispatch_wait_recv_cost_stats: Optional[torch.Tensor] = None) -> \
             Tuple[Union[Tuple[torch.Tensor, torch.Tensor], torch.Tensor], torch.Tensor, Tuple, EventOverlap, Callable]:
         if self._use_fallback:
             from mooncake.ep import get_active_ranks
             packed_recv_x, packed_recv_x_scales, packed_recv_count, packed_recv_src_info, packed_recv_layout_range, event, hook = \
                 self._fallback_dispatch(x, topk_idx, num_max_dispatch_tokens_per_rank, num_experts, use_fp8, return_recv_hook)
+            if cumulative_local_expert_recv_stats is not None:
+                cumulative_local_expert_recv_stats.add_(packed_recv_count)
             backend_active_ranks = get_active_ranks(self.backend).to(device=active_ranks.device, dtype=active_ranks.dtype)
             if active_ranks.numel() == backend_active_ranks.numel():
                 active_ranks.copy_(backend_active_ranks)
@@ -183,7 +174,8 @@ class Buffer:
             packed_recv_x, packed_recv_x_scales, packed_recv_count, packed_recv_src_info, packed_recv_layout_range, event, hook = \
                 self.runtime.dispatch(x, topk_idx, active_ranks,
                                       num_max_dispatch_tokens_per_rank, num_experts, timeout_us,
-                                      use_fp8, async_finish, return_recv_hook)
+                                      use_fp8, async_finish, return_recv_hook,
+                                      cumulative_local_expert_recv_stats, dispatch_wait_recv_cost_stats)
         handle = (packed_recv_src_info, packed_recv_layout_range, num_max_dispatch_tokens_per_rank, x.size(1), num_experts)
         tensors_to_record = (x, topk_idx,
                              packed_recv_x, packed_recv_x_scales, packed_recv_count,
@@ -195,7 +187,7 @@ class Buffer:
     def combine(self, x: torch.Tensor, topk_idx: torch.Tensor, topk_weights: torch.Tensor,
                 active_ranks: torch.Tensor, timeout_us: int,
                 handle: tuple, zero_copy: bool = False, async_finish: bool = False,
-                return_recv_hook: bool = False, out: Optional[torch.Tensor] = None) -> \
+                return_recv_hook: bool = False, out: Optional[torch.Tensor] = None, use_fp8: bool = False) -> \
             Tuple[torch.Tensor, EventOverlap, Callable]:
         src_info, layout_range, num_max_dispatch_tokens_per_rank, hidden, num_experts = handle
         if self._use_fallback:
@@ -210,7 +202,7 @@ class Buffer:
             combined_x, event, hook = self.runtime.combine(x, topk_idx, topk_weights, src_info, layout_range,
                                                            active_ranks,
                                                            num_max_dispatch_tokens_per_rank, num_experts, timeout_us,
-                                                           zero_copy, async_finish, return_recv_hook, out)
+                                                           zero_copy, use_fp8, async_finish, return_recv_hook, out)
         tensors_to_record = (x, topk_idx, topk_weights, src_info, layout_range, combined_x)
         return combined_x, EventOverlap(event, tensors_to_record if async_finish else None), hook
 
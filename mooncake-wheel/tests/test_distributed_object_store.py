@@ -162,6 +162,24 @@ class TestDistributedObjectStoreSingleStore(unittest.TestCase):
         time.sleep(default_kv_lease_ttl / 1000)
         for key in existing_keys:
             self.assertEqual(self.store.remove(key), 0)
+
+    def test_prefetch(self):
+        """Test that prefetch returns at once and leaves the objects intact."""
+        test_data = b"Hello, Prefetch World!"
+        keys = [f"test_prefetch_key_{i}" for i in range(4)]
+        for key in keys:
+            self.assertEqual(self.store.put(key, test_data), 0)
+
+        # Objects already in memory, and missing ones, are skipped
+        self.assertEqual(self.store.prefetch(keys + ["non_existent_key"]), 0)
+        self.assertEqual(self.store.prefetch([]), 0)
+        for key in keys:
+            self.assertEqual(self.store.get(key), test_data)
+
+        # Clean up
+        time.sleep(default_kv_lease_ttl / 1000)
+        for key in keys:
+            self.assertEqual(self.store.remove(key), 0)
         
 
     
@@ -152,6 +152,33 @@ class TestDistributedObjectStore(unittest.TestCase):
         self.store.remove(key_2d)
         self.store.remove(key_3d)
 
+    def test_put_get_quantized_tensor(self):
+        """Test put_tensor with quantize and transparent dequantization on get_tensor."""
+        import torch
+
+        tensor = torch.randn(16, 128, dtype=torch.bfloat16)
+        for mode, tolerance in (("int8", 0.02), ("fp8", 0.08)):
+            key = f"test_tensor_quantized_{mode}"
+            result = self.store.put_tensor(key, tensor, quantize=mode)
+            self.assertEqual(result, 0)
+            # Values take one byte, and each row of 128 a float32 scale
+            self.assertLess(self.store.get_size(key), tensor.nbytes)
+
+            retrieved = self.store.get_tensor(key)
+            self.assertIsNotNone(retrieved)
+            self.assertEqual(retrieved.shape, tensor.shape)
+            self.assertEqual(retrieved.dtype, tensor.dtype)
+            error = (retrieved.float() - tensor.float()).abs().max()
+            scale = tensor.float().abs().amax(dim=1).max()
+            self.assertLessEqual(error.item(), tolerance * scale.item())
+            self.store.remove(key)
+
+        # Only floating point tensors can be quantized
+        tensor_int = torch.tensor([1, 2, 3, 4], dtype=torch.int32)
+        self.assertNotEqual(
+            self.store.put_tensor("test_tensor_quantized_int", tensor_int,
+                                  quantize="int8"), 0)
+
              
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file